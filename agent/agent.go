@@ -292,6 +292,11 @@ func main() {
 	disable_system_protection := flag.Bool("no_sys_protect", false, "disable process and file protections")
 	disable_file_protection := flag.Bool("no_fs_protect", false, "disable file protections")
 	policy_puller := flag.Int("policy_puller", 0, "set policy pulling period")
+	conn_window := flag.Uint("conn_window", 0, "Connection report window in seconds, 0 for the dp default")
+	lat_sample := flag.Uint("lat_sample", 0, "Time one in this many packets through the dp pipeline, 0 to disable")
+	lat_trace := flag.Bool("lat_trace", false, "Keep the pipeline stages of timed packets as trace events")
+	dlp_scan_kb := flag.Uint("dlp_scan_kb", 0, "Stop matching DLP sensors on a session after this many KB, 0 for all")
+	metrics_port := flag.Uint("metrics_port", 0, "Serve dp counters in OpenMetrics format on this port, 0 to disable")
 	autoProfile := flag.Int("apc", 1, "Enable auto profile collection")
 	custom_check_control := flag.String("cbench", share.CustomCheckControl_Disable, "Custom check control")
 	show_all_cmds := flag.Bool("show_all_cmds", false, "Show all commands in the report")
@@ -363,6 +368,15 @@ func main() {
 		log.WithFields(log.Fields{"period": *policy_puller}).Info("policy pull regulator")
 	}
 
+	agentEnv.connReportWindow = uint32(*conn_window)
+	if *conn_window != 0 {
+		log.WithFields(log.Fields{"window": *conn_window}).Info("connection report window")
+	}
+
+	agentEnv.latencySample = uint32(*lat_sample)
+	agentEnv.latencyTrace = *lat_trace
+	agentEnv.dlpScanBudget = uint32(*dlp_scan_kb)
+
 	agentEnv.autoProfieCapture = 1 // default
 	if *autoProfile != 1 {
 		if *autoProfile < 0 {
@@ -671,6 +685,13 @@ func main() {
 	// Datapath
 	dpStatusChan := make(chan bool, 2)
 	dp.Open(dpTaskCallback, dpStatusChan, errRestartChan)
+	if *metrics_port != 0 {
+		go func() {
+			if err := dp.StartStatsServer(*metrics_port); err != nil {
+				log.WithError(err).Warn("failed to start metrics server")
+			}
+		}()
+	}
 
 	// bench initialized before the probe
 	bench = newBench(Host.Platform, Host.Flavor, Host.CloudPlatform)
@@ -3,6 +3,8 @@ package main
 import (
 	"bufio"
 	"bytes"
+	"crypto/sha256"
+	"encoding/hex"
 	"encoding/json"
 	"fmt"
 	"os"
@@ -94,6 +96,7 @@ const (
 	pathBaseImageBin    = "baseImageBin"
 	pathConfigPrefix    = "configPrefix"
 	scriptTimeout       = 1 * time.Minute
+	customCheckWorkers  = 4
 )
 
 type benchPlatform string
@@ -123,6 +126,7 @@ type Bench struct {
 	cloudPlatform   string
 	allContainers   utils.Set
 	newContainers   map[string]string
+	customCheckKeys map[string]string // container id: inputs of the last custom check
 	remediations    map[string]string
 	hostTimer       *time.Timer
 	conTimer        *time.Timer
@@ -133,7 +137,6 @@ type Bench struct {
 	kubeCisCmds     map[string]string
 	isKubeMaster    bool
 	isKubeWorker    bool
-	childCmd        *exec.Cmd
 	hostScript      *share.CLUSCustomCheckGroup
 	hostWarnItems   map[string]share.CLUSAuditBenchItem
 	kubeHostDone    bool
@@ -182,6 +185,7 @@ func newBench(platform, flavor, cloudPlatform string) *Bench {
 		cloudPlatform:   cloudPlatform,
 		allContainers:   utils.NewSet(),
 		newContainers:   make(map[string]string),
+		customCheckKeys: make(map[string]string),
 		remediations:    make(map[string]string),
 		hostTimer:       time.NewTimer(hostTimerStart),
 		conTimer:        time.NewTimer(containerTimerStart),
@@ -476,12 +480,30 @@ func (b *Bench) doKubeBench(masterScript, workerScript, remediation string) (err
 	defer os.Remove(journalScriptSh)
 
 	var errMaster, errWorker error
-	var out []byte
+	var outMaster, outWorker []byte
 
-	// run master bench
+	// the master and worker benches are independent, run them at the same time
+	var wg sync.WaitGroup
 	if b.isKubeMaster {
 		b.putBenchReport(Host.ID, share.BenchKubeMaster, nil, share.BenchStatusRunning)
-		out, errMaster = b.runKubeBench(share.BenchKubeMaster, masterScriptSh, remediation)
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			outMaster, errMaster = b.runKubeBench(share.BenchKubeMaster, masterScriptSh, remediation)
+		}()
+	}
+	if b.isKubeWorker {
+		b.putBenchReport(Host.ID, share.BenchKubeWorker, nil, share.BenchStatusRunning)
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			outWorker, errWorker = b.runKubeBench(share.BenchKubeWorker, workerScriptSh, remediation)
+		}()
+	}
+	wg.Wait()
+
+	// master bench
+	if b.isKubeMaster {
 		if errMaster != nil {
 			log.WithFields(log.Fields{
 				"error": errMaster, "script": masterScriptSh,
@@ -490,7 +512,7 @@ func (b *Bench) doKubeBench(masterScript, workerScript, remediation string) (err
 			b.logBenchFailure(benchPlatKube, share.BenchStatusKubeMasterFail)
 			b.putBenchReport(Host.ID, share.BenchKubeMaster, nil, share.BenchStatusKubeMasterFail)
 		} else {
-			list := b.getBenchMsg(out)
+			list := b.getBenchMsg(outMaster)
 			b.assignKubeBenchMeta(list)
 			b.kubeHostDone = true
 			b.logHostResult(list)
@@ -498,10 +520,8 @@ func (b *Bench) doKubeBench(masterScript, workerScript, remediation string) (err
 		}
 	}
 
-	// run worker bench
+	// worker bench
 	if b.isKubeWorker {
-		b.putBenchReport(Host.ID, share.BenchKubeWorker, nil, share.BenchStatusRunning)
-		out, errWorker = b.runKubeBench(share.BenchKubeWorker, workerScriptSh, remediation)
 		if errWorker != nil {
 			log.WithFields(log.Fields{
 				"error": errWorker, "script": workerScriptSh,
@@ -510,7 +530,7 @@ func (b *Bench) doKubeBench(masterScript, workerScript, remediation string) (err
 			b.logBenchFailure(benchPlatKube, share.BenchStatusKubeWorkerFail)
 			b.putBenchReport(Host.ID, share.BenchKubeWorker, nil, share.BenchStatusKubeWorkerFail)
 		} else {
-			list := b.getBenchMsg(out)
+			list := b.getBenchMsg(outWorker)
 			b.assignKubeBenchMeta(list)
 			b.kubeHostDone = true
 			b.logHostResult(list)
@@ -536,6 +556,7 @@ func (b *Bench) RemoveContainer(id string) {
 
 	b.allContainers.Remove(id)
 	delete(b.newContainers, id)
+	delete(b.customCheckKeys, id)
 	b.conTimer.Reset(containerTimerStart)
 
 	// TODO: delete existing keys
@@ -917,7 +938,6 @@ func (b *Bench) runDockerHostBench() ([]byte, error) {
 	cmd.SysProcAttr = &syscall.SysProcAttr{Setsid: true}
 	cmd.Stdout = &outb
 	cmd.Stderr = &errb
-	b.childCmd = cmd
 
 	err := cmd.Start()
 	if err != nil {
@@ -930,7 +950,6 @@ func (b *Bench) runDockerHostBench() ([]byte, error) {
 	global.SYS.RemoveToolProcess(pgid, false)
 	out := outb.Bytes()
 
-	b.childCmd = nil
 	if err != nil || len(out) == 0 {
 		if err == nil {
 			err = fmt.Errorf("Error executing docker bench")
@@ -1031,28 +1050,63 @@ func (b *Bench) getContainerItems(cname string, list []*benchItem) ([]*benchItem
 	return items, warns
 }
 
+// Containers are checked in parallel, up to customCheckWorkers at a time. A container is skipped
+// if its scripts and root pid are the same as the last check that had no script error.
 func (b *Bench) doContainerCustomCheck(wls []*share.CLUSWorkload) {
 	log.Debug("")
 
+	var wg sync.WaitGroup
+	sem := make(chan struct{}, customCheckWorkers)
 	for _, wl := range wls {
-		if items := b.runCustomScript(wl); len(items) > 0 {
-			b.mux.Lock()
-			if b.allContainers.Contains(wl.ID) {
-				b.putBenchReport(wl.ID, share.BenchCustomContainer, items, share.BenchStatusFinished)
-			}
-			b.mux.Unlock()
+		grpScripts := b.getCustomScripts(wl)
+		key := customCheckKey(wl.Pid, grpScripts)
+
+		b.mux.Lock()
+		last := b.customCheckKeys[wl.ID]
+		b.mux.Unlock()
+		if last == key {
+			log.WithFields(log.Fields{"name": wl.Name}).Debug("custom check unchanged")
+			continue
+		}
+
+		wg.Add(1)
+		sem <- struct{}{}
+		go func(wl *share.CLUSWorkload) {
+			defer func() {
+				<-sem
+				wg.Done()
+			}()
+
+			items := b.runCustomScript(wl, grpScripts)
 
 			warns := make([]*benchItem, 0)
+			var failed bool
 			for _, l := range items {
 				if l.level == share.BenchLevelWarn || l.level == share.BenchLevelError {
 					warns = append(warns, l)
 				}
+				if l.level == share.BenchLevelError {
+					failed = true
+				}
 			}
+
+			b.mux.Lock()
+			if b.allContainers.Contains(wl.ID) {
+				if len(items) > 0 {
+					b.putBenchReport(wl.ID, share.BenchCustomContainer, items, share.BenchStatusFinished)
+				}
+				if !failed {
+					b.customCheckKeys[wl.ID] = key
+				}
+			}
+			b.mux.Unlock()
+
 			if len(warns) > 0 {
 				b.logContainerResult(wl.Name, wl.ID, warns, share.CLUSAuditComplianceContainerCustomCheckViolation)
 			}
-		}
+		}(wl)
 	}
+	wg.Wait()
 
 	log.Debug("Running benchmark checks done")
 }
@@ -1121,7 +1175,6 @@ func (b *Bench) runDockerContainerBench(containers map[string]string) ([]byte, e
 	cmd.SysProcAttr = &syscall.SysProcAttr{Setsid: true}
 	cmd.Stdout = &outb
 	cmd.Stderr = &errb
-	b.childCmd = cmd
 	err := cmd.Start()
 	if err != nil {
 		log.WithFields(log.Fields{"error": err, "msg": errb.String()}).Error("Start")
@@ -1133,7 +1186,6 @@ func (b *Bench) runDockerContainerBench(containers map[string]string) ([]byte, e
 	global.SYS.RemoveToolProcess(pgid, false)
 	out := outb.Bytes()
 
-	b.childCmd = nil
 	if err != nil || len(out) == 0 {
 		if err == nil {
 			err = fmt.Errorf("Error executing docker bench")
@@ -1144,8 +1196,8 @@ func (b *Bench) runDockerContainerBench(containers map[string]string) ([]byte, e
 	return out, nil
 }
 
-func (b *Bench) runCustomScript(wl *share.CLUSWorkload) []*benchItem {
-	items := make([]*benchItem, 0)
+// Custom check scripts of the groups the workload belongs to, keyed by group name
+func (b *Bench) getCustomScripts(wl *share.CLUSWorkload) map[string]*share.CLUSCustomCheckGroup {
 	grpScripts := make(map[string]*share.CLUSCustomCheckGroup, 0)
 	groupMux.Lock()
 	for _, grp := range groups {
@@ -1154,7 +1206,30 @@ func (b *Bench) runCustomScript(wl *share.CLUSWorkload) []*benchItem {
 		}
 	}
 	groupMux.Unlock()
+	return grpScripts
+}
 
+// Hash of the inputs of a container's custom check: its root pid and the selected scripts
+func customCheckKey(pid int, grpScripts map[string]*share.CLUSCustomCheckGroup) string {
+	names := make([]string, 0, len(grpScripts))
+	for name := range grpScripts {
+		names = append(names, name)
+	}
+	sort.Strings(names)
+
+	h := sha256.New()
+	fmt.Fprintf(h, "%d\n", pid)
+	for _, name := range names {
+		fmt.Fprintf(h, "%s\n", name)
+		for _, s := range grpScripts[name].Scripts {
+			fmt.Fprintf(h, "%s\n%s\n", s.Name, s.Script)
+		}
+	}
+	return hex.EncodeToString(h.Sum(nil))
+}
+
+func (b *Bench) runCustomScript(wl *share.CLUSWorkload, grpScripts map[string]*share.CLUSCustomCheckGroup) []*benchItem {
+	items := make([]*benchItem, 0)
 	for grpName, script := range grpScripts {
 		log.WithFields(log.Fields{"name": wl.Name, "group": grpName, "script": script}).Debug("selected")
 
@@ -1217,7 +1292,6 @@ func (b *Bench) runScript(script string, pid int) (bool, string, error) {
 	cmd.Stderr = &errb
 	var msg string
 	result := make(chan error, 1)
-	b.childCmd = cmd
 
 	//
 	err = cmd.Start()
@@ -1239,7 +1313,6 @@ func (b *Bench) runScript(script string, pid int) (bool, string, error) {
 	}()
 	select {
 	case err := <-result:
-		b.childCmd = nil
 		global.SYS.RemoveToolProcess(pgid, false)
 		if err == nil {
 			return true, msg, nil
@@ -1256,7 +1329,6 @@ func (b *Bench) runScript(script string, pid int) (bool, string, error) {
 		return false, msg, err
 	case <-time.After(scriptTimeout):
 		global.SYS.RemoveToolProcess(pgid, true)
-		b.childCmd = nil
 		return false, "script timeout", fmt.Errorf("script timeout")
 	}
 }
@@ -1331,7 +1403,6 @@ func (b *Bench) readJournal() (string, error) {
 	cmd.SysProcAttr = &syscall.SysProcAttr{Setsid: true}
 	cmd.Stdout = &outb
 	cmd.Stderr = &errb
-	b.childCmd = cmd
 
 	err := cmd.Start()
 	if err != nil {
@@ -1343,7 +1414,6 @@ func (b *Bench) readJournal() (string, error) {
 	global.SYS.RemoveToolProcess(pgid, false)
 	out := outb.Bytes()
 
-	b.childCmd = nil
 	if err != nil || len(out) == 0 {
 		if err == nil {
 			err = fmt.Errorf("Error executing read Journal scripts")
@@ -1391,7 +1461,6 @@ func (b *Bench) runKubeBench(bench share.BenchType, script, remediationFolder st
 	cmd.SysProcAttr = &syscall.SysProcAttr{Setsid: true}
 	cmd.Stdout = &outb
 	cmd.Stderr = &errb
-	b.childCmd = cmd
 	err := cmd.Start()
 	if err != nil {
 		log.WithFields(log.Fields{"error": err, "msg": errb.String()}).Error("Start")
@@ -1403,7 +1472,6 @@ func (b *Bench) runKubeBench(bench share.BenchType, script, remediationFolder st
 	global.SYS.RemoveToolProcess(pgid, false)
 	out := outb.Bytes()
 
-	b.childCmd = nil
 	if err != nil {
 		if ee, ok := err.(*exec.ExitError); ok {
 			status := global.SYS.GetExitStatus(ee)
@@ -1437,7 +1505,6 @@ func (b *Bench) getKubeVersion() string {
 	cmd.SysProcAttr = &syscall.SysProcAttr{Setsid: true}
 	cmd.Stdout = &outb
 	cmd.Stderr = &errb
-	b.childCmd = cmd
 
 	err := cmd.Start()
 	if err != nil {
@@ -1450,7 +1517,6 @@ func (b *Bench) getKubeVersion() string {
 	global.SYS.RemoveToolProcess(pgid, false)
 	out := outb.Bytes()
 
-	b.childCmd = nil
 	if err != nil {
 		log.WithFields(log.Fields{"error": err, "msg": errb.String()}).Error("")
 		return ""
@@ -1740,11 +1806,6 @@ func (b *Bench) runFindSecrets(rootPid int, name, id, group string) {
 
 func (b *Bench) Close() {
 	b.bEnable = false
-	//	if b.childCmd != nil {
-	//		if err := syscall.Kill(b.childCmd.Process.Pid, syscall.SIGKILL); err != nil {
-	//			log.WithFields(log.Fields{"err": err}).Error("Failed to kill child script")
-	//		}
-	//	}
 }
 
 // a simple pipeline routine to trigger the goroutine of a scan task
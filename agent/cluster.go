@@ -8,6 +8,7 @@ import (
 	"strconv"
 	"time"
 
+	"github.com/neuvector/neuvector/agent/dp"
 	"github.com/neuvector/neuvector/share"
 	"github.com/neuvector/neuvector/share/cluster"
 	"github.com/neuvector/neuvector/share/container"
@@ -345,6 +346,31 @@ func putMemoryPressureEvent(rpt *system.MemoryPressureReport, setRisingEdge bool
 	}
 }
 
+func putDPOverloadEvent(o *dp.DPOverload) {
+	var msg string
+	if o.Overloaded {
+		msg = fmt.Sprintf("Datapath thread %d falls behind the traffic, new sessions are rate limited and established sessions are not inspected, count=%d",
+			o.Thread, o.Enters)
+	} else {
+		msg = fmt.Sprintf("Datapath thread %d caught up with the traffic after %d seconds, sessions refused=%d, sessions not inspected=%d",
+			o.Thread, o.Seconds, o.ShedSessions, o.ShedInspects)
+	}
+
+	clog := share.CLUSEventLog{
+		Event:      share.CLUSEvAgentDPOverload,
+		HostID:     Host.ID,
+		HostName:   Host.Name,
+		AgentID:    Agent.ID,
+		AgentName:  Agent.Name,
+		ReportedAt: time.Now().UTC(),
+		Msg:        msg,
+	}
+
+	if dbgError := evqueue.Append(&clog); dbgError != nil {
+		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+	}
+}
+
 // PUT-KEY: /object/host/<host_docker_id>
 // PUT-KEY: /object/device/<host_docker_id>/<device_uuid>
 func putLocalInfo() {
@@ -10,6 +10,7 @@ import (
 	"fmt"
 	"net"
 	"os"
+	"reflect"
 	"sync"
 	"time"
 	"unsafe"
@@ -27,7 +28,11 @@ const ctrlServer string = "/tmp/ctrl_listen.sock"
 const defaultDPMsgTimeout int = 2
 const dpConnJamRetryMax int = 16
 
-var dpConn *net.UnixConn
+// Requests waiting for a reply at the same time. Requests without a callback are not
+// counted: dp processes messages in order, so they never wait.
+const dpMaxInflight int = 16
+
+var dpConn *dpConnSet
 var dpClientMutex sync.Mutex
 
 const dpKeepAliveInterval time.Duration = (time.Second * 2)
@@ -39,6 +44,22 @@ var taskCallback DPTaskCallback
 var statusChan chan bool
 var restartChan chan interface{}
 
+type dpRequest struct {
+	cb       DPCallback
+	param    interface{}
+	done     chan struct{}
+	replied  uint32 // dp instances done with the request
+	stats    *C.DPMsgStats
+	statsHdr []byte
+}
+
+// Requests in flight by id, replies are dispatched by dpReceive. The callback is called with
+// dpReqMutex held, so a timed-out request cannot be completed at the same time.
+var dpReqMutex sync.Mutex
+var dpReqMap map[uint32]*dpRequest = make(map[uint32]*dpRequest)
+var dpReqSeq uint32
+var dpReqWindow chan struct{} = make(chan struct{}, dpMaxInflight)
+
 func dpClientLock() {
 	// log.Info("")
 	dpClientMutex.Lock()
@@ -49,16 +70,17 @@ func dpClientUnlock() {
 	dpClientMutex.Unlock()
 }
 
-// With lock hold
-func dpSendMsgExSilent(msg []byte, timeout int, cb DPCallback, param interface{}) int {
-	if dpConn == nil {
-		log.Error("Data path not connected")
-		if cb != nil && param != nil {
-			cb(nil, param)
-		}
-		return -1
+// Insert the request id as the first key of the json message
+func dpTagMsg(msg []byte, id uint32) []byte {
+	tag := fmt.Sprintf("{\"%s\":%d", C.DP_CTRL_REQ_ID_KEY, id)
+	if len(msg) > 2 {
+		tag += ","
 	}
+	return append([]byte(tag), msg[1:]...)
+}
 
+// With lock hold
+func dpWriteMsg(msg []byte) error {
 	if dbgError := dpConn.SetWriteDeadline(time.Now().Add(time.Second * 2)); dbgError != nil {
 		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 	}
@@ -68,56 +90,151 @@ func dpSendMsgExSilent(msg []byte, timeout int, cb DPCallback, param interface{}
 		log.WithFields(log.Fields{"error": err}).Error("Send error")
 		// Let keep alive to close dp to avoid reentry
 		// closeDP()
-		// debug.PrintStack()
-		if cb != nil && param != nil {
-			cb(nil, param)
+		return err
+	}
+	dpAliveMsgCnt++
+	return nil
+}
+
+func dpFailRequest(req *dpRequest) {
+	// The caller of cbKeepAlive is expected to hold the client lock when dp is closed
+	dpClientLock()
+	req.cb(nil, req.param)
+	dpClientUnlock()
+}
+
+// Send the request and wait for its reply. The dp client lock is only held while the message
+// is written, so other requests can be sent while this one is waiting.
+func dpSendMsgEx(msg []byte, timeout int, cb DPCallback, param interface{}) int {
+	//log.WithFields(log.Fields{"msg": string(msg), "size": len(msg)}).Debug("")
+
+	if cb == nil || param == nil {
+		dpClientLock()
+		defer dpClientUnlock()
+
+		if dpConn == nil {
+			log.Error("Data path not connected")
+			dpCfgTrack(msg, false)
+			return -1
+		}
+		err := dpWriteMsg(msg)
+		dpCfgTrack(msg, err == nil)
+		if err != nil {
+			return -1
 		}
+		return 0
+	}
+
+	if timeout == 0 {
+		timeout = defaultDPMsgTimeout
+	}
+
+	dpReqWindow <- struct{}{}
+	defer func() { <-dpReqWindow }()
+
+	req := &dpRequest{cb: cb, param: param, done: make(chan struct{})}
+
+	dpClientLock()
+	if dpConn == nil {
+		dpCfgTrack(msg, false)
+		dpClientUnlock()
+		log.Error("Data path not connected")
+		dpFailRequest(req)
 		return -1
 	}
 
-	if cb != nil && param != nil {
-		if timeout == 0 {
-			timeout = defaultDPMsgTimeout
-		}
+	dpReqMutex.Lock()
+	dpReqSeq++
+	if dpReqSeq == 0 {
+		dpReqSeq++
+	}
+	id := dpReqSeq
+	dpReqMap[id] = req
+	dpReqMutex.Unlock()
 
-		var done bool
-		var buf []byte = make([]byte, C.DP_MSG_SIZE)
+	err := dpWriteMsg(dpTagMsg(msg, id))
+	dpCfgTrack(msg, err == nil)
+	dpClientUnlock()
 
-		for !done {
-			if dbgError := dpConn.SetReadDeadline(time.Now().Add(time.Second * time.Duration(timeout))); dbgError != nil {
-				log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-			}
-			n, err := dpConn.Read(buf)
-			if err != nil {
-				log.WithFields(log.Fields{"error": err}).Error("Read error")
-				cb(nil, param)
-				// Time out could be because DP is busy. Don't close DP yet.
-				// Let keep alive cb to close dp later if dp is really gone
-				// closeDP()
-				return -1
-			} else {
-				done = cb(buf[:n], param)
-			}
+	if err == nil {
+		select {
+		case <-req.done:
+			return 0
+		case <-time.After(time.Second * time.Duration(timeout)):
 		}
 	}
-	dpAliveMsgCnt++
-	return 0
-}
 
-func dpSendMsgEx(msg []byte, timeout int, cb DPCallback, param interface{}) int {
-	//log.WithFields(log.Fields{"msg": string(msg), "size": len(msg)}).Debug("")
+	dpReqMutex.Lock()
+	_, pending := dpReqMap[id]
+	delete(dpReqMap, id)
+	dpReqMutex.Unlock()
 
-	// The cb call is inside the dp lock, so be careful if you need to grab
-	// another lock in cb
-	dpClientLock()
-	defer dpClientUnlock()
-	return dpSendMsgExSilent(msg, timeout, cb, param)
+	if !pending {
+		// Completed right at the timeout
+		return 0
+	}
+
+	if err == nil {
+		// Time out could be because DP is busy. Don't close DP yet.
+		// Let keep alive cb to close dp later if dp is really gone
+		log.WithFields(log.Fields{"id": id}).Error("Read timeout")
+	}
+	dpFailRequest(req)
+	return -1
 }
 
 func dpSendMsg(msg []byte) int {
 	return dpSendMsgEx(msg, 0, nil, nil)
 }
 
+// Dispatch replies of the connection to a dp instance to the requests in flight, until the
+// connection is closed. A request is done when all instances are done with it.
+func dpReceive(conn *net.UnixConn, instance int) {
+	var rh C.DPMsgReplyHdr
+	var buf []byte = make([]byte, int(unsafe.Sizeof(rh))+C.DP_MSG_SIZE)
+
+	offset := int(unsafe.Sizeof(rh))
+	for {
+		size, err := conn.Read(buf)
+		if err != nil {
+			log.WithFields(log.Fields{"error": err}).Debug("Read error")
+			return
+		}
+		if size < offset {
+			log.WithFields(log.Fields{"len": size}).Error("Reply without request id")
+			continue
+		}
+
+		id := binary.BigEndian.Uint32(buf[:offset])
+
+		dpReqMutex.Lock()
+		if req, ok := dpReqMap[id]; ok && req.replied&(1<<uint(instance)) == 0 {
+			var done bool
+			reply := buf[offset:size]
+			if dpStatsReply(reply) {
+				dpStatsAdd(req, reply)
+				done = true
+			} else {
+				done = req.cb(reply, req.param)
+			}
+			if done {
+				req.replied |= 1 << uint(instance)
+				if req.replied == 1<<uint(dpInstances)-1 {
+					if req.stats != nil {
+						req.cb(dpStatsMsg(req), req.param)
+					}
+					delete(dpReqMap, id)
+					close(req.done)
+				}
+			}
+		} else {
+			// Reply of a timed-out request
+			log.WithFields(log.Fields{"id": id, "len": size}).Debug("Drop stale reply")
+		}
+		dpReqMutex.Unlock()
+	}
+}
+
 // -- DP message functions
 
 func DPCtrlAddTapPort(netns, iface string, epmac net.HardwareAddr) {
@@ -205,18 +322,45 @@ func DPCtrlDelSrvcPort(iface string) {
 	dpSendMsg(msg)
 }
 
-func DPCtrlSetSysConf(xffenabled *bool) {
+// dlpScanBudget is kept by dp if nil
+func DPCtrlSetSysConf(xffenabled *bool, dlpScanBudget *uint32) {
 	log.WithFields(log.Fields{"xffenabled": *xffenabled}).Debug("")
 
 	data := DPSysConfReq{
 		Sysconf: &DPSysConf{
-			XffEnabled: xffenabled,
+			XffEnabled:    xffenabled,
+			DlpScanBudget: dlpScanBudget,
 		},
 	}
 	msg, _ := json.Marshal(data)
 	dpSendMsg(msg)
 }
 
+// window is the connection aggregation period in seconds, 0 keeps the one of dp
+func DPCtrlSetConnectReport(window uint32, compact bool) {
+	log.WithFields(log.Fields{"window": window, "compact": compact}).Debug("")
+
+	conf := &DPConnectReportConf{Compact: &compact}
+	if window > 0 {
+		conf.Window = &window
+	}
+	data := DPConnectReportReq{ConnectReport: conf}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
+// Threat logs of a threat, endpoint and peer, rate a minute after burst of them, rate 0
+// sends all. Logs held back are counted in the next one.
+func DPCtrlSetThreatLogLimit(rate, burst uint32) {
+	log.WithFields(log.Fields{"rate": rate, "burst": burst}).Debug("")
+
+	data := DPThreatLogLimitReq{
+		Limit: &DPThreatLogLimit{Rate: rate, Burst: burst},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
 func DPCtrlSetDisableNetPolicy(disableNetPolicy *bool) {
 	log.WithFields(log.Fields{"disableNetPolicy": *disableNetPolicy}).Debug("")
 
@@ -262,35 +406,58 @@ func DPCtrlSetStrictGroupMode(strictGroupMode *bool) {
 	dpSendMsg(msg)
 }
 
-func DPCtrlAddMAC(iface string, mac, ucmac, bcmac, oldmac, pmac net.HardwareAddr, pips []net.IP) {
-	log.WithFields(log.Fields{"mac": mac, "iface": iface}).Debug("")
-
-	tpips := make([]DPMacPip, 0, len(pips))
-	for _, addr := range pips {
-		pip := DPMacPip{
-			IP: addr,
+func DPAddMACEntry(iface string, mac, ucmac, bcmac, oldmac, pmac net.HardwareAddr, pips []net.IP) *DPAddMAC {
+	entry := &DPAddMAC{
+		Iface:  iface,
+		MAC:    mac.String(),
+		UCMAC:  ucmac.String(),
+		BCMAC:  bcmac.String(),
+		OldMAC: oldmac.String(),
+		PMAC:   pmac.String(),
+	}
+	if len(pips) > 0 {
+		entry.PIPS = make([]DPMacPip, 0, len(pips))
+		for _, addr := range pips {
+			entry.PIPS = append(entry.PIPS, DPMacPip{IP: addr})
 		}
-		tpips = append(tpips, pip)
 	}
+	return entry
+}
+
+func DPCtrlAddMAC(iface string, mac, ucmac, bcmac, oldmac, pmac net.HardwareAddr, pips []net.IP) {
+	log.WithFields(log.Fields{"mac": mac, "iface": iface}).Debug("")
 
 	data := DPAddMACReq{
-		AddMAC: &DPAddMAC{
-			Iface:  iface,
-			MAC:    mac.String(),
-			UCMAC:  ucmac.String(),
-			BCMAC:  bcmac.String(),
-			OldMAC: oldmac.String(),
-			PMAC:   pmac.String(),
-			PIPS:   tpips,
-		},
-	}
-	if len(pips) <= 0 {
-		data.AddMAC.PIPS = nil
+		AddMAC: DPAddMACEntry(iface, mac, ucmac, bcmac, oldmac, pmac, pips),
 	}
 	msg, _ := json.Marshal(data)
 	dpSendMsg(msg)
 }
 
+// Add endpoints in batches, dp publishes each batch with one RCU grace period
+func DPCtrlAddMACs(entries []*DPAddMAC) {
+	log.WithFields(log.Fields{"count": len(entries)}).Debug("")
+
+	for start := 0; start < len(entries); {
+		end := len(entries)
+		for {
+			data := DPAddMACsReq{
+				AddMACs: &DPAddMACs{MACs: entries[start:end]},
+			}
+			msg, _ := json.Marshal(data)
+			if len(msg) <= maxMsgSize || end == start+1 {
+				if dpSendMsg(msg) == -1 {
+					log.Debug("dpSendMsg error")
+					return
+				}
+				break
+			}
+			end = start + (end-start)/2
+		}
+		start = end
+	}
+}
+
 func DPCtrlDelMAC(iface string, mac net.HardwareAddr) {
 	log.WithFields(log.Fields{"mac": mac}).Debug("")
 
@@ -304,6 +471,35 @@ func DPCtrlDelMAC(iface string, mac net.HardwareAddr) {
 	dpSendMsg(msg)
 }
 
+// Remove endpoints in batches, dp releases each batch after one RCU grace period
+func DPCtrlDelMACs(macs []net.HardwareAddr) {
+	log.WithFields(log.Fields{"count": len(macs)}).Debug("")
+
+	strs := make([]string, len(macs))
+	for i, mac := range macs {
+		strs[i] = mac.String()
+	}
+
+	for start := 0; start < len(strs); {
+		end := len(strs)
+		for {
+			data := DPDelMACsReq{
+				DelMACs: &DPMACArray{MACs: strs[start:end]},
+			}
+			msg, _ := json.Marshal(data)
+			if len(msg) <= maxMsgSize || end == start+1 {
+				if dpSendMsg(msg) == -1 {
+					log.Debug("dpSendMsg error")
+					return
+				}
+				break
+			}
+			end = start + (end-start)/2
+		}
+		start = end
+	}
+}
+
 func DPCtrlRefreshApp() {
 	log.Debug("")
 
@@ -340,6 +536,61 @@ func DPCtrlConfigMAC(MACs []string, tap *bool, appMap map[share.CLUSProtoPort]*s
 	dpSendMsg(msg)
 }
 
+// With identify, the database parsers of the endpoints stop once the protocol is known, no
+// command is inspected.
+func DPCtrlConfigInspect(MACs []string, identify bool) {
+	level := C.DP_INSPECT_FULL
+	if identify {
+		level = C.DP_INSPECT_IDENTIFY
+	}
+	data := DPConfigMACReq{
+		Cfg: &DPMacConfig{
+			MACs:    MACs,
+			Inspect: &level,
+		},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
+// With dedup, the sessions of a meshed workload's own MACs are not parsed, the proxymesh
+// endpoint on "lo" inspects the same traffic in clear text and its blocks are enforced on them.
+func DPCtrlConfigMeshDedup(MACs []string, dedup bool) {
+	data := DPConfigMACReq{
+		Cfg: &DPMacConfig{
+			MACs:      MACs,
+			MeshDedup: &dedup,
+		},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
+// In tap mode, the sessions of the endpoints are inspected for their first kb KBytes, then
+// only tracked and counted for the connection report. 0 inspects the whole sessions.
+func DPCtrlConfigTapSample(MACs []string, kb uint32) {
+	data := DPConfigMACReq{
+		Cfg: &DPMacConfig{
+			MACs:      MACs,
+			TapSample: &kb,
+		},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
+// Limit the packets of the endpoints in inline and nfq modes, the ones over the limit are
+// dropped before they are inspected. Limits apply on each dp thread, all 0 removes them.
+func DPCtrlConfigRateLimit(limit *DPRateLimit) {
+	log.WithFields(log.Fields{"limit": *limit}).Debug("")
+
+	data := DPConfigRateLimitReq{
+		Cfg: limit,
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
 func DPCtrlConfigNBE(MACs []string, nbe *bool) {
 	data := DPConfigNbeReq{
 		Cfg: &DPNbeConfig{
@@ -424,6 +675,119 @@ func DPCtrlConfigAgent(debug *DPDebug) {
 	dpSendMsg(msg)
 }
 
+// Start dp threads up to 'threads', or retire the threads above it. Taps of the
+// retired threads move to the others.
+func DPCtrlSetDPThreads(threads int) {
+	log.WithFields(log.Fields{"threads": threads}).Debug("")
+
+	data := DPSetThreadsReq{
+		Threads: &DPThreads{Threads: threads},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
+// Time one in 'sample' packets of each dp thread, 0 to stop. With trace, the stages of
+// timed packets are also kept for DPCtrlDumpTrace().
+func DPCtrlSetLatency(sample uint32, trace bool) {
+	log.WithFields(log.Fields{"sample": sample, "trace": trace}).Debug("")
+
+	data := DPSetLatencyReq{
+		SetLatency: &DPLatencySample{Sample: sample, Trace: trace},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
+// Write the trace events as Chrome trace JSON, to the dp default file if path is empty
+func DPCtrlDumpTrace(path string) {
+	log.WithFields(log.Fields{"path": path}).Debug("")
+
+	data := DPDumpTraceReq{
+		DumpTrace: &DPTracePath{Path: path},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
+// The answer can take several messages, see ParseDPLatency()
+func DPCtrlLatency(cb DPCallback, param interface{}) {
+	log.Debug("")
+
+	data := DPLatencyReq{
+		Latency: &DPEmpty{},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsgEx(msg, 5, cb, param)
+}
+
+// Forwarding latency of the inline interfaces, timed at the rate of DPCtrlSetLatency(). The
+// answer can take several messages, see ParseDPFwdLatency()
+func DPCtrlStatsFwdLatency(cb DPCallback, param interface{}) {
+	log.Debug("")
+
+	data := DPFwdLatencyReq{
+		FwdLatency: &DPEmpty{},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsgEx(msg, 5, cb, param)
+}
+
+// Sessions decided by each policy rule, the counts start over after the read if reset is set.
+// The answer can take several messages, see ParseDPPolicyHits()
+func DPCtrlPolicyHits(reset bool, cb DPCallback, param interface{}) {
+	log.WithFields(log.Fields{"reset": reset}).Debug("")
+
+	data := DPPolicyHitsReq{
+		PolicyHits: &DPPolicyHitsOption{Reset: reset},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsgEx(msg, 5, cb, param)
+}
+
+// Capture packets of the endpoint into a pcapng file, all endpoints if mac is empty
+func DPCtrlCaptureStart(mac, filter string, snaplen, limit uint32, path string) {
+	log.WithFields(log.Fields{"mac": mac, "filter": filter, "limit": limit, "path": path}).Debug("")
+
+	data := DPCaptureStartReq{
+		Start: &DPCaptureStart{MAC: mac, Filter: filter, Snaplen: snaplen, Limit: limit, Path: path},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
+func DPCtrlCaptureStop() {
+	log.Debug("")
+
+	data := DPCaptureStopReq{
+		Stop: &DPEmpty{},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsg(msg)
+}
+
+// The answer is decoded with ParseDPCaptureStatus()
+func DPCtrlCaptureStatus(cb DPCallback, param interface{}) {
+	log.Debug("")
+
+	data := DPCaptureStatusReq{
+		Status: &DPEmpty{},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsgEx(msg, 5, cb, param)
+}
+
+// The answer is decoded with ParseDPMemStats()
+func DPCtrlMemStats(cb DPCallback, param interface{}) {
+	log.Debug("")
+
+	data := DPMemStatsReq{
+		Stats: &DPEmpty{},
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsgEx(msg, 5, cb, param)
+}
+
 func DPCtrlCountSession(cb DPCallback, param interface{}) {
 	log.Debug("")
 
@@ -444,6 +808,17 @@ func DPCtrlListSession(cb DPCallback, param interface{}) {
 	dpSendMsgEx(msg, 5, cb, param)
 }
 
+// The last message of the reply carries the cursor to go on with, 0 at the end
+func DPCtrlListSessionChunk(chunk *DPListSessionChunk, cb DPCallback, param interface{}) {
+	log.WithFields(log.Fields{"cursor": chunk.Cursor}).Debug("")
+
+	data := DPListSessionChunkReq{
+		ListSession: chunk,
+	}
+	msg, _ := json.Marshal(data)
+	dpSendMsgEx(msg, 5, cb, param)
+}
+
 func DPCtrlClearSession(id uint32) {
 	log.Debug("")
 
@@ -473,65 +848,92 @@ func getDPCtrlClientAddr() string {
 const maxMsgSize int = 8120
 
 func DPCtrlConfigPolicy(policy *DPWorkloadIPPolicy, cmd uint) int {
-	var start, end int = 0, 0
-	var first bool = true
-	var rulesPerMsg int = 40
-
-	num := len(policy.IPRules)
 	log.WithFields(log.Fields{
-		"workload": policy.WlID, "mac": policy.WorkloadMac, "num": num,
+		"workload": policy.WlID, "mac": policy.WorkloadMac, "num": len(policy.IPRules),
 	}).Debug("")
 
-	for num > 0 || first {
-		var flag uint = 0
+	return dpSendBinMsg(C.DP_CTRL_BIN_CFG_POLICY, dpCtrlBinPolicy(policy, cmd))
+}
 
-	retry:
-		flag = 0
-		if start == 0 {
-			flag = C.MSG_START
-		}
-		if num <= rulesPerMsg {
-			flag |= C.MSG_END
-			end = start + num
-		} else {
-			end = start + rulesPerMsg
+// Changes touching more than 1/dpPolicyDeltaRatio of the rules are pushed in full
+const dpPolicyDeltaRatio int = 4
+
+// dpPolicyDelta finds the rule IDs to remove and the rules to append to the dp copy of the
+// old policy to get the new one. Rules are grouped by ID, an ID whose rules changed is
+// removed and its new rules are appended, so the unchanged rules must keep their order and
+// the changed ones come last. dp takes ipv4 rules without fqdn only.
+func dpPolicyDelta(old, policy *DPWorkloadIPPolicy) ([]uint32, []*DPPolicyIPRule, bool) {
+	if old.DefAction != policy.DefAction || old.ApplyDir != policy.ApplyDir ||
+		!reflect.DeepEqual(old.WorkloadMac, policy.WorkloadMac) {
+		return nil, nil, false
+	}
+
+	group := func(rules []*DPPolicyIPRule) map[uint32][]*DPPolicyIPRule {
+		m := make(map[uint32][]*DPPolicyIPRule)
+		for _, rule := range rules {
+			m[rule.ID] = append(m[rule.ID], rule)
 		}
-		data := DPPolicyCfgReq{
-			DPPolicyCfg: &DPPolicyCfg{
-				Cmd:         cmd,
-				Flag:        flag,
-				DefAction:   policy.DefAction,
-				ApplyDir:    policy.ApplyDir,
-				WorkloadMac: policy.WorkloadMac,
-				IPRules:     policy.IPRules[start:end],
-			},
+		return m
+	}
+	deltaRule := func(rule *DPPolicyIPRule) bool {
+		v4, _ := ipRuleFamily(rule)
+		return v4 && rule.Fqdn == ""
+	}
+
+	oldRules, newRules := group(old.IPRules), group(policy.IPRules)
+	changed := utils.NewSet()
+	dels := make([]uint32, 0)
+	for id, rules := range oldRules {
+		if !reflect.DeepEqual(rules, newRules[id]) {
+			changed.Add(id)
+			dels = append(dels, id)
 		}
-		msg, _ := json.Marshal(data)
-		sz := len(msg)
-		if sz > maxMsgSize {
-			// a very rough way to calculate rulesPerMsg
-			newRulesPerMsg := maxMsgSize / (sz/(end-start) + 1)
-			if newRulesPerMsg == rulesPerMsg {
-				newRulesPerMsg--
-			}
-			if newRulesPerMsg == 0 {
-				log.WithFields(log.Fields{
-					"rule": policy.IPRules[start]},
-				).Error("rule too large")
-				return -1
-			}
-			rulesPerMsg = newRulesPerMsg
-			goto retry
+	}
+	for id := range newRules {
+		if _, ok := oldRules[id]; !ok {
+			changed.Add(id)
 		}
+	}
 
-		if dpSendMsg(msg) == -1 {
-			return -1
+	kept := make([]*DPPolicyIPRule, 0, len(old.IPRules))
+	for _, rule := range old.IPRules {
+		if !changed.Contains(rule.ID) {
+			kept = append(kept, rule)
+		} else if !deltaRule(rule) {
+			return nil, nil, false
 		}
-		num = num + start - end
-		start = end
-		first = false
 	}
-	return 0
+	if len(policy.IPRules) < len(kept) || !reflect.DeepEqual(kept, policy.IPRules[:len(kept)]) {
+		return nil, nil, false
+	}
+	adds := policy.IPRules[len(kept):]
+	for _, rule := range adds {
+		if !changed.Contains(rule.ID) || !deltaRule(rule) {
+			return nil, nil, false
+		}
+	}
+	if (len(dels)+len(adds))*dpPolicyDeltaRatio > len(policy.IPRules) {
+		return nil, nil, false
+	}
+	return dels, adds, true
+}
+
+// DPCtrlUpdatePolicy sends the change from the policy dp has to the new one, as a delta when
+// possible.
+func DPCtrlUpdatePolicy(old, policy *DPWorkloadIPPolicy) int {
+	dels, adds, ok := dpPolicyDelta(old, policy)
+	if !ok {
+		return DPCtrlConfigPolicy(policy, C.CFG_MODIFY)
+	}
+
+	log.WithFields(log.Fields{
+		"workload": policy.WlID, "mac": policy.WorkloadMac, "del": len(dels), "add": len(adds),
+	}).Debug("")
+
+	if len(dels) == 0 && len(adds) == 0 {
+		return 0
+	}
+	return dpSendBinMsg(C.DP_CTRL_BIN_CFG_POLICY_DELTA, dpCtrlBinPolicyDelta(policy.WorkloadMac, dels, adds))
 }
 
 func DPCtrlDeleteFqdn(names []string) int {
@@ -554,7 +956,7 @@ func DPCtrlDeleteFqdn(names []string) int {
 	return 0
 }
 
-func DPCtrlSetFqdnIp(fqdnip *share.CLUSFqdnIp) int {
+func dpFqdnIps(fqdnip *share.CLUSFqdnIp) *DPFqdnIps {
 	fips := make([]net.IP, 0, len(fqdnip.FqdnIP))
 	for _, fip := range fqdnip.FqdnIP {
 		if !utils.IsIPv4(fip) {
@@ -563,12 +965,16 @@ func DPCtrlSetFqdnIp(fqdnip *share.CLUSFqdnIp) int {
 		fips = append(fips, fip)
 	}
 	Vhost := fqdnip.Vhost
+	return &DPFqdnIps{
+		FqdnName: fqdnip.FqdnName,
+		FqdnIps:  fips,
+		Vhost:    &Vhost,
+	}
+}
+
+func DPCtrlSetFqdnIp(fqdnip *share.CLUSFqdnIp) int {
 	data := DPFqdnIpSetReq{
-		Fqdns: &DPFqdnIps{
-			FqdnName: fqdnip.FqdnName,
-			FqdnIps:  fips,
-			Vhost:    &Vhost,
-		},
+		Fqdns: dpFqdnIps(fqdnip),
 	}
 	msg, _ := json.Marshal(data)
 	if dpSendMsg(msg) < 0 {
@@ -577,139 +983,46 @@ func DPCtrlSetFqdnIp(fqdnip *share.CLUSFqdnIp) int {
 	return 0
 }
 
-func DPCtrlConfigPolicyAddr(subnets map[string]share.CLUSSubnet) {
-	data_subnet := make([]DPSubnet, 0, len(subnets))
-	for _, addr := range subnets {
-		if !utils.IsIPv4(addr.Subnet.IP) {
-			continue
-		}
-		subnet := DPSubnet{
-			IP:   addr.Subnet.IP,
-			Mask: net.IP(addr.Subnet.Mask),
-		}
-		data_subnet = append(data_subnet, subnet)
+// Set the ips of names in batches, dp applies each batch in one request
+func DPCtrlSetFqdnIps(fqdnips []*share.CLUSFqdnIp) int {
+	fqdns := make([]*DPFqdnIps, len(fqdnips))
+	for i, fqdnip := range fqdnips {
+		fqdns[i] = dpFqdnIps(fqdnip)
 	}
 
-	var start, end int = 0, 0
-	var first bool = true
-	var subnetPerMsg int = 600
-	var msg []byte
-
-	num := len(data_subnet)
-	log.WithFields(log.Fields{"policy_address_num": num}).Debug("config policy address")
-
-	for num > 0 || first {
-		var flag uint = 0
-
-	retry:
-		flag = 0
-		if start == 0 {
-			flag = C.MSG_START
-		}
-		if num <= subnetPerMsg {
-			flag |= C.MSG_END
-			end = start + num
-		} else {
-			end = start + subnetPerMsg
-		}
-		data := DPPolicyAddressCfgReq{
-			PolicyAddrCfg: &DPInternalSubnetCfg{
-				Flag:    flag,
-				Subnets: data_subnet[start:end],
-			},
-		}
-
-		msg, _ = json.Marshal(data)
-		sz := len(msg)
-		if sz > maxMsgSize {
-			// a very rough way to calculate rulesPerMsg
-			newSubnetPerMsg := maxMsgSize / (sz/(end-start) + 1)
-			if newSubnetPerMsg == subnetPerMsg {
-				newSubnetPerMsg--
+	for start := 0; start < len(fqdns); {
+		end := len(fqdns)
+		for {
+			data := DPFqdnIpsSetReq{
+				Fqdns: &DPFqdnIpsList{Fqdns: fqdns[start:end]},
 			}
-			if newSubnetPerMsg == 0 {
-				log.WithFields(log.Fields{"policy_address": data_subnet[start]}).Error("policy address too large")
-				return
+			msg, _ := json.Marshal(data)
+			if len(msg) <= maxMsgSize || end == start+1 {
+				if dpSendMsg(msg) < 0 {
+					return -1
+				}
+				break
 			}
-			subnetPerMsg = newSubnetPerMsg
-			goto retry
-		}
-
-		if dpSendMsg(msg) == -1 {
-			log.Debug("dpSendMsg error")
-			return
+			end = start + (end-start)/2
 		}
-		num = num + start - end
 		start = end
-		first = false
 	}
+	return 0
 }
 
-func DPCtrlConfigInternalSubnet(subnets map[string]share.CLUSSubnet) {
-	data_subnet := make([]DPSubnet, 0, len(subnets))
-	for _, addr := range subnets {
-		if !utils.IsIPv4(addr.Subnet.IP) {
-			continue
-		}
-		subnet := DPSubnet{
-			IP:   addr.Subnet.IP,
-			Mask: net.IP(addr.Subnet.Mask),
-		}
-		data_subnet = append(data_subnet, subnet)
-	}
-
-	var start, end int = 0, 0
-	var first bool = true
-	var subnetPerMsg int = 600
-	var msg []byte
-
-	num := len(data_subnet)
-	log.WithFields(log.Fields{"internal_subnet_num": num}).Debug("config internal subnet")
-
-	for num > 0 || first {
-		var flag uint = 0
+func DPCtrlConfigPolicyAddr(subnets map[string]share.CLUSSubnet) {
+	log.WithFields(log.Fields{"policy_address_num": len(subnets)}).Debug("config policy address")
 
-	retry:
-		flag = 0
-		if start == 0 {
-			flag = C.MSG_START
-		}
-		if num <= subnetPerMsg {
-			flag |= C.MSG_END
-			end = start + num
-		} else {
-			end = start + subnetPerMsg
-		}
-		data := DPInternalSubnetCfgReq{
-			SubnetCfg: &DPInternalSubnetCfg{
-				Flag:    flag,
-				Subnets: data_subnet[start:end],
-			},
-		}
+	if dpSendBinMsg(C.DP_CTRL_BIN_CFG_POLICY_ADDR, dpCtrlBinSubnets(subnets)) == -1 {
+		log.Debug("dpSendMsg error")
+	}
+}
 
-		msg, _ = json.Marshal(data)
-		sz := len(msg)
-		if sz > maxMsgSize {
-			// a very rough way to calculate rulesPerMsg
-			newSubnetPerMsg := maxMsgSize / (sz/(end-start) + 1)
-			if newSubnetPerMsg == subnetPerMsg {
-				newSubnetPerMsg--
-			}
-			if newSubnetPerMsg == 0 {
-				log.WithFields(log.Fields{"internal_subnet": data_subnet[start]}).Error("internal subnet too large")
-				return
-			}
-			subnetPerMsg = newSubnetPerMsg
-			goto retry
-		}
+func DPCtrlConfigInternalSubnet(subnets map[string]share.CLUSSubnet) {
+	log.WithFields(log.Fields{"internal_subnet_num": len(subnets)}).Debug("config internal subnet")
 
-		if dpSendMsg(msg) == -1 {
-			log.Debug("dpSendMsg error")
-			return
-		}
-		num = num + start - end
-		start = end
-		first = false
+	if dpSendBinMsg(C.DP_CTRL_BIN_CFG_INTERNAL_NET, dpCtrlBinSubnets(subnets)) == -1 {
+		log.Debug("dpSendMsg error")
 	}
 }
 
@@ -782,184 +1095,31 @@ func DPCtrlConfigSpecialIPSubnet(subnets map[string]share.CLUSSpecSubnet) {
 }
 
 func DPCtrlConfigDlp(wldlprule *DPWorkloadDlpRule) int {
-	var start, end int = 0, 0
-	var start1, end1 int = 0, 0
-	var first bool = true
-	var rulesPerMsg int = 40
-
-	num := len(wldlprule.DlpRuleNames)
-	num1 := len(wldlprule.WafRuleNames)
-	total := num + num1
 	log.WithFields(log.Fields{
 		"workload": wldlprule.WlID, "mac": wldlprule.WorkloadMac,
 		"policyids":  wldlprule.PolicyRuleIds,
 		"polwafids":  wldlprule.PolWafRuleIds,
-		"dlprulenum": num,
-		"wafrulenum": num1,
-		"total":      total,
+		"dlprulenum": len(wldlprule.DlpRuleNames),
+		"wafrulenum": len(wldlprule.WafRuleNames),
 	}).Debug("config dlp")
 
-	for total > 0 || first {
-		var flag uint = 0
-
-	retry:
-		flag = 0
-		if start == 0 {
-			flag = C.MSG_START
-		}
-		if total <= rulesPerMsg {
-			flag |= C.MSG_END
-			end = start + num
-			end1 = start1 + num1
-		} else {
-			tlen := rulesPerMsg / 2
-			if num <= tlen {
-				end = start + num
-				if num1 > (rulesPerMsg - num) {
-					end1 = start1 + (rulesPerMsg - num)
-				} else {
-					end1 = start1 + num1
-				}
-			} else {
-				end = start + tlen
-				if num1 > (rulesPerMsg - tlen) {
-					end1 = start1 + (rulesPerMsg - tlen)
-				} else {
-					end1 = start1 + num1
-				}
-			}
-		}
-		data := DPDlpCfgReq{
-			DPWlDlpCfg: &DPDlpCfg{
-				Flag:         flag,
-				WorkloadMac:  wldlprule.WorkloadMac,
-				DlpRuleNames: make([]*DPDlpRidSetting, 0),
-				WafRuleNames: make([]*DPDlpRidSetting, 0),
-				RuleIds:      wldlprule.PolicyRuleIds,
-				WafRuleIds:   wldlprule.PolWafRuleIds,
-				RuleType:     wldlprule.RuleType,
-				WafRuleType:  wldlprule.WafRuleType,
-			},
-		}
-		for _, drn := range wldlprule.DlpRuleNames[start:end] {
-			drids := &DPDlpRidSetting{
-				ID:     drn.ID,
-				Action: drn.Action,
-			}
-			data.DPWlDlpCfg.DlpRuleNames = append(data.DPWlDlpCfg.DlpRuleNames, drids)
-		}
-		for _, wrn := range wldlprule.WafRuleNames[start1:end1] {
-			wrids := &DPDlpRidSetting{
-				ID:     wrn.ID,
-				Action: wrn.Action,
-			}
-			data.DPWlDlpCfg.WafRuleNames = append(data.DPWlDlpCfg.WafRuleNames, wrids)
-		}
-		msg, _ := json.Marshal(data)
-		sz := len(msg)
-		if sz > maxMsgSize {
-			// a very rough way to calculate rulesPerMsg
-			newRulesPerMsg := maxMsgSize / (sz/((end-start)+(end1-start1)) + 1)
-			if newRulesPerMsg == rulesPerMsg {
-				newRulesPerMsg--
-			}
-			if newRulesPerMsg == 0 {
-				log.WithFields(log.Fields{
-					"DlpRuleNames": wldlprule.DlpRuleNames[start],
-					"WafRuleNames": wldlprule.WafRuleNames[start1]},
-				).Error("rulenames too large")
-				return -1
-			}
-			rulesPerMsg = newRulesPerMsg
-			goto retry
-		}
-
-		if dpSendMsg(msg) == -1 {
-			log.Debug("dpSendMsg error")
-			return -1
-		}
-		num = num + start - end
-		start = end
-		num1 = num1 + start1 - end1
-		start1 = end1
-		total = num + num1
-		first = false
+	if dpSendBinMsg(C.DP_CTRL_BIN_CFG_DLP, dpCtrlBinDlp(wldlprule)) == -1 {
+		log.Debug("dpSendMsg error")
+		return -1
 	}
 	return 0
 }
 
 func DPCtrlBldDlp(dlpRulesInfo []*DPDlpRuleEntry, dlpDpMacs utils.Set, delmacs utils.Set, dlpApplyDir int) int {
-	var start, end int = 0, 0
-	var first bool = true
-	var rulesPerMsg int = 40
-
-	num := len(dlpRulesInfo)
-	macNum := dlpDpMacs.Cardinality()
 	delmacNum := 0
 	if delmacs != nil {
 		delmacNum = delmacs.Cardinality()
 	}
 	log.WithFields(log.Fields{
-		"dlpRuleNum": num, "macNum": macNum, "delmacNum": delmacNum,
+		"dlpRuleNum": len(dlpRulesInfo), "macNum": dlpDpMacs.Cardinality(), "delmacNum": delmacNum,
 	}).Debug("build dlp")
 
-	for num > 0 || first {
-		var flag uint = 0
-
-	retry:
-		flag = 0
-		if start == 0 {
-			flag = C.MSG_START
-		}
-		if num <= rulesPerMsg {
-			flag |= C.MSG_END
-			end = start + num
-		} else {
-			end = start + rulesPerMsg
-		}
-		data := DPDlpBldReq{
-			DPDlpBld: &DPDlpBuild{
-				Flag:        flag,
-				ApplyDir:    dlpApplyDir,
-				DlpRules:    dlpRulesInfo[start:end],
-				WorkloadMac: make([]string, 0),
-				DelMac:      make([]string, 0),
-			},
-		}
-		for mc := range dlpDpMacs.Iter() {
-			data.DPDlpBld.WorkloadMac = append(data.DPDlpBld.WorkloadMac, mc.(string))
-		}
-		if delmacs != nil {
-			for dmc := range delmacs.Iter() {
-				data.DPDlpBld.DelMac = append(data.DPDlpBld.DelMac, dmc.(string))
-			}
-		}
-		msg, _ := json.Marshal(data)
-		sz := len(msg)
-		if sz > maxMsgSize {
-			// a very rough way to calculate rulesPerMsg
-			newRulesPerMsg := maxMsgSize / (sz/(end-start) + 1)
-			if newRulesPerMsg == rulesPerMsg {
-				newRulesPerMsg--
-			}
-			if newRulesPerMsg == 0 {
-				log.WithFields(log.Fields{
-					"DlpRules": dlpRulesInfo[start]},
-				).Error("rules too large")
-				return -1
-			}
-			rulesPerMsg = newRulesPerMsg
-			goto retry
-		}
-
-		if dpSendMsg(msg) == -1 {
-			return -1
-		}
-		num = num + start - end
-		start = end
-		first = false
-	}
-	return 0
+	return dpSendBinMsg(C.DP_CTRL_BIN_BLD_DLP, dpCtrlBinBldDlp(dlpRulesInfo, dlpDpMacs, delmacs, dlpApplyDir))
 }
 
 func DPCtrlBldDlpChgMac(oldmacs, addmacs, delmacs utils.Set) {
@@ -1041,10 +1201,10 @@ func dpKeepAlive() {
 	keepAliveSeq++
 	seq := keepAliveSeq
 	data := DPKeepAliveReq{
-		Alive: &DPKeepAlive{SeqNum: seq},
+		Alive: &DPKeepAlive{SeqNum: seq, Native: true},
 	}
 	msg, _ := json.Marshal(data)
-	dpSendMsgExSilent(msg, 3, cbKeepAlive, &seq)
+	dpSendMsgEx(msg, 3, cbKeepAlive, &seq)
 }
 
 func monitorDP() {
@@ -1068,11 +1228,13 @@ func monitorDP() {
 			if newConn != nil {
 				dpClientLock()
 				dpConn = newConn
-				// align msg with DP using keep alive
-				dpKeepAlive()
 				dpClientUnlock()
+				for n, conn := range newConn.conns {
+					go dpReceive(conn, n)
+				}
 
-				if dpConn != nil {
+				dpKeepAlive()
+				if Connected() {
 					log.Info("DP Connected")
 					dpConnJamRetry = 0
 					statusChan <- true
@@ -1086,9 +1248,7 @@ func monitorDP() {
 			}
 		} else if dpAliveMsgCnt == 0 {
 			// Only a best effort to avoid unecessary keep alive.
-			dpClientLock()
 			dpKeepAlive()
-			dpClientUnlock()
 
 			// Cannot send notify in closeDP() as it holds dpClientMutex, at the same time docker
 			// goroutine can send dp message but cannot get the mutex -> deadlock
@@ -1101,20 +1261,29 @@ func monitorDP() {
 	}
 }
 
-func connectDP() *net.UnixConn {
-	var conn *net.UnixConn
-	var err error
+// Connect to all dp instances, or none
+func connectDP() *dpConnSet {
+	set := &dpConnSet{}
 	kind := "unixgram"
-	lpath := getDPCtrlClientAddr()
-	laddr := net.UnixAddr{Name: lpath, Net: kind}
-	raddr := net.UnixAddr{Name: DPServer, Net: kind}
+	for n := 0; n < dpInstances; n++ {
+		lpath := dpInstanceName(getDPCtrlClientAddr(), n)
+		laddr := net.UnixAddr{Name: lpath, Net: kind}
+		raddr := net.UnixAddr{Name: dpInstanceName(DPServer, n), Net: kind}
+
+		conn, err := net.DialUnix(kind, &laddr, &raddr)
+		if err != nil {
+			set.Close()
+			removeDPClientAddrs()
+			return nil
+		}
+		set.conns = append(set.conns, conn)
+	}
+	return set
+}
 
-	conn, err = net.DialUnix(kind, &laddr, &raddr)
-	if err != nil {
-		os.Remove(lpath)
-		return nil
-	} else {
-		return conn
+func removeDPClientAddrs() {
+	for n := 0; n < dpInstances; n++ {
+		os.Remove(dpInstanceName(getDPCtrlClientAddr(), n))
 	}
 }
 
@@ -1124,7 +1293,7 @@ func closeDP() {
 		dpConn.Close()
 		dpConn = nil
 	}
-	os.Remove(getDPCtrlClientAddr())
+	removeDPClientAddrs()
 }
 
 func Open(cb DPTaskCallback, sc chan bool, ec chan interface{}) {
@@ -0,0 +1,336 @@
+package dp
+
+// #include "../../defs.h"
+import "C"
+
+import (
+	"bytes"
+	"encoding/binary"
+	"net"
+
+	"github.com/neuvector/neuvector/share"
+	"github.com/neuvector/neuvector/share/utils"
+	log "github.com/sirupsen/logrus"
+)
+
+// Binary encoding of the bulk dp configuration messages, see DPCtrlBinHdr in defs.h.
+// A message that doesn't fit in one datagram is passed to dp in a memfd, so it never
+// has to be split.
+
+const dpBinHdrSize int = 8
+
+type dpBinWriter struct {
+	bytes.Buffer
+}
+
+func (w *dpBinWriter) u8(v uint8) {
+	w.WriteByte(v)
+}
+
+func (w *dpBinWriter) u16(v uint16) {
+	var b [2]byte
+	binary.BigEndian.PutUint16(b[:], v)
+	w.Write(b[:])
+}
+
+func (w *dpBinWriter) u32(v uint32) {
+	var b [4]byte
+	binary.BigEndian.PutUint32(b[:], v)
+	w.Write(b[:])
+}
+
+func (w *dpBinWriter) pad(n int) {
+	for i := 0; i < n; i++ {
+		w.WriteByte(0)
+	}
+}
+
+// ipv4 is kept in network order, as inet_addr() returns it.
+func (w *dpBinWriter) ipv4(ip net.IP) {
+	if ip4 := ip.To4(); ip4 != nil {
+		w.Write(ip4)
+	} else {
+		w.pad(4)
+	}
+}
+
+// ipv6 is the 16 bytes of the address, a v4 address is written as its mapped form.
+func (w *dpBinWriter) ipv6(ip net.IP) {
+	if ip6 := ip.To16(); ip6 != nil {
+		w.Write(ip6)
+	} else {
+		w.pad(16)
+	}
+}
+
+func (w *dpBinWriter) mac(s string) {
+	var b [8]byte
+	if mac, err := net.ParseMAC(s); err == nil && len(mac) == 6 {
+		copy(b[:], mac)
+	}
+	w.Write(b[:])
+}
+
+func (w *dpBinWriter) str(s string) {
+	w.u16(uint16(len(s)))
+	w.WriteString(s)
+	w.pad((4 - (2+len(s))%4) % 4)
+}
+
+func dpSendBinMsg(kind uint8, payload []byte) int {
+	msg := make([]byte, dpBinHdrSize, dpBinHdrSize+len(payload))
+	msg[0] = C.DP_CTRL_BIN_MAGIC
+	msg[1] = kind
+	binary.BigEndian.PutUint32(msg[4:], uint32(len(payload)))
+	msg = append(msg, payload...)
+
+	if len(msg) <= maxMsgSize {
+		return dpSendMsg(msg)
+	}
+
+	dpClientLock()
+	defer dpClientUnlock()
+
+	if dpConn == nil {
+		log.Error("Data path not connected")
+		dpCfgTrack(msg, false)
+		return -1
+	}
+	err := dpWriteBinMsg(msg)
+	dpCfgTrack(msg, err == nil)
+	if err != nil {
+		return -1
+	}
+	return 0
+}
+
+// ipRuleFamily tells whether a rule goes in the ipv4 or ipv6 rule list. The zero address of
+// external peers is taken as "::" in an ipv6 rule. Rules mixing the two families can't match
+// anything and are left out.
+func ipRuleFamily(rule *DPPolicyIPRule) (v4, v6 bool) {
+	s4, d4 := rule.SrcIP.To4() != nil, rule.DstIP.To4() != nil
+	switch {
+	case s4 && d4:
+		return true, false
+	case !s4 && !d4:
+		return false, true
+	case s4:
+		return false, rule.SrcIP.Equal(net.IPv4zero)
+	default:
+		return false, rule.DstIP.Equal(net.IPv4zero)
+	}
+}
+
+func ipv6RuleAddr(ip net.IP) net.IP {
+	if ip.Equal(net.IPv4zero) {
+		return net.IPv6zero
+	}
+	return ip
+}
+
+func dpBinPolicyApps(w *dpBinWriter, rule *DPPolicyIPRule) {
+	for _, app := range rule.Apps {
+		w.u32(app.RuleID)
+		w.u32(app.App)
+		w.u8(app.Action)
+		w.pad(3)
+	}
+}
+
+func dpBinPolicyRule4(w *dpBinWriter, rule *DPPolicyIPRule) {
+	sipr, dipr := rule.SrcIPR, rule.DstIPR
+	if sipr == nil {
+		sipr = rule.SrcIP
+	}
+	if dipr == nil {
+		dipr = rule.DstIP
+	}
+	w.u32(rule.ID)
+	w.ipv4(rule.SrcIP)
+	w.ipv4(sipr)
+	w.ipv4(rule.DstIP)
+	w.ipv4(dipr)
+	w.u16(rule.Port)
+	w.u16(rule.PortR)
+	w.u8(rule.IPProto)
+	w.u8(rule.Action)
+	w.u8(boolToU8(rule.Ingress))
+	w.u8(boolToU8(rule.Vhost))
+	w.u16(uint16(len(rule.Apps)))
+	w.pad(2)
+	w.str(rule.Fqdn)
+	dpBinPolicyApps(w, rule)
+}
+
+func dpCtrlBinPolicy(policy *DPWorkloadIPPolicy, cmd uint) []byte {
+	var w dpBinWriter
+	var rules4, rules6 []*DPPolicyIPRule
+
+	for _, rule := range policy.IPRules {
+		if v4, v6 := ipRuleFamily(rule); v4 {
+			rules4 = append(rules4, rule)
+		} else if v6 && rule.Fqdn == "" {
+			rules6 = append(rules6, rule)
+		}
+	}
+
+	w.u16(uint16(cmd))
+	w.u16(C.MSG_START | C.MSG_END)
+	w.u8(policy.DefAction)
+	w.u8(uint8(policy.ApplyDir))
+	w.u16(uint16(len(policy.WorkloadMac)))
+	w.u32(uint32(len(rules4)))
+	w.u32(uint32(len(rules6)))
+	for _, mac := range policy.WorkloadMac {
+		w.mac(mac)
+	}
+	for _, rule := range rules4 {
+		dpBinPolicyRule4(&w, rule)
+	}
+	for _, rule := range rules6 {
+		sip, dip := ipv6RuleAddr(rule.SrcIP), ipv6RuleAddr(rule.DstIP)
+		sipr, dipr := rule.SrcIPR, rule.DstIPR
+		if sipr == nil {
+			sipr = sip
+		}
+		if dipr == nil {
+			dipr = dip
+		}
+		w.u32(rule.ID)
+		w.ipv6(sip)
+		w.ipv6(sipr)
+		w.ipv6(dip)
+		w.ipv6(dipr)
+		w.u16(rule.Port)
+		w.u16(rule.PortR)
+		w.u8(rule.IPProto)
+		w.u8(rule.Action)
+		w.u8(boolToU8(rule.Ingress))
+		w.u8(0)
+		w.u16(uint16(len(rule.Apps)))
+		w.pad(2)
+		dpBinPolicyApps(&w, rule)
+	}
+	return w.Bytes()
+}
+
+// dpCtrlBinPolicyDelta encodes the rule IDs to remove and the ipv4 rules to append to the
+// policy of the workload macs, see DPCtrlBinPolicyDelta.
+func dpCtrlBinPolicyDelta(macs []string, dels []uint32, adds []*DPPolicyIPRule) []byte {
+	var w dpBinWriter
+
+	w.u16(0)
+	w.u16(uint16(len(macs)))
+	w.u32(uint32(len(dels)))
+	w.u32(uint32(len(adds)))
+	for _, mac := range macs {
+		w.mac(mac)
+	}
+	for _, id := range dels {
+		w.u32(id)
+	}
+	for _, rule := range adds {
+		dpBinPolicyRule4(&w, rule)
+	}
+	return w.Bytes()
+}
+
+func dpCtrlBinSubnets(subnets map[string]share.CLUSSubnet) []byte {
+	var w dpBinWriter
+	var count uint32
+
+	for _, addr := range subnets {
+		if utils.IsIPv4(addr.Subnet.IP) {
+			count++
+		}
+	}
+
+	w.u16(C.MSG_START | C.MSG_END)
+	w.pad(2)
+	w.u32(count)
+	for _, addr := range subnets {
+		if !utils.IsIPv4(addr.Subnet.IP) {
+			continue
+		}
+		w.ipv4(addr.Subnet.IP)
+		w.ipv4(net.IP(addr.Subnet.Mask))
+	}
+	return w.Bytes()
+}
+
+func dpCtrlBinDlp(wldlprule *DPWorkloadDlpRule) []byte {
+	var w dpBinWriter
+
+	// All lists are always sent, as the JSON message does
+	w.u16(C.MSG_START | C.MSG_END)
+	w.u8(boolToU8(wldlprule.RuleType == share.DlpWlRuleIn))
+	w.u8(boolToU8(wldlprule.WafRuleType == share.WafWlRuleIn))
+	w.u16(C.DP_CTRL_BIN_DLP_RULE_IDS | C.DP_CTRL_BIN_DLP_WAF_RULE_IDS |
+		C.DP_CTRL_BIN_DLP_NAMES | C.DP_CTRL_BIN_DLP_WAF_NAMES)
+	w.u16(uint16(len(wldlprule.WorkloadMac)))
+	w.u32(uint32(len(wldlprule.PolicyRuleIds)))
+	w.u32(uint32(len(wldlprule.PolWafRuleIds)))
+	w.u32(uint32(len(wldlprule.DlpRuleNames)))
+	w.u32(uint32(len(wldlprule.WafRuleNames)))
+	for _, mac := range wldlprule.WorkloadMac {
+		w.mac(mac)
+	}
+	for _, id := range wldlprule.PolicyRuleIds {
+		w.u32(id)
+	}
+	for _, id := range wldlprule.PolWafRuleIds {
+		w.u32(id)
+	}
+	for _, rn := range wldlprule.DlpRuleNames {
+		w.u32(rn.ID)
+		w.u8(rn.Action)
+		w.pad(3)
+	}
+	for _, rn := range wldlprule.WafRuleNames {
+		w.u32(rn.ID)
+		w.u8(rn.Action)
+		w.pad(3)
+	}
+	return w.Bytes()
+}
+
+func dpCtrlBinBldDlp(dlpRulesInfo []*DPDlpRuleEntry, dlpDpMacs utils.Set, delmacs utils.Set, dlpApplyDir int) []byte {
+	var w dpBinWriter
+	var delmacNum int
+
+	if delmacs != nil {
+		delmacNum = delmacs.Cardinality()
+	}
+
+	w.u16(C.MSG_START | C.MSG_END)
+	w.u8(uint8(dlpApplyDir))
+	w.pad(1)
+	w.u32(uint32(dlpDpMacs.Cardinality()))
+	w.u32(uint32(delmacNum))
+	w.u32(uint32(len(dlpRulesInfo)))
+	for mc := range dlpDpMacs.Iter() {
+		w.mac(mc.(string))
+	}
+	if delmacs != nil {
+		for dmc := range delmacs.Iter() {
+			w.mac(dmc.(string))
+		}
+	}
+	for _, rule := range dlpRulesInfo {
+		w.u32(rule.ID)
+		w.u16(uint16(len(rule.Patterns)))
+		w.pad(2)
+		w.str(rule.Name)
+		for _, pat := range rule.Patterns {
+			w.str(pat)
+		}
+	}
+	return w.Bytes()
+}
+
+func boolToU8(b bool) uint8 {
+	if b {
+		return 1
+	}
+	return 0
+}
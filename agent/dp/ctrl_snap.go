@@ -0,0 +1,218 @@
+package dp
+
+// #include "../../defs.h"
+import "C"
+
+import (
+	"bytes"
+	"encoding/binary"
+	"encoding/json"
+	"os"
+	"time"
+	"unsafe"
+
+	log "github.com/sirupsen/logrus"
+	"golang.org/x/sys/unix"
+)
+
+// The dp journals the config messages it applies, see dp/snapshot.c. A restarted dp loads
+// the journal of the previous run but only replays it once the agent confirms, with
+// ctrl_cfg_restore, that it sent nothing the journal misses or that the agent still has.
+// The agent counts the config messages it sent since it reset the journal and keeps the
+// last ones, so a dp that lost the tail of its journal only gets that tail again.
+
+const dpCfgBacklogMax int = 8 * 1024 * 1024
+
+// Same list as g_cfg_cmds in dp/ctrl.c
+var dpCfgCmds map[string]bool = map[string]bool{
+	"ctrl_add_srvc_port": true, "ctrl_del_srvc_port": true,
+	"ctrl_add_port_pair": true, "ctrl_del_port_pair": true,
+	"ctrl_add_tap_port": true, "ctrl_del_tap_port": true,
+	"ctrl_add_nfq_port": true, "ctrl_del_nfq_port": true,
+	"ctrl_add_mac": true, "ctrl_del_mac": true,
+	"ctrl_add_macs": true, "ctrl_del_macs": true,
+	"ctrl_cfg_mac": true, "ctrl_cfg_nbe": true,
+	"ctrl_set_latency": true, "ctrl_set_threat_log_limit": true,
+	"ctrl_set_debug": true, "ctrl_set_dp_threads": true,
+	"ctrl_cfg_policy": true, "ctrl_cfg_del_fqdn": true, "ctrl_cfg_set_fqdn": true,
+	"ctrl_cfg_internal_net": true, "ctrl_cfg_specip_net": true, "ctrl_cfg_policy_addr": true,
+	"ctrl_cfg_dlp": true, "ctrl_cfg_dlpmac": true,
+	"ctrl_bld_dlp": true, "ctrl_bld_dlpmac": true,
+	"ctrl_sys_conf": true, "ctrl_connect_report": true,
+	"ctrl_disable_net_policy": true, "ctrl_detect_unmanaged_wl": true,
+	"ctrl_enable_icmp_policy": true, "ctrl_strict_group_mode": true,
+}
+
+// Protected by the client lock
+var dpCfg struct {
+	journal bool     // the dp journals the messages since the last reset
+	lost    bool     // a config message might not have reached the dp
+	sent    uint32   // config messages sent since the reset
+	backlog [][]byte // the last ones, inline binary messages with no flag
+	bytes   int
+}
+
+// Binary messages are all config, a JSON message is by its first key
+func dpCfgMsg(msg []byte) bool {
+	if len(msg) > 0 && msg[0] == C.DP_CTRL_BIN_MAGIC {
+		return true
+	}
+	if !bytes.HasPrefix(msg, []byte("{\"")) {
+		return false
+	}
+	end := bytes.IndexByte(msg[2:], '"')
+	return end > 0 && dpCfgCmds[string(msg[2:2+end])]
+}
+
+// With lock hold
+func dpCfgTrack(msg []byte, ok bool) {
+	if !dpCfg.journal || !dpCfgMsg(msg) {
+		return
+	}
+	if !ok {
+		dpCfg.lost = true
+		return
+	}
+
+	dpCfg.sent++
+	dpCfg.backlog = append(dpCfg.backlog, msg)
+	dpCfg.bytes += len(msg)
+	for len(dpCfg.backlog) > 0 && dpCfg.bytes > dpCfgBacklogMax {
+		dpCfg.bytes -= len(dpCfg.backlog[0])
+		dpCfg.backlog[0] = nil
+		dpCfg.backlog = dpCfg.backlog[1:]
+	}
+}
+
+// With lock hold. A binary message that doesn't fit in a datagram goes in a memfd.
+func dpWriteBinMsg(msg []byte) error {
+	if len(msg) <= maxMsgSize {
+		return dpWriteMsg(msg)
+	}
+
+	fd, err := unix.MemfdCreate("dp_ctrl", unix.MFD_CLOEXEC)
+	if err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Failed to create memfd")
+		return err
+	}
+	f := os.NewFile(uintptr(fd), "dp_ctrl")
+	defer f.Close()
+
+	if _, err = f.Write(msg[dpBinHdrSize:]); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Failed to write memfd")
+		return err
+	}
+
+	hdr := make([]byte, dpBinHdrSize)
+	copy(hdr, msg)
+	binary.BigEndian.PutUint16(hdr[2:], C.DP_CTRL_BIN_FLAG_MEMFD)
+
+	if dbgError := dpConn.SetWriteDeadline(time.Now().Add(time.Second * 2)); dbgError != nil {
+		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+	}
+	if _, _, err = dpConn.WriteMsgUnix(hdr, unix.UnixRights(fd), nil); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Send error")
+		return err
+	}
+	dpAliveMsgCnt++
+	return nil
+}
+
+// Start a new journal before the full config is pushed
+func DPCtrlCfgReset() {
+	log.Debug("")
+
+	data := DPCfgResetReq{
+		Reset: &DPEmpty{},
+	}
+	msg, _ := json.Marshal(data)
+
+	dpClientLock()
+	defer dpClientUnlock()
+
+	dpCfg.journal, dpCfg.lost = false, false
+	dpCfg.sent, dpCfg.backlog, dpCfg.bytes = 0, nil, 0
+	if dpConn == nil {
+		log.Error("Data path not connected")
+		return
+	}
+	if dpWriteMsg(msg) == nil {
+		dpCfg.journal = true
+	}
+}
+
+func cbCfgRestore(buf []byte, param interface{}) bool {
+	var m C.DPMsgCfgRestore
+
+	hdr := ParseDPMsgHeader(buf)
+	if hdr == nil || hdr.Kind != C.DP_KIND_CFG_RESTORE {
+		return false
+	}
+
+	r := bytes.NewReader(buf[int(unsafe.Sizeof(*hdr)):])
+	if err := binary.Read(r, binary.BigEndian, &m); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Short restore reply")
+		return true
+	}
+	if m.Valid != 0 {
+		*(param.(*uint32)) = uint32(m.Gen)
+	}
+	return true
+}
+
+// Ask a newly connected dp to replay its journal and resend what it misses. The full
+// config has to be pushed if it returns false.
+func DPCtrlCfgRestore() bool {
+	dpClientLock()
+	if !dpCfg.journal || dpCfg.lost {
+		dpClientUnlock()
+		return false
+	}
+	sent := dpCfg.sent
+	first := sent - uint32(len(dpCfg.backlog))
+	dpClientUnlock()
+
+	log.WithFields(log.Fields{"gen": sent, "min": first}).Debug("")
+
+	data := DPCfgRestoreReq{
+		Restore: &DPCfgRestore{Gen: sent, Min: first},
+	}
+	msg, _ := json.Marshal(data)
+
+	// The dp answers with a valid generation in [first, sent]
+	cur := sent + 1
+	if dpSendMsgEx(msg, 30, cbCfgRestore, &cur) != 0 || cur > sent || cur < first {
+		return false
+	}
+
+	dpClientLock()
+	defer dpClientUnlock()
+
+	if dpConn == nil || dpCfg.sent != sent || dpCfg.lost {
+		return false
+	}
+
+	resend := dpCfg.backlog[cur-first:]
+	dpCfg.backlog = dpCfg.backlog[:cur-first]
+	dpCfg.sent = cur
+	dpCfg.bytes = 0
+	for _, m := range dpCfg.backlog {
+		dpCfg.bytes += len(m)
+	}
+
+	log.WithFields(log.Fields{"gen": cur, "resend": len(resend)}).Info("Restore dp config")
+
+	for _, m := range resend {
+		var err error
+		if m[0] == C.DP_CTRL_BIN_MAGIC {
+			err = dpWriteBinMsg(m)
+		} else {
+			err = dpWriteMsg(m)
+		}
+		dpCfgTrack(m, err == nil)
+		if err != nil {
+			return false
+		}
+	}
+	return true
+}
@@ -7,8 +7,10 @@ import (
 	"bytes"
 	"encoding/base64"
 	"encoding/binary"
+	"io"
 	"net"
 	"os"
+	"sync/atomic"
 	"syscall"
 	"time"
 	"unsafe"
@@ -127,6 +129,167 @@ func dpMsgThreatLog(msg []byte) {
 	taskCallback(&task)
 }
 
+// Threat log rings shared by dp, see DPLogShmHdr. Mapped on the first notice and kept, dp
+// truncates the same file when it restarts. Each dp instance has its own rings.
+const dpLogShmPath string = "/dev/shm" + C.DP_LOG_SHM_NAME
+
+var dpLogShm [dpNumaMax][]byte
+var dpLogDrops [dpNumaMax][]uint64
+
+func dpLogShmMap(n int) []byte {
+	if dpLogShm[n] != nil {
+		return dpLogShm[n]
+	}
+
+	f, err := os.OpenFile(dpInstanceName(dpLogShmPath, n), os.O_RDWR, 0)
+	if err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Open threat log rings")
+		return nil
+	}
+	defer f.Close()
+
+	info, err := f.Stat()
+	if err != nil || info.Size() < int64(unsafe.Sizeof(C.DPLogShmHdr{})) {
+		log.WithFields(log.Fields{"error": err}).Error("Wrong threat log rings")
+		return nil
+	}
+	mem, err := syscall.Mmap(int(f.Fd()), 0, int(info.Size()), syscall.PROT_READ|syscall.PROT_WRITE, syscall.MAP_SHARED)
+	if err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Map threat log rings")
+		return nil
+	}
+	dpLogShm[n] = mem
+	return dpLogShm[n]
+}
+
+// The notice doesn't tell which dp instance sent it, the rings of all instances are read
+func dpMsgThreatLogRing() {
+	for n := 0; n < dpInstances; n++ {
+		dpThreatLogRings(n)
+	}
+}
+
+// Read all logs of all rings of the dp instance, then give the entries back to dp
+func dpThreatLogRings(n int) {
+	mem := dpLogShmMap(n)
+	if mem == nil {
+		return
+	}
+
+	hdr := (*C.DPLogShmHdr)(unsafe.Pointer(&mem[0]))
+	if atomic.LoadUint32((*uint32)(unsafe.Pointer(&hdr.Magic))) != C.DP_LOG_SHM_MAGIC {
+		return
+	}
+
+	hdrLen := int(unsafe.Sizeof(*hdr))
+	ringSize := int(hdr.RingSize)
+	entries := uint32(hdr.Entries)
+	if ringSize != int(unsafe.Sizeof(C.DPLogRing{})) || entries != C.DP_LOG_RING_ENTRIES {
+		log.WithFields(log.Fields{"size": ringSize, "entries": entries}).Error("Wrong threat log ring")
+		return
+	}
+	drops := dpLogDrops[n]
+	if len(drops) < int(hdr.Rings) {
+		drops = make([]uint64, hdr.Rings)
+		dpLogDrops[n] = drops
+	}
+
+	for i := 0; i < int(hdr.Rings) && hdrLen+(i+1)*ringSize <= len(mem); i++ {
+		ring := (*C.DPLogRing)(unsafe.Pointer(&mem[hdrLen+i*ringSize]))
+		writer := atomic.LoadUint32((*uint32)(unsafe.Pointer(&ring.Writer)))
+		reader := atomic.LoadUint32((*uint32)(unsafe.Pointer(&ring.Reader)))
+		if writer-reader > entries {
+			reader = writer - entries
+		}
+		for ; reader != writer; reader++ {
+			entry := &ring.Logs[reader%entries]
+			dpMsgThreatLog(C.GoBytes(unsafe.Pointer(entry), C.int(unsafe.Sizeof(*entry))))
+		}
+		atomic.StoreUint32((*uint32)(unsafe.Pointer(&ring.Reader)), reader)
+
+		dropped := atomic.LoadUint64((*uint64)(unsafe.Pointer(&ring.Drops)))
+		if dropped > drops[i] {
+			log.WithFields(log.Fields{"instance": n, "ring": i, "drops": dropped - drops[i]}).Error("Threat logs lost")
+		}
+		drops[i] = dropped
+	}
+}
+
+func dpConnection(conn *C.DPMsgConnect) *ConnectionData {
+	cc := &Connection{
+		ServerPort:   uint16(conn.ServerPort),
+		ClientPort:   uint16(conn.ClientPort),
+		IPProto:      uint8(conn.IPProto),
+		Bytes:        uint64(conn.Bytes),
+		Sessions:     uint32(conn.Sessions),
+		FirstSeenAt:  uint32(conn.FirstSeenAt),
+		LastSeenAt:   uint32(conn.LastSeenAt),
+		ThreatID:     uint32(conn.ThreatID),
+		Severity:     uint8(conn.Severity),
+		PolicyAction: uint8(conn.PolicyAction),
+		Application:  uint32(conn.Application),
+		PolicyId:     uint32(conn.PolicyId),
+		Violates:     uint32(conn.Violates),
+		EpSessCurIn:  uint32(conn.EpSessCurIn),
+		EpSessIn12:   uint32(conn.EpSessIn12),
+		EpByteIn12:   uint64(conn.EpByteIn12),
+	}
+	switch uint16(conn.EtherType) {
+	case syscall.ETH_P_IP:
+		cc.ClientIP = net.IP(C.GoBytes(unsafe.Pointer(&conn.ClientIP[0]), 4))
+		cc.ServerIP = net.IP(C.GoBytes(unsafe.Pointer(&conn.ServerIP[0]), 4))
+	case syscall.ETH_P_IPV6:
+		cc.ClientIP = net.IP(C.GoBytes(unsafe.Pointer(&conn.ClientIP[0]), 16))
+		cc.ServerIP = net.IP(C.GoBytes(unsafe.Pointer(&conn.ServerIP[0]), 16))
+	}
+	if (conn.Flags & C.DPCONN_FLAG_INGRESS) != 0 {
+		cc.Ingress = true
+	}
+	if (conn.Flags & C.DPCONN_FLAG_EXTERNAL) != 0 {
+		// Peer that is not on the host or container's subnet
+		cc.ExternalPeer = true
+	}
+	if (conn.Flags & C.DPCONN_FLAG_XFF) != 0 {
+		// connection is xff induced
+		cc.Xff = true
+	}
+	if (conn.Flags & C.DPCONN_FLAG_SVC_EXTIP) != 0 {
+		// connection has client->svcExtIP violation
+		cc.SvcExtIP = true
+	}
+	if (conn.Flags & C.DPCONN_FLAG_MESH_TO_SVR) != 0 {
+		// appcontainer to sidecar connection has
+		// client to remote svr detection
+		cc.MeshToSvr = true
+	}
+	if (conn.Flags & C.DPCONN_FLAG_LINK_LOCAL) != 0 {
+		// link local 169.254.0.0 is special svc loopback
+		// used by cilium CNI
+		cc.LinkLocal = true
+	}
+	if (conn.Flags & C.DPCONN_FLAG_TMP_OPEN) != 0 {
+		// temporary OPEN connection
+		cc.TmpOpen = true
+	}
+	if (conn.Flags & C.DPCONN_FLAG_UWLIP) != 0 {
+		// uwl connection
+		cc.UwlIp = true
+	}
+	if (conn.Flags & C.DPCONN_FLAG_CHK_NBE) != 0 {
+		// connection cross namespace
+		cc.Nbe = true
+	}
+	if (conn.Flags & C.DPCONN_FLAG_NBE_SNS) != 0 {
+		// connection cross same namespace
+		cc.NbeSns = true
+	}
+
+	return &ConnectionData{
+		EPMAC: net.HardwareAddr(C.GoBytes(unsafe.Pointer(&conn.EPMAC[0]), 6)),
+		Conn:  cc,
+	}
+}
+
 func dpMsgConnection(msg []byte) {
 	var connHdr C.DPMsgConnectHdr
 	var conn C.DPMsgConnect
@@ -155,82 +318,18 @@ func dpMsgConnection(msg []byte) {
 
 	conns := make([]*ConnectionData, count)
 
-	for i := 0; i < count; i++ {
-		if dbgError := binary.Read(r, binary.BigEndian, &conn); dbgError != nil {
-			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-		}
-
-		cc := &Connection{
-			ServerPort:   uint16(conn.ServerPort),
-			ClientPort:   uint16(conn.ClientPort),
-			IPProto:      uint8(conn.IPProto),
-			Bytes:        uint64(conn.Bytes),
-			Sessions:     uint32(conn.Sessions),
-			FirstSeenAt:  uint32(conn.FirstSeenAt),
-			LastSeenAt:   uint32(conn.LastSeenAt),
-			ThreatID:     uint32(conn.ThreatID),
-			Severity:     uint8(conn.Severity),
-			PolicyAction: uint8(conn.PolicyAction),
-			Application:  uint32(conn.Application),
-			PolicyId:     uint32(conn.PolicyId),
-			Violates:     uint32(conn.Violates),
-			EpSessCurIn:  uint32(conn.EpSessCurIn),
-			EpSessIn12:   uint32(conn.EpSessIn12),
-			EpByteIn12:   uint64(conn.EpByteIn12),
-		}
-		switch uint16(conn.EtherType) {
-		case syscall.ETH_P_IP:
-			cc.ClientIP = net.IP(C.GoBytes(unsafe.Pointer(&conn.ClientIP[0]), 4))
-			cc.ServerIP = net.IP(C.GoBytes(unsafe.Pointer(&conn.ServerIP[0]), 4))
-		case syscall.ETH_P_IPV6:
-			cc.ClientIP = net.IP(C.GoBytes(unsafe.Pointer(&conn.ClientIP[0]), 16))
-			cc.ServerIP = net.IP(C.GoBytes(unsafe.Pointer(&conn.ServerIP[0]), 16))
-		}
-		if (conn.Flags & C.DPCONN_FLAG_INGRESS) != 0 {
-			cc.Ingress = true
-		}
-		if (conn.Flags & C.DPCONN_FLAG_EXTERNAL) != 0 {
-			// Peer that is not on the host or container's subnet
-			cc.ExternalPeer = true
-		}
-		if (conn.Flags & C.DPCONN_FLAG_XFF) != 0 {
-			// connection is xff induced
-			cc.Xff = true
-		}
-		if (conn.Flags & C.DPCONN_FLAG_SVC_EXTIP) != 0 {
-			// connection has client->svcExtIP violation
-			cc.SvcExtIP = true
-		}
-		if (conn.Flags & C.DPCONN_FLAG_MESH_TO_SVR) != 0 {
-			// appcontainer to sidecar connection has
-			// client to remote svr detection
-			cc.MeshToSvr = true
-		}
-		if (conn.Flags & C.DPCONN_FLAG_LINK_LOCAL) != 0 {
-			// link local 169.254.0.0 is special svc loopback
-			// used by cilium CNI
-			cc.LinkLocal = true
-		}
-		if (conn.Flags & C.DPCONN_FLAG_TMP_OPEN) != 0 {
-			// temporary OPEN connection
-			cc.TmpOpen = true
-		}
-		if (conn.Flags & C.DPCONN_FLAG_UWLIP) != 0 {
-			// uwl connection
-			cc.UwlIp = true
+	if uint16(connHdr.Flags)&C.DP_MSG_FLAG_NATIVE != 0 {
+		// Host order, entries are read in place
+		connLen := int(unsafe.Sizeof(conn))
+		for i := 0; i < count; i++ {
+			conns[i] = dpConnection((*C.DPMsgConnect)(unsafe.Pointer(&msg[connHdrLen+i*connLen])))
 		}
-		if (conn.Flags & C.DPCONN_FLAG_CHK_NBE) != 0 {
-			// connection cross namespace
-			cc.Nbe = true
-		}
-		if (conn.Flags & C.DPCONN_FLAG_NBE_SNS) != 0 {
-			// connection cross same namespace
-			cc.NbeSns = true
-		}
-
-		conns[i] = &ConnectionData{
-			EPMAC: net.HardwareAddr(C.GoBytes(unsafe.Pointer(&conn.EPMAC[0]), 6)),
-			Conn:  cc,
+	} else {
+		for i := 0; i < count; i++ {
+			if dbgError := binary.Read(r, binary.BigEndian, &conn); dbgError != nil {
+				log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+			}
+			conns[i] = dpConnection(&conn)
 		}
 	}
 
@@ -238,77 +337,203 @@ func dpMsgConnection(msg []byte) {
 	taskCallback(&task)
 }
 
-func dpMsgFqdnIpUpdate(msg []byte) {
-	var fqdnIpHdr C.DPMsgFqdnIpHdr
-	var fqdnIp C.DPMsgFqdnIp
+func dpConnectIP(r *bytes.Reader, ip *[16]C.uint8_t, etherType C.uint16_t) error {
+	n := 4
+	if uint16(etherType) == syscall.ETH_P_IPV6 {
+		n = 16
+	}
+	var b [16]byte
+	if _, err := io.ReadFull(r, b[:n]); err != nil {
+		return err
+	}
+	for i := range ip {
+		ip[i] = C.uint8_t(b[i])
+	}
+	return nil
+}
+
+// Update the field of the entry being decoded, see DP_KIND_CONNECTION_COMPACT
+func dpConnectField(r *bytes.Reader, conn *C.DPMsgConnect, field int) error {
+	switch field {
+	case C.DPCONN_FIELD_EPMAC:
+		var b [6]byte
+		if _, err := io.ReadFull(r, b[:]); err != nil {
+			return err
+		}
+		for i := range conn.EPMAC {
+			conn.EPMAC[i] = C.uint8_t(b[i])
+		}
+		return nil
+	case C.DPCONN_FIELD_CLIENT_IP:
+		return dpConnectIP(r, &conn.ClientIP, conn.EtherType)
+	case C.DPCONN_FIELD_SERVER_IP:
+		return dpConnectIP(r, &conn.ServerIP, conn.EtherType)
+	}
+
+	v, err := binary.ReadUvarint(r)
+	if err != nil {
+		return err
+	}
+	switch field {
+	case C.DPCONN_FIELD_IPPROTO:
+		conn.IPProto = C.uint8_t(v)
+	case C.DPCONN_FIELD_SERVER_PORT:
+		conn.ServerPort = C.uint16_t(v)
+	case C.DPCONN_FIELD_CLIENT_PORT:
+		conn.ClientPort = C.uint16_t(v)
+	case C.DPCONN_FIELD_ETHER_TYPE:
+		conn.EtherType = C.uint16_t(v)
+	case C.DPCONN_FIELD_FLAGS:
+		conn.Flags = C.uint16_t(v)
+	case C.DPCONN_FIELD_BYTES:
+		conn.Bytes = C.uint32_t(v)
+	case C.DPCONN_FIELD_SESSIONS:
+		conn.Sessions = C.uint32_t(v)
+	case C.DPCONN_FIELD_FIRST_SEEN:
+		conn.FirstSeenAt = C.uint32_t(v)
+	case C.DPCONN_FIELD_LAST_SEEN:
+		conn.LastSeenAt = C.uint32_t(v)
+	case C.DPCONN_FIELD_APPLICATION:
+		conn.Application = C.uint16_t(v)
+	case C.DPCONN_FIELD_POLICY_ACTION:
+		conn.PolicyAction = C.uint8_t(v)
+	case C.DPCONN_FIELD_SEVERITY:
+		conn.Severity = C.uint8_t(v)
+	case C.DPCONN_FIELD_POLICY_ID:
+		conn.PolicyId = C.uint32_t(v)
+	case C.DPCONN_FIELD_VIOLATES:
+		conn.Violates = C.uint32_t(v)
+	case C.DPCONN_FIELD_THREAT_ID:
+		conn.ThreatID = C.uint32_t(v)
+	case C.DPCONN_FIELD_SESS_CUR_IN:
+		conn.EpSessCurIn = C.uint32_t(v)
+	case C.DPCONN_FIELD_SESS_IN12:
+		conn.EpSessIn12 = C.uint32_t(v)
+	case C.DPCONN_FIELD_BYTE_IN12:
+		conn.EpByteIn12 = C.uint64_t(v)
+	}
+	return nil
+}
+
+func dpMsgConnectionCompact(msg []byte) {
+	var connHdr C.DPMsgConnectHdr
+	var conn C.DPMsgConnect
+
 	// Verify header length
-	fqdnIpHdrLen := int(unsafe.Sizeof(fqdnIpHdr))
-	if len(msg) < fqdnIpHdrLen {
-		log.WithFields(log.Fields{"expect": fqdnIpHdrLen, "actual": len(msg)}).Error("Short header")
+	connHdrLen := int(unsafe.Sizeof(connHdr))
+	if len(msg) < connHdrLen {
+		log.WithFields(log.Fields{"expect": connHdrLen, "actual": len(msg)}).Error("Short header")
 		return
 	}
 
 	r := bytes.NewReader(msg)
-	if dbgError := binary.Read(r, binary.BigEndian, &fqdnIpHdr); dbgError != nil {
+	if dbgError := binary.Read(r, binary.BigEndian, &connHdr); dbgError != nil {
 		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 	}
 
-	// Verify total length
-	ipcnt := int(fqdnIpHdr.IpCnt)
-	totalLen := fqdnIpHdrLen + int(unsafe.Sizeof(fqdnIp))*ipcnt
-	if len(msg) != totalLen {
-		log.WithFields(log.Fields{
-			"ipcnt": ipcnt, "expect": totalLen, "actual": len(msg),
-		}).Error("Wrong message length.")
+	// Fields not in the mask are kept from the previous entry
+	count := int(connHdr.Connects)
+	conns := make([]*ConnectionData, 0, count)
+
+	for i := 0; i < count; i++ {
+		mask, err := binary.ReadUvarint(r)
+		for f := 0; err == nil && f < C.DPCONN_FIELD_MAX; f++ {
+			if mask&(1<<uint(f)) != 0 {
+				err = dpConnectField(r, &conn, f)
+			}
+		}
+		if err != nil {
+			log.WithFields(log.Fields{"connects": count, "entry": i, "error": err}).Error("Truncated entry")
+			return
+		}
+		conns = append(conns, dpConnection(&conn))
+	}
+	if r.Len() != 0 {
+		log.WithFields(log.Fields{"connects": count, "left": r.Len()}).Error("Wrong message length.")
 		return
 	}
 
-	fqdns := &share.CLUSFqdnIp{
-		FqdnIP: make([]net.IP, 0),
-	}
+	task := DPTask{Task: DP_TASK_CONNECTION, Connects: conns}
+	taskCallback(&task)
+}
 
-	fqdns.FqdnName = C.GoString(&fqdnIpHdr.FqdnName[0])
-	if (fqdnIpHdr.Flags & C.DPFQDN_IP_FLAG_VH) != 0 {
-		fqdns.Vhost = true
-	}
+// The message packs the records of one or more names
+func dpMsgFqdnIpUpdate(msg []byte) {
+	var fqdnIpHdr C.DPMsgFqdnIpHdr
+	var fqdnIp C.DPMsgFqdnIp
+	fqdnIpHdrLen := int(unsafe.Sizeof(fqdnIpHdr))
+	fqdnIpLen := int(unsafe.Sizeof(fqdnIp))
 
-	for i := 0; i < ipcnt; i++ {
-		if dbgError := binary.Read(r, binary.BigEndian, &fqdnIp); dbgError != nil {
+	r := bytes.NewReader(msg)
+	for r.Len() > 0 {
+		// Verify header length
+		if r.Len() < fqdnIpHdrLen {
+			log.WithFields(log.Fields{"expect": fqdnIpHdrLen, "actual": r.Len()}).Error("Short header")
+			return
+		}
+		if dbgError := binary.Read(r, binary.BigEndian, &fqdnIpHdr); dbgError != nil {
 			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 		}
-		fqdns.FqdnIP = append(fqdns.FqdnIP, net.IP(C.GoBytes(unsafe.Pointer(&fqdnIp.FqdnIP[0]), 4)))
-	}
-	log.WithFields(log.Fields{"fqdns": fqdns}).Debug("")
 
-	task := DPTask{Task: DP_TASK_FQDN_IP, Fqdns: fqdns}
-	taskCallback(&task)
+		// Verify record length
+		ipcnt := int(fqdnIpHdr.IpCnt)
+		if r.Len() < fqdnIpLen*ipcnt {
+			log.WithFields(log.Fields{
+				"ipcnt": ipcnt, "expect": fqdnIpLen * ipcnt, "actual": r.Len(),
+			}).Error("Wrong message length.")
+			return
+		}
+
+		fqdns := &share.CLUSFqdnIp{
+			FqdnIP: make([]net.IP, 0, ipcnt),
+		}
+
+		fqdns.FqdnName = C.GoString(&fqdnIpHdr.FqdnName[0])
+		if (fqdnIpHdr.Flags & C.DPFQDN_IP_FLAG_VH) != 0 {
+			fqdns.Vhost = true
+		}
+
+		for i := 0; i < ipcnt; i++ {
+			if dbgError := binary.Read(r, binary.BigEndian, &fqdnIp); dbgError != nil {
+				log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+			}
+			fqdns.FqdnIP = append(fqdns.FqdnIP, net.IP(C.GoBytes(unsafe.Pointer(&fqdnIp.FqdnIP[0]), 4)))
+		}
+		log.WithFields(log.Fields{"fqdns": fqdns}).Debug("")
+
+		task := DPTask{Task: DP_TASK_FQDN_IP, Fqdns: fqdns}
+		taskCallback(&task)
+	}
 }
 
+// The message packs one or more records
 func dpMsgIpFqdnStorageUpdate(msg []byte) {
 	var ipFqdnStorageUpdateHdr C.DPMsgIpFqdnStorageUpdateHdr
-	// Verify header length
+	// Verify length
 	ipFqdnStorageUpdateHdrLen := int(unsafe.Sizeof(ipFqdnStorageUpdateHdr))
-	if len(msg) < ipFqdnStorageUpdateHdrLen {
-		log.WithFields(log.Fields{"expect": ipFqdnStorageUpdateHdrLen, "actual": len(msg)}).Error("Short header")
+	if len(msg) < ipFqdnStorageUpdateHdrLen || len(msg)%ipFqdnStorageUpdateHdrLen != 0 {
+		log.WithFields(log.Fields{"record": ipFqdnStorageUpdateHdrLen, "actual": len(msg)}).Error("Wrong message length.")
 		return
 	}
 
 	r := bytes.NewReader(msg)
-	if dbgError := binary.Read(r, binary.BigEndian, &ipFqdnStorageUpdateHdr); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	for r.Len() > 0 {
+		if dbgError := binary.Read(r, binary.BigEndian, &ipFqdnStorageUpdateHdr); dbgError != nil {
+			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+		}
 
-	ip := net.IP(C.GoBytes(unsafe.Pointer(&ipFqdnStorageUpdateHdr.IP[0]), 4))
-	name := C.GoString(&ipFqdnStorageUpdateHdr.Name[0])
-	ipFqdnStorageUpdate := &IpFqdnStorageUpdate{
-		IP:   ip,
-		Name: name,
-	}
+		ip := net.IP(C.GoBytes(unsafe.Pointer(&ipFqdnStorageUpdateHdr.IP[0]), 4))
+		name := C.GoString(&ipFqdnStorageUpdateHdr.Name[0])
+		ipFqdnStorageUpdate := &IpFqdnStorageUpdate{
+			IP:   ip,
+			Name: name,
+		}
 
-	log.WithFields(log.Fields{"update ipFqdnStorage": ipFqdnStorageUpdate}).Debug("")
+		log.WithFields(log.Fields{"update ipFqdnStorage": ipFqdnStorageUpdate}).Debug("")
 
-	task := DPTask{Task: DP_TASK_IP_FQDN_STORAGE_UPDATE, FqdnStorageUpdate: ipFqdnStorageUpdate}
-	taskCallback(&task)
+		task := DPTask{Task: DP_TASK_IP_FQDN_STORAGE_UPDATE, FqdnStorageUpdate: ipFqdnStorageUpdate}
+		taskCallback(&task)
+	}
 }
 
 func dpMsgIpFqdnStorageRelease(msg []byte) {
@@ -333,6 +558,207 @@ func dpMsgIpFqdnStorageRelease(msg []byte) {
 	taskCallback(&task)
 }
 
+func dpMsgOverload(msg []byte) {
+	var m C.DPMsgOverload
+	mLen := int(unsafe.Sizeof(m))
+	if len(msg) < mLen {
+		log.WithFields(log.Fields{"expect": mLen, "actual": len(msg)}).Error("Short message")
+		return
+	}
+
+	r := bytes.NewReader(msg)
+	if dbgError := binary.Read(r, binary.BigEndian, &m); dbgError != nil {
+		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+		return
+	}
+
+	overload := &DPOverload{
+		Thread:       int(m.Thread),
+		Overloaded:   m.Overloaded != 0,
+		Enters:       uint32(m.Enters),
+		Seconds:      uint32(m.Seconds),
+		ShedSessions: uint64(m.ShedSessions),
+		ShedInspects: uint64(m.ShedInspects),
+	}
+
+	log.WithFields(log.Fields{"overload": overload}).Info()
+
+	task := DPTask{Task: DP_TASK_OVERLOAD, Overload: overload}
+	taskCallback(&task)
+}
+
+// Decode a DP_KIND_LATENCY message, 'more' is set if other messages follow
+func ParseDPLatency(buf []byte) (hists []*DPLatencyHist, more bool) {
+	var lh C.DPMsgLatencyHdr
+	var mh C.DPMsgLatencyHist
+	var mb C.DPMsgLatencyBucket
+
+	hdr := ParseDPMsgHeader(buf)
+	if hdr == nil || hdr.Kind != C.DP_KIND_LATENCY {
+		return nil, false
+	}
+
+	r := bytes.NewReader(buf[int(unsafe.Sizeof(*hdr)):])
+	if err := binary.Read(r, binary.BigEndian, &lh); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Short header")
+		return nil, false
+	}
+
+	hz := uint64(lh.TscHz)
+	if hz == 0 {
+		return nil, hdr.More != 0
+	}
+	ns := func(ticks C.uint64_t) uint64 {
+		return uint64(float64(ticks) * 1e9 / float64(hz))
+	}
+
+	hists = make([]*DPLatencyHist, 0, int(lh.Hists))
+	for i := 0; i < int(lh.Hists); i++ {
+		if err := binary.Read(r, binary.BigEndian, &mh); err != nil {
+			log.WithFields(log.Fields{"error": err}).Error("Truncated histogram")
+			return hists, false
+		}
+		h := &DPLatencyHist{
+			Hist: int(mh.Hist), Count: uint64(mh.Count), Sum: ns(mh.Sum), Max: ns(mh.Max),
+			Buckets: make([]DPLatencyBucket, int(mh.Buckets)),
+		}
+		for j := range h.Buckets {
+			if err := binary.Read(r, binary.BigEndian, &mb); err != nil {
+				log.WithFields(log.Fields{"error": err}).Error("Truncated histogram")
+				return hists, false
+			}
+			h.Buckets[j] = DPLatencyBucket{Low: ns(mb.Low), Count: uint64(mb.Count)}
+		}
+		hists = append(hists, h)
+	}
+	return hists, hdr.More != 0
+}
+
+// Decode a DP_KIND_FWD_LATENCY message, 'more' is set if other messages follow
+func ParseDPFwdLatency(buf []byte) (lats []*DPFwdLatency, more bool) {
+	var fh C.DPMsgFwdLatencyHdr
+	var mf C.DPMsgFwdLatency
+	var mb C.DPMsgLatencyBucket
+
+	hdr := ParseDPMsgHeader(buf)
+	if hdr == nil || hdr.Kind != C.DP_KIND_FWD_LATENCY {
+		return nil, false
+	}
+
+	r := bytes.NewReader(buf[int(unsafe.Sizeof(*hdr)):])
+	if err := binary.Read(r, binary.BigEndian, &fh); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Short header")
+		return nil, false
+	}
+
+	lats = make([]*DPFwdLatency, 0, int(fh.Ctxs))
+	for i := 0; i < int(fh.Ctxs); i++ {
+		if err := binary.Read(r, binary.BigEndian, &mf); err != nil {
+			log.WithFields(log.Fields{"error": err}).Error("Truncated histogram")
+			return lats, false
+		}
+		l := &DPFwdLatency{
+			Iface: C.GoString(&mf.Iface[0]), Count: uint64(mf.Count), Sum: uint64(mf.Sum), Max: uint64(mf.Max),
+			Buckets: make([]DPLatencyBucket, int(mf.Buckets)),
+		}
+		for j := range l.Buckets {
+			if err := binary.Read(r, binary.BigEndian, &mb); err != nil {
+				log.WithFields(log.Fields{"error": err}).Error("Truncated histogram")
+				return lats, false
+			}
+			l.Buckets[j] = DPLatencyBucket{Low: uint64(mb.Low), Count: uint64(mb.Count)}
+		}
+		lats = append(lats, l)
+	}
+	return lats, hdr.More != 0
+}
+
+// Decode a DP_KIND_POLICY_HITS message into hits, 'more' is set if other messages follow
+func ParseDPPolicyHits(buf []byte, hits *DPPolicyHits) (more bool) {
+	var ph C.DPMsgPolicyHitsHdr
+	var mh C.DPMsgPolicyHit
+
+	hdr := ParseDPMsgHeader(buf)
+	if hdr == nil || hdr.Kind != C.DP_KIND_POLICY_HITS {
+		return false
+	}
+
+	r := bytes.NewReader(buf[int(unsafe.Sizeof(*hdr)):])
+	if err := binary.Read(r, binary.BigEndian, &ph); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Short header")
+		return false
+	}
+
+	hits.Since = uint32(ph.Since)
+	hits.Overflow = uint64(ph.Overflow)
+	for i := 0; i < int(ph.Hits); i++ {
+		if err := binary.Read(r, binary.BigEndian, &mh); err != nil {
+			log.WithFields(log.Fields{"error": err}).Error("Truncated rule hits")
+			return false
+		}
+		hits.Hits = append(hits.Hits, DPPolicyHit{ID: uint32(mh.ID), Hits: uint64(mh.Hits), LastHit: uint32(mh.LastHit)})
+	}
+	return hdr.More != 0
+}
+
+// Lowest value of the bucket the pct percentile falls in, pct from 0 to 100
+func (l *DPFwdLatency) Percentile(pct float64) uint64 {
+	if l.Count == 0 {
+		return 0
+	}
+	rank := uint64(float64(l.Count) * pct / 100)
+	var seen uint64
+	for _, b := range l.Buckets {
+		seen += b.Count
+		if seen > rank {
+			return b.Low
+		}
+	}
+	return l.Max
+}
+
+func ParseDPCaptureStatus(buf []byte) *DPCaptureStatus {
+	var m C.DPMsgCapture
+
+	hdr := ParseDPMsgHeader(buf)
+	if hdr == nil || hdr.Kind != C.DP_KIND_CAPTURE {
+		return nil
+	}
+
+	r := bytes.NewReader(buf[int(unsafe.Sizeof(*hdr)):])
+	if err := binary.Read(r, binary.BigEndian, &m); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Short capture status")
+		return nil
+	}
+	return &DPCaptureStatus{
+		Active: m.Active != 0, Limit: uint32(m.Limit),
+		Packets: uint64(m.Packets), Bytes: uint64(m.Bytes), Drops: uint64(m.Drops),
+	}
+}
+
+func ParseDPMemStats(buf []byte) *DPMemStats {
+	var m C.DPMsgMemStats
+
+	hdr := ParseDPMsgHeader(buf)
+	if hdr == nil || hdr.Kind != C.DP_KIND_MEM_STATS {
+		return nil
+	}
+
+	r := bytes.NewReader(buf[int(unsafe.Sizeof(*hdr)):])
+	if err := binary.Read(r, binary.BigEndian, &m); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Short memory stats")
+		return nil
+	}
+	stats := &DPMemStats{
+		Allocated: uint64(m.Allocated), Resident: uint64(m.Resident), ArenaBytes: uint64(m.ArenaBytes),
+		Bytes: make(map[string]int64, len(dpMemNames)),
+	}
+	for j, name := range dpMemNames {
+		stats.Bytes[name] = int64(m.Bytes[j])
+	}
+	return stats
+}
+
 func ParseDPMsgHeader(msg []byte) *C.DPMsgHdr {
 	var hdr C.DPMsgHdr
 
@@ -368,14 +794,20 @@ func dpMessenger(msg []byte) {
 		dpMsgAppUpdate(msg[offset:])
 	case C.DP_KIND_THREAT_LOG:
 		dpMsgThreatLog(msg[offset:])
+	case C.DP_KIND_THREAT_LOG_RING:
+		dpMsgThreatLogRing()
 	case C.DP_KIND_CONNECTION:
 		dpMsgConnection(msg[offset:])
+	case C.DP_KIND_CONNECTION_COMPACT:
+		dpMsgConnectionCompact(msg[offset:])
 	case C.DP_KIND_FQDN_UPDATE:
 		dpMsgFqdnIpUpdate(msg[offset:])
 	case C.DP_KIND_IP_FQDN_STORAGE_UPDATE:
 		dpMsgIpFqdnStorageUpdate(msg[offset:])
 	case C.DP_KIND_IP_FQDN_STORAGE_RELEASE:
 		dpMsgIpFqdnStorageRelease(msg[offset:])
+	case C.DP_KIND_OVERLOAD:
+		dpMsgOverload(msg[offset:])
 	}
 }
 
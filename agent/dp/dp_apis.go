@@ -11,6 +11,7 @@ type DPEmpty struct {
 
 type DPKeepAlive struct {
 	SeqNum uint32 `json:"seq_num"`
+	Native bool   `json:"native"` // session and connection entries in host order
 }
 
 type DPKeepAliveReq struct {
@@ -100,6 +101,14 @@ type DPAddMACReq struct {
 	AddMAC *DPAddMAC `json:"ctrl_add_mac"`
 }
 
+type DPAddMACs struct {
+	MACs []*DPAddMAC `json:"macs"`
+}
+
+type DPAddMACsReq struct {
+	AddMACs *DPAddMACs `json:"ctrl_add_macs"`
+}
+
 type DPDelMAC struct {
 	Iface string `json:"iface"`
 	MAC   string `json:"mac"`
@@ -113,16 +122,36 @@ type DPDelMACReq struct {
 	DelMAC *DPDelMAC `json:"ctrl_del_mac"`
 }
 
+type DPDelMACsReq struct {
+	DelMACs *DPMACArray `json:"ctrl_del_macs"`
+}
+
 type DPMacConfig struct {
-	MACs []string          `json:"macs"`
-	Tap  *bool             `json:"tap,omitempty"`
-	Apps *[]DPProtoPortApp `json:"apps,omitempty"`
+	MACs      []string          `json:"macs"`
+	Tap       *bool             `json:"tap,omitempty"`
+	Apps      *[]DPProtoPortApp `json:"apps,omitempty"`
+	Inspect   *int              `json:"inspect,omitempty"`
+	MeshDedup *bool             `json:"mesh_dedup,omitempty"`
+	TapSample *uint32           `json:"tap_sample,omitempty"`
 }
 
 type DPConfigMACReq struct {
 	Cfg *DPMacConfig `json:"ctrl_cfg_mac"`
 }
 
+// Bps are in bits per second, 0 is no limit
+type DPRateLimit struct {
+	MACs       []string `json:"macs"`
+	IngressPPS uint64   `json:"ingress_pps,omitempty"`
+	IngressBPS uint64   `json:"ingress_bps,omitempty"`
+	EgressPPS  uint64   `json:"egress_pps,omitempty"`
+	EgressBPS  uint64   `json:"egress_bps,omitempty"`
+}
+
+type DPConfigRateLimitReq struct {
+	Cfg *DPRateLimit `json:"ctrl_cfg_rate_limit"`
+}
+
 type DPNbeConfig struct {
 	MACs []string `json:"macs"`
 	Nbe  *bool    `json:"nbe,omitempty"`
@@ -140,13 +169,33 @@ type DPRefreshAppReq struct {
 }
 
 type DPSysConf struct {
-	XffEnabled *bool `json:"xff_enabled"`
+	XffEnabled    *bool   `json:"xff_enabled"`
+	HttpBodyScan  *uint32 `json:"http_body_scan,omitempty"`  // bytes of a request body matched by the http parser
+	DlpScanBudget *uint32 `json:"dlp_scan_budget,omitempty"` // KB of a session matched by DLP, 0 for all
 }
 
 type DPSysConfReq struct {
 	Sysconf *DPSysConf `json:"ctrl_sys_conf"`
 }
 
+type DPConnectReportConf struct {
+	Window  *uint32 `json:"window,omitempty"`
+	Compact *bool   `json:"compact,omitempty"`
+}
+
+type DPConnectReportReq struct {
+	ConnectReport *DPConnectReportConf `json:"ctrl_connect_report"`
+}
+
+type DPThreatLogLimit struct {
+	Rate  uint32 `json:"rate"`
+	Burst uint32 `json:"burst,omitempty"`
+}
+
+type DPThreatLogLimitReq struct {
+	Limit *DPThreatLogLimit `json:"ctrl_set_threat_log_limit"`
+}
+
 type DPDisableNetPolicy struct {
 	DisableNetPolicy *bool `json:"disable_net_policy"`
 }
@@ -191,6 +240,128 @@ type DPCounterAgentReq struct {
 	Counter *DPEmpty `json:"ctrl_counter_device"`
 }
 
+type DPLatencyReq struct {
+	Latency *DPEmpty `json:"ctrl_latency"`
+}
+
+type DPFwdLatencyReq struct {
+	FwdLatency *DPEmpty `json:"ctrl_stats_fwd_latency"`
+}
+
+type DPPolicyHitsOption struct {
+	Reset bool `json:"reset,omitempty"`
+}
+
+type DPPolicyHitsReq struct {
+	PolicyHits *DPPolicyHitsOption `json:"ctrl_policy_hits"`
+}
+
+type DPPolicyHit struct {
+	ID      uint32
+	Hits    uint64
+	LastHit uint32
+}
+
+// Sessions decided by each policy rule since Since, 0 since the dp started. Rule 0 is the default action.
+type DPPolicyHits struct {
+	Since    uint32
+	Overflow uint64
+	Hits     []DPPolicyHit
+}
+
+type DPLatencySample struct {
+	Sample uint32 `json:"sample"`
+	Trace  bool   `json:"trace,omitempty"`
+}
+
+type DPTracePath struct {
+	Path string `json:"path,omitempty"`
+}
+
+type DPDumpTraceReq struct {
+	DumpTrace *DPTracePath `json:"ctrl_dump_trace"`
+}
+
+type DPSetLatencyReq struct {
+	SetLatency *DPLatencySample `json:"ctrl_set_latency"`
+}
+
+type DPLatencyBucket struct {
+	Low   uint64 // ns
+	Count uint64
+}
+
+// Hist is one of DP_LAT_*, or DP_LAT_STAGE_MAX + a parser type, times are in ns
+type DPLatencyHist struct {
+	Hist    int
+	Count   uint64
+	Sum     uint64
+	Max     uint64
+	Buckets []DPLatencyBucket
+}
+
+// Time from rx to tx of the timed packets received on an inline interface, in ns
+type DPFwdLatency struct {
+	Iface   string
+	Count   uint64
+	Sum     uint64
+	Max     uint64
+	Buckets []DPLatencyBucket
+}
+
+type DPCaptureStart struct {
+	MAC     string `json:"mac,omitempty"`
+	Filter  string `json:"filter,omitempty"`
+	Snaplen uint32 `json:"snaplen,omitempty"`
+	Limit   uint32 `json:"limit,omitempty"`
+	Path    string `json:"path"`
+}
+
+type DPCaptureStartReq struct {
+	Start *DPCaptureStart `json:"ctrl_capture_start"`
+}
+
+type DPCaptureStopReq struct {
+	Stop *DPEmpty `json:"ctrl_capture_stop"`
+}
+
+type DPCaptureStatusReq struct {
+	Status *DPEmpty `json:"ctrl_capture_status"`
+}
+
+type DPMemStatsReq struct {
+	Stats *DPEmpty `json:"ctrl_mem_stats"`
+}
+
+// Heap bytes by subsystem, keyed by the names of dpMemNames
+type DPMemStats struct {
+	Allocated  uint64
+	Resident   uint64
+	ArenaBytes uint64
+	Bytes      map[string]int64
+}
+
+type DPCfgResetReq struct {
+	Reset *DPEmpty `json:"ctrl_cfg_reset"`
+}
+
+type DPCfgRestore struct {
+	Gen uint32 `json:"gen"`
+	Min uint32 `json:"min"`
+}
+
+type DPCfgRestoreReq struct {
+	Restore *DPCfgRestore `json:"ctrl_cfg_restore"`
+}
+
+type DPCaptureStatus struct {
+	Active  bool
+	Limit   uint32
+	Packets uint64
+	Bytes   uint64
+	Drops   uint64
+}
+
 type DPCountSessionReq struct {
 	CountSession *DPEmpty `json:"ctrl_count_session"`
 }
@@ -199,6 +370,20 @@ type DPListSessionReq struct {
 	ListSession *DPEmpty `json:"ctrl_list_session"`
 }
 
+// Sessions of one dp thread from the cursor on, 0 to start. Filters left empty match all.
+type DPListSessionChunk struct {
+	Cursor uint64  `json:"cursor"`
+	Limit  uint32  `json:"limit,omitempty"`
+	MAC    string  `json:"mac,omitempty"`
+	Port   *uint16 `json:"port,omitempty"`
+	App    *uint16 `json:"app,omitempty"`
+	Action *uint8  `json:"action,omitempty"`
+}
+
+type DPListSessionChunkReq struct {
+	ListSession *DPListSessionChunk `json:"ctrl_list_session"`
+}
+
 type DPClearSession struct {
 	ID uint32 `json:"filter_id"`
 }
@@ -213,12 +398,22 @@ type DPListMeterReq struct {
 
 type DPDebug struct {
 	Categories []string `json:"categories"`
+	MAC        string   `json:"mac,omitempty"` // packet and session logs of the endpoint only
+	IP         string   `json:"ip,omitempty"`  // or of the IPv4 address
 }
 
 type DPSetDebugReq struct {
 	Debug *DPDebug `json:"ctrl_set_debug"`
 }
 
+type DPThreads struct {
+	Threads int `json:"threads"`
+}
+
+type DPSetThreadsReq struct {
+	Threads *DPThreads `json:"ctrl_set_dp_threads"`
+}
+
 /*
 type DPGetDebugReq struct {
 	Debug *DPEmpty `json:"ctrl_get_debug"`
@@ -291,6 +486,14 @@ type DPFqdnIpSetReq struct {
 	Fqdns *DPFqdnIps `json:"ctrl_cfg_set_fqdn"`
 }
 
+type DPFqdnIpsList struct {
+	Fqdns []*DPFqdnIps `json:"fqdns"`
+}
+
+type DPFqdnIpsSetReq struct {
+	Fqdns *DPFqdnIpsList `json:"ctrl_cfg_set_fqdns"`
+}
+
 type DPSubnet struct {
 	IP   net.IP `json:"ip"`
 	Mask net.IP `json:"mask"`
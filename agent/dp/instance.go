@@ -0,0 +1,137 @@
+package dp
+
+// #include "../../defs.h"
+import "C"
+
+import (
+	"bytes"
+	"encoding/binary"
+	"fmt"
+	"net"
+	"os"
+	"reflect"
+	"strconv"
+	"time"
+	"unsafe"
+
+	log "github.com/sirupsen/logrus"
+)
+
+// The monitor can run one dp per numa node, it tells the number of instances in
+// ENF_DP_NUMA_INSTANCES. Every instance is sent all messages and opens the ports of its node
+// only. Each reply is passed to the request callback, except the stats of an endpoint or of
+// the device, which are added up over the instances and passed once.
+
+const envDPNumaInstances string = "ENF_DP_NUMA_INSTANCES"
+const dpNumaMax int = 4 // DP_NUMA_MAX
+
+var dpInstances int = 1
+
+func init() {
+	if n, err := strconv.Atoi(os.Getenv(envDPNumaInstances)); err == nil && n > 1 {
+		if n > dpNumaMax {
+			n = dpNumaMax
+		}
+		dpInstances = n
+	}
+}
+
+// Same as dp_instance_name() of dp
+func dpInstanceName(name string, n int) string {
+	if dpInstances <= 1 {
+		return name
+	}
+	return fmt.Sprintf("%s.%d", name, n)
+}
+
+// Connections to all dp instances, a message is written to every one of them
+type dpConnSet struct {
+	conns []*net.UnixConn
+}
+
+func (s *dpConnSet) SetWriteDeadline(t time.Time) error {
+	var first error
+	for _, conn := range s.conns {
+		if err := conn.SetWriteDeadline(t); err != nil && first == nil {
+			first = err
+		}
+	}
+	return first
+}
+
+func (s *dpConnSet) Write(msg []byte) (int, error) {
+	for _, conn := range s.conns {
+		if n, err := conn.Write(msg); err != nil {
+			return n, err
+		}
+	}
+	return len(msg), nil
+}
+
+func (s *dpConnSet) WriteMsgUnix(b, oob []byte, addr *net.UnixAddr) (int, int, error) {
+	for _, conn := range s.conns {
+		if n, oobn, err := conn.WriteMsgUnix(b, oob, addr); err != nil {
+			return n, oobn, err
+		}
+	}
+	return len(b), len(oob), nil
+}
+
+func (s *dpConnSet) Close() {
+	for _, conn := range s.conns {
+		conn.Close()
+	}
+}
+
+// An endpoint or device stats reply, to be added up over the instances
+func dpStatsReply(buf []byte) bool {
+	if dpInstances <= 1 || len(buf) < int(unsafe.Sizeof(C.DPMsgHdr{})) {
+		return false
+	}
+	hdr := (*C.DPMsgHdr)(unsafe.Pointer(&buf[0]))
+	return hdr.Kind == C.DP_KIND_MAC_STATS || hdr.Kind == C.DP_KIND_DEVICE_STATS
+}
+
+// Add the counters of the stats reply to the sum of the request. The interval is the one of
+// the first reply.
+func dpStatsAdd(req *dpRequest, buf []byte) {
+	var stats C.DPMsgStats
+
+	offset := int(unsafe.Sizeof(C.DPMsgHdr{}))
+	if len(buf) < offset+int(unsafe.Sizeof(stats)) {
+		log.WithFields(log.Fields{"len": len(buf)}).Error("Short stats")
+		return
+	}
+	if err := binary.Read(bytes.NewReader(buf[offset:]), binary.BigEndian, &stats); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Read stats")
+		return
+	}
+	if req.stats == nil {
+		req.statsHdr = append([]byte(nil), buf[:offset]...)
+		req.stats = &stats
+		return
+	}
+
+	sum, v := reflect.ValueOf(req.stats).Elem(), reflect.ValueOf(&stats).Elem()
+	for i := 0; i < sum.NumField(); i++ {
+		switch name := sum.Type().Field(i).Name; {
+		case name == "Interval" || name == "Padding":
+		case sum.Field(i).CanSet():
+			sum.Field(i).SetUint(sum.Field(i).Uint() + v.Field(i).Uint())
+		}
+	}
+}
+
+// The sum of the stats replies, in the format of one reply
+func dpStatsMsg(req *dpRequest) []byte {
+	if req.stats == nil {
+		return nil
+	}
+	var w bytes.Buffer
+	w.Write(req.statsHdr)
+	if err := binary.Write(&w, binary.BigEndian, req.stats); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Write stats")
+		return nil
+	}
+	return w.Bytes()
+}
@@ -0,0 +1,248 @@
+package dp
+
+// #include "../../defs.h"
+import "C"
+
+import (
+	"bufio"
+	"fmt"
+	"net/http"
+	"os"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"unsafe"
+
+	log "github.com/sirupsen/logrus"
+)
+
+// Counters are read from the stats page the dp threads publish, a scrape never sends
+// a request to the dp. With more than one dp instance, the page of the first one is read.
+
+const dpStatsShmPath string = "/dev/shm" + C.DP_STATS_SHM_NAME
+
+var dpStatsShm []byte
+var dpStatsLock sync.Mutex
+
+func dpStatsShmMap() []byte {
+	if dpStatsShm != nil {
+		return dpStatsShm
+	}
+
+	f, err := os.Open(dpInstanceName(dpStatsShmPath, 0))
+	if err != nil {
+		log.WithFields(log.Fields{"error": err}).Debug("Open stats page")
+		return nil
+	}
+	defer f.Close()
+
+	info, err := f.Stat()
+	if err != nil || info.Size() < int64(unsafe.Sizeof(C.DPStatsShmHdr{})) {
+		log.WithFields(log.Fields{"error": err}).Error("Wrong stats page")
+		return nil
+	}
+	mem, err := syscall.Mmap(int(f.Fd()), 0, int(info.Size()), syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Map stats page")
+		return nil
+	}
+	dpStatsShm = mem
+	return dpStatsShm
+}
+
+// Copy a page, retry while its thread is writing it
+func dpStatsReadPage(p *C.DPStatsPage) (C.DPStatsPage, bool) {
+	seq := (*uint32)(unsafe.Pointer(&p.Seq))
+	for i := 0; i < 100; i++ {
+		s := atomic.LoadUint32(seq)
+		if s&1 != 0 {
+			continue
+		}
+		page := *p
+		if atomic.LoadUint32(seq) == s {
+			return page, true
+		}
+	}
+	return C.DPStatsPage{}, false
+}
+
+type dpStatsThread struct {
+	thread int
+	page   C.DPStatsPage
+}
+
+func dpStatsPages() []dpStatsThread {
+	dpStatsLock.Lock()
+	defer dpStatsLock.Unlock()
+
+	mem := dpStatsShmMap()
+	if mem == nil {
+		return nil
+	}
+
+	hdr := (*C.DPStatsShmHdr)(unsafe.Pointer(&mem[0]))
+	if atomic.LoadUint32((*uint32)(unsafe.Pointer(&hdr.Magic))) != C.DP_STATS_SHM_MAGIC {
+		return nil
+	}
+
+	hdrLen := int(unsafe.Sizeof(*hdr))
+	pageSize := int(hdr.PageSize)
+	if pageSize != int(unsafe.Sizeof(C.DPStatsPage{})) {
+		log.WithFields(log.Fields{"size": pageSize}).Error("Wrong stats page")
+		return nil
+	}
+
+	pages := make([]dpStatsThread, 0, int(hdr.Threads))
+	for i := 0; i < int(hdr.Threads) && hdrLen+(i+1)*pageSize <= len(mem); i++ {
+		page, ok := dpStatsReadPage((*C.DPStatsPage)(unsafe.Pointer(&mem[hdrLen+i*pageSize])))
+		if ok && page.UpdatedAt != 0 {
+			pages = append(pages, dpStatsThread{thread: i, page: page})
+		}
+	}
+	return pages
+}
+
+func dpStatsSharedMem(j int) int64 {
+	dpStatsLock.Lock()
+	defer dpStatsLock.Unlock()
+
+	if dpStatsShm == nil {
+		return 0
+	}
+	hdr := (*C.DPStatsShmHdr)(unsafe.Pointer(&dpStatsShm[0]))
+	return atomic.LoadInt64((*int64)(unsafe.Pointer(&hdr.SharedMemBytes[j])))
+}
+
+type dpMetric struct {
+	name  string
+	kind  string
+	help  string
+	value func(p *C.DPStatsPage) uint64
+}
+
+var dpMetrics []dpMetric = []dpMetric{
+	{"dp_rx_packets", "counter", "Packets received on the rings", func(p *C.DPStatsPage) uint64 { return uint64(p.RXPackets) }},
+	{"dp_rx_drop_packets", "counter", "Packets dropped by the rings", func(p *C.DPStatsPage) uint64 { return uint64(p.RXDropPackets) }},
+	{"dp_tx_packets", "counter", "Packets sent on the rings", func(p *C.DPStatsPage) uint64 { return uint64(p.TXPackets) }},
+	{"dp_tx_drop_packets", "counter", "Packets failed to send", func(p *C.DPStatsPage) uint64 { return uint64(p.TXDropPackets) }},
+	{"dp_handoff_packets", "counter", "Packets handed to another thread", func(p *C.DPStatsPage) uint64 { return uint64(p.HandoffPackets) }},
+	{"dp_handoff_drop_packets", "counter", "Packets lost on a full handoff ring", func(p *C.DPStatsPage) uint64 { return uint64(p.HandoffDropPackets) }},
+	{"dp_quar_drop_packets", "counter", "Packets dropped on quarantined ports", func(p *C.DPStatsPage) uint64 { return uint64(p.QuarDropPackets) }},
+	{"dp_error_packets", "counter", "Malformed packets", func(p *C.DPStatsPage) uint64 { return uint64(p.ErrorPackets) }},
+	{"dp_no_workload_packets", "counter", "Packets of unknown workloads", func(p *C.DPStatsPage) uint64 { return uint64(p.NoWorkloadPackets) }},
+	{"dp_ipv4_packets", "counter", "IPv4 packets", func(p *C.DPStatsPage) uint64 { return uint64(p.IPv4Packets) }},
+	{"dp_ipv6_packets", "counter", "IPv6 packets", func(p *C.DPStatsPage) uint64 { return uint64(p.IPv6Packets) }},
+	{"dp_tcp_packets", "counter", "TCP packets", func(p *C.DPStatsPage) uint64 { return uint64(p.TCPPackets) }},
+	{"dp_udp_packets", "counter", "UDP packets", func(p *C.DPStatsPage) uint64 { return uint64(p.UDPPackets) }},
+	{"dp_icmp_packets", "counter", "ICMP packets", func(p *C.DPStatsPage) uint64 { return uint64(p.ICMPPackets) }},
+	{"dp_other_packets", "counter", "Packets of other protocols", func(p *C.DPStatsPage) uint64 { return uint64(p.OtherPackets) }},
+	{"dp_sessions", "counter", "Sessions created", func(p *C.DPStatsPage) uint64 { return uint64(p.TotalSessions) }},
+	{"dp_tcp_sessions", "counter", "TCP sessions created", func(p *C.DPStatsPage) uint64 { return uint64(p.TCPSessions) }},
+	{"dp_udp_sessions", "counter", "UDP sessions created", func(p *C.DPStatsPage) uint64 { return uint64(p.UDPSessions) }},
+	{"dp_icmp_sessions", "counter", "ICMP sessions created", func(p *C.DPStatsPage) uint64 { return uint64(p.ICMPSessions) }},
+	{"dp_ip_sessions", "counter", "IP sessions created", func(p *C.DPStatsPage) uint64 { return uint64(p.IPSessions) }},
+	{"dp_cur_sessions", "gauge", "Open sessions", func(p *C.DPStatsPage) uint64 { return uint64(p.CurSessions) }},
+	{"dp_cur_tcp_sessions", "gauge", "Open TCP sessions", func(p *C.DPStatsPage) uint64 { return uint64(p.CurTCPSessions) }},
+	{"dp_cur_udp_sessions", "gauge", "Open UDP sessions", func(p *C.DPStatsPage) uint64 { return uint64(p.CurUDPSessions) }},
+	{"dp_cur_icmp_sessions", "gauge", "Open ICMP sessions", func(p *C.DPStatsPage) uint64 { return uint64(p.CurICMPSessions) }},
+	{"dp_cur_ip_sessions", "gauge", "Open IP sessions", func(p *C.DPStatsPage) uint64 { return uint64(p.CurIPSessions) }},
+	{"dp_drop_meters", "counter", "Packets dropped by meters", func(p *C.DPStatsPage) uint64 { return uint64(p.DropMeters) }},
+	{"dp_proxy_meters", "counter", "Connections proxied by meters", func(p *C.DPStatsPage) uint64 { return uint64(p.ProxyMeters) }},
+	{"dp_cur_meters", "gauge", "Meters in use", func(p *C.DPStatsPage) uint64 { return uint64(p.CurMeters) }},
+	{"dp_cur_log_caches", "gauge", "Threat logs cached", func(p *C.DPStatsPage) uint64 { return uint64(p.CurLogCaches) }},
+	{"dp_log_drops", "counter", "Threat logs lost on a full ring", func(p *C.DPStatsPage) uint64 { return uint64(p.LogDrops) }},
+	{"dp_log_suppressed", "counter", "Threat logs held back by their rate limit", func(p *C.DPStatsPage) uint64 { return uint64(p.LogSuppressed) }},
+	{"dp_dlp_scan_bytes", "counter", "Bytes scanned for DLP and WAF patterns", func(p *C.DPStatsPage) uint64 { return uint64(p.DlpScanBytes) }},
+	{"dp_inflate_bytes", "counter", "Bytes of HTTP bodies inflated for DLP", func(p *C.DPStatsPage) uint64 { return uint64(p.InflateBytes) }},
+	{"dp_inflate_limits", "counter", "HTTP bodies not inflated to the end for the limits", func(p *C.DPStatsPage) uint64 { return uint64(p.InflateLimits) }},
+	{"dp_load_permille", "gauge", "Busy time of the last second", func(p *C.DPStatsPage) uint64 { return uint64(p.Load) }},
+	{"dp_arena_bytes", "gauge", "Bytes in use in the thread's jemalloc arena", func(p *C.DPStatsPage) uint64 { return uint64(p.ArenaBytes) }},
+	{"dp_overloaded", "gauge", "The thread is in the overload mode", func(p *C.DPStatsPage) uint64 { return uint64(p.Overloaded) }},
+	{"dp_overload_enters", "counter", "Times the thread entered the overload mode", func(p *C.DPStatsPage) uint64 { return uint64(p.OverloadEnters) }},
+	{"dp_shed_sessions", "counter", "New sessions refused in the overload mode", func(p *C.DPStatsPage) uint64 { return uint64(p.ShedSessions) }},
+	{"dp_shed_inspects", "counter", "Sessions no longer inspected in the overload mode", func(p *C.DPStatsPage) uint64 { return uint64(p.ShedInspects) }},
+	{"dp_updated_seconds", "gauge", "Unix time the counters were published", func(p *C.DPStatsPage) uint64 { return uint64(p.UpdatedAt) }},
+}
+
+var dpPoolNames []string = []string{
+	C.DP_POOL_SESSION: "session",
+	C.DP_POOL_CLIP:    "clip",
+	C.DP_POOL_FRAG:    "frag",
+	C.DP_POOL_METER:   "meter",
+}
+
+var dpMemNames []string = []string{
+	C.DP_MEM_SESSION: "session",
+	C.DP_MEM_ASM:     "asm",
+	C.DP_MEM_FRAG:    "frag",
+	C.DP_MEM_METER:   "meter",
+	C.DP_MEM_LOG:     "log",
+	C.DP_MEM_POLICY:  "policy",
+	C.DP_MEM_DLP:     "dlp",
+	C.DP_MEM_PARSER:  "parser",
+}
+
+// Write the counters in the OpenMetrics text format, one sample per dp thread
+func DPStatsHandler(w http.ResponseWriter, r *http.Request) {
+	pages := dpStatsPages()
+	if pages == nil {
+		w.WriteHeader(http.StatusServiceUnavailable)
+		return
+	}
+
+	w.Header().Set("Content-Type", "application/openmetrics-text; version=1.0.0; charset=utf-8")
+	bw := bufio.NewWriter(w)
+	for _, m := range dpMetrics {
+		fmt.Fprintf(bw, "# TYPE %s %s\n# HELP %s %s.\n", m.name, m.kind, m.name, m.help)
+		suffix := ""
+		if m.kind == "counter" {
+			suffix = "_total"
+		}
+		for i := range pages {
+			fmt.Fprintf(bw, "%s%s{thread=\"%d\"} %d\n", m.name, suffix, pages[i].thread, m.value(&pages[i].page))
+		}
+	}
+
+	pools := []struct {
+		name string
+		kind string
+		help string
+		get  func(p *C.DPStatsPage, j int) uint64
+	}{
+		{"dp_pool_in_use", "gauge", "Pool objects in use", func(p *C.DPStatsPage, j int) uint64 { return uint64(p.PoolInUse[j]) }},
+		{"dp_pool_high_water", "gauge", "Most pool objects in use", func(p *C.DPStatsPage, j int) uint64 { return uint64(p.PoolHighWater[j]) }},
+		{"dp_pool_alloc_fails", "counter", "Pool allocations failed", func(p *C.DPStatsPage, j int) uint64 { return uint64(p.PoolAllocFails[j]) }},
+	}
+	for _, m := range pools {
+		fmt.Fprintf(bw, "# TYPE %s %s\n# HELP %s %s.\n", m.name, m.kind, m.name, m.help)
+		suffix := ""
+		if m.kind == "counter" {
+			suffix = "_total"
+		}
+		for i := range pages {
+			for j, pool := range dpPoolNames {
+				fmt.Fprintf(bw, "%s%s{thread=\"%d\",pool=\"%s\"} %d\n", m.name, suffix, pages[i].thread, pool, m.get(&pages[i].page, j))
+			}
+		}
+	}
+
+	// Memory of the ctrl and other threads is in the header, as thread "shared"
+	fmt.Fprintf(bw, "# TYPE dp_mem_bytes gauge\n# HELP dp_mem_bytes Heap bytes by subsystem.\n")
+	for i := range pages {
+		for j, sub := range dpMemNames {
+			fmt.Fprintf(bw, "dp_mem_bytes{thread=\"%d\",subsystem=\"%s\"} %d\n", pages[i].thread, sub, int64(pages[i].page.MemBytes[j]))
+		}
+	}
+	for j, sub := range dpMemNames {
+		fmt.Fprintf(bw, "dp_mem_bytes{thread=\"shared\",subsystem=\"%s\"} %d\n", sub, dpStatsSharedMem(j))
+	}
+	fmt.Fprintf(bw, "# EOF\n")
+	bw.Flush()
+}
+
+func StartStatsServer(port uint) error {
+	mux := http.NewServeMux()
+	mux.HandleFunc("/metrics", DPStatsHandler)
+
+	return http.ListenAndServe(fmt.Sprintf(":%d", port), mux)
+}
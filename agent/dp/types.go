@@ -17,6 +17,7 @@ const (
 	DP_TASK_FQDN_IP
 	DP_TASK_IP_FQDN_STORAGE_UPDATE
 	DP_TASK_IP_FQDN_STORAGE_RELEASE
+	DP_TASK_OVERLOAD
 )
 
 type Connection struct {
@@ -63,6 +64,16 @@ type ConnectionData struct {
 	Conn  *Connection
 }
 
+// A dp thread entered or left the overload mode
+type DPOverload struct {
+	Thread       int
+	Overloaded   bool
+	Enters       uint32
+	Seconds      uint32 // how long the mode lasted, when it is left
+	ShedSessions uint64
+	ShedInspects uint64
+}
+
 type IpFqdnStorageUpdate struct {
 	IP   net.IP
 	Name string
@@ -77,4 +88,5 @@ type DPTask struct {
 	Fqdns              *share.CLUSFqdnIp
 	FqdnStorageUpdate  *IpFqdnStorageUpdate
 	FqdnStorageRelease net.IP
+	Overload           *DPOverload
 }
@@ -7,6 +7,7 @@ import (
 	"bytes"
 	"errors"
 	"fmt"
+	"hash/fnv"
 	"net"
 	"os"
 	"reflect"
@@ -35,6 +36,8 @@ const containerWaitParentPeriod time.Duration = (time.Second * 1)
 const containerReexamIntfMax time.Duration = (time.Second * 180)
 const containerReexamIntfIPv4Min time.Duration = (time.Second * 4)
 const containerTaskChanSizeMin = 256
+const runtimeEventShards = 8
+const runtimeEventChanSize = 64
 
 var errHostModeUnsupported = errors.New("Host mode not supported")
 var errChildUnsupported = errors.New("Child container not supported")
@@ -343,11 +346,44 @@ func isSidecarContainer(labels map[string]string) bool {
 	return false
 }
 
+// Container events from the runtime are passed to the task thread by a pool of workers, sharded
+// by container ID so the events of a container keep their order. The worker inspects a starting
+// container before queuing its task, so the runtime calls of a mass restart run in parallel.
+// Containers are still added and removed by the task thread, the only writer of gInfo.
+var runtimeEventChans [runtimeEventShards]chan *ContainerTask
+
+func startRuntimeEventWorkers() {
+	for i := 0; i < runtimeEventShards; i++ {
+		runtimeEventChans[i] = make(chan *ContainerTask, runtimeEventChanSize)
+		go runtimeEventWorker(runtimeEventChans[i])
+	}
+}
+
+func runtimeEventWorker(ch chan *ContainerTask) {
+	for task := range ch {
+		if task.task == TASK_ADD_CONTAINER {
+			if _, ok := gInfoReadActiveContainer(task.id); !ok {
+				// on error, the task thread tries again
+				if info, err := getRuntimeContainer(task.id); err == nil {
+					task.info = info
+				}
+			}
+		}
+		ContainerTaskChan <- task
+	}
+}
+
+func queueRuntimeEvent(task *ContainerTask) {
+	h := fnv.New32a()
+	h.Write([]byte(task.id))
+	runtimeEventChans[h.Sum32()%runtimeEventShards] <- task
+}
+
 func runtimeEventCallback(ev container.Event, id string, pid int) {
 	switch ev {
 	case container.EventContainerStart:
 		task := ContainerTask{task: TASK_ADD_CONTAINER, id: id}
-		ContainerTaskChan <- &task
+		queueRuntimeEvent(&task)
 	case container.EventContainerStop:
 		// containerd runtime report TaskExit for both process stop and container stop.
 		// Here is to make sure the pid is container's pid and avoid writing event log
@@ -361,10 +397,10 @@ func runtimeEventCallback(ev container.Event, id string, pid int) {
 		}
 
 		task := ContainerTask{task: TASK_STOP_CONTAINER, id: id, pid: pid}
-		ContainerTaskChan <- &task
+		queueRuntimeEvent(&task)
 	case container.EventContainerDelete:
 		task := ContainerTask{task: TASK_DEL_CONTAINER, id: id}
-		ContainerTaskChan <- &task
+		queueRuntimeEvent(&task)
 	case container.EventContainerCopyIn:
 		if c, ok := gInfoReadActiveContainer(id); ok {
 			prober.ReportDockerCp(id, c.name, true)
@@ -1826,6 +1862,11 @@ func examNetworkInterface(c *containerData) bool {
 		if intfAdded {
 			programBridge(c)
 			programDP(c, false, nil)
+			if c.info != nil && !c.info.StartedAt.IsZero() {
+				log.WithFields(log.Fields{
+					"id": c.id, "pairs": len(c.intcpPairs), "enforced": time.Since(c.info.StartedAt).Round(time.Millisecond),
+				}).Info("Container ports programmed")
+			}
 		}
 
 		if subnetChanged {
@@ -1947,6 +1988,27 @@ func taskInterceptContainer(id string, info *container.ContainerMetaExtra) {
 	notifyContainerChanges(c, parent, changeInit)
 }
 
+func getRuntimeContainer(id string) (*container.ContainerMetaExtra, error) {
+	var info *container.ContainerMetaExtra
+	var err error
+	for i := 0; i < 2; i++ {
+		if info, err = global.RT.GetContainer(id); err != nil {
+			// Container: too early, container information is not ready, waiting for runtime API event
+			log.WithFields(log.Fields{"id": id, "err": err}).Debug("container info not ready")
+			return nil, err
+		}
+
+		if info.Pid != 0 {
+			break
+		}
+
+		// 2nd chance because the container info are not ready yet
+		time.Sleep(time.Millisecond * 50)
+		// log.Debug("2nd chance")
+	}
+	return info, nil
+}
+
 func taskAddContainer(id string, info *container.ContainerMetaExtra) {
 	// This can be invoked from Docker socket and probe.
 	if _, ok := gInfoReadActiveContainer(id); ok {
@@ -1956,20 +2018,8 @@ func taskAddContainer(id string, info *container.ContainerMetaExtra) {
 	if info == nil || info.Pid == 0 {
 		// Tasks from process monitor or scan-timer-loop
 		var err error
-		for i := 0; i < 2; i++ {
-			if info, err = global.RT.GetContainer(id); err != nil {
-				// Container: too early, container information is not ready, waiting for runtime API event
-				log.WithFields(log.Fields{"id": id, "err": err}).Debug("container info not ready")
-				return
-			}
-
-			if info.Pid != 0 {
-				break
-			}
-
-			// 2nd chance because the container info are not ready yet
-			time.Sleep(time.Millisecond * 50)
-			// log.Debug("2nd chance")
+		if info, err = getRuntimeContainer(id); err != nil {
+			return
 		}
 	}
 
@@ -2226,6 +2276,13 @@ func taskDelContainer(id string) {
 func taskDPConnect() {
 	log.Info()
 
+	// A restarted dp replays its config journal, the full config is pushed otherwise
+	if dp.DPCtrlCfgRestore() {
+		log.Info("DP config restored")
+		return
+	}
+	dp.DPCtrlCfgReset()
+
 	// Set debug as the first thing
 	debug := &dp.DPDebug{Categories: gInfo.agentConfig.Debug}
 	dp.DPCtrlConfigAgent(debug)
@@ -2262,7 +2319,8 @@ func taskDPConnect() {
 	pe.PushNetworkDlpToDP()
 	//set xff
 	xffenabled := gInfo.xffEnabled
-	dp.DPCtrlSetSysConf(&xffenabled)
+	dlpScanBudget := agentEnv.dlpScanBudget
+	dp.DPCtrlSetSysConf(&xffenabled, &dlpScanBudget)
 	//set disableNetPolicy
 	dnp := gInfo.disableNetPolicy
 	dp.DPCtrlSetDisableNetPolicy(&dnp)
@@ -2275,6 +2333,12 @@ func taskDPConnect() {
 	//set strictGroupMode
 	sgm := gInfo.strictGroupMode
 	dp.DPCtrlSetStrictGroupMode(&sgm)
+	//set connection report
+	dp.DPCtrlSetConnectReport(agentEnv.connReportWindow, true)
+	//set latency sampling
+	if agentEnv.latencySample != 0 {
+		dp.DPCtrlSetLatency(agentEnv.latencySample, agentEnv.latencyTrace)
+	}
 }
 
 var nextNetworkPolicyVer *share.CLUSGroupIPPolicyVer // incoming network ploicy version
@@ -2425,22 +2489,31 @@ func containerTaskExit() {
 		}
 	}
 	// The following operations are optional
+	var macs []net.HardwareAddr
+	for _, c := range gInfo.activeContainers {
+		if c.pid == 0 {
+			continue
+		}
+		for _, pair := range c.intcpPairs {
+			macs = append(macs, pair.MAC)
+		}
+	}
+	dp.DPCtrlDelMACs(macs)
+
 	for _, c := range gInfo.activeContainers {
 		if c.pid == 0 {
 			continue
 		}
 		netns := global.SYS.GetNetNamespacePath(c.pid)
 		if c.inline || c.quar {
-			for _, pair := range c.intcpPairs {
-				dp.DPCtrlDelMAC(nvSvcPort, pair.MAC)
-				if driver == pipe.PIPE_NOTC {
+			if driver == pipe.PIPE_NOTC {
+				for _, pair := range c.intcpPairs {
 					dp.DPCtrlDelPortPair(pair.ExPort(), pair.InPort())
 				}
 			}
 		} else {
 			for _, pair := range c.intcpPairs {
 				dp.DPCtrlDelTapPort(netns, pair.Port)
-				dp.DPCtrlDelMAC(nvSvcPort, pair.MAC)
 			}
 		}
 		if driver == pipe.PIPE_CLM || isMultiNetworkContainer(c) {
@@ -2459,6 +2532,7 @@ func eventMonitorLoop(probeChan chan *probe.ProbeMessage, fsmonChan chan *fsmon.
 
 	go containerTaskWorker(probeChan, fsmonChan, dpStatusChan)
 
+	startRuntimeEventWorkers()
 	go func() {
 		if err := global.RT.MonitorEvent(runtimeEventCallback, false); err != nil {
 			log.WithFields(log.Fields{"error": err}).Error("Runtime: MonitorEvent Failed")
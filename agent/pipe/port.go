@@ -1390,6 +1390,78 @@ func createIptablesNvQuarRules() {
 	}
 }
 
+// Bits of the packet mark set by the nfq verdicts of the dp, must match dp/nfq.c
+const (
+	nfqMarkMask       = 0x30000000
+	nfqMarkBypass     = 0x10000000
+	nfqMarkUnmark     = 0x20000000
+	nfqMarkUnmarkDrop = 0x30000000
+	nfqMarkSample     = 64 // one in as many packets of a marked connection is still queued
+)
+
+/*
+ * Rules in front of the NFQUEUE rules, top down. Once the verdict of a connection is final,
+ * the dp repeats the hook for its packet with the bypass mark, which is saved to the
+ * connection. Packets of a marked connection skip the queue, but for TCP SYN, FIN, RST and
+ * samples, which are queued with the bypass mark; the dp clears the mark of the connection
+ * with its verdict if the policy of a sample changed.
+ */
+func nfqBypassRules(chain, dir, intf string) []string {
+	m := fmt.Sprintf("%v -t filter %v %v", chain, dir, intf)
+	return []string{
+		fmt.Sprintf("%v -m mark --mark 0x%x/0x%x -j CONNMARK --set-xmark 0x%x/0x%x", m, nfqMarkBypass, nfqMarkMask, nfqMarkBypass, nfqMarkBypass),
+		fmt.Sprintf("%v -m mark --mark 0x%x/0x%x -j CONNMARK --set-xmark 0x0/0x%x", m, nfqMarkUnmark, nfqMarkUnmark, nfqMarkBypass),
+		fmt.Sprintf("%v -m mark --mark 0x%x/0x%x -j DROP", m, nfqMarkUnmarkDrop, nfqMarkMask),
+		fmt.Sprintf("%v -m mark ! --mark 0x0/0x%x -j RETURN", m, nfqMarkMask),
+		fmt.Sprintf("%v -p tcp --tcp-flags SYN,FIN,RST NONE -m connmark --mark 0x%x/0x%x -m statistic --mode nth ! --every %d -j RETURN",
+			m, nfqMarkBypass, nfqMarkBypass, nfqMarkSample),
+		fmt.Sprintf("%v -p udp -m connmark --mark 0x%x/0x%x -m statistic --mode nth ! --every %d -j RETURN",
+			m, nfqMarkBypass, nfqMarkBypass, nfqMarkSample),
+		fmt.Sprintf("%v -m connmark --mark 0x%x/0x%x -j MARK --set-xmark 0x%x/0x%x", m, nfqMarkBypass, nfqMarkBypass, nfqMarkBypass, nfqMarkMask),
+	}
+}
+
+func allNfqBypassRules(intf string) []string {
+	return append(nfqBypassRules(nvInputChain, "-i", intf), nfqBypassRules(nvOutputChain, "-o", intf)...)
+}
+
+func insertNfqBypassRules(intf string) {
+	//insert bottom up to keep them on top of the NFQUEUE rules
+	rules := nfqBypassRules(nvInputChain, "-i", intf)
+	for i := len(rules) - 1; i >= 0; i-- {
+		if _, dbgError := shellCombined("iptables -I " + rules[i]); dbgError != nil {
+			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+		}
+	}
+	rules = nfqBypassRules(nvOutputChain, "-o", intf)
+	for i := len(rules) - 1; i >= 0; i-- {
+		if _, dbgError := shellCombined("iptables -I " + rules[i]); dbgError != nil {
+			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+		}
+	}
+}
+
+// NFQUEUE rules inserted by the check went on top of the bypass rules, they are put back in front
+func checkInsertNfqBypassRules(intf string, reorder bool) {
+	if !reorder {
+		for _, rule := range allNfqBypassRules(intf) {
+			if _, err := shellCombined("iptables -C " + rule); err != nil {
+				reorder = true
+				break
+			}
+		}
+		if !reorder {
+			return
+		}
+	}
+	for _, rule := range allNfqBypassRules(intf) {
+		if _, dbgError := shellCombined("iptables -D " + rule); dbgError != nil {
+			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+		}
+	}
+	insertNfqBypassRules(intf)
+}
+
 func insertIptablesNvRules(intf string, isloopback bool, qno int, appMap map[share.CLUSProtoPort]*share.CLUSApp) {
 	var cmd string
 	if len(appMap) <= 0 {
@@ -1401,6 +1473,7 @@ func insertIptablesNvRules(intf string, isloopback bool, qno int, appMap map[sha
 		if _, dbgError := shellCombined(cmd); dbgError != nil {
 			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 		}
+		insertNfqBypassRules(intf)
 		return
 	}
 
@@ -1443,14 +1516,17 @@ func insertIptablesNvRules(intf string, isloopback bool, qno int, appMap map[sha
 			}
 		}
 	}
+	insertNfqBypassRules(intf)
 }
 
 func checkInsertIptablesNvRules(intf string, isloopback bool, qno int, appMap map[share.CLUSProtoPort]*share.CLUSApp) {
 	var cmd string
+	var inserted bool
 	if len(appMap) <= 0 {
 		cmd = fmt.Sprintf("iptables -C %v -t filter -i %v -j NFQUEUE --queue-num %d --queue-bypass", nvInputChain, intf, qno)
 		if _, err := shellCombined(cmd); err != nil {
 			cmd = fmt.Sprintf("iptables -I %v -t filter -i %v -j NFQUEUE --queue-num %d --queue-bypass", nvInputChain, intf, qno)
+			inserted = true
 			if _, dbgError := shellCombined(cmd); dbgError != nil {
 				log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 			}
@@ -1458,10 +1534,12 @@ func checkInsertIptablesNvRules(intf string, isloopback bool, qno int, appMap ma
 		cmd = fmt.Sprintf("iptables -C %v -t filter -o %v -j NFQUEUE --queue-num %d --queue-bypass", nvOutputChain, intf, qno)
 		if _, err := shellCombined(cmd); err != nil {
 			cmd = fmt.Sprintf("iptables -I %v -t filter -o %v -j NFQUEUE --queue-num %d --queue-bypass", nvOutputChain, intf, qno)
+			inserted = true
 			if _, dbgError := shellCombined(cmd); dbgError != nil {
 				log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 			}
 		}
+		checkInsertNfqBypassRules(intf, inserted)
 		return
 	}
 
@@ -1480,6 +1558,7 @@ func checkInsertIptablesNvRules(intf string, isloopback bool, qno int, appMap ma
 				} else {
 					cmd = fmt.Sprintf("iptables -I %v -t filter -i %v -p tcp --dport %d -j NFQUEUE --queue-num %d --queue-bypass", nvInputChain, intf, p.Port, qno)
 				}
+				inserted = true
 				if _, dbgError := shellCombined(cmd); dbgError != nil {
 					log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 				}
@@ -1497,6 +1576,7 @@ func checkInsertIptablesNvRules(intf string, isloopback bool, qno int, appMap ma
 				} else {
 					cmd = fmt.Sprintf("iptables -I %v -t filter -o %v -p tcp --sport %d -j NFQUEUE --queue-num %d --queue-bypass", nvOutputChain, intf, p.Port, qno)
 				}
+				inserted = true
 				if _, dbgError := shellCombined(cmd); dbgError != nil {
 					log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 				}
@@ -1515,6 +1595,7 @@ func checkInsertIptablesNvRules(intf string, isloopback bool, qno int, appMap ma
 				} else {
 					cmd = fmt.Sprintf("iptables -I %v -t filter -i %v -p udp --dport %d -j NFQUEUE --queue-num %d --queue-bypass", nvInputChain, intf, p.Port, qno)
 				}
+				inserted = true
 				if _, dbgError := shellCombined(cmd); dbgError != nil {
 					log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 				}
@@ -1532,12 +1613,14 @@ func checkInsertIptablesNvRules(intf string, isloopback bool, qno int, appMap ma
 				} else {
 					cmd = fmt.Sprintf("iptables -I %v -t filter -o %v -p udp --sport %d -j NFQUEUE --queue-num %d --queue-bypass", nvOutputChain, intf, p.Port, qno)
 				}
+				inserted = true
 				if _, dbgError := shellCombined(cmd); dbgError != nil {
 					log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 				}
 			}
 		}
 	}
+	checkInsertNfqBypassRules(intf, inserted)
 }
 
 /*
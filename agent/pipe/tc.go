@@ -3,8 +3,10 @@ package pipe
 import (
 	"fmt"
 	"net"
+	"os"
 	"strings"
 
+	"github.com/codeskyblue/go-sh"
 	"github.com/neuvector/neuvector/share/utils"
 	log "github.com/sirupsen/logrus"
 	"github.com/vishvananda/netlink"
@@ -13,6 +15,12 @@ import (
 const tcPrefMax uint = 65536
 const tcPrefBase uint = 10000
 
+// Flow offload classifiers pinned by the dp, see dp/offload.c. They go in front of the
+// forwarding filters and redirect packets of offloaded flows to the peer port.
+const tcPrefOffload uint = tcPrefBase - 1
+const tcOffloadExProg string = "/sys/fs/bpf/nv_flow_ex"
+const tcOffloadInProg string = "/sys/fs/bpf/nv_flow_in"
+
 type tcPortInfo struct {
 	idx  uint // port index in enforcer network namespace
 	pref uint
@@ -58,6 +66,25 @@ func (d *tcPipeDriver) retryCmd(cmd string) error {
 	return err
 }
 
+// Commands run by a single tc process, instead of a process each, when a port pair is
+// programmed. With -force, the commands after a failed one are still run.
+type tcBatch []string
+
+func (b *tcBatch) add(cmd string) {
+	*b = append(*b, strings.TrimPrefix(cmd, "tc "))
+}
+
+func (b *tcBatch) run() {
+	if len(*b) == 0 {
+		return
+	}
+	input := strings.Join(*b, "\n") + "\n"
+	if out, dbgError := sh.Command("tc", []string{"-force", "-batch", "-"}).SetInput(input).CombinedOutput(); dbgError != nil {
+		log.WithFields(log.Fields{"output": string(out), "dbgError": dbgError}).Debug()
+	}
+	*b = nil
+}
+
 func (d *tcPipeDriver) addQDisc(port string) {
 	if _, dbgError := shell(fmt.Sprintf("tc qdisc add dev %v ingress", port)); dbgError != nil {
 		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
@@ -70,6 +97,23 @@ func (d *tcPipeDriver) delQDisc(port string) {
 	}
 }
 
+// The dp only offloads flows of TC-mode endpoints, so without the classifiers all packets
+// still take the forwarding filters.
+func (d *tcPipeDriver) addOffload(b *tcBatch, port, prog, peer string) {
+	if _, err := os.Stat(prog); err != nil {
+		return
+	}
+	cmd := fmt.Sprintf("tc filter add dev %v pref %v parent ffff: protocol ip "+
+		"bpf object-pinned %v "+
+		"action mirred egress redirect dev %v",
+		port, tcPrefOffload, prog, peer)
+	b.add(cmd)
+}
+
+func (d *tcPipeDriver) delOffload(b *tcBatch, port string) {
+	b.add(fmt.Sprintf("tc filter del dev %v parent ffff: protocol ip pref %v", port, tcPrefOffload))
+}
+
 func (d *tcPipeDriver) attachPort(port string) uint {
 	_, idx := waitLinkReady(port)
 	if idx == 0 {
@@ -130,38 +174,32 @@ func (d *tcPipeDriver) ResetPortPair(pid int, pair *InterceptPair) {
 		return
 	}
 
+	var b tcBatch
+	defer b.run()
+
+	d.delOffload(&b, pair.exPort)
+	d.delOffload(&b, pair.inPort)
+
 	// Ingress --
 	// cmd = fmt.Sprintf("tc filter del dev %v parent ffff: protocol all pref %v", pair.exPort, tcPrefBase)
 	// shell(cmd)
 	cmd = fmt.Sprintf("tc filter del dev %v parent ffff: protocol ip pref %v", pair.exPort, tcPrefBase+1)
-	if _, dbgError := shellCombined(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 	cmd = fmt.Sprintf("tc filter del dev %v parent ffff: protocol all pref %v", pair.exPort, tcPrefBase+2)
-	if _, dbgError := shellCombined(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 
 	// Egress --
 	// cmd = fmt.Sprintf("tc filter del dev %v parent ffff: protocol all pref %v", pair.inPort, tcPrefBase)
 	// shell(cmd)
 	cmd = fmt.Sprintf("tc filter del dev %v parent ffff: protocol ip pref %v", pair.inPort, tcPrefBase+1)
-	if _, dbgError := shellCombined(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 	cmd = fmt.Sprintf("tc filter del dev %v parent ffff: protocol all pref %v", pair.inPort, tcPrefBase+2)
-	if _, dbgError := shellCombined(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 
 	cmd = fmt.Sprintf("tc filter del dev %v parent ffff: protocol all pref %v", nvVbrPortName, inInfo.pref)
-	if _, dbgError := shellCombined(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 	cmd = fmt.Sprintf("tc filter del dev %v parent ffff: protocol all pref %v", nvVbrPortName, exInfo.pref)
-	if _, dbgError := shellCombined(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 }
 
 func (d *tcPipeDriver) TapPortPair(pid int, pair *InterceptPair) {
@@ -179,6 +217,10 @@ func (d *tcPipeDriver) TapPortPair(pid int, pair *InterceptPair) {
 		return
 	}
 
+	// The first filter of a port waits for it, the others are added together
+	var b tcBatch
+	defer b.run()
+
 	// Ingress --
 	// Bypass multicast
 	// fmt.Sprintf("tc filter add dev %v pref %v parent ffff: protocol all "+
@@ -208,10 +250,7 @@ func (d *tcPipeDriver) TapPortPair(pid int, pair *InterceptPair) {
 		"u32 match u8 0 0 "+
 		"action mirred egress mirror dev %v",
 		pair.exPort, tcPrefBase+2, pair.inPort)
-	if err := d.retryCmd(cmd); err != nil {
-		log.WithFields(log.Fields{"exPort": pair.exPort}).Error("Cannot find port")
-		return
-	}
+	b.add(cmd)
 
 	// Egress --
 	// Bypass multicast
@@ -241,10 +280,7 @@ func (d *tcPipeDriver) TapPortPair(pid int, pair *InterceptPair) {
 		"u32 match u8 0 0 "+
 		"action mirred egress mirror dev %v",
 		pair.inPort, tcPrefBase+2, pair.exPort)
-	if err := d.retryCmd(cmd); err != nil {
-		log.WithFields(log.Fields{"inPort": pair.inPort}).Error("Cannot find port")
-		return
-	}
+	b.add(cmd)
 
 	// Drop the packets from enforcer
 	cmd = fmt.Sprintf("tc filter add dev %v pref %v parent ffff: protocol all "+
@@ -252,17 +288,13 @@ func (d *tcPipeDriver) TapPortPair(pid int, pair *InterceptPair) {
 		"action drop",
 		nvVbrPortName, exInfo.pref,
 		pair.UCMAC[0], pair.UCMAC[1], pair.UCMAC[2], pair.UCMAC[3], pair.UCMAC[4], pair.UCMAC[5])
-	if _, dbgError := shell(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 	cmd = fmt.Sprintf("tc filter add dev %v pref %v parent ffff: protocol all "+
 		"u32 match u32 0x%02x%02x%02x%02x 0xffffffff at -8 match u16 0x%02x%02x 0xffff at -4 "+
 		"action drop",
 		nvVbrPortName, inInfo.pref,
 		pair.UCMAC[0], pair.UCMAC[1], pair.UCMAC[2], pair.UCMAC[3], pair.UCMAC[4], pair.UCMAC[5])
-	if _, dbgError := shell(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 }
 
 func (d *tcPipeDriver) FwdPortPair(pid int, pair *InterceptPair) {
@@ -279,12 +311,19 @@ func (d *tcPipeDriver) FwdPortPair(pid int, pair *InterceptPair) {
 		return
 	}
 
+	// The first filter of a port waits for it, the others are added together
+	var b tcBatch
+	defer b.run()
+
 	// Ingress --
 	// Bypass multicast
 	// fmt.Sprintf("tc filter add dev %v pref %v parent ffff: protocol all "+
 	// 	"u32 match u8 1 1 at -14 "+
 	// 	"action mirred egress mirror dev %v", pair.exPort, tcPrefBase, pair.inPort)
 
+	// Offloaded flows to the workload, keyed by the destination mac
+	d.addOffload(&b, pair.exPort, tcOffloadExProg, pair.inPort)
+
 	// Forward IP packet, forward unicast packet with DA to the workload
 	cmd = fmt.Sprintf("tc filter add dev %v pref %v parent ffff: protocol ip "+
 		"u32 match u8 0 1 at -14 "+
@@ -305,10 +344,7 @@ func (d *tcPipeDriver) FwdPortPair(pid int, pair *InterceptPair) {
 		"u32 match u8 0 0 "+
 		"action mirred egress mirror dev %v",
 		pair.exPort, tcPrefBase+2, pair.inPort)
-	if err := d.retryCmd(cmd); err != nil {
-		log.WithFields(log.Fields{"exPort": pair.exPort}).Error("Cannot find port")
-		return
-	}
+	b.add(cmd)
 
 	// Egress --
 	// Bypass multicast
@@ -316,6 +352,9 @@ func (d *tcPipeDriver) FwdPortPair(pid int, pair *InterceptPair) {
 	// 	"u32 match u8 1 1 at -14 "+
 	// 	"action mirred egress mirror dev %v", pair.inPort, tcPrefBase, pair.exPort)
 
+	// Offloaded flows from the workload, keyed by the source mac
+	d.addOffload(&b, pair.inPort, tcOffloadInProg, pair.exPort)
+
 	// Forward IP packet, forward unicast packet with SA from the workload
 	cmd = fmt.Sprintf("tc filter add dev %v pref %v parent ffff: protocol ip "+
 		"u32 match u8 0 1 at -14 "+
@@ -336,10 +375,7 @@ func (d *tcPipeDriver) FwdPortPair(pid int, pair *InterceptPair) {
 		"u32 match u8 0 0 "+
 		"action mirred egress mirror dev %v",
 		pair.inPort, tcPrefBase+2, pair.exPort)
-	if err := d.retryCmd(cmd); err != nil {
-		log.WithFields(log.Fields{"inPort": pair.inPort}).Error("Cannot find port")
-		return
-	}
+	b.add(cmd)
 
 	// Forward the packets from enforcer
 	cmd = fmt.Sprintf("tc filter add dev %v pref %v parent ffff: protocol all "+
@@ -350,9 +386,7 @@ func (d *tcPipeDriver) FwdPortPair(pid int, pair *InterceptPair) {
 		pair.UCMAC[0], pair.UCMAC[1], pair.UCMAC[2], pair.UCMAC[3], pair.UCMAC[4], pair.UCMAC[5],
 		pair.MAC[0], pair.MAC[1], pair.MAC[2], pair.MAC[3], pair.MAC[4], pair.MAC[5],
 		pair.inPort)
-	if _, dbgError := shell(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 	cmd = fmt.Sprintf("tc filter add dev %v pref %v parent ffff: protocol all "+
 		"u32 match u32 0x%02x%02x%02x%02x 0xffffffff at -8 match u16 0x%02x%02x 0xffff at -4 "+
 		"action pedit munge offset -8 u32 set 0x%02x%02x%02x%02x munge offset -4 u16 set 0x%02x%02x pipe "+
@@ -361,9 +395,7 @@ func (d *tcPipeDriver) FwdPortPair(pid int, pair *InterceptPair) {
 		pair.UCMAC[0], pair.UCMAC[1], pair.UCMAC[2], pair.UCMAC[3], pair.UCMAC[4], pair.UCMAC[5],
 		pair.MAC[0], pair.MAC[1], pair.MAC[2], pair.MAC[3], pair.MAC[4], pair.MAC[5],
 		pair.exPort)
-	if _, dbgError := shell(cmd); dbgError != nil {
-		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-	}
+	b.add(cmd)
 }
 
 func (d *tcPipeDriver) GetPortPairRules(pair *InterceptPair) (string, string, string) {
@@ -903,10 +903,19 @@ func addWlHostModeAddrToPolicyAddrMap(from *share.CLUSWorkloadAddr, newHostPolic
 	}
 }
 
+// Only the workloads with a changed dependency are computed when deps has the ones of the
+// last computation, see network_deps.go. The other workloads of workloadPolicyMap are
+// returned with no rules.
 func (e *Engine) parseGroupIPPolicy(p []share.CLUSGroupIPPolicy, workloadPolicyMap map[string]*WorkloadIPPolicyInfo,
-	newPolicyAddrMap, newHostPolicyAddrMap map[string]share.CLUSSubnet) {
+	newPolicyAddrMap, newHostPolicyAddrMap map[string]share.CLUSSubnet, deps, oldDeps *ipPolicyDeps) map[string]*WorkloadIPPolicyInfo {
 	addrMap := make(map[string]*share.CLUSWorkloadAddr)
+	pMap := workloadPolicyMap
 	for i, pp := range p {
+		if i == 1 {
+			if m := deps.affected(oldDeps, p, workloadPolicyMap, addrMap, e.NetworkPolicy); m != nil {
+				pMap = m
+			}
+		}
 		// The first rule is the default rule that contains all container
 		if i == 0 {
 			for _, from := range pp.From {
@@ -936,12 +945,15 @@ func (e *Engine) parseGroupIPPolicy(p []share.CLUSGroupIPPolicy, workloadPolicyM
 			continue
 		}
 
+		wild := isGroupWideAddr(pp.From) || isGroupWideAddr(pp.To)
+
 		/* create egress rules */
-		wlList, pInfoList := getRelevantWorkload(pp.From, workloadPolicyMap, addrMap, false)
+		wlList, pInfoList := getRelevantWorkload(pp.From, pMap, addrMap, false)
 		wlToList := getWorkload(pp.To, addrMap, true)
-		for i, from := range wlList {
-			pInfo := pInfoList[i]
+		for j, from := range wlList {
+			pInfo := pInfoList[j]
 			for _, to := range wlToList {
+				deps.add(i, wild, pInfo, to.WlID)
 				if pInfo.Policy.ApplyDir&C.DP_POLICY_APPLY_EGRESS > 0 {
 					var sameHost bool = false
 					if isSameHostEP(to.WlID, e.HostID) {
@@ -981,11 +993,12 @@ func (e *Engine) parseGroupIPPolicy(p []share.CLUSGroupIPPolicy, workloadPolicyM
 		}
 
 		/* create ingress rules */
-		wlList, pInfoList = getRelevantWorkload(pp.To, workloadPolicyMap, addrMap, true)
+		wlList, pInfoList = getRelevantWorkload(pp.To, pMap, addrMap, true)
 		wlFromList := getWorkload(pp.From, addrMap, false)
-		for i, to := range wlList {
-			pInfo := pInfoList[i]
+		for j, to := range wlList {
+			pInfo := pInfoList[j]
 			for _, from := range wlFromList {
+				deps.add(i, wild, pInfo, from.WlID)
 				if pInfo.Policy.ApplyDir&C.DP_POLICY_APPLY_INGRESS > 0 {
 					var sameHost bool = false
 					if isSameHostEP(from.WlID, e.HostID) {
@@ -1014,6 +1027,11 @@ func (e *Engine) parseGroupIPPolicy(p []share.CLUSGroupIPPolicy, workloadPolicyM
 			}
 		}
 	}
+
+	for id := range pMap {
+		deps.workload(id)
+	}
+	return pMap
 }
 
 var SpecialSubnets map[string]share.CLUSSpecSubnet = make(map[string]share.CLUSSpecSubnet)
@@ -1106,7 +1124,7 @@ type unknown_ip_desc struct {
 }
 
 type unknown_ip_cache struct {
-	timerTask string
+	timerTask utils.TimerHandle
 	desc      unknown_ip_desc
 	polver    uint16
 	start_hit time.Time
@@ -1156,8 +1174,8 @@ func add_unkn_ip_cache(uip_desc *unknown_ip_desc, polver uint16, iptype string,
 	task.desc.sip = uip_desc.sip
 	task.desc.dip = uip_desc.dip
 
-	cache.timerTask, _ = aTimerWheel.AddTask(task, UNKN_IP_CACHE_TIMEOUT)
-	if cache.timerTask == "" {
+	cache.timerTask, _ = aTimerWheel.AddTimer(task, UNKN_IP_CACHE_TIMEOUT)
+	if cache.timerTask == 0 {
 		log.Error("Fail to insert unknown IP cache timer")
 	}
 	unknown_ip_map_mutex.Lock()
@@ -1267,6 +1285,23 @@ func policy_chk_nbe(pInfo *WorkloadIPPolicyInfo, conn *dp.Connection, policyId u
 	}
 	return id, action, chg
 }
+
+// First rule of the connection direction that matches
+func hostRulesMatch(pInfo *WorkloadIPPolicyInfo, conn *dp.Connection) (bool, uint32, uint8) {
+	if pInfo.hostRules != nil {
+		return pInfo.hostRules.match(conn)
+	}
+	for _, p := range pInfo.Policy.IPRules {
+		if p.Ingress != conn.Ingress {
+			continue
+		}
+		if match, id, action := hostPolicyMatch(p, conn); match {
+			return true, id, action
+		}
+	}
+	return false, 0, 0
+}
+
 func (e *Engine) HostNetworkPolicyLookup(wl string, conn *dp.Connection) (uint32, uint8, bool) {
 	e.Mutex.Lock()
 	pInfo := e.NetworkPolicy[wl]
@@ -1282,41 +1317,21 @@ func (e *Engine) HostNetworkPolicyLookup(wl string, conn *dp.Connection) (uint32
 			!isNbe {
 			return 0, C.DP_POLICY_ACTION_OPEN, false
 		}
-
-		for _, p := range pInfo.Policy.IPRules {
-			if !p.Ingress {
-				continue
-			}
-			if match, id, action := hostPolicyMatch(p, conn); match {
-				tid, taction, tchg := policy_chk_nbe(pInfo, conn, id, action)
-				if tchg {
-					id = tid
-					action = taction
-				}
-				return id, action, action > C.DP_POLICY_ACTION_CHECK_APP
-			}
-		}
 	} else {
 		if !conn.ExternalPeer &&
 			(pInfo.Policy.ApplyDir&C.DP_POLICY_APPLY_EGRESS == 0) &&
 			!isNbe {
 			return 0, C.DP_POLICY_ACTION_OPEN, false
 		}
+	}
 
-		for _, p := range pInfo.Policy.IPRules {
-			if p.Ingress {
-				continue
-			}
-
-			if match, id, action := hostPolicyMatch(p, conn); match {
-				tid, taction, tchg := policy_chk_nbe(pInfo, conn, id, action)
-				if tchg {
-					id = tid
-					action = taction
-				}
-				return id, action, action > C.DP_POLICY_ACTION_CHECK_APP
-			}
+	if match, id, action := hostRulesMatch(pInfo, conn); match {
+		tid, taction, tchg := policy_chk_nbe(pInfo, conn, id, action)
+		if tchg {
+			id = tid
+			action = taction
 		}
+		return id, action, action > C.DP_POLICY_ACTION_CHECK_APP
 	}
 	action := policyModeToDefaultAction(pInfo.Policy.Mode, pInfo.CapIntcp)
 	if action != C.DP_POLICY_ACTION_VIOLATE && action != C.DP_POLICY_ACTION_DENY {
@@ -1386,7 +1401,17 @@ func (e *Engine) UpdateNetworkPolicy(ps []share.CLUSGroupIPPolicy,
 
 	newPolicyAddrMap := make(map[string]share.CLUSSubnet)
 	newHostPolicyAddrMap := make(map[string]share.CLUSSubnet)
-	e.parseGroupIPPolicy(ps, newPolicy, newPolicyAddrMap, newHostPolicyAddrMap)
+	deps := newIPPolicyDeps(e, ps, newPolicy)
+	computed := e.parseGroupIPPolicy(ps, newPolicy, newPolicyAddrMap, newHostPolicyAddrMap, deps, e.ipDeps)
+	if len(computed) < len(newPolicy) {
+		for id, pInfo := range newPolicy {
+			if _, ok := computed[id]; !ok {
+				deps.keep(e.ipDeps, pInfo, e.NetworkPolicy[id])
+			}
+		}
+		log.WithFields(log.Fields{"computed": len(computed), "workloads": len(newPolicy)}).Debug("")
+	}
+	e.ipDeps = deps
 
 	dpConnected := dp.Connected()
 
@@ -1399,6 +1424,9 @@ func (e *Engine) UpdateNetworkPolicy(ps []share.CLUSGroupIPPolicy,
 	for id, pInfo := range newPolicy {
 		// release the ruleMap as it is not needed anymore
 		pInfo.RuleMap = nil
+		if pInfo.HostMode && pInfo.Configured && pInfo.hostRules == nil {
+			pInfo.hostRules = newHostRuleIndex(pInfo.Policy.IPRules)
+		}
 
 		// For workload that is not configured, policy is not calculated yet.
 		// Don't send policy to DP so that DP will bypass the traffic
@@ -1423,7 +1451,11 @@ func (e *Engine) UpdateNetworkPolicy(ps []share.CLUSGroupIPPolicy,
 				hostPolicyChangeSet.Add(id)
 			} else if dpConnected {
 				//simulateAddLargeNumIPRules(&pInfo.Policy, pInfo.Policy.ApplyDir)
-				dp.DPCtrlConfigPolicy(&pInfo.Policy, C.CFG_MODIFY)
+				if old.Configured && !old.SkipPush && !old.HostMode && !ToggleIcmpPolicy {
+					dp.DPCtrlUpdatePolicy(&old.Policy, &pInfo.Policy)
+				} else {
+					dp.DPCtrlConfigPolicy(&pInfo.Policy, C.CFG_MODIFY)
+				}
 			}
 		}
 	}
@@ -1493,6 +1525,7 @@ func (e *Engine) PushNetworkPolicyToDP() {
 func (e *Engine) PushFqdnInfoToDP() {
 	fqdn_key := fmt.Sprintf("%s%s/", share.CLUSFqdnIpStore, e.HostID)
 	allKeys, _ := cluster.GetStoreKeys(fqdn_key)
+	fqdnips := make([]*share.CLUSFqdnIp, 0, len(allKeys))
 	for _, key := range allKeys {
 		if value, _ := cluster.Get(key); value != nil {
 			uzb := utils.GunzipBytes(value)
@@ -1501,10 +1534,11 @@ func (e *Engine) PushFqdnInfoToDP() {
 				if dbgError := json.Unmarshal(uzb, &fqdnip); dbgError != nil {
 					log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 				}
-				dp.DPCtrlSetFqdnIp(&fqdnip)
+				fqdnips = append(fqdnips, &fqdnip)
 			}
 		}
 	}
+	dp.DPCtrlSetFqdnIps(fqdnips)
 }
 
 // dlp
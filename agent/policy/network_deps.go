@@ -0,0 +1,249 @@
+package policy
+
+import (
+	"encoding/json"
+	"fmt"
+	"hash/fnv"
+	"sort"
+	"strings"
+
+	"github.com/neuvector/neuvector/share"
+)
+
+// The ip rules of a local workload depend on the group ip policies that were matched against
+// it, on the addresses of the peers of those policies and on its own address and settings.
+// These dependencies are kept from one computation to the next so that when new group ip
+// policies come in, only the local workloads with a changed dependency are computed again,
+// the others keep their rules.
+
+type wlIPPolicyDeps struct {
+	rules map[uint64]bool // hash of the group ip policies matched against the workload
+	addrs map[string]bool // workload id of the peers, and its own
+	fqdns map[string]bool
+	wild  bool // a matched policy has a group wide address, any address change is one
+}
+
+type ipPolicyDeps struct {
+	globals uint64
+	rules   map[uint64]int    // group ip policy hash -> position, the default policy excluded
+	hashes  []uint64          // by position
+	addrs   map[string]uint64 // address hash by workload id, from the default policy
+	local   map[string]uint64 // input hash of the local workloads
+	wls     map[string]*wlIPPolicyDeps
+}
+
+func ipPolicyHash(v interface{}) uint64 {
+	h := fnv.New64a()
+	if value, err := json.Marshal(v); err == nil {
+		h.Write(value)
+	}
+	return h.Sum64()
+}
+
+func ipPolicyGlobals(e *Engine) uint64 {
+	var ips []string
+	if e.HostIPs != nil {
+		ips = e.HostIPs.ToStringSlice()
+		sort.Strings(ips)
+	}
+	h := fnv.New64a()
+	fmt.Fprintf(h, "%v/%v/%s/%s", StrictGroupMode, polAppDir, e.HostID, strings.Join(ips, ","))
+	return h.Sum64()
+}
+
+// What the computation of a local workload reads from it before the rules are added
+func localIPPolicyHash(pInfo *WorkloadIPPolicyInfo) uint64 {
+	return ipPolicyHash(struct {
+		Policy   interface{}
+		SkipPush bool
+		HostMode bool
+		CapIntcp bool
+		Nbe      bool
+	}{&pInfo.Policy, pInfo.SkipPush, pInfo.HostMode, pInfo.CapIntcp, pInfo.Nbe})
+}
+
+// Hash the inputs, before the computation fills the addresses of the policies
+func newIPPolicyDeps(e *Engine, p []share.CLUSGroupIPPolicy, workloadPolicyMap map[string]*WorkloadIPPolicyInfo) *ipPolicyDeps {
+	d := &ipPolicyDeps{
+		globals: ipPolicyGlobals(e),
+		rules:   make(map[uint64]int, len(p)),
+		hashes:  make([]uint64, len(p)),
+		addrs:   make(map[string]uint64),
+		local:   make(map[string]uint64, len(workloadPolicyMap)),
+		wls:     make(map[string]*wlIPPolicyDeps, len(workloadPolicyMap)),
+	}
+	for i := range p {
+		if i == 0 {
+			for _, from := range p[0].From {
+				d.addrs[from.WlID] = ipPolicyHash(from)
+			}
+			continue
+		}
+		h := ipPolicyHash(&p[i])
+		d.hashes[i] = h
+		if _, ok := d.rules[h]; ok {
+			// Identical policies, positions can't be told apart
+			d.rules = nil
+			break
+		}
+		d.rules[h] = i
+	}
+	for id, pInfo := range workloadPolicyMap {
+		d.local[id] = localIPPolicyHash(pInfo)
+	}
+	return d
+}
+
+func (d *ipPolicyDeps) workload(id string) *wlIPPolicyDeps {
+	wd, ok := d.wls[id]
+	if !ok {
+		wd = &wlIPPolicyDeps{
+			rules: make(map[uint64]bool),
+			addrs: map[string]bool{id: true},
+			fqdns: make(map[string]bool),
+		}
+		d.wls[id] = wd
+	}
+	return wd
+}
+
+func isGroupWideAddr(addrs []*share.CLUSWorkloadAddr) bool {
+	for _, addr := range addrs {
+		if addr.WlID == share.CLUSWLModeGroup || addr.WlID == share.CLUSWLAllContainer {
+			return true
+		}
+	}
+	return false
+}
+
+// A local workload is matched against the policy at pos, with a peer. wild if the policy has
+// a group wide address.
+func (d *ipPolicyDeps) add(pos int, wild bool, pInfo *WorkloadIPPolicyInfo, peer string) {
+	wd := d.workload(pInfo.Policy.WlID)
+	wd.rules[d.hashes[pos]] = true
+	wd.addrs[peer] = true
+	if isWorkloadFqdn(peer) {
+		name, _ := getFqdnName(peer)
+		wd.fqdns[name] = true
+	}
+	if wild {
+		wd.wild = true
+	}
+}
+
+// Local workloads to compute, all of them if nil. The default policy has been parsed.
+func (d *ipPolicyDeps) affected(old *ipPolicyDeps, p []share.CLUSGroupIPPolicy, workloadPolicyMap map[string]*WorkloadIPPolicyInfo,
+	addrMap map[string]*share.CLUSWorkloadAddr, oldPolicy map[string]*WorkloadIPPolicyInfo) map[string]*WorkloadIPPolicyInfo {
+
+	if old == nil || old.rules == nil || d.rules == nil || old.globals != d.globals || ToggleIcmpPolicy {
+		return nil
+	}
+
+	// Policies kept have to be in the same order, added ones are matched below
+	type posPair struct{ old, cur int }
+	kept := make([]posPair, 0, len(d.rules))
+	added := make([]int, 0)
+	for h, i := range d.rules {
+		if j, ok := old.rules[h]; ok {
+			kept = append(kept, posPair{old: j, cur: i})
+		} else {
+			added = append(added, i)
+		}
+	}
+	sort.Slice(kept, func(a, b int) bool { return kept[a].cur < kept[b].cur })
+	for i := 1; i < len(kept); i++ {
+		if kept[i].old < kept[i-1].old {
+			return nil
+		}
+	}
+	removed := make([]uint64, 0)
+	for h := range old.rules {
+		if _, ok := d.rules[h]; !ok {
+			removed = append(removed, h)
+		}
+	}
+
+	changed := make([]string, 0)
+	for id, h := range d.addrs {
+		if oh, ok := old.addrs[id]; !ok || oh != h {
+			changed = append(changed, id)
+		}
+	}
+	for id := range old.addrs {
+		if _, ok := d.addrs[id]; !ok {
+			changed = append(changed, id)
+		}
+	}
+	// A workload that turns local or remote changes the rules of its peers
+	for id := range d.local {
+		if _, ok := old.local[id]; !ok {
+			changed = append(changed, id)
+		}
+	}
+	for id := range old.local {
+		if _, ok := d.local[id]; !ok {
+			changed = append(changed, id)
+		}
+	}
+
+	pMap := make(map[string]*WorkloadIPPolicyInfo)
+	for id, pInfo := range workloadPolicyMap {
+		wd, ok := old.wls[id]
+		if _, ok2 := oldPolicy[id]; !ok || !ok2 || old.local[id] != d.local[id] {
+			pMap[id] = pInfo
+			continue
+		}
+		if wd.wild && len(changed) > 0 {
+			pMap[id] = pInfo
+			continue
+		}
+		for _, h := range removed {
+			if wd.rules[h] {
+				pMap[id] = pInfo
+				break
+			}
+		}
+		for _, a := range changed {
+			if wd.addrs[a] {
+				pMap[id] = pInfo
+				break
+			}
+		}
+		for name := range wd.fqdns {
+			if _, ok := fqdnMap[name]; !ok {
+				pMap[id] = pInfo
+				break
+			}
+		}
+	}
+
+	for _, i := range added {
+		pp := &p[i]
+		for _, isto := range []bool{false, true} {
+			addrs := pp.From
+			if isto {
+				addrs = pp.To
+			}
+			_, pInfoList := getRelevantWorkload(addrs, workloadPolicyMap, addrMap, isto)
+			for _, pInfo := range pInfoList {
+				pMap[pInfo.Policy.WlID] = pInfo
+			}
+		}
+	}
+	return pMap
+}
+
+// The workload is not computed again, it keeps its rules and dependencies
+func (d *ipPolicyDeps) keep(old *ipPolicyDeps, pInfo, oldInfo *WorkloadIPPolicyInfo) {
+	id := pInfo.Policy.WlID
+	pInfo.Policy.IPRules = oldInfo.Policy.IPRules
+	pInfo.hostRules = oldInfo.hostRules
+	if wd, ok := old.wls[id]; ok {
+		d.wls[id] = wd
+		for name := range wd.fqdns {
+			if info, ok := fqdnMap[name]; ok {
+				info.used = true
+			}
+		}
+	}
+}
@@ -0,0 +1,177 @@
+package policy
+
+import (
+	"bytes"
+	"net"
+	"sort"
+
+	"github.com/neuvector/neuvector/agent/dp"
+)
+
+// The ip rules of a host-mode workload are indexed by the peer address when the policy is
+// applied, so that a connection reported by the probe is only matched against the rules
+// that can match its peer, in the rule order, and not against all of them. Addresses are
+// compared in their 16-byte form.
+
+type hostRuleSeg struct {
+	start [net.IPv6len]byte // up to the start of the next segment
+	rules []int
+}
+
+type hostRuleDir struct {
+	exact map[[net.IPv6len]byte][]int
+	segs  []hostRuleSeg // of the ranges, by start
+	zero  []int         // rules from 0.0.0.0, they match any external peer
+}
+
+type hostRuleIndex struct {
+	rules []*dp.DPPolicyIPRule
+	dirs  [2]hostRuleDir // egress, ingress
+}
+
+func hostRuleKey(ip net.IP) ([net.IPv6len]byte, bool) {
+	var k [net.IPv6len]byte
+	ip16 := ip.To16()
+	if ip16 == nil {
+		return k, false
+	}
+	copy(k[:], ip16)
+	return k, true
+}
+
+// Next address, false if k is the last one
+func hostRuleKeyNext(k [net.IPv6len]byte) ([net.IPv6len]byte, bool) {
+	for i := net.IPv6len - 1; i >= 0; i-- {
+		k[i]++
+		if k[i] != 0 {
+			return k, true
+		}
+	}
+	return k, false
+}
+
+func newHostRuleDir(rules []*dp.DPPolicyIPRule, ingress bool) hostRuleDir {
+	type hostRuleRange struct {
+		l, r [net.IPv6len]byte
+		idx  int
+	}
+
+	d := hostRuleDir{exact: make(map[[net.IPv6len]byte][]int)}
+	ranges := make([]hostRuleRange, 0)
+	for i, r := range rules {
+		if r.Ingress != ingress {
+			continue
+		}
+		ipL, ipR := r.DstIP, r.DstIPR
+		if ingress {
+			ipL, ipR = r.SrcIP, r.SrcIPR
+		}
+		l, ok := hostRuleKey(ipL)
+		if !ok {
+			continue
+		}
+		if net.IP.Equal(ipL, net.IPv4zero) {
+			d.zero = append(d.zero, i)
+		}
+		if rk, ok := hostRuleKey(ipR); ok && bytes.Compare(rk[:], l[:]) > 0 {
+			ranges = append(ranges, hostRuleRange{l: l, r: rk, idx: i})
+		} else {
+			d.exact[l] = append(d.exact[l], i)
+		}
+	}
+	if len(ranges) == 0 {
+		return d
+	}
+
+	// Segments between the boundaries of the ranges, with the ranges covering them
+	bounds := make(map[[net.IPv6len]byte]bool, len(ranges)*2)
+	for _, rg := range ranges {
+		bounds[rg.l] = true
+		if next, ok := hostRuleKeyNext(rg.r); ok {
+			bounds[next] = true
+		}
+	}
+	d.segs = make([]hostRuleSeg, 0, len(bounds))
+	for b := range bounds {
+		d.segs = append(d.segs, hostRuleSeg{start: b})
+	}
+	sort.Slice(d.segs, func(a, b int) bool { return bytes.Compare(d.segs[a].start[:], d.segs[b].start[:]) < 0 })
+	for i := range d.segs {
+		s := d.segs[i].start[:]
+		for _, rg := range ranges {
+			if bytes.Compare(rg.l[:], s) <= 0 && bytes.Compare(s, rg.r[:]) <= 0 {
+				d.segs[i].rules = append(d.segs[i].rules, rg.idx)
+			}
+		}
+	}
+	return d
+}
+
+func newHostRuleIndex(rules []*dp.DPPolicyIPRule) *hostRuleIndex {
+	return &hostRuleIndex{
+		rules: rules,
+		dirs:  [2]hostRuleDir{newHostRuleDir(rules, false), newHostRuleDir(rules, true)},
+	}
+}
+
+// Rules that can match the peer, in the rule order
+func (d *hostRuleDir) candidates(ip net.IP, external bool) []int {
+	k, ok := hostRuleKey(ip)
+	if !ok {
+		return nil
+	}
+
+	lists := make([][]int, 0, 3)
+	if l := d.exact[k]; len(l) > 0 {
+		lists = append(lists, l)
+	}
+	if n := sort.Search(len(d.segs), func(i int) bool {
+		return bytes.Compare(d.segs[i].start[:], k[:]) > 0
+	}); n > 0 && len(d.segs[n-1].rules) > 0 {
+		lists = append(lists, d.segs[n-1].rules)
+	}
+	if external && len(d.zero) > 0 {
+		lists = append(lists, d.zero)
+	}
+	if len(lists) == 1 {
+		return lists[0]
+	}
+
+	// Merge, a rule from 0.0.0.0 can be in two of the lists
+	ret := make([]int, 0)
+	pos := make([]int, len(lists))
+	for {
+		next := -1
+		for i, l := range lists {
+			if pos[i] < len(l) && (next < 0 || l[pos[i]] < next) {
+				next = l[pos[i]]
+			}
+		}
+		if next < 0 {
+			return ret
+		}
+		for i, l := range lists {
+			if pos[i] < len(l) && l[pos[i]] == next {
+				pos[i]++
+			}
+		}
+		ret = append(ret, next)
+	}
+}
+
+// As matching the rules of the connection direction in order with hostPolicyMatch()
+func (x *hostRuleIndex) match(conn *dp.Connection) (bool, uint32, uint8) {
+	var d *hostRuleDir
+	var peer net.IP
+	if conn.Ingress {
+		d, peer = &x.dirs[1], conn.ClientIP
+	} else {
+		d, peer = &x.dirs[0], conn.ServerIP
+	}
+	for _, i := range d.candidates(peer, conn.ExternalPeer) {
+		if match, id, action := hostPolicyMatch(x.rules[i], conn); match {
+			return true, id, action
+		}
+	}
+	return false, 0, 0
+}
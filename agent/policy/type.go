@@ -23,6 +23,7 @@ type WorkloadIPPolicyInfo struct {
 	CapIntcp   bool
 	PolVer     uint16
 	Nbe        bool
+	hostRules  *hostRuleIndex // of host-mode workloads
 }
 
 type DlpBuildInfo struct {
@@ -45,6 +46,7 @@ type Engine struct {
 	HostPolicyAddrMap map[string]share.CLUSSubnet
 	PolTimerWheel     *utils.TimerWheel
 	PolDomNBEMap      map[string]bool
+	ipDeps            *ipPolicyDeps // of the last network policy computation
 }
 
 func (e *Engine) Init(HostID string, HostIPs utils.Set, TunnelIP []net.IPNet, cb GroupProcPolicyCallback, pad int) {
@@ -20,6 +20,11 @@ import (
 const hostRootMountPoint = "/proc/1/root"
 const waitFileActionCompleteSteps int = 16
 
+// Walks of the container layers run at a time. A walk and the file calculations are done
+// outside of the lock, the root is put in place when it is complete, so the events of the
+// other containers go on while many containers start.
+const fsnMaxEnums int = 4
+
 const (
 	drv_overlayfs = iota
 	drv_aufs
@@ -65,6 +70,7 @@ type FileNotificationCtr struct {
 	compLength int
 	roots      map[string]*fsnRootFd // index: rootPath by compLength
 	rootsByID  map[string]*fsnRootFd // index: container id (ref by probe)
+	enumSlots  chan struct{}
 }
 
 // ///
@@ -88,6 +94,7 @@ func NewFsnCenter(p *Probe, rtStorageDriver string) (*FileNotificationCtr, bool)
 		roots:     make(map[string]*fsnRootFd),
 		rootsByID: make(map[string]*fsnRootFd),
 		prober:    p,
+		enumSlots: make(chan struct{}, fsnMaxEnums),
 	}
 
 	switch strings.ToLower(rtStorageDriver) {
@@ -118,6 +125,9 @@ func NewFsnCenter(p *Probe, rtStorageDriver string) (*FileNotificationCtr, bool)
 // // No recursive dir mark is for inotify
 // // Add all sub-directories from the top layers
 func (fsn *FileNotificationCtr) enumFiles(rootPath, id string, bInit bool) (utils.Set, map[string]*fileInfo) {
+	fsn.enumSlots <- struct{}{}
+	defer func() { <-fsn.enumSlots }()
+
 	dirs := utils.NewSet()
 	files := make(map[string]*fileInfo)
 	dirs.Add(rootPath)
@@ -238,9 +248,8 @@ func (fsn *FileNotificationCtr) updateFileInfo(index string, file, path string)
 	var fi os.FileInfo
 
 	fsn.lockMux()
-	defer fsn.unlockMux()
-
 	root, ok := fsn.roots[index]
+	fsn.unlockMux()
 	if !ok {
 		// the container might be removed
 		// log.WithFields(log.Fields{"index": index}).Debug("FSN: no root")
@@ -273,6 +282,12 @@ func (fsn *FileNotificationCtr) updateFileInfo(index string, file, path string)
 	// calculations
 	bExec, bJavaPkg, length, hash := calculateFileInfo(fi, path)
 
+	fsn.lockMux()
+	defer fsn.unlockMux()
+	if r, ok := fsn.roots[index]; !ok || r != root {
+		return // removed or added again while the file was read
+	}
+
 	// updating record
 	var bUpdated, bNewFile bool
 	finfo, ok := root.files[file]
@@ -376,19 +391,7 @@ func (fsn *FileNotificationCtr) handleEvent(event fsnotify.Event) {
 	if (event.Op & fsnotify.Create) != 0 {
 		switch {
 		case fi.IsDir():
-			dirs, _ := fsn.enumFiles(path, root.id, false)
-			// sample: mkdir -p /tmp/test/bin, only "/tmp" was reported.
-			for d := range dirs.Iter() {
-				dir := d.(string)
-				if fsn.skipPathByRole(root.role, dir[root.cLayerLen:]) {
-					continue
-				}
-				// mLog.WithFields(log.Fields{"rdir": dir[root.cLayerLen:]}).Debug("FSN: new dir")
-				if dbgError := fsn.addDir(dir); dbgError != nil {
-					log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-				}
-				root.dirs.Add(dir)
-			}
+			go fsn.addNewDirs(index, root, path)
 		case fi.Mode().IsRegular():
 			// mLog.WithFields(log.Fields{"file": file, "path": path}).Debug("FSN: new file")
 			name := filepath.Base(file)
@@ -416,6 +419,29 @@ func (fsn *FileNotificationCtr) handleEvent(event fsnotify.Event) {
 	}
 }
 
+// sample: mkdir -p /tmp/test/bin, only "/tmp" was reported.
+func (fsn *FileNotificationCtr) addNewDirs(index string, root *fsnRootFd, path string) {
+	dirs, _ := fsn.enumFiles(path, root.id, false)
+
+	fsn.lockMux()
+	defer fsn.unlockMux()
+	if r, ok := fsn.roots[index]; !ok || r != root {
+		return
+	}
+
+	for d := range dirs.Iter() {
+		dir := d.(string)
+		if fsn.skipPathByRole(root.role, dir[root.cLayerLen:]) {
+			continue
+		}
+		// mLog.WithFields(log.Fields{"rdir": dir[root.cLayerLen:]}).Debug("FSN: new dir")
+		if dbgError := fsn.addDir(dir); dbgError != nil {
+			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+		}
+		root.dirs.Add(dir)
+	}
+}
+
 // main worker: goroutine
 func (fsn *FileNotificationCtr) monitorEvents() {
 	defer fsn.Close()
@@ -483,8 +509,6 @@ func (fsn *FileNotificationCtr) AddContainer(id, cPath, role string, pid int) (b
 	}
 
 	fsn.lockMux()
-	defer fsn.unlockMux()
-
 	// update the compared length if it is not set
 	if fsn.compLength == 0 {
 		fsn.compLength = len(path)
@@ -494,18 +518,13 @@ func (fsn *FileNotificationCtr) AddContainer(id, cPath, role string, pid int) (b
 	index := fsn.rootIndex(path)
 	// log.WithFields(log.Fields{"id": id, "index": index}).Debug("FSN:")
 
-	//// existing entry, remove its marks at first
-	if r, ok := fsn.roots[index]; ok {
-		for dir := range r.dirs.Iter() {
-			if dbgError := fsn.removeDir(dir.(string)); dbgError != nil {
-				log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-			}
-		}
-		r.files = nil
-		r.dirs.Clear()
-		delete(fsn.roots, index)
-		delete(fsn.rootsByID, id)
+	// The layer of a container added again is known, its records are kept up to date by the
+	// events, so they are taken over instead of walking the layer again
+	known, ok := fsn.roots[index]
+	if ok && (known.id != id || known.cLayer != path) {
+		known = nil
 	}
+	fsn.unlockMux()
 
 	//// create root records
 	root := &fsnRootFd{
@@ -514,17 +533,46 @@ func (fsn *FileNotificationCtr) AddContainer(id, cPath, role string, pid int) (b
 		cLayer:    path,
 		cLayerLen: len(path),
 		pid:       pid,
-		dirs:      utils.NewSet(),             // temporary
-		files:     make(map[string]*fileInfo), // temporary
 	}
 
-	// construct the initial file map
-	if fsn.storageDrv == drv_btrfs {
-		// It is composed of the image files and the new created files
-		// differentiate the "..._init" folder to filter out the image files
-		root.dirs, root.files, root.imgLayer = fsn.enumBtrfsInitFiles(path, id)
-	} else {
-		root.dirs, root.files = fsn.enumFiles(path, id, true)
+	// construct the initial file map, outside of the lock
+	if known == nil {
+		if fsn.storageDrv == drv_btrfs {
+			// It is composed of the image files and the new created files
+			// differentiate the "..._init" folder to filter out the image files
+			root.dirs, root.files, root.imgLayer = fsn.enumBtrfsInitFiles(path, id)
+		} else {
+			root.dirs, root.files = fsn.enumFiles(path, id, true)
+		}
+	}
+
+	fsn.lockMux()
+	defer fsn.unlockMux()
+	if !fsn.bEnabled {
+		return false, nil
+	}
+	if known != nil {
+		if r, ok := fsn.roots[index]; !ok || r != known {
+			log.WithFields(log.Fields{"id": id}).Debug("FSN: removed while added")
+			return false, nil
+		}
+		root.dirs, root.files, root.imgLayer = known.dirs.Clone(), make(map[string]*fileInfo, len(known.files)), known.imgLayer
+		for file, finfo := range known.files {
+			root.files[file] = finfo
+		}
+	}
+
+	//// existing entry, remove its marks at first
+	if r, ok := fsn.roots[index]; ok {
+		for dir := range r.dirs.Iter() {
+			if dbgError := fsn.removeDir(dir.(string)); dbgError != nil {
+				log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+			}
+		}
+		r.files = nil
+		r.dirs.Clear()
+		delete(fsn.roots, index)
+		delete(fsn.rootsByID, r.id)
 	}
 
 	for d := range root.dirs.Iter() {
@@ -676,6 +724,9 @@ func (fsn *FileNotificationCtr) enumBtrfsInitFiles(rootPath, id string) (utils.S
 	var err error
 	var bytesValue []byte
 
+	fsn.enumSlots <- struct{}{}
+	defer func() { <-fsn.enumSlots }()
+
 	dirs := utils.NewSet()
 	files := make(map[string]*fileInfo)
 	fileMap := make(map[string]*workerlet.FileData)
@@ -191,6 +191,7 @@ func (p *Probe) processContainerAppPortChanges() {
 	defer p.unlockProcMux()
 
 	changes := utils.NewSet()
+	tbls := make(socketTableCache)
 	for id, c := range p.containerMap {
 		if c.rootPid == 0 {
 			c.rootPid = p.getContainerPid(id)
@@ -202,7 +203,7 @@ func (p *Probe) processContainerAppPortChanges() {
 
 		if id != "" && id != p.selfID && c.rootPid != 0 {
 			// Check whether the container has port or app changed
-			if p.checkProcAppPorts(c, true) {
+			if p.checkProcAppPorts(c, true, tbls) {
 				changes.Add(id)
 			}
 		}
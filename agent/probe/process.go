@@ -291,7 +291,10 @@ func shouldScanProc(proc *procInternal) bool {
 //
 //	 When (c3) or (c4) takes too long, we have this false-positive cases.
 //	 Also, it is impossible to catch the (c2) event by a polling method.
-func (p *Probe) checkProcAppPorts(c *procContainer, rateLimit bool) bool {
+//
+//	 tbls shares the socket tables between the containers checked in one pass, nil to read
+//	 the container's own.
+func (p *Probe) checkProcAppPorts(c *procContainer, rateLimit bool, tbls socketTableCache) bool {
 	var addPort, notify bool
 	var socketTbl map[uint32]osutil.SocketInfo
 
@@ -300,7 +303,7 @@ func (p *Probe) checkProcAppPorts(c *procContainer, rateLimit bool) bool {
 	if c.checkRemovedPort > 4 { // every 10 = 5 x 2 seconds
 		c.checkRemovedPort = 0
 		//active socket table for a container: /proc/1/net/<tcp, tcp6, udp, udp6>
-		socketTbl = osutil.GetContainerSocketTable(c.rootPid)
+		socketTbl = tbls.get(c.rootPid)
 
 		// the obsoleted sockets and treat them as the closed ports
 		for pport, papp := range c.portsMap {
@@ -347,7 +350,7 @@ func (p *Probe) checkProcAppPorts(c *procContainer, rateLimit bool) bool {
 
 			// retrive while the probe is set
 			if socketTbl == nil {
-				socketTbl = osutil.GetContainerSocketTable(c.rootPid)
+				socketTbl = tbls.get(c.rootPid)
 				// no session: skip below all probes
 				if len(socketTbl) == 0 {
 					return notify
@@ -314,8 +314,48 @@ func (p *Probe) netlinkProcMonitor() {
 	}
 }
 
+const procEventSize = 4096
+
+// Above this queue depth only exec and uid change events are queued, they are the ones
+// evaluated against the process rules and checked for escalation. Forks and exits of
+// processes that are missed are recovered when the process tables are patched.
+const procEventHighWater = procEventSize * 3 / 4
+
+const procEventDropReportPeriod = time.Second * 10
+
+type procEventDrops struct {
+	fork, exec, exit, uid uint64
+	reportAt              time.Time
+}
+
+func isPriorityProcEvent(e *netlinkProcEvent) bool {
+	return e.Event == netlink.PROC_EVENT_EXEC || e.Event == netlink.PROC_EVENT_UID
+}
+
+func (d *procEventDrops) add(e *netlinkProcEvent) {
+	switch e.Event {
+	case netlink.PROC_EVENT_FORK:
+		d.fork++
+	case netlink.PROC_EVENT_EXEC:
+		d.exec++
+	case netlink.PROC_EVENT_EXIT:
+		d.exit++
+	case netlink.PROC_EVENT_UID:
+		d.uid++
+	}
+}
+
+// Returns true when drops are reported, at most once a period
+func (d *procEventDrops) report() bool {
+	if d.fork+d.exec+d.exit+d.uid == 0 || time.Since(d.reportAt) < procEventDropReportPeriod {
+		return false
+	}
+	log.WithFields(log.Fields{"fork": d.fork, "exec": d.exec, "exit": d.exit, "uid": d.uid}).Info("PROC: events dropped")
+	*d = procEventDrops{reportAt: time.Now()}
+	return true
+}
+
 func (p *Probe) netlinkProcWorker() {
-	const procEventSize = 4096
 	procEventQueue := make(chan *netlinkProcEvent, procEventSize) // increase to avoid underflow
 	go func() {
 		var ok bool
@@ -342,7 +382,7 @@ func (p *Probe) netlinkProcWorker() {
 	}()
 
 	lastReceiveTime := time.Now()
-	skipCnt := 0
+	var drops procEventDrops
 	for {
 		if !p.pidNetlink {
 			close(procEventQueue) // end channel at writer
@@ -378,18 +418,19 @@ func (p *Probe) netlinkProcWorker() {
 		}
 
 		for _, msg := range msgs {
-			if len(procEventQueue) == procEventSize {
-				skipCnt++
-				break
-			}
 			if event := p.parseNetLinkProcEvent(&msg); event != nil {
-				procEventQueue <- event
-				if skipCnt > 0 {
-					// log.WithFields(log.Fields{"skipCnt": skipCnt}).Debug("PROC:")
-					skipCnt = 0
+				// the only writer, the queue can't fill up in between
+				if n := len(procEventQueue); n >= procEventSize || (n >= procEventHighWater && !isPriorityProcEvent(event)) {
+					drops.add(event)
+					continue
 				}
+				procEventQueue <- event
 			}
 		}
+		if drops.report() {
+			// recover the missed processes
+			p.resetProcTbl = true
+		}
 	}
 	log.Info("PROC: exit")
 }
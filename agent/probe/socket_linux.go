@@ -2,11 +2,14 @@ package probe
 
 import (
 	"fmt"
+	"path/filepath"
+	"strconv"
 	"syscall"
 
 	log "github.com/sirupsen/logrus"
 
 	"github.com/neuvector/neuvector/agent/probe/netlink"
+	"github.com/neuvector/neuvector/share/osutil"
 	"github.com/neuvector/neuvector/share/utils"
 )
 
@@ -130,3 +133,20 @@ func (p *Probe) openSocketMonitor() (*netlink.NetlinkSocket, error) {
 		return ns, nil
 	}
 }
+
+// Socket tables read in one pass over the containers, by network namespace. The containers
+// of a pod share the namespace, its table is read once for all of them.
+type socketTableCache map[uint64]map[uint32]osutil.SocketInfo
+
+func (t socketTableCache) get(rootPid int) map[uint32]osutil.SocketInfo {
+	var st syscall.Stat_t
+	if t == nil || syscall.Stat(filepath.Join("/proc", strconv.Itoa(rootPid), "ns/net"), &st) != nil {
+		return osutil.GetContainerSocketTable(rootPid)
+	}
+	if tbl, ok := t[st.Ino]; ok {
+		return tbl
+	}
+	tbl := osutil.GetContainerSocketTable(rootPid)
+	t[st.Ino] = tbl
+	return tbl
+}
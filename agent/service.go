@@ -50,6 +50,7 @@ type sessionListParam struct {
 	list   []*share.CLUSSession
 	state  paginationState
 	stream share.EnforcerService_GetSessionListServer
+	cursor uint64 // to ask dp for the next sessions with, 0 at the end
 }
 
 type meterListParam struct {
@@ -63,6 +64,10 @@ type datapathCountParam struct {
 	count *share.CLUSDatapathCounter
 }
 
+type policyHitsParam struct {
+	hits dp.DPPolicyHits
+}
+
 type RPCService struct {
 }
 
@@ -217,12 +222,23 @@ func (rs *RPCService) cbSessionList(buf []byte, param interface{}) bool {
 
 	log.WithFields(log.Fields{"kind": hdr.Kind, "len": hdr.Length, "more": hdr.More}).Debug("")
 
+	offset := int(unsafe.Sizeof(*hdr))
+	cursorOffset := offset + int(unsafe.Sizeof(C.DPMsgSessionHdr{}))
+	if hdr.More == 0 && len(buf) == cursorOffset+int(unsafe.Sizeof(C.DPMsgSessionCursor{})) {
+		var sc C.DPMsgSessionCursor
+		r := bytes.NewReader(buf[cursorOffset:])
+		if dbgError := binary.Read(r, binary.BigEndian, &sc); dbgError != nil {
+			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+		}
+		pm.cursor = uint64(sc.Cursor)
+		return true
+	}
+
 	if pm.state == pageAbove {
 		return hdr.More == 0
 	}
 
 	// Check session header
-	offset := int(unsafe.Sizeof(*hdr))
 	sessHdr := rs.parseSessionListHeader(buf[offset:])
 	if sessHdr == nil {
 		return true
@@ -232,11 +248,16 @@ func (rs *RPCService) cbSessionList(buf []byte, param interface{}) bool {
 
 	offset += int(unsafe.Sizeof(*sessHdr))
 	r := bytes.NewReader(buf[offset:])
+	native := uint16(sessHdr.Flags)&C.DP_MSG_FLAG_NATIVE != 0
+	sessLen := int(unsafe.Sizeof(C.DPMsgSession{}))
 
 	// Going through session list
 	var sess C.DPMsgSession
 	for i := 0; i < sessions; i++ {
-		if dbgError := binary.Read(r, binary.BigEndian, &sess); dbgError != nil {
+		if native {
+			// Host order, the entry is read in place
+			sess = *(*C.DPMsgSession)(unsafe.Pointer(&buf[offset+i*sessLen]))
+		} else if dbgError := binary.Read(r, binary.BigEndian, &sess); dbgError != nil {
 			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 		}
 		var workload string
@@ -267,6 +288,26 @@ func (rs *RPCService) cbSessionList(buf []byte, param interface{}) bool {
 	return hdr.More == 0
 }
 
+// The MAC of the workload if it has only one, "" otherwise
+func workloadSessionMAC(workload string) string {
+	if workload == "" {
+		return ""
+	}
+
+	var found string
+	gInfoRLock()
+	defer gInfoRUnlock()
+	for mac, id := range gInfo.macContainerMap {
+		if id == workload {
+			if found != "" {
+				return ""
+			}
+			found = mac
+		}
+	}
+	return found
+}
+
 func (rs *RPCService) GetSessionList(f *share.CLUSFilter, stream share.EnforcerService_GetSessionListServer) error {
 	log.WithFields(log.Fields{"filter": f}).Debug("")
 
@@ -308,7 +349,16 @@ func (rs *RPCService) GetSessionList(f *share.CLUSFilter, stream share.EnforcerS
 		return nil
 	}
 
-	dp.DPCtrlListSession(rs.cbSessionList, &param)
+	// Ask dp for a chunk at a time, and filter by the workload there if it has one interface
+	chunk := dp.DPListSessionChunk{MAC: workloadSessionMAC(f.Workload)}
+	for {
+		param.cursor = 0
+		dp.DPCtrlListSessionChunk(&chunk, rs.cbSessionList, &param)
+		if param.cursor == 0 || param.state == pageAbove {
+			break
+		}
+		chunk.Cursor = param.cursor
+	}
 	rs.sendSessionList(&param)
 
 	return nil
@@ -509,6 +559,7 @@ func populateTrafficStats(data *share.CLUSStats, stats *C.DPMsgStats) {
 	data.Total.PacketOut = uint64(stats.PacketOut)
 	data.Total.ByteIn = uint64(stats.ByteIn)
 	data.Total.ByteOut = uint64(stats.ByteOut)
+	data.Total.DatapathCPUTime = uint64(stats.CPUTime)
 
 	data.Span1.SessionIn = uint32(stats.SessionIn1)
 	data.Span1.SessionOut = uint32(stats.SessionOut1)
@@ -785,6 +836,11 @@ func (rs *RPCService) cbAgentCounter(buf []byte, param interface{}) bool {
 		LimitPassConns:      uint64(count.LimitPassConns),
 		ParserSessions:      make([]uint64, C.DPI_PARSER_MAX),
 		ParserPackets:       make([]uint64, C.DPI_PARSER_MAX),
+		LatencySamples:      make([]uint64, C.DP_LAT_HISTS),
+		LatencyP50:          make([]uint64, C.DP_LAT_HISTS),
+		LatencyP99:          make([]uint64, C.DP_LAT_HISTS),
+		LatencyMax:          make([]uint64, C.DP_LAT_HISTS),
+		ParserCPUTime:       make([]uint64, C.DPI_PARSER_MAX),
 		PolicyType1Rules:    uint32(count.PolicyType1Rules),
 		PolicyType2Rules:    uint32(count.PolicyType2Rules),
 		PolicyDomains:       uint32(count.PolicyDomains),
@@ -798,6 +854,14 @@ func (rs *RPCService) cbAgentCounter(buf []byte, param interface{}) bool {
 	for i = 0; i < C.DPI_PARSER_MAX; i++ {
 		pm.count.ParserSessions[i] = uint64(count.ParserSessions[i])
 		pm.count.ParserPackets[i] = uint64(count.ParserPackets[i])
+		pm.count.ParserCPUTime[i] = uint64(count.ParserCPUTime[i])
+	}
+	// Pipeline stages, then parsers, see DP_LAT_*
+	for i = 0; i < C.DP_LAT_HISTS; i++ {
+		pm.count.LatencySamples[i] = uint64(count.LatencySamples[i])
+		pm.count.LatencyP50[i] = uint64(count.LatencyP50[i])
+		pm.count.LatencyP99[i] = uint64(count.LatencyP99[i])
+		pm.count.LatencyMax[i] = uint64(count.LatencyMax[i])
 	}
 
 	return true
@@ -811,6 +875,33 @@ func (rs *RPCService) GetDatapathCounter(ctx context.Context, v *share.RPCVoid)
 	return param.count, nil
 }
 
+func (rs *RPCService) cbPolicyHits(buf []byte, param interface{}) bool {
+	pm, _ := param.(*policyHitsParam)
+
+	if buf == nil {
+		log.Error("Empty buffer")
+		return true
+	}
+	return !dp.ParseDPPolicyHits(buf, &pm.hits)
+}
+
+func (rs *RPCService) GetPolicyRuleHits(ctx context.Context, req *share.CLUSPolicyRuleHitReq) (*share.CLUSPolicyRuleHitArray, error) {
+	log.WithFields(log.Fields{"reset": req.ResetHits}).Debug("")
+
+	var param policyHitsParam
+	dp.DPCtrlPolicyHits(req.ResetHits, rs.cbPolicyHits, &param)
+
+	resp := &share.CLUSPolicyRuleHitArray{
+		Hits:     make([]*share.CLUSPolicyRuleHit, len(param.hits.Hits)),
+		Since:    param.hits.Since,
+		Overflow: param.hits.Overflow,
+	}
+	for i, h := range param.hits.Hits {
+		resp.Hits[i] = &share.CLUSPolicyRuleHit{ID: h.ID, Hits: h.Hits, LastHitAt: h.LastHit}
+	}
+	return resp, nil
+}
+
 func (rs *RPCService) convertIPPolicy(pol *dp.DPWorkloadIPPolicy) *share.CLUSDerivedPolicyRuleArray {
 	rules := make([]*share.CLUSDerivedPolicyRule, len(pol.IPRules))
 	for i, r := range pol.IPRules {
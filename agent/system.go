@@ -132,7 +132,7 @@ func systemConfigXff(xffenabled bool) {
 	gInfo.xffEnabled = xffenabled
 	//set xff to dp
 	xff := gInfo.xffEnabled
-	dp.DPCtrlSetSysConf(&xff)
+	dp.DPCtrlSetSysConf(&xff, nil)
 }
 
 func systemConfigNetPolicy(disableNetPolicy bool) {
@@ -286,6 +286,115 @@ func getPolicyConfig(newRuleKey string, slots, ruleslen int) []share.CLUSGroupIP
 	return pols
 }
 
+// Node rules of the last version read completely, as received, to apply the next delta to
+var nodePolicyVer string
+var nodePolicyRaws []json.RawMessage
+
+func getPolicyConfigRaw(newRuleKey string, slots, ruleslen int) ([]json.RawMessage, bool) {
+	raws := make([]json.RawMessage, ruleslen)
+	complete := true
+	for i := 0; i < slots; i++ {
+		key := fmt.Sprintf("%s%v", newRuleKey, i)
+		value, _ := cluster.Get(key)
+		if value == nil {
+			complete = false
+			continue
+		}
+		uzb := utils.GunzipBytes(value)
+		if uzb == nil {
+			log.Error("Failed to unzip data")
+			complete = false
+			continue
+		}
+		pol := make([]json.RawMessage, 0)
+		if err := json.Unmarshal(uzb, &pol); err != nil {
+			log.WithFields(log.Fields{"error": err}).Error("Cannot decode policy")
+			complete = false
+			continue
+		}
+		//to keep the original rules order
+		for idx, raw := range pol {
+			if tidx := slots*idx + i; tidx < ruleslen {
+				raws[tidx] = raw
+			} else {
+				complete = false
+			}
+		}
+	}
+	return raws, complete
+}
+
+func applyPolicyDelta(newRuleKey string, ruleslen int) ([]json.RawMessage, bool) {
+	value, _ := cluster.Get(newRuleKey + share.PolicyIPRulesDeltaSlot)
+	if value == nil {
+		return nil, false
+	}
+	uzb := utils.GunzipBytes(value)
+	if uzb == nil {
+		return nil, false
+	}
+	var delta share.CLUSGroupIPPolicyDelta
+	if err := json.Unmarshal(uzb, &delta); err != nil || delta.Base != nodePolicyVer {
+		return nil, false
+	}
+
+	raws := make([]json.RawMessage, 0, ruleslen)
+	adds := delta.Adds
+	for _, seg := range delta.Segs {
+		if seg.Len < 0 {
+			return nil, false
+		} else if seg.Old < 0 {
+			if seg.Len > len(adds) {
+				return nil, false
+			}
+			raws = append(raws, adds[:seg.Len]...)
+			adds = adds[seg.Len:]
+		} else {
+			if seg.Old+seg.Len > len(nodePolicyRaws) {
+				return nil, false
+			}
+			raws = append(raws, nodePolicyRaws[seg.Old:seg.Old+seg.Len]...)
+		}
+	}
+	if len(raws) != ruleslen {
+		return nil, false
+	}
+	return raws, true
+}
+
+// The node rules are read from the delta when it is based on the last version read, from
+// the full slots otherwise
+func getNodePolicyConfig(newRuleKey string, s share.CLUSGroupIPPolicyVer) []share.CLUSGroupIPPolicy {
+	var raws []json.RawMessage
+	var complete bool
+	if s.DeltaFrom != "" && s.DeltaFrom == nodePolicyVer {
+		if raws, complete = applyPolicyDelta(newRuleKey, s.RulesLen); !complete {
+			log.WithFields(log.Fields{"base": s.DeltaFrom}).Debug("Fail to apply policy delta")
+		}
+	}
+	if !complete {
+		raws, complete = getPolicyConfigRaw(newRuleKey, s.SlotNo, s.RulesLen)
+	}
+
+	pols := make([]share.CLUSGroupIPPolicy, len(raws))
+	for i, raw := range raws {
+		if raw == nil {
+			continue
+		}
+		if err := json.Unmarshal(raw, &pols[i]); err != nil {
+			log.WithFields(log.Fields{"error": err}).Error("Cannot decode policy")
+			complete = false
+		}
+	}
+
+	if complete {
+		nodePolicyVer, nodePolicyRaws = s.PolicyIPRulesVersion, raws
+	} else {
+		nodePolicyVer, nodePolicyRaws = "", nil
+	}
+	return pols
+}
+
 func mergeWlPolicyConfig(rules []share.CLUSGroupIPPolicy, ruleslen, wlslots, wlens int) []share.CLUSGroupIPPolicy {
 	newGroupIPPolicy := make([]share.CLUSGroupIPPolicy, 0)
 	pol := share.CLUSGroupIPPolicy{
@@ -321,7 +430,7 @@ func systemConfigPolicyVersionNode(s share.CLUSGroupIPPolicyVer) []share.CLUSGro
 
 	//combine group ip rules from separate slots
 	groupIPPolicy = getPolicyConfig(newCommonRuleKey, s.CommonSlotNo, s.CommonRulesLen)
-	groupNodeIPPolicy := getPolicyConfig(newNodeRuleKey, s.SlotNo, s.RulesLen)
+	groupNodeIPPolicy := getNodePolicyConfig(newNodeRuleKey, s)
 	if groupIPPolicy != nil && groupNodeIPPolicy != nil {
 		groupIPPolicy = append(groupIPPolicy, groupNodeIPPolicy...)
 	}
@@ -41,7 +41,7 @@ var connsCache []*dp.ConnectionData
 var connsCacheMutex sync.Mutex
 var auditLogCache []*share.CLUSAuditLog
 var auditMutex sync.Mutex
-var fqdnIpCache []*share.CLUSFqdnIp
+var fqdnIpCache = make(map[string]*share.CLUSFqdnIp) // latest ips by name
 var fqdnIpMutex sync.Mutex
 var ipFqdnStorageCache map[string]string = make(map[string]string)
 var ipFqdnStorageMutex sync.Mutex
@@ -196,7 +196,7 @@ func dpTaskCallback(task *dp.DPTask) {
 		threatMutex.Unlock()
 	case dp.DP_TASK_FQDN_IP:
 		fqdnIpMutex.Lock()
-		fqdnIpCache = append(fqdnIpCache, task.Fqdns)
+		fqdnIpCache[task.Fqdns.FqdnName] = task.Fqdns
 		fqdnIpMutex.Unlock()
 	case dp.DP_TASK_IP_FQDN_STORAGE_UPDATE:
 		ipFqdnStorageMutex.Lock()
@@ -209,6 +209,8 @@ func dpTaskCallback(task *dp.DPTask) {
 		ip := task.FqdnStorageRelease.String()
 		delete(ipFqdnStorageCache, ip)
 		ipFqdnStorageMutex.Unlock()
+	case dp.DP_TASK_OVERLOAD:
+		putDPOverloadEvent(task.Overload)
 	case dp.DP_TASK_CONNECTION:
 		connsCacheMutex.Lock()
 		connsCache = append(connsCache, task.Connects...)
@@ -253,8 +255,8 @@ func updateContainerStats(cpuSystem uint64) {
 
 func putFqdnIps() {
 	fqdnIpMutex.Lock()
-	fqdnips := slices.Clone(fqdnIpCache)
-	fqdnIpCache = fqdnIpCache[:0]
+	fqdnips := fqdnIpCache
+	fqdnIpCache = make(map[string]*share.CLUSFqdnIp)
 	fqdnIpMutex.Unlock()
 
 	for _, fqdnip := range fqdnips {
@@ -565,15 +567,14 @@ func updateHostConnection(conns []*dp.ConnectionData) {
 // Max number of entries to transmit at one time.
 const connectionListMax int = 2048 * 4
 
+// With ipFqdnStorageMutex hold
 func conn2CLUS(c *dp.Connection) *share.CLUSConnection {
 	fqdn := ""
-	ipFqdnStorageMutex.Lock()
 	if c.ExternalPeer && len(ipFqdnStorageCache) > 0 {
 		if name, ok := ipFqdnStorageCache[net.IP(c.ServerIP).String()]; ok {
 			fqdn = name
 		}
 	}
-	ipFqdnStorageMutex.Unlock()
 
 	return &share.CLUSConnection{
 		AgentID:      c.AgentID,
@@ -639,9 +640,11 @@ func putConnections() {
 
 	if len(list) > 0 {
 		conns := make([]*share.CLUSConnection, len(list))
+		ipFqdnStorageMutex.Lock()
 		for i, c := range list {
 			conns[i] = conn2CLUS(c)
 		}
+		ipFqdnStorageMutex.Unlock()
 
 		resp, err := sendConnections(conns)
 		if err != nil {
@@ -23,6 +23,10 @@ type AgentEnvInfo struct {
 	fileProfile          bool
 	customBenchmark      bool
 	netPolicyPuller      int
+	connReportWindow     uint32
+	latencySample        uint32
+	latencyTrace         bool
+	dlpScanBudget        uint32
 	autoProfieCapture    uint64
 	memoryLimit          uint64
 	peakMemoryUsage      uint64
@@ -0,0 +1,392 @@
+package main
+
+import (
+	"bufio"
+	"crypto/sha256"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"os"
+	"path/filepath"
+	"runtime"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"time"
+
+	log "github.com/sirupsen/logrus"
+
+	"github.com/neuvector/neuvector/agent/workerlet"
+	"github.com/neuvector/neuvector/share/utils"
+)
+
+// The directories of a path walk are read by a bounded pool of workers. A worker reads a
+// directory, adds its entries to the result and queues its sub-directories for the pool.
+//
+// The exec check and the hash of a file read its content, they are kept in a cache file by
+// the walked path, which names the layer by its id in the storage drivers. The next walk of
+// the layer takes them over for the files whose inode, size, mtime and ctime are unchanged.
+// A cache file holds the files of the last walk only; the ones of layers not walked for a
+// day are removed.
+
+const walkMaxWorkers = 8
+const walkMaxErrors = 100
+const walkCacheDir = "cache"
+const walkCacheAge = time.Hour * 24
+const walkCacheMaxFiles = 256 * 1024
+
+type walkCacheEntry struct {
+	Ino    uint64 `json:"i"`
+	Size   int64  `json:"s"`
+	Mtime  int64  `json:"m"`
+	Ctime  int64  `json:"c"`
+	IsExec bool   `json:"x"`
+	Hashed bool   `json:"hd,omitempty"`
+	Hash   uint32 `json:"h,omitempty"`
+}
+
+type dirQueue struct {
+	mutex  sync.Mutex
+	cond   *sync.Cond
+	dirs   []string
+	busy   int // workers reading a directory
+	closed bool
+}
+
+type pathWalker struct {
+	req      workerlet.WalkPathRequest
+	rootPath string // with the trailing "/"
+	rootLen  int
+	deadline time.Time
+	queue    dirQueue
+	errorCnt int32
+	aborted  int32
+
+	cacheFile string
+	cache     map[string]*walkCacheEntry // of the last walk, read only
+	cacheHits uint64
+
+	mutex sync.Mutex
+	res   *workerlet.WalkPathResult
+	next  map[string]*walkCacheEntry
+	err   error
+}
+
+func (q *dirQueue) push(dirs []string) {
+	if len(dirs) == 0 {
+		return
+	}
+	q.mutex.Lock()
+	q.dirs = append(q.dirs, dirs...)
+	q.mutex.Unlock()
+	q.cond.Broadcast()
+}
+
+// Blocks until a directory is queued, false when the walk is done
+func (q *dirQueue) pop() (string, bool) {
+	q.mutex.Lock()
+	defer q.mutex.Unlock()
+	for len(q.dirs) == 0 && !q.closed {
+		q.cond.Wait()
+	}
+	if q.closed {
+		return "", false
+	}
+	dir := q.dirs[len(q.dirs)-1]
+	q.dirs = q.dirs[:len(q.dirs)-1]
+	q.busy++
+	return dir, true
+}
+
+// A directory was read, the walk is done when none is being read or queued
+func (q *dirQueue) done() {
+	q.mutex.Lock()
+	q.busy--
+	if q.busy == 0 && len(q.dirs) == 0 {
+		q.closed = true
+		q.cond.Broadcast()
+	}
+	q.mutex.Unlock()
+}
+
+func (q *dirQueue) close() {
+	q.mutex.Lock()
+	q.closed = true
+	q.mutex.Unlock()
+	q.cond.Broadcast()
+}
+
+func newPathWalker(req workerlet.WalkPathRequest, rootPath string) *pathWalker {
+	w := &pathWalker{
+		req:      req,
+		rootPath: rootPath + "/",
+		rootLen:  len(rootPath),
+		res: &workerlet.WalkPathResult{
+			Dirs:  make([]*workerlet.DirData, 0),
+			Files: make([]*workerlet.FileData, 0),
+		},
+		next: make(map[string]*walkCacheEntry),
+	}
+	w.queue.cond = sync.NewCond(&w.queue.mutex)
+	if req.Timeout > 0 {
+		w.deadline = time.Now().Add(req.Timeout)
+	}
+	w.loadCache()
+	return w
+}
+
+func (w *pathWalker) fail(err error) {
+	w.mutex.Lock()
+	if w.err == nil {
+		w.err = err
+	}
+	w.mutex.Unlock()
+	atomic.StoreInt32(&w.aborted, 1)
+	w.queue.close()
+}
+
+func (w *pathWalker) failed() bool {
+	return atomic.LoadInt32(&w.aborted) != 0
+}
+
+// Same as the walk function of filepath.Walk() on an error, false to abort the walk
+func (w *pathWalker) onError(err error) bool {
+	if isPidValid(w.req.Pid) {
+		return true
+	}
+
+	if strings.Contains(err.Error(), "no such file") {
+		if atomic.AddInt32(&w.errorCnt, 1) < walkMaxErrors {
+			return true
+		}
+	}
+	log.WithFields(log.Fields{"path": w.rootPath, "error": err}).Error("prevent panic")
+	w.fail(err)
+	return false
+}
+
+func (w *pathWalker) timedOut() bool {
+	if !w.deadline.IsZero() && time.Now().After(w.deadline) {
+		w.fail(errors.New("Timeout"))
+		return true
+	}
+	return false
+}
+
+func fInfo(info os.FileInfo) workerlet.FInfo {
+	return workerlet.FInfo{
+		Name:    info.Name(),
+		Size:    info.Size(),
+		Mode:    info.Mode(),
+		ModTime: info.ModTime(),
+		IsDir:   info.IsDir(),
+	}
+}
+
+// Directories below the root are walked if they are not mount points and in the requested dirs
+func (w *pathWalker) skipDir(path string) bool {
+	// avoid the huge file systems on the hosts: /dev, /sys and /proc
+	if utils.IsMountPoint(path) {
+		log.WithFields(log.Fields{"path": path}).Debug("skip dir")
+		return true
+	}
+
+	ldir := path[w.rootLen:]
+	for _, rdir := range w.req.Dirs {
+		if strings.HasPrefix(ldir, rdir) {
+			return false
+		}
+	}
+	return true
+}
+
+func (w *pathWalker) fileData(path string, info os.FileInfo, next map[string]*walkCacheEntry) *workerlet.FileData {
+	fdata := &workerlet.FileData{
+		File: path[w.rootLen:],
+		Info: fInfo(info),
+	}
+	if !info.Mode().IsRegular() {
+		return fdata
+	}
+
+	st, _ := info.Sys().(*syscall.Stat_t)
+	if st != nil {
+		if c, ok := w.cache[fdata.File]; ok && c.Ino == st.Ino && c.Size == st.Size &&
+			c.Mtime == st.Mtim.Nano() && c.Ctime == st.Ctim.Nano() && (c.Hashed || w.req.ExecOnly) {
+			atomic.AddUint64(&w.cacheHits, 1)
+			fdata.IsExec = c.IsExec
+			if !w.req.ExecOnly {
+				fdata.Hash = c.Hash
+			}
+			next[fdata.File] = c
+			return fdata
+		}
+	}
+
+	fdata.IsExec = utils.IsExecutable(info, path)
+	if !w.req.ExecOnly {
+		// add hash data
+		fdata.Hash = utils.FileHashCrc32(path, info.Size())
+	}
+	if st != nil {
+		next[fdata.File] = &walkCacheEntry{
+			Ino: st.Ino, Size: st.Size, Mtime: st.Mtim.Nano(), Ctime: st.Ctim.Nano(),
+			IsExec: fdata.IsExec, Hashed: !w.req.ExecOnly, Hash: fdata.Hash,
+		}
+	}
+	return fdata
+}
+
+func (w *pathWalker) readDir(dir string) {
+	entries, err := os.ReadDir(dir)
+	if err != nil && !w.onError(err) {
+		return
+	}
+
+	var dirs []*workerlet.DirData
+	var files []*workerlet.FileData
+	var subdirs []string
+	next := make(map[string]*walkCacheEntry)
+
+	for _, e := range entries {
+		if w.timedOut() || w.failed() {
+			return
+		}
+
+		path := filepath.Join(dir, e.Name())
+		info, err := e.Info()
+		if err != nil {
+			if !w.onError(err) {
+				return
+			}
+			continue
+		}
+
+		if info.IsDir() {
+			if w.skipDir(path) {
+				continue
+			}
+			dirs = append(dirs, &workerlet.DirData{Dir: path[w.rootLen:], Info: fInfo(info)})
+			subdirs = append(subdirs, path)
+			continue
+		}
+
+		fdata := w.fileData(path, info, next)
+		if !w.req.ExecOnly || fdata.IsExec {
+			files = append(files, fdata)
+		}
+	}
+
+	w.mutex.Lock()
+	w.res.Dirs = append(w.res.Dirs, dirs...)
+	w.res.Files = append(w.res.Files, files...)
+	for file, c := range next {
+		w.next[file] = c
+	}
+	w.mutex.Unlock()
+
+	w.queue.push(subdirs)
+}
+
+func (w *pathWalker) walk() error {
+	info, err := os.Stat(w.rootPath)
+	if err != nil {
+		if w.onError(err) {
+			return nil
+		}
+		return w.err
+	}
+	w.res.Dirs = append(w.res.Dirs, &workerlet.DirData{Dir: w.rootPath[w.rootLen:], Info: fInfo(info)})
+	w.queue.push([]string{w.rootPath})
+
+	workers := runtime.NumCPU()
+	if workers > walkMaxWorkers {
+		workers = walkMaxWorkers
+	}
+
+	var wg sync.WaitGroup
+	for i := 0; i < workers; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for {
+				dir, ok := w.queue.pop()
+				if !ok {
+					return
+				}
+				if !w.timedOut() && !w.failed() {
+					w.readDir(dir)
+				}
+				w.queue.done()
+			}
+		}()
+	}
+	wg.Wait()
+
+	if w.err == nil {
+		w.saveCache()
+	}
+	log.WithFields(log.Fields{"path": w.rootPath, "dirs": len(w.res.Dirs), "files": len(w.res.Files), "cached": w.cacheHits}).Debug()
+	return w.err
+}
+
+func (w *pathWalker) loadCache() {
+	dir := filepath.Join(workerlet.WalkerBasePath, walkCacheDir)
+	if dbgError := os.MkdirAll(dir, os.ModePerm); dbgError != nil {
+		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+		return
+	}
+
+	if entries, err := os.ReadDir(dir); err == nil {
+		for _, e := range entries {
+			if info, err := e.Info(); err == nil && time.Since(info.ModTime()) > walkCacheAge {
+				if dbgError := os.Remove(filepath.Join(dir, e.Name())); dbgError != nil {
+					log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+				}
+			}
+		}
+	}
+
+	w.cacheFile = filepath.Join(dir, fmt.Sprintf("%x.json", sha256.Sum256([]byte(w.rootPath))))
+	if value, err := os.ReadFile(w.cacheFile); err == nil {
+		if err = json.Unmarshal(value, &w.cache); err != nil {
+			log.WithFields(log.Fields{"file": w.cacheFile, "error": err}).Debug("drop cache")
+			w.cache = nil
+		}
+	}
+}
+
+func (w *pathWalker) saveCache() {
+	if w.cacheFile == "" || len(w.next) == 0 || len(w.next) > walkCacheMaxFiles {
+		return
+	}
+
+	tmp := w.cacheFile + ".tmp"
+	if err := writeJsonFile(tmp, w.next); err != nil {
+		log.WithFields(log.Fields{"file": tmp, "error": err}).Debug()
+		if dbgError := os.Remove(tmp); dbgError != nil {
+			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+		}
+		return
+	}
+	if dbgError := os.Rename(tmp, w.cacheFile); dbgError != nil {
+		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
+	}
+}
+
+// The output is encoded into the file as it is written, it is not built in memory first
+func writeJsonFile(file string, v interface{}) error {
+	f, err := os.Create(file)
+	if err != nil {
+		return err
+	}
+	bw := bufio.NewWriterSize(f, 64*1024)
+	if err = json.NewEncoder(bw).Encode(v); err == nil {
+		err = bw.Flush()
+	}
+	if cerr := f.Close(); err == nil {
+		err = cerr
+	}
+	return err
+}
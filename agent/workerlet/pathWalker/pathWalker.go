@@ -173,125 +173,17 @@ func (tm *taskMain) ProcessRequest(walkType string) error {
 
 // ///////////////////////////////////////////////////////////////////////////////////////////////////
 func (tm *taskMain) WalkPathTask(req workerlet.WalkPathRequest) {
-	var errorCnt int
-	var res = &workerlet.WalkPathResult{
-		Dirs:  make([]*workerlet.DirData, 0),
-		Files: make([]*workerlet.FileData, 0),
-	}
-
 	//log.WithFields(log.Fields{"req": req}).Debug()
 	rootPath := filepath.Join(fmt.Sprintf(procRootMountPoint, req.Pid), req.Path)
-	rootPathLen := len(rootPath)
-	rootPath += "/"
-
-	bTimeoutFlag := false
-	if req.Timeout > 0 {
-		go func() {
-			time.Sleep(req.Timeout)
-			bTimeoutFlag = true
-		}()
-	}
 
 	log.WithFields(log.Fields{"path": rootPath}).Debug("start")
-	err := filepath.Walk(rootPath, func(path string, info os.FileInfo, err error) error {
-		if bTimeoutFlag {
-			return errors.New("Timeout")
-		}
-
-		if err != nil {
-			if isPidValid(req.Pid) { // abort
-				// fmt.Errorf("Invalid pid: %d", req.Pid)
-				return nil
-			}
-
-			// log.WithFields(log.Fields{"path": rootPath, "error": err.Error()}).Error()
-			if strings.Contains(err.Error(), "no such file") {
-				errorCnt++
-				if errorCnt < 100 {
-					return nil
-				}
-			}
-			log.WithFields(log.Fields{"path": rootPath, "error": err}).Error("prevent panic")
-			return err
-		}
-
-		if info.IsDir() {
-			// avoid the huge file systems on the hosts: /dev, /sys and /proc
-			if path != rootPath {
-				if utils.IsMountPoint(path) {
-					log.WithFields(log.Fields{"path": path}).Debug("skip dir")
-					return filepath.SkipDir
-				}
-
-				bSkip := true
-				ldir := path[rootPathLen:]
-				for _, rdir := range req.Dirs {
-					if strings.HasPrefix(ldir, rdir) {
-						bSkip = false
-						break
-					}
-				}
-				if bSkip {
-					return filepath.SkipDir
-				}
-			}
-
-			ddata := &workerlet.DirData{
-				Dir: path[rootPathLen:],
-				Info: workerlet.FInfo{
-					Name:    info.Name(),
-					Size:    info.Size(),
-					Mode:    info.Mode(),
-					ModTime: info.ModTime(),
-					IsDir:   info.IsDir(),
-				},
-			}
-			res.Dirs = append(res.Dirs, ddata)
-			// log.WithFields(log.Fields{"dir": ddata.Dir}).Debug()
-		} else {
-			bExec := false
-			if info.Mode().IsRegular() {
-				bExec = utils.IsExecutable(info, path)
-			}
-
-			fdata := &workerlet.FileData{
-				File:   path[rootPathLen:],
-				IsExec: bExec,
-				Info: workerlet.FInfo{
-					Name:    info.Name(),
-					Size:    info.Size(),
-					Mode:    info.Mode(),
-					ModTime: info.ModTime(),
-					IsDir:   info.IsDir(),
-				},
-			}
-
-			if req.ExecOnly {
-				if fdata.IsExec {
-					res.Files = append(res.Files, fdata)
-					//log.WithFields(log.Fields{"file": fdata.File}).Debug()
-				}
-			} else {
-				if info.Mode().IsRegular() {
-					// add hash data
-					fdata.Hash = utils.FileHashCrc32(path, info.Size())
-				}
-				res.Files = append(res.Files, fdata)
-				// log.WithFields(log.Fields{"file": fdata.File}).Debug()
-			}
-		}
-		return nil
-	})
-
+	w := newPathWalker(req, rootPath)
+	err := w.walk()
 	log.WithFields(log.Fields{"path": rootPath}).Debug("done")
 
 	// outputs
-	if data, err := json.Marshal(res); err == nil {
-		if dbgError := os.WriteFile(filepath.Join(tm.workPath, workerlet.ResultJson), data, 0644); dbgError != nil {
-			log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
-		}
-	} else {
-		log.WithFields(log.Fields{"error": err}).Error()
+	if dbgError := writeJsonFile(filepath.Join(tm.workPath, workerlet.ResultJson), w.res); dbgError != nil {
+		log.WithFields(log.Fields{"dbgError": dbgError}).Debug()
 	}
 
 	tm.done <- err
@@ -22,11 +22,49 @@ typedef unsigned char bool;
 
 #define DP_MNT_SHM_NAME "/dp_mnt.shm"
 
+// The monitor can run one dp per numa node. With more than one, dp instance n appends ".n"
+// to DP_MNT_SHM_NAME and to the names of its ctrl socket, shared memories and snapshot.
+#define DP_NUMA_MAX 4
+
 #define MAX_DP_THREADS 4
 
+#define DP_SCHED_MODE_INTR 0
+#define DP_SCHED_MODE_POLL 1
+
+// What a dp thread is on, for the monitor to tell where a thread that misses its
+// heartbeat is stuck
+#define DP_STAGE_IDLE    0
+#define DP_STAGE_PACKET  1      // a received packet
+#define DP_STAGE_PARSER  2      // a protocol parser of the packet, see parser
+#define DP_STAGE_DETECT  3      // dlp and waf pattern match of the packet
+#define DP_STAGE_TIMER   4      // timers and once a second housekeeping
+#define DP_STAGE_CTRL    5      // requests of the ctrl thread
+
+// Sent by the monitor to a stuck thread, which writes its backtrace to DP_STALL_FILE
+#define DP_SIG_STALL_DUMP 42
+#define DP_STALL_FILE "/var/log/dp.stall.txt"
+
+// Written by its dp thread as it goes, read by the monitor while the thread is stuck
+typedef struct dp_mnt_stage_ {
+    uint32_t stage;         // DP_STAGE_*
+    uint32_t parser;        // parser type in DP_STAGE_PARSER
+    uint32_t sess_id;       // session of the packet once it is looked up, 0 otherwise
+    int32_t tid;
+    uint64_t since;         // tsc when the thread took up the packet or the timers
+    uint8_t ep_mac[6];
+    uint8_t pad[2];
+    // Soft watchdog: the monitor asks the thread to stop inspecting the session it is
+    // stuck on, the thread clears the request once the packet is done.
+    uint32_t quarantine;
+    uint32_t quarantined;   // sessions quarantined so far
+} __attribute__((aligned(64))) dp_mnt_stage_t;
+
 typedef struct dp_mnt_shm_ {
     uint32_t dp_hb[MAX_DP_THREADS];
 	bool dp_active[MAX_DP_THREADS];
+    uint8_t dp_sched_mode[MAX_DP_THREADS];
+    uint64_t tsc_hz;
+    dp_mnt_stage_t dp_stage[MAX_DP_THREADS];
 } dp_mnt_shm_t;
 
 #endif
@@ -89,6 +89,8 @@ const QueryKeySection string = "section"
 const QueryKeyView string = "view"
 const QueryValueViewPod string = "pod"
 const QueryValueViewPodOnly string = "pod_only"
+const QueryValueViewGroup string = "group"
+const QueryValueViewDomain string = "domain"
 const QueryKeyShow string = "show"
 const QueryValueShowAccepted string = "accepted"
 const QueryScope string = "scope"
@@ -181,6 +181,19 @@ type RESTFedRulesSettings struct {
 	WafGroupSensorData  *share.CLUSFedWafGroupSensorData `json:"waf_group_sensor_data,omitempty"`
 }
 
+// Changes of the fed network rules or groups since the revision the managed cluster has. Rule
+// heads are always sent in full. Checksum is hex(sha256) of the whole content at the new
+// revision, for the managed cluster to verify the content it builds from the changes.
+type RESTFedRulesDelta struct {
+	BaseRevision   uint64                  `json:"base_revision"`
+	Checksum       string                  `json:"checksum"`
+	Rules          []*share.CLUSPolicyRule `json:"rules,omitempty"`
+	DeletedRuleIDs []uint32                `json:"deleted_rule_ids,omitempty"`
+	RuleHeads      []*share.CLUSRuleHead   `json:"rule_heads,omitempty"`
+	Groups         []*share.CLUSGroup      `json:"groups,omitempty"`
+	DeletedGroups  []string                `json:"deleted_groups,omitempty"`
+}
+
 type RESTFedImageScanResult struct {
 	Hash    string                          `json:"hash"` // it's hex(sha256) of json.marshal(gob(regImageSummaryReport))
 	Summary *share.CLUSRegistryImageSummary `json:"summary,omitempty"`
@@ -223,6 +236,7 @@ type RESTPollFedRulesReq struct {
 	Revisions    map[string]uint64 `json:"revisions"`              // key is fed rules type, value is the revision
 	CspType      string            `json:"csp_type"`               // joint cluster's billing csp type
 	Nodes        int               `json:"nodes"`
+	DeltaTypes   []string          `json:"delta_types,omitempty"` // fed rules types the joint cluster can take as RESTFedRulesDelta
 }
 
 type RESTFedScanDataRevs struct {
@@ -232,13 +246,14 @@ type RESTFedScanDataRevs struct {
 }
 
 type RESTPollFedRulesResp struct {
-	Result             int                 `json:"result"`                // value: _fedSuccess/....
-	PollInterval       uint32              `json:"poll_interval"`         // in minute
-	Settings           []byte              `json:"settings,omitempty"`    // marshall of RESTFedRulesSettings, which contains only modified settings (for ~5.0.x)
-	Revisions          map[string]uint64   `json:"revisions"`             // key is fed rules type, value is the revision. It contains only revisions of modified settings
-	ScanDataRevs       RESTFedScanDataRevs `json:"scan_data_revs"`        // the latest revisions of all the fed registry/repo scan data on master cluster
-	DeployRepoScanData bool                `json:"deploy_repo_scan_data"` // for informing whether master cluster deploys repo scan data to managed clusters
-	CspType            string              `json:"csp_type"`              // master's billing csp type
+	Result             int                           `json:"result"`                // value: _fedSuccess/....
+	PollInterval       uint32                        `json:"poll_interval"`         // in minute
+	Settings           []byte                        `json:"settings,omitempty"`    // marshall of RESTFedRulesSettings, which contains only modified settings (for ~5.0.x)
+	Revisions          map[string]uint64             `json:"revisions"`             // key is fed rules type, value is the revision. It contains only revisions of modified settings
+	ScanDataRevs       RESTFedScanDataRevs           `json:"scan_data_revs"`        // the latest revisions of all the fed registry/repo scan data on master cluster
+	DeployRepoScanData bool                          `json:"deploy_repo_scan_data"` // for informing whether master cluster deploys repo scan data to managed clusters
+	CspType            string                        `json:"csp_type"`              // master's billing csp type
+	Deltas             map[string]*RESTFedRulesDelta `json:"deltas,omitempty"`      // fed rules types sent as changes, they are not in Settings
 }
 
 type RESTPollFedScanDataReq struct {
@@ -165,6 +165,7 @@ const (
 	EventNameDEKSeedUnavailable          = "Security.DEK.Seed.Unavailable"
 	EventNameReEncryptWithDEK            = "Security.DEK.Encrypt"
 	EventNameEncryptionSecretSet         = "Security.Encryption.Secret.Set"
+	EventNameAgentDPOverload             = "Agent.DP.Overload"
 )
 
 // TODO: these are not events but incidents
@@ -150,8 +150,7 @@ func TestAccessPolicy(t *testing.T) {
 	policyCache.ruleMap[r1.ID] = &r1
 	policyCache.ruleMap[r2.ID] = &r2
 	policyCache.ruleMap[r3.ID] = &r3
-	policyCache.ruleHeads = rhs
-	policyCache.ruleOrderMap = ruleHeads2OrderMap(rhs)
+	policyCache.setRuleHeads(rhs)
 
 	r, _ := http.NewRequest(http.MethodGet, "https://10.1.1.1/v1/policy/rule", nil)
 	// test
@@ -179,6 +178,22 @@ func TestAccessPolicy(t *testing.T) {
 		t.Errorf("Expected group count 0, but got %d\n", n)
 	}
 
+	// Pages of the readable rules
+	acc = access.NewAccessControl(r, access.AccessOPRead, map[string]string{"d1": api.UserRoleAdmin}, nil)
+	rules := cacher.GetPolicyRulesPage(share.ScopeLocal, acc, 1, 1)
+	if len(rules) != 1 || rules[0].ID != r2.ID {
+		t.Errorf("Expected rule %d on the page, but got %+v\n", r2.ID, rules)
+	}
+	if rules = cacher.GetPolicyRulesPage(share.ScopeFed, acc, 0, 0); len(rules) != 0 {
+		t.Errorf("Expected no federal rule, but got %+v\n", rules)
+	}
+
+	acc = access.NewAccessControl(r, access.AccessOPRead, map[string]string{"d2": api.UserRoleAdmin}, nil)
+	rules = cacher.GetPolicyRulesPage(share.ScopeAll, acc, 1, 0)
+	if len(rules) != 1 || rules[0].ID != r3.ID {
+		t.Errorf("Expected rule %d on the page, but got %+v\n", r3.ID, rules)
+	}
+
 	// cleanup
 	groupCacheMap = make(map[string]*groupCache, 0)
 	policyCache = policyCacheType{
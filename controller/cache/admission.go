@@ -6,7 +6,6 @@ import (
 	"fmt"
 	"os"
 	"os/signal"
-	"regexp"
 	"strconv"
 	"strings"
 	"sync"
@@ -200,6 +199,7 @@ func initCache() {
 						}
 					}
 				}
+				compileAdmissionRule(r)
 				ruleCaches[idx].RuleMap[arh.ID] = r
 				ruleCaches[idx].RuleHeads = append(ruleCaches[idx].RuleHeads, rh)
 
@@ -559,6 +559,8 @@ func admissionConfigUpdate(nType cluster.ClusterNotifyType, key string, value []
 			if rule.RuleType == "" {
 				rule.RuleType = ruleType
 			}
+			compileAdmissionRule(&rule)
+			forgetAdmissionRule(admPolicyCache.RuleMap[rule.ID])
 			admPolicyCache.RuleMap[rule.ID] = &rule
 			if rule.RuleType == api.ValidatingExceptRuleType || rule.RuleType == share.FedAdmCtrlExceptRulesType {
 				evalAdmCtrlRulesForAllowedNS(admStateCache.Enable)
@@ -577,6 +579,7 @@ func admissionConfigUpdate(nType cluster.ClusterNotifyType, key string, value []
 			evalAllowedNS := false
 			for id, r := range admPolicyCache.RuleMap {
 				if !ids.Contains(id) {
+					forgetAdmissionRule(r)
 					delete(admPolicyCache.RuleMap, id)
 					opa.DeletePolicy(id)
 					log.WithFields(log.Fields{"nType": nType, "cfgType": cfgType, "id": id}).Debug("admissionConfigUpdate, delete OPA")
@@ -601,13 +604,17 @@ func admissionConfigUpdate(nType cluster.ClusterNotifyType, key string, value []
 		switch cfgType {
 		case share.CLUSAdmissionCfgRule:
 			id := share.CLUSPolicyRuleKey2ID(key)
-			if _, ok := admPolicyCache.RuleMap[id]; ok {
+			if r, ok := admPolicyCache.RuleMap[id]; ok {
+				forgetAdmissionRule(r)
 				delete(admPolicyCache.RuleMap, id)
 				opa.DeletePolicy(id)
 			}
 		case share.CLUSAdmissionCfgRuleList:
 			heads := make([]*share.CLUSRuleHead, 0)
 			admPolicyCache.RuleHeads = heads
+			for _, r := range admPolicyCache.RuleMap {
+				forgetAdmissionRule(r)
+			}
 			admPolicyCache.RuleMap = make(map[uint32]*share.CLUSAdmissionRule, 0)
 		}
 	}
@@ -627,19 +634,17 @@ func admissionRuleInit() {
 func isStringCriterionMet(crt *share.CLUSAdmRuleCriterion, value string) (bool, bool) {
 	switch crt.Op {
 	case share.CriteriaOpEqual:
-		return share.EqualMatch(crt.Value, value), true
+		return admEqualMatch(crt.Value, value), true
 	case share.CriteriaOpNotEqual:
-		return !share.EqualMatch(crt.Value, value), false
+		return !admEqualMatch(crt.Value, value), false
 	case share.CriteriaOpContains:
 		return strings.Contains(value, crt.Value), true
 	case share.CriteriaOpPrefix:
 		return strings.HasPrefix(value, crt.Value), true
 	case share.CriteriaOpRegex, share.CriteriaOpRegex_Deprecated:
-		matched, _ := regexp.MatchString(crt.Value, value)
-		return matched, true
+		return admRegexMatch(crt.Value, value), true
 	case share.CriteriaOpNotRegex, share.CriteriaOpNotRegex_Deprecated:
-		matched, _ := regexp.MatchString(crt.Value, value)
-		return !matched, false
+		return !admRegexMatch(crt.Value, value), false
 	case share.CriteriaOpContainsAll, share.CriteriaOpContainsAny, share.CriteriaOpNotContainsAny, share.CriteriaOpContainsOtherThan,
 		share.CriteriaOpRegexContainsAny, share.CriteriaOpRegexNotContainsAny:
 		valueSet := utils.NewSet(value)
@@ -775,7 +780,7 @@ func isSetCriterionMet(crt *share.CLUSAdmRuleCriterion, valueSet utils.Set) (boo
 	if valueSet.Cardinality() > 0 {
 		switch crt.Op {
 		case share.CriteriaOpRegex, share.CriteriaOpNotRegex:
-			if regex, err := regexp.Compile(crt.Value); err == nil {
+			if regex := admRegexp(crt.Value); regex != nil {
 				for value := range valueSet.Iter() {
 					if regex.MatchString(value.(string)) {
 						if crt.Op == share.CriteriaOpRegex {
@@ -788,12 +793,29 @@ func isSetCriterionMet(crt *share.CLUSAdmRuleCriterion, valueSet utils.Set) (boo
 			}
 		case share.CriteriaOpContainsAll, share.CriteriaOpContainsAny, share.CriteriaOpNotContainsAny,
 			share.CriteriaOpRegexContainsAny, share.CriteriaOpRegexNotContainsAny:
+			if vs := getAdmValueSet(crt); vs != nil {
+				switch crt.Op {
+				case share.CriteriaOpContainsAll:
+					if !vs.containsAll(valueSet) {
+						return false, true
+					}
+				case share.CriteriaOpContainsAny:
+					if vs.containsAny(valueSet) {
+						return true, true
+					}
+				case share.CriteriaOpNotContainsAny:
+					if vs.containsAny(valueSet) {
+						return false, false
+					}
+				}
+				break
+			}
 			for _, crtValue := range crt.ValueSlice {
 				switch crt.Op {
 				case share.CriteriaOpContainsAll:
 					found := false
 					for value := range valueSet.Iter() {
-						if share.EqualMatch(crtValue, value.(string)) {
+						if admEqualMatch(crtValue, value.(string)) {
 							found = true
 							break
 						}
@@ -803,18 +825,18 @@ func isSetCriterionMet(crt *share.CLUSAdmRuleCriterion, valueSet utils.Set) (boo
 					}
 				case share.CriteriaOpContainsAny:
 					for value := range valueSet.Iter() {
-						if share.EqualMatch(crtValue, value.(string)) {
+						if admEqualMatch(crtValue, value.(string)) {
 							return true, true
 						}
 					}
 				case share.CriteriaOpNotContainsAny:
 					for value := range valueSet.Iter() {
-						if share.EqualMatch(crtValue, value.(string)) {
+						if admEqualMatch(crtValue, value.(string)) {
 							return false, false
 						}
 					}
 				case share.CriteriaOpRegexContainsAny, share.CriteriaOpRegexNotContainsAny:
-					if regex, err := regexp.Compile(crtValue); err == nil {
+					if regex := admRegexp(crtValue); regex != nil {
 						for value := range valueSet.Iter() {
 							if regex.MatchString(value.(string)) {
 								if crt.Op == share.CriteriaOpRegexContainsAny {
@@ -828,10 +850,16 @@ func isSetCriterionMet(crt *share.CLUSAdmRuleCriterion, valueSet utils.Set) (boo
 				}
 			}
 		case share.CriteriaOpContainsOtherThan:
+			if vs := getAdmValueSet(crt); vs != nil {
+				if vs.containsOtherThan(valueSet) {
+					return true, true
+				}
+				break
+			}
 			for value := range valueSet.Iter() {
 				found := false
 				for _, crtValue := range crt.ValueSlice {
-					if share.EqualMatch(crtValue, value.(string)) {
+					if admEqualMatch(crtValue, value.(string)) {
 						found = true
 						break
 					}
@@ -986,7 +1014,7 @@ func getCrtTestFunction(crt *share.CLUSAdmRuleCriterion, comparisonOp string) fu
 	}
 
 	return func(crtVal string, propVal string) bool {
-		return share.EqualMatch(crtVal, propVal)
+		return admEqualMatch(crtVal, propVal)
 	}
 }
 
@@ -1215,9 +1243,9 @@ func matchImageValue(crtOp, crtValue string, c *nvsysadmission.AdmContainerInfo)
 		}
 		switch crtOp {
 		case share.CriteriaOpRegex:
-			matched, _ = regexp.MatchString(crtValue, fullName)
+			matched = admRegexMatch(crtValue, fullName)
 		default:
-			matched = share.EqualMatch(crtValue, fullName)
+			matched = admEqualMatch(crtValue, fullName)
 		}
 		if !crtHasRegistry || matched {
 			break
@@ -1340,8 +1368,42 @@ func mergeVulnMaps(highVulns, criticalVulns map[string]share.CLUSScannedVulInfo)
 //	apply 'or' after the first positive match;
 //
 // For different criteria type, apply 'and'
+// The custom criteria rego only looks at the kind, namespace and object of the request. The
+// input has no other field, and none of the object metadata set per request, so that the same
+// workload gives the same input and its decision can be cached.
+func customCriteriaInput(ar *admissionv1beta1.AdmissionReview) string {
+	type customCriteriaRequest struct {
+		Kind      interface{} `json:"kind"`
+		Namespace string      `json:"namespace"`
+		Object    interface{} `json:"object"`
+	}
+	// OPA requres the data wrapped under "input" key
+	type customCriteriaWrapper struct {
+		Input struct {
+			Request customCriteriaRequest `json:"request"`
+		} `json:"input"`
+	}
+
+	var in customCriteriaWrapper
+	if ar.Request != nil {
+		var object map[string]interface{}
+		if err := json.Unmarshal(ar.Request.Object.Raw, &object); err == nil {
+			if meta, ok := object["metadata"].(map[string]interface{}); ok {
+				for _, f := range []string{"uid", "resourceVersion", "creationTimestamp", "managedFields"} {
+					delete(meta, f)
+				}
+			}
+			in.Input.Request.Object = object
+		}
+		in.Input.Request.Kind = ar.Request.Kind
+		in.Input.Request.Namespace = ar.Request.Namespace
+	}
+	jsonData, _ := json.Marshal(&in)
+	return string(jsonData)
+}
+
 func isAdmissionRuleMet(admResObject *nvsysadmission.AdmResObject, c *nvsysadmission.AdmContainerInfo, scannedImage *nvsysadmission.ScannedImageSummary,
-	criteria []*share.CLUSAdmRuleCriterion, rootAvail bool, ar *admissionv1beta1.AdmissionReview, ruleID uint32) (bool, string) { // return (matched, matched data source)
+	criteria []*share.CLUSAdmRuleCriterion, lastOfKey []bool, rootAvail bool, ar *admissionv1beta1.AdmissionReview, ruleID uint32) (bool, string) { // return (matched, matched data source)
 	var met, positive bool
 	var matchedSource string
 	var mets map[string]bool = make(map[string]bool)
@@ -1365,7 +1427,7 @@ func isAdmissionRuleMet(admResObject *nvsysadmission.AdmResObject, c *nvsysadmis
 		}
 	}
 
-	for _, crt := range criteria {
+	for i, crt := range criteria {
 		if c.Type == nvsysadmission.K8SEphemeralContainer || c.Type == nvsysadmission.K8sInitContainer {
 			if crt.Name != share.CriteriaKeyHasPssViolation {
 				// don't check non-pss criteria for ephemeral or init containers
@@ -1535,21 +1597,18 @@ func isAdmissionRuleMet(admResObject *nvsysadmission.AdmResObject, c *nvsysadmis
 			}
 			poss[key] = p || positive
 		}
+
+		// the rule can't be met, skip the rest of the criteria
+		if lastOfKey != nil && lastOfKey[i] && !mets[key] {
+			return false, ""
+		}
 	}
 
 	if hasCustomCriteria {
 		// handle custom criteria,
-		// OPA requres the data wrapped under "input" key
-		type AdmissionReviewWrapper struct {
-			Review *admissionv1beta1.AdmissionReview `json:"input"`
-		}
-
-		ar2 := AdmissionReviewWrapper{Review: ar}
-		jsonData, _ := json.Marshal(ar2)
-
 		policyUrl := fmt.Sprintf("/v1/data/neuvector_policy_%d", ruleID)
 
-		statusCode, body, err := opa.OpaEvalByString(policyUrl, string(jsonData))
+		statusCode, body, err := opa.OpaEvalByString(policyUrl, customCriteriaInput(ar))
 
 		if err != nil {
 			log.WithFields(log.Fields{"err": err, "policyUrl": policyUrl, "ar.RequestID": ar.Request.UID}).Error("opa.OpaEvalByString() failed")
@@ -1884,8 +1943,9 @@ func matchK8sAdmissionRules(ruleType string, matchCfgType int, admResObject *nvs
 						continue
 					}
 
+					criteria, lastOfKey := getAdmRuleCriteria(rule)
 					for _, scannedImage := range scannedImages {
-						if matched, matchedSource := isAdmissionRuleMet(admResObject, c, scannedImage, rule.Criteria, evalContext.RootAvail, ar, rule.ID); matched {
+						if matched, matchedSource := isAdmissionRuleMet(admResObject, c, scannedImage, criteria, lastOfKey, evalContext.RootAvail, ar, rule.ID); matched {
 							extraDenyRuleMsg := ""
 							if ruleType == share.FedAdmCtrlDenyRulesType || ruleType == api.ValidatingDenyRuleType {
 								if matchedSource != "" {
@@ -0,0 +1,234 @@
+package cache
+
+import (
+	"fmt"
+	"regexp"
+	"sort"
+	"strings"
+	"sync"
+
+	"github.com/neuvector/neuvector/share"
+	"github.com/neuvector/neuvector/share/utils"
+)
+
+// Admission rules are compiled when they are cached. The regex and wildcard patterns of the
+// criteria are compiled once, the set values without wildcard are hashed, and the criteria
+// are ordered by cost so that a rule is given up at the first criterion key that cannot be met,
+// before the expensive ones are looked at. Criteria of rules not in the cache, like the ones of
+// a rule test, are matched the same way without the ordering.
+
+type admCompiledRule struct {
+	criteria  []*share.CLUSAdmRuleCriterion
+	lastOfKey []bool // the last criterion of its key, all criteria with the key are checked
+}
+
+type admValueSet struct {
+	exact map[string]struct{}
+	globs []string
+}
+
+var admCompiledRules sync.Map // *share.CLUSAdmissionRule -> *admCompiledRule
+var admValueSets sync.Map     // *share.CLUSAdmRuleCriterion -> *admValueSet
+var admPatterns sync.Map      // regex -> *regexp.Regexp, nil if it doesn't compile
+
+func admRegexp(pattern string) *regexp.Regexp {
+	if v, ok := admPatterns.Load(pattern); ok {
+		return v.(*regexp.Regexp)
+	}
+	re, err := regexp.Compile(pattern)
+	if err != nil {
+		re = nil
+	}
+	admPatterns.Store(pattern, re)
+	return re
+}
+
+func admRegexMatch(pattern, value string) bool {
+	if re := admRegexp(pattern); re != nil {
+		return re.MatchString(value)
+	}
+	return false
+}
+
+func isAdmWildcard(match string) bool {
+	return strings.ContainsAny(match, "?*")
+}
+
+// Same as share.EqualMatch(), with the pattern compiled once
+func admEqualMatch(match, value string) bool {
+	if !isAdmWildcard(match) {
+		return match == value
+	}
+
+	re := strings.Replace(match, ".", "\\.", -1)
+	re = strings.Replace(re, "?", ".", -1)
+	re = strings.Replace(re, "*", ".*", -1)
+	if regex := admRegexp(fmt.Sprintf("^%s$", re)); regex != nil {
+		return regex.MatchString(value)
+	}
+	return match == value
+}
+
+func (vs *admValueSet) matchValue(value string) bool {
+	if _, ok := vs.exact[value]; ok {
+		return true
+	}
+	for _, glob := range vs.globs {
+		if admEqualMatch(glob, value) {
+			return true
+		}
+	}
+	return false
+}
+
+// Any value matches a criterion value
+func (vs *admValueSet) containsAny(valueSet utils.Set) bool {
+	for value := range valueSet.Iter() {
+		if vs.matchValue(value.(string)) {
+			return true
+		}
+	}
+	return false
+}
+
+// Every criterion value matches a value
+func (vs *admValueSet) containsAll(valueSet utils.Set) bool {
+	for crtValue := range vs.exact {
+		if !valueSet.Contains(crtValue) {
+			return false
+		}
+	}
+	for _, glob := range vs.globs {
+		found := false
+		for value := range valueSet.Iter() {
+			if admEqualMatch(glob, value.(string)) {
+				found = true
+				break
+			}
+		}
+		if !found {
+			return false
+		}
+	}
+	return true
+}
+
+// A value matches no criterion value
+func (vs *admValueSet) containsOtherThan(valueSet utils.Set) bool {
+	for value := range valueSet.Iter() {
+		if !vs.matchValue(value.(string)) {
+			return true
+		}
+	}
+	return false
+}
+
+func getAdmValueSet(crt *share.CLUSAdmRuleCriterion) *admValueSet {
+	if v, ok := admValueSets.Load(crt); ok {
+		return v.(*admValueSet)
+	}
+	return nil
+}
+
+// Lower is cheaper: a compare of a request field, a look at the container or image data, or
+// a k8s lookup or a full scan of the container spec
+func admCriterionCost(crt *share.CLUSAdmRuleCriterion) int {
+	if crt.Type == share.CriteriaKeySaBindRiskyRole {
+		return 2
+	}
+	switch crt.Name {
+	case share.CriteriaKeyUser, share.CriteriaKeyK8sGroups, share.CriteriaKeyNamespace, share.CriteriaKeyImageScanned,
+		share.CriteriaKeyRunAsPrivileged, share.CriteriaKeyRunAsRoot, share.CriteriaKeyAllowPrivEscalation,
+		share.CriteriaKeySharePidWithHost, share.CriteriaKeyShareIpcWithHost, share.CriteriaKeyShareNetWithHost,
+		share.CriteriaKeyImageNoOS:
+		return 0
+	case share.CriteriaKeyImageSigned, share.CriteriaKeyHasPssViolation, share.CriteriaKeyPspCompliance,
+		share.CriteriaKeyImageCompliance, share.CriteriaKeyEnvVarSecrets, share.CriteriaKeyStorageClassName:
+		return 2
+	}
+	return 1
+}
+
+func compileAdmRuleCriterion(crt *share.CLUSAdmRuleCriterion) {
+	switch crt.Op {
+	case share.CriteriaOpContainsAll, share.CriteriaOpContainsAny, share.CriteriaOpNotContainsAny, share.CriteriaOpContainsOtherThan:
+		vs := &admValueSet{exact: make(map[string]struct{})}
+		for _, crtValue := range crt.ValueSlice {
+			if isAdmWildcard(crtValue) {
+				admEqualMatch(crtValue, "")
+				vs.globs = append(vs.globs, crtValue)
+			} else {
+				vs.exact[crtValue] = struct{}{}
+			}
+		}
+		admValueSets.Store(crt, vs)
+	case share.CriteriaOpRegexContainsAny, share.CriteriaOpRegexNotContainsAny:
+		for _, crtValue := range crt.ValueSlice {
+			admRegexp(crtValue)
+		}
+	case share.CriteriaOpRegex, share.CriteriaOpNotRegex, share.CriteriaOpRegex_Deprecated, share.CriteriaOpNotRegex_Deprecated:
+		admRegexp(crt.Value)
+	case share.CriteriaOpEqual, share.CriteriaOpNotEqual:
+		admEqualMatch(crt.Value, "")
+	}
+	for _, sub := range crt.SubCriteria {
+		compileAdmRuleCriterion(sub)
+	}
+}
+
+// Called with the rule's ValueSlice filled, before the rule is put in the cache
+func compileAdmissionRule(rule *share.CLUSAdmissionRule) {
+	for _, crt := range rule.Criteria {
+		compileAdmRuleCriterion(crt)
+	}
+
+	// Criteria of a key stay together, in their order, keys are ordered by their cheapest criterion
+	keyCost := make(map[string]int)
+	keyFirst := make(map[string]int)
+	for i, crt := range rule.Criteria {
+		cost := admCriterionCost(crt)
+		if c, ok := keyCost[crt.Name]; !ok || cost < c {
+			keyCost[crt.Name] = cost
+		}
+		if _, ok := keyFirst[crt.Name]; !ok {
+			keyFirst[crt.Name] = i
+		}
+	}
+	criteria := make([]*share.CLUSAdmRuleCriterion, len(rule.Criteria))
+	copy(criteria, rule.Criteria)
+	sort.SliceStable(criteria, func(i, j int) bool {
+		ci, cj := keyCost[criteria[i].Name], keyCost[criteria[j].Name]
+		if ci != cj {
+			return ci < cj
+		}
+		return keyFirst[criteria[i].Name] < keyFirst[criteria[j].Name]
+	})
+
+	compiled := &admCompiledRule{criteria: criteria, lastOfKey: make([]bool, len(criteria))}
+	for i, crt := range criteria {
+		// custom criteria are evaluated together at the end
+		if crt.Type != "" && crt.Type != share.CriteriaKeySaBindRiskyRole {
+			continue
+		}
+		compiled.lastOfKey[i] = i == len(criteria)-1 || criteria[i+1].Name != crt.Name
+	}
+	admCompiledRules.Store(rule, compiled)
+}
+
+func forgetAdmissionRule(rule *share.CLUSAdmissionRule) {
+	if rule == nil {
+		return
+	}
+	admCompiledRules.Delete(rule)
+	for _, crt := range rule.Criteria {
+		admValueSets.Delete(crt)
+	}
+}
+
+func getAdmRuleCriteria(rule *share.CLUSAdmissionRule) ([]*share.CLUSAdmRuleCriterion, []bool) {
+	if v, ok := admCompiledRules.Load(rule); ok {
+		compiled := v.(*admCompiledRule)
+		return compiled.criteria, compiled.lastOfKey
+	}
+	return rule.Criteria, nil
+}
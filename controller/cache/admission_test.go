@@ -1512,7 +1512,7 @@ func TestIsLabelCriterionMet1(t *testing.T) {
 		tag := 0
 		for _, admResObject := range admResObjects {
 			for _, scannedImage := range scannedImages {
-				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, false, nil, 0)
+				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, nil, false, nil, 0)
 				if matched != expected[idx][tag].matched || matchedSource != expected[idx][tag].matchedSource {
 					t.Errorf("Unexpected isAdmissionRuleMet[%d:%d] result(%+v,%+v) for (yaml:%+v, image:%+v, scanned:%+v) %s %s, expect:(%+v,%+v)\n",
 						idx, tag, matched, matchedSource, admResObject.Labels, scannedImage.Labels, scannedImage.Scanned, crts[0].Op, crts[0].Value, expected[idx][tag].matched, expected[idx][tag].matchedSource)
@@ -1617,7 +1617,7 @@ func TestIsLabelCriterionMet2(t *testing.T) {
 		tag := 0
 		for _, admResObject := range admResObjects {
 			for _, scannedImage := range scannedImages {
-				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, false, nil, 0)
+				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, nil, false, nil, 0)
 				if matched != expected[idx][tag].matched || matchedSource != expected[idx][tag].matchedSource {
 					t.Errorf("Unexpected isAdmissionRuleMet[%d:%d] result(%+v,%+v) for (yaml:%+v, image:%+v, scanned:%+v) %s %s, expect:(%+v,%+v)\n",
 						idx, tag, matched, matchedSource, admResObject.Labels, scannedImage.Labels, scannedImage.Scanned, crts[0].Op, crts[0].Value, expected[idx][tag].matched, expected[idx][tag].matchedSource)
@@ -1722,7 +1722,7 @@ func TestIsLabelCriterionMet3(t *testing.T) {
 		tag := 0
 		for _, admResObject := range admResObjects {
 			for _, scannedImage := range scannedImages {
-				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, false, nil, 0)
+				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, nil, false, nil, 0)
 				if matched != expected[idx][tag].matched || matchedSource != expected[idx][tag].matchedSource {
 					t.Errorf("Unexpected isAdmissionRuleMet[%d:%d] result(%+v,%+v) for (yaml:%+v, image:%+v, scanned:%+v) %s %s, expect:(%+v,%+v)\n",
 						idx, tag, matched, matchedSource, admResObject.Labels, scannedImage.Labels, scannedImage.Scanned, crts[0].Op, crts[0].Value, expected[idx][tag].matched, expected[idx][tag].matchedSource)
@@ -1856,7 +1856,7 @@ func TestIsLabelCriterionMet4(t *testing.T) {
 		tag := 0
 		for _, admResObject := range admResObjects {
 			for _, scannedImage := range scannedImages {
-				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, false, nil, 0)
+				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, nil, false, nil, 0)
 				if matched != expected[idx][tag].matched || matchedSource != expected[idx][tag].matchedSource {
 					t.Errorf("Unexpected isAdmissionRuleMet[%d:%d] result(%+v,%+v) for (yaml:%+v, image:%+v, scanned:%+v) %s %s, expect:(%+v,%+v)\n",
 						idx, tag, matched, matchedSource, admResObject.Labels, scannedImage.Labels, scannedImage.Scanned, crts[0].Op, crts[0].Value, expected[idx][tag].matched, expected[idx][tag].matchedSource)
@@ -1990,7 +1990,7 @@ func TestIsLabelCriterionMet5(t *testing.T) {
 		tag := 0
 		for _, admResObject := range admResObjects {
 			for _, scannedImage := range scannedImages {
-				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, false, nil, 0)
+				matched, matchedSource = isAdmissionRuleMet(admResObject, cs[0], scannedImage, crts, nil, false, nil, 0)
 				if matched != expected[idx][tag].matched || matchedSource != expected[idx][tag].matchedSource {
 					t.Errorf("Unexpected isAdmissionRuleMet[%d:%d] result(%+v,%+v) for (yaml:%+v, image:%+v, scanned:%+v) %s %s, expect:(%+v,%+v)\n",
 						idx, tag, matched, matchedSource, admResObject.Labels, scannedImage.Labels, scannedImage.Scanned, crts[0].Op, crts[0].Value, expected[idx][tag].matched, expected[idx][tag].matchedSource)
@@ -2174,7 +2174,7 @@ func TestIsAnnotationCriterionMet(t *testing.T) {
 	cs := []*nvsysadmission.AdmContainerInfo{{}}
 	for _, rule_tcs := range expected {
 		for _, tc := range rule_tcs.tcs {
-			matched, _ := isAdmissionRuleMet(&tc.obj, cs[0], nil, rule_tcs.rule, false, nil, 0)
+			matched, _ := isAdmissionRuleMet(&tc.obj, cs[0], nil, rule_tcs.rule, nil, false, nil, 0)
 			t.Log(rule_tcs, rule_tcs.rule[0].Name, rule_tcs.rule[0].Op, tc.obj)
 			assert.Equal(t, tc.matched, matched)
 		}
@@ -2228,3 +2228,36 @@ func TestIsUserGroupCriterionMet(t *testing.T) {
 
 	postTest()
 }
+
+func TestAdmCompiledRule(t *testing.T) {
+	rule := &share.CLUSAdmissionRule{
+		ID: 1001,
+		Criteria: []*share.CLUSAdmRuleCriterion{
+			{Name: share.CriteriaKeyImageSigned, Op: share.CriteriaOpEqual, Value: "true"},
+			{Name: share.CriteriaKeyCVENames, Op: share.CriteriaOpContainsAny, ValueSlice: []string{"CVE-2023-1", "CVE-2024-*"}},
+			{Name: share.CriteriaKeyNamespace, Op: share.CriteriaOpContainsAny, ValueSlice: []string{"prod", "dev-*"}},
+			{Name: share.CriteriaKeyCVENames, Op: share.CriteriaOpContainsAll, ValueSlice: []string{"CVE-2023-2"}},
+		},
+	}
+	compileAdmissionRule(rule)
+	defer forgetAdmissionRule(rule)
+
+	criteria, lastOfKey := getAdmRuleCriteria(rule)
+	expect := []string{share.CriteriaKeyNamespace, share.CriteriaKeyCVENames, share.CriteriaKeyCVENames, share.CriteriaKeyImageSigned}
+	expectLast := []bool{true, false, true, true}
+	for i, crt := range criteria {
+		if crt.Name != expect[i] || lastOfKey[i] != expectLast[i] {
+			t.Errorf("Unexpected criteria order: i=%v name=%v last=%v", i, crt.Name, lastOfKey[i])
+		}
+	}
+
+	crt := rule.Criteria[1]
+	for values, met := range map[string]bool{"CVE-2023-1": true, "CVE-2024-77": true, "CVE-2022-1": false} {
+		if m, _ := isSetCriterionMet(crt, utils.NewSet(values, "CVE-2021-5")); m != met {
+			t.Errorf("Unexpected match: values=%v met=%v", values, m)
+		}
+	}
+	if m, _ := isSetCriterionMet(rule.Criteria[3], utils.NewSet("CVE-2023-1", "CVE-2023-2")); !m {
+		t.Errorf("Unexpected match: contains all")
+	}
+}
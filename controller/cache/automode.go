@@ -55,16 +55,15 @@ func automode_m2p_test_func(group string, probeDuration int64) (bool, error) {
 		switch modeType {
 		case atmo.ProfileMode: // runtime profile
 			// process incidents
-			for i := 0; i < curIncidentIndex; i++ {
-				incd := incidentCache[curIncidentIndex-i-1]
+			seqs := incidentGroupIndex[theGroup]
+			for i := len(seqs) - 1; i >= 0; i-- {
+				incd := incidentCache[incidentRing.slot(seqs[i])]
 				if incd == nil || incd.AggregationFrom < traceback {
 					continue
 				}
 
-				if incd.Group == theGroup {
-					count++
-					incd_last = incd
-				}
+				count++
+				incd_last = incd
 			}
 
 			if count > 0 {
@@ -72,30 +71,28 @@ func automode_m2p_test_func(group string, probeDuration int64) (bool, error) {
 			}
 		case atmo.PolicyMode: // network policy
 			// suspicious network threats
-			for i := 0; i < curThrtIndex; i++ {
-				thrt := thrtCache[curThrtIndex-i-1]
+			seqs := thrtGroupIndex[theGroup]
+			for i := len(seqs) - 1; i >= 0; i-- {
+				thrt := thrtCache[thrtRing.slot(seqs[i])]
 				if thrt == nil || thrt.ReportedTimeStamp < traceback {
 					continue
 				}
 
-				if thrt.Group == theGroup {
-					count++
-					thrt_last = thrt
-				}
+				count++
+				thrt_last = thrt
 			}
 
 			// network violations
 			service := strings.TrimPrefix(theGroup, "nv.")
-			for i := 0; i < curVioIndex; i++ {
-				vio := vioCache[curVioIndex-i-1]
+			seqs = vioServiceIndex[service]
+			for i := len(seqs) - 1; i >= 0; i-- {
+				vio := vioCache[vioRing.slot(seqs[i])]
 				if vio == nil || vio.ReportedTimeStamp < traceback {
 					continue
 				}
 
-				if vio.ServerService == service || vio.ClientService == service {
-					count++
-					vio_last = vio
-				}
+				count++
+				vio_last = vio
 			}
 			if count > 0 {
 				log.WithFields(log.Fields{"theGroup": theGroup, "count": count, "vio_last": vio_last, "thrt_last": thrt_last}).Debug("ATMO: Policy")
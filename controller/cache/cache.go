@@ -141,6 +141,7 @@ func cacheMutexLock() {
 }
 
 func cacheMutexUnlock() {
+	publishCacheView()
 	cacheMutex.Unlock()
 	cctx.MutexLog.WithFields(log.Fields{"goroutine": utils.GetGID()}).Debug("Released")
 }
@@ -446,11 +447,8 @@ func showStrictGroupMode(id string) bool {
 	if !getStrictGroupModeStatus() {
 		return false
 	}
-	if cache := getWorkloadCache(id); cache != nil {
-		policyMode, _ := getWorkloadEffectivePolicyMode(cache)
-		return policyMode == share.PolicyModeEnforce
-	}
-	return false
+	policyMode, _, ok := getCacheView().workloadPolicyMode(id)
+	return ok && policyMode == share.PolicyModeEnforce
 }
 
 func (m CacheMethod) CanAccessHost(id string, acc *access.AccessControl) error {
@@ -876,14 +874,12 @@ func getWafThreatNameSensorGroup(id uint32) (string, string, *[]string) { //waf
 }
 
 func getWorkloadDlpGrp(id string, grpname *[]string) string {
-	cacheMutexRLock()
-	defer cacheMutexRUnlock()
 	var gns string = ""
 	if id != "" {
-		if cache, ok := wlCacheMap[id]; ok {
+		if wv := getCacheView().workload(id); wv != nil {
 			if grpname != nil {
 				for _, gn := range *grpname {
-					if cache.groups.Contains(gn) {
+					if wv.hasGroup(gn) {
 						if gns == "" {
 							gns += gn
 						} else {
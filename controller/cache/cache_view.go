@@ -0,0 +1,172 @@
+package cache
+
+import (
+	"hash/fnv"
+	"sort"
+	"sync"
+	"sync/atomic"
+
+	"github.com/neuvector/neuvector/share"
+)
+
+// Read-mostly views of the workload and group caches are published as immutable snapshots, so
+// the REST calls and the connection handling read them without cacheMutex. A writer marks the
+// workloads and groups it changes, and cacheMutexUnlock() rebuilds the marked entries and swaps
+// in the new snapshot. The entries are kept in shards; a change copies the shards of the marked
+// keys only, the others are shared with the previous snapshot.
+
+const cacheViewShards = 64
+
+type workloadView struct {
+	groups       []string // sorted
+	learnedGroup string
+	domain       string
+}
+
+type groupView struct {
+	policyMode  string
+	profileMode string
+	capChgMode  bool
+	metric      bool // isCalGrpMet()
+}
+
+type cacheView struct {
+	workloads [cacheViewShards]map[string]*workloadView
+	groups    [cacheViewShards]map[string]*groupView
+}
+
+var cacheViewSnap atomic.Value // *cacheView
+
+var viewMutex sync.Mutex
+var viewDirtyWls map[string]struct{} = make(map[string]struct{})
+var viewDirtyGroups map[string]struct{} = make(map[string]struct{})
+
+func init() {
+	view := &cacheView{}
+	for i := 0; i < cacheViewShards; i++ {
+		view.workloads[i] = make(map[string]*workloadView)
+		view.groups[i] = make(map[string]*groupView)
+	}
+	cacheViewSnap.Store(view)
+}
+
+func getCacheView() *cacheView {
+	return cacheViewSnap.Load().(*cacheView)
+}
+
+func cacheViewShard(key string) int {
+	h := fnv.New32a()
+	h.Write([]byte(key))
+	return int(h.Sum32() % cacheViewShards)
+}
+
+func markViewWorkload(id string) {
+	viewMutex.Lock()
+	viewDirtyWls[id] = struct{}{}
+	viewMutex.Unlock()
+}
+
+func markViewGroup(name string) {
+	viewMutex.Lock()
+	viewDirtyGroups[name] = struct{}{}
+	viewMutex.Unlock()
+}
+
+// Called with cacheMutex locked, before it is released
+func publishCacheView() {
+	viewMutex.Lock()
+	defer viewMutex.Unlock()
+
+	if len(viewDirtyWls) == 0 && len(viewDirtyGroups) == 0 {
+		return
+	}
+
+	old := getCacheView()
+	view := *old
+
+	var copied [cacheViewShards]bool
+	for id := range viewDirtyWls {
+		i := cacheViewShard(id)
+		if !copied[i] {
+			copied[i] = true
+			view.workloads[i] = make(map[string]*workloadView, len(old.workloads[i])+1)
+			for k, v := range old.workloads[i] {
+				view.workloads[i][k] = v
+			}
+		}
+		if wlc, ok := wlCacheMap[id]; ok && wlc.groups != nil {
+			groups := wlc.groups.ToStringSlice()
+			sort.Strings(groups)
+			view.workloads[i][id] = &workloadView{
+				groups: groups, learnedGroup: wlc.learnedGroupName, domain: wlc.workload.Domain,
+			}
+		} else {
+			delete(view.workloads[i], id)
+		}
+	}
+
+	copied = [cacheViewShards]bool{}
+	for name := range viewDirtyGroups {
+		i := cacheViewShard(name)
+		if !copied[i] {
+			copied[i] = true
+			view.groups[i] = make(map[string]*groupView, len(old.groups[i])+1)
+			for k, v := range old.groups[i] {
+				view.groups[i][k] = v
+			}
+		}
+		if gc, ok := groupCacheMap[name]; ok && gc.group != nil {
+			view.groups[i][name] = &groupView{
+				policyMode: gc.group.PolicyMode, profileMode: gc.group.ProfileMode, capChgMode: gc.capChgMode,
+				metric: isCalGrpMet(gc),
+			}
+		} else {
+			delete(view.groups[i], name)
+		}
+	}
+
+	viewDirtyWls = make(map[string]struct{})
+	viewDirtyGroups = make(map[string]struct{})
+	cacheViewSnap.Store(&view)
+}
+
+func (v *cacheView) workload(id string) *workloadView {
+	return v.workloads[cacheViewShard(id)][id]
+}
+
+func (v *cacheView) group(name string) *groupView {
+	return v.groups[cacheViewShard(name)][name]
+}
+
+// Same as getWorkloadEffectivePolicyMode(), from the snapshot
+func (v *cacheView) workloadPolicyMode(id string) (string, string, bool) {
+	wv := v.workload(id)
+	if wv == nil {
+		return "", "", false
+	}
+	policyMode, profileMode := share.PolicyModeLearn, share.PolicyModeLearn
+	if gv := v.group(wv.learnedGroup); gv != nil {
+		policyMode, profileMode = gv.policyMode, gv.profileMode
+	}
+	if getNetServiceStatus() {
+		policyMode = getNetServicePolicyMode()
+	}
+	return policyMode, profileMode, true
+}
+
+func (wv *workloadView) hasGroup(name string) bool {
+	i := sort.SearchStrings(wv.groups, name)
+	return i < len(wv.groups) && wv.groups[i] == name
+}
+
+// A group of the workload calculates the group metric
+func (v *cacheView) hasGroupMetric(id string) bool {
+	if wv := v.workload(id); wv != nil {
+		for _, name := range wv.groups {
+			if gv := v.group(name); gv != nil && gv.metric {
+				return true
+			}
+		}
+	}
+	return false
+}
@@ -0,0 +1,55 @@
+package cache
+
+import (
+	"testing"
+
+	"github.com/neuvector/neuvector/share"
+	"github.com/neuvector/neuvector/share/utils"
+)
+
+func TestCacheViewPublish(t *testing.T) {
+	preTest()
+
+	groupCacheMap["nv.app"] = &groupCache{
+		group:      &share.CLUSGroup{Name: "nv.app", PolicyMode: share.PolicyModeEnforce, ProfileMode: share.PolicyModeEvaluate},
+		capChgMode: true,
+	}
+	wlCacheMap["wl1"] = &workloadCache{
+		workload:         &share.CLUSWorkload{ID: "wl1"},
+		groups:           utils.NewSet("nv.app", "g2"),
+		learnedGroupName: "nv.app",
+	}
+	cacheMutexLock()
+	markViewGroup("nv.app")
+	markViewWorkload("wl1")
+	cacheMutexUnlock()
+
+	before := getCacheView()
+	if policyMode, profileMode, ok := before.workloadPolicyMode("wl1"); !ok ||
+		policyMode != share.PolicyModeEnforce || profileMode != share.PolicyModeEvaluate {
+		t.Errorf("Unexpected mode: %v %v %v", policyMode, profileMode, ok)
+	}
+	if wv := before.workload("wl1"); wv == nil || !wv.hasGroup("g2") || wv.hasGroup("g3") {
+		t.Errorf("Unexpected groups: %+v", wv)
+	}
+	if !cacher.IsGroupPolicyModeChangeable("nv.app") {
+		t.Errorf("Group mode should be changeable")
+	}
+
+	// A published snapshot is not changed by the next ones
+	cacheMutexLock()
+	delete(wlCacheMap, "wl1")
+	delete(groupCacheMap, "nv.app")
+	markViewWorkload("wl1")
+	markViewGroup("nv.app")
+	cacheMutexUnlock()
+
+	if getCacheView().workload("wl1") != nil {
+		t.Errorf("Workload should be removed")
+	}
+	if before.workload("wl1") == nil {
+		t.Errorf("Workload should stay in the old snapshot")
+	}
+
+	postTest()
+}
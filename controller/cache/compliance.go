@@ -399,8 +399,8 @@ func (m CacheMethod) GetRiskScoreMetrics(acc, accCaller *access.AccessControl) *
 		var external, violate, threat bool
 
 		if outs := wlGraph.OutsByLink(id, graphLink); outs != nil {
-			for o := range outs.Iter() {
-				if o.(string) == api.LearnedExternal {
+			for _, o := range outs.Items() {
+				if o == api.LearnedExternal {
 					external = true
 					if a := wlGraph.Attr(id, graphLink, api.LearnedExternal); a != nil {
 						attr := a.(*graphAttr)
@@ -419,8 +419,8 @@ func (m CacheMethod) GetRiskScoreMetrics(acc, accCaller *access.AccessControl) *
 			}
 		}
 		if ins := wlGraph.InsByLink(id, graphLink); ins != nil {
-			for o := range ins.Iter() {
-				if o.(string) == api.LearnedExternal {
+			for _, o := range ins.Items() {
+				if o == api.LearnedExternal {
 					external = true
 					if a := wlGraph.Attr(api.LearnedExternal, graphLink, id); a != nil {
 						attr := a.(*graphAttr)
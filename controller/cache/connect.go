@@ -410,12 +410,12 @@ func recalcConversation(attr *graphAttr) {
 
 func deleteConversationByNode(node string) {
 	outs := wlGraph.OutsByLink(node, graphLink)
-	for o := range outs.Iter() {
-		wlGraph.DeleteLink(node, graphLink, o.(string))
+	for _, o := range outs.Items() {
+		wlGraph.DeleteLink(node, graphLink, o)
 	}
 	ins := wlGraph.InsByLink(node, graphLink)
-	for i := range ins.Iter() {
-		wlGraph.DeleteLink(i.(string), graphLink, node)
+	for _, i := range ins.Items() {
+		wlGraph.DeleteLink(i, graphLink, node)
 	}
 }
 
@@ -429,6 +429,7 @@ func deleteConversationByKeyIfViolation(fromNode, toNode string, key *graphKey)
 					wlGraph.DeleteLink(fromNode, graphLink, toNode)
 				} else {
 					recalcConversation(attr)
+					rollupConversation(fromNode, toNode)
 				}
 			}
 		}
@@ -444,6 +445,7 @@ func deleteConversationByKey(fromNode, toNode string, key *graphKey) {
 				wlGraph.DeleteLink(fromNode, graphLink, toNode)
 			} else {
 				recalcConversation(attr)
+				rollupConversation(fromNode, toNode)
 			}
 		}
 	}
@@ -464,6 +466,7 @@ func deleteConversationByPolicyId(fromNode, toNode string, id uint32) {
 				wlGraph.DeleteLink(fromNode, graphLink, toNode)
 			} else {
 				recalcConversation(attr)
+				rollupConversation(fromNode, toNode)
 			}
 		}
 	}
@@ -708,6 +711,10 @@ func CalculateGroupMetric(conn *share.CLUSConnection) {
 	} else {
 		epWL = conn.ClientWL
 	}
+	// Most groups don't monitor metrics, skip the lock for the workloads of none
+	if !getCacheView().hasGroupMetric(epWL) {
+		return
+	}
 	if cache := getWorkloadCache(epWL); cache != nil {
 		cacheMutexLock()
 		defer cacheMutexUnlock()
@@ -759,12 +766,11 @@ func calNetPolicyMet(conn *share.CLUSConnection) {
 	}
 }
 
+// A report is handled in two passes. The qualification and the metrics only need the cache
+// lock, they are done first without the graph lock so that reports from other agents are not
+// held behind them; the graph lock is then taken once for all connections left in the report.
 func UpdateConnections(conns []*share.CLUSConnection) {
-	//syncLock(syncCatgGraphIdx)
-	// use graph lock instead of sync lock for simplicity
-	graphMutexLock()
-	defer graphMutexUnlock()
-
+	qualified := make([]*share.CLUSConnection, 0, len(conns))
 	for i := range conns {
 		conn := conns[i]
 		if !preQualifyConnect(conn) {
@@ -775,7 +781,19 @@ func UpdateConnections(conns []*share.CLUSConnection) {
 		if conn.Ingress {
 			CalculateGroupMetric(conn)
 		}
+		qualified = append(qualified, conn)
+	}
+	if len(qualified) == 0 {
+		return
+	}
+
+	//syncLock(syncCatgGraphIdx)
+	// use graph lock instead of sync lock for simplicity
+	graphMutexLock()
+	defer graphMutexUnlock()
 
+	connDebug := cctx.ConnLog.IsLevelEnabled(log.DebugLevel)
+	for _, conn := range qualified {
 		var ca, sa *nodeAttr
 		var stip *serverTip
 		var add bool
@@ -803,43 +821,45 @@ func UpdateConnections(conns []*share.CLUSConnection) {
 			continue
 		}
 
-		cctx.ConnLog.WithFields(log.Fields{
-			"agent":          container.ShortContainerId(conn.AgentID),
-			"host":           conn.HostID,
-			"client":         container.ShortContainerId(conn.ClientWL),
-			"server":         container.ShortContainerId(conn.ServerWL),
-			"clientIP":       net.IP(conn.ClientIP),
-			"serverIP":       net.IP(conn.ServerIP),
-			"clientPort":     conn.ClientPort,
-			"serverPort":     conn.ServerPort,
-			"ipproto":        conn.IPProto,
-			"app":            conn.Application,
-			"scope":          conn.Scope,
-			"network":        conn.Network,
-			"bytes":          conn.Bytes,
-			"sessions":       conn.Sessions,
-			"first":          conn.FirstSeenAt,
-			"last":           conn.LastSeenAt,
-			"threatID":       conn.ThreatID,
-			"threatSev":      conn.Severity,
-			"policyAction":   conn.PolicyAction,
-			"policyID":       conn.PolicyId,
-			"policyViolates": conn.Violates,
-			"ingress":        conn.Ingress,
-			"external":       conn.ExternalPeer,
-			"local":          conn.LocalPeer,
-			"xff":            conn.Xff,
-			"extIP":          conn.SvcExtIP,
-			"toSidecar":      conn.ToSidecar,
-			"meshToSvr":      conn.MeshToSvr,
-			"linkLocal":      conn.LinkLocal,
-			"fqdn":           conn.FQDN,
-			"nbe":            conn.Nbe,
-			"nbesns":         conn.NbeSns,
-			"EpSessCurIn":    conn.EpSessCurIn,
-			"EpSessIn12":     conn.EpSessIn12,
-			"EpByteIn12":     conn.EpByteIn12,
-		}).Debug()
+		if connDebug {
+			cctx.ConnLog.WithFields(log.Fields{
+				"agent":          container.ShortContainerId(conn.AgentID),
+				"host":           conn.HostID,
+				"client":         container.ShortContainerId(conn.ClientWL),
+				"server":         container.ShortContainerId(conn.ServerWL),
+				"clientIP":       net.IP(conn.ClientIP),
+				"serverIP":       net.IP(conn.ServerIP),
+				"clientPort":     conn.ClientPort,
+				"serverPort":     conn.ServerPort,
+				"ipproto":        conn.IPProto,
+				"app":            conn.Application,
+				"scope":          conn.Scope,
+				"network":        conn.Network,
+				"bytes":          conn.Bytes,
+				"sessions":       conn.Sessions,
+				"first":          conn.FirstSeenAt,
+				"last":           conn.LastSeenAt,
+				"threatID":       conn.ThreatID,
+				"threatSev":      conn.Severity,
+				"policyAction":   conn.PolicyAction,
+				"policyID":       conn.PolicyId,
+				"policyViolates": conn.Violates,
+				"ingress":        conn.Ingress,
+				"external":       conn.ExternalPeer,
+				"local":          conn.LocalPeer,
+				"xff":            conn.Xff,
+				"extIP":          conn.SvcExtIP,
+				"toSidecar":      conn.ToSidecar,
+				"meshToSvr":      conn.MeshToSvr,
+				"linkLocal":      conn.LinkLocal,
+				"fqdn":           conn.FQDN,
+				"nbe":            conn.Nbe,
+				"nbesns":         conn.NbeSns,
+				"EpSessCurIn":    conn.EpSessCurIn,
+				"EpSessIn12":     conn.EpSessIn12,
+				"EpByteIn12":     conn.EpByteIn12,
+			}).Debug()
+		}
 
 		addConnectToGraph(conn, ca, sa, stip)
 
@@ -1709,9 +1729,9 @@ func graphAttr2REST(attr *graphAttr) *api.RESTConversationReport {
 	conver.PolicyAction = common.PolicyActionRESTString(attr.policyAction)
 	conver.Severity, _ = common.SeverityString(attr.severity)
 
-	protos := utils.NewSet()
-	apps := utils.NewSet()
-	ports := utils.NewSet()
+	protos := utils.NewUint32Set()
+	apps := utils.NewUint32Set()
+	ports := utils.NewStringSet()
 
 	var eventype map[string]string = make(map[string]string)
 	var entries []*api.RESTConversationReportEntry
@@ -1726,7 +1746,7 @@ func graphAttr2REST(attr *graphAttr) *api.RESTConversationReport {
 			FQDN:         ge.fqdn,
 			LastSeenAt:   int64(ge.last),
 		}
-		protos.Add(key.ipproto)
+		protos.Add(uint32(key.ipproto))
 		if key.application == 0 || key.application == C.DPI_APP_NOT_CHECKED {
 			ports.Add(utils.GetPortLink(key.ipproto, key.port))
 			entry.Port = utils.GetPortLink(key.ipproto, key.port)
@@ -1757,19 +1777,16 @@ func graphAttr2REST(attr *graphAttr) *api.RESTConversationReport {
 	}
 
 	conver.Protos = make([]string, 0)
-	for proto := range protos.Iter() {
-		str := utils.Proto2Name(proto.(uint8))
+	for _, proto := range protos.Items() {
+		str := utils.Proto2Name(uint8(proto))
 		conver.Protos = append(conver.Protos, str)
 	}
 	conver.Apps = make([]string, 0)
-	for app := range apps.Iter() {
-		str := common.AppNameMap[app.(uint32)]
+	for _, app := range apps.Items() {
+		str := common.AppNameMap[app]
 		conver.Apps = append(conver.Apps, str)
 	}
-	for port := range ports.Iter() {
-		str := port.(string)
-		conver.Ports = append(conver.Ports, str)
-	}
+	conver.Ports = append(conver.Ports, ports.Items()...)
 	conver.Entries = entries
 
 	return conver
@@ -1874,14 +1891,15 @@ func (s conversationEntrySorter) Less(i, j int) bool {
 }
 
 func isNodeConnected(node string, wls utils.Set) bool {
-	outs := wlGraph.OutsByLink(node, graphLink)
-	if outs != nil && outs.Intersect(wls).Cardinality() > 0 {
-		return true
+	for _, o := range wlGraph.OutsByLink(node, graphLink).Items() {
+		if wls.Contains(o) {
+			return true
+		}
 	}
-
-	ins := wlGraph.InsByLink(node, graphLink)
-	if ins != nil && ins.Intersect(wls).Cardinality() > 0 {
-		return true
+	for _, i := range wlGraph.InsByLink(node, graphLink).Items() {
+		if wls.Contains(i) {
+			return true
+		}
 	}
 	return false
 }
@@ -1925,9 +1943,9 @@ func (m CacheMethod) GetAllConverEndpoints(view string, acc *access.AccessContro
 
 	all := wlGraph.All()
 
-	for n := range all.Iter() {
-		if _, ok := wlCacheMap[n.(string)]; !ok {
-			if ep := getNonWorkloadEndpoint(n.(string)); ep != nil {
+	for _, n := range all.Items() {
+		if _, ok := wlCacheMap[n]; !ok {
+			if ep := getNonWorkloadEndpoint(n); ep != nil {
 				if !acc.Authorize(ep, nil) {
 					continue
 				}
@@ -2038,9 +2056,9 @@ func (m CacheMethod) getApplicationConver(src, dst string, acc *access.AccessCon
 func (m CacheMethod) GetApplicationConver(src, dst string, srcList, dstList []string, acc *access.AccessControl) (*api.RESTConversationDetail, error) {
 	if srcList != nil && dstList != nil {
 		var report api.RESTConversationReport
-		protos := utils.NewSet()
-		apps := utils.NewSet()
-		ports := utils.NewSet()
+		protos := utils.NewStringSet()
+		apps := utils.NewStringSet()
+		ports := utils.NewStringSet()
 		entries := make([]*api.RESTConversationEntry, 0)
 		reportEntries := make([]*api.RESTConversationReportEntry, 0)
 
@@ -2070,9 +2088,9 @@ func (m CacheMethod) GetApplicationConver(src, dst string, srcList, dstList []st
 			}
 		}
 
-		report.Protos = protos.ToStringSlice()
-		report.Ports = ports.ToStringSlice()
-		report.Apps = apps.ToStringSlice()
+		report.Protos = protos.Items()
+		report.Ports = ports.Items()
+		report.Apps = apps.Items()
 		report.Entries = reportEntries
 
 		accReadAll := access.NewReaderAccessControl()
@@ -2156,26 +2174,26 @@ func (m CacheMethod) GetAllApplicationConvers(
 		}
 	}
 
-	wlSet := utils.NewSet()
+	wlSet := utils.NewStringSet()
 	all := wlGraph.All()
-	for n := range all.Iter() {
+	for _, n := range all.Items() {
 		var ep *api.RESTConversationEndpoint
 		var ok bool
-		if ep, ok = epsMap[n.(string)]; !ok {
+		if ep, ok = epsMap[n]; !ok {
 			continue
 		}
 
 		outs := wlGraph.OutsByLink(ep.ID, graphLink)
-		for o := range outs.Iter() {
-			to, ok := epsMap[o.(string)]
+		for _, o := range outs.Items() {
+			to, ok := epsMap[o]
 			if !ok {
 				// The 'to' end is not visible to the login user, still include the conversation.
 				// Cannot add the endpoint to epsMap, which will have better performace if the endpoint is gonna used
 				// many times, because we use epsMap to check conversation duplication, see 'in-link' logic.
-				if cache, ok := wlCacheMap[o.(string)]; ok {
+				if cache, ok := wlCacheMap[o]; ok {
 					to = workload2EndpointREST(cache, true)
 				} else {
-					to = getNonWorkloadEndpoint(o.(string))
+					to = getNonWorkloadEndpoint(o)
 				}
 			}
 
@@ -2195,19 +2213,19 @@ func (m CacheMethod) GetAllApplicationConvers(
 		}
 
 		ins := wlGraph.InsByLink(ep.ID, graphLink)
-		for o := range ins.Iter() {
+		for _, o := range ins.Items() {
 			// if the other end is already in the epsMap, the link is included by the about 'out-link' logic.
-			_, ok := epsMap[o.(string)]
+			_, ok := epsMap[o]
 			if ok {
 				continue
 			}
 
 			var from *api.RESTConversationEndpoint
 			// the 'from' end is not visible to the login user, still include the conversation.
-			if cache, ok := wlCacheMap[o.(string)]; ok {
+			if cache, ok := wlCacheMap[o]; ok {
 				from = workload2EndpointREST(cache, true)
 			} else {
-				from = getNonWorkloadEndpoint(o.(string))
+				from = getNonWorkloadEndpoint(o)
 			}
 
 			if c := filterConvers(gc, domainFilter, from, ep, acc); c != nil {
@@ -2276,8 +2294,8 @@ func DeleteAllConvers() {
 	defer graphMutexUnlock()
 
 	nodes := wlGraph.All()
-	for n := range nodes.Iter() {
-		wlGraph.DeleteNode(n.(string))
+	for _, n := range nodes.Items() {
+		wlGraph.DeleteNode(n)
 	}
 }
 
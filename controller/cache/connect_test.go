@@ -4,8 +4,10 @@ import (
 	"testing"
 
 	"github.com/neuvector/neuvector/controller/access"
+	"github.com/neuvector/neuvector/controller/api"
 	"github.com/neuvector/neuvector/controller/graph"
 	"github.com/neuvector/neuvector/share"
+	"github.com/neuvector/neuvector/share/utils"
 )
 
 func TestGetAllEndpoints(t *testing.T) {
@@ -95,3 +97,69 @@ func TestAliasEndpoint(t *testing.T) {
 
 	postTest()
 }
+
+func TestRollupConvers(t *testing.T) {
+	preTest()
+
+	accReadAll := access.NewReaderAccessControl()
+
+	for _, id := range []string{"w1", "w2", "w3"} {
+		wlCacheMap[id] = &workloadCache{
+			workload:         &share.CLUSWorkload{ID: id, Domain: "ns1"},
+			groups:           utils.NewSet(),
+			learnedGroupName: "nv.app1",
+		}
+		markViewWorkload(id)
+	}
+	wlCacheMap["w3"].workload.Domain = "ns2"
+	wlCacheMap["w3"].learnedGroupName = "nv.app2"
+	cacheMutexLock()
+	cacheMutexUnlock()
+
+	wlGraph = graph.NewGraph()
+	wlGraph.RegisterDelEdgeHook(cbRollupDeleteEdge)
+	rollupReset()
+
+	links := []struct {
+		from, to string
+		attr     graphAttr
+	}{
+		{"w1", "w3", graphAttr{bytes: 100, sessions: 1, policyAction: DP_POLICY_ACTION_ALLOW}},
+		{"w2", "w3", graphAttr{bytes: 200, sessions: 2, policyAction: DP_POLICY_ACTION_VIOLATE}},
+		{"w1", "ex1", graphAttr{bytes: 10, sessions: 1}},
+	}
+	for i := range links {
+		wlGraph.AddLink(links[i].from, graphLink, links[i].to, &links[i].attr)
+		rollupConversation(links[i].from, links[i].to)
+	}
+
+	check := func(view, from, to string, bytes uint64, action string) {
+		for _, c := range cacher.GetRollupConvers(view, accReadAll) {
+			if c.From == from && c.To == to {
+				if c.Bytes != bytes || c.PolicyAction != action {
+					t.Errorf("Unexpected %v edge %v-%v: %+v", view, from, to, c.RESTConversationReport)
+				}
+				return
+			}
+		}
+		if bytes != 0 {
+			t.Errorf("Missing %v edge %v-%v", view, from, to)
+		}
+	}
+
+	check(api.QueryValueViewGroup, "nv.app1", "nv.app2", 300, share.PolicyActionViolate)
+	check(api.QueryValueViewDomain, "ns1", "ns2", 300, share.PolicyActionViolate)
+	check(api.QueryValueViewDomain, "ns1", "ex1", 10, share.PolicyActionOpen)
+
+	// the violation maximum goes away with the conversation
+	wlGraph.DeleteNode("w2")
+	check(api.QueryValueViewGroup, "nv.app1", "nv.app2", 100, share.PolicyActionAllow)
+
+	wlGraph.DeleteNode("w3")
+	check(api.QueryValueViewDomain, "ns1", "ns2", 0, "")
+	if len(cacher.GetRollupConvers(api.QueryValueViewGroup, accReadAll)) != 1 {
+		t.Errorf("Unexpected group edges: %+v", rollupEdges[rollupByGroup])
+	}
+
+	postTest()
+}
@@ -0,0 +1,197 @@
+package cache
+
+import (
+	"github.com/neuvector/neuvector/controller/access"
+	"github.com/neuvector/neuvector/controller/api"
+	"github.com/neuvector/neuvector/controller/common"
+)
+
+// Conversations between endpoints are rolled up into group and domain level edges as they are
+// updated, so the coarse views read the rollup edges instead of walking every conversation of
+// the graph. A workload is rolled up to its learned group and its domain, other endpoints are
+// their own group and domain. Every conversation remembers what it added to the rollup edges;
+// when it changes or is deleted, its old contribution is taken out first. Severity and policy
+// action are counted per value, so their maximum is right after a conversation is removed.
+// The rollup is protected by graphMutex.
+
+const (
+	rollupByGroup = iota
+	rollupByDomain
+	rollupLevels
+)
+
+const rollupValues = 8 // severity and policy action values
+
+type rollupKey struct {
+	from string
+	to   string
+}
+
+type rollupEdge struct {
+	fromDomain string
+	toDomain   string
+	bytes      uint64
+	sessions   uint32
+	convers    int
+	severity   [rollupValues]int32
+	action     [rollupValues]int32
+}
+
+// What a conversation added to the rollup edges
+type rollupContrib struct {
+	keys         [rollupLevels]rollupKey
+	fromDomain   string
+	toDomain     string
+	bytes        uint64
+	sessions     uint32
+	severity     uint8
+	policyAction uint8
+}
+
+var rollupContribs map[rollupKey]*rollupContrib = make(map[rollupKey]*rollupContrib)
+var rollupEdges [rollupLevels]map[rollupKey]*rollupEdge
+
+func init() {
+	rollupReset()
+}
+
+func rollupReset() {
+	rollupContribs = make(map[rollupKey]*rollupContrib)
+	for i := 0; i < rollupLevels; i++ {
+		rollupEdges[i] = make(map[rollupKey]*rollupEdge)
+	}
+}
+
+func rollupValue(v uint8) uint8 {
+	if v >= rollupValues {
+		return rollupValues - 1
+	}
+	return v
+}
+
+// Group, domain, and the domain for access control, of a node
+func rollupNodeNames(view *cacheView, node string) (string, string, string) {
+	if wv := view.workload(node); wv != nil {
+		group, domain := wv.learnedGroup, wv.domain
+		if group == "" {
+			group = node
+		}
+		if domain == "" {
+			return group, node, ""
+		}
+		return group, domain, domain
+	}
+	return node, node, ""
+}
+
+func rollupApply(c *rollupContrib, add bool) {
+	for i := 0; i < rollupLevels; i++ {
+		e, ok := rollupEdges[i][c.keys[i]]
+		if add {
+			if !ok {
+				e = &rollupEdge{fromDomain: c.fromDomain, toDomain: c.toDomain}
+				rollupEdges[i][c.keys[i]] = e
+			}
+			e.bytes += c.bytes
+			e.sessions += c.sessions
+			e.convers++
+			e.severity[c.severity]++
+			e.action[c.policyAction]++
+		} else if ok {
+			e.bytes -= c.bytes
+			e.sessions -= c.sessions
+			e.convers--
+			e.severity[c.severity]--
+			e.action[c.policyAction]--
+			if e.convers <= 0 {
+				delete(rollupEdges[i], c.keys[i])
+			}
+		}
+	}
+}
+
+// Update the rollup edges with the conversation from-to, after it's added, changed or deleted
+func rollupConversation(from, to string) {
+	key := rollupKey{from: from, to: to}
+	c, ok := rollupContribs[key]
+	if ok {
+		rollupApply(c, false)
+	}
+
+	var attr *graphAttr
+	if a := wlGraph.Attr(from, graphLink, to); a != nil {
+		attr = a.(*graphAttr)
+	}
+	if attr == nil {
+		if ok {
+			delete(rollupContribs, key)
+		}
+		return
+	}
+	if !ok {
+		c = &rollupContrib{}
+		rollupContribs[key] = c
+	}
+
+	// names are looked up every time, so a conversation added before its workload is known
+	// moves to the workload's group with its next update.
+	view := getCacheView()
+	fromGroup, fromDomain, fromAccDomain := rollupNodeNames(view, from)
+	toGroup, toDomain, toAccDomain := rollupNodeNames(view, to)
+	c.keys[rollupByGroup] = rollupKey{from: fromGroup, to: toGroup}
+	c.keys[rollupByDomain] = rollupKey{from: fromDomain, to: toDomain}
+	c.fromDomain, c.toDomain = fromAccDomain, toAccDomain
+	c.bytes, c.sessions = attr.bytes, attr.sessions
+	c.severity, c.policyAction = rollupValue(attr.severity), rollupValue(attr.policyAction)
+	rollupApply(c, true)
+}
+
+func cbRollupDeleteEdge(src, link, dst string) {
+	if link == graphLink {
+		rollupConversation(src, dst)
+	}
+}
+
+func rollupEdge2REST(key rollupKey, e *rollupEdge) *api.RESTConversationCompact {
+	var severity, action uint8
+	for v := rollupValues - 1; v > 0; v-- {
+		if e.severity[v] > 0 {
+			severity = uint8(v)
+			break
+		}
+	}
+	for v := rollupValues - 1; v > 0; v-- {
+		if e.action[v] > 0 {
+			action = uint8(v)
+			break
+		}
+	}
+
+	cr := &api.RESTConversationReport{Bytes: e.bytes, Sessions: e.sessions}
+	cr.PolicyAction = common.PolicyActionRESTString(action)
+	cr.Severity, _ = common.SeverityString(severity)
+	return &api.RESTConversationCompact{From: key.from, To: key.to, RESTConversationReport: cr}
+}
+
+// Conversations rolled up by group or by domain
+func (m CacheMethod) GetRollupConvers(view string, acc *access.AccessControl) []*api.RESTConversationCompact {
+	level := rollupByGroup
+	if view == api.QueryValueViewDomain {
+		level = rollupByDomain
+	}
+
+	graphMutexRLock()
+	defer graphMutexRUnlock()
+
+	convers := make([]*api.RESTConversationCompact, 0, len(rollupEdges[level]))
+	for key, e := range rollupEdges[level] {
+		// authorize as a conversation between endpoints of the edge's domains
+		from := &api.RESTConversationEndpoint{RESTWorkloadBrief: api.RESTWorkloadBrief{Domain: e.fromDomain}}
+		to := &api.RESTConversationEndpoint{RESTWorkloadBrief: api.RESTWorkloadBrief{Domain: e.toDomain}}
+		if !acc.Authorize(&api.RESTConversation{From: from, To: to}, nil) {
+			continue
+		}
+		convers = append(convers, rollupEdge2REST(key, e))
+	}
+	return convers
+}
@@ -0,0 +1,254 @@
+package cache
+
+import (
+	"crypto/sha256"
+	"encoding/hex"
+	"encoding/json"
+	"hash/fnv"
+	"sort"
+	"strconv"
+
+	log "github.com/sirupsen/logrus"
+
+	"github.com/neuvector/neuvector/controller/api"
+	"github.com/neuvector/neuvector/share"
+)
+
+// Fed network rules and groups, the largest fed rules types, are sent to a managed cluster as
+// the changes since the revision it has, when it asks for them. The master keeps the entry
+// hashes of the last revisions it served. The managed cluster builds the new content from its
+// own copy and the changes, and verifies it with the checksum of the master. Without the base
+// revision on the master, or when the checksum doesn't match, the type is sent in full.
+// The snapshots are protected by fedCacheMutex.
+
+const fedDeltaRevisions = 4
+
+type fedDeltaSnap struct {
+	revision uint64
+	hashes   map[string]uint64 // entry key: fnv64 of the entry's json
+	checksum string
+}
+
+var fedDeltaSnaps map[string][]*fedDeltaSnap = make(map[string][]*fedDeltaSnap)
+
+func fedDeltaReset() {
+	fedDeltaSnaps = make(map[string][]*fedDeltaSnap)
+}
+
+func fedEntryHash(v interface{}) uint64 {
+	data, _ := json.Marshal(v)
+	h := fnv.New64a()
+	h.Write(data)
+	return h.Sum64()
+}
+
+func fedRuleKey(id uint32) string {
+	return strconv.FormatUint(uint64(id), 10)
+}
+
+// The rules are taken in id order, the heads in their order
+func fedNetworkRulesChecksum(rules []*share.CLUSPolicyRule, heads []*share.CLUSRuleHead) string {
+	sorted := make([]*share.CLUSPolicyRule, len(rules))
+	copy(sorted, rules)
+	sort.Slice(sorted, func(i, j int) bool { return sorted[i].ID < sorted[j].ID })
+
+	h := sha256.New()
+	enc := json.NewEncoder(h)
+	_ = enc.Encode(sorted)
+	_ = enc.Encode(heads)
+	return hex.EncodeToString(h.Sum(nil))
+}
+
+// The groups are taken in name order
+func fedGroupsChecksum(groups []*share.CLUSGroup) string {
+	sorted := make([]*share.CLUSGroup, len(groups))
+	copy(sorted, groups)
+	sort.Slice(sorted, func(i, j int) bool { return sorted[i].Name < sorted[j].Name })
+
+	h := sha256.New()
+	_ = json.NewEncoder(h).Encode(sorted)
+	return hex.EncodeToString(h.Sum(nil))
+}
+
+func fedDeltaFind(ruleType string, revision uint64) *fedDeltaSnap {
+	for _, snap := range fedDeltaSnaps[ruleType] {
+		if snap.revision == revision {
+			return snap
+		}
+	}
+	return nil
+}
+
+func fedDeltaAdd(ruleType string, snap *fedDeltaSnap) {
+	snaps := append(fedDeltaSnaps[ruleType], snap)
+	if len(snaps) > fedDeltaRevisions {
+		snaps = snaps[len(snaps)-fedDeltaRevisions:]
+	}
+	fedDeltaSnaps[ruleType] = snaps
+}
+
+// Caller owns fedCacheMutexLock & cacheMutexRLock
+func fedNetworkRulesSnap(revision uint64, rules []*share.CLUSPolicyRule, heads []*share.CLUSRuleHead) *fedDeltaSnap {
+	if snap := fedDeltaFind(share.FedNetworkRulesType, revision); snap != nil {
+		return snap
+	}
+	snap := &fedDeltaSnap{revision: revision, hashes: make(map[string]uint64, len(rules))}
+	for _, rule := range rules {
+		snap.hashes[fedRuleKey(rule.ID)] = fedEntryHash(rule)
+	}
+	snap.checksum = fedNetworkRulesChecksum(rules, heads)
+	fedDeltaAdd(share.FedNetworkRulesType, snap)
+	return snap
+}
+
+// Caller owns fedCacheMutexLock & cacheMutexRLock
+func fedGroupsSnap(revision uint64, groups []*share.CLUSGroup) *fedDeltaSnap {
+	if snap := fedDeltaFind(share.FedGroupType, revision); snap != nil {
+		return snap
+	}
+	snap := &fedDeltaSnap{revision: revision, hashes: make(map[string]uint64, len(groups))}
+	for _, group := range groups {
+		snap.hashes[group.Name] = fedEntryHash(group)
+	}
+	snap.checksum = fedGroupsChecksum(groups)
+	fedDeltaAdd(share.FedGroupType, snap)
+	return snap
+}
+
+// Changes of the fed rules type from the base revision to the current one, nil if the base
+// revision is not kept. Caller owns fedCacheMutexLock & cacheMutexRLock.
+func (m CacheMethod) fedRulesDelta(ruleType string, baseRev, fedRev uint64) *api.RESTFedRulesDelta {
+	base := fedDeltaFind(ruleType, baseRev)
+
+	switch ruleType {
+	case share.FedNetworkRulesType:
+		rules, heads := m.GetFedNetworkRulesCache()
+		snap := fedNetworkRulesSnap(fedRev, rules, heads)
+		if base == nil {
+			return nil
+		}
+		delta := &api.RESTFedRulesDelta{BaseRevision: baseRev, Checksum: snap.checksum, RuleHeads: heads}
+		for _, rule := range rules {
+			key := fedRuleKey(rule.ID)
+			if hash, ok := base.hashes[key]; !ok || hash != snap.hashes[key] {
+				delta.Rules = append(delta.Rules, rule)
+			}
+		}
+		for key := range base.hashes {
+			if _, ok := snap.hashes[key]; !ok {
+				id, _ := strconv.ParseUint(key, 10, 32)
+				delta.DeletedRuleIDs = append(delta.DeletedRuleIDs, uint32(id))
+			}
+		}
+		return delta
+	case share.FedGroupType:
+		groups := m.GetFedGroupsCache()
+		snap := fedGroupsSnap(fedRev, groups)
+		if base == nil {
+			return nil
+		}
+		delta := &api.RESTFedRulesDelta{BaseRevision: baseRev, Checksum: snap.checksum}
+		for _, group := range groups {
+			if hash, ok := base.hashes[group.Name]; !ok || hash != snap.hashes[group.Name] {
+				delta.Groups = append(delta.Groups, group)
+			}
+		}
+		for name := range base.hashes {
+			if _, ok := snap.hashes[name]; !ok {
+				delta.DeletedGroups = append(delta.DeletedGroups, name)
+			}
+		}
+		return delta
+	}
+	return nil
+}
+
+// Called by managed clusters. Build the network rules and groups of the settings from the local
+// fed rules and the changes from the master. Returns the fed rules types that couldn't be built;
+// they must be polled in full.
+func (m CacheMethod) BuildFedRulesFromDeltas(settings *api.RESTFedRulesSettings, deltas map[string]*api.RESTFedRulesDelta,
+	fedRevs, localRevs map[string]uint64) []string {
+	var failed []string
+
+	cacheMutexRLock()
+	defer cacheMutexRUnlock()
+
+	for ruleType, delta := range deltas {
+		built := false
+		if delta != nil && delta.BaseRevision == localRevs[ruleType] {
+			switch ruleType {
+			case share.FedNetworkRulesType:
+				if data := m.buildFedNetworkRules(delta); data != nil {
+					data.Revision = fedRevs[ruleType]
+					settings.NetworkRulesData = data
+					built = true
+				}
+			case share.FedGroupType:
+				if data := m.buildFedGroups(delta); data != nil {
+					data.Revision = fedRevs[ruleType]
+					settings.GroupsData = data
+					built = true
+				}
+			}
+		}
+		if !built {
+			log.WithFields(log.Fields{"type": ruleType}).Info("fed rules changes not applicable, poll in full")
+			failed = append(failed, ruleType)
+		}
+	}
+	return failed
+}
+
+// caller owns cacheMutexRLock
+func (m CacheMethod) buildFedNetworkRules(delta *api.RESTFedRulesDelta) *share.CLUSFedNetworkRulesData {
+	local, _ := m.GetFedNetworkRulesCache()
+	ruleMap := make(map[uint32]*share.CLUSPolicyRule, len(local)+len(delta.Rules))
+	for _, rule := range local {
+		ruleMap[rule.ID] = rule
+	}
+	for _, id := range delta.DeletedRuleIDs {
+		delete(ruleMap, id)
+	}
+	for _, rule := range delta.Rules {
+		ruleMap[rule.ID] = rule
+	}
+
+	heads := delta.RuleHeads
+	if heads == nil {
+		heads = make([]*share.CLUSRuleHead, 0)
+	}
+	rules := make([]*share.CLUSPolicyRule, 0, len(heads))
+	for _, head := range heads {
+		if rule, ok := ruleMap[head.ID]; ok {
+			rules = append(rules, rule)
+		}
+	}
+	if len(rules) != len(ruleMap) || fedNetworkRulesChecksum(rules, heads) != delta.Checksum {
+		return nil
+	}
+	return &share.CLUSFedNetworkRulesData{Rules: rules, RuleHeads: heads}
+}
+
+// caller owns cacheMutexRLock
+func (m CacheMethod) buildFedGroups(delta *api.RESTFedRulesDelta) *share.CLUSFedGroupsData {
+	local := m.GetFedGroupsCache()
+	groupMap := make(map[string]*share.CLUSGroup, len(local)+len(delta.Groups))
+	for _, group := range local {
+		groupMap[group.Name] = group
+	}
+	for _, name := range delta.DeletedGroups {
+		delete(groupMap, name)
+	}
+	for _, group := range delta.Groups {
+		groupMap[group.Name] = group
+	}
+
+	groups := make([]*share.CLUSGroup, 0, len(groupMap))
+	for _, group := range groupMap {
+		groups = append(groups, group)
+	}
+	if fedGroupsChecksum(groups) != delta.Checksum {
+		return nil
+	}
+	return &share.CLUSFedGroupsData{Groups: groups}
+}
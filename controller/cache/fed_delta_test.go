@@ -0,0 +1,87 @@
+package cache
+
+import (
+	"testing"
+
+	"github.com/neuvector/neuvector/share"
+)
+
+func setFedNetworkRules(rules ...*share.CLUSPolicyRule) {
+	policyCache.ruleMap = make(map[uint32]*share.CLUSPolicyRule)
+	heads := make([]*share.CLUSRuleHead, 0, len(rules))
+	for _, rule := range rules {
+		policyCache.ruleMap[rule.ID] = rule
+		heads = append(heads, &share.CLUSRuleHead{ID: rule.ID, CfgType: share.FederalCfg})
+	}
+	policyCache.setRuleHeads(heads)
+}
+
+func TestFedNetworkRulesDelta(t *testing.T) {
+	preTest()
+	fedDeltaReset()
+
+	var m CacheMethod
+	r1 := &share.CLUSPolicyRule{ID: 100001, From: "fed.a", To: "fed.b", CfgType: share.FederalCfg}
+	r2 := &share.CLUSPolicyRule{ID: 100002, From: "fed.b", To: "fed.c", CfgType: share.FederalCfg}
+	r2new := &share.CLUSPolicyRule{ID: 100002, From: "fed.b", To: "fed.d", CfgType: share.FederalCfg}
+	r3 := &share.CLUSPolicyRule{ID: 100003, From: "fed.c", To: "fed.d", CfgType: share.FederalCfg}
+
+	// Revision 1 is served in full
+	setFedNetworkRules(r1, r2)
+	if delta := m.fedRulesDelta(share.FedNetworkRulesType, 0, 1); delta != nil {
+		t.Errorf("Unexpected delta without base revision: %+v", delta)
+	}
+
+	// Revision 2 changes r2, removes r1 and adds r3
+	setFedNetworkRules(r3, r2new)
+	delta := m.fedRulesDelta(share.FedNetworkRulesType, 1, 2)
+	if delta == nil || len(delta.Rules) != 2 || len(delta.DeletedRuleIDs) != 1 || delta.DeletedRuleIDs[0] != r1.ID {
+		t.Fatalf("Unexpected delta: %+v", delta)
+	}
+
+	// The managed cluster has revision 1
+	setFedNetworkRules(r1, r2)
+	data := m.buildFedNetworkRules(delta)
+	if data == nil || len(data.Rules) != 2 || data.Rules[0].ID != r3.ID || data.Rules[1].To != "fed.d" {
+		t.Errorf("Unexpected rules: %+v", data)
+	}
+
+	// The managed cluster doesn't have the base content
+	setFedNetworkRules(r1)
+	if data := m.buildFedNetworkRules(delta); data != nil {
+		t.Errorf("Rules should not be built from a different base: %+v", data)
+	}
+
+	setFedNetworkRules()
+	fedDeltaReset()
+	postTest()
+}
+
+func TestFedGroupsDelta(t *testing.T) {
+	preTest()
+	fedDeltaReset()
+
+	var m CacheMethod
+	groupCacheMap["fed.a"] = &groupCache{group: &share.CLUSGroup{Name: "fed.a", CfgType: share.FederalCfg}}
+	groupCacheMap["fed.b"] = &groupCache{group: &share.CLUSGroup{Name: "fed.b", CfgType: share.FederalCfg}}
+	m.fedRulesDelta(share.FedGroupType, 0, 1)
+
+	delete(groupCacheMap, "fed.a")
+	groupCacheMap["fed.c"] = &groupCache{group: &share.CLUSGroup{Name: "fed.c", CfgType: share.FederalCfg}}
+	delta := m.fedRulesDelta(share.FedGroupType, 1, 2)
+	if delta == nil || len(delta.Groups) != 1 || delta.Groups[0].Name != "fed.c" ||
+		len(delta.DeletedGroups) != 1 || delta.DeletedGroups[0] != "fed.a" {
+		t.Fatalf("Unexpected delta: %+v", delta)
+	}
+
+	// A group changed on the managed cluster fails the checksum
+	groupCacheMap["fed.b"] = &groupCache{group: &share.CLUSGroup{Name: "fed.b", Comment: "local", CfgType: share.FederalCfg}}
+	if data := m.buildFedGroups(delta); data != nil {
+		t.Errorf("Groups should not be built from a different base: %+v", data)
+	}
+
+	delete(groupCacheMap, "fed.b")
+	delete(groupCacheMap, "fed.c")
+	fedDeltaReset()
+	postTest()
+}
@@ -200,6 +200,7 @@ func fedConfigUpdate(nType cluster.ClusterNotifyType, key string, value []byte)
 				fedSystemConfigCache = share.CLUSSystemConfig{CfgType: share.FederalCfg}
 				cachedFedSettingsRev = nil
 				cachedFedSettingBytes = nil
+				fedDeltaReset()
 			}
 			fedMembershipCache = m
 			if m.FedRole == api.FedRoleNone {
@@ -270,6 +271,7 @@ func fedConfigUpdate(nType cluster.ClusterNotifyType, key string, value []byte)
 			fedRulesRevisionCache.Revisions = revCache.Revisions
 			if fedMembershipCache.FedRole != api.FedRoleMaster {
 				cachedFedSettingBytes = nil
+				fedDeltaReset()
 			}
 		case share.CLUSFedToPingPollSubKey:
 			if isLeader() {
@@ -537,6 +539,14 @@ func (m CacheMethod) SetFedJoinedClusterToken(id, mainSessionID, token string) {
 
 // only called by master cluster. caller doesn't own cache lock
 func (m CacheMethod) GetFedRules(reqRevs map[string]uint64, acc *access.AccessControl) ([]byte, map[string]uint64, error) {
+	settings, revs, _, err := m.GetFedRulesDeltas(reqRevs, nil, acc)
+	return settings, revs, err
+}
+
+// Same as GetFedRules(), the fed rules types of deltaTypes are returned as the changes since the
+// requested revisions when the base revisions are known. They are not in the settings.
+func (m CacheMethod) GetFedRulesDeltas(reqRevs map[string]uint64, deltaTypes []string, acc *access.AccessControl) (
+	[]byte, map[string]uint64, map[string]*api.RESTFedRulesDelta, error) {
 	askRevMap := make(map[string]uint64, len(reqRevs))
 
 	fedCacheMutexLock()
@@ -551,11 +561,34 @@ func (m CacheMethod) GetFedRules(reqRevs map[string]uint64, acc *access.AccessCo
 	}
 
 	// now askRevMap contains only those fed rules that the managed cluster misses
+	var deltas map[string]*api.RESTFedRulesDelta
+	fullRevMap := askRevMap
+	if len(deltaTypes) > 0 {
+		cacheMutexRLock()
+		for _, ruleType := range deltaTypes {
+			if fedRev, ok := askRevMap[ruleType]; ok {
+				if delta := m.fedRulesDelta(ruleType, reqRevs[ruleType], fedRev); delta != nil {
+					if deltas == nil {
+						deltas = make(map[string]*api.RESTFedRulesDelta)
+						fullRevMap = make(map[string]uint64, len(askRevMap))
+						for t, rev := range askRevMap {
+							fullRevMap[t] = rev
+						}
+					}
+					deltas[ruleType] = delta
+					delete(fullRevMap, ruleType)
+				}
+			}
+		}
+		cacheMutexRUnlock()
+	}
+
+	// fullRevMap contains the fed rules sent in full
 	var settings []byte
-	if len(askRevMap) > 0 {
+	if len(fullRevMap) > 0 {
 		useCache := true
-		if len(askRevMap) == len(cachedFedSettingsRev) {
-			for ruleType, rev := range askRevMap {
+		if len(fullRevMap) == len(cachedFedSettingsRev) {
+			for ruleType, rev := range fullRevMap {
 				if cacheRev, ok := cachedFedSettingsRev[ruleType]; !ok || rev != cacheRev {
 					useCache = false
 					break
@@ -570,7 +603,7 @@ func (m CacheMethod) GetFedRules(reqRevs map[string]uint64, acc *access.AccessCo
 		} else {
 			var current api.RESTFedRulesSettings
 			cacheMutexRLock()
-			for ruleType, fedRev := range askRevMap {
+			for ruleType, fedRev := range fullRevMap {
 				switch ruleType {
 				case share.FedAdmCtrlExceptRulesType, share.FedAdmCtrlDenyRulesType:
 					if current.AdmCtrlRulesData == nil {
@@ -580,8 +613,10 @@ func (m CacheMethod) GetFedRules(reqRevs map[string]uint64, acc *access.AccessCo
 				case share.FedNetworkRulesType:
 					current.NetworkRulesData = &share.CLUSFedNetworkRulesData{Revision: fedRev}
 					current.NetworkRulesData.Rules, current.NetworkRulesData.RuleHeads = m.GetFedNetworkRulesCache()
+					fedNetworkRulesSnap(fedRev, current.NetworkRulesData.Rules, current.NetworkRulesData.RuleHeads)
 				case share.FedGroupType:
 					current.GroupsData = &share.CLUSFedGroupsData{Revision: fedRev, Groups: m.GetFedGroupsCache()}
+					fedGroupsSnap(fedRev, current.GroupsData.Groups)
 				case share.FedResponseRulesType:
 					current.ResponseRulesData = &share.CLUSFedResponseRulesData{Revision: fedRev}
 					current.ResponseRulesData.Rules, current.ResponseRulesData.RuleHeads = m.GetFedResponseRulesCache()
@@ -605,12 +640,12 @@ func (m CacheMethod) GetFedRules(reqRevs map[string]uint64, acc *access.AccessCo
 
 			tempSettings := make([]byte, len(settings))
 			copy(tempSettings, settings)
-			cachedFedSettingsRev = askRevMap
+			cachedFedSettingsRev = fullRevMap
 			cachedFedSettingBytes = tempSettings
 		}
 	}
 
-	return settings, askRevMap, nil
+	return settings, askRevMap, deltas, nil
 }
 
 func (m CacheMethod) GetAllFedRulesRevisions() map[string]uint64 {
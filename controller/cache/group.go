@@ -479,6 +479,8 @@ func groupConfigUpdate(nType cluster.ClusterNotifyType, key string, value []byte
 				}
 			}
 			groupCacheMap[group.Name] = cache
+			markViewGroup(group.Name)
+			invalidateGroupMemberIndex()
 
 			// In case of group config change, remove old stuff
 			var adds, dels utils.Set
@@ -521,6 +523,8 @@ func groupConfigUpdate(nType cluster.ClusterNotifyType, key string, value []byte
 		} else {
 			refreshGroupMember(cache)
 			groupCacheMap[group.Name] = cache
+			markViewGroup(group.Name)
+			invalidateGroupMemberIndex()
 			//for imported empty group
 			if cache.members.Cardinality() == 0 && cacher.GetUnusedGroupAging() != 0 {
 				scheduleGroupRemoval(cache)
@@ -580,6 +584,7 @@ func groupConfigUpdate(nType cluster.ClusterNotifyType, key string, value []byte
 			}
 
 			delete(groupCacheMap, name)
+			markViewGroup(name)
 			refreshGroupMetricMap(name, "", true)
 		}
 		cacheMutexUnlock()
@@ -1105,6 +1110,7 @@ func rmEmptyGroupsFromCluster() {
 		if cg == nil {
 			log.WithFields(log.Fields{"group": name}).Error("Group doesn't exist in kv")
 			delete(groupCacheMap, name)
+			markViewGroup(name)
 		} else {
 			clusHelper.DeleteGroupTxn(txn, name)
 		}
@@ -1242,6 +1248,7 @@ func groupWorkloadLeave(id string, param interface{}) {
 	for _, cache := range groupCacheMap {
 		if cache.members.Contains(wl.ID) {
 			wlc.groups.Remove(cache.group.Name)
+			markViewWorkload(wlc.workload.ID)
 			cache.members.Remove(wl.ID)
 			if bHasGroupProfile && utils.IsCustomProfileGroup(cache.group.Name) {
 				dptCustomGrps.Add(cache.group.Name)
@@ -1330,10 +1337,12 @@ func addImageRelatedContainer2group(cache *groupCache, wlc *workloadCache) {
 			if pwlc, ok := wlCacheMap[wlc.workload.ShareNetNS]; ok {
 				cache.members.Add(pwlc.workload.ID)
 				pwlc.groups.Add(cache.group.Name)
+				markViewWorkload(pwlc.workload.ID)
 				for child := range pwlc.children.Iter() {
 					if childCache, ok1 := wlCacheMap[child.(string)]; ok1 {
 						cache.members.Add(childCache.workload.ID)
 						childCache.groups.Add(cache.group.Name)
+						markViewWorkload(childCache.workload.ID)
 					}
 				}
 			}
@@ -1342,6 +1351,7 @@ func addImageRelatedContainer2group(cache *groupCache, wlc *workloadCache) {
 				if childCache, ok := wlCacheMap[child.(string)]; ok {
 					cache.members.Add(childCache.workload.ID)
 					childCache.groups.Add(cache.group.Name)
+					markViewWorkload(childCache.workload.ID)
 				}
 			}
 		}
@@ -1362,6 +1372,7 @@ func groupWorkloadJoin(id string, param interface{}) {
 	if wlc.svcChanged != "" {
 		if cache, ok := groupCacheMap[wlc.svcChanged]; ok {
 			wlc.groups.Remove(wlc.svcChanged)
+			markViewWorkload(wlc.workload.ID)
 			cache.members.Remove(wl.ID)
 
 			log.WithFields(log.Fields{"group": cache.group.Name}).Debug("Leave learned group")
@@ -1398,6 +1409,7 @@ func groupWorkloadJoin(id string, param interface{}) {
 	} else {
 		if !cache.members.Contains(wl.ID) {
 			wlc.groups.Add(wlc.learnedGroupName)
+			markViewWorkload(wlc.workload.ID)
 			cache.members.Add(wl.ID)
 			memberUpdated = true
 			log.WithFields(log.Fields{"group": wlc.learnedGroupName}).Debug("Join group")
@@ -1405,14 +1417,14 @@ func groupWorkloadJoin(id string, param interface{}) {
 	}
 
 	// Join user defined group
-	for _, cache := range groupCacheMap {
-		if cache.group.CfgType == share.Learned {
-			continue
-		}
-
-		if share.IsGroupMember(cache.group, wlc.workload, getDomainData(wlc.workload.Domain)) {
+	domain := getDomainData(wlc.workload.Domain)
+	caches := grpMemberIndex.candidates(wlc.workload, domain)
+	match := matchGroupMembers(caches, wlc.workload, domain)
+	for i, cache := range caches {
+		if match[i] {
 			if !cache.members.Contains(wl.ID) {
 				wlc.groups.Add(cache.group.Name)
+				markViewWorkload(wlc.workload.ID)
 				cache.members.Add(wl.ID)
 				memberUpdated = true
 				log.WithFields(log.Fields{"group": cache.group.Name}).Debug("Join group")
@@ -1553,6 +1565,7 @@ func refreshGroupMember(cache *groupCache) {
 	for m := range cache.members.Iter() {
 		if wlc, ok := wlCacheMap[m.(string)]; ok {
 			wlc.groups.Remove(cache.group.Name)
+			markViewWorkload(wlc.workload.ID)
 		}
 	}
 
@@ -1612,6 +1625,7 @@ func refreshGroupMember(cache *groupCache) {
 		if share.IsGroupMember(cache.group, wlc.workload, getDomainData(wlc.workload.Domain)) {
 			cache.members.Add(wlc.workload.ID)
 			wlc.groups.Add(cache.group.Name)
+			markViewWorkload(wlc.workload.ID)
 			//NVSHAS-8136, container is selected based on image=xxx criteria, add related containers to group
 			addImageRelatedContainer2group(cache, wlc)
 
@@ -1925,6 +1939,7 @@ func (m CacheMethod) DeleteGroupCache(name string, acc *access.AccessControl) er
 			return err
 		}
 		delete(groupCacheMap, name)
+		markViewGroup(name)
 	}
 	cacheMutexUnlock()
 
@@ -2110,8 +2125,8 @@ func group2Service(gc *groupCache, view string, withCap bool) *api.RESTService {
 }
 
 func (m CacheMethod) IsGroupPolicyModeChangeable(name string) bool {
-	if cache, ok := groupCacheMap[name]; ok {
-		return cache.capChgMode
+	if gv := getCacheView().group(name); gv != nil {
+		return gv.capChgMode
 	}
 	return false
 }
@@ -2193,9 +2208,11 @@ func domainChange(domain share.CLUSDomain) {
 			if share.IsGroupMember(cache.group, wlc.workload, getDomainData(wlc.workload.Domain)) {
 				cache.members.Add(wlc.workload.ID)
 				wlc.groups.Add(cache.group.Name)
+				markViewWorkload(wlc.workload.ID)
 				dptLearnedGrpAdds.Add(wlc.learnedGroupName)
 			} else {
 				wlc.groups.Remove(cache.group.Name)
+				markViewWorkload(wlc.workload.ID)
 			}
 		}
 		cacheMutexUnlock()
@@ -0,0 +1,200 @@
+package cache
+
+import (
+	"runtime"
+	"strings"
+	"sync"
+
+	"github.com/neuvector/neuvector/share"
+)
+
+// Groups that a joining workload is checked against. A group whose criteria of one kind are
+// all positive exact matches, e.g. domain=billing or label app=redis, can only select a
+// workload with one of those values, so it is indexed by them; the others are always checked.
+// Groups that never select a workload are left out. The index is only a filter, the members
+// are still decided by share.IsGroupMember(); it is rebuilt when a group is added or
+// replaced, a removed group is skipped when it is looked up.
+
+const groupIndexSep = "\x00"
+
+// Type of criteria whose values are or'ed together, as in share.IsWorkloadSelected()
+func groupCriteriaKind(key string) string {
+	switch key {
+	case share.CriteriaKeyImage, share.CriteriaKeyHost, share.CriteriaKeyWorkload, share.CriteriaKeyService,
+		share.CriteriaKeyDomain, share.CriteriaKeyNamespace, share.CriteriaKeyAddress:
+		return key
+	}
+	if strings.HasPrefix(key, "ns:") {
+		return "ns-label"
+	}
+	return "pod-label"
+}
+
+func groupIndexToken(attr, value string) string {
+	return attr + groupIndexSep + value
+}
+
+// Workload attribute compared by a criterion
+func groupCriteriaAttr(key string) string {
+	switch key {
+	case share.CriteriaKeyDomain, share.CriteriaKeyNamespace:
+		return share.CriteriaKeyDomain
+	case share.CriteriaKeyImage, share.CriteriaKeyHost, share.CriteriaKeyWorkload, share.CriteriaKeyService:
+		return key
+	}
+	if strings.HasPrefix(key, "ns:") {
+		return key
+	}
+	return "pod:" + key
+}
+
+func workloadIndexTokens(wl *share.CLUSWorkload, domain *share.CLUSDomain) []string {
+	tokens := make([]string, 0, 5+len(wl.Labels))
+	tokens = append(tokens,
+		groupIndexToken(share.CriteriaKeyImage, wl.Image),
+		groupIndexToken(share.CriteriaKeyHost, wl.HostName),
+		groupIndexToken(share.CriteriaKeyWorkload, wl.Name),
+		groupIndexToken(share.CriteriaKeyService, wl.Service),
+		groupIndexToken(share.CriteriaKeyDomain, wl.Domain),
+	)
+	for k, v := range wl.Labels {
+		tokens = append(tokens, groupIndexToken("pod:"+k, v))
+	}
+	if domain != nil {
+		for k, v := range domain.Labels {
+			tokens = append(tokens, groupIndexToken("ns:"+k, v))
+		}
+	}
+	return tokens
+}
+
+// Tokens one of which a selected workload has, nil if the group can't be indexed.
+// never is true if the group can't select any workload.
+func groupIndexTokens(group *share.CLUSGroup) (tokens []string, never bool) {
+	if len(group.Criteria) == 0 {
+		return nil, true
+	}
+
+	kinds := make([]string, 0)
+	exact := make(map[string]bool)
+	for _, crt := range group.Criteria {
+		kind := groupCriteriaKind(crt.Key)
+		if kind == share.CriteriaKeyAddress {
+			// Address criteria doesn't match workload address
+			return nil, true
+		}
+		isExact := crt.Op == share.CriteriaOpEqual && crt.Value != share.CriteriaValueAny && !strings.ContainsAny(crt.Value, "?*")
+		if e, ok := exact[kind]; !ok {
+			kinds = append(kinds, kind)
+			exact[kind] = isExact
+		} else {
+			exact[kind] = e && isExact
+		}
+	}
+
+	for _, kind := range kinds {
+		if !exact[kind] {
+			continue
+		}
+		for _, crt := range group.Criteria {
+			if groupCriteriaKind(crt.Key) == kind {
+				tokens = append(tokens, groupIndexToken(groupCriteriaAttr(crt.Key), crt.Value))
+			}
+		}
+		return tokens, false
+	}
+	return nil, false
+}
+
+type groupMemberIndex struct {
+	dirty  bool
+	tokens map[string][]string // token -> group names
+	others []string
+}
+
+var grpMemberIndex = groupMemberIndex{dirty: true}
+
+// With cacheMutex hold, the group is added or replaced in groupCacheMap
+func invalidateGroupMemberIndex() {
+	grpMemberIndex.dirty = true
+}
+
+// With cacheMutex hold
+func (x *groupMemberIndex) rebuild() {
+	x.tokens = make(map[string][]string)
+	x.others = make([]string, 0)
+	for name, cache := range groupCacheMap {
+		tokens, never := groupIndexTokens(cache.group)
+		if never {
+			continue
+		} else if tokens == nil {
+			x.others = append(x.others, name)
+			continue
+		}
+		for _, token := range tokens {
+			x.tokens[token] = append(x.tokens[token], name)
+		}
+	}
+	x.dirty = false
+}
+
+// With cacheMutex hold, the user defined groups the workload can be a member of
+func (x *groupMemberIndex) candidates(wl *share.CLUSWorkload, domain *share.CLUSDomain) []*groupCache {
+	if x.dirty {
+		x.rebuild()
+	}
+
+	caches := make([]*groupCache, 0, len(x.others))
+	seen := make(map[string]bool)
+	add := func(name string) {
+		if seen[name] {
+			return
+		}
+		seen[name] = true
+		if cache, ok := groupCacheMap[name]; ok && cache.group.CfgType != share.Learned {
+			caches = append(caches, cache)
+		}
+	}
+	for _, name := range x.others {
+		add(name)
+	}
+	for _, token := range workloadIndexTokens(wl, domain) {
+		for _, name := range x.tokens[token] {
+			add(name)
+		}
+	}
+	return caches
+}
+
+// Candidates checked by one worker at least
+const groupMatchBatch = 64
+
+// With cacheMutex hold, whether the workload is a member of each group. The groups and the
+// workload are only read, so the check is spread over workers when there are many groups.
+func matchGroupMembers(caches []*groupCache, wl *share.CLUSWorkload, domain *share.CLUSDomain) []bool {
+	match := make([]bool, len(caches))
+
+	workers := (len(caches) + groupMatchBatch - 1) / groupMatchBatch
+	if cpus := runtime.NumCPU(); workers > cpus {
+		workers = cpus
+	}
+	if workers <= 1 {
+		for i, cache := range caches {
+			match[i] = share.IsGroupMember(cache.group, wl, domain)
+		}
+		return match
+	}
+
+	var wg sync.WaitGroup
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func(w int) {
+			for i := w; i < len(caches); i += workers {
+				match[i] = share.IsGroupMember(caches[i].group, wl, domain)
+			}
+			wg.Done()
+		}(w)
+	}
+	wg.Wait()
+	return match
+}
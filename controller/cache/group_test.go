@@ -259,3 +259,60 @@ func TestGroupPolicyMode(t *testing.T) {
 
 	postTest()
 }
+
+func TestGroupMemberIndex(t *testing.T) {
+	preTest()
+
+	groups := []*share.CLUSGroup{
+		{Name: "billing", CfgType: share.UserCreated, Criteria: []share.CLUSCriteriaEntry{
+			{Key: "image", Value: "redis*", Op: share.CriteriaOpEqual},
+			{Key: "domain", Value: "billing", Op: share.CriteriaOpEqual},
+		}},
+		{Name: "app", CfgType: share.UserCreated, Criteria: []share.CLUSCriteriaEntry{
+			{Key: "app", Value: "web", Op: share.CriteriaOpEqual},
+			{Key: "tier", Value: "front", Op: share.CriteriaOpEqual},
+		}},
+		{Name: "not-sales", CfgType: share.UserCreated, Criteria: []share.CLUSCriteriaEntry{
+			{Key: "domain", Value: "sales", Op: share.CriteriaOpNotEqual},
+		}},
+		{Name: "addr", CfgType: share.UserCreated, Criteria: []share.CLUSCriteriaEntry{
+			{Key: "address", Value: "1.2.3.4", Op: share.CriteriaOpEqual},
+		}},
+		{Name: "nv.redis.billing", CfgType: share.Learned, Criteria: []share.CLUSCriteriaEntry{
+			{Key: "domain", Value: "billing", Op: share.CriteriaOpEqual},
+		}},
+	}
+	groupCacheMap = make(map[string]*groupCache)
+	for _, g := range groups {
+		groupCacheMap[g.Name] = &groupCache{group: g}
+	}
+	invalidateGroupMemberIndex()
+
+	cases := []struct {
+		wl      *share.CLUSWorkload
+		expects []string
+	}{
+		{&share.CLUSWorkload{Image: "redis", Domain: "billing"}, []string{"billing", "not-sales"}},
+		{&share.CLUSWorkload{Image: "redis", Domain: "sales", Labels: map[string]string{"tier": "front"}}, []string{"app", "not-sales"}},
+		{&share.CLUSWorkload{Image: "redis", Domain: "sales"}, []string{"not-sales"}},
+	}
+	for _, c := range cases {
+		caches := grpMemberIndex.candidates(c.wl, nil)
+		names := make(map[string]bool)
+		for _, cache := range caches {
+			names[cache.group.Name] = true
+		}
+		if len(names) != len(c.expects) {
+			t.Errorf("Workload %+v: unexpected candidates %v, expect %v.", *c.wl, names, c.expects)
+		}
+		for _, name := range c.expects {
+			if !names[name] {
+				t.Errorf("Workload %+v: group %s is not a candidate.", *c.wl, name)
+			}
+		}
+	}
+
+	groupCacheMap = make(map[string]*groupCache)
+	invalidateGroupMemberIndex()
+	postTest()
+}
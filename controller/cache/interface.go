@@ -80,6 +80,7 @@ type CacheInterface interface {
 	GetConfigKvData(key string) ([]byte, bool)
 
 	GetAllPolicyRules(scope string, acc *access.AccessControl) []*api.RESTPolicyRule
+	GetPolicyRulesPage(scope string, acc *access.AccessControl, start, limit int) []*api.RESTPolicyRule
 	GetAllPolicyRulesCache(acc *access.AccessControl) []*share.CLUSPolicyRule
 	GetPolicyRuleCount(acc *access.AccessControl) int
 	GetPolicyRule(id uint32, acc *access.AccessControl) (*api.RESTPolicyRule, error)
@@ -98,6 +99,7 @@ type CacheInterface interface {
 	GetConverEndpoint(name string, acc *access.AccessControl) (*api.RESTConversationEndpoint, error)
 	GetAllConverEndpoints(view string, acc *access.AccessControl) []*api.RESTConversationEndpoint
 	GetAllApplicationConvers(groupFilter, domainFilter string, acc *access.AccessControl) ([]*api.RESTConversationCompact, []*api.RESTConversationEndpoint)
+	GetRollupConvers(view string, acc *access.AccessControl) []*api.RESTConversationCompact
 	GetApplicationConver(src, dst string, srcList, dstList []string, acc *access.AccessControl) (*api.RESTConversationDetail, error)
 
 	GetIP2WorkloadMap(hostID string) []*api.RESTDebugIP2Workload
@@ -153,6 +155,8 @@ type CacheInterface interface {
 	GetScanStatus(acc *access.AccessControl) (*api.RESTScanStatus, error)
 	GetScanPlatformSummary(acc *access.AccessControl) (*api.RESTScanPlatformSummary, error)
 	GetVulnerabilityReport(id string, showTag string) ([]*api.RESTVulnerability, []*api.RESTScanModule, error)
+	GetScanImageSummaries(acc *access.AccessControl) map[string]*api.RESTScanImageSummary
+	GetScanImageWorkload(imageID string, acc *access.AccessControl) string
 
 	// Compliance
 	GetComplianceProfile(name string, acc *access.AccessControl) (*api.RESTComplianceProfile, map[string][]string, error)
@@ -201,6 +205,8 @@ type CacheInterface interface {
 	GetFedMembershipRoleNoAuth() string
 	SetFedJoinedClusterToken(id, mainSessionID, token string)
 	GetFedRules(reqRevs map[string]uint64, acc *access.AccessControl) ([]byte, map[string]uint64, error)
+	GetFedRulesDeltas(reqRevs map[string]uint64, deltaTypes []string, acc *access.AccessControl) ([]byte, map[string]uint64, map[string]*api.RESTFedRulesDelta, error)
+	BuildFedRulesFromDeltas(settings *api.RESTFedRulesSettings, deltas map[string]*api.RESTFedRulesDelta, fedRevs, localRevs map[string]uint64) []string
 	GetAllFedRulesRevisions() map[string]uint64
 	GetFedSettings() share.CLUSFedSettings
 	GetFedScanResult(reqRegConfigRev uint64, reqScanResultHash map[string]map[string]string, reqIgnoreRegs, reqUpToDateRegs []string, fedRegs utils.Set) (api.RESTPollFedScanDataResp, bool)
@@ -452,6 +452,7 @@ func addConnectToGraph(conn *share.CLUSConnection, ca, sa *nodeAttr, stip *serve
 	}
 
 	wlGraph.AddLink(conn.ClientWL, graphLink, conn.ServerWL, attr)
+	rollupConversation(conn.ClientWL, conn.ServerWL)
 }
 
 /*--------------------------------------------------------------*/
@@ -965,8 +966,12 @@ func procLearnedPolicy(updateCluster bool) int {
 		txn := cluster.Transact()
 		defer txn.Close()
 
+		var crs map[uint32]*share.CLUSPolicyRule
+		if len(modifyList) >= learnedRuleListMin {
+			crs = clusHelper.GetPolicyRules()
+		}
 		for _, rule := range modifyList {
-			cr, _ := clusHelper.GetPolicyRule(rule.ID)
+			cr := getLearnedClusterRule(crs, rule.ID)
 			if cr != nil {
 				cr.Applications = rule.Applications
 				cr.Ports = rule.Ports
@@ -1035,6 +1040,19 @@ func procLearnedPolicy(updateCluster bool) int {
 
 var policyProcReturn int = 0
 
+// Rules written back by a learning pass are read from the cluster with one list of the
+// policy store, instead of one read each, when there are at least this many
+const learnedRuleListMin = 32
+
+// crs is from GetPolicyRules(), nil if the rules are read one by one
+func getLearnedClusterRule(crs map[uint32]*share.CLUSPolicyRule, id uint32) *share.CLUSPolicyRule {
+	if crs != nil {
+		return crs[id]
+	}
+	cr, _ := clusHelper.GetPolicyRule(id)
+	return cr
+}
+
 func syncLearnedPolicyToCluster() int {
 	log.Debug("")
 
@@ -1052,11 +1070,15 @@ func syncLearnedPolicyToCluster() int {
 
 	var lprWrapperMapById map[uint32]bool = make(map[uint32]bool)
 	var addList []*share.CLUSPolicyRule
+	var crs map[uint32]*share.CLUSPolicyRule
+	if len(lprWrapperMap) >= learnedRuleListMin {
+		crs = clusHelper.GetPolicyRules()
+	}
 
 	for pair, rw := range lprWrapperMap {
 		lpr := &rw.rule
 		lprWrapperMapById[rw.id] = true
-		cr, _ := clusHelper.GetPolicyRule(rw.id)
+		cr := getLearnedClusterRule(crs, rw.id)
 		if cr != nil {
 			if len(cr.Applications) > 0 {
 				if !cmpLearnedApps(cr.Applications, lpr.objs) {
@@ -1213,6 +1235,7 @@ func cbDeleteNode(node string) {
 func startPolicyThread() {
 	wlGraph = graph.NewGraph()
 	wlGraph.RegisterDelNodeHook(cbDeleteNode)
+	wlGraph.RegisterDelEdgeHook(cbRollupDeleteEdge)
 	// NOTE.1: The following way to detect if a service group has external connections is efficient but logic
 	// need to be fine tuned. Links can be created before the workload is discovered (sync from the lead),
 	// or deleted after the workload is gone.
@@ -1220,6 +1243,7 @@ func startPolicyThread() {
 	// wlGraph.RegisterDelLinkHook(cbDeleteLink)
 
 	lprWrapperMap = make(map[groupPair]*learnedPolicyRuleWrapper)
+	initNotifiers()
 	policyProcTimer = time.NewTimer(policyProcDelayIdle)
 	policyProcTimer.Stop()
 	policyCalculatingTimer = time.NewTimer(policyCalculatingDelaySlow)
@@ -1456,11 +1480,11 @@ func syncGraphTx() *syncDataMsg {
 
 	all := wlGraph.All()
 	nodes := make([]*graphSyncNodeData, all.Cardinality())
-	for n := range all.Iter() {
-		if n.(string) == dummyEP {
+	for _, n := range all.Items() {
+		if n == dummyEP {
 			continue
 		}
-		node := graphSyncNodeData{Name: n.(string)}
+		node := graphSyncNodeData{Name: n}
 		if a := wlGraph.Attr(node.Name, attrLink, dummyEP); a != nil {
 			attr := a.(*nodeAttr)
 			node.External = attr.external
@@ -1521,8 +1545,11 @@ func syncGraphTx() *syncDataMsg {
 	}
 
 	var violations []*api.Violation
-	if curVioIndex > 0 {
-		violations = vioCache[0:curVioIndex]
+	if vioRing.count() > 0 {
+		violations = make([]*api.Violation, vioRing.count())
+		for i := range violations {
+			violations[i] = vioCache[vioRing.oldest(i)]
+		}
 	}
 
 	learnedRules := make([]*graphSyncLearnedRule, 0, len(lprWrapperMap))
@@ -1576,6 +1603,7 @@ func syncGraphRx(msg *syncDataMsg) int {
 			}).Info()
 
 			wlGraph.Reset()
+			rollupReset()
 			renameMap := make(map[string]string)
 
 			for _, node := range gd.Nodes {
@@ -1645,14 +1673,20 @@ func syncGraphRx(msg *syncDataMsg) int {
 					}
 
 					wlGraph.AddLink(from, graphLink, to, &a)
+					rollupConversation(from, to)
 				}
 			}
 
-			curVioIndex = len(gd.Vios)
-			for i, vio := range gd.Vios {
+			vios := gd.Vios
+			if len(vios) > logCacheSize {
+				vios = vios[len(vios)-logCacheSize:]
+			}
+			vioRing.reset(len(vios))
+			for i, vio := range vios {
 				vio.Level = api.UpgradeLogLevel(vio.Level)
 				vioCache[i] = vio
 			}
+			rebuildViolationIndex()
 
 			maxLearnRuleID = gd.MaxLearnRuleID
 			//after sync clear active rule id list
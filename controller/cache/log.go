@@ -57,25 +57,28 @@ type logConnect struct {
 }
 
 var activityCache []*api.Event = make([]*api.Event, logCacheSize)
-var curActivityIndex int = 0
+var activityRing logRing = newLogRing(logCacheSize)
 var eventCache []*api.Event = make([]*api.Event, logCacheSize)
-var curEventIndex int = 0
+var eventRing logRing = newLogRing(logCacheSize)
 var thrtMap map[string]*api.Threat = make(map[string]*api.Threat)
 var thrtCache []*api.Threat = make([]*api.Threat, logCacheSize)
-var curThrtIndex int = 0
+var thrtRing logRing = newLogRing(logCacheSize)
+var thrtGroupIndex logIndex = make(logIndex)
 var vioCache []*api.Violation = make([]*api.Violation, logCacheSize)
-var curVioIndex int = 0
+var vioRing logRing = newLogRing(logCacheSize)
+var vioServiceIndex logIndex = make(logIndex) // by client and server service
 var incidentCache []*api.Incident = make([]*api.Incident, logCacheSize)
-var curIncidentIndex int = 0
+var incidentRing logRing = newLogRing(logCacheSize)
+var incidentGroupIndex logIndex = make(logIndex)
 var auditCache []*api.Audit = make([]*api.Audit, logCacheSize)
-var curAuditIndex int = 0
+var auditRing logRing = newLogRing(logCacheSize)
 
 // This is currently used to record policy voilation logs. It's not really a traffic log,
 // but an aggregated record.
 func (m CacheMethod) GetViolations(acc *access.AccessControl) []*api.Violation {
 	logs := make([]*api.Violation, 0)
-	for i := 0; i < curVioIndex; i++ {
-		vio := vioCache[curVioIndex-i-1]
+	for i := 0; i < vioRing.count(); i++ {
+		vio := vioCache[vioRing.newest(i)]
 		if !acc.Authorize(vio, nil) {
 			continue
 		}
@@ -87,11 +90,11 @@ func (m CacheMethod) GetViolations(acc *access.AccessControl) []*api.Violation {
 
 func (m CacheMethod) GetViolationCount(acc *access.AccessControl) int {
 	if acc.HasGlobalPermissions(share.PERM_SECURITY_EVENTS_BASIC, 0) {
-		return curVioIndex
+		return vioRing.count()
 	} else {
 		var count int
-		for i := 0; i < curVioIndex; i++ {
-			vio := vioCache[curVioIndex-i-1]
+		for i := 0; i < vioRing.count(); i++ {
+			vio := vioCache[vioRing.newest(i)]
 			if !acc.Authorize(vio, nil) {
 				continue
 			}
@@ -105,8 +108,8 @@ func (m CacheMethod) GetActivities(acc *access.AccessControl) []*api.Event {
 	users := clusHelper.GetAllUsers(acc)
 
 	logs := make([]*api.Event, 0)
-	for i := 0; i < curActivityIndex; i++ {
-		ev := activityCache[curActivityIndex-i-1]
+	for i := 0; i < activityRing.count(); i++ {
+		ev := activityCache[activityRing.newest(i)]
 		if !acc.Authorize(ev, func(u string) share.AccessObject {
 			if user, ok := users[u]; ok {
 				return user
@@ -124,13 +127,13 @@ func (m CacheMethod) GetActivities(acc *access.AccessControl) []*api.Event {
 
 func (m CacheMethod) GetActivityCount(acc *access.AccessControl) int {
 	if acc.HasGlobalPermissions(share.PERM_EVENTS, 0) {
-		return curActivityIndex
+		return activityRing.count()
 	} else {
 		users := clusHelper.GetAllUsers(acc)
 
 		var count int
-		for i := 0; i < curActivityIndex; i++ {
-			ev := activityCache[curActivityIndex-i-1]
+		for i := 0; i < activityRing.count(); i++ {
+			ev := activityCache[activityRing.newest(i)]
 			if !acc.Authorize(ev, func(u string) share.AccessObject {
 				if user, ok := users[u]; ok {
 					return user
@@ -151,8 +154,8 @@ func (m CacheMethod) GetEvents(caller string, acc *access.AccessControl) []*api.
 	users := clusHelper.GetAllUsers(acc)
 
 	logs := make([]*api.Event, 0)
-	for i := 0; i < curEventIndex; i++ {
-		ev := eventCache[curEventIndex-i-1]
+	for i := 0; i < eventRing.count(); i++ {
+		ev := eventCache[eventRing.newest(i)]
 		if !acc.Authorize(ev, func(u string) share.AccessObject {
 			if user, ok := users[u]; ok {
 				return user
@@ -173,13 +176,13 @@ func (m CacheMethod) GetEvents(caller string, acc *access.AccessControl) []*api.
 func (m CacheMethod) GetEventCount(caller string, acc *access.AccessControl) int {
 	// caller being "" means follow permission only
 	if acc.HasGlobalPermissions(share.PERM_EVENTS, 0) {
-		return curEventIndex
+		return eventRing.count()
 	} else {
 		users := clusHelper.GetAllUsers(acc)
 
 		var count int
-		for i := 0; i < curEventIndex; i++ {
-			ev := eventCache[curEventIndex-i-1]
+		for i := 0; i < eventRing.count(); i++ {
+			ev := eventCache[eventRing.newest(i)]
 			if !acc.Authorize(ev, func(u string) share.AccessObject {
 				if user, ok := users[u]; ok {
 					return user
@@ -199,8 +202,8 @@ func (m CacheMethod) GetEventCount(caller string, acc *access.AccessControl) int
 
 func (m CacheMethod) GetThreats(acc *access.AccessControl) []*api.Threat {
 	logs := make([]*api.Threat, 0)
-	for i := 0; i < curThrtIndex; i++ {
-		thrt := thrtCache[curThrtIndex-i-1]
+	for i := 0; i < thrtRing.count(); i++ {
+		thrt := thrtCache[thrtRing.newest(i)]
 		if !acc.Authorize(thrt, nil) {
 			continue
 		}
@@ -222,11 +225,11 @@ func (m CacheMethod) GetThreat(id string, acc *access.AccessControl) (*api.Threa
 
 func (m CacheMethod) GetThreatCount(acc *access.AccessControl) int {
 	if acc.HasGlobalPermissions(share.PERM_SECURITY_EVENTS_BASIC, 0) {
-		return curThrtIndex
+		return thrtRing.count()
 	} else {
 		var count int
-		for i := 0; i < curThrtIndex; i++ {
-			thrt := thrtCache[curThrtIndex-i-1]
+		for i := 0; i < thrtRing.count(); i++ {
+			thrt := thrtCache[thrtRing.newest(i)]
 			if !acc.Authorize(thrt, nil) {
 				continue
 			}
@@ -238,8 +241,8 @@ func (m CacheMethod) GetThreatCount(acc *access.AccessControl) int {
 
 func (m CacheMethod) GetIncidents(acc *access.AccessControl) []*api.Incident {
 	logs := make([]*api.Incident, 0)
-	for i := 0; i < curIncidentIndex; i++ {
-		incd := incidentCache[curIncidentIndex-i-1]
+	for i := 0; i < incidentRing.count(); i++ {
+		incd := incidentCache[incidentRing.newest(i)]
 		if !acc.Authorize(incd, nil) {
 			continue
 		}
@@ -251,11 +254,11 @@ func (m CacheMethod) GetIncidents(acc *access.AccessControl) []*api.Incident {
 
 func (m CacheMethod) GetIncidentCount(acc *access.AccessControl) int {
 	if acc.HasGlobalPermissions(share.PERM_SECURITY_EVENTS_BASIC, 0) {
-		return curIncidentIndex
+		return incidentRing.count()
 	} else {
 		var count int
-		for i := 0; i < curIncidentIndex; i++ {
-			incd := incidentCache[curIncidentIndex-i-1]
+		for i := 0; i < incidentRing.count(); i++ {
+			incd := incidentCache[incidentRing.newest(i)]
 			if !acc.Authorize(incd, nil) {
 				continue
 			}
@@ -269,8 +272,8 @@ func (m CacheMethod) GetAudits(acc *access.AccessControl) []*api.Audit {
 	syncRLock(syncCatgAuditIdx)
 	defer syncRUnlock(syncCatgAuditIdx)
 	logs := make([]*api.Audit, 0)
-	for i := 0; i < curAuditIndex; i++ {
-		incd := auditCache[curAuditIndex-i-1]
+	for i := 0; i < auditRing.count(); i++ {
+		incd := auditCache[auditRing.newest(i)]
 		if !acc.Authorize(incd, nil) {
 			continue
 		}
@@ -285,11 +288,11 @@ func (m CacheMethod) GetAuditCount(acc *access.AccessControl) int {
 	defer syncRUnlock(syncCatgAuditIdx)
 
 	if acc.HasGlobalPermissions(share.PERM_AUDIT_EVENTS, 0) {
-		return curAuditIndex
+		return auditRing.count()
 	} else {
 		var count int
-		for i := 0; i < curAuditIndex; i++ {
-			incd := auditCache[curAuditIndex-i-1]
+		for i := 0; i < auditRing.count(); i++ {
+			incd := auditCache[auditRing.newest(i)]
 			if !acc.Authorize(incd, nil) {
 				continue
 			}
@@ -299,67 +302,96 @@ func (m CacheMethod) GetAuditCount(acc *access.AccessControl) int {
 	}
 }
 
+func vioIndexAdd(vio *api.Violation, seq uint64) {
+	vioServiceIndex.add(vio.ClientService, seq)
+	if vio.ServerService != vio.ClientService {
+		vioServiceIndex.add(vio.ServerService, seq)
+	}
+}
+
+func vioIndexRemove(vio *api.Violation, seq uint64) {
+	vioServiceIndex.remove(vio.ClientService, seq)
+	if vio.ServerService != vio.ClientService {
+		vioServiceIndex.remove(vio.ServerService, seq)
+	}
+}
+
 func recordViolation(rlog *api.Violation) {
 	log.WithFields(log.Fields{"client": rlog.ClientName, "server": rlog.ServerName}).Debug("")
 
-	if curVioIndex == logCacheSize {
-		_, vioCache = vioCache[0], vioCache[1:]
-		vioCache = append(vioCache, rlog)
-	} else {
-		vioCache[curVioIndex] = rlog
-		curVioIndex++
+	slot, seq, evicted := vioRing.push()
+	if evicted && vioCache[slot] != nil {
+		vioIndexRemove(vioCache[slot], seq-uint64(logCacheSize))
+	}
+	vioCache[slot] = rlog
+	vioIndexAdd(rlog, seq)
+}
+
+// The violations of the cache were replaced, by a sync
+func rebuildViolationIndex() {
+	vioServiceIndex = make(logIndex)
+	for i := 0; i < vioRing.count(); i++ {
+		if vio := vioCache[vioRing.oldest(i)]; vio != nil {
+			vioIndexAdd(vio, vioRing.first+uint64(i))
+		}
 	}
 }
 
 func recordActivity(rlog *api.Event) {
 	log.WithFields(log.Fields{"name": rlog.Name}).Debug("")
 
-	if curActivityIndex == logCacheSize {
-		_, activityCache = activityCache[0], activityCache[1:]
-		activityCache = append(activityCache, rlog)
-	} else {
-		activityCache[curActivityIndex] = rlog
-		curActivityIndex++
-	}
+	slot, _, _ := activityRing.push()
+	activityCache[slot] = rlog
 }
 
 func recordEvent(rlog *api.Event) {
 	log.WithFields(log.Fields{"name": rlog.Name}).Debug("")
 
-	if curEventIndex == logCacheSize {
-		_, eventCache = eventCache[0], eventCache[1:]
-		eventCache = append(eventCache, rlog)
-	} else {
-		eventCache[curEventIndex] = rlog
-		curEventIndex++
-	}
+	slot, _, _ := eventRing.push()
+	eventCache[slot] = rlog
 }
 
 func recordIncident(rlog *api.Incident) {
 	log.WithFields(log.Fields{"name": rlog.Name}).Debug("")
 
-	if curIncidentIndex == logCacheSize {
-		_, incidentCache = incidentCache[0], incidentCache[1:]
-		incidentCache = append(incidentCache, rlog)
-	} else {
-		incidentCache[curIncidentIndex] = rlog
-		curIncidentIndex++
+	slot, seq, evicted := incidentRing.push()
+	if evicted && incidentCache[slot] != nil {
+		incidentGroupIndex.remove(incidentCache[slot].Group, seq-uint64(logCacheSize))
+	}
+	incidentCache[slot] = rlog
+	incidentGroupIndex.add(rlog.Group, seq)
+}
+
+// The incidents of the cache were replaced, by a sync
+func rebuildIncidentIndex() {
+	incidentGroupIndex = make(logIndex)
+	for i := 0; i < incidentRing.count(); i++ {
+		if incd := incidentCache[incidentRing.oldest(i)]; incd != nil {
+			incidentGroupIndex.add(incd.Group, incidentRing.first+uint64(i))
+		}
 	}
 }
 
 func recordThreat(rlog *api.Threat) {
 	log.WithFields(log.Fields{"name": rlog.Name}).Debug("")
 
-	if curThrtIndex == logCacheSize {
-		var pop *api.Threat
-		pop, thrtCache = thrtCache[0], thrtCache[1:]
-		thrtCache = append(thrtCache, rlog)
+	slot, seq, evicted := thrtRing.push()
+	if pop := thrtCache[slot]; evicted && pop != nil {
 		delete(thrtMap, pop.ID)
-		thrtMap[rlog.ID] = rlog
-	} else {
-		thrtCache[curThrtIndex] = rlog
-		thrtMap[rlog.ID] = rlog
-		curThrtIndex++
+		thrtGroupIndex.remove(pop.Group, seq-uint64(logCacheSize))
+	}
+	thrtCache[slot] = rlog
+	thrtMap[rlog.ID] = rlog
+	thrtGroupIndex.add(rlog.Group, seq)
+}
+
+// The threats of the cache were replaced, by a sync
+func rebuildThreatIndex() {
+	thrtGroupIndex = make(logIndex)
+	for i := 0; i < thrtRing.count(); i++ {
+		if thrt := thrtCache[thrtRing.oldest(i)]; thrt != nil {
+			thrtGroupIndex.add(thrt.Group, thrtRing.first+uint64(i))
+		}
 	}
 }
 
@@ -367,13 +399,8 @@ func recordAudit(rlog *api.Audit) {
 	log.WithFields(log.Fields{"name": rlog.Name, "level": rlog.Level}).Debug("")
 
 	auditSuppressSetIdRpts(rlog)
-	if curAuditIndex == logCacheSize {
-		_, auditCache = auditCache[0], auditCache[1:]
-		auditCache = append(auditCache, rlog)
-	} else {
-		auditCache[curAuditIndex] = rlog
-		curAuditIndex++
-	}
+	slot, _, _ := auditRing.push()
+	auditCache[slot] = rlog
 }
 
 func getWebhookCache(ruleID int, whName string) *webhookCache {
@@ -1228,8 +1255,11 @@ func syncActivityTx() *syncDataMsg {
 
 	// Use event sync lock for both event and activity
 	syncLock(syncCatgEventIdx)
-	if curActivityIndex > 0 {
-		acts := activityCache[0:curActivityIndex]
+	if activityRing.count() > 0 {
+		acts := make([]*api.Event, activityRing.count())
+		for i := range acts {
+			acts[i] = activityCache[activityRing.oldest(i)]
+		}
 		msg.Data, _ = json.Marshal(acts)
 	}
 	msg.ModifyIdx = getModifyIdx(syncCatgEventIdx)
@@ -1241,8 +1271,11 @@ func syncEventTx() *syncDataMsg {
 	msg := syncDataMsg{CatgName: syncCatgEvent}
 
 	syncLock(syncCatgEventIdx)
-	if curEventIndex > 0 {
-		events := eventCache[0:curEventIndex]
+	if eventRing.count() > 0 {
+		events := make([]*api.Event, eventRing.count())
+		for i := range events {
+			events[i] = eventCache[eventRing.oldest(i)]
+		}
 		msg.Data, _ = json.Marshal(events)
 	}
 	msg.ModifyIdx = getModifyIdx(syncCatgEventIdx)
@@ -1253,8 +1286,11 @@ func syncEventTx() *syncDataMsg {
 func syncThreatTx() *syncDataMsg {
 	msg := syncDataMsg{CatgName: syncCatgThreat}
 	syncLock(syncCatgThreatIdx)
-	if curThrtIndex > 0 {
-		threats := thrtCache[0:curThrtIndex]
+	if thrtRing.count() > 0 {
+		threats := make([]*api.Threat, thrtRing.count())
+		for i := range threats {
+			threats[i] = thrtCache[thrtRing.oldest(i)]
+		}
 		msg.Data, _ = json.Marshal(threats)
 	}
 	msg.ModifyIdx = getModifyIdx(syncCatgThreatIdx)
@@ -1265,8 +1301,11 @@ func syncThreatTx() *syncDataMsg {
 func syncIncidentTx() *syncDataMsg {
 	msg := syncDataMsg{CatgName: syncCatgIncident}
 	syncLock(syncCatgIncidentIdx)
-	if curIncidentIndex > 0 {
-		incidents := incidentCache[0:curIncidentIndex]
+	if incidentRing.count() > 0 {
+		incidents := make([]*api.Incident, incidentRing.count())
+		for i := range incidents {
+			incidents[i] = incidentCache[incidentRing.oldest(i)]
+		}
 		msg.Data, _ = json.Marshal(incidents)
 	}
 	msg.ModifyIdx = getModifyIdx(syncCatgIncidentIdx)
@@ -1277,8 +1316,11 @@ func syncIncidentTx() *syncDataMsg {
 func syncAuditTx() *syncDataMsg {
 	msg := syncDataMsg{CatgName: syncCatgAudit}
 	syncLock(syncCatgAuditIdx)
-	if curAuditIndex > 0 {
-		audits := auditCache[0:curAuditIndex]
+	if auditRing.count() > 0 {
+		audits := make([]*api.Audit, auditRing.count())
+		for i := range audits {
+			audits[i] = auditCache[auditRing.oldest(i)]
+		}
 		msg.Data, _ = json.Marshal(audits)
 	}
 	msg.ModifyIdx = getModifyIdx(syncCatgAuditIdx)
@@ -1303,14 +1345,17 @@ func syncActivityRx(msg *syncDataMsg) int {
 			syncUnlock(syncCatgEventIdx)
 			return syncRxErrorFailed
 		} else {
-			curActivityIndex = len(acts)
+			if len(acts) > logCacheSize {
+				acts = acts[len(acts)-logCacheSize:]
+			}
+			activityRing.reset(len(acts))
 			for i, act := range acts {
 				act.Level = api.UpgradeLogLevel(act.Level)
 				activityCache[i] = act
 			}
 		}
 	} else {
-		curActivityIndex = 0
+		activityRing.reset(0)
 	}
 	setModifyIdx(syncCatgEventIdx, msg.ModifyIdx)
 	syncUnlock(syncCatgEventIdx)
@@ -1333,14 +1378,17 @@ func syncEventRx(msg *syncDataMsg) int {
 			syncUnlock(syncCatgEventIdx)
 			return syncRxErrorFailed
 		} else {
-			curEventIndex = len(events)
+			if len(events) > logCacheSize {
+				events = events[len(events)-logCacheSize:]
+			}
+			eventRing.reset(len(events))
 			for i, evt := range events {
 				evt.Level = api.UpgradeLogLevel(evt.Level)
 				eventCache[i] = evt
 			}
 		}
 	} else {
-		curEventIndex = 0
+		eventRing.reset(0)
 	}
 	setModifyIdx(syncCatgEventIdx, msg.ModifyIdx)
 	syncUnlock(syncCatgEventIdx)
@@ -1363,7 +1411,10 @@ func syncThreatRx(msg *syncDataMsg) int {
 			syncUnlock(syncCatgThreatIdx)
 			return syncRxErrorFailed
 		} else {
-			curThrtIndex = len(threats)
+			if len(threats) > logCacheSize {
+				threats = threats[len(threats)-logCacheSize:]
+			}
+			thrtRing.reset(len(threats))
 			thrtMap = make(map[string]*api.Threat)
 			for i, thrt := range threats {
 				thrt.Level = api.UpgradeLogLevel(thrt.Level)
@@ -1372,8 +1423,9 @@ func syncThreatRx(msg *syncDataMsg) int {
 			}
 		}
 	} else {
-		curThrtIndex = 0
+		thrtRing.reset(0)
 	}
+	rebuildThreatIndex()
 	setModifyIdx(syncCatgThreatIdx, msg.ModifyIdx)
 	syncUnlock(syncCatgThreatIdx)
 	return syncRxErrorNone
@@ -1395,15 +1447,19 @@ func syncIncidentRx(msg *syncDataMsg) int {
 			syncUnlock(syncCatgIncidentIdx)
 			return syncRxErrorFailed
 		} else {
-			curIncidentIndex = len(incidents)
+			if len(incidents) > logCacheSize {
+				incidents = incidents[len(incidents)-logCacheSize:]
+			}
+			incidentRing.reset(len(incidents))
 			for i, incd := range incidents {
 				incd.Level = api.UpgradeLogLevel(incd.Level)
 				incidentCache[i] = incd
 			}
 		}
 	} else {
-		curIncidentIndex = 0
+		incidentRing.reset(0)
 	}
+	rebuildIncidentIndex()
 	setModifyIdx(syncCatgIncidentIdx, msg.ModifyIdx)
 	syncUnlock(syncCatgIncidentIdx)
 	return syncRxErrorNone
@@ -1434,11 +1490,14 @@ func syncAuditRx(msg *syncDataMsg) int {
 				auditSuppressSetIdRpts(audit)
 				auditCache[num] = audit
 				num++
+				if num == logCacheSize {
+					break
+				}
 			}
-			curAuditIndex = num
+			auditRing.reset(num)
 		}
 	} else {
-		curAuditIndex = 0
+		auditRing.reset(0)
 	}
 	setModifyIdx(syncCatgAuditIdx, msg.ModifyIdx)
 	syncUnlock(syncCatgAuditIdx)
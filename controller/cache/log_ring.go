@@ -0,0 +1,74 @@
+package cache
+
+// The last logCacheSize logs of a kind are kept in a slice of their type, used as a ring:
+// a new log takes the slot of the oldest one once the slice is full, nothing is moved or
+// reallocated. Each log recorded gets the next sequence number, its slot is seq % size, so
+// an index can refer to logs by seq and tell when they are overwritten.
+
+type logRing struct {
+	size  int
+	first uint64 // seq of the oldest log
+	next  uint64 // seq of the next log
+}
+
+func newLogRing(size int) logRing {
+	return logRing{size: size}
+}
+
+func (r *logRing) count() int {
+	return int(r.next - r.first)
+}
+
+func (r *logRing) slot(seq uint64) int {
+	return int(seq % uint64(r.size))
+}
+
+// Slot of the i-th newest log, from 0
+func (r *logRing) newest(i int) int {
+	return r.slot(r.next - 1 - uint64(i))
+}
+
+// Slot of the i-th oldest log, from 0
+func (r *logRing) oldest(i int) int {
+	return r.slot(r.first + uint64(i))
+}
+
+// Slot and seq of a new log. If evicted, the slot still holds the oldest log, which the
+// caller removes from its indexes before it is overwritten.
+func (r *logRing) push() (int, uint64, bool) {
+	var evicted bool
+	if r.count() == r.size {
+		r.first++
+		evicted = true
+	}
+	seq := r.next
+	r.next++
+	return r.slot(seq), seq, evicted
+}
+
+// The ring holds n logs in slots 0 to n-1, as filled by a sync from another controller
+func (r *logRing) reset(n int) {
+	if n > r.size {
+		n = r.size
+	}
+	r.first = 0
+	r.next = uint64(n)
+}
+
+// Seq of the logs of a ring by key, oldest first. The oldest log of the ring is the oldest of
+// its key, so it is always at the front when it is evicted.
+type logIndex map[string][]uint64
+
+func (x logIndex) add(key string, seq uint64) {
+	x[key] = append(x[key], seq)
+}
+
+func (x logIndex) remove(key string, seq uint64) {
+	if list, ok := x[key]; ok && len(list) > 0 && list[0] == seq {
+		if len(list) == 1 {
+			delete(x, key)
+		} else {
+			x[key] = list[1:]
+		}
+	}
+}
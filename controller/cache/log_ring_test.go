@@ -0,0 +1,48 @@
+package cache
+
+import (
+	"testing"
+)
+
+func TestLogRing(t *testing.T) {
+	r := newLogRing(4)
+	x := make(logIndex)
+	keys := make([]string, 4)
+
+	for i := 0; i < 10; i++ {
+		key := "a"
+		if i%3 == 0 {
+			key = "b"
+		}
+		slot, seq, evicted := r.push()
+		if evicted != (i >= 4) {
+			t.Errorf("Unexpected eviction: i=%v evicted=%v", i, evicted)
+		}
+		if evicted {
+			x.remove(keys[slot], seq-4)
+		}
+		keys[slot] = key
+		x.add(key, seq)
+	}
+
+	if r.count() != 4 {
+		t.Errorf("Unexpected count: %v", r.count())
+	}
+	// newest first: 9, 8, 7, 6
+	for i := 0; i < 4; i++ {
+		if r.newest(i) != (9-i)%4 || r.oldest(i) != (6+i)%4 {
+			t.Errorf("Unexpected slot: i=%v newest=%v oldest=%v", i, r.newest(i), r.oldest(i))
+		}
+	}
+	if len(x["a"]) != 2 || x["a"][0] != 7 || x["a"][1] != 8 {
+		t.Errorf("Unexpected index: a=%v", x["a"])
+	}
+	if len(x["b"]) != 2 || x["b"][0] != 6 || x["b"][1] != 9 {
+		t.Errorf("Unexpected index: b=%v", x["b"])
+	}
+
+	r.reset(3)
+	if r.count() != 3 || r.newest(0) != 2 || r.oldest(0) != 0 {
+		t.Errorf("Unexpected reset: count=%v", r.count())
+	}
+}
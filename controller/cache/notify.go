@@ -0,0 +1,140 @@
+package cache
+
+import (
+	"sync"
+	"time"
+
+	log "github.com/sirupsen/logrus"
+
+	"github.com/neuvector/neuvector/share/cluster"
+)
+
+// Fan-in of the cluster notifications of a kind, keyed by object. A notification after a quiet
+// period is handed to the handler right away; the ones that follow within the debounce delay
+// are held, and a burst of changes to the same key is handed over once, with the final value,
+// when the notifications have been quiet for the delay or at the latest maxDelay after the
+// first one. Keys are handed over in the order they were first notified.
+
+type pendingNotify struct {
+	nType     cluster.ClusterNotifyType
+	value     []byte
+	modifyIdx uint64
+}
+
+type notifyStats struct {
+	posted     uint64
+	coalesced  uint64
+	dispatched uint64
+}
+
+type notifyCoalescer struct {
+	name     string
+	handler  cluster.StoreWatcher
+	delay    time.Duration
+	maxDelay time.Duration
+
+	mutex     sync.Mutex
+	pending   map[string]*pendingNotify
+	order     []string
+	scheduled bool
+	timer     *time.Timer
+	firstAt   time.Time // first notification held for the timer
+	lastAt    time.Time
+	stats     notifyStats
+
+	flushMutex sync.Mutex // handler calls are never concurrent
+}
+
+const notifyDebounceDelay = time.Millisecond * 100
+const notifyDebounceDelayMax = time.Second
+
+var policyNotifier, connectNotifier *notifyCoalescer
+
+func initNotifiers() {
+	policyNotifier = newNotifyCoalescer("policy", notifyDebounceDelay, notifyDebounceDelayMax,
+		func(nType cluster.ClusterNotifyType, key string, value []byte, modifyIdx uint64) {
+			policyConfigUpdate(nType, key, value)
+		})
+	connectNotifier = newNotifyCoalescer("connect", notifyDebounceDelay, notifyDebounceDelayMax, connectUpdate)
+}
+
+func newNotifyCoalescer(name string, delay, maxDelay time.Duration, handler cluster.StoreWatcher) *notifyCoalescer {
+	return &notifyCoalescer{
+		name:     name,
+		handler:  handler,
+		delay:    delay,
+		maxDelay: maxDelay,
+		pending:  make(map[string]*pendingNotify),
+	}
+}
+
+func (c *notifyCoalescer) post(nType cluster.ClusterNotifyType, key string, value []byte, modifyIdx uint64) {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+
+	c.stats.posted++
+	if p, ok := c.pending[key]; ok {
+		c.stats.coalesced++
+		// an object added and then modified is still new to the handler
+		if p.nType != cluster.ClusterNotifyAdd || nType != cluster.ClusterNotifyModify {
+			p.nType = nType
+		}
+		p.value = value
+		p.modifyIdx = modifyIdx
+	} else {
+		c.pending[key] = &pendingNotify{nType: nType, value: value, modifyIdx: modifyIdx}
+		c.order = append(c.order, key)
+	}
+
+	now := time.Now()
+	quiet := now.Sub(c.lastAt) >= c.delay
+	c.lastAt = now
+
+	if !c.scheduled {
+		c.scheduled = true
+		if quiet {
+			go c.flush()
+		} else {
+			c.firstAt = now
+			c.timer = time.AfterFunc(c.delay, c.flush)
+		}
+	} else if c.timer != nil && now.Sub(c.firstAt) < c.maxDelay-c.delay {
+		c.timer.Reset(c.delay)
+	}
+}
+
+func (c *notifyCoalescer) flush() {
+	c.flushMutex.Lock()
+	defer c.flushMutex.Unlock()
+
+	c.mutex.Lock()
+	if len(c.order) == 0 {
+		c.mutex.Unlock()
+		return
+	}
+	order, pending := c.order, c.pending
+	c.order = nil
+	c.pending = make(map[string]*pendingNotify)
+	c.scheduled = false
+	c.timer = nil
+	c.stats.dispatched += uint64(len(order))
+	stats := c.stats
+	c.mutex.Unlock()
+
+	if len(order) > 1 {
+		log.WithFields(log.Fields{
+			"kind": c.name, "keys": len(order), "posted": stats.posted, "coalesced": stats.coalesced,
+		}).Debug("Coalesced notifications")
+	}
+
+	for _, key := range order {
+		p := pending[key]
+		c.handler(p.nType, key, p.value, p.modifyIdx)
+	}
+}
+
+func (c *notifyCoalescer) getStats() notifyStats {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+	return c.stats
+}
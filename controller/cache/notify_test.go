@@ -0,0 +1,58 @@
+package cache
+
+import (
+	"fmt"
+	"sync"
+	"testing"
+	"time"
+
+	"github.com/neuvector/neuvector/share/cluster"
+)
+
+func TestNotifyCoalescer(t *testing.T) {
+	var mutex sync.Mutex
+	got := make([]string, 0)
+	done := make(chan struct{}, 16)
+	c := newNotifyCoalescer("test", time.Millisecond*50, time.Second,
+		func(nType cluster.ClusterNotifyType, key string, value []byte, modifyIdx uint64) {
+			mutex.Lock()
+			got = append(got, fmt.Sprintf("%v:%v:%s", nType, key, value))
+			mutex.Unlock()
+			done <- struct{}{}
+		})
+
+	// The first notification is handed over right away
+	c.post(cluster.ClusterNotifyAdd, "a", []byte("1"), 1)
+	<-done
+
+	// The burst is held, keys are handed over once with their final value
+	c.post(cluster.ClusterNotifyAdd, "b", []byte("1"), 2)
+	c.post(cluster.ClusterNotifyModify, "a", []byte("2"), 3)
+	c.post(cluster.ClusterNotifyModify, "b", []byte("2"), 4)
+	c.post(cluster.ClusterNotifyAdd, "c", []byte("1"), 5)
+	c.post(cluster.ClusterNotifyDelete, "c", nil, 0)
+	for i := 0; i < 3; i++ {
+		select {
+		case <-done:
+		case <-time.After(time.Second * 2):
+			t.Fatalf("Notifications not handed over: %v", got)
+		}
+	}
+
+	expect := []string{
+		fmt.Sprintf("%v:a:1", cluster.ClusterNotifyAdd),
+		fmt.Sprintf("%v:b:2", cluster.ClusterNotifyAdd),
+		fmt.Sprintf("%v:a:2", cluster.ClusterNotifyModify),
+		fmt.Sprintf("%v:c:", cluster.ClusterNotifyDelete),
+	}
+	mutex.Lock()
+	defer mutex.Unlock()
+	if fmt.Sprint(got) != fmt.Sprint(expect) {
+		t.Errorf("Unexpected notifications: %v, expect %v", got, expect)
+	}
+
+	stats := c.getStats()
+	if stats.posted != 6 || stats.coalesced != 2 || stats.dispatched != 4 {
+		t.Errorf("Unexpected stats: %+v", stats)
+	}
+}
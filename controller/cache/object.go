@@ -1395,6 +1395,7 @@ func workloadUpdate(nType cluster.ClusterNotifyType, key string, value []byte) {
 		var workloadAgentChange bool
 
 		cacheMutexLock()
+		markViewWorkload(wl.ID)
 		if wlCache, ok = wlCacheMap[wl.ID]; ok && !isDummyWorkloadCache(wlCache) {
 			oldRunning := wlCache.workload.Running
 			oldQuar := wlCache.workload.Quarantine
@@ -1479,6 +1480,7 @@ func workloadUpdate(nType cluster.ClusterNotifyType, key string, value []byte) {
 					wlParent := initWorkloadCache()
 					wlParent.serviceAccount = wlCache.serviceAccount
 					wlCacheMap[wl.ShareNetNS] = wlParent
+					markViewWorkload(wl.ShareNetNS)
 					wlCacheMap[wl.ShareNetNS].children.Add(wl.ID)
 				} else {
 					parent.serviceAccount = wlCache.serviceAccount
@@ -1571,6 +1573,7 @@ func workloadUpdate(nType cluster.ClusterNotifyType, key string, value []byte) {
 
 		if wlCache, ok = wlCacheMap[id]; ok {
 			delete(wlCacheMap, id)
+			markViewWorkload(id)
 
 			// Update parent's children list.
 			if wlCache.workload.ShareNetNS != "" {
@@ -1640,7 +1643,7 @@ func ObjectUpdateHandler(nType cluster.ClusterNotifyType, key string, value []by
 	case "auditlog":
 		auditLogUpdate(nType, key, value, modifyIdx)
 	case "connect": // obsolete. Use grpc instead
-		connectUpdate(nType, key, value, modifyIdx)
+		connectNotifier.post(nType, key, value, modifyIdx)
 	case "config":
 		configUpdate(nType, key, value, modifyIdx)
 	case "uniconf":
@@ -1671,7 +1674,7 @@ func configUpdate(nType cluster.ClusterNotifyType, key string, value []byte, mod
 	case share.CFGEndpointGroup:
 		groupConfigUpdate(nType, key, value)
 	case share.CFGEndpointPolicy:
-		policyConfigUpdate(nType, key, value)
+		policyNotifier.post(nType, key, value, modifyIdx)
 	case share.CFGEndpointScan:
 		scanConfigUpdate(nType, value)
 	case share.CFGEndpointLicense:
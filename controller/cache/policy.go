@@ -7,6 +7,7 @@ import (
 	"encoding/json"
 	"errors"
 	"fmt"
+	"hash/fnv"
 	"net"
 	"sort"
 	"strings"
@@ -27,6 +28,8 @@ type policyCacheType struct {
 	ruleMap      map[uint32]*share.CLUSPolicyRule
 	ruleHeads    []*share.CLUSRuleHead
 	ruleOrderMap map[uint32]int
+	fedHeads     []*share.CLUSRuleHead // heads of the federal rules, in rule order
+	localHeads   []*share.CLUSRuleHead // and of the others
 }
 
 var policyCache policyCacheType = policyCacheType{
@@ -43,6 +46,34 @@ func ruleHeads2OrderMap(heads []*share.CLUSRuleHead) map[uint32]int {
 	return m
 }
 
+// With cacheMutex hold, the rule list is replaced, the heads of each scope are kept in order
+func (c *policyCacheType) setRuleHeads(heads []*share.CLUSRuleHead) {
+	c.ruleHeads = heads
+	c.ruleOrderMap = ruleHeads2OrderMap(heads)
+	c.fedHeads = make([]*share.CLUSRuleHead, 0)
+	c.localHeads = make([]*share.CLUSRuleHead, 0, len(heads))
+	for _, h := range heads {
+		if h.CfgType == share.FederalCfg {
+			c.fedHeads = append(c.fedHeads, h)
+		} else {
+			c.localHeads = append(c.localHeads, h)
+		}
+	}
+}
+
+// With cacheMutex hold, the heads to go through for a scope, nil for an unknown scope
+func (c *policyCacheType) scopeHeads(scope string) []*share.CLUSRuleHead {
+	switch scope {
+	case share.ScopeAll:
+		return c.ruleHeads
+	case share.ScopeFed:
+		return c.fedHeads
+	case share.ScopeLocal:
+		return c.localHeads
+	}
+	return nil
+}
+
 func appIDs2Names(ids []uint32) []string {
 	if ids == nil {
 		return []string{api.PolicyAppAny}
@@ -184,6 +215,7 @@ func policyConfigUpdate(nType cluster.ClusterNotifyType, key string, value []byt
 						gc = initGroupCache(rule.CfgType, rule.From)
 						gc.usedByPolicy.Add(rule.ID)
 						groupCacheMap[rule.From] = gc
+						markViewGroup(rule.From)
 					}
 				}
 				if !isHostOrUnmanagedWorkload(rule.To) {
@@ -195,6 +227,7 @@ func policyConfigUpdate(nType cluster.ClusterNotifyType, key string, value []byt
 						gc = initGroupCache(rule.CfgType, rule.To)
 						gc.usedByPolicy.Add(rule.ID)
 						groupCacheMap[rule.To] = gc
+						markViewGroup(rule.To)
 					}
 				}
 			}
@@ -208,9 +241,7 @@ func policyConfigUpdate(nType cluster.ClusterNotifyType, key string, value []byt
 			_ = json.Unmarshal(value, &heads)
 
 			cacheMutexLock()
-			policyCache.ruleHeads = nil
-			policyCache.ruleHeads = heads
-			policyCache.ruleOrderMap = ruleHeads2OrderMap(heads)
+			policyCache.setRuleHeads(heads)
 			cacheMutexUnlock()
 		}
 	case cluster.ClusterNotifyDelete:
@@ -234,9 +265,7 @@ func policyConfigUpdate(nType cluster.ClusterNotifyType, key string, value []byt
 			}
 		} else if share.CLUSIsPolicyZipRuleListKey(key) {
 			cacheMutexLock()
-			policyCache.ruleHeads = nil
-			policyCache.ruleHeads = make([]*share.CLUSRuleHead, 0)
-			policyCache.ruleOrderMap = ruleHeads2OrderMap(policyCache.ruleHeads)
+			policyCache.setRuleHeads(make([]*share.CLUSRuleHead, 0))
 			cacheMutexUnlock()
 		}
 	}
@@ -303,31 +332,48 @@ func (m CacheMethod) PolicyRule2REST(rule *share.CLUSPolicyRule) *api.RESTPolicy
 }
 
 func (m CacheMethod) GetAllPolicyRules(scope string, acc *access.AccessControl) []*api.RESTPolicyRule {
-	var getLocal, getFed bool
-	switch scope {
-	case share.ScopeLocal:
-		getLocal = true
-	case share.ScopeFed:
-		getFed = true
-	case share.ScopeAll:
-		getFed = true
-		getLocal = true
-	default:
-		return nil
-	}
+	return m.GetPolicyRulesPage(scope, acc, 0, 0)
+}
 
+// Rules of the scope readable by acc, from the start-th one and up to limit of them, all if
+// limit is 0. Only the rules of the page are converted; with the global permission, each
+// rule of the scope is readable so the page is taken from the start of the scope's index.
+func (m CacheMethod) GetPolicyRulesPage(scope string, acc *access.AccessControl, start, limit int) []*api.RESTPolicyRule {
 	cacheMutexRLock()
 	defer cacheMutexRUnlock()
 
-	rules := make([]*api.RESTPolicyRule, 0, len(policyCache.ruleHeads))
-	for _, head := range policyCache.ruleHeads {
-		if rule, ok := policyCache.ruleMap[head.ID]; ok {
-			if !acc.Authorize(rule, getAccessObjectFuncNoLock) {
-				continue
-			}
-			if (getFed && rule.CfgType == share.FederalCfg) || (getLocal && rule.CfgType != share.FederalCfg) {
-				rules = append(rules, policyRule2REST(rule))
-			}
+	heads := policyCache.scopeHeads(scope)
+	if heads == nil {
+		return nil
+	}
+	isFed := func(rule *share.CLUSPolicyRule) bool { return rule.CfgType == share.FederalCfg }
+
+	size := len(heads)
+	if limit > 0 && limit < size {
+		size = limit
+	}
+	rules := make([]*api.RESTPolicyRule, 0, size)
+	if start > 0 && acc.HasGlobalPermissions(share.PERMS_RUNTIME_POLICIES, 0) {
+		if start >= len(heads) {
+			return rules
+		}
+		heads, start = heads[start:], 0
+	}
+	for _, head := range heads {
+		rule, ok := policyCache.ruleMap[head.ID]
+		if !ok || (scope == share.ScopeFed && !isFed(rule)) || (scope == share.ScopeLocal && isFed(rule)) {
+			continue
+		}
+		if !acc.Authorize(rule, getAccessObjectFuncNoLock) {
+			continue
+		}
+		if start > 0 {
+			start--
+			continue
+		}
+		rules = append(rules, policyRule2REST(rule))
+		if limit > 0 && len(rules) == limit {
+			break
 		}
 	}
 
@@ -376,21 +422,13 @@ func (m CacheMethod) GetAllPolicyRulesCache(acc *access.AccessControl) []*share.
 
 // caller owns cacheMutexRLock & has allRead right
 func (m CacheMethod) GetFedNetworkRulesCache() ([]*share.CLUSPolicyRule, []*share.CLUSRuleHead) {
-	count := 0
-	for _, head := range policyCache.ruleHeads {
-		if head.CfgType == share.FederalCfg {
-			count++
-		}
-	}
-	heads := make([]*share.CLUSRuleHead, 0, count)
-	rules := make([]*share.CLUSPolicyRule, 0, count)
-	for _, head := range policyCache.ruleHeads {
-		if head.CfgType == share.FederalCfg {
-			heads = append(heads, head)
-			if rule, ok := policyCache.ruleMap[head.ID]; ok {
-				if rule.CfgType == share.FederalCfg {
-					rules = append(rules, rule)
-				}
+	heads := make([]*share.CLUSRuleHead, len(policyCache.fedHeads))
+	copy(heads, policyCache.fedHeads)
+	rules := make([]*share.CLUSPolicyRule, 0, len(heads))
+	for _, head := range heads {
+		if rule, ok := policyCache.ruleMap[head.ID]; ok {
+			if rule.CfgType == share.FederalCfg {
+				rules = append(rules, rule)
 			}
 		}
 	}
@@ -2062,6 +2100,68 @@ func policyIPRulesCleanupNode(rule_key, verstr, newCommonRuleKey string, tmpNid
 	policyIPRulesCleanup(newCommonKeys)
 }
 
+// Node rules last published to each node. A node that has them gets, besides the full slots
+// of a new version, a delta from them; a node that missed a version reads the full slots.
+type nodePolicyPublished struct {
+	ver    string
+	hashes []uint64
+}
+
+var nodePolicyPub map[string]*nodePolicyPublished
+
+func hashNodePolicy(rules []share.CLUSGroupIPPolicy) ([]json.RawMessage, []uint64) {
+	raws := make([]json.RawMessage, len(rules))
+	hashes := make([]uint64, len(rules))
+	for i := range rules {
+		raws[i], _ = json.Marshal(&rules[i])
+		h := fnv.New64a()
+		h.Write(raws[i])
+		hashes[i] = h.Sum64()
+	}
+	return raws, hashes
+}
+
+// nil if the delta is not worth it, when most rules are new, or too large
+func preparePolicyDelta(base *nodePolicyPublished, raws []json.RawMessage, hashes []uint64) []byte {
+	pos := make(map[uint64][]int, len(base.hashes))
+	for i, h := range base.hashes {
+		pos[h] = append(pos[h], i)
+	}
+
+	delta := share.CLUSGroupIPPolicyDelta{
+		Base: base.ver,
+		Segs: make([]share.CLUSPolicyDeltaSeg, 0),
+		Adds: make([]json.RawMessage, 0),
+	}
+	for i, h := range hashes {
+		old := -1
+		if l := pos[h]; len(l) > 0 {
+			old = l[0]
+			pos[h] = l[1:]
+		} else {
+			delta.Adds = append(delta.Adds, raws[i])
+		}
+		if n := len(delta.Segs); n > 0 {
+			last := &delta.Segs[n-1]
+			if (old < 0 && last.Old < 0) || (old >= 0 && last.Old >= 0 && last.Old+last.Len == old) {
+				last.Len++
+				continue
+			}
+		}
+		delta.Segs = append(delta.Segs, share.CLUSPolicyDeltaSeg{Old: old, Len: 1})
+	}
+	if len(delta.Adds)*2 > len(raws) {
+		return nil
+	}
+
+	value, _ := json.Marshal(&delta)
+	zb := utils.GzipBytes(value)
+	if len(zb) >= cluster.KVValueSizeMax {
+		return nil
+	}
+	return zb
+}
+
 func putPolicyIPRulesToClusterScaleNode(rules []share.CLUSGroupIPPolicy) {
 	//
 	//GroupIPRules is not directly watched by consul, to improve performance
@@ -2090,6 +2190,10 @@ func putPolicyIPRulesToClusterScaleNode(rules []share.CLUSGroupIPPolicy) {
 			return
 		}
 	}
+	// Only the nodes this version is published to keep a base for the next delta. An agent
+	// only bases a delta on a version it has read completely.
+	pubs := nodePolicyPub
+	nodePolicyPub = make(map[string]*nodePolicyPublished)
 	tmpNid := make(map[string]string)
 	ver_pushed := make(map[string]bool)
 	for _, nd := range nodNod {
@@ -2114,6 +2218,16 @@ func putPolicyIPRulesToClusterScaleNode(rules []share.CLUSGroupIPPolicy) {
 				return
 			}
 		}
+		var deltaFrom string
+		raws, hashes := hashNodePolicy(nodRules)
+		if pub, ok := pubs[nid]; ok {
+			if zb := preparePolicyDelta(pub, raws, hashes); zb != nil {
+				// The full slots are still there if the delta can't be written
+				if err = cluster.PutBinary(newNodeKey+share.PolicyIPRulesDeltaSlot, zb); err == nil {
+					deltaFrom = pub.ver
+				}
+			}
+		}
 		//new kv to indicate rule change
 		polVer := share.CLUSGroupIPPolicyVer{
 			Key:                  share.PolicyIPRulesVersionID,
@@ -2125,6 +2239,7 @@ func putPolicyIPRulesToClusterScaleNode(rules []share.CLUSGroupIPPolicy) {
 			RulesLen:             len(nodRules),
 			WorkloadSlot:         wlslots,
 			WorkloadLen:          wlens,
+			DeltaFrom:            deltaFrom,
 		}
 		log.WithFields(log.Fields{"newNodeKey": newNodeKey, "policyVer": polVer}).Debug("New policy rules written")
 
@@ -2135,6 +2250,7 @@ func putPolicyIPRulesToClusterScaleNode(rules []share.CLUSGroupIPPolicy) {
 			return
 		}
 		ver_pushed[nid] = true
+		nodePolicyPub[nid] = &nodePolicyPublished{ver: verstr, hashes: hashes}
 	}
 	//although there is no existing policy for some/all nodes,
 	//we still need to let relevant nodes know there are new
@@ -168,6 +168,7 @@ func responseRuleConfigUpdate(nType cluster.ClusterNotifyType, key string, value
 					gc = initGroupCache(rule.CfgType, rule.Group)
 					gc.usedByResponseRules.Add(rule.ID)
 					groupCacheMap[rule.Group] = gc
+					markViewGroup(rule.Group)
 				}
 			}
 		} else if cfgType == share.CLUSResCfgRuleList {
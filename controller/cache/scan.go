@@ -422,8 +422,8 @@ func refreshScanCache(id string, info *scanInfo, vpf scanUtils.VPFInterface) {
 	localVulTraits := scanUtils.ExtractVulnerability(reportVuls)
 
 	vpf.FilterVulTraits(localVulTraits, info.idns)
-	criticals, highs, meds := scanUtils.CountVulTrait(localVulTraits)
-	brief := fillScanBrief(info, criticals, highs, meds)
+	criticals, highs, meds, lows, fixedCriticalsInfo, fixedHighsInfo := scanUtils.GatherVulTrait(localVulTraits)
+	brief := fillScanBrief(info, len(criticals), len(highs), len(meds))
 	info.brief = brief
 	info.filteredTime = time.Now()
 
@@ -431,6 +431,7 @@ func refreshScanCache(id string, info *scanInfo, vpf scanUtils.VPFInterface) {
 	case share.ScanObjectType_CONTAINER:
 		if c := getWorkloadCache(id); c != nil {
 			c.scanBrief = brief
+			updateVulSummary(c, brief, criticals, highs, len(lows), len(fixedCriticalsInfo), len(fixedHighsInfo))
 		}
 	case share.ScanObjectType_HOST:
 		if c := getHostCache(id); c != nil {
@@ -535,6 +536,7 @@ func scanDone(id string, objType share.ScanObjectType, report *share.CLUSScanRep
 		case share.ScanObjectType_CONTAINER:
 			if c := getWorkloadCache(id); c != nil {
 				c.scanBrief = brief
+				updateVulSummary(c, brief, criticals, highs, len(lows), len(fixedCriticalsInfo), len(fixedHighsInfo))
 				dbAssetVul = getWorkloadDbAssetVul(c, criticals, highs, meds, lows, info.lastScanTime)
 			}
 		case share.ScanObjectType_HOST:
@@ -796,6 +798,10 @@ func scanWorkloadAgentChange(id string, param interface{}) {
 }
 
 func scanWorkloadDelete(id string, param interface{}) {
+	scanMutexLock()
+	removeVulSummary(id)
+	scanMutexUnlock()
+
 	scanMapDelete(id)
 }
 
@@ -1033,6 +1039,9 @@ func scanStateHandler(nType cluster.ClusterNotifyType, key string, value []byte)
 			if c := getWorkloadCache(id); c != nil {
 				c.scanBrief = brief
 			}
+			scanMutexLock()
+			removeVulSummary(id)
+			scanMutexUnlock()
 		} else if info.objType == share.ScanObjectType_HOST {
 			if c := getHostCache(id); c != nil {
 				c.scanBrief = brief
@@ -1546,6 +1555,144 @@ func fillScanBrief(info *scanInfo, critical, high, med int) *api.RESTScanBrief {
 	return brief
 }
 
+// Vulnerability summaries of the scanned workloads, also indexed by their image. They are
+// updated when a scan result arrives or the vulnerability profile changes, so the image views
+// read the counts instead of walking the workloads and their reports. The first critical and
+// high CVEs seen are given a bit of the topCVEs bitmap, up to vulTopCVEMax names.
+// Protected by scanMutex.
+
+const vulTopCVEMax = 64
+
+type vulSummary struct {
+	imageID        string
+	brief          *api.RESTScanBrief
+	lows           int
+	fixedCriticals int
+	fixedHighs     int
+	topCVEs        uint64 // bit n: the CVE of vulTopCVEIndex n is found
+}
+
+var vulSummaryMap map[string]*vulSummary = make(map[string]*vulSummary)
+var imageVulSummaryMap map[string]*utils.StringSet = make(map[string]*utils.StringSet) // image ID: workload IDs
+var vulTopCVEIndex map[string]uint = make(map[string]uint)
+
+func vulTopCVEBit(name string) uint64 {
+	n, ok := vulTopCVEIndex[name]
+	if !ok {
+		if len(vulTopCVEIndex) >= vulTopCVEMax {
+			return 0
+		}
+		n = uint(len(vulTopCVEIndex))
+		vulTopCVEIndex[name] = n
+	}
+	return 1 << n
+}
+
+// Whether the CVE is found, and whether the CVE has a bit so the answer is known
+func (s *vulSummary) hasTopCVE(name string) (bool, bool) {
+	n, ok := vulTopCVEIndex[name]
+	if !ok {
+		return false, false
+	}
+	return s.topCVEs&(1<<n) != 0, true
+}
+
+// With scan mutex locked
+func updateVulSummary(c *workloadCache, brief *api.RESTScanBrief, criticals, highs []string, lows, fixedCriticals, fixedHighs int) {
+	id := c.workload.ID
+	removeVulSummary(id)
+	if brief.Status != api.ScanStatusFinished || c.workload.ImageID == "" {
+		return
+	}
+
+	s := &vulSummary{
+		imageID: c.workload.ImageID, brief: brief, lows: lows, fixedCriticals: fixedCriticals, fixedHighs: fixedHighs,
+	}
+	for _, name := range criticals {
+		s.topCVEs |= vulTopCVEBit(name)
+	}
+	for _, name := range highs {
+		s.topCVEs |= vulTopCVEBit(name)
+	}
+	vulSummaryMap[id] = s
+
+	wls, ok := imageVulSummaryMap[s.imageID]
+	if !ok {
+		wls = utils.NewStringSet()
+		imageVulSummaryMap[s.imageID] = wls
+	}
+	wls.Add(id)
+}
+
+// With scan mutex locked
+func removeVulSummary(id string) {
+	s, ok := vulSummaryMap[id]
+	if !ok {
+		return
+	}
+	delete(vulSummaryMap, id)
+	if wls, ok := imageVulSummaryMap[s.imageID]; ok {
+		wls.Remove(id)
+		if wls.Cardinality() == 0 {
+			delete(imageVulSummaryMap, s.imageID)
+		}
+	}
+}
+
+// With scan mutex and cacheMutex locked
+func authorizedVulSummary(id string, acc *access.AccessControl) *workloadCache {
+	c, ok := wlCacheMap[id]
+	if !ok || !acc.Authorize(c.workload, nil) || common.OEMIgnoreWorkload(c.workload) {
+		return nil
+	}
+	if !acc.Authorize(&share.CLUSWorkloadScanDummy{Domain: c.workload.Domain}, nil) {
+		return nil
+	}
+	return c
+}
+
+// Scan summary of the images of the scanned workloads, by image ID. An image is given the
+// summary of its workload with the most high, then medium, vulnerabilities.
+func (m CacheMethod) GetScanImageSummaries(acc *access.AccessControl) map[string]*api.RESTScanImageSummary {
+	scanMutexRLock()
+	defer scanMutexRUnlock()
+	cacheMutexRLock()
+	defer cacheMutexRUnlock()
+
+	images := make(map[string]*api.RESTScanImageSummary, len(imageVulSummaryMap))
+	for imageID, wls := range imageVulSummaryMap {
+		for _, id := range wls.Items() {
+			c := authorizedVulSummary(id, acc)
+			if c == nil {
+				continue
+			}
+			b := vulSummaryMap[id].brief
+			old, ok := images[imageID]
+			if !ok || old.HighVuls < b.HighVuls || (old.HighVuls == b.HighVuls && old.MedVuls < b.MedVuls) {
+				images[imageID] = &api.RESTScanImageSummary{Image: c.workload.Image, ImageID: imageID, RESTScanBrief: *b}
+			}
+		}
+	}
+	return images
+}
+
+// A scanned workload of the image, whose report is the image's report
+func (m CacheMethod) GetScanImageWorkload(imageID string, acc *access.AccessControl) string {
+	scanMutexRLock()
+	defer scanMutexRUnlock()
+	cacheMutexRLock()
+	defer cacheMutexRUnlock()
+
+	if wls, ok := imageVulSummaryMap[imageID]; ok {
+		for _, id := range wls.Items() {
+			if c := authorizedVulSummary(id, acc); c != nil {
+				return id
+			}
+		}
+	}
+	return ""
+}
+
 func scanBrief2REST(info *scanInfo) *api.RESTScanBrief {
 	var r api.RESTScanBrief
 
@@ -1684,14 +1831,10 @@ func getPlatformDbAssetVul(criticals, highs, meds, lows []string, baseOS string,
 	return d
 }
 
-func ExtractVulAttributes(vulsb []byte, indsStr string) []string {
+// The vuls of an asset are read from the assetcves table of the db
+func ExtractVulAttributes(Vuls []*share.ScanVulnerability, indsStr string) []string {
 	cveList := make([]string, 0)
 
-	Vuls, err := db.UnzipVuls(vulsb)
-	if err != nil {
-		return cveList
-	}
-
 	inds := make([]api.RESTIDName, 0)
 	if indsStr != "" {
 		if err := json.Unmarshal([]byte(indsStr), &inds); err != nil {
@@ -1720,18 +1863,7 @@ func ExtractVulAttributes(vulsb []byte, indsStr string) []string {
 	return cveList
 }
 
-func FillVulPackages(mu *sync.Mutex, cvePackages map[string]map[string]utils.Set, vulsb []byte, idnsStr string, cveList *[]string, cveStat map[string]*int) error {
-
-	var Vuls []*share.ScanVulnerability
-	if uzb := utils.GunzipBytes(vulsb); uzb != nil {
-		buf := bytes.NewBuffer(uzb)
-		dec := gob.NewDecoder(buf)
-		if err := dec.Decode(&Vuls); err != nil {
-			log.WithFields(log.Fields{"vulsb": string(vulsb)}).Error("unzip vuls bytes error")
-			return err
-		}
-	}
-
+func FillVulPackages(mu *sync.Mutex, cvePackages map[string]map[string]utils.Set, Vuls []*share.ScanVulnerability, idnsStr string, cveList *[]string, cveStat map[string]*int) error {
 	idns := make([]api.RESTIDName, 0)
 	if idnsStr != "" {
 		if err := json.Unmarshal([]byte(idnsStr), &idns); err != nil {
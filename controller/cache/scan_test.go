@@ -4,6 +4,8 @@ import (
 	"fmt"
 	"testing"
 
+	"github.com/neuvector/neuvector/controller/access"
+	"github.com/neuvector/neuvector/controller/api"
 	"github.com/neuvector/neuvector/share"
 	"github.com/stretchr/testify/assert"
 )
@@ -210,3 +212,43 @@ func TestCompareScanConfig(t *testing.T) {
 		})
 	}
 }
+
+func TestImageVulSummary(t *testing.T) {
+	preTest()
+
+	var m CacheMethod
+	acc := access.NewReaderAccessControl()
+	wl1 := &workloadCache{workload: &share.CLUSWorkload{ID: "wl1", Image: "nginx", ImageID: "img1"}}
+	wl2 := &workloadCache{workload: &share.CLUSWorkload{ID: "wl2", Image: "nginx", ImageID: "img1"}}
+	wlCacheMap["wl1"], wlCacheMap["wl2"] = wl1, wl2
+
+	finished := func(high, med int) *api.RESTScanBrief {
+		return &api.RESTScanBrief{Status: api.ScanStatusFinished, HighVuls: high, MedVuls: med}
+	}
+	updateVulSummary(wl1, finished(1, 5), []string{"CVE-1"}, []string{"CVE-2"}, 0, 1, 0)
+	updateVulSummary(wl2, finished(2, 0), nil, []string{"CVE-2", "CVE-3"}, 0, 0, 1)
+
+	images := m.GetScanImageSummaries(acc)
+	assert.Equal(t, 1, len(images))
+	assert.Equal(t, 2, images["img1"].HighVuls)
+
+	found, known := vulSummaryMap["wl1"].hasTopCVE("CVE-1")
+	assert.True(t, found && known)
+	found, known = vulSummaryMap["wl2"].hasTopCVE("CVE-1")
+	assert.True(t, !found && known)
+	_, known = vulSummaryMap["wl2"].hasTopCVE("CVE-4")
+	assert.False(t, known)
+
+	// A workload being scanned again is not summarized
+	updateVulSummary(wl2, &api.RESTScanBrief{Status: api.ScanStatusScanning}, nil, nil, 0, 0, 0)
+	assert.Equal(t, 1, m.GetScanImageSummaries(acc)["img1"].HighVuls)
+
+	removeVulSummary("wl1")
+	assert.Equal(t, "", m.GetScanImageWorkload("img1", acc))
+	assert.Equal(t, 0, len(imageVulSummaryMap))
+
+	delete(wlCacheMap, "wl1")
+	delete(wlCacheMap, "wl2")
+	vulTopCVEIndex = make(map[string]uint)
+	postTest()
+}
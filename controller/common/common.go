@@ -224,6 +224,7 @@ var LogThreatMap = map[uint32]LogThreatInfo{
 	C.THRT_ID_SYN_FLOOD:         {"TCP.SYN.Flood"},
 	C.THRT_ID_ICMP_FLOOD:        {"ICMP.Flood"},
 	C.THRT_ID_IP_SRC_SESSION:    {"Source.IP.Session.Limit"},
+	C.THRT_ID_TCP_PORT_SCAN:     {"TCP.Port.Scan"},
 	C.THRT_ID_BAD_PACKET:        {"Invalid.Packet.Format"},
 	C.THRT_ID_IP_TEARDROP:       {"IP.Fragment.Teardrop"},
 	C.THRT_ID_TCP_SYN_DATA:      {"TCP.SYN.With.Data"},
@@ -347,6 +348,7 @@ var LogEventMap = map[share.TLogEvent]LogEventInfo{
 	share.CLUSEvDEKSeedUnavailable:          {api.EventNameDEKSeedUnavailable, api.EventCatConfig, api.LogLevelWARNING},
 	share.CLUSEvReEncryptWithDEK:            {api.EventNameReEncryptWithDEK, api.EventCatConfig, api.LogLevelINFO},
 	share.CLUSEvEncryptionSecretSet:         {api.EventNameEncryptionSecretSet, api.EventCatConfig, api.LogLevelNOTICE},
+	share.CLUSEvAgentDPOverload:             {api.EventNameAgentDPOverload, api.EventCatAgent, api.LogLevelWARNING},
 }
 
 type LogIncidentInfo struct {
@@ -30,6 +30,7 @@ type Graph struct {
 	cbNewLink        NewLinkCallback
 	cbDelNode        DelNodeCallback
 	cbDelLink        DelLinkCallback
+	cbDelEdge        DelLinkCallback
 	cbUpdateLinkAttr UpdateLinkAttrCallback
 }
 
@@ -51,6 +52,12 @@ func (g *Graph) RegisterDelLinkHook(cb DelLinkCallback) {
 	g.cbDelLink = cb
 }
 
+// Unlike the DelLink hook, which is called when the last end of a link is removed from a node,
+// the DelEdge hook is called for every src-dst end that is removed.
+func (g *Graph) RegisterDelEdgeHook(cb DelLinkCallback) {
+	g.cbDelEdge = cb
+}
+
 func (g *Graph) RegisterUpdateLinkAttrHook(cb UpdateLinkAttrCallback) {
 	g.cbUpdateLinkAttr = cb
 }
@@ -160,6 +167,9 @@ func (g *Graph) DeleteLink(src, link, dst string) {
 	if gl, ok := s.outs[link]; ok {
 		if _, ok = gl.ends[dst]; ok {
 			delete(gl.ends, dst)
+			if g.cbDelEdge != nil {
+				g.cbDelEdge(src, link, dst)
+			}
 			if len(gl.ends) == 0 {
 				delete(s.outs, link)
 
@@ -221,16 +231,16 @@ func (g *Graph) Node(v string) string {
 	}
 }
 
-func (g *Graph) All() utils.Set {
-	ret := utils.NewSet()
+func (g *Graph) All() *utils.StringSet {
+	ret := utils.NewStringSet()
 	for v := range g.nodes {
 		ret.Add(v)
 	}
 	return ret
 }
 
-func (g *Graph) NoIn() utils.Set {
-	ret := utils.NewSet()
+func (g *Graph) NoIn() *utils.StringSet {
+	ret := utils.NewStringSet()
 	for v, n := range g.nodes {
 		if len(n.ins) == 0 {
 			ret.Add(v)
@@ -240,8 +250,8 @@ func (g *Graph) NoIn() utils.Set {
 	return ret
 }
 
-func (g *Graph) NoInByLink(link string) utils.Set {
-	ret := utils.NewSet()
+func (g *Graph) NoInByLink(link string) *utils.StringSet {
+	ret := utils.NewStringSet()
 	for v, n := range g.nodes {
 		if _, ok := n.ins[link]; !ok {
 			ret.Add(v)
@@ -253,8 +263,8 @@ func (g *Graph) NoInByLink(link string) utils.Set {
 	return ret
 }
 
-func (g *Graph) NoOut() utils.Set {
-	ret := utils.NewSet()
+func (g *Graph) NoOut() *utils.StringSet {
+	ret := utils.NewStringSet()
 	for v, n := range g.nodes {
 		if len(n.outs) == 0 {
 			ret.Add(v)
@@ -264,8 +274,8 @@ func (g *Graph) NoOut() utils.Set {
 	return ret
 }
 
-func (g *Graph) NoOutByLink(link string) utils.Set {
-	ret := utils.NewSet()
+func (g *Graph) NoOutByLink(link string) *utils.StringSet {
+	ret := utils.NewStringSet()
 	for v, n := range g.nodes {
 		if _, ok := n.outs[link]; !ok {
 			ret.Add(v)
@@ -277,12 +287,12 @@ func (g *Graph) NoOutByLink(link string) utils.Set {
 	return ret
 }
 
-func (g *Graph) Ins(node string) utils.Set {
+func (g *Graph) Ins(node string) *utils.StringSet {
 	if _, ok := g.nodes[node]; !ok {
 		return nil
 	}
 
-	ret := utils.NewSet()
+	ret := utils.NewStringSet()
 	n := g.nodes[node]
 	for _, l := range n.ins {
 		for v := range l.ends {
@@ -293,12 +303,12 @@ func (g *Graph) Ins(node string) utils.Set {
 	return ret
 }
 
-func (g *Graph) InsByLink(node string, link string) utils.Set {
+func (g *Graph) InsByLink(node string, link string) *utils.StringSet {
 	if _, ok := g.nodes[node]; !ok {
 		return nil
 	}
 
-	ret := utils.NewSet()
+	ret := utils.NewStringSet()
 	n := g.nodes[node]
 	if gl, ok := n.ins[link]; !ok {
 		return ret
@@ -311,12 +321,12 @@ func (g *Graph) InsByLink(node string, link string) utils.Set {
 	return ret
 }
 
-func (g *Graph) Outs(node string) utils.Set {
+func (g *Graph) Outs(node string) *utils.StringSet {
 	if _, ok := g.nodes[node]; !ok {
 		return nil
 	}
 
-	ret := utils.NewSet()
+	ret := utils.NewStringSet()
 	n := g.nodes[node]
 	for _, l := range n.outs {
 		for v := range l.ends {
@@ -327,12 +337,12 @@ func (g *Graph) Outs(node string) utils.Set {
 	return ret
 }
 
-func (g *Graph) OutsByLink(node string, link string) utils.Set {
+func (g *Graph) OutsByLink(node string, link string) *utils.StringSet {
 	if _, ok := g.nodes[node]; !ok {
 		return nil
 	}
 
-	ret := utils.NewSet()
+	ret := utils.NewStringSet()
 	n := g.nodes[node]
 	if gl, ok := n.outs[link]; !ok {
 		return ret
@@ -345,7 +355,7 @@ func (g *Graph) OutsByLink(node string, link string) utils.Set {
 	return ret
 }
 
-func (g *Graph) Both(node string) utils.Set {
+func (g *Graph) Both(node string) *utils.StringSet {
 	if _, ok := g.nodes[node]; !ok {
 		return nil
 	}
@@ -353,7 +363,7 @@ func (g *Graph) Both(node string) utils.Set {
 	return g.Ins(node).Union(g.Outs(node))
 }
 
-func (g *Graph) BothByLink(node string, link string) utils.Set {
+func (g *Graph) BothByLink(node string, link string) *utils.StringSet {
 	if _, ok := g.nodes[node]; !ok {
 		return nil
 	}
@@ -361,12 +371,12 @@ func (g *Graph) BothByLink(node string, link string) utils.Set {
 	return g.InsByLink(node, link).Union(g.OutsByLink(node, link))
 }
 
-func (g *Graph) Connected(node string, cb ConnectedNodeCallback) utils.Set {
+func (g *Graph) Connected(node string, cb ConnectedNodeCallback) *utils.StringSet {
 	if _, ok := g.nodes[node]; !ok {
 		return nil
 	}
 
-	ret := utils.NewSet()
+	ret := utils.NewStringSet()
 	ret.Add(node)
 	q := []string{node}
 
@@ -375,11 +385,10 @@ func (g *Graph) Connected(node string, cb ConnectedNodeCallback) utils.Set {
 		node, q = q[0], q[1:]
 
 		both := g.Both(node)
-		for n := range both.Iter() {
-			if cb != nil && cb(n.(string)) {
-				if !ret.Contains(n) {
-					ret.Add(n)
-					q = append(q, n.(string))
+		for _, n := range both.Items() {
+			if cb != nil && cb(n) {
+				if ret.Add(n) {
+					q = append(q, n)
 				}
 			}
 		}
@@ -388,12 +397,12 @@ func (g *Graph) Connected(node string, cb ConnectedNodeCallback) utils.Set {
 	return ret
 }
 
-func (g *Graph) ConnectedByLink(node string, link string, cb ConnectedNodeCallback) utils.Set {
+func (g *Graph) ConnectedByLink(node string, link string, cb ConnectedNodeCallback) *utils.StringSet {
 	if _, ok := g.nodes[node]; !ok {
 		return nil
 	}
 
-	ret := utils.NewSet()
+	ret := utils.NewStringSet()
 	ret.Add(node)
 	q := []string{node}
 
@@ -402,11 +411,10 @@ func (g *Graph) ConnectedByLink(node string, link string, cb ConnectedNodeCallba
 		node, q = q[0], q[1:]
 
 		both := g.BothByLink(node, link)
-		for n := range both.Iter() {
-			if cb != nil && cb(n.(string)) {
-				if !ret.Contains(n) {
-					ret.Add(n)
-					q = append(q, n.(string))
+		for _, n := range both.Items() {
+			if cb != nil && cb(n) {
+				if ret.Add(n) {
+					q = append(q, n)
 				}
 			}
 		}
@@ -437,6 +445,9 @@ func (g *Graph) PurgeOutLinks(src string, cb PurgeOutLinkCallback, param interfa
 					if len(l.ends) == 0 {
 						delete(n.outs, ln)
 					}
+					if g.cbDelEdge != nil {
+						g.cbDelEdge(src, ln, dst)
+					}
 				}
 			}
 		}
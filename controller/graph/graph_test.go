@@ -47,7 +47,7 @@ func TestOuts(t *testing.T) {
 		t.Fatalf("Output: %v", out)
 	}
 
-	a := utils.NewSet()
+	a := utils.NewStringSet()
 	a.Add("cool")
 	a.Add("B")
 	a.Add("G")
@@ -65,7 +65,7 @@ func TestOutsLink(t *testing.T) {
 		t.Fatalf("Output: %v", out)
 	}
 
-	a := utils.NewSet()
+	a := utils.NewStringSet()
 	a.Add("F")
 
 	if !a.Equal(out) {
@@ -81,7 +81,7 @@ func TestNoIn(t *testing.T) {
 		t.Fatalf("Output: %v", out)
 	}
 
-	a := utils.NewSet()
+	a := utils.NewStringSet()
 	a.Add("A")
 	a.Add("C")
 	a.Add("E")
@@ -111,7 +111,7 @@ func TestConn(t *testing.T) {
 		t.Fatalf("Output: %v", out)
 	}
 
-	a := utils.NewSet()
+	a := utils.NewStringSet()
 	a.Add("A")
 	a.Add("B")
 	a.Add("C")
@@ -134,7 +134,7 @@ func TestConnNonNode(t *testing.T) {
 		t.Fatalf("Output: %v", out)
 	}
 
-	a := utils.NewSet()
+	a := utils.NewStringSet()
 	a.Add("A")
 
 	if !a.Equal(out) {
@@ -150,7 +150,7 @@ func TestConnPartial(t *testing.T) {
 		t.Fatalf("Output: %v", out)
 	}
 
-	a := utils.NewSet()
+	a := utils.NewStringSet()
 	a.Add("A")
 	a.Add("B")
 
@@ -167,7 +167,7 @@ func TestConnLink(t *testing.T) {
 		t.Fatalf("Output: %v", out)
 	}
 
-	a := utils.NewSet()
+	a := utils.NewStringSet()
 	a.Add("A")
 	a.Add("B")
 	a.Add("C")
@@ -187,7 +187,7 @@ func TestDeleteLink(t *testing.T) {
 	g.DeleteLink("A", "follows", "B")
 	in := g.Ins("B")
 
-	i := utils.NewSet()
+	i := utils.NewStringSet()
 	i.Add("C")
 	i.Add("D")
 
@@ -199,7 +199,7 @@ func TestDeleteLink(t *testing.T) {
 	g.DeleteLink("D", "status", "cool")
 	out := g.Outs("D")
 
-	o := utils.NewSet()
+	o := utils.NewStringSet()
 	o.Add("B")
 
 	if !o.Equal(out) {
@@ -233,3 +233,18 @@ func TestDeleteNode(t *testing.T) {
 		t.Errorf("Output: %v", g.Ins("F"))
 	}
 }
+
+func TestDelEdgeHook(t *testing.T) {
+	g := makeTestGraph()
+
+	edges := utils.NewStringSet()
+	g.RegisterDelEdgeHook(func(src, link, dst string) {
+		edges.Add(src + "-" + link + "-" + dst)
+	})
+	g.DeleteNode("D")
+
+	e := utils.NewStringSet("C-follows-D", "D-follows-B", "D-follows-G", "D-status-cool")
+	if !e.Equal(edges) {
+		t.Errorf("Output: %v", edges)
+	}
+}
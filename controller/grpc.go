@@ -436,8 +436,29 @@ func (s *UpgradeService) UpgradeScannerDB(stream share.ControllerUpgradeService_
 
 const reportChanSize = 128
 
+// Max number of connections coalesced from queued reports
+const reportBatchMax = 2048 * 16
+
+// Reports queued while one is handled are coalesced, so the graph is updated and the
+// connections are forwarded to other controllers once for all of them.
+func agentReportBatch(ch chan []*share.CLUSConnection, conns []*share.CLUSConnection) ([]*share.CLUSConnection, bool) {
+	for len(conns) < reportBatchMax {
+		select {
+		case more, ok := <-ch:
+			if !ok {
+				return conns, false
+			}
+			conns = append(conns, more...)
+		default:
+			return conns, true
+		}
+	}
+	return conns, true
+}
+
 func agentReportWorker(ch chan []*share.CLUSConnection) {
 	for conns := range ch {
+		conns, open := agentReportBatch(ch, conns)
 		cache.UpdateConnections(conns)
 
 		var wg sync.WaitGroup
@@ -455,6 +476,9 @@ func agentReportWorker(ch chan []*share.CLUSConnection) {
 			}
 		}
 		wg.Wait()
+		if !open {
+			return
+		}
 	}
 }
 
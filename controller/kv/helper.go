@@ -77,6 +77,7 @@ type ClusterHelper interface {
 	PutPolicyRuleListTxn(txn *cluster.ClusterTransact, crhs []*share.CLUSRuleHead) error
 	PutPolicyRuleListZip(key string, array []byte) error
 	GetPolicyRule(id uint32) (*share.CLUSPolicyRule, uint64)
+	GetPolicyRules() map[uint32]*share.CLUSPolicyRule
 	PutPolicyRule(rule *share.CLUSPolicyRule) error
 	PutPolicyRuleTxn(txn *cluster.ClusterTransact, rule *share.CLUSPolicyRule) error
 	PutPolicyRuleRev(rule *share.CLUSPolicyRule, rev uint64) error
@@ -1058,6 +1059,35 @@ func (m clusterHelper) GetPolicyRule(id uint32) (*share.CLUSPolicyRule, uint64)
 	return nil, 0
 }
 
+// All rules of the default policy in one read, nil if they can't be listed
+func (m clusterHelper) GetPolicyRules() map[uint32]*share.CLUSPolicyRule {
+	store := fmt.Sprintf("%s%s/rule/", share.CLUSConfigPolicyStore, share.DefaultPolicyName)
+	kvPairs, err := cluster.List(store)
+	if err != nil && err != cluster.ErrEmptyStore {
+		log.WithFields(log.Fields{"error": err}).Error("List policy rules")
+		return nil
+	}
+
+	rules := make(map[uint32]*share.CLUSPolicyRule, len(kvPairs))
+	for _, kv := range kvPairs {
+		if kv == nil {
+			continue
+		}
+		value, err, wrt := UpgradeAndConvert(kv.Key, kv.Value)
+		if wrt {
+			value, _, err = m.get(kv.Key)
+		}
+		if err != nil || value == nil {
+			continue
+		}
+		var rule share.CLUSPolicyRule
+		if nvJsonUnmarshal(kv.Key, value, &rule) == nil {
+			rules[rule.ID] = &rule
+		}
+	}
+	return rules
+}
+
 func (m clusterHelper) PutPolicyRule(rule *share.CLUSPolicyRule) error {
 	key := share.CLUSPolicyRuleKey(share.DefaultPolicyName, rule.ID)
 	value, err := json.Marshal(rule)
@@ -324,6 +324,10 @@ func (m *MockCluster) PutGroup(group *share.CLUSGroup, create bool) error {
 	return nil
 }
 
+func (m *MockCluster) PutGroupTxn(txn *cluster.ClusterTransact, group *share.CLUSGroup) error {
+	return m.PutGroup(group, false)
+}
+
 func (m *MockCluster) DeleteGroup(name string) error {
 	if _, ok := m.groupsCluster[name]; ok {
 		delete(m.groupsCluster, name)
@@ -354,6 +358,14 @@ func (m *MockCluster) GetPolicyRule(id uint32) (*share.CLUSPolicyRule, uint64) {
 	}
 }
 
+func (m *MockCluster) GetPolicyRules() map[uint32]*share.CLUSPolicyRule {
+	rules := make(map[uint32]*share.CLUSPolicyRule, len(m.rulesCluster))
+	for id, r := range m.rulesCluster {
+		rules[id] = r
+	}
+	return rules
+}
+
 func (m *MockCluster) PutPolicyRule(rule *share.CLUSPolicyRule) error {
 	m.rulesCluster[rule.ID] = rule
 	return nil
@@ -453,6 +465,10 @@ func (m *MockCluster) PutProcessProfile(group string, pg *share.CLUSProcessProfi
 	return nil
 }
 
+func (m *MockCluster) PutProcessProfileTxn(txn *cluster.ClusterTransact, group string, pg *share.CLUSProcessProfile) error {
+	return m.PutProcessProfile(group, pg)
+}
+
 func (m *MockCluster) GetAllComplianceProfiles(acc *access.AccessControl) []*share.CLUSComplianceProfile {
 	list := make([]*share.CLUSComplianceProfile, 0)
 	for _, cp := range m.complianceProfiles {
@@ -0,0 +1,84 @@
+package opa
+
+import (
+	"container/list"
+	"crypto/sha256"
+	"sync"
+)
+
+// LRU cache of the evaluation results by policy and input. Any change of the OPA policies or
+// documents empties it; an evaluation that started before the change is not cached.
+
+const decisionCacheSize = 1024
+
+type decisionKey struct {
+	policyPath string
+	input      [sha256.Size]byte
+}
+
+type decisionEntry struct {
+	key        decisionKey
+	statusCode int
+	body       string
+}
+
+type decisionCache struct {
+	mutex   sync.Mutex
+	size    int
+	gen     uint64
+	entries map[decisionKey]*list.Element
+	lru     *list.List
+}
+
+var opaDecisions = newDecisionCache(decisionCacheSize)
+
+func newDecisionCache(size int) *decisionCache {
+	return &decisionCache{
+		size:    size,
+		entries: make(map[decisionKey]*list.Element),
+		lru:     list.New(),
+	}
+}
+
+func makeDecisionKey(policyPath string, inputData string) decisionKey {
+	return decisionKey{policyPath: policyPath, input: sha256.Sum256([]byte(inputData))}
+}
+
+// Returns the generation to pass to put() on a miss
+func (c *decisionCache) get(key decisionKey) (*decisionEntry, uint64) {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+	if e, ok := c.entries[key]; ok {
+		c.lru.MoveToFront(e)
+		return e.Value.(*decisionEntry), c.gen
+	}
+	return nil, c.gen
+}
+
+func (c *decisionCache) put(key decisionKey, gen uint64, statusCode int, body string) {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+	if gen != c.gen {
+		return
+	}
+	if e, ok := c.entries[key]; ok {
+		c.lru.MoveToFront(e)
+		return
+	}
+	if c.lru.Len() >= c.size {
+		oldest := c.lru.Back()
+		delete(c.entries, oldest.Value.(*decisionEntry).key)
+		c.lru.Remove(oldest)
+	}
+	c.entries[key] = c.lru.PushFront(&decisionEntry{key: key, statusCode: statusCode, body: body})
+}
+
+func (c *decisionCache) invalidate() {
+	c.mutex.Lock()
+	defer c.mutex.Unlock()
+	c.gen++
+	if c.lru.Len() > 0 {
+		c.entries = make(map[decisionKey]*list.Element)
+		c.lru.Init()
+	}
+}
@@ -0,0 +1,39 @@
+package opa
+
+import (
+	"testing"
+)
+
+func TestDecisionCache(t *testing.T) {
+	c := newDecisionCache(2)
+
+	k1 := makeDecisionKey("/v1/data/neuvector_policy_1", `{"input":{}}`)
+	k2 := makeDecisionKey("/v1/data/neuvector_policy_2", `{"input":{}}`)
+	k3 := makeDecisionKey("/v1/data/neuvector_policy_1", `{"input":{"request":{}}}`)
+
+	_, gen := c.get(k1)
+	c.put(k1, gen, 200, "r1")
+	c.put(k2, gen, 200, "r2")
+	if e, _ := c.get(k1); e == nil || e.body != "r1" {
+		t.Errorf("Decision not cached: %v", e)
+	}
+	// k2 is the least recently used
+	c.put(k3, gen, 200, "r3")
+	if e, _ := c.get(k2); e != nil {
+		t.Errorf("Decision not evicted: %v", e)
+	}
+	if e, _ := c.get(k3); e == nil || e.body != "r3" {
+		t.Errorf("Decision not cached: %v", e)
+	}
+
+	// an evaluation started before a policy change is not cached
+	_, gen = c.get(k2)
+	c.invalidate()
+	c.put(k2, gen, 200, "r2")
+	if e, _ := c.get(k2); e != nil {
+		t.Errorf("Stale decision cached: %v", e)
+	}
+	if e, _ := c.get(k1); e != nil {
+		t.Errorf("Decision not invalidated: %v", e)
+	}
+}
@@ -116,8 +116,11 @@ func StartOpaServer() *exec.Cmd {
 	return cmd
 }
 
+// Shared so the connections to the OPA server are kept alive between the requests
+var opaHTTPClient = &http.Client{}
+
 func getOpaHTTPClient() *http.Client {
-	return &http.Client{}
+	return opaHTTPClient
 }
 
 func addObject(key string, contentType string, data string) bool {
@@ -150,6 +153,7 @@ func addObject(key string, contentType string, data string) bool {
 	}
 
 	if resp.StatusCode == 200 || resp.StatusCode == 204 {
+		opaDecisions.invalidate()
 		return true
 	}
 	return false
@@ -211,6 +215,8 @@ func DeleteDocument(key string) {
 		return
 	}
 
+	opaDecisions.invalidate()
+
 	opaCacheDocMutex.Lock()
 	delete(opaCacheDoc, key)
 	opaCacheDocMutex.Unlock()
@@ -229,11 +235,35 @@ func OpaEval(policyPath string, inputFile string) (int, string, error) {
 	return OpaEvalByString(policyPath, string(bytes))
 }
 
+// The same input to the same policy is answered from the decision cache. The OPA server is
+// only checked for a restart when an evaluation has no result, an undefined policy is how a
+// restarted server without our data answers.
 func OpaEvalByString(policyPath string, inputData string) (int, string, error) {
-	if IsOpaRestarted() {
+	key := makeDecisionKey(policyPath, inputData)
+	cached, gen := opaDecisions.get(key)
+	if cached != nil {
+		return cached.statusCode, cached.body, nil
+	}
+
+	statusCode, body, err := opaEvalRequest(policyPath, inputData)
+	if err != nil || statusCode != http.StatusOK || !strings.Contains(body, "result") {
+		if !IsOpaRestarted() {
+			return statusCode, body, err
+		}
 		RestoreOpaData()
+		_, gen = opaDecisions.get(key)
+		if statusCode, body, err = opaEvalRequest(policyPath, inputData); err != nil {
+			return statusCode, body, err
+		}
 	}
 
+	if statusCode == http.StatusOK && strings.Contains(body, "result") {
+		opaDecisions.put(key, gen, statusCode, body)
+	}
+	return statusCode, body, nil
+}
+
+func opaEvalRequest(policyPath string, inputData string) (int, string, error) {
 	client := getOpaHTTPClient()
 
 	// set the HTTP method, url, and request body
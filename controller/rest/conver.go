@@ -166,6 +166,19 @@ func handlerConverList(w http.ResponseWriter, r *http.Request, ps httprouter.Par
 
 	query := restParseQuery(r)
 
+	// Conversations rolled up by group or domain, the edges are not endpoints
+	if value, ok := query.pairs[api.QueryKeyView]; ok &&
+		(value == api.QueryValueViewGroup || value == api.QueryValueViewDomain) {
+		var resp api.RESTConversationsData
+		resp.Endpoints = make([]*api.RESTConversationEndpoint, 0)
+		resp.Convers = cacher.GetRollupConvers(value, acc)
+
+		log.WithFields(log.Fields{"view": value, "conversations": len(resp.Convers)}).Debug("Response")
+
+		restRespSuccess(w, r, &resp, acc, login, nil, "Get conversation list")
+		return
+	}
+
 	var groupFilter, domainFilter string
 	for _, f := range query.filters {
 		if f.tag == api.FilterByGroup && f.op == api.OPeq {
@@ -225,6 +238,17 @@ func handlerConverList(w http.ResponseWriter, r *http.Request, ps httprouter.Par
 			"conversations": len(resp.Convers), "endpoints": len(resp.Endpoints),
 		}).Debug("Response")
 
+		if restCanStream(r, len(resp.Convers)) {
+			stream := newRestStream(w, r)
+			stream.field("endpoints", resp.Endpoints)
+			stream.beginList("conversations")
+			for _, conver := range resp.Convers {
+				stream.add(conver)
+			}
+			stream.endList()
+			stream.close()
+			return
+		}
 		restRespSuccess(w, r, &resp, acc, login, nil, "Get conversation list")
 	} else {
 		var resp api.RESTConversationsData
@@ -235,6 +259,17 @@ func handlerConverList(w http.ResponseWriter, r *http.Request, ps httprouter.Par
 			"conversations": len(resp.Convers), "endpoints": len(resp.Endpoints),
 		}).Debug("Response")
 
+		if restCanStream(r, len(resp.Convers)) {
+			stream := newRestStream(w, r)
+			stream.field("endpoints", resp.Endpoints)
+			stream.beginList("conversations")
+			for _, conver := range resp.Convers {
+				stream.add(conver)
+			}
+			stream.endList()
+			stream.close()
+			return
+		}
 		restRespSuccess(w, r, &resp, acc, login, nil, "Get conversation list")
 	}
 }
@@ -1243,7 +1243,7 @@ func (h *nvCrdHandler) crdHandlePolicyMode(groupName, policyMode, profileMode, b
 
 		if changed {
 			log.WithFields(log.Fields{"group": grp}).Debug("CRD:")
-			err := configPolicyMode(grp)
+			err := configPolicyMode(nil, grp)
 			if err != nil {
 				return
 			}
@@ -143,6 +143,26 @@ var _fedPollingTimer *time.Timer = time.NewTimer(time.Minute * time.Duration(_fe
 var _fedPingInterval uint32 = 1                                                                 // in minutes
 var _fedPingTimer *time.Timer = time.NewTimer(time.Minute * time.Duration(_fedPingInterval))    // for master cluster to ping master clusters
 var _lastFedMemberPingTime time.Time = time.Now()
+
+// Fed rules types a joint cluster polls as the changes since its revisions. The types whose
+// changes couldn't be applied are polled in full the next time. Accessed by the polling only.
+var _fedDeltaTypes = []string{share.FedNetworkRulesType, share.FedGroupType}
+var _fedDeltaFailed = utils.NewStringSet()
+
+// The master notifies joint clusters of changed fed rules in parallel, up to _fedNotifyParallel at
+// a time. A joint cluster that can't be reached is not notified for a while, doubled on each
+// failure; it still polls the master on its polling interval.
+const _fedNotifyParallel = 8
+const _fedNotifyBackoffMin = time.Second * 30
+const _fedNotifyBackoffMax = time.Minute * 10
+
+type tFedNotifyBackoff struct {
+	delay time.Duration
+	until time.Time
+}
+
+var _fedNotifyBackoffs = make(map[string]*tFedNotifyBackoff) // key is cluster id
+var _fedNotifyMutex sync.Mutex
 var _masterClusterIP string
 var _fixedJoinToken string
 
@@ -1224,6 +1244,36 @@ func updateClusterState(id, masterClusterID string, status int, cspUsage *share.
 	return true
 }
 
+func fedNotifyBackedOff(id string, now time.Time) bool {
+	_fedNotifyMutex.Lock()
+	defer _fedNotifyMutex.Unlock()
+
+	b, ok := _fedNotifyBackoffs[id]
+	return ok && now.Before(b.until)
+}
+
+func fedNotifyResult(id string, reached bool) {
+	_fedNotifyMutex.Lock()
+	defer _fedNotifyMutex.Unlock()
+
+	if reached {
+		delete(_fedNotifyBackoffs, id)
+		return
+	}
+	b, ok := _fedNotifyBackoffs[id]
+	if !ok {
+		b = &tFedNotifyBackoff{delay: _fedNotifyBackoffMin}
+		_fedNotifyBackoffs[id] = b
+	} else {
+		b.delay *= 2
+		if b.delay > _fedNotifyBackoffMax {
+			b.delay = _fedNotifyBackoffMax
+		}
+	}
+	b.until = time.Now().Add(b.delay)
+	log.WithFields(log.Fields{"id": id, "delay": b.delay}).Debug("joint cluster not reached")
+}
+
 func notifyDeployFedRules(acc *access.AccessControl, login *loginSession) {
 	userName := common.ReservedFedUser
 	if login != nil {
@@ -1248,19 +1298,26 @@ func notifyDeployFedRules(acc *access.AccessControl, login *loginSession) {
 			User:         userName, // user on master cluster who changes the fed rules settings
 			Revisions:    cacher.GetAllFedRulesRevisions(),
 		}
+		bodyTo, _ := json.Marshal(&reqTo)
+		now := time.Now()
+		sem := make(chan struct{}, _fedNotifyParallel)
 		for id, disabled := range ids {
-			if !disabled {
+			if !disabled && !fedNotifyBackedOff(id, now) {
 				jointCluster := cacher.GetFedJoinedCluster(id, acc)
 				if jointCluster.ID == id {
 					notify++
-					bodyTo, _ := json.Marshal(&reqTo)
-					go talkToJointCluster(&jointCluster, http.MethodPost, "v1/fed/command_internal", id, _tagDeployFedPolicy, bodyTo, ch, acc, login, nil)
+					go func(jointCluster share.CLUSFedJointClusterInfo) {
+						sem <- struct{}{}
+						defer func() { <-sem }()
+						talkToJointCluster(&jointCluster, http.MethodPost, "v1/fed/command_internal", jointCluster.ID, _tagDeployFedPolicy, bodyTo, ch, acc, login, nil)
+					}(jointCluster)
 				}
 			}
 		}
 	}
 	for j := 0; j < notify; j++ {
 		notifyResult := <-ch
+		fedNotifyResult(notifyResult.id, notifyResult.result != _fedClusterDisconnected)
 		updateClusterState(notifyResult.id, "", notifyResult.result, nil, acc)
 	}
 }
@@ -2870,7 +2927,15 @@ func pollFedRules(forcePulling bool, tryTimes int) bool {
 			for ruleType := range reqTo.Revisions {
 				reqTo.Revisions[ruleType] = 0
 			}
+		} else {
+			// types whose changes couldn't be applied in the last polling are polled in full
+			for _, ruleType := range _fedDeltaTypes {
+				if !_fedDeltaFailed.Contains(ruleType) {
+					reqTo.DeltaTypes = append(reqTo.DeltaTypes, ruleType)
+				}
+			}
 		}
+		_fedDeltaFailed.Clear()
 
 		status := _fedClusterDisconnected
 		bodyTo, _ := json.Marshal(&reqTo)
@@ -2921,14 +2986,33 @@ func pollFedRules(forcePulling bool, tryTimes int) bool {
 							log.WithFields(log.Fields{"error": err}).Error("PutFedSettings")
 						}
 					}
-					if respTo.Settings != nil {
+					if respTo.Settings != nil || len(respTo.Deltas) > 0 {
 						var settings api.RESTFedRulesSettings
-						if err = json.Unmarshal(respTo.Settings, &settings); err == nil {
+						if respTo.Settings != nil {
+							err = json.Unmarshal(respTo.Settings, &settings)
+						}
+						if err == nil {
+							fedRevs := respTo.Revisions
+							if len(respTo.Deltas) > 0 {
+								if failed := cacher.BuildFedRulesFromDeltas(&settings, respTo.Deltas, respTo.Revisions, reqTo.Revisions); len(failed) > 0 {
+									fedRevs = make(map[string]uint64, len(respTo.Revisions))
+									for ruleType, rev := range respTo.Revisions {
+										fedRevs[ruleType] = rev
+									}
+									for _, ruleType := range failed {
+										delete(fedRevs, ruleType)
+										_fedDeltaFailed.Add(ruleType)
+									}
+									time.AfterFunc(time.Second, func() { pollFedRules(false, 1) })
+								}
+							}
 							updateClusterState(jointCluster.ID, "", _fedClusterSyncing, nil, accReadAll)
-							if workFedRules(&settings, respTo.Revisions, reqTo.Revisions, accReadAll) {
+							if workFedRules(&settings, fedRevs, reqTo.Revisions, accReadAll) {
 								// if any fed rule is updated, re-send polling request simply for updating joint cluster info on master cluster
 								reqTo.JointTicket = jwtGenFedTicket(jointCluster.Secret, jwtFedJointTicketLife)
-								reqTo.Revisions = respTo.Revisions
+								if _fedDeltaFailed.Cardinality() == 0 {
+									reqTo.Revisions = respTo.Revisions
+								}
 								bodyTo, _ := json.Marshal(&reqTo)
 								_, _, _, _ = sendRestRequest("", http.MethodPost, urlStr, "", "", "", "", nil, bodyTo, true, nil, accReadAll)
 							}
@@ -3242,7 +3326,7 @@ func handlerPollFedRulesInternal(w http.ResponseWriter, r *http.Request, ps http
 		} else {
 			// return fed registry/repo scan data revisions to managed clusters
 			resp.ScanDataRevs, _ = cacher.GetFedScanDataRevisions(true, fedCfg.DeployRepoScanData)
-			resp.Settings, resp.Revisions, _ = cacher.GetFedRules(req.Revisions, accReadAll)
+			resp.Settings, resp.Revisions, resp.Deltas, _ = cacher.GetFedRulesDeltas(req.Revisions, req.DeltaTypes, accReadAll)
 			if len(resp.Revisions) > 0 {
 				status = _fedClusterOutOfSync
 			} else {
@@ -1057,12 +1057,19 @@ func handlerServiceCreate(w http.ResponseWriter, r *http.Request, ps httprouter.
 	restRespSuccess(w, r, nil, acc, login, &rconf, "Create service")
 }
 
-func configPolicyMode(grp *share.CLUSGroup) error {
+// With txn, the profiles are written when the caller applies it; it holds the policy lock
+func configPolicyMode(txn *cluster.ClusterTransact, grp *share.CLUSGroup) error {
 	if pp := clusHelper.GetProcessProfile(grp.Name); pp != nil {
 		if pp.Mode != grp.ProfileMode || pp.Baseline != grp.BaselineProfile {
 			pp.Mode = grp.ProfileMode
 			pp.Baseline = grp.BaselineProfile
-			if err := clusHelper.PutProcessProfile(grp.Name, pp); err != nil {
+			var err error
+			if txn != nil {
+				err = clusHelper.PutProcessProfileTxn(txn, grp.Name, pp)
+			} else {
+				err = clusHelper.PutProcessProfile(grp.Name, pp)
+			}
+			if err != nil {
 				log.WithFields(log.Fields{"error": err}).Error()
 				return err
 			}
@@ -1071,7 +1078,13 @@ func configPolicyMode(grp *share.CLUSGroup) error {
 	if pp, rev := clusHelper.GetFileMonitorProfile(grp.Name); pp != nil {
 		if pp.Mode != grp.ProfileMode {
 			pp.Mode = grp.ProfileMode
-			if err := clusHelper.PutFileMonitorProfile(grp.Name, pp, rev); err != nil {
+			var err error
+			if txn != nil {
+				err = clusHelper.PutFileMonitorProfileTxn(txn, grp.Name, pp)
+			} else {
+				err = clusHelper.PutFileMonitorProfile(grp.Name, pp, rev)
+			}
+			if err != nil {
 				log.WithFields(log.Fields{"error": err}).Error()
 				return err
 			}
@@ -1150,6 +1163,9 @@ func handlerServiceBatchConfig(w http.ResponseWriter, r *http.Request, ps httpro
 	}
 	defer clusHelper.ReleaseLock(lock)
 
+	txn := cluster.Transact()
+	defer txn.Close()
+
 	var qualified bool = false    // Used to respond BadRequest if no group can be configured.
 	var managedByCRD bool = false // Used to respond BadRequest if one group is managed by CRD.
 	for _, svc := range rc.Services {
@@ -1212,13 +1228,13 @@ func handlerServiceBatchConfig(w http.ResponseWriter, r *http.Request, ps httpro
 
 		if changed {
 			if profileChanged || baselineChanged {
-				err := configPolicyMode(grp)
+				err := configPolicyMode(txn, grp)
 				if err != nil {
 					restRespError(w, http.StatusInternalServerError, api.RESTErrFailWriteCluster)
 					return
 				}
 			}
-			if err := clusHelper.PutGroup(grp, false); err != nil {
+			if err := clusHelper.PutGroupTxn(txn, grp); err != nil {
 				log.WithFields(log.Fields{"error": err}).Error()
 				restRespError(w, http.StatusInternalServerError, api.RESTErrFailWriteCluster)
 				return
@@ -1226,6 +1242,11 @@ func handlerServiceBatchConfig(w http.ResponseWriter, r *http.Request, ps httpro
 		}
 	}
 
+	if err := applyGroupsTxn(txn); err != nil {
+		restRespError(w, http.StatusInternalServerError, api.RESTErrFailWriteCluster)
+		return
+	}
+
 	if !qualified {
 		var status int = http.StatusNotFound
 		var code int = api.RESTErrObjectNotFound
@@ -1248,6 +1269,9 @@ func setServicePolicyModeAll(policy_mode, profile_mode string, acc *access.Acces
 	}
 	defer clusHelper.ReleaseLock(lock)
 
+	txn := cluster.Transact()
+	defer txn.Close()
+
 	grps := clusHelper.GetAllGroups(share.ScopeLocal, acc)
 	for name, grp := range grps {
 		if isManagedByCRD(name, acc) {
@@ -1265,16 +1289,29 @@ func setServicePolicyModeAll(policy_mode, profile_mode string, acc *access.Acces
 		}
 		if profile_mode != "" {
 			grp.ProfileMode = profile_mode
-			err = configPolicyMode(grp)
+			err = configPolicyMode(txn, grp)
 			if err != nil {
 				return err
 			}
 		}
-		if err := clusHelper.PutGroup(grp, false); err != nil {
+		if err := clusHelper.PutGroupTxn(txn, grp); err != nil {
 			log.WithFields(log.Fields{"error": err}).Error()
 			return err
 		}
 	}
+	return applyGroupsTxn(txn)
+}
+
+// The groups of a change to all of them are written in transactions, not a key at a time
+func applyGroupsTxn(txn *cluster.ClusterTransact) error {
+	if ok, err := txn.Apply(); err != nil {
+		log.WithFields(log.Fields{"error": err}).Error()
+		return err
+	} else if !ok {
+		err = errors.New("Atomic write to the cluster failed")
+		log.WithFields(log.Fields{"error": err}).Error()
+		return err
+	}
 	return nil
 }
 
@@ -1287,6 +1324,9 @@ func setServiceProcessBaslineAll(option string, acc *access.AccessControl) error
 	}
 	defer clusHelper.ReleaseLock(lock)
 
+	txn := cluster.Transact()
+	defer txn.Close()
+
 	var changed bool
 	grps := clusHelper.GetAllGroups(share.ScopeLocal, acc)
 	for name, grp := range grps {
@@ -1309,19 +1349,19 @@ func setServiceProcessBaslineAll(option string, acc *access.AccessControl) error
 		if changed {
 			if pp := clusHelper.GetProcessProfile(grp.Name); pp != nil {
 				pp.Baseline = grp.BaselineProfile
-				if err := clusHelper.PutProcessProfile(grp.Name, pp); err != nil {
+				if err := clusHelper.PutProcessProfileTxn(txn, grp.Name, pp); err != nil {
 					log.WithFields(log.Fields{"error": err}).Error()
 					return err
 				}
 			}
 
-			if err := clusHelper.PutGroup(grp, false); err != nil {
+			if err := clusHelper.PutGroupTxn(txn, grp); err != nil {
 				log.WithFields(log.Fields{"error": err}).Error()
 				return err
 			}
 		}
 	}
-	return nil
+	return applyGroupsTxn(txn)
 }
 
 func handlerServiceList(w http.ResponseWriter, r *http.Request, ps httprouter.Params) {
@@ -1597,6 +1637,9 @@ func handlerServiceBatchConfigNetwork(w http.ResponseWriter, r *http.Request, ps
 	}
 	defer clusHelper.ReleaseLock(lock)
 
+	txn := cluster.Transact()
+	defer txn.Close()
+
 	var qualified bool = false    // Used to respond BadRequest if no group can be configured.
 	var managedByCRD bool = false // Used to respond BadRequest if one group is managed by CRD.
 	for _, svc := range rc.Services {
@@ -1631,7 +1674,7 @@ func handlerServiceBatchConfigNetwork(w http.ResponseWriter, r *http.Request, ps
 		}
 
 		if changed {
-			if err := clusHelper.PutGroup(grp, false); err != nil {
+			if err := clusHelper.PutGroupTxn(txn, grp); err != nil {
 				log.WithFields(log.Fields{"error": err}).Error()
 				restRespError(w, http.StatusInternalServerError, api.RESTErrFailWriteCluster)
 				return
@@ -1639,6 +1682,11 @@ func handlerServiceBatchConfigNetwork(w http.ResponseWriter, r *http.Request, ps
 		}
 	}
 
+	if err := applyGroupsTxn(txn); err != nil {
+		restRespError(w, http.StatusInternalServerError, api.RESTErrFailWriteCluster)
+		return
+	}
+
 	if !qualified {
 		var status int = http.StatusNotFound
 		var code int = api.RESTErrObjectNotFound
@@ -1692,6 +1740,9 @@ func handlerServiceBatchConfigProfile(w http.ResponseWriter, r *http.Request, ps
 	}
 	defer clusHelper.ReleaseLock(lock)
 
+	txn := cluster.Transact()
+	defer txn.Close()
+
 	var qualified bool = false    // Used to respond BadRequest if no group can be configured.
 	var managedByCRD bool = false // Used to respond BadRequest if one group is managed by CRD.
 	for _, svc := range rc.Services {
@@ -1741,14 +1792,14 @@ func handlerServiceBatchConfigProfile(w http.ResponseWriter, r *http.Request, ps
 
 		if changed {
 			if profileChanged || baselineChanged {
-				err := configPolicyMode(grp)
+				err := configPolicyMode(txn, grp)
 				if err != nil {
 					restRespError(w, http.StatusInternalServerError, api.RESTErrFailWriteCluster)
 					return
 				}
 			}
 
-			if err := clusHelper.PutGroup(grp, false); err != nil {
+			if err := clusHelper.PutGroupTxn(txn, grp); err != nil {
 				log.WithFields(log.Fields{"error": err}).Error()
 				restRespError(w, http.StatusInternalServerError, api.RESTErrFailWriteCluster)
 				return
@@ -1756,6 +1807,11 @@ func handlerServiceBatchConfigProfile(w http.ResponseWriter, r *http.Request, ps
 		}
 	}
 
+	if err := applyGroupsTxn(txn); err != nil {
+		restRespError(w, http.StatusInternalServerError, api.RESTErrFailWriteCluster)
+		return
+	}
+
 	if !qualified {
 		var status int = http.StatusNotFound
 		var code int = api.RESTErrObjectNotFound
@@ -170,6 +170,18 @@ func (m *mockCache) GetAllPolicyRules(scope string, acc *access.AccessControl) [
 	return rules
 }
 
+func (m *mockCache) GetPolicyRulesPage(scope string, acc *access.AccessControl, start, limit int) []*api.RESTPolicyRule {
+	rules := m.GetAllPolicyRules(scope, acc)
+	if len(rules) <= start {
+		return make([]*api.RESTPolicyRule, 0)
+	}
+	rules = rules[start:]
+	if limit > 0 && limit < len(rules) {
+		rules = rules[:limit]
+	}
+	return rules
+}
+
 func (m *mockCache) CheckPolicyRuleAccess(id uint32, accRead *access.AccessControl, accWrite *access.AccessControl) (bool, bool, bool) {
 	var found bool
 	var readable, writable bool
@@ -76,25 +76,9 @@ func handlerPolicyRuleList(w http.ResponseWriter, r *http.Request, ps httprouter
 	}
 
 	var resp api.RESTPolicyRulesData
-	resp.Rules = make([]*api.RESTPolicyRule, 0)
-	rules := cacher.GetAllPolicyRules(scope, acc)
-
-	// Filter
-	if len(rules) <= query.start {
-		restRespSuccess(w, r, &resp, acc, login, nil, "Get policy rule list")
-		return
-	}
-
-	if query.limit == 0 {
-		resp.Rules = rules[query.start:]
-	} else {
-		var end int
-		if query.start+query.limit > len(rules) {
-			end = len(rules)
-		} else {
-			end = query.start + query.limit
-		}
-		resp.Rules = rules[query.start:end]
+	resp.Rules = cacher.GetPolicyRulesPage(scope, acc, query.start, query.limit)
+	if resp.Rules == nil {
+		resp.Rules = make([]*api.RESTPolicyRule, 0)
 	}
 	for _, rule := range resp.Rules {
 		if rule.Learned && rule.CfgType == "" {
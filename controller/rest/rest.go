@@ -204,18 +204,9 @@ func restRespPartial(w http.ResponseWriter, r *http.Request, resp interface{}) {
 		var e common.EmptyMarshaller
 		data, _ = e.Marshal(resp)
 
-		if hdrs, ok := r.Header["Accept-Encoding"]; ok {
-		loop:
-			for _, hdr := range hdrs {
-				// Accept-Encoding: gzip, deflate
-				for _, enc := range strings.Split(hdr, ",") {
-					if enc == "gzip" {
-						w.Header().Set("Content-Encoding", "gzip")
-						data = utils.GzipBytes(data)
-						break loop
-					}
-				}
-			}
+		if restAcceptGzip(r) {
+			w.Header().Set("Content-Encoding", "gzip")
+			data = utils.GzipBytes(data)
 		}
 	}
 	w.Header().Set("Content-Type", jsonContentType)
@@ -253,20 +244,9 @@ func restRespSuccess(w http.ResponseWriter, r *http.Request, resp interface{},
 			}
 		}
 
-		if len(data) > gzipThreshold {
-			if hdrs, ok := r.Header["Accept-Encoding"]; ok {
-			loop:
-				for _, hdr := range hdrs {
-					// Accept-Encoding: gzip, deflate
-					for _, enc := range strings.Split(hdr, ",") {
-						if enc == "gzip" {
-							w.Header().Set("Content-Encoding", "gzip")
-							data = utils.GzipBytes(data)
-							break loop
-						}
-					}
-				}
-			}
+		if len(data) > gzipThreshold && restAcceptGzip(r) {
+			w.Header().Set("Content-Encoding", "gzip")
+			data = utils.GzipBytes(data)
 		}
 	}
 	w.Header().Set("Content-Type", ct)
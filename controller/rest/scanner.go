@@ -286,20 +286,11 @@ func handlerScanImageReport(w http.ResponseWriter, r *http.Request, ps httproute
 		showTag = api.QueryValueShowAccepted
 	}
 
-	cached := cacher.GetAllWorkloadsBrief("", acc)
-
-	var brief *api.RESTWorkloadBrief
-	for _, wl := range cached {
-		if wl.ImageID == id && wl.ScanSummary != nil && wl.ScanSummary.Status == api.ScanStatusFinished {
-			brief = wl
-			break
-		}
-	}
-
-	if brief == nil {
+	wlID := cacher.GetScanImageWorkload(id, acc)
+	if wlID == "" {
 		restRespError(w, http.StatusNotFound, api.RESTErrObjectNotFound)
 	} else {
-		vuls, _, err := cacher.GetVulnerabilityReport(brief.ID, showTag)
+		vuls, _, err := cacher.GetVulnerabilityReport(wlID, showTag)
 		if vuls == nil {
 			restRespNotFoundLogAccessDenied(w, login, err)
 			return
@@ -324,31 +315,8 @@ func handlerScanImageSummary(w http.ResponseWriter, r *http.Request, ps httprout
 		query.sorts = append(query.sorts, restFieldSort{tag: "image", asc: true})
 	}
 
-	cached := cacher.GetAllWorkloadsBrief("", acc)
-
-	// remove duplicate results for the same image
-	var imageMap map[string]*api.RESTScanImageSummary = make(map[string]*api.RESTScanImageSummary)
-	for _, wl := range cached {
-		if wl.ScanSummary == nil || wl.ScanSummary.Status != api.ScanStatusFinished {
-			continue
-		}
-
-		if !acc.Authorize(&share.CLUSWorkloadScanDummy{Domain: wl.Domain}, nil) {
-			continue
-		}
-
-		w := wl.ScanSummary
-
-		old, ok := imageMap[wl.ImageID]
-		if !ok || old.HighVuls < w.HighVuls || (old.HighVuls == w.HighVuls && old.MedVuls < w.MedVuls) {
-			img := api.RESTScanImageSummary{
-				Image:         wl.Image,
-				ImageID:       wl.ImageID,
-				RESTScanBrief: *w,
-			}
-			imageMap[wl.ImageID] = &img
-		}
-	}
+	// one result for the same image
+	imageMap := cacher.GetScanImageSummaries(acc)
 
 	// Sort
 	var result []*api.RESTScanImageSummary
@@ -769,6 +737,20 @@ func handlerAssetVulnerability(w http.ResponseWriter, r *http.Request, ps httpro
 	}
 
 	log.WithFields(log.Fields{"entries": len(resp.Vuls)}).Debug("Response")
+	if restCanStream(r, len(resp.Vuls)) {
+		stream := newRestStream(w, r)
+		stream.beginList("vulnerabilities")
+		for _, vul := range resp.Vuls {
+			stream.add(vul)
+		}
+		stream.endList()
+		stream.field("workloads", resp.Workloads)
+		stream.field("nodes", resp.Nodes)
+		stream.field("images", resp.Images)
+		stream.field("platforms", resp.Platforms)
+		stream.close()
+		return
+	}
 	restRespSuccess(w, r, resp, acc, login, nil, "Get vulnerabiility asset report")
 }
 
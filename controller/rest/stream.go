@@ -0,0 +1,150 @@
+package rest
+
+import (
+	"compress/gzip"
+	"encoding/json"
+	"io"
+	"net/http"
+	"strings"
+
+	log "github.com/sirupsen/logrus"
+
+	"github.com/neuvector/neuvector/controller/common"
+)
+
+// Large list responses are written entry by entry instead of being marshaled into one buffer.
+// The handler opens the response object, adds its lists and fields and closes it; the body is
+// sent chunked, gzip'ed when the client accepts it, and each entry is masked the same way as
+// restRespSuccess() does. Gob responses and short lists still go through restRespSuccess().
+
+const restStreamMinEntries = 256
+const restStreamFlushSize = 64 * 1024
+
+type restStream struct {
+	w       http.ResponseWriter
+	out     io.Writer
+	gz      *gzip.Writer
+	mask    bool
+	first   bool // no member or entry written at this level yet
+	pending int  // bytes written since the last flush
+	err     error
+}
+
+// Accept-Encoding: gzip, deflate
+func restAcceptGzip(r *http.Request) bool {
+	if hdrs, ok := r.Header["Accept-Encoding"]; ok {
+		for _, hdr := range hdrs {
+			for _, enc := range strings.Split(hdr, ",") {
+				if enc == "gzip" {
+					return true
+				}
+			}
+		}
+	}
+	return false
+}
+
+func restCanStream(r *http.Request, entries int) bool {
+	return entries >= restStreamMinEntries && r.Header.Get("Accept") != "application/gob"
+}
+
+func newRestStream(w http.ResponseWriter, r *http.Request) *restStream {
+	s := &restStream{w: w, out: w, mask: restIsSupportReq(r), first: true}
+
+	w.Header().Set("Content-Type", jsonContentType)
+	w.Header().Set("Cache-Control", "no-cache")
+	if restAcceptGzip(r) {
+		w.Header().Set("Content-Encoding", "gzip")
+		s.gz = gzip.NewWriter(w)
+		s.out = s.gz
+	}
+	w.WriteHeader(http.StatusOK)
+	s.write([]byte("{"))
+	return s
+}
+
+func (s *restStream) write(data []byte) {
+	if s.err != nil {
+		return
+	}
+	if _, s.err = s.out.Write(data); s.err != nil {
+		log.WithFields(log.Fields{"error": s.err}).Debug("Write")
+		return
+	}
+	s.pending += len(data)
+	if s.pending >= restStreamFlushSize {
+		s.flush()
+	}
+}
+
+func (s *restStream) flush() {
+	s.pending = 0
+	if s.gz != nil {
+		s.gz.Flush()
+	}
+	if f, ok := s.w.(http.Flusher); ok {
+		f.Flush()
+	}
+}
+
+func (s *restStream) marshal(v interface{}) []byte {
+	var data []byte
+	var err error
+	if s.mask {
+		var m common.MaskMarshaller
+		data, err = m.Marshal(v)
+	} else {
+		var e common.EmptyMarshaller
+		data, err = e.Marshal(v)
+	}
+	if err != nil {
+		log.WithFields(log.Fields{"error": err}).Error("Marshal")
+		return []byte("null")
+	}
+	return data
+}
+
+func (s *restStream) name(name string) {
+	if !s.first {
+		s.write([]byte(","))
+	}
+	s.first = false
+	key, _ := json.Marshal(name)
+	s.write(key)
+	s.write([]byte(":"))
+}
+
+// A member of the response object
+func (s *restStream) field(name string, v interface{}) {
+	s.name(name)
+	s.write(s.marshal(v))
+}
+
+// A list member of the response object, its entries are added by add()
+func (s *restStream) beginList(name string) {
+	s.name(name)
+	s.write([]byte("["))
+	s.first = true
+}
+
+func (s *restStream) add(entry interface{}) {
+	if !s.first {
+		s.write([]byte(","))
+	}
+	s.first = false
+	s.write(s.marshal(entry))
+}
+
+func (s *restStream) endList() {
+	s.write([]byte("]"))
+	s.first = false
+}
+
+func (s *restStream) close() {
+	s.write([]byte("}"))
+	if s.gz != nil && s.err == nil {
+		if err := s.gz.Close(); err != nil {
+			log.WithFields(log.Fields{"error": err}).Debug("Write")
+		}
+	}
+}
@@ -342,6 +342,21 @@ func handlerWorkloadListBase(apiVer string, w http.ResponseWriter, r *http.Reque
 
 	log.WithFields(log.Fields{"entries": len(respV1.Workloads)}).Debug("Response")
 
+	if restCanStream(r, len(respV1.Workloads)) {
+		stream := newRestStream(w, r)
+		stream.beginList("workloads")
+		for _, wlV1 := range respV1.Workloads {
+			if apiVer != "v2" {
+				stream.add(wlV1)
+			} else if wlV2 := workloadV1ToV2(wlV1); wlV2 != nil {
+				stream.add(wlV2)
+			}
+		}
+		stream.endList()
+		stream.close()
+		return
+	}
+
 	if apiVer == "v2" {
 		respV2.Workloads = make([]*api.RESTWorkloadV2, 0, len(respV1.Workloads))
 		for _, wlV1 := range respV1.Workloads {
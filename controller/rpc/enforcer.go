@@ -202,6 +202,19 @@ func GetDerivedPolicyRules(agentID string, f *share.CLUSFilter) (*share.CLUSDeri
 	return client.GetDerivedPolicyRules(ctx, f)
 }
 
+// Sessions the agent's dp decided by each policy rule, the counts start over if reset is set
+func GetPolicyRuleHits(agentID string, reset bool) (*share.CLUSPolicyRuleHitArray, error) {
+	client, err := findEnforcerServiceClient(agentID)
+	if err != nil {
+		return nil, err
+	}
+
+	ctx, cancel := context.WithTimeout(context.Background(), defaultReqTimeout)
+	defer cancel()
+
+	return client.GetPolicyRuleHits(ctx, &share.CLUSPolicyRuleHitReq{ResetHits: reset})
+}
+
 func ProbeSummary(agentID string) (*share.CLUSProbeSummary, error) {
 	client, err := findEnforcerServiceClient(agentID)
 	if err != nil {
@@ -62,6 +62,11 @@ func (mgr *ScanCreditManager) releaseScanCredit(sid string) {
 // unlocks the mutex, and returns the scanner's ID. If no scanner is available, it waits for a signal on the creditPool channel
 // indicating that a scanner has become available.
 func (mgr *ScanCreditManager) acquireScanCredit() (string, error) {
+	return mgr.acquireScanCreditFor("")
+}
+
+// acquireScanCreditFor prefers the scanner the affinity key is pinned to, see PickScanner().
+func (mgr *ScanCreditManager) acquireScanCreditFor(affinity string) (string, error) {
 	for {
 		// Wait for a scanner to become available or timeout to avoid indefinite blocking
 		select {
@@ -70,9 +75,9 @@ func (mgr *ScanCreditManager) acquireScanCredit() (string, error) {
 			defer mgr.mutex.Unlock()
 
 			// Use a heap to find the scanner with the least active tasks
-			scanner, err := mgr.scannerLoadBalancer.PickLeastLoadedScanner()
+			scanner, err := mgr.scannerLoadBalancer.PickScanner(affinity)
 			if err != nil {
-				log.WithFields(log.Fields{"error": err}).Error("PickLeastLoadedScanner")
+				log.WithFields(log.Fields{"error": err}).Error("PickScanner")
 				return "", err
 			}
 			return scanner.ID, nil
@@ -82,6 +87,14 @@ func (mgr *ScanCreditManager) acquireScanCredit() (string, error) {
 	}
 }
 
+func (mgr *ScanCreditManager) recordScanTime(sid string, scanTime time.Duration) {
+	mgr.mutex.Lock()
+	defer mgr.mutex.Unlock()
+
+	// the scanner may have been removed during the scan
+	_ = mgr.scannerLoadBalancer.RecordScanTime(sid, scanTime)
+}
+
 func (mgr *ScanCreditManager) signalScanCredit() {
 	select {
 	case mgr.creditPool <- struct{}{}:
@@ -321,7 +334,8 @@ func ScanImage(scanner string, ctx context.Context, req *share.ScanImageRequest)
 	// In this case, we set shouldIncrementTask to false to avoid double counting.
 	if scanner == "" {
 		var err error
-		scanner, err = ScanCreditMgr.acquireScanCredit()
+		// images of a repository share layers, keep them on one scanner
+		scanner, err = ScanCreditMgr.acquireScanCreditFor(req.Registry + "/" + req.Repository)
 		if err != nil {
 			return nil, err
 		}
@@ -345,8 +359,10 @@ func ScanImage(scanner string, ctx context.Context, req *share.ScanImageRequest)
 		return nil, err
 	}
 
+	start := time.Now()
 	result, err := client.ScanImage(ctx, req)
 	if err == nil {
+		ScanCreditMgr.recordScanTime(scanner, time.Since(start))
 		if result.Labels == nil {
 			// grpc convert zero-length map to nil, fix it here.
 			result.Labels = make(map[string]string)
@@ -173,6 +173,7 @@ type registryDriver interface {
 	GetTagList(doamin, repo, tag string) ([]string, error)
 	GetAllImages() (map[share.CLUSImage][]string, error)
 	GetImageMeta(ctx context.Context, domain, repo, tag string) (*scanUtils.ImageInfo, share.ScanErrorCode)
+	ConcurrentImageMeta() bool
 	ScanImage(scanner string, ctx context.Context, id, digest, repo, tag string, scanTypesRequired share.ScanTypeMap) *share.ScanResult
 	SetConfig(cfg *share.CLUSRegistryConfig)
 	SetProxy()
@@ -294,6 +295,11 @@ func (r *base) GetImageMeta(ctx context.Context, domain, repo, tag string) (*sca
 	return rinfo, errCode
 }
 
+// GetImageMeta() can be called for several tags at the same time
+func (r *base) ConcurrentImageMeta() bool {
+	return true
+}
+
 func makeSigstoreScanRequestObj() ([]*share.SigstoreRootOfTrust, error) {
 	clusRootsOfTrust, err := clusHelper.GetAllSigstoreRootsOfTrust()
 	if err != nil {
@@ -142,6 +142,11 @@ func (r *openshift) GetTagList(domain, repo, tag string) ([]string, error) {
 	return list, nil
 }
 
+// The token is renewed when the image meta is requested
+func (r *openshift) ConcurrentImageMeta() bool {
+	return false
+}
+
 func (r *openshift) GetImageMeta(ctx context.Context, domain, repo, tag string) (*scanUtils.ImageInfo, share.ScanErrorCode) {
 	img := share.CLUSImage{Repo: repo, Domain: domain, Tag: tag}
 	ibMutex.RLock()
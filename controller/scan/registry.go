@@ -33,6 +33,8 @@ const (
 	scanReqSafetyTimeOut = time.Minute * 30 // Should be longer than scanReqTimeout
 
 	scanPersistImageExtra = 32
+
+	registryMetaFetchers = 8 // image manifests requested at the same time in a registry scan
 )
 
 type scanContext struct {
@@ -1557,6 +1559,64 @@ func (rs *Registry) scheduleScanImagesOnDemand(sctx *scanContext, imageMap map[s
 	}
 }
 
+type imageMetaResult struct {
+	info    *scanUtils.ImageInfo
+	errCode share.ScanErrorCode
+}
+
+// Get the manifests of the tags of itfList, registryMetaFetchers at a time if the driver allows
+// it, and return them in the order of the tags. After the scan is canceled, the remaining ones
+// are not requested and left nil.
+func fetchImageMetas(ctx context.Context, drv registryDriver, itfList []*share.CLUSImage, tagList [][]string) []*imageMetaResult {
+	type metaReq struct {
+		itf *share.CLUSImage
+		tag string
+	}
+
+	reqs := make([]metaReq, 0)
+	for i, itf := range itfList {
+		for _, tag := range tagList[i] {
+			reqs = append(reqs, metaReq{itf: itf, tag: tag})
+		}
+	}
+	metas := make([]*imageMetaResult, len(reqs))
+
+	workers := registryMetaFetchers
+	if !drv.ConcurrentImageMeta() {
+		workers = 1
+	}
+	if workers > len(reqs) {
+		workers = len(reqs)
+	}
+
+	var next int
+	var mutex sync.Mutex
+	var wg sync.WaitGroup
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for {
+				mutex.Lock()
+				i := next
+				next++
+				mutex.Unlock()
+				if i >= len(reqs) {
+					return
+				}
+				if ctx != nil && ctx.Err() != nil {
+					return
+				}
+				info, errCode := drv.GetImageMeta(ctx, reqs[i].itf.Domain, reqs[i].itf.Repo, reqs[i].tag)
+				metas[i] = &imageMetaResult{info: info, errCode: errCode}
+			}
+		}()
+	}
+	wg.Wait()
+
+	return metas
+}
+
 // Lock protected
 func (rs *Registry) scheduleScanImages(
 	sctx *scanContext, drv registryDriver, itfList []*share.CLUSImage, tagList [][]string,
@@ -1571,12 +1631,20 @@ func (rs *Registry) scheduleScanImages(
 		smd.scanLog.WithFields(log.Fields{"error": err.Error()}).Debug("Failed to get sigstore timestamp")
 	}
 
+	metas := fetchImageMetas(sctx.ctx, drv, itfList, tagList)
+	var n int
 	for i := 0; i < len(itfList); i++ {
 		itf := itfList[i]
 		tags := tagList[i]
 
 		for _, tag := range tags {
-			info, errCode := drv.GetImageMeta(sctx.ctx, itf.Domain, itf.Repo, tag)
+			meta := metas[n]
+			n++
+			if meta == nil {
+				// scan canceled
+				continue
+			}
+			info, errCode := meta.info, meta.errCode
 			if errCode != share.ScanErrorCode_ScanErrNone {
 				smd.scanLog.WithFields(log.Fields{
 					"repo": itf, "tag": tag, "error": scanUtils.ScanErrorToStr(errCode),
@@ -2,7 +2,9 @@ package scannerlb
 
 import (
 	"fmt"
+	"hash/fnv"
 	"sync"
+	"time"
 
 	"github.com/neuvector/neuvector/share"
 )
@@ -16,24 +18,34 @@ import (
 // - Thread-safe operations via mutex locking
 // - Dynamic registration/unregistration of scanners
 // - Credit-based workload tracking per scanner
+// - Scanners weighted by their recent scan time, and scans of the same repository kept on
+//   the same scanner, as the images of a repository mostly share their base layers
 //
 // The load balancer ensures optimal resource utilization by:
-// 1. Always selecting the scanner with the most available scan credits for new tasks
+// 1. Selecting the scanner with the most available scan credits per scan time for new tasks
 // 2. Tracking and updating scan credits as tasks complete
 // 3. Maintaining an accurate view of system-wide scanner capacity
 //
 // Usage:
 // - Register scanners with initial scan credit allocation
-// - Pick scanner for new scan tasks via PickLeastLoadedScanner()
+// - Pick scanner for new scan tasks via PickLeastLoadedScanner(), or PickScanner() with an affinity key
+// - Report the scan time via RecordScanTime() when a scan completes
 // - Release scan credits when tasks complete via ReleaseScanCredit()
 // - Remove scanners via UnregisterScanner() when they go offline
 
 // ScannerEntry represents an active scanner instance and its running tasks.
 type ScannerEntry struct {
 	Scanner              *share.CLUSScanner
-	AvailableScanCredits int // Number of currently running scanner tasks
+	AvailableScanCredits int           // Number of currently running scanner tasks
+	ScanTime             time.Duration // Moving average of the scan time, 0 before the first scan
 }
 
+// Weight of the last scan in the moving average of a scanner's scan time
+const scanTimeWeight = 8
+
+// An affinity scanner is kept while it is at least this fraction as good as the best one
+const affinityMinRatio = 0.5
+
 // ScannerLoadBalancer manages scanner workload using a B-tree heap.
 type ScannerLoadBalancer struct {
 	mutex          sync.RWMutex
@@ -95,12 +107,38 @@ func (lb *ScannerLoadBalancer) ReleaseScanCredit(scannerId string) error {
 	return fmt.Errorf("scanner %s not found", scannerId)
 }
 
+func (lb *ScannerLoadBalancer) RecordScanTime(scannerId string, scanTime time.Duration) error {
+	lb.mutex.Lock()
+	defer lb.mutex.Unlock()
+
+	for _, entry := range lb.ActiveScanners {
+		if entry.Scanner.ID == scannerId {
+			if entry.ScanTime == 0 {
+				entry.ScanTime = scanTime
+			} else {
+				entry.ScanTime += (scanTime - entry.ScanTime) / scanTimeWeight
+			}
+			return nil
+		}
+	}
+	return fmt.Errorf("scanner %s not found", scannerId)
+}
+
 // No mutex here, because it's called by PickLeastLoadedScanner, which already has a mutex.
 // func (lb *ScannerLoadBalancer) acquireScanCredit(scannerId string) error {
 // 	return lb.updateScanCredit(scannerId, -1)
 // }
 
 func (lb *ScannerLoadBalancer) PickLeastLoadedScanner() (*share.CLUSScanner, error) {
+	return lb.PickScanner("")
+}
+
+// PickScanner picks the scanner with the most available scan credits per scan time; a scanner
+// yet to finish a scan counts with the average scan time. With an affinity key, like the
+// repository of an image, the scanner the key hashes to is picked unless it is much worse than
+// the best one. The key is hashed with each scanner ID (rendezvous hashing) so it stays on its
+// scanner while other scanners come and go.
+func (lb *ScannerLoadBalancer) PickScanner(affinity string) (*share.CLUSScanner, error) {
 	lb.mutex.Lock()
 	defer lb.mutex.Unlock()
 
@@ -108,21 +146,51 @@ func (lb *ScannerLoadBalancer) PickLeastLoadedScanner() (*share.CLUSScanner, err
 		return nil, fmt.Errorf("no scanner found")
 	}
 
-	maxScanCredits := -1 // Initialize to an impossible value
-	maxScanCreditsIndex := -1
-
-	for i := 0; i < len(lb.ActiveScanners); i++ {
-		scanCredits := lb.ActiveScanners[i].AvailableScanCredits
-		if (maxScanCreditsIndex == -1 || scanCredits > maxScanCredits) && scanCredits > 0 {
-			maxScanCredits = scanCredits
-			maxScanCreditsIndex = i
+	var totalScanTime time.Duration
+	var timedScanners int
+	for _, entry := range lb.ActiveScanners {
+		if entry.ScanTime > 0 {
+			totalScanTime += entry.ScanTime
+			timedScanners++
+		}
+	}
+	avgScanTime := time.Duration(1)
+	if timedScanners > 0 {
+		avgScanTime = totalScanTime / time.Duration(timedScanners)
+	}
+	score := func(entry *ScannerEntry) float64 {
+		scanTime := entry.ScanTime
+		if scanTime == 0 {
+			scanTime = avgScanTime
 		}
+		return float64(entry.AvailableScanCredits) / float64(scanTime)
 	}
 
-	if maxScanCreditsIndex != -1 {
-		lb.ActiveScanners[maxScanCreditsIndex].AvailableScanCredits--
-		return lb.ActiveScanners[maxScanCreditsIndex].Scanner, nil
+	best, bestScore := -1, 0.0
+	pinned, pinnedHash := -1, uint64(0)
+	for i, entry := range lb.ActiveScanners {
+		if entry.AvailableScanCredits <= 0 {
+			continue
+		}
+		if sc := score(entry); best == -1 || sc > bestScore {
+			best, bestScore = i, sc
+		}
+		if affinity != "" {
+			h := fnv.New64a()
+			h.Write([]byte(affinity))
+			h.Write([]byte(entry.Scanner.ID))
+			if sum := h.Sum64(); pinned == -1 || sum > pinnedHash {
+				pinned, pinnedHash = i, sum
+			}
+		}
 	}
 
-	return nil, fmt.Errorf("no scanner available")
+	if best == -1 {
+		return nil, fmt.Errorf("no scanner available")
+	}
+	if pinned != -1 && score(lb.ActiveScanners[pinned]) >= bestScore*affinityMinRatio {
+		best = pinned
+	}
+	lb.ActiveScanners[best].AvailableScanCredits--
+	return lb.ActiveScanners[best].Scanner, nil
 }
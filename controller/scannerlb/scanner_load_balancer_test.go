@@ -4,6 +4,7 @@ import (
 	"fmt"
 	"sync"
 	"testing"
+	"time"
 
 	"github.com/neuvector/neuvector/share"
 	"github.com/stretchr/testify/assert"
@@ -95,6 +96,67 @@ func TestPickLeastLoadedScanner(t *testing.T) {
 	assert.Nil(t, pickedScanner)
 }
 
+func TestPickScannerByScanTime(t *testing.T) {
+	lb := NewScannerLoadBalancer()
+	scanner1 := &share.CLUSScanner{ID: "scanner1"}
+	scanner2 := &share.CLUSScanner{ID: "scanner2"}
+
+	lb.RegisterScanner(scanner1, 4)
+	lb.RegisterScanner(scanner2, 3)
+
+	// scanner2 scans 4 times faster, so 3 credits of scanner2 are worth more than 4 of scanner1
+	assert.Nil(t, lb.RecordScanTime(scanner1.ID, 4*time.Second))
+	assert.Nil(t, lb.RecordScanTime(scanner2.ID, time.Second))
+	assert.NotNil(t, lb.RecordScanTime("scanner3", time.Second))
+
+	pickedScanner, err := lb.PickLeastLoadedScanner()
+	assert.Nil(t, err)
+	assert.Equal(t, scanner2.ID, pickedScanner.ID)
+
+	// moving average
+	assert.Nil(t, lb.RecordScanTime(scanner2.ID, 9*time.Second))
+	scannerEntry, _ := lb.GetScanner(scanner2.ID)
+	assert.Equal(t, 2*time.Second, scannerEntry.ScanTime)
+}
+
+func TestPickScannerAffinity(t *testing.T) {
+	lb := NewScannerLoadBalancer()
+	scanners := prepareScanners(4)
+	for _, scanner := range scanners {
+		lb.RegisterScanner(scanner, 4)
+	}
+
+	// the same key goes to the same scanner while it has credits
+	pickedScanner, err := lb.PickScanner("registry/nginx")
+	assert.Nil(t, err)
+	for i := 0; i < 2; i++ {
+		s, err := lb.PickScanner("registry/nginx")
+		assert.Nil(t, err)
+		assert.Equal(t, pickedScanner.ID, s.ID)
+	}
+
+	// until it is much more loaded than the others
+	s, err := lb.PickScanner("registry/nginx")
+	assert.Nil(t, err)
+	assert.NotEqual(t, pickedScanner.ID, s.ID)
+
+	// the key stays on its scanner when another scanner leaves
+	lb = NewScannerLoadBalancer()
+	for _, scanner := range scanners {
+		lb.RegisterScanner(scanner, 4)
+	}
+	for _, scanner := range scanners {
+		if scanner.ID != pickedScanner.ID {
+			_, err = lb.UnregisterScanner(scanner.ID)
+			assert.Nil(t, err)
+			break
+		}
+	}
+	s, err = lb.PickScanner("registry/nginx")
+	assert.Nil(t, err)
+	assert.Equal(t, pickedScanner.ID, s.ID)
+}
+
 func prepareScanners(numScanners int) []*share.CLUSScanner {
 	scanners := make([]*share.CLUSScanner, numScanners)
 	for i := 0; i < numScanners; i++ {
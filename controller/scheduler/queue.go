@@ -0,0 +1,99 @@
+package scheduler
+
+import (
+	"container/heap"
+)
+
+// A task queue is a heap ordered by the position each task was given when added: tasks added
+// to the head get decreasing positions, tasks added to the tail increasing ones, so it pops
+// in the same order as a list would. Tasks are also indexed by key, a key is queued only once.
+
+type queueItem struct {
+	task  Task
+	order int64
+	index int
+}
+
+type taskHeap []*queueItem
+
+func (h taskHeap) Len() int           { return len(h) }
+func (h taskHeap) Less(i, j int) bool { return h[i].order < h[j].order }
+
+func (h taskHeap) Swap(i, j int) {
+	h[i], h[j] = h[j], h[i]
+	h[i].index = i
+	h[j].index = j
+}
+
+func (h *taskHeap) Push(x interface{}) {
+	item := x.(*queueItem)
+	item.index = len(*h)
+	*h = append(*h, item)
+}
+
+func (h *taskHeap) Pop() interface{} {
+	old := *h
+	n := len(old)
+	item := old[n-1]
+	old[n-1] = nil
+	*h = old[:n-1]
+	return item
+}
+
+// The zero value is an empty queue
+type taskQueue struct {
+	items taskHeap
+	keys  map[string]*queueItem
+	head  int64
+	tail  int64
+}
+
+func (q *taskQueue) len() int {
+	return len(q.items)
+}
+
+// A task already queued with the same key is replaced and moved to the new position
+func (q *taskQueue) add(task Task, toHead bool) {
+	var order int64
+	if toHead {
+		q.head--
+		order = q.head
+	} else {
+		order = q.tail
+		q.tail++
+	}
+
+	if q.keys == nil {
+		q.keys = make(map[string]*queueItem)
+	}
+
+	key := task.Key()
+	if item, ok := q.keys[key]; ok {
+		item.task = task
+		item.order = order
+		heap.Fix(&q.items, item.index)
+		return
+	}
+
+	item := &queueItem{task: task, order: order}
+	q.keys[key] = item
+	heap.Push(&q.items, item)
+}
+
+func (q *taskQueue) remove(key string) Task {
+	if item, ok := q.keys[key]; ok {
+		delete(q.keys, key)
+		heap.Remove(&q.items, item.index)
+		return item.task
+	}
+	return nil
+}
+
+func (q *taskQueue) pop() Task {
+	if len(q.items) == 0 {
+		return nil
+	}
+	item := heap.Pop(&q.items).(*queueItem)
+	delete(q.keys, item.task.Key())
+	return item.task
+}
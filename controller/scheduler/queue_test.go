@@ -0,0 +1,45 @@
+package scheduler
+
+import (
+	"testing"
+)
+
+type queueTestTask struct {
+	id string
+}
+
+func (t *queueTestTask) Key() string                { return t.id }
+func (t *queueTestTask) Priority() Priority         { return PriorityLow }
+func (t *queueTestTask) Handler(proc string) Action { return TaskActionDone }
+func (t *queueTestTask) StartTimer()                {}
+func (t *queueTestTask) CancelTimer()               {}
+func (t *queueTestTask) Print(msg string)           {}
+
+func TestTaskQueueOrder(t *testing.T) {
+	var q taskQueue
+
+	q.add(&queueTestTask{id: "2"}, false)
+	q.add(&queueTestTask{id: "3"}, false)
+	q.add(&queueTestTask{id: "1"}, true)
+	q.add(&queueTestTask{id: "4"}, false)
+	q.add(&queueTestTask{id: "0"}, true)
+	// requeued to the tail
+	q.add(&queueTestTask{id: "2"}, false)
+
+	if q.len() != 5 {
+		t.Errorf("Unexpected queue length: %v", q.len())
+	}
+	if q.remove("3") == nil || q.remove("3") != nil {
+		t.Errorf("Unexpected remove result")
+	}
+
+	expect := []string{"0", "1", "4", "2"}
+	for _, id := range expect {
+		if task := q.pop(); task == nil || task.Key() != id {
+			t.Errorf("Unexpected task: expect=%v task=%v", id, task)
+		}
+	}
+	if q.pop() != nil || q.len() != 0 || len(q.keys) != 0 {
+		t.Errorf("Queue is not empty: %v", q.len())
+	}
+}
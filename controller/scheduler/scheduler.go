@@ -23,6 +23,7 @@ const (
 type Processor struct {
 	name     string
 	currTask Task
+	deleted  bool
 }
 
 type Task interface {
@@ -36,8 +37,10 @@ type Task interface {
 
 type Schd struct {
 	procs         []*Processor
-	taskQueueHigh []Task
-	taskQueueLow  []Task
+	idleProcs     []*Processor          // in the order they became idle
+	running       map[string]*Processor // by key of the task waited on
+	taskQueueHigh taskQueue
+	taskQueueLow  taskQueue
 	mutex         sync.Mutex
 	notifyChan    chan bool
 }
@@ -53,7 +56,7 @@ func (s *Schd) unlock() {
 func (s *Schd) TaskCount() int {
 	s.lock()
 	defer s.unlock()
-	return len(s.taskQueueHigh) + len(s.taskQueueLow)
+	return s.taskQueueHigh.len() + s.taskQueueLow.len()
 }
 
 func (s *Schd) AddProcessor(name string) error {
@@ -64,7 +67,9 @@ func (s *Schd) AddProcessor(name string) error {
 			return fmt.Errorf("proc %s already exists", name)
 		}
 	}
-	s.procs = append(s.procs, &Processor{name: name})
+	proc := &Processor{name: name}
+	s.procs = append(s.procs, proc)
+	s.idleProcs = append(s.idleProcs, proc)
 	s.unlock()
 	s.taskNotify()
 	return nil
@@ -87,35 +92,27 @@ func (s *Schd) DelProcessor(name string) (string, error) {
 		return "", fmt.Errorf("proc %s doesn't exist", name)
 	} else {
 		s.procs = append(s.procs[:i], s.procs[i+1:]...)
+		proc.deleted = true
 	}
 
 	// cancel running jobs on this processor
 	if proc.currTask != nil {
+		key := proc.currTask.Key()
+		delete(s.running, key)
 		proc.currTask.CancelTimer()
-		return proc.currTask.Key(), nil
+		return key, nil
 	}
+	s.removeIdleProc(proc)
 	return "", nil
 }
 
-func getTaskIdxFromQueue(key string, queue []Task) int {
-	for i, t := range queue {
-		if t.Key() == key {
-			return i
+func (s *Schd) removeIdleProc(proc *Processor) {
+	for i, p := range s.idleProcs {
+		if p == proc {
+			s.idleProcs = append(s.idleProcs[:i], s.idleProcs[i+1:]...)
+			return
 		}
 	}
-	return -1
-}
-
-func removeTaskFromQueue(key string, queue []Task) ([]Task, Task) {
-	var task Task
-	i := getTaskIdxFromQueue(key, queue)
-	if i == -1 {
-		return queue, nil
-	} else {
-		task = queue[i]
-		queue = append(queue[:i], queue[i+1:]...)
-	}
-	return queue, task
 }
 
 func (s *Schd) AddTask(task Task, toHead bool) {
@@ -123,17 +120,9 @@ func (s *Schd) AddTask(task Task, toHead bool) {
 
 	s.lock()
 	if priority == PriorityLow {
-		if toHead {
-			s.taskQueueLow = append([]Task{task}, s.taskQueueLow...)
-		} else {
-			s.taskQueueLow = append(s.taskQueueLow, task)
-		}
+		s.taskQueueLow.add(task, toHead)
 	} else if priority == PriorityHigh {
-		if toHead {
-			s.taskQueueHigh = append([]Task{task}, s.taskQueueHigh...)
-		} else {
-			s.taskQueueHigh = append(s.taskQueueHigh, task)
-		}
+		s.taskQueueHigh.add(task, toHead)
 	}
 	s.unlock()
 	s.taskNotify()
@@ -146,9 +135,9 @@ func (s *Schd) DeleteTask(key string, priority Priority) bool {
 	// If the task is already running, the task will not be deleted
 	s.lock()
 	if priority == PriorityLow {
-		s.taskQueueLow, t = removeTaskFromQueue(key, s.taskQueueLow)
+		t = s.taskQueueLow.remove(key)
 	} else if priority == PriorityHigh {
-		s.taskQueueHigh, t = removeTaskFromQueue(key, s.taskQueueHigh)
+		t = s.taskQueueHigh.remove(key)
 	}
 	s.unlock()
 
@@ -162,9 +151,9 @@ func (s *Schd) DeleteTask(key string, priority Priority) bool {
 func (s *Schd) ClearTaskQueue(priority Priority) {
 	s.lock()
 	if priority == PriorityLow {
-		s.taskQueueLow = nil
+		s.taskQueueLow = taskQueue{}
 	} else if priority == PriorityHigh {
-		s.taskQueueHigh = nil
+		s.taskQueueHigh = taskQueue{}
 	}
 	s.unlock()
 }
@@ -173,10 +162,11 @@ func (s *Schd) TaskDone(task Task, action Action) {
 	key := task.Key()
 
 	s.lock()
-	for _, proc := range s.procs {
-		if proc.currTask != nil && proc.currTask.Key() == key {
-			proc.currTask = nil
-			break
+	if proc, ok := s.running[key]; ok {
+		delete(s.running, key)
+		proc.currTask = nil
+		if !proc.deleted {
+			s.idleProcs = append(s.idleProcs, proc)
 		}
 	}
 	s.unlock()
@@ -194,30 +184,19 @@ func (s *Schd) TaskDone(task Task, action Action) {
 	}
 }
 
-func (s *Schd) getAvailableProc() *Processor {
+// The processor idle the longest and the next task, in one pass under the lock. The processor
+// stays in the idle list until it is given a task to wait on.
+func (s *Schd) getNextDispatch() (*Processor, Task) {
 	s.lock()
 	defer s.unlock()
-	for _, proc := range s.procs {
-		if proc.currTask == nil {
-			return proc
-		}
+	if len(s.idleProcs) == 0 {
+		return nil, nil
 	}
-	return nil
-}
-
-func (s *Schd) getNextTask() Task {
-	s.lock()
-	defer s.unlock()
-	if len(s.taskQueueHigh) > 0 {
-		task := s.taskQueueHigh[0]
-		s.taskQueueHigh, _ = removeTaskFromQueue(task.Key(), s.taskQueueHigh)
-		return task
-	} else if len(s.taskQueueLow) > 0 {
-		task := s.taskQueueLow[0]
-		s.taskQueueLow, _ = removeTaskFromQueue(task.Key(), s.taskQueueLow)
-		return task
+	proc := s.idleProcs[0]
+	if task := s.taskQueueHigh.pop(); task != nil {
+		return proc, task
 	}
-	return nil
+	return proc, s.taskQueueLow.pop()
 }
 
 func (s *Schd) taskNotify() {
@@ -229,11 +208,7 @@ func (s *Schd) taskNotify() {
 func (s *Schd) taskWorker() {
 	for range s.notifyChan {
 		for {
-			proc := s.getAvailableProc()
-			if proc == nil {
-				break
-			}
-			task := s.getNextTask()
+			proc, task := s.getNextDispatch()
 			if task == nil {
 				break
 			}
@@ -242,7 +217,12 @@ func (s *Schd) taskWorker() {
 			case TaskActionWait:
 				task.StartTimer()
 				s.lock()
+				if s.running == nil {
+					s.running = make(map[string]*Processor)
+				}
+				s.removeIdleProc(proc)
 				proc.currTask = task
+				s.running[task.Key()] = proc
 				s.unlock()
 			case TaskActionRetry:
 				s.AddTask(task, true)
@@ -266,8 +246,8 @@ func (s *Schd) Init() {
 func (s *Schd) Reset() {
 	s.lock()
 	defer s.unlock()
-	s.taskQueueLow = nil
-	s.taskQueueHigh = nil
+	s.taskQueueLow = taskQueue{}
+	s.taskQueueHigh = taskQueue{}
 	for _, proc := range s.procs {
 		if proc.currTask != nil {
 			proc.currTask.CancelTimer()
@@ -275,4 +255,6 @@ func (s *Schd) Reset() {
 		}
 	}
 	s.procs = nil
+	s.idleProcs = nil
+	s.running = nil
 }
@@ -0,0 +1,125 @@
+package db
+
+import (
+	"database/sql"
+	"fmt"
+
+	"github.com/doug-martin/goqu/v9"
+	"github.com/neuvector/neuvector/share"
+)
+
+// The vulnerabilities of an asset are kept in the assetcves table as well, a row per vulnerability
+// with the fields the vulnerability profile and the asset views look at. The table is rewritten
+// with the asset's vuls in UpdateAssetVul, so the queries read the rows of the assets, and of the
+// CVEs, they are interested in instead of decoding the vulsb blob of every asset.
+
+const (
+	assetCVEInsertRows = 64  // rows of an insert statement
+	assetCVEQueryIDs   = 500 // asset ids of a query
+	assetCVEMaxNames   = 1000
+)
+
+func getAssetcveSchema() []string {
+	return []string{"id INTEGER NOT NULL PRIMARY KEY", "assetid TEXT", "type TEXT", "name TEXT", "dbkey TEXT", "severity TEXT",
+		"package_name TEXT", "package_version TEXT", "fixed_version TEXT", "published TEXT"}
+}
+
+func getAssetcveIndexes() []string {
+	return []string{
+		fmt.Sprintf("CREATE INDEX IF NOT EXISTS %s_assetid_idx on %s (assetid)", Table_assetcves, Table_assetcves),
+		fmt.Sprintf("CREATE INDEX IF NOT EXISTS %s_name_idx on %s (name)", Table_assetcves, Table_assetcves),
+	}
+}
+
+// Replace the CVE rows of an asset, within the transaction that updates the asset
+func replaceAssetCVEs(tx *sql.Tx, assetVul *DbAssetVul) error {
+	dialect := goqu.Dialect("sqlite3")
+
+	statement, args, _ := dialect.Delete(Table_assetcves).Where(goqu.C("assetid").Eq(assetVul.AssetID)).Prepared(true).ToSQL()
+	if _, err := tx.Exec(statement, args...); err != nil {
+		return err
+	}
+
+	for i := 0; i < len(assetVul.Vuls); i += assetCVEInsertRows {
+		end := i + assetCVEInsertRows
+		if end > len(assetVul.Vuls) {
+			end = len(assetVul.Vuls)
+		}
+
+		records := make([]interface{}, 0, end-i)
+		for _, vul := range assetVul.Vuls[i:end] {
+			records = append(records, goqu.Record{
+				"assetid":         assetVul.AssetID,
+				"type":            assetVul.Type,
+				"name":            vul.Name,
+				"dbkey":           vul.DBKey,
+				"severity":        vul.Severity,
+				"package_name":    vul.PackageName,
+				"package_version": vul.PackageVersion,
+				"fixed_version":   vul.FixedVersion,
+				"published":       vul.PublishedDate,
+			})
+		}
+
+		statement, args, _ := dialect.Insert(Table_assetcves).Rows(records...).Prepared(true).ToSQL()
+		if _, err := tx.Exec(statement, args...); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// Vuls of the assets, keyed by asset id, in the order of the scan report. When names are given,
+// only the vuls of these CVEs are read.
+func getAssetCVEs(assetIDs []string, names []string) (map[string][]*share.ScanVulnerability, error) {
+	dialect := goqu.Dialect("sqlite3")
+	columns := []interface{}{"assetid", "name", "dbkey", "severity", "package_name", "package_version", "fixed_version", "published"}
+
+	// a long name list costs more to bind than the rows it saves
+	var nameExp goqu.Ex
+	if len(names) > 0 && len(names) <= assetCVEMaxNames {
+		nameExp = goqu.Ex{"name": names}
+	}
+
+	assetCVEs := make(map[string][]*share.ScanVulnerability, len(assetIDs))
+	for i := 0; i < len(assetIDs); i += assetCVEQueryIDs {
+		end := i + assetCVEQueryIDs
+		if end > len(assetIDs) {
+			end = len(assetIDs)
+		}
+
+		where := goqu.And(goqu.Ex{"assetid": assetIDs[i:end]})
+		if nameExp != nil {
+			where = where.Append(nameExp)
+		}
+		statement, args, _ := dialect.From(Table_assetcves).Select(columns...).Where(where).Order(goqu.C("id").Asc()).Prepared(true).ToSQL()
+
+		rows, err := dbHandle.Query(statement, args...)
+		if err != nil {
+			return nil, err
+		}
+		for rows.Next() {
+			var assetID string
+			vul := &share.ScanVulnerability{}
+			err = rows.Scan(&assetID, &vul.Name, &vul.DBKey, &vul.Severity, &vul.PackageName, &vul.PackageVersion, &vul.FixedVersion, &vul.PublishedDate)
+			if err != nil {
+				rows.Close()
+				return nil, err
+			}
+			assetCVEs[assetID] = append(assetCVEs[assetID], vul)
+		}
+		err = rows.Err()
+		rows.Close()
+		if err != nil {
+			return nil, err
+		}
+	}
+	return assetCVEs, nil
+}
+
+func deleteAssetCVEs(assetid string) error {
+	dialect := goqu.Dialect("sqlite3")
+	statement, args, _ := dialect.Delete(Table_assetcves).Where(goqu.C("assetid").Eq(assetid)).Prepared(true).ToSQL()
+	_, err := dbHandle.Exec(statement, args...)
+	return err
+}
@@ -87,38 +87,53 @@ func PopulateAssetVul(assetVul *DbAssetVul) error {
 	return nil
 }
 
+// The asset and its rows in the assetcves table are written in a transaction
 func UpdateAssetVul(assetVul *DbAssetVul) (int, error) {
 	targetTable := Table_assetvuls
 
-	db := dbHandle
 	dialect := goqu.Dialect("sqlite3")
 
-	// Insert case
-	if assetVul.Db_ID == 0 {
+	tx, err := dbHandle.Begin()
+	if err != nil {
+		return 0, err
+	}
+
+	id := assetVul.Db_ID
+	if id == 0 {
+		// Insert case
 		ds := dialect.Insert(targetTable).Rows(getCompiledAssetVulRecord(assetVul))
 		sql, args, _ := ds.Prepared(true).ToSQL()
 
-		result, err := db.Exec(sql, args...)
+		result, err := tx.Exec(sql, args...)
 		if err != nil {
+			_ = tx.Rollback()
 			return 0, err
 		}
 
 		lastInsertID, err := result.LastInsertId()
 		if err != nil {
+			_ = tx.Rollback()
+			return 0, err
+		}
+		id = int(lastInsertID)
+	} else {
+		// Update case
+		sql, args, _ := dialect.Update(targetTable).Where(goqu.C("id").Eq(assetVul.Db_ID)).Set(getCompiledAssetVulRecord(assetVul)).Prepared(true).ToSQL()
+		if _, err := tx.Exec(sql, args...); err != nil {
+			_ = tx.Rollback()
 			return 0, err
 		}
-
-		return int(lastInsertID), nil
 	}
 
-	// Update case
-	sql, args, _ := dialect.Update(targetTable).Where(goqu.C("id").Eq(assetVul.Db_ID)).Set(getCompiledAssetVulRecord(assetVul)).Prepared(true).ToSQL()
-	_, err := db.Exec(sql, args...)
-	if err != nil {
+	if err := replaceAssetCVEs(tx, assetVul); err != nil {
+		_ = tx.Rollback()
 		return 0, err
 	}
 
-	return assetVul.Db_ID, nil
+	if err := tx.Commit(); err != nil {
+		return 0, err
+	}
+	return id, nil
 }
 
 func UpdateHostContainers(id string, containers int) error {
@@ -216,7 +231,7 @@ func getWorkloadAssetView(vulMap map[string]*DbVulAsset, assets []string, queryF
 	}
 
 	columns := []interface{}{"assetid", "name", "w_domain", "w_applications", "policy_mode", "w_service_group",
-		"scanned_at", "idns", "vulsb", "w_image"}
+		"scanned_at", "idns", "w_image"}
 
 	dialect := goqu.Dialect("sqlite3")
 	statement, args, _ := dialect.From(Table_assetvuls).Select(columns...).Where(buildWhereClauseForWorkload(assets, queryFilter.Filters)).Prepared(true).ToSQL()
@@ -227,20 +242,15 @@ func getWorkloadAssetView(vulMap map[string]*DbVulAsset, assets []string, queryF
 	}
 	defer rows.Close()
 
-	poolSize := queryFilter.ThreadCount
-	pool := pond.New(poolSize, 0, pond.MinWorkers(poolSize))
-	var mux sync.Mutex
-
+	views := make([]*assetViewVuls, 0)
 	for rows.Next() {
 		av := &api.RESTWorkloadAssetView{}
 		av.Vulnerabilities = make([]string, 0)
 
 		var assetId, apps, idnsStr string
-		var vulsBytes []byte
-		err = rows.Scan(&assetId, &av.Name, &av.Domain, &apps, &av.PolicyMode, &av.ServiceGroup, &av.ScannedAt, &idnsStr, &vulsBytes, &av.Image)
+		err = rows.Scan(&assetId, &av.Name, &av.Domain, &apps, &av.PolicyMode, &av.ServiceGroup, &av.ScannedAt, &idnsStr, &av.Image)
 
 		if err != nil {
-			pool.StopAndWait()
 			return nil, err
 		}
 
@@ -252,13 +262,15 @@ func getWorkloadAssetView(vulMap map[string]*DbVulAsset, assets []string, queryF
 			"Low":    &av.Low,
 		}
 
-		batchProcessAssetView(pool, &mux, cvePackages, vulsBytes, idnsStr, &av.Vulnerabilities, vulMap, cveStats)
+		views = append(views, &assetViewVuls{assetID: assetId, idns: idnsStr, vulnerabilities: &av.Vulnerabilities, cveStat: cveStats})
 
 		av.ID = assetId
 		records = append(records, av)
 	}
-	pool.StopAndWait()
 
+	if err := fillAssetViewVuls(views, queryFilter.ThreadCount, vulMap, cvePackages); err != nil {
+		return nil, err
+	}
 	return records, nil
 }
 
@@ -270,7 +282,7 @@ func getHostAssetView(vulMap map[string]*DbVulAsset, assets []string, queryFilte
 	}
 
 	columns := []interface{}{"assetid", "name", "policy_mode",
-		"scanned_at", "n_os", "n_kernel", "n_cpus", "n_memory", "n_containers", "idns", "vulsb"}
+		"scanned_at", "n_os", "n_kernel", "n_cpus", "n_memory", "n_containers", "idns"}
 
 	dialect := goqu.Dialect("sqlite3")
 	statement, args, _ := dialect.From(Table_assetvuls).Select(columns...).Where(buildWhereClauseForNode(assets, queryFilter.Filters)).Prepared(true).ToSQL()
@@ -281,20 +293,15 @@ func getHostAssetView(vulMap map[string]*DbVulAsset, assets []string, queryFilte
 	}
 	defer rows.Close()
 
-	poolSize := queryFilter.ThreadCount
-	pool := pond.New(poolSize, 0, pond.MinWorkers(poolSize))
-	var mux sync.Mutex
-
+	views := make([]*assetViewVuls, 0)
 	for rows.Next() {
 		av := &api.RESTHostAssetView{}
 		av.Vulnerabilities = make([]string, 0)
 
 		var assetId, idnsStr string
-		var vulsBytes []byte
 		err = rows.Scan(&assetId, &av.Name, &av.PolicyMode,
-			&av.ScannedAt, &av.OS, &av.Kernel, &av.CPUs, &av.Memory, &av.Containers, &idnsStr, &vulsBytes)
+			&av.ScannedAt, &av.OS, &av.Kernel, &av.CPUs, &av.Memory, &av.Containers, &idnsStr)
 		if err != nil {
-			pool.StopAndWait()
 			return nil, err
 		}
 
@@ -303,13 +310,15 @@ func getHostAssetView(vulMap map[string]*DbVulAsset, assets []string, queryFilte
 			"Medium": &av.Medium,
 			"Low":    &av.Low,
 		}
-		batchProcessAssetView(pool, &mux, cvePackages, vulsBytes, idnsStr, &av.Vulnerabilities, vulMap, cveStats)
+		views = append(views, &assetViewVuls{assetID: assetId, idns: idnsStr, vulnerabilities: &av.Vulnerabilities, cveStat: cveStats})
 
 		av.ID = assetId
 		records = append(records, av)
 	}
-	pool.StopAndWait()
 
+	if err := fillAssetViewVuls(views, queryFilter.ThreadCount, vulMap, cvePackages); err != nil {
+		return nil, err
+	}
 	return records, nil
 }
 
@@ -320,7 +329,7 @@ func getImageAssetView(vulMap map[string]*DbVulAsset, assets []string, queryFilt
 		return records, nil
 	}
 
-	columns := []interface{}{"assetid", "name", "idns", "vulsb"}
+	columns := []interface{}{"assetid", "name", "idns"}
 	dialect := goqu.Dialect("sqlite3")
 	statement, args, _ := dialect.From(Table_assetvuls).Select(columns...).Where(buildWhereClauseForImage(assets, queryFilter.Filters)).Prepared(true).ToSQL()
 
@@ -330,20 +339,15 @@ func getImageAssetView(vulMap map[string]*DbVulAsset, assets []string, queryFilt
 	}
 	defer rows.Close()
 
-	poolSize := queryFilter.ThreadCount
-	pool := pond.New(poolSize, 0, pond.MinWorkers(poolSize))
-	var mux sync.Mutex
-
+	views := make([]*assetViewVuls, 0)
 	for rows.Next() {
 		av := &api.RESTImageAssetView{}
 		av.Vulnerabilities = make([]string, 0)
 
 		var assetId, idnsStr string
-		var vulsBytes []byte
-		err = rows.Scan(&assetId, &av.Name, &idnsStr, &vulsBytes)
+		err = rows.Scan(&assetId, &av.Name, &idnsStr)
 
 		if err != nil {
-			pool.StopAndWait()
 			return nil, err
 		}
 
@@ -352,13 +356,15 @@ func getImageAssetView(vulMap map[string]*DbVulAsset, assets []string, queryFilt
 			"Medium": &av.Medium,
 			"Low":    &av.Low,
 		}
-		batchProcessAssetView(pool, &mux, cvePackages, vulsBytes, idnsStr, &av.Vulnerabilities, vulMap, cveStats)
+		views = append(views, &assetViewVuls{assetID: assetId, idns: idnsStr, vulnerabilities: &av.Vulnerabilities, cveStat: cveStats})
 
 		av.ID = assetId
 		records = append(records, av)
 	}
-	pool.StopAndWait()
 
+	if err := fillAssetViewVuls(views, queryFilter.ThreadCount, vulMap, cvePackages); err != nil {
+		return nil, err
+	}
 	return records, nil
 }
 
@@ -369,7 +375,7 @@ func getPlatformAssetView(vulMap map[string]*DbVulAsset, assets []string, queryF
 		return records, nil
 	}
 
-	columns := []interface{}{"assetid", "name", "p_version", "p_base_os", "idns", "vulsb"}
+	columns := []interface{}{"assetid", "name", "p_version", "p_base_os", "idns"}
 	dialect := goqu.Dialect("sqlite3")
 	statement, args, _ := dialect.From(Table_assetvuls).Select(columns...).Where(buildWhereClauseForPlatform(assets, queryFilter.Filters)).Prepared(true).ToSQL()
 
@@ -379,19 +385,15 @@ func getPlatformAssetView(vulMap map[string]*DbVulAsset, assets []string, queryF
 	}
 	defer rows.Close()
 
-	poolSize := 1
-	pool := pond.New(poolSize, 0, pond.MinWorkers(poolSize))
-	var mux sync.Mutex
+	views := make([]*assetViewVuls, 0)
 	for rows.Next() {
 		av := &api.RESTPlatformAssetView{}
 		av.Vulnerabilities = make([]string, 0)
 
 		var assetId, idnsStr string
-		var vulsBytes []byte
-		err = rows.Scan(&assetId, &av.Name, &av.Version, &av.BaseOS, &idnsStr, &vulsBytes)
+		err = rows.Scan(&assetId, &av.Name, &av.Version, &av.BaseOS, &idnsStr)
 
 		if err != nil {
-			pool.StopAndWait()
 			return nil, err
 		}
 
@@ -400,12 +402,14 @@ func getPlatformAssetView(vulMap map[string]*DbVulAsset, assets []string, queryF
 			"Medium": &av.Medium,
 			"Low":    &av.Low,
 		}
-		batchProcessAssetView(pool, &mux, cvePackages, vulsBytes, idnsStr, &av.Vulnerabilities, vulMap, cveStats)
+		views = append(views, &assetViewVuls{assetID: assetId, idns: idnsStr, vulnerabilities: &av.Vulnerabilities, cveStat: cveStats})
 		av.ID = assetId
 		records = append(records, av)
 	}
-	pool.StopAndWait()
 
+	if err := fillAssetViewVuls(views, 1, vulMap, cvePackages); err != nil {
+		return nil, err
+	}
 	return records, nil
 }
 
@@ -859,10 +863,47 @@ func hasNamespaceFilter(queryFilter *api.VulQueryFilterViewModel) bool {
 	return false
 }
 
-func batchProcessAssetView(pool *pond.WorkerPool, mu *sync.Mutex, cvePackages map[string]map[string]utils.Set, vulsBytes []byte, idnsStr string, vulnerabilities *[]string, vulMap map[string]*DbVulAsset, cveStat map[string]*int) {
+type assetViewVuls struct {
+	assetID         string
+	idns            string
+	vulnerabilities *[]string
+	cveStat         map[string]*int
+}
+
+// The vuls of the assets are read from the assetcves table a batch of assets at a time
+func fillAssetViewVuls(views []*assetViewVuls, poolSize int, vulMap map[string]*DbVulAsset, cvePackages map[string]map[string]utils.Set) error {
+	pool := pond.New(poolSize, 0, pond.MinWorkers(poolSize))
+	var mux sync.Mutex
+	defer pool.StopAndWait()
+
+	for i := 0; i < len(views); i += assetCVEQueryIDs {
+		end := i + assetCVEQueryIDs
+		if end > len(views) {
+			end = len(views)
+		}
+
+		assetIDs := make([]string, 0, end-i)
+		for _, v := range views[i:end] {
+			assetIDs = append(assetIDs, v.assetID)
+		}
+		assetCVEs, err := getAssetCVEs(assetIDs, nil)
+		if err != nil {
+			return err
+		}
+
+		for _, v := range views[i:end] {
+			if vuls, ok := assetCVEs[v.assetID]; ok {
+				batchProcessAssetView(pool, &mux, cvePackages, vuls, v.idns, v.vulnerabilities, vulMap, v.cveStat)
+			}
+		}
+	}
+	return nil
+}
+
+func batchProcessAssetView(pool *pond.WorkerPool, mu *sync.Mutex, cvePackages map[string]map[string]utils.Set, vuls []*share.ScanVulnerability, idnsStr string, vulnerabilities *[]string, vulMap map[string]*DbVulAsset, cveStat map[string]*int) {
 	pool.Submit(func() {
 		cveList := make([]string, 0)
-		if err := funcFillVulPackages(mu, cvePackages, vulsBytes, idnsStr, &cveList, cveStat); err != nil {
+		if err := funcFillVulPackages(mu, cvePackages, vuls, idnsStr, &cveList, cveStat); err != nil {
 			log.WithFields(log.Fields{"error": err}).Error("funcFillVulPackages")
 		}
 
@@ -959,19 +1000,21 @@ func CreateImageAssetSession(allowed map[string]utils.Set, queryFilter *AssetQue
 			continue
 		}
 
-		// insert into session table
-		for _, imgObj := range images {
-			assetCount++
-			asset.Name = imgObj.Repo
-			asset.I_tag = imgObj.Tag
-
-			// get cve count as it is VPF dependent
+		// get cve count as it is VPF dependent, it is the same for all the tags of the image
+		if len(images) > 0 {
 			criticalCount, highCount, medCount, err := funcGetImageCVECount(asset.I_repository_name, asset.AssetID)
 			if err == nil {
 				asset.CVE_critical = criticalCount
 				asset.CVE_high = highCount
 				asset.CVE_medium = medCount
 			}
+		}
+
+		// insert into session table
+		for _, imgObj := range images {
+			assetCount++
+			asset.Name = imgObj.Repo
+			asset.I_tag = imgObj.Tag
 
 			_, err = insertSessionAssetRecord(memoryDbHandle, queryToken, asset)
 			if err != nil {
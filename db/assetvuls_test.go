@@ -5,6 +5,7 @@ import (
 	"testing"
 
 	"github.com/neuvector/neuvector/controller/api"
+	"github.com/neuvector/neuvector/share"
 	"github.com/neuvector/neuvector/share/utils"
 )
 
@@ -82,6 +83,75 @@ func TestUpdateHostContainerCount(t *testing.T) {
 	t.Log("TestUpdateHostContainerCount completed successfully.")
 }
 
+func TestAssetCVEs(t *testing.T) {
+	err := CreateVulAssetDb(true)
+	if err != nil {
+		t.Errorf("CreateDatabase() returns %v", err)
+	}
+
+	// populate an workload asset with two vulnerabilities
+	workloadID := "1c0156a5c9e349b9fe0596db0a3846cce6de655936781386764040c6532841f3"
+	dbAssetVul := generateWorkloadDbAssetVul(workloadID)
+	dbAssetVul.Vuls = []*share.ScanVulnerability{
+		{Name: "CVE-2023-0002", DBKey: "alpine:CVE-2023-0002", Severity: "High", PackageName: "openssl", PackageVersion: "3.0.1", FixedVersion: "3.0.2"},
+		{Name: "CVE-2023-0001", DBKey: "alpine:CVE-2023-0001", Severity: "Low", PackageName: "zlib", PackageVersion: "1.2.11"},
+	}
+	err = PopulateAssetVul(dbAssetVul)
+	if err != nil {
+		t.Errorf("PopulateAssetVul returns %v", err)
+	}
+
+	// read the rows back, in the order of the report
+	assetCVEs, err := getAssetCVEs([]string{workloadID}, nil)
+	if err != nil {
+		t.Errorf("getAssetCVEs returns %v", err)
+	}
+	vuls := assetCVEs[workloadID]
+	if len(vuls) != 2 || vuls[0].Name != "CVE-2023-0002" || vuls[1].Name != "CVE-2023-0001" {
+		t.Errorf("Read back vuls don't match. Expected 2 vuls, but got %v", vuls)
+	} else if vuls[0].FixedVersion != "3.0.2" || vuls[0].Severity != "High" || vuls[1].PackageName != "zlib" {
+		t.Errorf("Read back vul fields don't match. Got %+v, %+v", vuls[0], vuls[1])
+	}
+
+	// rows of the named CVEs only
+	assetCVEs, err = getAssetCVEs([]string{workloadID}, []string{"CVE-2023-0001"})
+	if err != nil {
+		t.Errorf("getAssetCVEs returns %v", err)
+	}
+	if vuls := assetCVEs[workloadID]; len(vuls) != 1 || vuls[0].Name != "CVE-2023-0001" {
+		t.Errorf("Read back vuls by name don't match. Expected CVE-2023-0001, but got %v", vuls)
+	}
+
+	// an update replaces the rows of the asset
+	dbAssetVul.Vuls = dbAssetVul.Vuls[:1]
+	err = PopulateAssetVul(dbAssetVul)
+	if err != nil {
+		t.Errorf("PopulateAssetVul returns %v", err)
+	}
+	assetCVEs, err = getAssetCVEs([]string{workloadID}, nil)
+	if err != nil {
+		t.Errorf("getAssetCVEs returns %v", err)
+	}
+	if len(assetCVEs[workloadID]) != 1 {
+		t.Errorf("Read back vuls after update don't match. Expected %v, but got %v", 1, len(assetCVEs[workloadID]))
+	}
+
+	// and a delete removes them
+	err = DeleteAssetByID(AssetWorkload, workloadID)
+	if err != nil {
+		t.Errorf("DeleteAssetByID returns %v", err)
+	}
+	assetCVEs, err = getAssetCVEs([]string{workloadID}, nil)
+	if err != nil {
+		t.Errorf("getAssetCVEs returns %v", err)
+	}
+	if len(assetCVEs[workloadID]) != 0 {
+		t.Errorf("Read back vuls after delete don't match. Expected %v, but got %v", 0, len(assetCVEs[workloadID]))
+	}
+
+	t.Log("TestAssetCVEs completed successfully.")
+}
+
 func generateHostDbAssetVul(assetid string, containerCount int) *DbAssetVul {
 	d := &DbAssetVul{
 		Type:         AssetNode,
@@ -186,6 +186,7 @@ const (
 
 	Table_vulassets  = "vulassets"
 	Table_assetvuls  = "assetvuls"
+	Table_assetcves  = "assetcves"
 	Table_querystats = "querystats"
 	Table_bench      = "bench"
 )
@@ -194,8 +195,8 @@ var dbHandle *sql.DB = nil
 var memoryDbHandle *sql.DB = nil
 
 var funcGetCveRecord func(string, string, string) *DbVulAsset
-var funcGetCVEList func([]byte, string) []string
-var funcFillVulPackages func(*sync.Mutex, map[string]map[string]utils.Set, []byte, string, *[]string, map[string]*int) error
+var funcGetCVEList func([]*share.ScanVulnerability, string) []string
+var funcFillVulPackages func(*sync.Mutex, map[string]map[string]utils.Set, []*share.ScanVulnerability, string, *[]string, map[string]*int) error
 var funcGetImageCVECount func(string, string) (int, int, int, error) // funcGetImageCVECount
 var funcGetCveDbRecordCount func() int
 var memdbMutex sync.RWMutex
@@ -253,6 +254,11 @@ func CreateVulAssetDb(useLocal bool) error {
 	statements = append(statements, fmt.Sprintf("CREATE INDEX IF NOT EXISTS %s_name_idx on %s (name)", Table_assetvuls, Table_assetvuls))
 	statements = append(statements, fmt.Sprintf("CREATE INDEX IF NOT EXISTS %s_type_idx on %s (type)", Table_assetvuls, Table_assetvuls))
 
+	// assetcves table
+	columns = getAssetcveSchema()
+	statements = append(statements, fmt.Sprintf("CREATE TABLE IF NOT EXISTS %s (%s)", Table_assetcves, strings.Join(columns, ",")))
+	statements = append(statements, getAssetcveIndexes()...)
+
 	// bench table
 	columns = getBenchSchema()
 	statements = append(statements, fmt.Sprintf("CREATE TABLE IF NOT EXISTS %s (%s)", Table_bench, strings.Join(columns, ",")))
@@ -305,11 +311,11 @@ func SetGetCVERecordFunc(funcObj func(string, string, string) *DbVulAsset) {
 	funcGetCveRecord = funcObj
 }
 
-func SetGetCVEListFunc(funcObj func([]byte, string) []string) {
+func SetGetCVEListFunc(funcObj func([]*share.ScanVulnerability, string) []string) {
 	funcGetCVEList = funcObj
 }
 
-func SetFillVulPackagesFunc(funcObj func(*sync.Mutex, map[string]map[string]utils.Set, []byte, string, *[]string, map[string]*int) error) {
+func SetFillVulPackagesFunc(funcObj func(*sync.Mutex, map[string]map[string]utils.Set, []*share.ScanVulnerability, string, *[]string, map[string]*int) error) {
 	funcFillVulPackages = funcObj
 }
 
@@ -18,6 +18,7 @@ import (
 	"github.com/mattn/go-sqlite3"
 	_ "github.com/mattn/go-sqlite3"
 	"github.com/neuvector/neuvector/controller/api"
+	"github.com/neuvector/neuvector/share"
 	"github.com/neuvector/neuvector/share/utils"
 	log "github.com/sirupsen/logrus"
 )
@@ -132,7 +133,7 @@ func FilterVulAssetsV2(allowed map[string]utils.Set, queryFilter *VulQueryFilter
 		CVEDBReady = false
 	}
 
-	columns := []interface{}{"id", "type", "assetid", "idns", "vulsb"}
+	columns := []interface{}{"id", "type", "assetid", "idns"}
 
 	statement, args, _ := dialect.From(Table_assetvuls).Select(columns...).Where(buildAssetFilterWhereClause(queryFilter.Filters)).Prepared(true).ToSQL()
 	log.WithFields(log.Fields{"statement": statement, "args": args, "CVEDBReady": CVEDBReady}).Debug("GetVulAssetSessionV2, fetch assets")
@@ -150,11 +151,11 @@ func FilterVulAssetsV2(allowed map[string]utils.Set, queryFilter *VulQueryFilter
 	assetCount := 0
 	dbVulAssets := make(map[string]*DbVulAsset, 0)
 	var mux sync.Mutex
+	var assetIDs, assetTypes, assetIdns []string
 	for rows.Next() {
 		var dbId int
 		var assetType, assetid, idnsStr string
-		var vulsBytes []byte
-		err = rows.Scan(&dbId, &assetType, &assetid, &idnsStr, &vulsBytes)
+		err = rows.Scan(&dbId, &assetType, &assetid, &idnsStr)
 		if err != nil {
 			pool.StopAndWait()
 			return nil, 0, perf, CVEDBReady, err
@@ -181,7 +182,29 @@ func FilterVulAssetsV2(allowed map[string]utils.Set, queryFilter *VulQueryFilter
 			}
 		}
 
-		batchProcessVulAsset(pool, &mux, dbVulAssets, assetid, assetType, idnsStr, vulsBytes)
+		assetIDs = append(assetIDs, assetid)
+		assetTypes = append(assetTypes, assetType)
+		assetIdns = append(assetIdns, idnsStr)
+	}
+	rows.Close()
+
+	// vuls of the matched assets, a batch of assets at a time
+	for i := 0; i < len(assetIDs); i += assetCVEQueryIDs {
+		end := i + assetCVEQueryIDs
+		if end > len(assetIDs) {
+			end = len(assetIDs)
+		}
+
+		assetCVEs, err := getAssetCVEs(assetIDs[i:end], nil)
+		if err != nil {
+			pool.StopAndWait()
+			return nil, 0, perf, CVEDBReady, err
+		}
+		for j := i; j < end; j++ {
+			if vuls, ok := assetCVEs[assetIDs[j]]; ok {
+				batchProcessVulAsset(pool, &mux, dbVulAssets, assetIDs[j], assetTypes[j], assetIdns[j], vuls)
+			}
+		}
 	}
 
 	// Stop the pool and wait for all submitted tasks to complete
@@ -236,9 +259,9 @@ func FilterVulAssetsV2(allowed map[string]utils.Set, queryFilter *VulQueryFilter
 	return dataSlice, nTotalCVE, perf, CVEDBReady, nil
 }
 
-func batchProcessVulAsset(pool *pond.WorkerPool, mu *sync.Mutex, dbVulAssets map[string]*DbVulAsset, assetid, assetType, idnsStr string, vulsBytes []byte) {
+func batchProcessVulAsset(pool *pond.WorkerPool, mu *sync.Mutex, dbVulAssets map[string]*DbVulAsset, assetid, assetType, idnsStr string, vuls []*share.ScanVulnerability) {
 	pool.Submit(func() {
-		cveList := funcGetCVEList(vulsBytes, idnsStr) // this function will do VPF and remove filtered data..
+		cveList := funcGetCVEList(vuls, idnsStr) // this function will do VPF and remove filtered data..
 		for _, c := range cveList {
 			name, dbkey, fix := parseCVEDbKey(c)
 
@@ -578,7 +601,7 @@ func GetVulAssetSessionV2(requesetQuery *VulQueryFilter) (*api.RESTVulnerability
 	tStart = time.Now()
 	assets := allAssets.ToStringSlice()
 	expAssets := goqu.Ex{"assetid": assets}
-	columns = []interface{}{"idns", "vulsb"}
+	columns = []interface{}{"assetid", "idns"}
 
 	statement, args, _ = dialect.From(Table_assetvuls).Select(columns...).Where(goqu.And(expAssets)).Prepared(true).ToSQL()
 	rows, err = dbHandle.Query(statement, args...)
@@ -587,22 +610,36 @@ func GetVulAssetSessionV2(requesetQuery *VulQueryFilter) (*api.RESTVulnerability
 	}
 	defer rows.Close()
 
+	assetIdns := make(map[string]string, len(assets))
+	for rows.Next() {
+		var assetid, idnsStr string
+		err = rows.Scan(&assetid, &idnsStr)
+		if err != nil {
+			return nil, nil, err
+		}
+		assetIdns[assetid] = idnsStr
+	}
+
+	// only the vuls of the CVEs on this page are read
+	names := make([]string, 0, len(resp.Vuls))
+	for _, vul := range resp.Vuls {
+		names = append(names, vul.Name)
+	}
+	assetCVEs, err := getAssetCVEs(assets, names)
+	if err != nil {
+		return nil, nil, err
+	}
+
 	poolSize := threadCount
 	pool := pond.New(poolSize, 0, pond.MinWorkers(poolSize))
 	var mux sync.Mutex
 
 	var nAssets int
-	for rows.Next() {
-		var vulsBytes []byte
-		var idnsStr string
-		err = rows.Scan(&idnsStr, &vulsBytes)
-		if err != nil {
-			pool.StopAndWait()
-			return nil, nil, err
+	for assetid, vuls := range assetCVEs {
+		if idnsStr, ok := assetIdns[assetid]; ok {
+			nAssets++
+			batchProessFillVulPackages(pool, &mux, cvePackages, vuls, idnsStr, nil)
 		}
-
-		nAssets++
-		batchProessFillVulPackages(pool, &mux, cvePackages, vulsBytes, idnsStr, nil)
 	}
 
 	// Stop the pool and wait for all submitted tasks to complete
@@ -980,7 +1017,7 @@ func DeleteAssetByID(assetType string, assetid string) error {
 	if err != nil {
 		return err
 	}
-	return nil
+	return deleteAssetCVEs(assetid)
 }
 
 func shouleRetry(err error) bool {
@@ -1006,9 +1043,9 @@ func buildAssetFilterWhereClause(queryFilter *api.VulQueryFilterViewModel) exp.E
 	return goqu.Or(exp1, exp2, exp3, exp4)
 }
 
-func batchProessFillVulPackages(pool *pond.WorkerPool, mu *sync.Mutex, cvePackages map[string]map[string]utils.Set, vulsBytes []byte, idnsStr string, cveList *[]string) {
+func batchProessFillVulPackages(pool *pond.WorkerPool, mu *sync.Mutex, cvePackages map[string]map[string]utils.Set, vuls []*share.ScanVulnerability, idnsStr string, cveList *[]string) {
 	pool.Submit(func() {
-		if err := funcFillVulPackages(mu, cvePackages, vulsBytes, idnsStr, cveList, nil); err != nil {
+		if err := funcFillVulPackages(mu, cvePackages, vuls, idnsStr, cveList, nil); err != nil {
 			log.WithFields(log.Fields{"error": err}).Error("funcFillVulPackages")
 		}
 	})
@@ -110,6 +110,7 @@
 #define THRT_ID_SYN_FLOOD       1001
 #define THRT_ID_ICMP_FLOOD      1002
 #define THRT_ID_IP_SRC_SESSION  1003
+#define THRT_ID_TCP_PORT_SCAN   1004
 
 // Pattern based
 #define THRT_ID_BAD_PACKET           2001
@@ -159,6 +160,15 @@
 #define DP_KIND_FQDN_UPDATE             11
 #define DP_KIND_IP_FQDN_STORAGE_UPDATE  12
 #define DP_KIND_IP_FQDN_STORAGE_RELEASE 13
+#define DP_KIND_THREAT_LOG_RING         14
+#define DP_KIND_CONNECTION_COMPACT      15
+#define DP_KIND_LATENCY                 16
+#define DP_KIND_CAPTURE                 17
+#define DP_KIND_CFG_RESTORE             18
+#define DP_KIND_MEM_STATS               19
+#define DP_KIND_OVERLOAD                20
+#define DP_KIND_FWD_LATENCY             21
+#define DP_KIND_POLICY_HITS             22
 
 typedef struct {
     uint8_t  Kind;
@@ -166,6 +176,18 @@ typedef struct {
     uint16_t Length;   // DPMsgHdr + Msg
 } DPMsgHdr;
 
+// Entries of a session or connection message are in host order, not network order. The
+// dp uses it once the agent asks for it in ctrl_keep_alive, they run on the same host.
+#define DP_MSG_FLAG_NATIVE  0x0001
+
+// A request that carries "req_id" is answered with every reply message prefixed by the id,
+// so the agent can have several requests in flight and match the replies to them.
+#define DP_CTRL_REQ_ID_KEY "req_id"
+
+typedef struct {
+    uint32_t ReqID;
+} DPMsgReplyHdr;
+
 typedef struct {
     uint16_t Port;
     uint16_t Proto;
@@ -200,6 +222,12 @@ typedef struct {
 #define DPSESS_FLAG_UWLIP         0x0200 // uwl connection
 #define DPSESS_FLAG_CHK_NBE       0x0400 // check nbe
 #define DPSESS_FLAG_NBE_SNS       0x0800 // same ns nbe
+#define DPSESS_FLAG_ASM_LIMITED   0x1000 // over the reassembly budget, in-order only
+
+// Inspection level of an endpoint, "inspect" of ctrl_cfg_mac. At the identify level, the
+// database parsers stop once the protocol is identified.
+#define DP_INSPECT_FULL     0
+#define DP_INSPECT_IDENTIFY 1
 
 #define DP_POLICY_APPLY_EGRESS  0x1
 #define DP_POLICY_APPLY_INGRESS 0x2
@@ -226,6 +254,151 @@ typedef struct {
 #define MSG_START    0x1
 #define MSG_END      0x2
 
+// Binary control messages from agent to dp. A JSON message starts with '{', a binary one
+// with DPCtrlBinHdr. Fields are in network order, addresses as returned by inet_addr(),
+// strings are a uint16_t length followed by the bytes, padded to 4 bytes. When
+// DP_CTRL_BIN_FLAG_MEMFD is set, the payload is in a memfd passed with SCM_RIGHTS instead
+// of following the header, so a large push is not split into messages.
+#define DP_CTRL_BIN_MAGIC 0xDB
+
+#define DP_CTRL_BIN_CFG_POLICY      1
+#define DP_CTRL_BIN_CFG_INTERNAL_NET 2
+#define DP_CTRL_BIN_CFG_POLICY_ADDR 3
+#define DP_CTRL_BIN_CFG_DLP         4
+#define DP_CTRL_BIN_BLD_DLP         5
+#define DP_CTRL_BIN_CFG_POLICY_DELTA 6
+
+#define DP_CTRL_BIN_FLAG_MEMFD 0x1
+
+typedef struct {
+    uint8_t  Magic;
+    uint8_t  Kind;
+    uint16_t Flags;
+    uint32_t Length;
+} DPCtrlBinHdr;
+
+typedef struct {
+    uint8_t  MAC[6];
+    uint16_t Padding;
+} DPCtrlBinMAC;
+
+// Followed by NumMACs DPCtrlBinMAC, NumRules DPCtrlBinPolicyRule and NumRules6
+// DPCtrlBinPolicyRule6. An ipv4 rule is followed by its fqdn string and NumApps
+// DPCtrlBinPolicyApp, an ipv6 rule by its NumApps DPCtrlBinPolicyApp only.
+typedef struct {
+    uint16_t Cmd;
+    uint16_t Flag;
+    uint8_t  DefAction;
+    uint8_t  ApplyDir;
+    uint16_t NumMACs;
+    uint32_t NumRules;
+    uint32_t NumRules6;
+} DPCtrlBinPolicy;
+
+typedef struct {
+    uint32_t ID;
+    uint32_t SIP;
+    uint32_t SIPR;
+    uint32_t DIP;
+    uint32_t DIPR;
+    uint16_t Port;
+    uint16_t PortR;
+    uint8_t  Proto;
+    uint8_t  Action;
+    uint8_t  Ingress;
+    uint8_t  Vhost;
+    uint16_t NumApps;
+    uint16_t Padding;
+} DPCtrlBinPolicyRule;
+
+typedef struct {
+    uint32_t ID;
+    uint8_t  SIP[16];
+    uint8_t  SIPR[16];
+    uint8_t  DIP[16];
+    uint8_t  DIPR[16];
+    uint16_t Port;
+    uint16_t PortR;
+    uint8_t  Proto;
+    uint8_t  Action;
+    uint8_t  Ingress;
+    uint8_t  Padding1;
+    uint16_t NumApps;
+    uint16_t Padding;
+} DPCtrlBinPolicyRule6;
+
+typedef struct {
+    uint32_t RuleID;
+    uint32_t App;
+    uint8_t  Action;
+    uint8_t  Padding[3];
+} DPCtrlBinPolicyApp;
+
+// Rule changes of the policy the MACs share. Followed by NumMACs DPCtrlBinMAC, NumDelRules
+// uint32_t rule IDs to delete, then NumRules ipv4 rules as in DPCtrlBinPolicy, which go after
+// the remaining rules in order.
+typedef struct {
+    uint16_t Flag;
+    uint16_t NumMACs;
+    uint32_t NumDelRules;
+    uint32_t NumRules;
+} DPCtrlBinPolicyDelta;
+
+// Followed by Count DPCtrlBinSubnet
+typedef struct {
+    uint16_t Flag;
+    uint16_t Padding;
+    uint32_t Count;
+} DPCtrlBinSubnetCfg;
+
+typedef struct {
+    uint32_t IP;
+    uint32_t Mask;
+} DPCtrlBinSubnet;
+
+#define DP_CTRL_BIN_DLP_RULE_IDS     0x1
+#define DP_CTRL_BIN_DLP_WAF_RULE_IDS 0x2
+#define DP_CTRL_BIN_DLP_NAMES        0x4
+#define DP_CTRL_BIN_DLP_WAF_NAMES    0x8
+
+// Followed by NumMACs DPCtrlBinMAC, NumRuleIDs and NumWafRuleIDs uint32_t, then NumDlpRules
+// and NumWafRules DPCtrlBinDlpSetting. Present tells which lists are set, an empty list
+// is different from a missing one.
+typedef struct {
+    uint16_t Flag;
+    uint8_t  DlpInside;
+    uint8_t  WafInside;
+    uint16_t Present;
+    uint16_t NumMACs;
+    uint32_t NumRuleIDs;
+    uint32_t NumWafRuleIDs;
+    uint32_t NumDlpRules;
+    uint32_t NumWafRules;
+} DPCtrlBinDlpCfg;
+
+typedef struct {
+    uint32_t ID;
+    uint8_t  Action;
+    uint8_t  Padding[3];
+} DPCtrlBinDlpSetting;
+
+// Followed by NumMACs and NumDelMACs DPCtrlBinMAC, then NumRules rules. A rule is followed
+// by its name string and NumPatterns pattern strings.
+typedef struct {
+    uint16_t Flag;
+    uint8_t  ApplyDir;
+    uint8_t  Padding;
+    uint32_t NumMACs;
+    uint32_t NumDelMACs;
+    uint32_t NumRules;
+} DPCtrlBinDlpBuild;
+
+typedef struct {
+    uint32_t ID;
+    uint16_t NumPatterns;
+    uint16_t Padding;
+} DPCtrlBinDlpRule;
+
 #define MAX_SIG_NAME_LEN 512 + 10
 #define DP_DLP_RULE_NAME_MAX_LEN MAX_SIG_NAME_LEN
 #define DP_DLP_RULE_PATTERN_MAX_LEN 512
@@ -276,10 +449,15 @@ typedef struct {
 
 typedef struct {
     uint16_t Sessions;
-    uint16_t Reserved;
+    uint16_t Flags;     // DP_MSG_FLAG_*
     // DPMsgSession Sessions[0];
 } DPMsgSessionHdr;
 
+// Last message of a session list asked with a cursor, after an empty DPMsgSessionHdr
+typedef struct {
+    uint64_t Cursor;    // to ask for the next sessions with, 0 at the end
+} DPMsgSessionCursor;
+
 #define DPMETER_FLAG_IPV4    0x01
 #define DPMETER_FLAG_TAP     0x02
 
@@ -307,6 +485,51 @@ typedef struct {
     // DPMsgMeter Meters[0];
 } DPMsgMeterHdr;
 
+#define DP_POOL_SESSION 0
+#define DP_POOL_CLIP    1
+#define DP_POOL_FRAG    2
+#define DP_POOL_METER   3
+#define DP_POOL_MAX     4
+
+// Subsystems heap memory is accounted to. Pooled objects count the chunks of their pool,
+// the others the usable size of their allocations.
+#define DP_MEM_SESSION  0   // sessions and their xff, tls and vhost extras
+#define DP_MEM_ASM      1   // tcp reassembly clips
+#define DP_MEM_FRAG     2   // ip fragment trackers
+#define DP_MEM_METER    3   // meters and their sketches
+#define DP_MEM_LOG      4   // threat log caches and rate limits
+#define DP_MEM_POLICY   5   // policy handles, fqdn and ip maps
+#define DP_MEM_DLP      6   // hyperscan databases and scratch
+#define DP_MEM_PARSER   7   // per-session parser data
+#define DP_MEM_MAX      8
+
+#define DP_MAP_SESSION4 0
+#define DP_MAP_SESSION6 1
+#define DP_MAP_FRAG4    2
+#define DP_MAP_FRAG6    3
+#define DP_MAP_METER    4
+#define DP_MAP_LOG      5
+#define DP_MAP_EP       6
+#define DP_MAP_MAX      7
+
+#define DP_SESS_EVICT_EMBRYONIC     0   // TCP before the handshake is done
+#define DP_SESS_EVICT_IDLE          1   // UDP, ICMP and other IP
+#define DP_SESS_EVICT_ESTABLISHED   2
+#define DP_SESS_EVICT_MAX           3
+
+// Packet pipeline stages of the latency histograms. There is one histogram per stage, then
+// one per parser type, DP_LAT_HISTS in all. Policy lookups of new sessions are done by the
+// trackers, their time counts in both stages.
+#define DP_LAT_RX           0   // endpoint lookup and accounting of a received packet
+#define DP_LAT_PARSE        1   // l2 to l4 header parsing
+#define DP_LAT_SESSION      2   // session lookup
+#define DP_LAT_TRACKER      3   // tcp, udp, icmp and ip trackers
+#define DP_LAT_POLICY       4   // policy lookups
+#define DP_LAT_DETECTOR     5   // dlp and waf pattern match
+#define DP_LAT_TX           6   // send or hand the packet back
+#define DP_LAT_STAGE_MAX    7
+#define DP_LAT_HISTS        (DP_LAT_STAGE_MAX + DPI_PARSER_MAX)
+
 typedef struct {
     uint64_t RXPackets;
     uint64_t RXDropPackets;
@@ -343,8 +566,175 @@ typedef struct {
     uint32_t PolicyDomainIPs;
     uint64_t LimitDropConns;
     uint64_t LimitPassConns;
+    uint64_t HandoffPackets;
+    uint64_t HandoffDropPackets;
+    uint64_t HugepageBytes;
+    uint64_t DTLBMisses;
+    // Object pools of the dp threads, high water marks are the sum of the threads' marks
+    uint64_t PoolInUse[DP_POOL_MAX];
+    uint64_t PoolHighWater[DP_POOL_MAX];
+    uint64_t PoolAllocFails[DP_POOL_MAX];
+    // Maps of all dp threads, the load factor is entries / buckets. The lfht based log and
+    // ep maps resize on their own, their buckets are the initial count and resizes are 0.
+    uint64_t MapEntries[DP_MAP_MAX];
+    uint64_t MapBuckets[DP_MAP_MAX];
+    uint64_t MapResizes[DP_MAP_MAX];
+    // Sessions evicted at the per-thread or per-endpoint session limit, and new sessions
+    // refused because nothing could be evicted
+    uint64_t SessionEvicts[DP_SESS_EVICT_MAX];
+    uint64_t SessionLimitDrops;
+    // Timer entries expired, rolls that stopped at the per-roll budget, and entries that
+    // were due but left for the next loop pass at the last roll
+    uint64_t TimerExpires;
+    uint64_t TimerDeferredRolls;
+    uint64_t TimerBacklog;
+    // Session lookups of ipv4 packets answered by the per-thread flow cache, and the ones
+    // that went on to the session map
+    uint64_t FlowCacheHits;
+    uint64_t FlowCacheMisses;
+    // Packets of sessions with a cached verdict that skipped inspection, and verdicts
+    // dropped by a policy or DLP/WAF change of the endpoint
+    uint64_t VerdictPackets;
+    uint64_t VerdictRevokes;
+    // Flows handed to the tc classifier of TC-mode endpoints, the ones the kernel map took
+    // no more of, and packets the classifier forwarded for them
+    uint64_t FlowOffloads;
+    uint64_t FlowOffloadFails;
+    uint64_t FlowOffloadPackets;
+    // Connections of nfq endpoints marked to skip the queue, and marks cleared again
+    uint64_t NfqMarks;
+    uint64_t NfqUnmarks;
+    // Policy lookups of new sessions answered by the decision cache of the policy handle,
+    // and the ones that matched the rules
+    uint64_t PolicyCacheHits;
+    uint64_t PolicyCacheMisses;
+    // Sessions moved to a new policy version without a lookup, the change did not cover
+    // their proto and port
+    uint64_t PolicyReevalSkips;
+    // Unknown ips added to the temporary open cache, and live entries evicted by newer ones
+    uint64_t UnknownIPInserts;
+    uint64_t UnknownIPEvicts;
+    // Bytes cached for tcp reassembly, and sessions that went over a reassembly budget
+    uint64_t AsmBytes;
+    uint64_t AsmLimits;
+    // Fragment trackers dropped for new datagrams over the per-thread cap
+    uint64_t FragmentEvictions;
+    // Timed packets of the latency histograms, see DP_LAT_*, and their latency in ns. The
+    // percentiles are the upper bounds of the buckets they fall in.
+    uint64_t LatencySamples[DP_LAT_HISTS];
+    uint64_t LatencyP50[DP_LAT_HISTS];
+    uint64_t LatencyP99[DP_LAT_HISTS];
+    uint64_t LatencyMax[DP_LAT_HISTS];
+    uint64_t ParserCPUTime[DPI_PARSER_MAX];     // ns in each parser, all packets
+    // Objects unpublished by the ctrl thread and waiting for the reclaimer, its most, the
+    // grace periods it waited and the objects it freed
+    uint64_t ReclaimDepth;
+    uint64_t ReclaimHighWater;
+    uint64_t ReclaimBatches;
+    uint64_t ReclaimFreed;
 } DPMsgDeviceCounter;
 
+// DP_KIND_LATENCY answers ctrl_latency with the non-empty histograms of all dp threads,
+// over as many messages as needed. Each DPMsgLatencyHist is followed by its non-empty
+// buckets. Values are in ticks of TscHz.
+typedef struct {
+    uint64_t TscHz;
+    uint32_t Sample;        // one in Sample packets is timed, 0 when off
+    uint16_t Hists;
+    uint16_t Reserved;
+} DPMsgLatencyHdr;
+
+typedef struct {
+    uint8_t  Hist;          // DP_LAT_*, or DP_LAT_STAGE_MAX + the parser type
+    uint8_t  Reserved;
+    uint16_t Buckets;
+    uint32_t Reserved2;
+    uint64_t Count;
+    uint64_t Sum;
+    uint64_t Max;
+} DPMsgLatencyHist;
+
+typedef struct {
+    uint64_t Low;           // lowest value of the bucket
+    uint64_t Count;
+} DPMsgLatencyBucket;
+
+// DP_KIND_FWD_LATENCY answers ctrl_stats_fwd_latency with the time from rx to tx of the timed
+// packets of each inline interface, over as many messages as needed. Each DPMsgFwdLatency is
+// followed by its non-empty buckets, as DPMsgLatencyBucket. Values are in ns.
+typedef struct {
+    uint32_t Sample;        // one in Sample packets is timed, 0 when off
+    uint16_t Ctxs;
+    uint16_t Reserved;
+} DPMsgFwdLatencyHdr;
+
+typedef struct {
+    char     Iface[32];
+    uint16_t Buckets;
+    uint16_t Reserved;
+    uint32_t Reserved2;
+    uint64_t Count;
+    uint64_t Sum;
+    uint64_t Max;
+} DPMsgFwdLatency;
+
+// DP_KIND_POLICY_HITS answers ctrl_policy_hits with the sessions each policy rule decided on,
+// summed over all dp threads and sorted by rule id, over as many messages as needed. Rule 0
+// is the default action. Overflow counts the decisions of rules the per-thread tables had no
+// room for.
+typedef struct {
+    uint32_t Since;         // time of the last reset, 0 since the dp started
+    uint16_t Hits;
+    uint16_t Reserved;
+    uint64_t Overflow;
+} DPMsgPolicyHitsHdr;
+
+typedef struct {
+    uint32_t ID;
+    uint32_t LastHit;       // time of the last session
+    uint64_t Hits;
+} DPMsgPolicyHit;
+
+// State of the packet capture, the last one if none is running
+typedef struct {
+    uint8_t  Active;
+    uint8_t  Reserved[3];
+    uint32_t Limit;
+    uint64_t Packets;       // written to the file
+    uint64_t Bytes;         // captured bytes written
+    uint64_t Drops;         // matched but lost on a full ring
+} DPMsgCapture;
+
+// Answer of ctrl_cfg_restore. If Valid, the config of the dp is the first Gen config
+// messages the agent sent since it reset the journal, otherwise it needs a full push.
+typedef struct {
+    uint32_t Gen;
+    uint8_t  Valid;
+    uint8_t  Reserved[3];
+} DPMsgCfgRestore;
+
+// Answer of ctrl_mem_stats. Bytes are by DP_MEM_*, summed over all threads; a subsystem
+// allocating in one thread and freeing in another is only right in the sum.
+typedef struct {
+    uint64_t Allocated;     // in use as reported by jemalloc, all arenas
+    uint64_t Resident;
+    uint64_t ArenaBytes;    // in use in the arenas of the dp threads
+    int64_t  Bytes[DP_MEM_MAX];
+} DPMsgMemStats;
+
+// Sent when a dp thread enters or leaves the overload mode. While overloaded, new sessions
+// are admitted at a limited rate and established allowed sessions are no longer inspected.
+typedef struct {
+    uint16_t Thread;
+    uint8_t  Overloaded;
+    uint8_t  Reserved;
+    uint32_t Enters;        // times the thread was overloaded
+    uint32_t Seconds;       // how long the mode lasted, when it is left
+    uint32_t Reserved2;
+    uint64_t ShedSessions;  // new sessions refused in the mode
+    uint64_t ShedInspects;  // sessions let through without parsers and DLP/WAF
+} DPMsgOverload;
+
 typedef struct {
     uint32_t Interval;
     uint32_t Padding;
@@ -378,6 +768,10 @@ typedef struct {
     uint64_t PacketOut60;
     uint64_t ByteIn60;
     uint64_t ByteOut60;
+
+    uint64_t CPUTime;   // ns the dp threads spent on the packets, since the endpoint was added
+    uint64_t RateDropIn;    // packets dropped over the endpoint rate limit
+    uint64_t RateDropOut;
 } DPMsgStats;
 
 #define DPLOG_MAX_MSG_LEN         64
@@ -411,6 +805,99 @@ typedef struct {
     uint32_t DlpNameHash;
 } DPMsgThreatLog;
 
+// Threat logs of the dp threads, one ring per thread in a shared memory file mapped by the
+// agent. A ring has one writer, its dp thread, and one reader, the agent. Indexes are free
+// running and in host order, the logs are in network order as in DP_KIND_THREAT_LOG. A
+// DP_KIND_THREAT_LOG_RING message, a header with no body, tells the agent to read the rings.
+#define DP_LOG_SHM_NAME     "/dp_threat_log.shm"
+#define DP_LOG_SHM_MAGIC    0x44504c47
+#define DP_LOG_RING_ENTRIES 512
+
+typedef struct {
+    uint32_t Magic;     // set once the rings are ready
+    uint16_t Rings;
+    uint16_t Entries;   // per ring
+    uint32_t RingSize;  // bytes from a ring to the next, the first one follows this header
+    uint8_t  Pad[52];
+} DPLogShmHdr;
+
+typedef struct {
+    uint32_t Writer;    // next log to write, moved by the dp
+    uint8_t  Pad1[60];
+    uint32_t Reader;    // next log to read, moved by the agent
+    uint8_t  Pad2[60];
+    uint64_t Drops;     // logs lost on a full ring
+    uint8_t  Pad3[56];
+    DPMsgThreatLog Logs[DP_LOG_RING_ENTRIES];
+} DPLogRing;
+
+// Counters of the dp threads in a shared memory file, so they can be scraped without a
+// request to the dp. Each thread rewrites its own page once a second. Seq is odd while the
+// page is written, a reader copies the page and retries if Seq was odd or has changed.
+// Counters are totals since the dp started, in host order.
+#define DP_STATS_SHM_NAME   "/dp_stats.shm"
+#define DP_STATS_SHM_MAGIC  0x44505354
+
+typedef struct {
+    uint32_t Magic;     // set once the pages are ready
+    uint16_t Threads;   // pages written, the others stay zero
+    uint16_t Pages;
+    uint32_t PageSize;  // bytes from a page to the next, the first one follows this header
+    uint32_t Pad1;
+    // Heap memory by DP_MEM_* of the ctrl and other non-dp threads, updated once a second
+    int64_t  SharedMemBytes[DP_MEM_MAX];
+    uint8_t  Pad2[48];
+} DPStatsShmHdr;
+
+typedef struct {
+    uint32_t Seq;
+    uint32_t UpdatedAt;     // unix time
+    uint32_t Load;          // busy time of the last second, in permille
+    uint32_t Overloaded;    // in the overload mode, see DPMsgOverload
+    uint64_t RXPackets;
+    uint64_t RXDropPackets;
+    uint64_t TXPackets;
+    uint64_t TXDropPackets;
+    uint64_t HandoffPackets;
+    uint64_t HandoffDropPackets;
+    uint64_t QuarDropPackets;   // dropped on quarantined ports before inspection
+    uint64_t ErrorPackets;
+    uint64_t NoWorkloadPackets;
+    uint64_t IPv4Packets;
+    uint64_t IPv6Packets;
+    uint64_t TCPPackets;
+    uint64_t UDPPackets;
+    uint64_t ICMPPackets;
+    uint64_t OtherPackets;
+    uint64_t TotalSessions;
+    uint64_t TCPSessions;
+    uint64_t UDPSessions;
+    uint64_t ICMPSessions;
+    uint64_t IPSessions;
+    uint64_t CurSessions;
+    uint64_t CurTCPSessions;
+    uint64_t CurUDPSessions;
+    uint64_t CurICMPSessions;
+    uint64_t CurIPSessions;
+    uint64_t DropMeters;
+    uint64_t ProxyMeters;
+    uint64_t CurMeters;
+    uint64_t CurLogCaches;
+    uint64_t LogDrops;      // threat logs lost on a full ring
+    uint64_t LogSuppressed; // threat logs held back by their rate limit
+    uint64_t DlpScanBytes;
+    uint64_t PoolInUse[DP_POOL_MAX];
+    uint64_t PoolHighWater[DP_POOL_MAX];
+    uint64_t PoolAllocFails[DP_POOL_MAX];
+    int64_t  MemBytes[DP_MEM_MAX];  // heap memory of the thread by DP_MEM_*
+    uint64_t ArenaBytes;            // in use in the thread's jemalloc arena
+    uint64_t OverloadEnters;
+    uint64_t ShedSessions;
+    uint64_t ShedInspects;
+    uint64_t InflateBytes;  // of http bodies inflated for DLP
+    uint64_t InflateLimits; // bodies not inflated to the end for the limits
+} __attribute__((aligned(64))) DPStatsPage;
+
 #define DPCONN_FLAG_INGRESS       0x0001
 #define DPCONN_FLAG_EXTERNAL      0x0002
 #define DPCONN_FLAG_XFF           0x0004
@@ -449,10 +936,38 @@ typedef struct {
 
 typedef struct {
     uint16_t Connects;
-    uint16_t Reserved;
+    uint16_t Flags;     // DP_MSG_FLAG_*, not for the compact encoding
     // DPMsgConnect Connect[0];
 } DPMsgConnectHdr;
 
+// DP_KIND_CONNECTION_COMPACT has the same header, followed by variable length entries. Each
+// entry starts with a mask of the DPMsgConnect fields that differ from the previous entry
+// of the message, the first entry is compared to an all zero one. Fields in the mask follow
+// in bit order: EPMAC, ClientIP and ServerIP as raw bytes, the IPs 4 or 16 bytes long by
+// the EtherType of the entry, the others as unsigned LEB128 varints. The mask is a varint.
+#define DPCONN_FIELD_EPMAC          0
+#define DPCONN_FIELD_IPPROTO        1
+#define DPCONN_FIELD_SERVER_PORT    2
+#define DPCONN_FIELD_CLIENT_PORT    3
+#define DPCONN_FIELD_ETHER_TYPE     4
+#define DPCONN_FIELD_CLIENT_IP      5
+#define DPCONN_FIELD_SERVER_IP      6
+#define DPCONN_FIELD_FLAGS          7
+#define DPCONN_FIELD_BYTES          8
+#define DPCONN_FIELD_SESSIONS       9
+#define DPCONN_FIELD_FIRST_SEEN     10
+#define DPCONN_FIELD_LAST_SEEN      11
+#define DPCONN_FIELD_APPLICATION    12
+#define DPCONN_FIELD_POLICY_ACTION  13
+#define DPCONN_FIELD_SEVERITY       14
+#define DPCONN_FIELD_POLICY_ID      15
+#define DPCONN_FIELD_VIOLATES       16
+#define DPCONN_FIELD_THREAT_ID      17
+#define DPCONN_FIELD_SESS_CUR_IN    18
+#define DPCONN_FIELD_SESS_IN12      19
+#define DPCONN_FIELD_BYTE_IN12      20
+#define DPCONN_FIELD_MAX            21
+
 typedef struct {
     uint8_t  FqdnIP[16];
 } DPMsgFqdnIp;
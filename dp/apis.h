@@ -17,6 +17,8 @@
 #include "utils/rcu_map.h"
 #include "utils/bitmap.h"
 #include "utils/timer_wheel.h"
+#include "utils/ip4_lpm.h"
+#include "utils/lat_hist.h"
 
 #define MAX_THREAD_NAME_LEN 32
 extern __thread int THREAD_ID;
@@ -30,8 +32,55 @@ enum {
     CTRL_REQ_LIST_METER,
     CTRL_REQ_DEL_MAC,
     CTRL_REQ_DUMP_POLICY,
+    CTRL_REQ_MIGRATE_CTX,
+    CTRL_REQ_LIST_SESSION_CHUNK,
+    CTRL_REQ_RESIZE_CTX,
 };
 
+// Completion of a control command posted to one or more dp threads. It is reference
+// counted so a waiter that times out can leave while the threads are still working.
+typedef struct io_ctrl_future_ {
+    int pending;        // dp threads yet to complete, the waiter sleeps on it
+    int refcnt;
+    uint64_t result;    // of a command posted to one thread
+} io_ctrl_future_t;
+
+// A chunk of the sessions of one dp thread. The cursor is a position in its session maps,
+// 0 to start; the thread sets the future result to the cursor to go on from, or to
+// CTRL_SESSION_CURSOR_END.
+#define CTRL_SESSION_CURSOR_END UINT64_MAX
+#define CTRL_SESSION_BY_MAC     0x01
+#define CTRL_SESSION_BY_PORT    0x02
+#define CTRL_SESSION_BY_APP     0x04
+#define CTRL_SESSION_BY_ACTION  0x08
+typedef struct io_ctrl_session_list_ {
+    uint64_t cursor;
+    uint32_t limit;
+    uint8_t filters;            // CTRL_SESSION_BY_xxx
+    uint8_t action;             // policy action
+    uint16_t port;              // server port
+    uint16_t app;
+    struct ether_addr mac;      // endpoint
+} io_ctrl_session_list_t;
+
+typedef struct io_ctrl_cmd_ {
+    int req;            // CTRL_REQ_xxx
+    union {
+        uint32_t sess_id;           // CTRL_REQ_CLEAR_SESSION, 0 to clear all
+        struct ether_addr mac;      // CTRL_REQ_DEL_MAC
+        io_ctrl_session_list_t list;    // CTRL_REQ_LIST_SESSION_CHUNK
+        struct {
+            void *ctx;
+            int dst;
+        } migrate;                  // CTRL_REQ_MIGRATE_CTX, run by the owner of ctx
+        struct {
+            void *ctx;
+            void *ring_ctx;         // holds the socket of the new ring
+        } resize;                   // CTRL_REQ_RESIZE_CTX, run by the owner of ctx
+    };
+    io_ctrl_future_t *future;       // NULL if nobody waits
+} io_ctrl_cmd_t;
+
 enum {
     CTRL_DLP_REQ_NONE = 0,
     CTRL_DLP_REQ_BLD,
@@ -51,7 +100,7 @@ typedef struct io_counter_ {
     uint64_t pkt_id, err_pkts, unkn_pkts, ipv4_pkts, ipv6_pkts;
     uint64_t tcp_pkts, tcp_nosess_pkts, udp_pkts, icmp_pkts, other_pkts;
     uint64_t drop_pkts, total_asms, freed_asms;
-    uint64_t total_frags, tmout_frags, freed_frags;
+    uint64_t total_frags, tmout_frags, freed_frags, evict_frags;
 
     uint64_t sess_id, tcp_sess, udp_sess, icmp_sess, ip_sess;
     uint32_t cur_sess, cur_tcp_sess, cur_udp_sess, cur_icmp_sess, cur_ip_sess;
@@ -61,10 +110,38 @@ typedef struct io_counter_ {
     uint64_t drop_meters, proxy_meters;
     uint64_t cur_meters, cur_log_caches;
     uint32_t type1_rules, type2_rules, domains, domain_ips;
+    uint32_t pool_in_use[DP_POOL_MAX], pool_high_water[DP_POOL_MAX];
+    uint64_t pool_fails[DP_POOL_MAX];
+    int64_t mem_bytes[DP_MEM_MAX];
+    uint32_t map_entries[DP_MAP_MAX], map_buckets[DP_MAP_MAX], map_resizes[DP_MAP_MAX];
+    uint64_t sess_evicts[DP_SESS_EVICT_MAX], sess_limit_drops;
+    uint64_t timer_expires, timer_deferred;
+    uint32_t timer_backlog;
+    uint64_t flow_cache_hits, flow_cache_misses;
+    uint64_t verdict_pkts, verdict_revokes;
+    uint64_t offload_flows, offload_fails, offload_pkts;
+    uint64_t nfq_marks, nfq_unmarks;
+    uint64_t shed_sessions, shed_inspects;
+    uint64_t policy_cache_hits, policy_cache_misses;
+    uint64_t policy_reeval_skips;
+    uint64_t unknown_ip_inserts, unknown_ip_evicts;
+    uint64_t asm_bytes, asm_limits;
+    uint64_t dlp_scan_bytes;
+    uint32_t cur_inflates;
+    uint64_t inflate_bytes, inflate_limits;
+    uint64_t log_suppressed;
+    uint64_t parser_ticks[DPI_PARSER_MAX];
+    uint64_t icmp_checks, icmp_skips, icmp_tunnels;
 } io_counter_t;
 
 #define STATS_SLOTS 60
 #define STATS_INTERVAL 5 // in second
+#define STATS_WIN_SHORT 12 // in slots
+#define STATS_WIN_LONG  59
+typedef struct io_window_ {
+    uint64_t sess, pkt, byte;
+} io_window_t;
+
 typedef struct io_metry_ {
     uint64_t session;
     uint64_t packet;
@@ -73,6 +150,9 @@ typedef struct io_metry_ {
     uint32_t pkt_ring[STATS_SLOTS];
     uint32_t byte_ring[STATS_SLOTS];
     uint32_t cur_session;
+    uint64_t rate_drop;         // packets over the endpoint rate limit
+    // Sums of the complete slots before cur_slot, updated when the slot moves
+    io_window_t win_short, win_long;
 } io_metry_t;
 
 typedef struct io_stats_ {
@@ -106,6 +186,37 @@ typedef struct io_internal_pip_ {
     io_pip_t list[0];
 } io_internal_pip_t;
 
+// Blocks taken on the sidecar's leg of a meshed pod, read by the dp thread of the network leg.
+// A slot is the key hash << 32 | expiry tick, written and read as a whole.
+#define IO_MESH_VERDICT_SLOTS   256
+#define IO_MESH_VERDICT_TIMEOUT 10
+
+typedef struct io_mesh_verdict_ {
+    uint64_t slot[IO_MESH_VERDICT_SLOTS];
+} io_mesh_verdict_t;
+
+// Rate limit of an endpoint, set by ctrl_cfg_rate_limit. A bucket is the GCRA form of a token
+// bucket: the tsc time the next packet is due at, each packet moves it by its cost. A packet
+// over the limit is one that comes more than IO_RATE_BURST_MS before it is due. Each dp thread
+// has its own buckets, an endpoint gets the limit on each thread its packets are on.
+#define IO_RATE_EGRESS      0
+#define IO_RATE_INGRESS     1
+#define IO_RATE_BURST_MS    100
+#define IO_RATE_BYTE_SHIFT  16      // fraction bits of byte_cost
+
+typedef struct io_rate_bucket_ {
+    uint64_t pkt_due;
+    uint64_t byte_due;
+} io_rate_bucket_t;
+
+typedef struct io_rate_limit_ {
+    uint64_t pkt_cost[2];       // tsc ticks a packet takes, 0 if not limited
+    uint64_t byte_cost[2];      // tsc ticks a byte takes << IO_RATE_BYTE_SHIFT, 0 if not limited
+    uint64_t burst;             // tsc ticks of IO_RATE_BURST_MS
+    uint64_t pps[2], bps[2];    // as configured, bps in bits
+    io_rate_bucket_t bucket[MAX_DP_THREADS][2];
+} io_rate_limit_t;
+
 #define DLP_RULETYPE_INSIDE "inside"
 #define DLP_RULETYPE_OUTSIDE "outside"
 #define WAF_RULETYPE_INSIDE "wafinside"
@@ -122,7 +233,9 @@ typedef struct io_ep_ {
 
     uint32_t COPY_START;
 
-    io_stats_t stats;
+    io_stats_t stats[MAX_DP_THREADS]; // by dp thread, summed when read
+    uint32_t asm_bytes;     // cached for reassembly by its sessions on all dp threads
+    uint64_t cpu_ticks[MAX_DP_THREADS]; // tsc ticks in dpi_recv_packet(), by dp thread
 
     rcu_map_t app_map;
     uint32_t app_updated;
@@ -144,9 +257,14 @@ typedef struct io_ep_ {
     rcu_map_t waf_rid_map;
     void *dlp_detector;
     uint16_t dlp_detect_ver;
+    uint16_t inspect_ver;   // bumped when DLP/WAF of the endpoint changes
     bool dlp_inside;
     bool waf_inside;
     bool nbe;
+    uint8_t inspect_level;  // DP_INSPECT_xxx
+    io_mesh_verdict_t *mesh_verdict; // with "mesh_dedup", only the proxymesh child is inspected
+    uint32_t tap_sample;    // in tap mode, KB of a session inspected before only counting, 0 for all
+    io_rate_limit_t *rate_limit; // inline and nfq only, NULL if not limited
 } io_ep_t;
 
 typedef struct io_mac_ {
@@ -163,6 +281,8 @@ typedef struct io_subnet4_ {
 } io_subnet4_t;
 
 typedef struct io_internal_subnet4_ {
+    ip4_lpm_t *lpm;             // compiled from the list for subnet lookup
+    ip4_set_t *set;             // compiled from the list for exact address lookup
     int count;
     io_subnet4_t list[0];
 } io_internal_subnet4_t;
@@ -191,12 +311,21 @@ typedef struct io_spec_subnet4_ {
 } io_spec_subnet4_t;
 
 typedef struct io_spec_internal_subnet4_ {
+    ip4_lpm_t *lpm;
     int count;
     io_spec_subnet4_t list[0];
 } io_spec_internal_subnet4_t;
 
+// Endpoint last found for the packets of an rx context, valid while gen is g_ep_map_gen
+typedef struct io_ep_cache_ {
+    uint32_t gen;
+    struct ether_addr mac;
+    io_mac_t *entry;
+} io_ep_cache_t;
+
 typedef struct io_ctx_ {
     void *dp_ctx;
+    io_ep_cache_t *ep_cache;    // NULL if the context is not owned by the thread
     uint32_t tick;
     uint32_t stats_slot;
     struct ether_addr ep_mac;
@@ -205,8 +334,33 @@ typedef struct io_ctx_ {
     bool tc;
     bool quar;
     bool nfq;
+    bool nfq_mark;              // nfq packet of a connection that skips the queue, a sample
+    bool proxymesh;             // tap of the loopback of a proxy mesh sidecar
+    uint64_t rx_ns;             // rx timestamp of a timed inline packet, 0 if not timed
 } io_ctx_t;
 
+// A packet of an rx batch, large_frame and rx_ns are copied to the io_ctx_t for the packet
+typedef struct io_pkt_ {
+    uint8_t *pkt;
+    int len;
+    bool large_frame;
+    uint64_t rx_ns;
+} io_pkt_t;
+
+// One direction of an ipv4 flow handed to the tc classifier, mac of the endpoint it belongs
+// to, addresses and ports in network order. The classifier builds the same key, see offload.c.
+typedef struct io_flow_key_ {
+    uint8_t mac[ETH_ALEN];
+    uint8_t proto;
+    uint8_t pad;
+    uint32_t sip, dip;
+    uint16_t sport, dport;
+} io_flow_key_t;
+
+typedef struct io_flow_stats_ {
+    uint64_t pkts, bytes;
+} io_flow_stats_t;
+
 typedef struct io_callback_ {
     int (*debug) (bool print_ts, const char *fmt, va_list args);
     int (*send_packet) (io_ctx_t *ctx, uint8_t *data, int len);
@@ -215,6 +369,10 @@ typedef struct io_callback_ {
     int (*threat_log) (DPMsgThreatLog *log);
     int (*traffic_log) (DPMsgSession *log);
     int (*connect_report) (DPMsgSession *log, DPMonitorMetric *metric, int count_session, int count_violate);
+    // Kernel flow offload, NULL if not available
+    int (*flow_offload) (const io_flow_key_t *key);
+    int (*flow_unload) (const io_flow_key_t *key, io_flow_stats_t *stats);
+    int (*flow_stats) (const io_flow_key_t *key, io_flow_stats_t *stats);
 } io_callback_t;
 
 typedef struct dpi_config_ {
@@ -225,23 +383,75 @@ typedef struct dpi_config_ {
 
     io_mac_t dummy_mac;
     io_ep_t dummy_ep;
+
+    // Objects preallocated by each dp thread and the per-thread cap, 0 for no cap
+    uint32_t pool_prealloc[DP_POOL_MAX];
+    uint32_t pool_cap[DP_POOL_MAX];
+    // Expected entries of each map of a dp thread, 0 for the default
+    uint32_t map_size[DP_MAP_MAX];
+    // Max. sessions of a dp thread and of an endpoint, 0 for no limit
+    uint32_t sess_limit;
+    uint32_t ep_sess_limit;
+    // Max. bytes cached for tcp reassembly by a session wing, an endpoint and a dp thread,
+    // 0 for no limit
+    uint32_t asm_wing_limit;
+    uint32_t asm_ep_limit;
+    uint32_t asm_thread_limit;
 } io_config_t;
 
 #define DPI_INIT 0
 
 typedef void (*dpi_stats_callback_fct)(io_stats_t *stats, io_stats_t *s);
 
+typedef struct io_capture_ {
+    struct ether_addr mac;      // capture all endpoints if zero
+    uint32_t snaplen;
+    uint32_t limit;             // packets
+    const char *filter;         // pcap filter expression, NULL to take all
+    const char *path;           // pcapng file
+} io_capture_t;
+
 // in
 void dpi_setup(io_callback_t *cb, io_config_t *cfg);
 void dpi_init(int reason);
+// Verdicts of dpi_recv_packet() for nfq packets. A marked connection skips the queue, but for
+// TCP SYN, FIN, RST and samples of the other packets, see the rules in agent/pipe/port.go.
+#define DPI_VERDICT_ACCEPT      0
+#define DPI_VERDICT_DROP        1
+#define DPI_VERDICT_MARK        2   // accept and mark the connection
+#define DPI_VERDICT_UNMARK      3   // accept and clear the mark, all packets are queued again
+#define DPI_VERDICT_UNMARK_DROP 4
+
 int dpi_recv_packet(io_ctx_t *context, uint8_t *pkt, int len);
+void dpi_recv_batch(io_ctx_t *context, io_pkt_t *pkts, int count, uint8_t *verdicts);
 void dpi_timeout(uint32_t tick);
+bool dpi_timer_roll(uint32_t now_ms);
+void dpi_overload(bool on, uint32_t sessions);
+void dpi_reset_flush(void);
+void dpi_debug_set_filter(const struct ether_addr *mac, uint32_t ip);
 
-void dpi_handle_ctrl_req(int req, io_ctx_t *context);
-void dpi_handle_dlp_ctrl_req(int req);
+void dpi_handle_ctrl_req(io_ctrl_cmd_t *cmd, io_ctx_t *context);
+void dpi_handle_dlp_ctrl_req(void);
 void dpi_get_device_counter(DPMsgDeviceCounter *c);
+void dpi_read_counter(int thr_id, io_counter_t *c);
+int dpi_app_dirty_drain(int thr_id, struct ether_addr *macs, int max);
 void dpi_count_session(DPMsgSessionCount *c);
+void dpi_get_latency(lat_hist_t *hists);
+int dpi_get_policy_hits(DPMsgPolicyHit **hits, uint64_t *overflow);
 void dpi_get_stats(io_stats_t *stats, dpi_stats_callback_fct cb);
+void dpi_stats_window(const io_metry_t *a, uint32_t last, uint32_t cur, uint32_t len, io_window_t *w);
+void dpi_session_flow_bits(const struct ether_addr *ep_mac, uint8_t *bits, uint32_t nbits);
+int dpi_capture_start(io_capture_t *cap);
+void dpi_capture_stop(void);
+void dpi_capture_drain(void);
+void dpi_capture_status(DPMsgCapture *m);
+int dpi_trace_dump(const char *path);
+void dpi_trace_dump_timer(void);
+void dpi_trace_request_dump(void);
+#define DPI_RESUME_SHM_NAME "/dp_sess.shm"
+int dpi_resume_init(const char *shm_name);
+void dpi_stage_attach(dp_mnt_stage_t *stage);
+void dpi_resume_timer(void);
 
 
 #define GET_EP_FROM_MAC_MAP(buf)  (io_ep_t *)(buf + sizeof(io_mac_t) * 3)
@@ -269,6 +479,21 @@ typedef struct dpi_policy_rule_ {
     dpi_policy_app_rule_t *app_rules;
 } dpi_policy_rule_t;
 
+typedef struct dpi_policy_rule6_ {
+    uint32_t id;
+    struct in6_addr sip;
+    struct in6_addr sip_r;
+    struct in6_addr dip;
+    struct in6_addr dip_r;
+    uint16_t dport;
+    uint16_t dport_r;
+    uint16_t proto;
+    uint8_t action;
+    bool ingress;
+    uint32_t num_apps;
+    dpi_policy_app_rule_t *app_rules;
+} dpi_policy_rule6_t;
+
 typedef struct dpi_policy_ {
     int num_macs;
     struct ether_addr *mac_list;
@@ -276,9 +501,15 @@ typedef struct dpi_policy_ {
     int apply_dir;
     int num_rules;
     dpi_policy_rule_t *rule_list;
+    int num_rules6;
+    dpi_policy_rule6_t *rule6_list;
+    int num_del_ids;            // delta only, rule ids to delete
+    uint32_t *del_ids;
 } dpi_policy_t;
 
 int dpi_policy_cfg(int cmd, dpi_policy_t *policy, int flag);
+int dpi_policy_delta(dpi_policy_t *policy);
+void dpi_policy_cache_invalidate(void);
 void dp_policy_destroy(void *policy_hdl);
 void dpi_fqdn_entry_mark_delete(const char *name);
 void dpi_fqdn_entry_delete_marked();
@@ -311,10 +542,16 @@ typedef struct fqdn_name_entry_ {
     fqdn_record_t *r;
 } fqdn_name_entry_t;
 
+#define DPI_FQDN_MAX_ENTRIES      DP_POLICY_FQDN_MAX_ENTRIES
+#define DPI_FQDN_CODE_WORDS       (DPI_FQDN_MAX_ENTRIES / (sizeof(bitmap_type) * 8))
+// Bit of a fqdn code in the code bitmaps, codes are the network order of index + 1
+#define DPI_FQDN_CODE_BIT(code)   (ntohl(code) - 1)
+
 typedef struct fqdn_ipv4_entry_ {
     struct cds_lfht_node node;
     uint32_t ip;
     struct cds_list_head rlist;//IP->FQDN(s) mapping
+    bitmap_type codes[DPI_FQDN_CODE_WORDS];     // of the records in rlist
 } fqdn_ipv4_entry_t;
 
 typedef struct fqdn_ipv4_item_ {
@@ -322,11 +559,34 @@ typedef struct fqdn_ipv4_item_ {
     uint32_t ip;
 } fqdn_ipv4_item_t;
 
+// A label of the wildcard suffix trie. Wildcard names are added by their labels in reverse,
+// "*.mail.yahoo.com" is com -> yahoo -> mail with the record on the last node. A node is
+// keyed by its parent and label in fqdn_wild_map, a snooped name is matched against all
+// wildcard names in a lookup per label.
+typedef struct fqdn_wild_node_ {
+    struct cds_lfht_node node;
+    struct fqdn_wild_node_ *parent;
+    fqdn_record_t *r;           // of the wildcard name ending here, rcu
+    uint32_t children;
+    uint8_t depth;              // labels from the top
+    uint8_t len;
+    char label[64];
+    struct cds_list_head del;
+} fqdn_wild_node_t;
+
+typedef struct fqdn_wild_key_ {
+    fqdn_wild_node_t *parent;
+    const char *label;
+    int len;
+} fqdn_wild_key_t;
+
 #define DPI_FQDN_DELETE_QLEN      32
-#define DPI_FQDN_MAX_ENTRIES      DP_POLICY_FQDN_MAX_ENTRIES
+#define DPI_FQDN_BLOOM_BITS       16
 typedef struct dpi_fqdn_hdl_ {
     rcu_map_t fqdn_name_map;
     rcu_map_t fqdn_ipv4_map;
+    rcu_map_t fqdn_wild_map;
+    fqdn_record_t *records[DPI_FQDN_MAX_ENTRIES];   // by code bit
     bitmap *bm;
     int code_cnt;
     int del_name_cnt;
@@ -334,6 +594,11 @@ typedef struct dpi_fqdn_hdl_ {
     fqdn_name_entry_t *del_name_list[DPI_FQDN_DELETE_QLEN];
     fqdn_ipv4_entry_t *del_ipv4_list[DPI_FQDN_DELETE_QLEN];
     struct cds_list_head del_rlist;
+    struct cds_list_head del_wlist;
+    struct fqdn_del_batch_ *del_batches;           // reclaimed, codes not released yet
+    // Bloom filter of the configured names and wildcard suffixes. Bits are never cleared,
+    // a deleted name only costs a false positive.
+    uint8_t name_bloom[1 << (DPI_FQDN_BLOOM_BITS - 3)];
 } dpi_fqdn_hdl_t;
 
 typedef struct fqdn_iter_ctx_ {
@@ -383,7 +648,6 @@ typedef struct io_dlp_cfg_ {
     uint32_t sigid;
     uint8_t action;
     bool enable;
-    struct cds_list_head sig_user_list;
 } io_dlp_cfg_t;
 
 typedef struct io_dlp_ruleid_ {
@@ -416,13 +680,22 @@ int dpi_sig_bld_update_mac(dpi_dlpbld_mac_t *dlpbld_mac);
 void dp_dlp_destroy(void *dlp_detector);
 
 #define CTRL_REQ_TIMEOUT 4
-#define CTRL_DLP_REQ_TIMEOUT 2
-extern pthread_cond_t g_ctrl_req_cond;
-extern pthread_mutex_t g_ctrl_req_lock;
-extern int dp_data_wait_ctrl_req_thr(int req, int thr_id);
-extern pthread_cond_t g_dlp_ctrl_req_cond;
+extern int dp_data_post_ctrl_cmd(io_ctrl_cmd_t *cmd, int thr_id);
+extern int dp_data_wait_ctrl_cmd(io_ctrl_cmd_t *cmd);
+extern int dp_data_wait_ctrl_cmd_thr(io_ctrl_cmd_t *cmd, int thr_id, uint64_t *result);
 extern pthread_mutex_t g_dlp_ctrl_req_lock;
-extern int dp_dlp_wait_ctrl_req_thr(int req);
+extern int dp_dlp_kick_ctrl_req(void);
 extern void dp_ctrl_release_ip_fqdn_storage(dpi_ip_fqdn_storage_entry_t *entry);
 
+// Deferred free of unpublished rcu objects, see reclaim.c. fct is called even if ptr is NULL.
+typedef void (*dp_reclaim_fct)(void *ptr);
+typedef struct dp_reclaim_stats_ {
+    uint64_t depth;         // queued and not freed yet
+    uint64_t high_water;
+    uint64_t batches;       // grace periods waited by the reclaimer
+    uint64_t freed;
+} dp_reclaim_stats_t;
+extern void dp_reclaim_defer(dp_reclaim_fct fct, void *ptr);
+extern void dp_reclaim_stats(dp_reclaim_stats_t *s);
+
 #endif
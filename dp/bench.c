@@ -0,0 +1,1233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <pcap/pcap.h>
+#include <netinet/ip.h>
+#include <netinet/ether.h>
+#include <jansson.h>
+
+#include "urcu.h"
+
+#include "utils/helper.h"
+#include "utils/rcu_map.h"
+#include "utils/flat_map.h"
+#include "apis.h"
+#include "dpi/dpi_module.h"
+
+// Compare the session map engines, lfht and the flat map, with synthetic ipv4 tuples.
+// The run is single threaded, like a dp thread using its own session maps.
+//
+// The policy benchmark times dpi_policy_lookup() of a policy handle, generated or loaded
+// from a ctrl_cfg_policy message, and reports the ns per lookup by match path. Streams and
+// rules come from fixed seeds, so the output of two dp builds can be compared line by line.
+//
+// The replay benchmark runs the packets of a pcap file through the inspection path of dp
+// threads and reports the rate and cycles per packet, see dp_bench_replay().
+
+#define BENCH_LOOKUPS   (4 * 1024 * 1024)
+
+typedef struct bench_sess_ {
+    struct cds_lfht_node node;
+    uint32_t cip, sip;
+    uint16_t cport, sport;
+    uint8_t proto;
+} bench_sess_t;
+
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint32_t bench_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return (uint32_t)(x >> 16);
+}
+
+static inline bool bench_key_match(const bench_sess_t *s, const bench_sess_t *k)
+{
+    return s->cip == k->cip && s->sip == k->sip &&
+           s->cport == k->cport && s->sport == k->sport && s->proto == k->proto;
+}
+
+static inline uint32_t bench_hash(const void *key)
+{
+    const bench_sess_t *k = key;
+    uint64_t h = (((uint64_t)k->cip << 32) | k->sip) ^
+                 ((((uint32_t)k->cport << 16) | k->sport) * 0x9e3779b97f4a7c15ULL);
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (uint32_t)h;
+}
+
+static int bench_lfht_match(struct cds_lfht_node *ht_node, const void *key)
+{
+    return bench_key_match(STRUCT_OF(ht_node, bench_sess_t, node), key);
+}
+
+static inline bool bench_flat_match(const void *data, const void *key)
+{
+    return bench_key_match(data, key);
+}
+
+static void bench_tuples(bench_sess_t *sess, int cnt, uint64_t seed)
+{
+    int i;
+
+    for (i = 0; i < cnt; i ++) {
+        sess[i].cip = bench_rand(&seed);
+        sess[i].sip = 0x0a000000 | (bench_rand(&seed) & 0xffff);
+        sess[i].cport = bench_rand(&seed);
+        sess[i].sport = 80 + (i & 7);
+        sess[i].proto = 6;
+    }
+}
+
+static double bench_ns(uint64_t start, uint64_t ops)
+{
+    return (double)(bench_now_ns() - start) / ops;
+}
+
+static void bench_lfht(bench_sess_t *sess, bench_sess_t *miss, int cnt)
+{
+    rcu_map_t m;
+    uint64_t seed = 1, start, found = 0;
+    int i;
+
+    rcu_map_init(&m, 512, offsetof(bench_sess_t, node), bench_lfht_match, bench_hash);
+    rcu_read_lock();
+
+    start = bench_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        rcu_map_add(&m, &sess[i], &sess[i]);
+    }
+    printf("  lfht: add %6.1f ns", bench_ns(start, cnt));
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_LOOKUPS; i ++) {
+        found += rcu_map_lookup(&m, &sess[bench_rand(&seed) % cnt]) != NULL;
+    }
+    printf(", hit %6.1f ns", bench_ns(start, BENCH_LOOKUPS));
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_LOOKUPS; i ++) {
+        found += rcu_map_lookup(&m, &miss[bench_rand(&seed) % cnt]) != NULL;
+    }
+    printf(", miss %6.1f ns", bench_ns(start, BENCH_LOOKUPS));
+
+    start = bench_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        rcu_map_del(&m, &sess[i]);
+    }
+    printf(", del %6.1f ns, found=%lu\n", bench_ns(start, cnt), found);
+
+    rcu_read_unlock();
+    rcu_map_destroy(&m);
+}
+
+static void bench_flat(bench_sess_t *sess, bench_sess_t *miss, int cnt)
+{
+    flat_map_t m;
+    uint64_t seed = 1, start, found = 0;
+    int i;
+
+    flat_map_init(&m, 512, bench_flat_match, bench_hash);
+
+    start = bench_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        flat_map_add(&m, &sess[i], &sess[i]);
+    }
+    printf("  flat: add %6.1f ns", bench_ns(start, cnt));
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_LOOKUPS; i ++) {
+        bench_sess_t *k = &sess[bench_rand(&seed) % cnt];
+        found += flat_map_find(&m, bench_hash(k), k, bench_flat_match) != NULL;
+    }
+    printf(", hit %6.1f ns", bench_ns(start, BENCH_LOOKUPS));
+
+    start = bench_now_ns();
+    for (i = 0; i < BENCH_LOOKUPS; i ++) {
+        bench_sess_t *k = &miss[bench_rand(&seed) % cnt];
+        found += flat_map_find(&m, bench_hash(k), k, bench_flat_match) != NULL;
+    }
+    printf(", miss %6.1f ns", bench_ns(start, BENCH_LOOKUPS));
+
+    start = bench_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        flat_map_del(&m, &sess[i]);
+    }
+    printf(", del %6.1f ns, found=%lu\n", bench_ns(start, cnt), found);
+
+    flat_map_destroy(&m);
+}
+
+int dp_bench_session_map(void)
+{
+    static const int sizes[] = {1000, 100000, 1000000};
+    int i;
+
+    rcu_register_thread();
+
+    for (i = 0; i < ARRAY_ENTRIES(sizes); i ++) {
+        int cnt = sizes[i];
+        bench_sess_t *sess = calloc(cnt, sizeof(*sess));
+        bench_sess_t *miss = calloc(cnt, sizeof(*miss));
+
+        if (sess == NULL || miss == NULL) {
+            free(sess);
+            free(miss);
+            rcu_unregister_thread();
+            return -1;
+        }
+        bench_tuples(sess, cnt, 0x5eed + i);
+        bench_tuples(miss, cnt, 0xdead + i);
+
+        printf("sessions=%d\n", cnt);
+        bench_lfht(sess, miss, cnt);
+        bench_flat(sess, miss, cnt);
+
+        free(sess);
+        free(miss);
+    }
+
+    rcu_unregister_thread();
+    return 0;
+}
+
+// ---- policy lookups ----
+
+#define BENCH_POLICY_LOOKUPS    (256 * 1024)    // per path
+#define BENCH_WL_IP             0x0a000001      // 10.0.0.1, the workload
+#define BENCH_FQDN_NET          0xc6120000      // 198.18.0.0/16, addresses of fqdn names
+#define BENCH_EXT_NET           0xc6130000      // 198.19.0.0/16, external peers
+#define BENCH_UNKNOWN_NET       0x64400000      // 100.64.0.0/16, no rule has it
+
+extern int dp_ctrl_cfg_policy(json_t *msg);
+
+enum {
+    BENCH_PATH_EXACT,
+    BENCH_PATH_RANGE,
+    BENCH_PATH_FQDN,
+    BENCH_PATH_UNKNOWN,
+    BENCH_PATH_REPLAY,
+    BENCH_PATH_MAX,
+};
+
+static const char *bench_path_names[BENCH_PATH_MAX] = {
+    [BENCH_PATH_EXACT] = "exact",
+    [BENCH_PATH_RANGE] = "range",
+    [BENCH_PATH_FQDN] = "fqdn",
+    [BENCH_PATH_UNKNOWN] = "unknown",
+    [BENCH_PATH_REPLAY] = "replay",
+};
+
+typedef struct bench_tuple_ {
+    uint32_t sip, dip;          // network order
+    uint16_t dport;
+    uint8_t proto;
+    bool ingress;
+} bench_tuple_t;
+
+// The rules a stream is drawn from, per path
+typedef struct bench_rules_ {
+    dpi_policy_rule_t *rules[BENCH_PATH_MAX];
+    int count[BENCH_PATH_MAX];
+} bench_rules_t;
+
+static struct ether_addr bench_mac = {{0x02, 0x42, 0xbe, 0x4c, 0x00, 0x01}};
+
+// A workload of our own, policies are applied by mac
+static int bench_add_ep(void)
+{
+    void *buf = calloc(1, sizeof(io_mac_t) * 3 + sizeof(io_ep_t));
+    io_mac_t *mac = buf;
+
+    if (buf == NULL) {
+        return -1;
+    }
+    mac->mac = bench_mac;
+    mac->ep = GET_EP_FROM_MAC_MAP(buf);
+    rcu_map_add(&g_ep_map, mac, &mac->mac);
+    return 0;
+}
+
+static io_ep_t *bench_ep(void)
+{
+    io_mac_t *mac = rcu_map_lookup(&g_ep_map, &bench_mac);
+    return mac != NULL ? mac->ep : NULL;
+}
+
+static void bench_del_policy(void)
+{
+    dpi_policy_t p;
+
+    memset(&p, 0, sizeof(p));
+    p.num_macs = 1;
+    p.mac_list = &bench_mac;
+    dpi_policy_cfg(CFG_DELETE, &p, MSG_START | MSG_END);
+}
+
+static uint32_t bench_fqdn_ip(int i)
+{
+    return htonl(BENCH_FQDN_NET | (i & 0xffff));
+}
+
+// Give the fqdn names addresses, as if their dns responses were snooped
+static void bench_map_fqdn(bench_rules_t *br)
+{
+    char name[MAX_FQDN_LEN];
+    int i;
+
+    for (i = 0; i < br->count[BENCH_PATH_FQDN]; i ++) {
+        dpi_policy_rule_t *r = &br->rules[BENCH_PATH_FQDN][i];
+        uint32_t ip = bench_fqdn_ip(i);
+
+        if (r->fqdn[0] == '*') {
+            snprintf(name, sizeof(name), "www%s", r->fqdn + 1);
+        } else {
+            strlcpy(name, r->fqdn, sizeof(name));
+        }
+        snooped_fqdn_ipv4_mapping(name, &ip, 1);
+    }
+}
+
+static int bench_sort_rules(dpi_policy_rule_t *rules, int cnt, bench_rules_t *br)
+{
+    int i, path;
+
+    memset(br, 0, sizeof(*br));
+    for (path = 0; path < BENCH_PATH_MAX; path ++) {
+        if ((br->rules[path] = calloc(cnt > 0 ? cnt : 1, sizeof(dpi_policy_rule_t))) == NULL) {
+            return -1;
+        }
+    }
+    for (i = 0; i < cnt; i ++) {
+        dpi_policy_rule_t *r = &rules[i];
+
+        if (r->fqdn[0] != '\0') {
+            path = BENCH_PATH_FQDN;
+        } else if (r->sip == r->sip_r && r->dip == r->dip_r && r->dport == r->dport_r) {
+            path = BENCH_PATH_EXACT;
+        } else {
+            path = BENCH_PATH_RANGE;
+        }
+        // Without the apps, the stream only needs the key
+        br->rules[path][br->count[path]] = *r;
+        br->rules[path][br->count[path]].num_apps = 0;
+        br->rules[path][br->count[path]].app_rules = NULL;
+        br->count[path] ++;
+    }
+    return 0;
+}
+
+static void bench_free_rules(bench_rules_t *br)
+{
+    int path;
+
+    for (path = 0; path < BENCH_PATH_MAX; path ++) {
+        free(br->rules[path]);
+    }
+}
+
+// Rules of a protect-mode workload: exact peers, subnets and port ranges, ingress peers and
+// fqdn names, some of them wildcards
+static dpi_policy_rule_t *bench_gen_rules(int cnt)
+{
+    dpi_policy_rule_t *rules = calloc(cnt, sizeof(*rules));
+    uint64_t seed = 0x9011c7 + cnt;
+    int i;
+
+    if (rules == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < cnt; i ++) {
+        dpi_policy_rule_t *r = &rules[i];
+        uint32_t kind = i % 20, peer = bench_rand(&seed);
+
+        r->id = i + 1;
+        r->action = DP_POLICY_ACTION_ALLOW;
+        r->proto = (i & 1) ? IPPROTO_UDP : IPPROTO_TCP;
+        r->sip = r->sip_r = htonl(BENCH_WL_IP);
+        if (kind < 12) {
+            r->dip = r->dip_r = htonl(0x0a010000 | (peer & 0xffff));
+            r->dport = r->dport_r = 1000 + (peer >> 16) % 50000;
+        } else if (kind < 16) {
+            r->dip = htonl(0x0a800000 | (peer & 0x7fff00));
+            r->dip_r = htonl(0x0a800000 | (peer & 0x7fff00) | 0xff);
+            r->dport = 8000 + (peer >> 24);
+            r->dport_r = r->dport + 100;
+        } else if (kind < 18) {
+            r->ingress = true;
+            r->sip = r->sip_r = htonl(0x0a020000 | (peer & 0xffff));
+            r->dip = r->dip_r = htonl(BENCH_WL_IP);
+            r->dport = r->dport_r = 80 + (peer >> 16) % 20;
+            r->proto = IPPROTO_TCP;
+        } else {
+            r->dip = r->dip_r = 0;
+            r->dport = r->dport_r = 443;
+            r->proto = IPPROTO_TCP;
+            if (kind == 18) {
+                snprintf(r->fqdn, MAX_FQDN_LEN, "svc%d.bench.local", i);
+            } else {
+                snprintf(r->fqdn, MAX_FQDN_LEN, "*.w%d.bench.local", i);
+            }
+        }
+    }
+    return rules;
+}
+
+static int bench_json_rules(json_t *msg, dpi_policy_rule_t **list)
+{
+    json_t *obj = json_object_get(msg, "rules");
+    int i, cnt = json_array_size(obj);
+    dpi_policy_rule_t *rules;
+
+    if ((rules = calloc(cnt > 0 ? cnt : 1, sizeof(*rules))) == NULL) {
+        return -1;
+    }
+    for (i = 0; i < cnt; i ++) {
+        json_t *ro = json_array_get(obj, i), *o;
+        dpi_policy_rule_t *r = &rules[i];
+
+        r->sip = inet_addr(json_string_value(json_object_get(ro, "sip")));
+        r->dip = inet_addr(json_string_value(json_object_get(ro, "dip")));
+        r->sip_r = (o = json_object_get(ro, "sipr")) ? inet_addr(json_string_value(o)) : r->sip;
+        r->dip_r = (o = json_object_get(ro, "dipr")) ? inet_addr(json_string_value(o)) : r->dip;
+        r->dport = json_integer_value(json_object_get(ro, "port"));
+        r->dport_r = json_integer_value(json_object_get(ro, "portr"));
+        r->proto = json_integer_value(json_object_get(ro, "proto"));
+        r->ingress = json_boolean_value(json_object_get(ro, "ingress"));
+        if ((o = json_object_get(ro, "fqdn")) != NULL) {
+            strlcpy(r->fqdn, json_string_value(o), MAX_FQDN_LEN);
+        }
+    }
+    *list = rules;
+    return cnt;
+}
+
+static uint32_t bench_pick_ip(uint32_t lo, uint32_t hi, uint64_t *seed)
+{
+    uint32_t l = ntohl(lo), h = ntohl(hi);
+
+    // A peer of 0 is any external address
+    if (l == 0 && h == 0) {
+        return htonl(BENCH_EXT_NET | (bench_rand(seed) & 0xffff));
+    }
+    if (h <= l) {
+        return lo;
+    }
+    return htonl(l + bench_rand(seed) % (h - l + 1));
+}
+
+static void bench_gen_tuples(bench_rules_t *br, int path, bench_tuple_t *t, int cnt, uint64_t seed)
+{
+    int i;
+
+    for (i = 0; i < cnt; i ++) {
+        if (path == BENCH_PATH_UNKNOWN || br->count[path] == 0) {
+            t[i].sip = htonl(BENCH_WL_IP);
+            t[i].dip = htonl(BENCH_UNKNOWN_NET | (bench_rand(&seed) & 0xffff));
+            t[i].dport = 1 + bench_rand(&seed) % 65535;
+            t[i].proto = IPPROTO_TCP;
+            t[i].ingress = false;
+            continue;
+        }
+
+        int k = bench_rand(&seed) % br->count[path];
+        dpi_policy_rule_t *r = &br->rules[path][k];
+
+        t[i].sip = bench_pick_ip(r->sip, r->sip_r, &seed);
+        t[i].dip = bench_pick_ip(r->dip, r->dip_r, &seed);
+        if (path == BENCH_PATH_FQDN) {
+            if (r->ingress) {
+                t[i].sip = bench_fqdn_ip(k);
+            } else {
+                t[i].dip = bench_fqdn_ip(k);
+            }
+        }
+        t[i].dport = r->dport + (r->dport_r > r->dport ? bench_rand(&seed) % (r->dport_r - r->dport + 1) : 0);
+        t[i].proto = r->proto ? r->proto : IPPROTO_TCP;
+        t[i].ingress = r->ingress;
+    }
+}
+
+// Lines of "sip dip dport proto [ingress]"
+static bench_tuple_t *bench_load_tuples(const char *path, int *count)
+{
+    char line[256], sip[64], dip[64];
+    bench_tuple_t *t = NULL, *n;
+    unsigned int dport, proto, ingress;
+    int cnt = 0, size = 0;
+    FILE *fp;
+
+    if ((fp = fopen(path, "r")) == NULL) {
+        printf("Unable to open %s\n", path);
+        return NULL;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        ingress = 0;
+        if (line[0] == '#' || sscanf(line, "%63s %63s %u %u %u", sip, dip, &dport, &proto, &ingress) < 4) {
+            continue;
+        }
+        if (cnt == size) {
+            size = size ? size * 2 : 4096;
+            if ((n = realloc(t, sizeof(*t) * size)) == NULL) {
+                free(t);
+                fclose(fp);
+                return NULL;
+            }
+            t = n;
+        }
+        t[cnt].sip = inet_addr(sip);
+        t[cnt].dip = inet_addr(dip);
+        t[cnt].dport = dport;
+        t[cnt].proto = proto;
+        t[cnt].ingress = ingress != 0;
+        cnt ++;
+    }
+    fclose(fp);
+    *count = cnt;
+    return t;
+}
+
+static int bench_u32_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// What timing a lookup costs by itself
+static uint32_t bench_clock_overhead(void)
+{
+    uint32_t best = UINT32_MAX;
+    int i;
+
+    for (i = 0; i < 10000; i ++) {
+        uint64_t t0 = bench_now_ns();
+        best = min(best, (uint32_t)(bench_now_ns() - t0));
+    }
+    return best;
+}
+
+static void bench_lookup_path(dpi_policy_hdl_t *hdl, io_ep_t *ep, const char *name,
+                              bench_tuple_t *t, int cnt, uint32_t overhead)
+{
+    uint8_t buf[sizeof(struct iphdr)];
+    struct iphdr *iph = (struct iphdr *)buf;
+    uint64_t hits = th_counter.policy_cache_hits, misses = th_counter.policy_cache_misses;
+    uint64_t total = 0, t0, t1;
+    uint32_t *ns = malloc(sizeof(uint32_t) * (cnt > 0 ? cnt : 1));
+    dpi_policy_desc_t desc;
+    dpi_packet_t p;
+    int i, matched = 0, unknown = 0;
+
+    if (ns == NULL || cnt == 0) {
+        free(ns);
+        return;
+    }
+
+    memset(&p, 0, sizeof(p));
+    memset(buf, 0, sizeof(buf));
+    p.pkt = buf;
+    p.l3 = 0;
+    p.eth_type = ETH_P_IP;
+    p.ep = ep;
+
+    for (i = 0; i < cnt; i ++) {
+        iph->saddr = t[i].sip;
+        iph->daddr = t[i].dip;
+        p.ip_proto = t[i].proto;
+        p.sport = 40000 + (i & 0x3fff);
+        p.dport = t[i].dport;
+        p.flags = t[i].ingress ? DPI_PKT_FLAG_INGRESS : 0;
+
+        t0 = bench_now_ns();
+        dpi_policy_lookup(&p, hdl, 0, true, false, &desc, 0);
+        t1 = bench_now_ns();
+
+        ns[i] = t1 - t0 > overhead ? t1 - t0 - overhead : 0;
+        total += ns[i];
+        matched += desc.id != 0;
+        unknown += (desc.flags & POLICY_DESC_UNKNOWN_IP) != 0;
+    }
+
+    qsort(ns, cnt, sizeof(uint32_t), bench_u32_cmp);
+    printf("  %-8s lookups=%d rule=%d default=%d unknown_ip=%d mean=%.1f p50=%u p90=%u p99=%u"
+           " p999=%u max=%u ns cache_hits=%lu cache_misses=%lu\n",
+           name, cnt, matched, cnt - matched, unknown, (double)total / cnt, ns[cnt / 2], ns[cnt * 9 / 10],
+           ns[cnt * 99 / 100], ns[cnt * 999 / 1000], ns[cnt - 1],
+           th_counter.policy_cache_hits - hits, th_counter.policy_cache_misses - misses);
+    free(ns);
+}
+
+static void bench_policy_run(const char *label, bench_rules_t *br, bench_tuple_t *replay, int replay_cnt,
+                             uint64_t build_ns)
+{
+    io_ep_t *ep = bench_ep();
+    dpi_policy_hdl_t *hdl = ep != NULL ? ep->policy_hdl : NULL;
+    bench_tuple_t *t;
+    uint32_t overhead;
+    int path;
+
+    if (hdl == NULL) {
+        printf("%s: no policy hdl\n", label);
+        return;
+    }
+
+    printf("policy %s entries=%u exact=%u range=%u build=%.2f ms\n", label, hdl->entries,
+           th_counter.type1_rules, th_counter.type2_rules, (double)build_ns / 1000000);
+
+    overhead = bench_clock_overhead();
+    if (replay != NULL) {
+        bench_lookup_path(hdl, ep, bench_path_names[BENCH_PATH_REPLAY], replay, replay_cnt, overhead);
+        return;
+    }
+
+    if ((t = calloc(BENCH_POLICY_LOOKUPS, sizeof(*t))) == NULL) {
+        return;
+    }
+    for (path = BENCH_PATH_EXACT; path <= BENCH_PATH_UNKNOWN; path ++) {
+        if (path != BENCH_PATH_UNKNOWN && br->count[path] == 0) {
+            continue;
+        }
+        bench_gen_tuples(br, path, t, BENCH_POLICY_LOOKUPS, 0xbe4c + path);
+        bench_lookup_path(hdl, ep, bench_path_names[path], t, BENCH_POLICY_LOOKUPS, overhead);
+    }
+    free(t);
+}
+
+static int bench_policy_gen(bench_tuple_t *replay, int replay_cnt)
+{
+    static const int sizes[] = {100, 10000, 100000};
+    char label[32];
+    int i;
+
+    for (i = 0; i < ARRAY_ENTRIES(sizes); i ++) {
+        dpi_policy_t p;
+        bench_rules_t br;
+        uint64_t start;
+
+        memset(&p, 0, sizeof(p));
+        p.num_macs = 1;
+        p.mac_list = &bench_mac;
+        p.def_action = DP_POLICY_ACTION_DENY;
+        p.apply_dir = DP_POLICY_APPLY_EGRESS | DP_POLICY_APPLY_INGRESS;
+        p.num_rules = sizes[i];
+        if ((p.rule_list = bench_gen_rules(sizes[i])) == NULL ||
+            bench_sort_rules(p.rule_list, p.num_rules, &br) < 0) {
+            free(p.rule_list);
+            return -1;
+        }
+
+        start = bench_now_ns();
+        dpi_policy_cfg(CFG_ADD, &p, MSG_START | MSG_END);
+        start = bench_now_ns() - start;
+        bench_map_fqdn(&br);
+
+        snprintf(label, sizeof(label), "rules=%d", sizes[i]);
+        bench_policy_run(label, &br, replay, replay_cnt, start);
+
+        bench_del_policy();
+        bench_free_rules(&br);
+        free(p.rule_list);
+    }
+    return 0;
+}
+
+static int bench_policy_json(const char *file, bench_tuple_t *replay, int replay_cnt)
+{
+    json_error_t err;
+    json_t *root, *msg, *macs;
+    dpi_policy_rule_t *rules = NULL;
+    bench_rules_t br;
+    char label[32], mac[32];
+    uint64_t start;
+    int cnt;
+
+    if ((root = json_load_file(file, 0, &err)) == NULL) {
+        printf("Invalid policy file %s: %s, line %d\n", file, err.text, err.line);
+        return -1;
+    }
+    // The ctrl message or its body
+    if ((msg = json_object_get(root, "ctrl_cfg_policy")) == NULL) {
+        msg = root;
+    }
+    if ((cnt = bench_json_rules(msg, &rules)) < 0 || bench_sort_rules(rules, cnt, &br) < 0) {
+        free(rules);
+        json_decref(root);
+        return -1;
+    }
+
+    // Applied to our workload in one message
+    macs = json_array();
+    json_array_append_new(macs, json_string(ether_ntoa_r(&bench_mac, mac)));
+    json_object_set_new(msg, "mac", macs);
+    json_object_set_new(msg, "cmd", json_integer(CFG_ADD));
+    json_object_set_new(msg, "flag", json_integer(MSG_START | MSG_END));
+
+    start = bench_now_ns();
+    dp_ctrl_cfg_policy(msg);
+    start = bench_now_ns() - start;
+    bench_map_fqdn(&br);
+
+    snprintf(label, sizeof(label), "rules=%d", cnt);
+    bench_policy_run(label, &br, replay, replay_cnt, start);
+
+    bench_del_policy();
+    bench_free_rules(&br);
+    free(rules);
+    json_decref(root);
+    return 0;
+}
+
+// 'policy' is a ctrl_cfg_policy json file, or "gen" for generated rule sets of 100, 10K and
+// 100K rules. 'replay' is an optional tuple file to look up instead of the generated streams.
+int dp_bench_policy(const char *policy, const char *replay)
+{
+    bench_tuple_t *tuples = NULL;
+    int cnt = 0, ret;
+
+    rcu_register_thread();
+
+    if (replay != NULL && (tuples = bench_load_tuples(replay, &cnt)) == NULL) {
+        rcu_unregister_thread();
+        return -1;
+    }
+    if (bench_add_ep() < 0) {
+        free(tuples);
+        rcu_unregister_thread();
+        return -1;
+    }
+
+    rcu_read_lock();
+    if (strcmp(policy, "gen") == 0) {
+        ret = bench_policy_gen(tuples, cnt);
+    } else {
+        ret = bench_policy_json(policy, tuples, cnt);
+    }
+    rcu_read_unlock();
+
+    free(tuples);
+    rcu_unregister_thread();
+    return ret;
+}
+
+// ---- pcap replay ----
+
+// Each thread inspects its own copy of the packets of a pcap file with dpi_recv_batch(),
+// as a dp thread does an rx block, and keeps its own sessions. The fixture is a json object
+// with the ctrl messages to apply first, as the agent sends them, in "msgs", and the mac of
+// the port pair's endpoint in "ep_mac". Without one, packets go to the dummy endpoint.
+// Packets keep the time gaps of the file, each loop starts a second after the last one, so
+// later loops find the sessions of the earlier ones.
+
+#define BENCH_REPLAY_BATCH  32
+
+extern int dp_ctrl_apply_json(char *buf, int size);
+
+typedef struct bench_replay_ {
+    uint8_t *data;
+    size_t size;
+    io_pkt_t *pkts;             // pkt is the offset in data
+    uint32_t *secs;             // from the first packet
+    int count;
+    uint64_t bytes;
+    uint32_t duration;
+    io_ctx_t ctx;
+} bench_replay_t;
+
+typedef struct bench_replay_thr_ {
+    pthread_t thr;
+    int thr_id;
+    int loops;
+    const bench_replay_t *replay;
+    pthread_barrier_t *barrier;
+    uint64_t ns, ticks;
+    io_counter_t counter;
+    uint32_t map4, slots4, resizes4, map6;
+} bench_replay_thr_t;
+
+static int bench_load_pcap(const char *path, bench_replay_t *r)
+{
+    char err[PCAP_ERRBUF_SIZE];
+    struct pcap_pkthdr *hdr;
+    const u_char *pkt;
+    pcap_t *pcap;
+    time_t first = 0;
+    size_t room = 0;
+    int cap = 0;
+
+    if ((pcap = pcap_open_offline(path, err)) == NULL) {
+        printf("Cannot open pcap file %s: %s\n", path, err);
+        return -1;
+    }
+
+    while (pcap_next_ex(pcap, &hdr, &pkt) == 1) {
+        if (r->count == cap) {
+            cap = max(cap * 2, 1024);
+            r->pkts = realloc(r->pkts, sizeof(io_pkt_t) * cap);
+            r->secs = realloc(r->secs, sizeof(uint32_t) * cap);
+        }
+        if (r->size + hdr->caplen > room) {
+            room = max(room * 2, r->size + hdr->caplen + 65536);
+            r->data = realloc(r->data, room);
+        }
+        if (r->pkts == NULL || r->secs == NULL || r->data == NULL) {
+            pcap_close(pcap);
+            return -1;
+        }
+
+        if (r->count == 0) {
+            first = hdr->ts.tv_sec;
+        }
+        memcpy(r->data + r->size, pkt, hdr->caplen);
+        r->pkts[r->count].pkt = (uint8_t *)r->size;
+        r->pkts[r->count].len = hdr->caplen;
+        r->pkts[r->count].large_frame = hdr->caplen > 1518;
+        r->pkts[r->count].rx_ns = 0;
+        r->secs[r->count] = hdr->ts.tv_sec > first ? hdr->ts.tv_sec - first : 0;
+        r->duration = max(r->duration, r->secs[r->count]);
+        r->size += hdr->caplen;
+        r->bytes += hdr->caplen;
+        r->count ++;
+    }
+
+    pcap_close(pcap);
+
+    if (r->count == 0) {
+        printf("No packet in %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int bench_load_fixture(const char *path, bench_replay_t *r)
+{
+    json_error_t err;
+    json_t *root, *msgs, *msg;
+    const char *mac;
+    size_t i;
+
+    if ((root = json_load_file(path, 0, &err)) == NULL) {
+        printf("Invalid fixture %s: %s, line %d\n", path, err.text, err.line);
+        return -1;
+    }
+
+    if ((mac = json_string_value(json_object_get(root, "ep_mac"))) != NULL) {
+        if (ether_aton_r(mac, &r->ctx.ep_mac) == NULL) {
+            printf("Invalid ep_mac %s\n", mac);
+            json_decref(root);
+            return -1;
+        }
+        r->ctx.tc = false;
+    }
+
+    msgs = json_object_get(root, "msgs");
+    json_array_foreach(msgs, i, msg) {
+        char *buf = json_dumps(msg, JSON_COMPACT);
+
+        if (buf == NULL || dp_ctrl_apply_json(buf, strlen(buf)) < 0) {
+            printf("Failed to apply message %zu of %s\n", i, path);
+        }
+        free(buf);
+    }
+
+    json_decref(root);
+    return 0;
+}
+
+static void *bench_replay_thr(void *arg)
+{
+    bench_replay_thr_t *t = arg;
+    const bench_replay_t *r = t->replay;
+    io_pkt_t *pkts = malloc(sizeof(io_pkt_t) * r->count);
+    uint8_t *data = malloc(r->size);
+    io_ctx_t ctx = r->ctx;
+    uint32_t base = time(NULL), tick = 0;
+    uint64_t start, tsc;
+    int loop, i, n;
+
+    THREAD_ID = t->thr_id;
+    snprintf(THREAD_NAME, MAX_THREAD_NAME_LEN, "bench%d", t->thr_id);
+
+    rcu_register_thread();
+    dpi_init(DPI_INIT);
+
+    if (pkts == NULL || data == NULL) {
+        t->loops = 0;
+    } else {
+        memcpy(data, r->data, r->size);
+        for (i = 0; i < r->count; i ++) {
+            pkts[i] = r->pkts[i];
+            pkts[i].pkt = data + (size_t)r->pkts[i].pkt;
+        }
+    }
+
+    pthread_barrier_wait(t->barrier);
+
+    start = bench_now_ns();
+    tsc = tsc_read();
+    for (loop = 0; loop < t->loops; loop ++) {
+        for (i = 0; i < r->count; i += n) {
+            uint32_t now = base + r->secs[i];
+
+            for (n = 1; n < BENCH_REPLAY_BATCH && i + n < r->count && r->secs[i + n] == r->secs[i]; n ++);
+            if (now != tick) {
+                tick = now;
+                dpi_timeout(tick);
+            }
+            ctx.tick = tick;
+            dpi_recv_batch(&ctx, &pkts[i], n, NULL);
+        }
+        base += r->duration + 1;
+    }
+    t->ticks = tsc_read() - tsc;
+    t->ns = bench_now_ns() - start;
+
+    t->counter = th_counter;
+    t->map4 = flat_map_count(&th_session4_map);
+    t->slots4 = flat_map_slots(&th_session4_map);
+    t->resizes4 = th_session4_map.resizes;
+    t->map6 = flat_map_count(&th_session6_map);
+
+    rcu_unregister_thread();
+    free(pkts);
+    free(data);
+    return NULL;
+}
+
+// Session counters the report shows
+static void bench_replay_sum(io_counter_t *sum, const io_counter_t *c)
+{
+    int i;
+
+    sum->tcp_sess += c->tcp_sess;
+    sum->udp_sess += c->udp_sess;
+    sum->icmp_sess += c->icmp_sess;
+    sum->ip_sess += c->ip_sess;
+    sum->cur_sess += c->cur_sess;
+    for (i = 0; i < DP_SESS_EVICT_MAX; i ++) {
+        sum->sess_evicts[i] += c->sess_evicts[i];
+    }
+    sum->sess_limit_drops += c->sess_limit_drops;
+}
+
+static void bench_replay_report(const char *label, uint64_t pkts, uint64_t bytes, uint64_t ns,
+                                uint64_t ticks, const io_counter_t *c, const bench_replay_thr_t *t)
+{
+    uint64_t evicts = 0;
+    int i;
+
+    for (i = 0; i < DP_SESS_EVICT_MAX; i ++) {
+        evicts += c->sess_evicts[i];
+    }
+    printf("%-7s packets=%lu %.3f Mpps %.3f Gbps %.0f cycles/pkt sessions=%lu tcp=%lu udp=%lu cur=%u"
+           " evicts=%lu limit_drops=%lu",
+           label, pkts, ns > 0 ? (double)pkts * 1000 / ns : 0, ns > 0 ? (double)bytes * 8 / ns : 0,
+           pkts > 0 ? (double)ticks / pkts : 0, c->tcp_sess + c->udp_sess + c->icmp_sess + c->ip_sess,
+           c->tcp_sess, c->udp_sess, c->cur_sess, evicts, c->sess_limit_drops);
+    if (t != NULL) {
+        printf(" map4=%u/%u resizes=%u map6=%u", t->map4, t->slots4, t->resizes4, t->map6);
+    }
+    printf("\n");
+}
+
+// Replay of the first thread again, with every ICMP echo payload compared, to show the sampled
+// tunneling check finds the same tunnels. 'thr_id' is a thread not used by the replay.
+static void bench_replay_icmp(const bench_replay_t *r, const bench_replay_thr_t *sampled, int thr_id)
+{
+    bench_replay_thr_t t;
+    pthread_barrier_t barrier;
+    const io_counter_t *c = &sampled->counter;
+
+    memset(&t, 0, sizeof(t));
+    t.thr_id = thr_id;
+    t.loops = sampled->loops;
+    t.replay = r;
+    t.barrier = &barrier;
+
+    g_icmp_sample = 0;
+    pthread_barrier_init(&barrier, NULL, 1);
+    pthread_create(&t.thr, NULL, bench_replay_thr, &t);
+    pthread_join(t.thr, NULL);
+    pthread_barrier_destroy(&barrier);
+    g_icmp_sample = 1;
+
+    printf("icmp    sampled checks=%lu skips=%lu tunnels=%lu, unsampled checks=%lu tunnels=%lu %s\n",
+           c->icmp_checks, c->icmp_skips, c->icmp_tunnels, t.counter.icmp_checks, t.counter.icmp_tunnels,
+           c->icmp_tunnels == t.counter.icmp_tunnels ? "same" : "DIFFERENT");
+}
+
+// Replay 'pcap' 'loops' times in each of 'threads' threads, after the ctrl messages of the
+// optional 'fixture' file.
+int dp_bench_replay(const char *pcap, const char *fixture, int threads, int loops)
+{
+    bench_replay_t r;
+    bench_replay_thr_t *thrs;
+    pthread_barrier_t barrier;
+    io_counter_t sum;
+    uint64_t pkts = 0, ns = 0, ticks = 0;
+    int i, ret = -1;
+
+    memset(&r, 0, sizeof(r));
+    r.ctx.tc = true;
+    threads = min(max(threads, 1), MAX_DP_THREADS);
+    loops = max(loops, 1);
+
+    rcu_register_thread();
+
+    if (bench_load_pcap(pcap, &r) < 0 || (fixture != NULL && bench_load_fixture(fixture, &r) < 0)) {
+        goto out;
+    }
+    printf("replay %s packets=%d bytes=%lu duration=%us threads=%d loops=%d\n",
+           pcap, r.count, r.bytes, r.duration, threads, loops);
+
+    if ((thrs = calloc(threads, sizeof(*thrs))) == NULL) {
+        goto out;
+    }
+    pthread_barrier_init(&barrier, NULL, threads);
+    for (i = 0; i < threads; i ++) {
+        thrs[i].thr_id = i;
+        thrs[i].loops = loops;
+        thrs[i].replay = &r;
+        thrs[i].barrier = &barrier;
+        pthread_create(&thrs[i].thr, NULL, bench_replay_thr, &thrs[i]);
+    }
+
+    memset(&sum, 0, sizeof(sum));
+    for (i = 0; i < threads; i ++) {
+        bench_replay_thr_t *t = &thrs[i];
+        char label[16];
+
+        pthread_join(t->thr, NULL);
+        snprintf(label, sizeof(label), "thread%d", i);
+        bench_replay_report(label, (uint64_t)r.count * t->loops, r.bytes * t->loops, t->ns, t->ticks,
+                            &t->counter, t);
+
+        pkts += (uint64_t)r.count * t->loops;
+        ns = max(ns, t->ns);
+        ticks += t->ticks;
+        bench_replay_sum(&sum, &t->counter);
+    }
+    // Rate of all threads over the longest run, cycles of a packet on its thread
+    bench_replay_report("total", pkts, pkts / r.count * r.bytes, ns, ticks, &sum, NULL);
+
+    if (thrs[0].counter.icmp_checks + thrs[0].counter.icmp_skips > 0 && threads < MAX_DP_THREADS) {
+        bench_replay_icmp(&r, &thrs[0], threads);
+    }
+
+    pthread_barrier_destroy(&barrier);
+    free(thrs);
+    ret = 0;
+
+out:
+    free(r.data);
+    free(r.pkts);
+    free(r.secs);
+    rcu_unregister_thread();
+    return ret;
+}
+
+// ---- sql injection ----
+
+// Times the sql injection check of a query corpus, with every signature run on every query as
+// before the prefilter, and with the prefilter, and verifies both give the same matches.
+
+#define BENCH_SQLI_QUERIES  (64 * 1024)
+#define BENCH_SQLI_LOOPS    8
+
+extern void sql_injection_init(void);
+extern int sql_injection_match(dpi_packet_t *p, uint8_t *query, int len, bool prefilter);
+
+typedef struct bench_query_ {
+    char *text;
+    int len;
+} bench_query_t;
+
+static const char *bench_sqli_attacks[] = {
+    "SELECT * FROM users WHERE name='adam' or 'x' = 'x'",
+    "SELECT * FROM users WHERE id=1 or sleep(5)",
+    "SELECT benchmark(50000000, md5('a'))",
+    "SELECT * FROM t WHERE id=1 and benchmark(100, md5(1)) --",
+    "SELECT 1; waitfor delay '0:0:5'--",
+    "SELECT name FROM t WHERE id=1 union select @@version --",
+    "SELECT 1; exec master..xp_cmdshell 'dir' --",
+    "SELECT * FROM t WHERE id=-1 or 1 order by id desc --",
+};
+
+static const char *bench_sqli_tables[] = {"users", "orders", "order_items", "inventory", "sessions", "audit_log"};
+static const char *bench_sqli_columns[] = {"id", "name", "email", "created_at", "status", "amount", "owner_id"};
+
+// Mostly clean queries of the usual shapes, one in 64 is an attack
+static bench_query_t *bench_gen_queries(int cnt)
+{
+    bench_query_t *q = calloc(cnt, sizeof(*q));
+    uint64_t seed = 0x5a11;
+    char buf[512];
+    int i;
+
+    if (q == NULL) return NULL;
+
+    for (i = 0; i < cnt; i ++) {
+        const char *tbl = bench_sqli_tables[bench_rand(&seed) % ARRAY_ENTRIES(bench_sqli_tables)];
+        const char *col = bench_sqli_columns[bench_rand(&seed) % ARRAY_ENTRIES(bench_sqli_columns)];
+        const char *col2 = bench_sqli_columns[bench_rand(&seed) % ARRAY_ENTRIES(bench_sqli_columns)];
+        uint32_t v = bench_rand(&seed);
+
+        if (i % 64 == 63) {
+            snprintf(buf, sizeof(buf), "%s", bench_sqli_attacks[(i / 64) % ARRAY_ENTRIES(bench_sqli_attacks)]);
+            q[i].text = strdup(buf);
+        } else {
+            switch (v % 6) {
+            case 0:
+                snprintf(buf, sizeof(buf), "SELECT %s, %s FROM %s WHERE %s = %u ORDER BY %s LIMIT 100",
+                         col, col2, tbl, col, v % 100000, col2);
+                break;
+            case 1:
+                snprintf(buf, sizeof(buf), "SELECT * FROM %s WHERE %s = 'user%u' AND status = 'active'",
+                         tbl, col, v % 1000);
+                break;
+            case 2:
+                snprintf(buf, sizeof(buf), "INSERT INTO %s (%s, %s, created_at) VALUES (%u, 'value %u', now())",
+                         tbl, col, col2, v, v % 977);
+                break;
+            case 3:
+                snprintf(buf, sizeof(buf), "UPDATE %s SET %s = %s + 1, updated_at = now() WHERE id = %u",
+                         tbl, col, col, v % 100000);
+                break;
+            case 4:
+                snprintf(buf, sizeof(buf), "SELECT count(*) FROM %s o JOIN %s i ON i.%s = o.id WHERE o.%s > %u",
+                         tbl, bench_sqli_tables[v % ARRAY_ENTRIES(bench_sqli_tables)], col, col2, v % 5000);
+                break;
+            default:
+                snprintf(buf, sizeof(buf), "BEGIN");
+                break;
+            }
+            q[i].text = strdup(buf);
+        }
+        if (q[i].text == NULL) {
+            break;
+        }
+        q[i].len = strlen(q[i].text);
+    }
+    return q;
+}
+
+// One query per line
+static bench_query_t *bench_load_queries(const char *path, int *count)
+{
+    bench_query_t *q = NULL, *n;
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+    int cnt = 0, size = 0;
+    FILE *fp;
+
+    if ((fp = fopen(path, "r")) == NULL) {
+        printf("Unable to open %s\n", path);
+        return NULL;
+    }
+    while ((len = getline(&line, &cap, fp)) > 0) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[-- len] = '\0';
+        }
+        if (len == 0) {
+            continue;
+        }
+        if (cnt == size) {
+            size = size ? size * 2 : 4096;
+            if ((n = realloc(q, sizeof(*q) * size)) == NULL) {
+                break;
+            }
+            q = n;
+        }
+        if ((q[cnt].text = strdup(line)) == NULL) {
+            break;
+        }
+        q[cnt].len = len;
+        cnt ++;
+    }
+    free(line);
+    fclose(fp);
+    *count = cnt;
+    return q;
+}
+
+static void bench_sqli_run(const char *label, bench_query_t *q, int cnt, bool prefilter, int *matches)
+{
+    uint64_t start, found = 0;
+    int i, l;
+
+    start = bench_now_ns();
+    for (l = 0; l < BENCH_SQLI_LOOPS; l ++) {
+        for (i = 0; i < cnt; i ++) {
+            int m = sql_injection_match(NULL, (uint8_t *)q[i].text, q[i].len, prefilter);
+
+            if (l == 0) {
+                matches[i] = m;
+            }
+            found += m > 0;
+        }
+    }
+    printf("  %-10s %8.1f ns per query, %lu matched\n",
+           label, bench_ns(start, (uint64_t)cnt * BENCH_SQLI_LOOPS), found / BENCH_SQLI_LOOPS);
+}
+
+// 'corpus' is a file of queries, one per line, or "gen" for a generated corpus
+int dp_bench_sqli(const char *corpus)
+{
+    bench_query_t *q;
+    int *full, *fast;
+    int cnt = BENCH_SQLI_QUERIES, i, diff = 0;
+
+    sql_injection_init();
+
+    if (strcmp(corpus, "gen") == 0) {
+        q = bench_gen_queries(cnt);
+    } else {
+        q = bench_load_queries(corpus, &cnt);
+    }
+    if (q == NULL) {
+        return -1;
+    }
+    full = calloc(cnt, sizeof(*full));
+    fast = calloc(cnt, sizeof(*fast));
+    if (full == NULL || fast == NULL) {
+        printf("Failed to allocate the benchmark data\n");
+        cnt = 0;
+    }
+
+    printf("sqli: queries=%d\n", cnt);
+    if (cnt > 0) {
+        bench_sqli_run("all", q, cnt, false, full);
+        bench_sqli_run("prefilter", q, cnt, true, fast);
+    }
+    for (i = 0; i < cnt; i ++) {
+        if (full[i] != fast[i]) {
+            printf("  mismatch: %s\n", q[i].text);
+            diff ++;
+        }
+    }
+
+    for (i = 0; i < cnt; i ++) {
+        free(q[i].text);
+    }
+    free(q);
+    free(full);
+    free(fast);
+    return diff == 0 ? 0 : -1;
+}
@@ -0,0 +1,498 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "urcu.h"
+
+#include "utils/helper.h"
+#include "utils/rcu_map.h"
+#include "utils/timer_wheel.h"
+#include "utils/timer_queue.h"
+#include "utils/asm.h"
+#include "utils/bitmap.h"
+
+// Microbenchmarks of the dp/utils data structures, at the sizes the dp threads run them.
+// Each result is a json object on its own line,
+//
+//   {"bench":"timer_wheel","op":"refresh","size":1000000,"ops":1000000,"ns_per_op":21.4}
+//
+// so the output of two builds can be diffed or loaded by a regression tracker. Keys, timeouts
+// and orders come from fixed seeds.
+
+#define BENCH_UTILS_MAP_LOOKUPS     (4 * 1024 * 1024)
+#define BENCH_UTILS_TIMERS          (1024 * 1024)
+#define BENCH_UTILS_TIMER_SPAN_MS   (600 * 1000)    // timeouts of up to 10 minutes
+#define BENCH_UTILS_ASM_CLIP        1460
+#define BENCH_UTILS_ASM_CLIPS       (256 * 1024)    // per pattern and size
+#define BENCH_UTILS_BITMAP_BITS     (64 * 1024)
+#define BENCH_UTILS_BITMAP_OPS      (16 * 1024 * 1024)
+
+static inline uint64_t ut_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint32_t ut_rand(uint64_t *state)
+{
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return (uint32_t)(x >> 16);
+}
+
+static void ut_shuffle(uint32_t *order, uint32_t cnt, uint64_t seed)
+{
+    uint32_t i;
+
+    for (i = 0; i < cnt; i ++) {
+        order[i] = i;
+    }
+    for (i = cnt - 1; i > 0; i --) {
+        uint32_t j = ut_rand(&seed) % (i + 1), t = order[i];
+
+        order[i] = order[j];
+        order[j] = t;
+    }
+}
+
+static void ut_result(const char *bench, const char *op, uint32_t size, uint64_t ops, uint64_t ns)
+{
+    printf("{\"bench\":\"%s\",\"op\":\"%s\",\"size\":%u,\"ops\":%lu,\"ns_per_op\":%.1f}\n",
+           bench, op, size, ops, ops > 0 ? (double)ns / ops : 0);
+    fflush(stdout);
+}
+
+// ---- rcu_map ----
+
+typedef struct ut_map_node_ {
+    struct cds_lfht_node node;
+    uint64_t key;
+} ut_map_node_t;
+
+static int ut_map_match(struct cds_lfht_node *ht_node, const void *key)
+{
+    return STRUCT_OF(ht_node, ut_map_node_t, node)->key == *(const uint64_t *)key;
+}
+
+static uint32_t ut_map_hash(const void *key)
+{
+    uint64_t h = *(const uint64_t *)key;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (uint32_t)h;
+}
+
+// The map grows from its initial buckets, as the session and policy maps do
+static int ut_rcu_map(uint32_t cnt)
+{
+    ut_map_node_t *nodes = calloc(cnt, sizeof(*nodes));
+    uint32_t *order = calloc(cnt, sizeof(*order));
+    uint64_t seed = 0x5eed + cnt, start, found = 0, key;
+    rcu_map_t m;
+    uint32_t i;
+
+    if (nodes == NULL || order == NULL || rcu_map_init(&m, 64, offsetof(ut_map_node_t, node),
+                                                       ut_map_match, ut_map_hash) == NULL) {
+        free(nodes);
+        free(order);
+        return -1;
+    }
+    for (i = 0; i < cnt; i ++) {
+        nodes[i].key = ((uint64_t)ut_rand(&seed) << 32) | i;
+    }
+    ut_shuffle(order, cnt, seed);
+
+    rcu_read_lock();
+
+    start = ut_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        rcu_map_add(&m, &nodes[i], &nodes[i].key);
+    }
+    ut_result("rcu_map", "insert", cnt, cnt, ut_now_ns() - start);
+
+    start = ut_now_ns();
+    for (i = 0; i < BENCH_UTILS_MAP_LOOKUPS; i ++) {
+        found += rcu_map_lookup(&m, &nodes[order[i % cnt]].key) != NULL;
+    }
+    ut_result("rcu_map", "lookup_hit", cnt, BENCH_UTILS_MAP_LOOKUPS, ut_now_ns() - start);
+
+    // The low half of a key is its index, these are all missing
+    start = ut_now_ns();
+    for (i = 0; i < BENCH_UTILS_MAP_LOOKUPS; i ++) {
+        key = nodes[order[i % cnt]].key + cnt;
+        found += rcu_map_lookup(&m, &key) != NULL;
+    }
+    ut_result("rcu_map", "lookup_miss", cnt, BENCH_UTILS_MAP_LOOKUPS, ut_now_ns() - start);
+
+    start = ut_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        rcu_map_del(&m, &nodes[order[i]]);
+    }
+    ut_result("rcu_map", "delete", cnt, cnt, ut_now_ns() - start);
+
+    rcu_read_unlock();
+
+    if (found != BENCH_UTILS_MAP_LOOKUPS) {
+        printf("rcu_map: %lu lookups found, expected %u\n", found, BENCH_UTILS_MAP_LOOKUPS);
+    }
+
+    synchronize_rcu();
+    rcu_map_destroy(&m);
+    free(nodes);
+    free(order);
+    return 0;
+}
+
+// ---- timer_wheel and timer_queue ----
+
+static uint32_t ut_expired;
+
+static void ut_timer_expire(timer_entry_t *n)
+{
+    ut_expired ++;
+}
+
+static void ut_queue_remove(timer_node_t *n)
+{
+    ut_expired ++;
+}
+
+// Insert, refresh half a span later, roll the wheel millisecond by millisecond until it is
+// empty, then insert and remove, like sessions closed before they expire
+static int ut_timer_wheel(uint32_t cnt)
+{
+    timer_entry_t *entries = calloc(cnt, sizeof(*entries));
+    uint32_t *timeouts = calloc(cnt, sizeof(*timeouts));
+    uint32_t *order = calloc(cnt, sizeof(*order));
+    uint64_t seed = 0x71e4 + cnt, start, ns, rolls = 0;
+    uint32_t i, now = 1000;
+    timer_wheel_t w;
+
+    if (entries == NULL || timeouts == NULL || order == NULL) {
+        free(entries);
+        free(timeouts);
+        free(order);
+        return -1;
+    }
+    for (i = 0; i < cnt; i ++) {
+        timeouts[i] = 1 + ut_rand(&seed) % BENCH_UTILS_TIMER_SPAN_MS;
+    }
+    ut_shuffle(order, cnt, seed);
+
+    timer_wheel_init(&w);
+    timer_wheel_start(&w, now);
+
+    start = ut_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        timer_wheel_entry_init(&entries[i]);
+        timer_wheel_entry_start_ms(&w, &entries[i], ut_timer_expire, timeouts[i], now);
+    }
+    ut_result("timer_wheel", "insert", cnt, cnt, ut_now_ns() - start);
+
+    // Entries due by then are refreshed too, the wheel was not rolled
+    now += BENCH_UTILS_TIMER_SPAN_MS / 2;
+    start = ut_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        timer_wheel_entry_refresh_ms(&w, &entries[order[i]], now);
+    }
+    ut_result("timer_wheel", "refresh", cnt, cnt, ut_now_ns() - start);
+
+    ut_expired = 0;
+    start = ut_now_ns();
+    while (timer_wheel_count(&w) > 0) {
+        timer_wheel_roll(&w, now ++, UINT32_MAX);
+        rolls ++;
+    }
+    ns = ut_now_ns() - start;
+    ut_result("timer_wheel", "roll_expire", cnt, ut_expired, ns);
+    ut_result("timer_wheel", "roll_tick", cnt, rolls, ns);
+
+    start = ut_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        timer_wheel_entry_start_ms(&w, &entries[i], ut_timer_expire, timeouts[i], now);
+    }
+    for (i = 0; i < cnt; i ++) {
+        timer_wheel_entry_remove(&w, &entries[order[i]]);
+    }
+    ut_result("timer_wheel", "insert_remove", cnt, cnt, ut_now_ns() - start);
+
+    free(entries);
+    free(timeouts);
+    free(order);
+    return 0;
+}
+
+// A queue of one timeout, touched in a random order, then trimmed once all expired
+static int ut_timer_queue(uint32_t cnt)
+{
+    timer_node_t *nodes = calloc(cnt, sizeof(*nodes));
+    uint32_t *order = calloc(cnt, sizeof(*order));
+    uint32_t i, now = 1000, timeout = 300;
+    uint64_t start;
+    timer_queue_t q;
+
+    if (nodes == NULL || order == NULL) {
+        free(nodes);
+        free(order);
+        return -1;
+    }
+    ut_shuffle(order, cnt, 0x9e0e + cnt);
+
+    timer_queue_init(&q, timeout);
+
+    start = ut_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        timer_queue_append(&q, &nodes[i], now);
+    }
+    ut_result("timer_queue", "append", cnt, cnt, ut_now_ns() - start);
+
+    start = ut_now_ns();
+    for (i = 0; i < cnt; i ++) {
+        timer_queue_touch(&q, &nodes[order[i]], now + 1 + i * (timeout - 1) / cnt);
+    }
+    ut_result("timer_queue", "touch", cnt, cnt, ut_now_ns() - start);
+
+    ut_expired = 0;
+    start = ut_now_ns();
+    timer_queue_trim(&q, now + 2 * timeout, ut_queue_remove);
+    ut_result("timer_queue", "trim", cnt, ut_expired, ut_now_ns() - start);
+
+    free(nodes);
+    free(order);
+    return 0;
+}
+
+// ---- asm ----
+
+enum {
+    UT_ASM_INORDER = 0,
+    UT_ASM_REVERSE,
+    UT_ASM_SWAP,        // every other pair of clips swapped, light reordering
+    UT_ASM_LATE,        // the first clip comes last, as a retransmitted lost segment
+    UT_ASM_SHUFFLE,
+    UT_ASM_PATTERN_MAX,
+};
+
+static const char *ut_asm_patterns[UT_ASM_PATTERN_MAX] = {
+    [UT_ASM_INORDER] = "inorder",
+    [UT_ASM_REVERSE] = "reverse",
+    [UT_ASM_SWAP]    = "swap",
+    [UT_ASM_LATE]    = "late",
+    [UT_ASM_SHUFFLE] = "shuffle",
+};
+
+static void ut_asm_order(int pattern, uint32_t *order, uint32_t cnt, uint64_t seed)
+{
+    uint32_t i;
+
+    for (i = 0; i < cnt; i ++) {
+        switch (pattern) {
+        case UT_ASM_REVERSE:
+            order[i] = cnt - 1 - i;
+            break;
+        case UT_ASM_SWAP:
+            order[i] = (i & 2) && (i ^ 1) < cnt ? i ^ 1 : i;
+            break;
+        case UT_ASM_LATE:
+            order[i] = (i + 1) % cnt;
+            break;
+        default:
+            order[i] = i;
+            break;
+        }
+    }
+    if (pattern == UT_ASM_SHUFFLE) {
+        ut_shuffle(order, cnt, seed);
+    }
+}
+
+static void ut_asm_remove(clip_t *clip)
+{
+}
+
+// A stream of 'cnt' clips inserted in 'pattern' order and constructed in one buffer, as
+// the reassembly of a packet gap that got filled, then flushed as the stream moves on. Up to
+// ASM_INLINE_CLIPS clips stay in the inline array, more go to the tree.
+static int ut_asm(int pattern, uint32_t cnt)
+{
+    uint32_t rounds = BENCH_UTILS_ASM_CLIPS / cnt, i, r, isn = 0xfffff000;
+    uint8_t *payload = malloc(BENCH_UTILS_ASM_CLIP);
+    uint8_t *buf = malloc(cnt * BENCH_UTILS_ASM_CLIP);
+    clip_t *clips = calloc(cnt, sizeof(*clips));
+    uint32_t *order = calloc(cnt, sizeof(*order));
+    uint64_t insert_ns = 0, construct_ns = 0, flush_ns = 0, start;
+    uint32_t built = 0;
+    char op[64];
+    asm_t a;
+
+    if (payload == NULL || buf == NULL || clips == NULL || order == NULL) {
+        free(payload);
+        free(buf);
+        free(clips);
+        free(order);
+        return -1;
+    }
+    memset(payload, 'a', BENCH_UTILS_ASM_CLIP);
+    ut_asm_order(pattern, order, cnt, 0xa5a5 + cnt);
+
+    // The sequence numbers wrap in the middle of the stream
+    for (i = 0; i < cnt; i ++) {
+        clips[i].ptr = payload;
+        clips[i].seq = isn + i * BENCH_UTILS_ASM_CLIP;
+        clips[i].len = BENCH_UTILS_ASM_CLIP;
+    }
+
+    for (r = 0; r < rounds; r ++) {
+        clip_t target;
+
+        asm_init(&a);
+
+        start = ut_now_ns();
+        for (i = 0; i < cnt; i ++) {
+            asm_insert(&a, &clips[order[i]]);
+        }
+        insert_ns += ut_now_ns() - start;
+
+        target.ptr = buf;
+        target.seq = isn;
+        target.len = cnt * BENCH_UTILS_ASM_CLIP;
+
+        start = ut_now_ns();
+        if (asm_construct(&a, &target, isn) == ASM_OK && target.len == cnt * BENCH_UTILS_ASM_CLIP) {
+            built ++;
+        }
+        construct_ns += ut_now_ns() - start;
+
+        start = ut_now_ns();
+        asm_flush(&a, isn + cnt * BENCH_UTILS_ASM_CLIP, ut_asm_remove);
+        flush_ns += ut_now_ns() - start;
+
+        if (asm_count(&a) != 0) {
+            printf("asm: %u clips left after flush\n", asm_count(&a));
+        }
+        asm_destroy(&a, ut_asm_remove);
+    }
+
+    // One clip has nothing to construct
+    if (cnt > 1 && built != rounds) {
+        printf("asm: %u of %u streams constructed\n", built, rounds);
+    }
+
+    snprintf(op, sizeof(op), "insert_%s", ut_asm_patterns[pattern]);
+    ut_result("asm", op, cnt, (uint64_t)rounds * cnt, insert_ns);
+    snprintf(op, sizeof(op), "construct_%s", ut_asm_patterns[pattern]);
+    ut_result("asm", op, cnt, rounds, construct_ns);
+    snprintf(op, sizeof(op), "flush_%s", ut_asm_patterns[pattern]);
+    ut_result("asm", op, cnt, (uint64_t)rounds * cnt, flush_ns);
+
+    free(payload);
+    free(buf);
+    free(clips);
+    free(order);
+    return 0;
+}
+
+// ---- bitmap ----
+
+// Random set, test and clear, then the search for a free bit in a map that is 7/8 full,
+// the way ids are handed out
+static int ut_bitmap(int bits)
+{
+    bitmap *b = bitmap_allocate(bits);
+    uint64_t seed = 0xb17 + bits, start, set = 0;
+    int i, n = 0;
+
+    if (b == NULL) {
+        return -1;
+    }
+
+    start = ut_now_ns();
+    for (i = 0; i < BENCH_UTILS_BITMAP_OPS; i ++) {
+        bitmap_set(b, ut_rand(&seed) % bits);
+    }
+    ut_result("bitmap", "set", bits, BENCH_UTILS_BITMAP_OPS, ut_now_ns() - start);
+
+    start = ut_now_ns();
+    for (i = 0; i < BENCH_UTILS_BITMAP_OPS; i ++) {
+        set += bitmap_is_set(b, ut_rand(&seed) % bits);
+    }
+    ut_result("bitmap", "is_set", bits, BENCH_UTILS_BITMAP_OPS, ut_now_ns() - start);
+
+    start = ut_now_ns();
+    for (i = 0; i < BENCH_UTILS_BITMAP_OPS; i ++) {
+        bitmap_clear(b, ut_rand(&seed) % bits);
+    }
+    ut_result("bitmap", "clear", bits, BENCH_UTILS_BITMAP_OPS, ut_now_ns() - start);
+
+    for (i = 0; i < bits; i ++) {
+        if (ut_rand(&seed) % 8 != 0) {
+            bitmap_set(b, i);
+        } else {
+            bitmap_clear(b, i);
+        }
+    }
+
+    // Each free bit found is taken and an earlier one given back, the fill stays the same
+    start = ut_now_ns();
+    for (i = 0; i < BENCH_UTILS_BITMAP_OPS / 16; i ++) {
+        n = bitmap_get_next_zero(b, n + 1);
+        if (n < 0) {
+            break;
+        }
+        bitmap_set(b, n);
+        bitmap_clear(b, ut_rand(&seed) % bits);
+    }
+    ut_result("bitmap", "next_zero", bits, i, ut_now_ns() - start);
+
+    // Keep the loads
+    if (set == UINT64_MAX) {
+        printf("bitmap: %lu\n", set);
+    }
+
+    bitmap_deallocate(b);
+    return 0;
+}
+
+int dp_bench_utils(void)
+{
+    static const uint32_t map_sizes[] = {1000, 100000, 1000000};
+    static const uint32_t asm_sizes[] = {2, ASM_INLINE_CLIPS, 8, 64, 512};
+    int i, p, ret = 0;
+
+    rcu_register_thread();
+
+    for (i = 0; i < ARRAY_ENTRIES(map_sizes) && ret == 0; i ++) {
+        ret = ut_rcu_map(map_sizes[i]);
+    }
+    if (ret == 0) {
+        ret = ut_timer_wheel(BENCH_UTILS_TIMERS);
+    }
+    if (ret == 0) {
+        ret = ut_timer_queue(BENCH_UTILS_TIMERS);
+    }
+    for (p = 0; p < UT_ASM_PATTERN_MAX && ret == 0; p ++) {
+        for (i = 0; i < ARRAY_ENTRIES(asm_sizes) && ret == 0; i ++) {
+            ret = ut_asm(p, asm_sizes[i]);
+        }
+    }
+    if (ret == 0) {
+        ret = ut_bitmap(BENCH_UTILS_BITMAP_BITS);
+    }
+
+    rcu_unregister_thread();
+
+    if (ret < 0) {
+        printf("Failed to allocate the benchmark data\n");
+    }
+    return ret;
+}
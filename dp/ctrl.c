@@ -8,6 +8,11 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 
 #include "jansson.h"
 #include "urcu.h"
@@ -16,11 +21,13 @@
 #include "apis.h"
 #include "debug.h"
 #include "utils/helper.h"
+#include "utils/hash.h"
 #include "utils/rcu_map.h"
 #include "utils/bits.h"
+#include "utils/mem_acct.h"
 #include "dpi/sig/dpi_search.h"
 
-extern int dp_data_add_port(const char *iface, bool jumboframe, int thr_id);
+extern int dp_data_add_port(const char *iface, bool jumboframe, bool xdp, bool fanout, int thr_id);
 extern int dp_data_del_port(const char *iface, int thr_id);
 extern int dp_data_add_tap(const char *netns, const char *iface, const char *ep_mac, int thr_id);
 extern int dp_data_del_tap(const char *netns, const char *iface, int thr_id);
@@ -28,28 +35,43 @@ extern int dp_data_add_nfq(const char *netns, const char *iface, int qnum, const
 extern int dp_data_del_nfq(const char *netns, const char *iface, int thr_id);
 extern int dp_read_ring_stats(dp_stats_t *s, int thr_id);
 extern int dp_read_conn_stats(conn_stats_t *s, int thr_id);
-extern int dp_data_add_port_pair(const char *vin_iface, const char *vex_iface,const char *ep_mac, bool quar, int thr_id);
+extern int dp_read_fwd_latency(int thr_id, dp_fwd_lat_fct cb, void *arg);
+extern int dp_data_add_port_pair(const char *vin_iface, const char *vex_iface,const char *ep_mac, bool quar, bool xdp, int thr_id);
 extern int dp_data_del_port_pair(const char *vin_iface, const char *vex_iface, int thr_id);
+extern uint64_t dp_huge_tlb_read(int fd);
+extern uint64_t dp_huge_bytes(void);
+extern uint64_t dp_arena_bytes(int thr_id);
+extern void dp_arena_totals(uint64_t *allocated, uint64_t *resident);
+extern int dp_data_set_threads(int threads);
+extern void dp_data_rebalance(void);
+extern void dp_data_tune_rings(void);
+extern void dp_data_refresh_filter(struct ether_addr *mac);
+extern uint64_t dp_snap_key(const void *data, uint32_t len, uint64_t seed);
+extern void dp_snap_add(int type, uint64_t key, const void *hdr, uint32_t hdr_len, const void *data, uint32_t len);
+extern void dp_snap_reset(void);
+extern bool dp_snap_restore(uint32_t min, uint32_t gen, dp_snap_apply_fct apply, uint32_t *cur);
+
+int dp_ctrl_set_timer_period(const char *name, uint32_t period);
 
 extern rcu_map_t g_ep_map;
 extern struct cds_list_head g_subnet4_list;
 extern struct cds_list_head g_subnet6_list;
 extern dpi_fqdn_hdl_t *g_fqdn_hdl;
 
-pthread_cond_t g_ctrl_req_cond;
-pthread_mutex_t g_ctrl_req_lock;
-pthread_cond_t g_dlp_ctrl_req_cond;
 pthread_mutex_t g_dlp_ctrl_req_lock;
 
 static int g_ctrl_fd;
 #define DP_SERVER_SOCK "/tmp/dp_listen.sock"
 static struct sockaddr_un g_client_addr;
+static uint32_t g_client_req_id;    // id of the request being handled, 0 if none
 
 static int g_ctrl_notify_fd;
 #define CTRL_NOTIFY_SOCK "/tmp/ctrl_listen.sock"
 static struct sockaddr_un g_ctrl_notify_addr;
 
 static uint8_t g_notify_msg[DP_MSG_SIZE];
+static uint8_t g_report_msg[DP_MSG_SIZE];   // used by the report thread
+static bool g_app_walk;     // app changes not queued by MAC, walk all endpoints
 
 static int make_notify_client(const char *filename)
 {
@@ -98,6 +120,39 @@ static int make_named_socket(const char *filename)
     return sock;
 }
 
+// Reply to the client, prefixed with the request id if the request carried one
+static int dp_ctrl_send_reply(void *data, int len)
+{
+    DPMsgReplyHdr rh;
+    struct msghdr mh;
+    struct iovec iov[2];
+    int sent;
+
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_name = &g_client_addr;
+    mh.msg_namelen = sizeof(struct sockaddr_un);
+    mh.msg_iov = iov;
+
+    if (g_client_req_id != 0) {
+        rh.ReqID = htonl(g_client_req_id);
+        iov[0].iov_base = &rh;
+        iov[0].iov_len = sizeof(rh);
+        iov[1].iov_base = data;
+        iov[1].iov_len = len;
+        mh.msg_iovlen = 2;
+    } else {
+        iov[0].iov_base = data;
+        iov[0].iov_len = len;
+        mh.msg_iovlen = 1;
+    }
+
+    sent = sendmsg(g_ctrl_fd, &mh, 0);
+    if (sent > 0 && g_client_req_id != 0) {
+        sent -= sizeof(rh);
+    }
+    return sent;
+}
+
 // Send json message to client socket as response
 int dp_ctrl_send_json(json_t *root)
 {
@@ -115,11 +170,9 @@ int dp_ctrl_send_json(json_t *root)
         return 0;
     }
 
-    socklen_t addr_len = sizeof(struct sockaddr_un);
     //data is nul terminated according to json_dumps
     //so strlen(data) is safe here
-    int sent = sendto(g_ctrl_fd, data, strlen(data), 0,
-                      (struct sockaddr *)&g_client_addr, addr_len);
+    int sent = dp_ctrl_send_reply(data, strlen(data));
     DEBUG_CTRL("%s\n", data);
 
     free(data);
@@ -131,18 +184,19 @@ int dp_ctrl_send_json(json_t *root)
 // Send binary message to client socket as response
 int dp_ctrl_send_binary(void *data, int len)
 {
-    socklen_t addr_len = sizeof(struct sockaddr_un);
-    int sent = sendto(g_ctrl_fd, data, len, 0,
-                      (struct sockaddr *)&g_client_addr, addr_len);
-
-    return sent;
+    return dp_ctrl_send_reply(data, len);
 }
 
+uint8_t g_native_msg;
+
+// "native" is sent with every keep alive, an older agent turns the host order off again
 static int dp_ctrl_keep_alive(json_t *msg)
 {
     uint32_t seq_num = json_integer_value(json_object_get(msg, "seq_num"));
     uint8_t buf[sizeof(DPMsgHdr) + sizeof(uint32_t)];
 
+    uatomic_set(&g_native_msg, json_is_true(json_object_get(msg, "native")));
+
     DPMsgHdr *hdr = (DPMsgHdr *)buf;
     hdr->Kind = DP_KIND_KEEP_ALIVE;
     hdr->Length = htons(sizeof(DPMsgHdr) + sizeof(uint32_t));
@@ -163,8 +217,11 @@ static int dp_ctrl_add_tap_port(json_t *msg)
     iface = json_string_value(json_object_get(msg, "iface"));
     ep_mac = json_string_value(json_object_get(msg, "epmac"));
     DEBUG_CTRL("netns=%s iface=%s\n", netns, iface);
+    if (!dp_instance_owns(netns, iface)) {
+        return 0;
+    }
 
-    return dp_data_add_tap(netns, iface, ep_mac, 0);
+    return dp_data_add_tap(netns, iface, ep_mac, -1);
 }
 
 static int dp_ctrl_del_tap_port(json_t *msg)
@@ -174,16 +231,19 @@ static int dp_ctrl_del_tap_port(json_t *msg)
     netns = json_string_value(json_object_get(msg, "netns"));
     iface = json_string_value(json_object_get(msg, "iface"));
     DEBUG_CTRL("netns=%s iface=%s\n", netns, iface);
+    if (!dp_instance_owns(netns, iface)) {
+        return 0;
+    }
 
-    return dp_data_del_tap(netns, iface, 0);
+    return dp_data_del_tap(netns, iface, -1);
 }
 
 static int dp_ctrl_add_nfq_port(json_t *msg)
 {
     const char *netns, *iface, *ep_mac;
-    json_t *jumboframe_obj;
+    json_t *jumboframe_obj, *qcount_obj;
     bool jumboframe = false;
-    int qnum = 0;
+    int qnum = 0, qcount = 1, i, ret;
 
     jumboframe_obj = json_object_get(msg, "jumboframe");
     if (jumboframe_obj != NULL) {
@@ -194,66 +254,144 @@ static int dp_ctrl_add_nfq_port(json_t *msg)
     iface = json_string_value(json_object_get(msg, "iface"));
     qnum = json_integer_value(json_object_get(msg, "qnum"));
 
+    // Queue range of NFQUEUE --queue-balance, one queue on each dp thread.
+    qcount_obj = json_object_get(msg, "qcount");
+    if (qcount_obj != NULL) {
+        qcount = json_integer_value(qcount_obj);
+    }
+    if (qcount < 1) {
+        qcount = 1;
+    } else if (qcount > g_dp_threads) {
+        qcount = g_dp_threads;
+    }
+
     ep_mac = json_string_value(json_object_get(msg, "epmac"));
-    DEBUG_CTRL("add nfq netns=%s iface=%s, jumboframe=%d\n", netns, iface, jumboframe);
+    DEBUG_CTRL("add nfq netns=%s iface=%s, jumboframe=%d qnum=%d qcount=%d\n",
+               netns, iface, jumboframe, qnum, qcount);
+    if (!dp_instance_owns(netns, iface)) {
+        return 0;
+    }
 
-    return dp_data_add_nfq(netns, iface, qnum, ep_mac, jumboframe, 0);
+    for (i = 0; i < qcount; i ++) {
+        ret = dp_data_add_nfq(netns, iface, qnum + i, ep_mac, jumboframe, i);
+        if (ret < 0) {
+            while (-- i >= 0) {
+                dp_data_del_nfq(netns, iface, i);
+            }
+            return ret;
+        }
+    }
+    return 0;
 }
 
 static int dp_ctrl_del_nfq_port(json_t *msg)
 {
     const char *netns, *iface;
+    int thr_id, ret;
 
     netns = json_string_value(json_object_get(msg, "netns"));
     iface = json_string_value(json_object_get(msg, "iface"));
     DEBUG_CTRL("del nfq netns=%s iface=%s\n", netns, iface);
+    if (!dp_instance_owns(netns, iface)) {
+        return 0;
+    }
 
-    return dp_data_del_nfq(netns, iface, 0);
+    ret = dp_data_del_nfq(netns, iface, 0);
+    // Balanced queues on other threads
+    for (thr_id = 1; thr_id < g_dp_threads; thr_id ++) {
+        dp_data_del_nfq(netns, iface, thr_id);
+    }
+    return ret;
 }
 
 static int dp_ctrl_add_srvc_port(json_t *msg)
 {
     const char *iface;
-    json_t *jumboframe_obj;
-    bool jumboframe = false;
+    json_t *jumboframe_obj, *xdp_obj, *fanout_obj;
+    bool jumboframe = false, xdp = g_xdp, fanout = g_fanout;
+    int thr_id, ret;
 
     jumboframe_obj = json_object_get(msg, "jumboframe");
     if (jumboframe_obj != NULL) {
         jumboframe = json_boolean_value(jumboframe_obj);
     }
+    xdp_obj = json_object_get(msg, "xdp");
+    if (xdp_obj != NULL) {
+        xdp = json_boolean_value(xdp_obj);
+    }
+    fanout_obj = json_object_get(msg, "fanout");
+    if (fanout_obj != NULL) {
+        fanout = json_boolean_value(fanout_obj);
+    }
 
     iface = json_string_value(json_object_get(msg, "iface"));
-    DEBUG_CTRL("iface=%s, jumboframe=%d\n", iface, jumboframe);
+    DEBUG_CTRL("iface=%s, jumboframe=%d xdp=%d fanout=%d\n", iface, jumboframe, xdp, fanout);
+    if (!dp_instance_owns(NULL, iface)) {
+        return 0;
+    }
 
-    return dp_data_add_port(iface, jumboframe, 0);
+    if (!fanout || g_dp_threads <= 1) {
+        return dp_data_add_port(iface, jumboframe, xdp, false, 0);
+    }
+
+    // One socket per dp thread in the fanout group of the interface. Threads added later
+    // are not in the group, the hash of the handoff follows the group size.
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        ret = dp_data_add_port(iface, jumboframe, false, true, thr_id);
+        if (ret < 0) {
+            while (-- thr_id >= 0) {
+                dp_data_del_port(iface, thr_id);
+            }
+            return ret;
+        }
+    }
+    CMM_STORE_SHARED(g_dp_fanout_threads, g_dp_threads);
+    return 0;
 }
 
 static int dp_ctrl_del_srvc_port(json_t *msg)
 {
     const char *iface;
+    int thr_id, ret;
 
     iface = json_string_value(json_object_get(msg, "iface"));
     DEBUG_CTRL("iface=%s\n", iface);
+    if (!dp_instance_owns(NULL, iface)) {
+        return 0;
+    }
 
-    return dp_data_del_port(iface, 0);
+    CMM_STORE_SHARED(g_dp_fanout_threads, 0);
+    ret = dp_data_del_port(iface, 0);
+    // Fanout sockets on other threads
+    for (thr_id = 1; thr_id < g_dp_threads; thr_id ++) {
+        dp_data_del_port(iface, thr_id);
+    }
+    return ret;
 }
 
 static int dp_ctrl_add_port_pair(json_t *msg)
 {
     const char *vex_iface, *vin_iface, *ep_mac;
-    json_t *quar_obj;
-    bool quar = false;
+    json_t *quar_obj, *xdp_obj;
+    bool quar = false, xdp = g_xdp;
 
     quar_obj = json_object_get(msg, "quar");
     if (quar_obj != NULL) {
         quar = json_boolean_value(quar_obj);
     }
+    xdp_obj = json_object_get(msg, "xdp");
+    if (xdp_obj != NULL) {
+        xdp = json_boolean_value(xdp_obj);
+    }
 
     vin_iface = json_string_value(json_object_get(msg, "vin_iface"));
     vex_iface = json_string_value(json_object_get(msg, "vex_iface"));
     ep_mac = json_string_value(json_object_get(msg, "epmac"));
-    DEBUG_CTRL("Add vin %s: vex %s  epmac: %s quar: %d\n", vin_iface, vex_iface, ep_mac, quar);
-    return dp_data_add_port_pair(vin_iface, vex_iface, ep_mac, quar, 0);
+    DEBUG_CTRL("Add vin %s: vex %s  epmac: %s quar: %d xdp: %d\n", vin_iface, vex_iface, ep_mac, quar, xdp);
+    if (!dp_instance_owns(NULL, vin_iface)) {
+        return 0;
+    }
+    return dp_data_add_port_pair(vin_iface, vex_iface, ep_mac, quar, xdp, 0);
 }
 
 static int dp_ctrl_del_port_pair(json_t *msg)
@@ -263,13 +401,16 @@ static int dp_ctrl_del_port_pair(json_t *msg)
     vin_iface = json_string_value(json_object_get(msg, "vin_iface"));
     vex_iface = json_string_value(json_object_get(msg, "vex_iface"));
     DEBUG_CTRL("Del vin %s: vex %s\n", vin_iface, vex_iface);
+    if (!dp_instance_owns(NULL, vin_iface)) {
+        return 0;
+    }
     return dp_data_del_port_pair(vin_iface, vex_iface, 0);
 }
 
 static uint32_t ep_app_hash(const void *key)
 {
     const io_app_t *app = key;
-    return app->port ^ app->ip_proto;
+    return hash_u32(((uint32_t)app->port << 8) | app->ip_proto);
 }
 
 static int ep_app_match(struct cds_lfht_node *ht_node, const void *key)
@@ -286,6 +427,60 @@ static void dp_pips_destroy(io_ep_t *ep)
     }
 }
 
+// Sessions of the endpoint's network leg take the blocks of its proxymesh child's "lo" leg,
+// which is inspected in clear text, instead of being parsed again.
+static void ep_mesh_dedup(io_ep_t *ep, bool enable)
+{
+    io_mesh_verdict_t *mv = ep->mesh_verdict;
+
+    if (enable && mv == NULL) {
+        if ((mv = calloc(1, sizeof(*mv))) != NULL) {
+            rcu_assign_pointer(ep->mesh_verdict, mv);
+        }
+    } else if (!enable && mv != NULL) {
+        rcu_assign_pointer(ep->mesh_verdict, NULL);
+        dp_reclaim_defer(free, mv);
+    }
+}
+
+static uint64_t ep_rate_cost(uint64_t hz, uint64_t rate, int shift)
+{
+    uint64_t cost;
+
+    if (rate == 0) {
+        return 0;
+    }
+    cost = ((unsigned __int128)hz << shift) / rate;
+    return cost > 0 ? cost : 1;
+}
+
+// The buckets start over on each change, a limit of 0 is no limit
+static int ep_rate_limit(io_ep_t *ep, const uint64_t pps[2], const uint64_t bps[2])
+{
+    io_rate_limit_t *old = ep->rate_limit, *rl = NULL;
+    uint64_t hz = lat_tsc_hz();
+    int dir;
+
+    if (pps[0] != 0 || pps[1] != 0 || bps[0] != 0 || bps[1] != 0) {
+        if ((rl = calloc(1, sizeof(*rl))) == NULL) {
+            return -1;
+        }
+        for (dir = 0; dir < 2; dir ++) {
+            rl->pps[dir] = pps[dir];
+            rl->bps[dir] = bps[dir];
+            rl->pkt_cost[dir] = ep_rate_cost(hz, pps[dir], 0);
+            rl->byte_cost[dir] = ep_rate_cost(hz * 8, bps[dir], IO_RATE_BYTE_SHIFT);
+        }
+        rl->burst = hz * IO_RATE_BURST_MS / 1000;
+    }
+
+    rcu_assign_pointer(ep->rate_limit, rl);
+    if (old != NULL) {
+        dp_reclaim_defer(free, old);
+    }
+    return 0;
+}
+
 static void ep_app_destroy(io_ep_t *ep)
 {
     struct cds_lfht_node *node;
@@ -300,7 +495,7 @@ static void ep_app_destroy(io_ep_t *ep)
 static uint32_t ep_dlp_cfg_hash(const void *key)
 {
     const io_dlp_cfg_t *dlpcfg = key;
-    return sdbm_hash((uint8_t *)&dlpcfg->sigid, sizeof(uint32_t));
+    return hash_u32(dlpcfg->sigid);
 }
 
 static int ep_dlp_cfg_match(struct cds_lfht_node *ht_node, const void *key)
@@ -316,20 +511,7 @@ static void ep_dlp_cfg_destroy(io_ep_t *ep)
     RCU_MAP_FOR_EACH(&ep->dlp_cfg_map, node) {
         io_dlp_cfg_t *dlpcfg = STRUCT_OF(node, io_dlp_cfg_t, node);
         rcu_map_del(&ep->dlp_cfg_map, dlpcfg);
-
-        if (dlpcfg->sig_user_list.prev == NULL && dlpcfg->sig_user_list.next == NULL) {
-            CDS_INIT_LIST_HEAD(&dlpcfg->sig_user_list);
-        }
-        
-        dpi_sig_user_link_t *sig_user_itr, *sig_user_next;
-        cds_list_for_each_entry_safe(sig_user_itr, sig_user_next, &dlpcfg->sig_user_list, node) {
-            cds_list_del((struct cds_list_head *)sig_user_itr);
-            if (sig_user_itr->sig_user) {
-                free(sig_user_itr->sig_user);
-            }
-            free(sig_user_itr);
-        }
-       free(dlpcfg);
+        free(dlpcfg);
     }
     rcu_map_destroy(&ep->dlp_cfg_map);
 }
@@ -340,20 +522,7 @@ static void ep_waf_cfg_destroy(io_ep_t *ep)
     RCU_MAP_FOR_EACH(&ep->waf_cfg_map, node) {
         io_dlp_cfg_t *wafcfg = STRUCT_OF(node, io_dlp_cfg_t, node);
         rcu_map_del(&ep->waf_cfg_map, wafcfg);
-
-        if (wafcfg->sig_user_list.prev == NULL && wafcfg->sig_user_list.next == NULL) {
-            CDS_INIT_LIST_HEAD(&wafcfg->sig_user_list);
-        }
-        
-        dpi_sig_user_link_t *sig_user_itr, *sig_user_next;
-        cds_list_for_each_entry_safe(sig_user_itr, sig_user_next, &wafcfg->sig_user_list, node) {
-            cds_list_del((struct cds_list_head *)sig_user_itr);
-            if (sig_user_itr->sig_user) {
-                free(sig_user_itr->sig_user);
-            }
-            free(sig_user_itr);
-        }
-       free(wafcfg);
+        free(wafcfg);
     }
     rcu_map_destroy(&ep->waf_cfg_map);
 }
@@ -361,7 +530,7 @@ static void ep_waf_cfg_destroy(io_ep_t *ep)
 static uint32_t ep_dlp_ruleid_hash(const void *key)
 {
     const io_dlp_ruleid_t *dlprid = key;
-    return sdbm_hash((uint8_t *)&dlprid->rid, sizeof(uint32_t));
+    return hash_u32(dlprid->rid);
 }
 
 static int ep_dlp_ruleid_match(struct cds_lfht_node *ht_node, const void *key)
@@ -403,9 +572,77 @@ static void ep_destroy(io_ep_t *ep)
     ep_waf_rid_destroy(ep);
     dp_dlp_destroy(ep->dlp_detector);
     dp_pips_destroy(ep);
+    free(ep->mesh_verdict);
+    free(ep->rate_limit);
 }
 
-static int dp_ctrl_add_mac(json_t *msg)
+static int dp_dpi_del_mac(struct ether_addr *mac_addr)
+{
+    io_ctrl_cmd_t cmd;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.req = CTRL_REQ_DEL_MAC;
+    cmd.mac = *mac_addr;
+    dp_data_wait_ctrl_cmd(&cmd);
+
+    return 0;
+}
+
+// Bumped after g_ep_map changes, endpoints cached by the rx contexts are looked up again.
+// Removed entries are freed after a grace period that starts after the bump.
+uint32_t g_ep_map_gen = 1;
+
+static void dp_ctrl_ep_map_changed(void)
+{
+    cmm_smp_wmb();
+    CMM_STORE_SHARED(g_ep_map_gen, g_ep_map_gen + 1);
+}
+
+// An ep removed from g_ep_map, destroyed once readers are done with it
+typedef struct dp_ep_retired_ {
+    void *buf;
+    struct ether_addr mac;
+    bool replaced;      // resources are moved to the new ep
+} dp_ep_retired_t;
+
+// Destroy removed eps after a single grace period
+static void dp_ctrl_free_retired_eps(dp_ep_retired_t *retired, int count)
+{
+    int i;
+
+    if (count == 0) {
+        return;
+    }
+
+    synchronize_rcu();
+
+    for (i = 0; i < count; i ++) {
+        io_ep_t *ep = GET_EP_FROM_MAC_MAP(retired[i].buf);
+
+        if (retired[i].replaced) {
+            // Pointers are copied to the new ep. Reset pointers in the old ep to prevent data from being destroyed.
+            ep->policy_hdl = NULL;
+            rcu_map_init(&ep->app_map, 8, offsetof(io_app_t, node), ep_app_match, ep_app_hash);
+            //dlp
+            ep->dlp_detector = NULL;
+            rcu_map_init(&ep->dlp_cfg_map, 8, offsetof(io_dlp_cfg_t, node), ep_dlp_cfg_match, ep_dlp_cfg_hash);
+            rcu_map_init(&ep->waf_cfg_map, 8, offsetof(io_dlp_cfg_t, node), ep_dlp_cfg_match, ep_dlp_cfg_hash);
+            rcu_map_init(&ep->dlp_rid_map, 8, offsetof(io_dlp_ruleid_t, node), ep_dlp_ruleid_match, ep_dlp_ruleid_hash);
+            rcu_map_init(&ep->waf_rid_map, 8, offsetof(io_dlp_ruleid_t, node), ep_dlp_ruleid_match, ep_dlp_ruleid_hash);
+            ep->mesh_verdict = NULL;
+            ep->rate_limit = NULL;
+        }
+        ep_destroy(ep);
+        free(retired[i].buf);
+
+        if (!retired[i].replaced) {
+            dp_dpi_del_mac(&retired[i].mac);
+        }
+    }
+}
+
+// Add or replace an ep. Return 1 if an old ep is removed and added to 'retired'.
+static int dp_ctrl_add_ep(json_t *msg, dp_ep_retired_t *retired)
 {
     void *buf;
     io_ep_t *ep;
@@ -512,6 +749,10 @@ static int dp_ctrl_add_mac(json_t *msg)
 
         memcpy(&ep->COPY_START, &old_ep->COPY_START, sizeof(io_ep_t) - offsetof(io_ep_t, COPY_START));
         DEBUG_CTRL("copy existing ep, policy hdl %p.\n", old_ep->policy_hdl);
+        // Changes are queued with the old MAC
+        if (memcmp(&oldmac, &mac->mac, sizeof(oldmac)) != 0 && uatomic_read(&ep->app_updated)) {
+            g_app_walk = true;
+        }
 
         // Remove the old unicast/broadcast mac entry
         rcu_map_del(&g_ep_map, old_buf);
@@ -535,22 +776,14 @@ static int dp_ctrl_add_mac(json_t *msg)
         }
 
         rcu_read_unlock();
-        synchronize_rcu();
+        dp_ctrl_ep_map_changed();
 
-        // Pointers are copied to the new ep. Reset pointers in the old ep to prevent data from being destroyed.
-        old_ep->policy_hdl = NULL;
-        rcu_map_init(&old_ep->app_map, 8, offsetof(io_app_t, node), ep_app_match, ep_app_hash);
-        //dlp
-        old_ep->dlp_detector = NULL;
-        rcu_map_init(&old_ep->dlp_cfg_map, 8, offsetof(io_dlp_cfg_t, node), ep_dlp_cfg_match, ep_dlp_cfg_hash);
-        rcu_map_init(&old_ep->waf_cfg_map, 8, offsetof(io_dlp_cfg_t, node), ep_dlp_cfg_match, ep_dlp_cfg_hash);
-        rcu_map_init(&old_ep->dlp_rid_map, 8, offsetof(io_dlp_ruleid_t, node), ep_dlp_ruleid_match, ep_dlp_ruleid_hash);
-        rcu_map_init(&old_ep->waf_rid_map, 8, offsetof(io_dlp_ruleid_t, node), ep_dlp_ruleid_match, ep_dlp_ruleid_hash);
-        ep_destroy(old_ep);
-
-        free(old_buf);
+        retired->buf = old_buf;
+        retired->replaced = true;
+        dp_data_refresh_filter(&mac->mac);
 
         DEBUG_CTRL("replace %s to ep map.\n", mac_str);
+        return 1;
     } else {
         rcu_map_init(&ep->app_map, 8, offsetof(io_app_t, node), ep_app_match, ep_app_hash);
         rcu_map_init(&ep->dlp_cfg_map, 8, offsetof(io_dlp_cfg_t, node), ep_dlp_cfg_match, ep_dlp_cfg_hash);
@@ -568,32 +801,64 @@ static int dp_ctrl_add_mac(json_t *msg)
         }
 
         rcu_read_unlock();
+        dp_ctrl_ep_map_changed();
+        dp_data_refresh_filter(&mac->mac);
         DEBUG_CTRL("add %s to ep map.\n", mac_str);
     }
 
     return 0;
 }
 
-struct ether_addr *g_mac_addr_to_del = NULL;
-static int dp_dpi_del_mac(struct ether_addr *mac_addr)
+static int dp_ctrl_add_mac(json_t *msg)
 {
-    g_mac_addr_to_del = mac_addr;
+    dp_ep_retired_t retired;
+    int ret;
 
-    int thr_id;
-    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
-        dp_data_wait_ctrl_req_thr(CTRL_REQ_DEL_MAC, thr_id);
+    ret = dp_ctrl_add_ep(msg, &retired);
+    if (ret > 0) {
+        dp_ctrl_free_retired_eps(&retired, 1);
+    }
+    return ret < 0 ? -1 : 0;
+}
+
+// Add a batch of eps, replaced eps are released with one grace period
+static int dp_ctrl_add_macs(json_t *msg)
+{
+    dp_ep_retired_t *retired;
+    json_t *obj;
+    int i, ret, count, retired_cnt = 0;
+
+    obj = json_object_get(msg, "macs");
+    count = json_array_size(obj);
+    if (count == 0) {
+        return 0;
+    }
+
+    retired = calloc(count, sizeof(*retired));
+    if (retired == NULL) {
+        DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
+        return -1;
+    }
+
+    for (i = 0; i < count; i ++) {
+        ret = dp_ctrl_add_ep(json_array_get(obj, i), &retired[retired_cnt]);
+        if (ret > 0) {
+            retired_cnt ++;
+        }
     }
 
-    g_mac_addr_to_del = NULL;
+    DEBUG_CTRL("added %d eps, replaced %d\n", count, retired_cnt);
+
+    dp_ctrl_free_retired_eps(retired, retired_cnt);
+    free(retired);
     return 0;
 }
 
-static int dp_ctrl_del_mac(json_t *msg)
+// Remove an ep from the map. Return 1 if it is found and added to 'retired'.
+static int dp_ctrl_del_ep(const char *mac_str, dp_ep_retired_t *retired)
 {
     struct ether_addr mac_addr;
-    const char *mac_str;
 
-    mac_str = json_string_value(json_object_get(msg, "mac"));
     ether_aton_r(mac_str, &mac_addr);
 
     DEBUG_CTRL("mac=%s\n", mac_str);
@@ -603,28 +868,71 @@ static int dp_ctrl_del_mac(json_t *msg)
     if (old_buf == NULL) {
         rcu_read_unlock();
         DEBUG_CTRL("mac %s not found in ep map.\n", mac_str);
-        return -1;
-    } else {
-        rcu_map_del(&g_ep_map, old_buf);
+        return 0;
+    }
 
-        io_mac_t *old_ucmac = old_buf + sizeof(io_mac_t);
-        rcu_map_del(&g_ep_map, old_ucmac);
+    rcu_map_del(&g_ep_map, old_buf);
 
-        io_mac_t *old_bcmac = old_buf + sizeof(io_mac_t) * 2;
-        rcu_map_del(&g_ep_map, old_bcmac);
+    io_mac_t *old_ucmac = old_buf + sizeof(io_mac_t);
+    rcu_map_del(&g_ep_map, old_ucmac);
 
-        rcu_read_unlock();
-        synchronize_rcu();
+    io_mac_t *old_bcmac = old_buf + sizeof(io_mac_t) * 2;
+    rcu_map_del(&g_ep_map, old_bcmac);
 
-        io_ep_t *ep = (io_ep_t *)(old_buf + sizeof(io_mac_t) * 3);
-        ep_destroy(ep);
+    rcu_read_unlock();
+    dp_ctrl_ep_map_changed();
+    dp_data_refresh_filter(&mac_addr);
+
+    retired->buf = old_buf;
+    retired->mac = mac_addr;
+    retired->replaced = false;
+
+    DEBUG_CTRL("remove %s from ep map.\n", mac_str);
+    return 1;
+}
+
+static int dp_ctrl_del_mac(json_t *msg)
+{
+    dp_ep_retired_t retired;
+
+    if (dp_ctrl_del_ep(json_string_value(json_object_get(msg, "mac")), &retired) == 0) {
+        return -1;
+    }
+
+    dp_ctrl_free_retired_eps(&retired, 1);
+    return 0;
+}
+
+// Remove a batch of eps, they are released with one grace period
+static int dp_ctrl_del_macs(json_t *msg)
+{
+    dp_ep_retired_t *retired;
+    json_t *obj;
+    int i, count, retired_cnt = 0;
+
+    obj = json_object_get(msg, "macs");
+    count = json_array_size(obj);
+    if (count == 0) {
+        return 0;
+    }
 
-        free(old_buf);
+    retired = calloc(count, sizeof(*retired));
+    if (retired == NULL) {
+        DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
+        return -1;
+    }
 
-        DEBUG_CTRL("remove %s from ep map.\n", mac_str);
-        dp_dpi_del_mac(&mac_addr);
+    for (i = 0; i < count; i ++) {
+        const char *mac_str = json_string_value(json_array_get(obj, i));
+        if (mac_str != NULL) {
+            retired_cnt += dp_ctrl_del_ep(mac_str, &retired[retired_cnt]);
+        }
     }
 
+    DEBUG_CTRL("removed %d of %d eps\n", retired_cnt, count);
+
+    dp_ctrl_free_retired_eps(retired, retired_cnt);
+    free(retired);
     return 0;
 }
 
@@ -668,9 +976,53 @@ static int dp_ctrl_cfg_nbe(json_t *msg)
     return 0;
 }
 
+// Per endpoint "ingress_pps", "ingress_bps", "egress_pps" and "egress_bps", bps in bits. A
+// missing or 0 limit is no limit, the endpoints are not limited once all are 0.
+static int dp_ctrl_cfg_rate_limit(json_t *msg)
+{
+    json_t *obj = json_object_get(msg, "macs");
+    uint64_t pps[2], bps[2];
+    int len, i, ret = 0;
+
+    pps[IO_RATE_INGRESS] = json_integer_value(json_object_get(msg, "ingress_pps"));
+    bps[IO_RATE_INGRESS] = json_integer_value(json_object_get(msg, "ingress_bps"));
+    pps[IO_RATE_EGRESS] = json_integer_value(json_object_get(msg, "egress_pps"));
+    bps[IO_RATE_EGRESS] = json_integer_value(json_object_get(msg, "egress_bps"));
+
+    len = json_array_size(obj);
+    if (len == 0) {
+        DEBUG_ERROR(DBG_CTRL, "Missing mac address in rate limit cfg!!\n");
+        return -1;
+    }
+
+    rcu_read_lock();
+    for (i = 0; i < len; i ++) {
+        struct ether_addr mac_addr;
+        const char *mac_str = json_string_value(json_array_get(obj, i));
+        io_mac_t *mac;
+
+        if (mac_str == NULL || ether_aton_r(mac_str, &mac_addr) == NULL) {
+            continue;
+        }
+        mac = rcu_map_lookup(&g_ep_map, &mac_addr);
+        if (mac == NULL) {
+            DEBUG_ERROR(DBG_CTRL, "mac %s not found in ep map.\n", mac_str);
+            continue;
+        }
+        if (ep_rate_limit(mac->ep, pps, bps) < 0) {
+            ret = -1;
+            continue;
+        }
+        DEBUG_CTRL("mac=%s ingress=%lupps/%lubps egress=%lupps/%lubps\n", mac_str,
+                   pps[IO_RATE_INGRESS], bps[IO_RATE_INGRESS], pps[IO_RATE_EGRESS], bps[IO_RATE_EGRESS]);
+    }
+    rcu_read_unlock();
+    return ret;
+}
+
 static int dp_ctrl_cfg_mac(json_t *msg)
 {
-    json_t *obj, *tap_obj, *app_obj;
+    json_t *obj, *tap_obj, *app_obj, *inspect_obj, *dedup_obj, *sample_obj;
     bool tap = false;
     int len, i;
 #define MAX_APP_DELETE 64
@@ -683,6 +1035,9 @@ static int dp_ctrl_cfg_mac(json_t *msg)
         tap = json_boolean_value(tap_obj);
     }
     app_obj = json_object_get(msg, "apps");
+    inspect_obj = json_object_get(msg, "inspect");
+    dedup_obj = json_object_get(msg, "mesh_dedup");
+    sample_obj = json_object_get(msg, "tap_sample");
 
     len = json_array_size(obj);
     if (len == 0) {
@@ -706,6 +1061,18 @@ static int dp_ctrl_cfg_mac(json_t *msg)
         if (tap_obj != NULL) {
             ep->tap = tap;
         }
+        if (inspect_obj != NULL) {
+            ep->inspect_level = json_integer_value(inspect_obj);
+            DEBUG_CTRL("mac=%s, inspect=%u\n", mac_str, ep->inspect_level);
+        }
+        if (dedup_obj != NULL) {
+            ep_mesh_dedup(ep, json_boolean_value(dedup_obj));
+            DEBUG_CTRL("mac=%s, mesh_dedup=%d\n", mac_str, ep->mesh_verdict != NULL);
+        }
+        if (sample_obj != NULL) {
+            ep->tap_sample = json_integer_value(sample_obj);
+            DEBUG_CTRL("mac=%s, tap_sample=%uKB\n", mac_str, ep->tap_sample);
+        }
 
         // Listening ports and apps
         if (app_obj != NULL) {
@@ -770,9 +1137,52 @@ static int dp_ctrl_cfg_mac(json_t *msg)
 
 #define APPS_PER_MSG ((DP_MSG_SIZE - sizeof(DPMsgHdr) - sizeof(DPMsgAppHdr)) / sizeof(DPMsgApp))
 
+static void dp_ctrl_send_app(io_ep_t *ep)
+{
+    struct cds_lfht_node *app_node;
+    int ports = 0;
+
+    DPMsgHdr *hdr = (DPMsgHdr *)g_notify_msg;
+    DPMsgAppHdr *ah = (DPMsgAppHdr *)(g_notify_msg + sizeof(*hdr));
+    DPMsgApp *apps = (DPMsgApp *)(g_notify_msg + sizeof(*hdr) + sizeof(*ah));
+
+    hdr->Kind = DP_KIND_APP_UPDATE;
+    memcpy(&ah->MAC, &ep->mac->mac, sizeof(ah->MAC));
+
+    // Iterate through all apps
+    RCU_MAP_FOR_EACH(&ep->app_map, app_node) {
+        io_app_t *app = STRUCT_OF(app_node, io_app_t, node);
+
+        apps->Port = htons(app->port);
+        apps->IPProto = app->ip_proto;
+        apps->Proto = htons(app->proto);
+        apps->Server = htons(app->server);
+        apps->Application = htons(app->application);
+
+        apps ++;
+        ports ++;
+        if (ports == APPS_PER_MSG) {
+            break;
+        }
+    }
+
+    uint16_t len = sizeof(*hdr) + sizeof(*ah) + sizeof(DPMsgApp) * ports;
+    hdr->Length = htons(len);
+    ah->Ports = htons(ports);
+
+    if (ep->app_ports != ports) {
+        DEBUG_CTRL("Not all ports are sent. ports=%u sent=%u\n", ep->app_ports, ports);
+    }
+
+    DEBUG_CTRL("mac="DBG_MAC_FORMAT" ports=%d\n", DBG_MAC_TUPLE(ep->mac->mac), ports);
+
+    dp_ctrl_notify_ctrl(g_notify_msg, len);
+}
+
+// Walk all endpoints, on refresh or when some changes were not queued
 static void dp_ctrl_update_app(bool refresh)
 {
-    struct cds_lfht_node *node, *app_node;
+    struct cds_lfht_node *node;
 
     // Iterate through all MAC
     RCU_MAP_FOR_EACH(&g_ep_map, node) {
@@ -788,43 +1198,44 @@ static void dp_ctrl_update_app(bool refresh)
             continue;
         }
 
-        int ports = 0;
-
-        DPMsgHdr *hdr = (DPMsgHdr *)g_notify_msg;
-        DPMsgAppHdr *ah = (DPMsgAppHdr *)(g_notify_msg + sizeof(*hdr));
-        DPMsgApp *apps = (DPMsgApp *)(g_notify_msg + sizeof(*hdr) + sizeof(*ah));
+        dp_ctrl_send_app(ep);
+    }
+}
 
-        hdr->Kind = DP_KIND_APP_UPDATE;
-        memcpy(&ah->MAC, &mac->mac, sizeof(ah->MAC));
+#define APP_DIRTY_BATCH 64
 
-        // Iterate through all apps
-        RCU_MAP_FOR_EACH(&ep->app_map, app_node) {
-            io_app_t *app = STRUCT_OF(app_node, io_app_t, node);
+// Report the endpoints queued by the dp threads since the last time
+static void dp_ctrl_update_dirty_app(void)
+{
+    struct ether_addr macs[APP_DIRTY_BATCH];
+    bool walk = g_app_walk;
+    int thr_id, i, cnt;
 
-            apps->Port = htons(app->port);
-            apps->IPProto = app->ip_proto;
-            apps->Proto = htons(app->proto);
-            apps->Server = htons(app->server);
-            apps->Application = htons(app->application);
+    g_app_walk = false;
 
-            apps ++;
-            ports ++;
-            if (ports == APPS_PER_MSG) {
-                break;
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        while ((cnt = dpi_app_dirty_drain(thr_id, macs, APP_DIRTY_BATCH)) != 0) {
+            if (cnt < 0) {
+                walk = true;
+                continue;
             }
+            for (i = 0; i < cnt; i ++) {
+                io_mac_t *mac = rcu_map_lookup(&g_ep_map, &macs[i]);
+                if (mac == NULL) continue;
+
+                io_ep_t *ep = mac->ep;
+                if (ep->app_ports == 0) {
+                    uatomic_set(&ep->app_updated, 0);
+                } else if (uatomic_cmpxchg(&ep->app_updated, 1, 0) == 1) {
+                    dp_ctrl_send_app(ep);
+                }
+            }
+            if (cnt < APP_DIRTY_BATCH) break;
         }
+    }
 
-        uint16_t len = sizeof(*hdr) + sizeof(*ah) + sizeof(DPMsgApp) * ports;
-        hdr->Length = htons(len);
-        ah->Ports = htons(ports);
-
-        if (ep->app_ports != ports) {
-            DEBUG_CTRL("Not all ports are sent. ports=%u sent=%u\n", ep->app_ports, ports);
-        }
-
-        DEBUG_CTRL("mac="DBG_MAC_FORMAT" ports=%d\n", DBG_MAC_TUPLE(mac->mac), ports);
-
-        dp_ctrl_notify_ctrl(g_notify_msg, len);
+    if (walk) {
+        dp_ctrl_update_app(false);
     }
 }
 
@@ -848,54 +1259,43 @@ typedef struct ctrl_stats_ {
     uint64_t sess60;
     uint64_t pkt60;
     uint64_t byte60;
+    uint64_t rate_drop;
 } ctrl_stats_t;
 
+// Added to stats, which can sum several
 static void collect_stats(ctrl_stats_t *stats, io_metry_t *a, uint32_t cur, uint32_t last)
 {
-    register uint32_t s, n;
-    register uint64_t sess, pkt, byte;
+    io_window_t w;
+    uint32_t s;
 
-    stats->session = a->session;
-    stats->cur_session = a->cur_session;
-    stats->packet = a->packet;
-    stats->byte = a->byte;
+    stats->session += a->session;
+    stats->cur_session += a->cur_session;
+    stats->packet += a->packet;
+    stats->byte += a->byte;
+    stats->rate_drop += a->rate_drop;
 
     // 5s, last slot
     if (cur > 0 && last + 1 >= cur) {
         s = (cur - 1) % STATS_SLOTS;
-        stats->sess1 = a->sess_ring[s];
-        stats->pkt1 = a->pkt_ring[s];
-        stats->byte1 = a->byte_ring[s];
+        stats->sess1 += a->sess_ring[s];
+        stats->pkt1 += a->pkt_ring[s];
+        stats->byte1 += a->byte_ring[s];
     }
 
     // 12s
-    if (last + 12 >= cur) {
-        uint32_t from = (cur >= 12) ? cur - 12 : 0;
-        sess = pkt = byte = 0;
-        for (n = from; n < last; n ++) {
-            s = n % STATS_SLOTS;
-            sess += a->sess_ring[s];
-            pkt += a->pkt_ring[s];
-            byte += a->byte_ring[s];
-        }
-        stats->sess12 = sess;
-        stats->pkt12 = pkt;
-        stats->byte12 = byte;
+    if (last + STATS_WIN_SHORT >= cur) {
+        dpi_stats_window(a, last, cur, STATS_WIN_SHORT, &w);
+        stats->sess12 += w.sess;
+        stats->pkt12 += w.pkt;
+        stats->byte12 += w.byte;
     }
 
     // 60s
-    if (last + 59 >= cur) {
-        uint32_t from = (cur >= 59) ? cur - 59 : 0;
-        sess = pkt = byte = 0;
-        for (n = from; n < last; n ++) {
-            s = n % STATS_SLOTS;
-            sess += a->sess_ring[s];
-            pkt += a->pkt_ring[s];
-            byte += a->byte_ring[s];
-        }
-        stats->sess60 = sess;
-        stats->pkt60 = pkt;
-        stats->byte60 = byte;
+    if (last + STATS_WIN_LONG >= cur) {
+        dpi_stats_window(a, last, cur, STATS_WIN_LONG, &w);
+        stats->sess60 += w.sess;
+        stats->pkt60 += w.pkt;
+        stats->byte60 += w.byte;
     }
 }
 
@@ -929,14 +1329,18 @@ static int dp_ctrl_stats_macs(json_t *msg)
             continue;
         }
 
-        io_stats_t *s = &mac->ep->stats;
         ctrl_stats_t in, out;
+        int t;
 
         memset(&in, 0, sizeof(in));
         memset(&out, 0, sizeof(out));
 
-        collect_stats(&in, &s->in, g_stats_slot, s->cur_slot);
-        collect_stats(&out, &s->out, g_stats_slot, s->cur_slot);
+        // Each thread's slots up to the last one it updated
+        for (t = 0; t < MAX_DP_THREADS; t ++) {
+            io_stats_t *s = &mac->ep->stats[t];
+            collect_stats(&in, &s->in, g_stats_slot, s->cur_slot);
+            collect_stats(&out, &s->out, g_stats_slot, s->cur_slot);
+        }
 
         m->Interval = STATS_INTERVAL;
 
@@ -948,6 +1352,8 @@ static int dp_ctrl_stats_macs(json_t *msg)
         m->PacketOut += out.packet;
         m->ByteIn += in.byte;
         m->ByteOut += out.byte;
+        m->RateDropIn += in.rate_drop;
+        m->RateDropOut += out.rate_drop;
 
         m->SessionIn1 += in.sess1;
         m->SessionOut1 += out.sess1;
@@ -969,10 +1375,16 @@ static int dp_ctrl_stats_macs(json_t *msg)
         m->PacketOut60 += out.pkt60;
         m->ByteIn60 += in.byte60;
         m->ByteOut60 += out.byte60;
+
+        for (t = 0; t < MAX_DP_THREADS; t ++) {
+            m->CPUTime += mac->ep->cpu_ticks[t];
+        }
     }
 
     rcu_read_unlock();
 
+    m->CPUTime = htonll(lat_tsc_to_ns(m->CPUTime, lat_tsc_hz()));
+
     m->SessionIn = htonl(m->SessionIn);
     m->SessionOut = htonl(m->SessionOut);
     m->SessionCurIn = htonl(m->SessionCurIn);
@@ -981,6 +1393,8 @@ static int dp_ctrl_stats_macs(json_t *msg)
     m->PacketOut = htonll(m->PacketOut);
     m->ByteIn = htonll(m->ByteIn);
     m->ByteOut = htonll(m->ByteOut);
+    m->RateDropIn = htonll(m->RateDropIn);
+    m->RateDropOut = htonll(m->RateDropOut);
 
     m->SessionIn1 = htonl(m->SessionIn1);
     m->SessionOut1 = htonl(m->SessionOut1);
@@ -1014,10 +1428,12 @@ static void dpi_stats_callback(io_stats_t *stats, io_stats_t *s)
     stats->in.cur_session += s->in.cur_session;
     stats->in.packet += s->in.packet;
     stats->in.byte += s->in.byte;
+    stats->in.rate_drop += s->in.rate_drop;
     stats->out.session += s->out.session;
     stats->out.cur_session += s->out.cur_session;
     stats->out.packet += s->out.packet;
     stats->out.byte += s->out.byte;
+    stats->out.rate_drop += s->out.rate_drop;
 
     uint32_t start = (g_stats_slot < STATS_SLOTS) ? 0 : g_stats_slot - STATS_SLOTS;
     uint32_t end = min(g_stats_slot, s->cur_slot + 1);
@@ -1057,6 +1473,8 @@ static int dp_ctrl_stats_device(json_t *msg)
     out.cur_session = stats.out.cur_session;
     out.packet = stats.out.packet;
     out.byte = stats.out.byte;
+    in.rate_drop = stats.in.rate_drop;
+    out.rate_drop = stats.out.rate_drop;
     in.sess1 = stats.in.sess_ring[STATS_SLOTS - 1];
     in.pkt1 = stats.in.pkt_ring[STATS_SLOTS - 1];
     in.byte1 = stats.in.byte_ring[STATS_SLOTS - 1];
@@ -1100,6 +1518,8 @@ static int dp_ctrl_stats_device(json_t *msg)
     m->PacketOut = htonll(out.packet);
     m->ByteIn = htonll(in.byte);
     m->ByteOut = htonll(out.byte);
+    m->RateDropIn = htonll(in.rate_drop);
+    m->RateDropOut = htonll(out.rate_drop);
 
     m->SessionIn1 = htonl(in.sess1);
     m->SessionOut1 = htonl(out.sess1);
@@ -1185,22 +1605,402 @@ static int dp_ctrl_counter_device(json_t *msg)
     c->LimitDropConns = htonll(cs.limit_drop);
     c->LimitPassConns = htonll(cs.limit_pass);
 
-    // Get ring stats
+    // Get ring stats, fanout ports have a socket on each thread
     dp_stats_t s;
+    int thr_id;
     memset(&s, 0, sizeof(s));
-    dp_read_ring_stats(&s, 0);
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        dp_read_ring_stats(&s, thr_id);
+    }
 
     c->RXPackets = htonll(s.rx);
     c->TXPackets = htonll(s.tx);
     c->RXDropPackets = htonll(s.rx_drops);
     c->TXDropPackets = htonll(s.tx_drops);
+    c->HandoffPackets = htonll(s.handoff);
+    c->HandoffDropPackets = htonll(s.handoff_drops);
+
+    // Compare dTLB misses per packet with and without -H for the hugepage savings
+    uint64_t tlb_misses = 0;
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        tlb_misses += dp_huge_tlb_read(g_dp_thread_data[thr_id].tlb_fd);
+    }
+    c->HugepageBytes = htonll(dp_huge_bytes());
+    c->DTLBMisses = htonll(tlb_misses);
+
+    for (j = 0; j < DP_POOL_MAX; j ++) {
+        c->PoolInUse[j] = htonll(c->PoolInUse[j]);
+        c->PoolHighWater[j] = htonll(c->PoolHighWater[j]);
+        c->PoolAllocFails[j] = htonll(c->PoolAllocFails[j]);
+    }
+
+    // The ep map is shared, only the ctrl thread updates it
+    c->MapEntries[DP_MAP_EP] = g_ep_map.count;
+    c->MapBuckets[DP_MAP_EP] = g_ep_map.buckets;
+    for (j = 0; j < DP_MAP_MAX; j ++) {
+        c->MapEntries[j] = htonll(c->MapEntries[j]);
+        c->MapBuckets[j] = htonll(c->MapBuckets[j]);
+        c->MapResizes[j] = htonll(c->MapResizes[j]);
+    }
+    for (j = 0; j < DP_SESS_EVICT_MAX; j ++) {
+        c->SessionEvicts[j] = htonll(c->SessionEvicts[j]);
+    }
+    c->SessionLimitDrops = htonll(c->SessionLimitDrops);
+    c->TimerExpires = htonll(c->TimerExpires);
+    c->TimerDeferredRolls = htonll(c->TimerDeferredRolls);
+    c->TimerBacklog = htonll(c->TimerBacklog);
+    c->FlowCacheHits = htonll(c->FlowCacheHits);
+    c->FlowCacheMisses = htonll(c->FlowCacheMisses);
+    c->VerdictPackets = htonll(c->VerdictPackets);
+    c->VerdictRevokes = htonll(c->VerdictRevokes);
+    c->FlowOffloads = htonll(c->FlowOffloads);
+    c->FlowOffloadFails = htonll(c->FlowOffloadFails);
+    c->FlowOffloadPackets = htonll(c->FlowOffloadPackets);
+    c->NfqMarks = htonll(c->NfqMarks);
+    c->NfqUnmarks = htonll(c->NfqUnmarks);
+    c->PolicyCacheHits = htonll(c->PolicyCacheHits);
+    c->PolicyCacheMisses = htonll(c->PolicyCacheMisses);
+    c->PolicyReevalSkips = htonll(c->PolicyReevalSkips);
+    c->UnknownIPInserts = htonll(c->UnknownIPInserts);
+    c->UnknownIPEvicts = htonll(c->UnknownIPEvicts);
+    c->AsmBytes = htonll(c->AsmBytes);
+    c->AsmLimits = htonll(c->AsmLimits);
+    c->FragmentEvictions = htonll(c->FragmentEvictions);
+    for (j = 0; j < DP_LAT_HISTS; j ++) {
+        c->LatencySamples[j] = htonll(c->LatencySamples[j]);
+        c->LatencyP50[j] = htonll(c->LatencyP50[j]);
+        c->LatencyP99[j] = htonll(c->LatencyP99[j]);
+        c->LatencyMax[j] = htonll(c->LatencyMax[j]);
+    }
+    for (j = 0; j < DPI_PARSER_MAX; j ++) {
+        c->ParserCPUTime[j] = htonll(c->ParserCPUTime[j]);
+    }
+
+    dp_reclaim_stats_t rs;
+    dp_reclaim_stats(&rs);
+    c->ReclaimDepth = htonll(rs.depth);
+    c->ReclaimHighWater = htonll(rs.high_water);
+    c->ReclaimBatches = htonll(rs.batches);
+    c->ReclaimFreed = htonll(rs.freed);
 
     dp_ctrl_send_binary(buf, sizeof(buf));
 
     return 0;
 }
 
-static int dp_ctrl_count_session(json_t *msg)
+uint32_t g_lat_sample;
+uint32_t g_lat_trace;
+
+// "sample" times one in this many packets of each dp thread, 0 turns timing off. The
+// histograms are kept, a new rate adds to them. With "trace", the stages of timed packets
+// are also kept as events for ctrl_dump_trace.
+static int dp_ctrl_set_latency(json_t *msg)
+{
+    json_t *sample_obj = json_object_get(msg, "sample");
+
+    if (sample_obj == NULL || json_integer_value(sample_obj) < 0) {
+        return -1;
+    }
+    uatomic_set(&g_lat_sample, json_integer_value(sample_obj));
+    uatomic_set(&g_lat_trace, json_boolean_value(json_object_get(msg, "trace")));
+
+    DEBUG_CTRL("sample=%u trace=%u\n", g_lat_sample, g_lat_trace);
+
+    return 0;
+}
+
+static int dp_ctrl_dump_trace(json_t *msg)
+{
+    return dpi_trace_dump(json_string_value(json_object_get(msg, "path")));
+}
+
+static void send_latency(uint8_t *end, int hists, bool more)
+{
+    DPMsgHdr *hdr = (DPMsgHdr *)g_notify_msg;
+    DPMsgLatencyHdr *lh = (DPMsgLatencyHdr *)(g_notify_msg + sizeof(*hdr));
+    uint16_t len = end - g_notify_msg;
+
+    hdr->Kind = DP_KIND_LATENCY;
+    hdr->Length = htons(len);
+    hdr->More = more;
+    lh->TscHz = htonll(lat_tsc_hz());
+    lh->Sample = htonl(g_lat_sample);
+    lh->Hists = htons(hists);
+    lh->Reserved = 0;
+    dp_ctrl_send_binary(g_notify_msg, len);
+}
+
+#define LATENCY_FIRST_HIST (g_notify_msg + sizeof(DPMsgHdr) + sizeof(DPMsgLatencyHdr))
+
+static int dp_ctrl_latency(json_t *msg)
+{
+    lat_hist_t hists[DP_LAT_HISTS];
+    uint8_t *ptr = LATENCY_FIRST_HIST;
+    int i, b, count = 0;
+
+    dpi_get_latency(hists);
+
+    for (i = 0; i < DP_LAT_HISTS; i ++) {
+        lat_hist_t *h = &hists[i];
+        DPMsgLatencyHist *mh;
+        int buckets = 0;
+
+        if (h->count == 0) {
+            continue;
+        }
+        for (b = 0; b < LAT_HIST_BUCKETS; b ++) {
+            buckets += h->buckets[b] != 0;
+        }
+        if (g_notify_msg + DP_MSG_SIZE - ptr <
+            sizeof(DPMsgLatencyHist) + sizeof(DPMsgLatencyBucket) * buckets) {
+            send_latency(ptr, count, true);
+            ptr = LATENCY_FIRST_HIST;
+            count = 0;
+        }
+
+        mh = (DPMsgLatencyHist *)ptr;
+        memset(mh, 0, sizeof(*mh));
+        mh->Hist = i;
+        mh->Buckets = htons(buckets);
+        mh->Count = htonll(h->count);
+        mh->Sum = htonll(h->sum);
+        mh->Max = htonll(h->max);
+        ptr += sizeof(*mh);
+
+        for (b = 0; b < LAT_HIST_BUCKETS; b ++) {
+            if (h->buckets[b] != 0) {
+                DPMsgLatencyBucket *mb = (DPMsgLatencyBucket *)ptr;
+
+                mb->Low = htonll(lat_hist_low(b));
+                mb->Count = htonll(h->buckets[b]);
+                ptr += sizeof(*mb);
+            }
+        }
+        count ++;
+    }
+
+    send_latency(ptr, count, false);
+    return 0;
+}
+
+typedef struct fwd_latency_msg_ {
+    uint8_t *ptr;
+    int ctxs;
+} fwd_latency_msg_t;
+
+static void send_fwd_latency(uint8_t *end, int ctxs, bool more)
+{
+    DPMsgHdr *hdr = (DPMsgHdr *)g_notify_msg;
+    DPMsgFwdLatencyHdr *fh = (DPMsgFwdLatencyHdr *)(g_notify_msg + sizeof(*hdr));
+    uint16_t len = end - g_notify_msg;
+
+    hdr->Kind = DP_KIND_FWD_LATENCY;
+    hdr->Length = htons(len);
+    hdr->More = more;
+    fh->Sample = htonl(g_lat_sample);
+    fh->Ctxs = htons(ctxs);
+    fh->Reserved = 0;
+    dp_ctrl_send_binary(g_notify_msg, len);
+}
+
+#define FWD_LATENCY_FIRST_CTX (g_notify_msg + sizeof(DPMsgHdr) + sizeof(DPMsgFwdLatencyHdr))
+
+static void add_fwd_latency(const char *iface, const lat_hist_t *h, void *arg)
+{
+    fwd_latency_msg_t *m = arg;
+    DPMsgFwdLatency *mf;
+    int b, buckets = 0;
+
+    for (b = 0; b < LAT_HIST_BUCKETS; b ++) {
+        buckets += h->buckets[b] != 0;
+    }
+    if (g_notify_msg + DP_MSG_SIZE - m->ptr <
+        sizeof(DPMsgFwdLatency) + sizeof(DPMsgLatencyBucket) * buckets) {
+        send_fwd_latency(m->ptr, m->ctxs, true);
+        m->ptr = FWD_LATENCY_FIRST_CTX;
+        m->ctxs = 0;
+    }
+
+    mf = (DPMsgFwdLatency *)m->ptr;
+    memset(mf, 0, sizeof(*mf));
+    strlcpy(mf->Iface, iface, sizeof(mf->Iface));
+    mf->Buckets = htons(buckets);
+    mf->Count = htonll(h->count);
+    mf->Sum = htonll(h->sum);
+    mf->Max = htonll(h->max);
+    m->ptr += sizeof(*mf);
+
+    for (b = 0; b < LAT_HIST_BUCKETS; b ++) {
+        if (h->buckets[b] != 0) {
+            DPMsgLatencyBucket *mb = (DPMsgLatencyBucket *)m->ptr;
+
+            mb->Low = htonll(lat_hist_low(b));
+            mb->Count = htonll(h->buckets[b]);
+            m->ptr += sizeof(*mb);
+        }
+    }
+    m->ctxs ++;
+}
+
+// Forwarding latency of the inline contexts, timed at the rate of ctrl_set_latency
+static int dp_ctrl_stats_fwd_latency(json_t *msg)
+{
+    fwd_latency_msg_t m;
+    int thr_id;
+
+    m.ptr = FWD_LATENCY_FIRST_CTX;
+    m.ctxs = 0;
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        dp_read_fwd_latency(thr_id, add_fwd_latency, &m);
+    }
+
+    send_fwd_latency(m.ptr, m.ctxs, false);
+    return 0;
+}
+
+uint32_t g_policy_hit_gen;
+static uint32_t g_policy_hit_since;
+
+static void send_policy_hits(uint8_t *end, int hits, uint64_t overflow, bool more)
+{
+    DPMsgHdr *hdr = (DPMsgHdr *)g_notify_msg;
+    DPMsgPolicyHitsHdr *ph = (DPMsgPolicyHitsHdr *)(g_notify_msg + sizeof(*hdr));
+    uint16_t len = end - g_notify_msg;
+
+    hdr->Kind = DP_KIND_POLICY_HITS;
+    hdr->Length = htons(len);
+    hdr->More = more;
+    ph->Since = htonl(g_policy_hit_since);
+    ph->Hits = htons(hits);
+    ph->Reserved = 0;
+    ph->Overflow = htonll(overflow);
+    dp_ctrl_send_binary(g_notify_msg, len);
+}
+
+#define POLICY_HITS_PER_MSG ((DP_MSG_SIZE - sizeof(DPMsgHdr) - sizeof(DPMsgPolicyHitsHdr)) / sizeof(DPMsgPolicyHit))
+
+// Sessions decided by each policy rule. With "reset", the counts start over once they are read.
+static int dp_ctrl_policy_hits(json_t *msg)
+{
+    DPMsgPolicyHit *hits, *mh;
+    uint64_t overflow;
+    int i, count, cnt = 0;
+
+    count = dpi_get_policy_hits(&hits, &overflow);
+    if (count < 0) {
+        return -1;
+    }
+
+    mh = (DPMsgPolicyHit *)(g_notify_msg + sizeof(DPMsgHdr) + sizeof(DPMsgPolicyHitsHdr));
+    for (i = 0; i < count; i ++) {
+        if (cnt == POLICY_HITS_PER_MSG) {
+            send_policy_hits((uint8_t *)&mh[cnt], cnt, overflow, true);
+            cnt = 0;
+        }
+        mh[cnt].ID = htonl(hits[i].ID);
+        mh[cnt].LastHit = htonl(hits[i].LastHit);
+        mh[cnt].Hits = htonll(hits[i].Hits);
+        cnt ++;
+    }
+    send_policy_hits((uint8_t *)&mh[cnt], cnt, overflow, false);
+    free(hits);
+
+    if (json_boolean_value(json_object_get(msg, "reset"))) {
+        g_policy_hit_since = get_current_time();
+        uatomic_inc(&g_policy_hit_gen);
+    }
+
+    DEBUG_CTRL("rules=%d overflow=%lu\n", count, overflow);
+    return 0;
+}
+
+// "mac" limits the capture to one endpoint, "filter" is a pcap filter expression. It stops
+// after "limit" packets or on ctrl_capture_stop, only one capture runs at a time.
+static int dp_ctrl_capture_start(json_t *msg)
+{
+    const char *mac_str = json_string_value(json_object_get(msg, "mac"));
+    io_capture_t cap;
+
+    memset(&cap, 0, sizeof(cap));
+    cap.path = json_string_value(json_object_get(msg, "path"));
+    cap.filter = json_string_value(json_object_get(msg, "filter"));
+    cap.snaplen = json_integer_value(json_object_get(msg, "snaplen"));
+    cap.limit = json_integer_value(json_object_get(msg, "limit"));
+    if (cap.path == NULL) {
+        return -1;
+    }
+    if (mac_str != NULL && ether_aton_r(mac_str, &cap.mac) == NULL) {
+        DEBUG_ERROR(DBG_CTRL, "invalid mac %s\n", mac_str);
+        return -1;
+    }
+
+    return dpi_capture_start(&cap);
+}
+
+static int dp_ctrl_capture_stop(json_t *msg)
+{
+    dpi_capture_stop();
+    return 0;
+}
+
+static int dp_ctrl_capture_status(json_t *msg)
+{
+    uint8_t buf[sizeof(DPMsgHdr) + sizeof(DPMsgCapture)];
+    DPMsgHdr *hdr = (DPMsgHdr *)buf;
+    DPMsgCapture *m = (DPMsgCapture *)(buf + sizeof(DPMsgHdr));
+
+    hdr->Kind = DP_KIND_CAPTURE;
+    hdr->Length = htons(sizeof(buf));
+    hdr->More = 0;
+
+    dpi_capture_status(m);
+    m->Limit = htonl(m->Limit);
+    m->Packets = htonll(m->Packets);
+    m->Bytes = htonll(m->Bytes);
+    m->Drops = htonll(m->Drops);
+
+    dp_ctrl_send_binary(buf, sizeof(buf));
+    return 0;
+}
+
+// The dp threads count in their last published snapshot, the other threads as they are
+static int dp_ctrl_mem_stats(json_t *msg)
+{
+    uint8_t buf[sizeof(DPMsgHdr) + sizeof(DPMsgMemStats)];
+    DPMsgHdr *hdr = (DPMsgHdr *)buf;
+    DPMsgMemStats *m = (DPMsgMemStats *)(buf + sizeof(DPMsgHdr));
+    int64_t bytes[DP_MEM_MAX];
+    uint64_t allocated, resident, arena = 0;
+    int i, j;
+
+    hdr->Kind = DP_KIND_MEM_STATS;
+    hdr->Length = htons(sizeof(buf));
+    hdr->More = 0;
+
+    mem_acct_row(MEM_ACCT_SHARED, bytes);
+    for (i = 0; i < g_dp_threads; i ++) {
+        io_counter_t c;
+
+        dpi_read_counter(i, &c);
+        for (j = 0; j < DP_MEM_MAX; j ++) {
+            bytes[j] += c.mem_bytes[j];
+        }
+        arena += dp_arena_bytes(i);
+    }
+    dp_arena_totals(&allocated, &resident);
+
+    m->Allocated = htonll(allocated);
+    m->Resident = htonll(resident);
+    m->ArenaBytes = htonll(arena);
+    for (j = 0; j < DP_MEM_MAX; j ++) {
+        m->Bytes[j] = htonll(bytes[j]);
+    }
+
+    dp_ctrl_send_binary(buf, sizeof(buf));
+    return 0;
+}
+
+static int dp_ctrl_count_session(json_t *msg)
 {
     uint8_t buf[sizeof(DPMsgHdr) + sizeof(DPMsgSessionCount)];
 
@@ -1223,13 +2023,86 @@ static int dp_ctrl_count_session(json_t *msg)
     return 0;
 }
 
+#define SESSION_LIST_CHUNK_MAX  4096
+#define SESSION_CURSOR_THREAD   40  // bits of the cursor below the thread id
+
+// Sessions of one dp thread from the cursor on, so no request holds all threads for a full dump
+static int dp_ctrl_list_session_chunk(json_t *msg, uint64_t cursor)
+{
+    uint8_t buf[sizeof(DPMsgHdr) + sizeof(DPMsgSessionHdr) + sizeof(DPMsgSessionCursor)];
+    int thr_id = cursor >> SESSION_CURSOR_THREAD;
+    uint64_t next = 0;
+    io_ctrl_cmd_t cmd;
+    const char *mac;
+    json_t *obj;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.req = CTRL_REQ_LIST_SESSION_CHUNK;
+    cmd.list.cursor = cursor & ((1ULL << SESSION_CURSOR_THREAD) - 1);
+    cmd.list.limit = json_integer_value(json_object_get(msg, "limit"));
+    if (cmd.list.limit == 0 || cmd.list.limit > SESSION_LIST_CHUNK_MAX) {
+        cmd.list.limit = SESSION_LIST_CHUNK_MAX;
+    }
+    mac = json_string_value(json_object_get(msg, "mac"));
+    if (mac != NULL && ether_aton_r(mac, &cmd.list.mac) != NULL) {
+        cmd.list.filters |= CTRL_SESSION_BY_MAC;
+    }
+    if ((obj = json_object_get(msg, "port")) != NULL) {
+        cmd.list.port = json_integer_value(obj);
+        cmd.list.filters |= CTRL_SESSION_BY_PORT;
+    }
+    if ((obj = json_object_get(msg, "app")) != NULL) {
+        cmd.list.app = json_integer_value(obj);
+        cmd.list.filters |= CTRL_SESSION_BY_APP;
+    }
+    if ((obj = json_object_get(msg, "action")) != NULL) {
+        cmd.list.action = json_integer_value(obj);
+        cmd.list.filters |= CTRL_SESSION_BY_ACTION;
+    }
+
+    if (thr_id < g_dp_threads) {
+        if (dp_data_wait_ctrl_cmd_thr(&cmd, thr_id, &next) != 0) {
+            DEBUG_ERROR(DBG_CTRL, "fail to list sessions, thread=%d\n", thr_id);
+            next = 0;
+        } else if (next == CTRL_SESSION_CURSOR_END) {
+            next = thr_id + 1 < g_dp_threads ? (uint64_t)(thr_id + 1) << SESSION_CURSOR_THREAD : 0;
+        } else {
+            next |= (uint64_t)thr_id << SESSION_CURSOR_THREAD;
+        }
+    }
+    DEBUG_CTRL("cursor=0x%lx next=0x%lx\n", cursor, next);
+
+    DPMsgHdr *hdr = (DPMsgHdr *)buf;
+    hdr->Kind = DP_KIND_SESSION_LIST;
+    hdr->Length = htons(sizeof(buf));
+    hdr->More = 0;
+
+    DPMsgSessionHdr *sh = (DPMsgSessionHdr *)(buf + sizeof(DPMsgHdr));
+    sh->Sessions = 0;
+    sh->Flags = 0;
+
+    DPMsgSessionCursor *sc = (DPMsgSessionCursor *)(sh + 1);
+    sc->Cursor = htonll(next);
+
+    dp_ctrl_send_binary(buf, sizeof(buf));
+
+    return 0;
+}
+
 static int dp_ctrl_list_session(json_t *msg)
 {
-    int thr_id;
-    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
-        dp_data_wait_ctrl_req_thr(CTRL_REQ_LIST_SESSION, thr_id);
+    io_ctrl_cmd_t cmd;
+    json_t *cursor_obj;
+
+    cursor_obj = json_object_get(msg, "cursor");
+    if (cursor_obj != NULL) {
+        return dp_ctrl_list_session_chunk(msg, json_integer_value(cursor_obj));
     }
 
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.req = CTRL_REQ_LIST_SESSION;
+    dp_data_wait_ctrl_cmd(&cmd);
+
     uint8_t buf[sizeof(DPMsgHdr) + sizeof(DPMsgSessionHdr)];
 
     DPMsgHdr *hdr = (DPMsgHdr *)buf;
@@ -1245,28 +2118,26 @@ static int dp_ctrl_list_session(json_t *msg)
     return 0;
 }
 
-uint32_t g_sess_id_to_clear = 0;
-
 static int dp_ctrl_clear_session(json_t *msg)
 {
-    g_sess_id_to_clear = json_integer_value(json_object_get(msg, "filter_id"));
-    DEBUG_CTRL("clear session %d\n", g_sess_id_to_clear);
+    io_ctrl_cmd_t cmd;
 
-    int thr_id;
-    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
-        dp_data_wait_ctrl_req_thr(CTRL_REQ_CLEAR_SESSION, thr_id);
-    }
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.req = CTRL_REQ_CLEAR_SESSION;
+    cmd.sess_id = json_integer_value(json_object_get(msg, "filter_id"));
+    DEBUG_CTRL("clear session %d\n", cmd.sess_id);
 
-    g_sess_id_to_clear = 0;
+    dp_data_wait_ctrl_cmd(&cmd);
     return 0;
 }
 
 static int dp_ctrl_list_meter(json_t *msg)
 {
-    int thr_id;
-    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
-        dp_data_wait_ctrl_req_thr(CTRL_REQ_LIST_METER, thr_id);
-    }
+    io_ctrl_cmd_t cmd;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.req = CTRL_REQ_LIST_METER;
+    dp_data_wait_ctrl_cmd(&cmd);
 
     uint8_t buf[sizeof(DPMsgHdr) + sizeof(DPMsgMeterHdr)];
 
@@ -1298,9 +2169,35 @@ static int dp_ctrl_set_debug(json_t *msg)
         g_debug_levels = levels | DBG_DEFAULT;
     }
 
+    // Without the keys the filter is cleared
+    const char *mac_str = json_string_value(json_object_get(msg, "mac"));
+    const char *ip_str = json_string_value(json_object_get(msg, "ip"));
+    struct ether_addr mac;
+    struct in_addr ip;
+
+    if (mac_str == NULL || ether_aton_r(mac_str, &mac) == NULL) {
+        mac_str = NULL;
+    }
+    if (ip_str == NULL || inet_pton(AF_INET, ip_str, &ip) != 1) {
+        ip.s_addr = 0;
+    }
+    DEBUG_CTRL("mac=%s ip=%s\n", mac_str != NULL ? mac_str : "-", ip.s_addr != 0 ? ip_str : "-");
+    dpi_debug_set_filter(mac_str != NULL ? &mac : NULL, ip.s_addr);
+
     return 0;
 }
 
+// Taps on retired threads are moved to the active ones; fanout sockets and nfq queues
+// stay where they are.
+static int dp_ctrl_set_dp_threads(json_t *msg)
+{
+    int threads = json_integer_value(json_object_get(msg, "threads"));
+
+    DEBUG_CTRL("threads=%d\n", threads);
+
+    return dp_data_set_threads(threads);
+}
+
 /*
 static int dp_ctrl_get_debug(json_t *msg)
 {
@@ -1355,7 +2252,30 @@ static int dp_ctrl_get_debug(json_t *msg)
 */
 
 
-static int dp_ctrl_cfg_policy(json_t *msg)
+static void dp_ctrl_free_policy(dpi_policy_t *policy)
+{
+    int i;
+
+    free(policy->mac_list);
+    if (policy->rule_list) {
+        for (i = 0; i < policy->num_rules; i ++) {
+            if (policy->rule_list[i].app_rules)  {
+                free(policy->rule_list[i].app_rules);
+            }
+        }
+        free(policy->rule_list);
+    }
+    if (policy->rule6_list) {
+        for (i = 0; i < policy->num_rules6; i ++) {
+            free(policy->rule6_list[i].app_rules);
+        }
+        free(policy->rule6_list);
+    }
+    free(policy->del_ids);
+}
+
+// Also applied by the policy benchmark, dp -b
+int dp_ctrl_cfg_policy(json_t *msg)
 {
     int cmd;
     json_t *obj, *rule_obj, *app_obj, *app_rule_obj;
@@ -1368,6 +2288,10 @@ static int dp_ctrl_cfg_policy(json_t *msg)
     flag = json_integer_value(json_object_get(msg, "flag"));
     policy.def_action = json_integer_value(json_object_get(msg, "defact"));
     policy.apply_dir = json_integer_value(json_object_get(msg, "dir"));
+    policy.num_rules6 = 0;
+    policy.rule6_list = NULL;
+    policy.num_del_ids = 0;
+    policy.del_ids = NULL;
 
     obj = json_object_get(msg, "mac");
     policy.num_macs = json_array_size(obj);
@@ -1450,19 +2374,12 @@ static int dp_ctrl_cfg_policy(json_t *msg)
 
     dpi_policy_cfg(cmd, &policy, flag);
 cleanup:
-    free(policy.mac_list);
-    if (policy.rule_list) {
-        for (i = 0; i < policy.num_rules; i ++) {
-            if (policy.rule_list[i].app_rules)  {
-                free(policy.rule_list[i].app_rules);
-            }
-        }
-        free(policy.rule_list);
-    }
+    dp_ctrl_free_policy(&policy);
     return ret;
 }
 
-static int dp_ctrl_set_fqdn(json_t *msg)
+// Within rcu_read_lock
+static void dp_ctrl_cfg_fqdn_ips(json_t *msg)
 {
     int i, count;
     char fqdname[MAX_FQDN_LEN];
@@ -1480,14 +2397,38 @@ static int dp_ctrl_set_fqdn(json_t *msg)
     obj = json_object_get(msg, "fqdn_ips");
     count = json_array_size(obj);
 
-    rcu_read_lock();
     for (i = 0; i < count; i++) {
         fqdnip = inet_addr(json_string_value(json_array_get(obj, i)));
         //DEBUG_CTRL("fqdn(%s) vhost(%d) => "DBG_IPV4_FORMAT"\n", fqdname, vhost, DBG_IPV4_TUPLE(fqdnip));
         config_fqdn_ipv4_mapping(g_fqdn_hdl, fqdname, fqdnip, vhost);
     }
+}
+
+static int dp_ctrl_set_fqdn(json_t *msg)
+{
+    rcu_read_lock();
+    dp_ctrl_cfg_fqdn_ips(msg);
+    rcu_read_unlock();
+
+    return 0;
+}
+
+// Apply the ips of a batch of names in one request
+static int dp_ctrl_set_fqdns(json_t *msg)
+{
+    json_t *obj;
+    int i, count;
+
+    obj = json_object_get(msg, "fqdns");
+    count = json_array_size(obj);
+
+    rcu_read_lock();
+    for (i = 0; i < count; i++) {
+        dp_ctrl_cfg_fqdn_ips(json_array_get(obj, i));
+    }
     rcu_read_unlock();
 
+    DEBUG_CTRL("set ips of %d fqdns\n", count);
     return 0;
 }
 
@@ -1510,32 +2451,75 @@ static int dp_ctrl_del_fqdn(json_t *msg)
 io_internal_subnet4_t *g_internal_subnet4;
 io_internal_subnet4_t *g_policy_addr;
 
-//internal:true for internalSubnet, false for policy address map
-static int dp_ctrl_cfg_internal_net(json_t *msg, bool internal)
+// Bumped after a config the dp threads copy is changed, they copy it again on the next packet
+uint32_t g_dp_cfg_ver = 1;
+
+static void dp_ctrl_cfg_changed(void)
 {
-    int i, count;
-    json_t *obj, *nw_obj;
-    io_internal_subnet4_t *subnet4, *old, *tsubnet4;
-    static io_internal_subnet4_t *t_internal_subnet4 = NULL;
-    int flag;
-    bool multiple_msg = false;
+    cmm_smp_wmb();
+    CMM_STORE_SHARED(g_dp_cfg_ver, g_dp_cfg_ver + 1);
+}
 
-    flag = json_integer_value(json_object_get(msg, "flag"));
-    obj = json_object_get(msg, "subnet_addr");
-    count = json_array_size(obj);
+// Compile the list for the packet path. If it fails, the lookups scan the list.
+static void dp_ctrl_compile_internal_net(io_internal_subnet4_t *subnet4, bool internal)
+{
+    int i;
 
-    subnet4 = calloc(sizeof(io_internal_subnet4_t) + count * sizeof(io_subnet4_t), 1);
-    if (!subnet4) {
-        DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
-        return -1;
+    if (internal) {
+        subnet4->lpm = ip4_lpm_create();
+        for (i = 0; subnet4->lpm != NULL && i < subnet4->count; i++) {
+            if (ip4_lpm_add(subnet4->lpm, subnet4->list[i].ip, subnet4->list[i].mask, i) < 0) {
+                ip4_lpm_free(subnet4->lpm);
+                subnet4->lpm = NULL;
+            }
+        }
+        if (subnet4->lpm == NULL) {
+            DEBUG_ERROR(DBG_CTRL, "fail to compile internal subnets, count=%d\n", subnet4->count);
+        }
+    } else {
+        subnet4->set = ip4_set_create(subnet4->count);
+        for (i = 0; subnet4->set != NULL && i < subnet4->count; i++) {
+            if (ip4_set_add(subnet4->set, subnet4->list[i].ip) < 0) {
+                ip4_set_free(subnet4->set);
+                subnet4->set = NULL;
+            }
+        }
+        if (subnet4->set == NULL) {
+            DEBUG_ERROR(DBG_CTRL, "fail to compile policy addresses, count=%d\n", subnet4->count);
+        }
     }
+}
 
-    subnet4->count = count;
-    for (i = 0; i < count; i++) {
-        nw_obj = json_array_get(obj, i);
-        subnet4->list[i].ip = inet_addr(json_string_value(json_object_get(nw_obj, "ip")));
-        subnet4->list[i].mask = inet_addr(json_string_value(json_object_get(nw_obj, "mask")));
+static void dp_ctrl_free_internal_net(io_internal_subnet4_t *subnet4)
+{
+    if (subnet4 != NULL) {
+        ip4_lpm_free(subnet4->lpm);
+        ip4_set_free(subnet4->set);
+        free(subnet4);
     }
+}
+
+// Reclaimed after the grace period. Decisions cached by the dp threads until then might
+// be from the old subnets.
+static void dp_ctrl_reclaim_internal_net(void *ptr)
+{
+    dpi_policy_cache_invalidate();
+    dp_ctrl_free_internal_net(ptr);
+}
+
+static void dp_ctrl_reclaim_policy_addr(void *ptr)
+{
+    dp_ctrl_free_internal_net(ptr);
+}
+
+//internal:true for internalSubnet, false for policy address map
+// subnet4 is taken over by the function.
+static int dp_ctrl_apply_internal_net(io_internal_subnet4_t *subnet4, int flag, bool internal)
+{
+    io_internal_subnet4_t *old, *tsubnet4;
+    static io_internal_subnet4_t *t_internal_subnet4 = NULL;
+    int count = subnet4->count;
+    bool multiple_msg = false;
 
     if (flag & MSG_START) {
         //static pointer to remember allocated memory address
@@ -1568,34 +2552,70 @@ static int dp_ctrl_cfg_internal_net(json_t *msg, bool internal)
         return 0;
     }
 
+    if (multiple_msg) {
+        subnet4 = tsubnet4;
+    }
+    t_internal_subnet4 = NULL;
+    dp_ctrl_compile_internal_net(subnet4, internal);
+
     if (internal) {
         old = g_internal_subnet4;
+        g_internal_subnet4 = subnet4;
     } else {
         old = g_policy_addr;
+        g_policy_addr = subnet4;
     }
-    if (multiple_msg) {
-        if (internal) {
-            g_internal_subnet4 = tsubnet4;
-        } else {
-            g_policy_addr = tsubnet4;
-        }
-    } else {
-        if (internal) {
-            g_internal_subnet4 = subnet4;
-        } else {
-            g_policy_addr = subnet4;
-        }
+    dp_ctrl_cfg_changed();
+
+    if (internal) {
+        dp_reclaim_defer(dp_ctrl_reclaim_internal_net, old);
+    } else {
+        dp_reclaim_defer(dp_ctrl_reclaim_policy_addr, old);
     }
 
-    synchronize_rcu();
+    return 0;
+}
 
-    free(old);
+static int dp_ctrl_cfg_internal_net(json_t *msg, bool internal)
+{
+    int i, count;
+    json_t *obj, *nw_obj;
+    io_internal_subnet4_t *subnet4;
+    int flag;
 
-    return 0;
+    flag = json_integer_value(json_object_get(msg, "flag"));
+    obj = json_object_get(msg, "subnet_addr");
+    count = json_array_size(obj);
+
+    subnet4 = calloc(sizeof(io_internal_subnet4_t) + count * sizeof(io_subnet4_t), 1);
+    if (!subnet4) {
+        DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
+        return -1;
+    }
+
+    subnet4->count = count;
+    for (i = 0; i < count; i++) {
+        nw_obj = json_array_get(obj, i);
+        subnet4->list[i].ip = inet_addr(json_string_value(json_object_get(nw_obj, "ip")));
+        subnet4->list[i].mask = inet_addr(json_string_value(json_object_get(nw_obj, "mask")));
+    }
+
+    return dp_ctrl_apply_internal_net(subnet4, flag, internal);
 }
 
 io_spec_internal_subnet4_t *g_specialip_subnet4;
 
+static void dp_ctrl_reclaim_specialip_net(void *ptr)
+{
+    io_spec_internal_subnet4_t *subnet4 = ptr;
+
+    dpi_policy_cache_invalidate();
+    if (subnet4 != NULL) {
+        ip4_lpm_free(subnet4->lpm);
+        free(subnet4);
+    }
+}
+
 static int dp_ctrl_cfg_specialip_net(json_t *msg)
 {
     int i, count;
@@ -1666,16 +2686,28 @@ static int dp_ctrl_cfg_specialip_net(json_t *msg)
         return 0;
     }
 
-    old = g_specialip_subnet4;
     if (multiple_msg) {
-        g_specialip_subnet4 = tsubnet4;
-    } else {
-        g_specialip_subnet4 = subnet4;
+        subnet4 = tsubnet4;
+    }
+    t_specialip_subnet4 = NULL;
+
+    // Compile for the packet path, the lookup scans the list if it fails
+    subnet4->lpm = ip4_lpm_create();
+    for (i = 0; subnet4->lpm != NULL && i < subnet4->count; i++) {
+        if (ip4_lpm_add(subnet4->lpm, subnet4->list[i].ip, subnet4->list[i].mask, i) < 0) {
+            ip4_lpm_free(subnet4->lpm);
+            subnet4->lpm = NULL;
+        }
+    }
+    if (subnet4->lpm == NULL) {
+        DEBUG_ERROR(DBG_CTRL, "fail to compile special ip subnets, count=%d\n", subnet4->count);
     }
 
-    synchronize_rcu();
+    old = g_specialip_subnet4;
+    g_specialip_subnet4 = subnet4;
+    dp_ctrl_cfg_changed();
 
-    free(old);
+    dp_reclaim_defer(dp_ctrl_reclaim_specialip_net, old);
 
     return 0;
 }
@@ -1777,36 +2809,12 @@ static int dp_ctrl_del_dlp(json_t *msg)
     if ( cnt > 0 || cnt1 > 0 || cnt2 >0 || cnt3 > 0 ) {
         synchronize_rcu();
         for (i = 0; i < cnt; i++) {
-            io_dlp_cfg_t *dlp_cfg_ptr = STRUCT_OF(dlpcfg_node_list[i], io_dlp_cfg_t, node);
-            if (dlp_cfg_ptr->sig_user_list.prev == NULL && dlp_cfg_ptr->sig_user_list.next == NULL) {
-                CDS_INIT_LIST_HEAD(&dlp_cfg_ptr->sig_user_list);
-            }
-            dpi_sig_user_link_t *sig_user_itr, *sig_user_next;
-            cds_list_for_each_entry_safe(sig_user_itr, sig_user_next, &dlp_cfg_ptr->sig_user_list, node) {
-                cds_list_del((struct cds_list_head *)sig_user_itr);
-                if (sig_user_itr->sig_user) {
-                    free(sig_user_itr->sig_user);
-                }
-                free(sig_user_itr);
-            }
             free(dlpcfg_node_list[i]);
         }
         for (i = 0; i < cnt1; i++) {
             free(dlprid_node_list[i]);
         }
         for (i = 0; i < cnt2; i++) {
-            io_dlp_cfg_t *waf_cfg_ptr = STRUCT_OF(wafcfg_node_list[i], io_dlp_cfg_t, node);
-            if (waf_cfg_ptr->sig_user_list.prev == NULL && waf_cfg_ptr->sig_user_list.next == NULL) {
-                CDS_INIT_LIST_HEAD(&waf_cfg_ptr->sig_user_list);
-            }
-            dpi_sig_user_link_t *sig_user_itr, *sig_user_next;
-            cds_list_for_each_entry_safe(sig_user_itr, sig_user_next, &waf_cfg_ptr->sig_user_list, node) {
-                cds_list_del((struct cds_list_head *)sig_user_itr);
-                if (sig_user_itr->sig_user) {
-                    free(sig_user_itr->sig_user);
-                }
-                free(sig_user_itr);
-            }
             free(wafcfg_node_list[i]);
         }
         for (i = 0; i < cnt3; i++) {
@@ -1816,10 +2824,40 @@ static int dp_ctrl_del_dlp(json_t *msg)
     return 0;
 }
 
-static int dp_ctrl_cfg_dlp(json_t *msg)
+typedef struct dp_dlp_setting_ {
+    uint32_t id;
+    uint8_t action;
+} dp_dlp_setting_t;
+
+// Decoded ctrl_cfg_dlp, a NULL list is not configured
+typedef struct dp_dlp_cfg_ {
+    int flag;
+    bool dlp_inside;
+    bool waf_inside;
+    int num_macs;
+    struct ether_addr *macs;
+    int num_rule_ids;
+    uint32_t *rule_ids;
+    int num_waf_rule_ids;
+    uint32_t *waf_rule_ids;
+    int num_dlp_rules;
+    dp_dlp_setting_t *dlp_rules;
+    int num_waf_rules;
+    dp_dlp_setting_t *waf_rules;
+} dp_dlp_cfg_t;
+
+static void dp_ctrl_free_dlp_cfg(dp_dlp_cfg_t *cfg)
 {
-    json_t *obj, *dlp_rulename_obj, *rule_ids_obj, *waf_rulename_obj, *waf_rule_ids_obj;
-    int len, i;
+    free(cfg->macs);
+    free(cfg->rule_ids);
+    free(cfg->waf_rule_ids);
+    free(cfg->dlp_rules);
+    free(cfg->waf_rules);
+}
+
+static int dp_ctrl_apply_dlp_cfg(dp_dlp_cfg_t *cfg)
+{
+    int i;
     struct cds_lfht_node *dlpcfg_node_list[MAX_DLPCFG_DELETE];
     struct cds_lfht_node *wafcfg_node_list[MAX_DLPCFG_DELETE];
     struct cds_lfht_node *dlprid_node_list[MAX_DLPCFG_DELETE];
@@ -1828,53 +2866,28 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
     int cnt1 = 0;
     int cnt2 = 0;
     int cnt3 = 0;
-    int flag;
-    const char *ruletype = json_string_value(json_object_get(msg, "ruletype"));
-    const char *wafruletype = json_string_value(json_object_get(msg, "wafruletype"));
-    bool inside_rule = false;
-    bool wafinside_rule = false;
-
-    if ( strcmp(ruletype, DLP_RULETYPE_INSIDE) == 0 ) {
-        inside_rule = true;
-    } else if ( strcmp(ruletype, DLP_RULETYPE_OUTSIDE) == 0 ) {
-        inside_rule = false;
-    }
-    if ( strcmp(wafruletype, WAF_RULETYPE_INSIDE) == 0 ) {
-        wafinside_rule = true;
-    } else if ( strcmp(wafruletype, WAF_RULETYPE_OUTSIDE) == 0 ) {
-        wafinside_rule = false;
-    } 
-    DEBUG_CTRL("ruletype %s, wafruletype %s, inside_rule %d, wafinside_rule %d\n", ruletype, wafruletype, inside_rule, wafinside_rule);
-
-    obj = json_object_get(msg, "mac");
-    flag = json_integer_value(json_object_get(msg, "flag"));
-    dlp_rulename_obj = json_object_get(msg, "dlp_rule_names");
-    waf_rulename_obj = json_object_get(msg, "waf_rule_names");
-    rule_ids_obj = json_object_get(msg, "rule_ids");
-    waf_rule_ids_obj = json_object_get(msg, "waf_rule_ids");
 
-    len = json_array_size(obj);
-    if (len == 0) {
+    if (cfg->num_macs == 0) {
         DEBUG_ERROR(DBG_CTRL, "Missing mac address in dlp cfg rulenames!!\n");
         return -1;
     }
 
     rcu_read_lock();
-    for (i = 0; i < len; i ++) {
-        struct ether_addr mac_addr;
-        const char *mac_str = json_string_value(json_array_get(obj, i));
-        ether_aton_r(mac_str, &mac_addr);
-        io_mac_t *mac = rcu_map_lookup(&g_ep_map, &mac_addr);
+    for (i = 0; i < cfg->num_macs; i ++) {
+        char mac_str[32];
+        ether_ntoa_r(&cfg->macs[i], mac_str);
+        io_mac_t *mac = rcu_map_lookup(&g_ep_map, &cfg->macs[i]);
         if (mac == NULL) {
             DEBUG_ERROR(DBG_CTRL, "dlp cfg mac %s not found in ep map.\n", mac_str);
             continue;
         }
 
         io_ep_t *ep = mac->ep;
-        ep->dlp_inside = inside_rule;
-        ep->waf_inside = wafinside_rule;
+        ep->dlp_inside = cfg->dlp_inside;
+        ep->waf_inside = cfg->waf_inside;
+        ep->inspect_ver ++;
         // policy ids/connection to be exempt of dlp check
-        if ((flag & MSG_START) && rule_ids_obj != NULL) {
+        if ((cfg->flag & MSG_START) && cfg->rule_ids != NULL) {
             int k;
             struct cds_lfht_node *dlp_rid_node;
             //disalbe previous configured rids
@@ -1884,8 +2897,8 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
                     dlprid->enable = false;
                 }
             }
-            for (k = 0; k < json_array_size(rule_ids_obj); k++) {
-                uint32_t rid = json_integer_value(json_array_get(rule_ids_obj, k));
+            for (k = 0; k < cfg->num_rule_ids; k++) {
+                uint32_t rid = cfg->rule_ids[k];
                 io_dlp_ruleid_t ridkey;
                 ridkey.rid = rid;
 
@@ -1916,7 +2929,7 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
         }
 
         //waf
-        if ((flag & MSG_START) && waf_rule_ids_obj != NULL) {
+        if ((cfg->flag & MSG_START) && cfg->waf_rule_ids != NULL) {
             int k;
             struct cds_lfht_node *waf_rid_node;
             //disalbe previous configured rids
@@ -1926,8 +2939,8 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
                     wafrid->enable = false;
                 }
             }
-            for (k = 0; k < json_array_size(waf_rule_ids_obj); k++) {
-                uint32_t wafrid = json_integer_value(json_array_get(waf_rule_ids_obj, k));
+            for (k = 0; k < cfg->num_waf_rule_ids; k++) {
+                uint32_t wafrid = cfg->waf_rule_ids[k];
                 io_dlp_ruleid_t wafridkey;
                 wafridkey.rid = wafrid;
 
@@ -1958,10 +2971,10 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
         }
 
         // dlp rule names
-        if (dlp_rulename_obj != NULL) {
+        if (cfg->dlp_rules != NULL) {
             int j;
             struct cds_lfht_node *dlp_cfg_node;
-            if (flag & MSG_START) {
+            if (cfg->flag & MSG_START) {
                 RCU_MAP_FOR_EACH(&ep->dlp_cfg_map, dlp_cfg_node) {
                     io_dlp_cfg_t *dlpcfg = STRUCT_OF(dlp_cfg_node, io_dlp_cfg_t, node);
                     if (dlpcfg->enable) {
@@ -1969,11 +2982,10 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
                     }
                 }
             }
-            for (j = 0; j < json_array_size(dlp_rulename_obj); j++) {
-                json_t *dlprn = json_array_get(dlp_rulename_obj, j);
+            for (j = 0; j < cfg->num_dlp_rules; j++) {
                 io_dlp_cfg_t key;
-                key.sigid = json_integer_value(json_object_get(dlprn, "id"));
-                key.action = json_integer_value(json_object_get(dlprn, "action"));
+                key.sigid = cfg->dlp_rules[j].id;
+                key.action = cfg->dlp_rules[j].action;
 
                 io_dlp_cfg_t *dlp_cfg = rcu_map_lookup(&ep->dlp_cfg_map, &key);
                 if (dlp_cfg == NULL) {
@@ -1988,7 +3000,7 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
                     dlp_cfg->action = key.action;
                 }
             }
-            if (flag & MSG_END) {
+            if (cfg->flag & MSG_END) {
                 do {
                     RCU_MAP_FOR_EACH(&ep->dlp_cfg_map, dlp_cfg_node) {
                         io_dlp_cfg_t *dlp_conf = STRUCT_OF(dlp_cfg_node, io_dlp_cfg_t, node);
@@ -2005,10 +3017,10 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
         }
 
         // waf rule names
-        if (waf_rulename_obj != NULL) {
+        if (cfg->waf_rules != NULL) {
             int j;
             struct cds_lfht_node *waf_cfg_node;
-            if (flag & MSG_START) {
+            if (cfg->flag & MSG_START) {
                 RCU_MAP_FOR_EACH(&ep->waf_cfg_map, waf_cfg_node) {
                     io_dlp_cfg_t *wafcfg = STRUCT_OF(waf_cfg_node, io_dlp_cfg_t, node);
                     if (wafcfg->enable) {
@@ -2016,11 +3028,10 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
                     }
                 }
             }
-            for (j = 0; j < json_array_size(waf_rulename_obj); j++) {
-                json_t *wafrn = json_array_get(waf_rulename_obj, j);
+            for (j = 0; j < cfg->num_waf_rules; j++) {
                 io_dlp_cfg_t wafkey;
-                wafkey.sigid = json_integer_value(json_object_get(wafrn, "id"));
-                wafkey.action = json_integer_value(json_object_get(wafrn, "action"));
+                wafkey.sigid = cfg->waf_rules[j].id;
+                wafkey.action = cfg->waf_rules[j].action;
 
                 io_dlp_cfg_t *waf_cfg = rcu_map_lookup(&ep->waf_cfg_map, &wafkey);
                 if (waf_cfg == NULL) {
@@ -2035,7 +3046,7 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
                     waf_cfg->action = wafkey.action;
                 }
             }
-            if (flag & MSG_END) {
+            if (cfg->flag & MSG_END) {
                 do {
                     RCU_MAP_FOR_EACH(&ep->waf_cfg_map, waf_cfg_node) {
                         io_dlp_cfg_t *waf_conf = STRUCT_OF(waf_cfg_node, io_dlp_cfg_t, node);
@@ -2055,33 +3066,9 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
     if ( cnt > 0 || cnt1 > 0 || cnt2 >0 || cnt3 > 0 ) {
         synchronize_rcu();
         for (i = 0; i < cnt; i++) {
-            io_dlp_cfg_t *dlp_cfg_ptr = STRUCT_OF(dlpcfg_node_list[i], io_dlp_cfg_t, node);
-            if (dlp_cfg_ptr->sig_user_list.prev == NULL && dlp_cfg_ptr->sig_user_list.next == NULL) {
-                CDS_INIT_LIST_HEAD(&dlp_cfg_ptr->sig_user_list);
-            }
-            dpi_sig_user_link_t *sig_user_itr, *sig_user_next;
-            cds_list_for_each_entry_safe(sig_user_itr, sig_user_next, &dlp_cfg_ptr->sig_user_list, node) {
-                cds_list_del((struct cds_list_head *)sig_user_itr);
-                if (sig_user_itr->sig_user) {
-                    free(sig_user_itr->sig_user);
-                }
-                free(sig_user_itr);
-            }
             free(dlpcfg_node_list[i]);
         }
         for (i = 0; i < cnt3; i++) {
-            io_dlp_cfg_t *waf_cfg_ptr = STRUCT_OF(wafcfg_node_list[i], io_dlp_cfg_t, node);
-            if (waf_cfg_ptr->sig_user_list.prev == NULL && waf_cfg_ptr->sig_user_list.next == NULL) {
-                CDS_INIT_LIST_HEAD(&waf_cfg_ptr->sig_user_list);
-            }
-            dpi_sig_user_link_t *sig_user_itr, *sig_user_next;
-            cds_list_for_each_entry_safe(sig_user_itr, sig_user_next, &waf_cfg_ptr->sig_user_list, node) {
-                cds_list_del((struct cds_list_head *)sig_user_itr);
-                if (sig_user_itr->sig_user) {
-                    free(sig_user_itr->sig_user);
-                }
-                free(sig_user_itr);
-            }
             free(wafcfg_node_list[i]);
         }
         for (i = 0; i < cnt1; i++) {
@@ -2095,6 +3082,112 @@ static int dp_ctrl_cfg_dlp(json_t *msg)
     return 0;
 }
 
+static int dp_ctrl_json_dlp_settings(json_t *obj, dp_dlp_setting_t **list)
+{
+    int i, count = json_array_size(obj);
+
+    *list = calloc(count > 0 ? count : 1, sizeof(dp_dlp_setting_t));
+    if (*list == NULL) {
+        return -1;
+    }
+    for (i = 0; i < count; i ++) {
+        json_t *rn = json_array_get(obj, i);
+        (*list)[i].id = json_integer_value(json_object_get(rn, "id"));
+        (*list)[i].action = json_integer_value(json_object_get(rn, "action"));
+    }
+    return count;
+}
+
+static int dp_ctrl_json_rule_ids(json_t *obj, uint32_t **list)
+{
+    int i, count = json_array_size(obj);
+
+    *list = calloc(count > 0 ? count : 1, sizeof(uint32_t));
+    if (*list == NULL) {
+        return -1;
+    }
+    for (i = 0; i < count; i ++) {
+        (*list)[i] = json_integer_value(json_array_get(obj, i));
+    }
+    return count;
+}
+
+static int dp_ctrl_cfg_dlp(json_t *msg)
+{
+    json_t *obj, *dlp_rulename_obj, *rule_ids_obj, *waf_rulename_obj, *waf_rule_ids_obj;
+    dp_dlp_cfg_t cfg;
+    int i, ret;
+    const char *ruletype = json_string_value(json_object_get(msg, "ruletype"));
+    const char *wafruletype = json_string_value(json_object_get(msg, "wafruletype"));
+
+    memset(&cfg, 0, sizeof(cfg));
+    if ( strcmp(ruletype, DLP_RULETYPE_INSIDE) == 0 ) {
+        cfg.dlp_inside = true;
+    } else if ( strcmp(ruletype, DLP_RULETYPE_OUTSIDE) == 0 ) {
+        cfg.dlp_inside = false;
+    }
+    if ( strcmp(wafruletype, WAF_RULETYPE_INSIDE) == 0 ) {
+        cfg.waf_inside = true;
+    } else if ( strcmp(wafruletype, WAF_RULETYPE_OUTSIDE) == 0 ) {
+        cfg.waf_inside = false;
+    } 
+    DEBUG_CTRL("ruletype %s, wafruletype %s, inside_rule %d, wafinside_rule %d\n", ruletype, wafruletype, cfg.dlp_inside, cfg.waf_inside);
+
+    obj = json_object_get(msg, "mac");
+    cfg.flag = json_integer_value(json_object_get(msg, "flag"));
+    dlp_rulename_obj = json_object_get(msg, "dlp_rule_names");
+    waf_rulename_obj = json_object_get(msg, "waf_rule_names");
+    rule_ids_obj = json_object_get(msg, "rule_ids");
+    waf_rule_ids_obj = json_object_get(msg, "waf_rule_ids");
+
+    cfg.num_macs = json_array_size(obj);
+    if (cfg.num_macs == 0) {
+        DEBUG_ERROR(DBG_CTRL, "Missing mac address in dlp cfg rulenames!!\n");
+        return -1;
+    }
+    cfg.macs = calloc(cfg.num_macs, sizeof(struct ether_addr));
+    if (cfg.macs == NULL) {
+        DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
+        return -1;
+    }
+    for (i = 0; i < cfg.num_macs; i ++) {
+        ether_aton_r(json_string_value(json_array_get(obj, i)), &cfg.macs[i]);
+    }
+
+    if ((rule_ids_obj != NULL && (cfg.num_rule_ids = dp_ctrl_json_rule_ids(rule_ids_obj, &cfg.rule_ids)) < 0) ||
+        (waf_rule_ids_obj != NULL && (cfg.num_waf_rule_ids = dp_ctrl_json_rule_ids(waf_rule_ids_obj, &cfg.waf_rule_ids)) < 0) ||
+        (dlp_rulename_obj != NULL && (cfg.num_dlp_rules = dp_ctrl_json_dlp_settings(dlp_rulename_obj, &cfg.dlp_rules)) < 0) ||
+        (waf_rulename_obj != NULL && (cfg.num_waf_rules = dp_ctrl_json_dlp_settings(waf_rulename_obj, &cfg.waf_rules)) < 0)) {
+        DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
+        dp_ctrl_free_dlp_cfg(&cfg);
+        return -1;
+    }
+
+    ret = dp_ctrl_apply_dlp_cfg(&cfg);
+    dp_ctrl_free_dlp_cfg(&cfg);
+    return ret;
+}
+
+static void dp_ctrl_free_dlpbld(dpi_dlpbld_t *dlpbld)
+{
+    int i;
+
+    if (dlpbld->mac_list){
+        free(dlpbld->mac_list);
+    }
+    if (dlpbld->del_mac_list){
+        free(dlpbld->del_mac_list);
+    }
+    for (i = 0; i < dlpbld->num_dlp_rules; i ++) {
+        if (dlpbld->dlp_rule_list[i].dlp_rule_pat_list){
+            free(dlpbld->dlp_rule_list[i].dlp_rule_pat_list);
+        }
+    }
+    if (dlpbld->dlp_rule_list) {
+        free(dlpbld->dlp_rule_list);
+    }
+}
+
 static int dp_ctrl_bld_dlp(json_t *msg)
 {
     int flag;
@@ -2190,20 +3283,7 @@ static int dp_ctrl_bld_dlp(json_t *msg)
 
     dpi_sig_bld(&dlpbld, flag);
 dlpcleanup:
-    if (dlpbld.mac_list){
-        free(dlpbld.mac_list);
-    }
-    if (dlpbld.del_mac_list){
-        free(dlpbld.del_mac_list);
-    }
-    for (i = 0; i < dlpbld.num_dlp_rules; i ++) {
-        if (dlpbld.dlp_rule_list[i].dlp_rule_pat_list){
-            free(dlpbld.dlp_rule_list[i].dlp_rule_pat_list);
-        }
-    }
-    if (dlpbld.dlp_rule_list) {
-        free(dlpbld.dlp_rule_list);
-    }
+    dp_ctrl_free_dlpbld(&dlpbld);
     return ret;
 }
 
@@ -2290,10 +3370,14 @@ static int dp_ctrl_bld_dlp_update_ep(json_t *msg)
 
 //to avoid false positive implicit violation, set g_xff_enabled default to 0
 uint8_t g_xff_enabled = 0;
+// TLS sessions are given up after the ServerHello unless certificates are inspected
+uint8_t g_ssl_cert_inspect = 0;
+uint32_t g_http_body_scan = 64 * 1024;  // bytes of a request body matched by the parser
+uint32_t g_dlp_scan_budget = 0;         // KB of a session matched by DLP, 0 for all
 
 static int dp_ctrl_sys_conf(json_t *msg)
 {
-    json_t *xff_enabled_obj;
+    json_t *xff_enabled_obj, *cert_obj, *body_scan_obj, *dlp_budget_obj;
     bool xffenabled = false;
 
     xff_enabled_obj = json_object_get(msg, "xff_enabled");
@@ -2301,8 +3385,67 @@ static int dp_ctrl_sys_conf(json_t *msg)
         xffenabled = json_boolean_value(xff_enabled_obj);
     }
     g_xff_enabled = xffenabled ? 1 : 0;
+    // Optional, kept as is when not in the message
+    cert_obj = json_object_get(msg, "ssl_cert_inspect");
+    if (cert_obj != NULL) {
+        g_ssl_cert_inspect = json_boolean_value(cert_obj) ? 1 : 0;
+    }
+    body_scan_obj = json_object_get(msg, "http_body_scan");
+    if (body_scan_obj != NULL && json_integer_value(body_scan_obj) >= 0) {
+        uatomic_set(&g_http_body_scan, (uint32_t)json_integer_value(body_scan_obj));
+    }
+    dlp_budget_obj = json_object_get(msg, "dlp_scan_budget");
+    if (dlp_budget_obj != NULL && json_integer_value(dlp_budget_obj) >= 0) {
+        uatomic_set(&g_dlp_scan_budget, (uint32_t)json_integer_value(dlp_budget_obj));
+    }
+    dp_ctrl_cfg_changed();
+
+    DEBUG_CTRL("g_xff_enabled=%u g_ssl_cert_inspect=%u g_http_body_scan=%u g_dlp_scan_budget=%u\n",
+               g_xff_enabled, g_ssl_cert_inspect, g_http_body_scan, g_dlp_scan_budget);
+
+    return 0;
+}
 
-    DEBUG_CTRL("g_xff_enabled=%u\n", g_xff_enabled);
+static uint8_t g_conn_compact;   // report connections as DP_KIND_CONNECTION_COMPACT
+
+// "window" is the connection aggregation period in seconds, a longer one sends fewer,
+// bigger entries. Both keys are optional.
+static int dp_ctrl_connect_report_conf(json_t *msg)
+{
+    json_t *window_obj, *compact_obj;
+
+    window_obj = json_object_get(msg, "window");
+    if (window_obj != NULL && json_integer_value(window_obj) > 0) {
+        dp_ctrl_set_timer_period("connects", json_integer_value(window_obj));
+    }
+    compact_obj = json_object_get(msg, "compact");
+    if (compact_obj != NULL) {
+        g_conn_compact = json_boolean_value(compact_obj) ? 1 : 0;
+    }
+
+    DEBUG_CTRL("window=%lld compact=%u\n",
+               window_obj != NULL ? json_integer_value(window_obj) : 0, g_conn_compact);
+
+    return 0;
+}
+
+uint32_t g_log_limit_rate = 6;
+uint32_t g_log_limit_burst = 10;
+
+// Threat logs of a threat, endpoint and peer, "rate" a minute after a "burst", 0 for all
+static int dp_ctrl_set_threat_log_limit(json_t *msg)
+{
+    json_t *rate_obj = json_object_get(msg, "rate"), *burst_obj = json_object_get(msg, "burst");
+
+    if (rate_obj == NULL || json_integer_value(rate_obj) < 0) {
+        return -1;
+    }
+    if (burst_obj != NULL && json_integer_value(burst_obj) > 0) {
+        uatomic_set(&g_log_limit_burst, json_integer_value(burst_obj));
+    }
+    uatomic_set(&g_log_limit_rate, json_integer_value(rate_obj));
+
+    DEBUG_CTRL("rate=%u burst=%u\n", g_log_limit_rate, g_log_limit_burst);
 
     return 0;
 }
@@ -2319,6 +3462,7 @@ static int dp_ctrl_disable_net_policy(json_t *msg)
         disable_net_policy = json_boolean_value(disable_net_policy_obj);
     }
     g_disable_net_policy = disable_net_policy ? 1 : 0;
+    dp_ctrl_cfg_changed();
 
     DEBUG_CTRL("g_disable_net_policy=%u\n", g_disable_net_policy);
 
@@ -2337,6 +3481,9 @@ static int dp_ctrl_detect_unmanaged_wl(json_t *msg)
         detect_unmanaged_wl = json_boolean_value(detect_unmanaged_wl_obj);
     }
     g_detect_unmanaged_wl = detect_unmanaged_wl ? 1 : 0;
+    dp_ctrl_cfg_changed();
+    synchronize_rcu();
+    dpi_policy_cache_invalidate();
 
     DEBUG_CTRL("g_detect_unmanaged_wl=%u\n", g_detect_unmanaged_wl);
 
@@ -2344,6 +3491,7 @@ static int dp_ctrl_detect_unmanaged_wl(json_t *msg)
 }
 
 uint8_t g_enable_icmp_policy = 0;
+uint8_t g_icmp_sample = 1; // see dpi_icmp_tunneling_check(), cleared by the replay benchmark
 
 static int dp_ctrl_enable_icmp_policy(json_t *msg)
 {
@@ -2373,87 +3521,716 @@ static int dp_ctrl_strict_group_mode(json_t *msg)
         strict_group_mode = json_boolean_value(strict_group_mode_obj);
     }
     g_strict_group_mode = strict_group_mode ? 1 : 0;
+    synchronize_rcu();
+    dpi_policy_cache_invalidate();
 
     DEBUG_CTRL("g_strict_group_mode=%u\n", g_strict_group_mode);
 
     return 0;
 }
 
-#define BUF_SIZE 8192
-char ctrl_msg_buf[BUF_SIZE];
-static int dp_ctrl_handler(int fd)
+// -- binary control messages
+
+typedef struct dp_bin_reader_ {
+    uint8_t *ptr;
+    uint8_t *end;
+} dp_bin_reader_t;
+
+#define BIN_ALIGN(len) (((len) + 3) & ~3)
+
+static void *bin_get(dp_bin_reader_t *r, size_t len)
 {
-    socklen_t len;
-    int size, ret = 0;
+    uint8_t *p = r->ptr;
 
-    len = sizeof(struct sockaddr_un);
-    size = recvfrom(fd, ctrl_msg_buf, BUF_SIZE - 1, 0, (struct sockaddr *)&g_client_addr, &len);
-    ctrl_msg_buf[size] = '\0';
+    if (len > r->end - r->ptr) {
+        return NULL;
+    }
+    r->ptr += len;
+    return p;
+}
 
-    json_t *root;
-    json_error_t error;
+// dst is always NUL terminated, a string longer than the buffer is truncated.
+static int bin_get_string(dp_bin_reader_t *r, char *dst, size_t size)
+{
+    uint16_t *len;
+    uint8_t *str;
 
-    root = json_loads(ctrl_msg_buf, 0, &error);
-    if (root == NULL) {
-        DEBUG_ERROR(DBG_CTRL, "Invalid json format on line %d: %s\n", error.line, error.text);
+    if ((len = bin_get(r, sizeof(*len))) == NULL) {
+        return -1;
+    }
+    if ((str = bin_get(r, BIN_ALIGN(sizeof(*len) + ntohs(*len)) - sizeof(*len))) == NULL) {
         return -1;
     }
+    snprintf(dst, size, "%.*s", ntohs(*len), (char *)str);
+    return 0;
+}
 
-    const char *key;
-    json_t *msg;
+static int bin_get_macs(dp_bin_reader_t *r, int count, struct ether_addr **list)
+{
+    DPCtrlBinMAC *macs;
+    int i;
 
-    json_object_foreach(root, key, msg) {
-        if (strcmp(key, "ctrl_keep_alive") == 0) {
-            ret = dp_ctrl_keep_alive(msg);
-            continue;
-        }
-        char *data = NULL;
-        DEBUG_CTRL("\"%s\":%s\n", key, data=json_dumps(msg, JSON_ENSURE_ASCII));
-        //data needs to be freed otherwise there is memory leak
-        free(data);
+    *list = NULL;
+    if (count == 0) {
+        return 0;
+    }
+    if ((macs = bin_get(r, sizeof(*macs) * count)) == NULL) {
+        return -1;
+    }
+    if ((*list = calloc(count, sizeof(struct ether_addr))) == NULL) {
+        return -1;
+    }
+    for (i = 0; i < count; i ++) {
+        memcpy(&(*list)[i], macs[i].MAC, sizeof(struct ether_addr));
+    }
+    return 0;
+}
 
-        if (strcmp(key, "ctrl_add_srvc_port") == 0) {
-            ret = dp_ctrl_add_srvc_port(msg);
-        } else if (strcmp(key, "ctrl_del_srvc_port") == 0) {
-            ret = dp_ctrl_del_srvc_port(msg);
-        } else if (strcmp(key, "ctrl_add_port_pair") == 0) {
-            ret = dp_ctrl_add_port_pair(msg);
-        } else if (strcmp(key, "ctrl_del_port_pair") == 0) {
-            ret = dp_ctrl_del_port_pair(msg);
-        } else if (strcmp(key, "ctrl_add_tap_port") == 0) {
-            ret = dp_ctrl_add_tap_port(msg);
-        } else if (strcmp(key, "ctrl_del_tap_port") == 0) {
-            ret = dp_ctrl_del_tap_port(msg);
-        } else if (strcmp(key, "ctrl_add_nfq_port") == 0) {
-            ret = dp_ctrl_add_nfq_port(msg);
-        } else if (strcmp(key, "ctrl_del_nfq_port") == 0) {
-            ret = dp_ctrl_del_nfq_port(msg);
-        } else if (strcmp(key, "ctrl_add_mac") == 0) {
-            ret = dp_ctrl_add_mac(msg);
-        } else if (strcmp(key, "ctrl_del_mac") == 0) {
-            ret = dp_ctrl_del_mac(msg);
-        } else if (strcmp(key, "ctrl_cfg_mac") == 0) {
-            ret = dp_ctrl_cfg_mac(msg);
-        } else if (strcmp(key, "ctrl_cfg_nbe") == 0) {
-            ret = dp_ctrl_cfg_nbe(msg);
-        } else if (strcmp(key, "ctrl_refresh_app") == 0) {
-            ret = dp_ctrl_refresh_app(msg);
-        } else if (strcmp(key, "ctrl_stats_macs") == 0) {
-            ret = dp_ctrl_stats_macs(msg);
-        } else if (strcmp(key, "ctrl_stats_device") == 0) {
-            ret = dp_ctrl_stats_device(msg);
-        } else if (strcmp(key, "ctrl_counter_device") == 0) {
-            ret = dp_ctrl_counter_device(msg);
-        } else if (strcmp(key, "ctrl_count_session") == 0) {
-            ret = dp_ctrl_count_session(msg);
-        } else if (strcmp(key, "ctrl_list_session") == 0) {
-            ret = dp_ctrl_list_session(msg);
-        } else if (strcmp(key, "ctrl_clear_session") == 0) {
+static int bin_get_u32s(dp_bin_reader_t *r, int count, uint32_t **list)
+{
+    uint32_t *ids;
+    int i;
+
+    if ((ids = bin_get(r, sizeof(*ids) * count)) == NULL) {
+        return -1;
+    }
+    if ((*list = calloc(count > 0 ? count : 1, sizeof(uint32_t))) == NULL) {
+        return -1;
+    }
+    for (i = 0; i < count; i ++) {
+        (*list)[i] = ntohl(ids[i]);
+    }
+    return 0;
+}
+
+static int bin_get_dlp_settings(dp_bin_reader_t *r, int count, dp_dlp_setting_t **list)
+{
+    DPCtrlBinDlpSetting *settings;
+    int i;
+
+    if ((settings = bin_get(r, sizeof(*settings) * count)) == NULL) {
+        return -1;
+    }
+    if ((*list = calloc(count > 0 ? count : 1, sizeof(dp_dlp_setting_t))) == NULL) {
+        return -1;
+    }
+    for (i = 0; i < count; i ++) {
+        (*list)[i].id = ntohl(settings[i].ID);
+        (*list)[i].action = settings[i].Action;
+    }
+    return 0;
+}
+
+static int bin_get_policy_apps(dp_bin_reader_t *r, uint32_t count, dpi_policy_app_rule_t **list)
+{
+    DPCtrlBinPolicyApp *ba;
+    uint32_t i;
+
+    if (count == 0) {
+        return 0;
+    }
+    if ((ba = bin_get(r, sizeof(*ba) * count)) == NULL) {
+        return -1;
+    }
+    *list = calloc(count, sizeof(dpi_policy_app_rule_t));
+    if (*list == NULL) {
+        DEBUG_ERROR(DBG_CTRL, "out of memory!!\n");
+        return -1;
+    }
+    for (i = 0; i < count; i ++) {
+        (*list)[i].rule_id = ntohl(ba[i].RuleID);
+        (*list)[i].app = ntohl(ba[i].App);
+        (*list)[i].action = ba[i].Action;
+    }
+    return 0;
+}
+
+static int bin_get_policy_rules(dp_bin_reader_t *r, int count, dpi_policy_rule_t *list)
+{
+    int i;
+
+    for (i = 0; i < count; i ++) {
+        dpi_policy_rule_t *rule = &list[i];
+        DPCtrlBinPolicyRule *br;
+
+        if ((br = bin_get(r, sizeof(*br))) == NULL) {
+            return -1;
+        }
+        rule->id = ntohl(br->ID);
+        rule->sip = br->SIP;
+        rule->sip_r = br->SIPR;
+        rule->dip = br->DIP;
+        rule->dip_r = br->DIPR;
+        rule->dport = ntohs(br->Port);
+        rule->dport_r = ntohs(br->PortR);
+        rule->proto = br->Proto;
+        rule->action = br->Action;
+        rule->ingress = br->Ingress;
+        rule->vh = br->Vhost;
+        if (bin_get_string(r, rule->fqdn, MAX_FQDN_LEN) < 0) {
+            return -1;
+        }
+
+        rule->num_apps = ntohs(br->NumApps);
+        if (bin_get_policy_apps(r, rule->num_apps, &rule->app_rules) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int dp_ctrl_bin_cfg_policy(dp_bin_reader_t *r)
+{
+    DPCtrlBinPolicy *bp;
+    dpi_policy_t policy;
+    int i, ret = -1;
+
+    if ((bp = bin_get(r, sizeof(*bp))) == NULL) {
+        return -1;
+    }
+
+    memset(&policy, 0, sizeof(policy));
+    policy.def_action = bp->DefAction;
+    policy.apply_dir = bp->ApplyDir;
+    policy.num_macs = ntohs(bp->NumMACs);
+    policy.num_rules = ntohl(bp->NumRules);
+    policy.num_rules6 = ntohl(bp->NumRules6);
+    if (!policy.num_macs) {
+        DEBUG_ERROR(DBG_CTRL, "Missing mac address in policy cfg!!\n");
+        return -1;
+    }
+    if (bin_get_macs(r, policy.num_macs, &policy.mac_list) < 0) {
+        goto cleanup;
+    }
+    if (policy.num_rules) {
+        policy.rule_list = calloc(policy.num_rules, sizeof(dpi_policy_rule_t));
+        if (!policy.rule_list) {
+            DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
+            goto cleanup;
+        }
+    }
+    if (policy.num_rules6) {
+        policy.rule6_list = calloc(policy.num_rules6, sizeof(dpi_policy_rule6_t));
+        if (!policy.rule6_list) {
+            DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
+            goto cleanup;
+        }
+    }
+
+    if (bin_get_policy_rules(r, policy.num_rules, policy.rule_list) < 0) {
+        goto cleanup;
+    }
+
+    for (i = 0; i < policy.num_rules6; i ++) {
+        dpi_policy_rule6_t *rule = &policy.rule6_list[i];
+        DPCtrlBinPolicyRule6 *br;
+
+        if ((br = bin_get(r, sizeof(*br))) == NULL) {
+            goto cleanup;
+        }
+        rule->id = ntohl(br->ID);
+        memcpy(&rule->sip, br->SIP, sizeof(rule->sip));
+        memcpy(&rule->sip_r, br->SIPR, sizeof(rule->sip_r));
+        memcpy(&rule->dip, br->DIP, sizeof(rule->dip));
+        memcpy(&rule->dip_r, br->DIPR, sizeof(rule->dip_r));
+        rule->dport = ntohs(br->Port);
+        rule->dport_r = ntohs(br->PortR);
+        rule->proto = br->Proto;
+        rule->action = br->Action;
+        rule->ingress = br->Ingress;
+
+        rule->num_apps = ntohs(br->NumApps);
+        if (bin_get_policy_apps(r, rule->num_apps, &rule->app_rules) < 0) {
+            goto cleanup;
+        }
+    }
+
+    dpi_policy_cfg(ntohs(bp->Cmd), &policy, ntohs(bp->Flag));
+    ret = 0;
+cleanup:
+    dp_ctrl_free_policy(&policy);
+    return ret;
+}
+
+static int dp_ctrl_bin_cfg_policy_delta(dp_bin_reader_t *r)
+{
+    DPCtrlBinPolicyDelta *bd;
+    dpi_policy_t policy;
+    int ret = -1;
+
+    if ((bd = bin_get(r, sizeof(*bd))) == NULL) {
+        return -1;
+    }
+
+    memset(&policy, 0, sizeof(policy));
+    policy.num_macs = ntohs(bd->NumMACs);
+    policy.num_del_ids = ntohl(bd->NumDelRules);
+    policy.num_rules = ntohl(bd->NumRules);
+    if (!policy.num_macs) {
+        DEBUG_ERROR(DBG_CTRL, "Missing mac address in policy delta!!\n");
+        return -1;
+    }
+    if (bin_get_macs(r, policy.num_macs, &policy.mac_list) < 0 ||
+        bin_get_u32s(r, policy.num_del_ids, &policy.del_ids) < 0) {
+        goto cleanup;
+    }
+    if (policy.num_rules) {
+        policy.rule_list = calloc(policy.num_rules, sizeof(dpi_policy_rule_t));
+        if (!policy.rule_list) {
+            DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
+            goto cleanup;
+        }
+    }
+    if (bin_get_policy_rules(r, policy.num_rules, policy.rule_list) < 0) {
+        goto cleanup;
+    }
+
+    ret = dpi_policy_delta(&policy);
+cleanup:
+    dp_ctrl_free_policy(&policy);
+    return ret;
+}
+
+static int dp_ctrl_bin_cfg_internal_net(dp_bin_reader_t *r, bool internal)
+{
+    DPCtrlBinSubnetCfg *bc;
+    DPCtrlBinSubnet *bs;
+    io_internal_subnet4_t *subnet4;
+    int i, count;
+
+    if ((bc = bin_get(r, sizeof(*bc))) == NULL) {
+        return -1;
+    }
+    count = ntohl(bc->Count);
+    if ((bs = bin_get(r, sizeof(*bs) * count)) == NULL) {
+        return -1;
+    }
+
+    subnet4 = calloc(sizeof(io_internal_subnet4_t) + count * sizeof(io_subnet4_t), 1);
+    if (!subnet4) {
+        DEBUG_ERROR(DBG_CTRL, "out of memory!!\n")
+        return -1;
+    }
+
+    subnet4->count = count;
+    for (i = 0; i < count; i++) {
+        subnet4->list[i].ip = bs[i].IP;
+        subnet4->list[i].mask = bs[i].Mask;
+    }
+
+    return dp_ctrl_apply_internal_net(subnet4, ntohs(bc->Flag), internal);
+}
+
+static int dp_ctrl_bin_cfg_dlp(dp_bin_reader_t *r)
+{
+    DPCtrlBinDlpCfg *bc;
+    dp_dlp_cfg_t cfg;
+    uint16_t present;
+    int ret = -1;
+
+    if ((bc = bin_get(r, sizeof(*bc))) == NULL) {
+        return -1;
+    }
+
+    memset(&cfg, 0, sizeof(cfg));
+    present = ntohs(bc->Present);
+    cfg.flag = ntohs(bc->Flag);
+    cfg.dlp_inside = bc->DlpInside;
+    cfg.waf_inside = bc->WafInside;
+    cfg.num_macs = ntohs(bc->NumMACs);
+    cfg.num_rule_ids = ntohl(bc->NumRuleIDs);
+    cfg.num_waf_rule_ids = ntohl(bc->NumWafRuleIDs);
+    cfg.num_dlp_rules = ntohl(bc->NumDlpRules);
+    cfg.num_waf_rules = ntohl(bc->NumWafRules);
+
+    if (bin_get_macs(r, cfg.num_macs, &cfg.macs) < 0 ||
+        ((present & DP_CTRL_BIN_DLP_RULE_IDS) &&
+         bin_get_u32s(r, cfg.num_rule_ids, &cfg.rule_ids) < 0) ||
+        ((present & DP_CTRL_BIN_DLP_WAF_RULE_IDS) &&
+         bin_get_u32s(r, cfg.num_waf_rule_ids, &cfg.waf_rule_ids) < 0) ||
+        ((present & DP_CTRL_BIN_DLP_NAMES) &&
+         bin_get_dlp_settings(r, cfg.num_dlp_rules, &cfg.dlp_rules) < 0) ||
+        ((present & DP_CTRL_BIN_DLP_WAF_NAMES) &&
+         bin_get_dlp_settings(r, cfg.num_waf_rules, &cfg.waf_rules) < 0)) {
+        goto cleanup;
+    }
+
+    ret = dp_ctrl_apply_dlp_cfg(&cfg);
+cleanup:
+    dp_ctrl_free_dlp_cfg(&cfg);
+    return ret;
+}
+
+static int dp_ctrl_bin_bld_dlp(dp_bin_reader_t *r)
+{
+    DPCtrlBinDlpBuild *bb;
+    dpi_dlpbld_t dlpbld;
+    int i, j, ret = -1;
+
+    if ((bb = bin_get(r, sizeof(*bb))) == NULL) {
+        return -1;
+    }
+
+    memset(&dlpbld, 0, sizeof(dlpbld));
+    dlpbld.apply_dir = bb->ApplyDir;
+    dlpbld.num_macs = ntohl(bb->NumMACs);
+    dlpbld.num_del_macs = ntohl(bb->NumDelMACs);
+    if (bin_get_macs(r, dlpbld.num_macs, &dlpbld.mac_list) < 0 ||
+        bin_get_macs(r, dlpbld.num_del_macs, &dlpbld.del_mac_list) < 0) {
+        goto cleanup;
+    }
+
+    dlpbld.num_dlp_rules = ntohl(bb->NumRules);
+    DEBUG_CTRL("# of macs(%d) delete macs(%d) dlp rules(%d) bld dlp\n",
+               dlpbld.num_macs, dlpbld.num_del_macs, dlpbld.num_dlp_rules);
+    if (dlpbld.num_dlp_rules) {
+        dlpbld.dlp_rule_list = calloc(dlpbld.num_dlp_rules, sizeof(dpi_dlp_rule_entry_t));
+        if (!dlpbld.dlp_rule_list) {
+            DEBUG_ERROR(DBG_CTRL, "allocate dlpbld's dlp_rule_list out of memory!!\n")
+            dlpbld.num_dlp_rules = 0;
+            goto cleanup;
+        }
+    }
+
+    for (i = 0; i < dlpbld.num_dlp_rules; i ++) {
+        dpi_dlp_rule_entry_t *rule = &dlpbld.dlp_rule_list[i];
+        DPCtrlBinDlpRule *br;
+
+        if ((br = bin_get(r, sizeof(*br))) == NULL ||
+            bin_get_string(r, rule->rulename, MAX_DLP_RULE_NAME_LEN) < 0) {
+            goto cleanup;
+        }
+        rule->sigid = ntohl(br->ID);
+        rule->num_dlp_rule_pats = ntohs(br->NumPatterns);
+        if (rule->num_dlp_rule_pats == 0) {
+            continue;
+        }
+        rule->dlp_rule_pat_list = calloc(rule->num_dlp_rule_pats, sizeof(dpi_dlp_rule_pattern_t));
+        if (!rule->dlp_rule_pat_list) {
+            DEBUG_ERROR(DBG_CTRL, "allocate dlpbld's dlp_rule_list[%d]'s dlp_rule_pat_list out of memory!!\n", i)
+            goto cleanup;
+        }
+        for (j = 0; j < rule->num_dlp_rule_pats; j ++) {
+            if (bin_get_string(r, rule->dlp_rule_pat_list[j].rule_pattern, MAX_DLP_RULE_PATTERN_LEN) < 0) {
+                goto cleanup;
+            }
+        }
+    }
+
+    dpi_sig_bld(&dlpbld, ntohs(bb->Flag));
+    ret = 0;
+cleanup:
+    dp_ctrl_free_dlpbld(&dlpbld);
+    return ret;
+}
+
+// Key of a message that replaces the config of the older ones with the key, 0 if none: a
+// policy, DLP config or DLP build of a set of MACs, or the subnets, in one message.
+static uint64_t dp_ctrl_bin_snap_key(uint8_t kind, uint8_t *ptr, uint32_t len)
+{
+    dp_bin_reader_t r = {ptr, ptr + len};
+    uint32_t num_macs = 0;
+    uint16_t flag;
+    void *macs;
+
+    switch (kind) {
+    case DP_CTRL_BIN_CFG_POLICY:
+        {
+            DPCtrlBinPolicy *bp = bin_get(&r, sizeof(*bp));
+            if (bp == NULL) {
+                return 0;
+            }
+            flag = ntohs(bp->Flag);
+            num_macs = ntohs(bp->NumMACs);
+        }
+        break;
+    case DP_CTRL_BIN_CFG_INTERNAL_NET:
+    case DP_CTRL_BIN_CFG_POLICY_ADDR:
+        {
+            DPCtrlBinSubnetCfg *bc = bin_get(&r, sizeof(*bc));
+            if (bc == NULL) {
+                return 0;
+            }
+            flag = ntohs(bc->Flag);
+        }
+        break;
+    case DP_CTRL_BIN_CFG_DLP:
+        {
+            DPCtrlBinDlpCfg *bc = bin_get(&r, sizeof(*bc));
+            if (bc == NULL) {
+                return 0;
+            }
+            flag = ntohs(bc->Flag);
+            num_macs = ntohs(bc->NumMACs);
+        }
+        break;
+    case DP_CTRL_BIN_BLD_DLP:
+        {
+            DPCtrlBinDlpBuild *bb = bin_get(&r, sizeof(*bb));
+            if (bb == NULL) {
+                return 0;
+            }
+            flag = ntohs(bb->Flag);
+            num_macs = ntohl(bb->NumMACs);
+        }
+        break;
+    default:
+        return 0;
+    }
+
+    if ((flag & (MSG_START | MSG_END)) != (MSG_START | MSG_END) ||
+        (macs = bin_get(&r, sizeof(DPCtrlBinMAC) * num_macs)) == NULL) {
+        return 0;
+    }
+    return dp_snap_key(macs, sizeof(DPCtrlBinMAC) * num_macs, kind);
+}
+
+// fd is the memfd passed with the message, -1 if none.
+static int dp_ctrl_bin_handler(uint8_t *msg, int size, int fd)
+{
+    DPCtrlBinHdr *hdr = (DPCtrlBinHdr *)msg, snap_hdr;
+    dp_bin_reader_t r;
+    uint8_t *payload;
+    uint32_t len;
+    void *map = NULL;
+    int ret;
+
+    if (size < sizeof(*hdr)) {
+        DEBUG_ERROR(DBG_CTRL, "Short binary message, size=%d\n", size);
+        return -1;
+    }
+
+    len = ntohl(hdr->Length);
+    if (ntohs(hdr->Flags) & DP_CTRL_BIN_FLAG_MEMFD) {
+        if (fd < 0) {
+            DEBUG_ERROR(DBG_CTRL, "Missing memfd, kind=%u\n", hdr->Kind);
+            return -1;
+        }
+        map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            DEBUG_ERROR(DBG_CTRL, "Fail to map memfd, len=%u: %s\n", len, strerror(errno));
+            return -1;
+        }
+        r.ptr = map;
+    } else {
+        if (len > size - sizeof(*hdr)) {
+            DEBUG_ERROR(DBG_CTRL, "Truncated binary message, len=%u size=%d\n", len, size);
+            return -1;
+        }
+        r.ptr = msg + sizeof(*hdr);
+    }
+    r.end = r.ptr + len;
+
+    DEBUG_CTRL("binary kind=%u len=%u memfd=%d\n", hdr->Kind, len, map != NULL);
+
+    payload = r.ptr;
+    switch (hdr->Kind) {
+    case DP_CTRL_BIN_CFG_POLICY:
+        ret = dp_ctrl_bin_cfg_policy(&r);
+        break;
+    case DP_CTRL_BIN_CFG_INTERNAL_NET:
+        ret = dp_ctrl_bin_cfg_internal_net(&r, true);
+        break;
+    case DP_CTRL_BIN_CFG_POLICY_ADDR:
+        ret = dp_ctrl_bin_cfg_internal_net(&r, false);
+        break;
+    case DP_CTRL_BIN_CFG_DLP:
+        ret = dp_ctrl_bin_cfg_dlp(&r);
+        break;
+    case DP_CTRL_BIN_BLD_DLP:
+        ret = dp_ctrl_bin_bld_dlp(&r);
+        break;
+    case DP_CTRL_BIN_CFG_POLICY_DELTA:
+        ret = dp_ctrl_bin_cfg_policy_delta(&r);
+        break;
+    default:
+        DEBUG_ERROR(DBG_CTRL, "Unknown binary message, kind=%u\n", hdr->Kind);
+        ret = -1;
+        break;
+    }
+    if (ret < 0) {
+        DEBUG_ERROR(DBG_CTRL, "Fail to handle binary message, kind=%u\n", hdr->Kind);
+    }
+
+    // Journaled with the payload inline
+    snap_hdr = *hdr;
+    snap_hdr.Flags = 0;
+    snap_hdr.Length = htonl(len);
+    dp_snap_add(DP_SNAP_BIN, dp_ctrl_bin_snap_key(hdr->Kind, payload, len),
+                &snap_hdr, sizeof(snap_hdr), payload, len);
+
+    if (map != NULL) {
+        munmap(map, len);
+    }
+    return ret;
+}
+
+#define BUF_SIZE 8192
+char ctrl_msg_buf[BUF_SIZE];
+// Config commands, journaled for a restarted dp, see snapshot.c. The last message of a
+// single command sets all of its config. Keep in sync with dpCfgCmds of the agent.
+static const struct {
+    const char *cmd;
+    bool single;
+} g_cfg_cmds[] = {
+    {"ctrl_add_srvc_port",        false},
+    {"ctrl_del_srvc_port",        false},
+    {"ctrl_add_port_pair",        false},
+    {"ctrl_del_port_pair",        false},
+    {"ctrl_add_tap_port",         false},
+    {"ctrl_del_tap_port",         false},
+    {"ctrl_add_nfq_port",         false},
+    {"ctrl_del_nfq_port",         false},
+    {"ctrl_add_mac",              false},
+    {"ctrl_del_mac",              false},
+    {"ctrl_add_macs",             false},
+    {"ctrl_del_macs",             false},
+    {"ctrl_cfg_mac",              false},
+    {"ctrl_cfg_nbe",              false},
+    {"ctrl_set_latency",          true},
+    {"ctrl_set_threat_log_limit", true},
+    {"ctrl_set_debug",            true},
+    {"ctrl_set_dp_threads",       true},
+    {"ctrl_cfg_policy",           false},
+    {"ctrl_cfg_del_fqdn",         false},
+    {"ctrl_cfg_set_fqdn",         false},
+    {"ctrl_cfg_set_fqdns",        false},
+    {"ctrl_cfg_internal_net",     false},
+    {"ctrl_cfg_specip_net",       false},
+    {"ctrl_cfg_policy_addr",      false},
+    {"ctrl_cfg_dlp",              false},
+    {"ctrl_cfg_dlpmac",           false},
+    {"ctrl_bld_dlp",              false},
+    {"ctrl_bld_dlpmac",           false},
+    {"ctrl_sys_conf",             true},
+    {"ctrl_connect_report",       true},
+    {"ctrl_disable_net_policy",   true},
+    {"ctrl_detect_unmanaged_wl",  true},
+    {"ctrl_enable_icmp_policy",   true},
+    {"ctrl_strict_group_mode",    true},
+};
+
+static bool dp_ctrl_cfg_cmd(const char *key, uint64_t *snap_key)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_ENTRIES(g_cfg_cmds); i ++) {
+        if (strcmp(key, g_cfg_cmds[i].cmd) == 0) {
+            *snap_key = g_cfg_cmds[i].single ? dp_snap_key(key, strlen(key), 0) : 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int dp_ctrl_cfg_restore(json_t *msg);
+
+// buf is NUL terminated
+static int dp_ctrl_json_handler(char *buf, int size)
+{
+    int ret = 0;
+    json_t *root;
+    json_error_t error;
+
+    root = json_loads(buf, 0, &error);
+    if (root == NULL) {
+        DEBUG_ERROR(DBG_CTRL, "Invalid json format on line %d: %s\n", error.line, error.text);
+        return -1;
+    }
+
+    const char *key;
+    json_t *msg;
+    uint64_t snap_key = 0;
+    bool cfg = false;
+
+    g_client_req_id = json_integer_value(json_object_get(root, DP_CTRL_REQ_ID_KEY));
+
+    json_object_foreach(root, key, msg) {
+        if (strcmp(key, DP_CTRL_REQ_ID_KEY) == 0) {
+            continue;
+        }
+        if (strcmp(key, "ctrl_keep_alive") == 0) {
+            ret = dp_ctrl_keep_alive(msg);
+            continue;
+        }
+        if (!cfg) {
+            cfg = dp_ctrl_cfg_cmd(key, &snap_key);
+        }
+        char *data = NULL;
+        DEBUG_CTRL("\"%s\":%s\n", key, data=json_dumps(msg, JSON_ENSURE_ASCII));
+        //data needs to be freed otherwise there is memory leak
+        free(data);
+
+        if (strcmp(key, "ctrl_add_srvc_port") == 0) {
+            ret = dp_ctrl_add_srvc_port(msg);
+        } else if (strcmp(key, "ctrl_del_srvc_port") == 0) {
+            ret = dp_ctrl_del_srvc_port(msg);
+        } else if (strcmp(key, "ctrl_add_port_pair") == 0) {
+            ret = dp_ctrl_add_port_pair(msg);
+        } else if (strcmp(key, "ctrl_del_port_pair") == 0) {
+            ret = dp_ctrl_del_port_pair(msg);
+        } else if (strcmp(key, "ctrl_add_tap_port") == 0) {
+            ret = dp_ctrl_add_tap_port(msg);
+        } else if (strcmp(key, "ctrl_del_tap_port") == 0) {
+            ret = dp_ctrl_del_tap_port(msg);
+        } else if (strcmp(key, "ctrl_add_nfq_port") == 0) {
+            ret = dp_ctrl_add_nfq_port(msg);
+        } else if (strcmp(key, "ctrl_del_nfq_port") == 0) {
+            ret = dp_ctrl_del_nfq_port(msg);
+        } else if (strcmp(key, "ctrl_add_mac") == 0) {
+            ret = dp_ctrl_add_mac(msg);
+        } else if (strcmp(key, "ctrl_del_mac") == 0) {
+            ret = dp_ctrl_del_mac(msg);
+        } else if (strcmp(key, "ctrl_add_macs") == 0) {
+            ret = dp_ctrl_add_macs(msg);
+        } else if (strcmp(key, "ctrl_del_macs") == 0) {
+            ret = dp_ctrl_del_macs(msg);
+        } else if (strcmp(key, "ctrl_cfg_mac") == 0) {
+            ret = dp_ctrl_cfg_mac(msg);
+        } else if (strcmp(key, "ctrl_cfg_nbe") == 0) {
+            ret = dp_ctrl_cfg_nbe(msg);
+        } else if (strcmp(key, "ctrl_cfg_rate_limit") == 0) {
+            ret = dp_ctrl_cfg_rate_limit(msg);
+        } else if (strcmp(key, "ctrl_refresh_app") == 0) {
+            ret = dp_ctrl_refresh_app(msg);
+        } else if (strcmp(key, "ctrl_stats_macs") == 0) {
+            ret = dp_ctrl_stats_macs(msg);
+        } else if (strcmp(key, "ctrl_stats_device") == 0) {
+            ret = dp_ctrl_stats_device(msg);
+        } else if (strcmp(key, "ctrl_stats_fwd_latency") == 0) {
+            ret = dp_ctrl_stats_fwd_latency(msg);
+        } else if (strcmp(key, "ctrl_counter_device") == 0) {
+            ret = dp_ctrl_counter_device(msg);
+        } else if (strcmp(key, "ctrl_latency") == 0) {
+            ret = dp_ctrl_latency(msg);
+        } else if (strcmp(key, "ctrl_policy_hits") == 0) {
+            ret = dp_ctrl_policy_hits(msg);
+        } else if (strcmp(key, "ctrl_set_latency") == 0) {
+            ret = dp_ctrl_set_latency(msg);
+        } else if (strcmp(key, "ctrl_set_threat_log_limit") == 0) {
+            ret = dp_ctrl_set_threat_log_limit(msg);
+        } else if (strcmp(key, "ctrl_dump_trace") == 0) {
+            ret = dp_ctrl_dump_trace(msg);
+        } else if (strcmp(key, "ctrl_capture_start") == 0) {
+            ret = dp_ctrl_capture_start(msg);
+        } else if (strcmp(key, "ctrl_capture_stop") == 0) {
+            ret = dp_ctrl_capture_stop(msg);
+        } else if (strcmp(key, "ctrl_capture_status") == 0) {
+            ret = dp_ctrl_capture_status(msg);
+        } else if (strcmp(key, "ctrl_mem_stats") == 0) {
+            ret = dp_ctrl_mem_stats(msg);
+        } else if (strcmp(key, "ctrl_count_session") == 0) {
+            ret = dp_ctrl_count_session(msg);
+        } else if (strcmp(key, "ctrl_list_session") == 0) {
+            ret = dp_ctrl_list_session(msg);
+        } else if (strcmp(key, "ctrl_clear_session") == 0) {
             ret = dp_ctrl_clear_session(msg);
         } else if (strcmp(key, "ctrl_list_meter") == 0) {
             ret = dp_ctrl_list_meter(msg);
         } else if (strcmp(key, "ctrl_set_debug") == 0) {
             ret = dp_ctrl_set_debug(msg);
+        } else if (strcmp(key, "ctrl_set_dp_threads") == 0) {
+            ret = dp_ctrl_set_dp_threads(msg);
         // } else if (strcmp(key, "ctrl_get_debug") == 0) {
         //    ret = dp_ctrl_get_debug(msg);
         } else if (strcmp(key, "ctrl_cfg_policy") == 0) {
@@ -2462,6 +4239,8 @@ static int dp_ctrl_handler(int fd)
             ret = dp_ctrl_del_fqdn(msg);
         } else if (strcmp(key, "ctrl_cfg_set_fqdn") == 0) {
             ret = dp_ctrl_set_fqdn(msg);
+        } else if (strcmp(key, "ctrl_cfg_set_fqdns") == 0) {
+            ret = dp_ctrl_set_fqdns(msg);
         } else if (strcmp(key, "ctrl_cfg_internal_net") == 0) {
             ret = dp_ctrl_cfg_internal_net(msg, true);
         } else if (strcmp(key, "ctrl_cfg_specip_net") == 0) {
@@ -2478,6 +4257,8 @@ static int dp_ctrl_handler(int fd)
             ret = dp_ctrl_bld_dlp_update_ep(msg);
         } else if (strcmp(key, "ctrl_sys_conf") == 0) {
             ret = dp_ctrl_sys_conf(msg);
+        } else if (strcmp(key, "ctrl_connect_report") == 0) {
+            ret = dp_ctrl_connect_report_conf(msg);
         } else if (strcmp(key, "ctrl_disable_net_policy") == 0) {
             ret = dp_ctrl_disable_net_policy(msg);
         } else if (strcmp(key, "ctrl_detect_unmanaged_wl") == 0) {
@@ -2486,57 +4267,433 @@ static int dp_ctrl_handler(int fd)
             ret = dp_ctrl_enable_icmp_policy(msg);
         } else if (strcmp(key, "ctrl_strict_group_mode") == 0) {
             ret = dp_ctrl_strict_group_mode(msg);
+        } else if (strcmp(key, "ctrl_cfg_reset") == 0) {
+            dp_snap_reset();
+        } else if (strcmp(key, "ctrl_cfg_restore") == 0) {
+            ret = dp_ctrl_cfg_restore(msg);
         }
         DEBUG_CTRL("\"%s\" done\n", key);
     }
 
     json_decref(root);
 
+    if (cfg) {
+        dp_snap_add(DP_SNAP_JSON, snap_key, NULL, 0, buf, size);
+    }
     return ret;
 }
 
+// A ctrl message as the agent would send it, for the replay benchmark. buf is NUL terminated.
+int dp_ctrl_apply_json(char *buf, int size)
+{
+    return dp_ctrl_json_handler(buf, size);
+}
+
+static int dp_ctrl_handler(int fd)
+{
+    uint8_t cbuf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr *cmsg;
+    struct msghdr mh;
+    struct iovec iov;
+    int size, ret = 0, memfd = -1;
+
+    iov.iov_base = ctrl_msg_buf;
+    iov.iov_len = BUF_SIZE - 1;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_name = &g_client_addr;
+    mh.msg_namelen = sizeof(struct sockaddr_un);
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = cbuf;
+    mh.msg_controllen = sizeof(cbuf);
+
+    size = recvmsg(fd, &mh, MSG_CMSG_CLOEXEC);
+    if (size < 0) {
+        return -1;
+    }
+    g_client_req_id = 0;
+    for (cmsg = CMSG_FIRSTHDR(&mh); cmsg != NULL; cmsg = CMSG_NXTHDR(&mh, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            memcpy(&memfd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    if (size > 0 && (uint8_t)ctrl_msg_buf[0] == DP_CTRL_BIN_MAGIC) {
+        ret = dp_ctrl_bin_handler((uint8_t *)ctrl_msg_buf, size, memfd);
+        if (memfd >= 0) {
+            close(memfd);
+        }
+        return ret;
+    }
+    if (memfd >= 0) {
+        close(memfd);
+    }
+    ctrl_msg_buf[size] = '\0';
+
+    return dp_ctrl_json_handler(ctrl_msg_buf, size);
+}
+
+static int dp_ctrl_snap_apply(int type, uint8_t *data, uint32_t len)
+{
+    if (type == DP_SNAP_BIN) {
+        return dp_ctrl_bin_handler(data, len, -1);
+    }
+    return dp_ctrl_json_handler((char *)data, len);
+}
+
+static int dp_ctrl_cfg_restore(json_t *msg)
+{
+    uint32_t gen = json_integer_value(json_object_get(msg, "gen"));
+    uint32_t min = json_integer_value(json_object_get(msg, "min"));
+    uint32_t req_id = g_client_req_id;
+    uint8_t buf[sizeof(DPMsgHdr) + sizeof(DPMsgCfgRestore)];
+    DPMsgHdr *hdr = (DPMsgHdr *)buf;
+    DPMsgCfgRestore *m = (DPMsgCfgRestore *)(buf + sizeof(DPMsgHdr));
+    uint32_t cur;
+
+    memset(m, 0, sizeof(*m));
+    m->Valid = dp_snap_restore(min, gen, dp_ctrl_snap_apply, &cur);
+    m->Gen = htonl(cur);
+    // The replayed messages have their own ids
+    g_client_req_id = req_id;
+
+    hdr->Kind = DP_KIND_CFG_RESTORE;
+    hdr->Length = htons(sizeof(buf));
+    hdr->More = 0;
+
+    dp_ctrl_send_binary(buf, sizeof(buf));
+    return 0;
+}
+
 // -- threat log
 
+#define LOG_RING_SIZE (sizeof(DPLogShmHdr) + sizeof(DPLogRing) * MAX_DP_THREADS)
+
+static DPLogShmHdr *g_log_shm;
+static bool g_log_shared;       // the agent reads the rings, otherwise logs are sent one by one
+static int g_log_evfd = -1;     // wakes the report thread up when a ring gets its first log
+
+static inline DPLogRing *dp_ctrl_log_ring(int thr_id)
+{
+    return (DPLogRing *)((uint8_t *)g_log_shm + sizeof(DPLogShmHdr) + sizeof(DPLogRing) * thr_id);
+}
+
+// Called before the dp threads start. Without the shared memory file the rings are private.
+int dp_ctrl_log_init(bool shared)
+{
+    void *ptr = NULL;
+    int fd;
+
+    if (shared) {
+        char name[64];
+
+        fd = shm_open(dp_instance_name(DP_LOG_SHM_NAME, name, sizeof(name)), O_CREAT | O_RDWR | O_TRUNC, S_IRWXU | S_IRWXG);
+        if (fd >= 0) {
+            if (ftruncate(fd, LOG_RING_SIZE) == 0) {
+                ptr = mmap(NULL, LOG_RING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (ptr == MAP_FAILED) {
+                    ptr = NULL;
+                }
+            }
+            close(fd);
+        }
+        if (ptr == NULL) {
+            DEBUG_ERROR(DBG_CTRL, "fail to map threat log rings: %s\n", strerror(errno));
+            shared = false;
+        }
+    }
+    if (ptr == NULL && (ptr = calloc(1, LOG_RING_SIZE)) == NULL) {
+        return -1;
+    }
+
+    g_log_shm = ptr;
+    g_log_shared = shared;
+    g_log_shm->Rings = MAX_DP_THREADS;
+    g_log_shm->Entries = DP_LOG_RING_ENTRIES;
+    g_log_shm->RingSize = sizeof(DPLogRing);
+    g_log_evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    // The agent reads the rings once the magic is set
+    cmm_smp_wmb();
+    uatomic_set(&g_log_shm->Magic, DP_LOG_SHM_MAGIC);
+    return 0;
+}
+
+static void dp_ctrl_send_threat_logs(DPLogRing *r)
+{
+    static uint8_t buf[sizeof(DPMsgHdr) + sizeof(DPMsgThreatLog)];
+    DPMsgHdr *hdr = (DPMsgHdr *)buf;
+    uint32_t rd = r->Reader, wr = uatomic_read(&r->Writer);
+
+    cmm_smp_rmb();
+
+    hdr->Kind = DP_KIND_THREAT_LOG;
+    hdr->More = 0;
+    hdr->Length = htons(sizeof(buf));
+    for (; rd != wr; rd ++) {
+        memcpy(buf + sizeof(DPMsgHdr), &r->Logs[rd % DP_LOG_RING_ENTRIES], sizeof(DPMsgThreatLog));
+        dp_ctrl_notify_ctrl(buf, sizeof(buf));
+    }
+
+    cmm_smp_mb();
+    uatomic_set(&r->Reader, rd);
+}
+
+// On the eventfd and on the timer, which also picks up logs written while the reader was
+// catching up, as those don't signal the eventfd.
 static void dp_ctrl_consume_threat_log(void)
 {
     int thr_id;
 
+    if (g_log_shm == NULL) {
+        return;
+    }
+
     for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
-        dp_thread_data_t *th_data = &g_dp_thread_data[thr_id];
+        DPLogRing *r = dp_ctrl_log_ring(thr_id);
 
-        while (true) {
-            uint32_t next = (th_data->log_reader + 1) % MAX_LOG_ENTRIES;
-            if (next == th_data->log_writer) {
-                break;
-            }
-            uatomic_set(&th_data->log_reader, next);
+        if (uatomic_read(&r->Writer) == uatomic_read(&r->Reader)) {
+            continue;
+        }
+        if (g_log_shared) {
+            DPMsgHdr hdr;
+
+            // One notice for all rings, the agent reads them all
+            hdr.Kind = DP_KIND_THREAT_LOG_RING;
+            hdr.More = 0;
+            hdr.Length = htons(sizeof(hdr));
+            dp_ctrl_notify_ctrl(&hdr, sizeof(hdr));
+            return;
+        }
+        dp_ctrl_send_threat_logs(r);
+    }
+}
 
-            DEBUG_LOGGER("Read at entry=%u\n", th_data->log_reader);
+static void dp_ctrl_log_event(void)
+{
+    uint64_t cnt;
 
-            uint8_t *data = th_data->log_ring[th_data->log_reader];
-            dp_ctrl_notify_ctrl(data, LOG_ENTRY_SIZE);
-        }
+    if (read(g_log_evfd, &cnt, sizeof(cnt)) == sizeof(cnt)) {
+        dp_ctrl_consume_threat_log();
     }
 }
 
 int dp_ctrl_threat_log(DPMsgThreatLog *log)
 {
-    dp_thread_data_t *th_data = &g_dp_thread_data[THREAD_ID];
+    DPLogRing *r;
+    uint32_t wr, rd;
+
+    if (unlikely(g_log_shm == NULL)) {
+        return -1;
+    }
 
-    if (th_data->log_writer == th_data->log_reader) {
+    r = dp_ctrl_log_ring(THREAD_ID);
+    wr = r->Writer;
+    rd = uatomic_read(&r->Reader);
+    if (wr - rd >= DP_LOG_RING_ENTRIES) {
+        uatomic_set(&r->Drops, r->Drops + 1);
         DEBUG_ERROR(DBG_LOG, "Log ring full!\n");
         return -1;
     }
 
-    uint8_t *dst = &th_data->log_ring[th_data->log_writer][sizeof(DPMsgHdr)];
-    memcpy(dst, log, sizeof(*log));
+    memcpy(&r->Logs[wr % DP_LOG_RING_ENTRIES], log, sizeof(*log));
+
+    DEBUG_LOGGER("Wrote at entry=%u\n", wr);
+
+    cmm_smp_wmb();
+    uatomic_set(&r->Writer, wr + 1);
+
+    // A missed wakeup is covered by the timer
+    if (wr == rd && g_log_evfd >= 0) {
+        uint64_t w = 1;
+        write(g_log_evfd, &w, sizeof(w));
+    }
+    return 0;
+}
+
+// -- stats page
+
+#define STATS_PAGE_SIZE (sizeof(DPStatsShmHdr) + sizeof(DPStatsPage) * MAX_DP_THREADS)
+
+DPStatsShmHdr *g_stats_shm;
+
+static inline DPStatsPage *dp_ctrl_stats_page(int thr_id)
+{
+    return (DPStatsPage *)((uint8_t *)g_stats_shm + sizeof(DPStatsShmHdr) + sizeof(DPStatsPage) * thr_id);
+}
+
+// Called before the dp threads start. Without the file, nothing is published.
+int dp_ctrl_stats_init(void)
+{
+    void *ptr = MAP_FAILED;
+    char name[64];
+    int fd;
+
+    fd = shm_open(dp_instance_name(DP_STATS_SHM_NAME, name, sizeof(name)), O_CREAT | O_RDWR | O_TRUNC, S_IRWXU | S_IRWXG);
+    if (fd >= 0) {
+        if (ftruncate(fd, STATS_PAGE_SIZE) == 0) {
+            ptr = mmap(NULL, STATS_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+    }
+    if (ptr == MAP_FAILED) {
+        DEBUG_ERROR(DBG_CTRL, "fail to map stats page: %s\n", strerror(errno));
+        return -1;
+    }
+
+    g_stats_shm = ptr;
+    g_stats_shm->Threads = g_dp_threads;
+    g_stats_shm->Pages = MAX_DP_THREADS;
+    g_stats_shm->PageSize = sizeof(DPStatsPage);
+
+    cmm_smp_wmb();
+    uatomic_set(&g_stats_shm->Magic, DP_STATS_SHM_MAGIC);
+    return 0;
+}
+
+// Called by each dp thread on its own page, after its dpi counters are published
+void dp_ctrl_publish_stats(int thr_id, const dp_stats_t *ring, uint32_t load)
+{
+    DPStatsPage *st;
+    io_counter_t c;
+    int j;
+
+    if (g_stats_shm == NULL) {
+        return;
+    }
+    if (g_stats_shm->Threads < g_dp_threads) {
+        uatomic_set(&g_stats_shm->Threads, g_dp_threads);
+    }
+
+    dpi_read_counter(thr_id, &c);
+
+    st = dp_ctrl_stats_page(thr_id);
+    seqlock_write_begin((seqlock_t *)&st->Seq);
+
+    st->UpdatedAt = get_current_time();
+    st->Load = load;
+    st->RXPackets = ring->rx;
+    st->RXDropPackets = ring->rx_drops;
+    st->TXPackets = ring->tx;
+    st->TXDropPackets = ring->tx_drops;
+    st->HandoffPackets = ring->handoff;
+    st->HandoffDropPackets = ring->handoff_drops;
+    st->QuarDropPackets = ring->quar_drops;
+    st->ErrorPackets = c.err_pkts;
+    st->NoWorkloadPackets = c.unkn_pkts;
+    st->IPv4Packets = c.ipv4_pkts;
+    st->IPv6Packets = c.ipv6_pkts;
+    st->TCPPackets = c.tcp_pkts;
+    st->UDPPackets = c.udp_pkts;
+    st->ICMPPackets = c.icmp_pkts;
+    st->OtherPackets = c.other_pkts;
+    st->TotalSessions = c.sess_id;
+    st->TCPSessions = c.tcp_sess;
+    st->UDPSessions = c.udp_sess;
+    st->ICMPSessions = c.icmp_sess;
+    st->IPSessions = c.ip_sess;
+    st->CurSessions = c.cur_sess;
+    st->CurTCPSessions = c.cur_tcp_sess;
+    st->CurUDPSessions = c.cur_udp_sess;
+    st->CurICMPSessions = c.cur_icmp_sess;
+    st->CurIPSessions = c.cur_ip_sess;
+    st->DropMeters = c.drop_meters;
+    st->ProxyMeters = c.proxy_meters;
+    st->CurMeters = c.cur_meters;
+    st->CurLogCaches = c.cur_log_caches;
+    st->LogDrops = g_log_shm != NULL ? dp_ctrl_log_ring(thr_id)->Drops : 0;
+    st->LogSuppressed = c.log_suppressed;
+    st->DlpScanBytes = c.dlp_scan_bytes;
+    for (j = 0; j < DP_POOL_MAX; j ++) {
+        st->PoolInUse[j] = c.pool_in_use[j];
+        st->PoolHighWater[j] = c.pool_high_water[j];
+        st->PoolAllocFails[j] = c.pool_fails[j];
+    }
+    for (j = 0; j < DP_MEM_MAX; j ++) {
+        st->MemBytes[j] = c.mem_bytes[j];
+    }
+    st->ArenaBytes = dp_arena_bytes(thr_id);
+    st->Overloaded = g_dp_thread_data[thr_id].overloaded;
+    st->OverloadEnters = g_dp_thread_data[thr_id].overload_enters;
+    st->ShedSessions = c.shed_sessions;
+    st->ShedInspects = c.shed_inspects;
+    st->InflateBytes = c.inflate_bytes;
+    st->InflateLimits = c.inflate_limits;
+
+    seqlock_write_end((seqlock_t *)&st->Seq);
+}
+
+static void dp_ctrl_notify_overload(uint8_t *buf, uint8_t overloaded, uint32_t seconds)
+{
+    DPMsgOverload *m = (DPMsgOverload *)(buf + sizeof(DPMsgHdr));
+
+    m->Overloaded = overloaded;
+    m->Seconds = htonl(seconds);
+    DEBUG_CTRL("thr_id=%u overloaded=%u seconds=%u\n", ntohs(m->Thread), overloaded, seconds);
+    dp_ctrl_notify_ctrl(buf, sizeof(DPMsgHdr) + sizeof(DPMsgOverload));
+}
+
+// On the ctrl timer, tell the agent about the threads that entered or left the overload mode.
+// A thread that did both within the period is reported for each, in order.
+static void dp_ctrl_report_overload(void)
+{
+    static uint32_t reported[MAX_DP_THREADS], reported_enters[MAX_DP_THREADS];
+    uint8_t buf[sizeof(DPMsgHdr) + sizeof(DPMsgOverload)];
+    DPMsgHdr *hdr = (DPMsgHdr *)buf;
+    DPMsgOverload *m = (DPMsgOverload *)(buf + sizeof(DPMsgHdr));
+    int thr_id;
+
+    hdr->Kind = DP_KIND_OVERLOAD;
+    hdr->Length = htons(sizeof(buf));
+    hdr->More = 0;
+
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        dp_thread_data_t *th_data = &g_dp_thread_data[thr_id];
+        uint32_t overloaded = CMM_LOAD_SHARED(th_data->overloaded);
+        uint32_t enters = CMM_LOAD_SHARED(th_data->overload_enters);
+        io_counter_t c;
+
+        if (overloaded == reported[thr_id] && enters == reported_enters[thr_id]) {
+            continue;
+        }
+
+        dpi_read_counter(thr_id, &c);
+        memset(m, 0, sizeof(*m));
+        m->Thread = htons(thr_id);
+        m->Enters = htonl(enters);
+        m->ShedSessions = htonll(c.shed_sessions);
+        m->ShedInspects = htonll(c.shed_inspects);
+
+        // Left the mode reported last time, maybe to enter it again
+        if (reported[thr_id]) {
+            dp_ctrl_notify_overload(buf, 0, CMM_LOAD_SHARED(th_data->overload_seconds));
+        }
+        if (enters != reported_enters[thr_id]) {
+            dp_ctrl_notify_overload(buf, 1, 0);
+            if (!overloaded) {
+                dp_ctrl_notify_overload(buf, 0, CMM_LOAD_SHARED(th_data->overload_seconds));
+            }
+        }
+
+        reported[thr_id] = overloaded;
+        reported_enters[thr_id] = enters;
+    }
+}
 
-    DEBUG_LOGGER("Wrote at entry=%u\n", th_data->log_writer);
+// On the ctrl timer, publish the memory of the threads that have no page
+static void dp_ctrl_publish_mem(void)
+{
+    int64_t bytes[DP_MEM_MAX];
+    int j;
 
-    uint32_t next = (th_data->log_writer + 1) % MAX_LOG_ENTRIES;
-    uatomic_set(&th_data->log_writer, next);
+    if (g_stats_shm == NULL) {
+        return;
+    }
 
-    return 0;
+    mem_acct_row(MEM_ACCT_SHARED, bytes);
+    for (j = 0; j < DP_MEM_MAX; j ++) {
+        uatomic_set(&g_stats_shm->SharedMemBytes[j], bytes[j]);
+    }
 }
 
 // -- rate limiter
@@ -2579,7 +4736,7 @@ int dp_read_conn_stats(conn_stats_t *s, int thr_id)
     thr_id = thr_id % MAX_DP_THREADS;
 
     dp_thread_data_t *th_data = &g_dp_thread_data[thr_id];
-    dp_rate_limter_t *rl = &th_data->conn4_rl;
+    dp_rate_limter_t *rl = &th_data->conn_rl;
 
     s->limit_drop = rl->total_drop;
     s->limit_pass = rl->total_pass;
@@ -2619,9 +4776,43 @@ static int conn4_match(struct cds_lfht_node *ht_node, const void *key)
 static uint32_t conn4_hash(const void *key)
 {
     const conn4_key_t *ckey = key;
+    uint32_t k[4] = {ckey->client, ckey->server, ((uint32_t)ckey->port << 1) | ckey->ingress, ckey->pol_id};
+
+    return hash_key(k, sizeof(k));
+}
+
+typedef struct conn6_key_ {
+    uint32_t pol_id;
+    uint8_t client[16], server[16];
+    uint16_t port;
+    uint16_t application;
+    uint8_t ipproto;
+    bool ingress;
+} conn6_key_t;
+
+static int conn6_match(struct cds_lfht_node *ht_node, const void *key)
+{
+    conn_node_t *cnode = STRUCT_OF(ht_node, conn_node_t, node);
+    DPMsgConnect *conn = &cnode->conn;
+    const conn6_key_t *ckey = key;
+
+    return (conn->PolicyId == ckey->pol_id &&
+            memcmp(conn->ClientIP, ckey->client, 16) == 0 &&
+            memcmp(conn->ServerIP, ckey->server, 16) == 0 &&
+            !!FLAGS_TEST(conn->Flags, DPCONN_FLAG_INGRESS) == ckey->ingress &&
+            conn->Application == ckey->application &&
+            conn->ServerPort == ckey->port && conn->IPProto == ckey->ipproto) ? 1 : 0;
+}
+
+static uint32_t conn6_hash(const void *key)
+{
+    const conn6_key_t *ckey = key;
+    uint32_t k[2] = {((uint32_t)ckey->port << 1) | ckey->ingress, ckey->pol_id};
+    uint32_t crc;
 
-    return sdbm_hash((uint8_t *)&ckey->client, 4) +
-           sdbm_hash((uint8_t *)&ckey->server, 4) + ckey->port + ckey->ingress + ckey->pol_id;
+    crc = hash_crc32c(ckey->client, 16, HASH_CRC32C_INIT);
+    crc = hash_crc32c(ckey->server, 16, crc);
+    return hash_finish(hash_crc32c(k, sizeof(k), crc));
 }
 
 int dp_ctrl_traffic_log(DPMsgSession *log)
@@ -2629,177 +4820,401 @@ int dp_ctrl_traffic_log(DPMsgSession *log)
     return sizeof(*log);
 }
 
+static int g_conn_evfd = -1;    // wakes the report thread up when a connect ring fills up
+
 #define TUNNEL_THRESHOLD 800
+// Called by the report thread for the reports taken off a dp thread's ring
+static void dp_ctrl_aggregate_connect(dp_thread_data_t *th_data, dp_conn_log_t *log)
+{
+    dp_rate_limter_t *rl = &th_data->conn_rl;
+    conn4_key_t key4;
+    conn6_key_t key6;
+    rcu_map_t *conn_map;
+    uint32_t *cnt;
+    void *key;
+    int ip_len;
+
+    if (likely(log->ether_type == ETH_P_IP)) {
+        // host: IP is on host subnet
+        // unkpeer: IP is not on host or container subnets
+        /*
+        if (FLAGS_TEST(log->Flags, DPSESS_FLAG_EXTERNAL) &&
+            log->PolicyAction < DP_POLICY_ACTION_VIOLATE) {
+            key.client = 0;     // key.server = 0 for egress
+        } else {
+            // This is east-west traffic, if it's from containers on our managed host,
+            // it will be ignored, because it's counted at the egress container,
+            // (in bridge mode, we cannot identify src container by client IP and port);
+            // if it's from an unmanaged host, we want to record it.
+            key.client = ip4_get(log->ClientIP);
+        }
+        */
+        key4.client = ip4_get(log->client_ip);
+        key4.server = ip4_get(log->server_ip);
+        key4.ingress = !!FLAGS_TEST(log->flags, DPSESS_FLAG_INGRESS);
+        key4.port = log->server_port;
+        key4.application = log->application;
+        key4.ipproto = log->ipproto;
+        key4.pol_id = log->policy_id;
+        key = &key4;
+        ip_len = 4;
+        conn_map = &th_data->conn4_map;
+        cnt = &th_data->conn4_map_cnt;
+    } else {
+        memcpy(key6.client, log->client_ip, 16);
+        memcpy(key6.server, log->server_ip, 16);
+        key6.ingress = !!FLAGS_TEST(log->flags, DPSESS_FLAG_INGRESS);
+        key6.port = log->server_port;
+        key6.application = log->application;
+        key6.ipproto = log->ipproto;
+        key6.pol_id = log->policy_id;
+        key = &key6;
+        ip_len = 16;
+        conn_map = &th_data->conn6_map;
+        cnt = &th_data->conn6_map_cnt;
+    }
+
+    conn_node_t *n = rcu_map_lookup(conn_map, key);
+    if (n != NULL) {
+        DPMsgConnect *conn = &n->conn;
+        conn->Bytes += log->bytes;
+        conn->Sessions += log->sessions;
+        conn->Violates += log->violates;
+
+        if (log->last_seen >= conn->LastSeenAt) {
+            conn->PolicyAction = log->policy_action;
+            conn->PolicyId = log->policy_id;
+            conn->LastSeenAt = log->last_seen;
+        }
+        if (log->severity > conn->Severity) {
+            conn->ThreatID = log->threat_id;
+            conn->Severity = log->severity;
+        }
+        //check dns tunneling, put clientport to report and check it in agent
+        if ((log->server_port == 53 || log->application == DPI_APP_DNS) &&
+                !FLAGS_TEST(log->flags, DPSESS_FLAG_INGRESS) &&
+                log->ipproto == IPPROTO_UDP &&
+                log->client_bytes > TUNNEL_THRESHOLD) {
+            conn->ClientPort = log->client_port;
+        }
+        if (log->has_metric) {
+            conn->EpSessCurIn = log->metric.EpSessCurIn;
+            conn->EpSessIn12 = log->metric.EpSessIn12;
+            conn->EpByteIn12 = log->metric.EpByteIn12;
+        }
+    } else if ((log->policy_action == DP_POLICY_ACTION_LEARN || log->policy_action >= DP_POLICY_ACTION_VIOLATE
+                || dp_rate_limiter_check(rl) == 0) && (n = calloc(sizeof(*n), 1)) != NULL) {
+        DPMsgConnect *conn = &n->conn;
+        mac_cpy(conn->EPMAC, log->ep_mac);
+        memcpy(conn->ClientIP, log->client_ip, ip_len);
+        memcpy(conn->ServerIP, log->server_ip, ip_len);
+        conn->ServerPort = log->server_port;
+        if ((log->server_port == 53 || log->application == DPI_APP_DNS) &&
+                log->ipproto == IPPROTO_UDP &&
+                log->client_bytes > TUNNEL_THRESHOLD) {
+            conn->ClientPort = log->client_port;
+        }
+        conn->IPProto = log->ipproto;
+        conn->EtherType = log->ether_type;
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_INGRESS)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_INGRESS);
+        }
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_EXTERNAL)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_EXTERNAL);
+        }
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_XFF)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_XFF);
+        }
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_SVC_EXTIP)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_SVC_EXTIP);
+        }
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_MESH_TO_SVR)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_MESH_TO_SVR);
+        }
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_LINK_LOCAL)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_LINK_LOCAL);
+        }
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_TMP_OPEN)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_TMP_OPEN);
+        }
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_UWLIP)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_UWLIP);
+        }
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_CHK_NBE)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_CHK_NBE);
+        }
+        if (FLAGS_TEST(log->flags, DPSESS_FLAG_NBE_SNS)) {
+            FLAGS_SET(conn->Flags, DPCONN_FLAG_NBE_SNS);
+        }
+
+        conn->FirstSeenAt = conn->LastSeenAt = log->last_seen;
+        conn->Bytes = log->bytes;
+        conn->Sessions = log->sessions;
+        conn->Violates = log->violates;
+        conn->Application = log->application;
+        conn->PolicyAction = log->policy_action;
+        conn->ThreatID = log->threat_id;
+        conn->Severity = log->severity;
+        conn->PolicyId = log->policy_id;
+        if (log->has_metric) {
+            conn->EpSessCurIn = log->metric.EpSessCurIn;
+            conn->EpSessIn12 = log->metric.EpSessIn12;
+            conn->EpByteIn12 = log->metric.EpByteIn12;
+        }
+        rcu_map_add(conn_map, n, key);
+        (*cnt)++;
+    }
+}
+
+// Aggregate the published reports of the dp threads, on the eventfd and before the entries
+// are sent
+static void dp_ctrl_drain_connects(void)
+{
+    int thr_id;
+
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        dp_thread_data_t *th_data = &g_dp_thread_data[thr_id];
+        dp_conn_log_ring_t *r = th_data->conn_logs;
+        uint32_t rd, wr;
+
+        if (r == NULL) {
+            continue;
+        }
+
+        // Clear the flag first, so reports published from now on signal again
+        uatomic_set(&r->signaled, 0);
+        cmm_smp_mb();
+
+        rd = r->tail;
+        wr = CMM_LOAD_SHARED(r->head);
+        cmm_smp_rmb();
+        for (; rd != wr; rd ++) {
+            dp_ctrl_aggregate_connect(th_data, &r->logs[rd % CONN_LOG_RING_SIZE]);
+        }
+
+        cmm_smp_mb();
+        CMM_STORE_SHARED(r->tail, rd);
+    }
+}
+
+static void dp_ctrl_connect_event(void)
+{
+    uint64_t cnt;
+
+    if (read(g_conn_evfd, &cnt, sizeof(cnt)) == sizeof(cnt)) {
+        dp_ctrl_drain_connects();
+    }
+}
+
+// Publish the reports of the batch, called by the dp thread at the end of an rx batch or a
+// timer roll. The report thread is woken up when the ring is half full, otherwise the reports
+// wait for the connects timer.
+void dp_ctrl_connect_flush(void)
+{
+    dp_conn_log_ring_t *r = g_dp_thread_data[THREAD_ID].conn_logs;
+    uint32_t head;
+
+    if (r == NULL || r->pending == 0) {
+        return;
+    }
+
+    head = r->head + r->pending;
+    r->pending = 0;
+    cmm_smp_wmb();
+    CMM_STORE_SHARED(r->head, head);
+
+    cmm_smp_mb();
+    if (head - CMM_LOAD_SHARED(r->tail) >= CONN_LOG_RING_SIZE / 2 &&
+        !uatomic_read(&r->signaled) && g_conn_evfd >= 0) {
+        uint64_t w = 1;
+
+        uatomic_set(&r->signaled, 1);
+        write(g_conn_evfd, &w, sizeof(w));
+    }
+}
+
+// Called on the dp thread. The report is queued on the thread's ring, it is aggregated into
+// the connect entries by the report thread.
 int dp_ctrl_connect_report(DPMsgSession *log, DPMonitorMetric *metric, int count_session, int count_violate)
 {
-    dp_thread_data_t *th_data = &g_dp_thread_data[THREAD_ID];
+    dp_conn_log_ring_t *r = g_dp_thread_data[THREAD_ID].conn_logs;
+    dp_conn_log_t *c;
+    uint32_t wr;
 
-    // TODO: Only care IPv4 sessions
     if (likely(log->EtherType == ETH_P_IP)) {
-        conn4_key_t key;
-
         DEBUG_LOGGER(DBG_MAC_FORMAT" "DBG_IPV4_FORMAT":%u => "DBG_IPV4_FORMAT":%u"
                      " app=%u policy=%u action=%d sess=%d violate=%d threat=%u severity=%d\n",
                      DBG_MAC_TUPLE(log->EPMAC), DBG_IPV4_TUPLE(log->ClientIP), log->ClientPort,
                      DBG_IPV4_TUPLE(log->ServerIP),log->ServerPort,
                      log->Application, log->PolicyId, log->PolicyAction,
                      count_session, count_violate, log->ThreatID, log->Severity);
+    } else if (log->EtherType == ETH_P_IPV6) {
+        DEBUG_LOGGER(DBG_MAC_FORMAT" "DBG_IPV6_FORMAT":%u => "DBG_IPV6_FORMAT":%u"
+                     " app=%u policy=%u action=%d sess=%d violate=%d threat=%u severity=%d\n",
+                     DBG_MAC_TUPLE(log->EPMAC), DBG_IPV6_TUPLE(log->ClientIP), log->ClientPort,
+                     DBG_IPV6_TUPLE(log->ServerIP),log->ServerPort,
+                     log->Application, log->PolicyId, log->PolicyAction,
+                     count_session, count_violate, log->ThreatID, log->Severity);
+    } else {
+        return 0;
+    }
 
-        // host: IP is on host subnet
-        // unkpeer: IP is not on host or container subnets
-        if (FLAGS_TEST(log->Flags, DPSESS_FLAG_INGRESS)) {
-            /*
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_EXTERNAL) &&
-                log->PolicyAction < DP_POLICY_ACTION_VIOLATE) {
-                key.client = 0;
-            } else {
-                // This is east-west traffic, if it's from containers on our managed host,
-                // it will be ignored, because it's counted at the egress container,
-                // (in bridge mode, we cannot identify src container by client IP and port);
-                // if it's from an unmanaged host, we want to record it.
-                key.client = ip4_get(log->ClientIP);
-            }
-            */
-            key.client = ip4_get(log->ClientIP);
-            key.server = ip4_get(log->ServerIP);
-            key.ingress = true;
-        } else {
-            /*
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_EXTERNAL) &&
-                log->PolicyAction < DP_POLICY_ACTION_VIOLATE) {
-                key.server = 0;
-            } else {
-                key.server = ip4_get(log->ServerIP);
-            }
-            */
-            key.server = ip4_get(log->ServerIP);
-            key.client = ip4_get(log->ClientIP);
-            key.ingress = false;
-        }
-        key.port = log->ServerPort;
-        key.ipproto = log->IPProto;
-        key.pol_id = log->PolicyId;
-
-        // Hold the map pointer for RCU access
-        uint32_t idx = th_data->conn4_map_cur;
-        rcu_map_t *conn4_map = &th_data->conn4_map[idx];
-        uint32_t *cnt = &th_data->conn4_map_cnt[idx];
-        dp_rate_limter_t *rl = &th_data->conn4_rl;
-
-        conn_node_t *n = rcu_map_lookup(conn4_map, &key);
-        if (n != NULL) {
-            DPMsgConnect *conn = &n->conn;
-            uint32_t last_seen = get_current_time() - log->Idle;
-            conn->Bytes += log->ClientBytes + log->ServerBytes;
-            conn->Sessions += count_session;
-            conn->Violates += count_violate;
-
-            if (last_seen >= conn->LastSeenAt) {
-                conn->PolicyAction = log->PolicyAction;
-                conn->PolicyId = log->PolicyId;
-                conn->LastSeenAt = last_seen;
-            }
-            if (log->Severity > conn->Severity) {
-                conn->ThreatID = log->ThreatID;
-                conn->Severity = log->Severity;
-            }
-            //check dns tunneling, put clientport to report and check it in agent
-            if ((log->ServerPort == 53 || log->Application == DPI_APP_DNS) &&
-                    !FLAGS_TEST(log->Flags, DPSESS_FLAG_INGRESS) &&
-                    log->IPProto == IPPROTO_UDP &&
-                    log->ClientBytes > TUNNEL_THRESHOLD) {
-                conn->ClientPort = log->ClientPort;
-            }
-            if (metric != NULL) {
-                conn->EpSessCurIn = metric->EpSessCurIn;
-                conn->EpSessIn12 = metric->EpSessIn12;
-                conn->EpByteIn12 = metric->EpByteIn12;
-            }
-        } else if ((log->PolicyAction == DP_POLICY_ACTION_LEARN || log->PolicyAction >= DP_POLICY_ACTION_VIOLATE
-                    || dp_rate_limiter_check(rl) == 0) && (n = calloc(sizeof(*n), 1)) != NULL) {
-            DPMsgConnect *conn = &n->conn;
-            mac_cpy(conn->EPMAC, log->EPMAC);
-            memcpy(conn->ClientIP, &key.client, 4);
-            memcpy(conn->ServerIP, &key.server, 4);
-            conn->ServerPort = key.port;
-            if ((log->ServerPort == 53 || log->Application == DPI_APP_DNS) &&
-                    log->IPProto == IPPROTO_UDP &&
-                    log->ClientBytes > TUNNEL_THRESHOLD) {
-                conn->ClientPort = log->ClientPort;
-            }
-            conn->IPProto = key.ipproto;
-            conn->EtherType = log->EtherType;
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_INGRESS)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_INGRESS);
-            }
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_EXTERNAL)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_EXTERNAL);
-            }
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_XFF)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_XFF);
-            }
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_SVC_EXTIP)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_SVC_EXTIP);
-            }
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_MESH_TO_SVR)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_MESH_TO_SVR);
-            }
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_LINK_LOCAL)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_LINK_LOCAL);
-            }
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_TMP_OPEN)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_TMP_OPEN);
-            }
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_UWLIP)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_UWLIP);
-            }
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_CHK_NBE)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_CHK_NBE);
-            }
-            if (FLAGS_TEST(log->Flags, DPSESS_FLAG_NBE_SNS)) {
-                FLAGS_SET(conn->Flags, DPCONN_FLAG_NBE_SNS);
-            }
+    // Nothing happened since the last report of the session, e.g. the timer of an idle
+    // offloaded flow. Its entry, if any, was already sent.
+    if (count_session == 0 && count_violate == 0 && log->ClientBytes == 0 && log->ServerBytes == 0 &&
+        log->Severity == 0) {
+        return sizeof(*log);
+    }
 
-            conn->FirstSeenAt = conn->LastSeenAt = get_current_time() - log->Idle;
-            conn->Bytes = log->ClientBytes + log->ServerBytes;
-            conn->Sessions = count_session;
-            conn->Violates = count_violate;
-            conn->Application = log->Application;
-            conn->PolicyAction = log->PolicyAction;
-            conn->ThreatID = log->ThreatID;
-            conn->Severity = log->Severity;
-            conn->PolicyId = log->PolicyId;
-            if (metric != NULL) {
-                conn->EpSessCurIn = metric->EpSessCurIn;
-                conn->EpSessIn12 = metric->EpSessIn12;
-                conn->EpByteIn12 = metric->EpByteIn12;
-            }
-            rcu_map_add(conn4_map, n, &key);
-            (*cnt)++;
-        }
-    } else {
+    if (unlikely(r == NULL)) {
+        return 0;
+    }
+
+    // The session reports again on its next log when this one is dropped
+    wr = r->head + r->pending;
+    if (unlikely(wr - CMM_LOAD_SHARED(r->tail) >= CONN_LOG_RING_SIZE)) {
+        dp_ctrl_connect_flush();
+        r->drops ++;
+        DEBUG_ERROR(DBG_LOG, "Connect ring full!\n");
         return 0;
     }
 
+    c = &r->logs[wr % CONN_LOG_RING_SIZE];
+    mac_cpy(c->ep_mac, log->EPMAC);
+    c->ether_type = log->EtherType;
+    memcpy(c->client_ip, log->ClientIP, sizeof(c->client_ip));
+    memcpy(c->server_ip, log->ServerIP, sizeof(c->server_ip));
+    c->client_port = log->ClientPort;
+    c->server_port = log->ServerPort;
+    c->application = log->Application;
+    c->flags = log->Flags;
+    c->ipproto = log->IPProto;
+    c->policy_action = log->PolicyAction;
+    c->severity = log->Severity;
+    c->sessions = count_session;
+    c->violates = count_violate;
+    c->client_bytes = log->ClientBytes;
+    c->bytes = log->ClientBytes + log->ServerBytes;
+    c->last_seen = get_current_time() - log->Idle;
+    c->policy_id = log->PolicyId;
+    c->threat_id = log->ThreatID;
+    c->has_metric = metric != NULL;
+    if (metric != NULL) {
+        c->metric = *metric;
+    }
+    r->pending ++;
+
     return sizeof(*log);
 }
 
-#define CONNECTS_PER_MSG ((DP_MSG_SIZE - sizeof(DPMsgHdr) - sizeof(DPMsgConnectHdr)) / sizeof(DPMsgConnect))
-#define CONNECTS_FIRST_ENTRY (DPMsgConnect *)(g_notify_msg + sizeof(DPMsgHdr) + sizeof(DPMsgConnectHdr))
+#define CONNECTS_FIRST_ENTRY (g_report_msg + sizeof(DPMsgHdr) + sizeof(DPMsgConnectHdr))
+// A compact entry is never more than twice the fixed size
+#define CONNECT_COMPACT_MAX (sizeof(DPMsgConnect) * 2)
 
-static void send_connects(int count)
+static void send_connects(int count, uint8_t *end, bool compact, bool native)
 {
     //DEBUG_CTRL("count=%d\n", count);
 
-    DPMsgHdr *hdr = (DPMsgHdr *)g_notify_msg;
-    DPMsgConnectHdr *ch = (DPMsgConnectHdr *)(g_notify_msg + sizeof(*hdr));
-    uint16_t len = sizeof(*hdr) + sizeof(*ch) + sizeof(DPMsgConnect) * count;
+    DPMsgHdr *hdr = (DPMsgHdr *)g_report_msg;
+    DPMsgConnectHdr *ch = (DPMsgConnectHdr *)(g_report_msg + sizeof(*hdr));
+    uint16_t len = end - g_report_msg;
 
-    hdr->Kind = DP_KIND_CONNECTION;
+    hdr->Kind = compact ? DP_KIND_CONNECTION_COMPACT : DP_KIND_CONNECTION;
     hdr->Length = htons(len);
     hdr->More = 1;
     ch->Connects = htons(count);
-    dp_ctrl_notify_ctrl(g_notify_msg, len);
+    ch->Flags = htons(native ? DP_MSG_FLAG_NATIVE : 0);
+    dp_ctrl_notify_ctrl(g_report_msg, len);
+}
+
+static const struct {
+    uint8_t offset, size;
+} g_conn_fields[DPCONN_FIELD_MAX] = {
+    [DPCONN_FIELD_EPMAC]         = {offsetof(DPMsgConnect, EPMAC), 6},
+    [DPCONN_FIELD_IPPROTO]       = {offsetof(DPMsgConnect, IPProto), 1},
+    [DPCONN_FIELD_SERVER_PORT]   = {offsetof(DPMsgConnect, ServerPort), 2},
+    [DPCONN_FIELD_CLIENT_PORT]   = {offsetof(DPMsgConnect, ClientPort), 2},
+    [DPCONN_FIELD_ETHER_TYPE]    = {offsetof(DPMsgConnect, EtherType), 2},
+    [DPCONN_FIELD_CLIENT_IP]     = {offsetof(DPMsgConnect, ClientIP), 16},
+    [DPCONN_FIELD_SERVER_IP]     = {offsetof(DPMsgConnect, ServerIP), 16},
+    [DPCONN_FIELD_FLAGS]         = {offsetof(DPMsgConnect, Flags), 2},
+    [DPCONN_FIELD_BYTES]         = {offsetof(DPMsgConnect, Bytes), 4},
+    [DPCONN_FIELD_SESSIONS]      = {offsetof(DPMsgConnect, Sessions), 4},
+    [DPCONN_FIELD_FIRST_SEEN]    = {offsetof(DPMsgConnect, FirstSeenAt), 4},
+    [DPCONN_FIELD_LAST_SEEN]     = {offsetof(DPMsgConnect, LastSeenAt), 4},
+    [DPCONN_FIELD_APPLICATION]   = {offsetof(DPMsgConnect, Application), 2},
+    [DPCONN_FIELD_POLICY_ACTION] = {offsetof(DPMsgConnect, PolicyAction), 1},
+    [DPCONN_FIELD_SEVERITY]      = {offsetof(DPMsgConnect, Severity), 1},
+    [DPCONN_FIELD_POLICY_ID]     = {offsetof(DPMsgConnect, PolicyId), 4},
+    [DPCONN_FIELD_VIOLATES]      = {offsetof(DPMsgConnect, Violates), 4},
+    [DPCONN_FIELD_THREAT_ID]     = {offsetof(DPMsgConnect, ThreatID), 4},
+    [DPCONN_FIELD_SESS_CUR_IN]   = {offsetof(DPMsgConnect, EpSessCurIn), 4},
+    [DPCONN_FIELD_SESS_IN12]     = {offsetof(DPMsgConnect, EpSessIn12), 4},
+    [DPCONN_FIELD_BYTE_IN12]     = {offsetof(DPMsgConnect, EpByteIn12), 8},
+};
+
+static uint8_t *put_varint(uint8_t *ptr, uint64_t v)
+{
+    while (v >= 0x80) {
+        *ptr ++ = v | 0x80;
+        v >>= 7;
+    }
+    *ptr ++ = v;
+    return ptr;
+}
+
+// Encode the fields of conn that differ from prev, see DP_KIND_CONNECTION_COMPACT
+static uint8_t *compact_connect(uint8_t *ptr, const DPMsgConnect *conn, const DPMsgConnect *prev)
+{
+    const uint8_t *c = (const uint8_t *)conn, *o = (const uint8_t *)prev;
+    uint32_t mask = 0;
+    int i;
+
+    for (i = 0; i < DPCONN_FIELD_MAX; i ++) {
+        if (memcmp(c + g_conn_fields[i].offset, o + g_conn_fields[i].offset, g_conn_fields[i].size) != 0) {
+            mask |= 1 << i;
+        }
+    }
+
+    ptr = put_varint(ptr, mask);
+    for (i = 0; i < DPCONN_FIELD_MAX; i ++) {
+        const uint8_t *v = c + g_conn_fields[i].offset;
+        uint16_t v16;
+        uint32_t v32;
+        uint64_t v64;
+
+        if (!(mask & (1 << i))) {
+            continue;
+        }
+        switch (g_conn_fields[i].size) {
+        case 1:
+            ptr = put_varint(ptr, *v);
+            break;
+        case 2:
+            memcpy(&v16, v, 2);
+            ptr = put_varint(ptr, v16);
+            break;
+        case 4:
+            memcpy(&v32, v, 4);
+            ptr = put_varint(ptr, v32);
+            break;
+        case 8:
+            memcpy(&v64, v, 8);
+            ptr = put_varint(ptr, v64);
+            break;
+        case 16:
+            // IPv4 addresses are zero padded in the entry
+            v32 = conn->EtherType == ETH_P_IPV6 ? 16 : 4;
+            memcpy(ptr, v, v32);
+            ptr += v32;
+            break;
+        default:
+            memcpy(ptr, v, g_conn_fields[i].size);
+            ptr += g_conn_fields[i].size;
+            break;
+        }
+    }
+    return ptr;
 }
 
 static void netify_connects(DPMsgConnect *conn)
@@ -2823,53 +5238,64 @@ static void netify_connects(DPMsgConnect *conn)
 
 static void dp_ctrl_update_connects(void)
 {
+    bool compact = g_conn_compact, native = !compact && g_native_msg;
+    uint32_t entry_max = compact ? CONNECT_COMPACT_MAX : sizeof(DPMsgConnect);
     int thr_id, count, total;
-    DPMsgConnect *conn;
+    DPMsgConnect prev;
+    uint8_t *ptr;
 
     count = total = 0;
-    conn = CONNECTS_FIRST_ENTRY;
+    ptr = CONNECTS_FIRST_ENTRY;
+    memset(&prev, 0, sizeof(prev));
+
+    dp_ctrl_drain_connects();
 
     for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
         dp_thread_data_t *th_data = &g_dp_thread_data[thr_id];
 
-        // switch connection map
-        rcu_map_t *conn4_map = &th_data->conn4_map[th_data->conn4_map_cur];
-        uint32_t *cnt = &th_data->conn4_map_cnt[th_data->conn4_map_cur];
-        if (*cnt == 0) {
+        // the maps are only touched by this thread
+        rcu_map_t *maps[2] = {&th_data->conn4_map, &th_data->conn6_map};
+        uint32_t *cnts[2] = {&th_data->conn4_map_cnt, &th_data->conn6_map_cnt};
+        int i;
+
+        if (*cnts[0] == 0 && *cnts[1] == 0) {
             continue;
         }
-        uatomic_set(&th_data->conn4_map_cur, 1 - th_data->conn4_map_cur);
 
-        synchronize_rcu();
+        for (i = 0; i < 2; i ++) {
+            struct cds_lfht_node *node;
+            RCU_MAP_FOR_EACH(maps[i], node) {
+                conn_node_t *n = STRUCT_OF(node, conn_node_t, node);
+
+                if (compact) {
+                    ptr = compact_connect(ptr, &n->conn, &prev);
+                    memcpy(&prev, &n->conn, sizeof(prev));
+                } else {
+                    memcpy(ptr, &n->conn, sizeof(n->conn));
+                    if (!native) {
+                        netify_connects((DPMsgConnect *)ptr);
+                    }
+                    ptr += sizeof(n->conn);
+                }
 
-        struct cds_lfht_node *node;
-        RCU_MAP_FOR_EACH(conn4_map, node) {
-            conn_node_t *n = STRUCT_OF(node, conn_node_t, node);
-    
-            memcpy(conn, &n->conn, sizeof(*conn));
-            netify_connects(conn);
-
-            // Calculate delta
-            n->conn.Bytes = 0;
-            n->conn.Sessions = 0;
-
-            conn ++;
-            count ++;
-            total ++;
-            if (unlikely(count == CONNECTS_PER_MSG)) {
-                send_connects(count);
-                count = 0;
-                conn = CONNECTS_FIRST_ENTRY;
-            }
+                count ++;
+                total ++;
+                if (unlikely(g_report_msg + DP_MSG_SIZE - ptr < entry_max)) {
+                    send_connects(count, ptr, compact, native);
+                    count = 0;
+                    ptr = CONNECTS_FIRST_ENTRY;
+                    memset(&prev, 0, sizeof(prev));
+                }
 
-            rcu_map_del(conn4_map, n);
-            free(n);
+                rcu_map_del(maps[i], n);
+                free(n);
+            }
+            *cnts[i] = 0;
         }
-        *cnt = 0;
     }
 
     if (count > 0) {
-        send_connects(count);
+        send_connects(count, ptr, compact, native);
     }
 
     if (total > 0) {
@@ -2879,6 +5305,19 @@ static void dp_ctrl_update_connects(void)
 
 #define FQDN_IPS_PER_MSG ((DP_MSG_SIZE - sizeof(DPMsgHdr) - sizeof(DPMsgFqdnIpHdr)) / sizeof(DPMsgFqdnIp))
 
+static void dp_ctrl_notify_records(uint8_t kind, uint16_t len, int records)
+{
+    DPMsgHdr *hdr = (DPMsgHdr *)g_notify_msg;
+
+    hdr->Kind = kind;
+    hdr->Length = htons(len);
+
+    DEBUG_CTRL("kind=%u records=%d len=%u\n", kind, records, len);
+
+    dp_ctrl_notify_ctrl(g_notify_msg, len);
+}
+
+// The records of the updated names are packed in a message until it is full
 static void dp_ctrl_update_fqdn_ip(void)
 {
     //this function is called in ctrl thread, but g_fqdn_hdl is initialized
@@ -2888,6 +5327,8 @@ static void dp_ctrl_update_fqdn_ip(void)
         return;
     }
     struct cds_lfht_node *name_node;
+    uint16_t len = sizeof(DPMsgHdr);
+    int records = 0;
 
     // Iterate through fqdn map
     RCU_MAP_FOR_EACH(&g_fqdn_hdl->fqdn_name_map, name_node) {
@@ -2903,13 +5344,18 @@ static void dp_ctrl_update_fqdn_ip(void)
             continue;
         }
 
-        int ipcnt = 0;
+        int ipcnt = 0, ipmax = min(name_entry->r->ip_cnt, FQDN_IPS_PER_MSG);
+        if (len + sizeof(DPMsgFqdnIpHdr) + sizeof(DPMsgFqdnIp) * ipmax > DP_MSG_SIZE) {
+            dp_ctrl_notify_records(DP_KIND_FQDN_UPDATE, len, records);
+            len = sizeof(DPMsgHdr);
+            records = 0;
+        }
+        ipmax = (DP_MSG_SIZE - len - sizeof(DPMsgFqdnIpHdr)) / sizeof(DPMsgFqdnIp);
 
-        DPMsgHdr *hdr = (DPMsgHdr *)g_notify_msg;
-        DPMsgFqdnIpHdr *fh = (DPMsgFqdnIpHdr *)(g_notify_msg + sizeof(*hdr));
-        DPMsgFqdnIp *fqdnips = (DPMsgFqdnIp *)(g_notify_msg + sizeof(*hdr) + sizeof(*fh));
+        DPMsgFqdnIpHdr *fh = (DPMsgFqdnIpHdr *)(g_notify_msg + len);
+        DPMsgFqdnIp *fqdnips = (DPMsgFqdnIp *)(g_notify_msg + len + sizeof(*fh));
 
-        hdr->Kind = DP_KIND_FQDN_UPDATE;
+        memset(fh, 0, sizeof(*fh));
         strlcpy(fh->FqdnName, name_entry->r->name, DP_POLICY_FQDN_NAME_MAX_LEN);
         if (name_entry->r->vh) {
             FLAGS_SET(fh->Flags, DPFQDN_IP_FLAG_VH);
@@ -2920,24 +5366,28 @@ static void dp_ctrl_update_fqdn_ip(void)
             ip4_cpy(fqdnips->FqdnIP, (uint8_t *)&ipv4_itr->ip);
             fqdnips++;
             ipcnt++;
-            if (ipcnt == FQDN_IPS_PER_MSG) {
+            if (ipcnt == ipmax) {
                 break;
             }
         }
-        uint16_t len = sizeof(*hdr) + sizeof(*fh) + sizeof(DPMsgFqdnIp) * ipcnt;
-        hdr->Length = htons(len);
+        len += sizeof(*fh) + sizeof(DPMsgFqdnIp) * ipcnt;
         fh->IpCnt = htons(ipcnt);
+        records ++;
 
         if (name_entry->r->ip_cnt != ipcnt) {
             DEBUG_CTRL("Not all ips are sent. ipcnt=%u sent=%u\n", name_entry->r->ip_cnt, ipcnt);
         }
 
-        //DEBUG_CTRL("name: %s flags=0x%02x ipcnt=%d, len=%u\n", fh->FqdnName, fh->Flags, ipcnt, len);
+        //DEBUG_CTRL("name: %s flags=0x%02x ipcnt=%d\n", fh->FqdnName, fh->Flags, ipcnt);
+    }
 
-        dp_ctrl_notify_ctrl(g_notify_msg, len);
+    if (records > 0) {
+        dp_ctrl_notify_records(DP_KIND_FQDN_UPDATE, len, records);
     }
 }
 
+#define IP_FQDN_STORAGE_PER_MSG ((DP_MSG_SIZE - sizeof(DPMsgHdr)) / sizeof(DPMsgIpFqdnStorageUpdateHdr))
+
 static void dp_ctrl_update_ip_fqdn_storage(void)
 {
     //this function is called in ctrl thread, but th_ip_fqdn_storage_map is initialized
@@ -2947,6 +5397,8 @@ static void dp_ctrl_update_ip_fqdn_storage(void)
         return;
     }
     struct cds_lfht_node *ip_fqdn_storage_node;
+    DPMsgIpFqdnStorageUpdateHdr *fh = (DPMsgIpFqdnStorageUpdateHdr *)(g_notify_msg + sizeof(DPMsgHdr));
+    int records = 0;
 
     // Iterate through fqdn map
     RCU_MAP_FOR_EACH(&th_ip_fqdn_storage_map, ip_fqdn_storage_node) {
@@ -2956,18 +5408,21 @@ static void dp_ctrl_update_ip_fqdn_storage(void)
             continue;
         }
 
-        DPMsgHdr *hdr = (DPMsgHdr *)g_notify_msg;
-        DPMsgIpFqdnStorageUpdateHdr *fh = (DPMsgIpFqdnStorageUpdateHdr *)(g_notify_msg + sizeof(*hdr));
+        ip4_cpy(fh[records].IP, (uint8_t *)&entry->r->ip);
+        strlcpy(fh[records].Name, entry->r->name, DP_POLICY_FQDN_NAME_MAX_LEN);
 
-        hdr->Kind = DP_KIND_IP_FQDN_STORAGE_UPDATE;
-        ip4_cpy(fh->IP, (uint8_t *)&entry->r->ip);
-        strlcpy(fh->Name, entry->r->name, DP_POLICY_FQDN_NAME_MAX_LEN);
-        uint16_t len = sizeof(*hdr) + sizeof(*fh);
-        hdr->Length = htons(len);
+        DEBUG_CTRL("update ip-fqdn storage, ip=%x name=%s\n", entry->r->ip, fh[records].Name);
 
-        DEBUG_CTRL("update ip-fqdn storage, ip=%x name=%s len=%u\n", fh->IP, fh->Name, len);
+        if (++ records == IP_FQDN_STORAGE_PER_MSG) {
+            dp_ctrl_notify_records(DP_KIND_IP_FQDN_STORAGE_UPDATE,
+                                   sizeof(DPMsgHdr) + sizeof(*fh) * records, records);
+            records = 0;
+        }
+    }
 
-        dp_ctrl_notify_ctrl(g_notify_msg, len);
+    if (records > 0) {
+        dp_ctrl_notify_records(DP_KIND_IP_FQDN_STORAGE_UPDATE,
+                               sizeof(DPMsgHdr) + sizeof(*fh) * records, records);
     }
 }
 
@@ -2988,39 +5443,209 @@ void dp_ctrl_release_ip_fqdn_storage(dpi_ip_fqdn_storage_entry_t *entry)
 
 // -- ctrl loop
 
-void dp_ctrl_init_thread_data(void)
+// Called before the dp thread starts
+void dp_ctrl_init_thread_data(int thr_id)
 {
-    int thr_id, i;
+    dp_thread_data_t *th_data = &g_dp_thread_data[thr_id];
+    int i;
 
-    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
-        dp_thread_data_t *th_data = &g_dp_thread_data[thr_id];
+    // Control command ring
+    for (i = 0; i < CTRL_CMD_RING_SIZE; i ++) {
+        th_data->ctrl_cmds.slots[i].seq = i;
+    }
+
+    // Connection report ring and map
+    if (th_data->conn_logs == NULL) {
+        th_data->conn_logs = calloc(1, sizeof(dp_conn_log_ring_t));
+        if (th_data->conn_logs == NULL) {
+            DEBUG_ERROR(DBG_INIT, "fail to allocate connect ring of thread %d\n", thr_id);
+        }
+    }
+    if (g_conn_evfd < 0) {
+        g_conn_evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    rcu_map_init(&th_data->conn4_map, 128, offsetof(conn_node_t, node),
+                 conn4_match, conn4_hash);
+    rcu_map_init(&th_data->conn6_map, 32, offsetof(conn_node_t, node),
+                 conn6_match, conn6_hash);
+    th_data->conn4_map_cnt = 0;
+    th_data->conn6_map_cnt = 0;
+    dp_rate_limiter_reset(&th_data->conn_rl, CONNECT_RL_DUR, CONNECT_RL_CNT);
+}
+
+// -- housekeeping timers
+
+typedef struct dp_ctrl_timer_ {
+    const char *name;
+    void (*handler)(void);
+    uint32_t period;        // in seconds, 0 to disable
+    bool report;            // run on the report thread
+    int fd;
+} dp_ctrl_timer_t;
+
+static void dp_ctrl_update_app_timer(void)
+{
+    dp_ctrl_update_dirty_app();
+}
+
+// Threat logs and connections are reported from their own thread, so a long policy
+// push handled by the ctrl thread doesn't hold back security events.
+static dp_ctrl_timer_t g_ctrl_timers[] = {
+    {"app",             dp_ctrl_update_app_timer,       2, false, -1},
+    {"fqdn_ip",         dp_ctrl_update_fqdn_ip,         2, false, -1},
+    {"ip_fqdn_storage", dp_ctrl_update_ip_fqdn_storage, 2, false, -1},
+    {"threat_log",      dp_ctrl_consume_threat_log,     2, true,  -1},
+    {"connects",        dp_ctrl_update_connects,        6, true,  -1},
+    {"rebalance",       dp_data_rebalance,             10, false, -1},
+    {"ring_tune",       dp_data_tune_rings,            10, false, -1},
+    {"capture",         dpi_capture_drain,              1, false, -1},
+    {"trace",           dpi_trace_dump_timer,           1, false, -1},
+    {"resume",          dpi_resume_timer,               1, false, -1},
+    {"mem",             dp_ctrl_publish_mem,            1, false, -1},
+    {"overload",        dp_ctrl_report_overload,        1, false, -1},
+};
+
+// From the command line before dp_ctrl_loop() starts, or by the ctrl thread to re-arm a
+// running timer. A timer disabled at start stays disabled.
+int dp_ctrl_set_timer_period(const char *name, uint32_t period)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_ENTRIES(g_ctrl_timers); i ++) {
+        dp_ctrl_timer_t *t = &g_ctrl_timers[i];
+
+        if (strcmp(t->name, name) == 0) {
+            t->period = period;
+            if (t->fd >= 0 && period > 0) {
+                struct itimerspec its;
+
+                memset(&its, 0, sizeof(its));
+                its.it_value.tv_sec = its.it_interval.tv_sec = period;
+                timerfd_settime(t->fd, 0, &its, NULL);
+            }
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int dp_ctrl_open_timers(int epoll_fd, bool report)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_ENTRIES(g_ctrl_timers); i ++) {
+        dp_ctrl_timer_t *t = &g_ctrl_timers[i];
+        struct itimerspec its;
+        struct epoll_event ee;
+
+        if (t->report != report || t->period == 0) {
+            continue;
+        }
+
+        t->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (t->fd < 0) {
+            DEBUG_ERROR(DBG_CTRL, "fail to create timer fd, timer=%s\n", t->name);
+            return -1;
+        }
+
+        memset(&its, 0, sizeof(its));
+        its.it_value.tv_sec = its.it_interval.tv_sec = t->period;
+        timerfd_settime(t->fd, 0, &its, NULL);
+
+        ee.events = EPOLLIN;
+        ee.data.ptr = t;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, t->fd, &ee) < 0) {
+            DEBUG_ERROR(DBG_CTRL, "fail to add timer to epoll, timer=%s\n", t->name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void dp_ctrl_close_timers(bool report)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_ENTRIES(g_ctrl_timers); i ++) {
+        dp_ctrl_timer_t *t = &g_ctrl_timers[i];
+        if (t->report == report && t->fd >= 0) {
+            close(t->fd);
+            t->fd = -1;
+        }
+    }
+}
+
+static void dp_ctrl_run_timer(dp_ctrl_timer_t *t)
+{
+    uint64_t expired;
+
+    if (read(t->fd, &expired, sizeof(expired)) != sizeof(expired)) {
+        return;
+    }
+    t->handler();
+}
+
+#define CTRL_EPOLL_EVENTS 16
+#define CTRL_EPOLL_WAIT 1000    // ms, to check g_running
+
+static void *dp_ctrl_report_thr(void *args)
+{
+    struct epoll_event epoll_evs[CTRL_EPOLL_EVENTS];
+    int epoll_fd, i, evs;
+
+    strlcpy(THREAD_NAME, "rpt", MAX_THREAD_NAME_LEN);
+
+    rcu_register_thread();
 
-        // Log ring
-        th_data->log_reader = MAX_LOG_ENTRIES - 1;
-        for (i = 0; i < MAX_LOG_ENTRIES; i ++) {
-            DPMsgHdr *hdr = (DPMsgHdr *)th_data->log_ring[i];
-            hdr->Kind = DP_KIND_THREAT_LOG;
-            hdr->Length = htons(LOG_ENTRY_SIZE);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0 || dp_ctrl_open_timers(epoll_fd, true) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to start report timers\n");
+    } else {
+        if (g_log_evfd >= 0) {
+            struct epoll_event ee;
+
+            ee.events = EPOLLIN;
+            ee.data.ptr = NULL;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, g_log_evfd, &ee);
+        }
+        if (g_conn_evfd >= 0) {
+            struct epoll_event ee;
+
+            ee.events = EPOLLIN;
+            ee.data.ptr = &g_conn_evfd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, g_conn_evfd, &ee);
         }
-        
-        // Connection map
-        rcu_map_init(&th_data->conn4_map[0], 128, offsetof(conn_node_t, node),
-                     conn4_match, conn4_hash);
-        rcu_map_init(&th_data->conn4_map[1], 128, offsetof(conn_node_t, node),
-                     conn4_match, conn4_hash);
-        th_data->conn4_map_cnt[0] = 0;
-        th_data->conn4_map_cnt[1] = 0;
-        dp_rate_limiter_reset(&th_data->conn4_rl, CONNECT_RL_DUR, CONNECT_RL_CNT);
-        uatomic_set(&th_data->conn4_map_cur, 0);
+        while (g_running) {
+            evs = epoll_wait(epoll_fd, epoll_evs, CTRL_EPOLL_EVENTS, CTRL_EPOLL_WAIT);
+            for (i = 0; i < evs; i ++) {
+                if (epoll_evs[i].data.ptr == NULL) {
+                    dp_ctrl_log_event();
+                } else if (epoll_evs[i].data.ptr == &g_conn_evfd) {
+                    dp_ctrl_connect_event();
+                } else {
+                    dp_ctrl_run_timer(epoll_evs[i].data.ptr);
+                }
+            }
+        }
+    }
+
+    dp_ctrl_close_timers(true);
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
     }
+
+    rcu_unregister_thread();
+    return NULL;
 }
 
 void dp_ctrl_loop(void)
 {
-    int ret, round = 0;
-    fd_set read_fds;
-    struct timeval timeout;
-    struct timespec last, now;
+    struct epoll_event epoll_evs[CTRL_EPOLL_EVENTS];
+    struct epoll_event ee;
+    pthread_t report_thr;
+    char buf[64];
+    const char *server = dp_instance_name(DP_SERVER_SOCK, buf, sizeof(buf));
+    int epoll_fd, i, evs;
 
     strlcpy(THREAD_NAME, "cmd", MAX_THREAD_NAME_LEN);
 
@@ -3028,50 +5653,52 @@ void dp_ctrl_loop(void)
 
     rcu_register_thread();
 
-    unlink(DP_SERVER_SOCK);
-    g_ctrl_fd = make_named_socket(DP_SERVER_SOCK);
+    unlink(server);
+    g_ctrl_fd = make_named_socket(server);
     g_ctrl_notify_fd = make_notify_client(CTRL_NOTIFY_SOCK);
 
-    pthread_mutex_init(&g_ctrl_req_lock, NULL);
-    pthread_cond_init(&g_ctrl_req_cond, NULL);
     pthread_mutex_init(&g_dlp_ctrl_req_lock, NULL);
-    pthread_cond_init(&g_dlp_ctrl_req_cond, NULL);
-
-    clock_gettime(CLOCK_MONOTONIC, &last);
-    while (g_running) {
-        timeout.tv_sec = 2;
-        timeout.tv_usec = 0;
-
-        FD_ZERO(&read_fds);
-        FD_SET(g_ctrl_fd, &read_fds);
-        ret = select(g_ctrl_fd + 1, &read_fds, NULL, NULL, &timeout);
 
-        if (ret > 0 && FD_ISSET(g_ctrl_fd, &read_fds)) {
-            dp_ctrl_handler(g_ctrl_fd);
-        }
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to create epoll: %s\n", strerror(errno));
+        rcu_unregister_thread();
+        return;
+    }
 
-        clock_gettime(CLOCK_MONOTONIC, &now);
+    ee.events = EPOLLIN;
+    ee.data.ptr = NULL;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, g_ctrl_fd, &ee) < 0 ||
+        dp_ctrl_open_timers(epoll_fd, false) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to add ctrl events to epoll\n");
+        close(epoll_fd);
+        rcu_unregister_thread();
+        return;
+    }
 
-        if (now.tv_sec - last.tv_sec >= 2) {
-            last = now;
+    pthread_create(&report_thr, NULL, dp_ctrl_report_thr, NULL);
 
-            dp_ctrl_update_app(false);
-            dp_ctrl_update_fqdn_ip();
-            dp_ctrl_consume_threat_log();
-            dp_ctrl_update_ip_fqdn_storage();
+    while (g_running) {
+        evs = epoll_wait(epoll_fd, epoll_evs, CTRL_EPOLL_EVENTS, CTRL_EPOLL_WAIT);
+        for (i = 0; i < evs; i ++) {
+            dp_ctrl_timer_t *t = epoll_evs[i].data.ptr;
 
-            // every 6s
-            if ((round % 3) == 0) {
-                dp_ctrl_update_connects();
+            if (t == NULL) {
+                dp_ctrl_handler(g_ctrl_fd);
+            } else {
+                dp_ctrl_run_timer(t);
             }
-
-            round ++;
         }
     }
 
+    pthread_join(report_thr, NULL);
+
+    dp_ctrl_close_timers(false);
+    close(epoll_fd);
+
     close(g_ctrl_notify_fd);
     close(g_ctrl_fd);
-    unlink(DP_SERVER_SOCK);
+    unlink(server);
 
     rcu_map_destroy(&g_ep_map);
 
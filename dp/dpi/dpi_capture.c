@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pcap/pcap.h>
+
+#include "urcu.h"
+
+#include "utils/helper.h"
+
+#include "dpi/dpi_module.h"
+
+// Packets matching the capture are copied by the dp threads into their own ring, from
+// dpi_recv_packet() before they are parsed, and written to a pcapng file by the ctrl
+// thread. Each ring has one writer, its dp thread, and one reader; a packet that doesn't
+// fit is dropped and counted, the dp thread never waits.
+
+#define DPI_CAPTURE_RING_BITS   20
+#define DPI_CAPTURE_RING_SIZE   (1 << DPI_CAPTURE_RING_BITS)
+#define DPI_CAPTURE_RING_MASK   (DPI_CAPTURE_RING_SIZE - 1)
+#define DPI_CAPTURE_MAX_SNAPLEN 65535
+#define DPI_CAPTURE_DEF_LIMIT   10000
+#define DPI_CAPTURE_MAX_LIMIT   1000000
+
+// Records are 16-byte aligned so a header always fits before the end of the ring
+#define DPI_CAPTURE_REC_LEN(caplen) (((uint32_t)sizeof(dpi_capture_rec_t) + (caplen) + 15) & ~15u)
+
+typedef struct dpi_capture_rec_ {
+    uint32_t len;           // on the wire, 0 to skip to the start of the ring
+    uint32_t caplen;
+    uint64_t ts;            // us
+} dpi_capture_rec_t;
+
+typedef struct dpi_capture_ring_ {
+    uint32_t writer __attribute__((aligned(64)));   // moved by the dp thread
+    uint64_t drops;
+    uint32_t reader __attribute__((aligned(64)));   // moved by the ctrl thread
+    uint8_t data[DPI_CAPTURE_RING_SIZE] __attribute__((aligned(64)));
+} dpi_capture_ring_t;
+
+typedef struct dpi_capture_ {
+    struct ether_addr mac;
+    bool all_eps;
+    bool has_filter;
+    struct bpf_program filter;
+    uint32_t snaplen;
+    uint32_t limit;
+    uint32_t taken;         // matched packets, claimed by the dp threads
+    FILE *fp;
+    uint64_t packets, bytes;
+    dpi_capture_ring_t *rings[MAX_DP_THREADS];
+} dpi_capture_t;
+
+dpi_capture_t *g_capture;
+
+// Counts of the capture that ran last, only the ctrl thread uses them
+static DPMsgCapture g_capture_last;
+
+void dpi_capture_packet(dpi_packet_t *p)
+{
+    dpi_capture_t *cap = rcu_dereference(g_capture);
+    dpi_capture_ring_t *r;
+    dpi_capture_rec_t *rec;
+    struct timespec ts;
+    uint32_t caplen, need, wr, off;
+
+    if (cap == NULL || p->cap_len == 0) {
+        return;
+    }
+    if (!cap->all_eps && (p->ep_mac == NULL || !mac_cmp(p->ep_mac, cap->mac.ether_addr_octet))) {
+        return;
+    }
+    if (cap->has_filter && bpf_filter(cap->filter.bf_insns, p->pkt, p->cap_len, p->cap_len) == 0) {
+        return;
+    }
+    if (uatomic_read(&cap->taken) >= cap->limit || uatomic_add_return(&cap->taken, 1) > cap->limit) {
+        return;
+    }
+
+    r = cap->rings[g_dpi_thread - g_dpi_thread_data];
+    caplen = min(p->cap_len, cap->snaplen);
+    need = DPI_CAPTURE_REC_LEN(caplen);
+    wr = r->writer;
+    off = wr & DPI_CAPTURE_RING_MASK;
+
+    // Skip the end of the ring if the record would wrap
+    if (DPI_CAPTURE_RING_SIZE - off < need) {
+        if (DPI_CAPTURE_RING_SIZE - (wr - uatomic_read(&r->reader)) < DPI_CAPTURE_RING_SIZE - off + need) {
+            uatomic_set(&r->drops, r->drops + 1);
+            return;
+        }
+        ((dpi_capture_rec_t *)(r->data + off))->len = 0;
+        wr += DPI_CAPTURE_RING_SIZE - off;
+        off = 0;
+    } else if (DPI_CAPTURE_RING_SIZE - (wr - uatomic_read(&r->reader)) < need) {
+        uatomic_set(&r->drops, r->drops + 1);
+        return;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    rec = (dpi_capture_rec_t *)(r->data + off);
+    rec->len = p->cap_len;
+    rec->caplen = caplen;
+    rec->ts = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    memcpy(rec + 1, p->pkt, caplen);
+
+    cmm_smp_wmb();
+    uatomic_set(&r->writer, wr + need);
+}
+
+// -- pcapng
+
+static void pcapng_block(FILE *fp, uint32_t type, const void *body, uint32_t len,
+                         const void *data, uint32_t data_len)
+{
+    static const uint8_t pad[4];
+    uint32_t data_pad = (4 - (data_len & 3)) & 3;
+    uint32_t total = 12 + len + data_len + data_pad;
+
+    fwrite(&type, sizeof(type), 1, fp);
+    fwrite(&total, sizeof(total), 1, fp);
+    fwrite(body, len, 1, fp);
+    if (data_len > 0) {
+        fwrite(data, data_len, 1, fp);
+        fwrite(pad, data_pad, 1, fp);
+    }
+    fwrite(&total, sizeof(total), 1, fp);
+}
+
+// Section header and one ethernet interface, in host order as the magic tells readers
+static void pcapng_header(FILE *fp, uint32_t snaplen)
+{
+    struct {
+        uint32_t magic;
+        uint16_t major, minor;
+        int64_t section_len;
+    } __attribute__((packed)) shb = {0x1a2b3c4d, 1, 0, -1};
+    struct {
+        uint16_t linktype, reserved;
+        uint32_t snaplen;
+    } idb = {DLT_EN10MB, 0, snaplen};
+
+    pcapng_block(fp, 0x0a0d0d0a, &shb, sizeof(shb), NULL, 0);
+    pcapng_block(fp, 0x00000001, &idb, sizeof(idb), NULL, 0);
+}
+
+static void pcapng_packet(FILE *fp, dpi_capture_rec_t *rec)
+{
+    struct {
+        uint32_t if_id;
+        uint32_t ts_high, ts_low;
+        uint32_t caplen, len;
+    } epb = {0, rec->ts >> 32, (uint32_t)rec->ts, rec->caplen, rec->len};
+
+    pcapng_block(fp, 0x00000006, &epb, sizeof(epb), rec + 1, rec->caplen);
+}
+
+// -- ctrl
+
+static void dpi_capture_drain_ring(dpi_capture_t *cap, dpi_capture_ring_t *r)
+{
+    uint32_t rd = r->reader, wr = uatomic_read(&r->writer);
+
+    cmm_smp_rmb();
+
+    while (rd != wr) {
+        uint32_t off = rd & DPI_CAPTURE_RING_MASK;
+        dpi_capture_rec_t *rec = (dpi_capture_rec_t *)(r->data + off);
+
+        if (rec->len == 0) {
+            rd += DPI_CAPTURE_RING_SIZE - off;
+            continue;
+        }
+        pcapng_packet(cap->fp, rec);
+        cap->packets ++;
+        cap->bytes += rec->caplen;
+        rd += DPI_CAPTURE_REC_LEN(rec->caplen);
+    }
+
+    cmm_smp_mb();
+    uatomic_set(&r->reader, rd);
+}
+
+static void dpi_capture_free(dpi_capture_t *cap)
+{
+    int i;
+
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        free(cap->rings[i]);
+    }
+    if (cap->has_filter) {
+        pcap_freecode(&cap->filter);
+    }
+    if (cap->fp != NULL) {
+        fclose(cap->fp);
+    }
+    free(cap);
+}
+
+int dpi_capture_start(io_capture_t *c)
+{
+    dpi_capture_t *cap;
+    int i;
+
+    if (g_capture != NULL) {
+        DEBUG_ERROR(DBG_CTRL, "capture is running\n");
+        return -1;
+    }
+
+    cap = calloc(1, sizeof(*cap));
+    if (cap == NULL) {
+        return -1;
+    }
+
+    cap->mac = c->mac;
+    cap->all_eps = mac_zero(c->mac.ether_addr_octet);
+    cap->snaplen = (c->snaplen == 0 || c->snaplen > DPI_CAPTURE_MAX_SNAPLEN) ? DPI_CAPTURE_MAX_SNAPLEN : c->snaplen;
+    cap->limit = c->limit == 0 ? DPI_CAPTURE_DEF_LIMIT : min(c->limit, DPI_CAPTURE_MAX_LIMIT);
+
+    if (c->filter != NULL && c->filter[0] != '\0') {
+        if (pcap_compile_nopcap(cap->snaplen, DLT_EN10MB, &cap->filter, c->filter, 1,
+                                PCAP_NETMASK_UNKNOWN) < 0) {
+            DEBUG_ERROR(DBG_CTRL, "invalid capture filter: %s\n", c->filter);
+            free(cap);
+            return -1;
+        }
+        cap->has_filter = true;
+    }
+
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        if (posix_memalign((void **)&cap->rings[i], 64, sizeof(dpi_capture_ring_t)) != 0) {
+            cap->rings[i] = NULL;
+            dpi_capture_free(cap);
+            return -1;
+        }
+        cap->rings[i]->writer = cap->rings[i]->reader = 0;
+        cap->rings[i]->drops = 0;
+    }
+
+    cap->fp = fopen(c->path, "w");
+    if (cap->fp == NULL) {
+        DEBUG_ERROR(DBG_CTRL, "fail to open %s: %s\n", c->path, strerror(errno));
+        dpi_capture_free(cap);
+        return -1;
+    }
+    pcapng_header(cap->fp, cap->snaplen);
+
+    DEBUG_CTRL("mac="DBG_MAC_FORMAT" snaplen=%u limit=%u path=%s\n",
+               DBG_MAC_TUPLE(cap->mac), cap->snaplen, cap->limit, c->path);
+
+    memset(&g_capture_last, 0, sizeof(g_capture_last));
+    rcu_assign_pointer(g_capture, cap);
+    return 0;
+}
+
+void dpi_capture_stop(void)
+{
+    dpi_capture_t *cap = g_capture;
+    int i;
+
+    if (cap == NULL) {
+        return;
+    }
+
+    rcu_assign_pointer(g_capture, NULL);
+    synchronize_rcu();
+
+    g_capture_last.Limit = cap->limit;
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        dpi_capture_drain_ring(cap, cap->rings[i]);
+        g_capture_last.Drops += cap->rings[i]->drops;
+    }
+    g_capture_last.Packets = cap->packets;
+    g_capture_last.Bytes = cap->bytes;
+
+    DEBUG_CTRL("packets=%ju drops=%ju\n", g_capture_last.Packets, g_capture_last.Drops);
+
+    dpi_capture_free(cap);
+}
+
+// On the ctrl timer. The capture ends once the limit is reached and the rings are empty.
+void dpi_capture_drain(void)
+{
+    dpi_capture_t *cap = g_capture;
+    bool done;
+    int i;
+
+    if (cap == NULL) {
+        return;
+    }
+
+    done = uatomic_read(&cap->taken) >= cap->limit;
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        dpi_capture_drain_ring(cap, cap->rings[i]);
+    }
+    fflush(cap->fp);
+
+    if (done) {
+        dpi_capture_stop();
+    }
+}
+
+void dpi_capture_status(DPMsgCapture *m)
+{
+    dpi_capture_t *cap = g_capture;
+    int i;
+
+    if (cap == NULL) {
+        *m = g_capture_last;
+        return;
+    }
+
+    memset(m, 0, sizeof(*m));
+    m->Active = 1;
+    m->Limit = cap->limit;
+    m->Packets = cap->packets;
+    m->Bytes = cap->bytes;
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        m->Drops += uatomic_read(&cap->rings[i]->drops);
+    }
+}
@@ -14,18 +14,74 @@
 
 #include "dpi/dpi_module.h"
 
-bool debug_log_packet_filter(const dpi_packet_t *p)
+debug_filter_t g_debug_filter;
+
+// Called by the ctrl thread. The dp threads see the new filter from their next packet, a
+// packet being handled may log with the old one.
+void dpi_debug_set_filter(const struct ether_addr *mac, uint32_t ip)
+{
+    uatomic_set(&g_debug_filter.on, false);
+    cmm_smp_wmb();
+
+    g_debug_filter.has_mac = mac != NULL;
+    if (mac != NULL) {
+        memcpy(g_debug_filter.mac, mac->ether_addr_octet, ETH_ALEN);
+    }
+    g_debug_filter.has_ip = ip != 0;
+    g_debug_filter.ip = ip;
+
+    cmm_smp_wmb();
+    uatomic_set(&g_debug_filter.on, g_debug_filter.has_mac || g_debug_filter.has_ip);
+}
+
+// Errors are logged for all traffic
+static inline uint32_t debug_filter_levels(bool match)
+{
+    return match ? g_debug_levels : g_debug_levels & DBG_ERROR;
+}
+
+// With the filter on. The packet is not parsed yet, its IPv4 header is looked at in place.
+uint32_t debug_log_packet_levels(const dpi_packet_t *p)
 {
-    if (p == NULL) return true;
+    if (p == NULL) {
+        return debug_filter_levels(false);
+    }
+
+    if (g_debug_filter.has_mac && p->ep_mac != NULL &&
+        memcmp(p->ep_mac, g_debug_filter.mac, ETH_ALEN) == 0) {
+        return debug_filter_levels(true);
+    }
+    if (g_debug_filter.has_ip && p->cap_len >= sizeof(struct ethhdr) + sizeof(struct iphdr)) {
+        struct ethhdr *eth = (struct ethhdr *)(p->pkt + p->l2);
+        struct iphdr *iph = (struct iphdr *)(p->pkt + p->l2 + sizeof(struct ethhdr));
+
+        if (eth->h_proto == htons(ETH_P_IP) &&
+            (iph->saddr == g_debug_filter.ip || iph->daddr == g_debug_filter.ip)) {
+            return debug_filter_levels(true);
+        }
+    }
+    return debug_filter_levels(false);
+}
 
-    return true;
+uint32_t debug_log_session_levels(const dpi_session_t *s)
+{
+    return debug_filter_levels(debug_log_session_filter(s));
 }
 
 bool debug_log_session_filter(const dpi_session_t *s)
 {
-    if (s == NULL) return true;
+    if (s == NULL || !g_debug_filter.on) return true;
 
-    return true;
+    if (g_debug_filter.has_mac &&
+        (memcmp(s->client.mac, g_debug_filter.mac, ETH_ALEN) == 0 ||
+         memcmp(s->server.mac, g_debug_filter.mac, ETH_ALEN) == 0)) {
+        return true;
+    }
+    if (g_debug_filter.has_ip && (s->flags & DPI_SESS_FLAG_IPV4) &&
+        (s->client.ip.ip4 == g_debug_filter.ip || s->server.ip.ip4 == g_debug_filter.ip)) {
+        return true;
+    }
+    return false;
 }
 
 void debug_log(bool print_ts, const char *fmt, ...)
@@ -5,8 +5,32 @@
 
 #include "debug.h"
 
+// Debug filter of dp_ctrl_set_debug, the packet and session logs are limited to the traffic
+// of the endpoint MAC or the IPv4 address
+typedef struct debug_filter_ {
+    uint8_t mac[ETH_ALEN];
+    uint32_t ip;
+    bool has_mac, has_ip;
+    bool on;
+} debug_filter_t;
+
+extern debug_filter_t g_debug_filter;
+
+// The packet and session logs check th_debug, the debug levels of what the thread is handling.
+// It is set once per packet and per session timer, and follows g_debug_levels unless a filter
+// is on. The filter was applied already, the packet argument is only evaluated.
+#ifdef DPI_NO_PKT_DEBUG
 #define IF_DEBUG_LOG(level, p) \
-        if (unlikely((g_debug_levels & (level)) && debug_log_packet_filter(p)))
+        if ((void)(p), 0)
+#else
+#define IF_DEBUG_LOG(level, p) \
+        if ((void)(p), unlikely(th_debug & (level)))
+#endif
+
+#define DEBUG_LOG_FILTER_PACKET(p) \
+        (th_debug = likely(!g_debug_filter.on) ? g_debug_levels : debug_log_packet_levels(p))
+#define DEBUG_LOG_FILTER_SESSION(s) \
+        (th_debug = likely(!g_debug_filter.on) ? g_debug_levels : debug_log_session_levels(s))
 
 #define DEBUG_LOG_NO_FILTER(format, args...) \
         debug_log(true, "%s: "format, __FUNCTION__, ##args)
@@ -18,7 +42,9 @@
         IF_DEBUG_LOG(level, p) { DEBUG_LOG_NO_FILTER("enter\n"); }
 
 void debug_log(bool print_ts, const char *fmt, ...);
-bool debug_log_packet_filter(const dpi_packet_t *p);
+uint32_t debug_log_packet_levels(const dpi_packet_t *p);
+uint32_t debug_log_session_levels(const dpi_session_t *s);
+bool debug_log_session_filter(const dpi_session_t *s);
 
 void debug_dump_hex(const uint8_t *ptr, int len);
 void debug_dump_packet(const dpi_packet_t *p);
@@ -11,6 +11,7 @@
 #include "utils/helper.h"
 #include "utils/timer_wheel.h"
 #include "utils/rcu_map.h"
+#include "utils/cksum.h"
 #include "dpi/dpi_module.h"
 #include "dpi/sig/dpi_search.h"
 
@@ -19,10 +20,19 @@ extern void dpi_parser_setup(void);
 extern void sql_injection_init(void);
 extern void dpi_dlp_init(void);
 
+#define DPI_TIMER_BUDGET        256     // entries expired by a roll
+#define DPI_TIMER_BACKLOG_CAP   65536
+
 io_callback_t *g_io_callback;
 io_config_t *g_io_config;
 
+static void dpi_reset_setup(void);
+
 dpi_thread_data_t g_dpi_thread_data[MAX_DP_THREADS];
+__thread dpi_thread_data_t *g_dpi_thread = &g_dpi_thread_data[0];
+
+// Stages of threads that are not watched by the monitor
+static dp_mnt_stage_t g_dpi_stage_private[MAX_DP_THREADS];
 
 // Global
 void dpi_setup(io_callback_t *cb, io_config_t *cfg)
@@ -33,11 +43,15 @@ void dpi_setup(io_callback_t *cb, io_config_t *cfg)
     dpi_packet_setup();
     dpi_parser_setup();
     dpi_dlp_init();
+    dpi_reset_setup();
 }
 
 // Per DP thread
 void dpi_init(int reason)
 {
+    g_dpi_thread = &g_dpi_thread_data[THREAD_ID];
+    th_stage = &g_dpi_stage_private[THREAD_ID];
+
     th_packet.defrag_data = malloc(DPI_MAX_PKT_LEN);
     th_packet.asm_pkt.ptr = malloc(DPI_MAX_PKT_LEN);
     th_packet.decoded_pkt.ptr = malloc(DPI_MAX_PKT_LEN);
@@ -53,6 +67,30 @@ void dpi_init(int reason)
     sql_injection_init();
 }
 
+// Publish the stage of the calling thread in the monitor's page, after dpi_init()
+void dpi_stage_attach(dp_mnt_stage_t *stage)
+{
+    th_stage = stage;
+}
+
+// The monitor's soft watchdog found the thread stuck on a packet of this session. Parsers
+// and pattern match are stopped for the session so its next packets can't stall it again.
+void dpi_stage_quarantine(void)
+{
+    dp_mnt_stage_t *st = th_stage;
+    uint32_t id = CMM_LOAD_SHARED(st->quarantine);
+    dpi_session_t *s = th_packet.session;
+
+    if (s != NULL && s->id == id) {
+        FLAGS_SET(s->flags, DPI_SESS_FLAG_SKIP_PARSER | DPI_SESS_FLAG_IGNOR_PATTERN);
+        s->verdict_cached = false;
+        CMM_STORE_SHARED(st->quarantined, st->quarantined + 1);
+        DEBUG_ERROR(DBG_SESSION, "quarantine session=%u ep="DBG_MAC_FORMAT" stage=%u\n",
+                    id, DBG_MAC_TUPLE(st->ep_mac), st->stage);
+    }
+    CMM_STORE_SHARED(st->quarantine, 0);
+}
+
 io_app_t *dpi_ep_app_map_lookup(io_ep_t *ep, uint16_t port, uint8_t ip_proto)
 {
     io_app_t key;
@@ -84,6 +122,25 @@ static io_app_t *ep_app_map_locate(io_ep_t *ep, uint16_t port, uint8_t ip_proto)
     return app;
 }
 
+// Queue the endpoint on its first change since the ctrl thread last reported its apps
+static void ep_app_updated(io_ep_t *ep)
+{
+    dpi_app_dirty_t *q = &th_app_dirty;
+    uint32_t wr;
+
+    if (uatomic_cmpxchg(&ep->app_updated, 0, 1) != 0) return;
+    if (unlikely(ep->mac == NULL)) return;
+
+    wr = q->writer;
+    if (unlikely(wr - uatomic_read(&q->reader) >= DPI_APP_DIRTY_ENTRIES)) {
+        uatomic_set(&q->overflow, 1);
+        return;
+    }
+    q->macs[wr % DPI_APP_DIRTY_ENTRIES] = ep->mac->mac;
+    cmm_smp_wmb();
+    uatomic_set(&q->writer, wr + 1);
+}
+
 void dpi_ep_set_proto(dpi_packet_t *p, uint16_t proto)
 {
     dpi_session_t *s = p->session;
@@ -98,7 +155,7 @@ void dpi_ep_set_proto(dpi_packet_t *p, uint16_t proto)
 
     if (proto != 0 && unlikely(app->proto != proto)) {
         app->proto = proto;
-        uatomic_set(&p->ep->app_updated, 1);
+        ep_app_updated(p->ep);
     }
 }
 
@@ -128,11 +185,11 @@ void dpi_ep_set_app(dpi_packet_t *p, uint16_t server, uint16_t application)
 
     if (server != 0 && unlikely(app->server != server)) {
         app->server = server;
-        uatomic_set(&p->ep->app_updated, 1);
+        ep_app_updated(p->ep);
     }
     if (application != 0 && unlikely(app->application != application)) {
         app->application = application;
-        uatomic_set(&p->ep->app_updated, 1);
+        ep_app_updated(p->ep);
     }
 }
 
@@ -183,6 +240,13 @@ bool dpi_is_ip4_internal(uint32_t ip)
         || ip == htonl(INADDR_LOOPBACK) || IS_IN_LOOPBACK(ntohl(ip))) {
         return true;
     }
+    if (likely(th_internal_subnet4->lpm != NULL)) {
+        if (ip4_lpm_lookup(th_internal_subnet4->lpm, ip) >= 0) {
+            return true;
+        }
+        DEBUG_LOG(DBG_SESSION, NULL, "internal:false\n");
+        return false;
+    }
     for (i = 0; i < th_internal_subnet4->count; i++) {
         /*
         DEBUG_LOG(DBG_SESSION, NULL,
@@ -205,6 +269,13 @@ uint8_t dpi_ip4_iptype(uint32_t ip)
     if (unlikely(th_specialip_subnet4 == NULL)) {
         return DP_IPTYPE_NONE;
     }
+    if (likely(th_specialip_subnet4->lpm != NULL)) {
+        if ((i = ip4_lpm_lookup(th_specialip_subnet4->lpm, ip)) >= 0) {
+            DEBUG_LOG(DBG_SESSION, NULL, "iptype(%d)\n", th_specialip_subnet4->list[i].iptype);
+            return th_specialip_subnet4->list[i].iptype;
+        }
+        return DP_IPTYPE_NONE;
+    }
     for (i = 0; i < th_specialip_subnet4->count; i++) {
 
         /*DEBUG_LOG(DBG_SESSION, NULL,
@@ -227,6 +298,13 @@ bool dpi_is_policy_addr(uint32_t ip)
     if (unlikely(th_policy_addr == NULL)) {
         return false;
     }
+    if (likely(th_policy_addr->set != NULL)) {
+        if (ip4_set_lookup(th_policy_addr->set, ip)) {
+            return true;
+        }
+        DEBUG_LOG(DBG_SESSION, NULL, "unknown:ip\n");
+        return false;
+    }
     for (i = 0; i < th_policy_addr->count; i++) {
     /*
         DEBUG_LOG(DBG_SESSION, NULL,
@@ -249,14 +327,64 @@ bool cmp_mac_prefix(void *m1, void *prefix)
     return *(uint32_t *)m1 == *(uint32_t *)prefix;
 }
 
-void dpi_inject_reset_by_session(dpi_session_t *sess, bool to_server)
+typedef struct reset_frame_ {
+    struct ethhdr eth;
+    struct iphdr ip;
+    struct tcphdr tcp;
+} __attribute__((packed)) reset_frame_t;
+
+// Fields that are the same in all resets, with their part of the checksums. A reset is the
+// template with the addresses, ports and seq of the session added to the sums.
+static reset_frame_t g_reset_tmpl;
+static uint32_t g_reset_ip_sum, g_reset_tcp_sum;
+
+static void dpi_reset_setup(void)
+{
+    reset_frame_t *f = &g_reset_tmpl;
+    uint16_t pseudo[2] = {htons(IPPROTO_TCP), htons(sizeof(struct tcphdr))};
+
+    f->eth.h_proto = htons(ETH_P_IP);
+
+    f->ip.version = 4;
+    f->ip.ihl = sizeof(struct iphdr) >> 2;
+    f->ip.tot_len = htons(sizeof(struct iphdr) + sizeof(struct tcphdr));
+    f->ip.frag_off = htons(0x4000);
+    f->ip.ttl = 0xff;
+    f->ip.protocol = IPPROTO_TCP;
+
+    f->tcp.th_off = sizeof(struct tcphdr) >> 2;
+    f->tcp.th_flags = TH_RST;
+
+    g_reset_ip_sum = cksum_partial(&f->ip, sizeof(f->ip), 0);
+    g_reset_tcp_sum = cksum_partial(&f->tcp, sizeof(f->tcp), cksum_partial(pseudo, sizeof(pseudo), 0));
+}
+
+static inline uint32_t reset_sum32(uint32_t sum, uint32_t v)
+{
+    return sum + (v >> 16) + (v & 0xffff);
+}
+
+// Send the resets queued by the batch
+void dpi_reset_flush(void)
 {
     io_ctx_t ctx;
-    struct ethhdr *eth;
-    struct iphdr *iph;
-    struct tcphdr *tcph;
-    uint8_t buffer[sizeof(struct ethhdr) + sizeof(struct iphdr) + sizeof(struct tcphdr)];
+    uint32_t i;
+
+    if (likely(th_reset_count == 0)) return;
+
+    memset(&ctx, 0, sizeof(ctx));
+    for (i = 0; i < th_reset_count; i ++) {
+        g_io_callback->send_packet(&ctx, th_reset_queue[i], sizeof(reset_frame_t));
+    }
+    th_reset_count = 0;
+}
+
+void dpi_inject_reset_by_session(dpi_session_t *sess, bool to_server)
+{
+    reset_frame_t *f;
     dpi_wing_t *c = &sess->client, *s = &sess->server;
+    uint32_t saddr, daddr, seq;
+    uint16_t sport, dport, id;
 
     if (FLAGS_TEST(sess->flags, DPI_SESS_FLAG_TAP)) return;
     if (FLAGS_TEST(sess->flags, DPI_SESS_FLAG_PROXYMESH)) return;
@@ -277,84 +405,128 @@ void dpi_inject_reset_by_session(dpi_session_t *sess, bool to_server)
     }
     if (mac == NULL) return;
 
-    memset(&ctx, 0, sizeof(ctx));
+    if (unlikely(th_reset_count == DPI_RESET_QUEUE)) {
+        dpi_reset_flush();
+    }
+    f = (reset_frame_t *)th_reset_queue[th_reset_count ++];
+    *f = g_reset_tmpl;
 
     // L2
-    eth = (struct ethhdr *)buffer;
-    eth->h_proto = htons(ETH_P_IP);
     uint8_t *uc_mac = mac->ep->ucmac->mac.ether_addr_octet;
     if (sess->flags & DPI_SESS_FLAG_INGRESS) {
         if (to_server) {
-            mac_cpy(eth->h_source, c->mac);
-            mac_cpy(eth->h_dest, uc_mac);
+            mac_cpy(f->eth.h_source, c->mac);
+            mac_cpy(f->eth.h_dest, uc_mac);
         } else {
-            mac_cpy(eth->h_source, uc_mac);
-            mac_cpy(eth->h_dest, c->mac);
+            mac_cpy(f->eth.h_source, uc_mac);
+            mac_cpy(f->eth.h_dest, c->mac);
         }
     } else {
         if (to_server) {
-            mac_cpy(eth->h_source, uc_mac);
-            mac_cpy(eth->h_dest, c->mac);
+            mac_cpy(f->eth.h_source, uc_mac);
+            mac_cpy(f->eth.h_dest, c->mac);
         } else {
-            mac_cpy(eth->h_source, c->mac);
-            mac_cpy(eth->h_dest, uc_mac);
+            mac_cpy(f->eth.h_source, c->mac);
+            mac_cpy(f->eth.h_dest, uc_mac);
         }
     }
 
+    if (to_server) {
+        saddr = c->ip.ip4;
+        daddr = s->ip.ip4;
+        sport = htons(c->port);
+        dport = htons(s->port);
+        seq = htonl(c->next_seq);
+    } else {
+        saddr = s->ip.ip4;
+        daddr = c->ip.ip4;
+        sport = htons(s->port);
+        dport = htons(c->port);
+        // The client sees the server's seq shifted by the syn proxy
+        seq = htonl(s->next_seq + (sess->syn_proxy == DPI_SYN_PROXY_ON ? sess->syn_delta : 0));
+    }
+    id = htons((u_int16_t)rand());
+
     // L3
-    iph = (struct iphdr *)(buffer + sizeof(struct ethhdr));
+    f->ip.id = id;
+    f->ip.saddr = saddr;
+    f->ip.daddr = daddr;
+    f->ip.check = cksum_finish(reset_sum32(reset_sum32(g_reset_ip_sum + id, saddr), daddr));
+
+    // L4, ack and window are left 0
+    f->tcp.th_sport = sport;
+    f->tcp.th_dport = dport;
+    f->tcp.th_seq = seq;
+    f->tcp.th_sum = cksum_finish(reset_sum32(reset_sum32(reset_sum32(g_reset_tcp_sum + sport + dport, saddr), daddr), seq));
+}
+
+void dpi_inject_reset(dpi_packet_t *p, bool to_server)
+{
+    if (unlikely(p->session == NULL)) return;
+
+    dpi_inject_reset_by_session(p->session, to_server);
+}
+
+// Send an ipv4 tcp segment without payload on the flow of the packet, in the same direction
+// or as a reply. 'mss' adds the MSS option if not 0.
+int dpi_inject_tcp(dpi_packet_t *p, bool reply, uint32_t seq, uint32_t ack, uint8_t flags,
+                   uint16_t win, uint16_t mss)
+{
+    io_ctx_t ctx;
+    struct ethhdr *eth;
+    struct iphdr *iph, *piph = (struct iphdr *)(p->pkt + p->l3);
+    struct tcphdr *tcph, *ptcph = (struct tcphdr *)(p->pkt + p->l4);
+    uint8_t buffer[sizeof(struct ethhdr) + 4 + sizeof(struct iphdr) + sizeof(struct tcphdr) + 4];
+    uint16_t l4_len = sizeof(struct tcphdr) + (mss > 0 ? 4 : 0);
+
+    if (unlikely(p->l3 > sizeof(struct ethhdr) + 4)) return -1;
+
+    // L2, vlan tag kept
+    memcpy(buffer, p->pkt, p->l3);
+    eth = (struct ethhdr *)buffer;
+    if (reply) {
+        mac_cpy(eth->h_dest, ((struct ethhdr *)p->pkt)->h_source);
+        mac_cpy(eth->h_source, ((struct ethhdr *)p->pkt)->h_dest);
+    }
+
+    // L3
+    iph = (struct iphdr *)(buffer + p->l3);
     iph->version = 4;
     iph->ihl = sizeof(struct iphdr) >> 2;
     iph->tos = 0;
-    iph->tot_len = htons(sizeof(struct iphdr) + sizeof(struct tcphdr));
+    iph->tot_len = htons(sizeof(struct iphdr) + l4_len);
     iph->id = htons((u_int16_t)rand());
-    iph->frag_off = htons(0x4000); 
+    iph->frag_off = htons(0x4000);
     iph->ttl = 0xff;
     iph->protocol = IPPROTO_TCP;
     iph->check = 0;
-    if (to_server) {
-        iph->saddr = c->ip.ip4;
-        iph->daddr = s->ip.ip4;
-    } else {
-        iph->daddr = c->ip.ip4;
-        iph->saddr = s->ip.ip4;
-    }
+    iph->saddr = reply ? piph->daddr : piph->saddr;
+    iph->daddr = reply ? piph->saddr : piph->daddr;
     iph->check = get_ip_cksum(iph);
-    
+
     // L4
-    tcph = (struct tcphdr *)(buffer + sizeof(struct ethhdr) + sizeof(struct iphdr));
-    if (to_server) {
-        tcph->th_sport = htons(c->port);
-        tcph->th_dport = htons(s->port);
-        tcph->th_seq = htonl(c->next_seq);
-        // tcph->th_ack = htonl(s->tcp_acked);
-        // tcph->th_win = htons(c->tcp_win >> c->tcp_wscale);
-        tcph->th_ack = 0;
-        tcph->th_win = 0;
-    } else {
-        tcph->th_dport = htons(c->port);
-        tcph->th_sport = htons(s->port);
-        tcph->th_seq = htonl(s->next_seq);
-        // tcph->th_ack = htonl(c->tcp_acked);
-        // tcph->th_win = htons(s->tcp_win >> s->tcp_wscale);
-        tcph->th_ack = 0;
-        tcph->th_win = 0;
-    }
-    tcph->th_off = sizeof(struct tcphdr) >> 2;
+    tcph = (struct tcphdr *)((uint8_t *)iph + sizeof(struct iphdr));
+    tcph->th_sport = reply ? ptcph->th_dport : ptcph->th_sport;
+    tcph->th_dport = reply ? ptcph->th_sport : ptcph->th_dport;
+    tcph->th_seq = htonl(seq);
+    tcph->th_ack = htonl(ack);
+    tcph->th_off = l4_len >> 2;
     tcph->th_x2 = 0;
-    tcph->th_flags = TH_RST;
+    tcph->th_flags = flags;
+    tcph->th_win = htons(win);
     tcph->th_sum = 0;
     tcph->th_urp = 0;
-    tcph->th_sum = get_l4v4_cksum(iph, tcph, sizeof(struct tcphdr));
+    if (mss > 0) {
+        uint8_t *opt = (uint8_t *)(tcph + 1);
 
-    g_io_callback->send_packet(&ctx, buffer, sizeof(buffer));
-}
-
-void dpi_inject_reset(dpi_packet_t *p, bool to_server)
-{
-    if (unlikely(p->session == NULL)) return;
+        opt[0] = TCPOPT_MAXSEG;
+        opt[1] = TCPOLEN_MAXSEG;
+        *(uint16_t *)(opt + 2) = htons(mss);
+    }
+    tcph->th_sum = get_l4v4_cksum(iph, tcph, l4_len);
 
-    dpi_inject_reset_by_session(p->session, to_server);
+    memset(&ctx, 0, sizeof(ctx));
+    return g_io_callback->send_packet(&ctx, buffer, p->l3 + sizeof(struct iphdr) + l4_len) < 0 ? -1 : 0;
 }
 
 // return true if packet is ingress to i/f
@@ -413,49 +585,138 @@ static bool proxymesh_packet_direction(dpi_packet_t *p)
     return false;
 }
 
-//return value is only used by nfq, 0 means accept, 1 drop
-int dpi_recv_packet(io_ctx_t *ctx, uint8_t *ptr, int len)
+#define DPI_RECV_PREFETCH 4        // packets ahead of the one being inspected
+
+// Charge the packet to the rate limit of its endpoint, true if it is over the limit
+static inline bool dpi_rate_check(io_rate_limit_t *rl, int dir, int len)
 {
-    int action,c;
+    io_rate_bucket_t *b = &rl->bucket[g_dpi_thread - g_dpi_thread_data][dir];
+    uint64_t now = tsc_read(), pkt_due = b->pkt_due, byte_due = b->byte_due;
+
+    if (rl->pkt_cost[dir] != 0) {
+        if (pkt_due < now) pkt_due = now;
+        if (pkt_due > now + rl->burst) return true;
+    }
+    if (rl->byte_cost[dir] != 0) {
+        if (byte_due < now) byte_due = now;
+        if (byte_due > now + rl->burst) return true;
+    }
+    b->pkt_due = pkt_due + rl->pkt_cost[dir];
+    b->byte_due = byte_due + ((rl->byte_cost[dir] * len) >> IO_RATE_BYTE_SHIFT);
+    return false;
+}
+
+// Packets of a non-tap endpoint over its rate limit are dropped before they are inspected
+static inline bool dpi_rate_limited(dpi_packet_t *p, int len)
+{
+    io_rate_limit_t *rl = rcu_dereference(p->ep->rate_limit);
+    int dir;
+
+    if (likely(rl == NULL)) {
+        return false;
+    }
+    dir = FLAGS_TEST(p->flags, DPI_PKT_FLAG_INGRESS) ? IO_RATE_INGRESS : IO_RATE_EGRESS;
+    if (likely(!dpi_rate_check(rl, dir, len))) {
+        return false;
+    }
+    p->ep_all_metry->rate_drop ++;
+    p->all_metry->rate_drop ++;
+    return true;
+}
+
+// Copy the config only after ctrl changed it. ctrl bumps the version before waiting
+// for the grace period, so an old pointer is never used after it is freed.
+static inline void dpi_recv_cfg_refresh(void)
+{
+    if (unlikely(th_cfg_ver != CMM_LOAD_SHARED(g_dp_cfg_ver))) {
+        th_cfg_ver = CMM_LOAD_SHARED(g_dp_cfg_ver);
+        cmm_smp_rmb();
+        th_internal_subnet4 = g_internal_subnet4;
+        th_policy_addr = g_policy_addr;
+        th_specialip_subnet4 = g_specialip_subnet4;
+        th_xff_enabled = g_xff_enabled;
+        th_disable_net_policy = g_disable_net_policy;
+        th_detect_unmanaged_wl = g_detect_unmanaged_wl;
+    }
+}
+
+// A non-tc port context serves one endpoint, remember it on the context. Only found
+// entries are kept, an entry can't be freed before ctrl bumps g_ep_map_gen.
+static inline io_mac_t *dpi_ep_mac_lookup(io_ctx_t *ctx, const void *mac)
+{
+    io_ep_cache_t *cache = ctx->ep_cache;
+    uint32_t gen;
+    io_mac_t *entry;
+
+    if (cache == NULL) {
+        return rcu_map_lookup(&g_ep_map, mac);
+    }
+
+    gen = CMM_LOAD_SHARED(g_ep_map_gen);
+    if (likely(cache->gen == gen && mac_cmp(cache->mac.ether_addr_octet, (uint8_t *)mac))) {
+        return cache->entry;
+    }
+
+    cmm_smp_rmb();
+    entry = rcu_map_lookup(&g_ep_map, mac);
+    if (entry != NULL) {
+        cache->gen = gen;
+        cache->entry = entry;
+        mac_cpy(cache->mac.ether_addr_octet, (uint8_t *)mac);
+    }
+    return entry;
+}
+
+// The packet path is instantiated for each context mode with the mode as a constant, so
+// that the instance of a context does not branch on it. The generic instance reads the mode
+// from the context and is the only one with the debug logs, it takes over while packet
+// debug is on. Build with DEBUG_PKT_PATH for the logs in all of them.
+enum {
+    DPI_RECV_GENERIC = 0,
+    DPI_RECV_INLINE,            // non-TC
+    DPI_RECV_TC,                // TC and tapped ports
+    DPI_RECV_PROXYMESH,         // TC, lo of a proxymesh pod
+    DPI_RECV_NFQ,               // TC, nfq
+};
+
+#ifdef DPI_RECV_DEBUG
+#define DPI_RECV_LOGS(mode)     true
+#else
+#define DPI_RECV_LOGS(mode)     ((mode) == DPI_RECV_GENERIC)
+#endif
+
+#define IF_RECV_DEBUG_LOG(level, p) \
+        if (DPI_RECV_LOGS(mode)) IF_DEBUG_LOG(level, p)
+
+// The caller holds the rcu read lock
+static inline __attribute__((always_inline)) int dpi_recv_locked(io_ctx_t *ctx, uint8_t *ptr, int len, const int mode)
+{
+    int action;
     bool tap = false, inspect = true, isproxymesh = false;
-    bool nfq = ctx->nfq;
+    const bool tc = mode == DPI_RECV_GENERIC ? ctx->tc : mode != DPI_RECV_INLINE;
+    const bool nfq = mode == DPI_RECV_GENERIC ? ctx->nfq : mode == DPI_RECV_NFQ;
+    const bool proxymesh = mode == DPI_RECV_GENERIC || mode == DPI_RECV_PROXYMESH;
+    uint64_t lat;
+
+    dpi_lat_sample();
+    lat = dpi_lat_start();
 
     th_snap.tick = ctx->tick;
 
     memset(&th_packet, 0, offsetof(dpi_packet_t, EOZ));
 
-    for (c = 0; c < DPI_SIG_CONTEXT_TYPE_MAX; c++) {
-        th_packet.dlp_area[c].dlp_ptr = NULL;
-        th_packet.dlp_area[c].dlp_len = 0;
-        th_packet.dlp_area[c].dlp_start = 0;
-        th_packet.dlp_area[c].dlp_end = 0;
-        th_packet.dlp_area[c].dlp_offset = 0;
-        th_packet.dlp_area[c].dlp_flags = 0;
-    }
-    th_packet.decoded_pkt.len = 0;
-
     th_packet.pkt = ptr;
     th_packet.cap_len = len;
     th_packet.l2 = 0;
 
-    rcu_read_lock();
-
-    th_internal_subnet4 = g_internal_subnet4;
-    th_policy_addr = g_policy_addr;
-    th_specialip_subnet4 = g_specialip_subnet4;
-    th_xff_enabled = g_xff_enabled;
-    th_disable_net_policy = g_disable_net_policy;
-    th_detect_unmanaged_wl = g_detect_unmanaged_wl;
-
     if (likely(th_packet.cap_len >= sizeof(struct ethhdr))) {
         struct ethhdr *eth = (struct ethhdr *)(th_packet.pkt + th_packet.l2);
         io_mac_t *mac = NULL;
 
         // Lookup workloads
-        if (!ctx->tc) {
+        if (!tc) {
             // NON-TC mode just fwd the mcast/bcast mac packet
             if (is_mac_m_b_cast(eth->h_dest)) {
-                rcu_read_unlock();
                 if (!tap && nfq) {
                     //bypass nfq in case of multicast or broadcast
                     return 0;
@@ -467,54 +728,53 @@ int dpi_recv_packet(io_ctx_t *ctx, uint8_t *ptr, int len)
             // in case of quarantine for NON-TC mode we cannot rely on tc rule
             // reset to drop traffic, so we stop send_packet to its peer ctx
             if (ctx->quar) {
-                rcu_read_unlock();
-                return 1;
+                return ctx->nfq_mark ? DPI_VERDICT_UNMARK_DROP : DPI_VERDICT_DROP;
             }
 
             if (mac_cmp(eth->h_source, ctx->ep_mac.ether_addr_octet)) {
-                mac = rcu_map_lookup(&g_ep_map, &eth->h_source);
+                mac = dpi_ep_mac_lookup(ctx, &eth->h_source);
             } else if (mac_cmp(eth->h_dest, ctx->ep_mac.ether_addr_octet)) { 
-                mac = rcu_map_lookup(&g_ep_map, &eth->h_dest);
+                mac = dpi_ep_mac_lookup(ctx, &eth->h_dest);
                 th_packet.flags |= DPI_PKT_FLAG_INGRESS;
             } 
         } else if (cmp_mac_prefix(eth->h_source, MAC_PREFIX)) { 
-            mac = rcu_map_lookup(&g_ep_map, &eth->h_source);
+            mac = dpi_ep_mac_lookup(ctx, &eth->h_source);
         } else if (cmp_mac_prefix(eth->h_dest, MAC_PREFIX)) { 
-            mac = rcu_map_lookup(&g_ep_map, &eth->h_dest);
+            mac = dpi_ep_mac_lookup(ctx, &eth->h_dest);
             th_packet.flags |= DPI_PKT_FLAG_INGRESS;
         } else
         // For tapped port
         //check dst mac first because src mac may == dst mac for ingress
         if (mac_cmp(eth->h_dest, ctx->ep_mac.ether_addr_octet)) { 
-            mac = rcu_map_lookup(&g_ep_map, &eth->h_dest);
+            mac = dpi_ep_mac_lookup(ctx, &eth->h_dest);
             th_packet.flags |= DPI_PKT_FLAG_INGRESS;
         } else if (mac_cmp(eth->h_source, ctx->ep_mac.ether_addr_octet)) {
-            mac = rcu_map_lookup(&g_ep_map, &eth->h_source);
-        }  else if (cmp_mac_prefix(ctx->ep_mac.ether_addr_octet, PROXYMESH_MAC_PREFIX)) {
+            mac = dpi_ep_mac_lookup(ctx, &eth->h_source);
+        }  else if (proxymesh && ctx->proxymesh) {
             /*
              * proxymesh injects its proxy service as a sidecar into POD, 
              * ingress/egress traffic will be redirected to proxy, "lo"
              * interface is monitored to inspect traffic from and to proxy.
              */
-            mac = rcu_map_lookup(&g_ep_map, &ctx->ep_mac.ether_addr_octet);
+            mac = dpi_ep_mac_lookup(ctx, &ctx->ep_mac.ether_addr_octet);
             isproxymesh = true;
-            if (th_session4_proxymesh_map.map == NULL) {
-                dpi_session_proxymesh_init();
-            }
+            th_packet.flags |= DPI_PKT_FLAG_PROXYMESH;
         } else if (nfq) {
             //cilium ep use nfq in protect mode
-            mac = rcu_map_lookup(&g_ep_map, &ctx->ep_mac.ether_addr_octet);
+            mac = dpi_ep_mac_lookup(ctx, &ctx->ep_mac.ether_addr_octet);
         }
         if (likely(mac != NULL)) {
             tap = mac->ep->tap;
 
+            th_packet.flags |= DPI_PKT_FLAG_EP_CPU;
             th_packet.ctx = ctx;
             th_packet.ep = mac->ep;
             th_packet.ep_mac = mac->ep->mac->mac.ether_addr_octet;
-            th_packet.ep_stats = &mac->ep->stats;
+            th_packet.ep_stats = th_ep_stats(mac->ep);
             th_packet.stats = &th_stats;
+            DEBUG_LOG_FILTER_PACKET(&th_packet);
 
-            IF_DEBUG_LOG(DBG_PACKET, &th_packet) {
+            IF_RECV_DEBUG_LOG(DBG_PACKET, &th_packet) {
                 if (FLAGS_TEST(th_packet.flags, DPI_PKT_FLAG_INGRESS)) {
                     DEBUG_LOG_NO_FILTER("pkt_mac="DBG_MAC_FORMAT" ep_mac="DBG_MAC_FORMAT"\n",
                                         DBG_MAC_TUPLE(eth->h_dest), DBG_MAC_TUPLE(*th_packet.ep_mac));
@@ -541,19 +801,23 @@ int dpi_recv_packet(io_ctx_t *ctx, uint8_t *ptr, int len)
                 }
     
                 dpi_inc_stats_packet(&th_packet);
+
+                if (!tap && dpi_rate_limited(&th_packet, len)) {
+                    return DPI_VERDICT_ACCEPT;
+                }
             }
         } else if (g_io_config->promisc) {
             th_packet.ctx = ctx;
             th_packet.flags |= (DPI_PKT_FLAG_INGRESS | DPI_PKT_FLAG_FAKE_EP);
             th_packet.ep = g_io_config->dummy_mac.ep;
             th_packet.ep_mac = g_io_config->dummy_mac.mac.ether_addr_octet;
-            th_packet.ep_stats = &g_io_config->dummy_mac.ep->stats;
+            th_packet.ep_stats = th_ep_stats(g_io_config->dummy_mac.ep);
             th_packet.stats = &th_stats;
+            DEBUG_LOG_FILTER_PACKET(&th_packet);
             th_packet.ep_all_metry = &th_packet.ep_stats->in;
             th_packet.all_metry = &th_packet.stats->in;
             tap = ctx->tap;
         } else {
-            rcu_read_unlock();
             // If not in promisc mode, ignore flooded mac-mismatched pkts 
             //bypass nfq
             return 0;
@@ -561,11 +825,18 @@ int dpi_recv_packet(io_ctx_t *ctx, uint8_t *ptr, int len)
         }
     }
 
+    dpi_lat_stop(DP_LAT_RX, lat);
+
+    if (unlikely(CMM_LOAD_SHARED(g_capture) != NULL)) {
+        dpi_capture_packet(&th_packet);
+    }
+
     // Parse after figuring out direction so that if there is any threat in the packet
     // it can be logged correctly
+    lat = dpi_lat_start();
     action = dpi_parse_ethernet(&th_packet);
+    dpi_lat_stop(DP_LAT_PARSE, lat);
     if (unlikely(action == DPI_ACTION_DROP || action == DPI_ACTION_RESET)) {
-        rcu_read_unlock();
         if (th_packet.frag_trac != NULL) {
             dpi_frag_discard(th_packet.frag_trac);
         }
@@ -601,6 +872,13 @@ int dpi_recv_packet(io_ctx_t *ctx, uint8_t *ptr, int len)
         }
         
         dpi_inc_stats_packet(&th_packet);
+
+        if (nfq && !tap && dpi_rate_limited(&th_packet, len)) {
+            if (th_packet.frag_trac != NULL) {
+                dpi_frag_discard(th_packet.frag_trac);
+            }
+            return ctx->nfq_mark ? DPI_VERDICT_UNMARK_DROP : DPI_VERDICT_DROP;
+        }
     }
     
     // Bypass broadcast, multicast and non-ip packet
@@ -625,54 +903,250 @@ int dpi_recv_packet(io_ctx_t *ctx, uint8_t *ptr, int len)
     }
          
     if (action == DPI_ACTION_NONE && inspect) {
-        IF_DEBUG_LOG(DBG_PACKET, &th_packet) {
+        IF_RECV_DEBUG_LOG(DBG_PACKET, &th_packet) {
             debug_dump_packet(&th_packet);
         }
+        // Only the dlp and waf detection reads what the parsers leave in the areas
+        if (th_packet.ep != NULL && th_packet.ep->dlp_detector != NULL) {
+            memset(th_packet.dlp_area, 0, sizeof(th_packet.dlp_area));
+            th_packet.decoded_pkt.len = 0;
+            th_packet.flags |= DPI_PKT_FLAG_DLP_AREA;
+        }
         action = dpi_inspect_ethernet(&th_packet);
-        DEBUG_LOG(DBG_PACKET, NULL, "action=%d tap=%d inspect=%d\n",
-                  action, tap, inspect);
+        IF_RECV_DEBUG_LOG(DBG_PACKET, NULL) {
+            DEBUG_LOG_NO_FILTER("action=%d tap=%d inspect=%d\n", action, tap, inspect);
+        }
+        dpi_hold_cached_clip(&th_packet);
     }
 
-    rcu_read_unlock();
 
     if (likely(!tap && action != DPI_ACTION_DROP && action != DPI_ACTION_RESET &&
-               action != DPI_ACTION_BLOCK)) {
+               action != DPI_ACTION_BLOCK && !(th_packet.flags & DPI_PKT_FLAG_SYN_PROXY))) {
         if (!tap && nfq) {
             //nfq accept after inspect l4/7 
-            return 0;
+            if (ctx->nfq_mark) {
+                // a sample of a marked connection, it is queued again if its session lost the mark
+                return FLAGS_TEST(th_packet.flags, DPI_PKT_FLAG_NFQ_MARKED) ? DPI_VERDICT_ACCEPT : DPI_VERDICT_UNMARK;
+            }
+            return FLAGS_TEST(th_packet.flags, DPI_PKT_FLAG_NFQ_MARK) ? DPI_VERDICT_MARK : DPI_VERDICT_ACCEPT;
         }
+        lat = dpi_lat_start();
         if (th_packet.frag_trac != NULL) {
             dpi_frag_send(th_packet.frag_trac, ctx);
         } else {
             g_io_callback->send_packet(ctx, ptr, len);
         }
+        dpi_lat_stop(DP_LAT_TX, lat);
     } else {
         if (th_packet.frag_trac != NULL) {
             dpi_frag_discard(th_packet.frag_trac);
         }
         if (!tap && nfq) {
             //nfq drop after inspect l4/7 
-            return 1;
+            return ctx->nfq_mark ? DPI_VERDICT_UNMARK_DROP : DPI_VERDICT_DROP;
         }
     }
-    return 0;
+    return DPI_VERDICT_ACCEPT;
+}
+
+#define DPI_RECV_INSTANCE(name, mode) \
+static int name(io_ctx_t *ctx, uint8_t *ptr, int len) \
+{ \
+    return dpi_recv_locked(ctx, ptr, len, mode); \
+}
+
+DPI_RECV_INSTANCE(dpi_recv_generic, DPI_RECV_GENERIC)
+DPI_RECV_INSTANCE(dpi_recv_inline, DPI_RECV_INLINE)
+DPI_RECV_INSTANCE(dpi_recv_tc, DPI_RECV_TC)
+DPI_RECV_INSTANCE(dpi_recv_proxymesh, DPI_RECV_PROXYMESH)
+DPI_RECV_INSTANCE(dpi_recv_nfq, DPI_RECV_NFQ)
+
+typedef int (*dpi_recv_fct)(io_ctx_t *ctx, uint8_t *ptr, int len);
+
+// Once per call, the debug levels can change any time
+static inline dpi_recv_fct dpi_recv_select(const io_ctx_t *ctx)
+{
+    if (unlikely(g_debug_levels & DBG_PACKET)) {
+        return dpi_recv_generic;
+    } else if (!ctx->tc) {
+        return ctx->nfq ? dpi_recv_generic : dpi_recv_inline;
+    } else if (ctx->nfq) {
+        return dpi_recv_nfq;
+    } else if (ctx->proxymesh) {
+        return dpi_recv_proxymesh;
+    }
+    return dpi_recv_tc;
+}
+
+//return value is only used by nfq, see DPI_VERDICT_ACCEPT
+// Cycles of the packet, including its parsers and sending it on, are charged to its workload
+static inline int dpi_recv_charged(dpi_recv_fct recv, io_ctx_t *ctx, uint8_t *ptr, int len)
+{
+    uint64_t start = tsc_read();
+    int verdict;
+
+    dpi_stage_enter(DP_STAGE_PACKET, start);
+    verdict = recv(ctx, ptr, len);
+    dpi_stage_leave();
+
+    if (likely(FLAGS_TEST(th_packet.flags, DPI_PKT_FLAG_EP_CPU))) {
+        th_packet.ep->cpu_ticks[g_dpi_thread - g_dpi_thread_data] += tsc_read() - start;
+    }
+    return verdict;
+}
+
+int dpi_recv_packet(io_ctx_t *ctx, uint8_t *ptr, int len)
+{
+    int verdict;
+
+    rcu_read_lock();
+    dpi_recv_cfg_refresh();
+    verdict = dpi_recv_charged(dpi_recv_select(ctx), ctx, ptr, len);
+    rcu_read_unlock();
+
+    return verdict;
+}
+
+// Inspect packets of one rx block, in one rcu read section. Verdicts, as returned by
+// dpi_recv_packet(), are written to 'verdicts' if it is not NULL.
+void dpi_recv_batch(io_ctx_t *ctx, io_pkt_t *pkts, int count, uint8_t *verdicts)
+{
+    dpi_recv_fct recv;
+    int i;
+
+    rcu_read_lock();
+    dpi_recv_cfg_refresh();
+    recv = dpi_recv_select(ctx);
+
+    for (i = 0; i < count; i ++) {
+        int verdict;
+
+        if (i + DPI_RECV_PREFETCH < count) {
+            __builtin_prefetch(pkts[i + DPI_RECV_PREFETCH].pkt);
+            __builtin_prefetch(pkts[i + DPI_RECV_PREFETCH].pkt + 64);
+        }
+
+        ctx->large_frame = pkts[i].large_frame;
+        ctx->rx_ns = pkts[i].rx_ns;
+        verdict = dpi_recv_charged(recv, ctx, pkts[i].pkt, pkts[i].len);
+        if (verdicts != NULL) {
+            verdicts[i] = verdict;
+        }
+    }
+
+    rcu_read_unlock();
+}
+
+void dpi_pool_init(int id, uint32_t obj_size)
+{
+    if (obj_pool_init(th_pool(id), obj_size,
+                      g_io_config->pool_prealloc[id], g_io_config->pool_cap[id]) < 0) {
+        DEBUG_ERROR(DBG_INIT, "failed to preallocate pool %d, count=%u\n",
+                    id, g_io_config->pool_prealloc[id]);
+    }
+}
+
+static void dpi_publish_flat_map(int id, const flat_map_t *m)
+{
+    th_counter.map_entries[id] = flat_map_count(m);
+    th_counter.map_buckets[id] = flat_map_slots(m);
+    th_counter.map_resizes[id] = m->resizes;
+}
+
+static const int g_pool_mem[DP_POOL_MAX] = {
+    [DP_POOL_SESSION] = DP_MEM_SESSION,
+    [DP_POOL_CLIP] = DP_MEM_ASM,
+    [DP_POOL_FRAG] = DP_MEM_FRAG,
+    [DP_POOL_METER] = DP_MEM_METER,
+};
+
+static void dpi_publish_stats(void)
+{
+    int id;
+
+    mem_acct_row(THREAD_ID, th_counter.mem_bytes);
+    for (id = 0; id < DP_POOL_MAX; id ++) {
+        obj_pool_t *pool = th_pool(id);
+
+        th_counter.pool_in_use[id] = pool->in_use;
+        th_counter.pool_high_water[id] = pool->high_water;
+        th_counter.pool_fails[id] = pool->fails;
+        th_counter.mem_bytes[g_pool_mem[id]] += (int64_t)pool->total * pool->obj_size;
+    }
+
+    dpi_publish_flat_map(DP_MAP_SESSION4, &th_session4_map);
+    dpi_publish_flat_map(DP_MAP_SESSION6, &th_session6_map);
+    dpi_publish_flat_map(DP_MAP_FRAG4, &th_ip4frag_map);
+    dpi_publish_flat_map(DP_MAP_FRAG6, &th_ip6frag_map);
+    dpi_publish_flat_map(DP_MAP_METER, &th_meter_map);
+    th_counter.map_entries[DP_MAP_LOG] = th_log_map.count;
+    th_counter.map_buckets[DP_MAP_LOG] = th_log_map.buckets;
+
+    seqlock_write_begin(&th_snap_lock);
+    th_counter_snap = th_counter;
+    th_stats_snap = th_stats;
+    seqlock_write_end(&th_snap_lock);
 }
 
 void dpi_timeout(uint32_t tick)
 {
+    dpi_stage_enter(DP_STAGE_TIMER, tsc_read());
+
     th_snap.tick = tick;
 
+    dpi_publish_stats();
+    dpi_session_offload_check();
+    dpi_flowlet_expire();
+    dpi_session_policy_sweep();
+
     if (unlikely(!timer_wheel_started(&th_timer))) {
-        timer_wheel_start(&th_timer, tick);
+        timer_wheel_start(&th_timer, tick * 1000);
     }
 
     //DEBUG_LOG(DBG_TIMER, NULL, "tick=%u\n", tick);
 
+    dpi_timer_roll(tick * 1000);
+    dpi_stage_set(DP_STAGE_IDLE);
+}
+
+// Expire timers due by now_ms. dp threads also call it between packet batches, so timers
+// expire within the second; it is a no-op when the wheel has already rolled past now_ms.
+// A roll expires at most DPI_TIMER_BUDGET entries, so a mass timeout is spread over several
+// loop passes instead of holding up packets. Returns true if due entries are left.
+bool dpi_timer_roll(uint32_t now_ms)
+{
+    if (unlikely(!timer_wheel_started(&th_timer))) {
+        return false;
+    }
+
+    // Timers of sessions set it for their session, the others log without a filter only
+    DEBUG_LOG_FILTER_PACKET(NULL);
+
+    dpi_stage_enter(DP_STAGE_TIMER, tsc_read());
     rcu_read_lock();
-    uint32_t cnt = timer_wheel_roll(&th_timer, tick);
+    uint32_t cnt = timer_wheel_roll(&th_timer, now_ms, DPI_TIMER_BUDGET);
     rcu_read_unlock();
+    dpi_stage_set(DP_STAGE_IDLE);
+
+    th_counter.timer_expires += cnt;
+    if (unlikely(cnt >= DPI_TIMER_BUDGET)) {
+        th_counter.timer_deferred ++;
+        th_counter.timer_backlog = timer_wheel_backlog(&th_timer, now_ms, DPI_TIMER_BACKLOG_CAP);
+    } else {
+        th_counter.timer_backlog = 0;
+    }
 
     if (cnt > 0) {
-        DEBUG_LOG(DBG_TIMER, NULL, "tick=%u expires=%u\n", tick, cnt);
+        DEBUG_LOG(DBG_TIMER, NULL, "ms=%u expires=%u backlog=%u\n", now_ms, cnt, th_counter.timer_backlog);
     }
+    return cnt >= DPI_TIMER_BUDGET;
+}
+
+// Called by the dp thread at each of its load checks. While on, packets without a session
+// are dropped once 'sessions' new ones were admitted since the last call, and established
+// allowed sessions are no longer inspected, see dpi_overload_shed_inspect().
+void dpi_overload(bool on, uint32_t sessions)
+{
+    th_overload = on;
+    th_overload_sessions = sessions;
 }
@@ -1,20 +1,24 @@
 #include <stdio.h>
 #include <string.h>
 
-#include "utils/rcu_map.h"
+#include "utils/flat_map.h"
 
 #include "utils/helper.h"
+#include "utils/hash.h"
 #include "utils/asm.h"
+#include "utils/cksum.h"
 #include "dpi/dpi_module.h"
 
 #define DPI_FRAG_TIMEOUT 10
+#define DPI_FRAG_MAX_TRACKERS 4096  // per thread if the frag pool has no cap
 
 #define FRAG_TRAC_COMMON       \
-    struct cds_lfht_node node; \
     timer_entry_t ts_entry;      \
+    struct cds_list_head link; \
     uint32_t length : 30,      \
              first  : 1,       \
              last   : 1;       \
+    bool v6;                   \
     asm_t frags;               \
 
 
@@ -39,10 +43,9 @@ typedef struct teardrop_args_ {
 } teardrop_args_t;
 
 
-static int ip4frag_trac_match(struct cds_lfht_node *ht_node, const void *key)
+static bool ip4frag_trac_match(const void *data, const void *key)
 {
-    ip4frag_trac_t *t1 = STRUCT_OF(ht_node, ip4frag_trac_t, node);
-    const ip4frag_trac_t *t2 = key;
+    const ip4frag_trac_t *t1 = data, *t2 = key;
 
     return t1->src == t2->src && t1->dst == t2->dst && t1->ipid == t2->ipid && t1->ingress == t2->ingress;
 }
@@ -50,15 +53,122 @@ static int ip4frag_trac_match(struct cds_lfht_node *ht_node, const void *key)
 static uint32_t ip4frag_trac_hash(const void *key)
 {
     const ip4frag_trac_t *t = key;
+    uint32_t k[3] = {t->src, t->dst, t->ipid};
 
-    return sdbm_hash((uint8_t *)&t->src, sizeof(t->src)) +
-           sdbm_hash((uint8_t *)&t->dst, sizeof(t->dst)) + t->ipid;
+    return hash_key(k, sizeof(k));
 }
 
 static void ipfrag_remove(clip_t *clip)
 {
     th_counter.freed_frags ++;
-    free(clip);
+    dpi_clip_free(clip);
+}
+
+// Trackers in the maps are on th_frag_list, oldest first. When the cap is reached, the oldest
+// one is dropped for the new datagram.
+static void frag_trac_destroy(frag_trac_t *trac)
+{
+    cds_list_del(&trac->link);
+    th_frag_count --;
+    asm_destroy(&trac->frags, ipfrag_remove);
+    obj_pool_free(th_pool(DP_POOL_FRAG), trac);
+}
+
+static void frag_trac_evict(void)
+{
+    frag_trac_t *trac = cds_list_entry(th_frag_list.next, frag_trac_t, link);
+
+    flat_map_del(trac->v6 ? &th_ip6frag_map : &th_ip4frag_map, trac);
+    timer_wheel_entry_remove(&th_timer, &trac->ts_entry);
+
+    DEBUG_LOG(DBG_PACKET, NULL, "Evict fragment tracker, v6=%u len=%u\n", trac->v6, trac->length);
+    th_counter.evict_frags ++;
+    frag_trac_destroy(trac);
+}
+
+static void *frag_trac_alloc(void)
+{
+    uint32_t cap = g_io_config->pool_cap[DP_POOL_FRAG];
+    void *trac;
+
+    if (th_frag_count >= (cap > 0 ? cap : DPI_FRAG_MAX_TRACKERS)) {
+        frag_trac_evict();
+    }
+    trac = obj_pool_alloc(th_pool(DP_POOL_FRAG));
+    if (trac == NULL && !cds_list_empty(&th_frag_list)) {
+        frag_trac_evict();
+        trac = obj_pool_alloc(th_pool(DP_POOL_FRAG));
+    }
+    return trac;
+}
+
+static void frag_trac_start(frag_trac_t *trac, timer_wheel_expire_fct release)
+{
+    asm_init(&trac->frags);
+    cds_list_add_tail(&trac->link, &th_frag_list);
+    th_frag_count ++;
+    timer_wheel_entry_init(&trac->ts_entry);
+    timer_wheel_entry_start(&th_timer, &trac->ts_entry, release, DPI_FRAG_TIMEOUT, th_snap.tick);
+}
+
+// Assembled, the tracker leaves the map and is kept only to send or drop the fragments
+static void frag_trac_done(frag_trac_t *trac, flat_map_t *map, dpi_packet_t *p)
+{
+    flat_map_del(map, trac);
+    timer_wheel_entry_remove(&th_timer, &trac->ts_entry);
+    cds_list_del(&trac->link);
+    th_frag_count --;
+    p->frag_trac = trac;
+}
+
+// The fragment that likely completes the datagram is referenced in the packet: it's sent or
+// dropped with the others before dpi_recv_packet() returns. Other fragments are copied.
+static clip_t *frag_save(frag_trac_t *trac, dpi_packet_t *p, uint32_t seq, uint32_t len)
+{
+    bool ref = trac->first && trac->last && asm_gross(&trac->frags) + len >= trac->length;
+    clip_t *clip = dpi_clip_alloc(ref ? 0 : p->cap_len);
+
+    if (clip == NULL) {
+        return NULL;
+    }
+
+    th_counter.total_frags ++;
+    clip->seq = seq;
+    clip->skip = p->l4;
+    clip->len = len;
+    clip->ref = ref;
+    if (ref) {
+        clip->ptr = p->pkt;
+    } else {
+        clip->ptr = (uint8_t *)(clip + 1);
+        memcpy(clip->ptr, p->pkt, p->cap_len);
+    }
+
+    if (asm_insert(&trac->frags, clip) == ASM_FAILURE) {
+        ipfrag_remove(clip);
+        return NULL;
+    }
+    return clip;
+}
+
+// The datagram is not complete after all, copy the referenced fragment
+static void frag_unref(frag_trac_t *trac, clip_t *clip, dpi_packet_t *p)
+{
+    clip_t *copy = dpi_clip_alloc(p->cap_len);
+
+    if (copy == NULL) {
+        asm_remove(&trac->frags, clip, ipfrag_remove);
+        return;
+    }
+
+    copy->seq = clip->seq;
+    copy->skip = clip->skip;
+    copy->len = clip->len;
+    copy->ref = 0;
+    asm_remove(&trac->frags, clip, dpi_clip_free);
+    copy->ptr = (uint8_t *)(copy + 1);
+    memcpy(copy->ptr, p->pkt, p->cap_len);
+    asm_insert(&trac->frags, copy);
 }
 
 static void teardrop_check(clip_t *clip, void *args)
@@ -71,7 +181,7 @@ static void teardrop_check(clip_t *clip, void *args)
 }
 
 
-static void ipfrag_hold(ip4frag_trac_t *trac, dpi_packet_t *p)
+static clip_t *ipfrag_hold(ip4frag_trac_t *trac, dpi_packet_t *p)
 {
     struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
     uint32_t frag_off, seq, len, end;
@@ -82,7 +192,7 @@ static void ipfrag_hold(ip4frag_trac_t *trac, dpi_packet_t *p)
     end = seq + len;
 
     if (len == 0) {
-        return;
+        return NULL;
     }
 
     // Check teardrop
@@ -94,7 +204,7 @@ static void ipfrag_hold(ip4frag_trac_t *trac, dpi_packet_t *p)
         asm_foreach(&trac->frags, teardrop_check, &td);
         if (td.overlap) {
             dpi_threat_trigger(DPI_THRT_IP_TEARDROP, p, NULL);
-            return;
+            return NULL;
         }
     }
 
@@ -106,38 +216,27 @@ static void ipfrag_hold(ip4frag_trac_t *trac, dpi_packet_t *p)
         // more
         if (end > trac->length) {
             if (trac->last) {
-                return;
+                return NULL;
             }
             trac->length = end;
         }
     } else {
         // last
         if (end < trac->length || (trac->last && end != trac->length)) {
-            return;
+            return NULL;
         }
         trac->last = 1;
         trac->length = end;
     }
 
     // Save the fragment
-    clip_t *clip = malloc(sizeof(*clip) + p->cap_len);
+    clip_t *clip = frag_save((frag_trac_t *)trac, p, seq, len);
     if (clip == NULL) {
-        return;
-    }
-
-    th_counter.total_frags ++;
-    clip->seq = seq;
-    clip->skip = p->l4;
-    clip->len = len;
-    clip->ptr = (uint8_t *)(clip + 1);
-    memcpy(clip->ptr, p->pkt, p->cap_len);
-
-    if (asm_insert(&trac->frags, clip) == ASM_FAILURE) {
-        ipfrag_remove(clip);
         DEBUG_ERROR(DBG_PACKET, "Fail to save ipv4 fragment, seq=%u len=%u\n", seq, len);
     } else {
         DEBUG_LOG(DBG_PACKET, NULL, "Save ipv4 fragment, seq=%u len=%u\n", seq, len);
     }
+    return clip;
 }
 
 static bool ipfrag_construct(ip4frag_trac_t *trac, dpi_packet_t *p)
@@ -145,6 +244,7 @@ static bool ipfrag_construct(ip4frag_trac_t *trac, dpi_packet_t *p)
     struct iphdr *iph;
     clip_t cons;
     asm_result_t ret;
+    uint16_t tot_len;
 
     cons.seq = 0;
     cons.ptr = p->defrag_data + p->l4;
@@ -159,19 +259,17 @@ static bool ipfrag_construct(ip4frag_trac_t *trac, dpi_packet_t *p)
         // Copy L2/L3 header of the current packet
         memcpy(p->defrag_data, p->pkt, p->l4);
 
+        // Only two fields change, update the checksum of the copied header
+        iph->check = cksum_update16(iph->check, iph->frag_off, 0);
         iph->frag_off = 0;
-        iph->tot_len = htons(p->l4 - p->l3 + cons.len);
-
-        iph->check = 0;
-        iph->check = get_ip_cksum(iph);
+        tot_len = htons(p->l4 - p->l3 + cons.len);
+        iph->check = cksum_update16(iph->check, iph->tot_len, tot_len);
+        iph->tot_len = tot_len;
 
         p->pkt = p->defrag_data;
         p->cap_len = p->len = p->l4 + cons.len;
 
-        // Remove trac from the map, keep it to send packets
-        rcu_map_del(&th_ip4frag_map, trac);
-        timer_wheel_entry_remove(&th_timer, &trac->ts_entry);
-        p->frag_trac = trac;
+        frag_trac_done((frag_trac_t *)trac, &th_ip4frag_map, p);
 
         return 0;
     }
@@ -183,18 +281,18 @@ static void ipfrag_release(timer_entry_t *entry)
 {
     ip4frag_trac_t *trac = STRUCT_OF(entry, ip4frag_trac_t, ts_entry);
 
-    rcu_map_del(&th_ip4frag_map, trac);
+    flat_map_del(&th_ip4frag_map, trac);
 
     // TODO: should track the sender
     th_counter.tmout_frags ++;
-    asm_destroy(&trac->frags, ipfrag_remove);
-    free(trac);
+    frag_trac_destroy((frag_trac_t *)trac);
 }
 
 int dpi_ip_defrag(dpi_packet_t *p)
 {
     ip4frag_trac_t *trac, key;
     struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
+    clip_t *clip;
     int ret = -1;
 
     memset(&key, 0, sizeof(key));
@@ -203,28 +301,27 @@ int dpi_ip_defrag(dpi_packet_t *p)
     key.ipid = iph->id;
     key.ingress = !!(p->flags & DPI_PKT_FLAG_INGRESS);
 
-    trac = rcu_map_lookup(&th_ip4frag_map, &key);
+    trac = flat_map_lookup(&th_ip4frag_map, &key);
     if (trac == NULL) {
-        trac = malloc(sizeof(*trac));
+        trac = frag_trac_alloc();
         if (trac == NULL) {
             return -1;
         }
 
         memcpy(trac, &key, sizeof(key));
-        asm_init(&trac->frags);
-
-        rcu_map_add(&th_ip4frag_map, trac, &key);
-        timer_wheel_entry_init(&trac->ts_entry);
-        timer_wheel_entry_start(&th_timer, &trac->ts_entry,
-                                ipfrag_release, DPI_FRAG_TIMEOUT, th_snap.tick);
+        flat_map_add(&th_ip4frag_map, trac, &key);
+        frag_trac_start((frag_trac_t *)trac, ipfrag_release);
     }
 
     timer_wheel_entry_refresh(&th_timer, &trac->ts_entry, th_snap.tick);
 
-    ipfrag_hold(trac, p);
+    clip = ipfrag_hold(trac, p);
     if (trac->first && trac->last) {
         ret = ipfrag_construct(trac, p);
     }
+    if (ret < 0 && clip != NULL && clip->ref) {
+        frag_unref((frag_trac_t *)trac, clip, p);
+    }
 
     return ret;
 }
@@ -240,10 +337,9 @@ typedef struct ip6frag_trac_ {
     bool ingress;
 } ip6frag_trac_t;
 
-static int ip6frag_trac_match(struct cds_lfht_node *ht_node, const void *key)
+static bool ip6frag_trac_match(const void *data, const void *key)
 {
-    ip6frag_trac_t *t1 = STRUCT_OF(ht_node, ip6frag_trac_t, node);
-    const ip6frag_trac_t *t2 = key;
+    const ip6frag_trac_t *t1 = data, *t2 = key;
 
     return (memcmp(&t1->src, &t2->src, sizeof(t1->src)) == 0 &&
             memcmp(&t1->dst, &t2->dst, sizeof(t1->dst)) == 0 &&
@@ -253,12 +349,14 @@ static int ip6frag_trac_match(struct cds_lfht_node *ht_node, const void *key)
 static uint32_t ip6frag_trac_hash(const void *key)
 {
     const ip6frag_trac_t *t = key;
+    uint32_t crc;
 
-    return sdbm_hash((uint8_t *)&t->src, sizeof(t->src)) +
-           sdbm_hash((uint8_t *)&t->dst, sizeof(t->dst)) + t->ipid;
+    crc = hash_crc32c(&t->src, sizeof(t->src), HASH_CRC32C_INIT);
+    crc = hash_crc32c(&t->dst, sizeof(t->dst), crc);
+    return hash_finish(hash_crc32c(&t->ipid, sizeof(t->ipid), crc));
 }
 
-static void ip6frag_hold(ip6frag_trac_t *trac, dpi_packet_t *p)
+static clip_t *ip6frag_hold(ip6frag_trac_t *trac, dpi_packet_t *p)
 {
     uint32_t frag_off, seq, len, end;
 
@@ -276,37 +374,26 @@ static void ip6frag_hold(ip6frag_trac_t *trac, dpi_packet_t *p)
         // more
         if (end > trac->length) {
             if (trac->last) {
-                return;
+                return NULL;
             }
             trac->length = end;
         }
     } else {
         // last
         if (end < trac->length || (trac->last && end != trac->length)) {
-            return;
+            return NULL;
         }
         trac->last = 1;
         trac->length = end;
     }
 
-    clip_t *clip = malloc(sizeof(*clip) + p->cap_len);
+    clip_t *clip = frag_save((frag_trac_t *)trac, p, seq, len);
     if (clip == NULL) {
-        return;
-    }
-
-    th_counter.total_frags ++;
-    clip->seq = seq;
-    clip->skip = p->l4;
-    clip->len = len;
-    clip->ptr = (uint8_t *)(clip + 1);
-    memcpy(clip->ptr, p->pkt, p->cap_len);
-
-    if (asm_insert(&trac->frags, clip) == ASM_FAILURE) {
-        ipfrag_remove(clip); 
         DEBUG_ERROR(DBG_PACKET, "Fail to save ipv6 fragment, seq=%u len=%u\n", seq, len);
     } else {
         DEBUG_LOG(DBG_PACKET, NULL, "Save ipv6 fragment, seq=%u len=%u\n", seq, len);
-    }   
+    }
+    return clip;
 }
 
 static bool ip6frag_construct(ip6frag_trac_t *trac, dpi_packet_t *p)
@@ -335,10 +422,7 @@ static bool ip6frag_construct(ip6frag_trac_t *trac, dpi_packet_t *p)
         p->cap_len = p->len = p->l3 + sizeof(*ip6h) + cons.len;
         p->l4 = p->l3 + sizeof(*ip6h);
 
-        // Remove trac from the map, keep it to send packets
-        rcu_map_del(&th_ip4frag_map, trac);
-        timer_wheel_entry_remove(&th_timer, &trac->ts_entry);
-        p->frag_trac = trac;
+        frag_trac_done((frag_trac_t *)trac, &th_ip6frag_map, p);
 
         return 0;
     }
@@ -350,18 +434,18 @@ static void ip6frag_release(timer_entry_t *entry)
 {
     ip6frag_trac_t *trac = STRUCT_OF(entry, ip6frag_trac_t, ts_entry);
 
-    rcu_map_del(&th_ip4frag_map, trac);
+    flat_map_del(&th_ip6frag_map, trac);
 
     // TODO: should track the sender
     th_counter.tmout_frags ++;
-    asm_destroy(&trac->frags, ipfrag_remove);
-    free(trac);
+    frag_trac_destroy((frag_trac_t *)trac);
 }
 
 int dpi_ipv6_defrag(dpi_packet_t *p)
 {
     ip6frag_trac_t *trac, key;
     struct ip6_hdr *ip6h = (struct ip6_hdr *)(p->pkt + p->l3);
+    clip_t *clip;
     int ret = -1;
 
     memset(&key, 0, sizeof(key));
@@ -369,8 +453,9 @@ int dpi_ipv6_defrag(dpi_packet_t *p)
     key.dst = ip6h->ip6_dst;
     key.ipid = p->ip6_fragh->ip6f_ident;
     key.ingress = !!(p->flags & DPI_PKT_FLAG_INGRESS);
+    key.v6 = true;
 
-    trac = rcu_map_lookup(&th_ip6frag_map, &key);
+    trac = flat_map_lookup(&th_ip6frag_map, &key);
     if (trac == NULL) {
         // offset is 0 and no more fragments, this is a pseudo frag header
         uint16_t frag_off;
@@ -379,26 +464,25 @@ int dpi_ipv6_defrag(dpi_packet_t *p)
             return 0;
         }
 
-        trac = malloc(sizeof(*trac));
+        trac = frag_trac_alloc();
         if (trac == NULL) {
             return -1;
         }
 
         memcpy(trac, &key, sizeof(key));
-        asm_init(&trac->frags);
-
-        rcu_map_add(&th_ip6frag_map, trac, &key);
-        timer_wheel_entry_init(&trac->ts_entry);
-        timer_wheel_entry_start(&th_timer, &trac->ts_entry,
-                                ip6frag_release, DPI_FRAG_TIMEOUT, th_snap.tick);
+        flat_map_add(&th_ip6frag_map, trac, &key);
+        frag_trac_start((frag_trac_t *)trac, ip6frag_release);
     }
 
     timer_wheel_entry_refresh(&th_timer, &trac->ts_entry, th_snap.tick);
 
-    ip6frag_hold(trac, p);
+    clip = ip6frag_hold(trac, p);
     if (trac->first && trac->last) {
         ret = ip6frag_construct(trac, p);
     }
+    if (ret < 0 && clip != NULL && clip->ref) {
+        frag_unref((frag_trac_t *)trac, clip, p);
+    }
 
     return ret;
 }
@@ -414,7 +498,7 @@ void dpi_frag_discard(void *frag_trac)
 {
     frag_trac_t *trac = frag_trac;
     asm_destroy(&trac->frags, ipfrag_remove);
-    free(trac);
+    obj_pool_free(th_pool(DP_POOL_FRAG), trac);
 }
 
 void dpi_frag_send(void *frag_trac, io_ctx_t *ctx)
@@ -422,15 +506,16 @@ void dpi_frag_send(void *frag_trac, io_ctx_t *ctx)
     frag_trac_t *trac = frag_trac;
     asm_foreach(&trac->frags, send_frag, ctx);
     asm_destroy(&trac->frags, ipfrag_remove);
-    free(trac);
+    obj_pool_free(th_pool(DP_POOL_FRAG), trac);
 }
 
 void dpi_frag_init(void)
 {
     DEBUG_LOG_FUNC_ENTRY(DBG_INIT, NULL);
 
-    rcu_map_init(&th_ip4frag_map, 1, offsetof(ip4frag_trac_t, node),
-                 ip4frag_trac_match, ip4frag_trac_hash);
-    rcu_map_init(&th_ip6frag_map, 1, offsetof(ip6frag_trac_t, node),
-                 ip6frag_trac_match, ip6frag_trac_hash);
+    flat_map_init(&th_ip4frag_map, dpi_map_size(DP_MAP_FRAG4, 1), ip4frag_trac_match, ip4frag_trac_hash);
+    flat_map_init(&th_ip6frag_map, dpi_map_size(DP_MAP_FRAG6, 1), ip6frag_trac_match, ip6frag_trac_hash);
+    CDS_INIT_LIST_HEAD(&th_frag_list);
+    th_frag_count = 0;
+    dpi_pool_init(DP_POOL_FRAG, max(sizeof(ip4frag_trac_t), sizeof(ip6frag_trac_t)));
 }
@@ -11,6 +11,7 @@
 #include <netinet/icmp6.h>
 
 #include "utils/helper.h"
+#include "utils/hash.h"
 
 #include "dpi/dpi_log.h"
 
@@ -18,6 +19,31 @@ extern bool cmp_mac_prefix(void *m1, void *prefix);
 extern int g_stats_slot;
 
 #define LOG_CACHE_TIMEOUT 5
+#define LOG_LIMIT_TIMEOUT 60
+#define LOG_LIMIT_MAX     4096  // buckets of a thread, logs of other peers share one
+
+// Logs that pass the caches are sent through a token bucket of their threat, endpoint and
+// peer, g_log_limit_rate logs a minute up to g_log_limit_burst in a row. The events of the
+// logs held back are added to the next one sent, or to a summary when the bucket expires.
+typedef struct log_limit_key_ {
+    uint32_t threat_id;
+    uint8_t ep_mac[ETH_ALEN];
+    uint8_t peer[16];
+} log_limit_key_t;
+
+typedef struct log_limit_ {
+    struct cds_lfht_node node;
+    timer_entry_t ts_entry;
+
+    log_limit_key_t key;
+    uint32_t tokens;        // in 1/60 of a log
+    uint32_t last_fill;
+    uint32_t suppressed;    // events of the logs held back
+    uint8_t log[offsetof(DPMsgThreatLog, Packet)];  // header of the last log held back
+    uint32_t dlp_name_hash;
+} log_limit_t;
+
+static __thread log_limit_t t_log_limit_shared;
 
 typedef struct log_cache_ {
     struct cds_lfht_node node;
@@ -73,6 +99,7 @@ static threat_property_t threat_property[] = {
 [DPI_THRT_APACHE_STRUTS_RCE] = {THRT_ID_APACHE_STRUTS_RCE, THRT_SEVERITY_CRITICAL, 0, 0, 10, },
 [DPI_THRT_K8S_EXTIP_MITM] = {THRT_ID_K8S_EXTIP_MITM, THRT_SEVERITY_CRITICAL, 0, 0, 10, },
 [DPI_THRT_SSL_TLS_1DOT1] = {THRT_ID_SSL_TLS_1DOT1, THRT_SEVERITY_INFO, 0, 0, 10, },
+[DPI_THRT_TCP_PORT_SCAN] = {THRT_ID_TCP_PORT_SCAN, THRT_SEVERITY_HIGH, 1, 0, 10, },
 };
 
 static threat_config_t threat_config[] = {
@@ -106,6 +133,7 @@ static threat_config_t threat_config[] = {
 [DPI_THRT_APACHE_STRUTS_RCE] = {true, DPI_ACTION_DROP, },
 [DPI_THRT_K8S_EXTIP_MITM] = {true, DPI_ACTION_DROP, },
 [DPI_THRT_SSL_TLS_1DOT1] = {false, DPI_ACTION_ALLOW, },
+[DPI_THRT_TCP_PORT_SCAN] = {true, DPI_ACTION_ALLOW, },
 };
 
 static int log_dlp_match(struct cds_lfht_node *ht_node, const void *key)
@@ -134,7 +162,8 @@ static uint32_t log_dlp_hash(const void *key)
 {
     const DPMsgThreatLog *k = key;
 
-    return sdbm_hash((uint8_t *)k->EPMAC, sizeof(k->EPMAC)) + k->DlpNameHash;
+    return hash_finish(hash_crc32c(&k->DlpNameHash, sizeof(k->DlpNameHash),
+                                   hash_crc32c(k->EPMAC, sizeof(k->EPMAC), HASH_CRC32C_INIT)));
 }
 
 static uint32_t log_hash(const void *key)
@@ -145,7 +174,20 @@ static uint32_t log_hash(const void *key)
         return log_dlp_hash(key);
     }
 
-    return sdbm_hash((uint8_t *)k->EPMAC, sizeof(k->EPMAC)) + k->ThreatID;
+    return hash_finish(hash_crc32c(&k->ThreatID, sizeof(k->ThreatID),
+                                   hash_crc32c(k->EPMAC, sizeof(k->EPMAC), HASH_CRC32C_INIT)));
+}
+
+static int log_limit_match(struct cds_lfht_node *ht_node, const void *key)
+{
+    log_limit_t *l = STRUCT_OF(ht_node, log_limit_t, node);
+
+    return memcmp(&l->key, key, sizeof(l->key)) == 0;
+}
+
+static uint32_t log_limit_hash(const void *key)
+{
+    return hash_key(key, sizeof(log_limit_key_t));
 }
 
 static void log_release(timer_entry_t *entry)
@@ -162,7 +204,7 @@ static void log_release(timer_entry_t *entry)
 
     th_counter.cur_log_caches --;
     rcu_map_del(&th_log_map, c);
-    free(c);
+    mem_free(DP_MEM_LOG, c);
 }
 
 void dpi_log_init(void)
@@ -176,7 +218,9 @@ void dpi_log_init(void)
         dpi_set_threat_status(DPI_THRT_SSL_TLS_1DOT1, true);
     }
     
-    rcu_map_init(&th_log_map, 128, offsetof(log_cache_t, node), log_match, log_hash);
+    rcu_map_init(&th_log_map, dpi_map_size(DP_MAP_LOG, 128), offsetof(log_cache_t, node), log_match, log_hash);
+    rcu_map_init(&th_log_limit_map, dpi_map_size(DP_MAP_LOG, 128), offsetof(log_limit_t, node),
+                 log_limit_match, log_limit_hash);
 }
 
 static inline uint16_t session_app(dpi_session_t *sess)
@@ -389,7 +433,7 @@ void log_session_detail(DPMsgThreatLog *log, dpi_session_t *sess)
 
 static log_cache_t *add_cache(DPMsgThreatLog *log, DPMsgThreatLog *key)
 {
-    log_cache_t *cache = calloc(1, sizeof(*cache));
+    log_cache_t *cache = mem_calloc(DP_MEM_LOG, 1, sizeof(*cache));
     if (cache != NULL) {
         memcpy(&cache->log, log, sizeof(*log));
         cache->last_log = th_snap.tick;
@@ -421,6 +465,90 @@ static uint32_t update_cache(log_cache_t *cache, threat_property_t *tprop)
     }
 }
 
+static void log_limit_release(timer_entry_t *entry)
+{
+    log_limit_t *l = STRUCT_OF(entry, log_limit_t, ts_entry);
+
+    if (l->suppressed > 0) {
+        DPMsgThreatLog log;
+
+        memset(&log, 0, sizeof(log));
+        memcpy(&log, l->log, sizeof(l->log));
+        log.DlpNameHash = l->dlp_name_hash;
+        log.Count = htonl(l->suppressed);
+        log.ReportedAt = htonl(time(NULL));
+        log.PktLen = log.CapLen = 0;
+
+        DEBUG_LOG(DBG_LOG, NULL, "id=%u suppressed=%u\n", l->key.threat_id, l->suppressed);
+        g_io_callback->threat_log(&log);
+    }
+
+    th_log_limits --;
+    rcu_map_del(&th_log_limit_map, l);
+    mem_free(DP_MEM_LOG, l);
+}
+
+static log_limit_t *log_limit_get(DPMsgThreatLog *log)
+{
+    log_limit_key_t key;
+    log_limit_t *l;
+
+    memset(&key, 0, sizeof(key));
+    key.threat_id = ntohl(log->ThreatID);
+    mac_cpy(key.ep_mac, log->EPMAC);
+    memcpy(key.peer, (log->Flags & DPLOG_FLAG_PKT_INGRESS) ? log->SrcIP : log->DstIP, sizeof(key.peer));
+
+    l = rcu_map_lookup(&th_log_limit_map, &key);
+    if (l != NULL) {
+        timer_wheel_entry_refresh(&th_timer, &l->ts_entry, th_snap.tick);
+        return l;
+    }
+
+    if (th_log_limits >= LOG_LIMIT_MAX || (l = mem_calloc(DP_MEM_LOG, 1, sizeof(*l))) == NULL) {
+        return &t_log_limit_shared;
+    }
+    l->key = key;
+    l->tokens = g_log_limit_burst * 60;
+    l->last_fill = th_snap.tick;
+    rcu_map_add(&th_log_limit_map, l, &key);
+    th_log_limits ++;
+
+    timer_wheel_entry_init(&l->ts_entry);
+    timer_wheel_entry_start(&th_timer, &l->ts_entry, log_limit_release, LOG_LIMIT_TIMEOUT, th_snap.tick);
+    return l;
+}
+
+// Send the log, unless its bucket is empty
+static void log_send(DPMsgThreatLog *log)
+{
+    uint32_t rate = CMM_LOAD_SHARED(g_log_limit_rate), burst = CMM_LOAD_SHARED(g_log_limit_burst);
+    log_limit_t *l;
+
+    if (rate == 0) {
+        g_io_callback->threat_log(log);
+        return;
+    }
+
+    l = log_limit_get(log);
+    l->tokens = min((uint64_t)l->tokens + (uint64_t)(th_snap.tick - l->last_fill) * rate, burst * 60);
+    l->last_fill = th_snap.tick;
+
+    if (l->tokens < 60) {
+        l->suppressed += ntohl(log->Count);
+        memcpy(l->log, log, sizeof(l->log));
+        l->dlp_name_hash = log->DlpNameHash;
+        th_counter.log_suppressed ++;
+        return;
+    }
+    l->tokens -= 60;
+
+    if (l->suppressed > 0) {
+        log->Count = htonl(ntohl(log->Count) + l->suppressed);
+        l->suppressed = 0;
+    }
+    g_io_callback->threat_log(log);
+}
+
 bool dpi_threat_status(uint32_t idx)
 {
     if (unlikely(idx >= DPI_THRT_MAX)) return false;
@@ -540,7 +668,7 @@ static void dpi_threat_trigger_dir(uint32_t idx, dpi_packet_t *p, bool flip, con
         memcpy(&cache->log, &log, sizeof(log));
     }
 
-    g_io_callback->threat_log(&log);
+    log_send(&log);
 }
 
 void dpi_threat_trigger(uint32_t idx, dpi_packet_t *p, const char *format, ...)
@@ -567,7 +695,7 @@ static void dpi_dlp_trigger_sig_dir(dpi_packet_t *p, dpi_match_t *m, bool flip,
     DPMsgThreatLog log;
     uint32_t count = 1;
     uint8_t action;
-    bool isproxymesh = cmp_mac_prefix(p->ep_mac, PROXYMESH_MAC_PREFIX);
+    bool isproxymesh = FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) ? true : false;
     
     memset(&tprop, 0, sizeof(tprop));
 
@@ -645,7 +773,7 @@ static void dpi_dlp_trigger_sig_dir(dpi_packet_t *p, dpi_match_t *m, bool flip,
         memcpy(&cache->log, &log, sizeof(log));
     }
 
-    g_io_callback->threat_log(&log);
+    log_send(&log);
 }
 
 void dpi_dlp_log_by_sig(dpi_packet_t *p, dpi_match_t *m, const char *format, ...)
@@ -722,7 +850,7 @@ void dpi_threat_log_by_session(uint32_t idx, dpi_session_t *sess, const char *fo
         memcpy(&cache->log, &log, sizeof(log));
     }
 
-    g_io_callback->threat_log(&log);
+    log_send(&log);
 }
 
 static void dump_meter_short(const dpi_meter_t *m)
@@ -753,7 +881,7 @@ void dpi_ddos_log(uint32_t idx, dpi_meter_t *m, const char *format, ...)
         dump_meter_short(m);
     }
 
-    g_io_callback->threat_log(log);
+    log_send(log);
 }
 
 int dpi_session_log_xff(dpi_session_t *s, DPMsgSession *dps)
@@ -763,47 +891,52 @@ int dpi_session_log_xff(dpi_session_t *s, DPMsgSession *dps)
         //xff is always detected on sess_ingress direction
         dps->Flags |= DPSESS_FLAG_INGRESS;
         mac_cpy(dps->EPMAC, s->server.mac);
-        ip4_cpy(dps->ClientIP, (uint8_t *)&s->xff_client_ip);
-        if (s->xff_desc.flags & POLICY_DESC_EXTERNAL) {
+        const dpi_session_xff_t *xff = dpi_session_xff(s);
+
+        ip4_cpy(dps->ClientIP, (uint8_t *)&xff->client_ip);
+        if (xff->desc.flags & POLICY_DESC_EXTERNAL) {
             dps->Flags |= DPSESS_FLAG_EXTERNAL;
         }
         dps->Flags |= DPSESS_FLAG_XFF;
-        dps->Application = s->xff_app;
-        dps->ServerPort = s->xff_port;
-        dps->PolicyAction = s->xff_desc.action;
-        dps->PolicyId = s->xff_desc.id;
+        dps->Application = xff->app;
+        dps->ServerPort = xff->port;
+        dps->PolicyAction = xff->desc.action;
+        dps->PolicyId = xff->desc.id;
     } else {//no need to send a duplicate connect report if not ipv4
         return -1;
     }
     return 0;
 }
 
-static void get_ingress_stats(DPMonitorMetric *dpm, io_stats_t *s)
+static void get_ingress_stats(DPMonitorMetric *dpm, io_ep_t *ep)
 {
     uint32_t cur = g_stats_slot;
-    uint32_t last = s->cur_slot;
-    register uint32_t i, n;
-    register uint32_t sess;
-    register uint64_t byte;
-
-    // 12x5s
-    if (last + 12 >= cur) {
-        uint32_t from = (cur >= 12) ? cur - 12 : 0;
-        sess = 0;
-        byte = 0;
-        for (n = from; n < last; n ++) {
-            i = n % STATS_SLOTS;
-            sess += s->in.sess_ring[i];
-            byte += s->in.byte_ring[i];
+    uint32_t t, sess = 0, cur_sess = 0;
+    uint64_t byte = 0;
+    io_window_t w;
+
+    // 12x5s, each thread's slots up to the last one it updated
+    for (t = 0; t < MAX_DP_THREADS; t ++) {
+        io_stats_t *s = &ep->stats[t];
+
+        if (s->cur_slot + STATS_WIN_SHORT >= cur) {
+            dpi_stats_window(&s->in, s->cur_slot, cur, STATS_WIN_SHORT, &w);
+            sess += w.sess;
+            byte += w.byte;
         }
-        dpm->EpSessIn12 = sess;
-        dpm->EpByteIn12 = byte;
+        cur_sess += s->in.cur_session;
     }
-    dpm->EpSessCurIn = s->in.cur_session;
+    dpm->EpSessIn12 = sess;
+    dpm->EpByteIn12 = byte;
+    dpm->EpSessCurIn = cur_sess;
 }
 
 void dpi_session_log(dpi_session_t *sess, DPMsgSession *dps, DPMonitorMetric *dpm)
 {
+    if (unlikely(sess->offload != NULL)) {
+        dpi_session_offload_sync(sess);
+    }
+
     memset(dps, 0, sizeof(DPMsgSession));
 
     dpi_wing_t *c = &sess->client, *s = &sess->server;
@@ -827,6 +960,9 @@ void dpi_session_log(dpi_session_t *sess, DPMsgSession *dps, DPMonitorMetric *dp
     if (FLAGS_TEST(sess->flags, DPI_SESS_FLAG_MID_STREAM)) {
         dps->Flags |= DPSESS_FLAG_MID;
     }
+    if (sess->asm_limited) {
+        dps->Flags |= DPSESS_FLAG_ASM_LIMITED;
+    }
 
     if (likely(FLAGS_TEST(sess->flags, DPI_SESS_FLAG_IPV4))) {
         dps->EtherType = ETH_P_IP;
@@ -839,9 +975,11 @@ void dpi_session_log(dpi_session_t *sess, DPMsgSession *dps, DPMonitorMetric *dp
             dps->Flags |= DPSESS_FLAG_SVC_EXTIP;
         }
         if (FLAGS_TEST(sess->flags, DPI_SESS_FLAG_XFF)) {
-            ip4_cpy(dps->XffIP, (uint8_t *)&sess->xff_client_ip);
-            dps->XffApp = sess->xff_app;
-            dps->XffPort = sess->xff_port;
+            const dpi_session_xff_t *xff = dpi_session_xff(sess);
+
+            ip4_cpy(dps->XffIP, (uint8_t *)&xff->client_ip);
+            dps->XffApp = xff->app;
+            dps->XffPort = xff->port;
         }
         if (sess->policy_desc.flags & POLICY_DESC_MESH_TO_SVR) {
             dps->Flags |= DPSESS_FLAG_MESH_TO_SVR;
@@ -908,12 +1046,65 @@ void dpi_session_log(dpi_session_t *sess, DPMsgSession *dps, DPMonitorMetric *dp
     memset(dpm, 0, sizeof(DPMonitorMetric));
     io_mac_t *mac = rcu_map_lookup(&g_ep_map, dps->EPMAC);
     if (mac != NULL) {
-        get_ingress_stats(dpm, &mac->ep->stats);
+        get_ingress_stats(dpm, mac->ep);
         /*DEBUG_LOG(DBG_LOG, NULL, "EpSessCurIn(%lu) EpSessIn12(%lu) EpByteIn12(%llu)\n",
         dpm->EpSessCurIn, dpm->EpSessIn12, dpm->EpByteIn12);*/
     }
 }
 
+void dpi_flowlet_log(const dpi_flowlet_t *fl, DPMsgSession *dps)
+{
+    const dpi_policy_desc_t *desc = &fl->policy_desc;
+
+    memset(dps, 0, sizeof(DPMsgSession));
+
+    dps->ID = fl->id;
+    mac_cpy(dps->EPMAC, (uint8_t *)fl->client_mac);
+    mac_cpy(dps->ClientMAC, (uint8_t *)fl->client_mac);
+    mac_cpy(dps->ServerMAC, (uint8_t *)fl->server_mac);
+
+    dps->EtherType = ETH_P_IP;
+    ip4_cpy(dps->ClientIP, (uint8_t *)&fl->client_ip);
+    ip4_cpy(dps->ServerIP, (uint8_t *)&fl->server_ip);
+    if (desc->flags & POLICY_DESC_EXTERNAL) {
+        dps->Flags |= DPSESS_FLAG_EXTERNAL;
+    }
+    if (desc->flags & POLICY_DESC_SVC_EXTIP) {
+        dps->Flags |= DPSESS_FLAG_SVC_EXTIP;
+    }
+    if (desc->flags & POLICY_DESC_LINK_LOCAL) {
+        dps->Flags |= DPSESS_FLAG_LINK_LOCAL;
+    }
+    if (desc->flags & POLICY_DESC_TMP_OPEN) {
+        dps->Flags |= DPSESS_FLAG_TMP_OPEN;
+    }
+    if (desc->flags & POLICY_DESC_UWLIP) {
+        dps->Flags |= DPSESS_FLAG_UWLIP;
+    }
+    if (desc->flags & POLICY_DESC_CHK_NBE) {
+        dps->Flags |= DPSESS_FLAG_CHK_NBE;
+    }
+    if (desc->flags & POLICY_DESC_NBE_SNS) {
+        dps->Flags |= DPSESS_FLAG_NBE_SNS;
+    }
+
+    dps->Application = DPI_APP_DNS;
+    dps->IPProto = IPPROTO_UDP;
+    dps->ClientPort = fl->client_port;
+    dps->ServerPort = fl->server_port;
+    dps->ClientPkts = fl->client_pkts;
+    dps->ClientBytes = fl->client_bytes;
+    dps->ServerPkts = fl->server_pkts;
+    dps->ServerBytes = fl->server_bytes;
+    dps->Age = th_snap.tick - fl->created_at;
+    dps->Idle = th_snap.tick - fl->last_seen;
+
+    dps->ThreatID = fl->threat_id;
+    dps->Severity = fl->severity;
+    dps->PolicyAction = desc->action;
+    dps->PolicyId = desc->id;
+}
+
 static void dpi_session_log_from_pkt(dpi_packet_t *p, int to_server, dpi_policy_desc_t *desc,
                                      DPMsgSession *dps)
 {
@@ -35,6 +35,7 @@ enum {
     DPI_THRT_APACHE_STRUTS_RCE,
     DPI_THRT_K8S_EXTIP_MITM,
     DPI_THRT_SSL_TLS_1DOT1,
+    DPI_THRT_TCP_PORT_SCAN,
     DPI_THRT_MAX,
 };
 
@@ -53,6 +54,7 @@ int dpi_session_start_log(dpi_session_t *s, bool xff);
 void dpi_session_mid_log(dpi_session_t *s, int log_violate, bool xff);
 
 void dpi_session_log(dpi_session_t *sess, DPMsgSession *dps, DPMonitorMetric *dpm);
+void dpi_flowlet_log(const dpi_flowlet_t *fl, DPMsgSession *dps);
 int dpi_session_log_xff(dpi_session_t *s, DPMsgSession *dps);
 void dpi_policy_violate_log(dpi_packet_t *p, bool to_server,
                             dpi_policy_desc_t *desc);
@@ -1,8 +1,12 @@
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <sys/random.h>
 
-#include "utils/rcu_map.h"
+#include "utils/flat_map.h"
 #include "utils/timer_wheel.h"
 #include "utils/helper.h"
+#include "utils/hash.h"
 
 #include "dpi/dpi_module.h"
 
@@ -13,26 +17,30 @@ void log_session_flags(DPMsgThreatLog *log, dpi_session_t *sess);
 void log_session_detail(DPMsgThreatLog *log, dpi_session_t *sess);
 
 static meter_info_t meter_info[] = {
-[DPI_METER_SYN_FLOOD] = {"syn_flood", METER_ID_SYN_FLOOD, DPI_THRT_TCP_FLOOD, true, false, true, true,
+[DPI_METER_SYN_FLOOD] = {"syn_flood", METER_ID_SYN_FLOOD, DPI_THRT_TCP_FLOOD, true, false, true, true, true,
                             8, 30, 5, 800, 600},
-[DPI_METER_ICMP_FLOOD] = {"icmp_flood", METER_ID_ICMP_FLOOD, DPI_THRT_ICMP_FLOOD, true, false, true, false,
+[DPI_METER_ICMP_FLOOD] = {"icmp_flood", METER_ID_ICMP_FLOOD, DPI_THRT_ICMP_FLOOD, true, false, true, false, false,
                             3, 30, 1, 100, 100},
-[DPI_METER_IP_SRC_SESSION] = {"ip_src_session", METER_ID_IP_SRC_SESSION, DPI_THRT_IP_SRC_SESSION, false, false, true, true,
+[DPI_METER_IP_SRC_SESSION] = {"ip_src_session", METER_ID_IP_SRC_SESSION, DPI_THRT_IP_SRC_SESSION, false, false, true, true, false,
                             3, 30, 1, 2000, 2000},
-[DPI_METER_TCP_NODATA] = {"tcp_nodata", METER_ID_TCP_NODATA, DPI_THRT_TCP_NODATA, true, false, true, false,
+[DPI_METER_TCP_NODATA] = {"tcp_nodata", METER_ID_TCP_NODATA, DPI_THRT_TCP_NODATA, true, false, true, false, false,
                             10, 0, 10, 10, 10},
 };
 
+// SYN cookie key and the last time a cookie was sent, see syn_cookie_hash()
+static __thread uint64_t t_syn_cookie_secret;
+static __thread uint32_t t_syn_cookie_tick;
+static __thread bool t_syn_cookie_sent;
+
 meter_info_t *dpi_get_meter_info(int type)
 {
     if (type >= DPI_METER_MAX) return NULL;
     return &meter_info[type];
 }
 
-static int meter_match(struct cds_lfht_node *ht_node, const void *key)
+static bool meter_match(const void *data, const void *key)
 {
-    dpi_meter_t *m = STRUCT_OF(ht_node, dpi_meter_t, node);
-    const dpi_meter_t *k = key;
+    const dpi_meter_t *m = data, *k = key;
 
     if (m->type != k->type) return false;
 
@@ -50,14 +58,30 @@ static int meter_match(struct cds_lfht_node *ht_node, const void *key)
 static uint32_t meter_hash(const void *key)
 {
     const dpi_meter_t *k = key;
+    uint32_t crc;
 
-    return sdbm_hash((uint8_t *)&k->ep_mac, sizeof(k->ep_mac)) +
-           sdbm_hash((uint8_t *)&k->peer_ip, sizeof(k->peer_ip)) + k->type;
+    crc = hash_crc32c(&k->peer_ip, sizeof(k->peer_ip), HASH_CRC32C_INIT);
+    crc = hash_crc32c(k->ep_mac, sizeof(k->ep_mac), crc);
+    return hash_finish(hash_crc32c(&k->type, sizeof(k->type), crc));
 }
 
 void dpi_meter_init(void)
 {
-    rcu_map_init(&th_meter_map, 512, offsetof(dpi_meter_t, node), meter_match, meter_hash);
+    int type;
+
+    flat_map_init(&th_meter_map, dpi_map_size(DP_MAP_METER, 512), meter_match, meter_hash);
+    dpi_pool_init(DP_POOL_METER, sizeof(dpi_meter_t));
+
+    for (type = 0; type < DPI_METER_MAX; type ++) {
+        if (meter_info[type].sketch) {
+            th_meter_sketch[type] = mem_calloc(DP_MEM_METER, 1, sizeof(dpi_meter_sketch_t));
+        }
+    }
+    th_scan_sketch = mem_calloc(DP_MEM_METER, 1, sizeof(dpi_scan_sketch_t));
+
+    if (getrandom(&t_syn_cookie_secret, sizeof(t_syn_cookie_secret), 0) != sizeof(t_syn_cookie_secret)) {
+        t_syn_cookie_secret = ((uint64_t)rand() << 32) ^ rand() ^ (uint64_t)time(NULL);
+    }
 }
 
 static void make_key(dpi_meter_t *key, int type, uint8_t *ep_mac, uint8_t *peer_ip, bool ipv4)
@@ -101,26 +125,140 @@ static void meter_release(timer_entry_t *entry)
     }
 
     th_counter.cur_meters --;
-    rcu_map_del(&th_meter_map, m);
-    free(m);
+    flat_map_del(&th_meter_map, m);
+    obj_pool_free(th_pool(DP_POOL_METER), m);
 }
 
 static dpi_meter_t *meter_alloc(int type, uint8_t *ep_mac, uint8_t *peer_ip, bool ipv4)
 {
     dpi_meter_t *m;
 
-    m = calloc(1, sizeof(*m));
+    m = obj_pool_zalloc(th_pool(DP_POOL_METER));
     if (unlikely(m == NULL)) return NULL;
 
     make_key(m, type, ep_mac, peer_ip, ipv4);
     m->start_tick = th_snap.tick;
 
     th_counter.cur_meters ++;
-    rcu_map_add(&th_meter_map, m, m);
+    flat_map_add(&th_meter_map, m, m);
 
     return m;
 }
 
+static inline uint64_t sketch_mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Count the key in the sketch and return the estimate over the last two windows. Conservative
+// update: only the rows at the minimum are incremented.
+static uint32_t sketch_inc(dpi_meter_sketch_t *sk, meter_info_t *info, const dpi_meter_t *key)
+{
+    uint32_t span = th_snap.tick - sk->start_tick;
+    uint32_t idx[DPI_METER_SKETCH_DEPTH], cur = UINT32_MAX, est = UINT32_MAX;
+    uint32_t (*c)[DPI_METER_SKETCH_WIDTH], (*p)[DPI_METER_SKETCH_WIDTH];
+    uint64_t h;
+    int i;
+
+    if (span >= info->span) {
+        if (span >= (uint32_t)info->span * 2) {
+            memset(sk->count, 0, sizeof(sk->count));
+        } else {
+            sk->cur ^= 1;
+            memset(sk->count[sk->cur], 0, sizeof(sk->count[sk->cur]));
+        }
+        sk->start_tick = th_snap.tick;
+    }
+    c = sk->count[sk->cur];
+    p = sk->count[sk->cur ^ 1];
+
+    h = sketch_mix(((uint64_t)hash_key(key->ep_mac, sizeof(key->ep_mac)) << 32) |
+                   hash_key(&key->peer_ip, sizeof(key->peer_ip)));
+    for (i = 0; i < DPI_METER_SKETCH_DEPTH; i ++) {
+        idx[i] = (uint32_t)(h >> (i * DPI_METER_SKETCH_BITS)) & (DPI_METER_SKETCH_WIDTH - 1);
+        cur = min(cur, c[i][idx[i]]);
+    }
+    for (i = 0; i < DPI_METER_SKETCH_DEPTH; i ++) {
+        if (c[i][idx[i]] == cur) {
+            c[i][idx[i]] ++;
+        }
+        est = min(est, c[i][idx[i]] + p[i][idx[i]]);
+    }
+    return est;
+}
+
+// SYN cookies, answered while the syn flood meter of an inline endpoint is on. The low 2 bits
+// carry the client's MSS, the rest is a keyed hash of the flow, the client's isn and the
+// time slot. A cookie is valid in its slot and the next one.
+#define SYN_COOKIE_SLOT_BITS 6  // 64 seconds
+
+static const uint16_t syn_cookie_mss[] = {536, 1220, 1440, 1460};
+
+static uint32_t syn_cookie_hash(struct iphdr *iph, struct tcphdr *tcph, uint32_t isn, uint32_t slot, uint32_t idx)
+{
+    uint64_t h;
+
+    h = sketch_mix(t_syn_cookie_secret ^ ((uint64_t)iph->saddr << 32 | iph->daddr));
+    h = sketch_mix(h ^ ((uint64_t)tcph->th_sport << 48 | (uint64_t)tcph->th_dport << 32 | isn));
+    h = sketch_mix(h ^ ((uint64_t)slot << 2 | idx));
+    return ((uint32_t)h & ~3u) | idx;
+}
+
+static bool syn_cookie_reply(dpi_packet_t *p)
+{
+    struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
+    struct tcphdr *tcph = (struct tcphdr *)(p->pkt + p->l4);
+    uint32_t idx = 0, cookie;
+
+    if (p->ctx->nfq) return false;
+
+    while (idx + 1 < ARRAY_ENTRIES(syn_cookie_mss) && p->tcp_mss >= syn_cookie_mss[idx + 1]) {
+        idx ++;
+    }
+    cookie = syn_cookie_hash(iph, tcph, p->raw.seq, th_snap.tick >> SYN_COOKIE_SLOT_BITS, idx);
+
+    // No window scale, sack or timestamp is offered, neither in the SYN sent to the server
+    if (dpi_inject_tcp(p, true, cookie, p->raw.seq + 1, TH_SYN | TH_ACK,
+                       0xffff, syn_cookie_mss[idx]) < 0) {
+        return false;
+    }
+
+    DEBUG_LOG(DBG_DDOS, p, "syn cookie=0x%x mss=%u\n", cookie, syn_cookie_mss[idx]);
+    t_syn_cookie_tick = th_snap.tick;
+    t_syn_cookie_sent = true;
+    return true;
+}
+
+// Check the ACK without a session against the cookies sent recently, return the client's MSS
+bool dpi_syn_cookie_check(dpi_packet_t *p, uint16_t *mss)
+{
+    struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
+    struct tcphdr *tcph = (struct tcphdr *)(p->pkt + p->l4);
+    uint32_t slot = th_snap.tick >> SYN_COOKIE_SLOT_BITS, cookie, idx;
+
+    if (likely(!t_syn_cookie_sent) ||
+        th_snap.tick - t_syn_cookie_tick >= (2 << SYN_COOKIE_SLOT_BITS)) {
+        return false;
+    }
+    if (p->eth_type != ETH_P_IP || !(p->flags & DPI_PKT_FLAG_INGRESS) || p->ep->tap) {
+        return false;
+    }
+
+    cookie = ntohl(tcph->th_ack) - 1;
+    idx = cookie & 3;
+    if (syn_cookie_hash(iph, tcph, p->raw.seq - 1, slot, idx) == cookie ||
+        syn_cookie_hash(iph, tcph, p->raw.seq - 1, slot - 1, idx) == cookie) {
+        *mss = syn_cookie_mss[idx];
+        return true;
+    }
+    return false;
+}
+
 // Increment meter, return non-NULL if threshold is reached.
 static dpi_meter_t *meter_inc(uint8_t type, uint8_t *ep_mac, uint8_t *peer_ip, bool ipv4, bool *fire, bool *create)
 {
@@ -129,11 +267,28 @@ static dpi_meter_t *meter_inc(uint8_t type, uint8_t *ep_mac, uint8_t *peer_ip, b
 
     memset(&key, 0, sizeof(key));
     make_key(&key, type, ep_mac, peer_ip, ipv4);
-    m = rcu_map_lookup(&th_meter_map, &key);
+    m = flat_map_lookup(&th_meter_map, &key);
     if (m == NULL) {
+        uint32_t est = 0;
+
+        // Spoofed sources of a flood stay in the sketch instead of getting a meter each
+        if (info->sketch && th_meter_sketch[type] != NULL) {
+            est = sketch_inc(th_meter_sketch[type], info, &key);
+            if (likely(est < info->lower_limit)) {
+                *fire = false;
+                *create = false;
+                return NULL;
+            }
+        }
+
         m = meter_alloc(type, ep_mac, peer_ip, ipv4);
         if (unlikely(m == NULL)) return NULL;
 
+        // Start from the estimate, the increment below counts this packet
+        if (est > 0) {
+            m->count = est - 1;
+        }
+
         IF_DEBUG_LOG(DBG_DDOS, NULL) {
             if (likely(ipv4)) {
                 DEBUG_LOG_NO_FILTER("alloc: type=%s peer="DBG_IPV4_FORMAT"\n",
@@ -201,7 +356,7 @@ static void meter_dec(uint8_t type, uint8_t *ep_mac, uint8_t *peer_ip, bool ipv4
 
     memset(&key, 0, sizeof(key));
     make_key(&key, type, ep_mac, peer_ip, ipv4);
-    m = rcu_map_lookup(&th_meter_map, &key);
+    m = flat_map_lookup(&th_meter_map, &key);
     if (unlikely(m == NULL)) return;
 
     timer_wheel_entry_refresh(&th_timer, &m->ts_entry, th_snap.tick);
@@ -298,9 +453,15 @@ int dpi_meter_synflood_inc(dpi_packet_t *p)
                     m->log_count = 0;
                 }
 
-                th_counter.drop_meters ++;
-                // TODO: SYN proxy logic goes here
                 dpi_set_action(p, DPI_ACTION_DROP);
+
+                // Answer for the server, the session is created when the ACK brings the cookie back
+                if (ipv4 && syn_cookie_reply(p)) {
+                    th_counter.proxy_meters ++;
+                    return DPI_METER_ACTION_PROXY;
+                }
+
+                th_counter.drop_meters ++;
                 return DPI_METER_ACTION_CLEAR;
             }
         }
@@ -309,6 +470,110 @@ int dpi_meter_synflood_inc(dpi_packet_t *p)
     return DPI_METER_ACTION_NONE;
 }
 
+static uint64_t scan_ip_hash(uint64_t seed, const uint8_t *ip)
+{
+    uint64_t hi, lo;
+
+    memcpy(&hi, ip, sizeof(hi));
+    memcpy(&lo, ip + sizeof(hi), sizeof(lo));
+    return sketch_mix(sketch_mix(seed ^ hi) ^ lo);
+}
+
+static dpi_scan_entry_t *scan_entry(dpi_scan_sketch_t *sk, uint64_t h)
+{
+    dpi_scan_entry_t *set = sk->entry[h & (DPI_SCAN_SETS - 1)], *e = &set[0];
+    uint32_t tag = (uint32_t)(h >> 32) | 1;
+    int i;
+
+    for (i = 0; i < DPI_SCAN_WAYS; i ++) {
+        if (set[i].tag == tag) {
+            e = &set[i];
+            if (th_snap.tick - e->start_tick < DPI_SCAN_SPAN) {
+                return e;
+            }
+            break;
+        }
+        if (th_snap.tick - set[i].start_tick > th_snap.tick - e->start_tick) {
+            e = &set[i];
+        }
+    }
+
+    memset(e, 0, sizeof(*e));
+    e->tag = tag;
+    e->start_tick = th_snap.tick;
+    return e;
+}
+
+// Estimate of the distinct count, the registers are far from empty at the limit so the small
+// range correction is not needed.
+static uint32_t scan_estimate(const dpi_scan_entry_t *e)
+{
+    double sum = 0;
+    int i;
+
+    for (i = 0; i < DPI_SCAN_HLL_REGS; i ++) {
+        sum += 1.0 / ((uint64_t)1 << e->reg[i]);
+    }
+    return (uint32_t)(0.709 * DPI_SCAN_HLL_REGS * DPI_SCAN_HLL_REGS / sum);
+}
+
+// Count the destination of a SYN without session for its source, nothing is allocated
+int dpi_meter_scan_inc(dpi_packet_t *p)
+{
+    uint32_t log_id = DPI_THRT_TCP_PORT_SCAN;
+    uint8_t action = dpi_threat_action(log_id);
+    struct tcphdr *tcph = (struct tcphdr *)(p->pkt + p->l4);
+    dpi_scan_entry_t *e;
+    uint64_t h, g, w;
+    uint8_t rank;
+    uint32_t est;
+
+    if (!dpi_threat_status(log_id) || unlikely(th_scan_sketch == NULL)) return DPI_METER_ACTION_NONE;
+
+    if (likely(p->eth_type == ETH_P_IP)) {
+        struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
+        h = sketch_mix(t_syn_cookie_secret ^ iph->saddr);
+        g = sketch_mix(h ^ ((uint64_t)iph->daddr << 16 | tcph->th_dport));
+    } else {
+        struct ip6_hdr *ip6h = (struct ip6_hdr *)(p->pkt + p->l3);
+        h = scan_ip_hash(t_syn_cookie_secret, (uint8_t *)&ip6h->ip6_src);
+        g = sketch_mix(scan_ip_hash(h, (uint8_t *)&ip6h->ip6_dst) ^ tcph->th_dport);
+    }
+
+    e = scan_entry(th_scan_sketch, h);
+    if (unlikely(e->fired)) {
+        goto fired;
+    }
+
+    w = g >> DPI_SCAN_HLL_BITS;
+    rank = w != 0 ? __builtin_clzll(w) - DPI_SCAN_HLL_BITS + 1 : 64 - DPI_SCAN_HLL_BITS + 1;
+    if (likely(rank <= e->reg[g & (DPI_SCAN_HLL_REGS - 1)])) {
+        return DPI_METER_ACTION_NONE;
+    }
+    e->reg[g & (DPI_SCAN_HLL_REGS - 1)] = rank;
+
+    // The estimate only changes with a register
+    est = scan_estimate(e);
+    if (likely(est < DPI_SCAN_LIMIT)) {
+        return DPI_METER_ACTION_NONE;
+    }
+
+    e->fired = true;
+    dpi_threat_trigger(log_id, p, "TCP SYN to about %u destinations in %u seconds",
+                       est, th_snap.tick - e->start_tick);
+    return action == DPI_ACTION_DROP || action == DPI_ACTION_RESET ?
+           DPI_METER_ACTION_CLEAR : DPI_METER_ACTION_NONE;
+
+fired:
+    // Later probes of the source are only logged once, but still dropped
+    if (action == DPI_ACTION_DROP || action == DPI_ACTION_RESET) {
+        dpi_set_action(p, DPI_ACTION_DROP);
+        th_counter.drop_meters ++;
+        return DPI_METER_ACTION_CLEAR;
+    }
+    return DPI_METER_ACTION_NONE;
+}
+
 int dpi_meter_session_inc(dpi_packet_t *p, dpi_session_t *s)
 {
     if (!(s->flags & DPI_SESS_FLAG_INGRESS)) return DPI_METER_ACTION_NONE;
@@ -11,7 +11,8 @@ typedef struct meter_info_ {
     uint8_t rate   :1,
             limit  :1, // Number of incidents is allowed every 'span' of seconds
             per_dst:1,
-            per_src:1;
+            per_src:1,
+            sketch :1; // Count in a sketch, only heavy hitters get a meter
     uint8_t timeout;
     uint8_t log_timeout;
     uint8_t span; // If rate reaches 'limit' in 'span' of seconds, for example 100 in 10 seconds
@@ -28,7 +29,6 @@ enum {
 };
 
 typedef struct dpi_meter_ {
-    struct cds_lfht_node node;
     timer_entry_t ts_entry;
 
     io_ip_t peer_ip;
@@ -41,6 +41,41 @@ typedef struct dpi_meter_ {
     DPMsgThreatLog log;
 } dpi_meter_t;
 
+// Count-min sketch of the recent rate of each (endpoint, peer). Counts go to the current window,
+// which replaces the previous one every 'span' seconds. A source is promoted to an exact meter
+// once its estimate over both windows reaches the lower limit.
+#define DPI_METER_SKETCH_DEPTH 4
+#define DPI_METER_SKETCH_BITS  11
+#define DPI_METER_SKETCH_WIDTH (1 << DPI_METER_SKETCH_BITS)
+
+typedef struct dpi_meter_sketch_ {
+    uint32_t start_tick;
+    uint8_t cur;
+    uint32_t count[2][DPI_METER_SKETCH_DEPTH][DPI_METER_SKETCH_WIDTH];
+} dpi_meter_sketch_t;
+
+// Distinct destinations, ip and port, that a source sends a SYN without session to, counted in
+// a HyperLogLog. Sources share a fixed table of 2-way sets, the oldest entry of a set is taken
+// over by a new source. An entry counts for 'span' seconds from its first SYN.
+#define DPI_SCAN_HLL_BITS  6
+#define DPI_SCAN_HLL_REGS  (1 << DPI_SCAN_HLL_BITS)
+#define DPI_SCAN_SET_BITS  9
+#define DPI_SCAN_SETS      (1 << DPI_SCAN_SET_BITS)
+#define DPI_SCAN_WAYS      2
+#define DPI_SCAN_SPAN      60
+#define DPI_SCAN_LIMIT     1000
+
+typedef struct dpi_scan_entry_ {
+    uint32_t tag;
+    uint32_t start_tick;
+    bool fired;
+    uint8_t reg[DPI_SCAN_HLL_REGS];
+} dpi_scan_entry_t;
+
+typedef struct dpi_scan_sketch_ {
+    dpi_scan_entry_t entry[DPI_SCAN_SETS][DPI_SCAN_WAYS];
+} dpi_scan_sketch_t;
+
 typedef enum dpi_meter_action_ {
     DPI_METER_ACTION_NONE = 0,
     DPI_METER_ACTION_CLEAR,
@@ -50,10 +85,12 @@ typedef enum dpi_meter_action_ {
 void dpi_meter_init(void);
 int dpi_meter_packet_inc(uint8_t type, dpi_packet_t *p);
 int dpi_meter_synflood_inc(dpi_packet_t *p);
+int dpi_meter_scan_inc(dpi_packet_t *p);
 int dpi_meter_session_inc(dpi_packet_t *p, dpi_session_t *s);
 void dpi_meter_session_dec(dpi_session_t *s);
 bool dpi_meter_session_rate(uint8_t type, dpi_session_t *s);
 
 meter_info_t *dpi_get_meter_info(int type);
+bool dpi_syn_cookie_check(dpi_packet_t *p, uint16_t *mss);
 
 #endif
@@ -5,11 +5,17 @@
 #include <time.h>
 
 #include "utils/rcu_map.h"
+#include "utils/flat_map.h"
 #include "utils/timer_wheel.h"
+#include "utils/seqlock.h"
+#include "utils/obj_pool.h"
+#include "utils/mem_acct.h"
+#include "utils/lat_hist.h"
 
 #include "apis.h"
 #include "dpi/dpi_packet.h"
 #include "dpi/dpi_session.h"
+#include "dpi/dpi_meter.h"
 #include "dpi/dpi_debug.h"
 #include "dpi/dpi_log.h"
 #include "dpi/dpi_policy.h"
@@ -18,11 +24,23 @@ extern rcu_map_t g_ep_map;
 extern io_internal_subnet4_t *g_internal_subnet4;
 extern io_spec_internal_subnet4_t *g_specialip_subnet4;
 extern uint8_t g_xff_enabled;
+extern uint8_t g_ssl_cert_inspect;
+extern uint32_t g_http_body_scan;
+extern uint32_t g_dlp_scan_budget;
 extern uint8_t g_disable_net_policy;
 extern uint8_t g_detect_unmanaged_wl;
 extern uint8_t g_enable_icmp_policy;
+extern uint8_t g_icmp_sample;
 extern uint8_t g_strict_group_mode;
 extern io_internal_subnet4_t *g_policy_addr;
+extern uint32_t g_dp_cfg_ver;
+extern uint32_t g_ep_map_gen;
+extern uint32_t g_lat_sample;
+extern uint32_t g_lat_trace;
+extern uint32_t g_policy_hit_gen;
+extern uint8_t g_native_msg;
+extern uint32_t g_log_limit_rate, g_log_limit_burst;
+extern struct dpi_capture_ *g_capture;
 
 typedef struct dpi_snap_ {
     uint32_t tick;
@@ -33,66 +51,266 @@ extern io_config_t *g_io_config;
 
 // Thread data
 
+// Each thread's data starts on its own cacheline. The fields up to the snapshot are only
+// touched by the owning dp thread; counter and stats are published once a second into the
+// snapshot, which is the only part other threads read.
+// Last ipv4 session looked up on each slot, indexed by a symmetric hash of the tuple
+#define DPI_FLOW_CACHE_BITS 8
+#define DPI_FLOW_CACHE_SIZE (1 << DPI_FLOW_CACHE_BITS)
+
+// TCP resets injected while a batch is handled are sent together once it is done
+#define DPI_RESET_QUEUE     32
+#define DPI_RESET_FRAME_LEN (14 + 20 + 20)     // ethernet, ipv4 and tcp headers
+
+// One in g_lat_sample packets is timed through the pipeline, see DP_LAT_*
+typedef struct dpi_latency_ {
+    uint32_t seen;              // packets since the last timed one
+    bool timing;                // the packet being inspected is timed
+    lat_hist_t hists[DP_LAT_HISTS];
+} dpi_latency_t;
+
+// Sessions decided by each policy rule, keyed by dpi_policy_desc_t.id. The dp thread counts
+// the decision of each new session, the ctrl thread reads the table in place. A slot is taken
+// once its hits are set; a table not cleared since g_policy_hit_gen changed is not read.
+#define DPI_POLICY_HIT_BITS   12
+#define DPI_POLICY_HIT_SIZE   (1 << DPI_POLICY_HIT_BITS)
+#define DPI_POLICY_HIT_PROBES 16
+typedef struct dpi_policy_hit_ {
+    uint32_t id;
+    uint32_t last;              // time of the last session
+    uint64_t hits;
+} dpi_policy_hit_t;
+
+typedef struct dpi_policy_hits_ {
+    uint32_t gen;               // g_policy_hit_gen the table was cleared for
+    uint64_t overflow;          // decisions of rules with no room in the table
+    dpi_policy_hit_t entries[DPI_POLICY_HIT_SIZE];
+} dpi_policy_hits_t;
+
+// Endpoints whose apps changed, queued by the dp thread once until the ctrl thread reports
+// them. When the ring is full, the ctrl thread walks all endpoints instead.
+#define DPI_APP_DIRTY_ENTRIES 256
+typedef struct dpi_app_dirty_ {
+    uint32_t writer __attribute__((aligned(64)));
+    uint32_t reader __attribute__((aligned(64)));
+    uint32_t overflow;
+    struct ether_addr macs[DPI_APP_DIRTY_ENTRIES];
+} dpi_app_dirty_t;
+
 typedef struct dpi_thread_data_ {
     dpi_packet_t packet;
     dpi_snap_t snap;
     io_counter_t counter;
 	io_stats_t stats;
 
-    rcu_map_t ip4frag_map;
-    rcu_map_t ip6frag_map;
-    rcu_map_t session4_map;
-    rcu_map_t session4_proxymesh_map;
-    rcu_map_t session6_map;
-    rcu_map_t session6_proxymesh_map;
-    rcu_map_t meter_map;
+    flat_map_t ip4frag_map;
+    flat_map_t ip6frag_map;
+    struct cds_list_head frag_list;     // fragment trackers in the maps, oldest first
+    uint32_t frag_count;
+    flat_map_t session4_map;
+    flat_map_t session6_map;
+    flat_map_t meter_map;
+    dpi_meter_sketch_t *meter_sketch[DPI_METER_MAX];
+    dpi_scan_sketch_t *scan_sketch;
     rcu_map_t log_map;
-    rcu_map_t unknown_ip_map;
+    rcu_map_t log_limit_map;
+    uint32_t log_limits;
+    struct dpi_unknown_ip_set_ *unknown_ip_cache;
     rcu_map_t ip_fqdn_storage_map;
 	timer_wheel_t timer;
+    obj_pool_t pools[DP_POOL_MAX];
+    uint32_t sess_evict_slot;   // where the next eviction sample starts
+    struct dpi_session_ *flow_cache[DPI_FLOW_CACHE_SIZE];
+    struct cds_list_head offload_list;  // sessions offloaded to the kernel
+    flat_map_t flowlet_map;
+    struct cds_list_head flowlet_list;  // flowlets in the map, oldest first
+    struct cds_list_head flowlet_free;
+    struct dpi_flowlet_ *flowlets;      // DPI_FLOWLET_MAX of them
+    uint32_t offload_hold;      // no offload in this tick, the kernel map is full
+    uint32_t reeval_seq;        // policy scope change the sweep is for
+    uint32_t reeval_slot[2];    // where the sweep of the ipv4 and ipv6 session maps goes on
+    uint32_t reeval_left[2];    // sessions left to sweep
+    uint32_t reset_count;
+    uint8_t overload;           // the dp thread is behind, see dpi_overload()
+    uint32_t overload_sessions; // new sessions to admit until the next call
+    uint8_t reset_queue[DPI_RESET_QUEUE][DPI_RESET_FRAME_LEN];
 
 	io_internal_subnet4_t *subnet4;
 	io_spec_internal_subnet4_t *specialipsubnet4;
 	io_internal_subnet4_t *policyaddr;
 
 	void *apache_struts_re_data;
+    void *pcre_match_data;      // shared by the dlp pcre confirms
+    void *pcre_match_ctx;       // with the thread's jit stack
 
     uint8_t dp_msg[DP_MSG_SIZE];
     uint32_t hs_detect_id;
+    uint32_t cfg_ver;           // g_dp_cfg_ver of the config copied above
     uint8_t xff_enabled;
     uint8_t disable_net_policy;
     uint8_t detect_unmanaged_wl;
-} dpi_thread_data_t;
+    uint32_t debug;             // debug levels of the packet or session handled, see IF_DEBUG_LOG()
+    dp_mnt_stage_t *stage;      // in the monitor's page, see dpi_stage_attach()
+
+    seqlock_t snap_lock __attribute__((aligned(64)));
+    io_counter_t counter_snap;
+    io_stats_t stats_snap;
+
+    // Latency histograms are read in place, they are not part of the snapshot
+    dpi_latency_t latency __attribute__((aligned(64)));
+
+    dpi_app_dirty_t app_dirty __attribute__((aligned(64)));
+
+    dpi_policy_hits_t policy_hits __attribute__((aligned(64)));
+} __attribute__((aligned(64))) dpi_thread_data_t;
 
 extern dpi_thread_data_t g_dpi_thread_data[];
+// Data of the calling thread, set once by dpi_init(), so th_xxx don't index the
+// array by THREAD_ID on every access. Threads that never call it use the first slot.
+extern __thread dpi_thread_data_t *g_dpi_thread;
+
+#define th_packet   (g_dpi_thread->packet)
+#define th_snap     (g_dpi_thread->snap)
+#define th_counter  (g_dpi_thread->counter)
+#define th_stats    (g_dpi_thread->stats)
+#define th_snap_lock     (g_dpi_thread->snap_lock)
+#define th_counter_snap  (g_dpi_thread->counter_snap)
+#define th_stats_snap    (g_dpi_thread->stats_snap)
+
+#define th_ip4frag_map  (g_dpi_thread->ip4frag_map)
+#define th_ip6frag_map  (g_dpi_thread->ip6frag_map)
+#define th_frag_list    (g_dpi_thread->frag_list)
+#define th_frag_count   (g_dpi_thread->frag_count)
+#define th_session4_map (g_dpi_thread->session4_map)
+#define th_session6_map (g_dpi_thread->session6_map)
+#define th_meter_map    (g_dpi_thread->meter_map)
+#define th_meter_sketch (g_dpi_thread->meter_sketch)
+#define th_scan_sketch  (g_dpi_thread->scan_sketch)
+#define th_log_map      (g_dpi_thread->log_map)
+#define th_log_limit_map (g_dpi_thread->log_limit_map)
+#define th_log_limits   (g_dpi_thread->log_limits)
+#define th_unknown_ip_cache    (g_dpi_thread->unknown_ip_cache)
+#define th_ip_fqdn_storage_map (g_dpi_thread->ip_fqdn_storage_map)
+#define th_timer        (g_dpi_thread->timer)
+#define th_pool(id)     (&g_dpi_thread->pools[id])
+#define th_sess_evict_slot (g_dpi_thread->sess_evict_slot)
+#define th_flow_cache   (g_dpi_thread->flow_cache)
+#define th_offload_list (g_dpi_thread->offload_list)
+#define th_flowlet_map  (g_dpi_thread->flowlet_map)
+#define th_flowlet_list (g_dpi_thread->flowlet_list)
+#define th_flowlet_free (g_dpi_thread->flowlet_free)
+#define th_flowlets     (g_dpi_thread->flowlets)
+#define th_offload_hold (g_dpi_thread->offload_hold)
+#define th_reeval_seq   (g_dpi_thread->reeval_seq)
+#define th_reeval_slot  (g_dpi_thread->reeval_slot)
+#define th_reeval_left  (g_dpi_thread->reeval_left)
+#define th_reset_count  (g_dpi_thread->reset_count)
+#define th_reset_queue  (g_dpi_thread->reset_queue)
+#define th_overload     (g_dpi_thread->overload)
+#define th_overload_sessions (g_dpi_thread->overload_sessions)
+
+#define th_internal_subnet4 (g_dpi_thread->subnet4)
+#define th_specialip_subnet4 (g_dpi_thread->specialipsubnet4)
+#define th_policy_addr (g_dpi_thread->policyaddr)
+
+#define th_apache_struts_re_data (g_dpi_thread->apache_struts_re_data)
+#define th_pcre_match_data  (g_dpi_thread->pcre_match_data)
+#define th_pcre_match_ctx   (g_dpi_thread->pcre_match_ctx)
+
+#define th_dp_msg   (g_dpi_thread->dp_msg)
+#define th_hs_detect_id        (g_dpi_thread->hs_detect_id)
+#define th_xff_enabled (g_dpi_thread->xff_enabled)
+#define th_disable_net_policy (g_dpi_thread->disable_net_policy)
+#define th_detect_unmanaged_wl (g_dpi_thread->detect_unmanaged_wl)
+#define th_debug (g_dpi_thread->debug)
+#define th_cfg_ver (g_dpi_thread->cfg_ver)
+#define th_latency (g_dpi_thread->latency)
+#define th_app_dirty (g_dpi_thread->app_dirty)
+#define th_policy_hits (g_dpi_thread->policy_hits)
+#define th_stage   (g_dpi_thread->stage)
+#define th_ep_stats(ep) (&(ep)->stats[g_dpi_thread - g_dpi_thread_data])
+
+void dpi_pool_init(int id, uint32_t obj_size);
+
+// Called for each received packet, before any stage is timed
+static inline void dpi_lat_sample(void)
+{
+    uint32_t sample = CMM_LOAD_SHARED(g_lat_sample);
+
+    th_latency.timing = false;
+    if (unlikely(sample != 0) && ++ th_latency.seen >= sample) {
+        th_latency.seen = 0;
+        th_latency.timing = true;
+    }
+}
+
+// 0 if the packet is not timed
+static inline uint64_t dpi_lat_start(void)
+{
+    return unlikely(th_latency.timing) ? tsc_read() : 0;
+}
+
+// Record a stage of a timed packet in the trace ring, see dpi_trace.c
+void dpi_trace_add(int hist, uint64_t start, uint64_t ticks);
+
+static inline void dpi_lat_stop(int hist, uint64_t start)
+{
+    if (unlikely(start != 0)) {
+        uint64_t ticks = tsc_read() - start;
+
+        lat_hist_add(&th_latency.hists[hist], ticks);
+        if (unlikely(CMM_LOAD_SHARED(g_lat_trace))) {
+            dpi_trace_add(hist, start, ticks);
+        }
+    }
+}
+
+// Stage of the thread for the monitor's watchdog. A sub-stage of a packet keeps the time
+// the packet was taken up.
+static inline void dpi_stage_enter(int stage, uint64_t since)
+{
+    CMM_STORE_SHARED(th_stage->since, since);
+    CMM_STORE_SHARED(th_stage->sess_id, 0);
+    CMM_STORE_SHARED(th_stage->stage, stage);
+}
+
+static inline void dpi_stage_set(int stage)
+{
+    CMM_STORE_SHARED(th_stage->stage, stage);
+}
+
+// Sub-stage of the packet being inspected, with its session
+static inline void dpi_stage_packet(int stage, dpi_packet_t *p)
+{
+    dp_mnt_stage_t *st = th_stage;
+
+    if (p->session != NULL && p->session->id != st->sess_id) {
+        if (p->ep_mac != NULL) {
+            mac_cpy(st->ep_mac, p->ep_mac);
+        }
+        CMM_STORE_SHARED(st->sess_id, p->session->id);
+    }
+    CMM_STORE_SHARED(st->stage, stage);
+}
+
+// Quarantine the session the monitor found the thread stuck on, see dpi_entry.c
+void dpi_stage_quarantine(void);
+
+static inline void dpi_stage_leave(void)
+{
+    if (unlikely(CMM_LOAD_SHARED(th_stage->quarantine) != 0)) {
+        dpi_stage_quarantine();
+    }
+    CMM_STORE_SHARED(th_stage->stage, DP_STAGE_IDLE);
+}
+
+// Copy the packet to the capture ring if it matches, see dpi_capture.c
+void dpi_capture_packet(dpi_packet_t *p);
 
-#define th_packet   (g_dpi_thread_data[THREAD_ID].packet)
-#define th_snap     (g_dpi_thread_data[THREAD_ID].snap)
-#define th_counter  (g_dpi_thread_data[THREAD_ID].counter)
-#define th_stats    (g_dpi_thread_data[THREAD_ID].stats)
-
-#define th_ip4frag_map  (g_dpi_thread_data[THREAD_ID].ip4frag_map)
-#define th_ip6frag_map  (g_dpi_thread_data[THREAD_ID].ip6frag_map)
-#define th_session4_map (g_dpi_thread_data[THREAD_ID].session4_map)
-#define th_session4_proxymesh_map (g_dpi_thread_data[THREAD_ID].session4_proxymesh_map)
-#define th_session6_map (g_dpi_thread_data[THREAD_ID].session6_map)
-#define th_session6_proxymesh_map (g_dpi_thread_data[THREAD_ID].session6_proxymesh_map)
-#define th_meter_map    (g_dpi_thread_data[THREAD_ID].meter_map)
-#define th_log_map      (g_dpi_thread_data[THREAD_ID].log_map)
-#define th_unknown_ip_map      (g_dpi_thread_data[THREAD_ID].unknown_ip_map)
-#define th_ip_fqdn_storage_map (g_dpi_thread_data[THREAD_ID].ip_fqdn_storage_map)
-#define th_timer        (g_dpi_thread_data[THREAD_ID].timer)
-
-#define th_internal_subnet4 (g_dpi_thread_data[THREAD_ID].subnet4)
-#define th_specialip_subnet4 (g_dpi_thread_data[THREAD_ID].specialipsubnet4)
-#define th_policy_addr (g_dpi_thread_data[THREAD_ID].policyaddr)
-
-#define th_apache_struts_re_data (g_dpi_thread_data[THREAD_ID].apache_struts_re_data)
-
-#define th_dp_msg   (g_dpi_thread_data[THREAD_ID].dp_msg)
-#define th_hs_detect_id        (g_dpi_thread_data[THREAD_ID].hs_detect_id)
-#define th_xff_enabled (g_dpi_thread_data[THREAD_ID].xff_enabled)
-#define th_disable_net_policy (g_dpi_thread_data[THREAD_ID].disable_net_policy)
-#define th_detect_unmanaged_wl (g_dpi_thread_data[THREAD_ID].detect_unmanaged_wl)
+// Initial size of a map, from the workload count and session limit
+static inline uint32_t dpi_map_size(int id, uint32_t def)
+{
+    return g_io_config->map_size[id] > 0 ? g_io_config->map_size[id] : def;
+}
 
 #endif
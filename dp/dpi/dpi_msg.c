@@ -1,6 +1,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <fcntl.h>
 #include <linux/if_ether.h>
@@ -15,28 +16,61 @@
 #define DUMP_POLICY_FILE "/var/log/dp.pol"
 extern dpi_fqdn_hdl_t *g_fqdn_hdl;
 
-static void dpi_ctrl_req_done(void)
+// Read the snapshots published by the dp threads, so the ctrl thread never touches the
+// cachelines the threads are updating.
+void dpi_read_counter(int thr_id, io_counter_t *c)
 {
-    pthread_mutex_lock(&g_ctrl_req_lock);
-    pthread_cond_signal(&g_ctrl_req_cond);
-    pthread_mutex_unlock(&g_ctrl_req_lock);
+    dpi_thread_data_t *th = &g_dpi_thread_data[thr_id];
+    uint32_t seq;
+
+    do {
+        seq = seqlock_read_begin(&th->snap_lock);
+        *c = th->counter_snap;
+    } while (seqlock_read_retry(&th->snap_lock, seq));
 }
 
-static void dpi_dlp_ctrl_req_done(void)
+// Pop up to max endpoints queued by the dp thread, -1 if some were lost and the ctrl thread
+// has to walk all of them.
+int dpi_app_dirty_drain(int thr_id, struct ether_addr *macs, int max)
 {
-    pthread_mutex_lock(&g_dlp_ctrl_req_lock);
-    pthread_cond_signal(&g_dlp_ctrl_req_cond);
-    pthread_mutex_unlock(&g_dlp_ctrl_req_lock);
+    dpi_app_dirty_t *q = &g_dpi_thread_data[thr_id].app_dirty;
+    uint32_t rd = q->reader, wr = uatomic_read(&q->writer);
+    int cnt = 0;
+
+    if (uatomic_xchg(&q->overflow, 0)) {
+        uatomic_set(&q->reader, wr);
+        return -1;
+    }
+
+    cmm_smp_rmb();
+    for (; rd != wr && cnt < max; rd ++) {
+        macs[cnt ++] = q->macs[rd % DPI_APP_DIRTY_ENTRIES];
+    }
+    uatomic_set(&q->reader, rd);
+    return cnt;
+}
+
+static void dpi_read_stats(int thr_id, io_stats_t *s)
+{
+    dpi_thread_data_t *th = &g_dpi_thread_data[thr_id];
+    uint32_t seq;
+
+    do {
+        seq = seqlock_read_begin(&th->snap_lock);
+        *s = th->stats_snap;
+    } while (seqlock_read_retry(&th->snap_lock, seq));
 }
 
 void dpi_get_stats(io_stats_t *stats, dpi_stats_callback_fct cb)
 {
+    io_stats_t s;
     int i;
 
     DEBUG_LOG_FUNC_ENTRY(DBG_CTRL, NULL);
 
     for (i = 0; i < MAX_DP_THREADS; i ++) {
-        cb(stats, &g_dpi_thread_data[i].stats);
+        dpi_read_stats(i, &s);
+        cb(stats, &s);
     }
 }
 
@@ -44,53 +78,184 @@ void dpi_get_device_counter(DPMsgDeviceCounter *c)
 {
     DEBUG_LOG_FUNC_ENTRY(DBG_CTRL, NULL);
 
+    io_counter_t counter;
     int i, j;
     for (i = 0; i < MAX_DP_THREADS; i ++) {
-        c->ErrorPackets += g_dpi_thread_data[i].counter.err_pkts;
-        c->NoWorkloadPackets += g_dpi_thread_data[i].counter.unkn_pkts;
-        c->IPv4Packets += g_dpi_thread_data[i].counter.ipv4_pkts;
-        c->IPv6Packets += g_dpi_thread_data[i].counter.ipv6_pkts;
-        c->TCPPackets += g_dpi_thread_data[i].counter.tcp_pkts;
-        c->TCPNoSessionPackets += g_dpi_thread_data[i].counter.tcp_nosess_pkts;
-        c->UDPPackets += g_dpi_thread_data[i].counter.udp_pkts;
-        c->ICMPPackets += g_dpi_thread_data[i].counter.icmp_pkts;
-        c->OtherPackets += g_dpi_thread_data[i].counter.other_pkts;
-        c->Assemblys += g_dpi_thread_data[i].counter.total_asms;
-        c->FreedAssemblys += g_dpi_thread_data[i].counter.freed_asms;
-        c->Fragments += g_dpi_thread_data[i].counter.total_frags;
-        c->FreedFragments += g_dpi_thread_data[i].counter.freed_frags;
-        c->TimeoutFragments += g_dpi_thread_data[i].counter.tmout_frags;
-        c->TotalSessions += g_dpi_thread_data[i].counter.sess_id;
-        c->TCPSessions += g_dpi_thread_data[i].counter.tcp_sess;
-        c->UDPSessions += g_dpi_thread_data[i].counter.udp_sess;
-        c->ICMPSessions += g_dpi_thread_data[i].counter.icmp_sess;
-        c->IPSessions += g_dpi_thread_data[i].counter.ip_sess;
-        c->DropMeters += g_dpi_thread_data[i].counter.drop_meters;
-        c->ProxyMeters += g_dpi_thread_data[i].counter.proxy_meters;
-        c->CurMeters += g_dpi_thread_data[i].counter.cur_meters;
-        c->CurLogCaches += g_dpi_thread_data[i].counter.cur_log_caches;
+        dpi_read_counter(i, &counter);
+
+        c->ErrorPackets += counter.err_pkts;
+        c->NoWorkloadPackets += counter.unkn_pkts;
+        c->IPv4Packets += counter.ipv4_pkts;
+        c->IPv6Packets += counter.ipv6_pkts;
+        c->TCPPackets += counter.tcp_pkts;
+        c->TCPNoSessionPackets += counter.tcp_nosess_pkts;
+        c->UDPPackets += counter.udp_pkts;
+        c->ICMPPackets += counter.icmp_pkts;
+        c->OtherPackets += counter.other_pkts;
+        c->Assemblys += counter.total_asms;
+        c->FreedAssemblys += counter.freed_asms;
+        c->Fragments += counter.total_frags;
+        c->FreedFragments += counter.freed_frags;
+        c->TimeoutFragments += counter.tmout_frags;
+        c->TotalSessions += counter.sess_id;
+        c->TCPSessions += counter.tcp_sess;
+        c->UDPSessions += counter.udp_sess;
+        c->ICMPSessions += counter.icmp_sess;
+        c->IPSessions += counter.ip_sess;
+        c->DropMeters += counter.drop_meters;
+        c->ProxyMeters += counter.proxy_meters;
+        c->CurMeters += counter.cur_meters;
+        c->CurLogCaches += counter.cur_log_caches;
         for (j = 0; j < DPI_PARSER_MAX; j ++) {
-            c->ParserSessions[j] += g_dpi_thread_data[i].counter.parser_sess[j];
-            c->ParserPackets[j] += g_dpi_thread_data[i].counter.parser_pkts[j];
+            c->ParserSessions[j] += counter.parser_sess[j];
+            c->ParserPackets[j] += counter.parser_pkts[j];
+            c->ParserCPUTime[j] += counter.parser_ticks[j];
         }
-        c->PolicyType1Rules += g_dpi_thread_data[i].counter.type1_rules;
-        c->PolicyType2Rules += g_dpi_thread_data[i].counter.type2_rules;
-        c->PolicyDomains += g_dpi_thread_data[i].counter.domains;
-        c->PolicyDomainIPs += g_dpi_thread_data[i].counter.domain_ips;
+        c->PolicyType1Rules += counter.type1_rules;
+        c->PolicyType2Rules += counter.type2_rules;
+        c->PolicyDomains += counter.domains;
+        c->PolicyDomainIPs += counter.domain_ips;
+        for (j = 0; j < DP_POOL_MAX; j ++) {
+            c->PoolInUse[j] += counter.pool_in_use[j];
+            c->PoolHighWater[j] += counter.pool_high_water[j];
+            c->PoolAllocFails[j] += counter.pool_fails[j];
+        }
+        for (j = 0; j < DP_MAP_MAX; j ++) {
+            c->MapEntries[j] += counter.map_entries[j];
+            c->MapBuckets[j] += counter.map_buckets[j];
+            c->MapResizes[j] += counter.map_resizes[j];
+        }
+        for (j = 0; j < DP_SESS_EVICT_MAX; j ++) {
+            c->SessionEvicts[j] += counter.sess_evicts[j];
+        }
+        c->SessionLimitDrops += counter.sess_limit_drops;
+        c->TimerExpires += counter.timer_expires;
+        c->TimerDeferredRolls += counter.timer_deferred;
+        c->TimerBacklog += counter.timer_backlog;
+        c->FlowCacheHits += counter.flow_cache_hits;
+        c->FlowCacheMisses += counter.flow_cache_misses;
+        c->VerdictPackets += counter.verdict_pkts;
+        c->VerdictRevokes += counter.verdict_revokes;
+        c->FlowOffloads += counter.offload_flows;
+        c->FlowOffloadFails += counter.offload_fails;
+        c->FlowOffloadPackets += counter.offload_pkts;
+        c->NfqMarks += counter.nfq_marks;
+        c->NfqUnmarks += counter.nfq_unmarks;
+        c->PolicyCacheHits += counter.policy_cache_hits;
+        c->PolicyCacheMisses += counter.policy_cache_misses;
+        c->PolicyReevalSkips += counter.policy_reeval_skips;
+        c->UnknownIPInserts += counter.unknown_ip_inserts;
+        c->UnknownIPEvicts += counter.unknown_ip_evicts;
+        c->AsmBytes += counter.asm_bytes;
+        c->AsmLimits += counter.asm_limits;
+        c->FragmentEvictions += counter.evict_frags;
+    }
+
+    lat_hist_t hists[DP_LAT_HISTS];
+    uint64_t hz = lat_tsc_hz();
+
+    dpi_get_latency(hists);
+    for (j = 0; j < DP_LAT_HISTS; j ++) {
+        c->LatencySamples[j] = hists[j].count;
+        c->LatencyP50[j] = lat_tsc_to_ns(lat_hist_percentile(&hists[j], 50), hz);
+        c->LatencyP99[j] = lat_tsc_to_ns(lat_hist_percentile(&hists[j], 99), hz);
+        c->LatencyMax[j] = lat_tsc_to_ns(hists[j].max, hz);
+    }
+    for (j = 0; j < DPI_PARSER_MAX; j ++) {
+        c->ParserCPUTime[j] = lat_tsc_to_ns(c->ParserCPUTime[j], hz);
     }
 }
 
+// Histograms of all dp threads, DP_LAT_HISTS of them. They are read while being written.
+void dpi_get_latency(lat_hist_t *hists)
+{
+    int i, j;
+
+    memset(hists, 0, sizeof(lat_hist_t) * DP_LAT_HISTS);
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        dpi_latency_t *l = &g_dpi_thread_data[i].latency;
+
+        for (j = 0; j < DP_LAT_HISTS; j ++) {
+            lat_hist_merge(&hists[j], &l->hists[j]);
+        }
+    }
+}
+
+static int policy_hit_cmp(const void *a, const void *b)
+{
+    const DPMsgPolicyHit *ha = a, *hb = b;
+
+    return ha->ID < hb->ID ? -1 : ha->ID > hb->ID;
+}
+
+// Policy rule hits of all dp threads since the last reset, merged by rule and sorted by id.
+// The array is allocated for the caller, -1 if it can't be. The tables are read while being
+// written.
+int dpi_get_policy_hits(DPMsgPolicyHit **hits, uint64_t *overflow)
+{
+    uint32_t gen = CMM_LOAD_SHARED(g_policy_hit_gen);
+    DPMsgPolicyHit *list;
+    int i, j, cnt = 0;
+
+    *overflow = 0;
+    list = calloc(MAX_DP_THREADS * DPI_POLICY_HIT_SIZE, sizeof(*list));
+    if (list == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        dpi_policy_hits_t *h = &g_dpi_thread_data[i].policy_hits;
+
+        if (CMM_LOAD_SHARED(h->gen) != gen) {
+            continue;
+        }
+        cmm_smp_rmb();
+        *overflow += CMM_LOAD_SHARED(h->overflow);
+        for (j = 0; j < DPI_POLICY_HIT_SIZE; j ++) {
+            dpi_policy_hit_t *e = &h->entries[j];
+            uint64_t n = CMM_LOAD_SHARED(e->hits);
+
+            if (n == 0) {
+                continue;
+            }
+            cmm_smp_rmb();
+            list[cnt].ID = e->id;
+            list[cnt].LastHit = CMM_LOAD_SHARED(e->last);
+            list[cnt].Hits = n;
+            cnt ++;
+        }
+    }
+
+    qsort(list, cnt, sizeof(*list), policy_hit_cmp);
+    for (i = 0, j = 0; i < cnt; i ++) {
+        if (j > 0 && list[j - 1].ID == list[i].ID) {
+            list[j - 1].Hits += list[i].Hits;
+            if (list[i].LastHit > list[j - 1].LastHit) {
+                list[j - 1].LastHit = list[i].LastHit;
+            }
+        } else {
+            list[j ++] = list[i];
+        }
+    }
+
+    *hits = list;
+    return j;
+}
+
 void dpi_count_session(DPMsgSessionCount *c)
 {
     DEBUG_LOG_FUNC_ENTRY(DBG_CTRL, NULL);
 
+    io_counter_t counter;
     int i;
     for (i = 0; i < MAX_DP_THREADS; i ++) {
-        c->CurSess += g_dpi_thread_data[i].counter.cur_sess;
-        c->CurTCPSess += g_dpi_thread_data[i].counter.cur_tcp_sess;
-        c->CurUDPSess += g_dpi_thread_data[i].counter.cur_udp_sess;
-        c->CurICMPSess += g_dpi_thread_data[i].counter.cur_icmp_sess;
-        c->CurIPSess += g_dpi_thread_data[i].counter.cur_ip_sess;
+        dpi_read_counter(i, &counter);
+
+        c->CurSess += counter.cur_sess;
+        c->CurTCPSess += counter.cur_tcp_sess;
+        c->CurUDPSess += counter.cur_udp_sess;
+        c->CurICMPSess += counter.cur_icmp_sess;
+        c->CurIPSess += counter.cur_ip_sess;
     }
 }
 
@@ -103,7 +268,7 @@ typedef struct session_args_ {
     uint16_t count;
 } session_args_t;
 
-static void send_sessions(int count)
+static void send_sessions(int count, bool native)
 {
     DEBUG_LOG(DBG_CTRL, NULL, "count=%u\n", count);
 
@@ -115,6 +280,7 @@ static void send_sessions(int count)
     hdr->Length = htons(len);
     hdr->More = 1;
     dpsh->Sessions = htons(count);
+    dpsh->Flags = htons(native ? DP_MSG_FLAG_NATIVE : 0);
     g_io_callback->send_ctrl_binary(th_dp_msg, len);
 }
 
@@ -143,172 +309,153 @@ static void netify_session_log(DPMsgSession *dps)
     dps->XffPort = htons(dps->XffPort);
 }
 
-static void dpi_list_session()
-{
+typedef struct list_session_args_ {
     int count;
     DPMsgSession *dps;
+    io_ctrl_session_list_t *filter;     // NULL to list all
+    uint32_t listed;
+    bool native;                        // entries in host order, see DP_MSG_FLAG_NATIVE
+} list_session_args_t;
 
-    DEBUG_LOG_FUNC_ENTRY(DBG_CTRL, NULL);
+static bool session_filter_match(dpi_session_t *s, io_ctrl_session_list_t *f)
+{
+    if ((f->filters & CTRL_SESSION_BY_MAC) &&
+        !mac_cmp((s->flags & DPI_SESS_FLAG_INGRESS) ? s->server.mac : s->client.mac, f->mac.ether_addr_octet)) {
+        return false;
+    }
+    if ((f->filters & CTRL_SESSION_BY_PORT) && s->server.port != f->port) {
+        return false;
+    }
+    if ((f->filters & CTRL_SESSION_BY_APP) && s->app != f->app) {
+        return false;
+    }
+    if ((f->filters & CTRL_SESSION_BY_ACTION) && s->policy_desc.action != f->action) {
+        return false;
+    }
+    return true;
+}
 
-    count = 0;
-    dps = SESSIONS_FIRST_ENTRY;
+static bool list_one_session(void *data, void *args)
+{
+    dpi_session_t *sess = data;
+    list_session_args_t *ls = args;
 
-    struct cds_lfht_node *node;
-    struct cds_lfht_iter iter;
-    RCU_MAP_ITR_FOR_EACH(&th_session4_map, iter, node) {
-        dpi_session_t *sess = STRUCT_OF(node, dpi_session_t, node);
-        dpi_session_log(sess, dps, NULL);
-        netify_session_log(dps);
-
-        count ++;
-        dps ++;
-        if (count == SESSIONS_PER_MSG) {
-            send_sessions(count);
-            count = 0;
-            dps = SESSIONS_FIRST_ENTRY;
-        }
+    if (ls->filter != NULL && !session_filter_match(sess, ls->filter)) {
+        return false;
     }
+    ls->listed ++;
 
-    if (th_session4_proxymesh_map.map) {
-        RCU_MAP_ITR_FOR_EACH(&th_session4_proxymesh_map, iter, node) {
-            dpi_session_t *sess = STRUCT_OF(node, dpi_session_t, node);
-            dpi_session_log(sess, dps, NULL);
-            netify_session_log(dps);
+    dpi_session_log(sess, ls->dps, NULL);
+    if (!ls->native && FLAGS_TEST(sess->flags, DPI_SESS_FLAG_IPV4)) {
+        netify_session_log(ls->dps);
+    }
 
-            count ++;
-            dps ++;
-            if (count == SESSIONS_PER_MSG) {
-                send_sessions(count);
-                count = 0;
-                dps = SESSIONS_FIRST_ENTRY;
-            }
-        }
+    ls->count ++;
+    ls->dps ++;
+    if (ls->count == SESSIONS_PER_MSG) {
+        send_sessions(ls->count, ls->native);
+        ls->count = 0;
+        ls->dps = SESSIONS_FIRST_ENTRY;
     }
+    return false;
+}
 
-    RCU_MAP_ITR_FOR_EACH(&th_session6_map, iter, node) {
-        dpi_session_t *sess = STRUCT_OF(node, dpi_session_t, node);
-        dpi_session_log(sess, dps, NULL);
+static void dpi_list_session()
+{
+    list_session_args_t ls;
 
-        count ++;
-        dps ++;
-        if (count == SESSIONS_PER_MSG) {
-            send_sessions(count);
-            count = 0;
-            dps = SESSIONS_FIRST_ENTRY;
-        }
-    }
+    DEBUG_LOG_FUNC_ENTRY(DBG_CTRL, NULL);
 
-    if (th_session6_proxymesh_map.map) {
-        RCU_MAP_ITR_FOR_EACH(&th_session6_proxymesh_map, iter, node) {
-            dpi_session_t *sess = STRUCT_OF(node, dpi_session_t, node);
-            dpi_session_log(sess, dps, NULL);
-        
-            count ++;
-            dps ++;
-            if (count == SESSIONS_PER_MSG) {
-                send_sessions(count);
-                count = 0;
-                dps = SESSIONS_FIRST_ENTRY;
-            }
-        }
-    }
+    ls.count = 0;
+    ls.dps = SESSIONS_FIRST_ENTRY;
+    ls.filter = NULL;
+    ls.native = CMM_LOAD_SHARED(g_native_msg);
 
-    if (count > 0) {
-        send_sessions(count);
+    flat_map_for_each(&th_session4_map, list_one_session, &ls);
+    flat_map_for_each(&th_session6_map, list_one_session, &ls);
+
+    if (ls.count > 0) {
+        send_sessions(ls.count, ls.native);
     }
 }
 
-static void dpi_clear_session()
+// The map in the cursor, above the position in the map
+#define SESSION_CURSOR_MAP(c)   ((uint32_t)((c) >> 32))
+#define SESSION_CURSOR_POS(c)   ((uint32_t)(c))
+#define SESSION_CURSOR(map, pos) (((uint64_t)(map) << 32) | (pos))
+
+static bool list_session_limit(void *data, void *args)
 {
-    struct cds_lfht_node *node;
-    struct cds_lfht_iter iter;
-
-    RCU_MAP_ITR_FOR_EACH(&th_session4_map, iter, node) {
-        dpi_session_t *sess = STRUCT_OF(node, dpi_session_t, node);
-        if (!g_sess_id_to_clear) {
-            dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
-        } else if (g_sess_id_to_clear == sess->id) {
-            dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
+    list_session_args_t *ls = args;
+
+    list_one_session(data, args);
+    return ls->listed >= ls->filter->limit;
+}
+
+static uint64_t dpi_list_session_chunk(io_ctrl_session_list_t *list)
+{
+    uint32_t map = SESSION_CURSOR_MAP(list->cursor), pos = SESSION_CURSOR_POS(list->cursor);
+    list_session_args_t ls;
+
+    ls.count = 0;
+    ls.dps = SESSIONS_FIRST_ENTRY;
+    ls.filter = list;
+    ls.listed = 0;
+    ls.native = CMM_LOAD_SHARED(g_native_msg);
+
+    for (; map < 2 && ls.listed < list->limit; map ++, pos = 0) {
+        pos = flat_map_walk_from(map == 0 ? &th_session4_map : &th_session6_map, pos,
+                                 list->limit - ls.listed, list_session_limit, &ls);
+        if (pos != 0) {
             break;
         }
     }
-    if (th_session4_proxymesh_map.map) {
-        RCU_MAP_ITR_FOR_EACH(&th_session4_proxymesh_map, iter, node) {
-            dpi_session_t *sess = STRUCT_OF(node, dpi_session_t, node);
-            if (!g_sess_id_to_clear) {
-                dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
-            } else if (g_sess_id_to_clear == sess->id) {
-                dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
-                break;
-            }
-        }
-    }
-    RCU_MAP_ITR_FOR_EACH(&th_session6_map, iter, node) {
-        dpi_session_t *sess = STRUCT_OF(node, dpi_session_t, node);
-        if (!g_sess_id_to_clear) {
-            dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
-        } else if (g_sess_id_to_clear == sess->id) {
-            dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
-            break;
-        }
+
+    if (ls.count > 0) {
+        send_sessions(ls.count, ls.native);
     }
-    if (th_session6_proxymesh_map.map) {
-        RCU_MAP_ITR_FOR_EACH(&th_session6_proxymesh_map, iter, node) {
-            dpi_session_t *sess = STRUCT_OF(node, dpi_session_t, node);
-            if (!g_sess_id_to_clear) {
-                dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
-            } else if (g_sess_id_to_clear == sess->id) {
-                dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
-                break;
-            }
-        }
+    if (map >= 2) {
+        return CTRL_SESSION_CURSOR_END;
     }
+    return SESSION_CURSOR(map, pos);
 }
 
-static void dpi_session_delete_by_mac(struct ether_addr *mac_addr)
+// Return true to stop after the given session
+static bool clear_one_session(void *data, void *args)
 {
-    struct cds_lfht_node *node;
-    struct cds_lfht_iter iter;
-    uint8_t *ep_mac;
-
-    RCU_MAP_ITR_FOR_EACH(&th_session4_map, iter, node) {
-        dpi_session_t *s = STRUCT_OF(node, dpi_session_t, node);
-        ep_mac = (s->flags & DPI_SESS_FLAG_INGRESS)?s->server.mac:s->client.mac;
-        if (!mac_cmp(ep_mac, (uint8_t *)mac_addr)) {
-            continue;
-        }
-        dpi_session_delete(s, DPI_SESS_TERM_NORMAL);
+    dpi_session_t *sess = data;
+    uint32_t sess_id = *(uint32_t *)args;
+
+    if (!sess_id) {
+        dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
+    } else if (sess_id == sess->id) {
+        dpi_session_delete(sess, DPI_SESS_TERM_NORMAL);
+        return true;
     }
+    return false;
+}
 
-    if (th_session4_proxymesh_map.map) {
-        RCU_MAP_ITR_FOR_EACH(&th_session4_proxymesh_map, iter, node) {
-            dpi_session_t *s = STRUCT_OF(node, dpi_session_t, node);
-            ep_mac = (s->flags & DPI_SESS_FLAG_INGRESS)?s->server.mac:s->client.mac;
-            if (!mac_cmp(ep_mac, (uint8_t *)mac_addr)) {
-                continue;
-            }
-            dpi_session_delete(s, DPI_SESS_TERM_NORMAL);
-        }
-    }
+static void dpi_clear_session(uint32_t sess_id)
+{
+    flat_map_for_each(&th_session4_map, clear_one_session, &sess_id);
+    flat_map_for_each(&th_session6_map, clear_one_session, &sess_id);
+}
 
-    RCU_MAP_ITR_FOR_EACH(&th_session6_map, iter, node) {
-        dpi_session_t *s = STRUCT_OF(node, dpi_session_t, node);
-        ep_mac = (s->flags & DPI_SESS_FLAG_INGRESS)?s->server.mac:s->client.mac;
-        if (!mac_cmp(ep_mac, (uint8_t *)mac_addr)) {
-            continue;
-        }
+static bool delete_session_by_mac(void *data, void *args)
+{
+    dpi_session_t *s = data;
+    uint8_t *ep_mac = (s->flags & DPI_SESS_FLAG_INGRESS)?s->server.mac:s->client.mac;
+
+    if (mac_cmp(ep_mac, args)) {
         dpi_session_delete(s, DPI_SESS_TERM_NORMAL);
     }
-    if (th_session6_proxymesh_map.map) {
-        RCU_MAP_ITR_FOR_EACH(&th_session6_proxymesh_map, iter, node) {
-            dpi_session_t *s = STRUCT_OF(node, dpi_session_t, node);
-            ep_mac = (s->flags & DPI_SESS_FLAG_INGRESS)?s->server.mac:s->client.mac;
-            if (!mac_cmp(ep_mac, (uint8_t *)mac_addr)) {
-                continue;
-            }
-            dpi_session_delete(s, DPI_SESS_TERM_NORMAL);
-        }
-    }
+    return false;
+}
+
+static void dpi_session_delete_by_mac(struct ether_addr *mac_addr)
+{
+    flat_map_for_each(&th_session4_map, delete_session_by_mac, mac_addr);
+    flat_map_for_each(&th_session6_map, delete_session_by_mac, mac_addr);
 }
 
 bool iter_print_one_rule(struct cds_lfht_node *ht_node, void *args)
@@ -451,12 +598,12 @@ static void send_meters(meter_args_t *args)
     g_io_callback->send_ctrl_binary(th_dp_msg, len);
 }
 
-static bool list_one_meter(struct cds_lfht_node *ht_node, void *args)
+static bool list_one_meter(void *data, void *args)
 {
     meter_args_t *margs = args;
 
     DPMsgMeter *dpm;
-    dpi_meter_t *m = STRUCT_OF(ht_node, dpi_meter_t, node);
+    dpi_meter_t *m = data;
 
     meter_info_t *info = dpi_get_meter_info(m->type);
     if (info == NULL) return false;
@@ -497,74 +644,73 @@ static void dpi_list_meter()
 
     meter_args_t args;
     args.count = 0;
-    rcu_map_for_each(&th_meter_map, list_one_meter, &args);
+    flat_map_for_each(&th_meter_map, list_one_meter, &args);
 
     if (args.count > 0) {
         send_meters(&args);
     }
 }
 
-void dpi_handle_ctrl_req(int req, io_ctx_t *ctx)
+void dpi_handle_ctrl_req(io_ctrl_cmd_t *cmd, io_ctx_t *ctx)
 {
-    DEBUG_LOG(DBG_CTRL, NULL, "req=%d\n", req);
+    DEBUG_LOG(DBG_CTRL, NULL, "req=%d\n", cmd->req);
 
     th_snap.tick = ctx->tick;
 
-    switch (req) {
+    switch (cmd->req) {
     case CTRL_REQ_LIST_SESSION:
         dpi_list_session();
         break;
+    case CTRL_REQ_LIST_SESSION_CHUNK:
+        if (cmd->future != NULL) {
+            cmd->future->result = dpi_list_session_chunk(&cmd->list);
+        }
+        break;
     case CTRL_REQ_CLEAR_SESSION:
-        dpi_clear_session();
+        dpi_clear_session(cmd->sess_id);
         break;
     case CTRL_REQ_LIST_METER:
         dpi_list_meter();
         break;
     case CTRL_REQ_DEL_MAC:
-        if (g_mac_addr_to_del) {
-            dpi_session_delete_by_mac(g_mac_addr_to_del);
-        }
+        dpi_session_delete_by_mac(&cmd->mac);
         break;
     case CTRL_REQ_DUMP_POLICY:
         dpi_dump_policy();
         break;
     }
 
-    dpi_ctrl_req_done();
     DEBUG_LOG(DBG_CTRL, NULL, "done\n");
     return;
 }
 
-void dpi_handle_dlp_ctrl_req(int req)
+void dpi_handle_dlp_ctrl_req(void)
 {
-    DEBUG_LOG(DBG_CTRL, NULL, "dlp received req=%d\n", req);
     struct timespec before_time , after_time;
+    dpi_detector_t *detector;
     float time_taken; 
-    clock_gettime(CLOCK_MONOTONIC, &before_time);
+    uint8_t req;
+
+    while ((detector = dpi_dlp_next_req(&req)) != NULL) {
+        DEBUG_LOG(DBG_CTRL, NULL, "dlp received detector=%p req=0x%x\n", detector, req);
+        clock_gettime(CLOCK_MONOTONIC, &before_time);
 
-    switch (req) {
-    case CTRL_DLP_REQ_BLD:
-        if (g_build_detector) {
-            dpi_build_dlp_tree(g_build_detector);
+        if (req & (1 << CTRL_DLP_REQ_DEL)) {
+            // No point in building it first
+            dpi_dlp_release_detector(detector);
+            free(detector);
             clock_gettime(CLOCK_MONOTONIC, &after_time);
             time_taken = (float)(after_time.tv_sec - before_time.tv_sec) * 1e9; 
             time_taken = (float)((time_taken + (after_time.tv_nsec - before_time.tv_nsec)) * 1e-9); 
-            DEBUG_DLP("Building dlp time %.9fs\n", time_taken);
-        }
-        break;
-    case CTRL_DLP_REQ_DEL:
-        if (g_release_detector) {
-            dpi_dlp_release_detector(g_release_detector);
-            free(g_release_detector);
+            DEBUG_DLP("Release dlp time %.9fs\n", time_taken);
+        } else if (req & (1 << CTRL_DLP_REQ_BLD)) {
+            dpi_build_dlp_tree(detector);
             clock_gettime(CLOCK_MONOTONIC, &after_time);
             time_taken = (float)(after_time.tv_sec - before_time.tv_sec) * 1e9; 
             time_taken = (float)((time_taken + (after_time.tv_nsec - before_time.tv_nsec)) * 1e-9); 
-            DEBUG_DLP("Release dlp time %.9fs\n", time_taken);
+            DEBUG_DLP("Building dlp time %.9fs\n", time_taken);
         }
-        break;
     }
 
-    dpi_dlp_ctrl_req_done();
     DEBUG_LOG(DBG_CTRL, NULL, "done\n");
-    return;
 }
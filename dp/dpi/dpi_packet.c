@@ -14,6 +14,8 @@
 #include "apis.h"
 #include "utils/helper.h"
 #include "utils/bits.h"
+#include "utils/cksum.h"
+#include "utils/hash.h"
 #include "dpi/dpi_module.h"
 
 #define LOG_BAD_PKT(p, format, args...) \
@@ -31,30 +33,11 @@ extern bool dpi_waf_ep_policy_check(dpi_packet_t *p);
 
 static uint16_t get_l4_cksum(uint32_t sum, void *l4_hdr, uint16_t l4_len)
 {
-    register uint16_t *ptr;
-    register int len, i;
-
-    ptr = l4_hdr;
-    len = l4_len >> 1;
-    for (i = 0; i < len; i ++, ptr ++) {
-        sum += *ptr;
-    }
-
-    if (l4_len & 1) {
-        sum += *ptr & htons(0xff00);
-    }
-
-    sum = (sum >> 16) + (sum & 0xffff);
-    sum += (sum >> 16);
-    return (uint16_t)(~sum);
+    return cksum_finish(cksum_partial(l4_hdr, l4_len, sum));
 }
 
 uint16_t get_l4v6_cksum(struct ip6_hdr *ip6h, uint8_t ip_proto, void *l4_hdr, uint16_t l4_len)
 {
-    register uint32_t sum = 0;
-    register uint16_t *ptr;
-    register int i;
-
     union {
         struct {
             struct in6_addr src;
@@ -72,19 +55,12 @@ uint16_t get_l4v6_cksum(struct ip6_hdr *ip6h, uint8_t ip_proto, void *l4_hdr, ui
     u.ph.zero[0] = u.ph.zero[1] = u.ph.zero[2] = 0;
     u.ph.next_header = ip_proto;
 
-    ptr = &u.ph16[0];
-    for (i = 0; i < 20; i ++, ptr ++) {
-        sum += *ptr;
-    }
-
-    return get_l4_cksum(sum, l4_hdr, l4_len);
+    return get_l4_cksum(cksum_partial(u.ph16, sizeof(u.ph16), 0), l4_hdr, l4_len);
 }
 
 uint16_t get_l4v4_cksum(struct iphdr *iph, void *l4_hdr, uint16_t l4_len)
 {
-    register uint32_t sum = 0;
-    register uint16_t *ptr;
-    register int i;
+    uint32_t sum = 0;
 
     if (iph != NULL) {
         union {
@@ -104,10 +80,7 @@ uint16_t get_l4v4_cksum(struct iphdr *iph, void *l4_hdr, uint16_t l4_len)
         u.ph.proto = iph->protocol;
         u.ph.len = htons(l4_len);
 
-        ptr = &u.ph16[0];
-        for (i = 0; i < 6; i ++, ptr ++) {
-            sum += *ptr;
-        }
+        sum = cksum_partial(u.ph16, sizeof(u.ph16), 0);
     }
 
     return get_l4_cksum(sum, l4_hdr, l4_len);
@@ -115,16 +88,7 @@ uint16_t get_l4v4_cksum(struct iphdr *iph, void *l4_hdr, uint16_t l4_len)
 
 uint16_t get_ip_cksum(struct iphdr *iph)
 {
-    register uint16_t *ptr = (uint16_t *)iph;
-    register int len = get_iph_len(iph) >> 1;
-    register uint32_t sum = 0;
-
-    while (len --) {
-        sum += *ptr ++;
-    }
-    sum = (sum >> 16) + (sum & 0xffff);
-    sum += (sum >> 16);
-    return (uint16_t)(~sum);
+    return cksum_finish(cksum_partial(iph, get_iph_len(iph), 0));
 }
 
 int dpi_parse_embed_icmp(dpi_packet_t *p)
@@ -1012,12 +976,12 @@ static void dpi_pkt_policy_reeval(dpi_packet_t *p)
         if (log_violate == 1) {
             FLAGS_SET(p->flags, DPI_PKT_FLAG_LOG_VIOLATE);
         }
-        log_violate = DPI_POLICY_LOG_VIOLATE(s->xff_desc.action);
+        log_violate = DPI_POLICY_LOG_VIOLATE(dpi_session_xff(s)->desc.action);
         if (log_violate == 1) {
             FLAGS_SET(p->flags, DPI_PKT_FLAG_LOG_XFF_VIO);
         }
         if (s->policy_desc.action == DP_POLICY_ACTION_DENY ||
-            s->xff_desc.action == DP_POLICY_ACTION_DENY) {
+            dpi_session_xff(s)->desc.action == DP_POLICY_ACTION_DENY) {
             if (p->ip_proto == IPPROTO_TCP) {
                 dpi_inject_reset(p, true);
                 dpi_inject_reset(p, false);
@@ -1047,7 +1011,7 @@ static void dpi_pkt_log(dpi_packet_t *p)
                 return;
             }
             // proxymesh related session
-            if (cmp_mac_prefix(p->ep_mac,PROXYMESH_MAC_PREFIX) && 
+            if (FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) && 
                 /* 1. send connection report only when  return packet from server is seen */
                 ((!FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS) && s->server.pkts == 0) //||
                 /* 2. not to send connection report for session whose client and server ip are both 127.0.0.1/::1 */
@@ -1085,7 +1049,8 @@ static void dpi_post_cache_packet(dpi_packet_t *p)
 {
     dpi_wing_t *w0 = p->this_wing;
 
-    if ((p->session->flags & DPI_SESS_FLAG_SKIP_PARSER) || p->ip_proto != IPPROTO_TCP) {
+    if ((p->session->flags & DPI_SESS_FLAG_SKIP_PARSER) || p->ip_proto != IPPROTO_TCP ||
+        p->session->asm_limited) {
         w0->asm_seq = w0->next_seq;
     }
 
@@ -1094,7 +1059,7 @@ static void dpi_post_cache_packet(dpi_packet_t *p)
     if (!(p->flags & DPI_PKT_FLAG_CACHED) &&
         p->ip_proto == IPPROTO_TCP && p->raw.len > 0 &&
         u32_gt(p->raw.seq + p->raw.len, w0->asm_seq)) {
-        dpi_cache_packet(p, w0, true);
+        dpi_cache_packet(p, w0, true, false);
 
         // Packet loss is high under load, tcp_tracker() could exit early before calling
         // dpi_cache_packet, for example, if the packet is out-of-window; then asm_seq
@@ -1108,38 +1073,306 @@ static void dpi_post_cache_packet(dpi_packet_t *p)
             asm_destroy(&p->that_wing->asm_cache, dpi_asm_remove);
         }
     }
+    dpi_session_asm_account(p->session);
 
     // debug_dump_session(p->session);
     DEBUG_LOG(DBG_PACKET, p, "ASM cache, seq=0x%x pkts=%u gross=%u\n",
               w0->asm_seq, asm_count(&w0->asm_cache), asm_gross(&w0->asm_cache));
 }
 
+// A session whose inspection is done keeps its verdict, later packets only go through the
+// trackers for counters and TCP state. The verdict holds while the endpoint's policy and
+// DLP/WAF setup stay at the versions it was taken with.
+static inline bool dpi_session_verdict_valid(const dpi_session_t *s, const io_ep_t *ep)
+{
+    return s->verdict_policy_ver == ep->policy_ver &&
+           s->verdict_inspect_ver == ep->inspect_ver &&
+           (!th_disable_net_policy || ep->dlp_detector == NULL);
+}
+
+// Packets of offloaded flows skip the verdict check above. Once a second, take back the flows
+// of endpoints whose policy or DLP/WAF changed, or that are gone or switched to tap mode.
+void dpi_session_offload_check(void)
+{
+    dpi_session_offload_t *o, *next;
+
+    rcu_read_lock();
+    cds_list_for_each_entry_safe(o, next, &th_offload_list, link) {
+        dpi_session_t *s = o->sess;
+        uint8_t *ep_mac = FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS) ? s->server.mac : s->client.mac;
+        io_mac_t *mac = rcu_map_lookup(&g_ep_map, ep_mac);
+
+        if (likely(mac != NULL && !mac->ep->tap && dpi_session_verdict_valid(s, mac->ep))) {
+            continue;
+        }
+        s->verdict_cached = false;
+        th_counter.verdict_revokes ++;
+        dpi_session_offload_resume(s);
+    }
+    rcu_read_unlock();
+}
+
+// A connection of a meshed pod is seen twice, app to sidecar on "lo" and sidecar to the peer
+// on the network. Both legs have the peer's address and the server port, blocks taken on the
+// "lo" leg are shared by this key with the network leg of the parent endpoint.
+static uint32_t mesh_verdict_key(const dpi_session_t *s)
+{
+    struct {
+        io_ip_t peer;
+        uint16_t port;
+        uint8_t ingress;
+    } __attribute__((packed)) k;
+    bool ingress = FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS) ? true : false;
+
+    memset(&k, 0, sizeof(k));
+    k.peer = ingress ? s->client.ip : s->server.ip;
+    k.port = s->server.port;
+    k.ingress = ingress;
+    return hash_key(&k, sizeof(k)) | 1;
+}
+
+// The peer of a "lo" session can be the loopback address or the pod's own, then there is
+// nothing to match on the network leg.
+static bool mesh_peer_known(const dpi_packet_t *p, const dpi_session_t *s)
+{
+    const dpi_wing_t *peer = FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS) ? &s->client : &s->server;
+    int i;
+
+    if (!FLAGS_TEST(s->flags, DPI_SESS_FLAG_IPV4)) {
+        return !IN6_IS_ADDR_LOOPBACK(&peer->ip.ip6);
+    }
+    if ((ntohl(peer->ip.ip4) >> 24) == IN_LOOPBACKNET) {
+        return false;
+    }
+    if (p->ep->pips != NULL) {
+        for (i = 0; i < p->ep->pips->count; i ++) {
+            if (peer->ip.ip4 == p->ep->pips->list[i].ip) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// A session on "lo" of a proxymesh child is blocked
+static void dpi_session_mesh_share(dpi_packet_t *p)
+{
+    dpi_session_t *s = p->session;
+    io_mesh_verdict_t *mv;
+    io_mac_t *mac;
+    uint32_t key;
+
+    if (mac_zero(p->ep->pmac.ether_addr_octet) || !mesh_peer_known(p, s)) {
+        return;
+    }
+    mac = rcu_map_lookup(&g_ep_map, &p->ep->pmac);
+    if (mac == NULL || (mv = rcu_dereference(mac->ep->mesh_verdict)) == NULL) {
+        return;
+    }
+
+    key = mesh_verdict_key(s);
+    CMM_STORE_SHARED(mv->slot[key % IO_MESH_VERDICT_SLOTS],
+                     ((uint64_t)key << 32) | (uint32_t)(th_snap.tick + IO_MESH_VERDICT_TIMEOUT));
+}
+
+// The network leg of a meshed pod was blocked on its "lo" leg
+static bool dpi_session_mesh_blocked(dpi_packet_t *p)
+{
+    io_mesh_verdict_t *mv = rcu_dereference(p->ep->mesh_verdict);
+    uint32_t key;
+    uint64_t v;
+
+    if (mv == NULL) {
+        return false;
+    }
+    key = mesh_verdict_key(p->session);
+    v = CMM_LOAD_SHARED(mv->slot[key % IO_MESH_VERDICT_SLOTS]);
+    return (uint32_t)(v >> 32) == key && u32_lt(th_snap.tick, (uint32_t)v);
+}
+
+static void dpi_session_cache_verdict(dpi_packet_t *p)
+{
+    dpi_session_t *s = p->session;
+
+    if (s == NULL || s->verdict_cached || s->mesh_leg ||
+        !FLAGS_TEST(s->flags, DPI_SESS_FLAG_SKIP_PARSER) ||
+        FLAGS_TEST(s->flags, (DPI_SESS_FLAG_XFF | DPI_SESS_FLAG_PROXYMESH | DPI_SESS_FLAG_MESH_TO_SVR))) {
+        return;
+    }
+    if (p->action > DPI_ACTION_ALLOW ||
+        (s->action != DPI_ACTION_NONE && s->action != DPI_ACTION_ALLOW && s->action != DPI_ACTION_BYPASS) ||
+        s->policy_desc.action > DP_POLICY_ACTION_ALLOW ||
+        FLAGS_TEST(p->flags, (DPI_PKT_FLAG_DETECT_DLP | DPI_PKT_FLAG_DETECT_WAF))) {
+        return;
+    }
+    if (th_disable_net_policy && p->ep->dlp_detector != NULL) {
+        return;
+    }
+
+    s->verdict_cached = true;
+    s->verdict_policy_ver = p->ep->policy_ver;
+    s->verdict_inspect_ver = p->ep->inspect_ver;
+}
+
+// DLP/WAF eligibility is evaluated once for a session and kept in its detect flags while the
+// endpoint's policy and DLP/WAF setup, the session's app, the network policy switch and the
+// proxymesh leg stay the same. XFF sessions take the policy of each request, they are checked
+// on every packet. DLP stops once a session has matched g_dlp_scan_budget KB of payload.
+static void dpi_pkt_detect_check(dpi_packet_t *p, bool *dlp, bool *waf)
+{
+    dpi_session_t *s = p->session;
+    uint32_t budget;
+    uint16_t app;
+    uint8_t key;
+
+    if (s == NULL || FLAGS_TEST(s->flags, DPI_SESS_FLAG_XFF)) {
+        *dlp = dpi_dlp_ep_policy_check(p);
+        *waf = dpi_waf_ep_policy_check(p);
+        return;
+    }
+
+    app = s->app ? s->app : s->base_app;
+    key = (th_disable_net_policy ? DPI_SESS_DETECT_NO_NET_POLICY : 0) |
+          (FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) ? DPI_SESS_DETECT_MESH : 0);
+    if (unlikely(!(s->detect_flags & DPI_SESS_DETECT_VALID) ||
+                 (s->detect_flags & (DPI_SESS_DETECT_NO_NET_POLICY | DPI_SESS_DETECT_MESH)) != key ||
+                 s->detect_policy_ver != p->ep->policy_ver ||
+                 s->detect_inspect_ver != p->ep->inspect_ver || s->detect_app != app)) {
+        s->detect_flags = DPI_SESS_DETECT_VALID | key | (s->detect_flags & DPI_SESS_DETECT_DLP_DONE) |
+                          (dpi_dlp_ep_policy_check(p) ? DPI_SESS_DETECT_DLP : 0) |
+                          (dpi_waf_ep_policy_check(p) ? DPI_SESS_DETECT_WAF : 0);
+        s->detect_policy_ver = p->ep->policy_ver;
+        s->detect_inspect_ver = p->ep->inspect_ver;
+        s->detect_app = app;
+    }
+
+    *dlp = (s->detect_flags & (DPI_SESS_DETECT_DLP | DPI_SESS_DETECT_DLP_DONE)) == DPI_SESS_DETECT_DLP;
+    *waf = (s->detect_flags & DPI_SESS_DETECT_WAF) != 0;
+
+    budget = CMM_LOAD_SHARED(g_dlp_scan_budget);
+    if (*dlp && budget != 0) {
+        s->dlp_scanned += dpi_pkt_len(p);
+        if ((s->dlp_scanned >> 10) >= budget) {
+            DEBUG_LOG(DBG_SESSION, p, "DLP scan budget of %uKB used\n", budget);
+            s->detect_flags |= DPI_SESS_DETECT_DLP_DONE;
+        }
+    }
+}
+
+// A packet without a session under overload, dropped if over the new session budget. Taps
+// are not blocked, the packet is just not tracked.
+static bool dpi_overload_admit(dpi_packet_t *p)
+{
+    if (th_overload_sessions > 0) {
+        th_overload_sessions --;
+        return true;
+    }
+
+    th_counter.shed_sessions ++;
+    if (!p->ep->tap) {
+        dpi_set_action(p, DPI_ACTION_DROP);
+    }
+    return false;
+}
+
+// Under overload, an established session that the policy allows is no longer parsed nor
+// scanned for DLP/WAF, as for a tap past its sample, so its verdict is cached and it takes
+// the fast path. Sessions whose policy waits for the parsers to find the app keep them.
+static void dpi_overload_shed_inspect(dpi_packet_t *p)
+{
+    dpi_session_t *s = p->session;
+
+    if ((s->flags & (DPI_SESS_FLAG_SKIP_PARSER | DPI_SESS_FLAG_IGNOR_PATTERN)) ==
+        (DPI_SESS_FLAG_SKIP_PARSER | DPI_SESS_FLAG_IGNOR_PATTERN)) {
+        return;
+    }
+    if (p->action > DPI_ACTION_ALLOW || s->action > DPI_ACTION_ALLOW ||
+        s->policy_desc.action > DP_POLICY_ACTION_ALLOW) {
+        return;
+    }
+    if (s->ip_proto == IPPROTO_TCP &&
+        (s->client.tcp_state != TCP_ESTABLISHED || s->server.tcp_state != TCP_ESTABLISHED)) {
+        return;
+    }
+
+    DEBUG_LOG(DBG_SESSION, p, "Overload, inspection shed\n");
+    FLAGS_SET(s->flags, DPI_SESS_FLAG_SKIP_PARSER | DPI_SESS_FLAG_IGNOR_PATTERN);
+    asm_destroy(&s->client.asm_cache, dpi_asm_remove);
+    asm_destroy(&s->server.asm_cache, dpi_asm_remove);
+    dpi_session_asm_account(s);
+    th_counter.shed_inspects ++;
+}
+
 int dpi_inspect_ethernet(dpi_packet_t *p)
 {
+    bool verdict = false;
+    uint64_t lat;
+
     p->pkt_buffer = &p->raw;
 
     // Session lookup
+    lat = dpi_lat_start();
     p->session = dpi_session_lookup(&th_packet);
+    dpi_lat_stop(DP_LAT_SESSION, lat);
 
     if (p->session != NULL) {
         dpi_session_t *sess = p->session;
 
+        if (sess->verdict_cached) {
+            if (likely(dpi_session_verdict_valid(sess, p->ep))) {
+                verdict = true;
+                th_counter.verdict_pkts ++;
+            } else {
+                sess->verdict_cached = false;
+                th_counter.verdict_revokes ++;
+            }
+        }
+        if (unlikely(sess->nfq_marked)) {
+            if (!verdict) {
+                sess->nfq_marked = false;
+                th_counter.nfq_unmarks ++;
+            } else if (p->ip_proto == IPPROTO_TCP) {
+                // Packets between the samples were not seen, see tcp_resync_offloaded()
+                sess->client.flags |= DPI_WING_FLAG_RESYNC;
+                sess->server.flags |= DPI_WING_FLAG_RESYNC;
+            }
+        }
+        // The classifier leaves TCP SYN, FIN and RST to the dp, the flow comes back with them
+        if (unlikely(sess->offload != NULL)) {
+            struct tcphdr *tcph = (struct tcphdr *)(p->pkt + p->l4);
+
+            if (!verdict || (p->ip_proto == IPPROTO_TCP && (tcph->syn || tcph->fin || tcph->rst))) {
+                dpi_session_offload_resume(sess);
+            }
+        }
+
         p->this_wing->pkts ++;
         p->this_wing->bytes += p->cap_len;
 
         if (p->ep->tap) {
            FLAGS_SET(sess->flags, DPI_SESS_FLAG_TAP);
+
+           // Past the sampled bytes, the session is only tracked and counted for the report
+           if (p->ep->tap_sample != 0 &&
+               (sess->flags & (DPI_SESS_FLAG_SKIP_PARSER | DPI_SESS_FLAG_IGNOR_PATTERN)) !=
+               (DPI_SESS_FLAG_SKIP_PARSER | DPI_SESS_FLAG_IGNOR_PATTERN) &&
+               (((uint64_t)sess->client.bytes + sess->server.bytes) >> 10) >= p->ep->tap_sample) {
+               DEBUG_LOG(DBG_SESSION, p, "Tap sample of %uKB inspected\n", p->ep->tap_sample);
+               FLAGS_SET(sess->flags, DPI_SESS_FLAG_SKIP_PARSER | DPI_SESS_FLAG_IGNOR_PATTERN);
+               asm_destroy(&sess->client.asm_cache, dpi_asm_remove);
+               asm_destroy(&sess->server.asm_cache, dpi_asm_remove);
+               dpi_session_asm_account(sess);
+           }
         } else {
            FLAGS_UNSET(sess->flags, DPI_SESS_FLAG_TAP);
         }
-        if (cmp_mac_prefix(p->ep_mac, PROXYMESH_MAC_PREFIX)){
-           FLAGS_SET(sess->flags, DPI_SESS_FLAG_PROXYMESH);
-        } else {
-           FLAGS_UNSET(sess->flags, DPI_SESS_FLAG_PROXYMESH);
-        }
+    } else if (unlikely(th_overload) && !dpi_overload_admit(p)) {
+        return p->action;
     }
 
+    lat = dpi_lat_start();
     dpi_pkt_proto_tracker(p);
+    dpi_lat_stop(DP_LAT_TRACKER, lat);
 
     if (p->session != NULL) {
         dpi_session_t *sess = p->session;
@@ -1150,10 +1383,19 @@ int dpi_inspect_ethernet(dpi_packet_t *p)
             sess->threat_id = p->threat_id;
             FLAGS_SET(p->flags, DPI_PKT_FLAG_LOG_MID);
         }
+        if (unlikely(sess->mesh_leg) && sess->action != DPI_ACTION_BLOCK && dpi_session_mesh_blocked(p)) {
+            DEBUG_LOG(DBG_SESSION, p, "Blocked on the proxymesh leg\n");
+            dpi_set_action(p, DPI_ACTION_RESET);
+        }
         // Copy session action to the packet if packet action is allow.
         dpi_set_action(p, sess->action);
 
-        if (p->action == DPI_ACTION_BYPASS) {
+        if (unlikely(th_overload) && !verdict) {
+            dpi_overload_shed_inspect(p);
+        }
+        if (verdict) {
+            // Parsers are done and the policy can't change without a version bump
+        } else if (p->action == DPI_ACTION_BYPASS) {
             dpi_pkt_policy_reeval(p);
         } else if (p->ep->tap || p->action <= DPI_ACTION_ALLOW) {
             dpi_pkt_proto_parser(p);
@@ -1161,11 +1403,13 @@ int dpi_inspect_ethernet(dpi_packet_t *p)
         }
     }
 
-    bool dlp_detect = dpi_dlp_ep_policy_check(p);
+    bool dlp_detect = false, waf_detect = false;
+    if (!verdict && FLAGS_TEST(p->flags, DPI_PKT_FLAG_DLP_AREA)) {
+        dpi_pkt_detect_check(p, &dlp_detect, &waf_detect);
+    }
     if (dlp_detect) {
         p->flags |= DPI_PKT_FLAG_DETECT_DLP;
     }
-    bool waf_detect = dpi_waf_ep_policy_check(p);
     if (waf_detect) {
         p->flags |= DPI_PKT_FLAG_DETECT_WAF;
     }
@@ -1177,6 +1421,9 @@ int dpi_inspect_ethernet(dpi_packet_t *p)
 
         bool continue_detect = true;
 
+        lat = dpi_lat_start();
+        dpi_stage_packet(DP_STAGE_DETECT, p);
+
         // match reassmebled packet first
         if (continue_detect && FLAGS_TEST(p->flags, DPI_PKT_FLAG_ASSEMBLED)) {
             p->pkt_buffer = &p->asm_pkt;
@@ -1192,7 +1439,18 @@ int dpi_inspect_ethernet(dpi_packet_t *p)
         if (continue_detect && p->decoded_pkt.len > 0) {
             p->pkt_buffer = &p->decoded_pkt;
 
-            if (p->pkt_buffer->len > 0) {
+            if (FLAGS_TEST(p->flags, DPI_PKT_FLAG_INFLATED)) {
+                // the body of an inflated buffer is all of it, the raw body is arranged later
+                dpi_dlp_area_t *body = &p->dlp_area[DPI_SIG_CONTEXT_TYPE_BODY], raw_body = *body;
+
+                body->dlp_ptr = dpi_pkt_ptr(p);
+                body->dlp_len = dpi_pkt_len(p);
+                body->dlp_start = dpi_pkt_seq(p);
+                body->dlp_end = dpi_pkt_end_seq(p);
+                body->dlp_offset = 0;
+                continue_detect = dpi_process_detector(p);
+                *body = raw_body;
+            } else if (p->pkt_buffer->len > 0) {
                 continue_detect = dpi_process_detector(p);
             }
             p->pkt_buffer = &p->raw;
@@ -1207,6 +1465,8 @@ int dpi_inspect_ethernet(dpi_packet_t *p)
         if (p->session != NULL && !continue_detect) {
             FLAGS_SET(p->session->flags, DPI_SESS_FLAG_IGNOR_PATTERN);
         }
+        dpi_stage_set(DP_STAGE_PACKET);
+        dpi_lat_stop(DP_LAT_DETECTOR, lat);
     }
 
     dpi_pkt_log(p);
@@ -1255,9 +1515,51 @@ int dpi_inspect_ethernet(dpi_packet_t *p)
         }
     }
 
+    if (unlikely(p->session != NULL && p->session->action == DPI_ACTION_BLOCK &&
+                 FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH))) {
+        dpi_session_mesh_share(p);
+    }
+    if (!verdict) {
+        dpi_session_cache_verdict(p);
+    }
+    if (p->session != NULL && p->session->verdict_cached) {
+        if (p->ctx->nfq) {
+            dpi_session_nfq_mark(p);
+        } else if (p->session->offload == NULL) {
+            dpi_session_offload(p);
+        }
+    }
+
     return p->action;
 }
 
+static inline void window_add(io_window_t *w, const io_metry_t *a, uint32_t s)
+{
+    w->sess += a->sess_ring[s];
+    w->pkt += a->pkt_ring[s];
+    w->byte += a->byte_ring[s];
+}
+
+static inline void window_sub(io_window_t *w, const io_metry_t *a, uint32_t s)
+{
+    w->sess -= a->sess_ring[s];
+    w->pkt -= a->pkt_ring[s];
+    w->byte -= a->byte_ring[s];
+}
+
+// The slot completes, the one leaving each window is still in the ring
+static void metry_roll_slot(io_metry_t *a, uint32_t cur)
+{
+    window_add(&a->win_short, a, cur % STATS_SLOTS);
+    window_add(&a->win_long, a, cur % STATS_SLOTS);
+    if (cur >= STATS_WIN_SHORT) {
+        window_sub(&a->win_short, a, (cur - STATS_WIN_SHORT) % STATS_SLOTS);
+    }
+    if (cur >= STATS_WIN_LONG) {
+        window_sub(&a->win_long, a, (cur - STATS_WIN_LONG) % STATS_SLOTS);
+    }
+}
+
 void dpi_catch_stats_slot(io_stats_t *stats, uint32_t slot)
 {
     if (slot - stats->cur_slot >= STATS_SLOTS) {
@@ -1267,10 +1569,16 @@ void dpi_catch_stats_slot(io_stats_t *stats, uint32_t slot)
         memset(&stats->out.pkt_ring, 0, sizeof(stats->out.pkt_ring));
         memset(&stats->in.byte_ring, 0, sizeof(stats->in.byte_ring));
         memset(&stats->out.byte_ring, 0, sizeof(stats->out.byte_ring));
+        memset(&stats->in.win_short, 0, sizeof(stats->in.win_short));
+        memset(&stats->out.win_short, 0, sizeof(stats->out.win_short));
+        memset(&stats->in.win_long, 0, sizeof(stats->in.win_long));
+        memset(&stats->out.win_long, 0, sizeof(stats->out.win_long));
         stats->cur_slot = slot;
     } else {
         uint32_t s;
         for (; stats->cur_slot < slot; stats->cur_slot ++) {
+            metry_roll_slot(&stats->in, stats->cur_slot);
+            metry_roll_slot(&stats->out, stats->cur_slot);
             s = (stats->cur_slot + 1) % STATS_SLOTS;
             stats->in.sess_ring[s] = 0;
             stats->out.sess_ring[s] = 0;
@@ -1282,6 +1590,33 @@ void dpi_catch_stats_slot(io_stats_t *stats, uint32_t slot)
     }
 }
 
+// Sums of the complete slots from cur - len, of stats last moved to slot last. Only the slots
+// that have left the window since last are read, none if the stats are current.
+void dpi_stats_window(const io_metry_t *a, uint32_t last, uint32_t cur, uint32_t len, io_window_t *w)
+{
+    uint32_t n, from, to;
+
+    *w = len == STATS_WIN_SHORT ? a->win_short : a->win_long;
+    if (last >= cur) {
+        return;
+    }
+
+    from = (last >= len) ? last - len : 0;
+    to = (cur >= len) ? cur - len : 0;
+    for (n = from; n < to; n ++) {
+        window_sub(w, a, n % STATS_SLOTS);
+    }
+}
+
+// Ring slot of the current slot, the stats of an endpoint other than the packet's can be behind
+static inline uint32_t dpi_stats_cur_slot(io_stats_t *stats, uint32_t slot)
+{
+    if (unlikely(stats->cur_slot < slot)) {
+        dpi_catch_stats_slot(stats, slot);
+    }
+    return stats->cur_slot % STATS_SLOTS;
+}
+
 void dpi_inc_stats_packet(dpi_packet_t *p)
 {
     uint32_t s = p->ep_stats->cur_slot % STATS_SLOTS;
@@ -1296,54 +1631,114 @@ void dpi_inc_stats_packet(dpi_packet_t *p)
     p->all_metry->byte_ring[s] += p->cap_len;
 }
 
+// The endpoint of the packet is taken when the rx context found it in this generation of
+// g_ep_map, which is the case of most sessions, so only the others are looked up.
+static io_ep_t *dpi_stats_ep_lookup(dpi_packet_t *p, uint8_t *mac, uint32_t *gen)
+{
+    io_ep_cache_t *cache = p->ctx != NULL ? p->ctx->ep_cache : NULL;
+    io_mac_t *entry;
+
+    *gen = CMM_LOAD_SHARED(g_ep_map_gen);
+    if (likely(cache != NULL && cache->gen == *gen && cache->entry->ep == p->ep &&
+               mac_cmp(mac, p->ep_mac))) {
+        return p->ep;
+    }
+
+    cmm_smp_rmb();
+    entry = rcu_map_lookup(&g_ep_map, mac);
+    return entry != NULL ? entry->ep : NULL;
+}
+
 void dpi_inc_stats_session(dpi_packet_t *p, dpi_session_t *s)
 {
-    uint32_t slot = p->ep_stats->cur_slot % STATS_SLOTS;
+    // A slot is only counted while it is current, it is in the window sums once complete
+    uint32_t cur = p->ctx->stats_slot;
+    uint32_t slot = dpi_stats_cur_slot(&th_stats, cur);
+    io_ep_t *ep;
 
     if (FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS)) {
         th_stats.in.session ++;
         th_stats.in.cur_session ++;
         th_stats.in.sess_ring[slot] ++;
 
-        io_mac_t *mac = rcu_map_lookup(&g_ep_map, s->server.mac);
-        if (mac != NULL) {
-            mac->ep->stats.in.session ++;
-            mac->ep->stats.in.cur_session ++;
-            mac->ep->stats.in.sess_ring[slot] ++;
+        ep = dpi_stats_ep_lookup(p, s->server.mac, &s->stats_ep_gen);
+        if (ep != NULL) {
+            io_stats_t *stats = th_ep_stats(ep);
+            stats->in.session ++;
+            stats->in.cur_session ++;
+            stats->in.sess_ring[dpi_stats_cur_slot(stats, cur)] ++;
         }
     } else {
         th_stats.out.session ++;
         th_stats.out.cur_session ++;
         th_stats.out.sess_ring[slot] ++;
 
-        io_mac_t *mac = rcu_map_lookup(&g_ep_map, s->client.mac);
-        if (mac != NULL) {
-            mac->ep->stats.out.session ++;
-            mac->ep->stats.out.cur_session ++;
-            mac->ep->stats.out.sess_ring[slot] ++;
+        ep = dpi_stats_ep_lookup(p, s->client.mac, &s->stats_ep_gen);
+        if (ep != NULL) {
+            io_stats_t *stats = th_ep_stats(ep);
+            stats->out.session ++;
+            stats->out.cur_session ++;
+            stats->out.sess_ring[dpi_stats_cur_slot(stats, cur)] ++;
         }
     }
+    s->stats_ep = ep;
+}
+
+// A flowlet counts as a new session of the workload, it's never a current one
+void dpi_inc_stats_flowlet(dpi_packet_t *p)
+{
+    uint32_t cur = p->ctx->stats_slot, gen;
+    io_ep_t *ep;
+
+    th_stats.out.session ++;
+    th_stats.out.sess_ring[dpi_stats_cur_slot(&th_stats, cur)] ++;
+
+    ep = dpi_stats_ep_lookup(p, p->ep_mac, &gen);
+    if (ep != NULL) {
+        io_stats_t *stats = th_ep_stats(ep);
+        stats->out.session ++;
+        stats->out.sess_ring[dpi_stats_cur_slot(stats, cur)] ++;
+    }
 }
 
 void dpi_dec_stats_session(dpi_session_t *s)
 {
-    if (FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS)) {
-        th_stats.in.cur_session --;
+    bool ingress = FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS);
+    io_ep_t *ep = s->stats_ep;
 
-        io_mac_t *mac = rcu_map_lookup(&g_ep_map, s->server.mac);
-        if (mac != NULL) {
-            mac->ep->stats.in.cur_session --;
+    if (unlikely(s->stats_ep_gen != CMM_LOAD_SHARED(g_ep_map_gen))) {
+        // The endpoint can be removed or replaced
+        io_mac_t *mac;
+        cmm_smp_rmb();
+        mac = rcu_map_lookup(&g_ep_map, ingress ? s->server.mac : s->client.mac);
+        ep = mac != NULL ? mac->ep : NULL;
+    }
+
+    if (ingress) {
+        th_stats.in.cur_session --;
+        if (ep != NULL) {
+            th_ep_stats(ep)->in.cur_session --;
         }
     } else {
         th_stats.out.cur_session --;
-
-        io_mac_t *mac = rcu_map_lookup(&g_ep_map, s->client.mac);
-        if (mac != NULL) {
-            mac->ep->stats.out.cur_session --;
+        if (ep != NULL) {
+            th_ep_stats(ep)->out.cur_session --;
         }
     }
 }
 
+// Sessions of the endpoint on all threads, a session is counted and released on its thread
+uint32_t dpi_ep_cur_session(io_ep_t *ep)
+{
+    uint32_t cnt = 0;
+    int i;
+
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        cnt += ep->stats[i].in.cur_session + ep->stats[i].out.cur_session;
+    }
+    return cnt;
+}
+
 void dpi_packet_setup(void)
 {
     int i;
@@ -59,6 +59,13 @@ typedef enum dpi_tcp_options_ {
 #define DPI_PKT_FLAG_LOG_XFF_VIO   0x00004000
 #define DPI_PKT_FLAG_DETECT_DLP    0x00008000
 #define DPI_PKT_FLAG_DETECT_WAF    0x00010000
+#define DPI_PKT_FLAG_DLP_AREA      0x00020000   // dlp areas were reset for the packet
+#define DPI_PKT_FLAG_SYN_PROXY     0x00040000   // handled by the syn proxy, not forwarded
+#define DPI_PKT_FLAG_EP_CPU        0x00080000   // 'ep' is the workload the packet's cycles go to
+#define DPI_PKT_FLAG_PROXYMESH     0x00100000   // on "lo" of a proxymesh pod, see io_ctx_t
+#define DPI_PKT_FLAG_NFQ_MARK      0x00200000   // the session's connection is marked by this packet
+#define DPI_PKT_FLAG_NFQ_MARKED    0x00400000   // the session's connection skips the queue
+#define DPI_PKT_FLAG_INFLATED      0x00800000   // decoded_pkt is inflated body, seq as the wing's inflate output
 
 #define DPI_MAX_MATCH_RESULT     16
 #define DPI_MAX_MATCH_CANDIDATE  256
@@ -120,8 +127,10 @@ typedef struct dpi_packet_ {
 
     void *frag_trac;
     void *cached_clip;
+    // Decision of a session resumed from the previous run
+    const struct dpi_policy_desc_ *resume_desc;
 
-    uint32_t EOZ;
+    uint32_t EOZ;               // fields above are reset for every packet
 
     uint64_t id;
     struct dpi_parser_ *cur_parser;
@@ -142,7 +151,7 @@ typedef struct dpi_packet_ {
     io_metry_t *app_metry;
 
     uint8_t parser_left;
-    /*dlp related*/
+    /*dlp related, dlp_area and decoded_pkt.len are only reset with DPI_PKT_FLAG_DLP_AREA*/
     uint32_t dlp_match_seq;
     dpi_sig_context_type_t dlp_match_type;
     dpi_sig_context_type_t dlp_pat_context;
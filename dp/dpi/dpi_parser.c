@@ -1,4 +1,5 @@
 #include <string.h>
+#include <ctype.h>
 
 #include "dpi/dpi_module.h"
 
@@ -46,23 +47,83 @@ static dpi_parser_t **get_parser_list(int ip_proto)
     }
 }
 
+const char *dpi_parser_name(int type)
+{
+    if (g_tcp_parser[type] != NULL) {
+        return g_tcp_parser[type]->name;
+    } else if (g_udp_parser[type] != NULL) {
+        return g_udp_parser[type]->name;
+    } else if (g_any_parser[type] != NULL) {
+        return g_any_parser[type]->name;
+    }
+    return "unknown";
+}
+
 // Called by protocol parser
 inline void *dpi_get_parser_data(dpi_packet_t *p)
 {
     dpi_session_t *s = p->session;
+    if (s->parser_data == NULL) {
+        return NULL;
+    }
     return s->parser_data[p->cur_parser->type];
 }
 
+// Data that could not be kept in the session. The parser still works on it for the
+// current packet, so it is freed at the next put.
+static __thread void *t_orphan_data;
+static __thread dpi_parser_t *t_orphan_parser;
+
+// Parsers allocate their data themselves, it is accounted while the session holds it
+static inline void dpi_parser_data_acct(void *old, void *data)
+{
+    if (old != data) {
+        if (old != NULL) {
+            mem_acct_add(DP_MEM_PARSER, -(int64_t)malloc_usable_size(old));
+        }
+        if (data != NULL) {
+            mem_acct_add(DP_MEM_PARSER, malloc_usable_size(data));
+        }
+    }
+}
+
+// The table is allocated by the first parser that keeps data in the session. If that fails,
+// the parser is fired.
 inline void dpi_put_parser_data(dpi_packet_t *p, void *data)
 {
     dpi_session_t *s = p->session;
+
+    if (unlikely(t_orphan_data != NULL)) {
+        if (t_orphan_parser->delete_data != NULL) {
+            t_orphan_parser->delete_data(t_orphan_data);
+        }
+        t_orphan_data = NULL;
+    }
+
+    if (unlikely(s->parser_data == NULL)) {
+        if (data == NULL) {
+            return;
+        }
+        s->parser_data = mem_calloc(DP_MEM_PARSER, DPI_PARSER_MAX, sizeof(void *));
+        if (s->parser_data == NULL) {
+            t_orphan_data = data;
+            t_orphan_parser = p->cur_parser;
+            BITMASK_UNSET(s->parser_bits, p->cur_parser->type);
+            return;
+        }
+    }
+    dpi_parser_data_acct(s->parser_data[p->cur_parser->type], data);
     s->parser_data[p->cur_parser->type] = data;
 }
 
 // Called when parser loses interest of the session
 static void dpi_delete_parser_data(dpi_session_t *s, dpi_parser_t *cp)
 {
+    if (s->parser_data == NULL) {
+        return;
+    }
     if (cp->delete_data != NULL && s->parser_data[cp->type] != NULL) {
+        dpi_parser_data_acct(s->parser_data[cp->type], NULL);
         cp->delete_data(s->parser_data[cp->type]);
     }
     s->parser_data[cp->type] = NULL;
@@ -74,11 +135,17 @@ void dpi_purge_parser_data(dpi_session_t *s)
     dpi_parser_t **list = get_parser_list(s->ip_proto);
     int t;
 
+    if (s->parser_data == NULL) {
+        return;
+    }
+
     for (t = 0; t < DPI_PARSER_MAX; t ++) {
         if (list[t] != NULL) {
             dpi_delete_parser_data(s, list[t]);
         }
     }
+    mem_free(DP_MEM_PARSER, s->parser_data);
+    s->parser_data = NULL;
 }
 
 // Called by protocol parser
@@ -120,6 +187,20 @@ inline bool dpi_is_parser_final(dpi_packet_t *p)
     return !!(s->flags & DPI_SESS_FLAG_FINAL_PARSER);
 }
 
+// Database parsers finalize with this one. At the identify level of the endpoint, the parser
+// stops once the protocol is known and the session takes the parser-free path; return true
+// if so.
+bool dpi_finalize_inspect_parser(dpi_packet_t *p)
+{
+    dpi_finalize_parser(p);
+
+    if (p->ep != NULL && p->ep->inspect_level == DP_INSPECT_IDENTIFY) {
+        dpi_ignore_parser(p);
+        return true;
+    }
+    return false;
+}
+
 void dpi_finalize_parser(dpi_packet_t *p)
 {
     dpi_session_t *s = p->session;
@@ -194,6 +275,168 @@ void dpi_midstream_recruit_parser(dpi_packet_t *p)
     }
 }
 
+// ---- first payload screening ----
+
+#define SIG_CLIENT 0
+#define SIG_SERVER 1
+#define SIG_BIT(t) (1u << (t))
+
+// Tcp parsers that can take the first payload of a session, by the side it comes from and its
+// first byte, and by side alone when the payload doesn't start the stream
+static uint32_t g_sig_first[2][256];
+static uint32_t g_sig_side[2];
+// Parsers to check the whole magic of, by side
+static uint32_t g_sig_magic[2];
+
+static void dpi_parser_sig_setup(void)
+{
+    int side, t, b, i;
+
+    for (side = SIG_CLIENT; side <= SIG_SERVER; side ++) {
+        for (t = 0; t < DPI_PARSER_MAX; t ++) {
+            const dpi_parser_sig_t *sig = g_tcp_parser[t] != NULL ? g_tcp_parser[t]->sig : NULL;
+            uint8_t magic_flag = side == SIG_CLIENT ? DPI_PARSER_SIG_CLIENT_MAGIC : DPI_PARSER_SIG_SERVER_MAGIC;
+
+            if (g_tcp_parser[t] == NULL) {
+                continue;
+            }
+            if (sig != NULL && (sig->flags & (side == SIG_CLIENT ? DPI_PARSER_SIG_SERVER_FIRST :
+                                                                   DPI_PARSER_SIG_CLIENT_FIRST))) {
+                continue;
+            }
+            g_sig_side[side] |= SIG_BIT(t);
+
+            for (b = 0; b < 256; b ++) {
+                bool ok = true;
+
+                if (sig != NULL && side == SIG_CLIENT && (sig->flags & DPI_PARSER_SIG_ALPHA)) {
+                    ok = isalpha(b) != 0;
+                }
+                if (ok && sig != NULL && (sig->flags & magic_flag)) {
+                    for (ok = false, i = 0; sig->magic[i] != NULL && !ok; i ++) {
+                        ok = (uint8_t)sig->magic[i][0] == b;
+                    }
+                }
+                if (ok) {
+                    g_sig_first[side][b] |= SIG_BIT(t);
+                }
+            }
+            if (sig != NULL && (sig->flags & magic_flag)) {
+                g_sig_magic[side] |= SIG_BIT(t);
+            }
+        }
+    }
+}
+
+// A magic matches as far as the payload goes, or fully
+static bool sig_magic_match(const dpi_parser_sig_t *sig, uint8_t *ptr, uint32_t len, bool full)
+{
+    int i;
+
+    for (i = 0; sig->magic[i] != NULL; i ++) {
+        uint32_t mlen = strlen(sig->magic[i]);
+
+        if (full && len < mlen) {
+            continue;
+        }
+        if (memcmp(ptr, sig->magic[i], min(len, mlen)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The parser the server port is known for, learned on the workload or by a well-known port
+static int dpi_parser_port_hint(dpi_packet_t *p)
+{
+    dpi_session_t *s = p->session;
+    io_app_t *app;
+    int t;
+
+    if (FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS) && p->ep != NULL &&
+        (app = dpi_ep_app_map_lookup(p->ep, s->server.port, s->ip_proto)) != NULL) {
+        for (t = 0; t < DPI_PARSER_MAX; t ++) {
+            if (dpi_parser_2_app[t] != 0 &&
+                (dpi_parser_2_app[t] == app->proto || dpi_parser_2_app[t] == app->application)) {
+                return t;
+            }
+        }
+    }
+
+    switch (s->server.port) {
+    case 80:
+    case 8080:
+        return DPI_PARSER_HTTP;
+    case 443:
+    case 8443:
+        return DPI_PARSER_SSL;
+    case 22:
+        return DPI_PARSER_SSH;
+    }
+    return -1;
+}
+
+// Fire the tcp parsers that would give up on the first payload. If the parser of the server
+// port fully matches one of its magics, it is the only one kept.
+static void dpi_screen_parser(dpi_packet_t *p)
+{
+    dpi_session_t *s = p->session;
+    dpi_parser_t *saved_parser = p->cur_parser;
+    int side = dpi_is_client_pkt(p) ? SIG_CLIENT : SIG_SERVER;
+    uint8_t *ptr = dpi_pkt_ptr(p);
+    uint32_t len = dpi_pkt_len(p), keep, magic;
+    int t, hint;
+
+    s->parser_screened = true;
+
+    if (dpi_pkt_seq(p) != p->this_wing->init_seq) {
+        keep = g_sig_side[side];
+    } else {
+        keep = g_sig_first[side][ptr[0]];
+        for (magic = keep & g_sig_magic[side]; magic != 0; magic &= magic - 1) {
+            t = __builtin_ctz(magic);
+            if (!sig_magic_match(g_tcp_parser[t]->sig, ptr, len, false)) {
+                keep &= ~SIG_BIT(t);
+            }
+        }
+
+        hint = dpi_parser_port_hint(p);
+        if (hint >= 0 && (keep & SIG_BIT(hint)) && g_tcp_parser[hint]->sig != NULL &&
+            g_tcp_parser[hint]->sig->magic != NULL &&
+            sig_magic_match(g_tcp_parser[hint]->sig, ptr, len, true)) {
+            keep = SIG_BIT(hint);
+        }
+    }
+
+    for (t = 0; t < DPI_PARSER_MAX; t ++) {
+        if (BITMASK_TEST(s->parser_bits, t) && !(keep & SIG_BIT(t))) {
+            p->cur_parser = g_tcp_parser[t];
+            dpi_fire_parser(p);
+            dpi_delete_parser_data(s, p->cur_parser);
+        }
+    }
+    p->cur_parser = saved_parser;
+}
+
+// Parser cycles are always counted, those of a timed packet also go to its histogram
+static inline void dpi_call_parser(void (*fct)(dpi_packet_t *), dpi_packet_t *p, int type)
+{
+    uint64_t start = tsc_read(), ticks;
+
+    th_stage->parser = type;
+    dpi_stage_packet(DP_STAGE_PARSER, p);
+    fct(p);
+    dpi_stage_set(DP_STAGE_PACKET);
+    ticks = tsc_read() - start;
+    th_counter.parser_ticks[type] += ticks;
+    if (unlikely(th_latency.timing)) {
+        lat_hist_add(&th_latency.hists[DP_LAT_STAGE_MAX + type], ticks);
+        if (unlikely(CMM_LOAD_SHARED(g_lat_trace))) {
+            dpi_trace_add(DP_LAT_STAGE_MAX + type, start, ticks);
+        }
+    }
+}
+
 void dpi_proto_parser(dpi_packet_t *p)
 {
     dpi_session_t *s = p->session;
@@ -216,7 +459,7 @@ void dpi_proto_parser(dpi_packet_t *p)
 
             // Reset per-parser asm_seq to the earliest.
             p->parser_asm_seq = p->this_wing->asm_seq;
-            cp->parser(p);
+            dpi_call_parser(cp->parser, p, s->only_parser);
 
             if (!BITMASK_TEST(s->parser_bits, s->only_parser)) {
                 DEBUG_LOG(DBG_SESSION, p, "sess %u: skip parser\n", s->id);
@@ -234,6 +477,10 @@ void dpi_proto_parser(dpi_packet_t *p)
     } else {
         int t, last = 0;
 
+        if (unlikely(!s->parser_screened) && p->ip_proto == IPPROTO_TCP) {
+            dpi_screen_parser(p);
+        }
+
         // Walk through all parsers
         p->parser_left = 0;
         for (t = 0; t < DPI_PARSER_MAX; t ++) {
@@ -242,7 +489,7 @@ void dpi_proto_parser(dpi_packet_t *p)
                 DEBUG_LOG(DBG_PARSER, p, "parse: %s\n", cp->name);
 
                 p->parser_asm_seq = p->this_wing->asm_seq;
-                cp->parser(p);
+                dpi_call_parser(cp->parser, p, t);
 
                 if (BITMASK_TEST(s->parser_bits, t)) {
                     p->parser_left ++;
@@ -290,7 +537,7 @@ void dpi_midstream_proto_praser(dpi_packet_t *p) {
     if (s->flags & DPI_SESS_FLAG_ONLY_PARSER) {
         cp = p->cur_parser = list[s->only_parser];
         if (cp != NULL && cp->parser != NULL) {
-            cp->midstream(p);
+            dpi_call_parser(cp->midstream, p, s->only_parser);
         }
         if (!BITMASK_TEST(s->parser_bits, s->only_parser)) {
             DEBUG_LOG(DBG_PARSER, p, "Mid stream Skip parsers,sesssion id=%d\n", p->session->id);
@@ -305,7 +552,7 @@ void dpi_midstream_proto_praser(dpi_packet_t *p) {
             cp = p->cur_parser = list[t];
             if (cp != NULL && cp->midstream != NULL) {
                 DEBUG_LOG(DBG_PARSER, p, "Check mid stream %s\n", cp->name);
-                cp->midstream(p);
+                dpi_call_parser(cp->midstream, p, t);
                 if (BITMASK_TEST(s->parser_bits, t)) {
                     p->parser_left ++;
                     last = t;
@@ -387,4 +634,6 @@ void dpi_parser_setup(void)
     register_parser(dpi_tns_tcp_parser());
     register_parser(dpi_tds_tcp_parser());
     register_parser(dpi_grpc_tcp_parser());
+
+    dpi_parser_sig_setup();
 }
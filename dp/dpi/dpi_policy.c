@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <ctype.h>
 #include <errno.h>
 #include <unistd.h>
 #include <time.h>
@@ -10,9 +11,15 @@
 #include <netinet/ip6.h>
 #include <netinet/tcp.h>
 #include <netinet/udp.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 #include "urcu.h"
 #include "debug.h"
 #include "utils/rcu_map.h"
+#include "utils/hash.h"
 #include "dpi/dpi_module.h"
 
 dpi_fqdn_hdl_t *g_fqdn_hdl = NULL;
@@ -24,17 +31,38 @@ static bool _dpi_policy_implicit_default(dpi_policy_hdl_t *hdl, dpi_policy_desc_
 static void _dpi_policy_chk_unknown_ip(dpi_policy_hdl_t *hdl, uint32_t sip, uint32_t dip,
                                     uint8_t iptype, dpi_policy_desc_t **pol_desc);
 static void _dpi_policy_chk_nbe(dpi_packet_t *p, uint32_t sip, uint32_t dip, int is_ingress, dpi_policy_hdl_t *hdl, dpi_policy_desc_t **pol_desc);
+static void fqdn_del_batch_reap(dpi_fqdn_hdl_t *hdl);
+
+static inline void fqdn_code_set(bitmap_type *codes, uint32_t code)
+{
+    uint32_t bit = DPI_FQDN_CODE_BIT(code);
+    codes[bit / 32] |= 1u << (bit % 32);
+}
+
+static inline void fqdn_code_clear(bitmap_type *codes, uint32_t code)
+{
+    uint32_t bit = DPI_FQDN_CODE_BIT(code);
+    codes[bit / 32] &= ~(1u << (bit % 32));
+}
 
 /*
  * -----------------------------------------------------
  * --- unknown ip description cache definition ----------
  * -----------------------------------------------------
  */
+// Ips not in the policy addresses yet, a new workload's for instance, are open for a while. The
+// cache is a fixed table per dp thread of 4-way sets, entries expire by their last hit and are
+// reused in place, so there are no timers or allocations. When a set is full, a CLOCK hand picks
+// the victim; entries out of tries are kept over the others, as dropping one would open the ip
+// again.
 #define UNKNOWN_IP_CACHE_TIMEOUT 600 //sec
 #define POLICY_DESC_VER_CHG_MAX 60 //sec
 #define UNKNOWN_IP_TRY_COUNT 10 //10 times
 #define HOST_IP_TRY_COUNT 3 //3 times
 #define EXT_IP_TRY_COUNT 2 //2 times
+#define UNKNOWN_IP_CACHE_BITS 12
+#define UNKNOWN_IP_CACHE_SETS (1 << UNKNOWN_IP_CACHE_BITS)
+#define UNKNOWN_IP_CACHE_WAYS 4
 typedef struct dpi_unknown_ip_desc_ {
     uint32_t sip;
     uint32_t dip;
@@ -42,185 +70,1476 @@ typedef struct dpi_unknown_ip_desc_ {
 } dpi_unknown_ip_desc_t;
 
 typedef struct dpi_unknown_ip_cache_ {
-    struct cds_lfht_node node;
-    timer_entry_t ts_entry;
-
     dpi_unknown_ip_desc_t desc;
+    uint8_t try_cnt;
+    uint8_t flags;
+#define UNKNOWN_IP_USED 0x01
+#define UNKNOWN_IP_REF  0x02
     uint32_t start_hit;
     uint32_t last_hit;
-    uint8_t try_cnt;
 } dpi_unknown_ip_cache_t;
 
-static int unknown_ip_match(struct cds_lfht_node *ht_node, const void *key)
+typedef struct dpi_unknown_ip_set_ {
+    dpi_unknown_ip_cache_t way[UNKNOWN_IP_CACHE_WAYS];
+    uint8_t hand;
+} dpi_unknown_ip_set_t;
+
+static inline uint32_t unknown_ip_hash(const dpi_unknown_ip_desc_t *k)
+{
+    uint32_t h = k->sip * 0x9e3779b1u;
+
+    h ^= k->dip + 0x7f4a7c15u + (h << 6) + (h >> 2);
+    return h ^ (h >> 16);
+}
+
+static inline bool unknown_ip_live(const dpi_unknown_ip_cache_t *c)
+{
+    return (c->flags & UNKNOWN_IP_USED) && th_snap.tick - c->last_hit < UNKNOWN_IP_CACHE_TIMEOUT;
+}
+
+void dpi_unknown_ip_init(void)
+{
+    th_unknown_ip_cache = mem_calloc(DP_MEM_POLICY, UNKNOWN_IP_CACHE_SETS, sizeof(dpi_unknown_ip_set_t));
+}
+
+static dpi_unknown_ip_cache_t *lookup_unknown_ip_cache(dpi_unknown_ip_desc_t *key)
+{
+    dpi_unknown_ip_set_t *set;
+    int i;
+
+    if (unlikely(th_unknown_ip_cache == NULL)) {
+        return NULL;
+    }
+    set = &th_unknown_ip_cache[unknown_ip_hash(key) & (UNKNOWN_IP_CACHE_SETS - 1)];
+    for (i = 0; i < UNKNOWN_IP_CACHE_WAYS; i ++) {
+        dpi_unknown_ip_cache_t *c = &set->way[i];
+
+        if (c->desc.sip == key->sip && c->desc.dip == key->dip && unknown_ip_live(c)) {
+            c->flags |= UNKNOWN_IP_REF;
+            return c;
+        }
+    }
+    return NULL;
+}
+
+// A free or expired way, else the first way the hand finds unreferenced, passing over the ones
+// out of tries on the first turn
+static dpi_unknown_ip_cache_t *unknown_ip_victim(dpi_unknown_ip_set_t *set)
+{
+    dpi_unknown_ip_cache_t *c;
+    int i;
+
+    for (i = 0; i < UNKNOWN_IP_CACHE_WAYS; i ++) {
+        if (!unknown_ip_live(&set->way[i])) {
+            return &set->way[i];
+        }
+    }
+    for (i = 0; i < UNKNOWN_IP_CACHE_WAYS * 2; i ++) {
+        c = &set->way[set->hand];
+        set->hand = (set->hand + 1) % UNKNOWN_IP_CACHE_WAYS;
+        if (c->flags & UNKNOWN_IP_REF) {
+            c->flags &= ~UNKNOWN_IP_REF;
+        } else if (c->try_cnt > 0 || i >= UNKNOWN_IP_CACHE_WAYS) {
+            break;
+        }
+    }
+    th_counter.unknown_ip_evicts ++;
+    return c;
+}
+
+static void add_unknown_ip_cache(dpi_unknown_ip_desc_t *desc, dpi_unknown_ip_desc_t *key, uint8_t iptype, bool ext)
+{
+    dpi_unknown_ip_cache_t *cache;
+
+    if (unlikely(th_unknown_ip_cache == NULL)) {
+        return;
+    }
+    cache = unknown_ip_victim(&th_unknown_ip_cache[unknown_ip_hash(key) & (UNKNOWN_IP_CACHE_SETS - 1)]);
+    memcpy(&cache->desc, desc, sizeof(*desc));
+    cache->flags = UNKNOWN_IP_USED;
+    cache->start_hit = th_snap.tick;
+    cache->last_hit = th_snap.tick;
+    if (iptype == DP_IPTYPE_HOSTIP || iptype == DP_IPTYPE_TUNNELIP) {
+        cache->try_cnt = HOST_IP_TRY_COUNT;
+    } else {
+        cache->try_cnt = UNKNOWN_IP_TRY_COUNT;
+        if (ext) {
+            cache->try_cnt = EXT_IP_TRY_COUNT;
+        }
+    }
+    th_counter.unknown_ip_inserts ++;
+}
+
+static void refresh_unknown_ip_cache(dpi_unknown_ip_cache_t *cache, uint16_t thdl_ver, uint8_t try_cnt)
+{
+    cache->try_cnt = try_cnt;
+    cache->desc.hdl_ver = thdl_ver;
+    //restart timestamp
+    cache->start_hit = th_snap.tick;
+    cache->last_hit = th_snap.tick;
+}
+
+static void update_unknown_ip_cache(dpi_unknown_ip_cache_t *cache)
+{
+    //update timestamp
+    cache->last_hit = th_snap.tick;
+}
+
+/*
+ * -----------------------------------------------------
+ * --- Policy rule definition --------------------------
+ * -----------------------------------------------------
+ */
+static int dpi_policy_lookup_by_key(dpi_policy_hdl_t *hdl, uint32_t sip, uint32_t dip,
+                             uint16_t dport, uint16_t proto, uint32_t app,
+                             int is_ingress, dpi_policy_desc_t *desc, dpi_packet_t *p);
+static int dpi_rule_add(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l, dpi_rule_key_t *key_h,
+                 int app_num, dpi_policy_app_rule_t *app_rules,
+                 int dir, dpi_policy_desc_t *desc);
+
+/*----------------------------------------------------*/
+
+static int rule_match(struct cds_lfht_node *ht_node, const void *key)
+{
+    dpi_rule_t *s = STRUCT_OF(ht_node, dpi_rule_t, node);
+    const dpi_rule_key_t *k = key;
+    return memcmp(&s->key, k, sizeof(dpi_rule_key_t))?0:1;
+}
+
+static uint32_t rule_hash(const void *key)
+{
+    const dpi_rule_key_t *k = key;
+    return hash_key(k, sizeof(dpi_rule_key_t));
+}
+
+static void rule_key_cpy(dpi_rule_key_t *k1, dpi_rule_key_t *k2)
+{
+    memcpy(k1, k2, sizeof(dpi_rule_key_t));
+}
+
+static void policy_desc_cpy(dpi_policy_desc_t *d1, dpi_policy_desc_t *d2)
+{
+    memcpy(d1, d2, sizeof(dpi_policy_desc_t));
+}
+
+static int rule_key_comp(dpi_rule_key_t *k1, dpi_rule_key_t *k2)
+{
+    return memcmp(k1, k2, sizeof(dpi_rule_key_t));
+}
+
+static int range_rule_match(struct cds_lfht_node *ht_node, const void *key)
+{
+    dpi_range_rule_t *s = STRUCT_OF(ht_node, dpi_range_rule_t, node);
+    const dpi_range_rule_key_t *k = key;
+
+    return memcmp(&s->key, k, sizeof(dpi_range_rule_key_t))?0:1;
+}
+
+static uint32_t range_rule_hash(const void *key)
+{
+    const dpi_range_rule_key_t *k = key;
+    return hash_key(k, sizeof(dpi_range_rule_key_t));
+}
+
+static void range_rule_key_cpy(dpi_range_rule_key_t *k1, dpi_range_rule_key_t *k2)
+{
+    memcpy(k1, k2, sizeof(dpi_range_rule_key_t));
+}
+
+#define IS_X_IN_RANGE(x, y, z) ((x >= y) && (x <= z))
+static int rule_key_in_range(dpi_range_rule_item_t *item, dpi_rule_key_t *k)
+{
+    if (IS_X_IN_RANGE(k->dport, item->key_l.dport, item->key_h.dport) &&
+        IS_X_IN_RANGE(ntohl(k->sip), ntohl(item->key_l.sip), ntohl(item->key_h.sip)) &&
+        IS_X_IN_RANGE(ntohl(k->dip), ntohl(item->key_l.dip), ntohl(item->key_h.dip)) &&
+        IS_X_IN_RANGE(k->app, item->key_l.app, item->key_h.app)) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
+/*
+ * -----------------------------------------------------
+ * --- range rule decision tree -------------------------
+ * -----------------------------------------------------
+ */
+// HyperSplit style: each inner node cuts the region of one field at an endpoint of the rules,
+// picking the field and the median endpoint that leave the fewest rules on the larger side.
+// Rules crossing the cut are kept on both sides. Splitting stops when a few rules are left or
+// the first rule covers the whole region, as no later rule can win there.
+#define RANGE_TREE_LEAF_RULES   8
+#define RANGE_TREE_MAX_DEPTH    32
+#define RANGE_TREE_MAX_NODES    (1 << 18)
+#define RANGE_TREE_MAX_LEAFS(rules) ((rules) * 32)
+
+typedef struct range_tree_ctx_ {
+    dpi_range_tree_t *tree;
+    uint32_t node_size;
+    uint32_t leaf_size;
+    uint32_t *points;
+} range_tree_ctx_t;
+
+static inline void range_tree_fields(dpi_rule_key_t *k, uint32_t *f)
+{
+    f[DPI_RANGE_DIM_DPORT] = k->dport;
+    f[DPI_RANGE_DIM_SIP] = ntohl(k->sip);
+    f[DPI_RANGE_DIM_DIP] = ntohl(k->dip);
+    f[DPI_RANGE_DIM_APP] = k->app;
+}
+
+// Whether l <= f <= h in all fields. The 4 fields fit in one vector; SSE2 and NEON are part
+// of the x86-64 and arm64 baselines, SSE2 has no unsigned compare so the sign bits are flipped.
+static inline bool range_box_match(const uint32_t *l, const uint32_t *h, const uint32_t *f)
+{
+#if defined(__SSE2__)
+    __m128i sign = _mm_set1_epi32(0x80000000);
+    __m128i vf = _mm_xor_si128(_mm_loadu_si128((const __m128i *)f), sign);
+    __m128i vl = _mm_xor_si128(_mm_loadu_si128((const __m128i *)l), sign);
+    __m128i vh = _mm_xor_si128(_mm_loadu_si128((const __m128i *)h), sign);
+
+    return _mm_movemask_epi8(_mm_or_si128(_mm_cmpgt_epi32(vl, vf), _mm_cmpgt_epi32(vf, vh))) == 0;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint32x4_t vf = vld1q_u32(f);
+
+    return vminvq_u32(vandq_u32(vcgeq_u32(vf, vld1q_u32(l)), vcleq_u32(vf, vld1q_u32(h)))) != 0;
+#else
+    int d;
+
+    for (d = 0; d < DPI_RANGE_DIMS; d ++) {
+        if (f[d] < l[d] || f[d] > h[d]) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+static int range_tree_point_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int range_tree_node(range_tree_ctx_t *ctx)
+{
+    dpi_range_tree_t *tree = ctx->tree;
+
+    if (tree->node_count >= ctx->node_size) {
+        dpi_range_node_t *nodes;
+
+        if (ctx->node_size >= RANGE_TREE_MAX_NODES) {
+            return -1;
+        }
+        nodes = mem_realloc(DP_MEM_POLICY, tree->nodes, sizeof(*nodes) * ctx->node_size * 2);
+        if (nodes == NULL) {
+            return -1;
+        }
+        tree->nodes = nodes;
+        ctx->node_size *= 2;
+    }
+    memset(&tree->nodes[tree->node_count], 0, sizeof(dpi_range_node_t));
+    return tree->node_count ++;
+}
+
+static int range_tree_leaf(range_tree_ctx_t *ctx, int n, uint32_t *idx, uint32_t cnt)
+{
+    dpi_range_tree_t *tree = ctx->tree;
+
+    if (tree->leaf_count + cnt > ctx->leaf_size) {
+        uint32_t size = ctx->leaf_size * 2 + cnt, *leafs;
+
+        if (size > RANGE_TREE_MAX_LEAFS(tree->rule_count)) {
+            return -1;
+        }
+        leafs = mem_realloc(DP_MEM_POLICY, tree->leaf_rules, sizeof(uint32_t) * size);
+        if (leafs == NULL) {
+            return -1;
+        }
+        tree->leaf_rules = leafs;
+        ctx->leaf_size = size;
+    }
+    memcpy(&tree->leaf_rules[tree->leaf_count], idx, sizeof(uint32_t) * cnt);
+    tree->nodes[n].dim = DPI_RANGE_DIM_LEAF;
+    tree->nodes[n].count = cnt;
+    tree->nodes[n].left = tree->leaf_count;
+    tree->leaf_count += cnt;
+    return n;
+}
+
+// Pick the cut with the smallest larger side, return the field or -1 if no cut helps
+static int range_tree_split(range_tree_ctx_t *ctx, uint32_t *idx, uint32_t cnt,
+                            uint32_t *lo, uint32_t *hi, uint32_t *thr)
+{
+    dpi_range_bound_t *rules = ctx->tree->rules;
+    uint32_t best_max = cnt, best_sum = cnt * 2, i, np, t, left, right;
+    int d, best = -1;
+
+    for (d = 0; d < DPI_RANGE_DIMS; d ++) {
+        for (i = 0, np = 0; i < cnt; i ++) {
+            dpi_range_bound_t *b = &rules[idx[i]];
+
+            if (b->l[d] > lo[d]) {
+                ctx->points[np ++] = b->l[d] - 1;
+            }
+            if (b->h[d] < hi[d]) {
+                ctx->points[np ++] = b->h[d];
+            }
+        }
+        if (np == 0) {
+            continue;
+        }
+        qsort(ctx->points, np, sizeof(uint32_t), range_tree_point_cmp);
+        t = ctx->points[np / 2];
+
+        for (i = 0, left = 0, right = 0; i < cnt; i ++) {
+            dpi_range_bound_t *b = &rules[idx[i]];
+
+            left += b->l[d] <= t;
+            right += b->h[d] > t;
+        }
+        if (left + right >= cnt * 2) {
+            continue;
+        }
+        if (max(left, right) < best_max ||
+            (max(left, right) == best_max && left + right < best_sum)) {
+            best_max = max(left, right);
+            best_sum = left + right;
+            best = d;
+            *thr = t;
+        }
+    }
+    return best;
+}
+
+static int range_tree_build(range_tree_ctx_t *ctx, uint32_t *idx, uint32_t cnt,
+                            uint32_t *lo, uint32_t *hi, int depth)
+{
+    dpi_range_bound_t *rules = ctx->tree->rules, *first;
+    uint32_t *sub, nsub, sub_lo[DPI_RANGE_DIMS], sub_hi[DPI_RANGE_DIMS], thr = 0, i;
+    int n, d, left, right;
+
+    if ((n = range_tree_node(ctx)) < 0) {
+        return -1;
+    }
+    if (cnt == 0) {
+        return range_tree_leaf(ctx, n, idx, 0);
+    }
+
+    first = &rules[idx[0]];
+    for (d = 0; d < DPI_RANGE_DIMS; d ++) {
+        if (first->l[d] > lo[d] || first->h[d] < hi[d]) {
+            break;
+        }
+    }
+    if (d == DPI_RANGE_DIMS) {
+        return range_tree_leaf(ctx, n, idx, 1);
+    }
+
+    if (cnt <= RANGE_TREE_LEAF_RULES || depth >= RANGE_TREE_MAX_DEPTH ||
+        (d = range_tree_split(ctx, idx, cnt, lo, hi, &thr)) < 0) {
+        return range_tree_leaf(ctx, n, idx, cnt);
+    }
+
+    sub = mem_malloc(DP_MEM_POLICY, sizeof(uint32_t) * cnt);
+    if (sub == NULL) {
+        return -1;
+    }
+
+    memcpy(sub_lo, lo, sizeof(sub_lo));
+    memcpy(sub_hi, hi, sizeof(sub_hi));
+    sub_hi[d] = thr;
+    for (i = 0, nsub = 0; i < cnt; i ++) {
+        if (rules[idx[i]].l[d] <= thr) {
+            sub[nsub ++] = idx[i];
+        }
+    }
+    left = range_tree_build(ctx, sub, nsub, sub_lo, sub_hi, depth + 1);
+
+    sub_hi[d] = hi[d];
+    sub_lo[d] = thr + 1;
+    for (i = 0, nsub = 0; i < cnt; i ++) {
+        if (rules[idx[i]].h[d] > thr) {
+            sub[nsub ++] = idx[i];
+        }
+    }
+    right = left < 0 ? -1 : range_tree_build(ctx, sub, nsub, sub_lo, sub_hi, depth + 1);
+    mem_free(DP_MEM_POLICY, sub);
+
+    if (right < 0) {
+        return -1;
+    }
+    ctx->tree->nodes[n].dim = d;
+    ctx->tree->nodes[n].thr = thr;
+    ctx->tree->nodes[n].left = left;
+    ctx->tree->nodes[n].right = right;
+    return n;
+}
+
+static void range_tree_free(dpi_range_tree_t *tree)
+{
+    if (tree != NULL) {
+        mem_free(DP_MEM_POLICY, tree->nodes);
+        mem_free(DP_MEM_POLICY, tree->leaf_rules);
+        mem_free(DP_MEM_POLICY, tree->rules);
+        mem_free(DP_MEM_POLICY, tree);
+    }
+}
+
+static dpi_range_tree_t *range_tree_create(dpi_range_rule_t *r)
+{
+    static const uint32_t lo[DPI_RANGE_DIMS] = {0, 0, 0, 0};
+    static const uint32_t hi[DPI_RANGE_DIMS] = {0xffff, 0xffffffff, 0xffffffff, 0xffffffff};
+    range_tree_ctx_t ctx;
+    dpi_range_tree_t *tree;
+    dpi_range_rule_item_t *item;
+    uint32_t cnt = 0, i, *idx = NULL;
+    int ret = -1;
+
+    for (item = r->range_rule_list; item != NULL; item = item->next) {
+        cnt ++;
+    }
+    if (cnt <= RANGE_TREE_LEAF_RULES) {
+        return NULL;
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    tree = mem_calloc(DP_MEM_POLICY, 1, sizeof(*tree));
+    if (tree == NULL) {
+        return NULL;
+    }
+    ctx.tree = tree;
+    ctx.node_size = 64;
+    tree->nodes = mem_malloc(DP_MEM_POLICY, sizeof(dpi_range_node_t) * ctx.node_size);
+    tree->rules = mem_malloc(DP_MEM_POLICY, sizeof(dpi_range_bound_t) * cnt);
+    idx = mem_malloc(DP_MEM_POLICY, sizeof(uint32_t) * cnt);
+    ctx.points = mem_malloc(DP_MEM_POLICY, sizeof(uint32_t) * cnt * 2);
+    if (tree->nodes == NULL || tree->rules == NULL || idx == NULL || ctx.points == NULL) {
+        goto exit;
+    }
+
+    // A reversed range never matches, leave it out
+    for (item = r->range_rule_list; item != NULL; item = item->next) {
+        dpi_range_bound_t *b = &tree->rules[tree->rule_count];
+
+        range_tree_fields(&item->key_l, b->l);
+        range_tree_fields(&item->key_h, b->h);
+        for (i = 0; i < DPI_RANGE_DIMS && b->l[i] <= b->h[i]; i ++);
+        if (i == DPI_RANGE_DIMS) {
+            b->item = item;
+            idx[tree->rule_count] = tree->rule_count;
+            tree->rule_count ++;
+        }
+    }
+
+    ret = range_tree_build(&ctx, idx, tree->rule_count, (uint32_t *)lo, (uint32_t *)hi, 0);
+
+exit:
+    mem_free(DP_MEM_POLICY, idx);
+    mem_free(DP_MEM_POLICY, ctx.points);
+    if (ret < 0) {
+        DEBUG_POLICY("range rule tree not built, rules=%u nodes=%u\n", cnt, tree->node_count);
+        range_tree_free(tree);
+        return NULL;
+    }
+    DEBUG_POLICY("range rule tree: rules=%u nodes=%u leaf_rules=%u\n",
+                 tree->rule_count, tree->node_count, tree->leaf_count);
+    return tree;
+}
+
+static dpi_range_rule_item_t *range_tree_lookup(dpi_range_tree_t *tree, dpi_rule_key_t *key)
 {
-    dpi_unknown_ip_cache_t *c = STRUCT_OF(ht_node, dpi_unknown_ip_cache_t, node);
-    const dpi_unknown_ip_desc_t *k = key;
+    dpi_range_node_t *n = &tree->nodes[0];
+    uint32_t f[DPI_RANGE_DIMS], i;
+
+    range_tree_fields(key, f);
+    while (n->dim != DPI_RANGE_DIM_LEAF) {
+        n = &tree->nodes[f[n->dim] <= n->thr ? n->left : n->right];
+    }
+
+    for (i = 0; i < n->count; i ++) {
+        dpi_range_bound_t *b = &tree->rules[tree->leaf_rules[n->left + i]];
+
+        if (range_box_match(b->l, b->h, f)) {
+            return b->item;
+        }
+    }
+    return NULL;
+}
 
-    return (c->desc.sip == k->sip && c->desc.dip == k->dip) ? true : false;
+// Objects taken out of a handle in use, freed after a grace period. Without a list they are
+// not visible to the dp threads and freed right away.
+typedef struct policy_trash_ {
+    struct policy_trash_ *next;
+    void *ptr;
+    bool tree;
+} policy_trash_t;
+
+static void policy_trash_free_one(void *ptr, bool tree)
+{
+    if (tree) {
+        range_tree_free(ptr);
+    } else {
+        mem_free(DP_MEM_POLICY, ptr);
+    }
 }
 
-static uint32_t unknown_ip_hash(const void *key)
+static void policy_trash_put(policy_trash_t **trash, void *ptr, bool tree)
 {
-    const dpi_unknown_ip_desc_t *k = key;
+    policy_trash_t *t;
 
-    return sdbm_hash((uint8_t *)&k->sip, 4) + sdbm_hash((uint8_t *)&k->dip, 4);
+    if (ptr == NULL) {
+        return;
+    }
+    if (trash == NULL) {
+        policy_trash_free_one(ptr, tree);
+        return;
+    }
+    if ((t = mem_malloc(DP_MEM_POLICY, sizeof(*t))) == NULL) {
+        synchronize_rcu();
+        policy_trash_free_one(ptr, tree);
+        return;
+    }
+    t->ptr = ptr;
+    t->tree = tree;
+    t->next = *trash;
+    *trash = t;
+}
+
+static void policy_trash_empty(policy_trash_t *trash)
+{
+    policy_trash_t *next;
+
+    for (; trash != NULL; trash = next) {
+        next = trash->next;
+        policy_trash_free_one(trash->ptr, trash->tree);
+        mem_free(DP_MEM_POLICY, trash);
+    }
+}
+
+static bool range_tree_build_one(struct cds_lfht_node *ht_node, void *args)
+{
+    dpi_range_rule_t *r = (dpi_range_rule_t *)ht_node;
+    dpi_range_tree_t *old = r->tree;
+
+    if (!r->dirty) {
+        return false;
+    }
+    rcu_assign_pointer(r->tree, range_tree_create(r));
+    r->dirty = false;
+    policy_trash_put(args, old, true);
+    return false;
+}
+
+// Rebuild the trees of the buckets that changed. Called once all rules of the policy are
+// added; for a handle in use, the replaced trees go to the trash.
+static void dpi_policy_build_range_tree(dpi_policy_hdl_t *hdl, policy_trash_t **trash)
+{
+    rcu_map_for_each(&hdl->range_policy_map, range_tree_build_one, trash);
+}
+
+/*
+ * -----------------------------------------------------
+ * --- compiled ipv4 rules ------------------------------
+ * -----------------------------------------------------
+ */
+#define POLICY_BLOB_ALIGN(x) (((x) + 7) & ~(uint32_t)7)
+
+typedef struct policy_blob_ctx_ {
+    dpi_policy_blob_t *blob;
+    void **slots;               // map entries by index slot while the blob is built
+    uint32_t rules, buckets, items, nodes, leafs;
+} policy_blob_ctx_t;
+
+static inline void *policy_blob_at(const dpi_policy_blob_t *b, uint32_t off)
+{
+    return (uint8_t *)b + off;
+}
+
+static inline uint32_t policy_blob_slots(uint32_t cnt)
+{
+    uint32_t slots = 2;
+
+    while (slots < cnt * 2) {
+        slots <<= 1;
+    }
+    return slots;
+}
+
+static bool blob_count_rule(struct cds_lfht_node *ht_node, void *args)
+{
+    ((policy_blob_ctx_t *)args)->rules ++;
+    return false;
+}
+
+static bool blob_count_bucket(struct cds_lfht_node *ht_node, void *args)
+{
+    policy_blob_ctx_t *ctx = args;
+    dpi_range_rule_t *r = (dpi_range_rule_t *)ht_node;
+    dpi_range_rule_item_t *item;
+
+    ctx->buckets ++;
+    for (item = r->range_rule_list; item != NULL; item = item->next) {
+        ctx->items ++;
+    }
+    if (r->tree != NULL) {
+        ctx->nodes += r->tree->node_count;
+        ctx->leafs += r->tree->leaf_count;
+    }
+    return false;
+}
+
+static void blob_slot_put(void **slots, uint32_t mask, uint32_t hash, void *entry)
+{
+    uint32_t i = hash & mask;
+
+    while (slots[i] != NULL) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = entry;
+}
+
+static bool blob_slot_rule(struct cds_lfht_node *ht_node, void *args)
+{
+    policy_blob_ctx_t *ctx = args;
+    dpi_rule_t *r = (dpi_rule_t *)ht_node;
+
+    blob_slot_put(ctx->slots, ctx->blob->rule_mask, rule_hash(&r->key), r);
+    return false;
+}
+
+static bool blob_slot_bucket(struct cds_lfht_node *ht_node, void *args)
+{
+    policy_blob_ctx_t *ctx = args;
+    dpi_range_rule_t *r = (dpi_range_rule_t *)ht_node;
+
+    blob_slot_put(ctx->slots, ctx->blob->bucket_mask, range_rule_hash(&r->key), r);
+    return false;
+}
+
+static void blob_add_bucket(policy_blob_ctx_t *ctx, dpi_policy_blob_bucket_t *bk, dpi_range_rule_t *r)
+{
+    dpi_policy_blob_t *b = ctx->blob;
+    dpi_policy_blob_item_t *items = policy_blob_at(b, b->item_off);
+    dpi_range_tree_t *tree = r->tree;
+    dpi_range_rule_item_t *item;
+    uint32_t i, j, *leafs, *pos = NULL;
+
+    bk->key = r->key;
+    bk->item = ctx->items;
+    bk->items = 0;
+    bk->node = bk->leaf = POLICY_BLOB_NONE;
+
+    // Leaf entries of the tree count the rules it kept, without the reversed ranges
+    if (tree != NULL) {
+        pos = mem_malloc(DP_MEM_POLICY, sizeof(uint32_t) * (tree->rule_count + 1));
+    }
+
+    for (i = 0, j = 0, item = r->range_rule_list; item != NULL; item = item->next, i ++) {
+        dpi_policy_blob_item_t *it = &items[ctx->items ++];
+
+        range_tree_fields(&item->key_l, it->l);
+        range_tree_fields(&item->key_h, it->h);
+        it->desc = item->desc;
+        if (pos != NULL && j < tree->rule_count && tree->rules[j].item == item) {
+            pos[j ++] = i;
+        }
+    }
+    bk->items = i;
+
+    if (pos != NULL) {
+        if (j == tree->rule_count) {
+            leafs = policy_blob_at(b, b->leaf_off);
+            memcpy((dpi_range_node_t *)policy_blob_at(b, b->node_off) + ctx->nodes,
+                   tree->nodes, sizeof(dpi_range_node_t) * tree->node_count);
+            for (i = 0; i < tree->leaf_count; i ++) {
+                leafs[ctx->leafs + i] = pos[tree->leaf_rules[i]];
+            }
+            bk->node = ctx->nodes;
+            bk->leaf = ctx->leafs;
+            ctx->nodes += tree->node_count;
+            ctx->leafs += tree->leaf_count;
+        }
+        mem_free(DP_MEM_POLICY, pos);
+    }
+}
+
+static dpi_policy_blob_t *policy_blob_create(dpi_policy_hdl_t *hdl)
+{
+    policy_blob_ctx_t ctx;
+    dpi_policy_blob_t hdr, *b;
+    dpi_policy_blob_rule_t *rules;
+    dpi_policy_blob_bucket_t *buckets;
+    uint32_t *idx, slots, i, n;
+
+    memset(&ctx, 0, sizeof(ctx));
+    rcu_map_for_each(&hdl->policy_map, blob_count_rule, &ctx);
+    rcu_map_for_each(&hdl->range_policy_map, blob_count_bucket, &ctx);
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.rules = ctx.rules;
+    hdr.rule_mask = policy_blob_slots(ctx.rules) - 1;
+    hdr.buckets = ctx.buckets;
+    hdr.bucket_mask = policy_blob_slots(ctx.buckets) - 1;
+    hdr.items = ctx.items;
+    hdr.nodes = ctx.nodes;
+    hdr.leafs = ctx.leafs;
+
+    hdr.rule_off = POLICY_BLOB_ALIGN(sizeof(hdr));
+    hdr.rule_idx_off = POLICY_BLOB_ALIGN(hdr.rule_off + sizeof(dpi_policy_blob_rule_t) * hdr.rules);
+    hdr.bucket_off = POLICY_BLOB_ALIGN(hdr.rule_idx_off + sizeof(uint32_t) * (hdr.rule_mask + 1));
+    hdr.bucket_idx_off = POLICY_BLOB_ALIGN(hdr.bucket_off + sizeof(dpi_policy_blob_bucket_t) * hdr.buckets);
+    hdr.item_off = POLICY_BLOB_ALIGN(hdr.bucket_idx_off + sizeof(uint32_t) * (hdr.bucket_mask + 1));
+    hdr.node_off = POLICY_BLOB_ALIGN(hdr.item_off + sizeof(dpi_policy_blob_item_t) * hdr.items);
+    hdr.leaf_off = POLICY_BLOB_ALIGN(hdr.node_off + sizeof(dpi_range_node_t) * hdr.nodes);
+    hdr.size = POLICY_BLOB_ALIGN(hdr.leaf_off + sizeof(uint32_t) * hdr.leafs);
+
+    slots = max(hdr.rule_mask, hdr.bucket_mask) + 1;
+    b = mem_calloc(DP_MEM_POLICY, 1, hdr.size);
+    ctx.slots = mem_malloc(DP_MEM_POLICY, sizeof(void *) * slots);
+    if (b == NULL || ctx.slots == NULL) {
+        DEBUG_ERROR(DBG_POLICY, "Out of memory, policy hdl %p not compiled\n", hdl);
+        mem_free(DP_MEM_POLICY, b);
+        mem_free(DP_MEM_POLICY, ctx.slots);
+        return NULL;
+    }
+    *b = hdr;
+    ctx.blob = b;
+
+    // The arrays are filled in the order of the slots, probes stay on a few lines
+    rules = policy_blob_at(b, b->rule_off);
+    idx = policy_blob_at(b, b->rule_idx_off);
+    memset(ctx.slots, 0, sizeof(void *) * (b->rule_mask + 1));
+    rcu_map_for_each(&hdl->policy_map, blob_slot_rule, &ctx);
+    for (i = 0, n = 0; i <= b->rule_mask; i ++) {
+        dpi_rule_t *r = ctx.slots[i];
+
+        if (r != NULL) {
+            rules[n].key = r->key;
+            rules[n].desc = r->desc;
+            idx[i] = ++ n;
+        }
+    }
+
+    buckets = policy_blob_at(b, b->bucket_off);
+    idx = policy_blob_at(b, b->bucket_idx_off);
+    memset(ctx.slots, 0, sizeof(void *) * (b->bucket_mask + 1));
+    rcu_map_for_each(&hdl->range_policy_map, blob_slot_bucket, &ctx);
+    ctx.items = ctx.nodes = ctx.leafs = 0;
+    for (i = 0, n = 0; i <= b->bucket_mask; i ++) {
+        dpi_range_rule_t *r = ctx.slots[i];
+
+        if (r != NULL) {
+            blob_add_bucket(&ctx, &buckets[n], r);
+            idx[i] = ++ n;
+        }
+    }
+
+    mem_free(DP_MEM_POLICY, ctx.slots);
+    DEBUG_POLICY("policy hdl %p compiled: rules=%u buckets=%u items=%u nodes=%u size=%u\n",
+                 hdl, b->rules, b->buckets, b->items, b->nodes, b->size);
+    return b;
+}
+
+static const dpi_policy_blob_rule_t *policy_blob_rule(const dpi_policy_blob_t *b, dpi_rule_key_t *key)
+{
+    const dpi_policy_blob_rule_t *rules = policy_blob_at(b, b->rule_off);
+    const uint32_t *idx = policy_blob_at(b, b->rule_idx_off);
+    uint32_t i = rule_hash(key) & b->rule_mask;
+
+    for (; idx[i] != 0; i = (i + 1) & b->rule_mask) {
+        const dpi_policy_blob_rule_t *r = &rules[idx[i] - 1];
+
+        if (memcmp(&r->key, key, sizeof(*key)) == 0) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+static inline bool blob_item_match(const dpi_policy_blob_item_t *it, const uint32_t *f)
+{
+    return range_box_match(it->l, it->h, f);
+}
+
+static const dpi_policy_blob_item_t *policy_blob_range(const dpi_policy_blob_t *b,
+                                                       dpi_range_rule_key_t *key2, dpi_rule_key_t *key)
+{
+    const dpi_policy_blob_bucket_t *buckets = policy_blob_at(b, b->bucket_off);
+    const uint32_t *idx = policy_blob_at(b, b->bucket_idx_off);
+    const dpi_policy_blob_item_t *items = policy_blob_at(b, b->item_off);
+    const dpi_policy_blob_bucket_t *bk = NULL;
+    uint32_t f[DPI_RANGE_DIMS], i;
+
+    for (i = range_rule_hash(key2) & b->bucket_mask; idx[i] != 0; i = (i + 1) & b->bucket_mask) {
+        if (memcmp(&buckets[idx[i] - 1].key, key2, sizeof(*key2)) == 0) {
+            bk = &buckets[idx[i] - 1];
+            break;
+        }
+    }
+    if (bk == NULL) {
+        return NULL;
+    }
+
+    items += bk->item;
+    range_tree_fields(key, f);
+    if (bk->node != POLICY_BLOB_NONE) {
+        const dpi_range_node_t *nodes = (const dpi_range_node_t *)policy_blob_at(b, b->node_off) + bk->node;
+        const uint32_t *leafs = (const uint32_t *)policy_blob_at(b, b->leaf_off) + bk->leaf;
+        const dpi_range_node_t *n = &nodes[0];
+
+        while (n->dim != DPI_RANGE_DIM_LEAF) {
+            n = &nodes[f[n->dim] <= n->thr ? n->left : n->right];
+        }
+        for (i = 0; i < n->count; i ++) {
+            if (blob_item_match(&items[leafs[n->left + i]], f)) {
+                return &items[leafs[n->left + i]];
+            }
+        }
+        return NULL;
+    }
+
+    for (i = 0; i < bk->items; i ++) {
+        if (blob_item_match(&items[i], f)) {
+            return &items[i];
+        }
+    }
+    return NULL;
+}
+
+// Compile the ipv4 rules once all are added, after the range trees are built. Lookups move
+// to the new blob at once; for a handle in use, the old one goes to the trash.
+static void dpi_policy_compile(dpi_policy_hdl_t *hdl, policy_trash_t **trash)
+{
+    dpi_policy_blob_t *old = hdl->blob;
+
+    rcu_assign_pointer(hdl->blob, policy_blob_create(hdl));
+    policy_trash_put(trash, old, false);
+}
+
+/*
+ * -----------------------------------------------------
+ * --- ipv6 policy rules --------------------------------
+ * -----------------------------------------------------
+ */
+// Exact rules are hashed on the full key. A range rule lookup probes the bucket of the /64
+// pair and the wide bucket of the workload /64, so its cost doesn't grow with the number of
+// peer subnets. There are no ipv6 internal subnets, a peer is external if no rule names it.
+static int rule6_match(struct cds_lfht_node *ht_node, const void *key)
+{
+    dpi_rule6_t *s = STRUCT_OF(ht_node, dpi_rule6_t, node);
+    const dpi_rule6_key_t *k = key;
+    return memcmp(&s->key, k, sizeof(dpi_rule6_key_t))?0:1;
+}
+
+static uint32_t rule6_hash(const void *key)
+{
+    const dpi_rule6_key_t *k = key;
+    return hash_key(k, sizeof(dpi_rule6_key_t));
+}
+
+static int range_rule6_match(struct cds_lfht_node *ht_node, const void *key)
+{
+    dpi_range_rule6_t *s = STRUCT_OF(ht_node, dpi_range_rule6_t, node);
+    const dpi_range_rule6_key_t *k = key;
+    return memcmp(&s->key, k, sizeof(dpi_range_rule6_key_t))?0:1;
+}
+
+static uint32_t range_rule6_hash(const void *key)
+{
+    const dpi_range_rule6_key_t *k = key;
+    return hash_key(k, sizeof(dpi_range_rule6_key_t));
+}
+
+static inline uint64_t ip6_prefix64(const struct in6_addr *ip)
+{
+    uint64_t v;
+    memcpy(&v, ip, sizeof(v));
+    return v;
+}
+
+#define IS_IP6_IN_RANGE(x, y, z) \
+    (memcmp(x, y, sizeof(struct in6_addr)) >= 0 && memcmp(x, z, sizeof(struct in6_addr)) <= 0)
+static bool rule6_key_in_range(dpi_range_rule6_item_t *item, dpi_rule6_key_t *k)
+{
+    return IS_X_IN_RANGE(k->dport, item->key_l.dport, item->key_h.dport) &&
+           IS_X_IN_RANGE(k->app, item->key_l.app, item->key_h.app) &&
+           IS_IP6_IN_RANGE(&k->sip, &item->key_l.sip, &item->key_h.sip) &&
+           IS_IP6_IN_RANGE(&k->dip, &item->key_l.dip, &item->key_h.dip);
+}
+
+static bool dpi_policy6_init(dpi_policy_hdl_t *hdl)
+{
+    if (DPI_POLICY_HAS_IPV6(hdl)) {
+        return true;
+    }
+    if (rcu_map_init(&hdl->policy6_map, 32, offsetof(dpi_rule6_t, node),
+                     rule6_match, rule6_hash) == NULL) {
+        return false;
+    }
+    if (rcu_map_init(&hdl->range_policy6_map, 16, offsetof(dpi_range_rule6_t, node),
+                     range_rule6_match, range_rule6_hash) == NULL) {
+        rcu_map_destroy(&hdl->policy6_map);
+        return false;
+    }
+    hdl->flag |= POLICY_HDL_FLAG_IPV6;
+    return true;
+}
+
+static bool iter_delete_one_rule6(struct cds_lfht_node *ht_node, void *args)
+{
+    dpi_policy_hdl_t *hdl = (dpi_policy_hdl_t *)args;
+    dpi_rule6_t *r = STRUCT_OF(ht_node, dpi_rule6_t, node);
+    rcu_map_del(&hdl->policy6_map, r);
+    mem_free(DP_MEM_POLICY, r);
+    th_counter.type1_rules--;
+    return 0;
+}
+
+static bool iter_delete_one_range_rule6(struct cds_lfht_node *ht_node, void *args)
+{
+    dpi_policy_hdl_t *hdl = (dpi_policy_hdl_t *)args;
+    dpi_range_rule6_t *r = STRUCT_OF(ht_node, dpi_range_rule6_t, node);
+    dpi_range_rule6_item_t *p, *prev;
+    rcu_map_del(&hdl->range_policy6_map, r);
+    p = r->range_rule_list;
+    while (p) {
+        prev = p;
+        p = p->next;
+        mem_free(DP_MEM_POLICY, prev);
+        th_counter.type2_rules--;
+    }
+    mem_free(DP_MEM_POLICY, r);
+    return 0;
+}
+
+static void dpi_policy6_destroy(dpi_policy_hdl_t *hdl)
+{
+    if (!DPI_POLICY_HAS_IPV6(hdl)) {
+        return;
+    }
+    rcu_map_for_each(&hdl->policy6_map, iter_delete_one_rule6, hdl);
+    rcu_map_for_each(&hdl->range_policy6_map, iter_delete_one_range_rule6, hdl);
+    rcu_map_destroy(&hdl->policy6_map);
+    rcu_map_destroy(&hdl->range_policy6_map);
+}
+
+static int get_range6_key(dpi_rule6_key_t *key_l, dpi_rule6_key_t *key_h, int dir,
+                          dpi_range_rule6_key_t *key)
+{
+    struct in6_addr *local, *peer_l, *peer_h;
+
+    if (key_l->proto != key_h->proto) {
+        DEBUG_ERROR(DBG_POLICY, "policy not valid! proto %u-%u\n", key_l->proto, key_h->proto);
+        return -1;
+    }
+    memset(key, 0, sizeof(dpi_range_rule6_key_t));
+    key->proto = key_l->proto;
+    switch (dir) {
+    case POLICY_RULE_DIR_INGRESS:
+        local = &key_l->dip;
+        peer_l = &key_l->sip;
+        peer_h = &key_h->sip;
+        key->flag = DP_RANGE_RULE_INGRESS;
+        break;
+    case POLICY_RULE_DIR_EGRESS:
+        local = &key_l->sip;
+        peer_l = &key_l->dip;
+        peer_h = &key_h->dip;
+        key->flag = DP_RANGE_RULE_EGRESS;
+        break;
+    default:
+        DEBUG_ERROR(DBG_POLICY, "policy not valid! dir %d\n", dir);
+        return -1;
+    }
+    key->local = ip6_prefix64(local);
+    if (ip6_prefix64(peer_l) == ip6_prefix64(peer_h)) {
+        key->peer = ip6_prefix64(peer_l);
+    } else {
+        key->flag |= DP_RANGE_RULE_WIDE;
+    }
+    return 0;
+}
+
+static int dpi_range_rule6_add(dpi_policy_hdl_t *hdl, dpi_rule6_key_t *key_l,
+                               dpi_rule6_key_t *key_h, int dir, dpi_policy_desc_t *desc,
+                               dpi_policy_desc_t *exist_desc)
+{
+    dpi_range_rule6_key_t key;
+    dpi_range_rule6_t *r;
+    dpi_range_rule6_item_t *item, *p, *prev;
+
+    if (get_range6_key(key_l, key_h, dir, &key)) {
+        return -1;
+    }
+
+    r = rcu_map_lookup(&hdl->range_policy6_map, &key);
+    if (!r) {
+        r = (dpi_range_rule6_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(dpi_range_rule6_t));
+        if (!r) {
+            DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
+            return -1;
+        }
+        memcpy(&r->key, &key, sizeof(key));
+        rcu_map_add(&hdl->range_policy6_map, r, &key);
+    }
+
+    for (p = r->range_rule_list, prev = NULL; p; prev = p, p = p->next) {
+        if (memcmp(&p->key_l, key_l, sizeof(*key_l)) == 0 &&
+            memcmp(&p->key_h, key_h, sizeof(*key_h)) == 0) {
+            policy_desc_cpy(exist_desc, &p->desc);
+            return 0;
+        }
+    }
+
+    item = (dpi_range_rule6_item_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(dpi_range_rule6_item_t));
+    if (!item) {
+        DEBUG_ERROR(DBG_POLICY, "OOM 2!!!\n");
+        return -1;
+    }
+    policy_desc_cpy(&item->desc, desc);
+    memcpy(&item->key_l, key_l, sizeof(*key_l));
+    memcpy(&item->key_h, key_h, sizeof(*key_h));
+    item->seq = hdl->range6_seq ++;
+
+    /* append at the end */
+    if (prev) {
+        prev->next = item;
+    } else {
+        r->range_rule_list = item;
+    }
+    th_counter.type2_rules++;
+    hdl->entries++;
+    return 1;
+}
+
+static dpi_range_rule6_item_t *dpi_range_rule6_match(dpi_policy_hdl_t *hdl,
+                                                     dpi_range_rule6_key_t *key2,
+                                                     dpi_rule6_key_t *key)
+{
+    dpi_range_rule6_t *r = rcu_map_lookup(&hdl->range_policy6_map, key2);
+    dpi_range_rule6_item_t *item;
+
+    if (!r) {
+        return NULL;
+    }
+    for (item = r->range_rule_list; item; item = item->next) {
+        if (rule6_key_in_range(item, key)) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void _dpi_policy6_lookup_by_key(dpi_policy_hdl_t *hdl, dpi_rule6_key_t *key,
+                                       int is_ingress, dpi_policy_desc_t *desc)
+{
+    dpi_range_rule6_key_t key2;
+    dpi_range_rule6_item_t *item, *wide;
+    dpi_rule6_t *r;
+
+    r = rcu_map_lookup(&hdl->policy6_map, key);
+    if (r) {
+        policy_desc_cpy(desc, &r->desc);
+        return;
+    }
+
+    memset(&key2, 0, sizeof(key2));
+    key2.proto = key->proto;
+    if (is_ingress) {
+        key2.flag = DP_RANGE_RULE_INGRESS;
+        key2.local = ip6_prefix64(&key->dip);
+        key2.peer = ip6_prefix64(&key->sip);
+    } else {
+        key2.flag = DP_RANGE_RULE_EGRESS;
+        key2.local = ip6_prefix64(&key->sip);
+        key2.peer = ip6_prefix64(&key->dip);
+    }
+    item = dpi_range_rule6_match(hdl, &key2, key);
+
+    key2.flag |= DP_RANGE_RULE_WIDE;
+    key2.peer = 0;
+    wide = dpi_range_rule6_match(hdl, &key2, key);
+    if (wide && (!item || wide->seq < item->seq)) {
+        item = wide;
+    }
+
+    if (item) {
+        policy_desc_cpy(desc, &item->desc);
+    } else {
+        desc->id = 0;
+        desc->action = hdl->def_action;
+        desc->flags = POLICY_DESC_CHECK_VER;
+        desc->order = 0xffffffff;
+        desc->hdl_ver = 0;
+    }
+}
+
+static int dpi_policy6_lookup_by_key(dpi_policy_hdl_t *hdl, struct in6_addr *sip,
+                                     struct in6_addr *dip, uint16_t dport, uint16_t proto,
+                                     uint32_t app, int is_ingress, dpi_policy_desc_t *desc)
+{
+    dpi_rule6_key_t key;
+    dpi_policy_desc_t desc2;
+
+    if (unlikely(!hdl || th_disable_net_policy)) {
+        // workload just created, allow traffic pass until policy being configured
+        desc->id = 0;
+        desc->action = DP_POLICY_ACTION_OPEN;
+        desc->flags = POLICY_DESC_CHECK_VER | POLICY_DESC_TMP_OPEN | POLICY_DESC_EXTERNAL;
+        goto exit;
+    }
+    if (!DPI_POLICY_HAS_IPV6(hdl)) {
+        // no ipv6 rule is configured, ipv6 traffic is not enforced
+        memset(desc, 0, sizeof(dpi_policy_desc_t));
+        desc->flags = POLICY_DESC_CHECK_VER;
+        goto exit;
+    }
+    if (IN6_IS_ADDR_LINKLOCAL(sip) || IN6_IS_ADDR_LINKLOCAL(dip) ||
+        IN6_IS_ADDR_MULTICAST(sip) || IN6_IS_ADDR_MULTICAST(dip)) {
+        desc->id = 0;
+        desc->action = DP_POLICY_ACTION_OPEN;
+        desc->flags = POLICY_DESC_CHECK_VER | POLICY_DESC_INTERNAL | POLICY_DESC_LINK_LOCAL;
+        goto exit;
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.sip = *sip;
+    key.dip = *dip;
+    key.dport = dport;
+    key.proto = proto;
+    key.app = app;
+    _dpi_policy6_lookup_by_key(hdl, &key, is_ingress, desc);
+    if (desc->id > 0) {
+        desc->flags |= POLICY_DESC_INTERNAL;
+        goto exit;
+    }
+
+    // rules of external peers have a zero peer address
+    if (is_ingress) {
+        memset(&key.sip, 0, sizeof(key.sip));
+    } else {
+        memset(&key.dip, 0, sizeof(key.dip));
+    }
+    _dpi_policy6_lookup_by_key(hdl, &key, is_ingress, &desc2);
+    if (desc2.id > 0) {
+        policy_desc_cpy(desc, &desc2);
+    }
+    desc->flags |= POLICY_DESC_EXTERNAL;
+exit:
+    desc->hdl_ver = hdl?hdl->ver:0;
+    DEBUG_POLICY("ipv6 proto %u port %u app %u ingress %d match: " DP_POLICY_DESC_STR "\n",
+                 proto, dport, app, is_ingress, DP_POLICY_DESC(desc));
+    return 0;
+}
+
+static int dpi_rule6_add_one(dpi_policy_hdl_t *hdl, dpi_rule6_key_t *key_l,
+                             dpi_rule6_key_t *key_h, int dir, dpi_policy_desc_t *desc,
+                             dpi_policy_desc_t *exist_desc)
+{
+    if (key_h == NULL) {
+        dpi_rule6_t *r;
+
+        _dpi_policy6_lookup_by_key(hdl, key_l, dir == POLICY_RULE_DIR_INGRESS?1:0, exist_desc);
+        if (exist_desc->id != 0) {
+            return 0;
+        }
+
+        r = (dpi_rule6_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(dpi_rule6_t));
+        if (!r) {
+            DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
+            return -1;
+        }
+        memcpy(&r->key, key_l, sizeof(*key_l));
+        policy_desc_cpy(&r->desc, desc);
+        rcu_map_add(&hdl->policy6_map, r, key_l);
+        th_counter.type1_rules++;
+        hdl->entries++;
+        return 1;
+    } else {
+        return dpi_range_rule6_add(hdl, key_l, key_h, dir, desc, exist_desc);
+    }
+}
+
+static int dpi_add_app_rule6(dpi_policy_hdl_t *hdl, dpi_rule6_key_t *key_l, dpi_rule6_key_t *key_h,
+                             dpi_policy_app_rule_t *app_rule, int dir, dpi_policy_desc_t *desc,
+                             dpi_policy_desc_t *exist_desc)
+{
+    int use_key = 0;
+    dpi_rule6_key_t key;
+    dpi_policy_desc_t app_desc;
+
+    key_l->app = app_rule->app;
+    if (key_l->app) {
+        if (key_h) {
+            key_h->app = key_l->app;
+        }
+    } else {
+        // application any
+        if (key_h) {
+            key_h->app = 0xffffffff;
+        } else {
+            memcpy(&key, key_l, sizeof(dpi_rule6_key_t));
+            key.app = 0xffffffff;
+            use_key = 1;
+        }
+    }
+    app_desc.id = app_rule->rule_id;
+    app_desc.action = app_rule->action;
+    app_desc.hdl_ver = 0;
+    app_desc.flags = desc->flags;
+    app_desc.order = desc->order;
+    return dpi_rule6_add_one(hdl, key_l, use_key?&key:key_h, dir, &app_desc, exist_desc);
 }
 
-static void unknown_ip_release(timer_entry_t *entry)
+// Same as dpi_rule_add()
+static int dpi_rule6_add(dpi_policy_hdl_t *hdl, dpi_rule6_key_t *key_l, dpi_rule6_key_t *key_h,
+                         int app_num, dpi_policy_app_rule_t *app_rules,
+                         int dir, dpi_policy_desc_t *desc)
 {
-    dpi_unknown_ip_cache_t *c = STRUCT_OF(entry, dpi_unknown_ip_cache_t, ts_entry);
-    rcu_map_del(&th_unknown_ip_map, c);
-    free(c);
-}
+    int ret, i;
+    bool app_any = false;
+    dpi_policy_desc_t exist_desc;
 
-void dpi_unknown_ip_init(void)
-{
-    rcu_map_init(&th_unknown_ip_map, 64, offsetof(dpi_unknown_ip_cache_t, node), unknown_ip_match, unknown_ip_hash);
-}
+    memset(&exist_desc, 0, sizeof(exist_desc));
+    ret = dpi_rule6_add_one(hdl, key_l, key_h, dir, desc, &exist_desc);
+    if (ret < 0) {
+        return ret;
+    } else if (ret == 0 && exist_desc.id > 0) {
+        if (exist_desc.action != DP_POLICY_ACTION_CHECK_APP) {
+            return ret;
+        }
+        app_any = desc->action != DP_POLICY_ACTION_CHECK_APP;
+    } else if (ret > 0) {
+        app_any = desc->id > 0 && desc->action != DP_POLICY_ACTION_CHECK_APP;
+    }
+    if (app_any) {
+        dpi_policy_app_rule_t app_rule;
+        app_rule.app = 0;
+        app_rule.action = desc->action;
+        app_rule.rule_id = desc->id;
+        ret = dpi_add_app_rule6(hdl, key_l, key_h, &app_rule, dir, desc, &exist_desc);
+    }
 
-static void add_unknown_ip_cache(dpi_unknown_ip_desc_t *desc, dpi_unknown_ip_desc_t *key, uint8_t iptype, bool ext)
-{
-    dpi_unknown_ip_cache_t *cache = calloc(1, sizeof(*cache));
-    if (cache != NULL) {
-        memcpy(&cache->desc, desc, sizeof(*desc));
-        cache->start_hit = th_snap.tick;
-        cache->last_hit = th_snap.tick;
-        if (iptype == DP_IPTYPE_HOSTIP || iptype == DP_IPTYPE_TUNNELIP) {
-            cache->try_cnt = HOST_IP_TRY_COUNT;
-        } else {
-            cache->try_cnt = UNKNOWN_IP_TRY_COUNT;
-            if (ext) {
-                cache->try_cnt = EXT_IP_TRY_COUNT;
+    if (app_num > 0) {
+        for (i = 0; i < app_num; i++) {
+            if (dpi_add_app_rule6(hdl, key_l, key_h, &app_rules[i], dir, desc, &exist_desc) == 1) {
+                ret++;
             }
         }
-        rcu_map_add(&th_unknown_ip_map, cache, key);
-
-        timer_wheel_entry_init(&cache->ts_entry);
-        timer_wheel_entry_start(&th_timer, &cache->ts_entry,
-                                unknown_ip_release, UNKNOWN_IP_CACHE_TIMEOUT, th_snap.tick);
+        key_l->app = 0;
+        if (key_h) {
+            key_h->app = 0;
+        }
     }
+    return ret;
 }
 
-static void refresh_unknown_ip_cache(dpi_unknown_ip_cache_t *cache, uint16_t thdl_ver, uint8_t try_cnt)
+static void dpi_policy6_add_rule(dpi_policy_hdl_t *hdl, dpi_policy_rule6_t *rule, uint32_t order)
 {
-    cache->try_cnt = try_cnt;
-    cache->desc.hdl_ver = thdl_ver;
-    //restart timestamp
-    cache->start_hit = th_snap.tick;
-    cache->last_hit = th_snap.tick;
+    static const uint16_t protos[] = {IPPROTO_TCP, IPPROTO_UDP};
+    dpi_rule6_key_t key, key_r, *kh = NULL;
+    dpi_policy_desc_t desc;
+    int dir, i;
+
+    memset(&key, 0, sizeof(key));
+    memset(&desc, 0, sizeof(desc));
+    key.sip = rule->sip;
+    key.dip = rule->dip;
+    key.dport = rule->dport;
+    key.proto = rule->proto;
+    desc.id = rule->id;
+    desc.action = rule->action;
+    desc.flags = POLICY_DESC_CHECK_VER;
+    desc.order = order;
+    dir = rule->ingress?POLICY_RULE_DIR_INGRESS:POLICY_RULE_DIR_EGRESS;
+
+    if (rule->dport != rule->dport_r || memcmp(&rule->sip, &rule->sip_r, sizeof(rule->sip)) ||
+        memcmp(&rule->dip, &rule->dip_r, sizeof(rule->dip))) {
+        memcpy(&key_r, &key, sizeof(key_r));
+        key_r.sip = rule->sip_r;
+        key_r.dip = rule->dip_r;
+        key_r.dport = rule->dport_r;
+        kh = &key_r;
+    }
 
-    timer_wheel_entry_refresh(&th_timer, &cache->ts_entry, th_snap.tick);
+    // icmpv6 is not enforced, proto any is tcp and udp
+    if (rule->proto > 0) {
+        dpi_rule6_add(hdl, &key, kh, rule->num_apps, rule->app_rules, dir, &desc);
+        return;
+    }
+    for (i = 0; i < (int)(sizeof(protos) / sizeof(protos[0])); i++) {
+        key.proto = key_r.proto = protos[i];
+        dpi_rule6_add(hdl, &key, kh, rule->num_apps, rule->app_rules, dir, &desc);
+    }
 }
 
-static void update_unknown_ip_cache(dpi_unknown_ip_cache_t *cache)
+void dpi_add_default_policy(dpi_policy_hdl_t *hdl)
 {
-    timer_wheel_entry_refresh(&th_timer, &cache->ts_entry, th_snap.tick);
-    //update timestamp
-    cache->last_hit = th_snap.tick;
+    dpi_rule_key_t key_l, key_h;
+    dpi_policy_desc_t desc;
+
+    memset(&key_l, 0, sizeof(key_l));
+    memset(&key_h, 0, sizeof(key_h));
+    memset(&desc, 0, sizeof(desc));
+
+    /* Allow all ICMP traffic */
+    key_l.sip = 0;
+    key_l.dip = 0;
+    key_l.dport = 0;
+    key_l.proto = IPPROTO_ICMP;
+    key_h.sip = 0xffffffff;
+    key_h.dip = 0xffffffff;
+    key_h.dport = 0;
+    key_h.proto = IPPROTO_ICMP;
+    desc.action = DP_POLICY_ACTION_ALLOW;
+    desc.id = DEFAULT_ICMP_PASS_POLICY_ID;
+    desc.order = 0xffffffff;
+    dpi_rule_add(hdl, &key_l, &key_h, 0, NULL, POLICY_RULE_DIR_NONE, &desc);
 }
 
 /*
  * -----------------------------------------------------
- * --- Policy rule definition --------------------------
+ * --- shared policy hdls -------------------------------
  * -----------------------------------------------------
  */
-static int dpi_policy_lookup_by_key(dpi_policy_hdl_t *hdl, uint32_t sip, uint32_t dip,
-                             uint16_t dport, uint16_t proto, uint32_t app,
-                             int is_ingress, dpi_policy_desc_t *desc, dpi_packet_t *p);
-static int dpi_rule_add(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l, dpi_rule_key_t *key_h,
-                 int app_num, dpi_policy_app_rule_t *app_rules,
-                 int dir, dpi_policy_desc_t *desc);
+// Workloads with the same rule set, like the replicas of a deployment, share one hdl. A hdl built
+// from a full config is keyed by a digest of the config, a hdl made by a delta by the digest of
+// its source hdl and the delta, so replicas taking the same delta share the result again. The
+// map is only used by the ctrl thread.
+static rcu_map_t g_policy_hdl_map;
 
-/*----------------------------------------------------*/
+#define POLICY_DIGEST_BASIS 0xcbf29ce484222325ULL
+#define POLICY_DIGEST_PRIME 0x100000001b3ULL
 
-static int rule_match(struct cds_lfht_node *ht_node, const void *key)
+static uint64_t policy_digest(uint64_t h, const void *data, size_t len)
 {
-    dpi_rule_t *s = STRUCT_OF(ht_node, dpi_rule_t, node);
-    const dpi_rule_key_t *k = key;
-    return memcmp(&s->key, k, sizeof(dpi_rule_key_t))?0:1;
-}
+    const uint8_t *d = data;
+    size_t i;
 
-static uint32_t rule_hash(const void *key)
-{
-    const dpi_rule_key_t *k = key;
-    return sdbm_hash((uint8_t *)k, sizeof(dpi_rule_key_t));
+    for (i = 0; i < len; i ++) {
+        h = (h ^ d[i]) * POLICY_DIGEST_PRIME;
+    }
+    return h;
 }
 
-static void rule_key_cpy(dpi_rule_key_t *k1, dpi_rule_key_t *k2)
+#define POLICY_DIGEST_VAL(h, v) policy_digest(h, &(v), sizeof(v))
+
+static uint64_t policy_digest_apps(uint64_t h, uint32_t num_apps, dpi_policy_app_rule_t *apps)
 {
-    memcpy(k1, k2, sizeof(dpi_rule_key_t));
+    uint32_t i;
+
+    h = POLICY_DIGEST_VAL(h, num_apps);
+    for (i = 0; i < num_apps; i ++) {
+        h = POLICY_DIGEST_VAL(h, apps[i].rule_id);
+        h = POLICY_DIGEST_VAL(h, apps[i].app);
+        h = POLICY_DIGEST_VAL(h, apps[i].action);
+    }
+    return h;
 }
 
-static void policy_desc_cpy(dpi_policy_desc_t *d1, dpi_policy_desc_t *d2)
+// Digest of the rules of a config message, the first message also brings the policy settings.
+// Taken before the rules are added, fqdn rules get their address codes then.
+static uint64_t dpi_policy_digest(uint64_t h, dpi_policy_t *p, bool start)
 {
-    memcpy(d1, d2, sizeof(dpi_policy_desc_t));
+    int i;
+
+    if (start) {
+        h = POLICY_DIGEST_BASIS;
+        h = POLICY_DIGEST_VAL(h, p->def_action);
+        h = POLICY_DIGEST_VAL(h, p->apply_dir);
+        // rules are expanded differently with icmp policy
+        h = POLICY_DIGEST_VAL(h, g_enable_icmp_policy);
+    }
+
+    h = POLICY_DIGEST_VAL(h, p->num_rules);
+    for (i = 0; i < p->num_rules; i ++) {
+        dpi_policy_rule_t *r = &p->rule_list[i];
+
+        h = POLICY_DIGEST_VAL(h, r->id);
+        h = POLICY_DIGEST_VAL(h, r->sip);
+        h = POLICY_DIGEST_VAL(h, r->sip_r);
+        h = POLICY_DIGEST_VAL(h, r->dip);
+        h = POLICY_DIGEST_VAL(h, r->dip_r);
+        h = POLICY_DIGEST_VAL(h, r->dport);
+        h = POLICY_DIGEST_VAL(h, r->dport_r);
+        h = POLICY_DIGEST_VAL(h, r->proto);
+        h = POLICY_DIGEST_VAL(h, r->action);
+        h = POLICY_DIGEST_VAL(h, r->ingress);
+        h = POLICY_DIGEST_VAL(h, r->vh);
+        h = policy_digest(h, r->fqdn, strnlen(r->fqdn, MAX_FQDN_LEN) + 1);
+        h = policy_digest_apps(h, r->num_apps, r->app_rules);
+    }
+
+    h = POLICY_DIGEST_VAL(h, p->num_rules6);
+    for (i = 0; i < p->num_rules6; i ++) {
+        dpi_policy_rule6_t *r = &p->rule6_list[i];
+
+        h = POLICY_DIGEST_VAL(h, r->id);
+        h = POLICY_DIGEST_VAL(h, r->sip);
+        h = POLICY_DIGEST_VAL(h, r->sip_r);
+        h = POLICY_DIGEST_VAL(h, r->dip);
+        h = POLICY_DIGEST_VAL(h, r->dip_r);
+        h = POLICY_DIGEST_VAL(h, r->dport);
+        h = POLICY_DIGEST_VAL(h, r->dport_r);
+        h = POLICY_DIGEST_VAL(h, r->proto);
+        h = POLICY_DIGEST_VAL(h, r->action);
+        h = POLICY_DIGEST_VAL(h, r->ingress);
+        h = policy_digest_apps(h, r->num_apps, r->app_rules);
+    }
+    return h;
 }
 
-static int rule_key_comp(dpi_rule_key_t *k1, dpi_rule_key_t *k2)
+// The delete ids are sorted
+static uint64_t dpi_policy_delta_digest(uint64_t h, dpi_policy_t *p)
 {
-    return memcmp(k1, k2, sizeof(dpi_rule_key_t));
+    h = POLICY_DIGEST_VAL(h, p->num_del_ids);
+    h = policy_digest(h, p->del_ids, sizeof(uint32_t) * p->num_del_ids);
+    return dpi_policy_digest(h, p, false);
 }
 
-static int range_rule_match(struct cds_lfht_node *ht_node, const void *key)
+static int policy_hdl_match(struct cds_lfht_node *ht_node, const void *key)
 {
-    dpi_range_rule_t *s = STRUCT_OF(ht_node, dpi_range_rule_t, node);
-    const dpi_range_rule_key_t *k = key;
-
-    return memcmp(&s->key, k, sizeof(dpi_range_rule_key_t))?0:1;
+    dpi_policy_hdl_t *hdl = STRUCT_OF(ht_node, dpi_policy_hdl_t, node);
+    const uint64_t *k = key;
+    return hdl->digest == *k;
 }
 
-static uint32_t range_rule_hash(const void *key)
+static uint32_t policy_hdl_hash(const void *key)
 {
-    const dpi_range_rule_key_t *k = key;
-    return sdbm_hash((uint8_t *)k, sizeof(dpi_range_rule_key_t));
+    const uint64_t *k = key;
+    return hash_u64(*k);
 }
 
-static void range_rule_key_cpy(dpi_range_rule_key_t *k1, dpi_range_rule_key_t *k2)
+static dpi_policy_hdl_t *dpi_policy_hdl_find(uint64_t digest)
 {
-    memcpy(k1, k2, sizeof(dpi_range_rule_key_t));
+    return rcu_map_lookup(&g_policy_hdl_map, &digest);
 }
 
-#define IS_X_IN_RANGE(x, y, z) ((x >= y) && (x <= z))
-static int rule_key_in_range(dpi_range_rule_item_t *item, dpi_rule_key_t *k)
+static void dpi_policy_hdl_share(dpi_policy_hdl_t *hdl, uint64_t digest)
 {
-    if (IS_X_IN_RANGE(k->dport, item->key_l.dport, item->key_h.dport) &&
-        IS_X_IN_RANGE(ntohl(k->sip), ntohl(item->key_l.sip), ntohl(item->key_h.sip)) &&
-        IS_X_IN_RANGE(ntohl(k->dip), ntohl(item->key_l.dip), ntohl(item->key_h.dip)) &&
-        IS_X_IN_RANGE(k->app, item->key_l.app, item->key_h.app)) {
-        return 1;
-    } else {
-        return 0;
+    if (hdl->flag & (POLICY_HDL_FLAG_SHARED | POLICY_HDL_FLAG_NOSHARE)) {
+        return;
     }
+    hdl->digest = digest;
+    hdl->flag |= POLICY_HDL_FLAG_SHARED;
+    rcu_map_add(&g_policy_hdl_map, hdl, &hdl->digest);
+    DEBUG_POLICY("share policy hdl %p digest 0x%llx\n", hdl, (unsigned long long)digest);
 }
 
-void dpi_add_default_policy(dpi_policy_hdl_t *hdl)
+// The rules of the hdl no longer match its digest
+static void dpi_policy_hdl_unshare(dpi_policy_hdl_t *hdl)
 {
-    dpi_rule_key_t key_l, key_h;
-    dpi_policy_desc_t desc;
-
-    memset(&key_l, 0, sizeof(key_l));
-    memset(&key_h, 0, sizeof(key_h));
-    memset(&desc, 0, sizeof(desc));
-
-    /* Allow all ICMP traffic */
-    key_l.sip = 0;
-    key_l.dip = 0;
-    key_l.dport = 0;
-    key_l.proto = IPPROTO_ICMP;
-    key_h.sip = 0xffffffff;
-    key_h.dip = 0xffffffff;
-    key_h.dport = 0;
-    key_h.proto = IPPROTO_ICMP;
-    desc.action = DP_POLICY_ACTION_ALLOW;
-    desc.id = DEFAULT_ICMP_PASS_POLICY_ID;
-    desc.order = 0xffffffff;
-    dpi_rule_add(hdl, &key_l, &key_h, 0, NULL, POLICY_RULE_DIR_NONE, &desc);
+    if (hdl->flag & POLICY_HDL_FLAG_SHARED) {
+        rcu_map_del(&g_policy_hdl_map, hdl);
+        hdl->flag &= ~POLICY_HDL_FLAG_SHARED;
+    }
 }
 
 static dpi_policy_hdl_t *dpi_policy_hdl_init(int def_action)
 {
     dpi_policy_hdl_t *hdl;
-    hdl = calloc(sizeof(dpi_policy_hdl_t), 1);
+    hdl = mem_calloc(DP_MEM_POLICY, sizeof(dpi_policy_hdl_t), 1);
     if (!hdl) {
         DEBUG_ERROR(DBG_POLICY, "Out of memory!");
         return NULL;
@@ -241,7 +1560,7 @@ bool iter_delete_one_rule(struct cds_lfht_node *ht_node, void *args)
     dpi_policy_hdl_t *hdl = (dpi_policy_hdl_t *)args;
     dpi_rule_t *r = (dpi_rule_t *)ht_node;
     rcu_map_del(&hdl->policy_map, ht_node);
-    free(r);
+    mem_free(DP_MEM_POLICY, r);
     th_counter.type1_rules--;
     return 0;
 }
@@ -252,29 +1571,50 @@ bool iter_delete_one_range_rule(struct cds_lfht_node *ht_node, void *args)
     dpi_range_rule_t *r = (dpi_range_rule_t *)ht_node;
     dpi_range_rule_item_t  *p, *prev;
     rcu_map_del(&hdl->range_policy_map, ht_node);
+    range_tree_free(r->tree);
     p = r->range_rule_list;
     while (p) {
         prev = p;
         p = p->next;
-        free(prev);
+        mem_free(DP_MEM_POLICY, prev);
         th_counter.type2_rules--;
     }
-    free(r);
+    mem_free(DP_MEM_POLICY, r);
     return 0;
 }
 
+static void dpi_policy_shadow_free(dpi_policy_shadow_t *sh)
+{
+    dpi_policy_shadow_t *next;
+
+    for (; sh != NULL; sh = next) {
+        next = sh->next;
+        mem_free(DP_MEM_POLICY, sh);
+    }
+}
+
 void dpi_policy_hdl_destroy(dpi_policy_hdl_t *hdl)
 {
+    int i;
+
     DEBUG_POLICY("%p, ref_cnt %d \n", hdl, hdl->ref_cnt);
     if (hdl->ref_cnt > 1) {
         hdl->ref_cnt--;
         return;
     }
+    dpi_policy_hdl_unshare(hdl);
     rcu_map_for_each(&hdl->policy_map, iter_delete_one_rule, hdl);
     rcu_map_for_each(&hdl->range_policy_map, iter_delete_one_range_rule, hdl);
     rcu_map_destroy(&hdl->policy_map);
     rcu_map_destroy(&hdl->range_policy_map);
-    free(hdl);
+    mem_free(DP_MEM_POLICY, hdl->blob);
+    dpi_policy6_destroy(hdl);
+    dpi_policy_shadow_free(hdl->shadows);
+    mem_free(DP_MEM_POLICY, hdl->scope);
+    for (i = 0; i < MAX_DP_THREADS; i++) {
+        mem_free(DP_MEM_POLICY, hdl->cache[i]);
+    }
+    mem_free(DP_MEM_POLICY, hdl);
 }
 
 static int get_range_key(dpi_rule_key_t *key_l, dpi_rule_key_t *key_h, int dir,
@@ -310,9 +1650,11 @@ static int get_range_key(dpi_rule_key_t *key_l, dpi_rule_key_t *key_h, int dir,
     return 0;
 }
 
+// Items are kept in rule order, an item goes after those of the same order. The handle can
+// be in use, readers see the item once it is linked.
 static int dpi_range_rule_add(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l,
                               dpi_rule_key_t *key_h, int dir, dpi_policy_desc_t *desc,
-                              dpi_policy_desc_t *exist_desc)
+                              dpi_policy_desc_t *exist_desc, uint32_t src_id)
 {
     dpi_range_rule_key_t key;
     dpi_range_rule_t  *r;
@@ -324,7 +1666,7 @@ static int dpi_range_rule_add(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l,
 
     r = rcu_map_lookup(&hdl->range_policy_map, &key);
     if (!r) {
-        r = (dpi_range_rule_t *)calloc(1, sizeof(dpi_range_rule_t));
+        r = (dpi_range_rule_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(dpi_range_rule_t));
         if (!r) {
             DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
             return -1;
@@ -333,47 +1675,45 @@ static int dpi_range_rule_add(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l,
         rcu_map_add(&hdl->range_policy_map, r, &key);
     }
 
-    item = (dpi_range_rule_item_t *)calloc(1, sizeof(dpi_range_rule_item_t));
-    if (!item) {
-        DEBUG_ERROR(DBG_POLICY, "OOM 2!!!\n");
-        return -1;
-    } else {
-        policy_desc_cpy(&item->desc, desc);
-        rule_key_cpy(&item->key_l, key_l);
-        rule_key_cpy(&item->key_h, key_h);
-        item->next = NULL;
-    }
-
-    p = r->range_rule_list;
-    prev = p;
-    while (p) {
+    prev = NULL;
+    for (p = r->range_rule_list; p != NULL; p = p->next) {
         if ((rule_key_comp(&p->key_l, key_l) == 0) && (rule_key_comp(&p->key_h, key_h) == 0)) {
-            break;
-        } else {
+            /*
+            DEBUG_POLICY("Rule already exist!!!\n");
+            DEBUG_POLICY("key_l " DP_RULE_STR "key_h " DP_RULE_STR
+                        "old:"DP_POLICY_DESC_STR "new:" DP_POLICY_DESC_STR "\n",
+                        DP_RULE_KEY(key_l), DP_RULE_KEY(key_h),
+                        DP_POLICY_DESC(((&(p->desc)))), DP_POLICY_DESC(desc));
+            */
+            policy_desc_cpy(exist_desc, &p->desc);
+            return 0;
+        }
+        if (p->desc.order <= desc->order) {
             prev = p;
-            p = p->next;
         }
     }
 
-    if (p) {
-        /*
-        DEBUG_POLICY("Rule already exist!!!\n");
-        DEBUG_POLICY("key_l " DP_RULE_STR "key_h " DP_RULE_STR
-                    "old:"DP_POLICY_DESC_STR "new:" DP_POLICY_DESC_STR "\n",
-                    DP_RULE_KEY(key_l), DP_RULE_KEY(key_h),
-                    DP_POLICY_DESC(((&(p->desc)))), DP_POLICY_DESC(desc));
-        */
-        policy_desc_cpy(exist_desc, &p->desc);
-        free(item);
-        return 0;
-    } else if (prev) {
-        /* append at the end */
-        prev->next = item;
+    item = (dpi_range_rule_item_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(dpi_range_rule_item_t));
+    if (!item) {
+        DEBUG_ERROR(DBG_POLICY, "OOM 2!!!\n");
+        return -1;
+    }
+    policy_desc_cpy(&item->desc, desc);
+    rule_key_cpy(&item->key_l, key_l);
+    rule_key_cpy(&item->key_h, key_h);
+    item->src_id = src_id;
+
+    if (prev) {
+        item->next = prev->next;
+        rcu_assign_pointer(prev->next, item);
     } else {
         /* Add as the first item */
-        r->range_rule_list = item;
+        item->next = r->range_rule_list;
+        rcu_assign_pointer(r->range_rule_list, item);
     }
+    r->dirty = true;
     th_counter.type2_rules++;
+    hdl->entries++;
     return 1;
 }
 
@@ -414,14 +1754,14 @@ static int dpi_range_rule_del_one(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l,
     } else {
         r->range_rule_list = p->next;
     }
-    free(p);
+    mem_free(DP_MEM_POLICY, p);
     return 0;
 }
 */
 
 static int dpi_rule_add_one(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l,
                             dpi_rule_key_t *key_h, int dir, dpi_policy_desc_t *desc,
-                            dpi_policy_desc_t *exist_desc)
+                            dpi_policy_desc_t *exist_desc, uint32_t src_id)
 {
     if (key_h == NULL) {
         dpi_rule_t  *r;
@@ -437,20 +1777,22 @@ static int dpi_rule_add_one(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l,
             return 0;
         }
 
-        r = (dpi_rule_t *)calloc(1, sizeof(dpi_rule_t));
+        r = (dpi_rule_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(dpi_rule_t));
         if (!r) {
             DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
             return -1;
         }
         rule_key_cpy(&r->key, key_l);
         policy_desc_cpy(&r->desc, desc);
+        r->src_id = src_id;
         rcu_map_add(&hdl->policy_map, r, key_l);
         th_counter.type1_rules++;
+        hdl->entries++;
         return 1;
     } else {
         //DEBUG_POLICY("key_l " DP_RULE_STR "key_h " DP_RULE_STR DP_POLICY_DESC_STR "dir %d\n",
         //           DP_RULE_KEY(key_l), DP_RULE_KEY(key_h), DP_POLICY_DESC(desc), dir);
-        return dpi_range_rule_add(hdl, key_l, key_h, dir, desc, exist_desc);
+        return dpi_range_rule_add(hdl, key_l, key_h, dir, desc, exist_desc, src_id);
     }
 }
 
@@ -463,7 +1805,7 @@ int dpi_rule_del_one(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l, dpi_rule_key_
         DEBUG_POLICY("key_l " DP_RULE_STR "\n", DP_RULE_KEY(key_l));
         if (r) {
             rcu_map_del(&hdl->policy_map, r);
-            free(r);
+            mem_free(DP_MEM_POLICY, r);
         }
         return 0;
     } else {
@@ -502,7 +1844,34 @@ static int dpi_add_app_rule(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l, dpi_ru
     app_desc.hdl_ver = 0;
     app_desc.flags = desc->flags;
     app_desc.order = desc->order;
-    return dpi_rule_add_one(hdl, key_l, use_key?&key:key_h, dir, &app_desc, exist_desc);
+    return dpi_rule_add_one(hdl, key_l, use_key?&key:key_h, dir, &app_desc, exist_desc, desc->id);
+}
+
+static void dpi_policy_shadow_add(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l, dpi_rule_key_t *key_h,
+                                  int app_num, dpi_policy_app_rule_t *app_rules,
+                                  int dir, dpi_policy_desc_t *desc)
+{
+    dpi_policy_shadow_t *sh, **last;
+
+    sh = mem_malloc(DP_MEM_POLICY, sizeof(*sh) + sizeof(dpi_policy_app_rule_t) * app_num);
+    if (!sh) {
+        DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
+        return;
+    }
+    sh->next = NULL;
+    rule_key_cpy(&sh->key_l, key_l);
+    sh->range = key_h != NULL;
+    if (key_h) {
+        rule_key_cpy(&sh->key_h, key_h);
+    }
+    sh->dir = dir;
+    policy_desc_cpy(&sh->desc, desc);
+    sh->app_num = app_num;
+    if (app_num > 0) {
+        memcpy(sh->app_rules, app_rules, sizeof(dpi_policy_app_rule_t) * app_num);
+    }
+    for (last = &hdl->shadows; *last != NULL; last = &(*last)->next);
+    *last = sh;
 }
 
 int dpi_rule_add(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l, dpi_rule_key_t *key_h,
@@ -513,13 +1882,14 @@ int dpi_rule_add(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l, dpi_rule_key_t *k
     dpi_policy_desc_t exist_desc;
 
     memset(&exist_desc, 0, sizeof(exist_desc));
-    ret = dpi_rule_add_one(hdl, key_l, key_h, dir, desc, &exist_desc);
+    ret = dpi_rule_add_one(hdl, key_l, key_h, dir, desc, &exist_desc, desc->id);
     if (ret < 0) {
         return ret;
     } else if (ret == 0 && exist_desc.id > 0) {
         // If the exising rule is a check_app rule, it shouldn't override
         // the new rule
         if (exist_desc.action != DP_POLICY_ACTION_CHECK_APP) {
+            dpi_policy_shadow_add(hdl, key_l, key_h, app_num, app_rules, dir, desc);
             return ret;
         } else if (desc->action != DP_POLICY_ACTION_CHECK_APP) {
             // install an app any rule
@@ -559,7 +1929,12 @@ int dpi_rule_add(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key_l, dpi_rule_key_t *k
 
 static dpi_range_rule_item_t *dpi_range_rule_match(dpi_range_rule_t *r, dpi_rule_key_t *key)
 {
-    dpi_range_rule_item_t *item = r->range_rule_list;
+    dpi_range_rule_item_t *item = rcu_dereference(r->range_rule_list);
+    dpi_range_tree_t *tree = rcu_dereference(r->tree);
+
+    if (tree != NULL) {
+        return range_tree_lookup(tree, key);
+    }
     while (item) {
 /*
         DEBUG_POLICY("Found rule " DP_RULE_STR "-" DP_RULE_STR DP_POLICY_DESC_STR "%d\n",
@@ -569,14 +1944,14 @@ static dpi_range_rule_item_t *dpi_range_rule_match(dpi_range_rule_t *r, dpi_rule
         if (rule_key_in_range(item, key)) {
             break;
         } else {
-            item = item->next;
+            item = rcu_dereference(item->next);
         }
     }
     return item;
 }
 
-int dpi_policy_lookup(dpi_packet_t *p, dpi_policy_hdl_t *hdl, uint32_t app,
-                      bool to_server, bool xff, dpi_policy_desc_t *desc, uint32_t xff_replace_dst_ip)
+static int _dpi_policy_lookup(dpi_packet_t *p, dpi_policy_hdl_t *hdl, uint32_t app,
+                              bool to_server, bool xff, dpi_policy_desc_t *desc, uint32_t xff_replace_dst_ip)
 {
     struct iphdr *iph;
     int not_support = 0;
@@ -591,9 +1966,9 @@ int dpi_policy_lookup(dpi_packet_t *p, dpi_policy_hdl_t *hdl, uint32_t app,
     if (!xff) {
         memset(desc, 0, sizeof(dpi_policy_desc_t));
     }
-    /* only support ipv4 policy for now */
     switch (p->eth_type) {
     case ETH_P_IP:
+    case ETH_P_IPV6:
         break;
     default:
         not_support = 1;
@@ -621,18 +1996,33 @@ int dpi_policy_lookup(dpi_packet_t *p, dpi_policy_hdl_t *hdl, uint32_t app,
         goto exit;
     }
 
+    if (p->eth_type == ETH_P_IPV6) {
+        struct ip6_hdr *ip6h = (struct ip6_hdr *)(p->pkt + p->l3);
+
+        // x-forwarded-for is only taken for ipv4 sessions
+        if (xff) {
+            goto exit;
+        }
+        is_ingress = to_server?p->flags & DPI_PKT_FLAG_INGRESS:!(p->flags & DPI_PKT_FLAG_INGRESS);
+        dpi_policy6_lookup_by_key(hdl, to_server?&ip6h->ip6_src:&ip6h->ip6_dst,
+                                  to_server?&ip6h->ip6_dst:&ip6h->ip6_src,
+                                  dport, p->ip_proto, app, is_ingress, desc);
+        goto exit;
+    }
+
     iph = (struct iphdr *)(p->pkt + p->l3);
     sip = to_server?iph->saddr:iph->daddr;
     dip = to_server?iph->daddr:iph->saddr;
-    if (xff) {
-        if (sip != p->session->xff_client_ip) {
-            sip = p->session->xff_client_ip;
-            if (p->session->xff_port > 0) {
-                dport = p->session->xff_port;
+    if (xff && p->session->xff != NULL) {
+        dpi_session_xff_t *sxff = p->session->xff;
+        if (sip != sxff->client_ip) {
+            sip = sxff->client_ip;
+            if (sxff->port > 0) {
+                dport = sxff->port;
             } else {
                 //no x-forwarded-port in header
                 //use server port on workload
-                p->session->xff_port = dport;
+                sxff->port = dport;
             }
             DEBUG_POLICY("change dport to:%u, sip to x-forwarded-for:"DBG_IPV4_FORMAT"\n",dport, DBG_IPV4_TUPLE(sip));
             if (xff_replace_dst_ip > 0) {
@@ -726,6 +2116,53 @@ exit:
     return 0;
 }
 
+// Count a session under the rule that decided it, see dpi_policy_hits_t
+static void dpi_policy_hit(uint32_t id)
+{
+    dpi_policy_hits_t *h = &th_policy_hits;
+    uint32_t gen = CMM_LOAD_SHARED(g_policy_hit_gen);
+    uint32_t now = get_current_time();
+    uint32_t i, n;
+
+    if (unlikely(h->gen != gen)) {
+        memset(h->entries, 0, sizeof(h->entries));
+        h->overflow = 0;
+        cmm_smp_wmb();
+        CMM_STORE_SHARED(h->gen, gen);
+    }
+
+    i = (id * 2654435761u) >> (32 - DPI_POLICY_HIT_BITS);
+    for (n = 0; n < DPI_POLICY_HIT_PROBES; n ++, i = (i + 1) & (DPI_POLICY_HIT_SIZE - 1)) {
+        dpi_policy_hit_t *e = &h->entries[i];
+
+        if (e->hits == 0) {
+            e->id = id;
+            e->last = now;
+            cmm_smp_wmb();
+            CMM_STORE_SHARED(e->hits, 1);
+            return;
+        }
+        if (e->id == id) {
+            CMM_STORE_SHARED(e->last, now);
+            CMM_STORE_SHARED(e->hits, e->hits + 1);
+            return;
+        }
+    }
+    CMM_STORE_SHARED(h->overflow, h->overflow + 1);
+}
+
+int dpi_policy_lookup(dpi_packet_t *p, dpi_policy_hdl_t *hdl, uint32_t app,
+                      bool to_server, bool xff, dpi_policy_desc_t *desc, uint32_t xff_replace_dst_ip)
+{
+    uint64_t lat = dpi_lat_start();
+    int ret;
+
+    ret = _dpi_policy_lookup(p, hdl, app, to_server, xff, desc, xff_replace_dst_ip);
+    dpi_policy_hit(desc->id);
+    dpi_lat_stop(DP_LAT_POLICY, lat);
+    return ret;
+}
+
 static void _dpi_policy_chk_nbe(dpi_packet_t *p, uint32_t sip, uint32_t dip, int is_ingress, dpi_policy_hdl_t *hdl, dpi_policy_desc_t **pol_desc)
 {
     if (hdl == NULL || pol_desc == NULL) return;
@@ -813,7 +2250,7 @@ static void _dpi_policy_chk_unknown_ip(dpi_policy_hdl_t *hdl, uint32_t sip, uint
         iptype == DP_IPTYPE_HOSTIP ||
         iptype == DP_IPTYPE_TUNNELIP) {//unknown wl
         uint16_t thdl_ver = hdl?hdl->ver:0;
-        dpi_unknown_ip_cache_t *uip_cache = rcu_map_lookup(&th_unknown_ip_map, &uip_desc);
+        dpi_unknown_ip_cache_t *uip_cache = lookup_unknown_ip_cache(&uip_desc);
         if (uip_cache != NULL) {
             if (thdl_ver == uip_cache->desc.hdl_ver &&
                 th_snap.tick - uip_cache->start_hit < POLICY_DESC_VER_CHG_MAX) {
@@ -850,48 +2287,99 @@ static void _dpi_policy_chk_unknown_ip(dpi_policy_hdl_t *hdl, uint32_t sip, uint
     }
 }
 
-static int _dpi_policy_lookup_by_key(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key,
-                                     int is_ingress, dpi_policy_desc_t *desc)
+// Same as _dpi_policy_map_lookup() on the compiled rules
+static bool _dpi_policy_blob_lookup(const dpi_policy_blob_t *b, dpi_rule_key_t *key,
+                                    int is_ingress, dpi_policy_desc_t *desc)
+{
+    const dpi_policy_blob_rule_t *r;
+    const dpi_policy_blob_item_t *item;
+    dpi_range_rule_key_t key2;
+
+    if ((r = policy_blob_rule(b, key)) != NULL) {
+        policy_desc_cpy(desc, (dpi_policy_desc_t *)&r->desc);
+        return true;
+    }
+
+    memset(&key2, 0, sizeof(key2));
+    key2.proto = key->proto;
+    if (is_ingress) {
+        key2.flag = DP_RANGE_RULE_INGRESS;
+        key2.ip = key->dip;
+    } else {
+        key2.flag = DP_RANGE_RULE_EGRESS;
+        key2.ip = key->sip;
+    }
+    if ((item = policy_blob_range(b, &key2, key)) == NULL) {
+        key2.flag = 0;
+        key2.ip = 0;
+        item = policy_blob_range(b, &key2, key);
+    }
+    if (item != NULL) {
+        policy_desc_cpy(desc, (dpi_policy_desc_t *)&item->desc);
+        return true;
+    }
+    return false;
+}
+
+// Lookup on the rule maps of a handle that is not compiled
+static bool _dpi_policy_map_lookup(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key,
+                                   int is_ingress, dpi_policy_desc_t *desc)
 {
+    dpi_range_rule_key_t key2;
+    dpi_range_rule_t *r2;
+    dpi_range_rule_item_t *item;
     dpi_rule_t *r;
+
     r = rcu_map_lookup(&hdl->policy_map, key);
     if (r) {
         policy_desc_cpy(desc, &r->desc);
-        goto exit;
-    } else {
-        dpi_range_rule_key_t key2;
-        dpi_range_rule_t *r2;
-        dpi_range_rule_item_t *item;
+        return true;
+    }
 
-        memset(&key2, 0, sizeof(key2));
-        key2.proto = key->proto;
-        if (is_ingress) {
-            key2.flag = DP_RANGE_RULE_INGRESS;
-            key2.ip = key->dip;
-        } else {
-            key2.flag = DP_RANGE_RULE_EGRESS;
-            key2.ip = key->sip;
-        }
-        r2 = rcu_map_lookup(&hdl->range_policy_map, &key2);
-        if (r2) {
-            item = dpi_range_rule_match(r2, key);
-            if (item) {
-                policy_desc_cpy(desc, &item->desc);
-                goto exit;
-            }
+    memset(&key2, 0, sizeof(key2));
+    key2.proto = key->proto;
+    if (is_ingress) {
+        key2.flag = DP_RANGE_RULE_INGRESS;
+        key2.ip = key->dip;
+    } else {
+        key2.flag = DP_RANGE_RULE_EGRESS;
+        key2.ip = key->sip;
+    }
+    r2 = rcu_map_lookup(&hdl->range_policy_map, &key2);
+    if (r2) {
+        item = dpi_range_rule_match(r2, key);
+        if (item) {
+            policy_desc_cpy(desc, &item->desc);
+            return true;
         }
+    }
 
-        /* match no direction rule */
-        key2.flag = 0;
-        key2.ip = 0;
-        r2 = rcu_map_lookup(&hdl->range_policy_map, &key2);
-        if (r2) {
-            item = dpi_range_rule_match(r2, key);
-            if (item) {
-                policy_desc_cpy(desc, &item->desc);
-                goto exit;
-            }
+    /* match no direction rule */
+    key2.flag = 0;
+    key2.ip = 0;
+    r2 = rcu_map_lookup(&hdl->range_policy_map, &key2);
+    if (r2) {
+        item = dpi_range_rule_match(r2, key);
+        if (item) {
+            policy_desc_cpy(desc, &item->desc);
+            return true;
         }
+    }
+    return false;
+}
+
+static int _dpi_policy_lookup_by_key(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key,
+                                     int is_ingress, dpi_policy_desc_t *desc)
+{
+    dpi_policy_blob_t *blob = rcu_dereference(hdl->blob);
+    bool found;
+
+    if (likely(blob != NULL)) {
+        found = _dpi_policy_blob_lookup(blob, key, is_ingress, desc);
+    } else {
+        found = _dpi_policy_map_lookup(hdl, key, is_ingress, desc);
+    }
+    if (!found) {
         /* match not found */
         desc->id = 0;
         desc->action = hdl->def_action;
@@ -899,7 +2387,6 @@ static int _dpi_policy_lookup_by_key(dpi_policy_hdl_t *hdl, dpi_rule_key_t *key,
         desc->order = 0xffffffff;
         desc->hdl_ver = 0;
     }
-exit:
     DEBUG_POLICY(" key:" DP_RULE_STR "match: " DP_POLICY_DESC_STR "\n",
                  DP_RULE_KEY(key), DP_POLICY_DESC(desc));
     return 0;
@@ -921,9 +2408,9 @@ static bool _dpi_is_chk_nbe(dpi_packet_t *p)
         memcpy((desc1), (desc2), sizeof(dpi_policy_desc_t)); \
     }
 
-static int dpi_policy_lookup_by_key(dpi_policy_hdl_t *hdl, uint32_t sip, uint32_t dip,
-                                    uint16_t dport, uint16_t proto, uint32_t app,
-                                    int is_ingress, dpi_policy_desc_t *desc, dpi_packet_t *p)
+static int dpi_policy_match_by_key(dpi_policy_hdl_t *hdl, uint32_t sip, uint32_t dip,
+                                   uint16_t dport, uint16_t proto, uint32_t app,
+                                   int is_ingress, dpi_policy_desc_t *desc, dpi_packet_t *p)
 {
     dpi_rule_key_t key;
     bool is_nbe = _dpi_is_chk_nbe(p);
@@ -1105,6 +2592,114 @@ exit:
     return 0;
 }
 
+/*
+ * -----------------------------------------------------
+ * --- policy decision cache ----------------------------
+ * -----------------------------------------------------
+ */
+// Besides the handle, a decision depends on the internal and special ip subnets, the fqdn ip
+// map and a few global switches. Whoever changes them bumps the generation once the change
+// is visible to the dp threads. Handles with fqdn rules are not cached, their decision also
+// depends on the session's virtual host.
+static uint32_t g_policy_cache_gen = 0;
+
+void dpi_policy_cache_invalidate(void)
+{
+    uatomic_inc(&g_policy_cache_gen);
+}
+
+static inline uint32_t policy_cache_hash(uint32_t sip, uint32_t dip, uint16_t dport,
+                                         uint16_t proto, uint32_t app)
+{
+    uint32_t h = sip * 0x9e3779b1u;
+
+    h ^= dip + 0x7f4a7c15u + (h << 6) + (h >> 2);
+    h ^= (((uint32_t)dport << 16) | proto) + (h << 6) + (h >> 2);
+    h ^= app + (h << 6) + (h >> 2);
+    return h ^ (h >> 16);
+}
+
+static int dpi_policy_lookup_by_key(dpi_policy_hdl_t *hdl, uint32_t sip, uint32_t dip,
+                                    uint16_t dport, uint16_t proto, uint32_t app,
+                                    int is_ingress, dpi_policy_desc_t *desc, dpi_packet_t *p)
+{
+    dpi_policy_cache_t *cache;
+    dpi_policy_cache_entry_t *e;
+    uint32_t gen;
+    uint8_t flags;
+
+    // Lookups from the config path have no packet
+    if (p == NULL || unlikely(!hdl || th_disable_net_policy) || DPI_POLICY_HAS_FQDN(hdl) ||
+        THREAD_ID < 0 || THREAD_ID >= MAX_DP_THREADS) {
+        return dpi_policy_match_by_key(hdl, sip, dip, dport, proto, app, is_ingress, desc, p);
+    }
+
+    cache = hdl->cache[THREAD_ID];
+    if (unlikely(cache == NULL)) {
+        cache = hdl->cache[THREAD_ID] = mem_calloc(DP_MEM_POLICY, 1, sizeof(dpi_policy_cache_t));
+        if (cache == NULL) {
+            return dpi_policy_match_by_key(hdl, sip, dip, dport, proto, app, is_ingress, desc, p);
+        }
+    }
+
+    flags = POLICY_CACHE_VALID;
+    if (is_ingress) {
+        flags |= POLICY_CACHE_INGRESS;
+    }
+    if (_dpi_is_chk_nbe(p)) {
+        flags |= POLICY_CACHE_NBE;
+    }
+    gen = CMM_LOAD_SHARED(g_policy_cache_gen);
+    cmm_smp_rmb();
+
+    e = &cache->entry[policy_cache_hash(sip, dip, dport, proto, app) & (DPI_POLICY_CACHE_SIZE - 1)];
+    if (e->flags == flags && e->sip == sip && e->dip == dip && e->dport == dport &&
+        e->proto == proto && e->app == app && e->gen == gen && e->desc.hdl_ver == hdl->ver) {
+        policy_desc_cpy(desc, &e->desc);
+        th_counter.policy_cache_hits++;
+        return 0;
+    }
+
+    th_counter.policy_cache_misses++;
+    dpi_policy_match_by_key(hdl, sip, dip, dport, proto, app, is_ingress, desc, p);
+
+    e->sip = sip;
+    e->dip = dip;
+    e->app = app;
+    e->dport = dport;
+    e->proto = proto;
+    e->flags = flags;
+    e->gen = gen;
+    policy_desc_cpy(&e->desc, desc);
+    return 0;
+}
+
+// As with the decision cache, a decision of a handle with fqdn rules also depends on the
+// virtual host of the request
+static bool xff_eval_current(const dpi_packet_t *p, const dpi_session_xff_t *sxff, const dpi_policy_hdl_t *hdl)
+{
+    if (hdl != NULL && DPI_POLICY_HAS_FQDN(hdl)) {
+        return false;
+    }
+    return sxff->eval_valid && sxff->eval_ip == sxff->client_ip &&
+           sxff->eval_port == sxff->port && sxff->eval_app == sxff->app &&
+           sxff->eval_hdl == hdl && sxff->eval_hdl_ver == (hdl != NULL ? hdl->ver : 0) &&
+           sxff->eval_ep_ver == p->ep->policy_ver &&
+           sxff->eval_gen == CMM_LOAD_SHARED(g_policy_cache_gen);
+}
+
+static void xff_eval_save(const dpi_packet_t *p, dpi_session_xff_t *sxff, const dpi_policy_hdl_t *hdl, uint32_t gen)
+{
+    sxff->eval_valid = true;
+    sxff->eval_ip = sxff->client_ip;
+    sxff->eval_port = sxff->port;
+    sxff->eval_app = sxff->app;
+    sxff->eval_hdl = hdl;
+    sxff->eval_hdl_ver = hdl != NULL ? hdl->ver : 0;
+    sxff->eval_ep_ver = p->ep->policy_ver;
+    sxff->eval_gen = gen;
+}
+
 static void * get_parent_policy_hdl(struct ether_addr *pmac)
 {
     io_ep_t *pep;
@@ -1133,8 +2728,9 @@ int dpi_policy_reeval(dpi_packet_t *p, bool to_server)
     uint32_t old_rule_id = s->policy_desc.id;
     dpi_policy_hdl_t *hdl = (dpi_policy_hdl_t *)p->ep->policy_hdl;
     bool xff = false;
-    uint8_t old_xff_action = s->xff_desc.action;
-    uint32_t old_xff_rule_id = s->xff_desc.id;
+    dpi_session_xff_t *sxff = s->xff;
+    uint8_t old_xff_action = dpi_session_xff(s)->desc.action;
+    uint32_t old_xff_rule_id = dpi_session_xff(s)->desc.id;
 
     if (unlikely((s->policy_desc.hdl_ver != p->ep->policy_ver) &&
         (s->policy_desc.flags & POLICY_DESC_UNKNOWN_IP))) {
@@ -1143,7 +2739,8 @@ int dpi_policy_reeval(dpi_packet_t *p, bool to_server)
     }
 
     if (unlikely((s->policy_desc.hdl_ver != p->ep->policy_ver) &&
-        (s->policy_desc.flags & POLICY_DESC_CHECK_VER))) {
+        (s->policy_desc.flags & POLICY_DESC_CHECK_VER)) &&
+        !dpi_sess_policy_scope_check(s, p->ep)) {
         dpi_policy_lookup(p, hdl, 0, to_server, xff, &s->policy_desc, 0);
         policy_eval = 1;
     }
@@ -1173,7 +2770,7 @@ int dpi_policy_reeval(dpi_packet_t *p, bool to_server)
             iph->daddr == htonl(INADDR_LOOPBACK) || IS_IN_LOOPBACK(ntohl(iph->daddr)) ||
             iph->saddr == htonl(INADDR_LOOPBACK) || IS_IN_LOOPBACK(ntohl(iph->saddr))) {
         } else {
-            bool isproxymesh = cmp_mac_prefix(p->ep_mac, PROXYMESH_MAC_PREFIX);
+            bool isproxymesh = FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) ? true : false;
             dpi_policy_hdl_t *phdl;
             if (isproxymesh && p->ep) {
                 phdl = (dpi_policy_hdl_t *)get_parent_policy_hdl(&p->ep->pmac);
@@ -1197,13 +2794,13 @@ int dpi_policy_reeval(dpi_packet_t *p, bool to_server)
     //use original client ip saved in X-Forwarded-For header to match policy
     //this is used to detect traffic from router/ingress via loadbalancer
     if(unlikely(th_xff_enabled && FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS) &&
-        FLAGS_TEST(s->flags, DPI_SESS_FLAG_XFF))) {
+        FLAGS_TEST(s->flags, DPI_SESS_FLAG_XFF) && sxff != NULL)) {
         //for proxymesh traffic monitored from 'lo' i/f, policy match for
         //XFF traffic needs to be done on proxymesh's original mac
         struct iphdr *iph;
         uint32_t dip;
         bool dstlo = false;
-        bool isproxymesh = cmp_mac_prefix(p->ep_mac, PROXYMESH_MAC_PREFIX);
+        bool isproxymesh = FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) ? true : false;
         dpi_policy_hdl_t *phdl;
         if (isproxymesh && p->ep) {
             phdl = (dpi_policy_hdl_t *)get_parent_policy_hdl(&p->ep->pmac);
@@ -1215,43 +2812,49 @@ int dpi_policy_reeval(dpi_packet_t *p, bool to_server)
             dstlo = IS_IN_LOOPBACK(ntohl(dip));
         }
         xff = true;
-        if (s->xff_app == 0) {
+        if (sxff->app == 0) {
             //no X-Forwarded-Proto in header
-            s->xff_app = s->app?s->app:(s->base_app?s->base_app:(uint16_t)(DP_POLICY_APP_UNKNOWN));
-        }
-        if (dstlo) {
-            //in service mesh's case, if dst ip is lo ip we need to
-            //use its parent container's ip to replace dst ip for policy
-            //match, most container has just 1 IP, technically it can have
-            //more, once we see violation we break out loop
-            int idx;
-            if (p->ep && p->ep->pips) {
-                for (idx = 0; idx < p->ep->pips->count; idx++) {
-                    dpi_policy_lookup(p, hdl, 0, to_server, xff, &s->xff_desc, p->ep->pips->list[idx].ip);
-                    if (unlikely((s->xff_desc.action == DP_POLICY_ACTION_CHECK_APP))) {
-                        dpi_policy_lookup(p, hdl, s->xff_app, to_server, xff, &s->xff_desc, p->ep->pips->list[idx].ip);
-                    }
-                    if (DPI_POLICY_LOG_VIOLATE(s->xff_desc.action)) {
-                        break;
+            sxff->app = s->app?s->app:(s->base_app?s->base_app:(uint16_t)(DP_POLICY_APP_UNKNOWN));
+        }
+        //keep-alive requests from the same client, and the other packets of
+        //the session, keep the decision until the policy changes
+        if (!xff_eval_current(p, sxff, hdl)) {
+            uint32_t gen = CMM_LOAD_SHARED(g_policy_cache_gen);
+            if (dstlo) {
+                //in service mesh's case, if dst ip is lo ip we need to
+                //use its parent container's ip to replace dst ip for policy
+                //match, most container has just 1 IP, technically it can have
+                //more, once we see violation we break out loop
+                int idx;
+                if (p->ep && p->ep->pips) {
+                    for (idx = 0; idx < p->ep->pips->count; idx++) {
+                        dpi_policy_lookup(p, hdl, 0, to_server, xff, &sxff->desc, p->ep->pips->list[idx].ip);
+                        if (unlikely((sxff->desc.action == DP_POLICY_ACTION_CHECK_APP))) {
+                            dpi_policy_lookup(p, hdl, sxff->app, to_server, xff, &sxff->desc, p->ep->pips->list[idx].ip);
+                        }
+                        if (DPI_POLICY_LOG_VIOLATE(sxff->desc.action)) {
+                            break;
+                        }
                     }
                 }
+            } else {
+                dpi_policy_lookup(p, hdl, 0, to_server, xff, &sxff->desc, 0);
+                if (unlikely((sxff->desc.action == DP_POLICY_ACTION_CHECK_APP))) {
+                    dpi_policy_lookup(p, hdl, sxff->app, to_server, xff, &sxff->desc, 0);
+                }
             }
-        } else {
-            dpi_policy_lookup(p, hdl, 0, to_server, xff, &s->xff_desc, 0);
-            if (unlikely((s->xff_desc.action == DP_POLICY_ACTION_CHECK_APP))) {
-                dpi_policy_lookup(p, hdl, s->xff_app, to_server, xff, &s->xff_desc, 0);
-            }
+            xff_eval_save(p, sxff, hdl, gen);
+            policy_eval = 1;
         }
-        policy_eval = 1;
     }
 
     if (policy_eval) {
         if (xff) {
             bool chg = false;
             log_violate = DPI_POLICY_LOG_VIOLATE(s->policy_desc.action);
-            log_violate += DPI_POLICY_LOG_VIOLATE(s->xff_desc.action);
-            if ((old_xff_action != s->xff_desc.action) ||
-                (old_xff_rule_id != s->xff_desc.id)) {
+            log_violate += DPI_POLICY_LOG_VIOLATE(sxff->desc.action);
+            if ((old_xff_action != sxff->desc.action) ||
+                (old_xff_rule_id != sxff->desc.id)) {
                 FLAGS_SET(p->flags, DPI_PKT_FLAG_LOG_XFF);
                 chg = true;
             }
@@ -1281,6 +2884,44 @@ int dpi_policy_reeval(dpi_packet_t *p, bool to_server)
 }
 
 // Session reeval returns 1 if action changes and is violate or deny
+// Move a session to the current policy version without a lookup if the change from the version
+// it was decided with can't affect its proto and port. Returns true if it is up to date.
+bool dpi_sess_policy_scope_check(dpi_session_t *s, io_ep_t *ep)
+{
+    dpi_policy_desc_t *desc = &s->policy_desc;
+    dpi_policy_hdl_t *hdl = (dpi_policy_hdl_t *)ep->policy_hdl;
+    dpi_policy_scope_t *sc;
+    uint16_t dport = s->server.port;
+    int i;
+
+    if (desc->hdl_ver == ep->policy_ver) {
+        return true;
+    }
+    // Decisions not made by the rules alone
+    if ((desc->flags & (POLICY_DESC_CHECK_VER | POLICY_DESC_UNKNOWN_IP | POLICY_DESC_MESH_TO_SVR)) !=
+        POLICY_DESC_CHECK_VER || FLAGS_TEST(s->flags, DPI_SESS_FLAG_XFF) || hdl == NULL) {
+        return false;
+    }
+
+    sc = rcu_dereference(hdl->scope);
+    if (sc == NULL || sc->from_ver != desc->hdl_ver || hdl->ver != ep->policy_ver) {
+        return false;
+    }
+    if (s->ip_proto == IPPROTO_ICMP) {
+        dport = 0;
+    }
+    for (i = 0; i < sc->count; i ++) {
+        if ((sc->ports[i].proto == 0 || sc->ports[i].proto == s->ip_proto) &&
+            dport >= sc->ports[i].port_lo && dport <= sc->ports[i].port_hi) {
+            return false;
+        }
+    }
+
+    desc->hdl_ver = ep->policy_ver;
+    th_counter.policy_reeval_skips ++;
+    return true;
+}
+
 int dpi_sess_policy_reeval(dpi_session_t *s)
 {
     int policy_eval = 0;
@@ -1295,6 +2936,7 @@ int dpi_sess_policy_reeval(dpi_session_t *s)
     uint8_t old_action = s->policy_desc.action;
     uint32_t old_rule_id = s->policy_desc.id;
     dpi_policy_hdl_t *hdl;
+    bool is_ipv6;
 
     if (!(s->policy_desc.flags & POLICY_DESC_CHECK_VER)) {
         return 0;
@@ -1314,11 +2956,17 @@ int dpi_sess_policy_reeval(dpi_session_t *s)
     dport = s->server.port;
     proto = s->ip_proto;
     hdl = (dpi_policy_hdl_t *)ep->policy_hdl;
+    is_ipv6 = !(s->flags & DPI_SESS_FLAG_IPV4);
 
     if (unlikely((s->policy_desc.hdl_ver != ep->policy_ver) &&
         (s->policy_desc.flags & POLICY_DESC_CHECK_VER))) {
-        dpi_policy_lookup_by_key(hdl, sip, dip, dport,
-                                 proto, 0, is_ingress, &s->policy_desc, NULL);
+        if (is_ipv6) {
+            dpi_policy6_lookup_by_key(hdl, &s->client.ip.ip6, &s->server.ip.ip6, dport,
+                                      proto, 0, is_ingress, &s->policy_desc);
+        } else {
+            dpi_policy_lookup_by_key(hdl, sip, dip, dport,
+                                     proto, 0, is_ingress, &s->policy_desc, NULL);
+        }
         policy_eval = 1;
     }
 
@@ -1326,8 +2974,13 @@ int dpi_sess_policy_reeval(dpi_session_t *s)
         FLAGS_TEST(s->flags, DPI_SESS_FLAG_POLICY_APP_READY))) {
         app = s->app?s->app:(s->base_app?s->base_app:DP_POLICY_APP_UNKNOWN);
         //use 0xffffffff to indicate app cannot be identified
-        dpi_policy_lookup_by_key(hdl, sip, dip, dport,
-                                 proto, app, is_ingress, &s->policy_desc, NULL);
+        if (is_ipv6) {
+            dpi_policy6_lookup_by_key(hdl, &s->client.ip.ip6, &s->server.ip.ip6, dport,
+                                      proto, app, is_ingress, &s->policy_desc);
+        } else {
+            dpi_policy_lookup_by_key(hdl, sip, dip, dport,
+                                     proto, app, is_ingress, &s->policy_desc, NULL);
+        }
         policy_eval = 1;
     }
 
@@ -1342,68 +2995,581 @@ int dpi_sess_policy_reeval(dpi_session_t *s)
         }
     }
 
-    return log_violate;
+    return log_violate;
+}
+
+/*-----------------------------------------------------------*
+ *------------- Policy config -------------------------------*
+ *-----------------------------------------------------------*/
+static uint16_t policy_ver = 0;
+#define GET_NEW_POLICY_VER()  ((++policy_ver)?policy_ver:(++policy_ver))
+
+/*
+static void dpi_policy_set_session_reeval()
+{
+    struct cds_lfht_node *node;
+    struct cds_lfht_iter iter;
+    uint16_t new_policy_ver = GET_NEW_POLICY_VER();
+    RCU_MAP_ITR_FOR_EACH(&g_ep_map, iter, node) {
+        io_mac_t *mac = STRUCT_OF(node, io_mac_t, node);
+        if (mac->broadcast || mac->unicast) continue;
+        io_ep_t *ep = mac->ep;
+        if (ep->policy_hdl) {
+            ep->policy_ver = new_policy_ver;
+            ((dpi_policy_hdl_t *)ep->policy_hdl)->ver = ep->policy_ver;
+        }
+    }
+    DEBUG_POLICY("new policy ver: %d\n", new_policy_ver);
+}
+*/
+
+static void policy_hdl_reclaim(void *ptr)
+{
+    dpi_policy_hdl_destroy(ptr);
+}
+
+int dpi_policy_update(struct ether_addr *mac_addr, dpi_policy_hdl_t *hdl)
+{
+    void *buf;
+    io_ep_t *ep;
+    dpi_policy_hdl_t *old;
+
+    if (!mac_addr) {
+        return -1;
+    }
+    rcu_read_lock();
+    buf = rcu_map_lookup(&g_ep_map, mac_addr);
+    if (!buf) {
+        rcu_read_unlock();
+        DEBUG_POLICY("cannot find mac: "DBG_MAC_FORMAT "\n", DBG_MAC_TUPLE(*mac_addr));
+        return -1;
+    }
+    ep = GET_EP_FROM_MAC_MAP(buf);
+
+    old = (dpi_policy_hdl_t *)ep->policy_hdl;
+    if (hdl) {
+        hdl->ref_cnt++;
+    }
+    ep->policy_hdl = (void *)hdl;
+    ep->policy_ver = hdl?hdl->ver:0;
+    rcu_read_unlock();
+
+    if (old) {
+        if (old->ref_cnt < 2) {
+            // Unshared here so that no endpoint picks it up again, freed once the dp
+            // threads are out of it
+            dpi_policy_hdl_unshare(old);
+            dp_reclaim_defer(policy_hdl_reclaim, old);
+        } else {
+            dpi_policy_hdl_destroy(old);
+        }
+    }
+    DEBUG_POLICY("mac: "DBG_MAC_FORMAT" policy hdl %p ver %u done\n",
+               DBG_MAC_TUPLE(*mac_addr), hdl, ep->policy_ver);
+    return 0;
+}
+
+// Add a configured rule after the rules of the handle. Returns the number of entries added.
+static int dpi_policy_add_rule(dpi_policy_hdl_t *hdl, dpi_policy_rule_t *rule)
+{
+    uint32_t entries = hdl->entries;
+    dpi_rule_key_t key;
+    dpi_policy_desc_t desc;
+    int dir;
+    memset(&key, 0, sizeof(key));
+    memset(&desc, 0, sizeof(desc));
+
+    if (rule->fqdn[0] != '\0') {
+       uint32_t code;
+       if (rule->ingress) {
+           rcu_read_lock();
+           code = config_fqdn_ipv4_mapping(g_fqdn_hdl,
+                    rule->fqdn, rule->sip, rule->vh);
+           rcu_read_unlock();
+           if (code == -1) {
+               hdl->flag |= POLICY_HDL_FLAG_NOSHARE;
+               return 0;
+           }
+           rule->sip = code;
+           rule->sip_r = code;
+       } else {
+           rcu_read_lock();
+           code = config_fqdn_ipv4_mapping(g_fqdn_hdl,
+                    rule->fqdn, rule->dip, rule->vh);
+           rcu_read_unlock();
+           if (code == -1) {
+               hdl->flag |= POLICY_HDL_FLAG_NOSHARE;
+               return 0;
+           }
+           rule->dip = code;
+           rule->dip_r = code;
+       }
+       fqdn_code_set(hdl->fqdn_codes, code);
+       hdl->fqdn_words = max(hdl->fqdn_words, DPI_FQDN_CODE_BIT(code) / 32 + 1);
+       hdl->flag |= POLICY_HDL_FLAG_FQDN;
+    }
+
+    key.sip = rule->sip;
+    key.dip = rule->dip;
+    key.dport = rule->dport;
+    key.proto =  rule->proto;
+    desc.id = rule->id;
+    desc.action = rule->action;
+    desc.flags = POLICY_DESC_CHECK_VER;
+    desc.order = ++hdl->order;
+    dir = rule->ingress?POLICY_RULE_DIR_INGRESS:POLICY_RULE_DIR_EGRESS;
+
+    if (key.dport != rule->dport_r || key.sip != rule->sip_r ||
+            key.dip != rule->dip_r) {
+        dpi_rule_key_t key_r;
+        memcpy(&key_r, &key, sizeof(dpi_rule_key_t));
+        key_r.dport = rule->dport_r;
+        key_r.sip = rule->sip_r;
+        key_r.dip = rule->dip_r;
+        if (key.proto > 0) {
+            dpi_rule_add(hdl, &key, &key_r,
+                         rule->num_apps,rule->app_rules,
+                         dir, &desc);
+        } else {
+            key.proto = key_r.proto = IPPROTO_TCP;
+            dpi_rule_add(hdl, &key, &key_r,
+                         rule->num_apps,rule->app_rules,
+                         dir, &desc);
+            key.proto = key_r.proto = IPPROTO_UDP;
+            dpi_rule_add(hdl, &key, &key_r,
+                         rule->num_apps,rule->app_rules,
+                         dir, &desc);
+            if (g_enable_icmp_policy) {
+                key.proto = key_r.proto = IPPROTO_ICMP;
+                dpi_rule_add(hdl, &key, &key_r,
+                            rule->num_apps,rule->app_rules,
+                            dir, &desc);
+            }
+        }
+    } else {
+        if (key.proto > 0) {
+            dpi_rule_add(hdl, &key, NULL,
+                         rule->num_apps,rule->app_rules,
+                         dir, &desc);
+        } else {
+            key.proto = IPPROTO_TCP;
+            dpi_rule_add(hdl, &key, NULL,
+                         rule->num_apps,rule->app_rules,
+                         dir, &desc);
+            key.proto = IPPROTO_UDP;
+            dpi_rule_add(hdl, &key, NULL,
+                         rule->num_apps,rule->app_rules,
+                         dir, &desc);
+            if (g_enable_icmp_policy) {
+                key.proto = IPPROTO_ICMP;
+                dpi_rule_add(hdl, &key, NULL,
+                            rule->num_apps,rule->app_rules,
+                            dir, &desc);
+            }
+        }
+    }
+    return hdl->entries - entries;
+}
+
+/*
+ * -----------------------------------------------------
+ * --- policy deltas ------------------------------------
+ * -----------------------------------------------------
+ */
+// A delta deletes the rules of some ids and adds rules after the existing ones. It is applied in
+// place if the workloads of the message are the only users of their handle, otherwise to a copy
+// that replaces the handle for them. The version only changes if a rule entry was removed or an
+// added rule can decide differently from the default action, sessions are re-evaluated then.
+typedef struct policy_del_ctx_ {
+    dpi_policy_hdl_t *hdl;
+    uint32_t *ids;              // sorted
+    int count;
+    policy_trash_t **trash;
+    dpi_policy_scope_t *scope;
+} policy_del_ctx_t;
+
+// Bumped when a policy change comes with a scope, dp threads sweep their sessions then
+uint32_t g_policy_scope_seq = 0;
+
+static void policy_scope_add(dpi_policy_scope_t *sc, uint16_t proto, uint16_t lo, uint16_t hi)
+{
+    int i;
+
+    if (sc == NULL || sc->all) {
+        return;
+    }
+    for (i = 0; i < sc->count; i ++) {
+        if (sc->ports[i].proto == proto &&
+            lo <= sc->ports[i].port_hi + 1 && hi + 1 >= sc->ports[i].port_lo) {
+            sc->ports[i].port_lo = min(sc->ports[i].port_lo, lo);
+            sc->ports[i].port_hi = max(sc->ports[i].port_hi, hi);
+            return;
+        }
+    }
+    if (sc->count == POLICY_SCOPE_MAX) {
+        sc->all = true;
+        return;
+    }
+    sc->ports[i].proto = proto;
+    sc->ports[i].port_lo = lo;
+    sc->ports[i].port_hi = hi;
+    sc->count ++;
+}
+
+static int rule_id_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static bool policy_del_match(policy_del_ctx_t *ctx, uint32_t id)
+{
+    return bsearch(&id, ctx->ids, ctx->count, sizeof(uint32_t), rule_id_cmp) != NULL;
+}
+
+static bool iter_delete_rule_by_id(struct cds_lfht_node *ht_node, void *args)
+{
+    policy_del_ctx_t *ctx = args;
+    dpi_rule_t *r = (dpi_rule_t *)ht_node;
+
+    if (policy_del_match(ctx, r->src_id)) {
+        policy_scope_add(ctx->scope, r->key.proto, r->key.dport, r->key.dport);
+        rcu_map_del(&ctx->hdl->policy_map, r);
+        policy_trash_put(ctx->trash, r, false);
+        th_counter.type1_rules--;
+        ctx->hdl->entries--;
+    }
+    return false;
+}
+
+static bool iter_delete_range_rule_by_id(struct cds_lfht_node *ht_node, void *args)
+{
+    policy_del_ctx_t *ctx = args;
+    dpi_range_rule_t *r = (dpi_range_rule_t *)ht_node;
+    dpi_range_rule_item_t **pp = &r->range_rule_list, *p;
+
+    while ((p = *pp) != NULL) {
+        if (policy_del_match(ctx, p->src_id)) {
+            policy_scope_add(ctx->scope, p->key_l.proto, p->key_l.dport, p->key_h.dport);
+            rcu_assign_pointer(*pp, p->next);
+            policy_trash_put(ctx->trash, p, false);
+            r->dirty = true;
+            th_counter.type2_rules--;
+            ctx->hdl->entries--;
+        } else {
+            pp = &p->next;
+        }
+    }
+    return false;
+}
+
+// The ids are sorted. Returns the number of entries removed. The shadowed rules are added again,
+// they can be uncovered now.
+static int dpi_policy_del_rules(dpi_policy_hdl_t *hdl, uint32_t *ids, int count,
+                                policy_trash_t **trash, dpi_policy_scope_t *scope)
+{
+    policy_del_ctx_t ctx;
+    dpi_policy_shadow_t *sh, *shadows;
+    uint32_t entries = hdl->entries;
+
+    ctx.hdl = hdl;
+    ctx.ids = ids;
+    ctx.count = count;
+    ctx.trash = trash;
+    ctx.scope = scope;
+
+    rcu_map_for_each(&hdl->policy_map, iter_delete_rule_by_id, &ctx);
+    rcu_map_for_each(&hdl->range_policy_map, iter_delete_range_rule_by_id, &ctx);
+    if (hdl->entries == entries) {
+        return 0;
+    }
+
+    shadows = hdl->shadows;
+    hdl->shadows = NULL;
+    for (sh = shadows; sh != NULL; sh = sh->next) {
+        if (!policy_del_match(&ctx, sh->desc.id)) {
+            dpi_rule_add(hdl, &sh->key_l, sh->range ? &sh->key_h : NULL,
+                         sh->app_num, sh->app_rules, sh->dir, &sh->desc);
+        }
+    }
+    dpi_policy_shadow_free(shadows);
+    return entries - hdl->entries;
+}
+
+static bool iter_copy_rule(struct cds_lfht_node *ht_node, void *args)
+{
+    dpi_policy_hdl_t *hdl = args;
+    dpi_rule_t *r = (dpi_rule_t *)ht_node, *n;
+
+    if ((n = mem_malloc(DP_MEM_POLICY, sizeof(*n))) == NULL) {
+        DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
+        return true;
+    }
+    memcpy(n, r, sizeof(*n));
+    rcu_map_add(&hdl->policy_map, n, &n->key);
+    th_counter.type1_rules++;
+    hdl->entries++;
+    return false;
+}
+
+static bool iter_copy_range_rule(struct cds_lfht_node *ht_node, void *args)
+{
+    dpi_policy_hdl_t *hdl = args;
+    dpi_range_rule_t *r = (dpi_range_rule_t *)ht_node, *n;
+    dpi_range_rule_item_t *p, *item, **last;
+
+    if ((n = mem_calloc(DP_MEM_POLICY, 1, sizeof(*n))) == NULL) {
+        DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
+        return true;
+    }
+    range_rule_key_cpy(&n->key, &r->key);
+    n->dirty = true;
+    rcu_map_add(&hdl->range_policy_map, n, &n->key);
+
+    last = &n->range_rule_list;
+    for (p = r->range_rule_list; p != NULL; p = p->next) {
+        if ((item = mem_malloc(DP_MEM_POLICY, sizeof(*item))) == NULL) {
+            DEBUG_ERROR(DBG_POLICY, "OOM 2!!!\n");
+            return true;
+        }
+        memcpy(item, p, sizeof(*item));
+        item->next = NULL;
+        *last = item;
+        last = &item->next;
+        th_counter.type2_rules++;
+        hdl->entries++;
+    }
+    return false;
+}
+
+static bool iter_copy_rule6(struct cds_lfht_node *ht_node, void *args)
+{
+    dpi_policy_hdl_t *hdl = args;
+    dpi_rule6_t *r = STRUCT_OF(ht_node, dpi_rule6_t, node), *n;
+
+    if ((n = mem_malloc(DP_MEM_POLICY, sizeof(*n))) == NULL) {
+        DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
+        return true;
+    }
+    memcpy(n, r, sizeof(*n));
+    rcu_map_add(&hdl->policy6_map, n, &n->key);
+    th_counter.type1_rules++;
+    hdl->entries++;
+    return false;
+}
+
+static bool iter_copy_range_rule6(struct cds_lfht_node *ht_node, void *args)
+{
+    dpi_policy_hdl_t *hdl = args;
+    dpi_range_rule6_t *r = STRUCT_OF(ht_node, dpi_range_rule6_t, node), *n;
+    dpi_range_rule6_item_t *p, *item, **last;
+
+    if ((n = mem_calloc(DP_MEM_POLICY, 1, sizeof(*n))) == NULL) {
+        DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
+        return true;
+    }
+    memcpy(&n->key, &r->key, sizeof(n->key));
+    rcu_map_add(&hdl->range_policy6_map, n, &n->key);
+
+    last = &n->range_rule_list;
+    for (p = r->range_rule_list; p != NULL; p = p->next) {
+        if ((item = mem_malloc(DP_MEM_POLICY, sizeof(*item))) == NULL) {
+            DEBUG_ERROR(DBG_POLICY, "OOM 2!!!\n");
+            return true;
+        }
+        memcpy(item, p, sizeof(*item));
+        item->next = NULL;
+        *last = item;
+        last = &item->next;
+        th_counter.type2_rules++;
+        hdl->entries++;
+    }
+    return false;
+}
+
+// Copy the rules of a handle, the copy has no user yet
+static dpi_policy_hdl_t *dpi_policy_hdl_copy(dpi_policy_hdl_t *hdl)
+{
+    dpi_policy_hdl_t *n = dpi_policy_hdl_init(hdl->def_action);
+    dpi_policy_shadow_t *sh, **last;
+    uint32_t entries;
+
+    if (n == NULL) {
+        return NULL;
+    }
+    n->ver = hdl->ver;
+    n->apply_dir = hdl->apply_dir;
+    n->order = hdl->order;
+    n->range6_seq = hdl->range6_seq;
+    n->flag = hdl->flag & (POLICY_HDL_FLAG_FQDN | POLICY_HDL_FLAG_NOSHARE);
+    n->fqdn_words = hdl->fqdn_words;
+    memcpy(n->fqdn_codes, hdl->fqdn_codes, sizeof(n->fqdn_codes));
+
+    rcu_map_for_each(&hdl->policy_map, iter_copy_rule, n);
+    rcu_map_for_each(&hdl->range_policy_map, iter_copy_range_rule, n);
+    if (DPI_POLICY_HAS_IPV6(hdl) && dpi_policy6_init(n)) {
+        rcu_map_for_each(&hdl->policy6_map, iter_copy_rule6, n);
+        rcu_map_for_each(&hdl->range_policy6_map, iter_copy_range_rule6, n);
+    }
+    entries = n->entries;
+
+    last = &n->shadows;
+    for (sh = hdl->shadows; sh != NULL; sh = sh->next) {
+        size_t size = sizeof(*sh) + sizeof(dpi_policy_app_rule_t) * sh->app_num;
+
+        if ((*last = mem_malloc(DP_MEM_POLICY, size)) == NULL) {
+            break;
+        }
+        memcpy(*last, sh, size);
+        (*last)->next = NULL;
+        last = &(*last)->next;
+    }
+
+    if (entries != hdl->entries || sh != NULL) {
+        DEBUG_ERROR(DBG_POLICY, "failed to copy policy hdl %p\n", hdl);
+        dpi_policy_hdl_destroy(n);
+        return NULL;
+    }
+    return n;
 }
 
-/*-----------------------------------------------------------*
- *------------- Policy config -------------------------------*
- *-----------------------------------------------------------*/
-static uint16_t policy_ver = 0;
-#define GET_NEW_POLICY_VER()  ((++policy_ver)?policy_ver:(++policy_ver))
-
-/*
-static void dpi_policy_set_session_reeval()
+static dpi_policy_hdl_t *dpi_policy_delta_hdl(dpi_policy_t *p, bool *exclusive)
 {
-    struct cds_lfht_node *node;
-    struct cds_lfht_iter iter;
-    uint16_t new_policy_ver = GET_NEW_POLICY_VER();
-    RCU_MAP_ITR_FOR_EACH(&g_ep_map, iter, node) {
-        io_mac_t *mac = STRUCT_OF(node, io_mac_t, node);
-        if (mac->broadcast || mac->unicast) continue;
-        io_ep_t *ep = mac->ep;
-        if (ep->policy_hdl) {
-            ep->policy_ver = new_policy_ver;
-            ((dpi_policy_hdl_t *)ep->policy_hdl)->ver = ep->policy_ver;
+    dpi_policy_hdl_t *hdl = NULL;
+    void *buf;
+    io_ep_t *ep;
+    int i;
+
+    for (i = 0; i < p->num_macs; i++) {
+        buf = rcu_map_lookup(&g_ep_map, &p->mac_list[i]);
+        if (!buf) {
+            DEBUG_POLICY("cannot find mac: "DBG_MAC_FORMAT "\n", DBG_MAC_TUPLE(p->mac_list[i]));
+            return NULL;
+        }
+        ep = GET_EP_FROM_MAC_MAP(buf);
+        if (ep->policy_hdl == NULL || (hdl != NULL && ep->policy_hdl != hdl)) {
+            return NULL;
         }
+        hdl = ep->policy_hdl;
     }
-    DEBUG_POLICY("new policy ver: %d\n", new_policy_ver);
+    *exclusive = hdl != NULL && hdl->ref_cnt == p->num_macs;
+    return hdl;
 }
-*/
 
-int dpi_policy_update(struct ether_addr *mac_addr, dpi_policy_hdl_t *hdl)
+int dpi_policy_delta(dpi_policy_t *p)
 {
-    void *buf;
-    io_ep_t *ep;
-    dpi_policy_hdl_t *old;
+    dpi_policy_hdl_t *hdl, *cur;
+    policy_trash_t *trash = NULL;
+    dpi_policy_scope_t *scope, *old_scope;
+    bool exclusive = false, reeval = false, share = false;
+    uint64_t digest = 0;
+    int i, removed = 0;
 
-    if (!mac_addr) {
+    DEBUG_POLICY("num_macs: %d, del %d, add %d\n", p->num_macs, p->num_del_ids, p->num_rules);
+
+    rcu_read_lock();
+    cur = dpi_policy_delta_hdl(p, &exclusive);
+    rcu_read_unlock();
+    if (cur == NULL) {
+        DEBUG_ERROR(DBG_POLICY, "no common policy hdl for the delta!\n");
         return -1;
     }
-    rcu_read_lock();
-    buf = rcu_map_lookup(&g_ep_map, mac_addr);
-    if (!buf) {
-        rcu_read_unlock();
-        DEBUG_POLICY("cannot find mac: "DBG_MAC_FORMAT "\n", DBG_MAC_TUPLE(*mac_addr));
+
+    qsort(p->del_ids, p->num_del_ids, sizeof(uint32_t), rule_id_cmp);
+    if (cur->flag & POLICY_HDL_FLAG_SHARED) {
+        digest = dpi_policy_delta_digest(cur->digest, p);
+        share = true;
+        if ((hdl = dpi_policy_hdl_find(digest)) != NULL) {
+            // Another user of the hdl took the same delta
+            DEBUG_POLICY("use shared policy hdl %p ref_cnt %d\n", hdl, hdl->ref_cnt);
+            for (i = 0; i < p->num_macs; i++) {
+                dpi_policy_update(&p->mac_list[i], hdl);
+            }
+            return 0;
+        }
+    }
+
+    if (exclusive) {
+        hdl = cur;
+        dpi_policy_hdl_unshare(hdl);
+    } else if ((hdl = dpi_policy_hdl_copy(cur)) == NULL) {
         return -1;
     }
-    ep = GET_EP_FROM_MAC_MAP(buf);
 
-    old = (dpi_policy_hdl_t *)ep->policy_hdl;
-    if (hdl) {
-        hdl->ref_cnt++;
+    // NULL makes all sessions looked up again
+    scope = mem_calloc(DP_MEM_POLICY, 1, sizeof(*scope));
+
+    if (p->num_del_ids > 0) {
+        removed = dpi_policy_del_rules(hdl, p->del_ids, p->num_del_ids,
+                                       exclusive ? &trash : NULL, scope);
+        if (removed > 0) {
+            reeval = true;
+        }
     }
-    ep->policy_hdl = (void *)hdl;
-    ep->policy_ver = hdl?hdl->ver:0;
-    rcu_read_unlock();
+    for (i = 0; i < p->num_rules; i++) {
+        dpi_policy_rule_t *rule = &p->rule_list[i];
 
-    if (old) {
-        if (old->ref_cnt < 2) {
-            synchronize_rcu();
+        policy_scope_add(scope, rule->proto, rule->dport, rule->dport_r);
+        if (dpi_policy_add_rule(hdl, rule) > 0 &&
+            (rule->action != hdl->def_action || rule->num_apps > 0)) {
+            reeval = true;
         }
-        dpi_policy_hdl_destroy(old);
     }
-    DEBUG_POLICY("mac: "DBG_MAC_FORMAT" policy hdl %p ver %u done\n",
-               DBG_MAC_TUPLE(*mac_addr), hdl, ep->policy_ver);
+    dpi_policy_build_range_tree(hdl, exclusive ? &trash : NULL);
+    dpi_policy_compile(hdl, exclusive ? &trash : NULL);
+    if (reeval) {
+        if (scope != NULL) {
+            if (scope->all) {
+                mem_free(DP_MEM_POLICY, scope);
+                scope = NULL;
+            } else {
+                scope->from_ver = hdl->ver;
+            }
+        }
+        old_scope = hdl->scope;
+        rcu_assign_pointer(hdl->scope, scope);
+        policy_trash_put(exclusive ? &trash : NULL, old_scope, false);
+        hdl->ver = GET_NEW_POLICY_VER();
+    } else {
+        mem_free(DP_MEM_POLICY, scope);
+        scope = NULL;
+    }
+    if (share) {
+        dpi_policy_hdl_share(hdl, digest);
+    }
+
+    DEBUG_POLICY("policy hdl %p %s, removed %d entries, ver %u, scope %d\n",
+                 hdl, exclusive ? "updated" : "copied", removed, hdl->ver,
+                 scope != NULL ? scope->count : -1);
+
+    if (!exclusive) {
+        for (i = 0; i < p->num_macs; i++) {
+            dpi_policy_update(&p->mac_list[i], hdl);
+        }
+        if (hdl->ref_cnt == 0) {
+            dpi_policy_hdl_destroy(hdl);
+            return 0;
+        }
+    } else {
+        synchronize_rcu();
+        policy_trash_empty(trash);
+        if (reeval) {
+            rcu_read_lock();
+            for (i = 0; i < p->num_macs; i++) {
+                io_mac_t *mac = rcu_map_lookup(&g_ep_map, &p->mac_list[i]);
+                if (mac) {
+                    mac->ep->policy_ver = hdl->ver;
+                }
+            }
+            rcu_read_unlock();
+        }
+        // cached decisions are keyed by the version
+        dpi_policy_cache_invalidate();
+    }
+
+    if (scope != NULL) {
+        uatomic_inc(&g_policy_scope_seq);
+    }
     return 0;
 }
 
@@ -1411,7 +3577,8 @@ int dpi_policy_cfg(int cmd, dpi_policy_t *p, int flag)
 {
     int i;
     static dpi_policy_hdl_t *hdl = NULL;
-    static uint32_t order = 0;
+    static uint64_t digest;
+    dpi_policy_hdl_t *shared = NULL;
     DEBUG_POLICY("cmd %d, num_macs: %d, num_rules %d flag 0x%x\n",
                cmd, p->num_macs, p->num_rules, flag);
 
@@ -1429,119 +3596,53 @@ int dpi_policy_cfg(int cmd, dpi_policy_t *p, int flag)
     }
 
     if (cmd != CFG_DELETE) {
-        if (flag & MSG_START) {
-            hdl = dpi_policy_hdl_init(p->def_action);
-            hdl->apply_dir = p->apply_dir;
-            order = 0;
-            if (!hdl) {
-                return -1;
+        digest = dpi_policy_digest(digest, p, flag & MSG_START);
+        // A policy in a single message is not built if a shared hdl has it already
+        if ((flag & MSG_START) && (flag & MSG_END)) {
+            shared = dpi_policy_hdl_find(digest);
+        }
+        if (shared == NULL) {
+            if (flag & MSG_START) {
+                hdl = dpi_policy_hdl_init(p->def_action);
+                if (!hdl) {
+                    return -1;
+                }
+                hdl->apply_dir = p->apply_dir;
+                hdl->ver = GET_NEW_POLICY_VER();
             }
-            hdl->ver = GET_NEW_POLICY_VER();
-        }
-        for (i = 0; i < p->num_rules; i++) {
-            dpi_rule_key_t key;
-            dpi_policy_desc_t desc;
-            int dir;
-            memset(&key, 0, sizeof(key));
-            memset(&desc, 0, sizeof(desc));
-
-            if (p->rule_list[i].fqdn[0] != '\0') {
-               uint32_t code;
-               if (p->rule_list[i].ingress) {
-                   rcu_read_lock();
-                   code = config_fqdn_ipv4_mapping(g_fqdn_hdl,
-                            p->rule_list[i].fqdn, p->rule_list[i].sip, p->rule_list[i].vh);
-                   rcu_read_unlock();
-                   if (code == -1) {
-                       continue;
-                   }
-                   p->rule_list[i].sip = code;
-                   p->rule_list[i].sip_r = code;
-               } else {
-                   rcu_read_lock();
-                   code = config_fqdn_ipv4_mapping(g_fqdn_hdl,
-                            p->rule_list[i].fqdn, p->rule_list[i].dip, p->rule_list[i].vh);
-                   rcu_read_unlock();
-                   if (code == -1) {
-                       continue;
-                   }
-                   p->rule_list[i].dip = code;
-                   p->rule_list[i].dip_r = code;
-               }
-               hdl->flag |= POLICY_HDL_FLAG_FQDN;
+            for (i = 0; i < p->num_rules; i++) {
+                dpi_policy_add_rule(hdl, &p->rule_list[i]);
             }
-
-            key.sip = p->rule_list[i].sip;
-            key.dip = p->rule_list[i].dip;
-            key.dport = p->rule_list[i].dport;
-            key.proto =  p->rule_list[i].proto;
-            desc.id = p->rule_list[i].id;
-            desc.action = p->rule_list[i].action;
-            desc.flags = POLICY_DESC_CHECK_VER;
-            desc.order = ++order;
-            dir = p->rule_list[i].ingress?POLICY_RULE_DIR_INGRESS:POLICY_RULE_DIR_EGRESS;
-
-            if (key.dport != p->rule_list[i].dport_r || key.sip != p->rule_list[i].sip_r ||
-                    key.dip != p->rule_list[i].dip_r) {
-                dpi_rule_key_t key_r;
-                memcpy(&key_r, &key, sizeof(dpi_rule_key_t));
-                key_r.dport = p->rule_list[i].dport_r;
-                key_r.sip = p->rule_list[i].sip_r;
-                key_r.dip = p->rule_list[i].dip_r;
-                if (key.proto > 0) {
-                    dpi_rule_add(hdl, &key, &key_r,
-                                 p->rule_list[i].num_apps,p->rule_list[i].app_rules,
-                                 dir, &desc);
-                } else {
-                    key.proto = key_r.proto = IPPROTO_TCP;
-                    dpi_rule_add(hdl, &key, &key_r,
-                                 p->rule_list[i].num_apps,p->rule_list[i].app_rules,
-                                 dir, &desc);
-                    key.proto = key_r.proto = IPPROTO_UDP;
-                    dpi_rule_add(hdl, &key, &key_r,
-                                 p->rule_list[i].num_apps,p->rule_list[i].app_rules,
-                                 dir, &desc);
-                    if (g_enable_icmp_policy) {
-                        key.proto = key_r.proto = IPPROTO_ICMP;
-                        dpi_rule_add(hdl, &key, &key_r,
-                                    p->rule_list[i].num_apps,p->rule_list[i].app_rules,
-                                    dir, &desc);
-                    }
-                }
+            if (p->num_rules6 > 0 && !dpi_policy6_init(hdl)) {
+                DEBUG_ERROR(DBG_POLICY, "Out of memory, ipv6 rules are ignored!\n");
+                hdl->flag |= POLICY_HDL_FLAG_NOSHARE;
             } else {
-                if (key.proto > 0) {
-                    dpi_rule_add(hdl, &key, NULL,
-                                 p->rule_list[i].num_apps,p->rule_list[i].app_rules,
-                                 dir, &desc);
+                for (i = 0; i < p->num_rules6; i++) {
+                    dpi_policy6_add_rule(hdl, &p->rule6_list[i], ++hdl->order);
+                }
+            }
+            if (flag & MSG_END) {
+                if (!g_enable_icmp_policy) {
+                    dpi_add_default_policy(hdl);
+                }
+                dpi_policy_build_range_tree(hdl, NULL);
+                dpi_policy_compile(hdl, NULL);
+                if ((shared = dpi_policy_hdl_find(digest)) != NULL) {
+                    dpi_policy_hdl_destroy(hdl);
                 } else {
-                    key.proto = IPPROTO_TCP;
-                    dpi_rule_add(hdl, &key, NULL,
-                                 p->rule_list[i].num_apps,p->rule_list[i].app_rules,
-                                 dir, &desc);
-                    key.proto = IPPROTO_UDP;
-                    dpi_rule_add(hdl, &key, NULL,
-                                 p->rule_list[i].num_apps,p->rule_list[i].app_rules,
-                                 dir, &desc);
-                    if (g_enable_icmp_policy) {
-                        key.proto = IPPROTO_ICMP;
-                        dpi_rule_add(hdl, &key, NULL,
-                                    p->rule_list[i].num_apps,p->rule_list[i].app_rules,
-                                    dir, &desc);
-                    }
+                    dpi_policy_hdl_share(hdl, digest);
                 }
             }
         }
-        if (flag & MSG_END) {
-            if (!g_enable_icmp_policy) {
-                dpi_add_default_policy(hdl);
-            }
+        if (shared != NULL) {
+            DEBUG_POLICY("use shared policy hdl %p ref_cnt %d\n", shared, shared->ref_cnt);
+            hdl = shared;
         }
     } else {
         if (hdl != NULL) {
             DEBUG_POLICY("old policy hdl %p exists while receiving delete\n", hdl);
             dpi_policy_hdl_destroy(hdl);
             hdl = NULL;
-            order = 0;
         }
     }
 
@@ -1583,7 +3684,7 @@ static uint32_t fqdn_name_hash(const void *key)
 {
     //key is null terminated
     const char *k = key;
-    return sdbm_hash((uint8_t *)k, strlen(k)*sizeof(char));
+    return hash_key(k, strlen(k));
 }
 
 static int fqdn_ipv4_match(struct cds_lfht_node *ht_node, const void *key)
@@ -1596,13 +3697,32 @@ static int fqdn_ipv4_match(struct cds_lfht_node *ht_node, const void *key)
 static uint32_t fqdn_ipv4_hash(const void *key)
 {
     const uint32_t *k = key;
-    return sdbm_hash((uint8_t *)k, sizeof(uint32_t));
+    return hash_u32(*k);
+}
+
+static int fqdn_wild_match(struct cds_lfht_node *ht_node, const void *key)
+{
+    fqdn_wild_node_t *n = STRUCT_OF(ht_node, fqdn_wild_node_t, node);
+    const fqdn_wild_key_t *k = key;
+    return n->parent == k->parent && n->len == k->len && strncasecmp(n->label, k->label, k->len) == 0;
+}
+
+static uint32_t fqdn_wild_hash(const void *key)
+{
+    const fqdn_wild_key_t *k = key;
+    uint32_t h = (uint32_t)(uintptr_t)k->parent * 0x9e3779b1u;
+    int i;
+
+    for (i = 0; i < k->len; i ++) {
+        h = h * 31 + tolower((uint8_t)k->label[i]);
+    }
+    return h;
 }
 
 static dpi_fqdn_hdl_t *dpi_fqdn_hdl_init()
 {
     dpi_fqdn_hdl_t *hdl;
-    hdl = calloc(sizeof(dpi_fqdn_hdl_t), 1);
+    hdl = mem_calloc(DP_MEM_POLICY, sizeof(dpi_fqdn_hdl_t), 1);
     if (!hdl) {
         DEBUG_ERROR(DBG_POLICY, "Out of memory!");
         return NULL;
@@ -1612,19 +3732,23 @@ static dpi_fqdn_hdl_t *dpi_fqdn_hdl_init()
     hdl->bm = bitmap_allocate(DPI_FQDN_MAX_ENTRIES);
     if (!hdl->bm) {
         DEBUG_ERROR(DBG_POLICY, "Out of memory!");
-        free(hdl);
+        mem_free(DP_MEM_POLICY, hdl);
         return NULL;
     }
     rcu_map_init(&(hdl->fqdn_name_map), 32, offsetof(fqdn_name_entry_t, node),
                  fqdn_name_match, fqdn_name_hash);
     rcu_map_init(&(hdl->fqdn_ipv4_map), 32, offsetof(fqdn_ipv4_entry_t, node),
                  fqdn_ipv4_match, fqdn_ipv4_hash);
+    rcu_map_init(&(hdl->fqdn_wild_map), 32, offsetof(fqdn_wild_node_t, node),
+                 fqdn_wild_match, fqdn_wild_hash);
     CDS_INIT_LIST_HEAD(&hdl->del_rlist);
+    CDS_INIT_LIST_HEAD(&hdl->del_wlist);
     return hdl;
 }
 
 static uint32_t alloc_fqdn_code(dpi_fqdn_hdl_t *hdl)
 {
+    fqdn_del_batch_reap(hdl);
     hdl->code_cnt = bitmap_get_next_zero(hdl->bm, hdl->code_cnt);
     if (hdl->code_cnt < 0) {
         DEBUG_ERROR(DBG_POLICY, "used up fqdn code!!\n");
@@ -1663,6 +3787,174 @@ static bool is_fqdn_name_wildcard(char* name)
     return false;
 }
 
+// Return the start of the label ending at 'end', the labels of a name are visited from the top
+static const char *fqdn_prev_label(const char *name, const char *end)
+{
+    const char *start = end;
+
+    while (start > name && start[-1] != '.') {
+        start --;
+    }
+    return start;
+}
+
+static const char *fqdn_name_end(const char *name)
+{
+    const char *end = name + strlen(name);
+
+    if (end > name && end[-1] == '.') {
+        end --;
+    }
+    return end;
+}
+
+#define FQDN_BLOOM_HASHES 3
+
+static void fqdn_bloom_pos(const char *name, int len, uint32_t *pos)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    uint32_t h1, h2;
+    int i;
+
+    for (i = 0; i < len; i ++) {
+        h ^= (uint8_t)tolower(name[i]);
+        h *= 0x100000001b3ULL;
+    }
+    h1 = (uint32_t)h;
+    h2 = (uint32_t)(h >> 32) | 1;
+    for (i = 0; i < FQDN_BLOOM_HASHES; i ++) {
+        pos[i] = (h1 + i * h2) & ((1 << DPI_FQDN_BLOOM_BITS) - 1);
+    }
+}
+
+static void fqdn_bloom_add(dpi_fqdn_hdl_t *hdl, const char *name)
+{
+    uint32_t pos[FQDN_BLOOM_HASHES];
+    int i;
+
+    fqdn_bloom_pos(name, fqdn_name_end(name) - name, pos);
+    for (i = 0; i < FQDN_BLOOM_HASHES; i ++) {
+        uint8_t *b = &hdl->name_bloom[pos[i] >> 3];
+
+        CMM_STORE_SHARED(*b, *b | (1 << (pos[i] & 7)));
+    }
+}
+
+// Called from parser. False if neither an exact nor a wildcard name can match, the name
+// or one of its suffixes must be in the bloom filter.
+bool snooped_fqdn_name_wanted(const char *name)
+{
+    dpi_fqdn_hdl_t *hdl = g_fqdn_hdl;
+    const char *end = fqdn_name_end(name), *start = name;
+    uint32_t pos[FQDN_BLOOM_HASHES];
+    int i;
+
+    if (hdl == NULL) {
+        return false;
+    }
+    while (start < end) {
+        fqdn_bloom_pos(start, end - start, pos);
+        for (i = 0; i < FQDN_BLOOM_HASHES; i ++) {
+            if (!(CMM_LOAD_SHARED(hdl->name_bloom[pos[i] >> 3]) & (1 << (pos[i] & 7)))) {
+                break;
+            }
+        }
+        if (i == FQDN_BLOOM_HASHES) {
+            return true;
+        }
+        while (start < end && *start != '.') {
+            start ++;
+        }
+        start ++;
+    }
+    return false;
+}
+
+static fqdn_wild_node_t *fqdn_wild_child(dpi_fqdn_hdl_t *hdl, fqdn_wild_node_t *parent,
+                                         const char *label, int len)
+{
+    fqdn_wild_key_t key;
+
+    key.parent = parent;
+    key.label = label;
+    key.len = len;
+    return rcu_map_lookup(&hdl->fqdn_wild_map, &key);
+}
+
+// Remove the nodes without a record or children from 'n' up, they are freed after a grace period
+static void fqdn_wild_prune(dpi_fqdn_hdl_t *hdl, fqdn_wild_node_t *n)
+{
+    while (n != NULL && n->r == NULL && n->children == 0) {
+        fqdn_wild_node_t *parent = n->parent;
+
+        rcu_map_del(&hdl->fqdn_wild_map, n);
+        cds_list_add_tail(&n->del, &hdl->del_wlist);
+        if (parent != NULL) {
+            parent->children --;
+        }
+        n = parent;
+    }
+}
+
+static int fqdn_wild_add(dpi_fqdn_hdl_t *hdl, fqdn_record_t *r)
+{
+    const char *suffix = r->name + 2, *end = fqdn_name_end(suffix), *start;
+    fqdn_wild_node_t *parent = NULL, *n;
+    fqdn_wild_key_t key;
+
+    if (end == suffix) {
+        return -1;
+    }
+    while (end > suffix) {
+        start = fqdn_prev_label(suffix, end);
+        if (end - start == 0 || end - start >= sizeof(n->label)) {
+            fqdn_wild_prune(hdl, parent);
+            return -1;
+        }
+        n = fqdn_wild_child(hdl, parent, start, end - start);
+        if (n == NULL) {
+            if ((n = mem_calloc(DP_MEM_POLICY, 1, sizeof(*n))) == NULL) {
+                DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
+                fqdn_wild_prune(hdl, parent);
+                return -1;
+            }
+            n->parent = parent;
+            n->depth = parent != NULL ? parent->depth + 1 : 1;
+            n->len = end - start;
+            memcpy(n->label, start, n->len);
+            key.parent = parent;
+            key.label = n->label;
+            key.len = n->len;
+            rcu_map_add(&hdl->fqdn_wild_map, n, &key);
+            if (parent != NULL) {
+                parent->children ++;
+            }
+        }
+        parent = n;
+        end = start > suffix ? start - 1 : start;
+    }
+    rcu_assign_pointer(parent->r, r);
+    return 0;
+}
+
+static void fqdn_wild_del(dpi_fqdn_hdl_t *hdl, fqdn_record_t *r)
+{
+    const char *suffix = r->name + 2, *end = fqdn_name_end(suffix), *start;
+    fqdn_wild_node_t *n = NULL;
+
+    while (end > suffix) {
+        start = fqdn_prev_label(suffix, end);
+        if ((n = fqdn_wild_child(hdl, n, start, end - start)) == NULL) {
+            return;
+        }
+        end = start > suffix ? start - 1 : start;
+    }
+    if (n != NULL && n->r == r) {
+        rcu_assign_pointer(n->r, NULL);
+        fqdn_wild_prune(hdl, n);
+    }
+}
+
 //caller make sure entry and r is not NULL
 static void config_fqdn_init_ip_record_list(fqdn_ipv4_entry_t *ipv4_entry, fqdn_record_t *r)
 {
@@ -1707,25 +3999,26 @@ static int config_record_ip_list(fqdn_ipv4_entry_t *entry, fqdn_record_t *r)
     //init list
     config_fqdn_init_ip_record_list(entry,r);
     //one ip can map to multiple fqdn record
-    record_item = calloc(1, sizeof(fqdn_record_item_t));
+    record_item = mem_calloc(DP_MEM_POLICY, 1, sizeof(fqdn_record_item_t));
     if (record_item == NULL) {
         DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
         return -1;
     }
     //one fqdn record can map to multiple ip
-    ipv4_item = calloc(1, sizeof(fqdn_ipv4_item_t));
+    ipv4_item = mem_calloc(DP_MEM_POLICY, 1, sizeof(fqdn_ipv4_item_t));
     if (ipv4_item == NULL) {
         DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
-        free(record_item);
+        mem_free(DP_MEM_POLICY, record_item);
         return -1;
     }
     if (!find_record_or_ipentry(entry, r, true)){
         //add record_item to ipv4_entry's record list
         record_item->r = r;
         cds_list_add_tail((struct cds_list_head *)record_item, &entry->rlist);
+        fqdn_code_set(entry->codes, r->code);
         //DEBUG_POLICY("add record(%p) code(0x%08x) to ipv4_entry's rlist\n", record_item->r, record_item->r->code);
     } else {
-        free(record_item);
+        mem_free(DP_MEM_POLICY, record_item);
     }
     if (!find_record_or_ipentry(entry, r, false)) {
         //add ipv4_item to fqdn_record's iplist
@@ -1736,7 +4029,7 @@ static int config_record_ip_list(fqdn_ipv4_entry_t *entry, fqdn_record_t *r)
         //return 1 means this ip may need to be sent to consul
         return 1;
     } else {
-        free(ipv4_item);
+        mem_free(DP_MEM_POLICY, ipv4_item);
     }
     return 0;
 }
@@ -1751,28 +4044,33 @@ uint32_t config_fqdn_ipv4_mapping(dpi_fqdn_hdl_t *hdl, char *name, uint32_t ip,
     name_entry = rcu_map_lookup(&hdl->fqdn_name_map, name);
     if (!name_entry) {
         fqdn_name_entry_t *entry;
-        entry  = (fqdn_name_entry_t *)calloc(1, sizeof(fqdn_name_entry_t));
+        entry  = (fqdn_name_entry_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(fqdn_name_entry_t));
         if (!entry) {
             DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
             return -1;
         }
 
-        r = (fqdn_record_t *)calloc(1, sizeof(fqdn_record_t));
+        r = (fqdn_record_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(fqdn_record_t));
         if (!r) {
             DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
-            free(entry);
+            mem_free(DP_MEM_POLICY, entry);
             return -1;
         }
         strlcpy(r->name, name, MAX_FQDN_LEN);
         r->code = alloc_fqdn_code(hdl);
         if (r->code == -1) {
-            free(entry);
-            free(r);
+            mem_free(DP_MEM_POLICY, entry);
+            mem_free(DP_MEM_POLICY, r);
             return -1;
         }
         r->vh = vh;
+        hdl->records[DPI_FQDN_CODE_BIT(r->code)] = r;
         if (is_fqdn_name_wildcard(r->name)) {
             r->flag = FQDN_RECORD_WILDCARD;
+            fqdn_wild_add(hdl, r);
+            fqdn_bloom_add(hdl, r->name + 2);
+        } else {
+            fqdn_bloom_add(hdl, r->name);
         }
         entry->r = r;
         rcu_map_add(&hdl->fqdn_name_map, entry, name);
@@ -1798,16 +4096,17 @@ uint32_t config_fqdn_ipv4_mapping(dpi_fqdn_hdl_t *hdl, char *name, uint32_t ip,
     ipv4_entry = rcu_map_lookup(&hdl->fqdn_ipv4_map, &ip);
     if (!ipv4_entry) {
         fqdn_ipv4_entry_t *entry;
-        entry = (fqdn_ipv4_entry_t *)calloc(1, sizeof(fqdn_ipv4_entry_t));
+        entry = (fqdn_ipv4_entry_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(fqdn_ipv4_entry_t));
         if (!entry) {
             DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
         } else {
             entry->ip = ip;
             if (config_record_ip_list(entry, r) < 0){
-                free(entry);
+                mem_free(DP_MEM_POLICY, entry);
                 return r->code;
             }
             rcu_map_add(&hdl->fqdn_ipv4_map, entry, &ip);
+            dpi_policy_cache_invalidate();
             th_counter.domain_ips++;
             DEBUG_POLICY("create record ip:%x name:%s code %x\n", ip, name, r->code);
         }
@@ -1817,29 +4116,23 @@ uint32_t config_fqdn_ipv4_mapping(dpi_fqdn_hdl_t *hdl, char *name, uint32_t ip,
     return r->code;
 }
 
-static bool match_fqdn_wildcard_name(char *vhost, char *fqdname)
+// "*.yahoo.com" matches names of one or more labels before ".yahoo.com". The suffix has at
+// least two labels, "*.com" matches nothing.
+static bool match_fqdn_wildcard_name(const char *vhost, const char *fqdname)
 {
-    char dname[MAX_FQDN_LEN];
-    int i, j;
+    const char *suffix = fqdname + 1;
+    size_t vlen = strlen(vhost), slen = strlen(suffix);
 
-    strlcpy(dname, vhost, MAX_FQDN_LEN);
-    //dname is null terminated
-    for (j = strlen(dname)-2; j > 0;  j--) {
-        if (dname[j] == '.') {
-            break;
-        }
+    if (fqdname[0] != '*' || suffix[0] != '.' || strchr(suffix + 1, '.') == NULL) {
+        return false;
     }
-    for (i = 0; i < j-1; i++) {
-        if (dname[i+1] == '.') {
-            dname[i] = '*';
-            if (strcasecmp(fqdname, &dname[i]) == 0) {
-                return true;
-            }
-        }
+    if (vlen <= slen) {
+        return false;
     }
-    return false;
+    return strcasecmp(vhost + vlen - slen, suffix) == 0;
 }
-// Called by policy lookup
+// Called by policy lookup. Only the records of the ip that the policy has rules for are looked up,
+// the codes of both are in bitmaps.
 static int policy_match_ipv4_fqdn_code(dpi_fqdn_hdl_t *fqdn_hdl, uint32_t ip, dpi_policy_hdl_t *hdl, dpi_rule_key_t *key,
                                      int is_ingress, dpi_policy_desc_t *desc2, dpi_packet_t *p)
 {
@@ -1848,70 +4141,73 @@ static int policy_match_ipv4_fqdn_code(dpi_fqdn_hdl_t *fqdn_hdl, uint32_t ip, dp
     ipv4_entry = rcu_map_lookup(&fqdn_hdl->fqdn_ipv4_map, &ip);
     if (!ipv4_entry) {
         return 0;
-    } else {
-        DEBUG_POLICY("found ip %x\n", ip);
-        if(ipv4_entry->rlist.prev==NULL && ipv4_entry->rlist.next==NULL) {
-            CDS_INIT_LIST_HEAD(&ipv4_entry->rlist);
-        }
-        //ctrl path does not reach here, only dp does.
-        //For safety we still check whether p is NULL.
-        if (p) {
-            s = p->session;
-        }
-        fqdn_record_item_t *r_itr, *r_next;
-        int i = 0;
-        cds_list_for_each_entry_safe(r_itr, r_next, &ipv4_entry->rlist, node) {
+    }
+    DEBUG_POLICY("found ip %x\n", ip);
+    //ctrl path does not reach here, only dp does.
+    //For safety we still check whether p is NULL.
+    if (p) {
+        s = p->session;
+    }
+    int i = 0, w;
+    for (w = 0; w < hdl->fqdn_words; w++) {
+        bitmap_type bits = ipv4_entry->codes[w] & hdl->fqdn_codes[w];
+
+        while (bits != 0) {
             //multiple FQDN can map to same IP
+            fqdn_record_t *r = fqdn_hdl->records[w * 32 + __builtin_ctz(bits)];
             dpi_policy_desc_t desc3;
             bool wildmatch = false;
-            if (r_itr->r->code != 0) {
-                if (is_ingress) {
-                    key->sip = r_itr->r->code;
-                } else {
-                    key->dip = r_itr->r->code;
-                }
-                _dpi_policy_lookup_by_key(hdl, key, is_ingress, &desc3);
-                if (r_itr->r->vh) {
-                    //vhost based FQDN group, we need to match vhost in the session
-                    if (s && FLAGS_TEST(s->flags, DPI_SESS_FLAG_POLICY_APP_READY)) {
-                        if (desc3.id > 0) {//not implicit
-                            if (r_itr->r->flag & FQDN_RECORD_WILDCARD) {
-                                wildmatch = match_fqdn_wildcard_name((char *)s->vhost, r_itr->r->name);
-                            }
-                            //if we cannot match vhost in session with name in fqdn record
-                            //it means no match, set to implicit default
-                            if (s->vhlen == 0 || (strcasecmp(r_itr->r->name,(char *)s->vhost) != 0 && !wildmatch)) {
-                                desc3.id = 0;
-                                desc3.action = hdl->def_action;
-                                //desc3->flags = POLICY_DESC_CHECK_VER;
-                                desc3.order = 0xffffffff;
-                                desc3.hdl_ver = 0;
-                            }
+
+            bits &= bits - 1;
+            if (r == NULL || r->code == 0) {
+                continue;
+            }
+            if (is_ingress) {
+                key->sip = r->code;
+            } else {
+                key->dip = r->code;
+            }
+            _dpi_policy_lookup_by_key(hdl, key, is_ingress, &desc3);
+            if (r->vh) {
+                //vhost based FQDN group, we need to match vhost in the session
+                if (s && FLAGS_TEST(s->flags, DPI_SESS_FLAG_POLICY_APP_READY)) {
+                    if (desc3.id > 0) {//not implicit
+                        if (r->flag & FQDN_RECORD_WILDCARD) {
+                            wildmatch = match_fqdn_wildcard_name((char *)dpi_session_vhost(s), r->name);
                         }
-                    } else {
-                        //we need vhost in session to do exact match
-                        //if action is check_app we do not change to check_vh
-                        //because check_app will also reevaluate, by the time
-                        //app is ready, vhost should also be ready
-                        if (desc3.id > 0 && desc3.action != DP_POLICY_ACTION_CHECK_APP) {
-                            desc3.action = DP_POLICY_ACTION_CHECK_VH;
+                        //if we cannot match vhost in session with name in fqdn record
+                        //it means no match, set to implicit default
+                        if (dpi_session_vhlen(s) == 0 || (strcasecmp(r->name, dpi_session_vhost(s)) != 0 && !wildmatch)) {
+                            desc3.id = 0;
+                            desc3.action = hdl->def_action;
+                            //desc3->flags = POLICY_DESC_CHECK_VER;
+                            desc3.order = 0xffffffff;
+                            desc3.hdl_ver = 0;
                         }
                     }
-                }
-                if (i == 0) {
-                    policy_desc_cpy(desc2, &desc3);
                 } else {
-                    policy_desc_merge(desc2, &desc3);
+                    //we need vhost in session to do exact match
+                    //if action is check_app we do not change to check_vh
+                    //because check_app will also reevaluate, by the time
+                    //app is ready, vhost should also be ready
+                    if (desc3.id > 0 && desc3.action != DP_POLICY_ACTION_CHECK_APP) {
+                        desc3.action = DP_POLICY_ACTION_CHECK_VH;
+                    }
                 }
-                i++;
             }
+            if (i == 0) {
+                policy_desc_cpy(desc2, &desc3);
+            } else {
+                policy_desc_merge(desc2, &desc3);
+            }
+            i++;
         }
-        return i;
     }
+    return i;
 }
 
-//caller make sure hdl, name_entry and ip not NULL
-static int associate_ip_record(dpi_fqdn_hdl_t *hdl, fqdn_name_entry_t *name_entry, uint32_t *ip, int cnt)
+//caller make sure hdl, r and ip not NULL
+static int associate_ip_record(dpi_fqdn_hdl_t *hdl, fqdn_record_t *r, uint32_t *ip, int cnt)
 {
     fqdn_ipv4_entry_t *ipv4_entry = NULL;
     int i, ret;
@@ -1919,33 +4215,34 @@ static int associate_ip_record(dpi_fqdn_hdl_t *hdl, fqdn_name_entry_t *name_entr
     for (i = 0; i < cnt; i++) {
         ipv4_entry = rcu_map_lookup(&hdl->fqdn_ipv4_map, &ip[i]);
         if (ipv4_entry) {
-            ret = config_record_ip_list(ipv4_entry, name_entry->r);
+            ret = config_record_ip_list(ipv4_entry, r);
             //existing ip entry associated with wildcard fqdn
-            if ((ret == 1) && (name_entry->r->flag & FQDN_RECORD_WILDCARD)) {
+            if ((ret == 1) && (r->flag & FQDN_RECORD_WILDCARD)) {
                 new_ip = true;
             }
         } else {
-            ipv4_entry = (fqdn_ipv4_entry_t *)calloc(1, sizeof(fqdn_ipv4_entry_t));
+            ipv4_entry = (fqdn_ipv4_entry_t *)mem_calloc(DP_MEM_POLICY, 1, sizeof(fqdn_ipv4_entry_t));
             if (!ipv4_entry) {
                 DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
                 return -1;
             }
             ipv4_entry->ip = ip[i];
-            if (config_record_ip_list(ipv4_entry, name_entry->r) < 0){
-                free(ipv4_entry);
+            if (config_record_ip_list(ipv4_entry, r) < 0){
+                mem_free(DP_MEM_POLICY, ipv4_entry);
                 return -1;
             }
             th_counter.domain_ips++;
             rcu_map_add(&hdl->fqdn_ipv4_map, ipv4_entry, &ipv4_entry->ip);
+            dpi_policy_cache_invalidate();
             DEBUG_POLICY("create record ip: %x name: %s code %x\n",
-                            ipv4_entry->ip, name_entry->r->name, name_entry->r->code);
-            if (name_entry->r->flag & FQDN_RECORD_WILDCARD) {
+                            ipv4_entry->ip, r->name, r->code);
+            if (r->flag & FQDN_RECORD_WILDCARD) {
                 new_ip = true;
             }
         }
     }
     if (new_ip) {
-        uatomic_set(&name_entry->r->record_updated, 1);
+        uatomic_set(&r->record_updated, 1);
     }
     return 0;
 }
@@ -1966,28 +4263,26 @@ int snooped_fqdn_ipv4_mapping(char *name, uint32_t *ip, int cnt)
     if (name_entry &&
         !(name_entry->r->flag & (FQDN_RECORD_TO_DELETE|FQDN_RECORD_DELETED))) {
         DEBUG_POLICY("exact match name: (%s)\n", name);
-        associate_ip_record(hdl, name_entry, ip, cnt);
+        associate_ip_record(hdl, name_entry->r, ip, cnt);
     }
-    char dname[MAX_FQDN_LEN];
-    int i, j;
 
-    strlcpy(dname, name, MAX_FQDN_LEN);
-    //dname is null terminated
-    for (j = strlen(dname)-2; j > 0;  j--) {
-        if (dname[j] == '.') {
+    // Walk the wildcard trie down the labels, a wildcard of two or more labels matches if
+    // a label is left before it
+    const char *end = fqdn_name_end(name), *start;
+    fqdn_wild_node_t *n = NULL;
+    fqdn_record_t *r;
+
+    while (end > name) {
+        start = fqdn_prev_label(name, end);
+        if (start <= name + 1 || (n = fqdn_wild_child(hdl, n, start, end - start)) == NULL) {
             break;
         }
-    }
-    for (i = 0; i < j-1; i++) {
-        if (dname[i+1] == '.') {
-            dname[i] = '*';
-            name_entry = rcu_map_lookup(&hdl->fqdn_name_map, &dname[i]);
-            if (name_entry &&
-                !(name_entry->r->flag & (FQDN_RECORD_TO_DELETE|FQDN_RECORD_DELETED))) {
-                DEBUG_POLICY("wildcard match name: (%s)\n", &dname[i]);
-                associate_ip_record(hdl, name_entry, ip, cnt);
-            }
+        r = rcu_dereference(n->r);
+        if (r != NULL && n->depth >= 2 && !(r->flag & (FQDN_RECORD_TO_DELETE|FQDN_RECORD_DELETED))) {
+            DEBUG_POLICY("wildcard match name: (%s)\n", r->name);
+            associate_ip_record(hdl, r, ip, cnt);
         }
+        end = start - 1;
     }
     return 0;
 }
@@ -2013,49 +4308,135 @@ static int enqueue_fqdn_ipv4_to_del(dpi_fqdn_hdl_t *hdl, fqdn_ipv4_entry_t *entr
     return 0;
 }
 
-static void free_fqdn_ipv4(dpi_fqdn_hdl_t *hdl)
+// Deleted names and ips go to the reclaimer in batches, without waiting for the dp threads.
+// The codes of the names are only released to the bitmap by the ctrl thread once their
+// batch is freed, a new name never gets the code of one the dp threads might still see.
+typedef struct fqdn_del_batch_ {
+    struct fqdn_del_batch_ *next;
+    int done;                       // set by the reclaimer
+    int name_cnt;
+    int ipv4_cnt;
+    fqdn_name_entry_t *names[DPI_FQDN_DELETE_QLEN];
+    fqdn_ipv4_entry_t *ipv4s[DPI_FQDN_DELETE_QLEN];
+    struct cds_list_head rlist;
+    struct cds_list_head wlist;
+    uint32_t codes[DPI_FQDN_DELETE_QLEN];
+} fqdn_del_batch_t;
+
+// After the grace period, on the reclaimer
+static void fqdn_del_batch_free(void *ptr)
 {
+    fqdn_del_batch_t *b = ptr;
+    fqdn_record_t *r;
     int i;
-    for (i = 0; i < hdl->del_ipv4_cnt; i++) {
-        //DEBUG_POLICY("Free fqdn ipv4 %x\n", hdl->del_ipv4_list[i]->ip);
-        free(hdl->del_ipv4_list[i]);
-        hdl->del_ipv4_list[i] = NULL;
-        th_counter.domain_ips--;
-    }
-    hdl->del_ipv4_cnt = 0;
-}
 
-static void free_fqdn_name(dpi_fqdn_hdl_t *hdl)
-{
-    int i = 0;
-    fqdn_record_t *r;
-    for (i = 0; i < hdl->del_name_cnt; i++) {
-        r = hdl->del_name_list[i]->r;
-        if(r->iplist.prev==NULL && r->iplist.next==NULL) {
-            CDS_INIT_LIST_HEAD(&r->iplist);
-        }
+    for (i = 0; i < b->ipv4_cnt; i++) {
+        mem_free(DP_MEM_POLICY, b->ipv4s[i]);
+    }
+    for (i = 0; i < b->name_cnt; i++) {
+        r = b->names[i]->r;
         //release ipv4_item list(r->iplist) first
         fqdn_ipv4_item_t *ipv4_itr, *ipv4_next;
         cds_list_for_each_entry_safe(ipv4_itr, ipv4_next, &r->iplist, node) {
             cds_list_del((struct cds_list_head *)ipv4_itr);
-            free(ipv4_itr);
-            r->ip_cnt--;
+            mem_free(DP_MEM_POLICY, ipv4_itr);
         }
-        DEBUG_POLICY("Free fqdn name %s code %x ip_cnt %d\n", r->name, r->code, r->ip_cnt);
-        free_fqdn_code(hdl, r->code);
-        free(r);
-        free(hdl->del_name_list[i]);
-        hdl->del_name_list[i] = NULL;
-        th_counter.domains--;
+        mem_free(DP_MEM_POLICY, r);
+        mem_free(DP_MEM_POLICY, b->names[i]);
     }
-    hdl->del_name_cnt = 0;
 
     fqdn_record_item_t *r_itr, *r_next;
-    cds_list_for_each_entry_safe(r_itr, r_next, &hdl->del_rlist, node) {
-        DEBUG_POLICY("free fqdn_record_item_t %s\n", r_itr->r->name);
+    cds_list_for_each_entry_safe(r_itr, r_next, &b->rlist, node) {
         cds_list_del((struct cds_list_head *)r_itr);
-        free(r_itr);
+        mem_free(DP_MEM_POLICY, r_itr);
+    }
+
+    fqdn_wild_node_t *w_itr, *w_next;
+    cds_list_for_each_entry_safe(w_itr, w_next, &b->wlist, del) {
+        cds_list_del(&w_itr->del);
+        mem_free(DP_MEM_POLICY, w_itr);
+    }
+
+    cmm_smp_mb();
+    CMM_STORE_SHARED(b->done, 1);
+}
+
+static void fqdn_del_batch_release(dpi_fqdn_hdl_t *hdl, fqdn_del_batch_t *b)
+{
+    int i;
+
+    for (i = 0; i < b->name_cnt; i++) {
+        free_fqdn_code(hdl, b->codes[i]);
+    }
+}
+
+// Release the codes of the freed batches
+static void fqdn_del_batch_reap(dpi_fqdn_hdl_t *hdl)
+{
+    fqdn_del_batch_t **pb = &hdl->del_batches, *b;
+
+    while ((b = *pb) != NULL) {
+        if (CMM_LOAD_SHARED(b->done)) {
+            cmm_smp_mb();
+            fqdn_del_batch_release(hdl, b);
+            *pb = b->next;
+            mem_free(DP_MEM_POLICY, b);
+        } else {
+            pb = &b->next;
+        }
+    }
+}
+
+// Hand the queued ips, and the queued names if with_names, to the reclaimer
+static void fqdn_del_flush(dpi_fqdn_hdl_t *hdl, bool with_names)
+{
+    fqdn_del_batch_t local, *b;
+    fqdn_record_t *r;
+    int i;
+
+    b = mem_malloc(DP_MEM_POLICY, sizeof(*b));
+    if (b == NULL) {
+        b = &local;
+    }
+    b->done = 0;
+    b->name_cnt = 0;
+    CDS_INIT_LIST_HEAD(&b->rlist);
+    CDS_INIT_LIST_HEAD(&b->wlist);
+
+    memcpy(b->ipv4s, hdl->del_ipv4_list, sizeof(b->ipv4s[0]) * hdl->del_ipv4_cnt);
+    b->ipv4_cnt = hdl->del_ipv4_cnt;
+    th_counter.domain_ips -= hdl->del_ipv4_cnt;
+    hdl->del_ipv4_cnt = 0;
+    cds_list_splice(&hdl->del_rlist, &b->rlist);
+    CDS_INIT_LIST_HEAD(&hdl->del_rlist);
+
+    if (with_names) {
+        for (i = 0; i < hdl->del_name_cnt; i++) {
+            r = hdl->del_name_list[i]->r;
+            if(r->iplist.prev==NULL && r->iplist.next==NULL) {
+                CDS_INIT_LIST_HEAD(&r->iplist);
+            }
+            DEBUG_POLICY("Free fqdn name %s code %x ip_cnt %d\n", r->name, r->code, r->ip_cnt);
+            hdl->records[DPI_FQDN_CODE_BIT(r->code)] = NULL;
+            b->names[i] = hdl->del_name_list[i];
+            b->codes[i] = r->code;
+            th_counter.domains--;
+        }
+        b->name_cnt = hdl->del_name_cnt;
+        hdl->del_name_cnt = 0;
+        cds_list_splice(&hdl->del_wlist, &b->wlist);
+        CDS_INIT_LIST_HEAD(&hdl->del_wlist);
+    }
+
+    if (b == &local) {
+        synchronize_rcu();
+        fqdn_del_batch_free(b);
+        fqdn_del_batch_release(hdl, b);
+        return;
     }
+    b->next = hdl->del_batches;
+    hdl->del_batches = b;
+    dp_reclaim_defer(fqdn_del_batch_free, b);
 }
 
 bool check_fqdn_name_entry(struct cds_lfht_node *ht_node, void *args)
@@ -2068,6 +4449,9 @@ bool check_fqdn_name_entry(struct cds_lfht_node *ht_node, void *args)
             DEBUG_POLICY("Delete fqdn name record %s ref %d\n",
                          entry->r->name, entry->r->ip_cnt);
             rcu_map_del(&ctx->hdl->fqdn_name_map, ht_node);
+            if (entry->r->flag & FQDN_RECORD_WILDCARD) {
+                fqdn_wild_del(ctx->hdl, entry->r);
+            }
         } else {
             // Tell the caller that this record is not deleted successfully
             // due to queue full
@@ -2088,6 +4472,7 @@ bool check_fqdn_ipv4_entry(struct cds_lfht_node *ht_node, void *args)
     }
     cds_list_for_each_entry_safe(r_itr, r_next, &entry->rlist, node) {
         if (r_itr->r->flag & FQDN_RECORD_DELETED) {
+            fqdn_code_clear(entry->codes, r_itr->r->code);
             cds_list_del((struct cds_list_head *)r_itr);
             //free(r_itr);
             cds_list_add_tail((struct cds_list_head *)r_itr, &(ctx->hdl->del_rlist));
@@ -2097,6 +4482,7 @@ bool check_fqdn_ipv4_entry(struct cds_lfht_node *ht_node, void *args)
         if (enqueue_fqdn_ipv4_to_del(ctx->hdl, entry) == 0) {
             DEBUG_POLICY("Delete fqdn ipv4 record %x\n", entry->ip);
             rcu_map_del(&ctx->hdl->fqdn_ipv4_map, ht_node);
+            dpi_policy_cache_invalidate();
         } else {
             // Tell the caller that this record is not deleted successfully
             // due to queue full
@@ -2124,6 +4510,7 @@ void dpi_fqdn_entry_delete_marked()
 
     memset(&ctx, 0, sizeof(ctx));
     ctx.hdl = g_fqdn_hdl;
+    fqdn_del_batch_reap(ctx.hdl);
 
     while (more) {
         ctx.more = false;
@@ -2133,28 +4520,25 @@ void dpi_fqdn_entry_delete_marked()
         more = ctx.more;
 
         if (ctx.hdl->del_name_cnt > 0) {
-            bool rcu_synced = false;
             do {
                 ctx.more = false;
                 rcu_read_lock();
                 rcu_map_for_each(&ctx.hdl->fqdn_ipv4_map, check_fqdn_ipv4_entry, &ctx);
                 rcu_read_unlock();
-                if (ctx.hdl->del_ipv4_cnt > 0) {
-                    rcu_synced = true;
-                    synchronize_rcu();
-                    free_fqdn_ipv4(ctx.hdl);
+                // The names are still looked at by the next passes
+                if (ctx.more) {
+                    fqdn_del_flush(ctx.hdl, false);
                 }
             } while(ctx.more);
-            if (!rcu_synced) {
-                synchronize_rcu();
-            }
-            free_fqdn_name(ctx.hdl);
+            fqdn_del_flush(ctx.hdl, true);
         }
     }
     return;
 }
 
 int dpi_policy_init() {
+    rcu_map_init(&g_policy_hdl_map, 64, offsetof(dpi_policy_hdl_t, node),
+                 policy_hdl_match, policy_hdl_hash);
     g_fqdn_hdl = dpi_fqdn_hdl_init();
     if (g_fqdn_hdl == NULL) {
         DEBUG_ERROR(DBG_POLICY, "Fail to init fqdn hdl!!!\n");
@@ -2178,7 +4562,7 @@ static int ip_fqdn_storage_match(struct cds_lfht_node *ht_node, const void *key)
 static uint32_t ip_fqdn_storage_hash(const void *key)
 {
     const uint32_t *k = key;
-    return sdbm_hash((uint8_t *)k, sizeof(uint32_t));
+    return hash_u32(*k);
 }
 
 static void ip_fqdn_storage_release(timer_entry_t *entry)
@@ -2186,7 +4570,7 @@ static void ip_fqdn_storage_release(timer_entry_t *entry)
     dpi_ip_fqdn_storage_entry_t *c = STRUCT_OF(entry, dpi_ip_fqdn_storage_entry_t, ts_entry);
     rcu_map_del(&th_ip_fqdn_storage_map, c);    
     dp_ctrl_release_ip_fqdn_storage(c);
-    free(c);
+    mem_free(DP_MEM_POLICY, c);
 }
 
 void dpi_ip_fqdn_storage_init(void)
@@ -2196,16 +4580,16 @@ void dpi_ip_fqdn_storage_init(void)
 
 static void add_ip_fqdn_storage_entry(char *name, uint32_t ip)
 {
-    dpi_ip_fqdn_storage_entry_t *entry = calloc(1, sizeof(*entry));
+    dpi_ip_fqdn_storage_entry_t *entry = mem_calloc(DP_MEM_POLICY, 1, sizeof(*entry));
     if (!entry) {
         DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
         return;
     }
 
-    dpi_ip_fqdn_storage_record_t *r = calloc(1, sizeof(*r));
+    dpi_ip_fqdn_storage_record_t *r = mem_calloc(DP_MEM_POLICY, 1, sizeof(*r));
     if (!r) {
         DEBUG_ERROR(DBG_POLICY, "OOM!!!\n");
-        free(entry);
+        mem_free(DP_MEM_POLICY, entry);
         return;
     }
     r->ip = ip;
@@ -45,6 +45,7 @@ typedef struct dpi_rule_ {
     struct cds_lfht_node node;
     dpi_policy_desc_t desc;
     dpi_rule_key_t key;
+    uint32_t src_id;            // id of the configured rule, desc.id can be an app rule's
 } dpi_rule_t;
 
 typedef struct dpi_range_rule_key_ {
@@ -60,26 +61,213 @@ typedef struct dpi_range_rule_item_ {
     dpi_policy_desc_t desc;
     dpi_rule_key_t key_l;
     dpi_rule_key_t key_h;
+    uint32_t src_id;
 } dpi_range_rule_item_t;
 
+// Decision tree over the rules of a range rule bucket, built when the policy is complete.
+// Inner nodes split one field at a threshold, leaves list the rules that can match the
+// region in list order.
+enum {
+    DPI_RANGE_DIM_DPORT = 0,
+    DPI_RANGE_DIM_SIP,
+    DPI_RANGE_DIM_DIP,
+    DPI_RANGE_DIM_APP,
+    DPI_RANGE_DIMS,
+    DPI_RANGE_DIM_LEAF = DPI_RANGE_DIMS,
+};
+
+typedef struct dpi_range_node_ {
+    uint32_t thr;               // go left if the field <= thr
+    uint8_t dim;
+    uint8_t pad;
+    uint16_t count;             // leaf: number of rules
+    uint32_t left;              // leaf: first entry in leaf_rules
+    uint32_t right;
+} dpi_range_node_t;
+
+typedef struct dpi_range_bound_ {
+    uint32_t l[DPI_RANGE_DIMS]; // host order
+    uint32_t h[DPI_RANGE_DIMS];
+    dpi_range_rule_item_t *item;
+} dpi_range_bound_t;
+
+typedef struct dpi_range_tree_ {
+    dpi_range_node_t *nodes;
+    uint32_t node_count;
+    uint32_t leaf_count;
+    uint32_t *leaf_rules;
+    dpi_range_bound_t *rules;
+    uint32_t rule_count;
+} dpi_range_tree_t;
+
 typedef struct dpi_range_rule_ {
     struct cds_lfht_node node;
     dpi_range_rule_key_t key;
     dpi_range_rule_item_t *range_rule_list;
+    dpi_range_tree_t *tree;     // NULL if the list is short or the tree can't be built
+    bool dirty;                 // the list changed since the tree was built
 } dpi_range_rule_t;
 
+// Compiled form of the ipv4 rules of a handle, in one allocation with offsets instead of
+// pointers. Exact rules and range buckets are found through open addressed indexes, each
+// array is in the order of its index slots. Bucket items keep the list order, with bounds
+// in host order as in the decision trees; tree nodes and leaf entries are relative to the
+// first ones of the bucket.
+#define POLICY_BLOB_NONE    0xffffffff
+
+typedef struct dpi_policy_blob_rule_ {
+    dpi_rule_key_t key;
+    dpi_policy_desc_t desc;
+} dpi_policy_blob_rule_t;
+
+typedef struct dpi_policy_blob_item_ {
+    uint32_t l[DPI_RANGE_DIMS];
+    uint32_t h[DPI_RANGE_DIMS];
+    dpi_policy_desc_t desc;
+} dpi_policy_blob_item_t;
+
+typedef struct dpi_policy_blob_bucket_ {
+    dpi_range_rule_key_t key;
+    uint32_t item;              // first item
+    uint32_t items;
+    uint32_t node;              // root of the tree, POLICY_BLOB_NONE for a short list
+    uint32_t leaf;              // first leaf entry
+} dpi_policy_blob_bucket_t;
+
+typedef struct dpi_policy_blob_ {
+    uint32_t size;
+    uint32_t rules;
+    uint32_t rule_mask;         // index slots - 1
+    uint32_t buckets;
+    uint32_t bucket_mask;
+    uint32_t items;
+    uint32_t nodes;
+    uint32_t leafs;
+    // Offsets from the start of the blob. Index slots hold the array position plus 1.
+    uint32_t rule_off, rule_idx_off;
+    uint32_t bucket_off, bucket_idx_off;
+    uint32_t item_off, node_off, leaf_off;
+    uint32_t pad;
+} dpi_policy_blob_t;
+
+// A rule that was left out because an earlier rule already covers its key. It is added again
+// when rules are deleted from the handle.
+typedef struct dpi_policy_shadow_ {
+    struct dpi_policy_shadow_ *next;
+    dpi_rule_key_t key_l;
+    dpi_rule_key_t key_h;
+    bool range;
+    int dir;
+    dpi_policy_desc_t desc;
+    int app_num;
+    dpi_policy_app_rule_t app_rules[0];
+} dpi_policy_shadow_t;
+
+typedef struct dpi_rule6_key_ {
+    struct in6_addr sip;
+    struct in6_addr dip;
+    uint16_t dport;
+    uint16_t proto;
+    uint32_t app;
+} dpi_rule6_key_t;
+
+typedef struct dpi_rule6_ {
+    struct cds_lfht_node node;
+    dpi_policy_desc_t desc;
+    dpi_rule6_key_t key;
+} dpi_rule6_t;
+
+// ipv6 range rules are bucketed by the /64 prefix of the workload address and, if the peer
+// range stays in one /64, by the peer prefix too. Rules of wider peer ranges are in the
+// bucket flagged DP_RANGE_RULE_WIDE, with a zero peer prefix.
+typedef struct dpi_range_rule6_key_ {
+    uint64_t local;             // network order
+    uint64_t peer;
+    uint16_t proto;
+    uint16_t flag;
+#define DP_RANGE_RULE_WIDE       4
+    uint32_t pad;
+} dpi_range_rule6_key_t;
+
+typedef struct dpi_range_rule6_item_ {
+    struct dpi_range_rule6_item_ *next;
+    dpi_policy_desc_t desc;
+    dpi_rule6_key_t key_l;
+    dpi_rule6_key_t key_h;
+    uint32_t seq;               // order of addition, the first added of two buckets wins
+} dpi_range_rule6_item_t;
+
+typedef struct dpi_range_rule6_ {
+    struct cds_lfht_node node;
+    dpi_range_rule6_key_t key;
+    dpi_range_rule6_item_t *range_rule_list;
+} dpi_range_rule6_t;
+
+// Per-thread cache of the decisions of a policy handle, direct mapped. An entry is valid
+// for the handle version and the generation of the tables the decision depends on.
+#define DPI_POLICY_CACHE_SIZE   256
+
+typedef struct dpi_policy_cache_entry_ {
+    uint32_t sip;
+    uint32_t dip;
+    uint32_t app;
+    uint16_t dport;
+    uint8_t proto;
+    uint8_t flags;
+#define POLICY_CACHE_VALID     0x01
+#define POLICY_CACHE_INGRESS   0x02
+#define POLICY_CACHE_NBE       0x04
+    uint32_t gen;
+    dpi_policy_desc_t desc;
+} dpi_policy_cache_entry_t;
+
+typedef struct dpi_policy_cache_ {
+    dpi_policy_cache_entry_t entry[DPI_POLICY_CACHE_SIZE];
+} dpi_policy_cache_t;
+
+// What a delta changed, so sessions decided with the version before it are only looked up again
+// if their proto and port fall in one of the ranges. Proto 0 is any.
+#define POLICY_SCOPE_MAX 16
+typedef struct dpi_policy_scope_ {
+    uint16_t from_ver;
+    uint16_t count;
+    bool all;                   // too many ranges
+    struct {
+        uint16_t proto;
+        uint16_t port_lo;
+        uint16_t port_hi;
+    } ports[POLICY_SCOPE_MAX];
+} dpi_policy_scope_t;
+
 typedef struct dpi_policy_hdl_ {
+    struct cds_lfht_node node;  // in the shared hdl map
     uint16_t ref_cnt;
     uint16_t ver;
     rcu_map_t policy_map;
     rcu_map_t range_policy_map;
+    dpi_policy_blob_t *blob;    // lookups of ipv4 rules, the maps if NULL; rcu
     int def_action;
     int apply_dir;
+    uint32_t order;             // of the last added rule
+    uint32_t entries;           // rule entries in the maps
+    dpi_policy_shadow_t *shadows;
     uint32_t flag;
 #define POLICY_HDL_FLAG_FQDN   0x01
+#define POLICY_HDL_FLAG_IPV6   0x02     // the ipv6 maps are set up
+#define POLICY_HDL_FLAG_SHARED 0x04     // in the shared hdl map under its digest
+#define POLICY_HDL_FLAG_NOSHARE 0x08    // some rules could not be added
+    uint64_t digest;
+    rcu_map_t policy6_map;
+    rcu_map_t range_policy6_map;
+    uint32_t range6_seq;
+    dpi_policy_cache_t *cache[MAX_DP_THREADS];  // allocated by each dp thread on first use
+    dpi_policy_scope_t *scope;  // of the change to the current version, rcu
+    uint16_t fqdn_words;        // used words of fqdn_codes
+    bitmap_type fqdn_codes[DPI_FQDN_CODE_WORDS];    // of the fqdn rules
 } dpi_policy_hdl_t;
 
 #define DPI_POLICY_HAS_FQDN(hdl) (hdl->flag & POLICY_HDL_FLAG_FQDN)
+#define DPI_POLICY_HAS_IPV6(hdl) (hdl->flag & POLICY_HDL_FLAG_IPV6)
 
 #define DPI_POLICY_LOG_VIOLATE(action) (action > DP_POLICY_ACTION_CHECK_APP)
 
@@ -96,8 +284,10 @@ void dpi_policy_hdl_destroy(dpi_policy_hdl_t *hdl);
 int dpi_policy_lookup(dpi_packet_t *p, dpi_policy_hdl_t *hdl, uint32_t app,
                       bool to_server, bool xff, dpi_policy_desc_t *desc, uint32_t xff_replace_dst_ip);
 int dpi_policy_reeval(dpi_packet_t *p, bool to_server);
+extern uint32_t g_policy_scope_seq;
 int dpi_policy_init();
 int snooped_fqdn_ipv4_mapping(char *name, uint32_t *ip, int cnt);
+bool snooped_fqdn_name_wanted(const char *name);
 int sniff_ip_fqdn_storage(char *name, uint32_t *ip, int cnt);
 void dpi_unknown_ip_init(void);
 void dpi_ip_fqdn_storage_init(void);
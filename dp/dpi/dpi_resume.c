@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "urcu.h"
+
+#include "utils/helper.h"
+#include "utils/seqlock.h"
+
+#include "dpi/dpi_module.h"
+
+// With -R, each dp thread keeps the tuples, direction and policy decision of its TCP sessions
+// in a named shm segment that outlives the process. A dp restarted within DPI_RESUME_MAX_AGE
+// finds the records of the previous run and, for DPI_RESUME_WINDOW seconds, a mid-stream TCP
+// packet that matches one is opened in the recorded direction with the recorded decision
+// instead of a guessed direction and no policy. The decision is marked to be checked again,
+// it is only used until the agent pushes the endpoint's policy.
+//
+// The records of a thread are direct mapped by a hash that doesn't depend on the packet
+// direction, a new session takes the slot over. Policy handles are pointers of the old
+// process, only the decisions are kept.
+
+#define DPI_RESUME_MAGIC     0x44505253
+#define DPI_RESUME_VERSION   1
+
+#define DPI_RESUME_SLOT_BITS 16
+#define DPI_RESUME_SLOTS     (1 << DPI_RESUME_SLOT_BITS)
+
+#define DPI_RESUME_MAX_AGE   60     // seconds the segment can be left unattended
+#define DPI_RESUME_WINDOW    30     // seconds sessions are resumed after a start
+
+#define RESUME_FLAG_IPV6     0x01
+
+typedef struct dpi_resume_rec_ {
+    seqlock_t lock;
+    uint32_t gen;           // run that saved the record, 0 if free
+    uint8_t ip_proto;
+    uint8_t flags;
+    uint16_t client_port, server_port;
+    uint16_t pad;
+    io_ip_t client_ip, server_ip;
+    dpi_policy_desc_t desc;
+} dpi_resume_rec_t;
+
+typedef struct dpi_resume_hdr_ {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t rec_size;
+    uint32_t threads;
+    uint32_t slots;
+    uint32_t gen;
+    uint32_t updated_at;    // wall clock seconds, refreshed by the ctrl thread
+    uint8_t pad[40];
+} dpi_resume_hdr_t;
+
+typedef struct dpi_resume_shm_ {
+    dpi_resume_hdr_t hdr;
+    dpi_resume_rec_t recs[MAX_DP_THREADS][DPI_RESUME_SLOTS];
+} dpi_resume_shm_t;
+
+static dpi_resume_shm_t *g_resume;
+// Generation of the previous run while its sessions can be resumed, 0 otherwise
+static uint32_t g_resume_prev_gen;
+static time_t g_resume_until;
+static uint32_t g_resume_hits;
+
+static __thread dpi_policy_desc_t t_resume_desc;
+
+static uint32_t resume_hash(const io_ip_t *ip1, const io_ip_t *ip2, uint16_t port1, uint16_t port2,
+                            uint8_t ip_proto)
+{
+    const uint32_t *a = (const uint32_t *)ip1, *b = (const uint32_t *)ip2;
+    uint32_t h = ((uint32_t)(port1 ^ port2) * 0x10001) ^ ip_proto;
+    int i;
+
+    for (i = 0; i < sizeof(io_ip_t) / sizeof(uint32_t); i ++) {
+        h ^= a[i] ^ b[i];
+    }
+    return (h * 0x9e3779b1) >> (32 - DPI_RESUME_SLOT_BITS);
+}
+
+static void resume_key(dpi_session_t *s, io_ip_t *cip, io_ip_t *sip)
+{
+    memset(cip, 0, sizeof(*cip));
+    memset(sip, 0, sizeof(*sip));
+    if (s->flags & DPI_SESS_FLAG_IPV4) {
+        cip->ip4 = s->client.ip.ip4;
+        sip->ip4 = s->server.ip.ip4;
+    } else {
+        cip->ip6 = s->client.ip.ip6;
+        sip->ip6 = s->server.ip.ip6;
+    }
+}
+
+static dpi_resume_rec_t *resume_slot(dpi_session_t *s, io_ip_t *cip, io_ip_t *sip)
+{
+    resume_key(s, cip, sip);
+    return &g_resume->recs[g_dpi_thread - g_dpi_thread_data]
+                           [resume_hash(cip, sip, s->client.port, s->server.port, s->ip_proto)];
+}
+
+static bool resume_rec_match(const dpi_resume_rec_t *r, const io_ip_t *cip, const io_ip_t *sip,
+                             uint16_t cport, uint16_t sport, uint8_t ip_proto, uint8_t ipv6)
+{
+    return r->ip_proto == ip_proto && (r->flags & RESUME_FLAG_IPV6) == ipv6 &&
+           r->client_port == cport && r->server_port == sport &&
+           memcmp(&r->client_ip, cip, sizeof(*cip)) == 0 && memcmp(&r->server_ip, sip, sizeof(*sip)) == 0;
+}
+
+void dpi_resume_save(dpi_session_t *s)
+{
+    dpi_resume_rec_t *r;
+    io_ip_t cip, sip;
+
+    if (likely(g_resume == NULL)) {
+        return;
+    }
+
+    r = resume_slot(s, &cip, &sip);
+
+    seqlock_write_begin(&r->lock);
+    r->gen = g_resume->hdr.gen;
+    r->ip_proto = s->ip_proto;
+    r->flags = s->flags & DPI_SESS_FLAG_IPV4 ? 0 : RESUME_FLAG_IPV6;
+    r->client_port = s->client.port;
+    r->server_port = s->server.port;
+    r->client_ip = cip;
+    r->server_ip = sip;
+    r->desc = s->policy_desc;
+    seqlock_write_end(&r->lock);
+}
+
+void dpi_resume_drop(dpi_session_t *s)
+{
+    dpi_resume_rec_t *r;
+    io_ip_t cip, sip;
+
+    if (likely(g_resume == NULL)) {
+        return;
+    }
+
+    r = resume_slot(s, &cip, &sip);
+
+    // The slot can belong to a newer session by now
+    if (r->gen != g_resume->hdr.gen ||
+        !resume_rec_match(r, &cip, &sip, s->client.port, s->server.port, s->ip_proto,
+                          s->flags & DPI_SESS_FLAG_IPV4 ? 0 : RESUME_FLAG_IPV6)) {
+        return;
+    }
+
+    seqlock_write_begin(&r->lock);
+    r->gen = 0;
+    seqlock_write_end(&r->lock);
+}
+
+// Copy a record of the previous run. Its writer may have died while updating it.
+static bool resume_read(const dpi_resume_rec_t *r, dpi_resume_rec_t *out)
+{
+    uint32_t seq = __atomic_load_n(&r->lock.seq, __ATOMIC_ACQUIRE);
+
+    if ((seq & 1) || r->gen != g_resume_prev_gen) {
+        return false;
+    }
+    *out = *r;
+    return !seqlock_read_retry(&r->lock, seq) && out->gen == g_resume_prev_gen;
+}
+
+// Look for the session of a mid-stream TCP packet in the records of all threads, the
+// previous run could have had another number of threads. On a hit, the direction and
+// p->resume_desc are set.
+bool dpi_resume_lookup(dpi_packet_t *p, bool *to_server)
+{
+    io_ip_t src, dst;
+    uint8_t ipv6;
+    uint32_t slot;
+    int i;
+
+    if (likely(CMM_LOAD_SHARED(g_resume_prev_gen) == 0)) {
+        return false;
+    }
+
+    memset(&src, 0, sizeof(src));
+    memset(&dst, 0, sizeof(dst));
+    if (p->eth_type == ETH_P_IP) {
+        struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
+        src.ip4 = iph->saddr;
+        dst.ip4 = iph->daddr;
+        ipv6 = 0;
+    } else {
+        struct ip6_hdr *ip6h = (struct ip6_hdr *)(p->pkt + p->l3);
+        src.ip6 = ip6h->ip6_src;
+        dst.ip6 = ip6h->ip6_dst;
+        ipv6 = RESUME_FLAG_IPV6;
+    }
+
+    slot = resume_hash(&src, &dst, p->sport, p->dport, p->ip_proto);
+    for (i = 0; i < g_resume->hdr.threads; i ++) {
+        dpi_resume_rec_t r;
+
+        if (!resume_read(&g_resume->recs[i][slot], &r)) {
+            continue;
+        }
+        if (resume_rec_match(&r, &src, &dst, p->sport, p->dport, p->ip_proto, ipv6)) {
+            *to_server = true;
+        } else if (resume_rec_match(&r, &dst, &src, p->dport, p->sport, p->ip_proto, ipv6)) {
+            *to_server = false;
+        } else {
+            continue;
+        }
+
+        t_resume_desc = r.desc;
+        p->resume_desc = &t_resume_desc;
+        uatomic_inc(&g_resume_hits);
+
+        DEBUG_LOG(DBG_SESSION, p, "resume to_server=%d policy="DP_POLICY_DESC_STR"\n",
+                  *to_server, DP_POLICY_DESC((&r.desc)));
+        return true;
+    }
+
+    return false;
+}
+
+static bool resume_hdr_valid(const dpi_resume_hdr_t *hdr, time_t now)
+{
+    return hdr->magic == DPI_RESUME_MAGIC && hdr->version == DPI_RESUME_VERSION &&
+           hdr->rec_size == sizeof(dpi_resume_rec_t) && hdr->slots == DPI_RESUME_SLOTS &&
+           hdr->threads <= MAX_DP_THREADS && hdr->gen != 0 &&
+           now >= hdr->updated_at && now - hdr->updated_at <= DPI_RESUME_MAX_AGE;
+}
+
+// Before the dp threads start. Sessions of the previous run are resumed if it left a
+// segment recently enough, otherwise the segment is cleared.
+int dpi_resume_init(const char *shm_name)
+{
+    dpi_resume_shm_t *shm = MAP_FAILED;
+    time_t now = time(NULL);
+    struct stat st;
+    int fd;
+
+    st.st_size = 0;
+    fd = shm_open(shm_name, O_CREAT | O_RDWR, S_IRWXU | S_IRWXG);
+    if (fd >= 0) {
+        if (fstat(fd, &st) == 0 &&
+            (st.st_size == sizeof(dpi_resume_shm_t) || ftruncate(fd, sizeof(dpi_resume_shm_t)) == 0)) {
+            shm = mmap(NULL, sizeof(dpi_resume_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+    }
+    if (shm == MAP_FAILED) {
+        DEBUG_ERROR(DBG_CTRL, "fail to map session table: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (st.st_size == sizeof(dpi_resume_shm_t) && resume_hdr_valid(&shm->hdr, now)) {
+        g_resume_prev_gen = shm->hdr.gen;
+        g_resume_until = now + DPI_RESUME_WINDOW;
+        DEBUG_INIT("resume sessions of gen=%u, saved %lus ago\n",
+                   g_resume_prev_gen, (unsigned long)(now - shm->hdr.updated_at));
+    } else {
+        memset(shm, 0, sizeof(*shm));
+    }
+
+    shm->hdr.magic = DPI_RESUME_MAGIC;
+    shm->hdr.version = DPI_RESUME_VERSION;
+    shm->hdr.rec_size = sizeof(dpi_resume_rec_t);
+    shm->hdr.slots = DPI_RESUME_SLOTS;
+    shm->hdr.threads = MAX_DP_THREADS;
+    shm->hdr.gen = g_resume_prev_gen + 1 != 0 ? g_resume_prev_gen + 1 : 1;
+    shm->hdr.updated_at = now;
+
+    g_resume = shm;
+    return 0;
+}
+
+// On the ctrl timer, tell the next run the segment is alive and end the resume window
+void dpi_resume_timer(void)
+{
+    time_t now;
+
+    if (g_resume == NULL) {
+        return;
+    }
+
+    now = time(NULL);
+    g_resume->hdr.updated_at = now;
+
+    if (g_resume_prev_gen != 0 && now >= g_resume_until) {
+        CMM_STORE_SHARED(g_resume_prev_gen, 0);
+        DEBUG_CTRL("resumed sessions=%u\n", uatomic_read(&g_resume_hits));
+    }
+}
@@ -3,6 +3,8 @@
 #include <netinet/icmp6.h>
 
 #include "utils/helper.h"
+#include "utils/cksum.h"
+#include "utils/hash.h"
 
 #include "dpi/dpi_module.h"
 
@@ -12,7 +14,6 @@
 #define SESS_TIMEOUT_TCP_HALF_CLOSE     90
 #define SESS_TIMEOUT_TCP_CLOSE          15
 #define SESS_TIMEOUT_TCP_RST            60
-#define SESS_TIMEOUT_TCP_SHORT          2
 #define SESS_TIMEOUT_IP   15
 #define SESS_TIMEOUT_UDP  30
 #define SESS_TIMEOUT_ICMP 5
@@ -25,99 +26,65 @@
 #define SESS_SMALL_WINDOW_DROP          (4 * 1024)
 #define SESS_SMALL_WINDOW_SIZE          16
 
-#define SESS_FLAGS_FOR_LOOKUP (DPI_SESS_FLAG_INGRESS | DPI_SESS_FLAG_FAKE_EP)
+#define SESS_EVICT_SAMPLES 16    // sessions looked at to pick one to evict
+#define SESS_REEVAL_BUDGET 1024  // sessions the policy sweep looks at per tick
+
+#define SESS_FLAGS_FOR_LOOKUP (DPI_SESS_FLAG_INGRESS | DPI_SESS_FLAG_FAKE_EP | DPI_SESS_FLAG_PROXYMESH)
 
 extern bool cmp_mac_prefix(void *m1, void *prefix);
+extern void dpi_dlp_close_stream(dpi_wing_t *w);
+extern int dpi_dns_udp_snoop(dpi_packet_t *p);
 
 static void dpi_session_tick_timeout(timer_entry_t *n);
 static void tcp_scan_detection_release(dpi_session_t *s);
 
-static int session4_proxymesh_match(struct cds_lfht_node *ht_node, const void *key)
+// Proxymesh sessions, seen on "lo" of a pod, are in the same maps in their own key space,
+// DPI_SESS_FLAG_PROXYMESH. They are keyed by the client side only, because the server address
+// of a session redirected to the sidecar changes once the return packet shows the real one.
+static inline bool session4_match(const void *data, const void *key)
 {
-    dpi_session_t *s = STRUCT_OF(ht_node, dpi_session_t, node);
-    const dpi_session_t *k = key;
-    int matched = 0;
-
-    if (s->client.ip.ip4 == k->client.ip.ip4 &&
-        s->client.port == k->client.port && 
-        s->ip_proto == k->ip_proto) {
-        matched = 1;
-        if (s->server.ip.ip4 == htonl(INADDR_LOOPBACK) && 
-            s->client.ip.ip4 != htonl(INADDR_LOOPBACK)) {
-            s->server.ip.ip4 = k->server.ip.ip4;
-            s->server.port = k->server.port;
-            //return packet from svr shows correct svr ip
-            //instead of 127.0.0.1, this is for istio
-            FLAGS_SET(s->flags, DPI_SESS_FLAG_MESH_TO_SVR);
+    const dpi_session_t *s = data, *k = key;
 
-            s->policy_desc.flags &= ~(POLICY_DESC_INTERNAL|POLICY_DESC_EXTERNAL);
-            if (FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS)) {
-                s->policy_desc.flags |= dpi_is_ip4_internal(s->client.ip.ip4)?
-                                   POLICY_DESC_INTERNAL:POLICY_DESC_EXTERNAL;
-            } else {
-                s->policy_desc.flags |= dpi_is_ip4_internal(s->server.ip.ip4)?
-                                   POLICY_DESC_INTERNAL:POLICY_DESC_EXTERNAL;
-            }
-        }
+    if (unlikely(k->flags & DPI_SESS_FLAG_PROXYMESH)) {
+        return (s->flags & DPI_SESS_FLAG_PROXYMESH) &&
+               s->client.ip.ip4 == k->client.ip.ip4 && s->client.port == k->client.port &&
+               s->ip_proto == k->ip_proto;
     }
-
-    return matched;
-}
-
-static int session4_match(struct cds_lfht_node *ht_node, const void *key)
-{
-    dpi_session_t *s = STRUCT_OF(ht_node, dpi_session_t, node);
-    const dpi_session_t *k = key;
-
     return s->client.ip.ip4 == k->client.ip.ip4 && s->server.ip.ip4 == k->server.ip.ip4 &&
            s->client.port == k->client.port && s->server.port == k->server.port &&
            s->ip_proto == k->ip_proto &&
            (s->flags & SESS_FLAGS_FOR_LOOKUP) == (k->flags & SESS_FLAGS_FOR_LOOKUP);
 }
 
-static uint32_t session4_proxymesh_hash(const void *key)
-{
-    const dpi_session_t *k = key;
-    uint32_t port = k->client.port;
-
-    return sdbm_hash((uint8_t *)&k->client.ip, 4) +
-           sdbm_hash((uint8_t *)&port, sizeof(port));
-}
-
-static uint32_t session4_hash(const void *key)
+// CRC32C of the tuple packed in 64 bits, so the low bits that pick the home slot in the
+// session map are well spread.
+static inline uint32_t session_hash_mix(uint64_t ips, uint32_t ports)
 {
-    const dpi_session_t *k = key;
-    uint32_t port = (k->client.port << 16) + k->server.port;
+    uint32_t k[3] = {(uint32_t)(ips >> 32), (uint32_t)ips, ports};
 
-    return sdbm_hash((uint8_t *)&k->client.ip, 4) +
-           sdbm_hash((uint8_t *)&k->server.ip, 4) +
-           sdbm_hash((uint8_t *)&port, sizeof(port));
+    return hash_key(k, sizeof(k));
 }
 
-static int session6_proxymesh_match(struct cds_lfht_node *ht_node, const void *key)
+static inline uint32_t session4_hash(const void *key)
 {
-    dpi_session_t *s = STRUCT_OF(ht_node, dpi_session_t, node);
     const dpi_session_t *k = key;
-    int matched = 0;
 
-    if (memcmp(&s->client.ip, &k->client.ip, sizeof(k->client.ip)) == 0 &&
-        s->client.port == k->client.port && s->ip_proto == k->ip_proto) {
-        matched = 1;
-        if (memcmp((uint8_t *)&s->server.ip, (uint8_t *)(in6addr_loopback.s6_addr), sizeof(s->server.ip)) == 0 &&
-            memcmp((uint8_t *)&s->client.ip, (uint8_t *)(in6addr_loopback.s6_addr), sizeof(s->client.ip)) != 0) {
-            memcpy(&s->server.ip, &k->server.ip, sizeof(s->server.ip));
-            s->server.port = k->server.port;
-        }
+    if (unlikely(k->flags & DPI_SESS_FLAG_PROXYMESH)) {
+        return session_hash_mix((uint64_t)k->client.ip.ip4 << 32, (uint32_t)k->client.port << 16);
     }
-
-    return matched;
+    return session_hash_mix(((uint64_t)k->client.ip.ip4 << 32) | k->server.ip.ip4,
+                            ((uint32_t)k->client.port << 16) | k->server.port);
 }
 
-static int session6_match(struct cds_lfht_node *ht_node, const void *key)
+static inline bool session6_match(const void *data, const void *key)
 {
-    dpi_session_t *s = STRUCT_OF(ht_node, dpi_session_t, node);
-    const dpi_session_t *k = key;
+    const dpi_session_t *s = data, *k = key;
 
+    if (unlikely(k->flags & DPI_SESS_FLAG_PROXYMESH)) {
+        return (s->flags & DPI_SESS_FLAG_PROXYMESH) &&
+               memcmp(&s->client.ip, &k->client.ip, sizeof(k->client.ip)) == 0 &&
+               s->client.port == k->client.port && s->ip_proto == k->ip_proto;
+    }
     return memcmp(&s->client.ip, &k->client.ip, sizeof(k->client.ip)) == 0 &&
            memcmp(&s->server.ip, &k->server.ip, sizeof(k->server.ip)) == 0 &&
            s->client.port == k->client.port && s->server.port == k->server.port &&
@@ -125,23 +92,47 @@ static int session6_match(struct cds_lfht_node *ht_node, const void *key)
            (s->flags & SESS_FLAGS_FOR_LOOKUP) == (k->flags & SESS_FLAGS_FOR_LOOKUP);
 }
 
-static uint32_t session6_proxymesh_hash(const void *key)
+static inline uint32_t session6_hash(const void *key)
 {
     const dpi_session_t *k = key;
-    uint32_t port = k->client.port;
+    uint32_t crc = hash_crc32c(&k->client.ip.ip6, sizeof(k->client.ip.ip6), HASH_CRC32C_INIT);
+    uint32_t ports;
 
-    return sdbm_hash((uint8_t *)&k->client.ip, sizeof(k->client.ip)) +
-           sdbm_hash((uint8_t *)&port, sizeof(port));
+    if (unlikely(k->flags & DPI_SESS_FLAG_PROXYMESH)) {
+        ports = (uint32_t)k->client.port << 16;
+    } else {
+        crc = hash_crc32c(&k->server.ip.ip6, sizeof(k->server.ip.ip6), crc);
+        ports = ((uint32_t)k->client.port << 16) | k->server.port;
+    }
+    return hash_finish(hash_crc32c(&ports, sizeof(ports), crc));
 }
 
-static uint32_t session6_hash(const void *key)
+// A proxymesh session to the sidecar at the loopback address takes the server of the packet,
+// the return packet from the server shows its real address instead of 127.0.0.1 (istio).
+static void session_proxymesh_server(dpi_session_t *s, const dpi_session_t *k)
 {
-    const dpi_session_t *k = key;
-    uint32_t port = (k->client.port << 16) + k->server.port;
+    if (likely(s->flags & DPI_SESS_FLAG_IPV4)) {
+        if (s->server.ip.ip4 == htonl(INADDR_LOOPBACK) && s->client.ip.ip4 != htonl(INADDR_LOOPBACK)) {
+            s->server.ip.ip4 = k->server.ip.ip4;
+            s->server.port = k->server.port;
+            FLAGS_SET(s->flags, DPI_SESS_FLAG_MESH_TO_SVR);
 
-    return sdbm_hash((uint8_t *)&k->client.ip, sizeof(k->client.ip)) +
-           sdbm_hash((uint8_t *)&k->server.ip, sizeof(k->server.ip)) +
-           sdbm_hash((uint8_t *)&port, sizeof(port));
+            s->policy_desc.flags &= ~(POLICY_DESC_INTERNAL|POLICY_DESC_EXTERNAL);
+            if (FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS)) {
+                s->policy_desc.flags |= dpi_is_ip4_internal(s->client.ip.ip4)?
+                                   POLICY_DESC_INTERNAL:POLICY_DESC_EXTERNAL;
+            } else {
+                s->policy_desc.flags |= dpi_is_ip4_internal(s->server.ip.ip4)?
+                                   POLICY_DESC_INTERNAL:POLICY_DESC_EXTERNAL;
+            }
+        }
+    } else {
+        if (memcmp((uint8_t *)&s->server.ip, (uint8_t *)(in6addr_loopback.s6_addr), sizeof(s->server.ip)) == 0 &&
+            memcmp((uint8_t *)&s->client.ip, (uint8_t *)(in6addr_loopback.s6_addr), sizeof(s->client.ip)) != 0) {
+            memcpy(&s->server.ip, &k->server.ip, sizeof(s->server.ip));
+            s->server.port = k->server.port;
+        }
+    }
 }
 
 int dpi_session_start_log(dpi_session_t *s, bool xff)
@@ -175,7 +166,7 @@ int dpi_session_start_log(dpi_session_t *s, bool xff)
                      (s->policy_desc.action > DP_POLICY_ACTION_CHECK_APP)?1:0);
         } else {
             ret = g_io_callback->connect_report(&dps, &dpm, 1,
-                     (s->xff_desc.action > DP_POLICY_ACTION_CHECK_APP)?1:0);
+                     (dpi_session_xff(s)->desc.action > DP_POLICY_ACTION_CHECK_APP)?1:0);
         }
         s->last_report = th_snap.tick;
         if (likely(ret > 0)) {
@@ -213,7 +204,7 @@ static void dpi_session_end_log(dpi_session_t *s, int log_violate, bool xff)
         }
         if (likely(!FLAGS_TEST(s->flags, DPI_SESS_FLAG_FAKE_EP))) {
             // Always report if xff policy action is deny/violate; 
-            if (unlikely(s->xff_desc.action > DP_POLICY_ACTION_CHECK_APP)) {
+            if (unlikely(dpi_session_xff(s)->desc.action > DP_POLICY_ACTION_CHECK_APP)) {
                 // See if start_log has been done
                 if (likely(FLAGS_TEST(s->flags, DPI_SESS_FLAG_START_LOGGED))) {
                     g_io_callback->connect_report(&dps, &dpm, 0, log_violate);
@@ -302,21 +293,130 @@ void dpi_session_mid_log(dpi_session_t *s, int log_violate, bool xff)
     s->last_report = th_snap.tick;
 }
 
+// Clips of up to an MTU sized frame come from the thread's pool, larger ones are malloc'ed.
+#define DPI_CLIP_POOL_SIZE 2048
+
+clip_t *dpi_clip_alloc(uint32_t data_len)
+{
+    clip_t *clip;
+
+    if (likely(sizeof(*clip) + data_len <= DPI_CLIP_POOL_SIZE)) {
+        clip = obj_pool_alloc(th_pool(DP_POOL_CLIP));
+        if (clip != NULL) {
+            clip->pooled = 1;
+        }
+    } else {
+        clip = mem_malloc(DP_MEM_ASM, sizeof(*clip) + data_len);
+        if (clip != NULL) {
+            clip->pooled = 0;
+        }
+    }
+    return clip;
+}
+
+void dpi_clip_free(clip_t *clip)
+{
+    if (clip->pooled) {
+        obj_pool_free(th_pool(DP_POOL_CLIP), clip);
+    } else {
+        mem_free(DP_MEM_ASM, clip);
+    }
+}
+
 void dpi_asm_remove(clip_t *clip)
 {
+    if (clip == th_packet.cached_clip) {
+        th_packet.cached_clip = NULL;
+    }
     th_counter.freed_asms ++;
-    free(clip);
+    dpi_clip_free(clip);
 }
 
-int dpi_cache_packet(dpi_packet_t *p, dpi_wing_t *w, bool lookup)
+// A packet cached by reference keeps its payload in the packet until it's done with: the clip is
+// often assembled and flushed within the same packet, then the payload is never copied.
+void dpi_hold_cached_clip(dpi_packet_t *p)
+{
+    clip_t *clip = p->cached_clip;
+
+    if (clip != NULL) {
+        memcpy(clip + 1, clip->ptr, clip->len);
+        clip->ptr = (uint8_t *)(clip + 1);
+        clip->ref = 0;
+        p->cached_clip = NULL;
+    }
+}
+
+// Move the change of the session's reassembly cache to the thread and endpoint totals
+void dpi_session_asm_account(dpi_session_t *s)
+{
+    uint32_t bytes = asm_gross(&s->client.asm_cache) + asm_gross(&s->server.asm_cache);
+    int32_t delta = (int32_t)(bytes - s->asm_bytes);
+    uint8_t *ep_mac = (s->flags & DPI_SESS_FLAG_INGRESS) ? s->server.mac : s->client.mac;
+    io_mac_t *mac;
+
+    if (delta == 0) {
+        return;
+    }
+
+    s->asm_bytes = bytes;
+    th_counter.asm_bytes += delta;
+    mac = rcu_map_lookup(&g_ep_map, ep_mac);
+    if (mac != NULL) {
+        uatomic_add(&mac->ep->asm_bytes, delta);
+    }
+}
+
+static bool dpi_asm_over_budget(dpi_packet_t *p, dpi_wing_t *w)
+{
+    uint32_t len = p->raw.len;
+
+    if (g_io_config->asm_wing_limit > 0 &&
+        asm_gross(&w->asm_cache) + len > g_io_config->asm_wing_limit) {
+        return true;
+    }
+    if (g_io_config->asm_thread_limit > 0 &&
+        th_counter.asm_bytes + len > g_io_config->asm_thread_limit) {
+        return true;
+    }
+    if (g_io_config->asm_ep_limit > 0 &&
+        uatomic_read(&p->ep->asm_bytes) + len > g_io_config->asm_ep_limit) {
+        return true;
+    }
+    return false;
+}
+
+// Drop the cache of the session and stop reassembling it, only in-order data is inspected from
+// now on. Unlike a cache overrun, the session isn't bypassed.
+static void dpi_session_asm_limit(dpi_packet_t *p)
+{
+    dpi_session_t *s = p->session;
+
+    DEBUG_LOG(DBG_TCP, p, "Reassembly budget exceeded, asm:%u/%u\n",
+              asm_gross(&s->client.asm_cache), asm_gross(&s->server.asm_cache));
+
+    s->asm_limited = true;
+    asm_destroy(&s->client.asm_cache, dpi_asm_remove);
+    asm_destroy(&s->server.asm_cache, dpi_asm_remove);
+    dpi_session_asm_account(s);
+    th_counter.asm_limits ++;
+}
+
+int dpi_cache_packet(dpi_packet_t *p, dpi_wing_t *w, bool lookup, bool ref)
 {
     clip_t *clip;
 
     if (lookup && (asm_lookup(&w->asm_cache, p->raw.seq) != NULL)) {
         return -1;
     }
+    if (unlikely(p->session->asm_limited)) {
+        return -1;
+    }
+    if (unlikely(dpi_asm_over_budget(p, w))) {
+        dpi_session_asm_limit(p);
+        return -1;
+    }
 
-    clip = malloc(sizeof(*clip) + p->raw.len);
+    clip = dpi_clip_alloc(p->raw.len);
     if (clip == NULL) {
         return -1;
     }
@@ -325,8 +425,15 @@ int dpi_cache_packet(dpi_packet_t *p, dpi_wing_t *w, bool lookup)
     clip->seq = p->raw.seq;
     clip->skip = 0;
     clip->len = p->raw.len;
-    clip->ptr = (uint8_t *)(clip + 1);
-    memcpy(clip->ptr, p->raw.ptr, p->raw.len);
+    if (ref && p->cached_clip == NULL) {
+        clip->ptr = p->raw.ptr;
+        clip->ref = 1;
+        p->cached_clip = clip;
+    } else {
+        clip->ptr = (uint8_t *)(clip + 1);
+        clip->ref = 0;
+        memcpy(clip->ptr, p->raw.ptr, p->raw.len);
+    }
 
     if (asm_insert(&w->asm_cache, clip) == ASM_FAILURE) {
         // DEBUG_ERROR(DBG_TCP, "Fail to cache because packet duplication\n");
@@ -335,6 +442,7 @@ int dpi_cache_packet(dpi_packet_t *p, dpi_wing_t *w, bool lookup)
     } else {
         DEBUG_LOG(DBG_TCP, p, "Cache packet, len=%u\n", p->raw.len);
         p->flags |= DPI_PKT_FLAG_CACHED;
+        dpi_session_asm_account(p->session);
     }
 
     return 0;
@@ -367,23 +475,54 @@ static inline void dpi_session_timer_remove(dpi_session_t *s)
     timer_wheel_entry_remove(&th_timer, &s->ts_entry);
 }
 
-void dpi_session_start_tick_for(dpi_session_t *s, uint8_t flag, dpi_packet_t *p)
+// First tick a check of the session can fire at, 0 if none is pending
+static uint32_t dpi_session_tick_deadline(dpi_session_t *s)
 {
-    if (likely(s->tick_flags == 0)) {
-        DEBUG_LOG(DBG_SESSION, p, "Start session tick\n");
+    uint32_t deadline = 0, d;
 
-        dpi_session_set_tick(s, flag);
-        timer_wheel_entry_start(&th_timer, &s->tick_entry,
-                                dpi_session_tick_timeout, SESS_TIMEOUT_TCP_SHORT, th_snap.tick);
-    } else {
-        dpi_session_set_tick(s, flag);
+    if (dpi_session_check_tick(s, DPI_SESS_TICK_FLAG_SMALL_WINDOWS) && s->small_window_tick > 0) {
+        deadline = s->small_window_tick + SESS_SMALL_WINDOW_DURATION;
+    }
+    if (dpi_session_check_tick(s, DPI_SESS_TICK_FLAG_SLOWLORIS) && s->parser_data != NULL &&
+        s->parser_data[DPI_PARSER_HTTP] != NULL) {
+        d = dpi_http_tick_deadline(s, s->parser_data[DPI_PARSER_HTTP]);
+        if (d > 0 && (deadline == 0 || d < deadline)) {
+            deadline = d;
+        }
     }
+    return deadline;
 }
 
-static inline void dpi_session_resume_tick(dpi_session_t *s)
+// Rather than every few seconds, the tick fires at the first deadline. A deadline that
+// moves later, as the last body packet of a slowloris check, is found when it fires.
+static void dpi_session_arm_tick(dpi_session_t *s)
 {
-    timer_wheel_entry_start(&th_timer, &s->tick_entry,
-                            dpi_session_tick_timeout, SESS_TIMEOUT_TCP_SHORT, th_snap.tick);
+    uint32_t deadline = dpi_session_tick_deadline(s);
+    bool active = timer_wheel_entry_is_active(&s->tick_entry);
+
+    if (deadline == 0) {
+        if (active) {
+            timer_wheel_entry_remove(&th_timer, &s->tick_entry);
+        }
+        return;
+    }
+    if (active) {
+        if (th_snap.tick + timer_wheel_entry_get_life(&s->tick_entry, th_snap.tick) <= deadline) {
+            return;
+        }
+        timer_wheel_entry_remove(&th_timer, &s->tick_entry);
+    }
+    timer_wheel_entry_start(&th_timer, &s->tick_entry, dpi_session_tick_timeout,
+                            deadline > th_snap.tick ? deadline - th_snap.tick : 1, th_snap.tick);
+}
+
+void dpi_session_start_tick_for(dpi_session_t *s, uint8_t flag, dpi_packet_t *p)
+{
+    if (likely(s->tick_flags == 0)) {
+        DEBUG_LOG(DBG_SESSION, p, "Start session tick\n");
+    }
+    dpi_session_set_tick(s, flag);
+    dpi_session_arm_tick(s);
 }
 
 void dpi_session_stop_tick_for(dpi_session_t *s, uint8_t flag, dpi_packet_t *p)
@@ -401,14 +540,71 @@ bool dpi_session_is_tick_running(dpi_session_t *s)
     return timer_wheel_entry_is_active(&s->tick_entry);
 }
 
+// Both directions of a flow map to the same slot
+static inline uint32_t session4_cache_slot(uint32_t ip1, uint32_t ip2, uint16_t port1, uint16_t port2)
+{
+    uint32_t h = (ip1 ^ ip2 ^ ((uint32_t)(port1 ^ port2) * 0x10001)) * 0x9e3779b1;
+
+    return h >> (32 - DPI_FLOW_CACHE_BITS);
+}
+
+static inline bool session4_cache_hit(const dpi_session_t *s, uint32_t cip, uint32_t sip,
+                                      uint16_t cport, uint16_t sport, uint8_t ip_proto, uint16_t flags)
+{
+    return s->client.ip.ip4 == cip && s->server.ip.ip4 == sip &&
+           s->client.port == cport && s->server.port == sport && s->ip_proto == ip_proto &&
+           (s->flags & SESS_FLAGS_FOR_LOOKUP) == flags;
+}
+
+// Long runs of packets of one flow skip the hash and the map probe. The cache entry is
+// cleared by dpi_session_release().
+static inline dpi_session_t *session4_cache_lookup(dpi_packet_t *p, uint32_t slot, bool ingress)
+{
+    struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
+    dpi_session_t *s = th_flow_cache[slot];
+
+    if (s == NULL) {
+        return NULL;
+    }
+    if (session4_cache_hit(s, iph->saddr, iph->daddr, p->sport, p->dport, p->ip_proto,
+                           ingress ? DPI_SESS_FLAG_INGRESS : 0)) {
+        dpi_set_client_pkt(p);
+        p->this_wing = &s->client;
+        p->that_wing = &s->server;
+        return s;
+    }
+    if (session4_cache_hit(s, iph->daddr, iph->saddr, p->dport, p->sport, p->ip_proto,
+                           !ingress ? DPI_SESS_FLAG_INGRESS : 0)) {
+        p->this_wing = &s->server;
+        p->that_wing = &s->client;
+        return s;
+    }
+    return NULL;
+}
+
 dpi_session_t *dpi_session_lookup(dpi_packet_t *p)
 {
     dpi_session_t *s, key;
     bool ingress = !!(p->flags & DPI_PKT_FLAG_INGRESS);
-    bool isproxymesh = cmp_mac_prefix(p->ep_mac, PROXYMESH_MAC_PREFIX);
+    bool isproxymesh = FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) ? true : false;
+    bool cacheable = p->eth_type == ETH_P_IP && !isproxymesh &&
+                     !FLAGS_TEST(p->flags, DPI_PKT_FLAG_FAKE_EP);
+    uint32_t cache_slot = 0;
     
     DEBUG_LOG_FUNC_ENTRY(DBG_PACKET, p);
 
+    if (likely(cacheable)) {
+        struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
+
+        cache_slot = session4_cache_slot(iph->saddr, iph->daddr, p->sport, p->dport);
+        s = session4_cache_lookup(p, cache_slot, ingress);
+        if (s != NULL) {
+            th_counter.flow_cache_hits ++;
+            return s;
+        }
+        th_counter.flow_cache_misses ++;
+    }
+
     memset(&key.client.ip, 0, sizeof(key.client.ip));
     memset(&key.server.ip, 0, sizeof(key.server.ip));
 
@@ -421,6 +617,9 @@ dpi_session_t *dpi_session_lookup(dpi_packet_t *p)
     } else {
         key.flags = ingress ? DPI_SESS_FLAG_INGRESS : 0;
     }
+    if (unlikely(isproxymesh)) {
+        key.flags = DPI_SESS_FLAG_PROXYMESH;
+    }
     key.client.port = p->sport;
     key.server.port = p->dport;
 
@@ -428,24 +627,22 @@ dpi_session_t *dpi_session_lookup(dpi_packet_t *p)
         struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
         key.client.ip.ip4 = iph->saddr;
         key.server.ip.ip4 = iph->daddr;
-        if (isproxymesh) {
-            s = rcu_map_lookup(&th_session4_proxymesh_map, &key);
-        } else {
-            s = rcu_map_lookup(&th_session4_map, &key);
-        }
+        s = flat_map_find(&th_session4_map, session4_hash(&key), &key, session4_match);
     } else {
         struct ip6_hdr *ip6h = (struct ip6_hdr *)(p->pkt + p->l3);
         key.client.ip.ip6 = ip6h->ip6_src;
         key.server.ip.ip6 = ip6h->ip6_dst;
-        if (isproxymesh) {
-            s = rcu_map_lookup(&th_session6_proxymesh_map, &key);
-        } else {
-            s = rcu_map_lookup(&th_session6_map, &key);
-        }
+        s = flat_map_find(&th_session6_map, session6_hash(&key), &key, session6_match);
     }
 
     if (s != NULL) {
         DEBUG_LOG(DBG_PACKET, p, "Located session=%u\n", s->id);
+        if (unlikely(isproxymesh)) {
+            session_proxymesh_server(s, &key);
+        }
+        if (cacheable) {
+            th_flow_cache[cache_slot] = s;
+        }
         dpi_set_client_pkt(p);
         p->this_wing = &s->client;
         p->that_wing = &s->server;
@@ -459,6 +656,9 @@ dpi_session_t *dpi_session_lookup(dpi_packet_t *p)
     } else {
         key.flags = !ingress ? DPI_SESS_FLAG_INGRESS : 0;
     }
+    if (unlikely(isproxymesh)) {
+        key.flags = DPI_SESS_FLAG_PROXYMESH;
+    }
     key.client.port = p->dport;
     key.server.port = p->sport;
 
@@ -466,24 +666,22 @@ dpi_session_t *dpi_session_lookup(dpi_packet_t *p)
         struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
         key.client.ip.ip4 = iph->daddr;
         key.server.ip.ip4 = iph->saddr;
-        if (isproxymesh) {
-            s = rcu_map_lookup(&th_session4_proxymesh_map, &key);
-        } else {
-            s = rcu_map_lookup(&th_session4_map, &key);
-        }
+        s = flat_map_find(&th_session4_map, session4_hash(&key), &key, session4_match);
     } else {
         struct ip6_hdr *ip6h = (struct ip6_hdr *)(p->pkt + p->l3);
         key.client.ip.ip6 = ip6h->ip6_dst;
         key.server.ip.ip6 = ip6h->ip6_src;
-        if (isproxymesh) {
-            s = rcu_map_lookup(&th_session6_proxymesh_map, &key);
-        } else {
-            s = rcu_map_lookup(&th_session6_map, &key);
-        }
+        s = flat_map_find(&th_session6_map, session6_hash(&key), &key, session6_match);
     }
 
     if (s != NULL) {
         DEBUG_LOG(DBG_PACKET, p, "Located session=%u\n", s->id);
+        if (unlikely(isproxymesh)) {
+            session_proxymesh_server(s, &key);
+        }
+        if (cacheable) {
+            th_flow_cache[cache_slot] = s;
+        }
         p->this_wing = &s->server;
         p->that_wing = &s->client;
         return s;
@@ -492,22 +690,280 @@ dpi_session_t *dpi_session_lookup(dpi_packet_t *p)
     return NULL;
 }
 
+const dpi_session_xff_t g_dpi_session_no_xff;
+
+// Return NULL if it cannot be allocated, the X-Forwarded headers are ignored then.
+dpi_session_xff_t *dpi_session_get_xff(dpi_session_t *s)
+{
+    if (unlikely(s->xff == NULL)) {
+        s->xff = mem_calloc(DP_MEM_SESSION, 1, sizeof(*s->xff));
+    }
+    return s->xff;
+}
+
+dpi_session_tls_t *dpi_session_get_tls(dpi_session_t *s)
+{
+    if (unlikely(s->tls == NULL)) {
+        s->tls = mem_calloc(DP_MEM_SESSION, 1, sizeof(*s->tls));
+    }
+    return s->tls;
+}
+
+// The name is truncated to DPI_VHOST_MAX - 1 and kept zero terminated.
+void dpi_session_set_vhost(dpi_session_t *s, const uint8_t *name, int len)
+{
+    dpi_session_vhost_t *vh = s->vhost;
+
+    len = min(len, DPI_VHOST_MAX - 1);
+    if (vh == NULL || vh->size < len + 1) {
+        vh = mem_realloc(DP_MEM_SESSION, vh, sizeof(*vh) + len + 1);
+        if (vh == NULL) {
+            return;
+        }
+        vh->size = len + 1;
+        s->vhost = vh;
+    }
+    memcpy(vh->name, name, len);
+    vh->name[len] = '\0';
+    vh->len = len;
+}
+
+// -- Kernel offload
+
+#define SESS_OFFLOAD_MIN_PKTS 32    // packets of a session before it is worth the map updates
+
+static void dpi_session_offload_key(io_flow_key_t *key, uint8_t *mac, uint8_t proto,
+                                    const dpi_wing_t *from, const dpi_wing_t *to)
+{
+    memset(key, 0, sizeof(*key));
+    mac_cpy(key->mac, mac);
+    key->proto = proto;
+    key->sip = from->ip.ip4;
+    key->dip = to->ip.ip4;
+    key->sport = htons(from->port);
+    key->dport = htons(to->port);
+}
+
+static void dpi_session_offload_add(dpi_session_offload_t *o, int dir, const io_flow_stats_t *st)
+{
+    dpi_wing_t *w = dir == 0 ? &o->sess->client : &o->sess->server;
+    uint64_t pkts = st->pkts - o->synced[dir].pkts;
+
+    if (pkts == 0) {
+        return;
+    }
+    w->pkts += pkts;
+    w->bytes += st->bytes - o->synced[dir].bytes;
+    o->synced[dir] = *st;
+    o->active = th_snap.tick;
+    th_counter.offload_pkts += pkts;
+}
+
+// Add what the classifier forwarded since the last sync to the wings
+void dpi_session_offload_sync(dpi_session_t *s)
+{
+    dpi_session_offload_t *o = s->offload;
+    io_flow_stats_t st;
+    int dir;
+
+    for (dir = 0; dir < 2; dir ++) {
+        if (g_io_callback->flow_stats(&o->key[dir], &st) == 0) {
+            dpi_session_offload_add(o, dir, &st);
+        }
+    }
+}
+
+// The sequence numbers moved on in the kernel, the TCP tracker takes them from the next
+// packet, see tcp_resync_offloaded().
+static void dpi_session_offload_stop(dpi_session_t *s)
+{
+    dpi_session_offload_t *o = s->offload;
+    io_flow_stats_t st;
+    int dir;
+
+    for (dir = 0; dir < 2; dir ++) {
+        if (g_io_callback->flow_unload(&o->key[dir], &st) == 0) {
+            dpi_session_offload_add(o, dir, &st);
+        }
+    }
+
+    cds_list_del(&o->link);
+    free(o);
+    s->offload = NULL;
+
+    if (s->ip_proto == IPPROTO_TCP) {
+        s->client.flags |= DPI_WING_FLAG_RESYNC;
+        s->server.flags |= DPI_WING_FLAG_RESYNC;
+    }
+}
+
+// While offloaded, the session timer syncs the counters, sends the periodic connect report
+// and expires the session when the kernel counters stay still for the idle timeout.
+static void dpi_session_offload_timeout(timer_entry_t *n)
+{
+    dpi_session_t *s = STRUCT_OF(n, dpi_session_t, ts_entry);
+    dpi_session_offload_t *o = s->offload;
+    uint32_t idle;
+
+    DEBUG_LOG_FILTER_SESSION(s);
+    dpi_session_offload_sync(s);
+
+    idle = th_snap.tick - o->active;
+    if (idle >= o->timeout) {
+        dpi_session_release(s);
+        return;
+    }
+
+    if (FLAGS_TEST(s->flags, DPI_SESS_FLAG_START_LOGGED) &&
+        th_snap.tick - s->last_report >= DPI_CONNECT_REPORT_INTERVAL) {
+        dpi_session_mid_log(s, 0, false);
+    }
+    dpi_session_timer_start(s, dpi_session_offload_timeout,
+                            min(DPI_CONNECT_REPORT_INTERVAL, o->timeout - idle));
+}
+
+// Hand the flow of a session with a cached verdict to the tc classifier. Only inline ipv4
+// TCP/UDP sessions of TC-mode endpoints that have carried some packets are offloaded.
+void dpi_session_offload(dpi_packet_t *p)
+{
+    dpi_session_t *s = p->session;
+    dpi_session_offload_t *o;
+    io_flow_stats_t st;
+    uint8_t *mac;
+
+    if (g_io_callback->flow_offload == NULL || th_offload_hold == th_snap.tick ||
+        !p->ctx->tc || p->ctx->nfq || p->ep->tap || p->ep->mac == NULL ||
+        p->action > DPI_ACTION_ALLOW) {
+        return;
+    }
+    // The kernel can't shift the seq of a syn proxied flow
+    if (!FLAGS_TEST(s->flags, DPI_SESS_FLAG_IPV4) || FLAGS_TEST(s->flags, DPI_SESS_FLAG_FAKE_EP) ||
+        s->syn_proxy != DPI_SYN_PROXY_NONE || s->client.pkts + s->server.pkts < SESS_OFFLOAD_MIN_PKTS) {
+        return;
+    }
+    switch (s->ip_proto) {
+    case IPPROTO_TCP:
+        if (s->client.tcp_state != TCP_ESTABLISHED || s->server.tcp_state != TCP_ESTABLISHED) {
+            return;
+        }
+        break;
+    case IPPROTO_UDP:
+        break;
+    default:
+        return;
+    }
+
+    o = calloc(1, sizeof(*o));
+    if (o == NULL) {
+        return;
+    }
+
+    mac = p->ep->mac->mac.ether_addr_octet;
+    dpi_session_offload_key(&o->key[0], mac, s->ip_proto, &s->client, &s->server);
+    dpi_session_offload_key(&o->key[1], mac, s->ip_proto, &s->server, &s->client);
+    if (g_io_callback->flow_offload(&o->key[0]) < 0) {
+        goto fail;
+    }
+    if (g_io_callback->flow_offload(&o->key[1]) < 0) {
+        g_io_callback->flow_unload(&o->key[0], &st);
+        goto fail;
+    }
+
+    o->sess = s;
+    o->active = th_snap.tick;
+    o->timeout = timer_wheel_entry_get_timeout(&s->ts_entry);
+    s->offload = o;
+    cds_list_add_tail(&o->link, &th_offload_list);
+    th_counter.offload_flows ++;
+
+    DEBUG_LOG(DBG_SESSION, p, "offload session=%u timeout=%u\n", s->id, o->timeout);
+
+    dpi_session_timer_reprogram(s, dpi_session_offload_timeout,
+                                min(DPI_CONNECT_REPORT_INTERVAL, o->timeout));
+    return;
+
+fail:
+    // Most likely the map is full, try again in the next tick
+    th_counter.offload_fails ++;
+    th_offload_hold = th_snap.tick;
+    free(o);
+}
+
+// Take the flow back from the kernel, the session must be on the timer wheel
+void dpi_session_offload_resume(dpi_session_t *s)
+{
+    uint16_t timeout = s->offload->timeout;
+
+    DEBUG_LOG(DBG_SESSION, NULL, "resume session=%u\n", s->id);
+
+    dpi_session_offload_stop(s);
+    dpi_session_timer_reprogram(s, dpi_session_timeout, timeout);
+}
+
+// -- nfq bypass
+
+#define SESS_NFQ_MARK_MIN_PKTS 8    // packets of a session before its connection skips the queue
+
+// Same as offloading for nfq endpoints: the verdict of the packet marks the connection, the
+// iptables rules of the agent let its packets skip the queue but for TCP SYN, FIN, RST and a
+// sample of the others. A sample revokes the mark when the verdict is no longer valid.
+void dpi_session_nfq_mark(dpi_packet_t *p)
+{
+    dpi_session_t *s = p->session;
+
+    if (s->nfq_marked) {
+        p->flags |= DPI_PKT_FLAG_NFQ_MARKED;
+        return;
+    }
+    if (!p->ctx->nfq || p->ep->tap || p->action > DPI_ACTION_ALLOW ||
+        FLAGS_TEST(s->flags, DPI_SESS_FLAG_FAKE_EP) ||
+        s->client.pkts + s->server.pkts < SESS_NFQ_MARK_MIN_PKTS) {
+        return;
+    }
+    switch (s->ip_proto) {
+    case IPPROTO_TCP:
+        if (s->client.tcp_state != TCP_ESTABLISHED || s->server.tcp_state != TCP_ESTABLISHED) {
+            return;
+        }
+        break;
+    case IPPROTO_UDP:
+        break;
+    default:
+        return;
+    }
+
+    DEBUG_LOG(DBG_SESSION, p, "nfq mark session=%u\n", s->id);
+
+    s->nfq_marked = true;
+    if (s->ip_proto == IPPROTO_TCP) {
+        s->client.flags |= DPI_WING_FLAG_RESYNC;
+        s->server.flags |= DPI_WING_FLAG_RESYNC;
+    }
+    p->flags |= DPI_PKT_FLAG_NFQ_MARK | DPI_PKT_FLAG_NFQ_MARKED;
+    th_counter.nfq_marks ++;
+}
+
 void dpi_session_release(dpi_session_t *s)
 {
     DEBUG_LOG(DBG_SESSION, NULL, "id=%u asm:%u/%u\n",
               s->id, asm_gross(&s->client.asm_cache), asm_gross(&s->server.asm_cache));
-    uint8_t *ep_mac = (s->flags & DPI_SESS_FLAG_INGRESS)?s->server.mac:s->client.mac;
-    bool isproxymesh = cmp_mac_prefix(ep_mac, PROXYMESH_MAC_PREFIX);
+    bool isproxymesh = FLAGS_TEST(s->flags, DPI_SESS_FLAG_PROXYMESH) ? true : false;
 
     if (unlikely(dpi_session_is_tick_running(s))) {
         timer_wheel_entry_remove(&th_timer, &s->tick_entry);
     }
+    if (unlikely(s->offload != NULL)) {
+        dpi_session_offload_stop(s);
+    }
 
     dpi_meter_session_dec(s);
     dpi_dec_stats_session(s);
 
     if (s->ip_proto == IPPROTO_TCP) {
         tcp_scan_detection_release(s);
+        if (!isproxymesh) {
+            dpi_resume_drop(s);
+        }
     }
 
     if (likely(s->term_reason != DPI_SESS_TERM_VOLUME)) {
@@ -532,21 +988,23 @@ void dpi_session_release(dpi_session_t *s)
 
     asm_destroy(&s->client.asm_cache, dpi_asm_remove);
     asm_destroy(&s->server.asm_cache, dpi_asm_remove);
+    dpi_session_asm_account(s);
+    dpi_dlp_close_stream(&s->client);
+    dpi_dlp_close_stream(&s->server);
 
     dpi_purge_parser_data(s);
 
     if (likely(s->flags & DPI_SESS_FLAG_IPV4)) {
-        if (isproxymesh) {
-            rcu_map_del(&th_session4_proxymesh_map, s);
-        } else {
-            rcu_map_del(&th_session4_map, s);
+        if (!isproxymesh) {
+            uint32_t slot = session4_cache_slot(s->client.ip.ip4, s->server.ip.ip4,
+                                                s->client.port, s->server.port);
+            if (th_flow_cache[slot] == s) {
+                th_flow_cache[slot] = NULL;
+            }
         }
+        flat_map_del(&th_session4_map, s);
     } else {
-        if (isproxymesh) {
-            rcu_map_del(&th_session6_proxymesh_map, s);
-        } else {
-            rcu_map_del(&th_session6_map, s);
-        }
+        flat_map_del(&th_session6_map, s);
     }
 
     th_counter.cur_sess --;
@@ -562,12 +1020,16 @@ void dpi_session_release(dpi_session_t *s)
         th_counter.parser_pkts[s->only_parser] += s->client.pkts + s->server.pkts;
     }
 
-    free(s);
+    mem_free(DP_MEM_SESSION, s->xff);
+    mem_free(DP_MEM_SESSION, s->vhost);
+    mem_free(DP_MEM_SESSION, s->tls);
+    obj_pool_free(th_pool(DP_POOL_SESSION), s);
 }
 
 void dpi_session_timeout(timer_entry_t *n)
 {
     dpi_session_t *s = STRUCT_OF(n, dpi_session_t, ts_entry);
+    DEBUG_LOG_FILTER_SESSION(s);
     dpi_session_release(s);
 }
 
@@ -591,6 +1053,7 @@ static void dpi_session_tick_timeout(timer_entry_t *n)
 {
     dpi_session_t *s = STRUCT_OF(n, dpi_session_t, tick_entry);
 
+    DEBUG_LOG_FILTER_SESSION(s);
     DEBUG_LOG_FUNC_ENTRY(DBG_SESSION | DBG_TIMER, NULL);
 
     if (unlikely(s->small_window_tick > 0)) {
@@ -631,7 +1094,7 @@ static void dpi_session_tick_timeout(timer_entry_t *n)
     }
 
     if (s->tick_flags != 0) {
-        dpi_session_resume_tick(s);
+        dpi_session_arm_tick(s);
     }
 }
 
@@ -646,6 +1109,8 @@ static void session_nodata_timeout(timer_entry_t *n)
 {
     dpi_session_t *s = STRUCT_OF(n, dpi_session_t, ts_entry);
 
+    DEBUG_LOG_FILTER_SESSION(s);
+
     if (dpi_threat_status(DPI_THRT_TCP_NODATA)) {
         if (dpi_meter_session_rate(DPI_METER_TCP_NODATA, s)) {
             DEBUG_LOG(DBG_SESSION, NULL, "Trigger TCP nodata\n");
@@ -687,55 +1152,207 @@ void assign_session_app_by_port(dpi_packet_t *p, dpi_session_t *s)
         s->app = app;
     }
 }
-*/
-static void dpi_fill_proxymesh_policy_desc(dpi_packet_t *p, bool to_server, dpi_policy_desc_t *desc)
+*/
+static void dpi_fill_proxymesh_policy_desc(dpi_packet_t *p, bool to_server, dpi_policy_desc_t *desc)
+{
+    struct iphdr *iph;
+    uint32_t sip, dip;
+    int is_ingress;
+    
+    memset(desc, 0, sizeof(dpi_policy_desc_t));
+    /* only support ipv4 */
+    switch (p->eth_type) {
+    case ETH_P_IP:
+        break;
+    default:
+        return;
+    }
+    
+    iph = (struct iphdr *)(p->pkt + p->l3);
+    sip = to_server?iph->saddr:iph->daddr;
+    dip = to_server?iph->daddr:iph->saddr;
+    is_ingress = to_server?p->flags & DPI_PKT_FLAG_INGRESS:!(p->flags & DPI_PKT_FLAG_INGRESS);
+    DEBUG_POLICY("sip %x dip %x ingress %d\n",sip, dip, is_ingress);
+
+    desc->id = 0;
+    desc->action = DP_POLICY_ACTION_OPEN;
+    //desc->flags = POLICY_DESC_CHECK_VER;
+    desc->flags = 0;
+
+    if (is_ingress) {
+        desc->flags |= dpi_is_ip4_internal(sip)?
+                           POLICY_DESC_INTERNAL:POLICY_DESC_EXTERNAL;
+    } else {
+        desc->flags |= dpi_is_ip4_internal(dip)?
+                           POLICY_DESC_INTERNAL:POLICY_DESC_EXTERNAL;
+    }
+}
+
+
+// -- session limit
+
+typedef struct evict_args_ {
+    const uint8_t *ep_mac;      // only sessions of this endpoint if not NULL
+    dpi_session_t *victim;
+    int rank;
+    uint32_t idle;
+} evict_args_t;
+
+static int session_evict_rank(const dpi_session_t *s)
+{
+    if (s->ip_proto != IPPROTO_TCP) {
+        return DP_SESS_EVICT_IDLE;
+    }
+    return FLAGS_TEST(s->flags, DPI_SESS_FLAG_ESTABLISHED) ?
+           DP_SESS_EVICT_ESTABLISHED : DP_SESS_EVICT_EMBRYONIC;
+}
+
+// Keep the sample that ranks lowest, embryonic TCP first, then UDP and other flows, then
+// established TCP; the longest idle by its timer of the same rank.
+static bool session_evict_sample(void *data, void *args)
+{
+    dpi_session_t *s = data;
+    evict_args_t *ea = args;
+    int rank;
+    uint32_t idle;
+
+    if (ea->ep_mac != NULL) {
+        uint8_t *ep_mac = FLAGS_TEST(s->flags, DPI_SESS_FLAG_INGRESS) ? s->server.mac : s->client.mac;
+        if (!mac_cmp(ep_mac, (uint8_t *)ea->ep_mac)) {
+            return false;
+        }
+    }
+
+    rank = session_evict_rank(s);
+    // The timer of an offloaded session only tells when its counters were synced
+    idle = s->offload != NULL ? th_snap.tick - s->offload->active :
+                                timer_wheel_entry_get_idle(&s->ts_entry, th_snap.tick);
+    if (ea->victim == NULL || rank < ea->rank || (rank == ea->rank && idle > ea->idle)) {
+        ea->victim = s;
+        ea->rank = rank;
+        ea->idle = idle;
+    }
+    return false;
+}
+
+// Evict one session of the thread, or of the endpoint if ep_mac is given. The candidate is
+// picked from a small sample of the session map, starting where the last sample ended, so
+// the cost does not grow with the number of sessions. Proxymesh sessions are not evicted.
+static bool dpi_session_evict(const uint8_t *ep_mac)
+{
+    evict_args_t ea;
+    flat_map_t *m;
+
+    memset(&ea, 0, sizeof(ea));
+    ea.ep_mac = ep_mac;
+
+    m = flat_map_count(&th_session4_map) >= flat_map_count(&th_session6_map) ?
+        &th_session4_map : &th_session6_map;
+    th_sess_evict_slot = flat_map_sample(m, th_sess_evict_slot, SESS_EVICT_SAMPLES,
+                                         session_evict_sample, &ea);
+    if (ea.victim == NULL) {
+        return false;
+    }
+
+    DEBUG_LOG(DBG_SESSION, NULL, "evict session=%u rank=%d idle=%u\n", ea.victim->id, ea.rank, ea.idle);
+
+    th_counter.sess_evicts[ea.rank] ++;
+    // Only established sessions are logged, embryonic and idle ones are what floods are made of
+    dpi_session_delete(ea.victim, ea.rank == DP_SESS_EVICT_ESTABLISHED ?
+                                  DPI_SESS_TERM_NORMAL : DPI_SESS_TERM_VOLUME);
+    return true;
+}
+
+static bool session_reeval_sample(void *data, void *args)
+{
+    dpi_session_t *s = data;
+    io_mac_t *mac;
+
+    if (!(s->policy_desc.flags & POLICY_DESC_CHECK_VER)) {
+        return false;
+    }
+    mac = rcu_map_lookup(&g_ep_map, (s->flags & DPI_SESS_FLAG_INGRESS) ? s->server.mac : s->client.mac);
+    if (mac != NULL) {
+        dpi_sess_policy_scope_check(s, mac->ep);
+    }
+    return false;
+}
+
+// A policy change with a scope spreads the re-evaluation: sessions it can't affect are moved to
+// the new version in the background, a budget per tick and about one pass over the session maps,
+// so their next packet skips the check. The others are looked up again on their next packet,
+// which logs and enforces a changed decision.
+void dpi_session_policy_sweep(void)
+{
+    flat_map_t *maps[2] = {&th_session4_map, &th_session6_map};
+    uint32_t seq = uatomic_read(&g_policy_scope_seq), budget = SESS_REEVAL_BUDGET, n;
+    int i;
+
+    if (seq != th_reeval_seq) {
+        th_reeval_seq = seq;
+        for (i = 0; i < 2; i ++) {
+            th_reeval_left[i] = flat_map_count(maps[i]);
+        }
+    }
+
+    rcu_read_lock();
+    for (i = 0; i < 2 && budget > 0; i ++) {
+        if (th_reeval_left[i] == 0) {
+            continue;
+        }
+        n = min(budget, th_reeval_left[i]);
+        th_reeval_slot[i] = flat_map_sample(maps[i], th_reeval_slot[i], n, session_reeval_sample, NULL);
+        th_reeval_left[i] -= n;
+        budget -= n;
+    }
+    rcu_read_unlock();
+}
+
+// Make room for a new session under the thread and endpoint limits
+static bool dpi_session_admit(dpi_packet_t *p)
 {
-    struct iphdr *iph;
-    uint32_t sip, dip;
-    int is_ingress;
-    
-    memset(desc, 0, sizeof(dpi_policy_desc_t));
-    /* only support ipv4 */
-    switch (p->eth_type) {
-    case ETH_P_IP:
-        break;
-    default:
-        return;
-    }
-    
-    iph = (struct iphdr *)(p->pkt + p->l3);
-    sip = to_server?iph->saddr:iph->daddr;
-    dip = to_server?iph->daddr:iph->saddr;
-    is_ingress = to_server?p->flags & DPI_PKT_FLAG_INGRESS:!(p->flags & DPI_PKT_FLAG_INGRESS);
-    DEBUG_POLICY("sip %x dip %x ingress %d\n",sip, dip, is_ingress);
+    uint32_t limit = g_io_config->sess_limit;
 
-    desc->id = 0;
-    desc->action = DP_POLICY_ACTION_OPEN;
-    //desc->flags = POLICY_DESC_CHECK_VER;
-    desc->flags = 0;
+    if (unlikely(limit > 0 && th_counter.cur_sess >= limit)) {
+        if (!dpi_session_evict(NULL)) {
+            th_counter.sess_limit_drops ++;
+            return false;
+        }
+    }
 
-    if (is_ingress) {
-        desc->flags |= dpi_is_ip4_internal(sip)?
-                           POLICY_DESC_INTERNAL:POLICY_DESC_EXTERNAL;
-    } else {
-        desc->flags |= dpi_is_ip4_internal(dip)?
-                           POLICY_DESC_INTERNAL:POLICY_DESC_EXTERNAL;
+    // Sessions of the endpoint on all threads, the endpoint's own ones are evicted from this one
+    limit = g_io_config->ep_sess_limit;
+    if (unlikely(limit > 0 && dpi_ep_cur_session(p->ep) >= limit)) {
+        if (!dpi_session_evict(p->ep_mac)) {
+            th_counter.sess_limit_drops ++;
+            return false;
+        }
     }
+    return true;
 }
 
-
-static dpi_session_t *dpi_session_create(dpi_packet_t *p, bool to_server)
+// The policy is looked up unless the caller already did, 'decided'.
+static dpi_session_t *dpi_session_create(dpi_packet_t *p, bool to_server, const dpi_policy_desc_t *decided)
 {
     dpi_wing_t *w0, *w1;
     uint16_t timeout;
     dpi_policy_desc_t policy_desc;
     dpi_policy_hdl_t *hdl = (dpi_policy_hdl_t *)p->ep->policy_hdl;
-    bool isproxymesh = cmp_mac_prefix(p->ep_mac, PROXYMESH_MAC_PREFIX);
+    bool isproxymesh = FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) ? true : false;
 
     DEBUG_LOG_FUNC_ENTRY(DBG_SESSION, p);
 
-    if (!isproxymesh) {
-        dpi_policy_lookup(p, hdl, 0, to_server, false, &policy_desc, 0);
+    if (decided != NULL) {
+        policy_desc = *decided;
+    } else if (!isproxymesh) {
+        if (unlikely(p->resume_desc != NULL && hdl == NULL)) {
+            // Decision of the previous run until the agent pushes the policy
+            policy_desc = *p->resume_desc;
+            policy_desc.flags |= POLICY_DESC_CHECK_VER;
+            policy_desc.hdl_ver = p->ep->policy_ver;
+        } else {
+            dpi_policy_lookup(p, hdl, 0, to_server, false, &policy_desc, 0);
+        }
         // Violate log if needed will be reported in start log
         // except for the drop case, so we log it here
         if (policy_desc.action == DP_POLICY_ACTION_DENY) {
@@ -748,7 +1365,12 @@ static dpi_session_t *dpi_session_create(dpi_packet_t *p, bool to_server)
         dpi_fill_proxymesh_policy_desc(p,to_server,&policy_desc);
     }
 
-    dpi_session_t *s = calloc(1, sizeof(*s));
+    if (unlikely(!dpi_session_admit(p))) {
+        dpi_set_action(p, DPI_ACTION_DROP);
+        return NULL;
+    }
+
+    dpi_session_t *s = obj_pool_zalloc(th_pool(DP_POOL_SESSION));
     if (unlikely(s == NULL)) {
         return NULL;
     }
@@ -813,6 +1435,13 @@ static dpi_session_t *dpi_session_create(dpi_packet_t *p, bool to_server)
     if (p->ep->tap) {
         FLAGS_SET(s->flags, DPI_SESS_FLAG_TAP);
     }
+    if (isproxymesh) {
+        FLAGS_SET(s->flags, DPI_SESS_FLAG_PROXYMESH);
+    } else if (unlikely(p->ep->mesh_verdict != NULL) && p->ip_proto == IPPROTO_TCP) {
+        // The sidecar's leg on "lo" is inspected in clear text, this one is not parsed again
+        s->mesh_leg = true;
+        FLAGS_SET(s->flags, DPI_SESS_FLAG_SKIP_PARSER | DPI_SESS_FLAG_IGNOR_PATTERN);
+    }
 
     s->ip_proto = p->ip_proto;
 
@@ -832,19 +1461,15 @@ static dpi_session_t *dpi_session_create(dpi_packet_t *p, bool to_server)
         w0->ip.ip4 = iph->saddr;
         w1->ip.ip4 = iph->daddr;
         s->flags |= DPI_SESS_FLAG_IPV4;
-        if (isproxymesh) {
-            rcu_map_add(&th_session4_proxymesh_map, s, s);
-        } else {
-            rcu_map_add(&th_session4_map, s, s);
+        if (flat_map_add(&th_session4_map, s, s) < 0) {
+            DEBUG_ERROR(DBG_SESSION, "session map full, sessions=%u\n", flat_map_count(&th_session4_map));
         }
     } else {
         struct ip6_hdr *ip6h = (struct ip6_hdr *)(p->pkt + p->l3);
         w0->ip.ip6 = ip6h->ip6_src;
         w1->ip.ip6 = ip6h->ip6_dst;
-        if (isproxymesh) {
-            rcu_map_add(&th_session6_proxymesh_map, s, s);
-        } else {
-            rcu_map_add(&th_session6_map, s, s);
+        if (flat_map_add(&th_session6_map, s, s) < 0) {
+            DEBUG_ERROR(DBG_SESSION, "session map full, sessions=%u\n", flat_map_count(&th_session6_map));
         }
     }
 
@@ -871,6 +1496,10 @@ static dpi_session_t *dpi_session_create(dpi_packet_t *p, bool to_server)
         debug_dump_session_short(s);
     }
 
+    if (s->ip_proto == IPPROTO_TCP && !isproxymesh) {
+        dpi_resume_save(s);
+    }
+
     return s;
 }
 
@@ -913,43 +1542,272 @@ static bool udp_mid_session_direction(dpi_packet_t *p)
     }
 }
 
-void dpi_udp_tracker(dpi_packet_t *p)
+// DHCP server port is 67, client is 68
+#define DHCP_SERVER_PORT 67
+#define DNS_SERVER_PORT  53
+#define DNS_MC_SERVER_PORT  5353
+
+static bool udp_session_direction(dpi_packet_t *p)
 {
-    dpi_session_t *s = p->session;
+    if (unlikely(p->dport == DHCP_SERVER_PORT || p->dport == DNS_SERVER_PORT || p->dport == DNS_MC_SERVER_PORT)) {
+        return true;
+    } else if (unlikely(p->sport == DHCP_SERVER_PORT || p->sport == DNS_SERVER_PORT || p->sport == DNS_MC_SERVER_PORT)) {
+        return false;
+    } else {
+        // In offline mode, when load is heavy, not all packets can be put in the queue,
+        // we could mis-identify session direction for UDP => perform the direction check
+        // based on opened ports of the workload.
+        return udp_mid_session_direction(p);
+    }
+}
 
+static dpi_session_t *udp_session_create(dpi_packet_t *p, bool to_server, const dpi_policy_desc_t *decided)
+{
+    dpi_session_t *s = dpi_session_create(p, to_server, decided);
     if (unlikely(s == NULL)) {
-        bool to_server;
+        DEBUG_ERROR(DBG_SESSION, "Unable to create UDP session\n");
+        return NULL;
+    }
 
-        // DHCP server port is 67, client is 68
-#define DHCP_SERVER_PORT 67
-#define DNS_SERVER_PORT  53
-#define DNS_MC_SERVER_PORT  5353
-        if (unlikely(p->dport == DHCP_SERVER_PORT || p->dport == DNS_SERVER_PORT || p->dport == DNS_MC_SERVER_PORT)) {
-            to_server = true;
-        } else if (unlikely(p->sport == DHCP_SERVER_PORT || p->sport == DNS_SERVER_PORT || p->sport == DNS_MC_SERVER_PORT)) {
-            to_server = false;
-        } else {
-            // In offline mode, when load is heavy, not all packets can be put in the queue,
-            // we could mis-identify session direction for UDP => perform the direction check
-            // based on opened ports of the workload.
-            to_server = udp_mid_session_direction(p);
+    if (unlikely(dpi_meter_session_inc(p, s) != DPI_METER_ACTION_NONE)) {
+        dpi_session_delete(s, DPI_SESS_TERM_VOLUME);
+        dpi_set_action(p, DPI_ACTION_DROP);
+        return NULL;
+    }
+
+    DEBUG_LOG(DBG_SESSION, p, "Created UDP session\n");
+
+    p->session = s;
+    // assign_session_app_by_port(p, s);
+    return s;
+}
+
+// A DNS query of a workload and its answer are mostly all of a UDP flow. The query allowed by
+// the policy is snooped and kept in a flowlet instead of a session: no parser is recruited, no
+// timer is started and the connection is reported once, when the flowlet is released after
+// DPI_FLOWLET_TIMEOUT seconds without a packet. Flowlets are on th_flowlet_list by their last
+// packet, dpi_timeout() releases the ones at its head.
+//
+// The flowlet is promoted to a session, which takes over its counts, on a second query or
+// answer, when the message is not DNS, or when the endpoint's policy changes in between.
+// Policy actions that need the app to decide, or log a violation, go with a session at once.
+static inline bool flowlet_match(const void *data, const void *key)
+{
+    const dpi_flowlet_t *f = data, *k = key;
+
+    return f->client_ip == k->client_ip && f->server_ip == k->server_ip &&
+           f->client_port == k->client_port && f->server_port == k->server_port &&
+           mac_cmp((uint8_t *)f->client_mac, (uint8_t *)k->client_mac);
+}
+
+static inline uint32_t flowlet_hash(const void *key)
+{
+    const dpi_flowlet_t *k = key;
+
+    return session_hash_mix(((uint64_t)k->client_ip << 32) | k->server_ip,
+                            ((uint32_t)k->client_port << 16) | k->server_port);
+}
+
+static void dpi_flowlet_free(dpi_flowlet_t *fl)
+{
+    flat_map_del(&th_flowlet_map, fl);
+    cds_list_del(&fl->link);
+    cds_list_add(&fl->link, &th_flowlet_free);
+}
+
+static void dpi_flowlet_release(dpi_flowlet_t *fl)
+{
+    DPMsgSession dps;
+
+    DEBUG_LOG(DBG_SESSION | DBG_LOG, NULL, "flowlet=%u pkt=%u:%u\n",
+              fl->id, fl->client_pkts, fl->server_pkts);
+
+    dpi_flowlet_log(fl, &dps);
+    g_io_callback->connect_report(&dps, NULL, 1, 0);
+    dpi_flowlet_free(fl);
+}
+
+void dpi_flowlet_expire(void)
+{
+    while (!cds_list_empty(&th_flowlet_list)) {
+        dpi_flowlet_t *fl = cds_list_entry(th_flowlet_list.next, dpi_flowlet_t, link);
+
+        if (th_snap.tick - fl->last_seen < DPI_FLOWLET_TIMEOUT) {
+            break;
         }
-        s = dpi_session_create(p, to_server);
-        if (unlikely(s == NULL)) {
-            DEBUG_ERROR(DBG_SESSION, "Unable to create UDP session\n");
-            return;
+        dpi_flowlet_release(fl);
+    }
+}
+
+static dpi_flowlet_t *dpi_flowlet_alloc(void)
+{
+    dpi_flowlet_t *fl;
+
+    if (cds_list_empty(&th_flowlet_free)) {
+        if (cds_list_empty(&th_flowlet_list)) {
+            return NULL;
         }
+        dpi_flowlet_release(cds_list_entry(th_flowlet_list.next, dpi_flowlet_t, link));
+    }
 
-        if (unlikely(dpi_meter_session_inc(p, s) != DPI_METER_ACTION_NONE)) {
-            dpi_session_delete(s, DPI_SESS_TERM_VOLUME);
+    fl = cds_list_entry(th_flowlet_free.next, dpi_flowlet_t, link);
+    cds_list_del(&fl->link);
+    memset(fl, 0, sizeof(*fl));
+    return fl;
+}
+
+static void dpi_flowlet_touch(dpi_flowlet_t *fl, dpi_packet_t *p)
+{
+    fl->last_seen = th_snap.tick;
+    cds_list_del(&fl->link);
+    cds_list_add_tail(&fl->link, &th_flowlet_list);
+
+    if (unlikely(p->severity > fl->severity)) {
+        fl->severity = p->severity;
+        fl->threat_id = p->threat_id;
+    }
+}
+
+// The session of the packet takes over the flowlet, if there is one
+static void dpi_flowlet_promote(dpi_packet_t *p, dpi_flowlet_t *fl, const dpi_policy_desc_t *decided)
+{
+    dpi_session_t *s = udp_session_create(p, p->dport == DNS_SERVER_PORT, decided);
+
+    if (fl == NULL) {
+        return;
+    }
+    if (unlikely(s == NULL)) {
+        dpi_flowlet_release(fl);
+        return;
+    }
+
+    DEBUG_LOG(DBG_SESSION, p, "Promoted flowlet=%u to session=%u\n", fl->id, s->id);
+
+    s->created_at = fl->created_at;
+    s->client.pkts += fl->client_pkts;
+    s->client.bytes += fl->client_bytes;
+    s->server.pkts += fl->server_pkts;
+    s->server.bytes += fl->server_bytes;
+    if (fl->severity > s->severity) {
+        s->severity = fl->severity;
+        s->threat_id = fl->threat_id;
+    }
+    dpi_flowlet_free(fl);
+}
+
+// Return true if the packet is tracked by a flowlet, or by the session it was promoted to
+static bool dpi_flowlet_track(dpi_packet_t *p)
+{
+    dpi_policy_hdl_t *hdl = (dpi_policy_hdl_t *)p->ep->policy_hdl;
+    bool ingress = FLAGS_TEST(p->flags, DPI_PKT_FLAG_INGRESS);
+    struct iphdr *iph = (struct iphdr *)(p->pkt + p->l3);
+    dpi_flowlet_t *fl, key;
+    dpi_policy_desc_t desc;
+    bool query;
+
+    if (p->eth_type != ETH_P_IP || th_flowlets == NULL || hdl == NULL || p->ep->tap ||
+        FLAGS_TEST(p->flags, (DPI_PKT_FLAG_FAKE_EP | DPI_PKT_FLAG_PROXYMESH))) {
+        return false;
+    }
+
+    if (p->dport == DNS_SERVER_PORT && p->sport != DNS_SERVER_PORT && !ingress) {
+        query = true;
+        key.client_ip = iph->saddr;
+        key.server_ip = iph->daddr;
+        key.client_port = p->sport;
+        key.server_port = p->dport;
+    } else if (p->sport == DNS_SERVER_PORT && p->dport != DNS_SERVER_PORT && ingress) {
+        query = false;
+        key.client_ip = iph->daddr;
+        key.server_ip = iph->saddr;
+        key.client_port = p->dport;
+        key.server_port = p->sport;
+    } else {
+        return false;
+    }
+    mac_cpy(key.client_mac, p->ep_mac);
+
+    fl = flat_map_find(&th_flowlet_map, flowlet_hash(&key), &key, flowlet_match);
+    if (fl == NULL) {
+        // An answer without the query is left to a mid stream session
+        if (!query) {
+            return false;
+        }
+
+        dpi_policy_lookup(p, hdl, 0, true, false, &desc, 0);
+        if (desc.action == DP_POLICY_ACTION_DENY) {
+            dpi_policy_violate_log(p, true, &desc);
             dpi_set_action(p, DPI_ACTION_DROP);
-            return;
+            return true;
+        }
+        if (desc.action > DP_POLICY_ACTION_ALLOW ||
+            (dpi_dns_udp_snoop(p) < 0 && p->severity == 0)) {
+            dpi_flowlet_promote(p, NULL, &desc);
+            return true;
         }
 
-        DEBUG_LOG(DBG_SESSION, p, "Created UDP session\n");
+        fl = dpi_flowlet_alloc();
+        if (unlikely(fl == NULL)) {
+            dpi_flowlet_promote(p, NULL, &desc);
+            return true;
+        }
 
-        p->session = s;
-        // assign_session_app_by_port(p, s);
+        struct ethhdr *eth = (struct ethhdr *)(p->pkt + p->l2);
+
+        th_counter.sess_id ++;
+        fl->id = th_counter.sess_id;
+        fl->client_ip = key.client_ip;
+        fl->server_ip = key.server_ip;
+        fl->client_port = key.client_port;
+        fl->server_port = key.server_port;
+        mac_cpy(fl->client_mac, p->ep_mac);
+        mac_cpy(fl->server_mac, eth->h_dest);
+        fl->created_at = th_snap.tick;
+        fl->client_pkts = 1;
+        fl->client_bytes = p->cap_len;
+        fl->policy_ver = p->ep->policy_ver;
+        fl->policy_desc = desc;
+
+        CDS_INIT_LIST_HEAD(&fl->link);
+        if (flat_map_add(&th_flowlet_map, fl, fl) < 0) {
+            cds_list_add(&fl->link, &th_flowlet_free);
+            dpi_flowlet_promote(p, NULL, &desc);
+            return true;
+        }
+        dpi_flowlet_touch(fl, p);
+        dpi_inc_stats_flowlet(p);
+
+        DEBUG_LOG(DBG_SESSION, p, "Created flowlet=%u policy=" DP_POLICY_DESC_STR "\n",
+                  fl->id, DP_POLICY_DESC((&fl->policy_desc)));
+        return true;
+    }
+
+    // One exchange only
+    if (query || fl->server_pkts > 0 || fl->policy_ver != p->ep->policy_ver ||
+        (dpi_dns_udp_snoop(p) < 0 && p->severity == 0)) {
+        dpi_flowlet_promote(p, fl, NULL);
+        return true;
+    }
+
+    fl->server_pkts = 1;
+    fl->server_bytes = p->cap_len;
+    dpi_flowlet_touch(fl, p);
+    return true;
+}
+
+void dpi_udp_tracker(dpi_packet_t *p)
+{
+    dpi_session_t *s = p->session;
+
+    if (unlikely(s == NULL)) {
+        if (dpi_flowlet_track(p)) {
+            s = p->session;
+        } else {
+            s = udp_session_create(p, udp_session_direction(p), NULL);
+        }
+        if (s == NULL) {
+            return;
+        }
     } else {
         dpi_session_timer_refresh(s);
     }
@@ -961,6 +1819,24 @@ void dpi_udp_tracker(dpi_packet_t *p)
 
 #define ICMP_TUNNEL_THRESHOD  3
 #define ICMP_TUNNEL_REPORTED  255
+// Echo payloads of the first packets of a session are always compared with their replies.
+// After that, an echo is only hashed when its payload length changes or is over a default
+// ping's, a mismatch is pending, or it's one in ICMP_TUNNEL_SAMPLE; other exchanges are only
+// counted. A tunnel keeps giving mismatches on the sampled exchanges, so it's still reported,
+// but steady monitoring pings are not hashed.
+#define ICMP_TUNNEL_FULL_PKTS   32
+#define ICMP_TUNNEL_SAMPLE      16
+#define ICMP_TUNNEL_SAMPLE_LEN  56
+static bool icmp_tunneling_sampled(dpi_wing_t *client, uint32_t len)
+{
+    uint8_t echo_len = min(len, 255);
+    bool changed = echo_len != client->icmp_echo_len;
+
+    client->icmp_echo_len = echo_len;
+    return g_icmp_sample == 0 || changed || len > ICMP_TUNNEL_SAMPLE_LEN || client->icmp_times > 0 ||
+           client->pkts < ICMP_TUNNEL_FULL_PKTS || client->pkts % ICMP_TUNNEL_SAMPLE == 0;
+}
+
 void dpi_icmp_tunneling_check(dpi_packet_t *p)
 {
     uint32_t len = dpi_pkt_len(p);
@@ -973,20 +1849,27 @@ void dpi_icmp_tunneling_check(dpi_packet_t *p)
     }
 
     if (icmph->type == ICMP_ECHO) {
-        uint32_t hash = sdbm_hash(ptr, len);
+        if (!icmp_tunneling_sampled(client, len)) {
+            th_counter.icmp_skips ++;
+            client->icmp_echo_hash = 0;
+            client->icmp_echo_seq = 0;
+            return;
+        }
+        th_counter.icmp_checks ++;
 
-        client->icmp_echo_hash = hash;
+        client->icmp_echo_hash = sdbm_hash(ptr, len);
         client->icmp_echo_seq = icmph->un.echo.sequence;
     } else if (icmph->type == ICMP_ECHOREPLY) {
-        uint32_t hash = sdbm_hash(ptr, len);
-
         if (client->icmp_echo_seq == icmph->un.echo.sequence && client->icmp_echo_hash != 0) {
+            uint32_t hash = sdbm_hash(ptr, len);
+
             if (client->icmp_echo_hash == hash) {
                 client->icmp_times = 0;
             } else {
                 client->icmp_times ++;
                 if (client->icmp_times == ICMP_TUNNEL_THRESHOD) {
                     client->icmp_times = ICMP_TUNNEL_REPORTED;
+                    th_counter.icmp_tunnels ++;
                     dpi_threat_trigger(DPI_THRT_ICMP_TUNNELING, p, "ICMP tunneling");
                 }
             }
@@ -1033,7 +1916,7 @@ void dpi_icmp_tracker(dpi_packet_t *p)
     }
 
     if (unlikely(s == NULL)) {
-        s = dpi_session_create(p, dpi_is_client_pkt(p));
+        s = dpi_session_create(p, dpi_is_client_pkt(p), NULL);
         if (unlikely(s == NULL)) {
             DEBUG_ERROR(DBG_SESSION, "Unable to create ICMP session\n");
             return;
@@ -1050,7 +1933,8 @@ void dpi_icmp_tracker(dpi_packet_t *p)
         p->session = s;
         s->client.icmp_echo_hash = 0;
         s->client.icmp_echo_seq = 0;
-        s->client.icmp_times = 0; 
+        s->client.icmp_times = 0;
+        s->client.icmp_echo_len = 0;
         FLAGS_SET(s->flags, DPI_SESS_FLAG_SKIP_PARSER);
         if (g_enable_icmp_policy) {
             FLAGS_SET(s->flags, DPI_SESS_FLAG_POLICY_APP_READY);
@@ -1076,7 +1960,7 @@ void dpi_ip_tracker(dpi_packet_t *p)
     dpi_session_t *s = p->session;
 
     if (unlikely(s == NULL)) {
-        s = dpi_session_create(p, true);
+        s = dpi_session_create(p, true, NULL);
         if (unlikely(s == NULL)) {
             DEBUG_ERROR(DBG_SESSION, "Unable to create IP session\n");
             return;
@@ -1147,6 +2031,25 @@ static void tcp_open_by_mid_stream(dpi_session_t *s, dpi_packet_t *p)
 }
 
 
+// First packet after the flow came back from the kernel, like a mid-stream pickup but the
+// session keeps its state.
+static void tcp_resync_offloaded(dpi_session_t *s, dpi_packet_t *p)
+{
+    struct tcphdr *tcph = (struct tcphdr *)(p->pkt + p->l4);
+
+    p->this_wing->next_seq = p->this_wing->asm_seq = p->raw.seq;
+    p->this_wing->tcp_acked = 0;
+    if (tcph->ack) {
+        uint32_t ack = ntohl(tcph->th_ack);
+        p->that_wing->next_seq = p->that_wing->asm_seq = p->that_wing->tcp_acked = ack;
+    } else {
+        p->that_wing->tcp_acked = 0;
+    }
+    s->client.flags &= ~DPI_WING_FLAG_RESYNC;
+    s->server.flags &= ~DPI_WING_FLAG_RESYNC;
+}
+
+
 static int tcp_is_in_window(dpi_packet_t *p)
 {
     dpi_wing_t *w0 = p->this_wing, *w1 = p->that_wing;
@@ -1219,6 +2122,44 @@ static void tcp_scan_detection_release(dpi_session_t *s)
     }
 }
 
+// Transitions by the state of the other wing and the SYN, FIN and ACK bits of the packet.
+// Those that depend on more than that check the rest in tcp_update_state().
+#define TCP_PKT_CLASS(tcph) ((tcph)->syn << 2 | (tcph)->fin << 1 | (tcph)->ack)
+#define TCP_PKT_CLASSES     8
+
+enum {
+    TCP_TR_NONE = 0,
+    TCP_TR_LISTEN_SYN,
+    TCP_TR_SYN_SENT_SYNACK,
+    TCP_TR_SYN_SENT_SYN,
+    TCP_TR_SYN_RECV_ACK,
+    TCP_TR_SYN_RECV_SYNACK,
+    TCP_TR_ESTABLISHED_FIN,
+    TCP_TR_ESTABLISHED_SYN,
+    TCP_TR_FIN_WAIT1_FIN,
+    TCP_TR_FIN_WAIT1_ACK,
+    TCP_TR_FIN_WAIT2_FIN,
+    TCP_TR_LAST_ACK_ACK,
+};
+
+static const uint8_t tcp_transition[TCP_CLOSING + 1][TCP_PKT_CLASSES] = {
+                    //  -  A  F  FA  S  SA  SF  SFA
+[TCP_LISTEN]      = { 0, 0, 0, 0,
+                      TCP_TR_LISTEN_SYN, TCP_TR_LISTEN_SYN, TCP_TR_LISTEN_SYN, TCP_TR_LISTEN_SYN },
+[TCP_SYN_SENT]    = { 0, 0, 0, 0,
+                      TCP_TR_SYN_SENT_SYN, TCP_TR_SYN_SENT_SYNACK, TCP_TR_SYN_SENT_SYN, TCP_TR_SYN_SENT_SYNACK },
+[TCP_SYN_RECV]    = { 0, TCP_TR_SYN_RECV_ACK, 0, TCP_TR_SYN_RECV_ACK,
+                      0, TCP_TR_SYN_RECV_SYNACK, 0, TCP_TR_SYN_RECV_SYNACK },
+[TCP_ESTABLISHED] = { 0, 0, TCP_TR_ESTABLISHED_FIN, TCP_TR_ESTABLISHED_FIN,
+                      TCP_TR_ESTABLISHED_SYN, 0, TCP_TR_ESTABLISHED_FIN, TCP_TR_ESTABLISHED_FIN },
+[TCP_FIN_WAIT1]   = { 0, TCP_TR_FIN_WAIT1_ACK, TCP_TR_FIN_WAIT1_FIN, TCP_TR_FIN_WAIT1_FIN,
+                      0, 0, TCP_TR_FIN_WAIT1_FIN, TCP_TR_FIN_WAIT1_FIN },
+[TCP_FIN_WAIT2]   = { 0, 0, TCP_TR_FIN_WAIT2_FIN, TCP_TR_FIN_WAIT2_FIN,
+                      0, 0, TCP_TR_FIN_WAIT2_FIN, TCP_TR_FIN_WAIT2_FIN },
+// CLOSE_WAIT: no state change until the other side ACK-s
+[TCP_LAST_ACK]    = { 0, TCP_TR_LAST_ACK_ACK, 0, TCP_TR_LAST_ACK_ACK, 0, 0, 0, 0 },
+};
+
 static int tcp_update_state(dpi_packet_t *p, dpi_session_t *s)
 {
     struct tcphdr *tcph = (struct tcphdr *)(p->pkt + p->l4);
@@ -1231,95 +2172,75 @@ static int tcp_update_state(dpi_packet_t *p, dpi_session_t *s)
         return TCP_EVT_RST;
     }
 
-    switch (p->that_wing->tcp_state) {
-    case TCP_LISTEN:
-        if (tcph->syn) {
-            s->server.tcp_state = TCP_SYN_RECV;
-            return TCP_EVT_SYN;
-        }
+    switch (tcp_transition[p->that_wing->tcp_state][TCP_PKT_CLASS(tcph)]) {
+    case TCP_TR_NONE:
+        // Most packets of an established session
         break;
 
-    case TCP_SYN_SENT:
-        if (tcph->syn && tcph->ack) {
-            s->client.tcp_state = TCP_ESTABLISHED;
-            return TCP_EVT_SYNACK;
-        } else if (tcph->syn && !tcph->ack) {
-            // 4-way handshake
-            s->client.tcp_state = TCP_SYN_RECV;
-            return TCP_EVT_SYNACK;
-        }
-        break;
+    case TCP_TR_LISTEN_SYN:
+        s->server.tcp_state = TCP_SYN_RECV;
+        return TCP_EVT_SYN;
+
+    case TCP_TR_SYN_SENT_SYNACK:
+        s->client.tcp_state = TCP_ESTABLISHED;
+        return TCP_EVT_SYNACK;
 
-    case TCP_SYN_RECV:
-        if (!tcph->syn && tcph->ack && dpi_is_client_pkt(p)) {
+    case TCP_TR_SYN_SENT_SYN:
+        // 4-way handshake
+        s->client.tcp_state = TCP_SYN_RECV;
+        return TCP_EVT_SYNACK;
+
+    case TCP_TR_SYN_RECV_ACK:
+        if (dpi_is_client_pkt(p)) {
             s->client.tcp_state = s->server.tcp_state = TCP_ESTABLISHED;
             return TCP_EVT_TWH;
         }
-        if (tcph->syn && tcph->ack) {
-            // Client has sent SYN now sends SYN/ACK, split handshake
-            s->client.tcp_state = s->server.tcp_state = TCP_ESTABLISHED;
-            return TCP_EVT_SPLIT;
-        }
         break;
 
-    case TCP_ESTABLISHED:
-        if (unlikely(tcph->fin)) {
-            p->this_wing->tcp_state = TCP_FIN_WAIT1;
-            p->that_wing->tcp_state = TCP_CLOSE_WAIT;
-            return TCP_EVT_FIN;
-        } else if (unlikely(tcph->syn && !tcph->ack && s->server.tcp_state == TCP_SYN_RECV)) {
+    case TCP_TR_SYN_RECV_SYNACK:
+        // Client has sent SYN now sends SYN/ACK, split handshake
+        s->client.tcp_state = s->server.tcp_state = TCP_ESTABLISHED;
+        return TCP_EVT_SPLIT;
+
+    case TCP_TR_ESTABLISHED_FIN:
+        p->this_wing->tcp_state = TCP_FIN_WAIT1;
+        p->that_wing->tcp_state = TCP_CLOSE_WAIT;
+        return TCP_EVT_FIN;
+
+    case TCP_TR_ESTABLISHED_SYN:
+        if (s->server.tcp_state == TCP_SYN_RECV) {
             // server has sent SYN/ACK now sends SYN again, split handshake
             s->server.tcp_state = TCP_ESTABLISHED;
             return TCP_EVT_SPLIT;
         }
         break;
 
-    case TCP_FIN_WAIT1:
+    case TCP_TR_FIN_WAIT1_FIN:
         // That side state is at FIN_WAIT1 => That side has sent FIN without ACK-ed
-        if (tcph->fin) {
-            p->this_wing->tcp_state = TCP_LAST_ACK;
-            p->that_wing->tcp_state = TCP_FIN_WAIT2;
-            // Both sides send FIN
-            dpi_session_timer_reprogram(s, dpi_session_timeout, SESS_TIMEOUT_TCP_CLOSE);
-            return TCP_EVT_FIN;
-        } else if (!tcph->syn && tcph->ack) {
-            p->this_wing->tcp_state = TCP_CLOSE_WAIT;
-            p->that_wing->tcp_state = TCP_FIN_WAIT2;
-            // This side ACK-s, not sending FIN yet.
-            dpi_session_timer_reprogram(s, dpi_session_timeout, SESS_TIMEOUT_TCP_HALF_CLOSE);
-        }
-        break;
+        p->this_wing->tcp_state = TCP_LAST_ACK;
+        p->that_wing->tcp_state = TCP_FIN_WAIT2;
+        // Both sides send FIN
+        dpi_session_timer_reprogram(s, dpi_session_timeout, SESS_TIMEOUT_TCP_CLOSE);
+        return TCP_EVT_FIN;
 
-    case TCP_FIN_WAIT2:
-        // That side state is at FIN_WAIT2 => That side has sent FIN and ACK-ed
-        if (tcph->fin) {
-            // Both sides send FIN
-            p->this_wing->tcp_state = TCP_LAST_ACK;
-            p->that_wing->tcp_state = TCP_TIME_WAIT;
-            dpi_session_timer_reprogram(s, dpi_session_timeout, SESS_TIMEOUT_TCP_CLOSE);
-            return TCP_EVT_FIN;
-        }
+    case TCP_TR_FIN_WAIT1_ACK:
+        p->this_wing->tcp_state = TCP_CLOSE_WAIT;
+        p->that_wing->tcp_state = TCP_FIN_WAIT2;
+        // This side ACK-s, not sending FIN yet.
+        dpi_session_timer_reprogram(s, dpi_session_timeout, SESS_TIMEOUT_TCP_HALF_CLOSE);
         break;
 
-    case TCP_CLOSE_WAIT:
-        // That side state is at CLOSE_WAIT => This side has sent FIN without ACK-ed
-        /* No state change, until the other side ACK-s.
-        if (tcph->fin) {
-            p->this_wing->tcp_state = TCP_FIN_WAIT2;
-            p->that_wing->tcp_state = TCP_LAST_ACK;
-            return TCP_EVT_FIN;
-        } else if (!tcph->syn && tcph->ack) {
-            p->this_wing->tcp_state = TCP_FIN_WAIT2;
-        }
-        */
-        break;
+    case TCP_TR_FIN_WAIT2_FIN:
+        // That side state is at FIN_WAIT2 => That side has sent FIN and ACK-ed
+        p->this_wing->tcp_state = TCP_LAST_ACK;
+        p->that_wing->tcp_state = TCP_TIME_WAIT;
+        dpi_session_timer_reprogram(s, dpi_session_timeout, SESS_TIMEOUT_TCP_CLOSE);
+        return TCP_EVT_FIN;
 
-    case TCP_LAST_ACK:
+    case TCP_TR_LAST_ACK_ACK:
         // That side state is at LAST_ACK => Both sides have sent FIN
-        if (!tcph->syn && tcph->ack) {
-            p->that_wing->tcp_state = TCP_CLOSE;
-            dpi_session_timer_reprogram(s, dpi_session_timeout, SESS_TIMEOUT_TCP_CLOSE);
-        }
+        p->that_wing->tcp_state = TCP_CLOSE;
+        dpi_session_timer_reprogram(s, dpi_session_timeout, SESS_TIMEOUT_TCP_CLOSE);
         break;
     }
 
@@ -1404,7 +2325,7 @@ static void tcp_assembly(dpi_packet_t *p, dpi_session_t *s)
         return;
     }
 
-    if (dpi_cache_packet(p, w0, false) < 0) {
+    if (dpi_cache_packet(p, w0, false, true) < 0) {
         return;
     }
 
@@ -1465,7 +2386,7 @@ static void check_small_window_attack(dpi_packet_t *p, uint32_t old_win)
 
 static dpi_session_t *tcp_session_create(dpi_packet_t *p, bool to_server)
 {
-    dpi_session_t *s = dpi_session_create(p, to_server);
+    dpi_session_t *s = dpi_session_create(p, to_server, NULL);
     if (unlikely(s == NULL)) {
         return NULL;
     }
@@ -1481,12 +2402,89 @@ static dpi_session_t *tcp_session_create(dpi_packet_t *p, bool to_server)
     return s;
 }
 
+// The ACK carried a syn cookie. Open the session as if the client's SYN went through and send
+// the SYN to the server; the ACK itself is not forwarded.
+static dpi_session_t *tcp_open_by_cookie(dpi_packet_t *p, uint16_t mss)
+{
+    struct tcphdr *tcph = (struct tcphdr *)(p->pkt + p->l4);
+    dpi_session_t *s = tcp_session_create(p, true);
+
+    if (unlikely(s == NULL)) {
+        return NULL;
+    }
+
+    s->client.tcp_state = TCP_SYN_SENT;
+    s->server.tcp_state = TCP_SYN_RECV;
+    s->client.init_seq = s->client.next_seq = s->client.asm_seq = p->raw.seq;
+    s->client.tcp_win = ntohs(tcph->th_win);
+    s->client.tcp_mss = mss;
+    s->syn_proxy = DPI_SYN_PROXY_WAIT;
+    s->syn_delta = ntohl(tcph->th_ack) - 1;
+
+    dpi_inject_tcp(p, false, p->raw.seq - 1, 0, TH_SYN, s->client.tcp_win, mss);
+    FLAGS_SET(p->flags, DPI_PKT_FLAG_SYN_PROXY | DPI_PKT_FLAG_SKIP_PARSER | DPI_PKT_FLAG_SKIP_PATTERN);
+    return s;
+}
+
+// The server of a syn proxied session picked its own isn, its seq is shifted to the cookie
+// the client saw and the client's ack back. The tracker keeps the server's numbers.
+// Return true if the packet is consumed.
+static bool tcp_syn_proxy(dpi_packet_t *p, dpi_session_t *s)
+{
+    struct tcphdr *tcph = (struct tcphdr *)(p->pkt + p->l4);
+    uint32_t old, new;
+
+    if (dpi_is_client_pkt(p)) {
+        if (s->syn_proxy == DPI_SYN_PROXY_WAIT) {
+            // Nothing to shift with yet, the client retransmits
+            FLAGS_SET(p->flags, DPI_PKT_FLAG_SYN_PROXY | DPI_PKT_FLAG_SKIP_PARSER |
+                                DPI_PKT_FLAG_SKIP_PATTERN);
+            return true;
+        }
+        if (tcph->ack) {
+            old = tcph->th_ack;
+            new = htonl(ntohl(old) - s->syn_delta);
+            tcph->th_ack = new;
+            tcph->th_sum = cksum_update32(tcph->th_sum, old, new);
+        }
+        return false;
+    }
+
+    if (s->syn_proxy == DPI_SYN_PROXY_WAIT) {
+        if (tcph->syn && tcph->ack && ntohl(tcph->th_ack) == s->client.init_seq) {
+            // Complete the server's handshake, the client has done it with the cookie
+            s->syn_delta -= p->raw.seq;
+            s->syn_proxy = DPI_SYN_PROXY_ON;
+            dpi_inject_tcp(p, true, s->client.init_seq, p->raw.seq + 1, TH_ACK, s->client.tcp_win, 0);
+            FLAGS_SET(p->flags, DPI_PKT_FLAG_SYN_PROXY);
+        } else if (tcph->rst) {
+            old = tcph->th_seq;
+            new = htonl(s->syn_delta + 1);
+            tcph->th_seq = new;
+            tcph->th_sum = cksum_update32(tcph->th_sum, old, new);
+        }
+        return false;
+    }
+
+    old = tcph->th_seq;
+    new = htonl(ntohl(old) + s->syn_delta);
+    tcph->th_seq = new;
+    tcph->th_sum = cksum_update32(tcph->th_sum, old, new);
+    return false;
+}
+
 void dpi_tcp_tracker(dpi_packet_t *p)
 {
     struct tcphdr *tcph = (struct tcphdr *)(p->pkt + p->l4);
     dpi_session_t *s = p->session;
+
+    if (unlikely(s != NULL && s->syn_proxy != DPI_SYN_PROXY_NONE) && tcp_syn_proxy(p, s)) {
+        return;
+    }
+
     uint32_t seq = p->raw.seq, ack = ntohl(tcph->th_ack);
     uint32_t len = p->raw.len, end = seq + len;
+    uint16_t mss;
 
     DEBUG_LOG_FUNC_ENTRY(DBG_PACKET | DBG_TCP, p);
 
@@ -1503,6 +2501,9 @@ void dpi_tcp_tracker(dpi_packet_t *p)
                 if (unlikely(dpi_meter_synflood_inc(p) != DPI_METER_ACTION_NONE)) {
                     return;
                 }
+                if (unlikely(dpi_meter_scan_inc(p) != DPI_METER_ACTION_NONE)) {
+                    return;
+                }
 
                 DEBUG_LOG(DBG_TCP | DBG_SESSION, p, "TCP SYN without session\n");
 
@@ -1532,6 +2533,11 @@ void dpi_tcp_tracker(dpi_packet_t *p)
         } else if (tcph->rst || tcph->fin) {
             // Don't create mid-stream session for RST and FIN
             return;
+        } else if (unlikely(tcph->ack && dpi_syn_cookie_check(p, &mss))) {
+            DEBUG_LOG(DBG_TCP | DBG_SESSION, p, "TCP ACK with syn cookie\n");
+
+            p->session = tcp_open_by_cookie(p, mss);
+            return;
         } else {
             DEBUG_LOG(DBG_TCP | DBG_SESSION, p, "Mid-stream TCP packet\n");
 
@@ -1545,7 +2551,10 @@ void dpi_tcp_tracker(dpi_packet_t *p)
             }
             */
 
-            bool to_server = tcp_mid_session_direction(p);
+            bool to_server;
+            if (likely(!dpi_resume_lookup(p, &to_server))) {
+                to_server = tcp_mid_session_direction(p);
+            }
             s = tcp_session_create(p, to_server);
             if (unlikely(s == NULL)) {
                 return;
@@ -1569,6 +2578,9 @@ void dpi_tcp_tracker(dpi_packet_t *p)
                 if (unlikely(dpi_meter_synflood_inc(p) != DPI_METER_ACTION_NONE)) {
                     return;
                 }
+                if (unlikely(dpi_meter_scan_inc(p) != DPI_METER_ACTION_NONE)) {
+                    return;
+                }
 
                 s = tcp_session_create(p, true);
                 if (unlikely(s == NULL)) {
@@ -1595,6 +2607,9 @@ void dpi_tcp_tracker(dpi_packet_t *p)
             }
         }
 
+        if (unlikely(p->this_wing->flags & DPI_WING_FLAG_RESYNC)) {
+            tcp_resync_offloaded(s, p);
+        }
         dpi_session_timer_refresh(s);
     }
 
@@ -1619,7 +2634,8 @@ void dpi_tcp_tracker(dpi_packet_t *p)
         return;
     }
 
-    if (len > 0) {
+    // In-order data with nothing cached can't be a retransmission of a cached packet
+    if (len > 0 && asm_count(&p->this_wing->asm_cache) > 0) {
         clip_t *clip = asm_lookup(&p->this_wing->asm_cache, seq);
         if (clip != NULL) {
             if (clip->len == len) {
@@ -1719,23 +2735,73 @@ void dpi_session_delete(dpi_session_t *s, int reason)
     dpi_session_release(s);
 }
 
-void dpi_session_init(void)
+static uint32_t session_flow_hash(dpi_session_t *s)
 {
-    DEBUG_LOG_FUNC_ENTRY(DBG_INIT | DBG_SESSION, NULL);
+    uint32_t h = 0;
+    int i;
+
+    if (FLAGS_TEST(s->flags, DPI_SESS_FLAG_IPV4)) {
+        h = ntohl(s->client.ip.ip4) ^ ntohl(s->server.ip.ip4);
+    } else {
+        uint32_t *c = (uint32_t *)&s->client.ip.ip6, *v = (uint32_t *)&s->server.ip.ip6;
+        for (i = 0; i < 4; i ++) {
+            h ^= ntohl(c[i]) ^ ntohl(v[i]);
+        }
+    }
+    if (s->ip_proto == IPPROTO_TCP || s->ip_proto == IPPROTO_UDP || s->ip_proto == IPPROTO_SCTP) {
+        h ^= s->client.port ^ s->server.port;
+    }
+    return h ^ (h >> 16);
+}
+
+// Mark the flows of the endpoint's sessions in 'bits', by the symmetric flow hash dp uses to
+// hand packets between threads.
+typedef struct flow_bits_args_ {
+    const struct ether_addr *ep_mac;
+    uint8_t *bits;
+    uint32_t nbits;
+} flow_bits_args_t;
+
+static bool session_flow_bit(void *data, void *args)
+{
+    dpi_session_t *s = data;
+    flow_bits_args_t *fb = args;
+
+    if (mac_cmp(s->client.mac, (uint8_t *)fb->ep_mac->ether_addr_octet) ||
+        mac_cmp(s->server.mac, (uint8_t *)fb->ep_mac->ether_addr_octet)) {
+        uint32_t bit = session_flow_hash(s) % fb->nbits;
+        BITMASK_SET(fb->bits, bit);
+    }
+    return false;
+}
+
+void dpi_session_flow_bits(const struct ether_addr *ep_mac, uint8_t *bits, uint32_t nbits)
+{
+    flow_bits_args_t fb = {ep_mac, bits, nbits};
 
-    rcu_map_init(&th_session4_map, 512, offsetof(dpi_session_t, node),
-                 session4_match, session4_hash);
-    rcu_map_init(&th_session6_map, 64, offsetof(dpi_session_t, node),
-                 session6_match, session6_hash);
+    flat_map_for_each(&th_session4_map, session_flow_bit, &fb);
+    flat_map_for_each(&th_session6_map, session_flow_bit, &fb);
 }
 
-void dpi_session_proxymesh_init(void)
+void dpi_session_init(void)
 {
     DEBUG_LOG_FUNC_ENTRY(DBG_INIT | DBG_SESSION, NULL);
 
-    rcu_map_init(&th_session4_proxymesh_map, 64, offsetof(dpi_session_t, node),
-                 session4_proxymesh_match, session4_proxymesh_hash);
-    rcu_map_init(&th_session6_proxymesh_map, 32, offsetof(dpi_session_t, node),
-                 session6_proxymesh_match, session6_proxymesh_hash);
+    flat_map_init(&th_session4_map, dpi_map_size(DP_MAP_SESSION4, 512), session4_match, session4_hash);
+    flat_map_init(&th_session6_map, dpi_map_size(DP_MAP_SESSION6, 64), session6_match, session6_hash);
+    CDS_INIT_LIST_HEAD(&th_offload_list);
+    dpi_pool_init(DP_POOL_SESSION, sizeof(dpi_session_t));
+    dpi_pool_init(DP_POOL_CLIP, DPI_CLIP_POOL_SIZE);
+
+    flat_map_init(&th_flowlet_map, DPI_FLOWLET_MAX, flowlet_match, flowlet_hash);
+    CDS_INIT_LIST_HEAD(&th_flowlet_list);
+    CDS_INIT_LIST_HEAD(&th_flowlet_free);
+    th_flowlets = mem_calloc(DP_MEM_SESSION, DPI_FLOWLET_MAX, sizeof(dpi_flowlet_t));
+    if (th_flowlets != NULL) {
+        int i;
+        for (i = 0; i < DPI_FLOWLET_MAX; i ++) {
+            cds_list_add_tail(&th_flowlets[i].link, &th_flowlet_free);
+        }
+    }
 }
 
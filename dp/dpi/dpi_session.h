@@ -11,6 +11,22 @@
 
 #define DPI_WING_FLAG_FIN  0x01
 #define DPI_WING_FLAG_SACK 0x02
+#define DPI_WING_FLAG_RESYNC 0x04   // sequence moved on while offloaded, take it from the next packet
+
+// What a tcp parser accepts as the first payload of a session. The parsers are screened with it
+// before they run on the first payload, the ones that would give up on it are fired right away.
+// A parser without a signature runs on every session.
+typedef struct dpi_parser_sig_ {
+    uint8_t flags;
+#define DPI_PARSER_SIG_CLIENT_FIRST  0x01   // gives up if the server sends first
+#define DPI_PARSER_SIG_SERVER_FIRST  0x02   // gives up if the client sends first
+#define DPI_PARSER_SIG_ALPHA         0x04   // the client's first byte is a letter
+#define DPI_PARSER_SIG_CLIENT_MAGIC  0x08   // the client's first payload starts with a magic
+#define DPI_PARSER_SIG_SERVER_MAGIC  0x10   // the server's first payload starts with a magic
+    // NULL terminated. Without a _MAGIC flag, the magics only confirm the protocol on the
+    // parser's usual port, and the first payload may start with anything else too.
+    const char **magic;
+} dpi_parser_sig_t;
 
 typedef struct dpi_parser_ {
     void (*new_session) (dpi_packet_t *p);
@@ -21,8 +37,15 @@ typedef struct dpi_parser_ {
 
     const char *name;
     uint8_t ip_proto, type;
+    const dpi_parser_sig_t *sig;
 } dpi_parser_t;
 
+// Hyperscan stream of the DLP packet database, at seq of the bytes scanned
+typedef struct dpi_dlp_stream_ {
+    void *hs;                   // hs_stream_t
+    uint32_t seq, gen;
+} dpi_dlp_stream_t;
+
 typedef struct dpi_wing_ {
     uint8_t mac[ETH_ALEN];
     uint16_t port;
@@ -39,6 +62,7 @@ typedef struct dpi_wing_ {
             uint32_t icmp_echo_hash;
             uint16_t icmp_echo_seq;
             uint8_t icmp_times;
+            uint8_t icmp_echo_len;  // payload length of the last echo, up to 255
         };
     };
     uint16_t tcp_mss;
@@ -46,6 +70,8 @@ typedef struct dpi_wing_ {
             tcp_wscale: 4;
     uint8_t flags;
     asm_t asm_cache;
+    dpi_dlp_stream_t dlp_stream;    // of the payload
+    dpi_dlp_stream_t dlp_inflate;   // of the bodies a parser inflated, see DPI_PKT_FLAG_INFLATED
     uint32_t pkts, bytes;
     uint32_t reported_pkts, reported_bytes;
 } dpi_wing_t;
@@ -74,6 +100,14 @@ typedef struct dpi_wing_ {
 // false so no re-eval but SURE_PARSER is true so mid-session log keeps sending.
 #define DPI_SESS_FLAG_SURE_PARSER (DPI_SESS_FLAG_FINAL_PARSER | DPI_SESS_FLAG_SKIP_PARSER)
 
+// DLP/WAF eligibility of a session, see dpi_pkt_detect_check()
+#define DPI_SESS_DETECT_VALID           0x01
+#define DPI_SESS_DETECT_DLP             0x02
+#define DPI_SESS_DETECT_WAF             0x04
+#define DPI_SESS_DETECT_NO_NET_POLICY   0x08    // evaluated with the network policy disabled
+#define DPI_SESS_DETECT_MESH            0x10    // evaluated for a proxymesh packet
+#define DPI_SESS_DETECT_DLP_DONE        0x20    // the DLP scan budget is used up
+
 // 4bits in session
 #define DPI_SESS_TICK_FLAG_SMALL_WINDOWS  0x1
 #define DPI_SESS_TICK_FLAG_SLOWLORIS      0x2
@@ -95,8 +129,53 @@ enum {
     DPI_SESS_TERM_DLP,
 };
 
+// Rarely used session state, allocated on first use and freed with the session.
+typedef struct dpi_session_xff_ {
+    dpi_policy_desc_t desc;
+    uint32_t client_ip;
+    uint16_t app;
+    uint16_t port;
+    // What desc was evaluated with, it is kept while the next requests carry the same values
+    bool eval_valid;
+    uint16_t eval_app;
+    uint16_t eval_port;
+    uint16_t eval_hdl_ver;
+    uint16_t eval_ep_ver;
+    uint32_t eval_ip;
+    uint32_t eval_gen;
+    const void *eval_hdl;
+} dpi_session_xff_t;
+
+// Flow of a session offloaded to the tc classifier, allocated on offload and freed when the
+// flow comes back to the dp.
+typedef struct dpi_session_offload_ {
+    struct cds_list_head link;  // on th_offload_list
+    struct dpi_session_ *sess;
+    io_flow_key_t key[2];       // client to server, server to client
+    io_flow_stats_t synced[2];  // kernel counters already added to the wings
+    uint32_t active;            // last tick the kernel counters moved
+    uint16_t timeout;           // idle timeout of the session
+} dpi_session_offload_t;
+
+#define DPI_VHOST_MAX 256   // including the terminating zero
+typedef struct dpi_session_vhost_ {
+    uint16_t len;
+    uint16_t size;
+    char name[];
+} dpi_session_vhost_t;
+
+#define DPI_TLS_ALPN_MAX 32 // including the terminating zero
+#define DPI_TLS_JA3_LEN  32
+#define DPI_TLS_JA4_LEN  36
+typedef struct dpi_session_tls_ {
+    uint16_t client_version;    // highest version offered by the client
+    uint16_t version;           // version picked by the server, 0 until the ServerHello
+    char alpn[DPI_TLS_ALPN_MAX];    // first protocol offered
+    char ja3[DPI_TLS_JA3_LEN + 1];
+    char ja4[DPI_TLS_JA4_LEN + 1];
+} dpi_session_tls_t;
+
 typedef struct dpi_session_ {
-    struct cds_lfht_node node;
     timer_entry_t ts_entry;
     timer_entry_t tick_entry;
 
@@ -105,7 +184,7 @@ typedef struct dpi_session_ {
     uint32_t last_report;
 
     dpi_wing_t client, server;
-    void *parser_data[DPI_PARSER_MAX];
+    void **parser_data;         // DPI_PARSER_MAX entries, NULL until a parser keeps data
 
     uint16_t flags;
     uint8_t tick_flags :4,
@@ -121,17 +200,78 @@ typedef struct dpi_session_ {
     uint8_t action:      3,
             severity:    3,
             term_reason: 2;
+    bool verdict_cached;        // no more inspection, see dpi_session_verdict_valid()
+    bool parser_screened;       // the parsers were screened with the first payload
+    bool asm_limited;           // over a reassembly budget, only in-order data is inspected
+    bool mesh_leg;              // network leg of a meshed pod, takes the blocks of the "lo" leg
+    bool nfq_marked;            // the connection skips the nfq, only samples and TCP SYN/FIN/RST come
+#define DPI_SYN_PROXY_NONE  0
+#define DPI_SYN_PROXY_WAIT  1       // opened by a syn cookie, waiting for the server's SYN/ACK
+#define DPI_SYN_PROXY_ON    2
+    uint8_t syn_proxy;
+    uint32_t syn_delta;         // the cookie while waiting, then cookie minus the server's isn
+    uint32_t asm_bytes;         // reassembly cache accounted to the thread and endpoint
+    uint32_t stats_ep_gen;      // g_ep_map_gen when stats_ep was found
+    struct io_ep_ *stats_ep;    // counting the session, valid while g_ep_map_gen is stats_ep_gen
     uint32_t threat_id;
+    uint16_t verdict_policy_ver;    // versions of the endpoint the verdict was taken with
+    uint16_t verdict_inspect_ver;
+    uint8_t detect_flags;           // DPI_SESS_DETECT_xxx
+    uint16_t detect_policy_ver;     // versions of the endpoint and app the eligibility is for
+    uint16_t detect_inspect_ver;
+    uint16_t detect_app;
+    uint32_t dlp_scanned;           // payload bytes matched by DLP, counted with a scan budget
     dpi_policy_desc_t policy_desc;
-    dpi_policy_desc_t xff_desc;
     BITOP tags;
-    uint32_t xff_client_ip;
-    uint16_t xff_app;
-    uint16_t xff_port;
-    uint8_t vhost[256];
-    uint16_t vhlen;
+    dpi_session_xff_t *xff;     // NULL until an X-Forwarded header is seen
+    dpi_session_vhost_t *vhost; // NULL until a host name or SNI is seen
+    dpi_session_tls_t *tls;     // NULL until a TLS ClientHello is seen
+    dpi_session_offload_t *offload; // NULL unless the flow is offloaded to the kernel
 } dpi_session_t;
 
+// A DNS exchange over UDP of a workload, kept without a session while it's a query and its
+// answer, see dpi_flowlet_track(). IPv4 only, as the flow cache.
+typedef struct dpi_flowlet_ {
+    struct cds_list_head link;  // on th_flowlet_list by the last packet, or th_flowlet_free
+    uint32_t client_ip, server_ip;
+    uint16_t client_port, server_port;
+    uint8_t client_mac[ETH_ALEN];   // the workload's
+    uint8_t server_mac[ETH_ALEN];
+    uint32_t id;
+    uint32_t created_at, last_seen;
+    uint32_t client_bytes, server_bytes;
+    uint16_t client_pkts, server_pkts;
+    uint16_t policy_ver;        // of the endpoint when the policy was looked up
+    uint8_t severity;
+    uint32_t threat_id;
+    dpi_policy_desc_t policy_desc;
+} dpi_flowlet_t;
+
+#define DPI_FLOWLET_MAX     1024  // per dp thread, the oldest is released for a new one
+#define DPI_FLOWLET_TIMEOUT 5     // seconds after the last packet
+
+extern const dpi_session_xff_t g_dpi_session_no_xff;
+
+// Read-only view, zero values if not allocated
+static inline const dpi_session_xff_t *dpi_session_xff(const dpi_session_t *s)
+{
+    return s->xff != NULL ? s->xff : &g_dpi_session_no_xff;
+}
+
+static inline const char *dpi_session_vhost(const dpi_session_t *s)
+{
+    return s->vhost != NULL ? s->vhost->name : "";
+}
+
+static inline uint16_t dpi_session_vhlen(const dpi_session_t *s)
+{
+    return s->vhost != NULL ? s->vhost->len : 0;
+}
+
+dpi_session_xff_t *dpi_session_get_xff(dpi_session_t *s);
+dpi_session_tls_t *dpi_session_get_tls(dpi_session_t *s);
+void dpi_session_set_vhost(dpi_session_t *s, const uint8_t *name, int len);
+
 static inline uint32_t dpi_wing_length(const dpi_wing_t *wing)
 {
     return u32_distance(wing->init_seq, wing->next_seq);
@@ -141,10 +281,15 @@ void dpi_session_release(dpi_session_t *s);
 void dpi_session_timeout(timer_entry_t *n);
 void dpi_session_term_reason(dpi_session_t *s, int term);
 
-extern uint32_t g_sess_id_to_clear;
-extern struct ether_addr *g_mac_addr_to_del;
 void dpi_session_delete(dpi_session_t *s, int reason);
 
+void dpi_session_offload(dpi_packet_t *p);
+void dpi_session_offload_sync(dpi_session_t *s);
+void dpi_session_offload_resume(dpi_session_t *s);
+void dpi_session_offload_check(void);
+void dpi_flowlet_expire(void);
+void dpi_session_nfq_mark(dpi_packet_t *p);
+
 void dpi_proto_parser(dpi_packet_t *p);
 void dpi_midstream_proto_praser(dpi_packet_t *p);
 void dpi_recruit_parser(dpi_packet_t *p);
@@ -157,10 +302,15 @@ void dpi_ignore_parser(dpi_packet_t *p);
 void dpi_set_asm_seq(dpi_packet_t *p, uint32_t seq);
 bool dpi_is_parser_final(dpi_packet_t *p);
 void dpi_finalize_parser(dpi_packet_t *p);
+bool dpi_finalize_inspect_parser(dpi_packet_t *p);
 void dpi_purge_parser_data(dpi_session_t *s);
 
+clip_t *dpi_clip_alloc(uint32_t data_len);
+void dpi_clip_free(clip_t *clip);
 void dpi_asm_remove(clip_t *clip);
-int dpi_cache_packet(dpi_packet_t *p, dpi_wing_t *w, bool lookup);
+int dpi_cache_packet(dpi_packet_t *p, dpi_wing_t *w, bool lookup, bool ref);
+void dpi_hold_cached_clip(dpi_packet_t *p);
+void dpi_session_asm_account(dpi_session_t *s);
 
 io_app_t *dpi_ep_app_map_lookup(io_ep_t *ep, uint16_t port, uint8_t ip_proto);
 void dpi_ep_set_proto(dpi_packet_t *p, uint16_t proto);
@@ -168,8 +318,15 @@ void dpi_ep_set_app(dpi_packet_t *p, uint16_t server, uint16_t application);
 void dpi_ep_set_server_ver(dpi_packet_t *p, char *ver, int len);
 uint16_t dpi_ep_get_app(dpi_packet_t *p);
 bool dpi_is_base_app(uint16_t app);
+const char *dpi_parser_name(int type);
+
+void dpi_resume_save(dpi_session_t *s);
+void dpi_resume_drop(dpi_session_t *s);
+bool dpi_resume_lookup(dpi_packet_t *p, bool *to_server);
 
 void dpi_inject_reset(dpi_packet_t *p, bool to_server);
+int dpi_inject_tcp(dpi_packet_t *p, bool reply, uint32_t seq, uint32_t ack, uint8_t flags,
+                   uint16_t win, uint16_t mss);
 void dpi_inject_reset_by_session(dpi_session_t *s, bool to_server);
 void dpi_session_start_tick_for(dpi_session_t *s, uint8_t flag, dpi_packet_t *p);
 void dpi_session_stop_tick_for(dpi_session_t *s, uint8_t flag, dpi_packet_t *p);
@@ -190,17 +347,21 @@ static inline void dpi_session_unset_tick(dpi_session_t *s, int tick_flag)
 }
 
 void dpi_catch_stats_slot(io_stats_t *stats, uint32_t slot);
+uint32_t dpi_ep_cur_session(io_ep_t *ep);
 void dpi_inc_stats_packet(dpi_packet_t *p);
 void dpi_inc_stats_session(dpi_packet_t *p, dpi_session_t *s);
+void dpi_inc_stats_flowlet(dpi_packet_t *p);
 void dpi_dec_stats_session(dpi_session_t *s);
 
 int dpi_http_tick_timeout(dpi_session_t *s, void *parser_data);
+uint32_t dpi_http_tick_deadline(dpi_session_t *s, void *parser_data);
 
 const char *dpi_get_tcp_state_name(int state);
 
 void dpi_session_init(void);
-void dpi_session_proxymesh_init(void);
 void dpi_session_trim(void);
 
 int dpi_sess_policy_reeval(dpi_session_t *s);
+bool dpi_sess_policy_scope_check(dpi_session_t *s, io_ep_t *ep);
+void dpi_session_policy_sweep(void);
 #endif
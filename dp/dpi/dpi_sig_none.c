@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdint.h>
+
+#include "apis.h"
+#include "debug.h"
+#include "dpi/dpi_module.h"
+#include "dpi/sig/dpi_search.h"
+
+// Built with MSEG_ONLY, the micro-segmentation dp has no DLP/WAF engine: the sig/ objects and
+// hyperscan are left out and these are what the rest of the dp calls instead. Endpoints
+// never get a detector, so no packet is handed to the engine.
+
+#ifdef DP_NO_SIG
+
+void dpi_dlp_init(void)
+{
+    DEBUG_INIT("DLP/WAF engine not built\n");
+}
+
+int dpi_sig_bld(dpi_dlpbld_t *dlpsig, int flag)
+{
+    DEBUG_ERROR(DBG_CTRL, "DLP/WAF engine not built, ignore rules\n");
+    return -1;
+}
+
+int dpi_sig_bld_update_mac(dpi_dlpbld_mac_t *dlpbld_mac)
+{
+    return -1;
+}
+
+void dp_dlp_destroy(void *dlp_detector)
+{
+}
+
+dpi_detector_t *dpi_dlp_next_req(uint8_t *req)
+{
+    return NULL;
+}
+
+void dpi_dlp_release_detector(dpi_detector_t *detector)
+{
+}
+
+void dpi_build_dlp_tree(dpi_detector_t *dlp_detector)
+{
+}
+
+void dpi_print_siglist_fp(dpi_detector_t *detector, FILE *logfp)
+{
+}
+
+void dpi_dlp_close_stream(dpi_wing_t *w)
+{
+}
+
+bool dpi_dlp_ep_policy_check(dpi_packet_t *p)
+{
+    return false;
+}
+
+bool dpi_waf_ep_policy_check(dpi_packet_t *p)
+{
+    return false;
+}
+
+bool dpi_process_detector(dpi_packet_t *p)
+{
+    return false;
+}
+
+#endif
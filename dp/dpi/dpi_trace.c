@@ -0,0 +1,155 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "urcu.h"
+
+#include "utils/helper.h"
+
+#include "dpi/dpi_module.h"
+
+// While g_lat_trace is set, each stage of a timed packet, see dpi_lat_sample(), is also
+// recorded as an event in a ring of its dp thread, the oldest events are overwritten.
+// The rings are dumped as Chrome trace events, which Perfetto and speedscope open as
+// timelines and flame graphs. A dump reads the rings while they are written, the few
+// events being overwritten at that moment can be wrong.
+
+#define DPI_TRACE_DUMP_FILE "/var/log/dp.trace.json"
+
+#define DPI_TRACE_RING_BITS 13
+#define DPI_TRACE_RING_SIZE (1 << DPI_TRACE_RING_BITS)
+#define DPI_TRACE_RING_MASK (DPI_TRACE_RING_SIZE - 1)
+
+typedef struct dpi_trace_event_ {
+    uint64_t start;         // tsc ticks
+    uint32_t ticks;
+    uint32_t sess_id;
+    uint16_t hist;          // DP_LAT_*, or DP_LAT_STAGE_MAX + the parser type
+    uint8_t ep_mac[ETH_ALEN];
+} dpi_trace_event_t;
+
+typedef struct dpi_trace_ring_ {
+    uint32_t next __attribute__((aligned(64)));
+    dpi_trace_event_t events[DPI_TRACE_RING_SIZE];
+} dpi_trace_ring_t;
+
+// Set by a signal, the dump is written by the ctrl thread
+static bool g_trace_dump_req;
+
+static dpi_trace_ring_t g_trace_rings[MAX_DP_THREADS];
+
+static const char *stage_names[DP_LAT_STAGE_MAX] = {
+    [DP_LAT_RX]       = "rx",
+    [DP_LAT_PARSE]    = "parse",
+    [DP_LAT_SESSION]  = "session",
+    [DP_LAT_TRACKER]  = "tracker",
+    [DP_LAT_POLICY]   = "policy",
+    [DP_LAT_DETECTOR] = "detector",
+    [DP_LAT_TX]       = "tx",
+};
+
+void dpi_trace_add(int hist, uint64_t start, uint64_t ticks)
+{
+    dpi_trace_ring_t *r = &g_trace_rings[g_dpi_thread - g_dpi_thread_data];
+    dpi_trace_event_t *e = &r->events[r->next & DPI_TRACE_RING_MASK];
+    dpi_packet_t *p = &th_packet;
+
+    e->start = start;
+    e->ticks = min(ticks, UINT32_MAX);
+    e->sess_id = p->session != NULL ? p->session->id : 0;
+    e->hist = hist;
+    if (p->ep_mac != NULL) {
+        mac_cpy(e->ep_mac, p->ep_mac);
+    } else {
+        memset(e->ep_mac, 0, sizeof(e->ep_mac));
+    }
+
+    cmm_smp_wmb();
+    uatomic_set(&r->next, r->next + 1);
+}
+
+static const char *trace_name(int hist)
+{
+    return hist < DP_LAT_STAGE_MAX ? stage_names[hist] : dpi_parser_name(hist - DP_LAT_STAGE_MAX);
+}
+
+// Events of all threads, ts and dur in us from the oldest one. To DPI_TRACE_DUMP_FILE if
+// path is NULL.
+int dpi_trace_dump(const char *path)
+{
+    uint64_t hz = lat_tsc_hz(), base = UINT64_MAX;
+    uint32_t first[MAX_DP_THREADS], last[MAX_DP_THREADS];
+    bool comma = false;
+    int i, events = 0;
+    FILE *fp;
+
+    if (path == NULL) {
+        path = DPI_TRACE_DUMP_FILE;
+    }
+    fp = fopen(path, "w");
+    if (fp == NULL) {
+        DEBUG_ERROR(DBG_CTRL, "fail to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        dpi_trace_ring_t *r = &g_trace_rings[i];
+
+        last[i] = uatomic_read(&r->next);
+        first[i] = last[i] > DPI_TRACE_RING_SIZE ? last[i] - DPI_TRACE_RING_SIZE : 0;
+        if (first[i] != last[i]) {
+            base = min(base, r->events[first[i] & DPI_TRACE_RING_MASK].start);
+        }
+    }
+    cmm_smp_rmb();
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"tsc_hz\":%ju},\"traceEvents\":[", hz);
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        dpi_trace_ring_t *r = &g_trace_rings[i];
+        uint32_t n;
+
+        if (first[i] == last[i]) {
+            continue;
+        }
+
+        fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"dp%d\"}}",
+                comma ? "," : "", i, i);
+        comma = true;
+
+        for (n = first[i]; n != last[i]; n ++) {
+            dpi_trace_event_t *e = &r->events[n & DPI_TRACE_RING_MASK];
+
+            // Overwritten after the ring was read
+            if (e->start < base || e->hist >= DP_LAT_HISTS) {
+                continue;
+            }
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                        "\"args\":{\"session\":%u,\"ep\":\""DBG_MAC_FORMAT"\"}}",
+                    trace_name(e->hist), i,
+                    (double)lat_tsc_to_ns(e->start - base, hz) / 1000,
+                    (double)lat_tsc_to_ns(e->ticks, hz) / 1000,
+                    e->sess_id, DBG_MAC_TUPLE(e->ep_mac));
+            events ++;
+        }
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+
+    DEBUG_CTRL("events=%d path=%s\n", events, path);
+    return 0;
+}
+
+// Safe in a signal handler
+void dpi_trace_request_dump(void)
+{
+    CMM_STORE_SHARED(g_trace_dump_req, true);
+}
+
+// On the ctrl timer, for a dump asked by a signal
+void dpi_trace_dump_timer(void)
+{
+    if (CMM_LOAD_SHARED(g_trace_dump_req)) {
+        CMM_STORE_SHARED(g_trace_dump_req, false);
+        dpi_trace_dump(NULL);
+    }
+}
@@ -168,6 +168,10 @@ static void cassandra_delete_data(void *data)
     free(data);
 }
 
+static const dpi_parser_sig_t cassandra_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_FIRST,
+};
+
 static dpi_parser_t dpi_parser_cassandra = {
     .new_session = cassandra_new_session,
     .delete_data = cassandra_delete_data,
@@ -175,6 +179,7 @@ static dpi_parser_t dpi_parser_cassandra = {
     .name = "cassandra",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_CASSANDRA,
+    .sig = &cassandra_sig,
 };
 
 dpi_parser_t *dpi_cassandra_parser(void)
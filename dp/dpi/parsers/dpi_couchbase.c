@@ -400,6 +400,10 @@ static void couchbase_delete_data(void *data)
     free(data);
 }
 
+static const dpi_parser_sig_t couchbase_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_FIRST,
+};
+
 static dpi_parser_t dpi_parser_couchbase = {
     .new_session = couchbase_new_session,
     .delete_data = couchbase_delete_data,
@@ -407,6 +411,7 @@ static dpi_parser_t dpi_parser_couchbase = {
     .name = "couchbase",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_COUCHBASE,
+    .sig = &couchbase_sig,
 };
 
 dpi_parser_t *dpi_couchbase_parser(void)
@@ -5,6 +5,7 @@
 
 #define MAX_LABEL_LEN  256
 #define MAX_RECORD_NUM 256
+#define ALLOW_POINTER_NUMBER    63
 typedef struct dns_wing_ {
     uint32_t seq;
 } dns_wing_t;
@@ -13,18 +14,13 @@ typedef struct dns_data_ {
     dns_wing_t client, server;
 } dns_data_t;
 
-typedef struct dns_question_ {
-    char question[MAX_LABEL_LEN];
-} dns_question_t;
-
-typedef struct dns_answer_ {
+// Names are kept as offsets in the message and compared in place, only the name of a
+// resolved question is decoded.
+typedef struct dns_rr_ {
+    uint16_t name;
+    uint16_t data;              // of the ipv4 address or the canonical name
     bool ip;
-    char question[MAX_LABEL_LEN];
-    union {
-        uint32_t ip4;
-        char cname[MAX_LABEL_LEN];
-    };
-} dns_answer_t;
+} dns_rr_t;
 
 #define DNS_OP_QUERY    0       // Standard query
 #define DNS_OP_IQUERY   1       // Inverse query (deprecated/unsupported)
@@ -142,7 +138,8 @@ typedef struct dns_hdr_ {
     uint16_t ar_count;
 } dns_hdr_t;
 
-//get the dns domain name and canonical name, it is allowed pointer
+//get the dns domain name and canonical name, it is allowed pointer.
+//'labels' can be NULL to only validate and skip the name
 static int get_dns_name(dpi_packet_t *p, uint8_t *ptr, int len, int shift, char *labels)
 {
     int  size,total = 0;
@@ -156,7 +153,7 @@ static int get_dns_name(dpi_packet_t *p, uint8_t *ptr, int len, int shift, char
             size = *np;
             //check size valid
             if (size == 0) {
-                if (lp > labels) {
+                if (labels != NULL && lp > labels) {
                     *(lp-1)  = 0;
                 } 
                 if (loop == 0) {
@@ -169,12 +166,14 @@ static int get_dns_name(dpi_packet_t *p, uint8_t *ptr, int len, int shift, char
                 DEBUG_LOG(DBG_PARSER, p, "invalid dns question label\n");
                 return -1;
             }
-            if ((lp+size) >= (labels+MAX_LABEL_LEN)) return -1;
+            if (labels != NULL) {
+                if ((lp+size) >= (labels+MAX_LABEL_LEN)) return -1;
 
-            memcpy(lp, np, size);
+                memcpy(lp, np, size);
+                lp  += size;
+                *lp++  = '.';
+            }
             np  += size;
-            lp  += size;
-            *lp++  = '.';
             if (loop == 0) {
                 total += size + 1;
             } 
@@ -189,7 +188,6 @@ static int get_dns_name(dpi_packet_t *p, uint8_t *ptr, int len, int shift, char
                 return -1;
             }
             loop ++;
-#define ALLOW_POINTER_NUMBER    63
             //to avoid loop forever
             if (loop > ALLOW_POINTER_NUMBER) { 
                 DEBUG_LOG(DBG_PARSER, p, "dns pointer loop=%d\n", loop);
@@ -229,47 +227,114 @@ static int get_dns_name(dpi_packet_t *p, uint8_t *ptr, int len, int shift, char
     return -1;
 }
 
+// Return the length of the next label of the name at *off and point *label to it, 0 at the
+// end of the name, -1 if invalid. Pointers are followed, at most ALLOW_POINTER_NUMBER.
+static int dns_label(uint8_t *ptr, int len, int *off, int *ptrs, uint8_t **label)
+{
+    while (*off < len) {
+        uint8_t c = ptr[*off];
+
+        if ((c & 0xc0) == 0xc0) {
+            if (*off + 1 >= len || ++ (*ptrs) > ALLOW_POINTER_NUMBER) return -1;
+            *off = ((c & 0x3f) << 8) | ptr[*off + 1];
+            continue;
+        }
+        if (c & 0xc0) return -1;
+        if (c == 0) return 0;
+        if (*off + 1 + c >= len) return -1;
+
+        *label = ptr + *off + 1;
+        *off += 1 + c;
+        return c;
+    }
+    return -1;
+}
+
+static bool dns_name_equal(uint8_t *ptr, int len, int a, int b)
+{
+    int pa = 0, pb = 0, la, lb, i;
+    uint8_t *sa, *sb;
+
+    while (true) {
+        // Compressed names usually point to the same place
+        if (a == b) return true;
+
+        la = dns_label(ptr, len, &a, &pa, &sa);
+        lb = dns_label(ptr, len, &b, &pb, &sb);
+        if (la < 0 || la != lb) return false;
+        if (la == 0) return true;
+
+        for (i = 0; i < la; i ++) {
+            if (tolower(sa[i]) != tolower(sb[i])) return false;
+        }
+    }
+}
+
+// Decode the name at 'off' in lower case, without the trailing dot
+static int dns_name_decode(uint8_t *ptr, int len, int off, char *name)
+{
+    int ptrs = 0, n = 0, l, i;
+    uint8_t *label;
+
+    while ((l = dns_label(ptr, len, &off, &ptrs, &label)) > 0) {
+        if (n + l + 1 >= MAX_LABEL_LEN) return -1;
+        if (n > 0) name[n ++] = '.';
+        for (i = 0; i < l; i ++) {
+            name[n ++] = tolower(label[i]);
+        }
+    }
+    name[n] = 0;
+    return l < 0 ? -1 : n;
+}
+
 //get the domain to ip mapping
-static int get_domain_ip_mapping(dpi_packet_t *p, dns_question_t* questions, int qn, dns_answer_t* answers, int an)
+static int get_domain_ip_mapping(dpi_packet_t *p, uint8_t *ptr, int len,
+                                 uint16_t *questions, int qn, dns_rr_t *answers, int an)
 {
     int i,j;
     for (i=0; i < qn; i++) {
         char name[MAX_LABEL_LEN];
         uint32_t ips[an];
-        int cnt = 0;
+        int cnt = 0, cur = questions[i];
+        bool external = false;
 
-        strlcpy(name, questions[i].question, MAX_LABEL_LEN);
         for (j=0; j < an; j++) {
-            if (strcasecmp(name, answers[j].question) == 0) {
+            if (dns_name_equal(ptr, len, cur, answers[j].name)) {
                 if (answers[j].ip) {
-                    //inform policy here
-                    DEBUG_LOG(DBG_PARSER, p, "%s --> "DBG_IPV4_FORMAT"\n",questions[i].question,
-                            DBG_IPV4_TUPLE(answers[j].ip4));
-                    ips[cnt] = answers[j].ip4;
+                    memcpy(&ips[cnt], ptr + answers[j].data, 4);
+                    external |= !dpi_is_ip4_internal(ips[cnt]);
                     cnt++;
                 } else {
-                    strlcpy(name, answers[j].cname, MAX_LABEL_LEN);
+                    cur = answers[j].data;
                 }
             }
         }
-        if (cnt > 0) {
-            snooped_fqdn_ipv4_mapping(questions[i].question, ips, cnt);
-            sniff_ip_fqdn_storage(questions[i].question, ips, cnt);
+        if (cnt == 0 || dns_name_decode(ptr, len, questions[i], name) <= 0) {
+            continue;
+        }
+
+        DEBUG_LOG(DBG_PARSER, p, "%s --> "DBG_IPV4_FORMAT", cnt=%d\n", name, DBG_IPV4_TUPLE(ips[0]), cnt);
+
+        // Most answers are of names no FQDN rule cares about, and of internal addresses
+        if (snooped_fqdn_name_wanted(name)) {
+            snooped_fqdn_ipv4_mapping(name, ips, cnt);
+        }
+        if (external) {
+            sniff_ip_fqdn_storage(name, ips, cnt);
         }
     }
     return 0;
 }
 
-static int dns_question(dpi_packet_t *p, uint8_t *ptr, int len, int shift, int count, dns_question_t *questions, int *qt_count)
+static int dns_question(dpi_packet_t *p, uint8_t *ptr, int len, int shift, int count, uint16_t *questions, int *qt_count)
 {
-    char labels[MAX_LABEL_LEN];
     while (count > 0) {
-        labels[0] = 0;
-        int jump = get_dns_name(p, ptr, len, shift, labels);
+        int jump = get_dns_name(p, ptr, len, shift, NULL);
         if (jump < 0) {
             return jump;
         }
 
+        int name = shift;
         shift += jump + 4;
         if (shift > len) return -1;
 
@@ -277,7 +342,7 @@ static int dns_question(dpi_packet_t *p, uint8_t *ptr, int len, int shift, int c
 
         if (type == DNS_TYPE_A && questions != NULL) {
             if (jump > 1) {
-                strlcpy(questions[(*qt_count)++].question, labels, MAX_LABEL_LEN);
+                questions[(*qt_count)++] = name;
             }
         }else if (type == DNS_TYPE_AXFR) {
             DEBUG_LOG(DBG_PARSER, p, "DNS Zone Transfer AXFR.\n");
@@ -295,15 +360,15 @@ static int dns_question(dpi_packet_t *p, uint8_t *ptr, int len, int shift, int c
     return shift;
 }
 
-static int dns_answer(dpi_packet_t *p, uint8_t *ptr, int len, int shift, int count, dns_answer_t *answers, int *aw_count)
+static int dns_answer(dpi_packet_t *p, uint8_t *ptr, int len, int shift, int count, dns_rr_t *answers, int *aw_count)
 {
-    char labels[MAX_LABEL_LEN];
     while (count > 0) {
-        labels[0] = 0;
-        int jump = get_dns_name(p, ptr, len, shift, labels);
+        int jump = get_dns_name(p, ptr, len, shift, NULL);
         if (jump < 0) {
             return jump;
         }
+
+        int name = shift;
         shift += jump;
 
         if (shift + 10 > len) {
@@ -323,19 +388,17 @@ static int dns_answer(dpi_packet_t *p, uint8_t *ptr, int len, int shift, int cou
         //ipv4 address
         if (type == DNS_TYPE_A && rd_len == 4 && answers != NULL) {
             if (jump > 1) {
-                strlcpy(answers[*aw_count].question, labels, MAX_LABEL_LEN);
-                uint8_t *addr = ptr + shift;
-                memcpy(&answers[*aw_count].ip4, addr, 4);
+                answers[*aw_count].name = name;
+                answers[*aw_count].data = shift;
                 answers[*aw_count].ip = true;
                 (*aw_count)++;
             }
         }else if (type == DNS_TYPE_CNAME && answers != NULL) {
-            char cname[MAX_LABEL_LEN]={'\0'};
             if (jump > 1) {
-                int ret = get_dns_name(p, ptr, len, shift, cname);
+                int ret = get_dns_name(p, ptr, len, shift, NULL);
                 if (ret > 1) {
-                    strlcpy(answers[*aw_count].question, labels, MAX_LABEL_LEN);
-                    strlcpy(answers[*aw_count].cname, cname, MAX_LABEL_LEN);
+                    answers[*aw_count].name = name;
+                    answers[*aw_count].data = shift;
                     answers[*aw_count].ip = false;
                     (*aw_count)++;
                 }
@@ -352,8 +415,8 @@ static int dns_parser(dpi_packet_t *p, uint8_t *ptr, uint32_t len)
 {
     int shift = 0;
     dns_hdr_t *dns = (dns_hdr_t *)ptr;
-    dns_question_t* questions = NULL;
-    dns_answer_t* answers = NULL;
+    uint16_t q_names[MAX_RECORD_NUM], *questions = NULL;
+    dns_rr_t a_rrs[MAX_RECORD_NUM], *answers = NULL;
     int qt_count = 0, aw_count = 0;
 
 
@@ -385,33 +448,17 @@ static int dns_parser(dpi_packet_t *p, uint8_t *ptr, uint32_t len)
     uint16_t qd = ntohs(dns->qd_count);
     uint16_t an = ntohs(dns->an_count);
 
-    //limit the question and answer max number in case of wrong dns type
-    if ((qd + an) < MAX_RECORD_NUM) {
-        if (qd > 0) {
-            questions = calloc(qd, sizeof(dns_question_t));
-        }
-        if (an > 0) {
-            answers = calloc(an, sizeof(dns_answer_t));
-        }
-
-        if ((questions == NULL) ^ (answers == NULL)) {
-            free(questions);
-            free(answers);
-            questions = NULL;
-            answers = NULL;
-        }
+    //limit the question and answer max number in case of wrong dns type,
+    //addresses are only mapped for responses with both
+    if ((qd + an) < MAX_RECORD_NUM && qd > 0 && an > 0) {
+        questions = q_names;
+        answers = a_rrs;
     }
 
     if (qd > 0) {
         DEBUG_LOG(DBG_PARSER, p, "DNS question record: %u\n", qd);
         shift = dns_question(p, ptr, len, shift, qd, questions, &qt_count);
         if (shift < 0) {
-            if (questions != NULL){
-                free(questions);
-            }
-            if (answers != NULL) {
-                free(answers);
-            }
             return -1;
         }
     }
@@ -420,24 +467,12 @@ static int dns_parser(dpi_packet_t *p, uint8_t *ptr, uint32_t len)
         DEBUG_LOG(DBG_PARSER, p, "DNS answer record: %u\n", an);
         shift = dns_answer(p, ptr, len, shift, an, answers, &aw_count);
         if (shift < 0) {
-            if (questions != NULL){
-                free(questions);
-            }
-            if (answers != NULL) {
-                free(answers);
-            }
             return -1;
         }
     }
 
-    if (qt_count > 0 && aw_count > 0 && questions != NULL && answers != NULL) {
-        get_domain_ip_mapping(p, questions, qd, answers, an);
-    }
-    if (questions != NULL){
-        free(questions);
-    }
-    if (answers != NULL) {
-        free(answers);
+    if (qt_count > 0 && aw_count > 0) {
+        get_domain_ip_mapping(p, ptr, len, questions, qt_count, answers, aw_count);
     }
 
     uint16_t ns = ntohs(dns->ns_count);
@@ -600,11 +635,27 @@ static void dns_udp_parser(dpi_packet_t *p)
     dpi_finalize_parser(p);
 }
 
+// A message of a flowlet, which has no session to confirm DNS on, so the oversized ones are
+// left to the session's overflow check. -1 if it's not a DNS message.
+int dpi_dns_udp_snoop(dpi_packet_t *p)
+{
+    uint32_t len = dpi_pkt_len(p);
+
+    if (len > DNS_OVERFLOW_THRES) {
+        return -1;
+    }
+    return dns_parser(p, dpi_pkt_ptr(p), len) < 0 ? -1 : 0;
+}
+
 static void dns_udp_new_session(dpi_packet_t *p)
 {
     dpi_hire_parser(p);
 }
 
+static const dpi_parser_sig_t dns_tcp_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_FIRST,
+};
+
 static dpi_parser_t dpi_parser_dns_tcp = {
     .new_session = dns_tcp_new_session,
     .delete_data = dns_tcp_delete_data,
@@ -612,6 +663,7 @@ static dpi_parser_t dpi_parser_dns_tcp = {
     .name = "dns",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_DNS,
+    .sig = &dns_tcp_sig,
 };
 
 static dpi_parser_t dpi_parser_dns_udp = {
@@ -34,6 +34,11 @@
 
 #define HTTP2_LEN_MAX (10*1024)
 
+/* HEADERS, PUSH_PROMISE and DATA flags */
+#define HTTP2_FLAGS_END_HEADERS 0x04
+#define HTTP2_FLAGS_PADDED      0x08
+#define HTTP2_FLAGS_PRIORITY    0x20
+
 /* Magic Header : PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n */
 static uint8_t http2clientmagic[] = {
     0x50, 0x52, 0x49, 0x20, 0x2a, 0x20, 0x48, 0x54,
@@ -56,11 +61,37 @@ static const char* http2_type_vals[] = {
     [HTTP2_BLOCKED] = "BLOCKED",
 };
 
+// HPACK, RFC 7541. Each wing decodes the header blocks it sends with its own dynamic table.
+// Entries are appended to an arena twice the table size that is compacted when it fills
+// up, the eviction order is kept in a ring.
+#define HPACK_TABLE_DEFAULT 4096
+#define HPACK_TABLE_MAX     65536
+#define HPACK_ENTRY_OVERHEAD 32
+#define HPACK_STR_MAX       16384
+#define HPACK_STATIC_ENTRIES 61
+
+typedef struct hpack_entry_ {
+    uint32_t off;
+    uint16_t name_len;
+    uint16_t value_len;
+} hpack_entry_t;
+
+typedef struct hpack_table_ {
+    uint8_t *buf;
+    hpack_entry_t *ents;
+    uint32_t buf_size, used;
+    uint32_t ent_cap, first, count;
+    uint32_t size, max_size;
+} hpack_table_t;
+
 typedef struct grpc_wing_ {
     uint32_t seq;
     uint32_t h2_strm_hdr_cnt;
     uint32_t pktcnt;
     uint8_t setting_flag;
+    bool hpack_broken;          // lost track of the dynamic table, stop decoding
+    bool data_skip;             // w->seq is after the end of a DATA frame
+    hpack_table_t hpack;
 } grpc_wing_t;
 
 typedef struct grpc_data_ {
@@ -68,6 +99,378 @@ typedef struct grpc_data_ {
     bool isgrpc;
 } grpc_data_t;
 
+static const struct {
+    const char *name, *value;
+} hpack_static[HPACK_STATIC_ENTRIES + 1] = {
+    [1] = {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+// Code lengths of the canonical Huffman code, symbol 256 is EOS
+static const uint8_t hpack_huff_len[257] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30,
+};
+
+// Decoding is a state machine over nibbles, a state is an inner node of the code tree.
+// A nibble completes at most one symbol, the shortest code is 5 bits.
+#define HPACK_HUFF_STATES   256
+#define HPACK_HUFF_ACCEPT   0x01    // the next state only has padding bits behind it
+#define HPACK_HUFF_EMIT     0x02
+#define HPACK_HUFF_FAIL     0x04
+
+typedef struct hpack_huff_ {
+    uint8_t state;
+    uint8_t flags;
+    uint8_t sym;
+} hpack_huff_t;
+
+static hpack_huff_t hpack_huff[HPACK_HUFF_STATES][16];
+
+// Decoded header blocks of the packet being parsed, and the strings of the current field
+static __thread uint8_t t_h2_hdrs[HTTP2_LEN_MAX];
+static __thread uint32_t t_h2_hdrs_len;
+static __thread uint32_t t_h2_hdrs_seq;
+static __thread uint8_t t_h2_path[HPACK_STR_MAX];
+static __thread uint8_t t_h2_name[HPACK_STR_MAX];
+static __thread uint8_t t_h2_value[HPACK_STR_MAX];
+
+static void hpack_huff_setup(void)
+{
+    int16_t child[HPACK_HUFF_STATES * 2 + 1][2], sym[HPACK_HUFF_STATES * 2 + 1];
+    uint8_t state[HPACK_HUFF_STATES * 2 + 1], accept[HPACK_HUFF_STATES * 2 + 1];
+    int nodes = 1, states = 1, len, s, i, n, b;
+    uint32_t code = 0;
+
+    memset(child, 0xff, sizeof(child));
+    memset(sym, 0xff, sizeof(sym));
+    state[0] = 0;
+    accept[0] = 1;
+
+    // Canonical code, shorter codes first, then by symbol
+    for (len = 5; len <= 30; len ++) {
+        for (s = 0; s < 257; s ++) {
+            if (hpack_huff_len[s] != len) continue;
+
+            for (n = 0, i = len - 1; i >= 0; i --) {
+                b = (code >> i) & 1;
+                if (child[n][b] < 0) {
+                    child[n][b] = nodes;
+                    if (i > 0) {
+                        state[nodes] = states ++;
+                        // Padding is up to 7 bits of the EOS code, all ones
+                        accept[nodes] = accept[n] && b == 1 && len - i < 8;
+                    }
+                    nodes ++;
+                }
+                n = child[n][b];
+            }
+            sym[n] = s;
+            code ++;
+        }
+        code <<= 1;
+    }
+
+    for (n = 0; n < nodes; n ++) {
+        if (sym[n] >= 0) continue;
+
+        for (b = 0; b < 16; b ++) {
+            hpack_huff_t *e = &hpack_huff[state[n]][b];
+            int cur = n;
+
+            e->flags = 0;
+            for (i = 3; i >= 0; i --) {
+                cur = child[cur][(b >> i) & 1];
+                if (cur < 0 || sym[cur] == 256) {
+                    e->flags = HPACK_HUFF_FAIL;
+                    break;
+                }
+                if (sym[cur] >= 0) {
+                    e->flags |= HPACK_HUFF_EMIT;
+                    e->sym = sym[cur];
+                    cur = 0;
+                }
+            }
+            if (!(e->flags & HPACK_HUFF_FAIL)) {
+                e->state = state[cur];
+                if (accept[cur]) e->flags |= HPACK_HUFF_ACCEPT;
+            }
+        }
+    }
+}
+
+static int hpack_huff_decode(const uint8_t *src, uint32_t len, uint8_t *dst, uint32_t cap)
+{
+    uint8_t state = 0, flags = HPACK_HUFF_ACCEPT;
+    uint32_t i, n = 0;
+
+    for (i = 0; i < len * 2; i ++) {
+        const hpack_huff_t *e = &hpack_huff[state][i & 1 ? src[i >> 1] & 0xf : src[i >> 1] >> 4];
+
+        if (e->flags & HPACK_HUFF_FAIL) {
+            return -1;
+        }
+        if (e->flags & HPACK_HUFF_EMIT) {
+            if (n == cap) return -1;
+            dst[n ++] = e->sym;
+        }
+        state = e->state;
+        flags = e->flags;
+    }
+    return (flags & HPACK_HUFF_ACCEPT) ? n : -1;
+}
+
+static int hpack_int(uint8_t **ptr, uint8_t *end, int prefix, uint32_t *v)
+{
+    uint32_t mask = (1 << prefix) - 1, shift = 0;
+    uint8_t b;
+
+    if (*ptr >= end) return -1;
+    *v = *(*ptr) ++ & mask;
+    if (*v < mask) return 0;
+
+    do {
+        if (*ptr >= end || shift > 21) return -1;
+        b = *(*ptr) ++;
+        *v += (uint32_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return 0;
+}
+
+// A raw string is returned in place, a Huffman coded one is decoded to buf
+static int hpack_string(uint8_t **ptr, uint8_t *end, uint8_t *buf, uint8_t **str, uint32_t *len)
+{
+    bool huff;
+    uint32_t n;
+    int dec;
+
+    if (*ptr >= end) return -1;
+    huff = (**ptr & 0x80) != 0;
+    if (hpack_int(ptr, end, 7, &n) < 0 || n > end - *ptr || n > HPACK_STR_MAX) return -1;
+
+    if (huff) {
+        if ((dec = hpack_huff_decode(*ptr, n, buf, HPACK_STR_MAX)) < 0) return -1;
+        *str = buf;
+        *len = dec;
+    } else {
+        *str = *ptr;
+        *len = n;
+    }
+    *ptr += n;
+    return 0;
+}
+
+static void hpack_table_free(hpack_table_t *t)
+{
+    free(t->buf);
+    free(t->ents);
+    memset(t, 0, sizeof(*t));
+}
+
+static hpack_entry_t *hpack_table_entry(hpack_table_t *t, uint32_t i)
+{
+    return &t->ents[(t->first + i) % t->ent_cap];
+}
+
+static void hpack_table_evict(hpack_table_t *t, uint32_t max)
+{
+    while (t->count > 0 && t->size > max) {
+        hpack_entry_t *e = hpack_table_entry(t, 0);
+
+        t->size -= e->name_len + e->value_len + HPACK_ENTRY_OVERHEAD;
+        t->first = (t->first + 1) % t->ent_cap;
+        t->count --;
+    }
+    if (t->count == 0) {
+        t->used = 0;
+    }
+}
+
+// Move the live entries to the start of a new ring, and of a new or the same arena
+static int hpack_table_pack(hpack_table_t *t, uint32_t cap)
+{
+    uint32_t ent_cap = cap / HPACK_ENTRY_OVERHEAD, buf_size = cap * 2, used = 0, i;
+    uint8_t *buf = t->buf;
+    hpack_entry_t *ents;
+
+    if (ent_cap > t->ent_cap) {
+        buf = malloc(buf_size);
+        if (buf == NULL) {
+            return -1;
+        }
+    } else {
+        ent_cap = t->ent_cap;
+        buf_size = t->buf_size;
+    }
+    ents = malloc(ent_cap * sizeof(*ents));
+    if (ents == NULL) {
+        if (buf != t->buf) free(buf);
+        return -1;
+    }
+
+    for (i = 0; i < t->count; i ++) {
+        hpack_entry_t e = *hpack_table_entry(t, i);
+        uint32_t len = e.name_len + e.value_len;
+
+        memmove(buf + used, t->buf + e.off, len);
+        e.off = used;
+        ents[i] = e;
+        used += len;
+    }
+
+    if (buf != t->buf) {
+        free(t->buf);
+    }
+    free(t->ents);
+    t->buf = buf;
+    t->ents = ents;
+    t->buf_size = buf_size;
+    t->ent_cap = ent_cap;
+    t->used = used;
+    t->first = 0;
+    return 0;
+}
+
+static int hpack_table_add(hpack_table_t *t, uint8_t *name, uint32_t name_len, uint8_t *value, uint32_t value_len)
+{
+    uint32_t esize = name_len + value_len + HPACK_ENTRY_OVERHEAD;
+    hpack_entry_t *e;
+
+    // The name can be an entry that is about to be evicted or moved
+    if (t->buf != NULL && name >= t->buf && name < t->buf + t->buf_size) {
+        memcpy(t_h2_name, name, name_len);
+        name = t_h2_name;
+    }
+
+    if (esize > t->max_size) {
+        hpack_table_evict(t, 0);
+        return 0;
+    }
+    hpack_table_evict(t, t->max_size - esize);
+
+    if (t->ent_cap < t->max_size / HPACK_ENTRY_OVERHEAD ||
+        t->used + name_len + value_len > t->buf_size) {
+        if (hpack_table_pack(t, t->max_size) < 0) {
+            return -1;
+        }
+    }
+
+    e = hpack_table_entry(t, t->count);
+    e->off = t->used;
+    e->name_len = name_len;
+    e->value_len = value_len;
+    memcpy(t->buf + t->used, name, name_len);
+    memcpy(t->buf + t->used + name_len, value, value_len);
+    t->used += name_len + value_len;
+    t->size += esize;
+    t->count ++;
+    return 0;
+}
+
+static int hpack_table_get(hpack_table_t *t, uint32_t index, uint8_t **name, uint32_t *name_len,
+                           uint8_t **value, uint32_t *value_len)
+{
+    hpack_entry_t *e;
+
+    if (index == 0) {
+        return -1;
+    }
+    if (index <= HPACK_STATIC_ENTRIES) {
+        *name = (uint8_t *)hpack_static[index].name;
+        *name_len = strlen(hpack_static[index].name);
+        *value = (uint8_t *)hpack_static[index].value;
+        *value_len = strlen(hpack_static[index].value);
+        return 0;
+    }
+
+    index -= HPACK_STATIC_ENTRIES + 1;
+    if (index >= t->count) {
+        return -1;
+    }
+    // Newest first
+    e = hpack_table_entry(t, t->count - 1 - index);
+    *name = t->buf + e->off;
+    *name_len = e->name_len;
+    *value = t->buf + e->off + e->name_len;
+    *value_len = e->value_len;
+    return 0;
+}
+
 static bool grpc_find_grpc_content_type(dpi_packet_t *p, uint8_t *ptr, uint32_t hdrstrmlen)
 {
     uint32_t pos = 0;
@@ -101,6 +504,151 @@ static bool grpc_find_grpc_content_type(dpi_packet_t *p, uint8_t *ptr, uint32_t
     return false;
 }
 
+static void grpc_header(dpi_packet_t *p, grpc_data_t *data, uint8_t *name, uint32_t name_len,
+                        uint8_t *value, uint32_t value_len, uint32_t seq)
+{
+    uint32_t left = sizeof(t_h2_hdrs) - t_h2_hdrs_len;
+
+    if (dpi_is_client_pkt(p) && name_len == 5 && memcmp(name, ":path", 5) == 0) {
+        dpi_dlp_area_t *dlparea = &p->dlp_area[DPI_SIG_CONTEXT_TYPE_URI_ORIGIN];
+
+        // A raw path stays in the packet, others are gone with the next field
+        if (value < dpi_pkt_ptr(p) || value >= dpi_pkt_end(p)) {
+            memcpy(t_h2_path, value, value_len);
+            value = t_h2_path;
+        }
+        dlparea->dlp_ptr = value;
+        dlparea->dlp_len = value_len;
+        dlparea->dlp_start = seq;
+        dlparea->dlp_end = seq + value_len;
+        dlparea->dlp_offset = 0;
+        DEBUG_LOG(DBG_PARSER, p, "path=%.*s\n", value_len, value);
+    } else if (dpi_is_client_pkt(p) &&
+               name_len == HTTP2_HDR_CONT_TYPE_LEN && value_len >= HTTP2_HDR_APP_GRPC_LEN &&
+               memcmp(name, HTTP2_HEADER_CONTENT_TYPE, HTTP2_HDR_CONT_TYPE_LEN) == 0 &&
+               strncasecmp((char *)value, HTTP2_HEADER_APP_GRPC, HTTP2_HDR_APP_GRPC_LEN) == 0) {
+        DEBUG_LOG(DBG_PARSER, p, "c2s application/grpc found\n");
+        data->isgrpc = true;
+    }
+
+    // Same layout as http/1 headers for the dlp header context
+    if (name_len + value_len + 4 <= left) {
+        uint8_t *ptr = t_h2_hdrs + t_h2_hdrs_len;
+
+        if (t_h2_hdrs_len == 0) {
+            t_h2_hdrs_seq = seq;
+        }
+        memcpy(ptr, name, name_len);
+        ptr += name_len;
+        *ptr ++ = ':';
+        *ptr ++ = ' ';
+        memcpy(ptr, value, value_len);
+        ptr += value_len;
+        *ptr ++ = '\r';
+        *ptr ++ = '\n';
+        t_h2_hdrs_len = ptr - t_h2_hdrs;
+    }
+}
+
+static int grpc_decode_header_block(dpi_packet_t *p, grpc_data_t *data, grpc_wing_t *w,
+                                    uint8_t *ptr, uint32_t len)
+{
+    hpack_table_t *t = &w->hpack;
+    uint8_t *end = ptr + len, *name, *value;
+    uint32_t index, name_len, value_len;
+
+    while (ptr < end) {
+        uint32_t seq = dpi_ptr_2_seq(p, ptr);
+        uint8_t b = *ptr;
+
+        if (b & 0x80) {
+            // Indexed field
+            if (hpack_int(&ptr, end, 7, &index) < 0 ||
+                hpack_table_get(t, index, &name, &name_len, &value, &value_len) < 0) {
+                return -1;
+            }
+        } else if ((b & 0xe0) == 0x20) {
+            // Dynamic table size update
+            if (hpack_int(&ptr, end, 5, &index) < 0 || index > HPACK_TABLE_MAX) {
+                return -1;
+            }
+            t->max_size = index;
+            hpack_table_evict(t, index);
+            continue;
+        } else {
+            // Literal, with incremental indexing or not
+            bool indexing = (b & 0x40) != 0;
+
+            if (hpack_int(&ptr, end, indexing ? 6 : 4, &index) < 0) {
+                return -1;
+            }
+            if (index == 0) {
+                if (hpack_string(&ptr, end, t_h2_name, &name, &name_len) < 0) return -1;
+            } else if (hpack_table_get(t, index, &name, &name_len, &value, &value_len) < 0) {
+                return -1;
+            }
+            if (hpack_string(&ptr, end, t_h2_value, &value, &value_len) < 0) {
+                return -1;
+            }
+            if (indexing) {
+                grpc_header(p, data, name, name_len, value, value_len, seq);
+                if (hpack_table_add(t, name, name_len, value, value_len) < 0) {
+                    return -1;
+                }
+                continue;
+            }
+        }
+
+        grpc_header(p, data, name, name_len, value, value_len, seq);
+    }
+    return 0;
+}
+
+// Strip padding, priority and the promised stream id from a header frame
+static void grpc_header_frame(dpi_packet_t *p, grpc_data_t *data, grpc_wing_t *w,
+                              uint8_t type, uint8_t flags, uint8_t *ptr, uint32_t len)
+{
+    uint32_t skip = 0, pad = 0;
+
+    if (w->hpack_broken) {
+        return;
+    }
+
+    if (type != HTTP2_CONTINUATION && (flags & HTTP2_FLAGS_PADDED)) {
+        if (len < 1) goto broken;
+        pad = ptr[0];
+        skip = 1;
+    }
+    if (type == HTTP2_HEADERS && (flags & HTTP2_FLAGS_PRIORITY)) {
+        skip += 5;
+    } else if (type == HTTP2_PUSH_PROMISE) {
+        skip += 4;
+    }
+    if (skip + pad > len) goto broken;
+
+    // A block split into continuation frames could cut a field, not followed
+    if (type == HTTP2_CONTINUATION || !(flags & HTTP2_FLAGS_END_HEADERS)) goto broken;
+
+    if (grpc_decode_header_block(p, data, w, ptr + skip, len - skip - pad) < 0) goto broken;
+    return;
+
+broken:
+    DEBUG_LOG(DBG_PARSER, p, "stop hpack decoding, type=%u flags=0x%x\n", type, flags);
+    w->hpack_broken = true;
+}
+
+static void grpc_data_frame(dpi_packet_t *p, uint8_t *ptr, uint32_t len)
+{
+    dpi_dlp_area_t *dlparea = &p->dlp_area[DPI_SIG_CONTEXT_TYPE_BODY];
+    uint32_t seq = dpi_ptr_2_seq(p, ptr);
+
+    // Frames of the packet are one area, the frame headers between them are scanned too
+    if (dlparea->dlp_end == dlparea->dlp_start) {
+        dlparea->dlp_start = seq;
+    }
+    dlparea->dlp_end = seq + len;
+}
+
 static void grpc_parser(dpi_packet_t *p)
 {
     dpi_session_t *s = p->session;
@@ -125,10 +673,12 @@ static void grpc_parser(dpi_packet_t *p)
         data->client.setting_flag = 0;
         data->client.h2_strm_hdr_cnt = 0;
         data->client.pktcnt = 0;
+        data->client.hpack.max_size = HPACK_TABLE_DEFAULT;
         data->server.seq = s->server.init_seq;
         data->server.setting_flag = 0;
         data->server.h2_strm_hdr_cnt = 0;
         data->server.pktcnt = 0;
+        data->server.hpack.max_size = HPACK_TABLE_DEFAULT;
         data->isgrpc = false;
 
         dpi_put_parser_data(p, data);
@@ -140,12 +690,22 @@ static void grpc_parser(dpi_packet_t *p)
         len = dpi_pkt_len(p);
     } else if (dpi_is_seq_in_pkt(p, w->seq)) {
         uint32_t shift = u32_distance(dpi_pkt_seq(p), w->seq);
+
+        if (w->data_skip && shift > 0) {
+            grpc_data_frame(p, dpi_pkt_ptr(p), shift);
+        }
         ptr = dpi_pkt_ptr(p) + shift;
         len = dpi_pkt_len(p) - shift;
+    } else if (w->data_skip && u32_gte(w->seq, dpi_pkt_end_seq(p))) {
+        // Still in the DATA frame
+        grpc_data_frame(p, dpi_pkt_ptr(p), dpi_pkt_len(p));
+        return;
     } else {
         dpi_fire_parser(p);
         return;
     }
+    w->data_skip = false;
+    t_h2_hdrs_len = 0;
 
     /*
      * There is not enough space to hold http2 frame 
@@ -188,13 +748,35 @@ static void grpc_parser(dpi_packet_t *p)
 
         /* tcp segmentation */
         if (h2_hdr_len + h2_strm_len > len) {
+            if (data->isgrpc && h2_strm_type == HTTP2_DATA) {
+                // Don't hold large messages, scan them as they go by
+                grpc_data_frame(p, ptr, len - h2_hdr_len);
+                w->seq = dpi_ptr_2_seq(p, ptr) + h2_strm_len;
+                w->data_skip = true;
+                dpi_set_asm_seq(p, w->seq);
+                break;
+            }
             if (h2_hdr_len + h2_strm_len > HTTP2_LEN_MAX) {
                 /* abnormal http2 length */
                 dpi_fire_parser(p);
                 return;
             }
-            return;
+            break;
         }
+
+        switch (h2_hdr_len > 0 ? h2_strm_type : HTTP2_BLOCKED) {
+        case HTTP2_HEADERS:
+        case HTTP2_PUSH_PROMISE:
+        case HTTP2_CONTINUATION:
+            grpc_header_frame(p, data, w, h2_strm_type, h2_strm_flags, ptr, h2_strm_len);
+            break;
+        case HTTP2_DATA:
+            if (data->isgrpc) {
+                grpc_data_frame(p, ptr, h2_strm_len);
+            }
+            break;
+        }
+
         if (dpi_is_client_pkt(p)){ 
             if (data->client.h2_strm_hdr_cnt == 1) {
                 if (h2_strm_type != HTTP2_SETTINGS) {
@@ -214,10 +796,9 @@ static void grpc_parser(dpi_packet_t *p)
                     DEBUG_LOG(DBG_PARSER, p, "c2s server HTTP2_SETTING_ACKED\n");
                 }
 
-                if (h2_strm_type == HTTP2_HEADERS) {
-                    if (!data->isgrpc) {
-                        data->isgrpc = grpc_find_grpc_content_type(p, ptr, h2_strm_len);
-                    }
+                // Look for the content type in the raw block if it can't be decoded
+                if (h2_strm_type == HTTP2_HEADERS && !data->isgrpc && data->client.hpack_broken) {
+                    data->isgrpc = grpc_find_grpc_content_type(p, ptr, h2_strm_len);
                 }
             }
             data->client.h2_strm_hdr_cnt++;
@@ -248,6 +829,20 @@ static void grpc_parser(dpi_packet_t *p)
         dpi_set_asm_seq(p, w->seq);
     }
 
+    if (t_h2_hdrs_len > 0) {
+        dpi_dlp_area_t *dlparea = &p->dlp_area[DPI_SIG_CONTEXT_TYPE_HEADER];
+
+        dlparea->dlp_ptr = t_h2_hdrs;
+        dlparea->dlp_len = t_h2_hdrs_len;
+        dlparea->dlp_start = t_h2_hdrs_seq;
+        dlparea->dlp_end = t_h2_hdrs_seq + t_h2_hdrs_len;
+        dlparea->dlp_offset = 0;
+    }
+
+    if (dpi_is_parser_final(p)) {
+        return;
+    }
+
     if (dpi_is_client_pkt(p)) {
         data->client.pktcnt++;
         DEBUG_LOG(DBG_PARSER, p, "c2s pktcnt(%u)\n", data->client.pktcnt);
@@ -271,8 +866,8 @@ static void grpc_parser(dpi_packet_t *p)
         (data->server.setting_flag & HTTP2_SETTING_ACKED) && 
         data->isgrpc) {
         DEBUG_LOG(DBG_PARSER, p, "HTTP2 PREFACE ESTABLISHED, GRPC IDENTIFIED\n");
+        // Keep decoding the frames for the dlp url, header and body contexts
         dpi_finalize_parser(p);
-        dpi_ignore_parser(p);
     }
 }
 
@@ -283,9 +878,20 @@ static void grpc_new_session(dpi_packet_t *p)
 
 static void grpc_delete_data(void *data)
 {
+    grpc_data_t *gdata = data;
+
+    hpack_table_free(&gdata->client.hpack);
+    hpack_table_free(&gdata->server.hpack);
     free(data);
 }
 
+static const char *grpc_sig_magic[] = { "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n", NULL, };
+
+static const dpi_parser_sig_t grpc_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_MAGIC,
+    .magic = grpc_sig_magic,
+};
+
 static dpi_parser_t dpi_parser_grpc = {
     .new_session = grpc_new_session,
     .delete_data = grpc_delete_data,
@@ -293,10 +899,12 @@ static dpi_parser_t dpi_parser_grpc = {
     .name = "grpc",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_GRPC,
+    .sig = &grpc_sig,
 };
 
 dpi_parser_t *dpi_grpc_tcp_parser(void)
 {
+    hpack_huff_setup();
     return &dpi_parser_grpc;
 }
 
@@ -5,11 +5,26 @@
 
 #define PCRE2_CODE_UNIT_WIDTH 8
 #include <pcre2.h>
+#include <zlib.h>
 
 #define HTTP_HEADER_COMPLETE_TIMEOUT 3
 #define HTTP_BODY_FIRST_TIMEOUT      30
 #define HTTP_BODY_INTERVAL_TIMEOUT   3
 
+// Gzip and deflate bodies are inflated for DLP as they stream by. The window is fixed at 32KB,
+// a stream takes about 40KB, so the streams open at a time are capped per thread. A body is
+// no longer inflated past its output limit or ratio, on a stream error or a full buffer.
+#define HTTP_INFLATE_MAX_STREAMS 256
+#define HTTP_INFLATE_MAX_BYTES   (1024 * 1024)  // inflated of a body
+#define HTTP_INFLATE_RATIO_FREE  (64 * 1024)    // inflated before the ratio is checked
+#define HTTP_INFLATE_MAX_RATIO   100
+
+typedef struct http_inflate_ {
+    z_stream zs;
+    uint32_t in, out;
+    bool raw;                   // deflate without the zlib header
+} http_inflate_t;
+
 typedef struct http_wing_ {
     uint32_t seq;
     uint32_t content_len;
@@ -18,6 +33,7 @@ typedef struct http_wing_ {
 #define HTTP_FLAGS_CONN_CLOSE   0x04
 #define HTTP_FLAGS_REQUEST      0x08
 #define HTTP_FLAGS_NEGATIVE_LEN 0x10
+#define HTTP_FLAGS_INFLATE_END  0x20    // the body is not inflated anymore
     uint8_t flags;
 #define HTTP_SECTION_NONE       0
 #define HTTP_SECTION_REQ_RESP   1
@@ -40,6 +56,8 @@ typedef struct http_wing_ {
     uint32_t cmd_start;
     uint32_t body_start;
     uint32_t hdr_start;
+    http_inflate_t *inflate;
+    uint32_t inflate_seq;       // of the inflated bytes, over all bodies of the wing
 } http_wing_t;
 
 typedef struct http_data_ {
@@ -57,10 +75,11 @@ typedef struct http_data_ {
 #define HTTP_PROTO_SIP  2
 #define HTTP_PROTO_RTSP 3
              proto :2;
-    uint16_t body_buffer_len; // TODO: temp. way to buffer body in some cases.
+    uint16_t body_buffer_len; // held of a partial match, see buffer_body()
     uint32_t url_start_tick;
     uint32_t last_body_tick;
-    uint8_t *body_buffer; // TODO: temp. way to buffer body in some cases.
+    uint32_t body_scanned;
+    uint8_t *body_buffer;
 } http_data_t;
 
 typedef struct http_ctx_ {
@@ -171,6 +190,19 @@ int dpi_http_tick_timeout(dpi_session_t *s, void *parser_data)
     return DPI_SESS_TICK_CONTINUE;
 }
 
+// Tick at which dpi_http_tick_timeout() can reset the session, 0 if none
+uint32_t dpi_http_tick_deadline(dpi_session_t *s, void *parser_data)
+{
+    http_data_t *data = parser_data;
+
+    if (data->url_start_tick > 0) {
+        return data->url_start_tick + HTTP_HEADER_COMPLETE_TIMEOUT;
+    } else if (data->last_body_tick > 0 && data->client.section == HTTP_SECTION_FIRST_BODY) {
+        return data->last_body_tick + HTTP_BODY_FIRST_TIMEOUT;
+    }
+    return 0;
+}
+
 static inline bool to_detect_slowloris_body_attack(http_data_t *data, http_wing_t *w)
 {
     return data->method != HTTP_METHOD_GET && data->method != HTTP_METHOD_HEAD &&
@@ -293,6 +325,12 @@ static int http_parse_request(http_ctx_t *ctx, uint8_t *ptr, int len)
             if (part[n].start == NULL) {
                 part[n].start = l;
             }
+            if (n == 1) {
+                // Skip to the end of the uri
+                uint8_t *d = consume_until(l, end - l, ' ', '\t', '\n');
+                l = d != NULL ? d : end;
+                continue;
+            }
             if (n == 2 && l - part[n].start > 8) return -1;
             if (n == 0 && l - part[n].start > 16) return -1;
         }
@@ -446,13 +484,13 @@ static int http_header_content_encoding_token(void *param, uint8_t *ptr, int len
     http_wing_t *w = ctx->w;
 
     if (strncmp((char *)ptr, "gzip", 4) == 0 || strncmp((char *)ptr, "x-gzip", 6) == 0) {
-        w->ctype = HTTP_ENCODE_GZIP;
+        w->encode = HTTP_ENCODE_GZIP;
         return CONSUME_TOKEN_SKIP_LINE;
     } else if (strncmp((char *)ptr, "compress", 8) == 0) {
-        w->ctype = HTTP_ENCODE_COMPRESS;
+        w->encode = HTTP_ENCODE_COMPRESS;
         return CONSUME_TOKEN_SKIP_LINE;
     } else if (strncmp((char *)ptr, "deflate", 7) == 0) {
-        w->ctype = HTTP_ENCODE_DEFLATE;
+        w->encode = HTTP_ENCODE_DEFLATE;
         return CONSUME_TOKEN_SKIP_LINE;
     }
 
@@ -534,8 +572,13 @@ static int http_header_xforwarded_port_token(void *param, uint8_t *ptr, int len,
     dpi_packet_t *p = ctx->p;
     dpi_session_t *s = p->session;
     register uint8_t *l = ptr, *end = ptr + len;
+    dpi_session_xff_t *xff = dpi_session_get_xff(s);
     uint16_t xffport = 0;
 
+    if (unlikely(xff == NULL)) {
+        return CONSUME_TOKEN_SKIP_LINE;
+    }
+
     while (l < end) {
         if (likely(isdigit(*l))) {
             xffport = xffport * 10 + ctoi(*l);
@@ -545,9 +588,9 @@ static int http_header_xforwarded_port_token(void *param, uint8_t *ptr, int len,
         l ++;
     }
 
-    s->xff_port = xffport;
+    xff->port = xffport;
 
-    DEBUG_LOG(DBG_PARSER, p, "X-Forwarded-Port: %d\n",s->xff_port);
+    DEBUG_LOG(DBG_PARSER, p, "X-Forwarded-Port: %d\n",xff->port);
 
     return CONSUME_TOKEN_SKIP_LINE;
 }
@@ -563,15 +606,19 @@ static int http_header_xforwarded_proto_token(void *param, uint8_t *ptr, int len
 {
     http_ctx_t *ctx = param;
     dpi_packet_t *p = ctx->p;
-    dpi_session_t *s = p->session;
+    dpi_session_xff_t *xff = dpi_session_get_xff(p->session);
+
+    if (unlikely(xff == NULL)) {
+        return CONSUME_TOKEN_SKIP_LINE;
+    }
 
     if (strncmp((char *)ptr, "https", 5) == 0) {
-        s->xff_app = DPI_APP_SSL;
+        xff->app = DPI_APP_SSL;
     } else if (strncmp((char *)ptr, "http", 4) == 0) {
-        s->xff_app = DPI_APP_HTTP;
+        xff->app = DPI_APP_HTTP;
     }
 
-    DEBUG_LOG(DBG_PARSER, p, "X-Forwarded-Proto: %d\n",s->xff_app);
+    DEBUG_LOG(DBG_PARSER, p, "X-Forwarded-Proto: %d\n",xff->app);
 
     return CONSUME_TOKEN_SKIP_LINE;
 }
@@ -588,10 +635,15 @@ static int http_header_xforwarded_for_token(void *param, uint8_t *ptr, int len,
     http_ctx_t *ctx = param;
     dpi_packet_t *p = ctx->p;
     dpi_session_t *s = p->session;
+    dpi_session_xff_t *xff = dpi_session_get_xff(s);
     char *ip_str;
     int ip_str_len;
     register uint8_t *l = ptr, *end = ptr + len;
 
+    if (unlikely(xff == NULL)) {
+        return CONSUME_TOKEN_SKIP_LINE;
+    }
+
     while (l < end) {
         if (unlikely(*l == ',')) {
             break;
@@ -608,17 +660,17 @@ static int http_header_xforwarded_for_token(void *param, uint8_t *ptr, int len,
     strncpy(ip_str, (char *)ptr, ip_str_len);
     //ip_str is null terminated
     ip_str[ip_str_len] = '\0';
-    s->xff_client_ip = inet_addr(ip_str);
-    if (s->xff_client_ip == (uint32_t)(-1)) {
-        DEBUG_LOG(DBG_PARSER, p, "ipv6 or wrong format ipv4: %s, ip=0x%08x\n",ip_str, s->xff_client_ip);
-        s->xff_client_ip = 0;
+    xff->client_ip = inet_addr(ip_str);
+    if (xff->client_ip == (uint32_t)(-1)) {
+        DEBUG_LOG(DBG_PARSER, p, "ipv6 or wrong format ipv4: %s, ip=0x%08x\n",ip_str, xff->client_ip);
+        xff->client_ip = 0;
         //memory freed
         free(ip_str);
         return CONSUME_TOKEN_SKIP_LINE;
     }
     s->flags |= DPI_SESS_FLAG_XFF;
 
-    DEBUG_LOG(DBG_PARSER, p, "X-Forwarded-For: %s, ip=0x%08x, sess flags=0x%04x\n",ip_str, s->xff_client_ip, s->flags);
+    DEBUG_LOG(DBG_PARSER, p, "X-Forwarded-For: %s, ip=0x%08x, sess flags=0x%04x\n",ip_str, xff->client_ip, s->flags);
 
     //memory freed
     free(ip_str);
@@ -637,7 +689,7 @@ static int http_header_host_token(void *param, uint8_t *ptr, int len, int token_
     http_ctx_t *ctx = param;
     dpi_packet_t *p = ctx->p;
     dpi_session_t *s = p->session;
-    int host_str_len, size;
+    int host_str_len;
     register uint8_t *l = ptr, *end = ptr + len;
 
     while (l < end) {
@@ -647,12 +699,8 @@ static int http_header_host_token(void *param, uint8_t *ptr, int len, int token_
         l ++;
     }
     host_str_len = l-ptr;
-    size = min(host_str_len+1, sizeof(s->vhost));
-    strncpy((char *)s->vhost, (char *)ptr, size-1);
-    //vhost is null terminated
-    s->vhost[size-1] = '\0';
-    s->vhlen = size-1;
-    DEBUG_LOG(DBG_PARSER, p, "vhostname(%s) vhlen(%hu)\n", (char *)s->vhost, s->vhlen);
+    dpi_session_set_vhost(s, ptr, host_str_len);
+    DEBUG_LOG(DBG_PARSER, p, "vhostname(%s) vhlen(%hu)\n", dpi_session_vhost(s), dpi_session_vhlen(s));
 
     return CONSUME_TOKEN_SKIP_LINE;
 }
@@ -695,6 +743,47 @@ static void http_header_server(http_ctx_t *ctx, uint8_t *ptr, int len)
     consume_tokens(ptr, len, http_header_server_token, ctx);
 }
 
+static void http_header_etcd(http_ctx_t *ctx, uint8_t *ptr, int len)
+{
+    dpi_ep_set_app(ctx->p, 0, DPI_APP_ETCD);
+}
+
+typedef void (*http_header_fct)(http_ctx_t *ctx, uint8_t *ptr, int len);
+
+typedef struct http_header_ {
+    const char *name;
+    uint8_t len;
+    bool response;      // only parsed in responses
+    http_header_fct func;
+} http_header_t;
+
+#define HTTP_HEADER(name, resp, func) { name, sizeof(name) - 1, resp, func }
+
+static const http_header_t http_header[] = {
+    HTTP_HEADER("Content-Length", false, http_header_content_length),
+    HTTP_HEADER("Content-Type", false, http_header_content_type),
+    HTTP_HEADER("Content-Encoding", false, http_header_content_encoding),
+    HTTP_HEADER("Connection", false, http_header_connection),
+    HTTP_HEADER("Host", false, http_header_host),
+    HTTP_HEADER("Transfer-Encoding", false, http_header_xfr_encoding),
+    HTTP_HEADER("X-Etcd-Cluster-Id", false, http_header_etcd),
+    HTTP_HEADER("X-Forwarded-Port", false, http_header_xforwarded_port),
+    HTTP_HEADER("X-Forwarded-Proto", false, http_header_xforwarded_proto),
+    HTTP_HEADER("X-Forwarded-For", false, http_header_xforwarded_for),
+    // TODO: move to signature
+    HTTP_HEADER("Server", true, http_header_server),
+};
+
+// Perfect hash of the header names, by name length and last character; the slots are checked
+// to be unique when the parser is set up.
+#define HTTP_HEADER_SLOTS 32
+static const http_header_t *http_header_slot[HTTP_HEADER_SLOTS];
+
+static inline uint32_t http_header_hash(const uint8_t *name, int len)
+{
+    return ((len << 1) + (name[len - 1] | 0x20)) & (HTTP_HEADER_SLOTS - 1);
+}
+
 static int http_parse_header(http_ctx_t *ctx, uint8_t *ptr, int len, bool *done)
 {
     dpi_packet_t *p = ctx->p;
@@ -706,7 +795,7 @@ static int http_parse_header(http_ctx_t *ctx, uint8_t *ptr, int len, bool *done)
     *done = false;
     while (true) {
         int eols, shift;
-        uint8_t *eol = consume_line(ptr, end - ptr, &eols);
+        uint8_t *eol = consume_line(ptr, end - ptr, &eols), *colon;
 
         if (eol == NULL) return consume;
 
@@ -718,40 +807,14 @@ static int http_parse_header(http_ctx_t *ctx, uint8_t *ptr, int len, bool *done)
             return consume + shift;
         }
 
-        // TODO: replace this to keyword parser
-        if (shift > 15 && strncasecmp((char *)ptr, "Content-Length:", 15) == 0) {
-            http_header_content_length(ctx, ptr + 15, shift - eols - 15);
-        } else
-        if (shift > 13 && strncasecmp((char *)ptr, "Content-Type:", 13) == 0) {
-            http_header_content_type(ctx, ptr + 13, shift - eols - 13);
-        } else
-        if (shift > 17 && strncasecmp((char *)ptr, "Content-Encoding:", 17) == 0) {
-            http_header_content_encoding(ctx, ptr + 17, shift - eols - 17);
-        } else
-        if (shift > 11 && strncasecmp((char *)ptr, "Connection:", 11) == 0) {
-            http_header_connection(ctx, ptr + 11, shift - eols - 11);
-        } else
-        if (shift > 5 && strncasecmp((char *)ptr, "Host:", 5) == 0) {
-            http_header_host(ctx, ptr + 5, shift - eols - 5);
-        } else
-        if (shift > 18 && strncasecmp((char *)ptr, "Transfer-Encoding:", 18) == 0) {
-            http_header_xfr_encoding(ctx, ptr + 18, shift - eols - 18);
-        } else
-        if (shift > 18 && strncasecmp((char *)ptr, "X-Etcd-Cluster-Id:", 18) == 0) {
-            dpi_ep_set_app(ctx->p, 0, DPI_APP_ETCD);
-        } else
-        if (shift > 17 && strncasecmp((char *)ptr, "X-Forwarded-Port:", 17) == 0) {
-            http_header_xforwarded_port(ctx, ptr + 17, shift - eols - 17);
-        } else
-        if (shift > 18 && strncasecmp((char *)ptr, "X-Forwarded-Proto:", 18) == 0) {
-            http_header_xforwarded_proto(ctx, ptr + 18, shift - eols - 18);
-        } else
-        if (shift > 16 && strncasecmp((char *)ptr, "X-Forwarded-For:", 16) == 0) {
-            http_header_xforwarded_for(ctx, ptr + 16, shift - eols - 16);
-        } else if (!is_request(ctx->w)) {
-            // TODO: move to signature
-            if (shift > 7 && strncasecmp((char *)ptr, "Server:", 7) == 0) {
-                http_header_server(ctx, ptr + 7, shift - eols - 7);
+        colon = consume_until(ptr, shift - eols, ':', ':', ':');
+        if (colon != NULL && colon > ptr) {
+            int nlen = colon - ptr;
+            const http_header_t *h = http_header_slot[http_header_hash(ptr, nlen)];
+
+            if (h != NULL && h->len == nlen && strncasecmp((char *)ptr, h->name, nlen) == 0 &&
+                (!h->response || !is_request(ctx->w))) {
+                h->func(ctx, colon + 1, shift - eols - nlen - 1);
             }
         }
 
@@ -763,6 +826,8 @@ static int http_parse_header(http_ctx_t *ctx, uint8_t *ptr, int len, bool *done)
     return consume;
 }
 
+static void http_inflate_body(http_ctx_t *ctx, uint8_t *ptr, int len);
+
 static int http_body_chunk(http_ctx_t *ctx, uint8_t *ptr, int len, bool *done)
 {
     dpi_packet_t *p = ctx->p;
@@ -807,10 +872,12 @@ static int http_body_chunk(http_ctx_t *ctx, uint8_t *ptr, int len, bool *done)
             if (w->content_len > 0) {
                 if (len < w->content_len) {
                     DEBUG_LOG(DBG_PARSER, p, "consume=%u\n", len);
+                    http_inflate_body(ctx, ptr, len);
                     w->content_len -= len;
                     return consume + len;
                 } else {
                     DEBUG_LOG(DBG_PARSER, p, "chunk done, consume=%u\n", w->content_len);
+                    http_inflate_body(ctx, ptr, w->content_len);
 
                     ptr += w->content_len;
                     len -= w->content_len;
@@ -851,34 +918,198 @@ static int http_body_chunk(http_ctx_t *ctx, uint8_t *ptr, int len, bool *done)
 #define APACHE_STRUTS_PCRE "class=[\"']java\\.lang\\.ProcessBuilder[\"']>[\\s\\n\\r]*<command>[\\s\\n\\r]*<string>\\/bin\\/sh<\\/string>"
 static pcre2_code *apache_struts_re;
 
-// TODO: temp. way to buffer body in some cases.
+#define HTTP_BODY_HOLD 2048   // of a partial match held over to the next segment
+
+static int http_struts_match(uint8_t *ptr, int len, PCRE2_SIZE *start)
+{
+    int rc = pcre2_match(apache_struts_re, (PCRE2_SPTR)ptr, len, 0, PCRE2_PARTIAL_HARD,
+                         th_apache_struts_re_data, NULL);
+
+    if (rc == PCRE2_ERROR_PARTIAL) {
+        *start = pcre2_get_ovector_pointer(th_apache_struts_re_data)[0];
+    }
+    return rc;
+}
+
+// The first g_http_body_scan bytes of the body are matched in place, segment by segment.
+// Only a segment that ends in a partial match has its bytes from the match start copied, and
+// the next segment is matched after them, so a buffer is allocated, and bytes copied, only for
+// a match that spans segments. The pattern has no lookbehind, the held bytes are enough.
 static void buffer_body(http_ctx_t *ctx, uint8_t *ptr, int len) {
     http_wing_t *w = ctx->w;
+    http_data_t *data = ctx->data;
+    uint32_t limit = g_http_body_scan;
+    PCRE2_SIZE start;
+    int rc;
 
     // This is to specifically detect threats in client-side XML, e.g. CVE-2017-9805
-    if (unlikely(is_request(w) && w->ctype == HTTP_CTYPE_APPLICATION_XML && w->encode == HTTP_ENCODE_NONE)) {
-        http_data_t *data = ctx->data;
-        if (data->body_buffer == NULL) {
-            data->body_buffer = malloc(2048);
+    if (likely(!is_request(w) || w->ctype != HTTP_CTYPE_APPLICATION_XML || w->encode != HTTP_ENCODE_NONE)) {
+        return;
+    }
+    if (len <= 0 || data->body_scanned >= limit) {
+        return;
+    }
+    if (unlikely(th_apache_struts_re_data == NULL)) {
+        th_apache_struts_re_data  = pcre2_match_data_create_from_pattern(apache_struts_re, NULL);
+        if (th_apache_struts_re_data == NULL) return;
+    }
+
+    len = min(len, limit - data->body_scanned);
+    data->body_scanned += len;
+
+    if (data->body_buffer_len > 0) {
+        int copy = min(len, HTTP_BODY_HOLD - data->body_buffer_len);
+        int held = data->body_buffer_len + copy;
+
+        memcpy(&data->body_buffer[data->body_buffer_len], ptr, copy);
+        rc = http_struts_match(data->body_buffer, held, &start);
+        if (rc >= 0) {
+            dpi_threat_trigger(DPI_THRT_APACHE_STRUTS_RCE, ctx->p, NULL);
+            data->body_buffer_len = 0;
+            data->body_scanned = UINT32_MAX;
+            return;
+        } else if (rc == PCRE2_ERROR_PARTIAL && copy == len) {
+            data->body_buffer_len = held - start;
+            memmove(data->body_buffer, &data->body_buffer[start], data->body_buffer_len);
+            return;
         }
-        if (data->body_buffer != NULL && data->body_buffer_len < 2048) {
-            int copy = min(len, 2048 - data->body_buffer_len);
-            memcpy(&data->body_buffer[data->body_buffer_len], ptr, copy);
-            data->body_buffer_len += copy;
+        // A match starting in the segment is looked for in place
+        data->body_buffer_len = 0;
+    }
 
-            if (unlikely(th_apache_struts_re_data == NULL)) {
-                th_apache_struts_re_data  = pcre2_match_data_create_from_pattern(apache_struts_re, NULL);
-            }
+    rc = http_struts_match(ptr, len, &start);
+    if (rc >= 0) {
+        dpi_threat_trigger(DPI_THRT_APACHE_STRUTS_RCE, ctx->p, NULL);
+        data->body_scanned = UINT32_MAX;
+    } else if (rc == PCRE2_ERROR_PARTIAL && len - start <= HTTP_BODY_HOLD) {
+        if (data->body_buffer == NULL && (data->body_buffer = malloc(HTTP_BODY_HOLD)) == NULL) {
+            return;
+        }
+        data->body_buffer_len = len - start;
+        memcpy(data->body_buffer, &ptr[start], data->body_buffer_len);
+    }
+}
 
-            if (likely(th_apache_struts_re_data != NULL)) {
-                int rc = pcre2_match(apache_struts_re,
-                        (PCRE2_SPTR)data->body_buffer, data->body_buffer_len,
-                        0, 0, th_apache_struts_re_data, NULL);
-                if (rc >= 0) {
-                    dpi_threat_trigger(DPI_THRT_APACHE_STRUTS_RCE, ctx->p, NULL);
-                }
-            }
+static voidpf http_zalloc(voidpf opaque, uInt items, uInt size)
+{
+    return mem_calloc(DP_MEM_PARSER, items, size);
+}
+
+static void http_zfree(voidpf opaque, voidpf ptr)
+{
+    mem_free(DP_MEM_PARSER, ptr);
+}
+
+static void http_inflate_end(http_wing_t *w)
+{
+    if (w->inflate != NULL) {
+        inflateEnd(&w->inflate->zs);
+        mem_free(DP_MEM_PARSER, w->inflate);
+        w->inflate = NULL;
+        th_counter.cur_inflates --;
+    }
+}
+
+static http_inflate_t *http_inflate_start(http_wing_t *w)
+{
+    http_inflate_t *inf;
+
+    if (th_counter.cur_inflates >= HTTP_INFLATE_MAX_STREAMS) {
+        th_counter.inflate_limits ++;
+        return NULL;
+    }
+    if ((inf = mem_calloc(DP_MEM_PARSER, 1, sizeof(*inf))) == NULL) {
+        return NULL;
+    }
+    inf->zs.zalloc = http_zalloc;
+    inf->zs.zfree = http_zfree;
+    // zlib or gzip header, whichever it is
+    if (inflateInit2(&inf->zs, 32 + MAX_WBITS) != Z_OK) {
+        mem_free(DP_MEM_PARSER, inf);
+        return NULL;
+    }
+
+    w->inflate = inf;
+    th_counter.cur_inflates ++;
+    return inf;
+}
+
+// Inflate the body bytes into the decoded buffer of the packet, after what earlier bodies of
+// the packet left there. The buffer is in the seq space of the wing's inflated bytes, so DLP
+// scans it in a stream of its own.
+static void http_inflate_body(http_ctx_t *ctx, uint8_t *ptr, int len)
+{
+    dpi_packet_t *p = ctx->p;
+    http_wing_t *w = ctx->w;
+    http_inflate_t *inf = w->inflate;
+    buf_t *out = &p->decoded_pkt;
+    bool limit = false;
+
+    if (len <= 0 || (w->encode != HTTP_ENCODE_GZIP && w->encode != HTTP_ENCODE_DEFLATE) ||
+        (w->flags & HTTP_FLAGS_INFLATE_END) || !FLAGS_TEST(p->flags, DPI_PKT_FLAG_DLP_AREA)) {
+        return;
+    }
+    if (out->len > 0 && !FLAGS_TEST(p->flags, DPI_PKT_FLAG_INFLATED)) {
+        return;
+    }
+    if (inf == NULL && (inf = http_inflate_start(w)) == NULL) {
+        w->flags |= HTTP_FLAGS_INFLATE_END;
+        return;
+    }
+    if (out->len == 0) {
+        out->seq = w->inflate_seq;
+        FLAGS_SET(p->flags, DPI_PKT_FLAG_INFLATED);
+    }
+
+    inf->zs.next_in = ptr;
+    inf->zs.avail_in = len;
+    while (inf->zs.avail_in > 0) {
+        uint32_t room = DPI_MAX_PKT_LEN - out->len, made, in;
+        int ret;
+
+        if (room == 0) {
+            limit = true;
+            break;
+        }
+
+        inf->zs.next_out = out->ptr + out->len;
+        inf->zs.avail_out = room;
+        ret = inflate(&inf->zs, Z_NO_FLUSH);
+        made = room - inf->zs.avail_out;
+        out->len += made;
+        inf->out += made;
+        w->inflate_seq += made;
+        th_counter.inflate_bytes += made;
+
+        // Content-Encoding deflate is often sent raw, without the zlib header
+        if (ret == Z_DATA_ERROR && !inf->raw && inf->in == 0 && inf->out == 0 &&
+            inflateReset2(&inf->zs, -MAX_WBITS) == Z_OK) {
+            inf->raw = true;
+            inf->zs.next_in = ptr;
+            inf->zs.avail_in = len;
+            continue;
         }
+        if (ret != Z_OK) {
+            DEBUG_LOG(DBG_PARSER, p, "inflate end, ret=%d out=%u\n", ret, inf->out);
+            break;
+        }
+
+        in = inf->in + len - inf->zs.avail_in;
+        if (inf->out > HTTP_INFLATE_MAX_BYTES ||
+            (inf->out > HTTP_INFLATE_RATIO_FREE && inf->out / HTTP_INFLATE_MAX_RATIO > in)) {
+            limit = true;
+            break;
+        }
+    }
+    inf->in += len;
+
+    if (limit) {
+        DEBUG_LOG(DBG_PARSER, p, "inflate limit, in=%u out=%u\n", inf->in, inf->out);
+        th_counter.inflate_limits ++;
+    }
+    if (limit || inf->zs.avail_in > 0) {
+        http_inflate_end(w);
+        w->flags |= HTTP_FLAGS_INFLATE_END;
     }
 }
 
@@ -892,6 +1123,7 @@ static int http_parse_body(http_ctx_t *ctx, uint8_t *ptr, int len, bool *done)
     *done = false;
     if (w->flags & HTTP_FLAGS_CONN_CLOSE) {
         DEBUG_LOG(DBG_PARSER, p, "consume all=%u\n", len);
+        http_inflate_body(ctx, ptr, len);
         return len;
     } else if (w->flags & HTTP_FLAGS_CHUNKED) {
         return http_body_chunk(ctx, ptr, len, done);
@@ -899,11 +1131,13 @@ static int http_parse_body(http_ctx_t *ctx, uint8_t *ptr, int len, bool *done)
         if (len < w->content_len) {
             DEBUG_LOG(DBG_PARSER, p, "consume=%u\n", len);
             buffer_body(ctx, ptr, len);
+            http_inflate_body(ctx, ptr, len);
             w->content_len -= len;
             return len;
         } else {
             DEBUG_LOG(DBG_PARSER, p, "body done. consume=%u\n", w->content_len);
             buffer_body(ctx, ptr, w->content_len);
+            http_inflate_body(ctx, ptr, w->content_len);
             *done = true;
             return w->content_len;
         }
@@ -987,6 +1221,8 @@ static void http_parser(dpi_packet_t *p)
             }
             break;
         case HTTP_SECTION_REQ_RESP:
+            w->ctype = HTTP_CTYPE_NONE;
+            w->encode = HTTP_ENCODE_NONE;
             if (dpi_is_client_pkt(p)) {
                 FLAGS_SET(w->flags, HTTP_FLAGS_REQUEST);
                 w->cmd_start = dpi_ptr_2_seq(p, ptr);
@@ -1078,8 +1314,11 @@ static void http_parser(dpi_packet_t *p)
 
             w->body_start = w->seq;
             w->section = HTTP_SECTION_FIRST_BODY;
+            http_inflate_end(w);
+            w->flags &= ~HTTP_FLAGS_INFLATE_END;
 
             data->body_buffer_len = 0;
+            data->body_scanned = 0;
 
             // start slowloris body attack detection
             if (is_slowloris_on_for_wing(s, w)) {
@@ -1091,6 +1330,7 @@ static void http_parser(dpi_packet_t *p)
 
                     // Try to detect HTTP slowloris body attack. Between header and first body, 30s.
                     data->last_body_tick = th_snap.tick;
+                    dpi_session_start_tick_for(s, DPI_SESS_TICK_FLAG_SLOWLORIS, p);
                 } else {
                     DEBUG_LOG(DBG_SESSION | DBG_PARSER, p, "Stop HTTP slowerloris detection\n");
 
@@ -1147,6 +1387,7 @@ static void http_parser(dpi_packet_t *p)
                 }
 
                 set_body_done(w);
+                http_inflate_end(w);
                 w->section = HTTP_SECTION_NONE;
             } else if (unlikely(w->section == HTTP_SECTION_FIRST_BODY)) {
                 w->section = HTTP_SECTION_BODY;
@@ -1164,10 +1405,21 @@ static void http_new_session(dpi_packet_t *p)
 
 static void http_delete_data(void *data)
 {
+    http_inflate_end(&((http_data_t *)data)->client);
+    http_inflate_end(&((http_data_t *)data)->server);
     free(((http_data_t *)data)->body_buffer);
     free(data);
 }
 
+static const char *http_sig_magic[] = {
+    "GET ", "PUT ", "POST ", "DELETE ", "HEAD ", "OPTIONS ", "PATCH ", NULL,
+};
+
+static const dpi_parser_sig_t http_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_FIRST | DPI_PARSER_SIG_ALPHA,
+    .magic = http_sig_magic,
+};
+
 static dpi_parser_t dpi_parser_http = {
     .new_session = http_new_session,
     .delete_data = http_delete_data,
@@ -1175,13 +1427,25 @@ static dpi_parser_t dpi_parser_http = {
     .name = "http",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_HTTP,
+    .sig = &http_sig,
 };
 
 dpi_parser_t *dpi_http_tcp_parser(void)
 {
-    int pcre_errno;
+    int pcre_errno, i;
     PCRE2_SIZE pcre_erroroffset;
 
+    for (i = 0; i < sizeof(http_header) / sizeof(http_header[0]); i ++) {
+        const http_header_t *h = &http_header[i];
+        uint32_t slot = http_header_hash((const uint8_t *)h->name, h->len);
+
+        if (http_header_slot[slot] != NULL && http_header_slot[slot] != h) {
+            DEBUG_ERROR(DBG_PARSER, "ERROR: http header %s and %s hash to the same slot\n",
+                                    h->name, http_header_slot[slot]->name);
+        }
+        http_header_slot[slot] = h;
+    }
+
     if (apache_struts_re == NULL) {
         apache_struts_re = pcre2_compile((PCRE2_SPTR)APACHE_STRUTS_PCRE,
                                          PCRE2_ZERO_TERMINATED,
@@ -725,6 +725,22 @@ static int check_controlled_shutdown_request(dpi_packet_t *p, kafka_data_t * dat
     return 1;
 }
 
+// Request header v1, client_id is a nullable string, -1 for null. Same returns as above.
+static int check_client_id(dpi_packet_t *p, uint8_t *ptr, int left, int size_left)
+{
+    int str_len;
+
+    if (left >= 2 && GET_BIG_INT16(ptr) == 0xffff) {
+        return 2;
+    }
+    str_len = get_short_string_len(ptr, &left);
+    if (str_len > size_left) {
+        DEBUG_LOG(DBG_PARSER, p, "Kafka client id longer than request\n");
+        return -1;
+    }
+    return str_len;
+}
+
 static int check_api_key(dpi_packet_t *p, kafka_data_t * data, uint16_t api_key, uint16_t version_id, uint8_t *ptr, int * pleft, int size_left)
 {
     switch (api_key) {
@@ -902,6 +918,25 @@ static void kafka_parser(dpi_packet_t *p)
         ptr += 2;left -= 2;
         corr_id     = GET_BIG_INT32(ptr);
         ptr += 4;left -= 4;
+
+        // The header is enough to identify the app, walk the request body only for DLP
+        if (p->ep->dlp_detector == NULL) {
+            int res = check_client_id(p, ptr, left, size - 8);
+            if (res < 0) {
+                DEBUG_LOG(DBG_PARSER, p, "Invalid Kafka request header:%d\n",api_key);
+                dpi_fire_parser(p);
+                return;
+            } else if (res == 0) {
+                w->left = 0;
+                return;
+            }
+
+            DEBUG_LOG(DBG_PARSER, p, "Kafka request header: api=%d version=%d\n", api_key, api_version);
+            dpi_finalize_parser(p);
+            dpi_ignore_parser(p);
+            return;
+        }
+
         int res = check_api_key(p, data, api_key, api_version, ptr, &left, size-8);
         int parsed = len - left;
         if (res < 0) {
@@ -1035,6 +1070,10 @@ static void kafka_delete_data(void *data)
     free(data);
 }
 
+static const dpi_parser_sig_t kafka_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_FIRST,
+};
+
 static dpi_parser_t dpi_parser_kafka = {
     .new_session = kafka_new_session,
     .delete_data = kafka_delete_data,
@@ -1044,6 +1083,7 @@ static dpi_parser_t dpi_parser_kafka = {
     .name = "kafka",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_KAFKA,
+    .sig = &kafka_sig,
 };
 
 dpi_parser_t *dpi_kafka_parser(void)
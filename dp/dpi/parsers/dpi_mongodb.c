@@ -143,6 +143,10 @@ static void mongodb_delete_data(void *data)
     free(data);
 }
 
+static const dpi_parser_sig_t mongodb_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_FIRST,
+};
+
 static dpi_parser_t dpi_parser_mongodb = {
     .new_session = mongodb_new_session,
     .delete_data = mongodb_delete_data,
@@ -150,6 +154,7 @@ static dpi_parser_t dpi_parser_mongodb = {
     .name = "mongodb",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_MONGODB,
+    .sig = &mongodb_sig,
 };
 
 dpi_parser_t *dpi_mongodb_parser(void)
@@ -285,8 +285,9 @@ static void mysql_parser(dpi_packet_t *p)
                 return;
             }
             data->state = MYSQL_CLIENT_LOGIN;
-            dpi_finalize_parser(p);
-            //dpi_ignore_parser(p);
+            if (dpi_finalize_inspect_parser(p)) {
+                return;
+            }
 
             ptr += expect;
             len -= expect;
@@ -411,6 +412,10 @@ static void mysql_delete_data(void *data)
     free(data);
 }
 
+static const dpi_parser_sig_t mysql_sig = {
+    .flags = DPI_PARSER_SIG_SERVER_FIRST,
+};
+
 static dpi_parser_t dpi_parser_mysql = {
     .new_session = mysql_new_session,
     .delete_data = mysql_delete_data,
@@ -418,6 +423,7 @@ static dpi_parser_t dpi_parser_mysql = {
     .name = "mysql",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_MYSQL,
+    .sig = &mysql_sig,
 };
 
 dpi_parser_t *dpi_mysql_parser(void)
@@ -215,6 +215,10 @@ static void postgresql_delete_data(void *data)
     free(data);
 }
 
+static const dpi_parser_sig_t postgresql_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_FIRST,
+};
+
 static dpi_parser_t dpi_parser_postgresql = {
     .new_session = postgresql_new_session,
     .delete_data = postgresql_delete_data,
@@ -222,6 +226,7 @@ static dpi_parser_t dpi_parser_postgresql = {
     .name = "postgresql",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_POSTGRESQL,
+    .sig = &postgresql_sig,
 };
 
 dpi_parser_t *dpi_postgresql_parser(void)
@@ -190,6 +190,10 @@ static void redis_delete_data(void *data)
     free(data);
 }
 
+static const dpi_parser_sig_t redis_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_FIRST,
+};
+
 static dpi_parser_t dpi_parser_redis = {
     .new_session = redis_new_session,
     .delete_data = redis_delete_data,
@@ -197,6 +201,7 @@ static dpi_parser_t dpi_parser_redis = {
     .name = "redis",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_REDIS,
+    .sig = &redis_sig,
 };
 
 dpi_parser_t *dpi_redis_parser(void)
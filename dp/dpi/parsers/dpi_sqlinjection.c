@@ -1,5 +1,11 @@
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #include "dpi/dpi_module.h"
 
@@ -9,11 +15,20 @@
 typedef bool (*sql_injection_callback_t)(dpi_packet_t *p, pcre2_code *recompiled, char *signature,
        int  substr_values, uint8_t *query, int len);
 
+// Features a query needs for a signature to match, see sqli_features()
+#define SQLI_F_SELECT   0x01    // starts with SELECT
+#define SQLI_F_QUOTE    0x02
+#define SQLI_F_EQ       0x04
+#define SQLI_F_COMMENT  0x08    // --, # or /*
+#define SQLI_F_SLEEP    0x10    // sleep(
+#define SQLI_F_BENCH    0x20    // benchmark(
+
 typedef struct sql_injection_ {
     sql_injection_callback_t cb;
     pcre2_code *recompiled;
     int  substr_values;
     char * signature; 
+    uint8_t need;
 } sql_injection_t;
 
 static bool injection_0 (dpi_packet_t *p, pcre2_code *recompiled, char *signature,
@@ -68,14 +83,14 @@ static bool injection_0 (dpi_packet_t *p, pcre2_code *recompiled, char *signatur
 }
 
 static sql_injection_t sql_injections[] ={   
-{injection_0, NULL, 0, "(?i)^SELECT.*\'\\s+OR\\s+((?:\'|\")?[0-9a-zA-Z_]+(?:\'|\")?)\\s*=\\s*\\1"},               // SELECT * FROM users WHERE name='adam' or 'x' = 'x'
-{injection_0, NULL, 0, "(?i)\\bSLEEP\\b\\s*\\(\\s*(?:\\d+|__TIME__)\\s*\\)"},                                     // ' or sleep(__TIME__)'
-{injection_0, NULL, 0, "(?i)\\bBENCHMARK\\b\\s*\\(\\s*(?:\\s*[1-9][0-9]{4,}\\s*,)"},                              // benchmark iteration greater than 10000
-{injection_0, NULL, 0, "(?i)\\bBENCHMARK\\b\\s*\\(\\s*(?:\\s*[0-9]{0,4}\\s*,).*(?:--|#|\\/\\*)"},                 // benchmark iteration less than 10000 but with comment symbols at the end
-{injection_0, NULL, 0, "(?i)\\bWAITFOR\\s+DELAY\\b.*(?:--|#|\\/\\*)"},                                            // ;waitfor delay '0:0:__TIME__'--
-{injection_0, NULL, 0, "(?i)(?:1|\"|\'|\\))\\s*\\bUNION\\b.*(?:--|#|\\/\\*)"},                                    // ' union (select @@version) --'
-{injection_0, NULL, 0, "(?i)\\bEXEC\\b\\s+.*(?:--|#|\\/\\*)"},                                                    // exec master..xp_cmdshell <attacker command> --
-{injection_0, NULL, 0, "(?i)\\bOR\\b\\s+(?:1|((?:\'|\")?[0-9a-zA-Z_]+(?:\'|\")?)\\s*=\\s*\\1).*(?:--|#|\\/\\*)"}, // -1" or 1 order by id desc --
+{injection_0, NULL, 0, "(?i)^SELECT.*\'\\s+OR\\s+((?:\'|\")?[0-9a-zA-Z_]+(?:\'|\")?)\\s*=\\s*\\1", SQLI_F_SELECT | SQLI_F_QUOTE | SQLI_F_EQ},               // SELECT * FROM users WHERE name='adam' or 'x' = 'x'
+{injection_0, NULL, 0, "(?i)\\bSLEEP\\b\\s*\\(\\s*(?:\\d+|__TIME__)\\s*\\)", SQLI_F_SLEEP},                                     // ' or sleep(__TIME__)'
+{injection_0, NULL, 0, "(?i)\\bBENCHMARK\\b\\s*\\(\\s*(?:\\s*[1-9][0-9]{4,}\\s*,)", SQLI_F_BENCH},                              // benchmark iteration greater than 10000
+{injection_0, NULL, 0, "(?i)\\bBENCHMARK\\b\\s*\\(\\s*(?:\\s*[0-9]{0,4}\\s*,).*(?:--|#|\\/\\*)", SQLI_F_BENCH | SQLI_F_COMMENT},                 // benchmark iteration less than 10000 but with comment symbols at the end
+{injection_0, NULL, 0, "(?i)\\bWAITFOR\\s+DELAY\\b.*(?:--|#|\\/\\*)", SQLI_F_COMMENT},                                            // ;waitfor delay '0:0:__TIME__'--
+{injection_0, NULL, 0, "(?i)(?:1|\"|\'|\\))\\s*\\bUNION\\b.*(?:--|#|\\/\\*)", SQLI_F_COMMENT},                                    // ' union (select @@version) --'
+{injection_0, NULL, 0, "(?i)\\bEXEC\\b\\s+.*(?:--|#|\\/\\*)", SQLI_F_COMMENT},                                                    // exec master..xp_cmdshell <attacker command> --
+{injection_0, NULL, 0, "(?i)\\bOR\\b\\s+(?:1|((?:\'|\")?[0-9a-zA-Z_]+(?:\'|\")?)\\s*=\\s*\\1).*(?:--|#|\\/\\*)", SQLI_F_COMMENT}, // -1" or 1 order by id desc --
 };
 
 void sql_injection_init()
@@ -101,17 +116,125 @@ void sql_injection_init()
     }
 }
 
-//Embedded sql-injection threat detection based on PCRE pattern matching
-void check_sql_query(dpi_packet_t *p, uint8_t *query, int len, int app)
+static inline bool sqli_word_char(uint8_t c)
 {
-    int i;
+    return isalnum(c) || c == '_';
+}
+
+// The word before the '(' at pos, as \bword\b\s*\( in the signatures
+static uint8_t sqli_call_feature(const uint8_t *query, int pos)
+{
+    int end = pos, start;
+
+    while (end > 0 && isspace(query[end - 1])) {
+        end --;
+    }
+    for (start = end; start > 0 && sqli_word_char(query[start - 1]); start --);
+
+    if (end - start == 5 && strncasecmp((const char *)query + start, "sleep", 5) == 0) {
+        return SQLI_F_SLEEP;
+    } else if (end - start == 9 && strncasecmp((const char *)query + start, "benchmark", 9) == 0) {
+        return SQLI_F_BENCH;
+    }
+    return 0;
+}
+
+static uint8_t sqli_byte_feature(const uint8_t *query, int len, int pos)
+{
+    switch (query[pos]) {
+    case '\'':
+        return SQLI_F_QUOTE;
+    case '=':
+        return SQLI_F_EQ;
+    case '#':
+        return SQLI_F_COMMENT;
+    case '-':
+        return pos + 1 < len && query[pos + 1] == '-' ? SQLI_F_COMMENT : 0;
+    case '/':
+        return pos + 1 < len && query[pos + 1] == '*' ? SQLI_F_COMMENT : 0;
+    case '(':
+        return sqli_call_feature(query, pos);
+    }
+    return 0;
+}
+
+// Features of the query in one pass. Only the bytes a signature needs are looked at, 16 at a
+// time where SSE2 or NEON is there; a query without them is clean without running the
+// signatures.
+static uint8_t sqli_features(const uint8_t *query, int len)
+{
+    uint8_t f = 0;
+    int i = 0, j;
+
+    if (len >= 6 && strncasecmp((const char *)query, "select", 6) == 0) {
+        f |= SQLI_F_SELECT;
+    }
+
+#if defined(__SSE2__)
+    __m128i v1 = _mm_set1_epi8('\''), v2 = _mm_set1_epi8('='), v3 = _mm_set1_epi8('#');
+    __m128i v4 = _mm_set1_epi8('-'), v5 = _mm_set1_epi8('/'), v6 = _mm_set1_epi8('(');
+
+    for (; len - i >= 16; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(query + i));
+        int mask = _mm_movemask_epi8(_mm_or_si128(
+                       _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, v1), _mm_cmpeq_epi8(v, v2)),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, v3), _mm_cmpeq_epi8(v, v4))),
+                       _mm_or_si128(_mm_cmpeq_epi8(v, v5), _mm_cmpeq_epi8(v, v6))));
+        while (mask != 0) {
+            f |= sqli_byte_feature(query, len, i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+#elif defined(__ARM_NEON)
+    uint8x16_t v1 = vdupq_n_u8('\''), v2 = vdupq_n_u8('='), v3 = vdupq_n_u8('#');
+    uint8x16_t v4 = vdupq_n_u8('-'), v5 = vdupq_n_u8('/'), v6 = vdupq_n_u8('(');
+
+    for (; len - i >= 16; i += 16) {
+        uint8x16_t v = vld1q_u8(query + i);
+        uint8x16_t m = vorrq_u8(vorrq_u8(vorrq_u8(vceqq_u8(v, v1), vceqq_u8(v, v2)),
+                                         vorrq_u8(vceqq_u8(v, v3), vceqq_u8(v, v4))),
+                                vorrq_u8(vceqq_u8(v, v5), vceqq_u8(v, v6)));
+        if (vmaxvq_u8(m) != 0) {
+            for (j = i; j < i + 16; j ++) {
+                f |= sqli_byte_feature(query, len, j);
+            }
+        }
+    }
+#endif
+    for (j = i; j < len; j ++) {
+        f |= sqli_byte_feature(query, len, j);
+    }
+
+    return f;
+}
+
+// Number of signatures the query matches. Without prefilter, all signatures are run.
+int sql_injection_match(dpi_packet_t *p, uint8_t *query, int len, bool prefilter)
+{
+    uint8_t f = prefilter ? sqli_features(query, len) : 0xff;
+    int i, cnt = 0;
+
     for (i=0; i<sizeof(sql_injections)/sizeof(sql_injections[0]); i++) {
+        if ((f & sql_injections[i].need) != sql_injections[i].need) {
+            continue;
+        }
         if (sql_injections[i].cb(p, sql_injections[i].recompiled, 
                                  sql_injections[i].signature, 
                                  sql_injections[i].substr_values,
                                  query, len)) {
-            dpi_threat_trigger(DPI_THRT_SQL_INJECTION, p, 
-                    "SQL Injection, application=%d", app);
+            cnt ++;
         }
     }
+    return cnt;
+}
+
+//Embedded sql-injection threat detection based on PCRE pattern matching
+void check_sql_query(dpi_packet_t *p, uint8_t *query, int len, int app)
+{
+    int cnt = sql_injection_match(p, query, len, true);
+
+    while (cnt -- > 0) {
+        dpi_threat_trigger(DPI_THRT_SQL_INJECTION, p, 
+                "SQL Injection, application=%d", app);
+    }
 }
@@ -160,6 +160,14 @@ static void ssh_delete_data(void *data)
     free(data);
 }
 
+static const char *ssh_sig_magic[] = { "SSH-", NULL, };
+
+// The banner is checked on both sides, either can send it first
+static const dpi_parser_sig_t ssh_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_MAGIC | DPI_PARSER_SIG_SERVER_MAGIC,
+    .magic = ssh_sig_magic,
+};
+
 static dpi_parser_t dpi_parser_ssh = {
     .new_session = ssh_new_session,
     .delete_data = ssh_delete_data,
@@ -167,6 +175,7 @@ static dpi_parser_t dpi_parser_ssh = {
     .name = "ssh",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_SSH,
+    .sig = &ssh_sig,
 };
 
 dpi_parser_t *dpi_ssh_parser(void)
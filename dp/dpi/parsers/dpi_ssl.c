@@ -1,6 +1,9 @@
 #include <string.h>
+#include <ctype.h>
+#include <stddef.h>
 
 #include "utils/asn1.h"
+#include "utils/digest.h"
 #include "dpi/dpi_module.h"
 
 #define FORMAT_MATCH  0
@@ -16,6 +19,7 @@
 #define TLS_1_0        0x0301
 #define TLS_1_1        0x0302
 #define TLS_1_2        0x0303
+#define TLS_1_3        0x0304
 
 #define PCT_CLIENT_HELLO           1
 #define PCT_SERVER_HELLO           2
@@ -50,6 +54,13 @@
 #define SSL3_RT_APPLICATION_DATA   23
 #define SSL3_RT_HEARTBEAT          24
 
+#define SSL_EXT_SNI       0
+#define SSL_EXT_GROUPS    10
+#define SSL_EXT_EC_POINT  11
+#define SSL_EXT_SIG_ALGS  13
+#define SSL_EXT_ALPN      16
+#define SSL_EXT_VERSIONS  43
+
 #define SSL3_HBT_REQUEST  1
 #define SSL3_HBT_RESPONSE 2
 
@@ -232,7 +243,7 @@ int ssl_parse_handshake_v3(dpi_packet_t *p, ssl_wing_t *w, uint8_t *ptr, ssl_rec
             return FORMAT_WRONG;
         }
 
-        if (type == SSL3_HS_CERTIFICATE) {
+        if (type == SSL3_HS_CERTIFICATE && g_ssl_cert_inspect) {
             int cert_len = GET_BIG_INT24(ptr + 3);
             int ret = ssl_parse_x509(p, ptr + 6, cert_len);
             if (ret != ASN1_ERR_NONE) {
@@ -254,77 +265,333 @@ static inline int safe_advance(uint8_t **tptr, uint8_t *end, size_t step) {
     return 0;
 }
 
-void ssl_get_sni_v3(dpi_packet_t *p, uint8_t *ptr, ssl_record_t *rec)
+// GREASE values of RFC 8701, 0x0a0a, 0x1a1a, ... 0xfafa, are left out of the fingerprints
+static inline bool ssl_grease(uint16_t v)
+{
+    return (v & 0x0f0f) == 0x0a0a && (v >> 8) == (v & 0xff);
+}
+
+#define SSL_JA4_MAX 128     // ciphers and extensions kept for sorting, the rest is not hashed
+
+typedef struct ssl_hello_ {
+    int cipher_count, ext_count;    // GREASE excluded
+    int ja4_ciphers, ja4_exts;      // entries in the arrays
+    uint16_t version;               // highest of supported_versions
+    bool sni;
+    uint8_t *groups, *points, *sigalgs, *alpn;
+    uint16_t groups_len, points_len, sigalgs_len, alpn_len;
+    // Not cleared
+    uint16_t ciphers[SSL_JA4_MAX];
+    uint16_t exts[SSL_JA4_MAX];     // without SNI and ALPN
+} ssl_hello_t;
+
+static void ja3_add(md5_ctx_t *md5, uint16_t v, bool *first)
 {
-    uint8_t *tptr = ptr;
-    uint8_t *end = tptr + rec->len;
-    dpi_session_t *s = p->session;
-    uint16_t len = 0;
+    char buf[8];
+    int n = snprintf(buf, sizeof(buf), *first ? "%u" : "-%u", v);
 
-    // handshake(1) + length(3) + version(2)
-    if (safe_advance(&tptr, end, 6)) return;
-    // random(32)
-    if (safe_advance(&tptr, end, 32)) return;
+    md5_update(md5, buf, n);
+    *first = false;
+}
 
-    // session id length
-    if (tptr + 1 > end) return;
-    len = (uint16_t)(*(uint8_t *)(tptr));
-    if (safe_advance(&tptr, end, 1)) return;
+static void ja3_add_list16(md5_ctx_t *md5, const uint8_t *ptr, int len)
+{
+    bool first = true;
+    int i;
+
+    for (i = 0; i + 2 <= len; i += 2) {
+        uint16_t v = GET_BIG_INT16(ptr + i);
+        if (!ssl_grease(v)) {
+            ja3_add(md5, v, &first);
+        }
+    }
+}
+
+static void ssl_sort16(uint16_t *v, int n)
+{
+    int i, j;
+
+    for (i = 1; i < n; i ++) {
+        uint16_t x = v[i];
+        for (j = i; j > 0 && v[j - 1] > x; j --) {
+            v[j] = v[j - 1];
+        }
+        v[j] = x;
+    }
+}
+
+// First 12 hex digits of the sha256 of the list, and of the signature algorithms if any
+static void ja4_hash(const uint16_t *list, int count, const uint8_t *sigalgs, int sigalgs_len, char *out)
+{
+    uint8_t digest[SHA256_DIGEST_LEN];
+    sha256_ctx_t sha;
+    char buf[8], hex[SHA256_DIGEST_LEN * 2 + 1];
+    bool first = true;
+    int i, n;
+
+    if (count == 0) {
+        memcpy(out, "000000000000", 12);
+        return;
+    }
+
+    sha256_init(&sha);
+    for (i = 0; i < count; i ++) {
+        n = snprintf(buf, sizeof(buf), i == 0 ? "%04x" : ",%04x", list[i]);
+        sha256_update(&sha, buf, n);
+    }
+    for (i = 0; i + 2 <= sigalgs_len; i += 2) {
+        uint16_t v = GET_BIG_INT16(sigalgs + i);
+        if (!ssl_grease(v)) {
+            n = snprintf(buf, sizeof(buf), first ? "_%04x" : ",%04x", v);
+            sha256_update(&sha, buf, n);
+            first = false;
+        }
+    }
+    sha256_final(&sha, digest);
+    digest_hex(digest, 6, hex);
+    memcpy(out, hex, 12);
+}
+
+static const char *ja4_version(uint16_t ver)
+{
+    switch (ver) {
+    case TLS_1_3: return "13";
+    case TLS_1_2: return "12";
+    case TLS_1_1: return "11";
+    case TLS_1_0: return "10";
+    case SSL_3_0: return "s3";
+    case SSL_2_2BYTE: return "s2";
+    default:      return "00";
+    }
+}
+
+static void ssl_hello_ext(dpi_packet_t *p, ssl_hello_t *h, uint16_t type, uint8_t *data, uint16_t len)
+{
+    uint16_t n, i;
+
+    switch (type) {
+    case SSL_EXT_SNI:
+        // list length(2) + name type(1) + name length(2)
+        h->sni = true;
+        if (len >= 5 && data[2] == 0) {
+            n = GET_BIG_INT16(data + 3);
+            if (n <= len - 5) {
+                dpi_session_set_vhost(p->session, data + 5, n);
+            }
+        }
+        break;
+    case SSL_EXT_GROUPS:
+    case SSL_EXT_SIG_ALGS:
+        if (len >= 2) {
+            n = min(GET_BIG_INT16(data), len - 2);
+            if (type == SSL_EXT_GROUPS) {
+                h->groups = data + 2;
+                h->groups_len = n;
+            } else {
+                h->sigalgs = data + 2;
+                h->sigalgs_len = n;
+            }
+        }
+        break;
+    case SSL_EXT_EC_POINT:
+        if (len >= 1) {
+            h->points = data + 1;
+            h->points_len = min(data[0], len - 1);
+        }
+        break;
+    case SSL_EXT_ALPN:
+        // list length(2) + the first protocol
+        if (len >= 3) {
+            h->alpn = data + 3;
+            h->alpn_len = min(data[2], len - 3);
+        }
+        break;
+    case SSL_EXT_VERSIONS:
+        if (len >= 1) {
+            n = min(data[0], len - 1);
+            for (i = 0; i + 2 <= n; i += 2) {
+                uint16_t v = GET_BIG_INT16(data + 1 + i);
+                if (!ssl_grease(v) && v > h->version) {
+                    h->version = v;
+                }
+            }
+        }
+        break;
+    }
+}
+
+/* RFC 8446
+ * struct {
+ *     ProtocolVersion legacy_version;
+ *     Random random;
+ *     opaque legacy_session_id<0..32>;
+ *     CipherSuite cipher_suites<2..2^16-2>;
+ *     opaque legacy_compression_methods<1..2^8-1>;
+ *     Extension extensions<8..2^16-1>;
+ * } ClientHello;
+ *
+ * SNI, ALPN, the offered version and the JA3 and JA4 fingerprints are taken in one walk.
+ * JA3 is the md5 of "version,ciphers,extensions,groups,point formats" in decimal, the lists
+ * joined by '-'. JA4 is "t<version><d|i><ciphers><extensions><alpn>_<ciphers>_<extensions>",
+ * the lists sorted and hashed with sha256.
+ */
+static void ssl_parse_client_hello(dpi_packet_t *p, uint8_t *ptr, ssl_record_t *rec)
+{
+    uint8_t *tptr, *end = ptr + rec->len, *ext_end;
+    uint8_t digest[MD5_DIGEST_LEN];
+    dpi_session_tls_t *tls;
+    ssl_hello_t h;
+    md5_ctx_t md5;
+    uint16_t legacy, len, i;
+    uint32_t hs_len;
+    bool first;
+    char buf[8], alpn[2];
+
+    // handshake(1) + length(3) + version(2) + random(32) + session id length(1)
+    if (rec->len < 39) return;
+    hs_len = GET_BIG_INT24(ptr + 1);
+    if (hs_len + 4 < rec->len) {
+        end = ptr + 4 + hs_len;
+    }
+    legacy = GET_BIG_INT16(ptr + 4);
+    tptr = ptr + 38;
+
+    len = *tptr ++;
     if (safe_advance(&tptr, end, len)) return;
 
-    // cipher suite length
     if (tptr + 2 > end) return;
     len = GET_BIG_INT16(tptr);
-    if (safe_advance(&tptr, end, 2)) return;
-    if (safe_advance(&tptr, end, len)) return;
+    tptr += 2;
+    if (tptr + len > end) return;
+
+    memset(&h, 0, offsetof(ssl_hello_t, ciphers));
+
+    md5_init(&md5);
+    md5_update(&md5, buf, snprintf(buf, sizeof(buf), "%u,", legacy));
+    first = true;
+    for (i = 0; i + 2 <= len; i += 2) {
+        uint16_t v = GET_BIG_INT16(tptr + i);
+        if (ssl_grease(v)) continue;
+
+        ja3_add(&md5, v, &first);
+        if (h.ja4_ciphers < SSL_JA4_MAX) {
+            h.ciphers[h.ja4_ciphers ++] = v;
+        }
+        h.cipher_count ++;
+    }
+    md5_update(&md5, ",", 1);
+    tptr += len;
 
     // compression methods
     if (tptr + 1 > end) return;
-    len =(uint16_t)(*(uint8_t *)(tptr));
-    if (safe_advance(&tptr, end, 1)) return;
+    len = *tptr ++;
     if (safe_advance(&tptr, end, len)) return;
 
-    // extensions length
-    if (tptr + 2 > end) return;
-    len = GET_BIG_INT16(tptr);
-    if (safe_advance(&tptr, end, 2)) return;
+    // extensions, absent in old hellos
+    ext_end = tptr;
+    if (tptr + 2 <= end) {
+        len = GET_BIG_INT16(tptr);
+        tptr += 2;
+        if (tptr + len > end) {
+            DEBUG_LOG(DBG_PARSER, p, "Mismatch length!\n");
+            return;
+        }
+        ext_end = tptr + len;
+    }
 
-    if ((tptr + len) != end) {
-        DEBUG_LOG(DBG_PARSER, p, "Mismatch length!\n");
-        return;
+    first = true;
+    while (tptr + 4 <= ext_end) {
+        uint16_t type = GET_BIG_INT16(tptr);
+        uint16_t elen = GET_BIG_INT16(tptr + 2);
+        uint8_t *data = tptr + 4;
+
+        if (data + elen > ext_end) break;
+        tptr = data + elen;
+        if (ssl_grease(type)) continue;
+
+        ja3_add(&md5, type, &first);
+        h.ext_count ++;
+        if (type != SSL_EXT_SNI && type != SSL_EXT_ALPN && h.ja4_exts < SSL_JA4_MAX) {
+            h.exts[h.ja4_exts ++] = type;
+        }
+        ssl_hello_ext(p, &h, type, data, elen);
     }
 
-    while (tptr < end) {
-        if (tptr + 4 > end) return;
-        uint16_t ext_type = GET_BIG_INT16(tptr);
-        tptr += 2;
-        uint16_t ext_len = GET_BIG_INT16(tptr);
-        tptr += 2;
+    md5_update(&md5, ",", 1);
+    ja3_add_list16(&md5, h.groups, h.groups_len);
+    md5_update(&md5, ",", 1);
+    first = true;
+    for (i = 0; i < h.points_len; i ++) {
+        ja3_add(&md5, h.points[i], &first);
+    }
+    md5_final(&md5, digest);
+
+    if ((tls = dpi_session_get_tls(p->session)) == NULL) return;
 
-        if (tptr + ext_len > end) return;
+    tls->client_version = h.version != 0 ? h.version : legacy;
+    digest_hex(digest, MD5_DIGEST_LEN, tls->ja3);
 
-        if (ext_type == 0) {
-            // SNI
-            if (ext_len < 5) return; // minimum size check
-            if (tptr + 3 > end) return;
-            tptr += 3;
+    len = min(h.alpn_len, DPI_TLS_ALPN_MAX - 1);
+    memcpy(tls->alpn, h.alpn, len);
+    tls->alpn[len] = '\0';
 
-            if (tptr + 2 > end) return;
-            uint16_t namelen = GET_BIG_INT16(tptr);
-            tptr += 2;
+    // First and last characters of the first ALPN, in hex if not alphanumeric
+    if (h.alpn_len == 0) {
+        alpn[0] = alpn[1] = '0';
+    } else if (isalnum(h.alpn[0]) && isalnum(h.alpn[h.alpn_len - 1])) {
+        alpn[0] = h.alpn[0];
+        alpn[1] = h.alpn[h.alpn_len - 1];
+    } else {
+        alpn[0] = "0123456789abcdef"[h.alpn[0] >> 4];
+        alpn[1] = "0123456789abcdef"[h.alpn[h.alpn_len - 1] & 0xf];
+    }
+
+    ssl_sort16(h.ciphers, h.ja4_ciphers);
+    ssl_sort16(h.exts, h.ja4_exts);
+    snprintf(tls->ja4, sizeof(tls->ja4), "t%s%c%02d%02d%c%c_",
+             ja4_version(tls->client_version), h.sni ? 'd' : 'i',
+             min(h.cipher_count, 99), min(h.ext_count, 99), alpn[0], alpn[1]);
+    ja4_hash(h.ciphers, h.ja4_ciphers, NULL, 0, tls->ja4 + 11);
+    tls->ja4[23] = '_';
+    ja4_hash(h.exts, h.ja4_exts, h.sigalgs, h.sigalgs_len, tls->ja4 + 24);
+    tls->ja4[DPI_TLS_JA4_LEN] = '\0';
+
+    DEBUG_LOG(DBG_PARSER, p, "sniname(%s) alpn(%s) ja3(%s) ja4(%s)\n",
+              dpi_session_vhost(p->session), tls->alpn, tls->ja3, tls->ja4);
+}
 
-            if (tptr + namelen > end) return;
+// The version picked by the server, from supported_versions in TLS 1.3
+static void ssl_parse_server_hello(dpi_packet_t *p, uint8_t *ptr, ssl_record_t *rec)
+{
+    dpi_session_tls_t *tls = p->session->tls;
+    uint8_t *tptr, *end = ptr + rec->len;
+    uint16_t len;
 
-            int size = min(namelen + 1, sizeof(s->vhost));
-            strncpy((char *)s->vhost, (char *)tptr, size - 1);
-            s->vhost[size - 1] = '\0';
-            s->vhlen = size - 1;
+    if (tls == NULL || rec->len < 39) return;
+    tls->version = GET_BIG_INT16(ptr + 4);
+    tptr = ptr + 38;
+
+    // session id, cipher(2), compression(1)
+    len = *tptr ++;
+    if (safe_advance(&tptr, end, len + 3)) return;
+    if (tptr + 2 > end) return;
+    len = GET_BIG_INT16(tptr);
+    tptr += 2;
+    end = min(end, tptr + len);
+
+    while (tptr + 4 <= end) {
+        uint16_t type = GET_BIG_INT16(tptr);
+        uint16_t elen = GET_BIG_INT16(tptr + 2);
+
+        tptr += 4;
+        if (tptr + elen > end) break;
+        if (type == SSL_EXT_VERSIONS && elen == 2) {
+            tls->version = GET_BIG_INT16(tptr);
             break;
-        } else {
-            tptr += ext_len;
         }
+        tptr += elen;
     }
-    DEBUG_LOG(DBG_PARSER, p, "sniname(%s) vhlen(%hu)\n", (char *)s->vhost, s->vhlen);
+    DEBUG_LOG(DBG_PARSER, p, "server version 0x%x\n", tls->version);
 }
 
 int ssl_parse_v3(dpi_packet_t *p, ssl_wing_t *w, uint8_t *ptr, ssl_record_t *rec)
@@ -348,12 +615,13 @@ int ssl_parse_v3(dpi_packet_t *p, ssl_wing_t *w, uint8_t *ptr, ssl_record_t *rec
                 return FORMAT_WRONG;
             }
             rec->ver = GET_BIG_INT16(ptr + 4);
-            ssl_get_sni_v3(p, ptr, rec);
+            ssl_parse_client_hello(p, ptr, rec);
         } else if (handshake_type == SSL3_HS_SERVER_HELLO) {
             if (dpi_is_client_pkt(p)) {
                 return FORMAT_WRONG;
             }
             rec->ver = GET_BIG_INT16(ptr + 4);
+            ssl_parse_server_hello(p, ptr, rec);
         }
 
         if (!w->encrypted) {
@@ -649,8 +917,10 @@ static void ssl_parser(dpi_packet_t *p)
                 DEBUG_LOG(DBG_PARSER, p, "SSL final: ver=0x%x\n", data->version);
                 dpi_finalize_parser(p);
 
-                if (ignore) {
+                // The hellos have all there is to know without the certificates
+                if (ignore || !g_ssl_cert_inspect) {
                     dpi_ignore_parser(p);
+                    return;
                 }
             }
         } else {
@@ -712,6 +982,16 @@ static void ssl_delete_data(void *data)
     free(data);
 }
 
+// TLS 1.0 to 1.2 handshake records, SSLv2 hellos can start with about anything
+static const char *ssl_sig_magic[] = {
+    "\x16\x03\x01", "\x16\x03\x02", "\x16\x03\x03", NULL,
+};
+
+static const dpi_parser_sig_t ssl_sig = {
+    .flags = DPI_PARSER_SIG_CLIENT_FIRST,
+    .magic = ssl_sig_magic,
+};
+
 static dpi_parser_t dpi_parser_ssl = {
     .new_session = ssl_new_session,
     .delete_data = ssl_delete_data,
@@ -719,6 +999,7 @@ static dpi_parser_t dpi_parser_ssl = {
     .name = "ssl",
     .ip_proto = IPPROTO_TCP,
     .type = DPI_PARSER_SSL,
+    .sig = &ssl_sig,
 };
 
 dpi_parser_t *dpi_ssl_parser(void)
@@ -623,8 +623,7 @@ static void tds_parser(dpi_packet_t *p)
     }
 
     if (!dpi_is_parser_final(p) && rc == TDS_PASS) {
-        dpi_finalize_parser(p);
-        //dpi_ignore_parser(p);
+        dpi_finalize_inspect_parser(p);
     }
 }
 
@@ -645,7 +645,7 @@ static void tns_parser(dpi_packet_t *p)
     }
     
     if (!dpi_is_parser_final(p) && rc == TNS_PASS) {
-        dpi_finalize_parser(p);
+        dpi_finalize_inspect_parser(p);
     }
 }
 
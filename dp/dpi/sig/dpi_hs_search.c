@@ -1,3 +1,9 @@
+#include <stdio.h>
+#include <limits.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 #include "dpi/dpi_module.h"
 #include "dpi/sig/dpi_hyperscan_common.h"
 #include "dpi/sig/dpi_search.h"
@@ -8,6 +14,30 @@ extern void dpi_dlp_add_candidate(dpi_packet_t *p, dpi_sig_t *sig, bool nc);
 
 #define DFA_LONGEST_USEFULL_PATTERN 16
 
+// Databases, scratch and streams of hyperscan count as DLP memory
+static void *dpi_hs_alloc(size_t size)
+{
+    return mem_malloc(DP_MEM_DLP, size);
+}
+
+static void dpi_hs_free(void *ptr)
+{
+    mem_free(DP_MEM_DLP, ptr);
+}
+
+void dpi_dlp_hs_setup(void)
+{
+    if (hs_set_allocator(dpi_hs_alloc, dpi_hs_free) != HS_SUCCESS) {
+        DEBUG_ERROR(DBG_INIT, "failed to set hyperscan allocator\n");
+    }
+    // Vectorscan on arm64 keeps the hyperscan API, its build must match the cpu as well
+    if (hs_valid_platform() != HS_SUCCESS) {
+        DEBUG_ERROR(DBG_INIT, "hyperscan %s doesn't support this cpu, DLP patterns won't compile\n", hs_version());
+    } else {
+        DEBUG_INIT("hyperscan %s\n", hs_version());
+    }
+}
+
 static dpi_hyperscan_pm_t *dpi_hs_create()
 {
     dpi_hyperscan_pm_t *pm = (dpi_hyperscan_pm_t *) calloc(1, sizeof(dpi_hyperscan_pm_t));
@@ -58,7 +88,248 @@ dpi_dlp_hs_add_pattern (dpi_hyperscan_pm_t *hspm, uint8_t *pcre_pat, int patlen,
     memcpy(&hp->hs_sa, sa, sizeof(dpi_sig_assoc_t));
 }
 
-int dpi_dlp_hs_compile(dpi_hyperscan_pm_t *hspm, dpi_detector_t *detector) {
+// Compiled databases are kept in files named by a hash of the pattern set, a rebuild with
+// the same patterns or a dp restart loads them instead of compiling
+#define DPI_HS_CACHE_DIR    "/var/lib/dp/hs"
+#define DPI_HS_CACHE_FILES  64
+
+static uint64_t dpi_hs_cache_hash_bytes(uint64_t h, const void *data, size_t len)
+{
+    const uint8_t *ptr = data;
+
+    while (len -- > 0) {
+        h = (h ^ *ptr ++) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static uint64_t dpi_hs_cache_key(char **patterns, uint32_t *flags, uint32_t *ids, uint32_t num_patterns,
+                                 uint32_t mode)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    const char *ver = hs_version();
+    uint32_t i;
+
+    h = dpi_hs_cache_hash_bytes(h, ver, strlen(ver));
+    h = dpi_hs_cache_hash_bytes(h, &mode, sizeof(mode));
+    h = dpi_hs_cache_hash_bytes(h, &num_patterns, sizeof(num_patterns));
+    for (i = 0; i < num_patterns; i++) {
+        h = dpi_hs_cache_hash_bytes(h, patterns[i], strlen(patterns[i]) + 1);
+        h = dpi_hs_cache_hash_bytes(h, &flags[i], sizeof(flags[i]));
+        h = dpi_hs_cache_hash_bytes(h, &ids[i], sizeof(ids[i]));
+    }
+    return h;
+}
+
+static hs_database_t *dpi_hs_cache_load(const char *path)
+{
+    hs_database_t *db = NULL;
+    struct stat st;
+    char *buf;
+    FILE *fp;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fstat(fileno(fp), &st) < 0 || st.st_size <= 0 || (buf = malloc(st.st_size)) == NULL) {
+        fclose(fp);
+        return NULL;
+    }
+    if (fread(buf, 1, st.st_size, fp) != st.st_size ||
+        hs_deserialize_database(buf, st.st_size, &db) != HS_SUCCESS) {
+        DEBUG_ERROR(DBG_DETECT, "Ignore bad hyperscan cache %s\n", path);
+        db = NULL;
+        unlink(path);
+    }
+    free(buf);
+    fclose(fp);
+    return db;
+}
+
+// Keep the newest files
+static void dpi_hs_cache_prune(void)
+{
+    char path[PATH_MAX], oldest[PATH_MAX];
+    time_t oldest_mtime = 0;
+    struct dirent *ent;
+    struct stat st;
+    int files = 0;
+    DIR *dir;
+
+    dir = opendir(DPI_HS_CACHE_DIR);
+    if (dir == NULL) {
+        return;
+    }
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", DPI_HS_CACHE_DIR, ent->d_name);
+        if (stat(path, &st) < 0) {
+            continue;
+        }
+        if (files ++ == 0 || st.st_mtime < oldest_mtime) {
+            oldest_mtime = st.st_mtime;
+            strlcpy(oldest, path, sizeof(oldest));
+        }
+    }
+    closedir(dir);
+
+    if (files > DPI_HS_CACHE_FILES) {
+        unlink(oldest);
+    }
+}
+
+static void dpi_hs_cache_save(const char *path, const hs_database_t *db)
+{
+    char tmp[PATH_MAX + 16], *buf = NULL;
+    size_t len = 0;
+    FILE *fp;
+
+    if (hs_serialize_database(db, &buf, &len) != HS_SUCCESS) {
+        return;
+    }
+
+    mkdir("/var/lib/dp", 0755);
+    mkdir(DPI_HS_CACHE_DIR, 0755);
+
+    // Write and rename, a dp that crashes or a concurrent build never leaves a partial file
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, getpid());
+    fp = fopen(tmp, "wb");
+    if (fp != NULL) {
+        bool ok = fwrite(buf, 1, len, fp) == len;
+
+        if (fclose(fp) == 0 && ok && rename(tmp, path) == 0) {
+            dpi_hs_cache_prune();
+        } else {
+            unlink(tmp);
+        }
+    }
+    free(buf);
+}
+
+// Databases in use are shared by all detectors built from the same pattern set, so a
+// rebuild only compiles the classes whose patterns changed. A database is read-only once
+// compiled, each detector still has its own scratch. Only the dlp thread builds and releases
+// detectors, the list needs no lock.
+typedef struct dpi_hs_fragment_ {
+    struct cds_list_head link;
+    uint64_t key;
+    hs_database_t *db;
+    uint32_t ref;
+} dpi_hs_fragment_t;
+
+static CDS_LIST_HEAD(dpi_hs_fragments);
+
+static hs_database_t *dpi_hs_fragment_get(uint64_t key)
+{
+    dpi_hs_fragment_t *f;
+
+    cds_list_for_each_entry(f, &dpi_hs_fragments, link) {
+        if (f->key == key) {
+            f->ref ++;
+            return f->db;
+        }
+    }
+    return NULL;
+}
+
+static void dpi_hs_fragment_add(uint64_t key, hs_database_t *db)
+{
+    dpi_hs_fragment_t *f = calloc(1, sizeof(*f));
+
+    // Not shared then, dpi_hs_db_release() frees it
+    if (f == NULL) {
+        return;
+    }
+    f->key = key;
+    f->db = db;
+    f->ref = 1;
+    cds_list_add(&f->link, &dpi_hs_fragments);
+}
+
+static void dpi_hs_db_release(hs_database_t *db)
+{
+    dpi_hs_fragment_t *f;
+
+    cds_list_for_each_entry(f, &dpi_hs_fragments, link) {
+        if (f->db == db) {
+            if (-- f->ref == 0) {
+                cds_list_del(&f->link);
+                hs_free_database(db);
+                free(f);
+            }
+            return;
+        }
+    }
+    hs_free_database(db);
+}
+
+static hs_error_t dpi_hs_compile_cached(char **patterns, uint32_t *flags, uint32_t *ids, uint32_t num_patterns,
+                                        uint32_t mode, hs_database_t **db, hs_compile_error_t **compile_error)
+{
+    uint64_t key = dpi_hs_cache_key(patterns, flags, ids, num_patterns, mode);
+    char path[PATH_MAX];
+    hs_error_t error;
+
+    *db = dpi_hs_fragment_get(key);
+    if (*db != NULL) {
+        DEBUG_LOG(DBG_DETECT, NULL, "Shared hyperscan database %016llx, %u patterns\n",
+                  (unsigned long long)key, num_patterns);
+        return HS_SUCCESS;
+    }
+
+    snprintf(path, sizeof(path), "%s/%016llx.db", DPI_HS_CACHE_DIR, (unsigned long long)key);
+
+    *db = dpi_hs_cache_load(path);
+    if (*db != NULL) {
+        DEBUG_LOG(DBG_DETECT, NULL, "Loaded hyperscan database %s, %u patterns\n", path, num_patterns);
+        dpi_hs_fragment_add(key, *db);
+        return HS_SUCCESS;
+    }
+
+    error = hs_compile_multi((const char **)patterns, flags, ids, num_patterns, mode, NULL, db, compile_error);
+    if (error == HS_SUCCESS) {
+        dpi_hs_cache_save(path, *db);
+        dpi_hs_fragment_add(key, *db);
+    }
+    return error;
+}
+
+static uint32_t g_dlp_stream_gen;
+
+// Patterns go on matching across packets, a pattern may match more than once in a stream
+static void dpi_dlp_hs_compile_stream(dpi_hyperscan_pm_t *hspm, char **patterns, uint32_t *flags,
+                                      uint32_t *ids, uint32_t num_patterns)
+{
+    hs_compile_error_t *compile_error = NULL;
+    hs_error_t error;
+    uint32_t i;
+
+    for (i = 0; i < num_patterns; i++) {
+        flags[i] &= ~HS_FLAG_SINGLEMATCH;
+    }
+
+    error = dpi_hs_compile_cached(patterns, flags, ids, num_patterns, HS_MODE_STREAM,
+                                  &hspm->stream_db, &compile_error);
+    if (compile_error != NULL) {
+        DEBUG_ERROR(DBG_DETECT, "hs_compile_multi() stream mode failed: %s (expression: %d), scan by packet\n",
+                   compile_error->message, compile_error->expression);
+        hs_free_compile_error(compile_error);
+        hspm->stream_db = NULL;
+        return;
+    }
+    if (error != HS_SUCCESS) {
+        DEBUG_ERROR(DBG_DETECT, "hs_compile_multi() stream mode failed: error %d, scan by packet\n", error);
+        hspm->stream_db = NULL;
+        return;
+    }
+
+    hspm->stream_gen = ++ g_dlp_stream_gen;
+}
+
+int dpi_dlp_hs_compile(dpi_hyperscan_pm_t *hspm, dpi_detector_t *detector, bool stream) {
 
     if (!hspm || hspm->hs_patterns_num == 0) {
         return -1;
@@ -102,7 +373,11 @@ int dpi_dlp_hs_compile(dpi_hyperscan_pm_t *hspm, dpi_detector_t *detector) {
     }
 
     hs_compile_error_t *compile_error = NULL;
-    hs_error_t error = hs_compile_multi((const char **)patterns, flags, ids, num_patterns, HS_MODE_BLOCK, NULL, &(hspm->db), &compile_error);
+    hs_error_t error = dpi_hs_compile_cached(patterns, flags, ids, num_patterns, HS_MODE_BLOCK, &(hspm->db), &compile_error);
+
+    if (stream && compile_error == NULL && error == HS_SUCCESS) {
+        dpi_dlp_hs_compile_stream(hspm, patterns, flags, ids, num_patterns);
+    }
 
     free(patterns);
     free(flags);
@@ -127,6 +402,12 @@ int dpi_dlp_hs_compile(dpi_hyperscan_pm_t *hspm, dpi_detector_t *detector) {
         DEBUG_ERROR(DBG_DETECT,"hs_alloc_scratch() failed: error %d\n", error);
         return -1;
     }
+    if (hspm->stream_db != NULL &&
+        hs_alloc_scratch(hspm->stream_db, &detector->dlp_hs_mpse_build_scratch) != HS_SUCCESS) {
+        DEBUG_ERROR(DBG_DETECT,"hs_alloc_scratch() failed for the stream database\n");
+        dpi_hs_db_release(hspm->stream_db);
+        hspm->stream_db = NULL;
+    }
 
     uint32_t scratch_size = 0;
     error = hs_scratch_size(detector->dlp_hs_mpse_build_scratch, (size_t *)&scratch_size);
@@ -245,6 +526,68 @@ static void dpi_dlp_hs_search_add_dlprule (void *context, dpi_sig_t *sig)
 }
 
 
+// The uri, header and body classes in one vectored database, the pattern id carries the class.
+// Matches are reported with their start so that one that spans two areas can be told apart.
+#define DPI_HS_VECTOR_CLASS_SHIFT 24
+static const dpi_sig_context_class_t dpi_hs_vector_class[] = {
+    DPI_SIG_CONTEXT_CLASS_URI, DPI_SIG_CONTEXT_CLASS_HEADER, DPI_SIG_CONTEXT_CLASS_BODY,
+};
+
+static void dpi_dlp_hs_compile_vector(dpi_hs_search_t *hs_search)
+{
+    hs_compile_error_t *compile_error = NULL;
+    uint32_t num_patterns = 0, n = 0, i, k;
+    char **patterns;
+    uint32_t *flags, *ids;
+    hs_error_t error;
+
+    for (k = 0; k < ARRAY_ENTRIES(dpi_hs_vector_class); k ++) {
+        dpi_hyperscan_pm_t *pm = hs_search->data[dpi_hs_vector_class[k]].hs_pm;
+
+        if (pm == NULL || pm->db == NULL) {
+            return;
+        }
+        num_patterns += pm->hs_patterns_num;
+    }
+
+    patterns = calloc(num_patterns, sizeof(char *));
+    flags = calloc(num_patterns, sizeof(uint32_t));
+    ids = calloc(num_patterns, sizeof(uint32_t));
+    if (patterns == NULL || flags == NULL || ids == NULL) {
+        goto exit;
+    }
+
+    for (k = 0; k < ARRAY_ENTRIES(dpi_hs_vector_class); k ++) {
+        dpi_hyperscan_pm_t *pm = hs_search->data[dpi_hs_vector_class[k]].hs_pm;
+
+        for (i = 0; i < pm->hs_patterns_num; i ++, n ++) {
+            patterns[n] = pm->hs_patterns[i].pattern;
+            // Single match can't be combined with the start of match
+            flags[n] = (pm->hs_patterns[i].hs_flags & ~HS_FLAG_SINGLEMATCH) | HS_FLAG_SOM_LEFTMOST;
+            ids[n] = (dpi_hs_vector_class[k] << DPI_HS_VECTOR_CLASS_SHIFT) | i;
+        }
+    }
+
+    error = dpi_hs_compile_cached(patterns, flags, ids, num_patterns, HS_MODE_VECTORED,
+                                  &hs_search->vector_db, &compile_error);
+    if (compile_error != NULL) {
+        DEBUG_LOG(DBG_DETECT, NULL, "No vectored database: %s (expression: %d)\n",
+                  compile_error->message, compile_error->expression);
+        hs_free_compile_error(compile_error);
+        hs_search->vector_db = NULL;
+    } else if (error != HS_SUCCESS) {
+        hs_search->vector_db = NULL;
+    } else if (hs_alloc_scratch(hs_search->vector_db, &hs_search->detector->dlp_hs_mpse_build_scratch) != HS_SUCCESS) {
+        dpi_hs_db_release(hs_search->vector_db);
+        hs_search->vector_db = NULL;
+    }
+
+exit:
+    free(patterns);
+    free(flags);
+    free(ids);
+}
+
 static void dpi_dlp_hs_search_compile (void *context)
 {
     dpi_hs_search_t *hs_search = context;
@@ -267,8 +610,9 @@ static void dpi_dlp_hs_search_compile (void *context)
     }    
 
     for (c = 0; c < DPI_SIG_CONTEXT_CLASS_MAX; c ++) {
-        dpi_dlp_hs_compile(hs_search->data[c].hs_pm, hs_search->detector);
+        dpi_dlp_hs_compile(hs_search->data[c].hs_pm, hs_search->detector, c == DPI_SIG_CONTEXT_CLASS_PACKET);
     }
+    dpi_dlp_hs_compile_vector(hs_search);
 }
 
 int dpi_dlp_hs_proc_sa (dpi_hs_search_t *hs_search, dpi_sig_assoc_t *sa, dpi_packet_t *p)
@@ -326,6 +670,74 @@ int dpi_dlp_hs_onmatch(unsigned int id, unsigned long long from, unsigned long l
     return 0; // Continue matching.
 }
 
+static void dpi_dlp_close_hs_stream(dpi_dlp_stream_t *st)
+{
+    if (st->hs != NULL) {
+        hs_close_stream(st->hs, NULL, NULL, NULL);
+        st->hs = NULL;
+    }
+}
+
+void dpi_dlp_close_stream(dpi_wing_t *w)
+{
+    dpi_dlp_close_hs_stream(&w->dlp_stream);
+    dpi_dlp_close_hs_stream(&w->dlp_inflate);
+}
+
+// Scan the packet area in the stream of its wing, only the bytes the stream hasn't seen yet. The
+// assembled, decoded and raw buffers of a packet are detected in turn, the raw bytes are usually
+// seen already. Bodies inflated by a parser go on in a stream of their own, in the seq space of
+// the inflated bytes. Return false if the area can't be streamed and is scanned as a block.
+static bool dpi_dlp_hsdb_stream (dpi_packet_t *p, dpi_dlp_area_t *area, hs_scratch_t *scratch,
+                                 dpi_hs_callback_context_t *ctx)
+{
+    dpi_hyperscan_pm_t *pm = ctx->pm;
+    dpi_wing_t *w = p->this_wing;
+    dpi_dlp_stream_t *st;
+    uint32_t skip;
+    hs_error_t error;
+
+    if (pm->stream_db == NULL || p->session == NULL || p->ip_proto != IPPROTO_TCP) {
+        return false;
+    }
+    if (p->pkt_buffer == &p->raw || p->pkt_buffer == &p->asm_pkt) {
+        st = &w->dlp_stream;
+    } else if (p->pkt_buffer == &p->decoded_pkt && FLAGS_TEST(p->flags, DPI_PKT_FLAG_INFLATED)) {
+        st = &w->dlp_inflate;
+    } else {
+        return false;
+    }
+
+    // A match can't span a database change or bytes the stream missed
+    if (st->hs != NULL && (st->gen != pm->stream_gen || u32_gt(area->dlp_start, st->seq))) {
+        dpi_dlp_close_hs_stream(st);
+    }
+    if (st->hs == NULL) {
+        if (hs_open_stream(pm->stream_db, 0, (hs_stream_t **)&st->hs) != HS_SUCCESS) {
+            st->hs = NULL;
+            return false;
+        }
+        st->gen = pm->stream_gen;
+        st->seq = area->dlp_start;
+    }
+
+    skip = st->seq - area->dlp_start;
+    if (skip >= area->dlp_len) {
+        return true;
+    }
+
+    th_counter.dlp_scan_bytes += area->dlp_len - skip;
+    error = hs_scan_stream(st->hs, (const char *)area->dlp_ptr + skip, area->dlp_len - skip, 0,
+                           scratch, dpi_dlp_hs_onmatch, ctx);
+    st->seq = area->dlp_start + area->dlp_len;
+
+    if (error != HS_SUCCESS && error != HS_SCAN_TERMINATED) {
+        DEBUG_LOG(DBG_DETECT,NULL, "hs_scan_stream() failed: error %d\n", error);
+        dpi_dlp_close_hs_stream(st);
+    }
+    return true;
+}
+
 static void
 dpi_dlp_hsdb_detect (dpi_hs_search_t *hs_search, dpi_packet_t *p, dpi_sig_context_type_t t)
 {
@@ -360,6 +772,12 @@ dpi_dlp_hsdb_detect (dpi_hs_search_t *hs_search, dpi_packet_t *p, dpi_sig_contex
         }
     }
 
+    if (t == DPI_SIG_CONTEXT_TYPE_PACKET_ORIGIN &&
+        dpi_dlp_hsdb_stream(p, &p->dlp_area[t], detector->dlp_hs_mpse_scan_scratch, &ctx)) {
+        return;
+    }
+
+    th_counter.dlp_scan_bytes += len;
     error = hs_scan(hs_search->data[c].hs_pm->db, (const char *)buf, len, 0,
                                detector->dlp_hs_mpse_scan_scratch, dpi_dlp_hs_onmatch, &ctx);
 
@@ -368,6 +786,82 @@ dpi_dlp_hsdb_detect (dpi_hs_search_t *hs_search, dpi_packet_t *p, dpi_sig_contex
     }
 }
 
+typedef struct dpi_hs_vector_context_ {
+    dpi_hs_search_t *hs_search;
+    dpi_packet_t *pkt;
+    int count;
+    dpi_sig_context_class_t cls[ARRAY_ENTRIES(dpi_hs_vector_class)];
+    unsigned long long start[ARRAY_ENTRIES(dpi_hs_vector_class)];
+    unsigned long long end[ARRAY_ENTRIES(dpi_hs_vector_class)];
+} dpi_hs_vector_context_t;
+
+// Only take a match that is within an area of the pattern's class
+static int dpi_dlp_hs_vector_onmatch(unsigned int id, unsigned long long from, unsigned long long to,
+                                     unsigned int flags, void *hs_ctx)
+{
+    dpi_hs_vector_context_t *ctx = hs_ctx;
+    dpi_sig_context_class_t c = id >> DPI_HS_VECTOR_CLASS_SHIFT;
+    int k;
+
+    for (k = 0; k < ctx->count; k ++) {
+        if (from >= ctx->start[k] && from < ctx->end[k]) {
+            if (to <= ctx->end[k] && ctx->cls[k] == c) {
+                dpi_hyperscan_pm_t *pm = ctx->hs_search->data[c].hs_pm;
+                dpi_hyperscan_pattern_t *hp = &pm->hs_patterns[id & ((1 << DPI_HS_VECTOR_CLASS_SHIFT) - 1)];
+
+                dpi_dlp_hs_proc_sa(ctx->hs_search, &hp->hs_sa, ctx->pkt);
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+// Scan the uri, header and body areas of the packet in one call
+static void dpi_dlp_hsdb_detect_vector (dpi_hs_search_t *hs_search, dpi_packet_t *p,
+                                        const dpi_sig_context_type_t *types, int count)
+{
+    dpi_detector_t *detector = hs_search->detector;
+    const char *bufs[ARRAY_ENTRIES(dpi_hs_vector_class)];
+    unsigned int lens[ARRAY_ENTRIES(dpi_hs_vector_class)];
+    dpi_sig_node_t *sig_node_itr, *sig_node_next;
+    dpi_hs_vector_context_t ctx;
+    unsigned long long offset = 0;
+    hs_error_t error;
+    int k;
+
+    ctx.hs_search = hs_search;
+    ctx.pkt = p;
+    ctx.count = count;
+    for (k = 0; k < count; k ++) {
+        dpi_dlp_area_t *area = &p->dlp_area[types[k]];
+
+        ctx.cls[k] = dpi_dlp_ctxt_type_2_cat(types[k]);
+        cds_list_for_each_entry_safe(sig_node_itr, sig_node_next, &hs_search->data[ctx.cls[k]].nc_sigs, node) {
+            dpi_dlp_add_candidate(p, sig_node_itr->sig, true);
+        }
+
+        bufs[k] = (const char *)area->dlp_ptr;
+        lens[k] = area->dlp_len;
+        ctx.start[k] = offset;
+        ctx.end[k] = offset += area->dlp_len;
+    }
+
+    if (detector->dlp_hs_mpse_scan_scratch == NULL) {
+        HyperscanActivateMpse((void *)detector);
+        if (detector->dlp_hs_mpse_scan_scratch == NULL) {
+            return;
+        }
+    }
+
+    th_counter.dlp_scan_bytes += offset;
+    error = hs_scan_vector(hs_search->vector_db, bufs, lens, count, 0,
+                           detector->dlp_hs_mpse_scan_scratch, dpi_dlp_hs_vector_onmatch, &ctx);
+    if (error != HS_SUCCESS && error != HS_SCAN_TERMINATED) {
+        DEBUG_LOG(DBG_DETECT,NULL, "hs_scan_vector() failed: error %d\n", error);
+    }
+}
+
 static void dpi_dlp_hs_search_detect (void *context, void *packet)
 {
     dpi_hs_search_t *hs_search = context;
@@ -377,6 +871,11 @@ static void dpi_dlp_hs_search_detect (void *context, void *packet)
     uint32_t proc_id = THREAD_ID;
     dlptbl_node_t *dlptbl = hs_search->dlptbls[proc_id].tbl;
     dpi_sig_node_t *sig_node_itr, *sig_node_next;
+    static const dpi_sig_context_type_t area_types[] = {
+        DPI_SIG_CONTEXT_TYPE_URI_ORIGIN, DPI_SIG_CONTEXT_TYPE_HEADER, DPI_SIG_CONTEXT_TYPE_BODY,
+    };
+    dpi_sig_context_type_t types[ARRAY_ENTRIES(area_types)];
+    int k, count = 0;
 
     if (dlptbl == NULL) {
         return;
@@ -388,20 +887,20 @@ static void dpi_dlp_hs_search_detect (void *context, void *packet)
         th_hs_detect_id = 1;
     }
 
-    if (p->dlp_area[DPI_SIG_CONTEXT_TYPE_URI_ORIGIN].dlp_len > 0) {
-        dpi_dlp_hsdb_detect(hs_search, p, DPI_SIG_CONTEXT_TYPE_URI_ORIGIN);
-        skip_packet = true;
-    }
-
-    if (p->dlp_area[DPI_SIG_CONTEXT_TYPE_HEADER].dlp_len > 0) {
-        dpi_dlp_hsdb_detect(hs_search, p, DPI_SIG_CONTEXT_TYPE_HEADER);
-        skip_packet = true;
+    for (k = 0; k < ARRAY_ENTRIES(area_types); k ++) {
+        if (p->dlp_area[area_types[k]].dlp_len > 0) {
+            types[count ++] = area_types[k];
+        }
     }
 
-    if (p->dlp_area[DPI_SIG_CONTEXT_TYPE_BODY].dlp_len > 0) {
-        dpi_dlp_hsdb_detect(hs_search, p, DPI_SIG_CONTEXT_TYPE_BODY);
-        skip_packet = true;
+    if (count > 1 && hs_search->vector_db != NULL) {
+        dpi_dlp_hsdb_detect_vector(hs_search, p, types, count);
+    } else {
+        for (k = 0; k < count; k ++) {
+            dpi_dlp_hsdb_detect(hs_search, p, types[k]);
+        }
     }
+    skip_packet = count > 0;
     
     if (!skip_packet && p->dlp_area[DPI_SIG_CONTEXT_TYPE_PACKET_ORIGIN].dlp_len > 0) {
         dpi_dlp_hsdb_detect(hs_search, p, DPI_SIG_CONTEXT_TYPE_PACKET_ORIGIN);
@@ -432,7 +931,9 @@ static void release_hs_pm (dpi_hyperscan_pm_t *hs_pm)
     }
     
     if (hs_pm->db)
-        hs_free_database(hs_pm->db);
+        dpi_hs_db_release(hs_pm->db);
+    if (hs_pm->stream_db)
+        dpi_hs_db_release(hs_pm->stream_db);
     free(hs_pm);
 }
 
@@ -455,6 +956,9 @@ static void dpi_dlp_hs_search_release (void *context)
         return;
     }
 
+    if (hs_search->vector_db) {
+        dpi_hs_db_release(hs_search->vector_db);
+    }
     for (c = 0; c < DPI_SIG_CONTEXT_CLASS_MAX; c ++) {
         release_hs_pm(hs_search->data[c].hs_pm);
         release_nc_dlprules(&hs_search->data[c].nc_sigs);
@@ -20,6 +20,8 @@ typedef struct dpi_hyperscan_pattern_ {
 
 typedef struct dpi_hyperscan_pm_ {
     hs_database_t *db;
+    hs_database_t *stream_db;   // packet class only, scanned in order per session wing
+    uint32_t stream_gen;        // streams opened on an older database are reopened
     dpi_hyperscan_pattern_t *hs_patterns;
     uint32_t hs_patterns_num; // number of elements
     uint32_t hs_patterns_cap; // allocated capacity
@@ -353,82 +353,30 @@ static void dpi_sig_match_sigs (dpi_packet_t *p)
     }
 }
 
-dpi_sig_user_t* dpi_find_sig_user(struct cds_list_head *sig_user_list, dpi_sig_t *sig, io_dlp_cfg_t *dlp_cfg)
-{
-    dpi_sig_user_link_t *sig_user_itr, *sig_user_next;
-
-    cds_list_for_each_entry_safe(sig_user_itr, sig_user_next, sig_user_list, node) {
-        if (sig_user_itr->sig_user) {
-            dpi_sig_t *tsig = sig_user_itr->sig_user->sig;
-            if (tsig && tsig==sig) {
-                sig_user_itr->sig_user->sig = sig;
-                sig_user_itr->sig_user->action = dlp_cfg->action;
-                return sig_user_itr->sig_user;
-            }
-        }
-    }
-
-    dpi_sig_user_t *new_user = (dpi_sig_user_t *)calloc(1, sizeof(dpi_sig_user_t));
-    if (!new_user) {
-        DEBUG_DLP("OOM while creating new sig user\n");
-        return NULL;
-    }
-    new_user->sig = sig;
-    new_user->flags = sig->conf->flags;
-    new_user->action = dlp_cfg->action;
-    new_user->severity = sig->conf->severity;
-
-    dpi_sig_user_link_t *new_sig_user_link = (dpi_sig_user_link_t *)calloc(1, sizeof(dpi_sig_user_link_t));
-    if (!new_sig_user_link) {
-        DEBUG_DLP("OOM while creating new sig user link\n");
-        free(new_user);
-        return NULL;
-    }
-    new_sig_user_link->sig_user = new_user;
-
-    if (sig_user_list->prev == NULL || sig_user_list->next == NULL) {
-        CDS_INIT_LIST_HEAD(sig_user_list);
-    }
-    cds_list_add_tail((struct cds_list_head *)new_sig_user_link, sig_user_list);
-
-    return new_user;
-}
-
+// The user of a signature for the endpoint, by the action the endpoint gives its rule
 dpi_sig_user_t *dpi_dlp_ep_match (dpi_packet_t *p, dpi_sig_t *sig){
-    dpi_sig_user_t *user = NULL;
-    if (!p || !sig) return user;
+    if (!p || !sig) return NULL;
 
     io_ep_t *ep = p->ep;
-    io_dlp_cfg_t key;
+    io_dlp_cfg_t key, *cfg;
 
     key.sigid = sig->conf->id;
     key.action = sig->conf->action;
     if (key.sigid >= DPI_SIG_MIN_WAF_SIG_ID) {
         if (!FLAGS_TEST(p->flags, DPI_PKT_FLAG_DETECT_WAF)) {
-            return user;
+            return NULL;
         }
-        //DEBUG_DLP("match waf rid:(%d)!\n", key.sigid);
-        io_dlp_cfg_t *waf_cfg = rcu_map_lookup(&ep->waf_cfg_map, &key);
-        if (waf_cfg != NULL) {
-            if (waf_cfg->sig_user_list.prev == NULL && waf_cfg->sig_user_list.next == NULL) {
-                CDS_INIT_LIST_HEAD(&waf_cfg->sig_user_list);
-            }
-            user = dpi_find_sig_user(&waf_cfg->sig_user_list, sig, waf_cfg);
-        } 
+        cfg = rcu_map_lookup(&ep->waf_cfg_map, &key);
     } else {
         if (!FLAGS_TEST(p->flags, DPI_PKT_FLAG_DETECT_DLP)) {
-            return user;
+            return NULL;
         }
-        //DEBUG_DLP("match dlp rid:(%d)!\n", key.sigid);
-        io_dlp_cfg_t *dlp_cfg = rcu_map_lookup(&ep->dlp_cfg_map, &key);
-        if (dlp_cfg != NULL) {
-            if (dlp_cfg->sig_user_list.prev == NULL && dlp_cfg->sig_user_list.next == NULL) {
-                CDS_INIT_LIST_HEAD(&dlp_cfg->sig_user_list);
-            }
-            user = dpi_find_sig_user(&dlp_cfg->sig_user_list, sig, dlp_cfg);
-        } 
+        cfg = rcu_map_lookup(&ep->dlp_cfg_map, &key);
+    }
+    if (cfg == NULL || cfg->action >= DPI_ACTION_MAX) {
+        return NULL;
     }
-    return user;
+    return &sig->users[cfg->action];
 }
 
 void dpi_dlp_add_candidate (dpi_packet_t *p, dpi_sig_t *sig, bool nc)
@@ -506,7 +454,7 @@ static dpi_dlp_context_status_t app_dlp_context_status[] = {
 [DPI_APP_ERLANG_EPMD - DPI_APP_PROTO_MARK] = {0, 0, 0,},
 [DPI_APP_TNS - DPI_APP_PROTO_MARK] = {0, 0, 0,},
 [DPI_APP_TDS - DPI_APP_PROTO_MARK] = {0, 0, 0,},
-[DPI_APP_GRPC - DPI_APP_PROTO_MARK] = {0, 0, 0,},
+[DPI_APP_GRPC - DPI_APP_PROTO_MARK] = {1, 1, 1,},
 };
 
 static bool dpi_support_dlp_context (dpi_packet_t *p, dpi_sig_context_class_t c)
@@ -704,7 +652,7 @@ static void dpi_sift_matchs (dpi_packet_t *p)
 {
     //DEBUG_LOG_FUNC_ENTRY(DBG_DETECT,NULL);
 
-    bool isproxymesh = cmp_mac_prefix(p->ep_mac, PROXYMESH_MAC_PREFIX);
+    bool isproxymesh = FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) ? true : false;
 
     int i;
     dpi_sig_user_t *best_user;
@@ -716,12 +664,6 @@ static void dpi_sift_matchs (dpi_packet_t *p)
     for (i = 0; i < p->dlp_results; i ++) {
         m = &p->dlp_match_results[i];
         best_user = p->dlp_match_results[i].user;
-        if (best_user->action == DPI_ACTION_ALLOW) {
-            best_user->severity = THRT_SEVERITY_MEDIUM;
-        } else if (best_user->action == DPI_ACTION_DROP) {
-            best_user->severity = THRT_SEVERITY_CRITICAL;
-        }
-
         best_sig = best_user->sig;
         if (best_user->action > action) {
             action = best_user->action;
@@ -757,7 +699,7 @@ bool dpi_waf_ep_policy_check (dpi_packet_t *p) {
     io_ep_t *ep = p->ep;
     dpi_detector_t *dlp_detector = (dpi_detector_t *)ep->dlp_detector;
     dpi_policy_hdl_t *hdl = (dpi_policy_hdl_t *)ep->policy_hdl;
-    bool isproxymesh = cmp_mac_prefix(p->ep_mac, PROXYMESH_MAC_PREFIX);
+    bool isproxymesh = FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) ? true : false;
     io_dlp_ruleid_t key;
     dpi_session_t *sess = p->session;
     key.rid = sess->policy_desc.id;
@@ -824,7 +766,7 @@ bool dpi_dlp_ep_policy_check (dpi_packet_t *p) {
     io_ep_t *ep = p->ep;
     dpi_detector_t *dlp_detector = (dpi_detector_t *)ep->dlp_detector;
     dpi_policy_hdl_t *hdl = (dpi_policy_hdl_t *)ep->policy_hdl;
-    bool isproxymesh = cmp_mac_prefix(p->ep_mac, PROXYMESH_MAC_PREFIX);
+    bool isproxymesh = FLAGS_TEST(p->flags, DPI_PKT_FLAG_PROXYMESH) ? true : false;
     io_dlp_ruleid_t key;
     dpi_session_t *sess = p->session;
     key.rid = sess->policy_desc.id;
@@ -40,6 +40,8 @@ typedef struct dpi_detector_ {
     dpi_hs_summary_t dlp_hs_summary;
     uint16_t dlp_ref_cnt;
     uint16_t dlp_ver;
+    struct cds_list_head dlp_req_link;  // queued for the dlp thread
+    uint8_t dlp_req;                    // 1 << CTRL_DLP_REQ_xxx
     //int def_action;
     int dlp_apply_dir;
 } dpi_detector_t;
@@ -67,6 +69,7 @@ typedef struct dlptbl_ {
 typedef struct dpi_hs_search_ {
     uint32_t count;
     struct dpi_hs_class_ data[DPI_SIG_CONTEXT_CLASS_MAX];
+    hs_database_t *vector_db;   // uri, header and body classes, scanned in one call
 
     dlptbl_t *dlptbls;
     dpi_detector_t *detector;
@@ -78,13 +81,13 @@ bool dpi_waf_ep_policy_check(dpi_packet_t *p);
 bool dpi_process_detector(dpi_packet_t *p);
 void dpi_set_pkt_decision(dpi_packet_t *p, int action);
 void dpi_dlp_init_hs_search (void *detector);
+void dpi_dlp_hs_setup(void);
 void dpi_dlp_release_detector (dpi_detector_t *detector);
 void dpi_dlp_detector_destroy(dpi_detector_t *detector);
 void dpi_dlp_release_dlprulelist (dpi_detector_t *detector);
 void dpi_print_siglist(dpi_detector_t *detector);
 void dpi_print_siglist_fp(dpi_detector_t *detector, FILE *logfp);
 void dpi_hs_free_global_context(dpi_detector_t *detector);
-extern dpi_detector_t *g_release_detector;
-extern dpi_detector_t *g_build_detector;
+dpi_detector_t *dpi_dlp_next_req(uint8_t *req);
 
 #endif
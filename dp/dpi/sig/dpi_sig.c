@@ -377,6 +377,7 @@ void dpi_dlp_init(void)
 {
     DEBUG_LOG_FUNC_ENTRY(DBG_INIT|DBG_DETECT,NULL);
     dpi_dlp_register_options(&DlpRuleParser);
+    dpi_dlp_hs_setup();
 }
 
 void dpi_dlp_proc(char *dlp_sig_opts, void *detector)
@@ -417,6 +418,7 @@ static dpi_detector_t *dpi_dlp_detector_init(int apply_dir)
     detector->dlp_apply_dir = apply_dir;
     //per detector dlpSigList
     CDS_INIT_LIST_HEAD(&detector->dlpSigList);
+    CDS_INIT_LIST_HEAD(&detector->dlp_req_link);
 
     //per detector mpse/pcre build and scan scratch space
     detector->dlp_hs_mpse_build_scratch = NULL;
@@ -429,27 +431,50 @@ static dpi_detector_t *dpi_dlp_detector_init(int apply_dir)
     return detector;
 }
 
-dpi_detector_t *g_release_detector = NULL;
-static int dp_dlp_free_detector(dpi_detector_t *detector)
+// Detectors with pending build or release requests, in the order they were posted. The ctrl
+// thread doesn't wait, the dlp thread builds and frees them after it has returned. A detector
+// is queued once; one released before its turn is never built.
+static CDS_LIST_HEAD(dlp_req_list);
+
+static void dp_dlp_post_req(dpi_detector_t *detector, int req)
 {
-    g_release_detector = detector;
-    DEBUG_DLP("g_release_detector(%p) dlp_ref_cnt(%d)\n", g_release_detector, g_release_detector->dlp_ref_cnt);
+    pthread_mutex_lock(&g_dlp_ctrl_req_lock);
+    if (cds_list_empty(&detector->dlp_req_link)) {
+        cds_list_add_tail(&detector->dlp_req_link, &dlp_req_list);
+    }
+    detector->dlp_req |= 1 << req;
+    pthread_mutex_unlock(&g_dlp_ctrl_req_lock);
 
-    dp_dlp_wait_ctrl_req_thr(CTRL_DLP_REQ_DEL);
+    dp_dlp_kick_ctrl_req();
+}
+
+// Called by the dlp thread, return the next detector and its requests
+dpi_detector_t *dpi_dlp_next_req(uint8_t *req)
+{
+    dpi_detector_t *detector = NULL;
 
-    g_release_detector = NULL;
+    pthread_mutex_lock(&g_dlp_ctrl_req_lock);
+    if (!cds_list_empty(&dlp_req_list)) {
+        detector = cds_list_first_entry(&dlp_req_list, dpi_detector_t, dlp_req_link);
+        cds_list_del_init(&detector->dlp_req_link);
+        *req = detector->dlp_req;
+        detector->dlp_req = 0;
+    }
+    pthread_mutex_unlock(&g_dlp_ctrl_req_lock);
+    return detector;
+}
+
+static int dp_dlp_free_detector(dpi_detector_t *detector)
+{
+    DEBUG_DLP("release detector(%p) dlp_ref_cnt(%d)\n", detector, detector->dlp_ref_cnt);
+    dp_dlp_post_req(detector, CTRL_DLP_REQ_DEL);
     return 0;
 }
 
-dpi_detector_t *g_build_detector = NULL;
 static int dp_dlp_build_detector(dpi_detector_t *detector)
 {
-    g_build_detector = detector;
-    DEBUG_DLP("g_build_detector(%p) dlp_ref_cnt(%d)\n", g_build_detector, g_build_detector->dlp_ref_cnt);
-
-    dp_dlp_wait_ctrl_req_thr(CTRL_DLP_REQ_BLD);
-
-    g_build_detector = NULL;
+    DEBUG_DLP("build detector(%p) dlp_ref_cnt(%d)\n", detector, detector->dlp_ref_cnt);
+    dp_dlp_post_req(detector, CTRL_DLP_REQ_BLD);
     return 0;
 }
 
@@ -500,6 +525,7 @@ static int dpi_dlp_detect_update(struct ether_addr *mac_addr, dpi_detector_t *ne
         new_dlp_detector->dlp_ref_cnt++;
     }
     ep->dlp_detect_ver = new_dlp_detector ? new_dlp_detector->dlp_ver : 0;
+    ep->inspect_ver ++;
     rcu_read_unlock();
 
     if (old_dlp_detector) {
@@ -539,6 +565,7 @@ static int dpi_dlp_detect_add_mac(struct ether_addr *add_mac_addr, dpi_detector_
     }
     ep->dlp_detector = (void *)exist_dlp_detector;
     ep->dlp_detect_ver = exist_dlp_detector ? exist_dlp_detector->dlp_ver : 0;
+    ep->inspect_ver ++;
     rcu_read_unlock();
 
     if (old_dlp_detector) {
@@ -602,6 +629,7 @@ static int dpi_dlp_detect_release(struct ether_addr *del_mac_addr)
     old_dlp_detector = (dpi_detector_t *)ep->dlp_detector;
     ep->dlp_detector = NULL;
     ep->dlp_detect_ver = 0;
+    ep->inspect_ver ++;
     rcu_read_unlock();
 
     if (old_dlp_detector) {
@@ -615,6 +643,34 @@ static int dpi_dlp_detect_release(struct ether_addr *del_mac_addr)
     return 0;
 }
 
+// The users of each signature, one per action an endpoint can give its rule. The severity of
+// a match follows the action.
+static void dpi_dlp_build_sig_users(dpi_detector_t *detector)
+{
+    dpi_sig_macro_sig_t *macro;
+    dpi_sig_t *sig;
+    int a;
+
+    cds_list_for_each_entry(macro, &detector->dlpSigList, node) {
+        cds_list_for_each_entry(sig, &macro->sigs, node) {
+            for (a = 0; a < DPI_ACTION_MAX; a ++) {
+                dpi_sig_user_t *user = &sig->users[a];
+
+                user->sig = sig;
+                user->flags = sig->conf->flags;
+                user->action = a;
+                if (a == DPI_ACTION_ALLOW) {
+                    user->severity = THRT_SEVERITY_MEDIUM;
+                } else if (a == DPI_ACTION_DROP) {
+                    user->severity = THRT_SEVERITY_CRITICAL;
+                } else {
+                    user->severity = sig->conf->severity;
+                }
+            }
+        }
+    }
+}
+
 int dpi_sig_bld(dpi_dlpbld_t *dlpsig, int flag)
 {
     int i,j,k;
@@ -666,6 +722,7 @@ int dpi_sig_bld(dpi_dlpbld_t *dlpsig, int flag)
     
     if (flag & MSG_END) {
         DEBUG_DLP("PARSE DLP RULE DONE!\n");
+        dpi_dlp_build_sig_users(dlpDetector);
         DEBUG_DLP("Single pattern subtotal: hyperscan db_count(%u) allocated, db_bytes(%u), scratch_size(%u)!\n",
             dlpDetector->dlp_pcre_hs_summary.db_count, dlpDetector->dlp_pcre_hs_summary.db_bytes, dlpDetector->dlp_pcre_hs_summary.scratch_size);
         //dpi_print_siglist(dlpDetector);
@@ -43,6 +43,9 @@ typedef enum dpi_sig_context_type_ {
 } dpi_sig_context_type_t;
 
 #define DPI_MAX_PCRE_PATTERNS 16
+#define DPI_PCRE_LITERALS     4   // required literals kept per pcre
+#define DPI_PCRE_LITERAL_MAX  32
+#define DPI_PCRE_LITERAL_MIN  3
 
 typedef enum dpi_action_cate_ {
     DPI_CAT_NONE = 0,
@@ -68,7 +71,16 @@ typedef struct dpi_sig_macro_sig_ {
 
 // forward declaration
 struct dpi_sigopt_node_;
-struct dpi_sig_user_;
+struct dpi_sig_;
+
+// A signature as used by the endpoints giving its rule the action
+typedef struct dpi_sig_user_ {
+    uint16_t flags;
+    uint8_t action;
+    uint8_t severity;
+
+    struct dpi_sig_ *sig;
+} dpi_sig_user_t;
 
 typedef struct dpi_sig_ {
     struct cds_list_head node;
@@ -91,20 +103,10 @@ typedef struct dpi_sig_ {
 
     uint8_t pcre_count;
     void *last_pattern;
-} dpi_sig_t;
 
-typedef struct dpi_sig_user_ {
-    uint16_t flags;
-    uint8_t action;
-    uint8_t severity;
-
-    dpi_sig_t *sig;
-} dpi_sig_user_t;
-
-typedef struct dpi_sig_user_link_ {
-    struct cds_list_head node;
-    dpi_sig_user_t *sig_user;
-} dpi_sig_user_link_t;
+    // By DPI_ACTION_xxx, filled when the detector is built, see dpi_dlp_build_sig_users()
+    dpi_sig_user_t users[DPI_ACTION_MAX];
+} dpi_sig_t;
 
 // forward declaration
 struct dpi_packet_;
@@ -157,6 +159,10 @@ typedef struct dpi_sigopt_pcre_pattern_ {
         struct hs_database *hs_db; /* hyperscan database */
         int hs_flags;              /* hyperscan flags used for compile */
         int hs_noconfirm;          /* hyperscan matches don't need confirm */
+        uint8_t literal_count;     /* literals any match must contain */
+        uint8_t literal_caseless;
+        uint8_t literal_len[DPI_PCRE_LITERALS];
+        uint8_t literal[DPI_PCRE_LITERALS][DPI_PCRE_LITERAL_MAX];
     } pcre;
 } dpi_sigopt_pcre_pattern_t;
 
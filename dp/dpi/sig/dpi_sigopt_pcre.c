@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include "dpi/sig/dpi_sig.h"
 #include "dpi/dpi_module.h"
 #include "dpi/sig/dpi_search.h"
@@ -137,6 +138,77 @@ static int dpi_sigopt_hs_search(dpi_sigopt_pcre_pattern_t *data, const char *buf
 }
 
 
+#define DPI_PCRE_JIT_STACK_MIN  (32 * 1024)
+#define DPI_PCRE_JIT_STACK_MAX  (512 * 1024)
+
+// Match data and jit stack of the thread, the confirm only reads the first ovector pair.
+static pcre2_match_data *dpi_sigopt_pcre_thread_data(void)
+{
+    if (unlikely(th_pcre_match_data == NULL)) {
+        pcre2_jit_stack *stack;
+        pcre2_match_context *ctx;
+
+        th_pcre_match_data = pcre2_match_data_create(1, NULL);
+        if (th_pcre_match_data == NULL) {
+            return NULL;
+        }
+
+        stack = pcre2_jit_stack_create(DPI_PCRE_JIT_STACK_MIN, DPI_PCRE_JIT_STACK_MAX, NULL);
+        ctx = pcre2_match_context_create(NULL);
+        if (stack != NULL && ctx != NULL) {
+            pcre2_jit_stack_assign(ctx, NULL, stack);
+            th_pcre_match_ctx = ctx;
+        } else {
+            // pcre2 falls back to a small stack on the machine stack
+            if (stack != NULL) pcre2_jit_stack_free(stack);
+            if (ctx != NULL) pcre2_match_context_free(ctx);
+        }
+    }
+    return th_pcre_match_data;
+}
+
+static bool dpi_sigopt_pcre_find(const uint8_t *ptr, uint32_t len, const uint8_t *lit, uint32_t lit_len,
+                                 bool caseless)
+{
+    const uint8_t *end = ptr + len - lit_len + 1, *s;
+    uint8_t lo, up;
+
+    if (len < lit_len) {
+        return false;
+    }
+    if (!caseless) {
+        for (s = ptr; (s = memchr(s, lit[0], end - s)) != NULL; s ++) {
+            if (memcmp(s + 1, lit + 1, lit_len - 1) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    lo = tolower(lit[0]);
+    up = toupper(lit[0]);
+    for (s = ptr; s < end; s ++) {
+        if ((*s == lo || *s == up) && strncasecmp((const char *)s + 1, (const char *)lit + 1, lit_len - 1) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Return false if a literal that every match contains is not in the buffer
+static bool dpi_sigopt_pcre_literals_present(dpi_sigopt_pcre_pattern_t *data, const uint8_t *ptr, uint32_t len)
+{
+    int i;
+
+    for (i = 0; i < data->pcre.literal_count; i ++) {
+        if (!dpi_sigopt_pcre_find(ptr, len, data->pcre.literal[i], data->pcre.literal_len[i],
+                                  data->pcre.literal_caseless)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 static int
 dpi_sigopt_pcre_search (dpi_sigopt_pcre_pattern_t *data, dpi_packet_t *p,
                     dpi_sig_context_type_t t, dpi_sig_t *sig)
@@ -154,6 +226,11 @@ dpi_sigopt_pcre_search (dpi_sigopt_pcre_pattern_t *data, dpi_packet_t *p,
     ptr = dlparea->dlp_ptr;
     len = dlparea->dlp_len;
     offset = dlparea->dlp_offset;
+
+    // Cheapest check first, a match starts at the offset and contains all the literals
+    if (offset > len || !dpi_sigopt_pcre_literals_present(data, ptr + offset, len - offset)) {
+        goto exit;
+    }
     
     // Prefilter with Hyperscan if available; if Hyperscan says the buffer
     // cannot match this PCRE, we can fall out here.
@@ -200,13 +277,15 @@ pcre_confirm:
         DEBUG_LOG(DBG_DETECT, p, "ERROR: PCRE2 signature is not compiled '%s'\n", data->pcre.string);
         return ret;
     } 
-    match_data = pcre2_match_data_create_from_pattern(data->pcre.recompiled, NULL);
+    match_data = dpi_sigopt_pcre_thread_data();
     
     if (match_data == NULL) {
         DEBUG_LOG(DBG_DETECT, p, "ERROR: PCRE2 match data block cannot be allocated\n");
         return ret;
     }
-    rc = pcre2_match(data->pcre.recompiled, (PCRE2_SPTR)ptr, len, offset, 0, match_data, NULL);
+    // A match with more groups than the ovector has returns 0, the first pair is still set
+    rc = pcre2_match(data->pcre.recompiled, (PCRE2_SPTR)ptr, len, offset, 0, match_data,
+                     th_pcre_match_ctx);
     
     /* Matching failed: handle error cases */
     if (rc < 0) { 
@@ -229,8 +308,8 @@ pcre_confirm:
         p->dlp_match_type = t;
         ret = 1;
     }
-    pcre2_match_data_free(match_data);
 
+exit:
     if (!FLAGS_TEST(data->flags, DPI_SIGOPT_PAT_FLAG_NEGATIVE)) {
         return ret;
     } else {
@@ -408,6 +487,187 @@ static dpi_sigopt_status_t dpi_sigopt_hsbuild(dpi_sigopt_pcre_pattern_t *data, c
     return DPI_SIGOPT_OK;
 }
 
+static void dpi_sigopt_pcre_keep_literal(dpi_sigopt_pcre_pattern_t *data, const uint8_t *run, int len)
+{
+    int i, shortest = 0;
+
+    if (len < DPI_PCRE_LITERAL_MIN) {
+        return;
+    }
+    len = min(len, DPI_PCRE_LITERAL_MAX);
+
+    if (data->pcre.literal_count < DPI_PCRE_LITERALS) {
+        i = data->pcre.literal_count ++;
+    } else {
+        for (i = 1; i < DPI_PCRE_LITERALS; i ++) {
+            if (data->pcre.literal_len[i] < data->pcre.literal_len[shortest]) {
+                shortest = i;
+            }
+        }
+        if (data->pcre.literal_len[shortest] >= len) {
+            return;
+        }
+        i = shortest;
+    }
+    memcpy(data->pcre.literal[i], run, len);
+    data->pcre.literal_len[i] = len;
+}
+
+static const char *dpi_sigopt_pcre_skip_class(const char *c)
+{
+    // c is after '[', a ']' right after '[' or '[^' is a member
+    if (*c == '^') c ++;
+    if (*c == ']') c ++;
+    for (; *c != '\0' && *c != ']'; c ++) {
+        if (*c == '\\' && c[1] != '\0') {
+            c ++;
+        } else if (*c == '[' && c[1] == ':') {
+            // [:alpha:]
+            if ((c = strstr(c + 2, ":]")) == NULL) {
+                return NULL;
+            }
+            c ++;
+        }
+    }
+    return *c == ']' ? c + 1 : NULL;
+}
+
+// Length of a {n}, {n,} or {n,m} quantifier at c, 0 if '{' is a literal
+static int dpi_sigopt_pcre_quantifier(const char *c)
+{
+    const char *s = c + 1;
+
+    if (!isdigit((uint8_t)*s)) return 0;
+    while (isdigit((uint8_t)*s)) s ++;
+    if (*s == ',') {
+        s ++;
+        while (isdigit((uint8_t)*s)) s ++;
+    }
+    return *s == '}' ? s - c + 1 : 0;
+}
+
+// Collect literal runs from the top level of the pattern, every match contains each of them.
+// Anything that is not plainly a literal ends the run, and a top level alternation gives none.
+static void dpi_sigopt_pcre_literals(dpi_sigopt_pcre_pattern_t *data, const char *re, uint32_t pcre_flags)
+{
+    uint8_t run[DPI_PCRE_LITERAL_MAX];
+    const char *c;
+    int len = 0, depth = 0, q;
+
+    data->pcre.literal_count = 0;
+    if (pcre_flags & PCRE2_EXTENDED) {
+        return;
+    }
+    // Inline options can turn on caseless, taking all literals caseless is always safe
+    data->pcre.literal_caseless = (pcre_flags & PCRE2_CASELESS) || strstr(re, "(?") != NULL;
+
+#define END_RUN() do { dpi_sigopt_pcre_keep_literal(data, run, len); len = 0; } while (0)
+#define ADD_RUN(ch) do { \
+        if (len == DPI_PCRE_LITERAL_MAX) END_RUN(); \
+        run[len ++] = (ch); \
+    } while (0)
+
+    for (c = re; *c != '\0'; c ++) {
+        if (depth > 0) {
+            if (*c == '\\') {
+                if (*++ c == '\0') break;
+            } else if (*c == '[') {
+                if ((c = dpi_sigopt_pcre_skip_class(c + 1)) == NULL) break;
+                c --;
+            } else if (*c == '(') {
+                depth ++;
+            } else if (*c == ')') {
+                depth --;
+            }
+            continue;
+        }
+
+        switch (*c) {
+        case '|':
+            data->pcre.literal_count = 0;
+            return;
+        case '(':
+            END_RUN();
+            depth ++;
+            break;
+        case '[':
+            END_RUN();
+            if ((c = dpi_sigopt_pcre_skip_class(c + 1)) == NULL) {
+                return;
+            }
+            c --;
+            break;
+        case '?':
+        case '*':
+            // The char before is optional
+            if (len > 0) len --;
+            END_RUN();
+            break;
+        case '+':
+            // The char before repeats, the run can't go on after it
+            END_RUN();
+            break;
+        case '{':
+            if ((q = dpi_sigopt_pcre_quantifier(c)) == 0) {
+                ADD_RUN('{');
+                break;
+            }
+            if (len > 0) len --;
+            END_RUN();
+            c += q - 1;
+            break;
+        case '.':
+        case '^':
+        case '$':
+        case ')':
+            END_RUN();
+            break;
+        case '\\':
+            c ++;
+            if (*c == '\0') {
+                c --;
+            } else if (!isalnum((uint8_t)*c)) {
+                ADD_RUN(*c);
+            } else if (*c == 'x' && isxdigit((uint8_t)c[1]) && isxdigit((uint8_t)c[2])) {
+                char hex[3] = { c[1], c[2], '\0' };
+
+                ADD_RUN((uint8_t)strtol(hex, NULL, 16));
+                c += 2;
+            } else {
+                // Classes, assertions, back references, \Q and so on
+                END_RUN();
+                if (c[1] == '{' || c[1] == '<' || c[1] == '\'') {
+                    const char *close = strchr(c + 2, c[1] == '{' ? '}' : c[1] == '<' ? '>' : '\'');
+
+                    if (close == NULL) return;
+                    c = close;
+                } else if (*c == 'c' && c[1] != '\0') {
+                    c ++;
+                } else if (*c == 'Q') {
+                    const char *e = strstr(c, "\\E");
+
+                    if (e == NULL) return;
+                    c = e + 1;
+                } else {
+                    while (isdigit((uint8_t)c[1])) c ++;
+                }
+            }
+            break;
+        default:
+            ADD_RUN(*c);
+            break;
+        }
+    }
+    END_RUN();
+
+    // An unbalanced pattern doesn't compile, but don't trust what was collected
+    if (depth != 0) {
+        data->pcre.literal_count = 0;
+    }
+#undef ADD_RUN
+#undef END_RUN
+}
+
 static dpi_sigopt_status_t dpi_sigopt_pcre_parser (char *value, dpi_sig_t *sig)
 {
     //DEBUG_LOG_FUNC_ENTRY(DBG_DETECT, NULL);
@@ -516,6 +776,12 @@ static dpi_sigopt_status_t dpi_sigopt_pcre_parser (char *value, dpi_sig_t *sig)
         return DPI_SIGOPT_INVALID_OPTION_VALUE;
     } 
 
+    // Without jit the interpreter is used, slower but the same result
+    if (pcre2_jit_compile(data->pcre.recompiled, PCRE2_JIT_COMPLETE) != 0) {
+        DEBUG_LOG(DBG_DETECT, NULL, "PCRE2 jit compilation for (%s) failed\n", start);
+    }
+    dpi_sigopt_pcre_literals(data, start, pcre_flags);
+
     if (dpi_sigopt_hsbuild(data,start, pcre_flags, (dpi_detector_t *)sig->detector) == DPI_SIGOPT_INVALID_OPTION_VALUE) {
         if (data->pcre.hs_db != NULL) {
             hs_free_database(data->pcre.hs_db);
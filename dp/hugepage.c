@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "main.h"
+#include "debug.h"
+
+// jemalloc.h pulls in stdbool.h, keep it after the dp headers.
+#include <jemalloc/jemalloc.h>
+
+#ifndef MAP_HUGETLB
+#define MAP_HUGETLB 0x40000
+#endif
+#ifndef MADV_HUGEPAGE
+#define MADV_HUGEPAGE 14
+#endif
+
+#define HUGEPAGE_SIZE (2 * 1024 * 1024)
+#define HUGEPAGE_ALIGN(x) (((x) + HUGEPAGE_SIZE - 1) & ~((size_t)HUGEPAGE_SIZE - 1))
+
+static uint64_t g_hugetlb_bytes;    // backed by reserved hugetlb pages
+static uint64_t g_thp_bytes;        // advised for transparent hugepages
+
+// -- mapping
+
+// Map anonymous memory with 2M pages. Reserved hugetlb pages are tried first; when the pool
+// is empty, fall back to a 2M aligned mapping advised for transparent hugepages.
+void *dp_huge_map(size_t size, size_t align, size_t *map_size)
+{
+    uint8_t *ptr, *aligned;
+    size_t len;
+
+    if (align < HUGEPAGE_SIZE) {
+        align = HUGEPAGE_SIZE;
+    }
+    len = HUGEPAGE_ALIGN(size);
+
+    if (align == HUGEPAGE_SIZE) {
+        ptr = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+        if (ptr != MAP_FAILED) {
+            __sync_fetch_and_add(&g_hugetlb_bytes, len);
+            *map_size = len;
+            return ptr;
+        }
+    }
+
+    // Over-map so the area can be trimmed to the alignment
+    ptr = mmap(NULL, len + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return NULL;
+    }
+
+    aligned = (uint8_t *)(((uintptr_t)ptr + align - 1) & ~((uintptr_t)align - 1));
+    if (aligned > ptr) {
+        munmap(ptr, aligned - ptr);
+    }
+    if (aligned + len < ptr + len + align) {
+        munmap(aligned + len, ptr + len + align - (aligned + len));
+    }
+
+    if (madvise(aligned, len, MADV_HUGEPAGE) == 0) {
+        __sync_fetch_and_add(&g_thp_bytes, len);
+    }
+
+    *map_size = len;
+    return aligned;
+}
+
+void dp_huge_unmap(void *ptr, size_t map_size)
+{
+    munmap(ptr, map_size);
+}
+
+// -- per-thread arena
+
+// Extents of the arena are never returned (dalloc is not hooked), jemalloc keeps them for reuse.
+// With retain enabled, jemalloc grows the arena in steps of 2M and more, so rounding up the
+// mapping to the hugepage size wastes little.
+static void *huge_extent_alloc(extent_hooks_t *hooks, void *new_addr, size_t size, size_t alignment,
+                               bool *zero, bool *commit, unsigned arena_ind)
+{
+    size_t map_size;
+    void *ptr;
+
+    if (new_addr != NULL) {
+        // Growing in place is not supported
+        return NULL;
+    }
+
+    ptr = dp_huge_map(size, alignment, &map_size);
+    if (ptr == NULL) {
+        return NULL;
+    }
+    *zero = true;
+    *commit = true;
+    return ptr;
+}
+
+static extent_hooks_t g_huge_extent_hooks = {
+    .alloc = huge_extent_alloc,
+};
+
+// Clips of jumbo and GRO frames are malloc'ed, let the thread caches keep up to 64K
+const char *malloc_conf = "lg_tcache_max:16";
+
+static int g_arena_ind[MAX_DP_THREADS];     // arena of each dp thread plus 1, 0 if none
+
+// Bind the calling dp thread to an arena of its own, so its allocations don't contend with
+// other threads and its memory can be told apart. With hugepages, the arena is backed by
+// 2M pages so the sessions, fragments and meters of the thread are covered by few TLB entries.
+int dp_arena_thread_init(int thr_id)
+{
+    extent_hooks_t *hooks = &g_huge_extent_hooks;
+    unsigned arena;
+    size_t sz = sizeof(arena);
+    int ret;
+
+    if (g_hugepage) {
+        ret = mallctl("arenas.create", &arena, &sz, &hooks, sizeof(hooks));
+    } else {
+        ret = mallctl("arenas.create", &arena, &sz, NULL, 0);
+    }
+    if (ret != 0) {
+        DEBUG_ERROR(DBG_INIT, "failed to create arena, thr_id=%d\n", thr_id);
+        return -1;
+    }
+    if (mallctl("thread.arena", NULL, NULL, &arena, sizeof(arena)) != 0) {
+        DEBUG_ERROR(DBG_INIT, "failed to bind arena, thr_id=%d\n", thr_id);
+        return -1;
+    }
+    // Objects cached before the switch belong to the old arena
+    mallctl("thread.tcache.flush", NULL, NULL, NULL, 0);
+
+    g_arena_ind[thr_id] = arena + 1;
+    DEBUG_INIT("arena %u bound, hugepage=%d\n", arena, g_hugepage);
+    return 0;
+}
+
+static void dp_mallctl_u64(const char *name, uint64_t *val)
+{
+    size_t v = 0, sz = sizeof(v);
+
+    mallctl(name, &v, &sz, NULL, 0);
+    *val = v;
+}
+
+// Refresh the statistics of jemalloc, they are cached until the next call
+static void dp_arena_refresh(void)
+{
+    uint64_t epoch = 1;
+    size_t sz = sizeof(epoch);
+
+    mallctl("epoch", &epoch, &sz, &epoch, sz);
+}
+
+// Bytes in use in the arena of a dp thread, 0 before it is bound
+uint64_t dp_arena_bytes(int thr_id)
+{
+    uint64_t small, large;
+    char name[64];
+    int ind = g_arena_ind[thr_id];
+
+    if (ind == 0) {
+        return 0;
+    }
+
+    dp_arena_refresh();
+    snprintf(name, sizeof(name), "stats.arenas.%d.small.allocated", ind - 1);
+    dp_mallctl_u64(name, &small);
+    snprintf(name, sizeof(name), "stats.arenas.%d.large.allocated", ind - 1);
+    dp_mallctl_u64(name, &large);
+    return small + large;
+}
+
+// Bytes in use and resident in all arenas
+void dp_arena_totals(uint64_t *allocated, uint64_t *resident)
+{
+    dp_arena_refresh();
+    dp_mallctl_u64("stats.allocated", allocated);
+    dp_mallctl_u64("stats.resident", resident);
+}
+
+// -- dTLB counter
+
+// Count data TLB load misses of the calling thread. Return -1 if perf events are not
+// permitted, in which case misses are reported as 0.
+int dp_huge_tlb_open(void)
+{
+    struct perf_event_attr attr;
+    int fd;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.exclude_hv = 1;
+
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (fd < 0) {
+        DEBUG_INIT("dTLB miss counter not available, errno=%d\n", errno);
+        return -1;
+    }
+    return fd;
+}
+
+uint64_t dp_huge_tlb_read(int fd)
+{
+    uint64_t cnt;
+
+    if (fd < 0 || read(fd, &cnt, sizeof(cnt)) != sizeof(cnt)) {
+        return 0;
+    }
+    return cnt;
+}
+
+uint64_t dp_huge_bytes(void)
+{
+    return __sync_fetch_and_add(&g_hugetlb_bytes, 0) + __sync_fetch_and_add(&g_thp_bytes, 0);
+}
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+
+#include "urcu.h"
+
+#include "main.h"
+#include "apis.h"
+#include "debug.h"
+#include "utils/helper.h"
+
+extern time_t get_current_time();
+
+// Debug lines are formatted by the calling thread into its own ring and written out by the
+// logger thread, so a thread never waits for the lock, the terminal or the disk. When a ring
+// is full the line is dropped and counted.
+
+#define LOG_LINE_SIZE   512
+#define LOG_RING_SIZE   512     // lines, power of 2
+#define MAX_LOG_RINGS   64
+#define LOG_IOV_BATCH   64
+#define LOG_IDLE_WAIT   10000   // us
+
+typedef struct log_line_ {
+    uint32_t len;
+    char buf[LOG_LINE_SIZE - sizeof(uint32_t)];
+} log_line_t;
+
+// Single producer, the owner thread, and single consumer, the logger thread
+typedef struct log_ring_ {
+    uint32_t head __attribute__((aligned(64)));
+    uint32_t drops;
+    uint32_t tail __attribute__((aligned(64)));
+    uint32_t drops_seen;
+    log_line_t lines[LOG_RING_SIZE];
+} log_ring_t;
+
+static log_ring_t *g_log_rings[MAX_LOG_RINGS];
+static int g_log_ring_cnt;
+static int g_log_fd = STDOUT_FILENO;
+static pthread_t g_log_thr;
+static bool g_log_thr_create;
+static volatile bool g_log_running;
+static pthread_mutex_t g_log_lock = PTHREAD_MUTEX_INITIALIZER;   // threads without a ring
+
+static __thread log_ring_t *t_log_ring;
+static __thread bool t_log_ring_failed;
+static __thread time_t t_ts_sec = -1;
+static __thread char t_ts[64];
+
+// Timestamp is formatted once a second by each thread
+static const char *log_ts(void)
+{
+    time_t t = get_current_time();
+
+    if (t != t_ts_sec) {
+        struct tm tm;
+
+        localtime_r(&t, &tm);
+        snprintf(t_ts, sizeof(t_ts), "%04d-%02d-%02dT%02d:%02d:%02d|DEBU|",
+                 tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+        t_ts_sec = t;
+    }
+    return t_ts;
+}
+
+static log_ring_t *log_thread_ring(void)
+{
+    log_ring_t *r;
+    int idx;
+
+    if (likely(t_log_ring != NULL) || t_log_ring_failed) {
+        return t_log_ring;
+    }
+
+    r = calloc(1, sizeof(*r));
+    if (r == NULL) {
+        t_log_ring_failed = true;
+        return NULL;
+    }
+    idx = uatomic_add_return(&g_log_ring_cnt, 1) - 1;
+    if (idx >= MAX_LOG_RINGS) {
+        free(r);
+        t_log_ring_failed = true;
+        return NULL;
+    }
+    rcu_assign_pointer(g_log_rings[idx], r);
+    t_log_ring = r;
+    return r;
+}
+
+static int log_format(char *buf, int size, bool print_ts, const char *fmt, va_list args)
+{
+    int len = 0, n;
+
+    if (print_ts) {
+        len = snprintf(buf, size, "%s%s|", log_ts(), THREAD_NAME);
+    }
+    n = vsnprintf(buf + len, size - len, fmt, args);
+    if (n >= size - len) {
+        // Truncated, keep the line break
+        len = size - 1;
+        buf[len - 1] = '\n';
+    } else if (n > 0) {
+        len += n;
+    }
+    return len;
+}
+
+int dp_logger_write(bool print_ts, const char *fmt, va_list args)
+{
+    log_ring_t *r = log_thread_ring();
+    log_line_t *line;
+    uint32_t head;
+
+    if (unlikely(r == NULL)) {
+        char buf[LOG_LINE_SIZE];
+        int len = log_format(buf, sizeof(buf), print_ts, fmt, args);
+
+        pthread_mutex_lock(&g_log_lock);
+        write(g_log_fd, buf, len);
+        pthread_mutex_unlock(&g_log_lock);
+        return len;
+    }
+
+    head = r->head;
+    if (head - CMM_LOAD_SHARED(r->tail) >= LOG_RING_SIZE) {
+        CMM_STORE_SHARED(r->drops, r->drops + 1);
+        return 0;
+    }
+
+    line = &r->lines[head & (LOG_RING_SIZE - 1)];
+    line->len = log_format(line->buf, sizeof(line->buf), print_ts, fmt, args);
+    cmm_smp_wmb();
+    CMM_STORE_SHARED(r->head, head + 1);
+    return line->len;
+}
+
+static void log_write_all(struct iovec *iov, int cnt)
+{
+    while (cnt > 0) {
+        ssize_t n = writev(g_log_fd, iov, cnt);
+
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        // Skip what is written, resume in the middle of a partly written line
+        while (cnt > 0 && n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov ++;
+            cnt --;
+        }
+        if (cnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+}
+
+// Write out the lines queued by the time of the call, return the number of lines.
+static uint32_t log_drain(void)
+{
+    struct iovec iov[LOG_IOV_BATCH];
+    char drop_msg[64];
+    uint32_t total = 0;
+    int i, rings = min(uatomic_read(&g_log_ring_cnt), MAX_LOG_RINGS);
+
+    for (i = 0; i < rings; i ++) {
+        log_ring_t *r = rcu_dereference(g_log_rings[i]);
+        uint32_t tail, head, drops;
+
+        if (r == NULL) {
+            continue;
+        }
+
+        drops = CMM_LOAD_SHARED(r->drops);
+        head = CMM_LOAD_SHARED(r->head);
+        cmm_smp_rmb();
+
+        for (tail = r->tail; tail != head; ) {
+            int cnt = 0;
+            uint32_t start = tail;
+
+            if (drops != r->drops_seen) {
+                iov[cnt].iov_base = drop_msg;
+                iov[cnt].iov_len = snprintf(drop_msg, sizeof(drop_msg), "%s%s|dropped %u debug lines\n",
+                                            log_ts(), THREAD_NAME, drops - r->drops_seen);
+                r->drops_seen = drops;
+                cnt ++;
+            }
+            for (; tail != head && cnt < LOG_IOV_BATCH; tail ++, cnt ++) {
+                log_line_t *line = &r->lines[tail & (LOG_RING_SIZE - 1)];
+                iov[cnt].iov_base = line->buf;
+                iov[cnt].iov_len = line->len;
+            }
+
+            log_write_all(iov, cnt);
+            total += tail - start;
+
+            cmm_smp_mb();
+            CMM_STORE_SHARED(r->tail, tail);
+        }
+    }
+
+    return total;
+}
+
+static void *dp_logger_thr(void *args)
+{
+    snprintf(THREAD_NAME, MAX_THREAD_NAME_LEN, "log");
+    pin_thread_other_cpus(g_dp_cpus, g_dp_cpu_cnt);
+
+    while (g_log_running) {
+        if (log_drain() == 0) {
+            usleep(LOG_IDLE_WAIT);
+        }
+    }
+    log_drain();
+    return NULL;
+}
+
+int dp_logger_start(void)
+{
+    g_log_running = true;
+    if (pthread_create(&g_log_thr, NULL, dp_logger_thr, NULL) != 0) {
+        g_log_running = false;
+        return -1;
+    }
+    g_log_thr_create = true;
+    return 0;
+}
+
+// Flush what is queued
+void dp_logger_stop(void)
+{
+    if (g_log_thr_create) {
+        g_log_running = false;
+        pthread_join(g_log_thr, NULL);
+        g_log_thr_create = false;
+    }
+}
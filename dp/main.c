@@ -13,27 +13,49 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <execinfo.h>
 
 #include "debug.h"
 #include "apis.h"
 #include "utils/helper.h"
+#include "utils/hash.h"
 #include "utils/rcu_map.h"
+#include "main.h"
 
 extern void *dp_timer_thr(void *args);
 extern void *dp_bld_dlp_thr(void *args);
 extern void *dp_data_thr(void *args);
 extern void dp_ctrl_loop(void);
+extern int dp_ctrl_set_timer_period(const char *name, uint32_t period);
 extern int dp_ctrl_send_json(json_t *root);
 extern int dp_ctrl_send_binary(void *data, int len);
 extern int dp_ctrl_threat_log(DPMsgThreatLog *log);
+extern int dp_ctrl_log_init(bool shared);
+extern int dp_ctrl_stats_init(void);
+extern int dp_snap_init(void);
 extern int dp_ctrl_traffic_log(DPMsgSession *log);
 extern int dp_ctrl_connect_report(DPMsgSession *log, DPMonitorMetric *metric, int count_session, int count_violate);
-extern void dp_ctrl_init_thread_data(void);
+extern void dp_ctrl_init_thread_data(int thr_id);
+extern int dp_logger_write(bool print_ts, const char *fmt, va_list args);
+extern int dp_logger_start(void);
+extern void dp_logger_stop(void);
+extern int dp_reclaim_start(void);
+extern void dp_reclaim_stop(void);
+extern int dp_bench_session_map(void);
+extern int dp_bench_utils(void);
+extern int dp_bench_policy(const char *policy, const char *replay);
+extern int dp_bench_replay(const char *pcap, const char *fixture, int threads, int loops);
+extern int dp_bench_sqli(const char *corpus);
 
 extern int dp_data_add_tap(const char *netns, const char *iface, const char *ep_mac, int thr_id);
 
 extern int dp_send_packet(io_ctx_t *context, uint8_t *pkt, int len);
 
+extern int dp_offload_init(void);
+extern int dp_flow_offload(const io_flow_key_t *key);
+extern int dp_flow_unload(const io_flow_key_t *key, io_flow_stats_t *stats);
+extern int dp_flow_stats(const io_flow_key_t *key, io_flow_stats_t *stats);
+
 __thread int THREAD_ID;
 __thread char THREAD_NAME[32];
 
@@ -46,8 +68,25 @@ struct cds_list_head g_subnet4_list;
 struct cds_list_head g_subnet6_list; 
 struct timeval g_now;
 int g_dp_threads = 0;
+int g_dp_active_threads = 0;   // threads taking taps, the rest are retired
+int g_dp_fanout_threads = 0;   // sockets in the fanout group of the service port
 int g_stats_slot = 0;
 char *g_in_iface;
+bool g_xdp = false;
+bool g_ring_v3 = false;
+bool g_fanout = false;
+bool g_gro = false;
+uint32_t g_ring_mem_limit = 512;   // MB, the rings of all contexts are tuned within it
+int g_sched_policy = DP_SCHED_ADAPTIVE;
+int g_dp_cpus[MAX_DP_THREADS];
+int g_dp_cpu_cnt = 0;
+int g_dp_instance = 0;          // numa node of this instance, see dp_instance_name()
+int g_dp_instances = 1;
+bool g_hugepage = false;
+// Keep the session table in shm for the next run
+static bool g_resume_sessions = false;
+static uint32_t g_expected_workloads = 0;
+static uint32_t g_session_limit = 0;    // of all dp threads
 pthread_mutex_t g_debug_lock;
 
 io_callback_t g_callback;
@@ -55,12 +94,40 @@ io_config_t g_config;
 
 static void dp_signal_dump_policy(int num)
 {
+    io_ctrl_cmd_t cmd;
     int thr_id;
+
+    // Don't wait in the signal handler
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.req = CTRL_REQ_DUMP_POLICY;
     for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
-        dp_data_wait_ctrl_req_thr(CTRL_REQ_DUMP_POLICY, thr_id);
+        dp_data_post_ctrl_cmd(&cmd, thr_id);
     }
 }
 
+static void dp_signal_dump_trace(int num)
+{
+    dpi_trace_request_dump();
+}
+
+// Asked by the monitor before it restarts dp for a thread that misses its heartbeat, the
+// signal is sent to that thread
+static void dp_signal_stall_dump(int num)
+{
+    void *frames[64];
+    int fd, n;
+
+    fd = open(DP_STALL_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return;
+    }
+    n = backtrace(frames, ARRAY_ENTRIES(frames));
+    if (write(fd, THREAD_NAME, strnlen(THREAD_NAME, MAX_THREAD_NAME_LEN)) > 0 && write(fd, ":\n", 2) > 0) {
+        backtrace_symbols_fd(frames, n, fd);
+    }
+    close(fd);
+}
+
 static void dp_signal_exit(int num)
 {
     g_running = false;
@@ -131,12 +198,87 @@ int debug_file(bool print_ts, const char *fmt, va_list args)
     return len;
 }
 
+// Name of a socket, shared memory or file of this instance. The monitor and the agent add
+// the same suffix.
+const char *dp_instance_name(const char *name, char *buf, int size)
+{
+    if (g_dp_instances <= 1) {
+        return name;
+    }
+    snprintf(buf, size, "%s.%d", name, g_dp_instance);
+    return buf;
+}
+
+// Ports are added to all instances, each opens the ones of its numa node. Virtual interfaces
+// and interfaces in other namespaces have no node, they are spread by the namespace or name.
+bool dp_instance_owns(const char *netns, const char *iface)
+{
+    const char *key = netns != NULL ? netns : iface;
+    char path[128];
+    uint32_t node;
+    int n = -1;
+    FILE *fp;
+
+    if (g_dp_instances <= 1) {
+        return true;
+    }
+    if (key == NULL) {
+        return g_dp_instance == 0;
+    }
+
+    if (netns == NULL) {
+        snprintf(path, sizeof(path), "/sys/class/net/%s/device/numa_node", iface);
+        if ((fp = fopen(path, "r")) != NULL) {
+            if (fscanf(fp, "%d", &n) != 1) {
+                n = -1;
+            }
+            fclose(fp);
+        }
+    }
+    node = n >= 0 ? n : sdbm_hash((const uint8_t *)key, strlen(key));
+    return node % g_dp_instances == g_dp_instance;
+}
+
+// Run all threads of the instance on the cpus of its node, with memory of the node. The dp
+// threads take the first cpus unless -C is given.
+static int dp_instance_bind(void)
+{
+    char path[64], list[1024];
+    int cpus[MAX_CPU_ID];
+    int cnt = 0;
+    FILE *fp;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", g_dp_instance);
+    if ((fp = fopen(path, "r")) != NULL) {
+        if (fgets(list, sizeof(list), fp) != NULL) {
+            list[strcspn(list, "\n")] = '\0';
+            cnt = parse_cpu_list(list, cpus, MAX_CPU_ID);
+        }
+        fclose(fp);
+    }
+    if (cnt <= 0) {
+        DEBUG_INIT("no cpu of node %d\n", g_dp_instance);
+        return -1;
+    }
+
+    if (g_dp_cpu_cnt == 0) {
+        int threads = g_dp_threads > 0 ? min(g_dp_threads, MAX_DP_THREADS) : MAX_DP_THREADS;
+
+        g_dp_cpu_cnt = min(cnt, threads);
+        memcpy(g_dp_cpus, cpus, sizeof(int) * g_dp_cpu_cnt);
+    }
+    pin_thread_cpus(cpus, cnt);
+    set_mem_node(g_dp_instance);
+    return 0;
+}
+
 static void *get_shm(size_t size)
 {
+    char name[64];
     int fd;
     void *ptr;
 
-    fd = shm_open(DP_MNT_SHM_NAME, O_RDWR, S_IRWXU | S_IRWXG);
+    fd = shm_open(dp_instance_name(DP_MNT_SHM_NAME, name, sizeof(name)), O_RDWR, S_IRWXU | S_IRWXG);
     if (fd < 0) {
         return NULL;
     }
@@ -152,13 +294,55 @@ static void *get_shm(size_t size)
     return ptr;
 }
 
+static pthread_t g_dp_thr[MAX_DP_THREADS];
+static int g_dp_thr_id[MAX_DP_THREADS];
+static bool g_dp_thr_create[MAX_DP_THREADS];
+
+// Also called by the ctrl thread to add a thread at runtime
+int dp_start_data_thread(int i)
+{
+    if (g_dp_thr_create[i]) {
+        return 0;
+    }
+
+    // Rings of a dp thread are allocated on the node of its cpu
+    g_dp_thread_data[i].cpu = g_dp_cpu_cnt > 0 ? g_dp_cpus[i % g_dp_cpu_cnt] : -1;
+    g_dp_thread_data[i].numa_node = g_dp_cpu_cnt > 0 ? cpu_to_node(g_dp_thread_data[i].cpu) : -1;
+    g_dp_thread_data[i].tlb_fd = -1;
+    dp_ctrl_init_thread_data(i);
+
+    g_dp_thr_id[i] = i;
+    if (pthread_create(&g_dp_thr[i], NULL, dp_data_thr, &g_dp_thr_id[i]) != 0) {
+        DEBUG_ERROR(DBG_INIT, "failed to create dp thread %d\n", i);
+        return -1;
+    }
+    g_dp_thr_create[i] = true;
+    return 0;
+}
+
+// Size the maps of dp threads up front, so they don't resize in the first burst of connections
+static void dp_size_maps(int threads)
+{
+    if (g_session_limit > 0) {
+        uint32_t sessions = g_session_limit / threads;
+
+        g_config.sess_limit = max(sessions, 1);
+        g_config.map_size[DP_MAP_SESSION4] = sessions;
+        g_config.map_size[DP_MAP_SESSION6] = sessions / 8;
+        g_config.map_size[DP_MAP_FRAG4] = sessions / 256;
+        g_config.map_size[DP_MAP_FRAG6] = sessions / 1024;
+    }
+    if (g_expected_workloads > 0) {
+        g_config.map_size[DP_MAP_METER] = g_expected_workloads * 4;
+        g_config.map_size[DP_MAP_LOG] = g_expected_workloads;
+    }
+}
+
 static int net_run(const char *in_iface)
 {
     pthread_t timer_thr;
     pthread_t bld_dlp_thr;
-    pthread_t dp_thr[MAX_DP_THREADS];
-    int i, j, timer_thr_id, bld_dlp_thr_id, thr_id[MAX_DP_THREADS];
-    bool thr_create[MAX_DP_THREADS];
+    int i, timer_thr_id, bld_dlp_thr_id;
     DEBUG_FUNC_ENTRY(DBG_INIT);
 
     g_running = true;
@@ -167,28 +351,29 @@ static int net_run(const char *in_iface)
     signal(SIGINT, dp_signal_exit);
     signal(SIGQUIT, dp_signal_exit);
     signal(SIGUSR1, dp_signal_dump_policy);
+    signal(SIGUSR2, dp_signal_dump_trace);
+    signal(DP_SIG_STALL_DUMP, dp_signal_stall_dump);
+    // The first backtrace() loads libgcc, not to be done in the signal handler
+    void *frame;
+    backtrace(&frame, 1);
 
-    for (j = 0; j < MAX_DP_THREADS; j++) {
-        thr_create[j] = false;
-    }
     // Calculate number of dp threads
     if (g_dp_threads == 0) {
-        g_dp_threads = count_cpu();
+        g_dp_threads = g_dp_cpu_cnt > 0 ? g_dp_cpu_cnt : count_cpu();
     }
     if (g_dp_threads > MAX_DP_THREADS) {
         g_dp_threads = MAX_DP_THREADS;
     }
 
-    dp_ctrl_init_thread_data();
+    g_dp_active_threads = g_dp_threads;
+    dp_size_maps(g_dp_threads);
 
     pthread_create(&timer_thr, NULL, dp_timer_thr, &timer_thr_id);
 
     pthread_create(&bld_dlp_thr, NULL, dp_bld_dlp_thr, &bld_dlp_thr_id);
 
     for (i = 0; i < g_dp_threads; i ++) {
-        thr_id[i] = i;
-        thr_create[i] = true;
-        pthread_create(&dp_thr[i], NULL, dp_data_thr, &thr_id[i]);
+        dp_start_data_thread(i);
     }
 
     if (in_iface != NULL) {
@@ -200,23 +385,117 @@ static int net_run(const char *in_iface)
 
     pthread_join(timer_thr, NULL);
     pthread_join(bld_dlp_thr, NULL);
-    for (i = 0; i < g_dp_threads; i ++) {
-        if (thr_create[i]) {
-            pthread_join(dp_thr[i], NULL);
+    for (i = 0; i < MAX_DP_THREADS; i ++) {
+        if (g_dp_thr_create[i]) {
+            pthread_join(g_dp_thr[i], NULL);
         }
     }
 
     return 0;
 }
 
+#ifdef DP_MSEG
+// micro-segment runs the dp without the monitor, and names its config file with -c
+#define DP_OPTIONS "h3A:b:BC:c:d:E:fF:gG:Hi:j:l:m:M:n:N:p:P:q:r:RsS:T:uv:w:x"
+#else
+#define DP_OPTIONS "h3A:b:BcC:d:E:fF:gG:Hi:j:l:m:M:n:N:p:P:q:r:RsS:T:uv:w:x"
+#endif
+
 static void help(const char *prog)
 {
     printf("%s:\n", prog);
     printf("  h: help\n");
+    printf("  B: benchmark the session map engines and exit\n");
+    printf("  u: benchmark the utils data structures, one json result per line, and exit\n");
+    printf("  b: benchmark policy lookups of a ctrl_cfg_policy json file, or of generated rules with 'gen', and exit\n");
+    printf("  r: tuple file (sip dip dport proto [ingress]) to replay in the policy benchmark\n");
+    printf("  G: benchmark the inspection of a pcap file replayed in each of -n threads, and exit\n");
+    printf("  F: json fixture of the replay benchmark, the ctrl messages to apply and the endpoint mac\n");
+    printf("  l: times the replay benchmark goes through the pcap file\n");
+    printf("  q: benchmark the sql injection check of a query file, one per line, or of generated queries with 'gen', and exit\n");
     printf("  d: debug flags\n");
     printf("     (none, all, int, error, ctrl, packet, session, timer, tcp, parser, log, ddos, policy, dlp)\n");
     printf("  p: pcap file or directory\n");
     printf("  s: standalone mode (listen to the control channel)\n");
+#ifdef DP_MSEG
+    printf("     always on in the micro-segment build\n");
+    printf("  c: config file of micro-segment, the settings are sent by the agent\n");
+#endif
+    printf("  x: use AF_XDP sockets for inline ports\n");
+    printf("  3: use TPACKET_V3 rings\n");
+    printf("  f: spread service port traffic to all dp threads with packet fanout\n");
+    printf("  g: size TPACKET_V3 blocks for GRO frames, implies -3\n");
+    printf("  m: packet wait mode (adaptive, poll, interrupt)\n");
+    printf("  M: MB of packet rings the ring tuning can grow to, all contexts together\n");
+    printf("  C: cpu list of dp threads, e.g. 2,3,6-7\n");
+    printf("  N: numa node of the instance and number of instances, e.g. 1/4\n");
+    printf("  H: back AF_XDP umem and dp thread allocations with 2M pages\n");
+    printf("  R: keep the tcp sessions in shared memory and resume them after a restart\n");
+    printf("  T: housekeeping period in seconds, 0 to disable, e.g. connects=6\n");
+    printf("     (app, fqdn_ip, ip_fqdn_storage, threat_log, connects, ring_tune)\n");
+    printf("  w: expected number of workloads, to size the maps\n");
+    printf("  S: session limit of all dp threads, split evenly, also sizes the session maps\n");
+    printf("  E: session limit of an endpoint\n");
+    printf("  A: bytes cached for tcp reassembly, e.g. wing=32768; over it a session is inspected in order only\n");
+    printf("     (wing, ep, thread)\n");
+    printf("  P: objects preallocated per dp thread and optional cap, e.g. session=4096:65536\n");
+    printf("     (session, clip, frag, meter)\n");
+}
+
+static const char *g_pool_names[DP_POOL_MAX] = {
+    [DP_POOL_SESSION] = "session",
+    [DP_POOL_CLIP] = "clip",
+    [DP_POOL_FRAG] = "frag",
+    [DP_POOL_METER] = "meter",
+};
+
+// name=prealloc[:cap]
+static int parse_pool_size(char *arg)
+{
+    char *eq = strchr(arg, '='), *colon;
+    int id;
+
+    if (eq == NULL) {
+        return -1;
+    }
+    *eq = '\0';
+    for (id = 0; id < DP_POOL_MAX; id ++) {
+        if (strcasecmp(arg, g_pool_names[id]) == 0) {
+            break;
+        }
+    }
+    if (id == DP_POOL_MAX) {
+        return -1;
+    }
+
+    g_config.pool_prealloc[id] = strtoul(eq + 1, &colon, 10);
+    if (*colon == ':') {
+        g_config.pool_cap[id] = strtoul(colon + 1, NULL, 10);
+    }
+    return 0;
+}
+
+// wing|ep|thread=bytes
+static int parse_asm_limit(char *arg)
+{
+    char *eq = strchr(arg, '=');
+    uint32_t bytes;
+
+    if (eq == NULL) {
+        return -1;
+    }
+    *eq = '\0';
+    bytes = strtoul(eq + 1, NULL, 10);
+    if (strcasecmp(arg, "wing") == 0) {
+        g_config.asm_wing_limit = bytes;
+    } else if (strcasecmp(arg, "ep") == 0) {
+        g_config.asm_ep_limit = bytes;
+    } else if (strcasecmp(arg, "thread") == 0) {
+        g_config.asm_thread_limit = bytes;
+    } else {
+        return -1;
+    }
+    return 0;
 }
 
 // -- pcap
@@ -250,16 +529,21 @@ static void pcap_packet(char *user, struct pcap_pkthdr *hdr, uint8_t *pkt)
     struct timeval last_now = g_now;
 
     context.dp_ctx = NULL;
+    context.ep_cache = NULL;
     g_now = hdr->ts;
     context.tick = g_now.tv_sec;
     context.tap = true;
     context.quar = false;
+    context.rx_ns = 0;
     dpi_recv_packet(&context, pkt, hdr->caplen);
 
     struct timeval td = tv_diff(last_now, g_now);
     if (td.tv_sec > 0) {
         dpi_timeout(g_now.tv_sec);
+    } else {
+        dpi_timer_roll(g_now.tv_sec * 1000 + g_now.tv_usec / 1000);
     }
+    dpi_reset_flush();
 }
 
 
@@ -341,14 +625,22 @@ static int dp_ep_match(struct cds_lfht_node *ht_node, const void *key)
 
 static uint32_t dp_ep_hash(const void *key)
 {
-    return sdbm_hash(key, ETH_ALEN);
+    return hash_key(key, ETH_ALEN);
 }
 
 
 int main(int argc, char *argv[])
 {
     char *pcap = NULL;
+    char *bench_policy = NULL, *bench_replay = NULL;
+    char *bench_pcap = NULL, *bench_fixture = NULL;
+    int bench_loops = 1;
+#ifdef DP_MSEG
+    char *config_file = NULL;
+    bool standalone = true;
+#else
     bool standalone = false;
+#endif
     int arg = 0;
     struct rlimit core_limits;
 
@@ -357,13 +649,38 @@ int main(int argc, char *argv[])
 
     memset(&g_config, 0, sizeof(g_config));
     while (arg != -1) {
-        arg = getopt(argc, argv, "hcd:i:j:n:p:s:v:");
+        arg = getopt(argc, argv, DP_OPTIONS);
 
         switch (arg) {
         case -1:
             break;
+        case '3':
+            g_ring_v3 = true;
+            break;
+        case 'b':
+            bench_policy = optarg;
+            break;
+        case 'B':
+            return dp_bench_session_map();
         case 'c':
+#ifdef DP_MSEG
+            config_file = optarg;
+#else
             g_config.enable_cksum = true;
+#endif
+            break;
+        case 'A':
+            if (parse_asm_limit(optarg) < 0) {
+                printf("Invalid reassembly limit: %s\n", optarg);
+                exit(-2);
+            }
+            break;
+        case 'C':
+            g_dp_cpu_cnt = parse_cpu_list(optarg, g_dp_cpus, MAX_DP_THREADS);
+            if (g_dp_cpu_cnt <= 0) {
+                printf("Invalid cpu list: %s\n", optarg);
+                exit(-2);
+            }
             break;
         case 'd':
             if (strcasecmp(optarg, "none") == 0) {
@@ -374,20 +691,101 @@ int main(int argc, char *argv[])
                 g_debug_levels |= debug_name2level(optarg);
             }
             break;
+        case 'E':
+            g_config.ep_sess_limit = strtoul(optarg, NULL, 10);
+            break;
+        case 'f':
+            g_fanout = true;
+            break;
+        case 'F':
+            bench_fixture = optarg;
+            break;
+        case 'g':
+            g_gro = true;
+            break;
+        case 'G':
+            bench_pcap = optarg;
+            g_config.promisc = true;
+            break;
+        case 'H':
+            g_hugepage = true;
+            break;
         case 'i':
             g_in_iface = strdup(optarg);
             g_config.promisc = true;
             break;
+        case 'l':
+            bench_loops = atoi(optarg);
+            break;
+        case 'm':
+            if (strcasecmp(optarg, "poll") == 0) {
+                g_sched_policy = DP_SCHED_POLL;
+            } else if (strcasecmp(optarg, "interrupt") == 0) {
+                g_sched_policy = DP_SCHED_INTERRUPT;
+            } else {
+                g_sched_policy = DP_SCHED_ADAPTIVE;
+            }
+            break;
+        case 'M':
+            g_ring_mem_limit = strtoul(optarg, NULL, 10);
+            break;
         case 'n':
             g_dp_threads = atoi(optarg);
             break;
+        case 'N':
+            if (sscanf(optarg, "%d/%d", &g_dp_instance, &g_dp_instances) != 2 ||
+                g_dp_instances < 1 || g_dp_instances > DP_NUMA_MAX ||
+                g_dp_instance < 0 || g_dp_instance >= g_dp_instances) {
+                printf("Invalid instance: %s\n", optarg);
+                exit(-2);
+            }
+            break;
         case 'p':
             pcap = optarg;
             g_config.promisc = true;
             break;
+        case 'P':
+            if (parse_pool_size(optarg) < 0) {
+                printf("Invalid pool size: %s\n", optarg);
+                exit(-2);
+            }
+            break;
+        case 'q':
+            return dp_bench_sqli(optarg);
+        case 'r':
+            bench_replay = optarg;
+            break;
+        case 'R':
+            g_resume_sessions = true;
+            break;
         case 's':
             standalone = true;
             break;
+        case 'S':
+            g_session_limit = strtoul(optarg, NULL, 10);
+            break;
+        case 'T':
+            {
+                char *eq = strchr(optarg, '=');
+                if (eq == NULL) {
+                    help(argv[0]);
+                    exit(-2);
+                }
+                *eq = '\0';
+                if (dp_ctrl_set_timer_period(optarg, atoi(eq + 1)) < 0) {
+                    printf("Unknown timer: %s\n", optarg);
+                    exit(-2);
+                }
+            }
+            break;
+        case 'u':
+            return dp_bench_utils();
+        case 'w':
+            g_expected_workloads = strtoul(optarg, NULL, 10);
+            break;
+        case 'x':
+            g_xdp = true;
+            break;
         case 'v':
             if (strcasecmp(optarg, "thrt_tls_1dot0") == 0) {
                 g_config.thrt_ssl_tls_1dot0 = true;
@@ -404,16 +802,22 @@ int main(int argc, char *argv[])
     }
 
     setlinebuf(stdout);
+#ifdef DP_MSEG
+    if (config_file != NULL) {
+        printf("Config file: %s\n", config_file);
+    }
+#endif
 
     pthread_mutex_init(&g_debug_lock, NULL);
-    rcu_map_init(&g_ep_map, 1, offsetof(io_mac_t, node), dp_ep_match, dp_ep_hash);
+    // An ep has its mac and may have unicast and broadcast macs
+    rcu_map_init(&g_ep_map, max(g_expected_workloads * 3, 1), offsetof(io_mac_t, node), dp_ep_match, dp_ep_hash);
     CDS_INIT_LIST_HEAD(&g_subnet4_list);
     CDS_INIT_LIST_HEAD(&g_subnet6_list);
 
     init_dummy_ep(&g_config.dummy_ep);
     g_config.dummy_mac.ep = &g_config.dummy_ep;
 
-    if (pcap != NULL) {
+    if (pcap != NULL || bench_policy != NULL || bench_pcap != NULL) {
         g_callback.debug = debug_stdout;
         g_callback.send_packet = pcap_send_packet;
         g_callback.send_ctrl_json = dp_ctrl_send_json;
@@ -422,10 +826,20 @@ int main(int argc, char *argv[])
         g_callback.traffic_log = pcap_traffic_log;
         g_callback.connect_report = pcap_connect_report;
         dpi_setup(&g_callback, &g_config);
+        if (bench_pcap != NULL) {
+            int threads = g_dp_threads > 0 ? min(g_dp_threads, MAX_DP_THREADS) : 1;
+
+            dp_size_maps(threads);
+            return dp_bench_replay(bench_pcap, bench_fixture, threads, bench_loops);
+        }
+        dp_size_maps(1);
         dpi_init(DPI_INIT);
+        if (bench_policy != NULL) {
+            return dp_bench_policy(bench_policy, bench_replay);
+        }
         return pcap_run(pcap);
     } else if (standalone) {
-        g_callback.debug = debug_stdout;
+        g_callback.debug = dp_logger_write;
         g_callback.send_packet = dp_send_packet;
         g_callback.send_ctrl_json = dp_ctrl_send_json;
         g_callback.send_ctrl_binary = dp_ctrl_send_binary;
@@ -434,19 +848,27 @@ int main(int argc, char *argv[])
         g_callback.connect_report = dp_ctrl_connect_report;
         dpi_setup(&g_callback, &g_config);
 
+        dp_logger_start();
+        dp_reclaim_start();
+        dp_ctrl_log_init(false);
+
         g_shm = calloc(1, sizeof(dp_mnt_shm_t));
         if (g_shm == NULL) {
             DEBUG_INIT("Unable to allocate shared memory.\n");
+            dp_reclaim_stop();
+            dp_logger_stop();
             return -1;
         }
 
         int ret = net_run(g_in_iface);
 
+        dp_reclaim_stop();
         free(g_shm);
+        dp_logger_stop();
 
         return ret;
     } else {
-        g_callback.debug = debug_stdout;
+        g_callback.debug = dp_logger_write;
         g_callback.send_packet = dp_send_packet;
         g_callback.send_ctrl_json = dp_ctrl_send_json;
         g_callback.send_ctrl_binary = dp_ctrl_send_binary;
@@ -455,16 +877,44 @@ int main(int argc, char *argv[])
         g_callback.connect_report = dp_ctrl_connect_report;
         dpi_setup(&g_callback, &g_config);
 
+        // Before any thread starts, they inherit the cpus and memory policy
+        if (g_dp_instances > 1 && dp_instance_bind() < 0) {
+            return -1;
+        }
+
+        dp_logger_start();
+        dp_reclaim_start();
+
+        // The agent attaches the classifiers to TC-mode port pairs
+        if (dp_offload_init() == 0) {
+            g_callback.flow_offload = dp_flow_offload;
+            g_callback.flow_unload = dp_flow_unload;
+            g_callback.flow_stats = dp_flow_stats;
+        }
+
         g_shm = get_shm(sizeof(dp_mnt_shm_t));
         if (g_shm == NULL) {
             DEBUG_INIT("Unable to get shared memory.\n");
+            dp_reclaim_stop();
+            dp_logger_stop();
             return -1;
         }
+        g_shm->tsc_hz = lat_tsc_hz();
+        dp_ctrl_log_init(true);
+        dp_ctrl_stats_init();
+        dp_snap_init();
+        if (g_resume_sessions) {
+            char name[64];
+
+            dpi_resume_init(dp_instance_name(DPI_RESUME_SHM_NAME, name, sizeof(name)));
+        }
 
         // Start
         int ret = net_run(g_in_iface);
 
+        dp_reclaim_stop();
         munmap(g_shm, sizeof(dp_mnt_shm_t));
+        dp_logger_stop();
 
         return ret;
     }
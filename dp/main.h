@@ -12,16 +12,42 @@
 
 #include "utils/timer_queue.h"
 #include "utils/rcu_map.h"
+#include "utils/seqlock.h"
+#include "utils/lat_hist.h"
+#include "apis.h"
 
 extern int g_running;
 extern int g_stats_slot;
+extern bool g_xdp;
+extern bool g_ring_v3;
+extern bool g_fanout;
+extern bool g_gro;
+extern uint32_t g_ring_mem_limit;
+
+#define DP_SCHED_ADAPTIVE  0
+#define DP_SCHED_POLL      1
+#define DP_SCHED_INTERRUPT 2
+extern int g_sched_policy;
+extern int g_dp_cpus[];
+extern int g_dp_cpu_cnt;
+extern bool g_hugepage;
 extern int g_dp_threads;
+extern int g_dp_active_threads;
+extern int g_dp_fanout_threads;
+extern int g_dp_instance;
+extern int g_dp_instances;
+
+const char *dp_instance_name(const char *name, char *buf, int size);
+bool dp_instance_owns(const char *netns, const char *iface);
 
 typedef struct dp_stats_ {
     uint64_t rx;
     uint64_t rx_drops;
     uint64_t tx_drops;
     uint64_t tx;
+    uint64_t handoff;
+    uint64_t handoff_drops;
+    uint64_t quar_drops;
 } dp_stats_t;
 
 typedef struct conn_stats_ {
@@ -57,7 +83,8 @@ typedef struct dp_ring_ {
     uint32_t batch;
     int (*rx)(struct dp_context_ *ctx, uint32_t tick);
     int (*tx)(struct dp_context_ *ctx, uint8_t *pkt, int len, bool large_frame);
-    void (*stats)(int fd, dp_stats_t *stats);
+    void (*stats)(struct dp_context_ *ctx);
+    struct dp_xsk_ *xsk; // AF_XDP socket, NULL for packet ring
 } dp_ring_t;
 
 typedef struct dp_nfq_ {
@@ -68,10 +95,15 @@ typedef struct dp_nfq_ {
     uint32_t last_tick;
     uint8_t rx_accept;
     uint8_t rx_deny;
+    uint32_t pending_id;        // last packet of the pending verdict batch
+    uint32_t pending_verdict;
+    uint32_t pending_cnt;
     int (*rx)(struct dp_context_ *ctx, uint32_t tick);
     void (*stats)(struct dp_context_ *ctx);
 } dp_nfq_t;
 
+typedef void (*dp_fwd_lat_fct)(const char *iface, const lat_hist_t *h, void *arg);
+
 typedef struct dp_context_ {
     struct cds_hlist_node link;
     timer_node_t free_node;
@@ -85,6 +117,7 @@ typedef struct dp_context_ {
     dp_nfq_t nfq_ctx;
     dp_stats_t stats;
     struct ether_addr ep_mac;
+    io_ep_cache_t ep_cache;
 #define DEFAULT_PENDING_LIMIT 16
     uint8_t tx_pending;
     uint8_t thr_id  :4,
@@ -93,38 +126,187 @@ typedef struct dp_context_ {
     bool tc;
     bool quar;
     bool jumboframe;
+    bool xdp;
+    bool fanout;
     bool nfq;
+    bool proxymesh;
+    bool filtered;                // a socket filter is attached, see dp_ring_filter()
     bool epoll;
     struct dp_context_ *peer_ctx; // for vbr peer is self, for no-tc vin/vex pair with each other.
+    uint32_t rx_pkts;             // received in the current second
+    uint32_t rx_pps;              // received in the last second
+    // After the context moves to another thread, packets of the flows in drain_flows are
+    // handed back to drain_thr, which owns their sessions, until drain_until.
+#define DRAIN_FLOW_BITS 4096
+#define DRAIN_DURATION  60
+    uint8_t *drain_flows;
+    uint32_t drain_until;
+    uint8_t drain_thr;
+    // Ring tuning, see dp_data_tune_rings()
+    char iface[IFACE_NAME_LEN];
+    uint32_t blocks;              // of the ring
+    uint8_t rx_peak;              // quarters of the ring found filled, since the last tune
+    uint8_t tune_idle;            // tunes in a row the ring stayed mostly empty
+    uint64_t tune_drops;          // rx drops at the last tune
+    // Forwarding latency in ns of the timed packets received, see dp_send_packet()
+    uint32_t fwd_lat_skip;        // packets since the last one timed
+    lat_hist_t fwd_lat;
+    uint16_t mtu;                 // of the interface, large frames are segmented to it
 } dp_context_t;
 
+// Quarantined port pair, only multicast and broadcast are forwarded, as in dpi_recv_packet()
+static inline bool dp_rx_quar_drop(dp_context_t *ctx, uint8_t *pkt, int len)
+{
+    if (likely(!ctx->quar) || ctx->tc) {
+        return false;
+    }
+    if (len >= ETH_ALEN && (pkt[0] & 0x01)) {
+        return false;
+    }
+    ctx->stats.quar_drops ++;
+    return true;
+}
+
 typedef struct dp_bld_dlp_context_ {
     struct epoll_event ee;
     int fd;
 } dp_bld_dlp_context_t;
 
+// Single producer/consumer ring to hand packets of a fanout port, or of a migrated context,
+// to the thread owning the flow
+#define HANDOFF_RING_SIZE 256
+#define HANDOFF_FRAME_SIZE 2048
+typedef struct dp_handoff_slot_ {
+    struct dp_context_ *ctx;        // NULL for a fanout port, handled by the inline context
+    uint32_t len;
+    uint8_t pkt[HANDOFF_FRAME_SIZE];
+} dp_handoff_slot_t;
+
+typedef struct dp_handoff_ring_ {
+    uint32_t head __attribute__((aligned(64)));     // written by producer
+    uint32_t signaled;
+    uint32_t tail __attribute__((aligned(64)));     // written by consumer
+    dp_handoff_slot_t slots[HANDOFF_RING_SIZE];
+} dp_handoff_ring_t;
+
+// Multi-producer/single consumer ring of control commands to a dp thread. A producer claims
+// a slot by advancing head, the slot's seq tells the consumer when the command is written.
+#define CTRL_CMD_RING_SIZE 64
+typedef struct dp_ctrl_cmd_slot_ {
+    uint32_t seq;
+    io_ctrl_cmd_t cmd;
+} dp_ctrl_cmd_slot_t;
+
+typedef struct dp_ctrl_cmd_ring_ {
+    uint32_t head __attribute__((aligned(64)));     // claimed by producers
+    uint32_t tail __attribute__((aligned(64)));     // written by consumer
+    dp_ctrl_cmd_slot_t slots[CTRL_CMD_RING_SIZE];
+} dp_ctrl_cmd_ring_t;
+
+// Connection report of a session, see dp_ctrl_connect_report()
+typedef struct dp_conn_log_ {
+    uint8_t ep_mac[6];
+    uint16_t ether_type;
+    uint8_t client_ip[16];
+    uint8_t server_ip[16];
+    uint16_t client_port;
+    uint16_t server_port;
+    uint16_t application;
+    uint16_t flags;                             // DPSESS_FLAG_xxx
+    uint8_t ipproto;
+    uint8_t policy_action;
+    uint8_t severity;
+    uint8_t sessions;
+    uint8_t violates;
+    bool has_metric;
+    uint32_t client_bytes;
+    uint32_t bytes;
+    uint32_t last_seen;
+    uint32_t policy_id;
+    uint32_t threat_id;
+    DPMonitorMetric metric;
+} dp_conn_log_t;
+
+// Single producer/single consumer ring of the connection reports of a dp thread. The dp
+// thread adds the reports of a batch after head and publishes them at the end of the rx
+// batch or timer roll; the report thread aggregates them into the connect entries.
+#define CONN_LOG_RING_SIZE 4096
+typedef struct dp_conn_log_ring_ {
+    uint32_t head __attribute__((aligned(64)));     // written by producer
+    uint32_t pending;                               // added after head, not published yet
+    uint32_t signaled;
+    uint32_t drops;
+    uint32_t tail __attribute__((aligned(64)));     // written by consumer
+    dp_conn_log_t logs[CONN_LOG_RING_SIZE];
+} dp_conn_log_ring_t;
+
+// Each thread's data starts on its own cacheline. The first part is only touched by the
+// owning dp thread; the fields from ctx_list on are shared with the ctrl and other dp
+// threads, and counters they read are published in the seqlock protected snapshot.
+// Load of the current overload window, see dp_check_overload()
+typedef struct dp_overload_ {
+    uint64_t window_start;
+    uint64_t busy_ns;
+    uint32_t polls;
+    uint32_t full;                              // rx returned a full batch
+    uint32_t backlog;                           // and the ring was half filled ahead of it
+    uint32_t slow;                              // batches that took too long
+    uint64_t behind_at;                         // end of the last window behind
+    uint16_t behind;                            // windows in a row behind
+    bool on;
+} dp_overload_t;
+
 typedef struct dp_thread_data_ {
     int epoll_fd;
-    struct cds_hlist_head ctx_list;
-    struct cds_hlist_head notc_nfq_ctx_list;
     timer_queue_t ctx_free_list;
     struct dp_context_ *ctx_inline;
+    void *nfq_rcv_buf;                          // recvmmsg buffers of nfq contexts
+    uint8_t sched_mode;                         // DP_SCHED_MODE_xxx
+    uint32_t sched_idle;                        // empty polls since last packet
+    uint32_t sched_pkts;
+    uint32_t sched_pps;
+    uint64_t handoff_pkts;
+    uint64_t handoff_drops;
+    uint64_t busy_ns;                           // not waiting in epoll, since last second
+    dp_overload_t overload;
+#define MAX_TSO_SIZE 65536
+    uint8_t tso_packet[MAX_TSO_SIZE];           // large frame not fit in the ring
+
+    struct cds_hlist_head ctx_list __attribute__((aligned(64)));
+    struct cds_hlist_head notc_nfq_ctx_list;
     pthread_mutex_t ctrl_dp_lock;
     int ctrl_req_evfd;
-    uint32_t ctrl_req;
-#define MAX_LOG_ENTRIES 128
-#define LOG_ENTRY_SIZE (sizeof(DPMsgHdr) + sizeof(DPMsgThreatLog))
-    uint32_t log_writer;
-    uint32_t log_reader;
-    uint8_t log_ring[MAX_LOG_ENTRIES][LOG_ENTRY_SIZE];
-    rcu_map_t conn4_map[2];
-    uint32_t conn4_map_cnt[2];
-    dp_rate_limter_t conn4_rl;
+    int handoff_evfd;
+    int cpu;                                    // pinned cpu, -1 if not pinned
+    int numa_node;                              // node of the pinned cpu, -1 if unknown
+    int tlb_fd;                                 // dTLB miss perf counter, -1 if unavailable
+    dp_handoff_ring_t *handoff[MAX_DP_THREADS]; // indexed by source thread
+    dp_ctrl_cmd_ring_t ctrl_cmds;
+    dp_conn_log_ring_t *conn_logs;
+    rcu_map_t conn4_map;                        // only touched by the report thread
+    uint32_t conn4_map_cnt;
+    rcu_map_t conn6_map;
+    uint32_t conn6_map_cnt;
+    dp_rate_limter_t conn_rl;
 #define CONNECT_RL_DUR  2
 #define CONNECT_RL_CNT  800
-    uint32_t conn4_map_cur;
-} dp_thread_data_t;
+    bool ready;                                 // initialized, can take commands
+    uint32_t overloaded;                        // in the overload mode
+    uint32_t overload_enters;
+    uint32_t overload_since;                    // g_seconds when the mode was entered
+    uint32_t overload_seconds;                  // how long the last one lasted
+
+    seqlock_t snap_lock __attribute__((aligned(64)));
+    uint64_t handoff_pkts_snap;
+    uint64_t handoff_drops_snap;
+    uint32_t load_snap;                         // busy time of the last second, in permille
+} __attribute__((aligned(64))) dp_thread_data_t;
 
 extern dp_thread_data_t g_dp_thread_data[MAX_DP_THREADS];
 
+// Records of the config journal, see snapshot.c
+#define DP_SNAP_JSON 1
+#define DP_SNAP_BIN  2
+typedef int (*dp_snap_apply_fct)(int type, uint8_t *data, uint32_t len);
+
 #endif
@@ -4,6 +4,8 @@
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
 
 #include <netinet/in.h>
 #include <linux/types.h>
@@ -21,8 +23,55 @@
 #define NFQ_PKT_SIZE_JUMBO (1024 * 10)
 #define NFQ_PKT_SIZE (1024 * 2)
 #define MAX_NFQ_BUF_SIZE 65536
-static uint8_t g_nfq_rx_buf[MAX_NFQ_BUF_SIZE];
-static uint8_t g_rcv_packet[MAX_NFQ_BUF_SIZE];
+#define NFQ_RECV_BATCH 16
+
+#define th_nfq_rcv_buf(thr_id) (g_dp_thread_data[thr_id].nfq_rcv_buf)
+
+// sys/socket.h is included ahead of _GNU_SOURCE by base.h, so recvmmsg() is not declared.
+struct dp_mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
+static inline int dp_recvmmsg(int fd, struct dp_mmsghdr *msgs, unsigned int vlen, int flags)
+{
+    return syscall(__NR_recvmmsg, fd, msgs, vlen, flags, NULL);
+}
+
+// Packet ids of a queue increase, one batch verdict covers all pending packets up to the id.
+static void dp_nfq_flush_verdict(dp_nfq_t *nfq_ctx)
+{
+    if (nfq_ctx->pending_cnt == 0) {
+        return;
+    }
+
+    nfq_set_verdict_batch(nfq_ctx->nfq_q_hdl, nfq_ctx->pending_id, nfq_ctx->pending_verdict);
+    nfq_ctx->pending_cnt = 0;
+}
+
+static inline void dp_nfq_set_verdict(dp_nfq_t *nfq_ctx, uint32_t id, uint32_t verdict)
+{
+    if (nfq_ctx->pending_cnt > 0 && nfq_ctx->pending_verdict != verdict) {
+        dp_nfq_flush_verdict(nfq_ctx);
+    }
+    nfq_ctx->pending_id = id;
+    nfq_ctx->pending_verdict = verdict;
+    nfq_ctx->pending_cnt ++;
+}
+
+// Bits of the packet mark the agent's rules act on, see nfqBypassRules() in agent/pipe/port.go.
+// A marked verdict repeats the hook so that the rules save the mark to the connection, or clear it.
+#define DP_NFQ_MARK_MASK        0x30000000
+#define DP_NFQ_MARK_BYPASS      0x10000000  // skip the queue, on the samples of a marked connection
+#define DP_NFQ_MARK_UNMARK      0x20000000
+#define DP_NFQ_MARK_UNMARK_DROP 0x30000000
+
+static void dp_nfq_set_verdict_mark(dp_nfq_t *nfq_ctx, uint32_t id, uint32_t nfmark, uint32_t mark)
+{
+    // the batch is for lower ids, a verdict with a mark can't be batched
+    dp_nfq_flush_verdict(nfq_ctx);
+    nfq_set_verdict2(nfq_ctx->nfq_q_hdl, id, NF_REPEAT, (nfmark & ~DP_NFQ_MARK_MASK) | mark, 0, NULL);
+}
 
 static int dp_nfq_rx_cb(struct nfq_q_handle *qh, struct nfgenmsg *nfmsg,
                        struct nfq_data *nfa, void *data)
@@ -38,20 +87,16 @@ static int dp_nfq_rx_cb(struct nfq_q_handle *qh, struct nfgenmsg *nfmsg,
     struct ethhdr *nfq_eth;
 
     context.dp_ctx = ctx;
+    context.ep_cache = &ctx->ep_cache;
     context.tick = ctx->nfq_ctx.last_tick;
     context.stats_slot = g_stats_slot;
     context.tap = ctx->tap;
     context.tc = ctx->tc;
     context.nfq = true;
+    context.rx_ns = 0;
+    context.nfq_mark = (nfq_get_nfmark(nfa) & DP_NFQ_MARK_MASK) == DP_NFQ_MARK_BYPASS;
+    context.proxymesh = false;
     mac_cpy(context.ep_mac.ether_addr_octet, ctx->ep_mac.ether_addr_octet);
-    
-    dpi_rcv_pkt_ptr = g_nfq_rx_buf;
-
-    //set up ether header
-    nfq_eth = (struct ethhdr *)dpi_rcv_pkt_ptr;
-    memset(nfq_eth->h_dest, 0, ETHER_ADDR_LEN);
-    memset(nfq_eth->h_source, 0, ETHER_ADDR_LEN);
-    nfq_eth->h_proto = htons(ETH_P_IP);
 
 	ph = nfq_get_msg_packet_hdr(nfa);
 	if (ph) {
@@ -61,14 +106,37 @@ static int dp_nfq_rx_cb(struct nfq_q_handle *qh, struct nfgenmsg *nfmsg,
 	ret = nfq_get_payload(nfa, &payload_data);
 	if (ret >= 0) {
         int total_len = ret + sizeof(struct ethhdr);
-        memcpy(&dpi_rcv_pkt_ptr[sizeof(struct ethhdr)], payload_data, ret);
+
+        // The payload attribute always follows the message and packet headers, all parsed
+        // already, so the ether header is built in place instead of copying the payload.
+        dpi_rcv_pkt_ptr = payload_data - sizeof(struct ethhdr);
+        nfq_eth = (struct ethhdr *)dpi_rcv_pkt_ptr;
+        memset(nfq_eth->h_dest, 0, ETHER_ADDR_LEN);
+        memset(nfq_eth->h_source, 0, ETHER_ADDR_LEN);
+        nfq_eth->h_proto = htons(ETH_P_IP);
+
         verdict = dpi_recv_packet(&context, dpi_rcv_pkt_ptr, total_len);
-        if (verdict == 1) {//drop
-            nfq_set_verdict(ctx->nfq_ctx.nfq_q_hdl, id, NF_DROP, 0, NULL);
+        switch (verdict) {
+        case DPI_VERDICT_DROP:
+            dp_nfq_set_verdict(&ctx->nfq_ctx, id, NF_DROP);
             ctx->nfq_ctx.rx_deny++;
-        } else {//accept
-            nfq_set_verdict(ctx->nfq_ctx.nfq_q_hdl, id, NF_ACCEPT, 0, NULL);
+            break;
+        case DPI_VERDICT_MARK:
+            dp_nfq_set_verdict_mark(&ctx->nfq_ctx, id, nfq_get_nfmark(nfa), DP_NFQ_MARK_BYPASS);
+            ctx->nfq_ctx.rx_accept++;
+            break;
+        case DPI_VERDICT_UNMARK:
+            dp_nfq_set_verdict_mark(&ctx->nfq_ctx, id, nfq_get_nfmark(nfa), DP_NFQ_MARK_UNMARK);
             ctx->nfq_ctx.rx_accept++;
+            break;
+        case DPI_VERDICT_UNMARK_DROP:
+            dp_nfq_set_verdict_mark(&ctx->nfq_ctx, id, nfq_get_nfmark(nfa), DP_NFQ_MARK_UNMARK_DROP);
+            ctx->nfq_ctx.rx_deny++;
+            break;
+        default:
+            dp_nfq_set_verdict(&ctx->nfq_ctx, id, NF_ACCEPT);
+            ctx->nfq_ctx.rx_accept++;
+            break;
         }
     }
 
@@ -77,24 +145,49 @@ static int dp_nfq_rx_cb(struct nfq_q_handle *qh, struct nfgenmsg *nfmsg,
 
 static int dp_rx_nfq(dp_context_t *ctx, uint32_t tick)
 {
-	int len;
-    uint8_t *rcv_pkt_ptr;
+    struct dp_mmsghdr msgs[NFQ_RECV_BATCH];
+    struct iovec iovs[NFQ_RECV_BATCH];
     dp_nfq_t *nfq_ctx = &ctx->nfq_ctx;
+    uint8_t (*bufs)[MAX_NFQ_BUF_SIZE];
     uint32_t count = 0;
+    int i, n;
+
     nfq_ctx->last_tick = tick;
-    size_t rcv_size = MAX_NFQ_BUF_SIZE;
-    int flag = MSG_DONTWAIT;
+
+    bufs = th_nfq_rcv_buf(ctx->thr_id);
+    if (unlikely(bufs == NULL)) {
+        bufs = malloc(NFQ_RECV_BATCH * MAX_NFQ_BUF_SIZE);
+        if (bufs == NULL) {
+            return DP_RX_DONE;
+        }
+        th_nfq_rcv_buf(ctx->thr_id) = bufs;
+    }
+
+    for (i = 0; i < NFQ_RECV_BATCH; i ++) {
+        iovs[i].iov_base = bufs[i];
+        iovs[i].iov_len = MAX_NFQ_BUF_SIZE;
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
 
     while (count < nfq_ctx->batch) {
-        rcv_pkt_ptr = g_rcv_packet;
-        count ++;
-        if ((len = recv(ctx->fd, rcv_pkt_ptr, rcv_size, flag)) > 0) {
-            if (ctx->nfq_ctx.nfq_q_hdl != NULL) {
-                nfq_handle_packet(ctx->nfq_ctx.nfq_hdl, (char *)rcv_pkt_ptr, len);
+        n = dp_recvmmsg(ctx->fd, msgs, min(NFQ_RECV_BATCH, nfq_ctx->batch - count), MSG_DONTWAIT);
+        if (n <= 0) {
+            break;
+        }
+
+        if (ctx->nfq_ctx.nfq_q_hdl != NULL) {
+            for (i = 0; i < n; i ++) {
+                nfq_handle_packet(ctx->nfq_ctx.nfq_hdl, (char *)bufs[i], msgs[i].msg_len);
             }
         }
+        count += n;
     }
-    return DP_RX_MORE;
+
+    dp_nfq_flush_verdict(nfq_ctx);
+
+    return count < nfq_ctx->batch ? count : DP_RX_MORE;
 }
 
 
@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mount.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <netinet/in.h>
+#include <net/ethernet.h>
+#include <arpa/inet.h>
+
+#include "main.h"
+#include "apis.h"
+#include "debug.h"
+#include "utils/helper.h"
+
+//
+// Kernel offload of allowed flows of TC-mode endpoints. The dp creates a hash map of flow
+// keys and two tc classifiers and pins them to bpffs, the agent attaches the classifiers in
+// front of its mirred filters. A packet whose flow is in the map is counted and redirected to
+// the peer port of the pair, so it never reaches the dp. The classifier on the external port
+// takes the endpoint mac from the destination, the one on the internal port from the source.
+//
+// TCP SYN, FIN and RST, fragments and ip options always go to the dp.
+//
+
+#define OFFLOAD_BPF_FS          "/sys/fs/bpf"
+#define OFFLOAD_MAP_PIN         OFFLOAD_BPF_FS "/nv_flow_map"
+#define OFFLOAD_EX_PROG_PIN     OFFLOAD_BPF_FS "/nv_flow_ex"
+#define OFFLOAD_IN_PROG_PIN     OFFLOAD_BPF_FS "/nv_flow_in"
+#define OFFLOAD_MAP_ENTRIES     (64 * 1024)
+
+#ifndef BPF_FS_MAGIC
+#define BPF_FS_MAGIC 0xcafe4a11
+#endif
+
+static int g_offload_map_fd = -1;
+
+static int offload_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static int offload_obj_get(const char *path)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.pathname = (uint64_t)(unsigned long)path;
+    return offload_bpf(BPF_OBJ_GET, &attr);
+}
+
+static int offload_obj_pin(int fd, const char *path)
+{
+    union bpf_attr attr;
+
+    unlink(path);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.bpf_fd = fd;
+    attr.pathname = (uint64_t)(unsigned long)path;
+    return offload_bpf(BPF_OBJ_PIN, &attr);
+}
+
+static bool offload_map_compatible(int fd)
+{
+    struct bpf_map_info info;
+    union bpf_attr attr;
+
+    memset(&info, 0, sizeof(info));
+    memset(&attr, 0, sizeof(attr));
+    attr.info.bpf_fd = fd;
+    attr.info.info_len = sizeof(info);
+    attr.info.info = (uint64_t)(unsigned long)&info;
+    if (offload_bpf(BPF_OBJ_GET_INFO_BY_FD, &attr) < 0) {
+        return false;
+    }
+    return info.type == BPF_MAP_TYPE_HASH &&
+           info.key_size == sizeof(io_flow_key_t) && info.value_size == sizeof(io_flow_stats_t);
+}
+
+static int offload_create_map(void)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_HASH;
+    attr.key_size = sizeof(io_flow_key_t);
+    attr.value_size = sizeof(io_flow_stats_t);
+    attr.max_entries = OFFLOAD_MAP_ENTRIES;
+    return offload_bpf(BPF_MAP_CREATE, &attr);
+}
+
+// Entries left by an earlier dp would bypass flows no thread knows of
+static void offload_flush_map(int map_fd)
+{
+    io_flow_key_t key;
+    union bpf_attr attr;
+    int cnt = 0;
+
+    for (;;) {
+        memset(&attr, 0, sizeof(attr));
+        attr.map_fd = map_fd;
+        attr.key = 0;
+        attr.next_key = (uint64_t)(unsigned long)&key;
+        if (offload_bpf(BPF_MAP_GET_NEXT_KEY, &attr) < 0) {
+            break;
+        }
+
+        memset(&attr, 0, sizeof(attr));
+        attr.map_fd = map_fd;
+        attr.key = (uint64_t)(unsigned long)&key;
+        if (offload_bpf(BPF_MAP_DELETE_ELEM, &attr) < 0) {
+            break;
+        }
+        cnt ++;
+    }
+
+    if (cnt > 0) {
+        DEBUG_INIT("flushed %d stale entries\n", cnt);
+    }
+}
+
+#define OFFLOAD_ETH_LEN     14
+#define OFFLOAD_IP_OFF      OFFLOAD_ETH_LEN
+#define OFFLOAD_L4_OFF      (OFFLOAD_ETH_LEN + 20)
+#define OFFLOAD_KEY_OFF     (-24)   // key on the stack
+#define OFFLOAD_KEY(f)      (OFFLOAD_KEY_OFF + (int)offsetof(io_flow_key_t, f))
+
+// Labels of the classifier
+#define L_KEY   22
+#define L_MISS  48
+
+#define JMP_K(op, reg, k, pc, label) \
+    { .code = BPF_JMP | op | BPF_K, .dst_reg = reg, .imm = k, .off = (label) - (pc) - 1 }
+#define JMP_X(op, dst, src, pc, label) \
+    { .code = BPF_JMP | op | BPF_X, .dst_reg = dst, .src_reg = src, .off = (label) - (pc) - 1 }
+#define LDX(size, dst, src, o) \
+    { .code = BPF_LDX | size | BPF_MEM, .dst_reg = dst, .src_reg = src, .off = o }
+#define STX(size, dst, src, o) \
+    { .code = BPF_STX | size | BPF_MEM, .dst_reg = dst, .src_reg = src, .off = o }
+#define ALU_K(op, dst, k) \
+    { .code = BPF_ALU64 | op | BPF_K, .dst_reg = dst, .imm = k }
+
+// mac_off is 0 to key on the destination mac, ETH_ALEN on the source mac.
+//
+//   if (ipv4 without options, not a fragment, udp or tcp without SYN/FIN/RST) {
+//       key = {mac, proto, saddr, daddr, sport, dport};
+//       if ((v = bpf_map_lookup_elem(&map, &key)) != NULL) {
+//           v->pkts += 1; v->bytes += skb->len;
+//           return -1;       // match, run the redirect action
+//       }
+//   }
+//   return 0;
+static int offload_load_prog(int map_fd, int mac_off)
+{
+    struct bpf_insn insns[] = {
+        /*  0 */ { .code = BPF_ALU64 | BPF_MOV | BPF_X, .dst_reg = BPF_REG_6, .src_reg = BPF_REG_1 },
+        /*  1 */ LDX(BPF_W, BPF_REG_2, BPF_REG_1, offsetof(struct __sk_buff, data)),
+        /*  2 */ LDX(BPF_W, BPF_REG_3, BPF_REG_1, offsetof(struct __sk_buff, data_end)),
+        /*  3 */ { .code = BPF_ALU64 | BPF_MOV | BPF_X, .dst_reg = BPF_REG_4, .src_reg = BPF_REG_2 },
+        /*  4 */ ALU_K(BPF_ADD, BPF_REG_4, OFFLOAD_L4_OFF + 4),
+        /*  5 */ JMP_X(BPF_JGT, BPF_REG_4, BPF_REG_3, 5, L_MISS),
+        /*  6 */ LDX(BPF_H, BPF_REG_5, BPF_REG_2, 12),
+        /*  7 */ JMP_K(BPF_JNE, BPF_REG_5, htons(ETH_P_IP), 7, L_MISS),
+        /*  8 */ LDX(BPF_B, BPF_REG_5, BPF_REG_2, OFFLOAD_IP_OFF),
+        /*  9 */ JMP_K(BPF_JNE, BPF_REG_5, 0x45, 9, L_MISS),
+        /* 10 */ LDX(BPF_H, BPF_REG_5, BPF_REG_2, OFFLOAD_IP_OFF + 6),
+        /* 11 */ ALU_K(BPF_AND, BPF_REG_5, htons(0x3fff)),
+        /* 12 */ JMP_K(BPF_JNE, BPF_REG_5, 0, 12, L_MISS),
+        /* 13 */ LDX(BPF_B, BPF_REG_7, BPF_REG_2, OFFLOAD_IP_OFF + 9),
+        /* 14 */ JMP_K(BPF_JEQ, BPF_REG_7, IPPROTO_UDP, 14, L_KEY),
+        /* 15 */ JMP_K(BPF_JNE, BPF_REG_7, IPPROTO_TCP, 15, L_MISS),
+        /* 16 */ { .code = BPF_ALU64 | BPF_MOV | BPF_X, .dst_reg = BPF_REG_4, .src_reg = BPF_REG_2 },
+        /* 17 */ ALU_K(BPF_ADD, BPF_REG_4, OFFLOAD_L4_OFF + 20),
+        /* 18 */ JMP_X(BPF_JGT, BPF_REG_4, BPF_REG_3, 18, L_MISS),
+        /* 19 */ LDX(BPF_B, BPF_REG_5, BPF_REG_2, OFFLOAD_L4_OFF + 13),
+        /* 20 */ ALU_K(BPF_AND, BPF_REG_5, 0x07),
+        /* 21 */ JMP_K(BPF_JNE, BPF_REG_5, 0, 21, L_MISS),
+        // L_KEY
+        /* 22 */ LDX(BPF_H, BPF_REG_5, BPF_REG_2, mac_off),
+        /* 23 */ STX(BPF_H, BPF_REG_10, BPF_REG_5, OFFLOAD_KEY_OFF),
+        /* 24 */ LDX(BPF_H, BPF_REG_5, BPF_REG_2, mac_off + 2),
+        /* 25 */ STX(BPF_H, BPF_REG_10, BPF_REG_5, OFFLOAD_KEY_OFF + 2),
+        /* 26 */ LDX(BPF_H, BPF_REG_5, BPF_REG_2, mac_off + 4),
+        /* 27 */ STX(BPF_H, BPF_REG_10, BPF_REG_5, OFFLOAD_KEY_OFF + 4),
+        /* 28 */ STX(BPF_B, BPF_REG_10, BPF_REG_7, OFFLOAD_KEY(proto)),
+        /* 29 */ { .code = BPF_ST | BPF_B | BPF_MEM, .dst_reg = BPF_REG_10,
+                   .off = OFFLOAD_KEY(pad), .imm = 0 },
+        /* 30 */ LDX(BPF_W, BPF_REG_5, BPF_REG_2, OFFLOAD_IP_OFF + 12),
+        /* 31 */ STX(BPF_W, BPF_REG_10, BPF_REG_5, OFFLOAD_KEY(sip)),
+        /* 32 */ LDX(BPF_W, BPF_REG_5, BPF_REG_2, OFFLOAD_IP_OFF + 16),
+        /* 33 */ STX(BPF_W, BPF_REG_10, BPF_REG_5, OFFLOAD_KEY(dip)),
+        /* 34 */ LDX(BPF_W, BPF_REG_5, BPF_REG_2, OFFLOAD_L4_OFF),
+        /* 35 */ STX(BPF_W, BPF_REG_10, BPF_REG_5, OFFLOAD_KEY(sport)),
+        /* 36 */ { .code = BPF_LD | BPF_DW | BPF_IMM, .dst_reg = BPF_REG_1, .src_reg = BPF_PSEUDO_MAP_FD,
+                   .imm = map_fd },
+        /* 37 */ { .code = 0 },
+        /* 38 */ { .code = BPF_ALU64 | BPF_MOV | BPF_X, .dst_reg = BPF_REG_2, .src_reg = BPF_REG_10 },
+        /* 39 */ ALU_K(BPF_ADD, BPF_REG_2, OFFLOAD_KEY_OFF),
+        /* 40 */ { .code = BPF_JMP | BPF_CALL, .imm = BPF_FUNC_map_lookup_elem },
+        /* 41 */ JMP_K(BPF_JEQ, BPF_REG_0, 0, 41, L_MISS),
+        /* 42 */ ALU_K(BPF_MOV, BPF_REG_1, 1),
+        /* 43 */ { .code = BPF_STX | BPF_DW | BPF_XADD, .dst_reg = BPF_REG_0, .src_reg = BPF_REG_1,
+                   .off = offsetof(io_flow_stats_t, pkts) },
+        /* 44 */ LDX(BPF_W, BPF_REG_1, BPF_REG_6, offsetof(struct __sk_buff, len)),
+        /* 45 */ { .code = BPF_STX | BPF_DW | BPF_XADD, .dst_reg = BPF_REG_0, .src_reg = BPF_REG_1,
+                   .off = offsetof(io_flow_stats_t, bytes) },
+        /* 46 */ ALU_K(BPF_MOV, BPF_REG_0, -1),
+        /* 47 */ { .code = BPF_JMP | BPF_EXIT },
+        // L_MISS
+        /* 48 */ ALU_K(BPF_MOV, BPF_REG_0, 0),
+        /* 49 */ { .code = BPF_JMP | BPF_EXIT },
+    };
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_SCHED_CLS;
+    attr.insns = (uint64_t)(unsigned long)insns;
+    attr.insn_cnt = ARRAY_ENTRIES(insns);
+    attr.license = (uint64_t)(unsigned long)"GPL";
+    return offload_bpf(BPF_PROG_LOAD, &attr);
+}
+
+static int offload_mount_bpf_fs(void)
+{
+    struct statfs st;
+
+    if (statfs(OFFLOAD_BPF_FS, &st) == 0 && st.f_type == BPF_FS_MAGIC) {
+        return 0;
+    }
+    return mount("bpf", OFFLOAD_BPF_FS, "bpf", 0, NULL);
+}
+
+// Reuse a compatible map pinned by an earlier dp, the classifiers the agent attached keep
+// working across a dp restart.
+int dp_offload_init(void)
+{
+    int map_fd, ex_fd, in_fd;
+
+    if (offload_mount_bpf_fs() < 0) {
+        DEBUG_INIT("no bpf fs, error=%s\n", strerror(errno));
+        return -1;
+    }
+
+    map_fd = offload_obj_get(OFFLOAD_MAP_PIN);
+    if (map_fd >= 0 && !offload_map_compatible(map_fd)) {
+        close(map_fd);
+        map_fd = -1;
+    }
+    if (map_fd >= 0) {
+        ex_fd = offload_obj_get(OFFLOAD_EX_PROG_PIN);
+        in_fd = offload_obj_get(OFFLOAD_IN_PROG_PIN);
+        if (ex_fd >= 0 && in_fd >= 0) {
+            offload_flush_map(map_fd);
+            close(ex_fd);
+            close(in_fd);
+            g_offload_map_fd = map_fd;
+            return 0;
+        }
+        if (ex_fd >= 0) close(ex_fd);
+        if (in_fd >= 0) close(in_fd);
+        offload_flush_map(map_fd);
+    } else {
+        map_fd = offload_create_map();
+        if (map_fd < 0) {
+            DEBUG_INIT("fail to create map, error=%s\n", strerror(errno));
+            return -1;
+        }
+    }
+
+    ex_fd = offload_load_prog(map_fd, 0);
+    in_fd = offload_load_prog(map_fd, ETH_ALEN);
+    if (ex_fd < 0 || in_fd < 0) {
+        DEBUG_INIT("fail to load classifier, error=%s\n", strerror(errno));
+        goto error;
+    }
+    if (offload_obj_pin(map_fd, OFFLOAD_MAP_PIN) < 0 ||
+        offload_obj_pin(ex_fd, OFFLOAD_EX_PROG_PIN) < 0 ||
+        offload_obj_pin(in_fd, OFFLOAD_IN_PROG_PIN) < 0) {
+        DEBUG_INIT("fail to pin, error=%s\n", strerror(errno));
+        unlink(OFFLOAD_MAP_PIN);
+        unlink(OFFLOAD_EX_PROG_PIN);
+        unlink(OFFLOAD_IN_PROG_PIN);
+        goto error;
+    }
+
+    // The pins hold the references
+    close(ex_fd);
+    close(in_fd);
+    g_offload_map_fd = map_fd;
+    DEBUG_INIT("flow offload map=%s\n", OFFLOAD_MAP_PIN);
+    return 0;
+
+error:
+    if (ex_fd >= 0) close(ex_fd);
+    if (in_fd >= 0) close(in_fd);
+    close(map_fd);
+    return -1;
+}
+
+// The functions below are called by dp threads, the bpf syscalls take care of locking.
+
+int dp_flow_offload(const io_flow_key_t *key)
+{
+    io_flow_stats_t zero = {0};
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = g_offload_map_fd;
+    attr.key = (uint64_t)(unsigned long)key;
+    attr.value = (uint64_t)(unsigned long)&zero;
+    attr.flags = BPF_ANY;
+    return offload_bpf(BPF_MAP_UPDATE_ELEM, &attr);
+}
+
+int dp_flow_stats(const io_flow_key_t *key, io_flow_stats_t *stats)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = g_offload_map_fd;
+    attr.key = (uint64_t)(unsigned long)key;
+    attr.value = (uint64_t)(unsigned long)stats;
+    return offload_bpf(BPF_MAP_LOOKUP_ELEM, &attr);
+}
+
+// Counts of packets forwarded between the lookup and the delete are lost
+int dp_flow_unload(const io_flow_key_t *key, io_flow_stats_t *stats)
+{
+    union bpf_attr attr;
+    int ret;
+
+    ret = dp_flow_stats(key, stats);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = g_offload_map_fd;
+    attr.key = (uint64_t)(unsigned long)key;
+    offload_bpf(BPF_MAP_DELETE_ELEM, &attr);
+    return ret;
+}
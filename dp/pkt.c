@@ -13,6 +13,11 @@
 #include <time.h>
 #include <sys/types.h>
 #include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <linux/if_ether.h>
 
 #include "urcu.h"
 #include "urcu/rcuhlist.h"
@@ -21,8 +26,18 @@
 #include "apis.h"
 #include "debug.h"
 #include "utils/helper.h"
+#include "utils/bits.h"
+#include "utils/mem_acct.h"
 
 extern dp_mnt_shm_t *g_shm;
+extern DPStatsShmHdr *g_stats_shm;
+extern void dp_ctrl_publish_stats(int thr_id, const dp_stats_t *ring, uint32_t load);
+extern void dp_ctrl_connect_flush(void);
+extern int dp_arena_thread_init(int thr_id);
+extern int dp_huge_tlb_open(void);
+extern int dp_start_data_thread(int thr_id);
+extern bool cmp_mac_prefix(void *m1, void *prefix);
+extern rcu_map_t g_ep_map;
 
 #define INLINE_BLOCK 2048
 #define INLINE_BATCH 4096
@@ -38,6 +53,7 @@ extern dp_mnt_shm_t *g_shm;
 #define RELEASED_CTX_TIMEOUT 5      // 10 second
 #define RELEASED_CTX_PRUNE_FREQ 5   // 10 second
 #define DP_STATS_FREQ 60            // 1 minute
+#define HOUSEKEEPING_SPREAD 800000000   // ns, offsets of the threads' housekeeping in a second
 
 #define MAX_EPOLL_EVENTS 128
 
@@ -50,18 +66,45 @@ dp_thread_data_t g_dp_thread_data[MAX_DP_THREADS];
 #define th_ctx_inline(thr_id)        (g_dp_thread_data[thr_id].ctx_inline)
 #define th_ctrl_dp_lock(thr_id)      (g_dp_thread_data[thr_id].ctrl_dp_lock)
 #define th_ctrl_req_evfd(thr_id)     (g_dp_thread_data[thr_id].ctrl_req_evfd)
-#define th_ctrl_req(thr_id)          (g_dp_thread_data[thr_id].ctrl_req)
+#define th_ctrl_cmds(thr_id)         (g_dp_thread_data[thr_id].ctrl_cmds)
+#define th_handoff(thr_id)           (g_dp_thread_data[thr_id].handoff)
+#define th_handoff_evfd(thr_id)      (g_dp_thread_data[thr_id].handoff_evfd)
+#define th_handoff_pkts(thr_id)      (g_dp_thread_data[thr_id].handoff_pkts)
+#define th_handoff_drops(thr_id)     (g_dp_thread_data[thr_id].handoff_drops)
+#define th_snap_lock(thr_id)         (g_dp_thread_data[thr_id].snap_lock)
+#define th_handoff_pkts_snap(thr_id) (g_dp_thread_data[thr_id].handoff_pkts_snap)
+#define th_handoff_drops_snap(thr_id) (g_dp_thread_data[thr_id].handoff_drops_snap)
+#define th_sched_mode(thr_id)        (g_dp_thread_data[thr_id].sched_mode)
+#define th_sched_idle(thr_id)        (g_dp_thread_data[thr_id].sched_idle)
+#define th_sched_pkts(thr_id)        (g_dp_thread_data[thr_id].sched_pkts)
+#define th_sched_pps(thr_id)         (g_dp_thread_data[thr_id].sched_pps)
+#define th_cpu(thr_id)               (g_dp_thread_data[thr_id].cpu)
+#define th_numa_node(thr_id)         (g_dp_thread_data[thr_id].numa_node)
+#define th_tlb_fd(thr_id)            (g_dp_thread_data[thr_id].tlb_fd)
+#define th_busy_ns(thr_id)           (g_dp_thread_data[thr_id].busy_ns)
+#define th_ready(thr_id)             (g_dp_thread_data[thr_id].ready)
+#define th_load_snap(thr_id)         (g_dp_thread_data[thr_id].load_snap)
+#define th_overload(thr_id)          (g_dp_thread_data[thr_id].overload)
+#define th_overloaded(thr_id)        (g_dp_thread_data[thr_id].overloaded)
+#define th_overload_enters(thr_id)   (g_dp_thread_data[thr_id].overload_enters)
+#define th_overload_since(thr_id)    (g_dp_thread_data[thr_id].overload_since)
+#define th_overload_seconds(thr_id)  (g_dp_thread_data[thr_id].overload_seconds)
 
 int bld_dlp_epoll_fd;
 int bld_dlp_ctrl_req_evfd;
-uint32_t bld_dlp_ctrl_req;
 
 static uint32_t g_seconds;
 static time_t g_start_time;
 
-int dp_open_socket(dp_context_t *ctx, const char *iface, bool tap, bool tc, uint blocks, uint batch);
+int dp_open_socket(dp_context_t *ctx, const char *iface, bool tap, bool jumboframe, dp_context_t *umem_ctx, uint blocks, uint batch);
 void dp_close_socket(dp_context_t *ctx);
+int dp_ring_fanout(dp_context_t *ctx, const char *iface);
+int dp_ring_filter(dp_context_t *ctx, bool ep_known);
 int dp_rx(dp_context_t *ctx, uint32_t tick);
+uint32_t dp_rx_backlog(dp_context_t *ctx);
+int dp_ring_block(dp_context_t *ctx);
+void dp_ring_swap(dp_context_t *ctx, dp_context_t *nc, bool ep_known, uint32_t tick);
+uint32_t dp_rx_handoff(dp_context_t *ctx, dp_handoff_ring_t *r, uint32_t tick);
 void dp_get_stats(dp_context_t *ctx);
 int dp_open_nfq_handle(dp_context_t *ctx, int qnum, bool jumboframe, uint blocks, uint batch);
 
@@ -70,6 +113,174 @@ dp_context_t *dp_inline_context()
     return th_ctx_inline(THREAD_ID);
 }
 
+// -- flow handoff
+
+// Same hash as the fanout filter in ring.c: xor of addresses and ports is symmetric, so
+// both directions of a session map to the same thread.
+static uint32_t dp_flow_hash_sym(uint8_t *pkt, int len)
+{
+    struct ethhdr *eth = (struct ethhdr *)pkt;
+    uint16_t proto;
+    uint8_t *l3, *l4 = NULL;
+    uint8_t ip_proto;
+    uint32_t h = 0;
+    int i;
+
+    if (unlikely(len < sizeof(*eth))) {
+        return 0;
+    }
+    proto = ntohs(eth->h_proto);
+    l3 = pkt + sizeof(*eth);
+    if (proto == ETH_P_8021Q && len >= sizeof(*eth) + 4) {
+        proto = ntohs(*(uint16_t *)(l3 + 2));
+        l3 += 4;
+    }
+
+    if (proto == ETH_P_IP) {
+        struct iphdr *iph = (struct iphdr *)l3;
+        if (l3 + sizeof(*iph) > pkt + len) {
+            return 0;
+        }
+        h = ntohl(iph->saddr) ^ ntohl(iph->daddr);
+        ip_proto = iph->protocol;
+        l4 = l3 + iph->ihl * 4;
+    } else if (proto == ETH_P_IPV6) {
+        struct ip6_hdr *ip6h = (struct ip6_hdr *)l3;
+        uint32_t *a;
+        if (l3 + sizeof(*ip6h) > pkt + len) {
+            return 0;
+        }
+        a = (uint32_t *)&ip6h->ip6_src;
+        for (i = 0; i < 8; i ++) {
+            h ^= ntohl(a[i]);
+        }
+        ip_proto = ip6h->ip6_nxt;
+        l4 = l3 + sizeof(*ip6h);
+    } else {
+        return 0;
+    }
+
+    if ((ip_proto == IPPROTO_TCP || ip_proto == IPPROTO_UDP || ip_proto == IPPROTO_SCTP) &&
+        l4 + 4 <= pkt + len) {
+        h ^= ntohs(*(uint16_t *)l4) ^ ntohs(*(uint16_t *)(l4 + 2));
+    }
+
+    return h ^ (h >> 16);
+}
+
+// Queue the packet to thread dst, which handles it with slot_ctx, or with its inline context
+// if slot_ctx is NULL. Return true if the packet is consumed.
+static bool dp_handoff_to(dp_context_t *ctx, int dst, dp_context_t *slot_ctx, uint8_t *pkt, int len)
+{
+    dp_handoff_ring_t *r;
+    dp_handoff_slot_t *slot;
+    int src = ctx->thr_id;
+    uint32_t head;
+
+    r = CMM_LOAD_SHARED(th_handoff(dst)[src]);
+    if (r == NULL) {
+        return false;
+    }
+
+    head = r->head;
+    if (head - CMM_LOAD_SHARED(r->tail) >= HANDOFF_RING_SIZE) {
+        th_handoff_drops(src) ++;
+        ctx->stats.rx_drops ++;
+        return true;
+    }
+
+    slot = &r->slots[head & (HANDOFF_RING_SIZE - 1)];
+    memcpy(slot->pkt, pkt, len);
+    slot->len = len;
+    slot->ctx = slot_ctx;
+    cmm_smp_wmb();
+    CMM_STORE_SHARED(r->head, head + 1);
+    th_handoff_pkts(src) ++;
+
+    // One wakeup until the consumer starts draining
+    if (!CMM_LOAD_SHARED(r->signaled)) {
+        uint64_t w = 1;
+        CMM_STORE_SHARED(r->signaled, 1);
+        write(th_handoff_evfd(dst), &w, sizeof(w));
+    }
+    return true;
+}
+
+// Return true if the packet is queued to the thread owning the flow.
+bool dp_handoff_packet(dp_context_t *ctx, uint8_t *pkt, int len)
+{
+    int threads = CMM_LOAD_SHARED(g_dp_fanout_threads), dst;
+
+    if (unlikely(len > HANDOFF_FRAME_SIZE) || threads <= 1) {
+        return false;
+    }
+
+    dst = dp_flow_hash_sym(pkt, len) % threads;
+    if (likely(dst == ctx->thr_id)) {
+        return false;
+    }
+    return dp_handoff_to(ctx, dst, NULL, pkt, len);
+}
+
+// For a context that moved from another thread, return true if the packet belongs to a
+// session still owned by the previous thread and is queued to it.
+bool dp_drain_packet(dp_context_t *ctx, uint8_t *pkt, int len)
+{
+    uint32_t bit;
+
+    if (unlikely(g_seconds >= ctx->drain_until)) {
+        DEBUG_CTRL("drained, ctx=%s from thr_id=%u\n", ctx->name, ctx->drain_thr);
+        free(ctx->drain_flows);
+        ctx->drain_flows = NULL;
+        return false;
+    }
+    if (unlikely(len > HANDOFF_FRAME_SIZE)) {
+        return false;
+    }
+
+    bit = dp_flow_hash_sym(pkt, len) % DRAIN_FLOW_BITS;
+    if (!BITMASK_TEST(ctx->drain_flows, bit)) {
+        return false;
+    }
+    return dp_handoff_to(ctx, ctx->drain_thr, ctx, pkt, len);
+}
+
+static uint32_t dp_drain_handoff(int thr_id)
+{
+    uint32_t count = 0;
+    int src;
+
+    for (src = 0; src < g_dp_threads; src ++) {
+        dp_handoff_ring_t *r = th_handoff(thr_id)[src];
+        if (r == NULL || r->head == r->tail) {
+            continue;
+        }
+        CMM_STORE_SHARED(r->signaled, 0);
+        cmm_smp_mb();
+        count += dp_rx_handoff(th_ctx_inline(thr_id), r, g_seconds);
+    }
+    th_sched_pkts(thr_id) += count;
+    return count;
+}
+
+// Rings are allocated once and kept, producers may look them up at any time.
+static int dp_alloc_handoff(int thr_id)
+{
+    int src;
+
+    for (src = 0; src < MAX_DP_THREADS; src ++) {
+        if (th_handoff(thr_id)[src] == NULL) {
+            dp_handoff_ring_t *r;
+            if (posix_memalign((void **)&r, 64, sizeof(*r)) != 0) {
+                return -1;
+            }
+            memset(r, 0, sizeof(*r));
+            rcu_assign_pointer(th_handoff(thr_id)[src], r);
+        }
+    }
+    return 0;
+}
+
 void dp_refresh_stats(struct cds_hlist_head *list)
 {
     dp_context_t *ctx;
@@ -80,6 +291,21 @@ void dp_refresh_stats(struct cds_hlist_head *list)
     }
 }
 
+// Called by the owning thread, which keeps the lists from changing with the lock
+static void dp_sum_ring_stats(dp_stats_t *s, struct cds_hlist_head *list)
+{
+    dp_context_t *ctx;
+    struct cds_hlist_node *itr;
+
+    cds_hlist_for_each_entry_rcu(ctx, itr, list, link) {
+        s->rx += ctx->stats.rx;
+        s->rx_drops += ctx->stats.rx_drops;
+        s->tx += ctx->stats.tx;
+        s->tx_drops += ctx->stats.tx_drops;
+        s->quar_drops += ctx->stats.quar_drops;
+    }
+}
+
 int dp_read_ring_stats(dp_stats_t *s, int thr_id)
 {
     dp_context_t *ctx;
@@ -99,6 +325,7 @@ int dp_read_ring_stats(dp_stats_t *s, int thr_id)
         s->rx_drops += ctx->stats.rx_drops;
         s->tx += ctx->stats.tx;
         s->tx_drops += ctx->stats.tx_drops;
+        s->quar_drops += ctx->stats.quar_drops;
     }
 
     cds_hlist_for_each_entry_rcu(ctx, itr, list1, link) {
@@ -108,12 +335,73 @@ int dp_read_ring_stats(dp_stats_t *s, int thr_id)
         s->rx_drops += ctx->stats.rx_drops;
         s->tx += ctx->stats.tx;
         s->tx_drops += ctx->stats.tx_drops;
+        s->quar_drops += ctx->stats.quar_drops;
     }
 
     pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+
+    uint64_t pkts, drops;
+    uint32_t seq;
+    do {
+        seq = seqlock_read_begin(&th_snap_lock(thr_id));
+        pkts = th_handoff_pkts_snap(thr_id);
+        drops = th_handoff_drops_snap(thr_id);
+    } while (seqlock_read_retry(&th_snap_lock(thr_id), seq));
+
+    s->handoff += pkts;
+    s->handoff_drops += drops;
     return 0;
 }
 
+// Forwarding latency of the inline contexts of the thread with timed packets, 'cb' is called
+// with the context lock held. The histograms keep their single writer, see lat_hist.h.
+int dp_read_fwd_latency(int thr_id, dp_fwd_lat_fct cb, void *arg)
+{
+    struct cds_hlist_head *lists[2];
+    dp_context_t *ctx;
+    struct cds_hlist_node *itr;
+    int i, cnt = 0;
+
+    thr_id = thr_id % MAX_DP_THREADS;
+    lists[0] = &th_ctx_list(thr_id);
+    lists[1] = &th_notc_nfq_ctx_list(thr_id);
+
+    pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+    for (i = 0; i < 2; i ++) {
+        cds_hlist_for_each_entry_rcu(ctx, itr, lists[i], link) {
+            if (ctx->tap || ctx->nfq || ctx->fwd_lat.count == 0) {
+                continue;
+            }
+            cb(ctx->iface, &ctx->fwd_lat, arg);
+            cnt ++;
+        }
+    }
+    pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+
+    return cnt;
+}
+
+// Publish the counters other threads read, once a second
+static void dp_publish_stats(int thr_id, uint32_t load)
+{
+    seqlock_write_begin(&th_snap_lock(thr_id));
+    th_handoff_pkts_snap(thr_id) = th_handoff_pkts(thr_id);
+    th_handoff_drops_snap(thr_id) = th_handoff_drops(thr_id);
+    th_load_snap(thr_id) = load;
+    seqlock_write_end(&th_snap_lock(thr_id));
+}
+
+static uint32_t dp_read_load(int thr_id)
+{
+    uint32_t load, seq;
+
+    do {
+        seq = seqlock_read_begin(&th_snap_lock(thr_id));
+        load = th_load_snap(thr_id);
+    } while (seqlock_read_retry(&th_snap_lock(thr_id), seq));
+    return load;
+}
+
 static dp_context_t *dp_lookup_context(struct cds_hlist_head *list, const char *name)
 {
     dp_context_t *ctx;
@@ -128,7 +416,9 @@ static dp_context_t *dp_lookup_context(struct cds_hlist_head *list, const char *
     return NULL;
 }
 
-static dp_context_t *dp_alloc_context(const char *iface, int thr_id, bool tap, bool jumboframe, uint blocks, uint batch)
+// umem_ctx: AF_XDP context whose umem is shared with the new context, NULL to create one.
+static dp_context_t *dp_alloc_context(const char *iface, int thr_id, bool tap, bool jumboframe, bool xdp,
+                                      dp_context_t *umem_ctx, uint blocks, uint batch)
 {
     int fd;
     dp_context_t *ctx;
@@ -138,7 +428,11 @@ static dp_context_t *dp_alloc_context(const char *iface, int thr_id, bool tap, b
         return NULL;
     }
 
-    fd = dp_open_socket(ctx, iface, tap, jumboframe, blocks, batch);
+    ctx->xdp = xdp;
+    // Called from the ctrl thread, prefer the node of the dp thread for the ring
+    set_mem_node(th_numa_node(thr_id));
+    fd = dp_open_socket(ctx, iface, tap, jumboframe, umem_ctx, blocks, batch);
+    set_mem_node(-1);
     if (fd < 0) {
         DEBUG_ERROR(DBG_CTRL, "fail to open dp socket, iface=%s\n", iface);
         free(ctx);
@@ -152,6 +446,8 @@ static dp_context_t *dp_alloc_context(const char *iface, int thr_id, bool tap, b
     ctx->quar = false;
     ctx->jumboframe = jumboframe;
     ctx->nfq = false;
+    ctx->blocks = blocks;
+    strlcpy(ctx->iface, iface, sizeof(ctx->iface));
 
     DEBUG_CTRL("ctx=%p\n", ctx);
 
@@ -237,6 +533,7 @@ static void dp_remove_context(timer_node_t *node)
     dp_context_t *ctx = STRUCT_OF(node, dp_context_t, free_node);
     DEBUG_CTRL("ctx=%s\n", ctx->name);
     dp_close_socket(ctx);
+    free(ctx->drain_flows);
     free(ctx);
 }
 
@@ -250,6 +547,7 @@ static void dp_release_context(dp_context_t *ctx, bool kill)
 
     if (kill) {
         dp_close_socket(ctx);
+        free(ctx->drain_flows);
         free(ctx);
     } else {
         DEBUG_CTRL("add context to free list, ctx=%s, ts=%u\n", ctx->name, g_seconds);
@@ -298,11 +596,116 @@ static const char *get_tap_name(char *name, const char *netns, const char *iface
     return name;
 }
 
+// -- thread placement
+
+// Contexts are counted when two threads have about the same load
+#define LOAD_STEP 50    // permille
+
+static int dp_count_contexts(int thr_id)
+{
+    dp_context_t *ctx;
+    struct cds_hlist_node *itr;
+    int cnt = 0;
+
+    pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+    cds_hlist_for_each_entry_rcu(ctx, itr, &th_ctx_list(thr_id), link) {
+        cnt ++;
+    }
+    pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+    return cnt;
+}
+
+// Least loaded of the active threads, -1 if none is ready
+static int dp_data_pick_thread(void)
+{
+    int thr_id, best = -1;
+    uint32_t load, best_load = 0;
+    int cnt, best_cnt = 0;
+
+    for (thr_id = 0; thr_id < g_dp_active_threads; thr_id ++) {
+        if (!CMM_LOAD_SHARED(th_ready(thr_id))) {
+            continue;
+        }
+        load = dp_read_load(thr_id) / LOAD_STEP;
+        cnt = dp_count_contexts(thr_id);
+        if (best < 0 || load < best_load || (load == best_load && cnt < best_cnt)) {
+            best = thr_id;
+            best_load = load;
+            best_cnt = cnt;
+        }
+    }
+    return best;
+}
+
+// Thread holding the named context, -1 if not found
+static int dp_data_find_context(const char *name)
+{
+    int thr_id;
+
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        dp_context_t *ctx;
+
+        if (!CMM_LOAD_SHARED(th_ready(thr_id))) {
+            continue;
+        }
+        pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+        ctx = dp_lookup_context(&th_ctx_list(thr_id), name);
+        pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+        if (ctx != NULL) {
+            return thr_id;
+        }
+    }
+    return -1;
+}
+
+static bool dp_ep_known(dp_context_t *ctx)
+{
+    bool known;
+
+    rcu_read_lock();
+    known = rcu_map_lookup(&g_ep_map, &ctx->ep_mac) != NULL;
+    rcu_read_unlock();
+    return known;
+}
+
+// The endpoint of the mac is added to or removed from the ep map, the socket filters of its
+// taps are regenerated.
+void dp_data_refresh_filter(struct ether_addr *mac)
+{
+    int thr_id;
+
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        dp_context_t *ctx;
+        struct cds_hlist_node *itr;
+
+        if (!CMM_LOAD_SHARED(th_ready(thr_id))) {
+            continue;
+        }
+        pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+        cds_hlist_for_each_entry_rcu(ctx, itr, &th_ctx_list(thr_id), link) {
+            if (ctx->tap && !ctx->released && mac_cmp(ctx->ep_mac.ether_addr_octet, mac->ether_addr_octet)) {
+                dp_ring_filter(ctx, dp_ep_known(ctx));
+            }
+        }
+        pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+    }
+}
+
+// thr_id is -1 to place the tap on the least loaded thread. Taps are only added, moved and
+// removed by the ctrl thread, so the placement cannot change in between.
 int dp_data_add_tap(const char *netns, const char *iface, const char *ep_mac, int thr_id)
 {
     int ret = 0;
     dp_context_t *ctx;
 
+    if (thr_id < 0) {
+        char name[CTX_NAME_LEN];
+        get_tap_name(name, netns, iface);
+        if ((thr_id = dp_data_find_context(name)) < 0 && (thr_id = dp_data_pick_thread()) < 0) {
+            DEBUG_ERROR(DBG_CTRL, "no dp thread is ready, netns=%s\n", netns);
+            return -1;
+        }
+    }
     thr_id = thr_id % MAX_DP_THREADS;
 
     if (th_epoll_fd(thr_id) == 0) {
@@ -325,11 +728,13 @@ int dp_data_add_tap(const char *netns, const char *iface, const char *ep_mac, in
         if (ctx != NULL) {
             // handle mac address change
             ether_aton_r(ep_mac, &ctx->ep_mac);
+            ctx->proxymesh = cmp_mac_prefix(ctx->ep_mac.ether_addr_octet, PROXYMESH_MAC_PREFIX);
+            dp_ring_filter(ctx, dp_ep_known(ctx));
             DEBUG_CTRL("tap already exists, netns=%s iface=%s\n", netns, iface);
             break;
         }
 
-        ctx = dp_alloc_context(iface, thr_id, true, false, TAP_BLOCK, TAP_BATCH);
+        ctx = dp_alloc_context(iface, thr_id, true, false, false, NULL, TAP_BLOCK, TAP_BATCH);
         if (ctx == NULL) {
             ret = -1;
             break;
@@ -344,7 +749,9 @@ int dp_data_add_tap(const char *netns, const char *iface, const char *ep_mac, in
         }
 
         ether_aton_r(ep_mac, &ctx->ep_mac);
+        ctx->proxymesh = cmp_mac_prefix(ctx->ep_mac.ether_addr_octet, PROXYMESH_MAC_PREFIX);
         strlcpy(ctx->name, name, sizeof(ctx->name));
+        dp_ring_filter(ctx, dp_ep_known(ctx));
         cds_hlist_add_head_rcu(&ctx->link, &th_ctx_list(thr_id));
 
         DEBUG_CTRL("tap added netns=%s iface=%s fd=%d\n", netns, iface, ctx->fd);
@@ -357,11 +764,20 @@ int dp_data_add_tap(const char *netns, const char *iface, const char *ep_mac, in
     return ret;
 }
 
+// thr_id is -1 to remove the tap from whichever thread holds it
 int dp_data_del_tap(const char *netns, const char *iface, int thr_id)
 {
     int ret = 0;
     dp_context_t *ctx;
- 
+
+    if (thr_id < 0) {
+        char name[CTX_NAME_LEN];
+        get_tap_name(name, netns, iface);
+        if ((thr_id = dp_data_find_context(name)) < 0) {
+            DEBUG_CTRL("tap cannot be found, netns=%s iface=%s\n", netns, iface);
+            return -1;
+        }
+    }
     thr_id = thr_id % MAX_DP_THREADS;
 
     pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
@@ -476,7 +892,7 @@ int dp_data_del_nfq(const char *netns, const char *iface, int thr_id)
     return ret;
 }
 
-int dp_data_add_port(const char *iface, bool jumboframe, int thr_id)
+int dp_data_add_port(const char *iface, bool jumboframe, bool xdp, bool fanout, int thr_id)
 {
     int ret = 0;
     dp_context_t *ctx;
@@ -497,15 +913,24 @@ int dp_data_add_port(const char *iface, bool jumboframe, int thr_id)
             break;
         }
 
-        ctx = dp_alloc_context(iface, thr_id, false, jumboframe, INLINE_BLOCK, INLINE_BATCH);
+        ctx = dp_alloc_context(iface, thr_id, false, jumboframe, xdp && !fanout, NULL, INLINE_BLOCK, INLINE_BATCH);
         if (ctx == NULL) {
             ret = -1;
             break;
         }
+        if (fanout && (dp_alloc_handoff(thr_id) < 0 || dp_ring_fanout(ctx, iface) < 0)) {
+            dp_close_socket(ctx);
+            free(ctx);
+            ret = -1;
+            break;
+        }
+        ctx->fanout = fanout;
         ctx->peer_ctx = ctx;
         th_ctx_inline(thr_id) = ctx;
 
         strlcpy(ctx->name, iface, sizeof(ctx->name));
+        // No endpoint of its own, frames are the endpoints' by the mac prefix
+        dp_ring_filter(ctx, false);
         cds_hlist_add_head_rcu(&ctx->link, &th_ctx_list(thr_id));
 
         DEBUG_CTRL("added iface=%s fd=%d\n", iface, ctx->fd);
@@ -539,7 +964,7 @@ int dp_data_del_port(const char *iface, int thr_id)
     return ret;
 }
 
-int dp_data_add_port_pair(const char *vin_iface, const char *vex_iface, const char *ep_mac, bool quar, int thr_id) {
+int dp_data_add_port_pair(const char *vin_iface, const char *vex_iface, const char *ep_mac, bool quar, bool xdp, int thr_id) {
     int ret = 0;
     thr_id = thr_id % MAX_DP_THREADS;
     dp_context_t *ctx_in = NULL; 
@@ -560,7 +985,7 @@ int dp_data_add_port_pair(const char *vin_iface, const char *vex_iface, const ch
     ctx_in = dp_lookup_context(&th_notc_nfq_ctx_list(thr_id), vin_iface);
     if (ctx_in == NULL) {
         new_in = true;
-        ctx_in = dp_alloc_context(vin_iface, thr_id, false, false, INLINE_BLOCK_NOTC, INLINE_BATCH_NOTC);   
+        ctx_in = dp_alloc_context(vin_iface, thr_id, false, false, xdp, NULL, INLINE_BLOCK_NOTC, INLINE_BATCH_NOTC);
         if (ctx_in == NULL) {
             DEBUG_ERROR(DBG_CTRL, "fail to alloc dp_context for %s\n", vin_iface);
             goto error;
@@ -574,7 +999,7 @@ int dp_data_add_port_pair(const char *vin_iface, const char *vex_iface, const ch
     ctx_ex = dp_lookup_context(&th_notc_nfq_ctx_list(thr_id), vex_iface);
     if (ctx_ex == NULL) {
         new_ex = true;
-        ctx_ex = dp_alloc_context(vex_iface, thr_id, false, false, INLINE_BLOCK_NOTC, INLINE_BATCH_NOTC);   
+        ctx_ex = dp_alloc_context(vex_iface, thr_id, false, false, xdp, ctx_in, INLINE_BLOCK_NOTC, INLINE_BATCH_NOTC);
         if (ctx_ex == NULL) {
             DEBUG_ERROR(DBG_CTRL, "fail to alloc dp_context for %s , free context for %s\n", vex_iface, vin_iface);
             goto error;
@@ -654,94 +1079,682 @@ int dp_data_del_port_pair(const char *vin_iface, const char *vex_iface, int thr_
 }
 
 
-/* This function can only be called by dp_data_wait_ctrl_req_thr() */
-static int dp_ctrl_wait_dp_threads(int threads)
+// -- control commands
+
+static inline int futex_op(int *uaddr, int op, int val, const struct timespec *ts)
 {
-    int rc, done = 0;
+    return syscall(SYS_futex, uaddr, op, val, ts, NULL, 0);
+}
 
-    while (1) {
-        struct timespec ts;
+static io_ctrl_future_t *dp_ctrl_future_alloc(int threads)
+{
+    io_ctrl_future_t *f = malloc(sizeof(*f));
+    if (f == NULL) {
+        return NULL;
+    }
+
+    f->pending = threads;
+    f->refcnt = threads + 1;
+    f->result = 0;    // one for each thread and one for the waiter
+    return f;
+}
+
+static void dp_ctrl_future_put(io_ctrl_future_t *f)
+{
+    if (uatomic_sub_return(&f->refcnt, 1) == 0) {
+        free(f);
+    }
+}
 
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_sec += CTRL_REQ_TIMEOUT;
+static void dp_ctrl_future_done(io_ctrl_future_t *f)
+{
+    if (f == NULL) {
+        return;
+    }
+    if (uatomic_sub_return(&f->pending, 1) == 0) {
+        futex_op(&f->pending, FUTEX_WAKE, 1, NULL);
+    }
+    dp_ctrl_future_put(f);
+}
 
-        rc = pthread_cond_timedwait(&g_ctrl_req_cond, &g_ctrl_req_lock, &ts);
-        if (rc == 0) {
-            if (++ done == threads) break;
+static int dp_ctrl_future_wait(io_ctrl_future_t *f, int timeout)
+{
+    struct timespec start, now, ts;
+    int pending;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while ((pending = uatomic_read(&f->pending)) > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        ts.tv_sec = start.tv_sec + timeout - now.tv_sec;
+        ts.tv_nsec = start.tv_nsec - now.tv_nsec;
+        if (ts.tv_nsec < 0) {
+            ts.tv_sec --;
+            ts.tv_nsec += 1000000000;
         }
-        if (rc == ETIMEDOUT) {
-            DEBUG_CTRL("timeout: wait=%d done=%d\n", threads, done);
-            break;
+        if (ts.tv_sec < 0) {
+            DEBUG_CTRL("timeout: pending=%d\n", pending);
+            return ETIMEDOUT;
         }
+        futex_op(&f->pending, FUTEX_WAIT, pending, &ts);
     }
 
-    return rc;
+    return 0;
 }
 
-int dp_data_wait_ctrl_req_thr(int req, int thr_id)
+// Copy the command to the thread's ring and kick the thread. Safe to call from several
+// threads at once.
+int dp_data_post_ctrl_cmd(io_ctrl_cmd_t *cmd, int thr_id)
 {
+    dp_ctrl_cmd_ring_t *r = &th_ctrl_cmds(thr_id);
+    dp_ctrl_cmd_slot_t *slot;
+    uint32_t pos, seq;
     uint64_t w = 1;
-    ssize_t s;
-    int rc = 0;
 
-    DEBUG_CTRL("req=%d thread=%d\n", req, thr_id);
+    pos = uatomic_read(&r->head);
+    while (1) {
+        slot = &r->slots[pos % CTRL_CMD_RING_SIZE];
+        seq = CMM_LOAD_SHARED(slot->seq);
+        cmm_smp_rmb();
+        if (seq == pos) {
+            uint32_t old = uatomic_cmpxchg(&r->head, pos, pos + 1);
+            if (old == pos) {
+                break;
+            }
+            pos = old;
+        } else if ((int32_t)(seq - pos) < 0) {
+            DEBUG_CTRL("command ring full, req=%d thr_id=%d\n", cmd->req, thr_id);
+            return -1;
+        } else {
+            pos = uatomic_read(&r->head);
+        }
+    }
+
+    slot->cmd = *cmd;
+    cmm_smp_wmb();
+    CMM_STORE_SHARED(slot->seq, pos + 1);
 
-    pthread_mutex_lock(&g_ctrl_req_lock);
-    th_ctrl_req(thr_id) = req;
-    s  = write(th_ctrl_req_evfd(thr_id), &w, sizeof(uint64_t));
-    if (s != sizeof(uint64_t)) {
-        pthread_mutex_unlock(&g_ctrl_req_lock);
+    if (write(th_ctrl_req_evfd(thr_id), &w, sizeof(uint64_t)) != sizeof(uint64_t)) {
+        // The command is queued, it runs at the next kick.
+        DEBUG_CTRL("fail to kick thread, thr_id=%d\n", thr_id);
+    }
+    return 0;
+}
+
+// Run the command on all dp threads at once and wait for them to complete.
+int dp_data_wait_ctrl_cmd(io_ctrl_cmd_t *cmd)
+{
+    io_ctrl_future_t *f;
+    int thr_id, posted = 0, rc;
+
+    DEBUG_CTRL("req=%d\n", cmd->req);
+
+    f = dp_ctrl_future_alloc(g_dp_threads);
+    if (f == NULL) {
         return -1;
     }
-    rc = dp_ctrl_wait_dp_threads(1);
-    th_ctrl_req(thr_id) = 0;
-    pthread_mutex_unlock(&g_ctrl_req_lock);
+
+    cmd->future = f;
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        if (dp_data_post_ctrl_cmd(cmd, thr_id) == 0) {
+            posted ++;
+        }
+    }
+    cmd->future = NULL;
+
+    // Release the references of threads the command was not posted to
+    for (; posted < g_dp_threads; posted ++) {
+        dp_ctrl_future_done(f);
+    }
+
+    rc = dp_ctrl_future_wait(f, CTRL_REQ_TIMEOUT);
+    dp_ctrl_future_put(f);
     return rc;
 }
 
-/* This function can only be called by dp_dlp_wait_ctrl_req_thr() */
-static int dp_ctrl_wait_dlp_threads()
+// Post the command to one dp thread and wait for it to complete. 'result' is optional.
+int dp_data_wait_ctrl_cmd_thr(io_ctrl_cmd_t *cmd, int thr_id, uint64_t *result)
 {
-    int rc = 0;
+    io_ctrl_future_t *f;
+    int rc;
+
+    DEBUG_CTRL("req=%d thr_id=%d\n", cmd->req, thr_id);
+
+    f = dp_ctrl_future_alloc(1);
+    if (f == NULL) {
+        return -1;
+    }
+
+    cmd->future = f;
+    if (dp_data_post_ctrl_cmd(cmd, thr_id) < 0) {
+        dp_ctrl_future_done(f);
+    }
+    cmd->future = NULL;
+
+    rc = dp_ctrl_future_wait(f, CTRL_REQ_TIMEOUT);
+    if (rc == 0 && result != NULL) {
+        *result = f->result;
+    }
+    dp_ctrl_future_put(f);
+    return rc;
+}
+
+// Run by the thread owning the tap context. Sessions of the endpoint stay with this thread;
+// the flows they hash to are recorded, and the new owner hands packets of those flows back
+// until the sessions drain. Inline, port pair and nfq contexts transmit with the socket of
+// their thread and never move.
+static void dp_migrate_ctx_out(int thr_id, dp_context_t *ctx, int dst)
+{
+    dp_context_t *c;
+    struct cds_hlist_node *itr;
+    bool found = false;
+    uint8_t *flows;
+    int first = min(thr_id, dst), second = max(thr_id, dst);
+
+    if (dst == thr_id || !CMM_LOAD_SHARED(th_ready(dst))) {
+        return;
+    }
+
+    pthread_mutex_lock(&th_ctrl_dp_lock(first));
+    pthread_mutex_lock(&th_ctrl_dp_lock(second));
+
+    cds_hlist_for_each_entry_rcu(c, itr, &th_ctx_list(thr_id), link) {
+        if (c == ctx) {
+            found = true;
+            break;
+        }
+    }
+
+    do {
+        if (!found || !ctx->tap || ctx->released || ctx->drain_flows != NULL ||
+            ctx == th_ctx_inline(thr_id)) {
+            DEBUG_CTRL("context cannot move, ctx=%p\n", ctx);
+            break;
+        }
+
+        flows = calloc(1, BITMASK_ARRAY_SIZE(DRAIN_FLOW_BITS));
+        if (flows == NULL) {
+            break;
+        }
+        dpi_session_flow_bits(&ctx->ep_mac, flows, DRAIN_FLOW_BITS);
+        if (!BITMASK_ANY_TEST(flows, DRAIN_FLOW_BITS)) {
+            free(flows);
+            flows = NULL;
+        }
+
+        dp_epoll_remove_ctx(ctx);
+        cds_hlist_del(&ctx->link);
+
+        ctx->drain_flows = flows;
+        ctx->drain_thr = thr_id;
+        ctx->drain_until = g_seconds + DRAIN_DURATION;
+        ctx->thr_id = dst;
+        cds_hlist_add_head_rcu(&ctx->link, &th_ctx_list(dst));
+        if (dp_epoll_add_ctx(ctx, dst) < 0) {
+            // Not polled, but still listed so it can be removed
+            DEBUG_ERROR(DBG_CTRL, "fail to poll moved context, ctx=%s\n", ctx->name);
+        }
+
+        DEBUG_CTRL("moved ctx=%s to thr_id=%d drain=%d\n", ctx->name, dst, flows != NULL);
+    } while (false);
+
+    pthread_mutex_unlock(&th_ctrl_dp_lock(second));
+    pthread_mutex_unlock(&th_ctrl_dp_lock(first));
+}
+
+static bool dp_listed_ctx(int thr_id, dp_context_t *ctx)
+{
+    dp_context_t *c;
+    struct cds_hlist_node *itr;
+
+    cds_hlist_for_each_entry_rcu(c, itr, &th_ctx_list(thr_id), link) {
+        if (c == ctx) {
+            return true;
+        }
+    }
+    cds_hlist_for_each_entry_rcu(c, itr, &th_notc_nfq_ctx_list(thr_id), link) {
+        if (c == ctx) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Run by the thread owning the context, nc holds the socket of the new ring. The context
+// keeps its state and sessions, only its socket is swapped; the socket left over is closed.
+static void dp_resize_ctx_ring(int thr_id, dp_context_t *ctx, dp_context_t *nc)
+{
+    pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+
+    if (dp_listed_ctx(thr_id, ctx) && !ctx->released && ctx->thr_id == thr_id) {
+        bool epoll = ctx->epoll;
+        uint32_t blocks = ctx->blocks;
+
+        dp_epoll_remove_ctx(ctx);
+        dp_ring_swap(ctx, nc, ctx->tap && dp_ep_known(ctx), g_seconds);
+        ctx->blocks = nc->blocks;
+        nc->blocks = blocks;
+        if (epoll && dp_epoll_add_ctx(ctx, thr_id) < 0) {
+            DEBUG_ERROR(DBG_CTRL, "fail to poll resized context, ctx=%s\n", ctx->name);
+        }
+        DEBUG_CTRL("ctx=%s blocks=%u -> %u\n", ctx->name, blocks, ctx->blocks);
+    } else {
+        DEBUG_CTRL("context cannot be resized, ctx=%p\n", ctx);
+    }
+
+    pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+
+    dp_close_socket(nc);
+    free(nc);
+}
+
+static void dp_run_ctrl_cmds(int thr_id, io_ctx_t *context)
+{
+    dp_ctrl_cmd_ring_t *r = &th_ctrl_cmds(thr_id);
+    dp_mnt_stage_t *stage = &g_shm->dp_stage[thr_id];
 
     while (1) {
-        struct timespec ts;
+        dp_ctrl_cmd_slot_t *slot = &r->slots[r->tail % CTRL_CMD_RING_SIZE];
+        io_ctrl_cmd_t cmd;
+
+        if (CMM_LOAD_SHARED(slot->seq) != r->tail + 1) {
+            break;
+        }
+        cmm_smp_rmb();
+        cmd = slot->cmd;
+        cmm_smp_mb();
+        CMM_STORE_SHARED(slot->seq, r->tail + CTRL_CMD_RING_SIZE);
+        r->tail ++;
+
+        if (cmd.req == CTRL_REQ_MIGRATE_CTX) {
+            dp_migrate_ctx_out(thr_id, cmd.migrate.ctx, cmd.migrate.dst);
+        } else if (cmd.req == CTRL_REQ_RESIZE_CTX) {
+            dp_resize_ctx_ring(thr_id, cmd.resize.ctx, cmd.resize.ring_ctx);
+        } else {
+            CMM_STORE_SHARED(stage->since, tsc_read());
+            CMM_STORE_SHARED(stage->sess_id, 0);
+            CMM_STORE_SHARED(stage->stage, DP_STAGE_CTRL);
+            dpi_handle_ctrl_req(&cmd, context);
+            CMM_STORE_SHARED(stage->stage, DP_STAGE_IDLE);
+        }
+        dp_ctrl_future_done(cmd.future);
+    }
+}
+
+// -- rebalance
+
+#define REBALANCE_LOAD_HIGH 700     // permille, busiest thread to relieve
+#define REBALANCE_LOAD_GAP  300     // permille, over the least loaded thread
+#define THREAD_READY_WAIT   100     // ms
+
+static int dp_data_migrate_ctx(dp_context_t *ctx, int src, int dst)
+{
+    io_ctrl_cmd_t cmd;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.req = CTRL_REQ_MIGRATE_CTX;
+    cmd.migrate.ctx = ctx;
+    cmd.migrate.dst = dst;
+    if (dp_data_wait_ctrl_cmd_thr(&cmd, src, NULL) != 0) {
+        return -1;
+    }
+    return ctx->thr_id == dst ? 0 : -1;
+}
+
+// A movable tap of the thread, the one whose packet rate is closest to 'pps'
+static dp_context_t *dp_pick_tap(int thr_id, uint32_t pps)
+{
+    dp_context_t *ctx, *best = NULL;
+    struct cds_hlist_node *itr;
+    uint32_t diff, best_diff = 0;
+
+    pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+    cds_hlist_for_each_entry_rcu(ctx, itr, &th_ctx_list(thr_id), link) {
+        if (!ctx->tap || ctx->released || ctx->drain_flows != NULL) {
+            continue;
+        }
+        diff = ctx->rx_pps > pps ? ctx->rx_pps - pps : pps - ctx->rx_pps;
+        if (best == NULL || diff < best_diff) {
+            best = ctx;
+            best_diff = diff;
+        }
+    }
+    pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+    return best;
+}
+
+static uint32_t dp_thread_pps(int thr_id)
+{
+    dp_context_t *ctx;
+    struct cds_hlist_node *itr;
+    uint32_t pps = 0;
+
+    pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+    cds_hlist_for_each_entry_rcu(ctx, itr, &th_ctx_list(thr_id), link) {
+        pps += ctx->rx_pps;
+    }
+    pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+    return pps;
+}
+
+// Move taps off retired threads. A tap that moved recently is left until it drains.
+static void dp_data_evacuate(void)
+{
+    int thr_id, dst;
+
+    for (thr_id = g_dp_active_threads; thr_id < g_dp_threads; thr_id ++) {
+        dp_context_t *ctx;
+
+        while ((ctx = dp_pick_tap(thr_id, 0)) != NULL) {
+            if ((dst = dp_data_pick_thread()) < 0 || dp_data_migrate_ctx(ctx, thr_id, dst) < 0) {
+                break;
+            }
+        }
+    }
+}
+
+// Called by the ctrl thread periodically. Move one tap from the busiest to the least
+// loaded thread, with about the packet rate that evens out their load.
+void dp_data_rebalance(void)
+{
+    int thr_id, hot = -1, cold = -1;
+    uint32_t load, hot_load = 0, cold_load = 0, pps;
+    dp_context_t *ctx;
+
+    dp_data_evacuate();
+
+    for (thr_id = 0; thr_id < g_dp_active_threads; thr_id ++) {
+        if (!CMM_LOAD_SHARED(th_ready(thr_id))) {
+            continue;
+        }
+        load = dp_read_load(thr_id);
+        if (hot < 0 || load > hot_load) {
+            hot = thr_id;
+            hot_load = load;
+        }
+        if (cold < 0 || load < cold_load) {
+            cold = thr_id;
+            cold_load = load;
+        }
+    }
+
+    if (hot < 0 || hot == cold ||
+        hot_load < REBALANCE_LOAD_HIGH || hot_load - cold_load < REBALANCE_LOAD_GAP) {
+        return;
+    }
+
+    pps = (uint64_t)dp_thread_pps(hot) * (hot_load - cold_load) / (2 * hot_load);
+    ctx = dp_pick_tap(hot, pps);
+    if (ctx == NULL || ctx->rx_pps == 0 || ctx->rx_pps > pps * 2) {
+        return;
+    }
+
+    DEBUG_CTRL("ctx=%s pps=%u thr_id=%d load=%u -> thr_id=%d load=%u\n",
+               ctx->name, ctx->rx_pps, hot, hot_load, cold, cold_load);
+    dp_data_migrate_ctx(ctx, hot, cold);
+}
+
+// -- ring tuning
+
+// A ring is doubled when it dropped packets or was found 3/4 filled since the last tune, and
+// halved after a minute of never being over a quarter filled, between a quarter and four
+// times the size it was created with. Rings only grow while the rings of all contexts stay
+// within g_ring_mem_limit. Fanout, AF_XDP and nfq contexts keep their size.
+#define TUNE_GROW_PEAK  3       // quarters
+#define TUNE_IDLE_RUNS  6
+#define TUNE_MAX_RESIZE 4       // per tune
+
+typedef struct dp_ring_tune_ {
+    dp_context_t *ctx;
+    int thr_id;
+    uint32_t blocks;
+    bool grow;
+} dp_ring_tune_t;
+
+static bool dp_ctx_tunable(dp_context_t *ctx)
+{
+    return !ctx->nfq && !ctx->fanout && !ctx->released && ctx->ring.xsk == NULL && ctx->blocks > 0;
+}
+
+static uint32_t dp_ctx_default_blocks(dp_context_t *ctx)
+{
+    if (ctx->tap) {
+        return TAP_BLOCK;
+    }
+    return ctx->tc ? INLINE_BLOCK : INLINE_BLOCK_NOTC;
+}
+
+// Blocks the ring of the context should have, called with the lock of its thread
+static uint32_t dp_ctx_tune_blocks(dp_context_t *ctx)
+{
+    uint32_t def = dp_ctx_default_blocks(ctx);
+    uint64_t drops;
+    uint8_t peak;
+
+    dp_get_stats(ctx);
+    drops = ctx->stats.rx_drops - ctx->tune_drops;
+    ctx->tune_drops = ctx->stats.rx_drops;
+    peak = CMM_LOAD_SHARED(ctx->rx_peak);
+    CMM_STORE_SHARED(ctx->rx_peak, 0);
+
+    if (drops > 0 || peak >= TUNE_GROW_PEAK) {
+        ctx->tune_idle = 0;
+        return ctx->blocks < def * 4 ? ctx->blocks * 2 : ctx->blocks;
+    }
+    if (peak > 0) {
+        ctx->tune_idle = 0;
+        return ctx->blocks;
+    }
+    // Kept at the threshold until it is resized
+    if (ctx->tune_idle < TUNE_IDLE_RUNS) {
+        ctx->tune_idle ++;
+    }
+    if (ctx->tune_idle < TUNE_IDLE_RUNS) {
+        return ctx->blocks;
+    }
+    return ctx->blocks > def / 4 ? ctx->blocks / 2 : ctx->blocks;
+}
+
+// Open the socket of the new ring on the ctrl thread, in the namespace of a tap, and have
+// the owner of the context swap it in. The owner closes the socket left over.
+static int dp_data_resize_ctx(dp_ring_tune_t *t)
+{
+    dp_context_t *ctx = t->ctx, *nc;
+    io_ctrl_cmd_t cmd;
+    int fd, curns_fd = -1;
+
+    nc = calloc(1, sizeof(*nc));
+    if (nc == NULL) {
+        return -1;
+    }
+
+    if (ctx->tap) {
+        char netns[CTX_NAME_LEN];
+        // The tap name is netns-iface
+        int len = strlen(ctx->name) - strlen(ctx->iface) - 1;
+
+        if (len <= 0) {
+            free(nc);
+            return -1;
+        }
+        memcpy(netns, ctx->name, len);
+        netns[len] = '\0';
+        if ((curns_fd = enter_netns(netns)) < 0) {
+            free(nc);
+            return -1;
+        }
+    }
+
+    set_mem_node(th_numa_node(t->thr_id));
+    fd = dp_open_socket(nc, ctx->iface, ctx->tap, ctx->jumboframe, NULL, t->blocks, ctx->ring.batch);
+    set_mem_node(-1);
+    if (curns_fd >= 0) {
+        restore_netns(curns_fd);
+    }
+    if (fd < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to open dp socket, iface=%s blocks=%u\n", ctx->iface, t->blocks);
+        free(nc);
+        return -1;
+    }
+    nc->fd = fd;
+    nc->blocks = t->blocks;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.req = CTRL_REQ_RESIZE_CTX;
+    cmd.resize.ctx = ctx;
+    cmd.resize.ring_ctx = nc;
+    if (dp_ring_block(nc) < 0 || dp_data_post_ctrl_cmd(&cmd, t->thr_id) < 0) {
+        dp_close_socket(nc);
+        free(nc);
+        return -1;
+    }
+    ctx->tune_idle = 0;
+    return 0;
+}
+
+static uint64_t dp_ring_bytes(struct cds_hlist_head *list)
+{
+    dp_context_t *ctx;
+    struct cds_hlist_node *itr;
+    uint64_t bytes = 0;
+
+    cds_hlist_for_each_entry_rcu(ctx, itr, list, link) {
+        if (!ctx->nfq && ctx->ring.xsk == NULL) {
+            bytes += ctx->ring.map_size;
+        }
+    }
+    return bytes;
+}
+
+static void dp_tune_list(int thr_id, struct cds_hlist_head *list, dp_ring_tune_t *tunes, int *cnt)
+{
+    dp_context_t *ctx;
+    struct cds_hlist_node *itr;
+
+    cds_hlist_for_each_entry_rcu(ctx, itr, list, link) {
+        dp_ring_tune_t *t = NULL;
+        uint32_t blocks;
+        int i;
+
+        if (!dp_ctx_tunable(ctx)) {
+            continue;
+        }
+        blocks = dp_ctx_tune_blocks(ctx);
+        if (blocks == ctx->blocks) {
+            continue;
+        }
+
+        if (*cnt < TUNE_MAX_RESIZE) {
+            t = &tunes[(*cnt) ++];
+        } else if (blocks > ctx->blocks) {
+            // A ring to grow takes the place of one to shrink, which is left for the next tune
+            for (i = 0; i < *cnt; i ++) {
+                if (tunes[i].blocks < tunes[i].ctx->blocks) {
+                    t = &tunes[i];
+                    break;
+                }
+            }
+        }
+        if (t != NULL) {
+            t->ctx = ctx;
+            t->thr_id = thr_id;
+            t->blocks = blocks;
+        }
+    }
+}
+
+// Called by the ctrl thread periodically
+void dp_data_tune_rings(void)
+{
+    dp_ring_tune_t tunes[TUNE_MAX_RESIZE];
+    uint64_t bytes = 0, limit = (uint64_t)g_ring_mem_limit << 20;
+    int thr_id, cnt = 0, i;
 
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_sec += CTRL_DLP_REQ_TIMEOUT;
+    for (thr_id = 0; thr_id < g_dp_threads; thr_id ++) {
+        if (!CMM_LOAD_SHARED(th_ready(thr_id))) {
+            continue;
+        }
+        pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+        bytes += dp_ring_bytes(&th_ctx_list(thr_id));
+        bytes += dp_ring_bytes(&th_notc_nfq_ctx_list(thr_id));
+        dp_tune_list(thr_id, &th_ctx_list(thr_id), tunes, &cnt);
+        dp_tune_list(thr_id, &th_notc_nfq_ctx_list(thr_id), tunes, &cnt);
+        pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+    }
+
+    // Shrink first, so the memory is there for the rings to grow. The size changes by half
+    // or double, the rings resized may still be draining.
+    for (i = 0; i < cnt; i ++) {
+        dp_ring_tune_t *t = &tunes[i];
+        uint64_t size = t->ctx->ring.map_size;
+
+        t->grow = t->blocks > t->ctx->blocks;
+        if (!t->grow && dp_data_resize_ctx(t) == 0) {
+            bytes -= size / 2;
+        }
+    }
+    for (i = 0; i < cnt; i ++) {
+        dp_ring_tune_t *t = &tunes[i];
+        uint64_t size = t->ctx->ring.map_size;
+
+        if (!t->grow) {
+            continue;
+        }
+        if (bytes + size > limit) {
+            DEBUG_CTRL("ring memory limit, ctx=%s blocks=%u bytes=%lu\n", t->ctx->name, t->ctx->blocks, bytes);
+            continue;
+        }
+        if (dp_data_resize_ctx(t) == 0) {
+            bytes += size;
+        }
+    }
+}
+
+// Start threads up to 'threads', or retire the threads above it. Retired threads keep running
+// for their fanout sockets, nfq queues and draining sessions, but get no more taps.
+int dp_data_set_threads(int threads)
+{
+    int thr_id, wait;
+
+    if (threads < 1 || threads > MAX_DP_THREADS) {
+        return -1;
+    }
 
-        rc = pthread_cond_timedwait(&g_dlp_ctrl_req_cond, &g_dlp_ctrl_req_lock, &ts);
-        if (rc == 0) {
+    for (thr_id = g_dp_threads; thr_id < threads; thr_id ++) {
+        if (dp_start_data_thread(thr_id) < 0) {
             break;
         }
-        if (rc == ETIMEDOUT) {
-            DEBUG_CTRL("timeout: wait dlp thread\n");
+        for (wait = 0; wait < CTRL_REQ_TIMEOUT * 1000 / THREAD_READY_WAIT; wait ++) {
+            if (CMM_LOAD_SHARED(th_ready(thr_id))) {
+                break;
+            }
+            usleep(THREAD_READY_WAIT * 1000);
+        }
+        if (!CMM_LOAD_SHARED(th_ready(thr_id))) {
+            DEBUG_ERROR(DBG_CTRL, "dp thread is not ready, thr_id=%d\n", thr_id);
             break;
         }
+        // Only count the thread once it takes commands
+        CMM_STORE_SHARED(g_dp_threads, thr_id + 1);
     }
 
-    return rc;
+    CMM_STORE_SHARED(g_dp_active_threads, min(threads, g_dp_threads));
+    DEBUG_CTRL("threads=%d active=%d\n", g_dp_threads, g_dp_active_threads);
+
+    dp_data_evacuate();
+    return g_dp_active_threads == threads ? 0 : -1;
 }
 
-int dp_dlp_wait_ctrl_req_thr(int req)
+// Wake up the dlp thread, the requests are queued with the detectors
+int dp_dlp_kick_ctrl_req(void)
 {
     uint64_t w = 1;
-    ssize_t s;
-    int rc = 0;
 
-    DEBUG_CTRL("dlp req=%d\n", req);
-
-    pthread_mutex_lock(&g_dlp_ctrl_req_lock);
-    bld_dlp_ctrl_req = req;
-    s  = write(bld_dlp_ctrl_req_evfd, &w, sizeof(uint64_t));
-    if (s != sizeof(uint64_t)) {
-        pthread_mutex_unlock(&g_dlp_ctrl_req_lock);
+    if (write(bld_dlp_ctrl_req_evfd, &w, sizeof(uint64_t)) != sizeof(uint64_t)) {
+        // The request is queued, it runs at the next kick.
+        DEBUG_CTRL("fail to kick dlp thread\n");
         return -1;
     }
-    rc = dp_ctrl_wait_dlp_threads();
-    bld_dlp_ctrl_req = 0;
-    pthread_mutex_unlock(&g_dlp_ctrl_req_lock);
-    return rc;
+    return 0;
 }
 
 
@@ -759,7 +1772,7 @@ void dp_data_set_ctrl_req(int req)
 }
 #endif
 
-static dp_context_t *dp_add_ctrl_req_event(int thr_id)
+static dp_context_t *dp_add_event(int thr_id)
 {
     int fd;
     dp_context_t *ctx;
@@ -773,7 +1786,7 @@ static dp_context_t *dp_add_ctrl_req_event(int thr_id)
 
     fd = eventfd(0, 0);
     if (fd < 0) {
-        DEBUG_ERROR(DBG_CTRL, "fail to create dp_ctrl_req event fd.\n");
+        DEBUG_ERROR(DBG_CTRL, "fail to create event fd.\n");
         free(ctx);
         return NULL;
     }
@@ -796,8 +1809,24 @@ static dp_context_t *dp_add_ctrl_req_event(int thr_id)
         return NULL;
     }
 
-    th_ctrl_req_evfd(thr_id) = fd;
+    return ctx;
+}
+
+static dp_context_t *dp_add_ctrl_req_event(int thr_id)
+{
+    dp_context_t *ctx = dp_add_event(thr_id);
+    if (ctx != NULL) {
+        th_ctrl_req_evfd(thr_id) = ctx->fd;
+    }
+    return ctx;
+}
 
+static dp_context_t *dp_add_handoff_event(int thr_id)
+{
+    dp_context_t *ctx = dp_add_event(thr_id);
+    if (ctx != NULL) {
+        th_handoff_evfd(thr_id) = ctx->fd;
+    }
     return ctx;
 }
 
@@ -855,6 +1884,140 @@ static inline struct timespec ts_diff(struct timespec s, struct timespec e)
     return d;
 }
 
+static inline uint32_t dp_rx_count(int thr_id, dp_context_t *ctx, int ret)
+{
+    uint32_t cnt;
+
+    if (ret == DP_RX_MORE) {
+        cnt = ctx->nfq ? ctx->nfq_ctx.batch : ctx->ring.batch;
+    } else {
+        cnt = ret > 0 ? ret : 0;
+    }
+    ctx->rx_pkts += cnt;
+    th_sched_pkts(thr_id) += cnt;
+    return cnt;
+}
+
+static inline uint64_t dp_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// -- overload
+
+// The thread is behind in a window of 10ms when a batch took over 2ms, when half of the full
+// batches found the ring half filled ahead, or when it was busy for 95% of the window and
+// still had full batches. The ring occupancy isn't known for nfq and AF_XDP contexts, they
+// count on the batch and busy time. The overload mode starts after 3 windows behind in a row
+// and ends after a second without, see dpi_overload() for what it sheds.
+#define OVERLOAD_WINDOW_NS  10000000
+#define OVERLOAD_SLOW_NS    2000000
+#define OVERLOAD_BUSY       950         // permille
+#define OVERLOAD_ENTER      3
+#define OVERLOAD_CALM_NS    1000000000
+#define OVERLOAD_SESSIONS   10          // new sessions admitted per window
+
+static int dp_rx_timed(int thr_id, dp_context_t *ctx)
+{
+    dp_overload_t *o = &th_overload(thr_id);
+    uint64_t start = dp_now_ns();
+    int ret = dp_rx(ctx, g_seconds);
+
+    o->polls ++;
+    if (ret == DP_RX_MORE) {
+        uint32_t filled = dp_rx_backlog(ctx);
+
+        o->full ++;
+        if (filled >= 2) {
+            o->backlog ++;
+        }
+        if (filled > ctx->rx_peak) {
+            CMM_STORE_SHARED(ctx->rx_peak, filled);
+        }
+    }
+    if (unlikely(dp_now_ns() - start > OVERLOAD_SLOW_NS)) {
+        o->slow ++;
+    }
+    return ret;
+}
+
+static void dp_check_overload(int thr_id, uint64_t now)
+{
+    dp_overload_t *o = &th_overload(thr_id);
+    uint64_t window = now - o->window_start;
+    bool behind;
+
+    behind = o->slow > 0 ||
+             (o->backlog > 0 && o->backlog * 2 >= o->full) ||
+             (o->full > 0 && o->busy_ns * 1000 >= window * OVERLOAD_BUSY);
+
+    if (behind) {
+        o->behind_at = now;
+        if (!o->on && ++ o->behind >= OVERLOAD_ENTER) {
+            o->on = true;
+            CMM_STORE_SHARED(th_overload_since(thr_id), g_seconds);
+            CMM_STORE_SHARED(th_overload_enters(thr_id), th_overload_enters(thr_id) + 1);
+            CMM_STORE_SHARED(th_overloaded(thr_id), 1);
+        }
+    } else {
+        o->behind = 0;
+        if (o->on && now - o->behind_at >= OVERLOAD_CALM_NS) {
+            o->on = false;
+            CMM_STORE_SHARED(th_overload_seconds(thr_id), g_seconds - th_overload_since(thr_id));
+            CMM_STORE_SHARED(th_overloaded(thr_id), 0);
+        }
+    }
+    dpi_overload(o->on, OVERLOAD_SESSIONS);
+
+    o->window_start = now;
+    o->busy_ns = 0;
+    o->polls = o->full = o->backlog = o->slow = 0;
+}
+
+// Packet rate of each context, for rebalancing
+static void dp_roll_ctx_rate(struct cds_hlist_head *list, uint32_t elapsed)
+{
+    dp_context_t *ctx;
+    struct cds_hlist_node *itr;
+
+    cds_hlist_for_each_entry_rcu(ctx, itr, list, link) {
+        ctx->rx_pps = ctx->rx_pkts / elapsed;
+        ctx->rx_pkts = 0;
+        if (ctx->drain_flows != NULL && g_seconds >= ctx->drain_until) {
+            free(ctx->drain_flows);
+            ctx->drain_flows = NULL;
+        }
+    }
+}
+
+// Keep busy polling the inline context after it drains, for a number of empty loops that
+// grows with the recent arrival rate. An empty loop costs about a zero-timeout epoll_wait.
+#define SCHED_PPS_PER_SPIN 1000
+#define SCHED_MAX_SPIN     2000
+static bool dp_sched_spin(int thr_id, int ret)
+{
+    uint32_t budget;
+
+    if (ret > 0) {
+        th_sched_idle(thr_id) = 0;
+    } else {
+        th_sched_idle(thr_id) ++;
+    }
+
+    switch (g_sched_policy) {
+    case DP_SCHED_POLL:
+        return true;
+    case DP_SCHED_INTERRUPT:
+        return false;
+    default:
+        budget = min(th_sched_pps(thr_id) / SCHED_PPS_PER_SPIN, SCHED_MAX_SPIN);
+        return th_sched_idle(thr_id) < budget;
+    }
+}
+
 void *dp_data_thr(void *args)
 {
     struct epoll_event epoll_evs[MAX_EPOLL_EVENTS];
@@ -867,6 +2030,15 @@ void *dp_data_thr(void *args)
     THREAD_ID = thr_id;
     snprintf(THREAD_NAME, MAX_THREAD_NAME_LEN, "dp%u", thr_id);
 
+    // Pin before per-thread init so the thread's own data is first touched on its node
+    if (th_cpu(thr_id) >= 0) {
+        if (pin_thread_cpus(&th_cpu(thr_id), 1) < 0) {
+            DEBUG_ERROR(DBG_INIT, "failed to pin thread to cpu %d\n", th_cpu(thr_id));
+        } else {
+            DEBUG_INIT("pinned to cpu %d, node %d\n", th_cpu(thr_id), th_numa_node(thr_id));
+        }
+    }
+
     // Create epoll, add ctrl_req event
     if ((th_epoll_fd(thr_id) = epoll_create(MAX_EPOLL_EVENTS)) < 0) {
         DEBUG_INIT("failed to create epoll, thr_id=%u\n", thr_id);
@@ -877,9 +2049,13 @@ void *dp_data_thr(void *args)
     if (ctrl_req_ev_ctx == NULL) {
         return NULL;
     }
+    if (dp_add_handoff_event(thr_id) == NULL) {
+        return NULL;
+    }
 
     rcu_register_thread();
 
+    g_shm->dp_stage[thr_id].tid = syscall(SYS_gettid);
     g_shm->dp_active[thr_id] = true;
 
     pthread_mutex_init(&th_ctrl_dp_lock(thr_id), NULL);
@@ -888,7 +2064,12 @@ void *dp_data_thr(void *args)
     timer_queue_init(&th_ctx_free_list(thr_id), RELEASED_CTX_TIMEOUT);
 
     // Per-thread init
+    mem_acct_bind(thr_id);
+    dp_arena_thread_init(thr_id);
+    th_tlb_fd(thr_id) = dp_huge_tlb_open();
     dpi_init(DPI_INIT);
+    dpi_stage_attach(&g_shm->dp_stage[thr_id]);
+    CMM_STORE_SHARED(th_ready(thr_id), true);
 
     DEBUG_INIT("dp thread starts\n");
 
@@ -900,15 +2081,31 @@ void *dp_data_thr(void *args)
     // worsen the latency, such as ping latency in protect mode.
     tmo = SHORT_WAIT;
     uint32_t last_seconds = g_seconds;
+    // Time out of epoll_wait counts as busy when packets are handled in it
+    uint64_t seg_start = dp_now_ns();
+    uint32_t seg_rx = 0;
+    // Housekeeping runs once a second, each thread at its own offset into the second, so the
+    // work doesn't hit all cores at the same instant. Less frequent tasks start apart as well.
+    uint64_t hk_offset = (uint64_t)thr_id * HOUSEKEEPING_SPREAD / max(g_dp_threads, 1), hk_due = 0;
+    uint32_t seen_seconds = g_seconds;
+    // Timers have millisecond resolution, the wheel is rolled as the second goes by
+    uint64_t second_start = seg_start;
+    uint32_t last_ms = seen_seconds * 1000;
+    bool timer_behind = false;
+    int slot_tick = 0, ctx_tick = thr_id % RELEASED_CTX_PRUNE_FREQ, stats_tick = thr_id % DP_STATS_FREQ;
     while (g_running) {
         // Check if polling context exist, if yes, keep polling it.
         dp_context_t *polling_ctx = th_ctx_inline(thr_id);
         if (likely(polling_ctx != NULL)) {
-            if (likely(dp_rx(polling_ctx, g_seconds) == DP_RX_MORE)) {
-                // If there are more packets to consume, not to add polling context to epoll,
-                // use no-wait time out so we can get back to polling right away.
+            int ret = dp_rx_timed(thr_id, polling_ctx);
+            seg_rx += dp_rx_count(thr_id, polling_ctx, ret);
+            if (likely(ret == DP_RX_MORE) || dp_sched_spin(thr_id, ret)) {
+                // If there are more packets to consume, or packets are likely soon, not to add
+                // polling context to epoll, use no-wait time out so we can get back to polling
+                // right away.
                 tmo = NO_WAIT;
                 polling_ctx = NULL;
+                th_sched_mode(thr_id) = DP_SCHED_MODE_POLL;
             } else {
                 // If all packets are consumed, add polling context to epoll, so once there is
                 // a packet, it can be handled.
@@ -918,23 +2115,52 @@ void *dp_data_thr(void *args)
                 } else {
                     tmo = LONG_WAIT;
                 }
+                th_sched_mode(thr_id) = DP_SCHED_MODE_INTR;
             }
         }
-        struct cds_hlist_node *titr, *tnext;
-        dp_context_t *notc_nfq_ctx;
-        pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
-        cds_hlist_for_each_entry_safe(notc_nfq_ctx, titr, tnext, &th_notc_nfq_ctx_list(thr_id), link) {
-            dp_rx(notc_nfq_ctx, g_seconds);
-        }
-        pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
+        // nfq and no-tc port pair contexts are always in epoll, they are handled on readiness.
 
         int i, evs;
+        uint64_t now = dp_now_ns();
+        if (seg_rx > 0) {
+            th_busy_ns(thr_id) += now - seg_start;
+            th_overload(thr_id).busy_ns += now - seg_start;
+        }
+        if (unlikely(now - th_overload(thr_id).window_start >= OVERLOAD_WINDOW_NS)) {
+            dp_check_overload(thr_id, now);
+        }
+        if (unlikely(g_seconds != seen_seconds)) {
+            seen_seconds = g_seconds;
+            second_start = now;
+            hk_due = now + hk_offset;
+        }
+        uint32_t now_ms = seen_seconds * 1000 + min((now - second_start) / 1000000, 999);
+        // Expiry left over by the roll budget goes on in the next pass, after the next batch
+        if (now_ms != last_ms || unlikely(timer_behind)) {
+            last_ms = now_ms;
+            timer_behind = dpi_timer_roll(now_ms);
+        }
+        if (unlikely(hk_due != 0) && tmo > 0) {
+            tmo = min(tmo, hk_due > now ? (hk_due - now) / 1000000 : 0);
+        }
+        if (unlikely(timer_behind)) {
+            tmo = NO_WAIT;
+        }
+        dpi_reset_flush();
+        dp_ctrl_connect_flush();
         evs = epoll_wait(th_epoll_fd(thr_id), epoll_evs, MAX_EPOLL_EVENTS, tmo);
+        seg_start = dp_now_ns();
+        seg_rx = 0;
         if (evs > 0) {
             for (i = 0; i < evs; i ++) {
                 struct epoll_event *ee = &epoll_evs[i];
                 dp_context_t *ctx = ee->data.ptr;
 
+                // Moved to another thread by a command handled in this batch
+                if (unlikely(ctx->thr_id != thr_id)) {
+                    continue;
+                }
+
                 if ((ee->events & EPOLLHUP) || (ee->events & EPOLLERR)) {
                     // When switch mode, port is pulled first, then epoll error happens first.
                     // ctx is more likely to be released here
@@ -953,15 +2179,18 @@ void *dp_data_thr(void *args)
                 } else if (ee->events & EPOLLIN) {
                     if (ctx->fd == th_ctrl_req_evfd(thr_id)) {
                         uint64_t cnt;
+                        io_ctx_t context;
                         read(ctx->fd, &cnt, sizeof(uint64_t));
-                        if (th_ctrl_req(thr_id)) {
-                            io_ctx_t context;
-                            context.tick = g_seconds;
-                            context.tap = ctx->tap;
-                            dpi_handle_ctrl_req(th_ctrl_req(thr_id), &context);
-                        }
+                        context.tick = g_seconds;
+                        context.tap = ctx->tap;
+                        context.rx_ns = 0;
+                        dp_run_ctrl_cmds(thr_id, &context);
+                    } else if (ctx->fd == th_handoff_evfd(thr_id)) {
+                        uint64_t cnt;
+                        read(ctx->fd, &cnt, sizeof(uint64_t));
+                        seg_rx += dp_drain_handoff(thr_id);
                     } else {
-                        dp_rx(ctx, g_seconds);
+                        seg_rx += dp_rx_count(thr_id, ctx, dp_rx_timed(thr_id, ctx));
                     }
                 }
             }
@@ -971,38 +2200,62 @@ void *dp_data_thr(void *args)
             dp_epoll_remove_ctx(polling_ctx);
         }
 
-        if (unlikely(g_seconds - last_seconds >= 1)) {
+        if (unlikely(hk_due != 0) && seg_start >= hk_due) {
+            hk_due = 0;
+
             // Only one thread update the global variable
             if (thr_id == 0) {
-                static int stats_tick = 0;
-                if (++ stats_tick >= STATS_INTERVAL) {
+                if (++ slot_tick >= STATS_INTERVAL) {
                     g_stats_slot ++;
-                    stats_tick = 0;
+                    slot_tick = 0;
                 }
             }
 
-            static int ctx_tick = 0;
             if (++ ctx_tick >= RELEASED_CTX_PRUNE_FREQ) {
                 timer_queue_trim(&th_ctx_free_list(thr_id), g_seconds, dp_remove_context);
                 ctx_tick = 0;
             }
 
-            static int stats_tick = 0;
-            if (++ stats_tick >= DP_STATS_FREQ) {
-                pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+            uint32_t elapsed = g_seconds - last_seconds;
+            uint32_t load = min(th_busy_ns(thr_id) / ((uint64_t)elapsed * 1000000), 1000);
+            dp_stats_t ring;
+
+            memset(&ring, 0, sizeof(ring));
+
+            pthread_mutex_lock(&th_ctrl_dp_lock(thr_id));
+            // The stats page is scraped at any time, keep its ring counters a second old at most
+            if (++ stats_tick >= DP_STATS_FREQ || g_stats_shm != NULL) {
                 dp_refresh_stats(&th_ctx_list(thr_id));
                 dp_refresh_stats(&th_notc_nfq_ctx_list(thr_id));
-                pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
                 stats_tick = 0;
             }
+            if (g_stats_shm != NULL) {
+                dp_sum_ring_stats(&ring, &th_ctx_list(thr_id));
+                dp_sum_ring_stats(&ring, &th_notc_nfq_ctx_list(thr_id));
+            }
+            dp_roll_ctx_rate(&th_ctx_list(thr_id), elapsed);
+            pthread_mutex_unlock(&th_ctrl_dp_lock(thr_id));
 
             dpi_timeout(g_seconds);
+            dp_publish_stats(thr_id, load);
+            th_busy_ns(thr_id) = 0;
+
+            ring.handoff = th_handoff_pkts(thr_id);
+            ring.handoff_drops = th_handoff_drops(thr_id);
+            dp_ctrl_publish_stats(thr_id, &ring, load);
+
+            // Arrival rate of the last second drives the spin budget
+            th_sched_pps(thr_id) = th_sched_pkts(thr_id) / elapsed;
+            th_sched_pkts(thr_id) = 0;
+            g_shm->dp_sched_mode[thr_id] = th_sched_mode(thr_id);
 
             // Update heartbeat
             g_shm->dp_hb[thr_id] ++;
 
             last_seconds = g_seconds;
         }
+        dpi_reset_flush();
+        dp_ctrl_connect_flush();
     }
 
     close(th_epoll_fd(thr_id));
@@ -1036,6 +2289,7 @@ void *dp_bld_dlp_thr(void *args)
     dp_bld_dlp_context_t *ctrl_dlp_req_ev_ctx;
 
     snprintf(THREAD_NAME, MAX_THREAD_NAME_LEN, "dlp");
+    pin_thread_other_cpus(g_dp_cpus, g_dp_cpu_cnt);
 
     // Create epoll, add ctrl_req event
     if ((bld_dlp_epoll_fd = epoll_create(MAX_EPOLL_EVENTS)) < 0) {
@@ -1064,9 +2318,7 @@ void *dp_bld_dlp_thr(void *args)
                     if (ctx->fd == bld_dlp_ctrl_req_evfd) {
                         uint64_t cnt;
                         read(ctx->fd, &cnt, sizeof(uint64_t));
-                        if (bld_dlp_ctrl_req) {
-                            dpi_handle_dlp_ctrl_req(bld_dlp_ctrl_req);
-                        }
+                        dpi_handle_dlp_ctrl_req();
                     }
                 }
             }
@@ -1086,6 +2338,7 @@ void *dp_bld_dlp_thr(void *args)
 void *dp_timer_thr(void *args)
 {
     snprintf(THREAD_NAME, MAX_THREAD_NAME_LEN, "tmr");
+    pin_thread_other_cpus(g_dp_cpus, g_dp_cpu_cnt);
     g_start_time = time(NULL);
     while (g_running) {
         sleep(1);
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "urcu.h"
+
+#include "main.h"
+#include "apis.h"
+#include "debug.h"
+#include "utils/helper.h"
+
+// Objects unpublished by the ctrl thread are queued here instead of waiting for readers in
+// synchronize_rcu() one by one. The reclaimer takes the whole queue, waits for a single grace
+// period and frees the batch; what is queued in the meantime goes in the next batch. An
+// object that can't be queued, or queued while the reclaimer is not running, is freed
+// inline after its own grace period.
+
+typedef struct reclaim_entry_ {
+    struct reclaim_entry_ *next;
+    dp_reclaim_fct fct;
+    void *ptr;
+} reclaim_entry_t;
+
+static reclaim_entry_t *g_reclaim_head;
+static reclaim_entry_t **g_reclaim_tail = &g_reclaim_head;
+static pthread_mutex_t g_reclaim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_reclaim_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t g_reclaim_thr;
+static bool g_reclaim_thr_create;
+static bool g_reclaim_running;
+static dp_reclaim_stats_t g_reclaim_stats;
+
+void dp_reclaim_defer(dp_reclaim_fct fct, void *ptr)
+{
+    reclaim_entry_t *e;
+
+    pthread_mutex_lock(&g_reclaim_lock);
+    if (g_reclaim_running && (e = malloc(sizeof(*e))) != NULL) {
+        e->next = NULL;
+        e->fct = fct;
+        e->ptr = ptr;
+        *g_reclaim_tail = e;
+        g_reclaim_tail = &e->next;
+        g_reclaim_stats.depth ++;
+        if (g_reclaim_stats.depth > g_reclaim_stats.high_water) {
+            g_reclaim_stats.high_water = g_reclaim_stats.depth;
+        }
+        pthread_cond_signal(&g_reclaim_cond);
+        pthread_mutex_unlock(&g_reclaim_lock);
+        return;
+    }
+    pthread_mutex_unlock(&g_reclaim_lock);
+
+    synchronize_rcu();
+    fct(ptr);
+}
+
+void dp_reclaim_stats(dp_reclaim_stats_t *s)
+{
+    pthread_mutex_lock(&g_reclaim_lock);
+    *s = g_reclaim_stats;
+    pthread_mutex_unlock(&g_reclaim_lock);
+}
+
+// Returns the number of objects freed
+static int reclaim_batch(reclaim_entry_t *batch)
+{
+    reclaim_entry_t *next;
+    int cnt = 0;
+
+    synchronize_rcu();
+
+    for (; batch != NULL; batch = next) {
+        next = batch->next;
+        batch->fct(batch->ptr);
+        free(batch);
+        cnt ++;
+    }
+    return cnt;
+}
+
+static void *dp_reclaim_thr(void *args)
+{
+    reclaim_entry_t *batch;
+    bool running;
+    int cnt;
+
+    snprintf(THREAD_NAME, MAX_THREAD_NAME_LEN, "rcl");
+    pin_thread_other_cpus(g_dp_cpus, g_dp_cpu_cnt);
+
+    rcu_register_thread();
+
+    pthread_mutex_lock(&g_reclaim_lock);
+    do {
+        while (g_reclaim_running && g_reclaim_head == NULL) {
+            pthread_cond_wait(&g_reclaim_cond, &g_reclaim_lock);
+        }
+        running = g_reclaim_running;
+        batch = g_reclaim_head;
+        g_reclaim_head = NULL;
+        g_reclaim_tail = &g_reclaim_head;
+        pthread_mutex_unlock(&g_reclaim_lock);
+
+        cnt = batch != NULL ? reclaim_batch(batch) : 0;
+
+        pthread_mutex_lock(&g_reclaim_lock);
+        if (cnt > 0) {
+            g_reclaim_stats.depth -= cnt;
+            g_reclaim_stats.batches ++;
+            g_reclaim_stats.freed += cnt;
+        }
+    } while (running);
+    pthread_mutex_unlock(&g_reclaim_lock);
+
+    rcu_unregister_thread();
+    return NULL;
+}
+
+int dp_reclaim_start(void)
+{
+    pthread_mutex_lock(&g_reclaim_lock);
+    g_reclaim_running = true;
+    pthread_mutex_unlock(&g_reclaim_lock);
+
+    if (pthread_create(&g_reclaim_thr, NULL, dp_reclaim_thr, NULL) != 0) {
+        pthread_mutex_lock(&g_reclaim_lock);
+        g_reclaim_running = false;
+        pthread_mutex_unlock(&g_reclaim_lock);
+        DEBUG_ERROR(DBG_INIT, "fail to start reclaimer, free inline\n");
+        return -1;
+    }
+    g_reclaim_thr_create = true;
+    return 0;
+}
+
+// Free what is queued, later objects are freed inline
+void dp_reclaim_stop(void)
+{
+    if (g_reclaim_thr_create) {
+        pthread_mutex_lock(&g_reclaim_lock);
+        g_reclaim_running = false;
+        pthread_cond_signal(&g_reclaim_cond);
+        pthread_mutex_unlock(&g_reclaim_lock);
+        pthread_join(g_reclaim_thr, NULL);
+        g_reclaim_thr_create = false;
+    }
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
@@ -9,6 +10,14 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <linux/filter.h>
+#include <linux/ethtool.h>
+#include <linux/sockios.h>
+#include <netinet/if_ether.h>
+#include <netinet/ip.h>
+#include <netinet/ip6.h>
+#include <netinet/tcp.h>
 
 #include "urcu.h"
 #include "urcu/rcuhlist.h"
@@ -17,11 +26,18 @@
 #include "apis.h"
 #include "debug.h"
 #include "utils/helper.h"
+#include "utils/cksum.h"
 
 extern dp_context_t *dp_inline_context();
+extern int dp_open_xsk(dp_context_t *ctx, const char *iface, dp_context_t *share_ctx, uint blocks, uint batch);
+extern void dp_close_xsk(dp_context_t *ctx);
+extern void dp_xsk_tx_kick(dp_context_t *ctx);
+extern bool dp_handoff_packet(dp_context_t *ctx, uint8_t *pkt, int len);
+extern bool dp_drain_packet(dp_context_t *ctx, uint8_t *pkt, int len);
+extern io_config_t g_config;
+extern uint32_t g_lat_sample;
 
-#define MAX_TSO_SIZE 65536
-static uint8_t g_tso_packet[MAX_TSO_SIZE];
+#define th_tso_packet(thr_id) (g_dp_thread_data[thr_id].tso_packet)
 
 #define ERR_UNSUPPORT_v3 (-255)
 
@@ -33,6 +49,8 @@ static uint8_t g_tso_packet[MAX_TSO_SIZE];
 
 #define FRAME_SIZE_V3 (1024 * 2)
 #define BLOCK_SIZE_V3 (1024 * 64)
+// Block of V3 packs frames of any size, so GRO/TSO super frames fit in the ring.
+#define BLOCK_SIZE_GRO_V3 (1024 * 128)
 
 static int dp_ring_bind(int fd, const char *iface)
 {
@@ -48,26 +66,197 @@ static int dp_ring_bind(int fd, const char *iface)
     return bind(fd, (struct sockaddr *)&ll, sizeof(ll));
 }
 
+static inline uint32_t dp_tx_frame_room(dp_context_t *ctx)
+{
+    return (ctx->jumboframe ? FRAME_SIZE_JUMBO_V1 : FRAME_SIZE_V1) - TPACKET3_HDRLEN;
+}
+
+// Packets of a block kept for dpi_recv_batch()
+#define DP_RX_BATCH 64
+
+static inline bool dp_rx_check(dp_context_t *ctx, uint8_t *pkt, int len)
+{
+    if (unlikely(dp_rx_quar_drop(ctx, pkt, len))) {
+        return false;
+    }
+    // Fanout socket may get a flow owned by another thread
+    if (unlikely(ctx->fanout) && dp_handoff_packet(ctx, pkt, len)) {
+        return false;
+    }
+    // Moved context, sessions of the previous thread are not drained yet
+    if (unlikely(ctx->drain_flows != NULL) && dp_drain_packet(ctx, pkt, len)) {
+        return false;
+    }
+    return true;
+}
+
 static void dp_tx_flush(dp_context_t *ctx, int limit)
 {
     //DEBUG_PACKET("pending=%u limit=%u\n", ctx->tx_pending, limit);
 
     if (ctx->tx_pending >= limit && ctx->tx_pending > 0) {
-        send(ctx->fd, NULL, 0, 0);
+        if (ctx->ring.xsk != NULL) {
+            dp_xsk_tx_kick(ctx);
+        } else {
+            send(ctx->fd, NULL, 0, 0);
+        }
         ctx->stats.tx += ctx->tx_pending;
         ctx->tx_pending = 0;
     }
 }
 
+// Software GSO. A GRO/TSO frame of TCP is split into segments of the interface MTU, which are
+// built straight into the TX ring slots, instead of being sent as one frame by send(). The
+// IPv4 header checksum is updated incrementally for the new length and id. The checksum of a
+// GRO frame from the packet socket may only cover the pseudo header, so the TCP checksum of
+// each segment is computed over the segment.
+#define DP_TH_CWR 0x80
+
+typedef uint8_t *(*dp_tx_slot_fct)(dp_context_t *ctx);
+typedef void (*dp_tx_commit_fct)(dp_context_t *ctx, int len);
+
+// Returns 0 if the frame can't be segmented, -1 if the ring fills up, the length sent otherwise
+static int dp_tx_segment(dp_context_t *ctx, uint8_t *pkt, int len,
+                         dp_tx_slot_fct slot, dp_tx_commit_fct commit)
+{
+    struct ethhdr *eth = (struct ethhdr *)pkt;
+    struct iphdr *iph = NULL;
+    struct ip6_hdr *ip6h = NULL;
+    struct tcphdr *tcph;
+    uint32_t l2 = sizeof(struct ethhdr), l3;
+    uint16_t proto = eth->h_proto;
+
+    if (proto == htons(ETH_P_8021Q)) {
+        if (len < l2 + 4) return 0;
+        proto = *(uint16_t *)(pkt + l2 + 2);
+        l2 += 4;
+    }
+
+    if (proto == htons(ETH_P_IP)) {
+        if (len < l2 + sizeof(struct iphdr)) return 0;
+        iph = (struct iphdr *)(pkt + l2);
+        if (iph->protocol != IPPROTO_TCP || (iph->frag_off & htons(IP_MF | IP_OFFMASK))) return 0;
+        l3 = iph->ihl * 4;
+    } else if (proto == htons(ETH_P_IPV6)) {
+        if (len < l2 + sizeof(struct ip6_hdr)) return 0;
+        ip6h = (struct ip6_hdr *)(pkt + l2);
+        // GRO does not merge packets with extension headers
+        if (ip6h->ip6_nxt != IPPROTO_TCP) return 0;
+        l3 = sizeof(struct ip6_hdr);
+    } else {
+        return 0;
+    }
+
+    if (len < l2 + l3 + sizeof(struct tcphdr)) return 0;
+    tcph = (struct tcphdr *)(pkt + l2 + l3);
+    uint32_t l4 = tcph->doff * 4;
+    uint32_t hdr_len = l2 + l3 + l4;
+    uint32_t room = min(ctx->mtu + l2, dp_tx_frame_room(ctx));
+    if (len <= hdr_len || room <= hdr_len) return 0;
+
+    uint32_t mss = room - hdr_len;
+    uint32_t seq = ntohl(tcph->seq);
+    uint16_t id = iph != NULL ? ntohs(iph->id) : 0;
+    uint32_t off;
+
+    for (off = hdr_len; off < len; off += mss) {
+        uint32_t seg = min(mss, len - off);
+        uint8_t *data = slot(ctx);
+        if (data == NULL) {
+            DEBUG_PACKET("TX queue full, segment at %u of len=%u Drop!\n", off, len);
+
+            ctx->stats.tx_drops ++;
+            return -1;
+        }
+
+        memcpy(data, pkt, hdr_len);
+        memcpy(data + hdr_len, pkt + off, seg);
+
+        struct tcphdr *t = (struct tcphdr *)(data + l2 + l3);
+        uint16_t l4_len = l4 + seg;
+        uint32_t sum;
+
+        t->seq = htonl(seq + off - hdr_len);
+        // CWR goes with the first segment, FIN and PSH with the last, as the kernel does
+        if (off != hdr_len) {
+            t->th_flags &= ~DP_TH_CWR;
+        }
+        if (off + seg < len) {
+            t->th_flags &= ~(TH_FIN | TH_PUSH);
+        }
+
+        if (iph != NULL) {
+            struct iphdr *ip = (struct iphdr *)(data + l2);
+            uint16_t tot_len = htons(l3 + l4_len);
+            uint16_t ip_id = htons(id ++);
+
+            ip->check = cksum_update16(ip->check, ip->tot_len, tot_len);
+            ip->tot_len = tot_len;
+            ip->check = cksum_update16(ip->check, ip->id, ip_id);
+            ip->id = ip_id;
+            sum = cksum_partial(&ip->saddr, 8, 0);
+        } else {
+            struct ip6_hdr *ip6 = (struct ip6_hdr *)(data + l2);
+
+            ip6->ip6_plen = htons(l4_len);
+            sum = cksum_partial(&ip6->ip6_src, 32, 0);
+        }
+        sum += htons(IPPROTO_TCP) + htons(l4_len);
+        t->check = 0;
+        t->check = cksum_finish(cksum_partial(t, l4_len, sum));
+
+        commit(ctx, hdr_len + seg);
+    }
+
+    DEBUG_PACKET("Sent large frame: len=%u in %u segments to %s\n",
+                 len, (len - hdr_len + mss - 1) / mss, ctx->name);
+    return len;
+}
+
+// Data of the next TX slot, NULL if the ring is full
+static uint8_t *dp_tx_slot_v1(dp_context_t *ctx)
+{
+    dp_ring_t *ring = &ctx->ring;
+    struct tpacket_hdr *tp = (struct tpacket_hdr *)(ring->tx_map + ring->tx_offset);
+
+    if ((tp->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) != 0) {
+        DEBUG_PACKET("TX queue full, status=0x%x\n", tp->tp_status);
+        return NULL;
+    }
+    return (uint8_t *)tp + TPACKET_HDRLEN - sizeof(struct sockaddr_ll);
+}
+
+static void dp_tx_commit_v1(dp_context_t *ctx, int len)
+{
+    dp_ring_t *ring = &ctx->ring;
+    struct tpacket_hdr *tp = (struct tpacket_hdr *)(ring->tx_map + ring->tx_offset);
+
+    tp->tp_len = len;
+
+    tp->tp_status = TP_STATUS_SEND_REQUEST;
+    ctx->tx_pending ++;
+
+    if (!ctx->tap && ctx->jumboframe) {
+        ring->tx_offset = (ring->tx_offset + FRAME_SIZE_JUMBO_V1) & (ring->size - 1);
+    } else {
+        ring->tx_offset = (ring->tx_offset + FRAME_SIZE_V1) & (ring->size - 1);
+    }
+
+    dp_tx_flush(ctx, DEFAULT_PENDING_LIMIT);
+}
+
 static int dp_tx_v1(dp_context_t *ctx, uint8_t *pkt, int len, bool large_frame)
 {
     //DEBUG_FUNC_ENTRY(DBG_PACKET);
 
-    dp_ring_t *ring = &ctx->ring;
-    struct tpacket_hdr *tp;
+    uint8_t *data;
     int ret = len;
 
     if (large_frame) {
+        ret = dp_tx_segment(ctx, pkt, len, dp_tx_slot_v1, dp_tx_commit_v1);
+        if (ret != 0) {
+            return ret;
+        }
         dp_tx_flush(ctx, 0);
 
         ret = send(ctx->fd, pkt, len, 0);
@@ -76,27 +265,14 @@ static int dp_tx_v1(dp_context_t *ctx, uint8_t *pkt, int len, bool large_frame)
         return ret;
     }
 
-    tp = (struct tpacket_hdr *)(ring->tx_map + ring->tx_offset);
-    if ((tp->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) == 0) {
-        uint8_t *data = (uint8_t *)tp + TPACKET_HDRLEN - sizeof(struct sockaddr_ll);
-
+    data = dp_tx_slot_v1(ctx);
+    if (data != NULL) {
         memcpy(data, pkt, len);
-        tp->tp_len = len;
-
-        tp->tp_status = TP_STATUS_SEND_REQUEST;
-        ctx->tx_pending ++;
-
-        if (!ctx->tap && ctx->jumboframe) {
-            ring->tx_offset = (ring->tx_offset + FRAME_SIZE_JUMBO_V1) & (ring->size - 1);
-        } else {
-            ring->tx_offset = (ring->tx_offset + FRAME_SIZE_V1) & (ring->size - 1);
-        }
-
-        dp_tx_flush(ctx, DEFAULT_PENDING_LIMIT);
+        dp_tx_commit_v1(ctx, len);
 
         //DEBUG_PACKET("Sent len=%u to %s\n", len, ctx->name);
     } else {
-        DEBUG_PACKET("TX queue full, status=0x%x Drop!\n", tp->tp_status);
+        DEBUG_PACKET("TX queue full, Drop!\n");
 
         ctx->stats.tx_drops ++;
         ret = -1;
@@ -105,19 +281,53 @@ static int dp_tx_v1(dp_context_t *ctx, uint8_t *pkt, int len, bool large_frame)
     return ret;
 }
 
+static inline uint32_t dp_fwd_lat_sample(dp_context_t *ctx)
+{
+    return ctx->tap ? 0 : CMM_LOAD_SHARED(g_lat_sample);
+}
+
+static inline uint64_t dp_fwd_lat_stamp(dp_context_t *ctx, uint32_t sample, uint32_t status,
+                                        uint32_t sec, uint32_t nsec)
+{
+    if (likely(sample == 0) || ++ ctx->fwd_lat_skip < sample) {
+        return 0;
+    }
+    ctx->fwd_lat_skip = 0;
+    if (sec == 0 || (status & TP_STATUS_TS_RAW_HARDWARE)) {
+        return 0;
+    }
+    return (uint64_t)sec * 1000000000 + nsec;
+}
+
+static void dp_fwd_lat_add(dp_context_t *ctx, uint64_t rx_ns)
+{
+    struct timespec ts;
+    uint64_t now;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    now = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    // the clock was stepped back
+    if (now >= rx_ns) {
+        lat_hist_add(&ctx->fwd_lat, now - rx_ns);
+    }
+}
+
 static int dp_rx_v1(dp_context_t *ctx, uint32_t tick)
 {
     io_ctx_t context;
     uint32_t count = 0;
+    uint32_t sample = dp_fwd_lat_sample(ctx);
     dp_ring_t *ring = &ctx->ring;
 
     context.dp_ctx = ctx;
+    context.ep_cache = &ctx->ep_cache;
     context.tick = tick;
     context.stats_slot = g_stats_slot;
     context.tap = ctx->tap;
     context.tc = ctx->tc;
     context.quar = ctx->quar;
     context.nfq = false;
+    context.proxymesh = ctx->proxymesh;
     mac_cpy(context.ep_mac.ether_addr_octet, ctx->ep_mac.ether_addr_octet);
 
     while (count < ring->batch) {
@@ -137,14 +347,17 @@ static int dp_rx_v1(dp_context_t *ctx, uint32_t tick)
         if (unlikely(tp->tp_len != tp->tp_snaplen)) {
             if (tp->tp_status & TP_STATUS_COPY) {
                 if (tp->tp_len <= MAX_TSO_SIZE) {
-                    int len = recv(ctx->fd, g_tso_packet, MAX_TSO_SIZE, 0);
+                    int len = recv(ctx->fd, th_tso_packet(ctx->thr_id), MAX_TSO_SIZE, 0);
                     DEBUG_PACKET("Recv large frame: len=%u from %s\n", len, ctx->name); 
 
                     context.large_frame = true;
-                    dpi_recv_packet(&context, g_tso_packet, len);
+                    context.rx_ns = 0;
+                    if (!dp_rx_quar_drop(ctx, th_tso_packet(ctx->thr_id), len)) {
+                        dpi_recv_packet(&context, th_tso_packet(ctx->thr_id), len);
+                    }
                 } else {
                     // read to consume
-                    recv(ctx->fd, g_tso_packet, 1, 0);
+                    recv(ctx->fd, th_tso_packet(ctx->thr_id), 1, 0);
 
                     DEBUG_PACKET("Discard: len=%u snap=%u from %s\n",
                                  tp->tp_len, tp->tp_snaplen, ctx->name);
@@ -155,7 +368,11 @@ static int dp_rx_v1(dp_context_t *ctx, uint32_t tick)
             }
         } else {
             context.large_frame = false;
-            dpi_recv_packet(&context, (uint8_t *)tp + tp->tp_mac, tp->tp_snaplen);
+            context.rx_ns = dp_fwd_lat_stamp(ctx, sample, tp->tp_status, tp->tp_sec,
+                                             tp->tp_usec * 1000);
+            if (dp_rx_check(ctx, (uint8_t *)tp + tp->tp_mac, tp->tp_snaplen)) {
+                dpi_recv_packet(&context, (uint8_t *)tp + tp->tp_mac, tp->tp_snaplen);
+            }
         }
 
         tp->tp_status = TP_STATUS_KERNEL;
@@ -172,20 +389,20 @@ static int dp_rx_v1(dp_context_t *ctx, uint32_t tick)
     return DP_RX_MORE;
 }
 
-static void dp_stats_v1(int fd, dp_stats_t *stats)
+static void dp_stats_v1(dp_context_t *ctx)
 {
     struct tpacket_stats s;
     socklen_t len;
     int err;
 
     len = sizeof(s);
-    err = getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &s, &len);
+    err = getsockopt(ctx->fd, SOL_PACKET, PACKET_STATISTICS, &s, &len);
     if (err < 0) {
         return;
     }
 
-    stats->rx += s.tp_packets;
-    stats->rx_drops += s.tp_drops;
+    ctx->stats.rx += s.tp_packets;
+    ctx->stats.rx_drops += s.tp_drops;
 }
 
 static int dp_ring_v1(int fd, const char *iface, dp_ring_t *ring, bool tap, bool jumboframe, uint blocks, uint batch)
@@ -247,71 +464,178 @@ static int dp_ring_v1(int fd, const char *iface, dp_ring_t *ring, bool tap, bool
     return fd;
 }
 
+static uint8_t *dp_tx_slot_v3(dp_context_t *ctx)
+{
+    dp_ring_t *ring = &ctx->ring;
+    struct tpacket3_hdr *tp = (struct tpacket3_hdr *)(ring->tx_map + ring->tx_offset);
+
+    if ((tp->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) != 0) {
+        DEBUG_PACKET("TX queue full, status=0x%x\n", tp->tp_status);
+        return NULL;
+    }
+    return (uint8_t *)tp + TPACKET3_HDRLEN - sizeof(struct sockaddr_ll);
+}
+
+static void dp_tx_commit_v3(dp_context_t *ctx, int len)
+{
+    dp_ring_t *ring = &ctx->ring;
+    struct tpacket3_hdr *tp = (struct tpacket3_hdr *)(ring->tx_map + ring->tx_offset);
+
+    tp->tp_len = len;
+    tp->tp_next_offset = 0;
+
+    tp->tp_status = TP_STATUS_SEND_REQUEST;
+    ctx->tx_pending ++;
+
+    // TX ring of V3 is frame based, same layout as V1
+    if (ctx->jumboframe) {
+        ring->tx_offset = (ring->tx_offset + FRAME_SIZE_JUMBO_V1) & (ring->size - 1);
+    } else {
+        ring->tx_offset = (ring->tx_offset + FRAME_SIZE_V1) & (ring->size - 1);
+    }
+
+    dp_tx_flush(ctx, DEFAULT_PENDING_LIMIT);
+}
+
 static int dp_tx_v3(dp_context_t *ctx, uint8_t *pkt, int len, bool large_frame)
 {
-    return 0;
+    uint8_t *data;
+    int ret = len;
+
+    if (large_frame) {
+        ret = dp_tx_segment(ctx, pkt, len, dp_tx_slot_v3, dp_tx_commit_v3);
+        if (ret != 0) {
+            return ret;
+        }
+        dp_tx_flush(ctx, 0);
+
+        ret = send(ctx->fd, pkt, len, 0);
+        DEBUG_PACKET("Sent large frame: len=%u to %s\n", len, ctx->name);
+
+        return ret;
+    }
+
+    data = dp_tx_slot_v3(ctx);
+    if (data != NULL) {
+        memcpy(data, pkt, len);
+        dp_tx_commit_v3(ctx, len);
+    } else {
+        DEBUG_PACKET("TX queue full, Drop!\n");
+
+        ctx->stats.tx_drops ++;
+        ret = -1;
+    }
+
+    return ret;
 }
 
 static int dp_rx_v3(dp_context_t *ctx, uint32_t tick)
 {
     io_ctx_t context;
+    io_pkt_t pkts[DP_RX_BATCH];
     uint32_t count = 0;
+    uint32_t sample = dp_fwd_lat_sample(ctx);
+    int n;
     dp_ring_t *ring = &ctx->ring;
 
     context.dp_ctx = ctx;
+    context.ep_cache = &ctx->ep_cache;
     context.tick = tick;
     context.stats_slot = g_stats_slot;
     context.tap = ctx->tap;
+    context.tc = ctx->tc;
+    context.quar = ctx->quar;
+    context.nfq = false;
+    context.proxymesh = ctx->proxymesh;
     mac_cpy(context.ep_mac.ether_addr_octet, ctx->ep_mac.ether_addr_octet);
 
     while (count < ring->batch) {
         struct tpacket_block_desc *desc;
         desc = (struct tpacket_block_desc *)(ring->rx_map + ring->rx_offset);
         if ((desc->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+            if (likely(!ctx->tap)) {
+                dp_tx_flush(ctx->peer_ctx, 0);
+            }
             return count;
         }
 
-        if (unlikely(desc->hdr.bh1.block_status & TP_STATUS_COPY)) {
-            DEBUG_PACKET("Discard: status=0x%x len=%u from %s\n",
-                         desc->hdr.bh1.block_status, desc->hdr.bh1.blk_len, ctx->name);
-        } else {
-            uint8_t *ptr = (uint8_t *)desc + desc->hdr.bh1.offset_to_first_pkt;
-            uint32_t c = desc->hdr.bh1.num_pkts;
-            count += c;
-
-            // always consume the whole block
-            int i;
-            for (i = 0; i < c; i ++) {
-                struct tpacket3_hdr *tp = (struct tpacket3_hdr *)ptr;
-                dpi_recv_packet(&context, ptr + tp->tp_mac, tp->tp_snaplen);
-                ptr += tp->tp_next_offset;
+        uint8_t *ptr = (uint8_t *)desc + desc->hdr.bh1.offset_to_first_pkt;
+        uint32_t c = desc->hdr.bh1.num_pkts;
+        count += c;
+
+        // always consume the whole block
+        int i;
+        for (i = 0, n = 0; i < c; i ++) {
+            struct tpacket3_hdr *tp = (struct tpacket3_hdr *)ptr;
+
+            if (unlikely(tp->tp_len != tp->tp_snaplen)) {
+                if ((tp->tp_status & TP_STATUS_COPY) && tp->tp_len <= MAX_TSO_SIZE) {
+                    int len;
+
+                    // The large frame buffer is per thread, keep the packet order
+                    dpi_recv_batch(&context, pkts, n, NULL);
+                    n = 0;
+
+                    len = recv(ctx->fd, th_tso_packet(ctx->thr_id), MAX_TSO_SIZE, 0);
+                    DEBUG_PACKET("Recv large frame: len=%u from %s\n", len, ctx->name);
+
+                    context.large_frame = true;
+                    context.rx_ns = 0;
+                    if (!dp_rx_quar_drop(ctx, th_tso_packet(ctx->thr_id), len)) {
+                        dpi_recv_packet(&context, th_tso_packet(ctx->thr_id), len);
+                    }
+                } else {
+                    if (tp->tp_status & TP_STATUS_COPY) {
+                        // read to consume
+                        recv(ctx->fd, th_tso_packet(ctx->thr_id), 1, 0);
+                    }
+                    DEBUG_PACKET("Discard: len=%u snap=%u from %s\n",
+                                 tp->tp_len, tp->tp_snaplen, ctx->name);
+                }
+            } else if (dp_rx_check(ctx, ptr + tp->tp_mac, tp->tp_snaplen)) {
+                pkts[n].pkt = ptr + tp->tp_mac;
+                pkts[n].len = tp->tp_snaplen;
+                // GRO frame in the block doesn't fit in a TX frame
+                pkts[n].large_frame = tp->tp_snaplen > dp_tx_frame_room(ctx);
+                pkts[n].rx_ns = dp_fwd_lat_stamp(ctx, sample, tp->tp_status, tp->tp_sec, tp->tp_nsec);
+                if (++ n == DP_RX_BATCH) {
+                    dpi_recv_batch(&context, pkts, n, NULL);
+                    n = 0;
+                }
             }
+            ptr += tp->tp_next_offset;
         }
+        dpi_recv_batch(&context, pkts, n, NULL);
 
         desc->hdr.bh1.block_status = TP_STATUS_KERNEL;
-        ring->rx_offset = (ring->rx_offset + BLOCK_SIZE_V3) & (ring->size - 1);
+        ring->rx_offset = (ring->rx_offset + ring->req3.tp_block_size) & (ring->size - 1);
     }
 
-    return 0;
+    if (likely(!ctx->tap)) {
+        dp_tx_flush(ctx->peer_ctx, 0);
+    }
+    return DP_RX_MORE;
 }
 
-static void dp_stats_v3(int fd, dp_stats_t *stats)
+static void dp_stats_v3(dp_context_t *ctx)
 {
     struct tpacket_stats_v3 s;
     socklen_t len;
     int err;
 
     len = sizeof(s);
-    err = getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &s, &len);
+    err = getsockopt(ctx->fd, SOL_PACKET, PACKET_STATISTICS, &s, &len);
     if (err < 0) {
         return;
     }
 
-    stats->rx += s.tp_packets;
-    stats->rx_drops += s.tp_drops;
+    ctx->stats.rx += s.tp_packets;
+    ctx->stats.rx_drops += s.tp_drops;
 }
 
-static int dp_ring_v3(int fd, const char *iface, dp_ring_t *ring, bool tap, uint blocks, uint batch)
+// RX blocks of V3 are sized to take the same memory as the V1 ring; inline contexts
+// also get a frame based TX ring of that size right after the RX ring.
+static int dp_ring_v3(int fd, const char *iface, dp_ring_t *ring, bool tap, bool jumboframe, uint blocks, uint batch)
 {
     int val = TPACKET_V3;
     if (setsockopt(fd, SOL_PACKET, PACKET_VERSION, &val, sizeof(val))) {
@@ -325,19 +649,54 @@ static int dp_ring_v3(int fd, const char *iface, dp_ring_t *ring, bool tap, uint
     // Packet truncated indication
     setsockopt(fd, SOL_PACKET, PACKET_COPY_THRESH, &enable, sizeof(enable));
 
+    if (!tap && jumboframe) {
+        ring->size = BLOCK_SIZE_JUMBO_V1 * blocks;
+    } else {
+        ring->size = BLOCK_SIZE_V1 * blocks;
+    }
+
     struct tpacket_req3 *req = &ring->req3;
-    req->tp_block_size = BLOCK_SIZE_V3;
+    req->tp_block_size = g_gro ? BLOCK_SIZE_GRO_V3 : BLOCK_SIZE_V3;
+    if (ring->size < req->tp_block_size) {
+        ring->size = req->tp_block_size;
+    }
     req->tp_frame_size = FRAME_SIZE_V3;
-    req->tp_block_nr = blocks;
-    req->tp_frame_nr = (req->tp_block_size * blocks) / req->tp_frame_size;
-    req->tp_retire_blk_tov = 64;
+    req->tp_block_nr = ring->size / req->tp_block_size;
+    req->tp_frame_nr = (req->tp_block_size * req->tp_block_nr) / req->tp_frame_size;
+    // Block is retired when full or at timeout (ms), keep it short for inline.
+    req->tp_retire_blk_tov = tap ? 64 : 1;
     req->tp_sizeof_priv = 0;
     req->tp_feature_req_word = 0;
-    ring->size = req->tp_block_size * blocks;
-    ring->map_size = ring->size;
     ring->batch = batch;
 
-    setsockopt(fd, SOL_PACKET, PACKET_RX_RING, req, sizeof(*req));
+    if (setsockopt(fd, SOL_PACKET, PACKET_RX_RING, req, sizeof(*req)) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to set V3 rx ring.\n");
+        return ERR_UNSUPPORT_v3;
+    }
+
+    if (!tap) {
+        struct tpacket_req3 txreq;
+
+        memset(&txreq, 0, sizeof(txreq));
+        if (jumboframe) {
+            txreq.tp_block_size = BLOCK_SIZE_JUMBO_V1;
+            txreq.tp_frame_size = FRAME_SIZE_JUMBO_V1;
+        } else {
+            txreq.tp_block_size = BLOCK_SIZE_V1;
+            txreq.tp_frame_size = FRAME_SIZE_V1;
+        }
+        txreq.tp_block_nr = ring->size / txreq.tp_block_size;
+        txreq.tp_frame_nr = ring->size / txreq.tp_frame_size;
+
+        // TX ring of TPACKET_V3 needs kernel 4.11+
+        if (setsockopt(fd, SOL_PACKET, PACKET_TX_RING, &txreq, sizeof(txreq)) < 0) {
+            DEBUG_ERROR(DBG_CTRL, "fail to set V3 tx ring.\n");
+            return ERR_UNSUPPORT_v3;
+        }
+        ring->map_size = ring->size * 2;
+    } else {
+        ring->map_size = ring->size;
+    }
 
     ring->rx_map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, fd, 0);
     if (ring->rx_map == MAP_FAILED) {
@@ -346,6 +705,8 @@ static int dp_ring_v3(int fd, const char *iface, dp_ring_t *ring, bool tap, uint
         return -1;
     }
 
+    ring->tx_map = ring->rx_map + ring->size;
+
     ring->rx = dp_rx_v3;
     ring->tx = dp_tx_v3;
     ring->stats = dp_stats_v3;
@@ -365,14 +726,26 @@ void dp_close_socket(dp_context_t *ctx)
             nfq_close(ctx->nfq_ctx.nfq_hdl);
             ctx->nfq_ctx.nfq_hdl = NULL;
         }
+    } else if (ctx->ring.xsk != NULL) {
+        dp_close_xsk(ctx);
     } else {
         munmap(ctx->ring.rx_map, ctx->ring.map_size);
         close(ctx->fd);
     }
 }
 
-int dp_open_socket(dp_context_t *ctx, const char *iface, bool tap, bool jumboframe, uint blocks, uint batch)
+int dp_open_socket(dp_context_t *ctx, const char *iface, bool tap, bool jumboframe, dp_context_t *umem_ctx, uint blocks, uint batch)
 {
+    // AF_XDP frames are one page, jumbo frames stay on the packet ring.
+    if (ctx->xdp && !jumboframe) {
+        int fd = dp_open_xsk(ctx, iface, umem_ctx, blocks, batch);
+        if (fd >= 0) {
+            return fd;
+        }
+        DEBUG_CTRL("fall back to packet ring, iface=%s\n", iface);
+    }
+    ctx->xdp = false;
+
     int fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
     if (fd < 0) {
         DEBUG_ERROR(DBG_CTRL, "fail to open socket.\n");
@@ -380,10 +753,17 @@ int dp_open_socket(dp_context_t *ctx, const char *iface, bool tap, bool jumbofra
     }
 
     int err = 0;
-    //if (tap) {
-    if (0) {
-        err = dp_ring_v3(fd, iface, &ctx->ring, tap, blocks, batch);
+    if (g_ring_v3 || g_gro) {
+        err = dp_ring_v3(fd, iface, &ctx->ring, tap, jumboframe, blocks, batch);
         if (err == ERR_UNSUPPORT_v3) {
+            // Ring options can only be set with no ring mapped, start over with a fresh socket.
+            close(fd);
+            fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+            if (fd < 0) {
+                DEBUG_ERROR(DBG_CTRL, "fail to open socket.\n");
+                return -1;
+            }
+            memset(&ctx->ring, 0, sizeof(ctx->ring));
             err = dp_ring_v1(fd, iface, &ctx->ring, tap, jumboframe, blocks, batch);
         }
     } else {
@@ -401,9 +781,340 @@ int dp_open_socket(dp_context_t *ctx, const char *iface, bool tap, bool jumbofra
         return -1;
     }
 
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strlcpy(ifr.ifr_name, iface, sizeof(ifr.ifr_name));
+    if (ioctl(fd, SIOCGIFMTU, &ifr) == 0 && ifr.ifr_mtu > 0 && ifr.ifr_mtu <= UINT16_MAX) {
+        ctx->mtu = ifr.ifr_mtu;
+    } else {
+        ctx->mtu = ETH_DATA_LEN;
+    }
+
     return fd;
 }
 
+// Symmetric hash of the addresses and ports, so both directions of a session land on
+// the same socket of the fanout group. Other ethertypes go to the first socket.
+static struct sock_filter g_fanout_filter[] = {
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, SKF_AD_OFF + SKF_AD_PROTOCOL),  // A = ethertype
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 18),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 16),  // A = dst ^ src
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 12),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_ST, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_NET_OFF + 9),  // ip protocol
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_TCP, 2, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 1, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_SCTP, 0, 44),
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, SKF_NET_OFF),  // X = ip header length
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, SKF_NET_OFF),  // A ^= sport ^ dport
+        BPF_STMT(BPF_ST, 1),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, SKF_NET_OFF + 2),
+        BPF_STMT(BPF_LDX | BPF_MEM, 1),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_LDX | BPF_MEM, 0),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_JMP | BPF_JA, 36),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IPV6, 0, 39),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 8),  // A = xor of src and dst words
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 12),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 16),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 20),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 24),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 28),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 32),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_NET_OFF + 36),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_ST, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, SKF_NET_OFF + 6),  // next header
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_TCP, 2, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 1, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_SCTP, 0, 7),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, SKF_NET_OFF + 40),  // A ^= sport ^ dport
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, SKF_NET_OFF + 42),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_LDX | BPF_MEM, 0),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_JMP | BPF_JA, 1),
+        BPF_STMT(BPF_LD | BPF_MEM, 0),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),  // A ^= A >> 16
+        BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+        BPF_STMT(BPF_ALU | BPF_XOR | BPF_X, 0),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+};
+
+// Socket filter of a tap or TC context. It drops the frames dpi_recv_packet() would discard
+// without forwarding them, before they take a ring slot: frames of no endpoint, unless in
+// promiscuous mode, and on a tap, frames that are not unicast IP. ep_known is whether the
+// context's endpoint is in the ep map, it is compiled in, so the filter is regenerated when
+// the endpoint is added or removed. Non-TC and nfq contexts forward all frames, and AF_XDP
+// sockets have no socket filter, these are not filtered.
+#define RING_FILTER_MAX    48
+#define RING_FILTER_LABELS 8
+
+typedef struct ring_filter_ {
+    struct sock_filter ins[RING_FILTER_MAX];
+    uint8_t jt[RING_FILTER_MAX], jf[RING_FILTER_MAX];   // labels, 0 is the next instruction
+    int label[RING_FILTER_LABELS];
+    int n, labels;
+} ring_filter_t;
+
+static int ring_filter_label(ring_filter_t *f)
+{
+    return ++ f->labels;
+}
+
+static void ring_filter_bind(ring_filter_t *f, int label)
+{
+    f->label[label] = f->n;
+}
+
+static void ring_filter_emit(ring_filter_t *f, uint16_t code, uint32_t k, uint8_t jt, uint8_t jf)
+{
+    f->ins[f->n] = (struct sock_filter)BPF_JUMP(code, k, 0, 0);
+    f->jt[f->n] = jt;
+    f->jf[f->n] = jf;
+    f->n ++;
+}
+
+static void ring_filter_resolve(ring_filter_t *f)
+{
+    int i;
+
+    for (i = 0; i < f->n; i ++) {
+        if (f->jt[i] != 0) {
+            f->ins[i].jt = f->label[f->jt[i]] - i - 1;
+        }
+        if (f->jf[i] != 0) {
+            f->ins[i].jf = f->label[f->jf[i]] - i - 1;
+        }
+    }
+}
+
+// Jump to 'match' if the 6 bytes at 'off' are the mac, fall through otherwise
+static void ring_filter_mac(ring_filter_t *f, uint32_t off, const uint8_t *mac, int match)
+{
+    uint32_t hi = ((uint32_t)mac[0] << 24) | (mac[1] << 16) | (mac[2] << 8) | mac[3];
+    uint32_t lo = (mac[4] << 8) | mac[5];
+    int miss = ring_filter_label(f);
+
+    ring_filter_emit(f, BPF_LD | BPF_W | BPF_ABS, off, 0, 0);
+    ring_filter_emit(f, BPF_JMP | BPF_JEQ | BPF_K, hi, 0, miss);
+    ring_filter_emit(f, BPF_LD | BPF_H | BPF_ABS, off + 4, 0, 0);
+    ring_filter_emit(f, BPF_JMP | BPF_JEQ | BPF_K, lo, match, 0);
+    ring_filter_bind(f, miss);
+}
+
+int dp_ring_filter(dp_context_t *ctx, bool ep_known)
+{
+    ring_filter_t f;
+    struct sock_fprog prog;
+    uint32_t prefix = ntohl(*(uint32_t *)MAC_PREFIX);
+    int mac_ok, ip6, accept, drop;
+
+    if (!ctx->tc || ctx->nfq || ctx->ring.xsk != NULL) {
+        return 0;
+    }
+
+    memset(&f, 0, sizeof(f));
+    mac_ok = ring_filter_label(&f);
+    ip6 = ring_filter_label(&f);
+    accept = ring_filter_label(&f);
+    drop = ring_filter_label(&f);
+
+    if (g_config.promisc) {
+        // Frames of no endpoint go to the dummy one
+        if (!ctx->tap) {
+            if (ctx->filtered && setsockopt(ctx->fd, SOL_SOCKET, SO_DETACH_FILTER, NULL, 0) == 0) {
+                ctx->filtered = false;
+            }
+            return 0;
+        }
+    } else if (ctx->proxymesh) {
+        // All frames on "lo" are the proxymesh endpoint's
+        if (!ep_known) {
+            ring_filter_emit(&f, BPF_RET | BPF_K, 0, 0, 0);
+        }
+    } else {
+        ring_filter_emit(&f, BPF_LD | BPF_W | BPF_ABS, 0, 0, 0);
+        ring_filter_emit(&f, BPF_JMP | BPF_JEQ | BPF_K, prefix, mac_ok, 0);
+        ring_filter_emit(&f, BPF_LD | BPF_W | BPF_ABS, ETH_ALEN, 0, 0);
+        ring_filter_emit(&f, BPF_JMP | BPF_JEQ | BPF_K, prefix, mac_ok, 0);
+        if (ep_known && !mac_zero(ctx->ep_mac.ether_addr_octet)) {
+            ring_filter_mac(&f, 0, ctx->ep_mac.ether_addr_octet, mac_ok);
+            ring_filter_mac(&f, ETH_ALEN, ctx->ep_mac.ether_addr_octet, mac_ok);
+        }
+        ring_filter_emit(&f, BPF_RET | BPF_K, 0, 0, 0);
+    }
+    ring_filter_bind(&f, mac_ok);
+
+    if (ctx->tap) {
+        // Frames that are not unicast IPv4 or IPv6 are not inspected
+        ring_filter_emit(&f, BPF_LD | BPF_H | BPF_ABS, offsetof(struct ethhdr, h_proto), 0, 0);
+        ring_filter_emit(&f, BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, ip6);
+        ring_filter_emit(&f, BPF_LD | BPF_W | BPF_ABS, ETH_HLEN + offsetof(struct iphdr, daddr), 0, 0);
+        ring_filter_emit(&f, BPF_JMP | BPF_JEQ | BPF_K, INADDR_BROADCAST, drop, 0);
+        ring_filter_emit(&f, BPF_ALU | BPF_AND | BPF_K, 0xf0000000, 0, 0);
+        ring_filter_emit(&f, BPF_JMP | BPF_JEQ | BPF_K, INADDR_UNSPEC_GROUP, drop, accept);
+        ring_filter_bind(&f, ip6);
+        ring_filter_emit(&f, BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IPV6, 0, drop);
+        ring_filter_emit(&f, BPF_LD | BPF_B | BPF_ABS, ETH_HLEN + offsetof(struct ip6_hdr, ip6_dst), 0, 0);
+        ring_filter_emit(&f, BPF_JMP | BPF_JEQ | BPF_K, 0xff, drop, accept);
+    }
+    ring_filter_bind(&f, accept);
+    ring_filter_emit(&f, BPF_RET | BPF_K, 0xffffffff, 0, 0);
+    ring_filter_bind(&f, drop);
+    ring_filter_emit(&f, BPF_RET | BPF_K, 0, 0, 0);
+
+    ring_filter_resolve(&f);
+    prog.len = f.n;
+    prog.filter = f.ins;
+    if (setsockopt(ctx->fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to attach socket filter, ctx=%s: %s\n", ctx->name, strerror(errno));
+        return -1;
+    }
+    ctx->filtered = true;
+    return 0;
+}
+
+// Program a symmetric Toeplitz key (0x6d5a repeated), so the NIC RSS hash of both
+// directions of a flow is the same. Best effort, virtual devices usually don't support it.
+static void dp_ring_rss_symmetric(int fd, const char *iface)
+{
+    struct ethtool_rxfh get, *set;
+    struct ifreq ifr;
+    uint32_t i;
+
+    memset(&ifr, 0, sizeof(ifr));
+    strlcpy(ifr.ifr_name, iface, IFNAMSIZ);
+
+    memset(&get, 0, sizeof(get));
+    get.cmd = ETHTOOL_GRSSH;
+    ifr.ifr_data = (void *)&get;
+    if (ioctl(fd, SIOCETHTOOL, &ifr) < 0 || get.key_size == 0) {
+        return;
+    }
+
+    set = calloc(1, sizeof(*set) + get.key_size);
+    if (set == NULL) {
+        return;
+    }
+    set->cmd = ETHTOOL_SRSSH;
+    set->indir_size = ETH_RXFH_INDIR_NO_CHANGE;
+    set->key_size = get.key_size;
+    for (i = 0; i < get.key_size; i ++) {
+        ((uint8_t *)set->rss_config)[i] = (i & 1) ? 0x5a : 0x6d;
+    }
+    ifr.ifr_data = (void *)set;
+    if (ioctl(fd, SIOCETHTOOL, &ifr) < 0) {
+        DEBUG_CTRL("symmetric rss key not set, iface=%s: %s\n", iface, strerror(errno));
+    }
+    free(set);
+}
+
+int dp_ring_fanout(dp_context_t *ctx, const char *iface)
+{
+    struct sock_fprog prog;
+    int ifindex, val;
+
+    ifindex = if_nametoindex(iface);
+    if (ifindex == 0) {
+        return -1;
+    }
+
+    // Group id is unique per netns, use the ifindex.
+    val = (ifindex & 0xffff) | ((PACKET_FANOUT_CBPF | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+    if (setsockopt(ctx->fd, SOL_PACKET, PACKET_FANOUT, &val, sizeof(val)) == 0) {
+        prog.len = ARRAY_ENTRIES(g_fanout_filter);
+        prog.filter = g_fanout_filter;
+        if (setsockopt(ctx->fd, SOL_PACKET, PACKET_FANOUT_DATA, &prog, sizeof(prog)) == 0) {
+            return 0;
+        }
+        DEBUG_ERROR(DBG_CTRL, "fail to set fanout filter, iface=%s: %s\n", iface, strerror(errno));
+        return -1;
+    }
+
+    // Old kernel without CBPF fanout, the flow hash is symmetric only when computed in software
+    // or with a symmetric RSS key. The flow owner thread gets packets taken by others anyway.
+    dp_ring_rss_symmetric(ctx->fd, iface);
+    val = (ifindex & 0xffff) | ((PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG) << 16);
+    if (setsockopt(ctx->fd, SOL_PACKET, PACKET_FANOUT, &val, sizeof(val)) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to join fanout group, iface=%s: %s\n", iface, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void dp_handoff_context(io_ctx_t *context, dp_context_t *ctx, uint32_t tick)
+{
+    context->dp_ctx = ctx;
+    context->ep_cache = NULL;
+    context->tick = tick;
+    context->stats_slot = g_stats_slot;
+    context->tap = ctx->tap;
+    context->tc = ctx->tc;
+    context->quar = ctx->quar;
+    context->nfq = false;
+    context->proxymesh = ctx->proxymesh;
+    context->large_frame = false;
+    context->rx_ns = 0;
+    mac_cpy(context->ep_mac.ether_addr_octet, ctx->ep_mac.ether_addr_octet);
+}
+
+// Packets handed off by other threads. Fanout packets are sent out with the socket of this
+// thread; packets of a moved tap context carry the context, they are only inspected.
+uint32_t dp_rx_handoff(dp_context_t *ctx, dp_handoff_ring_t *r, uint32_t tick)
+{
+    io_ctx_t context, slot_context;
+    dp_context_t *last = NULL;
+    uint32_t tail = r->tail, head = CMM_LOAD_SHARED(r->head), count = head - tail;
+
+    cmm_smp_rmb();
+
+    if (ctx != NULL) {
+        dp_handoff_context(&context, ctx, tick);
+    }
+
+    for (; tail != head; tail ++) {
+        dp_handoff_slot_t *slot = &r->slots[tail & (HANDOFF_RING_SIZE - 1)];
+
+        if (slot->ctx != NULL) {
+            if (slot->ctx != last) {
+                dp_handoff_context(&slot_context, slot->ctx, tick);
+                last = slot->ctx;
+            }
+            dpi_recv_packet(&slot_context, slot->pkt, slot->len);
+        } else if (likely(ctx != NULL)) {
+            dpi_recv_packet(&context, slot->pkt, slot->len);
+        }
+        // else, port removed
+    }
+
+    cmm_smp_mb();
+    CMM_STORE_SHARED(r->tail, tail);
+
+    if (ctx != NULL && likely(!ctx->tap)) {
+        dp_tx_flush(ctx->peer_ctx, 0);
+    }
+    return count;
+}
+
 int dp_rx(dp_context_t *ctx, uint32_t tick)
 {
     if (ctx->nfq) {
@@ -413,6 +1124,104 @@ int dp_rx(dp_context_t *ctx, uint32_t tick)
     }
 }
 
+static bool dp_rx_filled(dp_ring_t *ring, uint32_t quarter)
+{
+    uint32_t offset;
+
+    if (ring->rx == dp_rx_v3) {
+        struct tpacket_block_desc *desc;
+
+        offset = (ring->rx_offset + (ring->req3.tp_block_nr * quarter / 4) * ring->req3.tp_block_size) & (ring->size - 1);
+        desc = (struct tpacket_block_desc *)(ring->rx_map + offset);
+        return (desc->hdr.bh1.block_status & TP_STATUS_USER) != 0;
+    } else {
+        struct tpacket_hdr *tp;
+
+        offset = (ring->rx_offset + ring->size / 4 * quarter) & (ring->size - 1);
+        tp = (struct tpacket_hdr *)(ring->rx_map + offset);
+        return (tp->tp_status & TP_STATUS_USER) != 0;
+    }
+}
+
+// Quarters of the ring already filled ahead of the reading position, 0 to 3, by the frame or
+// block at each quarter. Not known for nfq and AF_XDP contexts, always 0.
+uint32_t dp_rx_backlog(dp_context_t *ctx)
+{
+    dp_ring_t *ring = &ctx->ring;
+    uint32_t quarter;
+
+    if (ctx->nfq || ring->xsk != NULL || ring->rx_map == NULL) {
+        return 0;
+    }
+
+    for (quarter = 3; quarter > 0; quarter --) {
+        if (dp_rx_filled(ring, quarter)) {
+            break;
+        }
+    }
+    return quarter;
+}
+
+// Drop all packets on the socket, until dp_ring_unblock()
+int dp_ring_block(dp_context_t *ctx)
+{
+    struct sock_filter drop = BPF_STMT(BPF_RET | BPF_K, 0);
+    struct sock_fprog prog = {.len = 1, .filter = &drop};
+
+    if (setsockopt(ctx->fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to block socket, ctx=%s: %s\n", ctx->name, strerror(errno));
+        return -1;
+    }
+    ctx->filtered = true;
+    return 0;
+}
+
+// Take the packets the context is meant to, with its own filter or all of them. The filter
+// replaces the block one, or dp_ring_filter() detaches it on a promisc port.
+static void dp_ring_unblock(dp_context_t *ctx, bool ep_known)
+{
+    if (ctx->tc && dp_ring_filter(ctx, ep_known) == 0) {
+        return;
+    }
+    if (setsockopt(ctx->fd, SOL_SOCKET, SO_DETACH_FILTER, NULL, 0) == 0) {
+        ctx->filtered = false;
+    }
+}
+
+// The blocked socket of 'nc', of a ring of another size, takes over from the one of ctx. The
+// old socket is blocked, the new one opened right after, so no packet is taken by both. The
+// packets the old ring holds are handled, then the sockets are swapped, and nc is left with
+// the old one to close. Run by the thread owning ctx.
+void dp_ring_swap(dp_context_t *ctx, dp_context_t *nc, bool ep_known, uint32_t tick)
+{
+    dp_ring_t ring;
+    int fd, i, max_rx;
+    bool filtered;
+
+    dp_ring_block(ctx);
+    nc->tap = ctx->tap;
+    nc->tc = ctx->tc;
+    nc->proxymesh = ctx->proxymesh;
+    nc->ep_mac = ctx->ep_mac;
+    strlcpy(nc->name, ctx->name, sizeof(nc->name));
+    dp_ring_unblock(nc, ep_known);
+
+    max_rx = ctx->ring.size / ctx->ring.batch + 1;
+    for (i = 0; i < max_rx && dp_rx(ctx, tick) == DP_RX_MORE; i ++);
+    dp_tx_flush(ctx, 0);
+    ctx->ring.stats(ctx);
+
+    ring = ctx->ring;
+    fd = ctx->fd;
+    filtered = ctx->filtered;
+    ctx->ring = nc->ring;
+    ctx->fd = nc->fd;
+    ctx->filtered = nc->filtered;
+    nc->ring = ring;
+    nc->fd = fd;
+    nc->filtered = filtered;
+}
+
 int dp_send_packet(io_ctx_t *context, uint8_t *pkt, int len)
 {
     //no send for nfq
@@ -431,6 +1240,9 @@ int dp_send_packet(io_ctx_t *context, uint8_t *pkt, int len)
 
     // Context is released in data path thread too. It's synchronized.
     dp_context_t *ctx = (dp_context_t *)context->dp_ctx;
+    dp_context_t *rx_ctx = ctx;
+    int ret;
+
     ctx = ctx->peer_ctx;
     if (ctx->released) {
         DEBUG_PACKET("Port removed. Drop!\n");
@@ -439,7 +1251,16 @@ int dp_send_packet(io_ctx_t *context, uint8_t *pkt, int len)
         return -1;
     }
 
-    return ctx->ring.tx(ctx, pkt, len, context->large_frame);
+    ret = ctx->ring.tx(ctx, pkt, len, context->large_frame);
+
+    // Only the first packet sent for the received one is timed
+    if (unlikely(context->rx_ns != 0)) {
+        if (ret >= 0) {
+            dp_fwd_lat_add(rx_ctx, context->rx_ns);
+        }
+        context->rx_ns = 0;
+    }
+    return ret;
 }
 
 void dp_get_stats(dp_context_t *ctx)
@@ -447,6 +1268,6 @@ void dp_get_stats(dp_context_t *ctx)
     if (ctx->nfq) {
         ctx->nfq_ctx.stats(ctx);
     } else {
-        ctx->ring.stats(ctx->fd, &ctx->stats);
+        ctx->ring.stats(ctx);
     }
 }
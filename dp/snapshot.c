@@ -0,0 +1,388 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+
+#include "main.h"
+#include "debug.h"
+
+// The config messages of the agent are journaled to DP_SNAP_FILE in the order they are
+// applied, so a restarted dp can be given back its config without the agent pushing it
+// again. gen counts the messages since the agent reset the journal; the agent counts the
+// ones it sent, and ctrl_cfg_restore replays the journal only if the agent can send the
+// messages after it, see dp_snap_restore().
+//
+// A message that replaces a whole piece of config, e.g. the policy of a set of MACs, has a
+// key; it supersedes the older messages of the same key, which are dropped when the file
+// is compacted. Past DP_SNAP_MAX_SIZE the file is removed and the journal stops until the
+// next reset, a restart then takes a full push.
+
+#define DP_SNAP_FILE          "/var/run/dp_cfg.snap"
+#define DP_SNAP_MAGIC         0x44505343
+#define DP_SNAP_VERSION       1
+#define DP_SNAP_MAX_SIZE      (256 << 20)
+#define DP_SNAP_COMPACT_MIN   (1 << 20)
+
+typedef struct dp_snap_file_hdr_ {
+    uint32_t magic;
+    uint32_t version;
+} dp_snap_file_hdr_t;
+
+typedef struct dp_snap_rec_ {
+    uint32_t len;           // of the data
+    uint32_t gen;
+    uint64_t key;
+    uint8_t type;
+    uint8_t pad[7];
+} dp_snap_rec_t;
+
+typedef struct dp_snap_entry_ {
+    off_t off;
+    uint32_t size;          // record and data
+    bool live;
+    uint64_t key;
+} dp_snap_entry_t;
+
+enum {
+    SNAP_EMPTY = 0,         // no config the agent knows of
+    SNAP_PENDING,           // journal of the previous run, waiting for ctrl_cfg_restore
+    SNAP_ACTIVE,            // config is the first gen messages since the reset
+};
+
+static int g_snap_state = SNAP_EMPTY;
+static int g_snap_fd = -1;
+static char g_snap_path[64] = DP_SNAP_FILE;     // of the instance, see dp_snap_init()
+static uint32_t g_snap_gen;
+static off_t g_snap_size, g_snap_dead;
+static dp_snap_entry_t *g_snap_entries;
+static uint32_t g_snap_count, g_snap_max;
+static bool g_snap_replaying;
+
+// FNV-1a, chained from seed
+uint64_t dp_snap_key(const void *data, uint32_t len, uint64_t seed)
+{
+    const uint8_t *p = data;
+    uint64_t h = seed ^ 0xcbf29ce484222325ULL;
+    uint32_t i;
+
+    for (i = 0; i < len; i ++) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static int snap_add_entry(off_t off, uint32_t size, uint64_t key)
+{
+    dp_snap_entry_t *e;
+    uint32_t i;
+
+    if (key != 0) {
+        for (i = 0; i < g_snap_count; i ++) {
+            e = &g_snap_entries[i];
+            if (e->live && e->key == key) {
+                e->live = false;
+                g_snap_dead += e->size;
+            }
+        }
+    }
+
+    if (g_snap_count == g_snap_max) {
+        uint32_t max = g_snap_max == 0 ? 256 : g_snap_max * 2;
+
+        e = realloc(g_snap_entries, sizeof(*e) * max);
+        if (e == NULL) {
+            return -1;
+        }
+        g_snap_entries = e;
+        g_snap_max = max;
+    }
+
+    e = &g_snap_entries[g_snap_count ++];
+    e->off = off;
+    e->size = size;
+    e->key = key;
+    e->live = true;
+    return 0;
+}
+
+static void snap_close(bool remove)
+{
+    if (g_snap_fd >= 0) {
+        close(g_snap_fd);
+        g_snap_fd = -1;
+    }
+    if (remove) {
+        unlink(g_snap_path);
+    }
+    free(g_snap_entries);
+    g_snap_entries = NULL;
+    g_snap_count = g_snap_max = 0;
+    g_snap_size = g_snap_dead = 0;
+}
+
+static int snap_create(void)
+{
+    dp_snap_file_hdr_t fh = {DP_SNAP_MAGIC, DP_SNAP_VERSION};
+
+    g_snap_fd = open(g_snap_path, O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (g_snap_fd < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to create %s: %s\n", g_snap_path, strerror(errno));
+        return -1;
+    }
+    if (write(g_snap_fd, &fh, sizeof(fh)) != sizeof(fh)) {
+        DEBUG_ERROR(DBG_CTRL, "fail to write %s: %s\n", g_snap_path, strerror(errno));
+        snap_close(true);
+        return -1;
+    }
+    g_snap_size = sizeof(fh);
+    return 0;
+}
+
+// Copy the live records to a new file
+static void snap_compact(void)
+{
+    char tmp[sizeof(g_snap_path) + 4];
+    dp_snap_file_hdr_t fh = {DP_SNAP_MAGIC, DP_SNAP_VERSION};
+    uint8_t buf[65536];
+    off_t size = sizeof(fh);
+    uint32_t i, n = 0;
+    int fd;
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", g_snap_path);
+    fd = open(tmp, O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0 || write(fd, &fh, sizeof(fh)) != sizeof(fh)) {
+        goto fail;
+    }
+    for (i = 0; i < g_snap_count; i ++) {
+        dp_snap_entry_t *e = &g_snap_entries[i];
+        off_t off = e->off;
+        uint32_t left = e->size;
+
+        if (!e->live) {
+            continue;
+        }
+        while (left > 0) {
+            ssize_t len = pread(g_snap_fd, buf, min(left, sizeof(buf)), off);
+
+            if (len <= 0 || write(fd, buf, len) != len) {
+                goto fail;
+            }
+            off += len;
+            left -= len;
+        }
+        g_snap_entries[n].off = size;
+        g_snap_entries[n].size = e->size;
+        g_snap_entries[n].key = e->key;
+        g_snap_entries[n].live = true;
+        size += e->size;
+        n ++;
+    }
+    if (rename(tmp, g_snap_path) < 0) {
+        goto fail;
+    }
+
+    DEBUG_CTRL("records=%u->%u size=%jd->%jd\n", g_snap_count, n, (intmax_t)g_snap_size, (intmax_t)size);
+
+    close(g_snap_fd);
+    g_snap_fd = fd;
+    g_snap_count = n;
+    g_snap_size = size;
+    g_snap_dead = 0;
+    return;
+
+fail:
+    DEBUG_ERROR(DBG_CTRL, "fail to compact %s: %s\n", g_snap_path, strerror(errno));
+    if (fd >= 0) {
+        close(fd);
+    }
+    unlink(tmp);
+}
+
+// Stop journaling, the config of the process is still the gen messages
+static void snap_stop(const char *reason)
+{
+    DEBUG_ERROR(DBG_CTRL, "stop config journal: %s\n", reason);
+    snap_close(true);
+}
+
+// Called by the ctrl thread after a config message is handled. data follows hdr in the
+// record, hdr can be NULL.
+void dp_snap_add(int type, uint64_t key, const void *hdr, uint32_t hdr_len, const void *data, uint32_t len)
+{
+    dp_snap_rec_t rec;
+    struct iovec iov[3];
+    uint32_t size = sizeof(rec) + hdr_len + len;
+
+    if (g_snap_replaying) {
+        return;
+    }
+    if (g_snap_state == SNAP_PENDING) {
+        // The journal would be replayed after this message
+        DEBUG_CTRL("drop config journal of the previous run, gen=%u\n", g_snap_gen);
+        snap_close(true);
+        g_snap_state = SNAP_EMPTY;
+    }
+    if (g_snap_state != SNAP_ACTIVE) {
+        return;
+    }
+
+    g_snap_gen ++;
+    if (g_snap_fd < 0) {
+        return;
+    }
+    if (g_snap_size + size > DP_SNAP_MAX_SIZE) {
+        snap_stop("too large");
+        return;
+    }
+
+    memset(&rec, 0, sizeof(rec));
+    rec.len = hdr_len + len;
+    rec.key = key;
+    rec.gen = g_snap_gen;
+    rec.type = type;
+
+    iov[0].iov_base = &rec;
+    iov[0].iov_len = sizeof(rec);
+    iov[1].iov_base = (void *)hdr;
+    iov[1].iov_len = hdr_len;
+    iov[2].iov_base = (void *)data;
+    iov[2].iov_len = len;
+    if (pwritev(g_snap_fd, iov, 3, g_snap_size) != size) {
+        snap_stop(strerror(errno));
+        return;
+    }
+    if (snap_add_entry(g_snap_size, size, key) < 0) {
+        snap_stop("out of memory");
+        return;
+    }
+    g_snap_size += size;
+
+    if (g_snap_dead > DP_SNAP_COMPACT_MIN && g_snap_dead > g_snap_size - g_snap_dead) {
+        snap_compact();
+    }
+}
+
+// The agent starts a full push
+void dp_snap_reset(void)
+{
+    DEBUG_CTRL("gen=%u\n", g_snap_gen);
+
+    snap_close(false);
+    g_snap_gen = 0;
+    g_snap_state = SNAP_ACTIVE;
+    snap_create();
+}
+
+// Index the journal of the previous run, before the agent connects
+int dp_snap_init(void)
+{
+    dp_snap_file_hdr_t fh;
+    dp_snap_rec_t rec;
+    struct stat st;
+    off_t off;
+
+    dp_instance_name(DP_SNAP_FILE, g_snap_path, sizeof(g_snap_path));
+    g_snap_fd = open(g_snap_path, O_RDWR | O_CLOEXEC);
+    if (g_snap_fd < 0) {
+        return 0;
+    }
+    if (fstat(g_snap_fd, &st) < 0 || pread(g_snap_fd, &fh, sizeof(fh), 0) != sizeof(fh) ||
+        fh.magic != DP_SNAP_MAGIC || fh.version != DP_SNAP_VERSION) {
+        DEBUG_INIT("Ignore config journal of another version\n");
+        snap_close(true);
+        return 0;
+    }
+
+    off = sizeof(fh);
+    g_snap_gen = 0;
+    while (pread(g_snap_fd, &rec, sizeof(rec), off) == sizeof(rec)) {
+        uint32_t size = sizeof(rec) + rec.len;
+
+        if (rec.gen <= g_snap_gen || off + size > st.st_size) {
+            break;
+        }
+        if (snap_add_entry(off, size, rec.key) < 0) {
+            snap_close(true);
+            return -1;
+        }
+        g_snap_gen = rec.gen;
+        off += size;
+    }
+
+    // Cut a record the previous run didn't finish writing
+    if (ftruncate(g_snap_fd, off) < 0) {
+        snap_close(true);
+        return -1;
+    }
+    g_snap_size = off;
+    g_snap_state = SNAP_PENDING;
+
+    DEBUG_INIT("Config journal gen=%u records=%u size=%jd\n", g_snap_gen, g_snap_count, (intmax_t)off);
+    return 0;
+}
+
+static int snap_replay(dp_snap_apply_fct apply)
+{
+    uint32_t i, n = 0;
+    int ret = 0;
+
+    g_snap_replaying = true;
+    for (i = 0; i < g_snap_count; i ++) {
+        dp_snap_entry_t *e = &g_snap_entries[i];
+        dp_snap_rec_t *rec;
+        uint8_t *buf;
+
+        if (!e->live) {
+            continue;
+        }
+        // A zero after the data for the json parser
+        buf = malloc(e->size + 1);
+        if (buf == NULL) {
+            ret = -1;
+            break;
+        }
+        if (pread(g_snap_fd, buf, e->size, e->off) != e->size) {
+            free(buf);
+            ret = -1;
+            break;
+        }
+        buf[e->size] = '\0';
+
+        rec = (dp_snap_rec_t *)buf;
+        apply(rec->type, buf + sizeof(*rec), rec->len);
+        free(buf);
+        n ++;
+    }
+    g_snap_replaying = false;
+
+    DEBUG_CTRL("replayed=%u gen=%u ret=%d\n", n, g_snap_gen, ret);
+    return ret;
+}
+
+// Asked by the agent, which sent gen messages since the reset and can send again those
+// after min. The journal of the previous run is replayed if its gen is in between. Return
+// true if the config is the first *cur messages, false if the agent must push it in full.
+bool dp_snap_restore(uint32_t min, uint32_t gen, dp_snap_apply_fct apply, uint32_t *cur)
+{
+    if (g_snap_state == SNAP_PENDING) {
+        if (g_snap_gen >= min && g_snap_gen <= gen && snap_replay(apply) == 0) {
+            g_snap_state = SNAP_ACTIVE;
+        } else {
+            DEBUG_CTRL("drop config journal, gen=%u agent=%u-%u\n", g_snap_gen, min, gen);
+            snap_close(true);
+            g_snap_state = SNAP_EMPTY;
+        }
+    }
+
+    if (g_snap_state != SNAP_ACTIVE || g_snap_gen < min || g_snap_gen > gen) {
+        *cur = 0;
+        return false;
+    }
+    *cur = g_snap_gen;
+    return true;
+}
@@ -23,11 +23,60 @@ void asm_init(asm_t *a)
 {
     tree_init(&a->tree, asm_compare);
     a->gross = 0;
+    a->count = 0;
+    a->in_tree = false;
+}
+
+// Clips in order, through the array index i or the tree
+static clip_t *asm_first(asm_t *a, int *i)
+{
+    *i = 0;
+    if (a->in_tree) {
+        return (clip_t *)tree_first_node((tree_node_t *)(&a->tree));
+    }
+    return a->count > 0 ? a->clips[0] : NULL;
+}
+
+static clip_t *asm_next(asm_t *a, clip_t *clip, int *i)
+{
+    if (a->in_tree) {
+        return (clip_t *)tree_next_node(&clip->node);
+    }
+    return ++ *i < a->count ? a->clips[*i] : NULL;
+}
+
+// Index of the first clip not before seq in the array. Clips mostly come in order, so the
+// array is searched from the end.
+static int asm_inline_pos(asm_t *a, uint32_t seq)
+{
+    int i = a->count;
+
+    while (i > 0 && u32_gte(a->clips[i - 1]->seq, seq)) {
+        i --;
+    }
+    return i;
+}
+
+static void asm_promote(asm_t *a)
+{
+    int i;
+
+    for (i = 0; i < a->count; i ++) {
+        tree_insert_node(&a->tree, &a->clips[i]->node);
+    }
+    a->count = 0;
+    a->in_tree = true;
 }
 
 clip_t *asm_lookup(asm_t *a, uint32_t seq)
 {
     clip_t clip;
+    int i;
+
+    if (!a->in_tree) {
+        i = asm_inline_pos(a, seq);
+        return i < a->count && a->clips[i]->seq == seq ? a->clips[i] : NULL;
+    }
 
     clip.seq = seq;
     return (clip_t *)tree_find_node(&a->tree, &clip.node);
@@ -36,8 +85,25 @@ clip_t *asm_lookup(asm_t *a, uint32_t seq)
 
 asm_result_t asm_insert(asm_t *a, clip_t *clip)
 {
+    int i;
+
     tree_init_node(&clip->node);
 
+    if (!a->in_tree) {
+        i = asm_inline_pos(a, clip->seq);
+        if (i < a->count && a->clips[i]->seq == clip->seq) {
+            return ASM_FAILURE;
+        }
+        if (a->count < ASM_INLINE_CLIPS) {
+            memmove(&a->clips[i + 1], &a->clips[i], (a->count - i) * sizeof(a->clips[0]));
+            a->clips[i] = clip;
+            a->count ++;
+            a->gross += clip->len;
+            return ASM_OK;
+        }
+        asm_promote(a);
+    }
+
     if (tree_insert_node(&a->tree, &clip->node) == NULL) {
         return ASM_FAILURE;
     } else {
@@ -48,8 +114,22 @@ asm_result_t asm_insert(asm_t *a, clip_t *clip)
 
 void asm_remove(asm_t *a, clip_t *clip, asm_remove_func_t remove)
 {
-    if (tree_remove_node(&a->tree, &clip->node) != NULL) {
+    int i;
+
+    if (!a->in_tree) {
+        for (i = 0; i < a->count; i ++) {
+            if (a->clips[i] == clip) {
+                a->count --;
+                memmove(&a->clips[i], &a->clips[i + 1], (a->count - i) * sizeof(a->clips[0]));
+                a->gross -= clip->len;
+                break;
+            }
+        }
+    } else if (tree_remove_node(&a->tree, &clip->node) != NULL) {
         a->gross -= clip->len;
+        if (tree_count_node(&a->tree) == 0) {
+            a->in_tree = false;
+        }
     }
     remove(clip);
 }
@@ -57,35 +137,48 @@ void asm_remove(asm_t *a, clip_t *clip, asm_remove_func_t remove)
 
 void asm_destroy(asm_t *a, asm_remove_func_t remove)
 {
-    tree_destroy(&a->tree, (tree_remove_func_t)remove);
+    int i;
+
+    if (a->in_tree) {
+        tree_destroy(&a->tree, (tree_remove_func_t)remove);
+    } else {
+        for (i = 0; i < a->count; i ++) {
+            remove(a->clips[i]);
+        }
+    }
     a->gross = 0;
+    a->count = 0;
+    a->in_tree = false;
 }
 
 
 void asm_flush(asm_t *a, uint32_t seq, asm_remove_func_t remove)
 {
-    clip_t *clip, *next;
-
-    if (asm_count(a) == 0) return;
-
-    clip = (clip_t *)tree_first_node((tree_node_t *)(&a->tree));
-    while (clip != NULL) {
-        next = (clip_t *)tree_next_node(&clip->node);
-
-        if (u32_lte(clip->seq + clip->len, seq)) {
-            asm_remove(a, clip, remove);
-        } else {
-            break;
-        }
+    clip_t *clip;
+    int i;
 
-        clip = next;
+    while ((clip = asm_first(a, &i)) != NULL && u32_lte(clip->seq + clip->len, seq)) {
+        asm_remove(a, clip, remove);
     }
 }
 
 
 void asm_foreach(asm_t *a, asm_foreach_func_t foreach, void *args)
 {
-    tree_traverse(&a->tree, (tree_each_func_t)foreach, args);
+    clip_t *clips[ASM_INLINE_CLIPS];
+    int i, count;
+
+    if (a->in_tree) {
+        tree_traverse(&a->tree, (tree_each_func_t)foreach, args);
+        return;
+    }
+
+    // The callback may remove the clip
+    count = a->count;
+    memcpy(clips, a->clips, count * sizeof(clips[0]));
+    for (i = 0; i < count; i ++) {
+        foreach(clips[i], args);
+    }
 }
 
 
@@ -93,24 +186,27 @@ asm_result_t asm_construct(asm_t *a, clip_t *target, uint32_t must_have)
 {
     clip_t *itr, *next, *first, *last;
     uint32_t end, total = 0;
+    int i, first_i;
 
     if (asm_count(a) <= 1) {
         return ASM_NOP;
     }
 
-    first = (clip_t *)tree_first_node((tree_node_t *)(&a->tree));
+    first = asm_first(a, &i);
+    first_i = i;
 
-    // Traverse the tree to find the assembly range
+    // Traverse the clips to find the assembly range
     itr = last = first;
     while (itr != NULL) {
         last = itr;
-        next = (clip_t *)tree_next_node(&itr->node);
+        next = asm_next(a, itr, &i);
 
         end = itr->seq + itr->len;
         total = max(total, end - first->seq);
         if (u32_lte(end, target->seq)) {
             // Move forward as the current clip is too early
             first = last = next;
+            first_i = i;
         } else if (next != NULL && u32_lt(end, next->seq)) {
             // Gap! 
             if (u32_lt(end, must_have)) {
@@ -135,8 +231,9 @@ asm_result_t asm_construct(asm_t *a, clip_t *target, uint32_t must_have)
 
     target->len = 0;
     itr = first;
+    i = first_i;
     while (itr) {
-        next = (itr == last) ? NULL : (clip_t *)tree_next_node(&itr->node);
+        next = (itr == last) ? NULL : asm_next(a, itr, &i);
 
         end = itr->seq + itr->len;
         memcpy(target->ptr + (itr->seq - first->seq), itr->ptr + itr->skip, itr->len);
@@ -149,4 +246,3 @@ asm_result_t asm_construct(asm_t *a, clip_t *target, uint32_t must_have)
 
     return ASM_OK;
 }
-
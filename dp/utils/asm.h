@@ -11,17 +11,27 @@ typedef struct clip_ {
     uint8_t *ptr;
     uint32_t seq;
     uint32_t len : 24,
-             action:3;
+             action:3,
+             pooled:1,
+             ref:1;         // ptr is still in the packet, not copied yet
     uint16_t skip;
 } clip_t;
 
 typedef void (*asm_remove_func_t)(clip_t *clip);
 typedef void (*asm_foreach_func_t)(clip_t *clip, void *args);
 
+// Clips are kept sorted in the inline array while there are few of them, the common case of
+// a few segments mostly in order. The store moves to the tree when the array is full, and
+// back to the array when the tree is emptied.
+#define ASM_INLINE_CLIPS 4
+
 typedef struct asm_ {
     tree_t tree;
+    clip_t *clips[ASM_INLINE_CLIPS];
 
     uint32_t gross;
+    uint8_t count;          // clips in the array
+    uint8_t in_tree;
 } asm_t;
 
 
@@ -44,7 +54,7 @@ asm_result_t asm_construct(asm_t *a, clip_t *target, uint32_t must_have);
 
 static inline uint32_t asm_count(asm_t *a)
 {
-    return tree_count_node(&a->tree);
+    return a->in_tree ? tree_count_node(&a->tree) : a->count;
 }
 
 
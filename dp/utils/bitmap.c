@@ -113,41 +113,3 @@ void bitmap_deallocate(bitmap *b)
     free(b->array);
     free(b);
 }
-
-//#define DP_BITMAP_TEST
-#ifdef DP_BITMAP_TEST
-void bitmap_print(bitmap *b)
-{
-    int i;
-    for (i = 0; i < b->words; i++)
-    {
-        printf("%08x  " , b->array[i]);
-    }
-    printf("\n");
-}
-
-int main(void)
-{
-  const int testlen = 100;	// number of bits in the bitmap
-  int i, j;
-  bitmap *bm = bitmap_allocate(testlen);
-
-  bitmap_print(bm);
-  for (i = 0; i < testlen; i += 4) { bitmap_set(bm, i); }
-  bitmap_print(bm);
-
-  int free_bit = 0;
-  for (i = 0; i < 120; i++) {
-      free_bit = bitmap_get_next_zero(bm, free_bit+1);
-      if (free_bit >= 0) {
-          bitmap_set(bm, free_bit);
-      } else {
-          for (j = 0; j < testlen; j += 4) {bitmap_clear(bm, j);}
-      }
-      printf("Get free bit i %d, as %u\n", i, free_bit);
-  }
-
-  bitmap_deallocate(bm);
-  return 0;
-}
-#endif
@@ -0,0 +1,146 @@
+#include <stdint.h>
+#include <string.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "utils/cksum.h"
+
+// Kernels add 32-bit words into 64-bit lanes, the carries are folded at the end. The sum of
+// 32-bit words folds to the same value as the sum of their 16-bit halves.
+
+static inline uint64_t cksum_tail(const uint8_t *p, uint32_t len, uint64_t sum)
+{
+    uint32_t w32;
+    uint16_t w16 = 0;
+
+    while (len >= 4) {
+        memcpy(&w32, p, 4);
+        sum += w32;
+        p += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        memcpy(&w16, p, 2);
+        sum += w16;
+        p += 2;
+        len -= 2;
+    }
+    if (len > 0) {
+        // The odd byte is the first byte of a word padded with zero
+        w16 = 0;
+        memcpy(&w16, p, 1);
+        sum += w16;
+    }
+    return sum;
+}
+
+static uint32_t cksum_partial_scalar(const void *buf, uint32_t len, uint32_t sum)
+{
+    const uint8_t *p = buf;
+    uint64_t s0 = sum, s1 = 0;
+    uint32_t w[4];
+
+    while (len >= 16) {
+        memcpy(w, p, 16);
+        s0 += w[0];
+        s1 += w[1];
+        s0 += w[2];
+        s1 += w[3];
+        p += 16;
+        len -= 16;
+    }
+    return cksum_fold(cksum_tail(p, len, s0 + s1));
+}
+
+#if defined(__x86_64__)
+static uint32_t cksum_partial_sse2(const void *buf, uint32_t len, uint32_t sum)
+{
+    const uint8_t *p = buf;
+    __m128i zero = _mm_setzero_si128(), a0 = zero, a1 = zero;
+    uint64_t s[2];
+
+    while (len >= 32) {
+        __m128i v0 = _mm_loadu_si128((const __m128i *)p);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(p + 16));
+
+        a0 = _mm_add_epi64(a0, _mm_unpacklo_epi32(v0, zero));
+        a1 = _mm_add_epi64(a1, _mm_unpackhi_epi32(v0, zero));
+        a0 = _mm_add_epi64(a0, _mm_unpacklo_epi32(v1, zero));
+        a1 = _mm_add_epi64(a1, _mm_unpackhi_epi32(v1, zero));
+        p += 32;
+        len -= 32;
+    }
+    _mm_storeu_si128((__m128i *)s, _mm_add_epi64(a0, a1));
+    s[0] = (uint64_t)cksum_fold(s[0]) + cksum_fold(s[1]) + sum;
+    return cksum_fold(cksum_tail(p, len, s[0]));
+}
+
+__attribute__((target("avx2")))
+static uint32_t cksum_partial_avx2(const void *buf, uint32_t len, uint32_t sum)
+{
+    const uint8_t *p = buf;
+    __m256i zero = _mm256_setzero_si256(), a0 = zero, a1 = zero;
+    uint64_t s[4];
+
+    while (len >= 64) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)p);
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(p + 32));
+
+        a0 = _mm256_add_epi64(a0, _mm256_unpacklo_epi32(v0, zero));
+        a1 = _mm256_add_epi64(a1, _mm256_unpackhi_epi32(v0, zero));
+        a0 = _mm256_add_epi64(a0, _mm256_unpacklo_epi32(v1, zero));
+        a1 = _mm256_add_epi64(a1, _mm256_unpackhi_epi32(v1, zero));
+        p += 64;
+        len -= 64;
+    }
+    _mm256_storeu_si256((__m256i *)s, _mm256_add_epi64(a0, a1));
+    s[0] = (uint64_t)cksum_fold(s[0]) + cksum_fold(s[1]) + cksum_fold(s[2]) + cksum_fold(s[3]) + sum;
+    return cksum_partial_sse2(p, len, cksum_fold(s[0]));
+}
+#elif defined(__ARM_NEON)
+static uint32_t cksum_partial_neon(const void *buf, uint32_t len, uint32_t sum)
+{
+    const uint8_t *p = buf;
+    uint64x2_t a0 = vdupq_n_u64(0), a1 = vdupq_n_u64(0);
+    uint64_t s;
+
+    while (len >= 32) {
+        a0 = vpadalq_u32(a0, vreinterpretq_u32_u8(vld1q_u8(p)));
+        a1 = vpadalq_u32(a1, vreinterpretq_u32_u8(vld1q_u8(p + 16)));
+        p += 32;
+        len -= 32;
+    }
+    a0 = vaddq_u64(a0, a1);
+    s = (uint64_t)cksum_fold(vgetq_lane_u64(a0, 0)) + cksum_fold(vgetq_lane_u64(a0, 1)) + sum;
+    return cksum_fold(cksum_tail(p, len, s));
+}
+#endif
+
+static uint32_t cksum_partial_resolve(const void *buf, uint32_t len, uint32_t sum);
+
+cksum_partial_fct cksum_partial_impl = cksum_partial_resolve;
+
+static cksum_partial_fct cksum_select(void)
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return cksum_partial_avx2;
+    }
+    return cksum_partial_sse2;
+#elif defined(__ARM_NEON)
+    return cksum_partial_neon;
+#else
+    return cksum_partial_scalar;
+#endif
+}
+
+// Called once on the first checksum, threads racing here pick the same kernel
+static uint32_t cksum_partial_resolve(const void *buf, uint32_t len, uint32_t sum)
+{
+    cksum_partial_impl = cksum_select();
+    return cksum_partial_impl(buf, len, sum);
+}
@@ -0,0 +1,54 @@
+#ifndef __CKSUM_H__
+#define __CKSUM_H__
+
+#include <stdint.h>
+
+// Internet checksum, RFC 1071. Data is summed as 16-bit words in memory order, so values
+// in network order are added as they are, no byte swapping is needed.
+//
+// cksum_partial() adds a buffer to a running sum. The kernel is picked at startup: AVX2 if
+// the cpu has it, SSE2 or NEON of the x86-64 and arm64 baselines, scalar otherwise.
+
+typedef uint32_t (*cksum_partial_fct)(const void *buf, uint32_t len, uint32_t sum);
+
+extern cksum_partial_fct cksum_partial_impl;
+
+// Fold a running sum to 16 bits, not complemented
+static inline uint16_t cksum_fold(uint64_t sum)
+{
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum += sum >> 16;
+    return (uint16_t)sum;
+}
+
+// A buffer of odd length must be the last one added
+static inline uint32_t cksum_partial(const void *buf, uint32_t len, uint32_t sum)
+{
+    return cksum_partial_impl(buf, len, sum);
+}
+
+static inline uint16_t cksum_finish(uint32_t sum)
+{
+    return (uint16_t)~cksum_fold(sum);
+}
+
+// RFC 1624 eqn. 3, HC' = ~(~HC + ~m + m'), for a header field changed from old to new
+static inline uint16_t cksum_update16(uint16_t check, uint16_t old, uint16_t new)
+{
+    uint32_t sum = (uint16_t)~check + (uint16_t)~old + new;
+
+    return (uint16_t)~cksum_fold(sum);
+}
+
+static inline uint16_t cksum_update32(uint16_t check, uint32_t old, uint32_t new)
+{
+    uint32_t sum = (uint16_t)~check;
+
+    sum += (uint16_t)~(old >> 16) + (uint16_t)~(old & 0xffff);
+    sum += (new >> 16) + (new & 0xffff);
+    return (uint16_t)~cksum_fold(sum);
+}
+
+#endif
@@ -0,0 +1,206 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/digest.h"
+
+#define ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static const uint32_t md5_k[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static const uint8_t md5_r[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static void md5_block(uint32_t *h, const uint8_t *blk)
+{
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], m[16], f, t;
+    int i, g;
+
+    for (i = 0; i < 16; i ++) {
+        m[i] = blk[i * 4] | (blk[i * 4 + 1] << 8) | (blk[i * 4 + 2] << 16) | ((uint32_t)blk[i * 4 + 3] << 24);
+    }
+    for (i = 0; i < 64; i ++) {
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) & 15;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) & 15;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) & 15;
+        }
+        t = d;
+        d = c;
+        c = b;
+        b += ROL32(a + f + md5_k[i] + m[g], md5_r[i]);
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+}
+
+static void sha256_block(uint32_t *h, const uint8_t *blk)
+{
+    uint32_t w[64], s[8], t1, t2;
+    int i;
+
+    for (i = 0; i < 16; i ++) {
+        w[i] = ((uint32_t)blk[i * 4] << 24) | (blk[i * 4 + 1] << 16) | (blk[i * 4 + 2] << 8) | blk[i * 4 + 3];
+    }
+    for (i = 16; i < 64; i ++) {
+        uint32_t s0 = ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    memcpy(s, h, sizeof(s));
+    for (i = 0; i < 64; i ++) {
+        t1 = s[7] + (ROR32(s[4], 6) ^ ROR32(s[4], 11) ^ ROR32(s[4], 25)) +
+             ((s[4] & s[5]) ^ (~s[4] & s[6])) + sha256_k[i] + w[i];
+        t2 = (ROR32(s[0], 2) ^ ROR32(s[0], 13) ^ ROR32(s[0], 22)) +
+             ((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+        memmove(&s[1], &s[0], sizeof(uint32_t) * 7);
+        s[4] += t1;
+        s[0] = t1 + t2;
+    }
+    for (i = 0; i < 8; i ++) {
+        h[i] += s[i];
+    }
+}
+
+typedef void (*digest_block_fct)(uint32_t *h, const uint8_t *blk);
+
+static void digest_update(uint32_t *h, uint64_t *total, uint8_t *buf, digest_block_fct block,
+                          const uint8_t *data, uint32_t len)
+{
+    uint32_t used = *total & 63;
+
+    *total += len;
+    if (used > 0) {
+        uint32_t n = min(64 - used, len);
+
+        memcpy(buf + used, data, n);
+        data += n;
+        len -= n;
+        if (used + n < 64) {
+            return;
+        }
+        block(h, buf);
+    }
+    while (len >= 64) {
+        block(h, data);
+        data += 64;
+        len -= 64;
+    }
+    memcpy(buf, data, len);
+}
+
+// Pad to 56 bytes mod 64 and append the length in bits, little endian for md5
+static void digest_pad(uint32_t *h, uint64_t total, uint8_t *buf, digest_block_fct block, bool be)
+{
+    uint32_t used = total & 63;
+    uint64_t bits = total << 3;
+    int i;
+
+    buf[used ++] = 0x80;
+    if (used > 56) {
+        memset(buf + used, 0, 64 - used);
+        block(h, buf);
+        used = 0;
+    }
+    memset(buf + used, 0, 56 - used);
+    for (i = 0; i < 8; i ++) {
+        buf[be ? 63 - i : 56 + i] = bits >> (i * 8);
+    }
+    block(h, buf);
+}
+
+void md5_init(md5_ctx_t *ctx)
+{
+    ctx->h[0] = 0x67452301;
+    ctx->h[1] = 0xefcdab89;
+    ctx->h[2] = 0x98badcfe;
+    ctx->h[3] = 0x10325476;
+    ctx->len = 0;
+}
+
+void md5_update(md5_ctx_t *ctx, const void *data, uint32_t len)
+{
+    digest_update(ctx->h, &ctx->len, ctx->buf, md5_block, data, len);
+}
+
+void md5_final(md5_ctx_t *ctx, uint8_t *digest)
+{
+    int i;
+
+    digest_pad(ctx->h, ctx->len, ctx->buf, md5_block, false);
+    for (i = 0; i < MD5_DIGEST_LEN; i ++) {
+        digest[i] = ctx->h[i >> 2] >> ((i & 3) * 8);
+    }
+}
+
+void sha256_init(sha256_ctx_t *ctx)
+{
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    memcpy(ctx->h, iv, sizeof(iv));
+    ctx->len = 0;
+}
+
+void sha256_update(sha256_ctx_t *ctx, const void *data, uint32_t len)
+{
+    digest_update(ctx->h, &ctx->len, ctx->buf, sha256_block, data, len);
+}
+
+void sha256_final(sha256_ctx_t *ctx, uint8_t *digest)
+{
+    int i;
+
+    digest_pad(ctx->h, ctx->len, ctx->buf, sha256_block, true);
+    for (i = 0; i < SHA256_DIGEST_LEN; i ++) {
+        digest[i] = ctx->h[i >> 2] >> ((3 - (i & 3)) * 8);
+    }
+}
+
+void digest_hex(const uint8_t *digest, int len, char *out)
+{
+    static const char hex[] = "0123456789abcdef";
+    int i;
+
+    for (i = 0; i < len; i ++) {
+        out[i * 2] = hex[digest[i] >> 4];
+        out[i * 2 + 1] = hex[digest[i] & 0xf];
+    }
+    out[len * 2] = '\0';
+}
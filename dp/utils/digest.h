@@ -0,0 +1,35 @@
+#ifndef __DIGEST_H__
+#define __DIGEST_H__
+
+#include <stdint.h>
+
+// MD5 (RFC 1321) and SHA-256 (FIPS 180-4) for fingerprints, not for anything that needs to
+// resist an attacker. Data can be added in any number of pieces.
+
+#define MD5_DIGEST_LEN     16
+#define SHA256_DIGEST_LEN  32
+
+typedef struct md5_ctx_ {
+    uint32_t h[4];
+    uint64_t len;
+    uint8_t buf[64];
+} md5_ctx_t;
+
+typedef struct sha256_ctx_ {
+    uint32_t h[8];
+    uint64_t len;
+    uint8_t buf[64];
+} sha256_ctx_t;
+
+void md5_init(md5_ctx_t *ctx);
+void md5_update(md5_ctx_t *ctx, const void *data, uint32_t len);
+void md5_final(md5_ctx_t *ctx, uint8_t *digest);
+
+void sha256_init(sha256_ctx_t *ctx);
+void sha256_update(sha256_ctx_t *ctx, const void *data, uint32_t len);
+void sha256_final(sha256_ctx_t *ctx, uint8_t *digest);
+
+// Write 2 * len lower case hex digits and a terminating zero
+void digest_hex(const uint8_t *digest, int len, char *out);
+
+#endif
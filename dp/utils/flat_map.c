@@ -0,0 +1,287 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/flat_map.h"
+
+#define FLAT_MAP_MIN_SIZE   16
+#define FLAT_MAP_MOVE_SLOTS 16      // old slots visited by each add while resizing
+
+static inline bool flat_map_over_load(uint32_t count, uint32_t size)
+{
+    return count > size - size / 8;
+}
+
+static void flat_map_insert(flat_map_slot_t *slots, uint32_t mask, uint32_t hash, void *data)
+{
+    flat_map_slot_t cur, tmp;
+    uint32_t i = hash & mask;
+
+    cur.hash = hash;
+    cur.dist = 0;
+    cur.data = data;
+
+    for (;; i = (i + 1) & mask, cur.dist ++) {
+        flat_map_slot_t *s = &slots[i];
+
+        if (s->data == NULL) {
+            *s = cur;
+            return;
+        }
+        // Take the slot from an entry closer to its home, carry that one further
+        if (s->dist < cur.dist) {
+            tmp = *s;
+            *s = cur;
+            cur = tmp;
+        }
+    }
+}
+
+static int flat_map_locate(const flat_map_slot_t *slots, uint32_t mask, uint32_t hash, const void *data)
+{
+    uint32_t i = hash & mask, dist;
+
+    for (dist = 0; ; dist ++, i = (i + 1) & mask) {
+        const flat_map_slot_t *s = &slots[i];
+
+        if (s->data == NULL || s->dist < dist) {
+            return -1;
+        }
+        if (s->data == data) {
+            return i;
+        }
+    }
+}
+
+// Remove slot i, shift the following entries back until one is empty or at its home slot.
+// Entries never move across an empty slot.
+static void flat_map_remove(flat_map_slot_t *slots, uint32_t mask, uint32_t i)
+{
+    for (;;) {
+        flat_map_slot_t *s = &slots[i], *next = &slots[(i + 1) & mask];
+
+        if (next->data == NULL || next->dist == 0) {
+            s->data = NULL;
+            s->dist = 0;
+            return;
+        }
+        *s = *next;
+        s->dist --;
+        i = (i + 1) & mask;
+    }
+}
+
+static uint32_t flat_map_empty_slot(const flat_map_slot_t *slots)
+{
+    uint32_t i;
+
+    // There is always one
+    for (i = 0; slots[i].data != NULL; i ++);
+    return i;
+}
+
+// Move the entries of up to 'budget' old slots. The move walks from an empty slot, and taking
+// out an entry pulls the next one into the same slot, much like flat_map_for_each().
+static void flat_map_move(flat_map_t *m, uint32_t budget)
+{
+    uint32_t old_size = m->old_mask + 1;
+
+    while (budget > 0 && m->old_count > 0 && m->old_pos <= old_size) {
+        uint32_t i = (m->old_start + m->old_pos) & m->old_mask;
+        flat_map_slot_t *s = &m->old_slots[i];
+
+        budget --;
+        if (s->data == NULL) {
+            m->old_pos ++;
+            continue;
+        }
+
+        flat_map_insert(m->slots, m->mask, s->hash, s->data);
+        flat_map_remove(m->old_slots, m->old_mask, i);
+        m->old_count --;
+    }
+
+    if (m->old_count == 0) {
+        free(m->old_slots);
+        m->old_slots = NULL;
+    }
+}
+
+static int flat_map_grow(flat_map_t *m)
+{
+    uint32_t size = (m->mask + 1) << 1;
+    flat_map_slot_t *slots;
+
+    if (m->old_slots != NULL) {
+        flat_map_move(m, UINT32_MAX);
+    }
+
+    slots = calloc(size, sizeof(*slots));
+    if (slots == NULL) {
+        return -1;
+    }
+
+    m->old_slots = m->slots;
+    m->old_mask = m->mask;
+    m->old_count = m->count;
+    m->old_start = flat_map_empty_slot(m->old_slots);
+    m->old_pos = 1;
+    m->slots = slots;
+    m->mask = size - 1;
+    m->resizes ++;
+    return 0;
+}
+
+// 'size' is the expected number of entries
+flat_map_t *flat_map_init(flat_map_t *m, uint32_t size,
+                          flat_map_match_fct match_func, flat_map_hash_fct hash_func)
+{
+    uint32_t n = FLAT_MAP_MIN_SIZE;
+
+    while (n < (1u << 31) && flat_map_over_load(size, n)) {
+        n <<= 1;
+    }
+
+    memset(m, 0, sizeof(*m));
+    m->slots = calloc(n, sizeof(*m->slots));
+    if (m->slots == NULL) {
+        return NULL;
+    }
+    m->mask = n - 1;
+    m->match = match_func;
+    m->hash = hash_func;
+    return m;
+}
+
+void flat_map_destroy(flat_map_t *m)
+{
+    free(m->slots);
+    free(m->old_slots);
+    m->slots = m->old_slots = NULL;
+    m->count = m->old_count = 0;
+}
+
+// If growing fails, fill up the map but always leave one slot empty, iteration and the move
+// depend on it.
+int flat_map_add(flat_map_t *m, void *data, const void *key)
+{
+    uint32_t size = m->mask + 1;
+
+    if (flat_map_over_load(m->count + 1, size)) {
+        if (flat_map_grow(m) < 0 && m->count - m->old_count + 1 >= size) {
+            return -1;
+        }
+    }
+
+    flat_map_insert(m->slots, m->mask, m->hash(key), data);
+    m->count ++;
+
+    if (m->old_slots != NULL) {
+        flat_map_move(m, FLAT_MAP_MOVE_SLOTS);
+    }
+    return 0;
+}
+
+int flat_map_del(flat_map_t *m, void *data)
+{
+    uint32_t hash = m->hash(data);
+    int i;
+
+    i = flat_map_locate(m->slots, m->mask, hash, data);
+    if (i >= 0) {
+        flat_map_remove(m->slots, m->mask, i);
+        m->count --;
+        return 0;
+    }
+
+    if (m->old_slots != NULL) {
+        i = flat_map_locate(m->old_slots, m->old_mask, hash, data);
+        if (i >= 0) {
+            flat_map_remove(m->old_slots, m->old_mask, i);
+            m->count --;
+            m->old_count --;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static bool flat_map_walk(flat_map_slot_t *slots, uint32_t mask,
+                          flat_map_for_each_fct each_func, void *args)
+{
+    uint32_t size = mask + 1, start, n;
+
+    // Start after an empty slot, no entry is shifted across it. Deleting the visited entry
+    // can only pull in the next entry, which is visited from the same slot.
+    start = flat_map_empty_slot(slots);
+
+    for (n = 1; n <= size; ) {
+        uint32_t i = (start + n) & mask;
+        void *data = slots[i].data;
+
+        if (data == NULL) {
+            n ++;
+            continue;
+        }
+        if (each_func(data, args)) {
+            return true;
+        }
+        if (slots[i].data == data) {
+            n ++;
+        }
+    }
+    return false;
+}
+
+// each_func may delete the entry it is called with, but must not add entries.
+void flat_map_for_each(flat_map_t *m, flat_map_for_each_fct each_func, void *args)
+{
+    if (flat_map_walk(m->slots, m->mask, each_func, args)) {
+        return;
+    }
+    if (m->old_slots != NULL) {
+        flat_map_walk(m->old_slots, m->old_mask, each_func, args);
+    }
+}
+
+// Visit up to 'n' entries from position 'pos' on, 0 to start, for a walk over several calls.
+// The slots being moved by a resize come after the current ones. Entries added or moved between
+// calls can be visited twice or missed. Returns the position to go on from, 0 at the end.
+uint32_t flat_map_walk_from(flat_map_t *m, uint32_t pos, uint32_t n,
+                            flat_map_for_each_fct each_func, void *args)
+{
+    uint32_t cur = m->mask + 1, end = cur + (m->old_slots != NULL ? m->old_mask + 1 : 0);
+
+    while (pos < end && n > 0) {
+        flat_map_slot_t *s = pos < cur ? &m->slots[pos] : &m->old_slots[pos - cur];
+
+        pos ++;
+        if (s->data != NULL) {
+            n --;
+            if (each_func(s->data, args)) {
+                break;
+            }
+        }
+    }
+    return pos < end ? pos : 0;
+}
+
+// Visit up to 'n' entries of the current slots from slot 'start' on, scanning no more than 4 * n
+// slots. For sampling; each_func must not change the map. Returns the slot to go on from.
+uint32_t flat_map_sample(flat_map_t *m, uint32_t start, uint32_t n,
+                         flat_map_for_each_fct each_func, void *args)
+{
+    uint32_t i = start & m->mask, scan = min(n * 4, m->mask + 1);
+
+    for (; scan > 0 && n > 0; scan --, i = (i + 1) & m->mask) {
+        void *data = m->slots[i].data;
+
+        if (data != NULL) {
+            n --;
+            if (each_func(data, args)) {
+                return (i + 1) & m->mask;
+            }
+        }
+    }
+    return i;
+}
@@ -0,0 +1,100 @@
+#ifndef __FLAT_MAP_H__
+#define __FLAT_MAP_H__
+
+#include <stdint.h>
+
+// Open addressing hash map for maps that only the owning thread reads and writes. Robin hood
+// probing keeps entries close to their home slot, and the full hash is kept in the slot, so a
+// lookup scans one short run of contiguous slots and calls match only on a hash hit. Entries
+// are deleted by backward shift, there are no tombstones.
+//
+// The map doubles at 7/8 load. Entries are moved to the new slots a few at a time on each
+// add, and both slot arrays are looked up until the move is done, so no add pays for a full
+// rehash.
+//
+// The hash function is also applied to the stored data on delete, so data must be its own key.
+
+typedef uint32_t (*flat_map_hash_fct)(const void *key);
+typedef bool (*flat_map_match_fct)(const void *data, const void *key);
+// return true to exit loop
+typedef bool (*flat_map_for_each_fct)(void *data, void *args);
+
+typedef struct flat_map_slot_ {
+    uint32_t hash;
+    uint32_t dist;          // distance from the home slot
+    void *data;             // NULL if empty
+} flat_map_slot_t;
+
+typedef struct flat_map_ {
+    flat_map_slot_t *slots;
+    uint32_t mask;
+    uint32_t count;             // in both slot arrays
+    flat_map_match_fct match;
+    flat_map_hash_fct hash;
+
+    // Slots being moved, NULL if not resizing
+    flat_map_slot_t *old_slots;
+    uint32_t old_mask;
+    uint32_t old_count;
+    uint32_t old_start;         // an empty old slot, the move goes on from there
+    uint32_t old_pos;
+    uint32_t resizes;
+} flat_map_t;
+
+flat_map_t *flat_map_init(flat_map_t *m, uint32_t size,
+                          flat_map_match_fct match_func, flat_map_hash_fct hash_func);
+void flat_map_destroy(flat_map_t *m);
+
+int flat_map_add(flat_map_t *m, void *data, const void *key);
+int flat_map_del(flat_map_t *m, void *data);
+void flat_map_for_each(flat_map_t *m, flat_map_for_each_fct each_func, void *args);
+uint32_t flat_map_walk_from(flat_map_t *m, uint32_t pos, uint32_t n,
+                            flat_map_for_each_fct each_func, void *args);
+uint32_t flat_map_sample(flat_map_t *m, uint32_t start, uint32_t n,
+                         flat_map_for_each_fct each_func, void *args);
+
+static inline void *flat_map_probe(const flat_map_slot_t *slots, uint32_t mask, uint32_t hash,
+                                   const void *key, flat_map_match_fct match)
+{
+    uint32_t i = hash & mask, dist;
+
+    for (dist = 0; ; dist ++, i = (i + 1) & mask) {
+        const flat_map_slot_t *s = &slots[i];
+
+        if (s->data == NULL || s->dist < dist) {
+            return NULL;
+        }
+        if (s->hash == hash && match(s->data, key)) {
+            return s->data;
+        }
+    }
+}
+
+// Callers on the packet path pass their own hash and match, which the compiler can inline.
+static inline void *flat_map_find(const flat_map_t *m, uint32_t hash, const void *key,
+                                  flat_map_match_fct match)
+{
+    void *data = flat_map_probe(m->slots, m->mask, hash, key, match);
+
+    if (unlikely(data == NULL && m->old_slots != NULL)) {
+        data = flat_map_probe(m->old_slots, m->old_mask, hash, key, match);
+    }
+    return data;
+}
+
+static inline void *flat_map_lookup(const flat_map_t *m, const void *key)
+{
+    return flat_map_find(m, m->hash(key), key, m->match);
+}
+
+static inline uint32_t flat_map_count(const flat_map_t *m)
+{
+    return m->count;
+}
+
+static inline uint32_t flat_map_slots(const flat_map_t *m)
+{
+    return m->mask + 1;
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include <stdint.h>
+#include <string.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#include "utils/hash.h"
+
+// Reflected CRC32C, as the instructions compute it: no inversion here, bytes in memory order.
+
+#define CRC32C_POLY 0x82f63b78
+
+// Bit by bit, only for cpus from before the instructions
+static uint32_t hash_crc32c_scalar(const void *key, uint32_t len, uint32_t crc)
+{
+    const uint8_t *p = key;
+    int i;
+
+    while (len > 0) {
+        crc ^= *p;
+        for (i = 0; i < 8; i ++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        }
+        p ++;
+        len --;
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+static uint32_t hash_crc32c_sse42(const void *key, uint32_t len, uint32_t crc)
+{
+    const uint8_t *p = key;
+    uint64_t c = crc, w64;
+    uint32_t w32;
+
+    while (len >= 8) {
+        memcpy(&w64, p, 8);
+        c = _mm_crc32_u64(c, w64);
+        p += 8;
+        len -= 8;
+    }
+    crc = (uint32_t)c;
+    if (len >= 4) {
+        memcpy(&w32, p, 4);
+        crc = _mm_crc32_u32(crc, w32);
+        p += 4;
+        len -= 4;
+    }
+    while (len > 0) {
+        crc = _mm_crc32_u8(crc, *p);
+        p ++;
+        len --;
+    }
+    return crc;
+}
+#elif defined(__aarch64__)
+// CRC32 is optional before ARMv8.1, the instructions are enabled for these lines only
+static uint32_t hash_crc32c_armv8(const void *key, uint32_t len, uint32_t crc)
+{
+    const uint8_t *p = key;
+    uint64_t w64;
+    uint32_t w32;
+
+    while (len >= 8) {
+        memcpy(&w64, p, 8);
+        __asm__(".arch_extension crc\n\tcrc32cx %w0, %w0, %x1" : "+r"(crc) : "r"(w64));
+        p += 8;
+        len -= 8;
+    }
+    if (len >= 4) {
+        memcpy(&w32, p, 4);
+        __asm__(".arch_extension crc\n\tcrc32cw %w0, %w0, %w1" : "+r"(crc) : "r"(w32));
+        p += 4;
+        len -= 4;
+    }
+    while (len > 0) {
+        w32 = *p;
+        __asm__(".arch_extension crc\n\tcrc32cb %w0, %w0, %w1" : "+r"(crc) : "r"(w32));
+        p ++;
+        len --;
+    }
+    return crc;
+}
+#endif
+
+static uint32_t hash_crc32c_resolve(const void *key, uint32_t len, uint32_t crc);
+
+hash_crc32c_fct hash_crc32c_impl = hash_crc32c_resolve;
+
+static hash_crc32c_fct hash_select(void)
+{
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        return hash_crc32c_sse42;
+    }
+#elif defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+        return hash_crc32c_armv8;
+    }
+#endif
+    return hash_crc32c_scalar;
+}
+
+// Called once on the first hash, threads racing here pick the same kernel
+static uint32_t hash_crc32c_resolve(const void *key, uint32_t len, uint32_t crc)
+{
+    hash_crc32c_impl = hash_select();
+    return hash_crc32c_impl(key, len, crc);
+}
@@ -0,0 +1,45 @@
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <stdint.h>
+
+// CRC32C (Castagnoli) of the keys of the hash maps. Keys are packed in fixed-size structs or
+// arrays and hashed with their padding, so they must be zeroed before they are filled.
+//
+// The kernel is picked at startup: the SSE4.2 or ARMv8 CRC32 instructions if the cpu has
+// them, bit by bit otherwise. All give the same value, a hash is never kept outside the process.
+
+#define HASH_CRC32C_INIT 0xffffffff
+
+typedef uint32_t (*hash_crc32c_fct)(const void *key, uint32_t len, uint32_t crc);
+
+extern hash_crc32c_fct hash_crc32c_impl;
+
+// A key in several parts: the crc of each part goes on from the previous one, from
+// HASH_CRC32C_INIT for the first, and hash_finish() gives the hash.
+static inline uint32_t hash_crc32c(const void *key, uint32_t len, uint32_t crc)
+{
+    return hash_crc32c_impl(key, len, crc);
+}
+
+static inline uint32_t hash_finish(uint32_t crc)
+{
+    return ~crc;
+}
+
+static inline uint32_t hash_key(const void *key, uint32_t len)
+{
+    return hash_finish(hash_crc32c_impl(key, len, HASH_CRC32C_INIT));
+}
+
+static inline uint32_t hash_u32(uint32_t v)
+{
+    return hash_key(&v, sizeof(v));
+}
+
+static inline uint32_t hash_u64(uint64_t v)
+{
+    return hash_key(&v, sizeof(v));
+}
+
+#endif
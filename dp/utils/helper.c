@@ -3,7 +3,15 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/syscall.h>
 #include <arpa/inet.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 #include "utils/helper.h"
 
@@ -87,6 +95,143 @@ int count_cpu(void)
     return ret > 0 ? n : 1;
 }
 
+// Parse a cpu list such as "2,3,6-7". Return the number of cpus, -1 on error.
+int parse_cpu_list(const char *str, int *cpus, int max)
+{
+    const char *p = str;
+    char *end;
+    int cnt = 0;
+
+    while (*p != '\0') {
+        long from, to;
+
+        from = strtol(p, &end, 10);
+        if (end == p || from < 0 || from >= MAX_CPU_ID) {
+            return -1;
+        }
+        to = from;
+        p = end;
+        if (*p == '-') {
+            p ++;
+            to = strtol(p, &end, 10);
+            if (end == p || to < from || to >= MAX_CPU_ID) {
+                return -1;
+            }
+            p = end;
+        }
+        for (; from <= to && cnt < max; from ++) {
+            cpus[cnt ++] = from;
+        }
+        if (*p == ',') {
+            p ++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+
+    return cnt;
+}
+
+#define CPU_MASK_LONGS (MAX_CPU_ID / (8 * sizeof(unsigned long)))
+
+static int set_affinity(const unsigned long *mask)
+{
+    return syscall(SYS_sched_setaffinity, 0, CPU_MASK_LONGS * sizeof(unsigned long), mask);
+}
+
+// Pin the calling thread to the given cpus.
+int pin_thread_cpus(const int *cpus, int cnt)
+{
+    unsigned long mask[CPU_MASK_LONGS];
+    int i;
+
+    memset(mask, 0, sizeof(mask));
+    for (i = 0; i < cnt; i ++) {
+        mask[cpus[i] / (8 * sizeof(unsigned long))] |= 1UL << (cpus[i] % (8 * sizeof(unsigned long)));
+    }
+
+    return set_affinity(mask);
+}
+
+// Pin the calling thread to the cpus it can run on except the given ones, all online cpus
+// if its affinity can't be read. Nothing is done if no cpu is left.
+int pin_thread_other_cpus(const int *cpus, int cnt)
+{
+    unsigned long mask[CPU_MASK_LONGS];
+    int i, online, left = 0;
+
+    if (cnt == 0) {
+        return 0;
+    }
+
+    memset(mask, 0, sizeof(mask));
+    if (syscall(SYS_sched_getaffinity, 0, sizeof(mask), mask) <= 0) {
+        online = sysconf(_SC_NPROCESSORS_ONLN);
+        if (online > MAX_CPU_ID) {
+            online = MAX_CPU_ID;
+        }
+        memset(mask, 0, sizeof(mask));
+        for (i = 0; i < online; i ++) {
+            mask[i / (8 * sizeof(unsigned long))] |= 1UL << (i % (8 * sizeof(unsigned long)));
+        }
+    }
+    for (i = 0; i < cnt; i ++) {
+        mask[cpus[i] / (8 * sizeof(unsigned long))] &= ~(1UL << (cpus[i] % (8 * sizeof(unsigned long))));
+    }
+    for (i = 0; i < CPU_MASK_LONGS; i ++) {
+        left |= (mask[i] != 0);
+    }
+    if (!left) {
+        return 0;
+    }
+
+    return set_affinity(mask);
+}
+
+// Return the numa node of the cpu, -1 if unknown.
+int cpu_to_node(int cpu)
+{
+    char path[64];
+    struct dirent *ent;
+    DIR *dir;
+    int node = -1;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    dir = opendir(path);
+    if (dir == NULL) {
+        return -1;
+    }
+    while ((ent = readdir(dir)) != NULL) {
+        if (strncmp(ent->d_name, "node", 4) == 0 && ent->d_name[4] >= '0' && ent->d_name[4] <= '9') {
+            node = atoi(ent->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+
+    return node;
+}
+
+#define MPOL_DEFAULT    0
+#define MPOL_PREFERRED  1
+
+// Prefer memory of the numa node for allocations of the calling thread, node -1
+// restores the default policy.
+int set_mem_node(int node)
+{
+    unsigned long mask;
+
+    if (node < 0) {
+        return syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0);
+    }
+    if (node >= 8 * sizeof(unsigned long)) {
+        return -1;
+    }
+
+    mask = 1UL << node;
+    return syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, 8 * sizeof(unsigned long));
+}
+
 static int8_t hex[256] = {
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
@@ -111,69 +256,95 @@ int8_t c2hex(uint8_t c)
     return hex[c];
 }
 
-uint8_t *consume_string(uint8_t *ptr, int len)
+// Return the first byte that is c1, c2 or c3, 16 bytes at a time. SSE2 and NEON are part of
+// the x86-64 and arm64 baselines, so no runtime dispatch is needed.
+static inline uint8_t *scan_bytes(uint8_t *l, uint8_t *end, uint8_t c1, uint8_t c2, uint8_t c3)
 {
-    register uint8_t *l = ptr, *end = ptr + len;
-
+#if defined(__SSE2__)
+    __m128i v1 = _mm_set1_epi8(c1), v2 = _mm_set1_epi8(c2), v3 = _mm_set1_epi8(c3);
+
+    while (end - l >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)l);
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, v1), _mm_cmpeq_epi8(v, v2)),
+                                                  _mm_cmpeq_epi8(v, v3)));
+        if (mask != 0) {
+            return l + __builtin_ctz(mask);
+        }
+        l += 16;
+    }
+#elif defined(__ARM_NEON)
+    uint8x16_t v1 = vdupq_n_u8(c1), v2 = vdupq_n_u8(c2), v3 = vdupq_n_u8(c3);
+
+    while (end - l >= 16) {
+        uint8x16_t v = vld1q_u8(l);
+        uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, v1), vceqq_u8(v, v2)), vceqq_u8(v, v3));
+        // 4 bits per byte
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+        if (mask != 0) {
+            return l + (__builtin_ctzll(mask) >> 2);
+        }
+        l += 16;
+    }
+#endif
     while (l < end) {
-        if (unlikely(*l == '\0')) {
+        if (*l == c1 || *l == c2 || *l == c3) {
             return l;
         }
-
         l ++;
     }
 
     return NULL;
 }
 
+uint8_t *consume_string(uint8_t *ptr, int len)
+{
+    return scan_bytes(ptr, ptr + len, '\0', '\0', '\0');
+}
+
+uint8_t *consume_until(uint8_t *ptr, int len, uint8_t c1, uint8_t c2, uint8_t c3)
+{
+    return scan_bytes(ptr, ptr + len, c1, c2, c3);
+}
+
 // eol_chars: return number of EOL characters. eg: if line ends with '\r\n', then 2.
 uint8_t *consume_line(uint8_t *ptr, int len, int *eol_chars)
 {
-    register uint8_t *l = ptr, *end = ptr + len;
-    register int n = 0;
+    register uint8_t *l, *nl = scan_bytes(ptr, ptr + len, '\n', '\n', '\n');
 
-    while (l < end) {
-        if (unlikely(*l == '\r')) {
-            n ++;
-        } else if (unlikely(*l == '\n')) {
-            *eol_chars = n + 1;
-            return l + 1;
-        } else {
-            n = 0;
-        }
-
-        l ++;
+    if (nl == NULL) {
+        *eol_chars = 0;
+        return NULL;
     }
 
-    *eol_chars = 0;
-    return NULL;
+    for (l = nl; l > ptr && *(l - 1) == '\r'; l --);
+
+    *eol_chars = nl - l + 1;
+    return nl + 1;
 }
 
 void consume_tokens(uint8_t *ptr, int len, token_func_t func, void *param)
 {
-    register uint8_t *l = ptr, *end = ptr + len, *token = NULL;
+    register uint8_t *l = ptr, *end = ptr + len, *token;
     int idx = 0;
 
     while (l < end) {
         if (*l == ' ') {
-            if (token != NULL) {
-                int ret = func(param, token, l - token, idx);
-                token = NULL;
-                idx ++;
-
-                if (ret == CONSUME_TOKEN_SKIP_LINE) {
-                    return;
-                }
-            }
-        } else if (token == NULL) {
-            token = l;
+            l ++;
+            continue;
         }
 
-        l ++;
-    }
+        token = l;
+        l = scan_bytes(token, end, ' ', ' ', ' ');
+        if (l == NULL) {
+            func(param, token, end - token, idx);
+            return;
+        }
 
-    if (token != NULL) {
-        func(param, token, l - token, idx);
+        if (func(param, token, l - token, idx) == CONSUME_TOKEN_SKIP_LINE) {
+            return;
+        }
+        idx ++;
+        l ++;
     }
 }
 
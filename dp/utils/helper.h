@@ -78,11 +78,18 @@ static inline uint32_t sdbm_hash(register const uint8_t *a, register int len)
 typedef int (*token_func_t) (void *param, uint8_t *ptr, int len, int token_idx);
 
 uint8_t *consume_string(uint8_t *ptr, int len);
+uint8_t *consume_until(uint8_t *ptr, int len, uint8_t c1, uint8_t c2, uint8_t c3);
 uint8_t *consume_line(uint8_t *ptr, int len, int *eol_chars);
 void consume_tokens(uint8_t *ptr, int len, token_func_t func, void *param);
 void lower_string(char* s);
 
 int count_cpu(void);
+#define MAX_CPU_ID 1024
+int parse_cpu_list(const char *str, int *cpus, int max);
+int pin_thread_cpus(const int *cpus, int cnt);
+int pin_thread_other_cpus(const int *cpus, int cnt);
+int cpu_to_node(int cpu);
+int set_mem_node(int node);
 
 static inline uint32_t u32_distance(uint32_t u1, uint32_t u2)
 {
@@ -0,0 +1,195 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "utils/ip4_lpm.h"
+
+#define IP4_LPM_L0_SLOTS    (1 << IP4_LPM_L0_BITS)
+
+// Keep the lowest index, slot values are index + 1 and 0 is empty
+static void ip4_lpm_set(ip4_lpm_t *lpm, uint32_t *slot, uint32_t value)
+{
+    if (*slot & IP4_LPM_EXT) {
+        uint32_t *chunk = &lpm->chunks[(*slot & ~IP4_LPM_EXT) << IP4_LPM_CHUNK_BITS];
+        int i;
+
+        for (i = 0; i < IP4_LPM_CHUNK; i ++) {
+            ip4_lpm_set(lpm, &chunk[i], value);
+        }
+    } else if (*slot == 0 || *slot > value) {
+        *slot = value;
+    }
+}
+
+// Return the chunk index below the slot, allocating it if needed. The slot is passed as an
+// offset, the chunk array may move.
+static int ip4_lpm_chunk(ip4_lpm_t *lpm, uint32_t *table, uint32_t offset)
+{
+    uint32_t e = table == NULL ? lpm->chunks[offset] : table[offset];
+    uint32_t *chunks, i;
+
+    if (e & IP4_LPM_EXT) {
+        return e & ~IP4_LPM_EXT;
+    }
+    if (lpm->chunk_count >= IP4_LPM_EXT) {
+        return -1;
+    }
+
+    chunks = realloc(lpm->chunks, sizeof(uint32_t) * IP4_LPM_CHUNK * (lpm->chunk_count + 1));
+    if (chunks == NULL) {
+        return -1;
+    }
+    lpm->chunks = chunks;
+
+    // Fill with the covering value of the slot
+    for (i = 0; i < IP4_LPM_CHUNK; i ++) {
+        chunks[(lpm->chunk_count << IP4_LPM_CHUNK_BITS) + i] = e;
+    }
+    if (table == NULL) {
+        chunks[offset] = lpm->chunk_count | IP4_LPM_EXT;
+    } else {
+        table[offset] = lpm->chunk_count | IP4_LPM_EXT;
+    }
+    return lpm->chunk_count ++;
+}
+
+static int ip4_lpm_add_irregular(ip4_lpm_t *lpm, uint32_t ip, uint32_t mask, uint32_t index)
+{
+    ip4_lpm_irregular_t *r;
+
+    r = realloc(lpm->irregular, sizeof(*r) * (lpm->irregular_count + 1));
+    if (r == NULL) {
+        return -1;
+    }
+    lpm->irregular = r;
+    r[lpm->irregular_count].ip = ip;
+    r[lpm->irregular_count].mask = mask;
+    r[lpm->irregular_count].index = index;
+    lpm->irregular_count ++;
+    return 0;
+}
+
+ip4_lpm_t *ip4_lpm_create(void)
+{
+    ip4_lpm_t *lpm = calloc(1, sizeof(*lpm));
+
+    if (lpm == NULL) {
+        return NULL;
+    }
+    lpm->l0 = calloc(IP4_LPM_L0_SLOTS, sizeof(uint32_t));
+    if (lpm->l0 == NULL) {
+        free(lpm);
+        return NULL;
+    }
+    return lpm;
+}
+
+int ip4_lpm_add(ip4_lpm_t *lpm, uint32_t ip, uint32_t mask, uint32_t index)
+{
+    uint32_t a = ntohl(ip), m = ntohl(mask), value = index + 1, start, n, i;
+    uint32_t *table;
+    int len, c;
+
+    if (index >= IP4_LPM_EXT - 1) {
+        return -1;
+    }
+    // Never matches
+    if ((ip & ~mask) != 0) {
+        return 0;
+    }
+    // Not a prefix
+    if ((~m & (~m + 1)) != 0) {
+        return ip4_lpm_add_irregular(lpm, ip, mask, index);
+    }
+
+    len = __builtin_popcount(m);
+    if (len <= IP4_LPM_L0_BITS) {
+        table = lpm->l0;
+        start = a >> IP4_LPM_L0_BITS;
+        n = 1 << (IP4_LPM_L0_BITS - len);
+    } else {
+        if ((c = ip4_lpm_chunk(lpm, lpm->l0, a >> IP4_LPM_L0_BITS)) < 0) {
+            return -1;
+        }
+        if (len > IP4_LPM_L0_BITS + IP4_LPM_CHUNK_BITS) {
+            c = ip4_lpm_chunk(lpm, NULL, (c << IP4_LPM_CHUNK_BITS) + ((a >> 8) & 0xff));
+            if (c < 0) {
+                return -1;
+            }
+            start = a & 0xff;
+            n = 1 << (32 - len);
+        } else {
+            start = (a >> 8) & 0xff;
+            n = 1 << (IP4_LPM_L0_BITS + IP4_LPM_CHUNK_BITS - len);
+        }
+        table = &lpm->chunks[c << IP4_LPM_CHUNK_BITS];
+    }
+
+    for (i = 0; i < n; i ++) {
+        ip4_lpm_set(lpm, &table[start + i], value);
+    }
+    return 0;
+}
+
+void ip4_lpm_free(ip4_lpm_t *lpm)
+{
+    if (lpm == NULL) {
+        return;
+    }
+    free(lpm->l0);
+    free(lpm->chunks);
+    free(lpm->irregular);
+    free(lpm);
+}
+
+// 'count' is the number of addresses to add, the set is sized to stay under half full
+ip4_set_t *ip4_set_create(uint32_t count)
+{
+    ip4_set_t *set = calloc(1, sizeof(*set));
+    uint32_t n = 16;
+
+    if (set == NULL) {
+        return NULL;
+    }
+    while (n < (1u << 31) && n < count * 2) {
+        n <<= 1;
+    }
+    set->slots = calloc(n, sizeof(uint32_t));
+    if (set->slots == NULL) {
+        free(set);
+        return NULL;
+    }
+    set->mask = n - 1;
+    return set;
+}
+
+int ip4_set_add(ip4_set_t *set, uint32_t ip)
+{
+    uint32_t i;
+
+    if (ip == 0) {
+        set->has_zero = true;
+        return 0;
+    }
+    if (set->count + 1 > set->mask) {
+        return -1;
+    }
+    for (i = ip4_set_hash(ip) & set->mask; set->slots[i] != 0; i = (i + 1) & set->mask) {
+        if (set->slots[i] == ip) {
+            return 0;
+        }
+    }
+    set->slots[i] = ip;
+    set->count ++;
+    return 0;
+}
+
+void ip4_set_free(ip4_set_t *set)
+{
+    if (set == NULL) {
+        return;
+    }
+    free(set->slots);
+    free(set);
+}
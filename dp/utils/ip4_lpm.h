@@ -0,0 +1,105 @@
+#ifndef __IP4_LPM_H__
+#define __IP4_LPM_H__
+
+#include <stdint.h>
+#include <arpa/inet.h>
+
+// Immutable lookup tables compiled from ipv4 subnet lists, built once on config and only read
+// by the dp threads afterwards.
+//
+// ip4_lpm_t is a 16-8-8 multibit trie with prefix expansion: a 64K entry table indexed by the
+// upper 16 bits, with 256 entry chunks below it for prefixes longer than /16 and /24. A lookup
+// is at most three memory reads. Each slot keeps the lowest list index of the prefixes covering
+// it, so the lookup returns the first matching entry of the list, like a linear scan. Subnets
+// with a non-contiguous mask can't be expanded and are checked one by one.
+//
+// ip4_set_t is an open addressing hash set of exact addresses.
+//
+// Addresses and masks are in network order, as in the subnet lists.
+
+#define IP4_LPM_L0_BITS     16
+#define IP4_LPM_CHUNK_BITS  8
+#define IP4_LPM_CHUNK       (1 << IP4_LPM_CHUNK_BITS)
+#define IP4_LPM_EXT         0x80000000u     // the slot points to a chunk
+
+typedef struct ip4_lpm_irregular_ {
+    uint32_t ip;
+    uint32_t mask;
+    uint32_t index;
+} ip4_lpm_irregular_t;
+
+typedef struct ip4_lpm_ {
+    uint32_t *l0;               // 1 << IP4_LPM_L0_BITS slots
+    uint32_t *chunks;
+    uint32_t chunk_count;
+    uint32_t irregular_count;
+    ip4_lpm_irregular_t *irregular;
+} ip4_lpm_t;
+
+typedef struct ip4_set_ {
+    uint32_t *slots;            // 0 if empty
+    uint32_t mask;
+    uint32_t count;
+    bool has_zero;
+} ip4_set_t;
+
+// Add subnets in list order, index is the position in the list
+ip4_lpm_t *ip4_lpm_create(void);
+int ip4_lpm_add(ip4_lpm_t *lpm, uint32_t ip, uint32_t mask, uint32_t index);
+void ip4_lpm_free(ip4_lpm_t *lpm);
+
+ip4_set_t *ip4_set_create(uint32_t count);
+int ip4_set_add(ip4_set_t *set, uint32_t ip);
+void ip4_set_free(ip4_set_t *set);
+
+// Return the index of the first matching subnet, -1 if none
+static inline int ip4_lpm_lookup(const ip4_lpm_t *lpm, uint32_t ip)
+{
+    uint32_t a = ntohl(ip), e, i;
+    int index;
+
+    e = lpm->l0[a >> IP4_LPM_L0_BITS];
+    if (e & IP4_LPM_EXT) {
+        e = lpm->chunks[((e & ~IP4_LPM_EXT) << IP4_LPM_CHUNK_BITS) + ((a >> 8) & 0xff)];
+        if (e & IP4_LPM_EXT) {
+            e = lpm->chunks[((e & ~IP4_LPM_EXT) << IP4_LPM_CHUNK_BITS) + (a & 0xff)];
+        }
+    }
+    index = (int)e - 1;
+
+    if (unlikely(lpm->irregular_count > 0)) {
+        for (i = 0; i < lpm->irregular_count; i ++) {
+            const ip4_lpm_irregular_t *r = &lpm->irregular[i];
+
+            if (index >= 0 && r->index >= (uint32_t)index) {
+                break;
+            }
+            if ((ip & r->mask) == r->ip) {
+                return r->index;
+            }
+        }
+    }
+    return index;
+}
+
+static inline uint32_t ip4_set_hash(uint32_t ip)
+{
+    return (ip * 0x9e3779b1u) ^ (ip >> 16);
+}
+
+static inline bool ip4_set_lookup(const ip4_set_t *set, uint32_t ip)
+{
+    uint32_t i;
+
+    if (unlikely(ip == 0)) {
+        return set->has_zero;
+    }
+    for (i = ip4_set_hash(ip) & set->mask; set->slots[i] != 0; i = (i + 1) & set->mask) {
+        if (set->slots[i] == ip) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
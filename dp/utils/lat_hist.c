@@ -0,0 +1,76 @@
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "utils/lat_hist.h"
+
+void lat_hist_merge(lat_hist_t *to, const lat_hist_t *from)
+{
+    int i;
+
+    to->count += from->count;
+    to->sum += from->sum;
+    if (from->max > to->max) {
+        to->max = from->max;
+    }
+    for (i = 0; i < LAT_HIST_BUCKETS; i ++) {
+        to->buckets[i] += from->buckets[i];
+    }
+}
+
+uint64_t lat_hist_percentile(const lat_hist_t *h, double pct)
+{
+    uint64_t total = 0, rank, seen = 0;
+    int i;
+
+    // The count can be ahead of the buckets while the writer is at it
+    for (i = 0; i < LAT_HIST_BUCKETS; i ++) {
+        total += h->buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    rank = total * pct / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    for (i = 0; i < LAT_HIST_BUCKETS - 1; i ++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            return min(lat_hist_low(i + 1) - 1, h->max);
+        }
+    }
+    return h->max;
+}
+
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+uint64_t lat_tsc_hz(void)
+{
+    static uint64_t hz;
+
+    if (hz == 0) {
+#if defined(__aarch64__)
+        __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(hz));
+#elif defined(__x86_64__)
+        // An invariant tsc is assumed, 10ms gives the rate to about 0.01%
+        struct timespec pause = {0, 10000000};
+        uint64_t t0 = tsc_read(), n0 = mono_ns(), t1, n1;
+
+        nanosleep(&pause, NULL);
+        t1 = tsc_read();
+        n1 = mono_ns();
+        hz = (unsigned __int128)(t1 - t0) * 1000000000 / (n1 - n0);
+#else
+        hz = 1000000000;
+#endif
+    }
+    return hz;
+}
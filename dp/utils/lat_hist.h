@@ -0,0 +1,86 @@
+#ifndef __LAT_HIST_H__
+#define __LAT_HIST_H__
+
+#include <stdint.h>
+#include <time.h>
+
+// Log-linear latency histogram of cpu timestamp counter ticks, HDR style. Values below 4
+// have a bucket each, above that every power of two is split in 4 buckets, so a value is
+// off by at most 25% of its bucket. Values past the last bucket are counted in it.
+//
+// A histogram has a single writer, other threads read the counters as they are; a reader
+// can see count and buckets a few samples apart.
+
+#define LAT_HIST_SUB_BITS   2
+#define LAT_HIST_BUCKETS    128     // up to 2^33 ticks, a few seconds
+
+typedef struct lat_hist_ {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t buckets[LAT_HIST_BUCKETS];
+} lat_hist_t;
+
+static inline uint64_t tsc_read(void)
+{
+#if defined(__x86_64__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static inline int lat_hist_index(uint64_t v)
+{
+    int msb, idx;
+
+    if (v < (1 << LAT_HIST_SUB_BITS)) {
+        return v;
+    }
+    msb = 63 - __builtin_clzll(v);
+    idx = ((msb - LAT_HIST_SUB_BITS + 1) << LAT_HIST_SUB_BITS) +
+          ((v >> (msb - LAT_HIST_SUB_BITS)) & ((1 << LAT_HIST_SUB_BITS) - 1));
+    return idx < LAT_HIST_BUCKETS ? idx : LAT_HIST_BUCKETS - 1;
+}
+
+// Lowest value of a bucket
+static inline uint64_t lat_hist_low(int idx)
+{
+    int sub = idx & ((1 << LAT_HIST_SUB_BITS) - 1), shift = (idx >> LAT_HIST_SUB_BITS) - 1;
+
+    if (idx < (1 << LAT_HIST_SUB_BITS)) {
+        return idx;
+    }
+    return (uint64_t)((1 << LAT_HIST_SUB_BITS) + sub) << shift;
+}
+
+static inline void lat_hist_add(lat_hist_t *h, uint64_t v)
+{
+    h->count ++;
+    h->sum += v;
+    if (v > h->max) {
+        h->max = v;
+    }
+    h->buckets[lat_hist_index(v)] ++;
+}
+
+void lat_hist_merge(lat_hist_t *to, const lat_hist_t *from);
+// Upper bound of the bucket the pct percentile falls in, pct from 0 to 100
+uint64_t lat_hist_percentile(const lat_hist_t *h, double pct);
+// Ticks per second of tsc_read(), measured on the first call
+uint64_t lat_tsc_hz(void);
+
+static inline uint64_t lat_tsc_to_ns(uint64_t ticks, uint64_t hz)
+{
+    return hz == 0 ? 0 : (unsigned __int128)ticks * 1000000000 / hz;
+}
+
+#endif
@@ -0,0 +1,33 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "utils/mem_acct.h"
+
+int64_t g_mem_acct[MEM_ACCT_ROWS][DP_MEM_MAX] __attribute__((aligned(64)));
+__thread int t_mem_acct_row = MEM_ACCT_SHARED;
+
+void mem_acct_bind(int thr_id)
+{
+    t_mem_acct_row = thr_id;
+}
+
+void mem_acct_row(int row, int64_t *bytes)
+{
+    int j;
+
+    for (j = 0; j < DP_MEM_MAX; j ++) {
+        bytes[j] = __atomic_load_n(&g_mem_acct[row][j], __ATOMIC_RELAXED);
+    }
+}
+
+void mem_acct_total(int64_t *bytes)
+{
+    int i, j;
+
+    memset(bytes, 0, sizeof(int64_t) * DP_MEM_MAX);
+    for (i = 0; i < MEM_ACCT_ROWS; i ++) {
+        for (j = 0; j < DP_MEM_MAX; j ++) {
+            bytes[j] += __atomic_load_n(&g_mem_acct[i][j], __ATOMIC_RELAXED);
+        }
+    }
+}
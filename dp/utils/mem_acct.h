@@ -0,0 +1,88 @@
+#ifndef __MEM_ACCT_H__
+#define __MEM_ACCT_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+// Heap bytes by subsystem, DP_MEM_*. A dp thread counts in its own row with plain stores,
+// the ctrl and other threads share the last row and count atomically. Counts follow the
+// allocating and freeing threads, a row can go negative, only the sum of rows is exact.
+// Rows are one cache line each.
+
+#define MEM_ACCT_SHARED MAX_DP_THREADS
+#define MEM_ACCT_ROWS   (MAX_DP_THREADS + 1)
+
+extern int64_t g_mem_acct[MEM_ACCT_ROWS][DP_MEM_MAX];
+extern __thread int t_mem_acct_row;
+
+// Called by a dp thread before it allocates anything
+void mem_acct_bind(int thr_id);
+// Sum of all rows, or a single row
+void mem_acct_total(int64_t *bytes);
+void mem_acct_row(int row, int64_t *bytes);
+
+static inline void mem_acct_add(int tag, int64_t bytes)
+{
+    if (likely(t_mem_acct_row != MEM_ACCT_SHARED)) {
+        g_mem_acct[t_mem_acct_row][tag] += bytes;
+    } else {
+        __sync_fetch_and_add(&g_mem_acct[MEM_ACCT_SHARED][tag], bytes);
+    }
+}
+
+static inline void *mem_malloc(int tag, size_t size)
+{
+    void *ptr = malloc(size);
+
+    if (likely(ptr != NULL)) {
+        mem_acct_add(tag, malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+static inline void *mem_calloc(int tag, size_t nmemb, size_t size)
+{
+    void *ptr = calloc(nmemb, size);
+
+    if (likely(ptr != NULL)) {
+        mem_acct_add(tag, malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+// As realloc(), ptr is left untouched and counted if NULL is returned
+static inline void *mem_realloc(int tag, void *ptr, size_t size)
+{
+    size_t old = ptr != NULL ? malloc_usable_size(ptr) : 0;
+    void *new_ptr = realloc(ptr, size);
+
+    if (likely(new_ptr != NULL)) {
+        mem_acct_add(tag, (int64_t)malloc_usable_size(new_ptr) - (int64_t)old);
+    } else if (size == 0) {
+        mem_acct_add(tag, -(int64_t)old);
+    }
+    return new_ptr;
+}
+
+static inline char *mem_strdup(int tag, const char *str)
+{
+    size_t len = strlen(str) + 1;
+    char *ptr = mem_malloc(tag, len);
+
+    if (likely(ptr != NULL)) {
+        memcpy(ptr, str, len);
+    }
+    return ptr;
+}
+
+static inline void mem_free(int tag, void *ptr)
+{
+    if (ptr != NULL) {
+        mem_acct_add(tag, -(int64_t)malloc_usable_size(ptr));
+        free(ptr);
+    }
+}
+
+#endif
@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "utils/obj_pool.h"
+
+#define OBJ_POOL_ALIGN      16
+#define OBJ_POOL_GROW_OBJS  64
+
+static int obj_pool_add_chunk(obj_pool_t *pool, uint32_t cnt)
+{
+    uint8_t *chunk, *obj;
+    uint32_t i;
+
+    chunk = malloc((size_t)pool->obj_size * cnt);
+    if (chunk == NULL) {
+        return -1;
+    }
+
+    // Chain in reverse, so objects are handed out in address order
+    obj = chunk + (size_t)pool->obj_size * cnt;
+    for (i = 0; i < cnt; i ++) {
+        obj_pool_free_t *f;
+
+        obj -= pool->obj_size;
+        f = (obj_pool_free_t *)obj;
+        f->next = pool->free_list;
+        pool->free_list = f;
+    }
+    pool->total += cnt;
+    return 0;
+}
+
+int obj_pool_grow(obj_pool_t *pool)
+{
+    uint32_t cnt = OBJ_POOL_GROW_OBJS;
+
+    if (pool->cap > 0) {
+        if (pool->total >= pool->cap) {
+            return -1;
+        }
+        cnt = min(cnt, pool->cap - pool->total);
+    }
+    return obj_pool_add_chunk(pool, cnt);
+}
+
+int obj_pool_init(obj_pool_t *pool, uint32_t obj_size, uint32_t prealloc, uint32_t cap)
+{
+    memset(pool, 0, sizeof(*pool));
+    obj_size = max(obj_size, sizeof(obj_pool_free_t));
+    pool->obj_size = (obj_size + OBJ_POOL_ALIGN - 1) & ~(OBJ_POOL_ALIGN - 1);
+    pool->cap = cap;
+
+    if (cap > 0 && prealloc > cap) {
+        prealloc = cap;
+    }
+    if (prealloc > 0) {
+        return obj_pool_add_chunk(pool, prealloc);
+    }
+    return 0;
+}
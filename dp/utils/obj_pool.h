@@ -0,0 +1,66 @@
+#ifndef __DP_OBJ_POOL_H__
+#define __DP_OBJ_POOL_H__
+
+#include <stdint.h>
+#include <string.h>
+
+// Fixed-size object pool owned by a single thread, no locking. Objects are carved out of
+// chunks that are never returned; a freed object goes to the head of the free list, so the
+// next allocation reuses the most recently touched memory.
+
+typedef struct obj_pool_free_ {
+    struct obj_pool_free_ *next;
+} obj_pool_free_t;
+
+typedef struct obj_pool_ {
+    obj_pool_free_t *free_list;
+    uint32_t obj_size;
+    uint32_t cap;           // max. objects, 0 for no limit
+    uint32_t total;         // objects carved out of the chunks
+    uint32_t in_use;
+    uint32_t high_water;
+    uint64_t fails;         // allocations refused by the cap or failed to grow
+} obj_pool_t;
+
+int obj_pool_init(obj_pool_t *pool, uint32_t obj_size, uint32_t prealloc, uint32_t cap);
+int obj_pool_grow(obj_pool_t *pool);
+
+static inline void *obj_pool_alloc(obj_pool_t *pool)
+{
+    obj_pool_free_t *obj = pool->free_list;
+
+    if (unlikely(obj == NULL)) {
+        if (obj_pool_grow(pool) < 0) {
+            pool->fails ++;
+            return NULL;
+        }
+        obj = pool->free_list;
+    }
+
+    pool->free_list = obj->next;
+    if (++ pool->in_use > pool->high_water) {
+        pool->high_water = pool->in_use;
+    }
+    return obj;
+}
+
+static inline void *obj_pool_zalloc(obj_pool_t *pool)
+{
+    void *obj = obj_pool_alloc(pool);
+
+    if (likely(obj != NULL)) {
+        memset(obj, 0, pool->obj_size);
+    }
+    return obj;
+}
+
+static inline void obj_pool_free(obj_pool_t *pool, void *ptr)
+{
+    obj_pool_free_t *obj = ptr;
+
+    obj->next = pool->free_list;
+    pool->free_list = obj;
+    pool->in_use --;
+}
+
+#endif
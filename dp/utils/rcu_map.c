@@ -4,8 +4,14 @@ rcu_map_t *rcu_map_init(rcu_map_t *m, uint32_t buckets, int node_offset,
                         cds_lfht_match_fct match_func, rcu_map_hash_fct hash_func)
 {
     struct cds_lfht *ht_map;
+    uint32_t n = 1;
+
+    // lfht takes a power of 2
+    while (n < buckets && n < (1u << 31)) {
+        n <<= 1;
+    }
    
-    ht_map = cds_lfht_new(buckets, buckets, 0, CDS_LFHT_AUTO_RESIZE | CDS_LFHT_ACCOUNTING, NULL);
+    ht_map = cds_lfht_new(n, n, 0, CDS_LFHT_AUTO_RESIZE | CDS_LFHT_ACCOUNTING, NULL);
     if (ht_map == NULL) {
         return NULL;
     }
@@ -14,6 +20,8 @@ rcu_map_t *rcu_map_init(rcu_map_t *m, uint32_t buckets, int node_offset,
     m->match = match_func;
     m->hash = hash_func;
     m->offset = node_offset;
+    m->buckets = n;
+    m->count = 0;
     return m;
 }
 
@@ -27,6 +35,7 @@ void rcu_map_add(rcu_map_t *m, void *data, const void *key)
     uint32_t hash = m->hash(key);
 
     cds_lfht_add(m->map, hash, data);
+    uatomic_inc(&m->count);
 }
 
 void *rcu_map_add_replace(rcu_map_t *m, void *data, const void *key)
@@ -36,6 +45,7 @@ void *rcu_map_add_replace(rcu_map_t *m, void *data, const void *key)
 
     node = cds_lfht_add_replace(m->map, hash, m->match, key, data + m->offset);
     if (node == NULL) {
+        uatomic_inc(&m->count);
         return NULL;
     } else {
         return (void *)node - m->offset;
@@ -71,7 +81,12 @@ void rcu_map_for_each(rcu_map_t *m, rcu_map_for_each_fct each_func, void *args)
 
 int rcu_map_del(rcu_map_t *m, void *data)
 {
-    return cds_lfht_del(m->map, (struct cds_lfht_node *)(data + m->offset));
+    int ret = cds_lfht_del(m->map, (struct cds_lfht_node *)(data + m->offset));
+
+    if (ret == 0) {
+        uatomic_dec(&m->count);
+    }
+    return ret;
 }
 
 
@@ -15,6 +15,8 @@ typedef struct rcu_map_ {
     cds_lfht_match_fct match;
     rcu_map_hash_fct hash;
     int offset;
+    uint32_t buckets;           // initial
+    uint32_t count;
 } rcu_map_t;
 
 
@@ -0,0 +1,41 @@
+#ifndef __DP_SEQLOCK_H__
+#define __DP_SEQLOCK_H__
+
+#include <stdint.h>
+
+#include "urcu.h"
+
+// Single writer sequence lock. seq is odd while the writer updates the protected data;
+// a reader retries its copy if seq was odd or changed in between.
+typedef struct seqlock_ {
+    uint32_t seq;
+} seqlock_t;
+
+static inline void seqlock_write_begin(seqlock_t *l)
+{
+    __atomic_store_n(&l->seq, l->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void seqlock_write_end(seqlock_t *l)
+{
+    __atomic_store_n(&l->seq, l->seq + 1, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t seqlock_read_begin(const seqlock_t *l)
+{
+    uint32_t seq;
+
+    while ((seq = __atomic_load_n(&l->seq, __ATOMIC_ACQUIRE)) & 1) {
+        caa_cpu_relax();
+    }
+    return seq;
+}
+
+static inline bool seqlock_read_retry(const seqlock_t *l, uint32_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&l->seq, __ATOMIC_RELAXED) != seq;
+}
+
+#endif
@@ -5,54 +5,156 @@
 #include "utils/timer_wheel.h"
 #include "utils/helper.h"
 
+#define L0_MASK (TIMER_WHEEL_L0_SLOTS - 1)
+#define LN_MASK (TIMER_WHEEL_LN_SLOTS - 1)
+
+static inline bool time_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static inline struct cds_list_head *level_slot(timer_wheel_t *w, int level, uint32_t idx)
+{
+    return &w->slots[TIMER_WHEEL_L0_SLOTS + (level - 1) * TIMER_WHEEL_LN_SLOTS + idx];
+}
+
+static inline uint32_t level_shift(int level)
+{
+    return TIMER_WHEEL_L0_BITS + (level - 1) * TIMER_WHEEL_LN_BITS;
+}
+
+// Put the entry on the lowest level whose turn covers its expiry
+static void timer_wheel_link(timer_wheel_t *w, timer_entry_t *n)
+{
+    uint32_t expires = n->expires, delta = expires - w->current;
+    struct cds_list_head *head;
+    int level;
+
+    if (time_before(expires, w->current)) {
+        // Already due, expires at the next roll
+        head = &w->slots[w->current & L0_MASK];
+    } else if (delta < TIMER_WHEEL_L0_SLOTS) {
+        head = &w->slots[expires & L0_MASK];
+    } else {
+        for (level = 1; level < TIMER_WHEEL_LEVELS - 1; level ++) {
+            if (delta < (1u << (level_shift(level) + TIMER_WHEEL_LN_BITS))) {
+                break;
+            }
+        }
+        head = level_slot(w, level, (expires >> level_shift(level)) & LN_MASK);
+    }
+    cds_list_add_tail(&n->link, head);
+}
+
+// Move the entries of the level's current slot down, they all expire within one turn of the
+// level below. Returns the slot index, the next level is due as well if it is 0.
+static uint32_t timer_wheel_cascade(timer_wheel_t *w, int level)
+{
+    uint32_t idx = (w->current >> level_shift(level)) & LN_MASK;
+    struct cds_list_head *head = level_slot(w, level, idx);
+
+    // Entries always land on a lower level, so the head empties
+    while (!cds_list_empty(head)) {
+        timer_entry_t *itr = cds_list_first_entry(head, timer_entry_t, link);
+        cds_list_del(&itr->link);
+        timer_wheel_link(w, itr);
+    }
+    return idx;
+}
 
 void timer_wheel_init(timer_wheel_t *w)
 {
     int i;
 
-    for (i = 0; i < MAX_TIMER_SLOTS; i ++) {
+    for (i = 0; i < TIMER_WHEEL_SLOTS; i ++) {
         CDS_INIT_LIST_HEAD(&w->slots[i]);
     }
     w->current = w->count = 0;
+    w->started = false;
 }
 
-void timer_wheel_start(timer_wheel_t *w, uint32_t now)
+void timer_wheel_start(timer_wheel_t *w, uint32_t now_ms)
 {
-    w->current = now;
+    w->current = now_ms;
+    w->started = true;
 }
 
-uint32_t timer_wheel_roll(timer_wheel_t *w, uint32_t now)
+// Step to the next millisecond, and cascade when the bottom level turns over, once per turn
+static void timer_wheel_advance(timer_wheel_t *w)
 {
-    if (now < w->current) {
-        return 0;
+    int level;
+
+    w->current ++;
+    if ((w->current & L0_MASK) == 0) {
+        for (level = 1; level < TIMER_WHEEL_LEVELS; level ++) {
+            if (timer_wheel_cascade(w, level) != 0) {
+                break;
+            }
+        }
     }
+}
 
+// Expire entries due up to and including now_ms, but no more than 'budget' of them. What is
+// left stays due, and the next roll goes on from the same slot.
+uint32_t timer_wheel_roll(timer_wheel_t *w, uint32_t now_ms, uint32_t budget)
+{
     uint32_t cnt = 0;
-    uint32_t s, m = min(now, w->current + MAX_TIMER_SLOTS);
-    for (s = w->current; s < m; s ++) {
-        struct cds_list_head *head = &w->slots[s % MAX_TIMER_SLOTS];
+
+    while (!time_before(now_ms, w->current)) {
+        struct cds_list_head *head = &w->slots[w->current & L0_MASK];
+
+        if (w->count == 0) {
+            w->current = now_ms + 1;
+            break;
+        }
 
         // Because link entries can be modified in callback, so we cannot use
         // cds_list_for_each_entry_safe() to walk through the list; instead, we remove
         // the head every time and start over again until the link is empty.
         while (!cds_list_empty(head)) {
+            if (cnt >= budget) {
+                return cnt;
+            }
+
             timer_entry_t *itr = cds_list_first_entry(head, timer_entry_t, link);
             timer_wheel_expire_fct fn = itr->callback;
             timer_wheel_entry_remove(w, itr);
             fn(itr);
             cnt ++;
         }
+
+        timer_wheel_advance(w);
     }
 
-    w->current = now;
+    return cnt;
+}
+
+// Entries due by now_ms that are still on the bottom level, counted up to 'cap'. Entries of
+// upper levels that a lagging wheel has not cascaded yet are not counted.
+uint32_t timer_wheel_backlog(timer_wheel_t *w, uint32_t now_ms, uint32_t cap)
+{
+    uint32_t cnt = 0, t, end;
+    struct cds_list_head *pos;
+
+    if (time_before(now_ms, w->current)) {
+        return 0;
+    }
 
+    end = time_before(now_ms, w->current + L0_MASK) ? now_ms : w->current + L0_MASK;
+    for (t = w->current; !time_before(end, t); t ++) {
+        cds_list_for_each(pos, &w->slots[t & L0_MASK]) {
+            if (++ cnt >= cap) {
+                return cnt;
+            }
+        }
+    }
     return cnt;
 }
 
 void timer_wheel_entry_init(timer_entry_t *n)
 {
     CDS_INIT_LIST_HEAD(&n->link);
-    n->expire_slot = (uint16_t)(-1);
+    n->expires = 0;
     n->callback = NULL;
 }
 
@@ -62,7 +164,7 @@ void timer_wheel_entry_init(timer_entry_t *n)
 #define REMOVE 1
 #endif
 
-void timer_wheel_entry_insert(timer_wheel_t *w, timer_entry_t *n, uint32_t now)
+void timer_wheel_entry_insert_ms(timer_wheel_t *w, timer_entry_t *n, uint32_t now_ms)
 {
 #ifdef DEBUG_TIMER_WHEEL
     void *c1 = __builtin_return_address(0);
@@ -84,18 +186,23 @@ void timer_wheel_entry_insert(timer_wheel_t *w, timer_entry_t *n, uint32_t now)
     }
 #endif
 
-    uint32_t expire_at = now + n->timeout;
-    n->expire_slot = expire_at % MAX_TIMER_SLOTS;
-    cds_list_add_tail(&n->link, &w->slots[n->expire_slot]);
+    if (unlikely(!w->started)) {
+        timer_wheel_start(w, now_ms);
+    }
+
+    // Callers pass the time of their last tick, the wheel may have rolled past it
+    uint32_t base = time_before(now_ms, w->current) ? w->current : now_ms;
+    n->expires = base + n->timeout;
+    timer_wheel_link(w, n);
     w->count ++;
 }
 
-void timer_wheel_entry_refresh(timer_wheel_t *w, timer_entry_t *n, uint32_t now)
+void timer_wheel_entry_refresh_ms(timer_wheel_t *w, timer_entry_t *n, uint32_t now_ms)
 {
     timer_wheel_expire_fct fn = n->callback;
     timer_wheel_entry_remove(w, n);
     n->callback = fn;
-    timer_wheel_entry_insert(w, n, now);
+    timer_wheel_entry_insert_ms(w, n, now_ms);
 }
 
 void timer_wheel_entry_remove(timer_wheel_t *w, timer_entry_t *n)
@@ -128,40 +235,26 @@ void timer_wheel_entry_remove(timer_wheel_t *w, timer_entry_t *n)
 
     cds_list_del(&n->link);
     w->count --;
-    //n->expire_slot = (uint16_t)(-1);
     n->callback = NULL;
 }
 
-void timer_wheel_entry_start(timer_wheel_t *w, timer_entry_t *n,
-                             timer_wheel_expire_fct cb, uint16_t timeout, uint32_t now)
+void timer_wheel_entry_start_ms(timer_wheel_t *w, timer_entry_t *n,
+                                timer_wheel_expire_fct cb, uint32_t timeout_ms, uint32_t now_ms)
 {
-    if (unlikely(timeout >= MAX_TIMER_SLOTS)) {
-        timeout = 0;
-    }
-
     n->callback = cb;
-    n->timeout = timeout;
+    timer_wheel_entry_set_timeout_ms(n, timeout_ms);
 
-    timer_wheel_entry_insert(w, n, now);
+    timer_wheel_entry_insert_ms(w, n, now_ms);
 }
 
-static uint32_t get_expire_at(const timer_entry_t *n, uint32_t now)
+uint32_t timer_wheel_entry_get_idle(const timer_entry_t *n, uint32_t now)
 {
-    uint16_t slot = now % MAX_TIMER_SLOTS;
-    if (n->callback == NULL || n->expire_slot >= slot) {
-        return now + n->expire_slot - slot;
-    } else {
-        return now + n->expire_slot + MAX_TIMER_SLOTS - slot;
-    }
-}
-
-uint16_t timer_wheel_entry_get_idle(const timer_entry_t *n, uint32_t now)
-{
-    return (uint16_t)(now - (get_expire_at(n, now) - n->timeout));
+    int32_t idle = (int32_t)(now * 1000 - (n->expires - n->timeout));
+    return idle > 0 ? idle / 1000 : 0;
 }
 
-uint16_t timer_wheel_entry_get_life(const timer_entry_t *n, uint32_t now)
+uint32_t timer_wheel_entry_get_life(const timer_entry_t *n, uint32_t now)
 {
-    return (uint16_t)(get_expire_at(n, now) - now);
+    int32_t life = (int32_t)(n->expires - now * 1000);
+    return life > 0 ? life / 1000 : 0;
 }
-
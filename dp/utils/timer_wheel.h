@@ -3,17 +3,38 @@
 
 #include "urcu/list.h"
 
-#define MAX_TIMER_SLOTS 3600
+// Hierarchical timer wheel in milliseconds. The bottom level has a slot per millisecond, each
+// upper level slot spans a full turn of the level below. An entry is put on the level its
+// timeout falls into and moved down a level when the level below turns over to its slot, so
+// insert and remove are O(1) and a roll only looks at the slots it passes.
+//
+//   level 0: 256 x 1ms, level 1: 64 x 256ms, level 2: 64 x 16.4s, level 3: 64 x 17.5min,
+//   level 4: 64 x 18.6h
+//
+// Times are 32-bit milliseconds that wrap, an entry can be up to TIMER_WHEEL_MAX_TIMEOUT_MS
+// ahead. The functions without the _ms suffix take seconds.
+
+#define TIMER_WHEEL_LEVELS      5
+#define TIMER_WHEEL_L0_BITS     8
+#define TIMER_WHEEL_LN_BITS     6
+#define TIMER_WHEEL_L0_SLOTS    (1 << TIMER_WHEEL_L0_BITS)
+#define TIMER_WHEEL_LN_SLOTS    (1 << TIMER_WHEEL_LN_BITS)
+#define TIMER_WHEEL_SLOTS       (TIMER_WHEEL_L0_SLOTS + (TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_LN_SLOTS)
+
+#define TIMER_WHEEL_MAX_TIMEOUT_MS  0x7fffffffu
+#define TIMER_WHEEL_MAX_TIMEOUT     (TIMER_WHEEL_MAX_TIMEOUT_MS / 1000)
 
 typedef struct timer_wheel_ {
-    struct cds_list_head slots[MAX_TIMER_SLOTS];
-	uint32_t count;
-    uint32_t current;
+    struct cds_list_head slots[TIMER_WHEEL_SLOTS];
+    uint32_t count;
+    uint32_t current;           // next millisecond to expire
+    bool started;
 } timer_wheel_t;
 
 void timer_wheel_init(timer_wheel_t *w);
-void timer_wheel_start(timer_wheel_t *w, uint32_t now);
-uint32_t timer_wheel_roll(timer_wheel_t *w, uint32_t now);
+void timer_wheel_start(timer_wheel_t *w, uint32_t now_ms);
+uint32_t timer_wheel_roll(timer_wheel_t *w, uint32_t now_ms, uint32_t budget);
+uint32_t timer_wheel_backlog(timer_wheel_t *w, uint32_t now_ms, uint32_t cap);
 
 static inline uint32_t timer_wheel_current(timer_wheel_t *w)
 {
@@ -27,7 +48,7 @@ static inline uint32_t timer_wheel_count(timer_wheel_t *w)
 
 static inline bool timer_wheel_started(timer_wheel_t *w)
 {
-    return w->current > 0;
+    return w->started;
 }
 
 struct timer_entry_;
@@ -44,8 +65,8 @@ typedef struct debug_entry_ {
 typedef struct timer_entry_ {
     struct cds_list_head link;
 	timer_wheel_expire_fct callback;
-    uint16_t expire_slot;
-    uint16_t timeout;
+    uint32_t expires;           // in ms
+    uint32_t timeout;           // in ms
 #ifdef DEBUG_TIMER_WHEEL
     debug_entry_t history[16];
     int debugs;
@@ -53,37 +74,53 @@ typedef struct timer_entry_ {
 } timer_entry_t;
 
 void timer_wheel_entry_init(timer_entry_t *n);
-void timer_wheel_entry_insert(timer_wheel_t *w, timer_entry_t *n, uint32_t now);
-void timer_wheel_entry_refresh(timer_wheel_t *w, timer_entry_t *n, uint32_t now);
+void timer_wheel_entry_insert_ms(timer_wheel_t *w, timer_entry_t *n, uint32_t now_ms);
 void timer_wheel_entry_remove(timer_wheel_t *w, timer_entry_t *n);
-void timer_wheel_entry_start(timer_wheel_t *w, timer_entry_t *n,
-                             timer_wheel_expire_fct cb, uint16_t timeout, uint32_t now);
+void timer_wheel_entry_refresh_ms(timer_wheel_t *w, timer_entry_t *n, uint32_t now_ms);
+void timer_wheel_entry_start_ms(timer_wheel_t *w, timer_entry_t *n,
+                                timer_wheel_expire_fct cb, uint32_t timeout_ms, uint32_t now_ms);
+
+static inline void timer_wheel_entry_insert(timer_wheel_t *w, timer_entry_t *n, uint32_t now)
+{
+    timer_wheel_entry_insert_ms(w, n, now * 1000);
+}
+
+static inline void timer_wheel_entry_refresh(timer_wheel_t *w, timer_entry_t *n, uint32_t now)
+{
+    timer_wheel_entry_refresh_ms(w, n, now * 1000);
+}
+
+static inline void timer_wheel_entry_start(timer_wheel_t *w, timer_entry_t *n,
+                                           timer_wheel_expire_fct cb, uint32_t timeout, uint32_t now)
+{
+    timer_wheel_entry_start_ms(w, n, cb, min(timeout, TIMER_WHEEL_MAX_TIMEOUT) * 1000, now * 1000);
+}
 
 static inline void timer_wheel_entry_set_callback(timer_entry_t *n, timer_wheel_expire_fct cb)
 {
     n->callback = cb;
 }
 
-static inline uint16_t timer_wheel_entry_get_timeout(timer_entry_t *n)
+static inline uint32_t timer_wheel_entry_get_timeout(timer_entry_t *n)
 {
-	return n->timeout;
+	return n->timeout / 1000;
 }
 
-static inline void timer_wheel_entry_set_timeout(timer_entry_t *n, uint16_t timeout)
+static inline void timer_wheel_entry_set_timeout_ms(timer_entry_t *n, uint32_t timeout_ms)
 {
-    if (unlikely(timeout >= MAX_TIMER_SLOTS)) {
-        return;
-    }
+    n->timeout = min(timeout_ms, TIMER_WHEEL_MAX_TIMEOUT_MS);
+}
 
-    n->timeout = timeout;
+static inline void timer_wheel_entry_set_timeout(timer_entry_t *n, uint32_t timeout)
+{
+    timer_wheel_entry_set_timeout_ms(n, min(timeout, TIMER_WHEEL_MAX_TIMEOUT) * 1000);
 }
 
-uint16_t timer_wheel_entry_get_idle(const timer_entry_t *n, uint32_t now);
-uint16_t timer_wheel_entry_get_life(const timer_entry_t *n, uint32_t now);
+uint32_t timer_wheel_entry_get_idle(const timer_entry_t *n, uint32_t now);
+uint32_t timer_wheel_entry_get_life(const timer_entry_t *n, uint32_t now);
 
 static inline bool timer_wheel_entry_is_active(const timer_entry_t *n)
 {
-    //return (n->expire_slot == (uint16_t)(-1)) ? false : true;
     return n->callback ? true : false;
 }
 
@@ -0,0 +1,791 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <net/if.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include "urcu.h"
+
+#include "main.h"
+#include "apis.h"
+#include "debug.h"
+#include "utils/helper.h"
+
+extern void *dp_huge_map(size_t size, size_t align, size_t *map_size);
+extern void dp_huge_unmap(void *ptr, size_t map_size);
+
+//
+// AF_XDP ring backend. A UMEM is shared by the two contexts of a port pair, so a
+// frame received on one side is reposted to the TX ring of the other side as is.
+//
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+#define XSK_FRAME_SIZE 4096
+#define XSK_FRAME_HEADROOM 256  // XDP_PACKET_HEADROOM, kernel reserves it in front of rx data
+#define XSK_MAX_PKT_LEN (XSK_FRAME_SIZE - XSK_FRAME_HEADROOM)
+#define XSK_MAX_RING_SIZE 2048
+#define XSK_MIN_RING_SIZE 64
+#define XSK_UMEM_SOCKETS 2      // port pair
+#define XSK_MAP_ENTRIES 64
+#define XSK_BUSY_POLL_USEC 20
+
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+#ifndef SO_BUSY_POLL_BUDGET
+#define SO_BUSY_POLL_BUDGET 70
+#endif
+
+typedef struct dp_xsk_ring_ {
+    uint32_t *producer;
+    uint32_t *consumer;
+    uint32_t *flags;
+    void *desc;
+    uint32_t mask;
+    uint32_t size;
+    uint32_t cached_prod;
+    uint32_t cached_cons;
+    void *map;
+    size_t map_size;
+} dp_xsk_ring_t;
+
+typedef struct dp_xsk_umem_ {
+    uint8_t *area;
+    uint64_t size;
+    size_t map_size;        // hugepage mapping may be rounded up, 0 if regular pages
+    uint32_t frames;
+    uint32_t free_cnt;
+    uint64_t *free_list;
+    int owner_fd;           // bound socket that registered the umem, -1 if gone
+    int refcnt;
+    // Frame being inspected by dpi_recv_packet(), the TX side reposts it directly.
+    uint64_t rx_addr;
+    bool rx_busy;
+    bool rx_fwd;
+} dp_xsk_umem_t;
+
+typedef struct dp_xsk_ {
+    dp_xsk_umem_t *umem;
+    dp_xsk_ring_t fill, comp, rx, tx;
+    int ifindex;
+    int prog_fd;
+    int map_fd;
+    uint32_t outstanding_tx;
+    uint64_t rx_pkts;
+    struct xdp_statistics last;
+} dp_xsk_t;
+
+// -- ring helpers
+
+static inline uint32_t xsk_prod_nb_free(dp_xsk_ring_t *r, uint32_t nb)
+{
+    uint32_t free = r->cached_cons - r->cached_prod;
+
+    if (free >= nb) {
+        return free;
+    }
+
+    // Producer rings keep consumer + size in cached_cons
+    r->cached_cons = CMM_LOAD_SHARED(*r->consumer) + r->size;
+    return r->cached_cons - r->cached_prod;
+}
+
+static inline uint32_t xsk_cons_nb_avail(dp_xsk_ring_t *r, uint32_t nb)
+{
+    uint32_t entries = r->cached_prod - r->cached_cons;
+
+    if (entries == 0) {
+        r->cached_prod = CMM_LOAD_SHARED(*r->producer);
+        entries = r->cached_prod - r->cached_cons;
+    }
+
+    return entries > nb ? nb : entries;
+}
+
+static inline void xsk_prod_submit(dp_xsk_ring_t *r)
+{
+    cmm_smp_wmb();
+    CMM_STORE_SHARED(*r->producer, r->cached_prod);
+}
+
+static inline void xsk_cons_release(dp_xsk_ring_t *r)
+{
+    cmm_smp_mb();
+    CMM_STORE_SHARED(*r->consumer, r->cached_cons);
+}
+
+static inline uint64_t *xsk_addr(dp_xsk_ring_t *r, uint32_t idx)
+{
+    return &((uint64_t *)r->desc)[idx & r->mask];
+}
+
+static inline struct xdp_desc *xsk_desc(dp_xsk_ring_t *r, uint32_t idx)
+{
+    return &((struct xdp_desc *)r->desc)[idx & r->mask];
+}
+
+static inline bool xsk_need_wakeup(dp_xsk_ring_t *r)
+{
+    return !!(CMM_LOAD_SHARED(*r->flags) & XDP_RING_NEED_WAKEUP);
+}
+
+static inline void xsk_umem_put(dp_xsk_umem_t *umem, uint64_t addr)
+{
+    if (likely(umem->free_cnt < umem->frames)) {
+        umem->free_list[umem->free_cnt ++] = addr & ~((uint64_t)XSK_FRAME_SIZE - 1);
+    }
+}
+
+static inline bool xsk_umem_get(dp_xsk_umem_t *umem, uint64_t *addr)
+{
+    if (unlikely(umem->free_cnt == 0)) {
+        return false;
+    }
+
+    *addr = umem->free_list[-- umem->free_cnt];
+    return true;
+}
+
+static int xsk_map_ring(int fd, dp_xsk_ring_t *r, struct xdp_ring_offset *off,
+                        uint32_t size, size_t desc_size, off_t pgoff)
+{
+    r->map_size = off->desc + size * desc_size;
+    r->map = mmap(NULL, r->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, pgoff);
+    if (r->map == MAP_FAILED) {
+        r->map = NULL;
+        return -1;
+    }
+
+    r->producer = (uint32_t *)((uint8_t *)r->map + off->producer);
+    r->consumer = (uint32_t *)((uint8_t *)r->map + off->consumer);
+    r->flags = (uint32_t *)((uint8_t *)r->map + off->flags);
+    r->desc = (uint8_t *)r->map + off->desc;
+    r->size = size;
+    r->mask = size - 1;
+    return 0;
+}
+
+static void xsk_unmap_ring(dp_xsk_ring_t *r)
+{
+    if (r->map != NULL) {
+        munmap(r->map, r->map_size);
+        r->map = NULL;
+    }
+}
+
+// -- XDP redirect program
+
+static int xsk_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static int xsk_create_map(void)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(int);
+    attr.value_size = sizeof(int);
+    attr.max_entries = XSK_MAP_ENTRIES;
+    return xsk_bpf(BPF_MAP_CREATE, &attr);
+}
+
+static int xsk_update_map(int map_fd, int key, int fd)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = map_fd;
+    attr.key = (uint64_t)(unsigned long)&key;
+    attr.value = (uint64_t)(unsigned long)&fd;
+    attr.flags = BPF_ANY;
+    return xsk_bpf(BPF_MAP_UPDATE_ELEM, &attr);
+}
+
+// return bpf_redirect_map(&xsks_map, ctx->rx_queue_index, XDP_PASS);
+static int xsk_load_prog(int map_fd)
+{
+    struct bpf_insn insns[] = {
+        { .code = BPF_LDX | BPF_W | BPF_MEM, .dst_reg = BPF_REG_2, .src_reg = BPF_REG_1,
+          .off = offsetof(struct xdp_md, rx_queue_index) },
+        { .code = BPF_LD | BPF_DW | BPF_IMM, .dst_reg = BPF_REG_1, .src_reg = BPF_PSEUDO_MAP_FD,
+          .imm = map_fd },
+        { .code = 0 },
+        { .code = BPF_ALU64 | BPF_MOV | BPF_K, .dst_reg = BPF_REG_3, .imm = XDP_PASS },
+        { .code = BPF_JMP | BPF_CALL, .imm = BPF_FUNC_redirect_map },
+        { .code = BPF_JMP | BPF_EXIT },
+    };
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uint64_t)(unsigned long)insns;
+    attr.insn_cnt = ARRAY_ENTRIES(insns);
+    attr.license = (uint64_t)(unsigned long)"GPL";
+    return xsk_bpf(BPF_PROG_LOAD, &attr);
+}
+
+// Attach (prog_fd >= 0) or detach (prog_fd = -1) the xdp program of an interface.
+static int xsk_set_link_xdp(int ifindex, int prog_fd, uint32_t flags)
+{
+    struct {
+        struct nlmsghdr nh;
+        struct ifinfomsg ifi;
+        char attrbuf[64];
+    } req;
+    struct nlattr *nla, *nla_fd, *nla_flags;
+    char buf[512];
+    int sock, len, ret = -1;
+
+    sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    if (sock < 0) {
+        return -1;
+    }
+
+    memset(&req, 0, sizeof(req));
+    req.nh.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    req.nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    req.nh.nlmsg_type = RTM_SETLINK;
+    req.ifi.ifi_family = AF_UNSPEC;
+    req.ifi.ifi_index = ifindex;
+
+    nla = (struct nlattr *)((char *)&req + NLMSG_ALIGN(req.nh.nlmsg_len));
+    nla->nla_type = NLA_F_NESTED | IFLA_XDP;
+    nla->nla_len = NLA_HDRLEN;
+
+    nla_fd = (struct nlattr *)((char *)nla + nla->nla_len);
+    nla_fd->nla_type = IFLA_XDP_FD;
+    nla_fd->nla_len = NLA_HDRLEN + sizeof(int);
+    memcpy((char *)nla_fd + NLA_HDRLEN, &prog_fd, sizeof(int));
+    nla->nla_len += NLA_ALIGN(nla_fd->nla_len);
+
+    nla_flags = (struct nlattr *)((char *)nla + nla->nla_len);
+    nla_flags->nla_type = IFLA_XDP_FLAGS;
+    nla_flags->nla_len = NLA_HDRLEN + sizeof(uint32_t);
+    memcpy((char *)nla_flags + NLA_HDRLEN, &flags, sizeof(uint32_t));
+    nla->nla_len += NLA_ALIGN(nla_flags->nla_len);
+
+    req.nh.nlmsg_len += NLA_ALIGN(nla->nla_len);
+
+    if (send(sock, &req, req.nh.nlmsg_len, 0) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    len = recv(sock, buf, sizeof(buf), 0);
+    if (len >= (int)NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
+        struct nlmsghdr *nh = (struct nlmsghdr *)buf;
+        if (nh->nlmsg_type == NLMSG_ERROR) {
+            struct nlmsgerr *err = (struct nlmsgerr *)NLMSG_DATA(nh);
+            ret = err->error;
+        }
+    }
+
+    close(sock);
+    return ret;
+}
+
+// -- umem
+
+static void xsk_umem_unmap(dp_xsk_umem_t *umem)
+{
+    if (umem->map_size > 0) {
+        dp_huge_unmap(umem->area, umem->map_size);
+    } else {
+        munmap(umem->area, umem->size);
+    }
+}
+
+static dp_xsk_umem_t *xsk_umem_alloc(uint32_t frames)
+{
+    dp_xsk_umem_t *umem;
+    uint32_t i;
+
+    umem = calloc(1, sizeof(*umem));
+    if (umem == NULL) {
+        return NULL;
+    }
+
+    umem->size = (uint64_t)frames * XSK_FRAME_SIZE;
+    if (g_hugepage) {
+        umem->area = dp_huge_map(umem->size, 0, &umem->map_size);
+    }
+    if (umem->area == NULL) {
+        umem->area = mmap(NULL, umem->size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (umem->area == MAP_FAILED) {
+            free(umem);
+            return NULL;
+        }
+    }
+
+    umem->free_list = malloc(sizeof(uint64_t) * frames);
+    if (umem->free_list == NULL) {
+        xsk_umem_unmap(umem);
+        free(umem);
+        return NULL;
+    }
+
+    umem->frames = frames;
+    for (i = 0; i < frames; i ++) {
+        umem->free_list[i] = (uint64_t)i * XSK_FRAME_SIZE;
+    }
+    umem->free_cnt = frames;
+    umem->owner_fd = -1;
+    umem->refcnt = 0;
+
+    return umem;
+}
+
+static void xsk_umem_unref(dp_xsk_umem_t *umem, int fd)
+{
+    if (umem->owner_fd == fd) {
+        umem->owner_fd = -1;
+    }
+
+    if (-- umem->refcnt > 0) {
+        return;
+    }
+
+    xsk_umem_unmap(umem);
+    free(umem->free_list);
+    free(umem);
+}
+
+static inline bool xsk_umem_owns(dp_xsk_umem_t *umem, uint8_t *ptr)
+{
+    return ptr >= umem->area && ptr < umem->area + umem->size;
+}
+
+// -- data path
+
+static void xsk_reap_tx(dp_xsk_t *xsk)
+{
+    uint32_t i, n;
+
+    if (xsk->outstanding_tx == 0) {
+        return;
+    }
+
+    n = xsk_cons_nb_avail(&xsk->comp, xsk->comp.size);
+    for (i = 0; i < n; i ++) {
+        xsk_umem_put(xsk->umem, *xsk_addr(&xsk->comp, xsk->comp.cached_cons + i));
+    }
+    if (n > 0) {
+        xsk->comp.cached_cons += n;
+        xsk_cons_release(&xsk->comp);
+        xsk->outstanding_tx -= n;
+    }
+}
+
+static void xsk_refill(dp_context_t *ctx, dp_xsk_t *xsk)
+{
+    dp_xsk_umem_t *umem = xsk->umem;
+    uint32_t n, i;
+    uint64_t addr;
+
+    n = xsk_prod_nb_free(&xsk->fill, xsk->fill.size);
+    n = min(n, umem->free_cnt);
+    for (i = 0; i < n; i ++) {
+        if (!xsk_umem_get(umem, &addr)) {
+            break;
+        }
+        *xsk_addr(&xsk->fill, xsk->fill.cached_prod + i) = addr;
+    }
+    if (i > 0) {
+        xsk->fill.cached_prod += i;
+        xsk_prod_submit(&xsk->fill);
+    }
+
+    if (xsk_need_wakeup(&xsk->fill)) {
+        recvfrom(ctx->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+    }
+}
+
+void dp_xsk_tx_kick(dp_context_t *ctx)
+{
+    dp_xsk_t *xsk = ctx->ring.xsk;
+
+    if (xsk_need_wakeup(&xsk->tx)) {
+        sendto(ctx->fd, NULL, 0, MSG_DONTWAIT, NULL, 0);
+    }
+    xsk_reap_tx(xsk);
+}
+
+static int dp_tx_xsk(dp_context_t *ctx, uint8_t *pkt, int len, bool large_frame)
+{
+    dp_xsk_t *xsk = ctx->ring.xsk;
+    dp_xsk_umem_t *umem = xsk->umem;
+    struct xdp_desc *desc;
+    uint64_t addr;
+
+    if (unlikely(len > XSK_MAX_PKT_LEN)) {
+        DEBUG_PACKET("Frame too large for xsk: len=%u to %s\n", len, ctx->name);
+        ctx->stats.tx_drops ++;
+        return -1;
+    }
+
+    if (xsk_prod_nb_free(&xsk->tx, 1) == 0) {
+        xsk_reap_tx(xsk);
+        DEBUG_PACKET("TX queue full, Drop!\n");
+        ctx->stats.tx_drops ++;
+        return -1;
+    }
+
+    if (umem->rx_busy && !umem->rx_fwd && xsk_umem_owns(umem, pkt) &&
+        ((uint64_t)(pkt - umem->area) & ~((uint64_t)XSK_FRAME_SIZE - 1)) ==
+        (umem->rx_addr & ~((uint64_t)XSK_FRAME_SIZE - 1))) {
+        // Repost the frame being inspected, ownership moves to the TX ring.
+        addr = pkt - umem->area;
+        umem->rx_fwd = true;
+    } else {
+        if (!xsk_umem_get(umem, &addr)) {
+            xsk_reap_tx(xsk);
+            if (!xsk_umem_get(umem, &addr)) {
+                DEBUG_PACKET("No free xsk frame, Drop!\n");
+                ctx->stats.tx_drops ++;
+                return -1;
+            }
+        }
+        memcpy(umem->area + addr, pkt, len);
+    }
+
+    desc = xsk_desc(&xsk->tx, xsk->tx.cached_prod ++);
+    desc->addr = addr;
+    desc->len = len;
+    desc->options = 0;
+    xsk_prod_submit(&xsk->tx);
+
+    xsk->outstanding_tx ++;
+    ctx->tx_pending ++;
+    if (ctx->tx_pending >= DEFAULT_PENDING_LIMIT) {
+        dp_xsk_tx_kick(ctx);
+        ctx->stats.tx += ctx->tx_pending;
+        ctx->tx_pending = 0;
+    }
+
+    return len;
+}
+
+static void xsk_flush_peer(dp_context_t *ctx)
+{
+    dp_context_t *peer = ctx->peer_ctx;
+
+    if (peer == NULL || peer->tx_pending == 0) {
+        return;
+    }
+
+    if (peer->ring.xsk != NULL) {
+        dp_xsk_tx_kick(peer);
+    } else {
+        send(peer->fd, NULL, 0, 0);
+    }
+    peer->stats.tx += peer->tx_pending;
+    peer->tx_pending = 0;
+}
+
+static int dp_rx_xsk(dp_context_t *ctx, uint32_t tick)
+{
+    io_ctx_t context;
+    dp_ring_t *ring = &ctx->ring;
+    dp_xsk_t *xsk = ring->xsk;
+    dp_xsk_umem_t *umem = xsk->umem;
+    uint32_t i, n;
+
+    context.dp_ctx = ctx;
+    context.ep_cache = &ctx->ep_cache;
+    context.tick = tick;
+    context.stats_slot = g_stats_slot;
+    context.tap = ctx->tap;
+    context.tc = ctx->tc;
+    context.quar = ctx->quar;
+    context.nfq = false;
+    context.proxymesh = ctx->proxymesh;
+    context.large_frame = false;
+    context.rx_ns = 0;
+    mac_cpy(context.ep_mac.ether_addr_octet, ctx->ep_mac.ether_addr_octet);
+
+    xsk_reap_tx(xsk);
+
+    n = xsk_cons_nb_avail(&xsk->rx, ring->batch);
+    for (i = 0; i < n; i ++) {
+        struct xdp_desc *desc = xsk_desc(&xsk->rx, xsk->rx.cached_cons + i);
+
+        umem->rx_addr = desc->addr;
+        umem->rx_busy = true;
+        umem->rx_fwd = false;
+
+        if (!dp_rx_quar_drop(ctx, umem->area + desc->addr, desc->len)) {
+            dpi_recv_packet(&context, umem->area + desc->addr, desc->len);
+        }
+
+        if (!umem->rx_fwd) {
+            xsk_umem_put(umem, desc->addr);
+        }
+        umem->rx_busy = false;
+    }
+    if (n > 0) {
+        xsk->rx.cached_cons += n;
+        xsk_cons_release(&xsk->rx);
+        xsk->rx_pkts += n;
+    }
+
+    xsk_refill(ctx, xsk);
+
+    if (likely(!ctx->tap)) {
+        xsk_flush_peer(ctx);
+    }
+
+    return n < ring->batch ? n : DP_RX_MORE;
+}
+
+static void dp_stats_xsk(dp_context_t *ctx)
+{
+    dp_xsk_t *xsk = ctx->ring.xsk;
+    struct xdp_statistics s;
+    socklen_t len;
+
+    ctx->stats.rx += xsk->rx_pkts;
+    xsk->rx_pkts = 0;
+
+    len = sizeof(s);
+    if (getsockopt(ctx->fd, SOL_XDP, XDP_STATISTICS, &s, &len) < 0) {
+        return;
+    }
+
+    // Kernel counters are cumulative
+    ctx->stats.rx_drops += (s.rx_dropped - xsk->last.rx_dropped) +
+                           (s.rx_ring_full - xsk->last.rx_ring_full) +
+                           (s.rx_invalid_descs - xsk->last.rx_invalid_descs);
+    ctx->stats.tx_drops += s.tx_invalid_descs - xsk->last.tx_invalid_descs;
+    xsk->last = s;
+}
+
+// -- setup
+
+static uint32_t xsk_ring_size(uint blocks)
+{
+    uint32_t size = XSK_MIN_RING_SIZE;
+
+    while (size < blocks && size < XSK_MAX_RING_SIZE) {
+        size <<= 1;
+    }
+    return size;
+}
+
+static int xsk_setup_rings(int fd, dp_xsk_t *xsk, uint32_t size, bool reg_umem)
+{
+    struct xdp_mmap_offsets off;
+    socklen_t optlen;
+
+    if (reg_umem) {
+        struct xdp_umem_reg mr;
+
+        memset(&mr, 0, sizeof(mr));
+        mr.addr = (uint64_t)(unsigned long)xsk->umem->area;
+        mr.len = xsk->umem->size;
+        mr.chunk_size = XSK_FRAME_SIZE;
+        mr.headroom = 0;
+        if (setsockopt(fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr)) < 0) {
+            DEBUG_ERROR(DBG_CTRL, "fail to register umem: %s\n", strerror(errno));
+            return -1;
+        }
+    }
+
+    // Each socket owns its fill/completion rings, also when the umem is shared.
+    if (setsockopt(fd, SOL_XDP, XDP_UMEM_FILL_RING, &size, sizeof(size)) < 0 ||
+        setsockopt(fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &size, sizeof(size)) < 0 ||
+        setsockopt(fd, SOL_XDP, XDP_RX_RING, &size, sizeof(size)) < 0 ||
+        setsockopt(fd, SOL_XDP, XDP_TX_RING, &size, sizeof(size)) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to set xsk rings: %s\n", strerror(errno));
+        return -1;
+    }
+
+    optlen = sizeof(off);
+    if (getsockopt(fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to get xsk mmap offsets: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (xsk_map_ring(fd, &xsk->fill, &off.fr, size, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING) < 0 ||
+        xsk_map_ring(fd, &xsk->comp, &off.cr, size, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING) < 0 ||
+        xsk_map_ring(fd, &xsk->rx, &off.rx, size, sizeof(struct xdp_desc), XDP_PGOFF_RX_RING) < 0 ||
+        xsk_map_ring(fd, &xsk->tx, &off.tx, size, sizeof(struct xdp_desc), XDP_PGOFF_TX_RING) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to mmap xsk rings: %s\n", strerror(errno));
+        return -1;
+    }
+
+    // Producer rings start with all entries free
+    xsk->fill.cached_cons = size;
+    xsk->tx.cached_cons = size;
+    return 0;
+}
+
+static void xsk_release(dp_xsk_t *xsk, int fd)
+{
+    xsk_unmap_ring(&xsk->fill);
+    xsk_unmap_ring(&xsk->comp);
+    xsk_unmap_ring(&xsk->rx);
+    xsk_unmap_ring(&xsk->tx);
+
+    if (xsk->prog_fd >= 0) {
+        xsk_set_link_xdp(xsk->ifindex, -1, 0);
+        close(xsk->prog_fd);
+    }
+    if (xsk->map_fd >= 0) {
+        close(xsk->map_fd);
+    }
+    if (xsk->umem != NULL) {
+        xsk_umem_unref(xsk->umem, fd);
+    }
+    free(xsk);
+}
+
+void dp_close_xsk(dp_context_t *ctx)
+{
+    dp_xsk_t *xsk = ctx->ring.xsk;
+
+    if (xsk != NULL) {
+        xsk_release(xsk, ctx->fd);
+        ctx->ring.xsk = NULL;
+    }
+    close(ctx->fd);
+}
+
+// Open an AF_XDP socket on queue 0 of the interface. If share_ctx is an AF_XDP context,
+// its umem is shared so frames can be forwarded between the two without copy.
+int dp_open_xsk(dp_context_t *ctx, const char *iface, dp_context_t *share_ctx, uint blocks, uint batch)
+{
+    dp_ring_t *ring = &ctx->ring;
+    dp_xsk_umem_t *umem = NULL;
+    struct sockaddr_xdp sxdp;
+    dp_xsk_t *xsk;
+    uint32_t size;
+    bool reg_umem;
+    int fd;
+
+    int ifindex = if_nametoindex(iface);
+    if (ifindex == 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to find iface=%s\n", iface);
+        return -1;
+    }
+
+    fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (fd < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to open xsk socket: %s\n", strerror(errno));
+        return -1;
+    }
+
+    xsk = calloc(1, sizeof(*xsk));
+    if (xsk == NULL) {
+        close(fd);
+        return -1;
+    }
+    xsk->ifindex = ifindex;
+    xsk->prog_fd = -1;
+    xsk->map_fd = -1;
+
+    size = xsk_ring_size(blocks);
+
+    if (share_ctx != NULL && share_ctx->ring.xsk != NULL &&
+        share_ctx->ring.xsk->umem->owner_fd >= 0) {
+        umem = share_ctx->ring.xsk->umem;
+        reg_umem = false;
+    } else {
+        umem = xsk_umem_alloc(size * 2 * XSK_UMEM_SOCKETS);
+        if (umem == NULL) {
+            DEBUG_ERROR(DBG_CTRL, "fail to allocate umem, iface=%s\n", iface);
+            xsk_release(xsk, fd);
+            close(fd);
+            return -1;
+        }
+        reg_umem = true;
+    }
+    xsk->umem = umem;
+    umem->refcnt ++;
+
+    if (xsk_setup_rings(fd, xsk, size, reg_umem) < 0) {
+        xsk_release(xsk, fd);
+        close(fd);
+        return -1;
+    }
+
+    memset(&sxdp, 0, sizeof(sxdp));
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = ifindex;
+    sxdp.sxdp_queue_id = 0;
+    if (reg_umem) {
+        sxdp.sxdp_flags = XDP_USE_NEED_WAKEUP;
+    } else {
+        sxdp.sxdp_flags = XDP_SHARED_UMEM;
+        sxdp.sxdp_shared_umem_fd = umem->owner_fd;
+    }
+    if (bind(fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to bind xsk socket, iface=%s: %s\n", iface, strerror(errno));
+        xsk_release(xsk, fd);
+        close(fd);
+        return -1;
+    }
+    if (reg_umem) {
+        umem->owner_fd = fd;
+    }
+
+    // Steer the queue to the socket
+    xsk->map_fd = xsk_create_map();
+    if (xsk->map_fd >= 0) {
+        xsk->prog_fd = xsk_load_prog(xsk->map_fd);
+    }
+    if (xsk->prog_fd < 0 || xsk_update_map(xsk->map_fd, 0, fd) < 0 ||
+        xsk_set_link_xdp(ifindex, xsk->prog_fd, XDP_FLAGS_UPDATE_IF_NOEXIST) < 0) {
+        DEBUG_ERROR(DBG_CTRL, "fail to attach xdp program, iface=%s: %s\n", iface, strerror(errno));
+        if (xsk->prog_fd >= 0) {
+            close(xsk->prog_fd);
+            xsk->prog_fd = -1;
+        }
+        xsk_release(xsk, fd);
+        close(fd);
+        return -1;
+    }
+
+    if (g_sched_policy == DP_SCHED_POLL) {
+        // Best effort, let the dp thread drive the NAPI of the queue
+        int val = 1;
+        setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &val, sizeof(val));
+        val = XSK_BUSY_POLL_USEC;
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val));
+        val = batch;
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &val, sizeof(val));
+    }
+
+    ring->xsk = xsk;
+    ring->size = size;
+    ring->map_size = 0;
+    ring->batch = min(batch, size);
+    ring->rx = dp_rx_xsk;
+    ring->tx = dp_tx_xsk;
+    ring->stats = dp_stats_xsk;
+
+    xsk_refill(ctx, xsk);
+
+    DEBUG_CTRL("xsk opened iface=%s fd=%d ring=%u shared=%d\n", iface, fd, size, !reg_umem);
+    return fd;
+}
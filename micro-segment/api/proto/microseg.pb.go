@@ -1169,6 +1169,7 @@ type ConnectionReport struct {
 	AgentId       string                 `protobuf:"bytes,1,opt,name=agent_id,json=agentId,proto3" json:"agent_id,omitempty"`
 	HostId        string                 `protobuf:"bytes,2,opt,name=host_id,json=hostId,proto3" json:"host_id,omitempty"`
 	Connections   []*Connection          `protobuf:"bytes,3,rep,name=connections,proto3" json:"connections,omitempty"`
+	Seq           uint64                 `protobuf:"varint,4,opt,name=seq,proto3" json:"seq,omitempty"` // 流式上报的批次序号
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
@@ -1224,6 +1225,13 @@ func (x *ConnectionReport) GetConnections() []*Connection {
 	return nil
 }
 
+func (x *ConnectionReport) GetSeq() uint64 {
+	if x != nil {
+		return x.Seq
+	}
+	return 0
+}
+
 type ThreatLog struct {
 	state         protoimpl.MessageState `protogen:"open.v1"`
 	Id            string                 `protobuf:"bytes,1,opt,name=id,proto3" json:"id,omitempty"`
@@ -1369,6 +1377,7 @@ type ThreatReport struct {
 	AgentId       string                 `protobuf:"bytes,1,opt,name=agent_id,json=agentId,proto3" json:"agent_id,omitempty"`
 	HostId        string                 `protobuf:"bytes,2,opt,name=host_id,json=hostId,proto3" json:"host_id,omitempty"`
 	Threats       []*ThreatLog           `protobuf:"bytes,3,rep,name=threats,proto3" json:"threats,omitempty"`
+	Seq           uint64                 `protobuf:"varint,4,opt,name=seq,proto3" json:"seq,omitempty"` // 流式上报的批次序号
 	unknownFields protoimpl.UnknownFields
 	sizeCache     protoimpl.SizeCache
 }
@@ -1424,6 +1433,13 @@ func (x *ThreatReport) GetThreats() []*ThreatLog {
 	return nil
 }
 
+func (x *ThreatReport) GetSeq() uint64 {
+	if x != nil {
+		return x.Seq
+	}
+	return 0
+}
+
 type PolicyRule struct {
 	state         protoimpl.MessageState `protogen:"open.v1"`
 	Id            uint32                 `protobuf:"varint,1,opt,name=id,proto3" json:"id,omitempty"`
@@ -1992,6 +2008,202 @@ func (x *SubnetConfig) GetSubnets() []*Subnet {
 	return nil
 }
 
+type ReportAck struct {
+	state          protoimpl.MessageState `protogen:"open.v1"`
+	Seq            uint64                 `protobuf:"varint,1,opt,name=seq,proto3" json:"seq,omitempty"` // 已处理的批次序号，之前的批次一并确认
+	Code           int32                  `protobuf:"varint,2,opt,name=code,proto3" json:"code,omitempty"`
+	Message        string                 `protobuf:"bytes,3,opt,name=message,proto3" json:"message,omitempty"`
+	Window         uint32                 `protobuf:"varint,4,opt,name=window,proto3" json:"window,omitempty"`                                       // 允许未确认的批次数
+	ReportInterval uint32                 `protobuf:"varint,5,opt,name=report_interval,json=reportInterval,proto3" json:"report_interval,omitempty"` // 建议的上报间隔（秒）
+	unknownFields  protoimpl.UnknownFields
+	sizeCache      protoimpl.SizeCache
+}
+
+func (x *ReportAck) Reset() {
+	*x = ReportAck{}
+	mi := &file_microseg_proto_msgTypes[26]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *ReportAck) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*ReportAck) ProtoMessage() {}
+
+func (x *ReportAck) ProtoReflect() protoreflect.Message {
+	mi := &file_microseg_proto_msgTypes[26]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use ReportAck.ProtoReflect.Descriptor instead.
+func (*ReportAck) Descriptor() ([]byte, []int) {
+	return file_microseg_proto_rawDescGZIP(), []int{26}
+}
+
+func (x *ReportAck) GetSeq() uint64 {
+	if x != nil {
+		return x.Seq
+	}
+	return 0
+}
+
+func (x *ReportAck) GetCode() int32 {
+	if x != nil {
+		return x.Code
+	}
+	return 0
+}
+
+func (x *ReportAck) GetMessage() string {
+	if x != nil {
+		return x.Message
+	}
+	return ""
+}
+
+func (x *ReportAck) GetWindow() uint32 {
+	if x != nil {
+		return x.Window
+	}
+	return 0
+}
+
+func (x *ReportAck) GetReportInterval() uint32 {
+	if x != nil {
+		return x.ReportInterval
+	}
+	return 0
+}
+
+type PolicyWatchRequest struct {
+	state         protoimpl.MessageState `protogen:"open.v1"`
+	AgentId       string                 `protobuf:"bytes,1,opt,name=agent_id,json=agentId,proto3" json:"agent_id,omitempty"`
+	HostId        string                 `protobuf:"bytes,2,opt,name=host_id,json=hostId,proto3" json:"host_id,omitempty"`
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *PolicyWatchRequest) Reset() {
+	*x = PolicyWatchRequest{}
+	mi := &file_microseg_proto_msgTypes[27]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *PolicyWatchRequest) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*PolicyWatchRequest) ProtoMessage() {}
+
+func (x *PolicyWatchRequest) ProtoReflect() protoreflect.Message {
+	mi := &file_microseg_proto_msgTypes[27]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use PolicyWatchRequest.ProtoReflect.Descriptor instead.
+func (*PolicyWatchRequest) Descriptor() ([]byte, []int) {
+	return file_microseg_proto_rawDescGZIP(), []int{27}
+}
+
+func (x *PolicyWatchRequest) GetAgentId() string {
+	if x != nil {
+		return x.AgentId
+	}
+	return ""
+}
+
+func (x *PolicyWatchRequest) GetHostId() string {
+	if x != nil {
+		return x.HostId
+	}
+	return ""
+}
+
+type PolicyUpdate struct {
+	state         protoimpl.MessageState `protogen:"open.v1"`
+	Version       uint64                 `protobuf:"varint,1,opt,name=version,proto3" json:"version,omitempty"`                                // 策略版本
+	Full          bool                   `protobuf:"varint,2,opt,name=full,proto3" json:"full,omitempty"`                                      // 全量更新，替换 Agent 已有的规则
+	Rules         []*PolicyRule          `protobuf:"bytes,3,rep,name=rules,proto3" json:"rules,omitempty"`                                     // 新增或变更的规则
+	DeletedIds    []uint32               `protobuf:"varint,4,rep,packed,name=deleted_ids,json=deletedIds,proto3" json:"deleted_ids,omitempty"` // 删除的规则ID
+	unknownFields protoimpl.UnknownFields
+	sizeCache     protoimpl.SizeCache
+}
+
+func (x *PolicyUpdate) Reset() {
+	*x = PolicyUpdate{}
+	mi := &file_microseg_proto_msgTypes[28]
+	ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+	ms.StoreMessageInfo(mi)
+}
+
+func (x *PolicyUpdate) String() string {
+	return protoimpl.X.MessageStringOf(x)
+}
+
+func (*PolicyUpdate) ProtoMessage() {}
+
+func (x *PolicyUpdate) ProtoReflect() protoreflect.Message {
+	mi := &file_microseg_proto_msgTypes[28]
+	if x != nil {
+		ms := protoimpl.X.MessageStateOf(protoimpl.Pointer(x))
+		if ms.LoadMessageInfo() == nil {
+			ms.StoreMessageInfo(mi)
+		}
+		return ms
+	}
+	return mi.MessageOf(x)
+}
+
+// Deprecated: Use PolicyUpdate.ProtoReflect.Descriptor instead.
+func (*PolicyUpdate) Descriptor() ([]byte, []int) {
+	return file_microseg_proto_rawDescGZIP(), []int{28}
+}
+
+func (x *PolicyUpdate) GetVersion() uint64 {
+	if x != nil {
+		return x.Version
+	}
+	return 0
+}
+
+func (x *PolicyUpdate) GetFull() bool {
+	if x != nil {
+		return x.Full
+	}
+	return false
+}
+
+func (x *PolicyUpdate) GetRules() []*PolicyRule {
+	if x != nil {
+		return x.Rules
+	}
+	return nil
+}
+
+func (x *PolicyUpdate) GetDeletedIds() []uint32 {
+	if x != nil {
+		return x.DeletedIds
+	}
+	return nil
+}
+
 var File_microseg_proto protoreflect.FileDescriptor
 
 const file_microseg_proto_rawDesc = "" +
@@ -2101,11 +2313,12 @@ const file_microseg_proto_rawDesc = "" +
 	"local_peer\x18\x13 \x01(\bR\tlocalPeer\x12\x14\n" +
 	"\x05scope\x18\x14 \x01(\tR\x05scope\x12\x18\n" +
 	"\anetwork\x18\x15 \x01(\tR\anetwork\x12\x1a\n" +
-	"\bviolates\x18\x16 \x01(\rR\bviolates\"~\n" +
+	"\bviolates\x18\x16 \x01(\rR\bviolates\"\x90\x01\n" +
 	"\x10ConnectionReport\x12\x19\n" +
 	"\bagent_id\x18\x01 \x01(\tR\aagentId\x12\x17\n" +
 	"\ahost_id\x18\x02 \x01(\tR\x06hostId\x126\n" +
-	"\vconnections\x18\x03 \x03(\v2\x14.microseg.ConnectionR\vconnections\"\x86\x03\n" +
+	"\vconnections\x18\x03 \x03(\v2\x14.microseg.ConnectionR\vconnections\x12\x10\n" +
+	"\x03seq\x18\x04 \x01(\x04R\x03seq\"\x86\x03\n" +
 	"\tThreatLog\x12\x0e\n" +
 	"\x02id\x18\x01 \x01(\tR\x02id\x12\x1b\n" +
 	"\tthreat_id\x18\x02 \x01(\rR\bthreatId\x12\x1f\n" +
@@ -2125,11 +2338,12 @@ const file_microseg_proto_rawDesc = "" +
 	"\n" +
 	"local_peer\x18\f \x01(\bR\tlocalPeer\x12\x1f\n" +
 	"\vreported_at\x18\r \x01(\x04R\n" +
-	"reportedAt\"q\n" +
+	"reportedAt\"\x83\x01\n" +
 	"\fThreatReport\x12\x19\n" +
 	"\bagent_id\x18\x01 \x01(\tR\aagentId\x12\x17\n" +
 	"\ahost_id\x18\x02 \x01(\tR\x06hostId\x12-\n" +
-	"\athreats\x18\x03 \x03(\v2\x13.microseg.ThreatLogR\athreats\"\xfc\x01\n" +
+	"\athreats\x18\x03 \x03(\v2\x13.microseg.ThreatLogR\athreats\x12\x10\n" +
+	"\x03seq\x18\x04 \x01(\x04R\x03seq\"\xfc\x01\n" +
 	"\n" +
 	"PolicyRule\x12\x0e\n" +
 	"\x02id\x18\x01 \x01(\rR\x02id\x12\x12\n" +
@@ -2179,20 +2393,38 @@ const file_microseg_proto_rawDesc = "" +
 	"\x04mask\x18\x02 \x01(\fR\x04mask\x12\x14\n" +
 	"\x05scope\x18\x03 \x01(\tR\x05scope\":\n" +
 	"\fSubnetConfig\x12*\n" +
-	"\asubnets\x18\x01 \x03(\v2\x10.microseg.SubnetR\asubnets2\xc9\x02\n" +
+	"\asubnets\x18\x01 \x03(\v2\x10.microseg.SubnetR\asubnets\"\x8c\x01\n" +
+	"\tReportAck\x12\x10\n" +
+	"\x03seq\x18\x01 \x01(\x04R\x03seq\x12\x12\n" +
+	"\x04code\x18\x02 \x01(\x05R\x04code\x12\x18\n" +
+	"\amessage\x18\x03 \x01(\tR\amessage\x12\x16\n" +
+	"\x06window\x18\x04 \x01(\rR\x06window\x12'\n" +
+	"\x0freport_interval\x18\x05 \x01(\rR\x0ereportInterval\"H\n" +
+	"\x12PolicyWatchRequest\x12\x19\n" +
+	"\bagent_id\x18\x01 \x01(\tR\aagentId\x12\x17\n" +
+	"\ahost_id\x18\x02 \x01(\tR\x06hostId\"\x89\x01\n" +
+	"\fPolicyUpdate\x12\x18\n" +
+	"\aversion\x18\x01 \x01(\x04R\aversion\x12\x12\n" +
+	"\x04full\x18\x02 \x01(\bR\x04full\x12*\n" +
+	"\x05rules\x18\x03 \x03(\v2\x14.microseg.PolicyRuleR\x05rules\x12\x1f\n" +
+	"\vdeleted_ids\x18\x04 \x03(\rR\n" +
+	"deletedIds2\xc9\x02\n" +
 	"\fAgentService\x12@\n" +
 	"\fConfigPolicy\x12\x16.microseg.PolicyConfig\x1a\x18.microseg.ConfigResponse\x12F\n" +
 	"\x0fConfigGroupMode\x12\x19.microseg.GroupModeConfig\x1a\x18.microseg.ConfigResponse\x12A\n" +
 	"\rConfigSubnets\x12\x16.microseg.SubnetConfig\x1a\x18.microseg.ConfigResponse\x123\n" +
 	"\tGetStatus\x12\x0f.microseg.Empty\x1a\x15.microseg.AgentStatus\x127\n" +
-	"\fGetWorkloads\x12\x0f.microseg.Empty\x1a\x16.microseg.WorkloadList2\xa7\x03\n" +
+	"\fGetWorkloads\x12\x0f.microseg.Empty\x1a\x16.microseg.WorkloadList2\xfc\x04\n" +
 	"\x11ControllerService\x12;\n" +
 	"\bRegister\x12\x13.microseg.AgentInfo\x1a\x1a.microseg.RegisterResponse\x12D\n" +
 	"\tHeartbeat\x12\x1a.microseg.HeartbeatRequest\x1a\x1b.microseg.HeartbeatResponse\x12I\n" +
 	"\x11ReportConnections\x12\x1a.microseg.ConnectionReport\x1a\x18.microseg.ReportResponse\x12A\n" +
-	"\rReportThreats\x12\x16.microseg.ThreatReport\x1a\x18.microseg.ReportResponse\x12C\n" +
+	"\rReportThreats\x12\x16.microseg.ThreatReport\x1a\x18.microseg.ReportResponse\x12H\n" +
+	"\x11StreamConnections\x12\x1a.microseg.ConnectionReport\x1a\x13.microseg.ReportAck(\x010\x01\x12@\n" +
+	"\rStreamThreats\x12\x16.microseg.ThreatReport\x1a\x13.microseg.ReportAck(\x010\x01\x12C\n" +
 	"\x0eReportWorkload\x12\x17.microseg.WorkloadEvent\x1a\x18.microseg.ReportResponse\x12<\n" +
-	"\vGetPolicies\x12\x17.microseg.PolicyRequest\x1a\x14.microseg.PolicyListB$Z\"github.com/micro-segment/api/protob\x06proto3"
+	"\vGetPolicies\x12\x17.microseg.PolicyRequest\x1a\x14.microseg.PolicyList\x12G\n" +
+	"\rWatchPolicies\x12\x1c.microseg.PolicyWatchRequest\x1a\x16.microseg.PolicyUpdate0\x01B$Z\"github.com/micro-segment/api/protob\x06proto3"
 
 var (
 	file_microseg_proto_rawDescOnce sync.Once
@@ -2206,41 +2438,44 @@ func file_microseg_proto_rawDescGZIP() []byte {
 	return file_microseg_proto_rawDescData
 }
 
-var file_microseg_proto_msgTypes = make([]protoimpl.MessageInfo, 27)
+var file_microseg_proto_msgTypes = make([]protoimpl.MessageInfo, 30)
 var file_microseg_proto_goTypes = []any{
-	(*Empty)(nil),             // 0: microseg.Empty
-	(*ConfigResponse)(nil),    // 1: microseg.ConfigResponse
-	(*ReportResponse)(nil),    // 2: microseg.ReportResponse
-	(*AgentInfo)(nil),         // 3: microseg.AgentInfo
-	(*RegisterResponse)(nil),  // 4: microseg.RegisterResponse
-	(*HeartbeatRequest)(nil),  // 5: microseg.HeartbeatRequest
-	(*HeartbeatResponse)(nil), // 6: microseg.HeartbeatResponse
-	(*AgentStats)(nil),        // 7: microseg.AgentStats
-	(*AgentStatus)(nil),       // 8: microseg.AgentStatus
-	(*Workload)(nil),          // 9: microseg.Workload
-	(*NetworkInterface)(nil),  // 10: microseg.NetworkInterface
-	(*IPAddress)(nil),         // 11: microseg.IPAddress
-	(*WorkloadList)(nil),      // 12: microseg.WorkloadList
-	(*WorkloadEvent)(nil),     // 13: microseg.WorkloadEvent
-	(*Connection)(nil),        // 14: microseg.Connection
-	(*ConnectionReport)(nil),  // 15: microseg.ConnectionReport
-	(*ThreatLog)(nil),         // 16: microseg.ThreatLog
-	(*ThreatReport)(nil),      // 17: microseg.ThreatReport
-	(*PolicyRule)(nil),        // 18: microseg.PolicyRule
-	(*IPRule)(nil),            // 19: microseg.IPRule
-	(*PolicyConfig)(nil),      // 20: microseg.PolicyConfig
-	(*PolicyList)(nil),        // 21: microseg.PolicyList
-	(*PolicyRequest)(nil),     // 22: microseg.PolicyRequest
-	(*GroupModeConfig)(nil),   // 23: microseg.GroupModeConfig
-	(*Subnet)(nil),            // 24: microseg.Subnet
-	(*SubnetConfig)(nil),      // 25: microseg.SubnetConfig
-	nil,                       // 26: microseg.Workload.LabelsEntry
+	(*Empty)(nil),              // 0: microseg.Empty
+	(*ConfigResponse)(nil),     // 1: microseg.ConfigResponse
+	(*ReportResponse)(nil),     // 2: microseg.ReportResponse
+	(*AgentInfo)(nil),          // 3: microseg.AgentInfo
+	(*RegisterResponse)(nil),   // 4: microseg.RegisterResponse
+	(*HeartbeatRequest)(nil),   // 5: microseg.HeartbeatRequest
+	(*HeartbeatResponse)(nil),  // 6: microseg.HeartbeatResponse
+	(*AgentStats)(nil),         // 7: microseg.AgentStats
+	(*AgentStatus)(nil),        // 8: microseg.AgentStatus
+	(*Workload)(nil),           // 9: microseg.Workload
+	(*NetworkInterface)(nil),   // 10: microseg.NetworkInterface
+	(*IPAddress)(nil),          // 11: microseg.IPAddress
+	(*WorkloadList)(nil),       // 12: microseg.WorkloadList
+	(*WorkloadEvent)(nil),      // 13: microseg.WorkloadEvent
+	(*Connection)(nil),         // 14: microseg.Connection
+	(*ConnectionReport)(nil),   // 15: microseg.ConnectionReport
+	(*ThreatLog)(nil),          // 16: microseg.ThreatLog
+	(*ThreatReport)(nil),       // 17: microseg.ThreatReport
+	(*PolicyRule)(nil),         // 18: microseg.PolicyRule
+	(*IPRule)(nil),             // 19: microseg.IPRule
+	(*PolicyConfig)(nil),       // 20: microseg.PolicyConfig
+	(*PolicyList)(nil),         // 21: microseg.PolicyList
+	(*PolicyRequest)(nil),      // 22: microseg.PolicyRequest
+	(*GroupModeConfig)(nil),    // 23: microseg.GroupModeConfig
+	(*Subnet)(nil),             // 24: microseg.Subnet
+	(*SubnetConfig)(nil),       // 25: microseg.SubnetConfig
+	(*ReportAck)(nil),          // 26: microseg.ReportAck
+	(*PolicyWatchRequest)(nil), // 27: microseg.PolicyWatchRequest
+	(*PolicyUpdate)(nil),       // 28: microseg.PolicyUpdate
+	nil,                        // 29: microseg.Workload.LabelsEntry
 }
 var file_microseg_proto_depIdxs = []int32{
 	7,  // 0: microseg.HeartbeatRequest.stats:type_name -> microseg.AgentStats
 	7,  // 1: microseg.AgentStatus.stats:type_name -> microseg.AgentStats
 	10, // 2: microseg.Workload.ifaces:type_name -> microseg.NetworkInterface
-	26, // 3: microseg.Workload.labels:type_name -> microseg.Workload.LabelsEntry
+	29, // 3: microseg.Workload.labels:type_name -> microseg.Workload.LabelsEntry
 	11, // 4: microseg.NetworkInterface.addrs:type_name -> microseg.IPAddress
 	9,  // 5: microseg.WorkloadList.workloads:type_name -> microseg.Workload
 	9,  // 6: microseg.WorkloadEvent.workload:type_name -> microseg.Workload
@@ -2249,33 +2484,40 @@ var file_microseg_proto_depIdxs = []int32{
 	19, // 9: microseg.PolicyConfig.rules:type_name -> microseg.IPRule
 	18, // 10: microseg.PolicyList.rules:type_name -> microseg.PolicyRule
 	24, // 11: microseg.SubnetConfig.subnets:type_name -> microseg.Subnet
-	20, // 12: microseg.AgentService.ConfigPolicy:input_type -> microseg.PolicyConfig
-	23, // 13: microseg.AgentService.ConfigGroupMode:input_type -> microseg.GroupModeConfig
-	25, // 14: microseg.AgentService.ConfigSubnets:input_type -> microseg.SubnetConfig
-	0,  // 15: microseg.AgentService.GetStatus:input_type -> microseg.Empty
-	0,  // 16: microseg.AgentService.GetWorkloads:input_type -> microseg.Empty
-	3,  // 17: microseg.ControllerService.Register:input_type -> microseg.AgentInfo
-	5,  // 18: microseg.ControllerService.Heartbeat:input_type -> microseg.HeartbeatRequest
-	15, // 19: microseg.ControllerService.ReportConnections:input_type -> microseg.ConnectionReport
-	17, // 20: microseg.ControllerService.ReportThreats:input_type -> microseg.ThreatReport
-	13, // 21: microseg.ControllerService.ReportWorkload:input_type -> microseg.WorkloadEvent
-	22, // 22: microseg.ControllerService.GetPolicies:input_type -> microseg.PolicyRequest
-	1,  // 23: microseg.AgentService.ConfigPolicy:output_type -> microseg.ConfigResponse
-	1,  // 24: microseg.AgentService.ConfigGroupMode:output_type -> microseg.ConfigResponse
-	1,  // 25: microseg.AgentService.ConfigSubnets:output_type -> microseg.ConfigResponse
-	8,  // 26: microseg.AgentService.GetStatus:output_type -> microseg.AgentStatus
-	12, // 27: microseg.AgentService.GetWorkloads:output_type -> microseg.WorkloadList
-	4,  // 28: microseg.ControllerService.Register:output_type -> microseg.RegisterResponse
-	6,  // 29: microseg.ControllerService.Heartbeat:output_type -> microseg.HeartbeatResponse
-	2,  // 30: microseg.ControllerService.ReportConnections:output_type -> microseg.ReportResponse
-	2,  // 31: microseg.ControllerService.ReportThreats:output_type -> microseg.ReportResponse
-	2,  // 32: microseg.ControllerService.ReportWorkload:output_type -> microseg.ReportResponse
-	21, // 33: microseg.ControllerService.GetPolicies:output_type -> microseg.PolicyList
-	23, // [23:34] is the sub-list for method output_type
-	12, // [12:23] is the sub-list for method input_type
-	12, // [12:12] is the sub-list for extension type_name
-	12, // [12:12] is the sub-list for extension extendee
-	0,  // [0:12] is the sub-list for field type_name
+	18, // 12: microseg.PolicyUpdate.rules:type_name -> microseg.PolicyRule
+	20, // 13: microseg.AgentService.ConfigPolicy:input_type -> microseg.PolicyConfig
+	23, // 14: microseg.AgentService.ConfigGroupMode:input_type -> microseg.GroupModeConfig
+	25, // 15: microseg.AgentService.ConfigSubnets:input_type -> microseg.SubnetConfig
+	0,  // 16: microseg.AgentService.GetStatus:input_type -> microseg.Empty
+	0,  // 17: microseg.AgentService.GetWorkloads:input_type -> microseg.Empty
+	3,  // 18: microseg.ControllerService.Register:input_type -> microseg.AgentInfo
+	5,  // 19: microseg.ControllerService.Heartbeat:input_type -> microseg.HeartbeatRequest
+	15, // 20: microseg.ControllerService.ReportConnections:input_type -> microseg.ConnectionReport
+	17, // 21: microseg.ControllerService.ReportThreats:input_type -> microseg.ThreatReport
+	15, // 22: microseg.ControllerService.StreamConnections:input_type -> microseg.ConnectionReport
+	17, // 23: microseg.ControllerService.StreamThreats:input_type -> microseg.ThreatReport
+	13, // 24: microseg.ControllerService.ReportWorkload:input_type -> microseg.WorkloadEvent
+	22, // 25: microseg.ControllerService.GetPolicies:input_type -> microseg.PolicyRequest
+	27, // 26: microseg.ControllerService.WatchPolicies:input_type -> microseg.PolicyWatchRequest
+	1,  // 27: microseg.AgentService.ConfigPolicy:output_type -> microseg.ConfigResponse
+	1,  // 28: microseg.AgentService.ConfigGroupMode:output_type -> microseg.ConfigResponse
+	1,  // 29: microseg.AgentService.ConfigSubnets:output_type -> microseg.ConfigResponse
+	8,  // 30: microseg.AgentService.GetStatus:output_type -> microseg.AgentStatus
+	12, // 31: microseg.AgentService.GetWorkloads:output_type -> microseg.WorkloadList
+	4,  // 32: microseg.ControllerService.Register:output_type -> microseg.RegisterResponse
+	6,  // 33: microseg.ControllerService.Heartbeat:output_type -> microseg.HeartbeatResponse
+	2,  // 34: microseg.ControllerService.ReportConnections:output_type -> microseg.ReportResponse
+	2,  // 35: microseg.ControllerService.ReportThreats:output_type -> microseg.ReportResponse
+	26, // 36: microseg.ControllerService.StreamConnections:output_type -> microseg.ReportAck
+	26, // 37: microseg.ControllerService.StreamThreats:output_type -> microseg.ReportAck
+	2,  // 38: microseg.ControllerService.ReportWorkload:output_type -> microseg.ReportResponse
+	21, // 39: microseg.ControllerService.GetPolicies:output_type -> microseg.PolicyList
+	28, // 40: microseg.ControllerService.WatchPolicies:output_type -> microseg.PolicyUpdate
+	27, // [27:41] is the sub-list for method output_type
+	13, // [13:27] is the sub-list for method input_type
+	13, // [13:13] is the sub-list for extension type_name
+	13, // [13:13] is the sub-list for extension extendee
+	0,  // [0:13] is the sub-list for field type_name
 }
 
 func init() { file_microseg_proto_init() }
@@ -2289,7 +2531,7 @@ func file_microseg_proto_init() {
 			GoPackagePath: reflect.TypeOf(x{}).PkgPath(),
 			RawDescriptor: unsafe.Slice(unsafe.StringData(file_microseg_proto_rawDesc), len(file_microseg_proto_rawDesc)),
 			NumEnums:      0,
-			NumMessages:   27,
+			NumMessages:   30,
 			NumExtensions: 0,
 			NumServices:   2,
 		},
@@ -290,8 +290,11 @@ const (
 	ControllerService_Heartbeat_FullMethodName         = "/microseg.ControllerService/Heartbeat"
 	ControllerService_ReportConnections_FullMethodName = "/microseg.ControllerService/ReportConnections"
 	ControllerService_ReportThreats_FullMethodName     = "/microseg.ControllerService/ReportThreats"
+	ControllerService_StreamConnections_FullMethodName = "/microseg.ControllerService/StreamConnections"
+	ControllerService_StreamThreats_FullMethodName     = "/microseg.ControllerService/StreamThreats"
 	ControllerService_ReportWorkload_FullMethodName    = "/microseg.ControllerService/ReportWorkload"
 	ControllerService_GetPolicies_FullMethodName       = "/microseg.ControllerService/GetPolicies"
+	ControllerService_WatchPolicies_FullMethodName     = "/microseg.ControllerService/WatchPolicies"
 )
 
 // ControllerServiceClient is the client API for ControllerService service.
@@ -306,10 +309,16 @@ type ControllerServiceClient interface {
 	ReportConnections(ctx context.Context, in *ConnectionReport, opts ...grpc.CallOption) (*ReportResponse, error)
 	// 上报威胁日志
 	ReportThreats(ctx context.Context, in *ThreatReport, opts ...grpc.CallOption) (*ReportResponse, error)
+	// 流式上报连接，Controller 按批次确认
+	StreamConnections(ctx context.Context, opts ...grpc.CallOption) (grpc.BidiStreamingClient[ConnectionReport, ReportAck], error)
+	// 流式上报威胁日志，Controller 按批次确认
+	StreamThreats(ctx context.Context, opts ...grpc.CallOption) (grpc.BidiStreamingClient[ThreatReport, ReportAck], error)
 	// 上报工作负载变更
 	ReportWorkload(ctx context.Context, in *WorkloadEvent, opts ...grpc.CallOption) (*ReportResponse, error)
 	// 获取策略
 	GetPolicies(ctx context.Context, in *PolicyRequest, opts ...grpc.CallOption) (*PolicyList, error)
+	// 订阅策略，Controller 推送本节点工作负载相关的策略增量
+	WatchPolicies(ctx context.Context, in *PolicyWatchRequest, opts ...grpc.CallOption) (grpc.ServerStreamingClient[PolicyUpdate], error)
 }
 
 type controllerServiceClient struct {
@@ -360,6 +369,32 @@ func (c *controllerServiceClient) ReportThreats(ctx context.Context, in *ThreatR
 	return out, nil
 }
 
+func (c *controllerServiceClient) StreamConnections(ctx context.Context, opts ...grpc.CallOption) (grpc.BidiStreamingClient[ConnectionReport, ReportAck], error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	stream, err := c.cc.NewStream(ctx, &ControllerService_ServiceDesc.Streams[0], ControllerService_StreamConnections_FullMethodName, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	x := &grpc.GenericClientStream[ConnectionReport, ReportAck]{ClientStream: stream}
+	return x, nil
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type ControllerService_StreamConnectionsClient = grpc.BidiStreamingClient[ConnectionReport, ReportAck]
+
+func (c *controllerServiceClient) StreamThreats(ctx context.Context, opts ...grpc.CallOption) (grpc.BidiStreamingClient[ThreatReport, ReportAck], error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	stream, err := c.cc.NewStream(ctx, &ControllerService_ServiceDesc.Streams[1], ControllerService_StreamThreats_FullMethodName, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	x := &grpc.GenericClientStream[ThreatReport, ReportAck]{ClientStream: stream}
+	return x, nil
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type ControllerService_StreamThreatsClient = grpc.BidiStreamingClient[ThreatReport, ReportAck]
+
 func (c *controllerServiceClient) ReportWorkload(ctx context.Context, in *WorkloadEvent, opts ...grpc.CallOption) (*ReportResponse, error) {
 	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
 	out := new(ReportResponse)
@@ -380,6 +415,25 @@ func (c *controllerServiceClient) GetPolicies(ctx context.Context, in *PolicyReq
 	return out, nil
 }
 
+func (c *controllerServiceClient) WatchPolicies(ctx context.Context, in *PolicyWatchRequest, opts ...grpc.CallOption) (grpc.ServerStreamingClient[PolicyUpdate], error) {
+	cOpts := append([]grpc.CallOption{grpc.StaticMethod()}, opts...)
+	stream, err := c.cc.NewStream(ctx, &ControllerService_ServiceDesc.Streams[2], ControllerService_WatchPolicies_FullMethodName, cOpts...)
+	if err != nil {
+		return nil, err
+	}
+	x := &grpc.GenericClientStream[PolicyWatchRequest, PolicyUpdate]{ClientStream: stream}
+	if err := x.ClientStream.SendMsg(in); err != nil {
+		return nil, err
+	}
+	if err := x.ClientStream.CloseSend(); err != nil {
+		return nil, err
+	}
+	return x, nil
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type ControllerService_WatchPoliciesClient = grpc.ServerStreamingClient[PolicyUpdate]
+
 // ControllerServiceServer is the server API for ControllerService service.
 // All implementations must embed UnimplementedControllerServiceServer
 // for forward compatibility.
@@ -392,10 +446,16 @@ type ControllerServiceServer interface {
 	ReportConnections(context.Context, *ConnectionReport) (*ReportResponse, error)
 	// 上报威胁日志
 	ReportThreats(context.Context, *ThreatReport) (*ReportResponse, error)
+	// 流式上报连接，Controller 按批次确认
+	StreamConnections(grpc.BidiStreamingServer[ConnectionReport, ReportAck]) error
+	// 流式上报威胁日志，Controller 按批次确认
+	StreamThreats(grpc.BidiStreamingServer[ThreatReport, ReportAck]) error
 	// 上报工作负载变更
 	ReportWorkload(context.Context, *WorkloadEvent) (*ReportResponse, error)
 	// 获取策略
 	GetPolicies(context.Context, *PolicyRequest) (*PolicyList, error)
+	// 订阅策略，Controller 推送本节点工作负载相关的策略增量
+	WatchPolicies(*PolicyWatchRequest, grpc.ServerStreamingServer[PolicyUpdate]) error
 	mustEmbedUnimplementedControllerServiceServer()
 }
 
@@ -418,12 +478,21 @@ func (UnimplementedControllerServiceServer) ReportConnections(context.Context, *
 func (UnimplementedControllerServiceServer) ReportThreats(context.Context, *ThreatReport) (*ReportResponse, error) {
 	return nil, status.Error(codes.Unimplemented, "method ReportThreats not implemented")
 }
+func (UnimplementedControllerServiceServer) StreamConnections(grpc.BidiStreamingServer[ConnectionReport, ReportAck]) error {
+	return status.Error(codes.Unimplemented, "method StreamConnections not implemented")
+}
+func (UnimplementedControllerServiceServer) StreamThreats(grpc.BidiStreamingServer[ThreatReport, ReportAck]) error {
+	return status.Error(codes.Unimplemented, "method StreamThreats not implemented")
+}
 func (UnimplementedControllerServiceServer) ReportWorkload(context.Context, *WorkloadEvent) (*ReportResponse, error) {
 	return nil, status.Error(codes.Unimplemented, "method ReportWorkload not implemented")
 }
 func (UnimplementedControllerServiceServer) GetPolicies(context.Context, *PolicyRequest) (*PolicyList, error) {
 	return nil, status.Error(codes.Unimplemented, "method GetPolicies not implemented")
 }
+func (UnimplementedControllerServiceServer) WatchPolicies(*PolicyWatchRequest, grpc.ServerStreamingServer[PolicyUpdate]) error {
+	return status.Error(codes.Unimplemented, "method WatchPolicies not implemented")
+}
 func (UnimplementedControllerServiceServer) mustEmbedUnimplementedControllerServiceServer() {}
 func (UnimplementedControllerServiceServer) testEmbeddedByValue()                           {}
 
@@ -517,6 +586,20 @@ func _ControllerService_ReportThreats_Handler(srv interface{}, ctx context.Conte
 	return interceptor(ctx, in, info, handler)
 }
 
+func _ControllerService_StreamConnections_Handler(srv interface{}, stream grpc.ServerStream) error {
+	return srv.(ControllerServiceServer).StreamConnections(&grpc.GenericServerStream[ConnectionReport, ReportAck]{ServerStream: stream})
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type ControllerService_StreamConnectionsServer = grpc.BidiStreamingServer[ConnectionReport, ReportAck]
+
+func _ControllerService_StreamThreats_Handler(srv interface{}, stream grpc.ServerStream) error {
+	return srv.(ControllerServiceServer).StreamThreats(&grpc.GenericServerStream[ThreatReport, ReportAck]{ServerStream: stream})
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type ControllerService_StreamThreatsServer = grpc.BidiStreamingServer[ThreatReport, ReportAck]
+
 func _ControllerService_ReportWorkload_Handler(srv interface{}, ctx context.Context, dec func(interface{}) error, interceptor grpc.UnaryServerInterceptor) (interface{}, error) {
 	in := new(WorkloadEvent)
 	if err := dec(in); err != nil {
@@ -553,6 +636,17 @@ func _ControllerService_GetPolicies_Handler(srv interface{}, ctx context.Context
 	return interceptor(ctx, in, info, handler)
 }
 
+func _ControllerService_WatchPolicies_Handler(srv interface{}, stream grpc.ServerStream) error {
+	m := new(PolicyWatchRequest)
+	if err := stream.RecvMsg(m); err != nil {
+		return err
+	}
+	return srv.(ControllerServiceServer).WatchPolicies(m, &grpc.GenericServerStream[PolicyWatchRequest, PolicyUpdate]{ServerStream: stream})
+}
+
+// This type alias is provided for backwards compatibility with existing code that references the prior non-generic stream type by name.
+type ControllerService_WatchPoliciesServer = grpc.ServerStreamingServer[PolicyUpdate]
+
 // ControllerService_ServiceDesc is the grpc.ServiceDesc for ControllerService service.
 // It's only intended for direct use with grpc.RegisterService,
 // and not to be introspected or modified (even as a copy)
@@ -585,6 +679,24 @@ var ControllerService_ServiceDesc = grpc.ServiceDesc{
 			Handler:    _ControllerService_GetPolicies_Handler,
 		},
 	},
-	Streams:  []grpc.StreamDesc{},
+	Streams: []grpc.StreamDesc{
+		{
+			StreamName:    "StreamConnections",
+			Handler:       _ControllerService_StreamConnections_Handler,
+			ServerStreams: true,
+			ClientStreams: true,
+		},
+		{
+			StreamName:    "StreamThreats",
+			Handler:       _ControllerService_StreamThreats_Handler,
+			ServerStreams: true,
+			ClientStreams: true,
+		},
+		{
+			StreamName:    "WatchPolicies",
+			Handler:       _ControllerService_WatchPolicies_Handler,
+			ServerStreams: true,
+		},
+	},
 	Metadata: "microseg.proto",
 }
@@ -29,9 +29,18 @@ const connectionMapMax int = 2048 * 64
 // connectionListMax 单次传输最大连接数，避免消息过大
 const connectionListMax int = 2048 * 4
 
+// connectionBatchMax 单批上报的连接数，一次传输按批次流式发送
+const connectionBatchMax int = 1024
+
 // reportInterval 上报间隔（秒），定期将聚合数据发送给Controller
 const reportInterval uint32 = 5
 
+// threatFlushInterval 威胁日志上报间隔，威胁日志不等连接的上报周期
+const threatFlushInterval = time.Second
+
+// threatBatchMax 单批上报的威胁日志数，缓存达到一批时提前上报
+const threatBatchMax int = 256
+
 // Aggregator 连接聚合器，负责收集和批量上报连接信息
 type Aggregator struct {
 	mutex          sync.Mutex                    // 连接映射表锁
@@ -40,6 +49,7 @@ type Aggregator struct {
 	connsCacheMux  sync.Mutex                    // 缓存锁
 	threatLogCache []*threatLogEntry             // 威胁日志缓存
 	threatMutex    sync.Mutex                    // 威胁日志锁
+	threatKick     chan struct{}                 // 威胁日志满一批时通知上报
 
 	// 回调函数
 	onConnections func([]*agent.Connection) // 连接上报回调
@@ -66,6 +76,7 @@ func NewAggregator(agentID, hostID string) *Aggregator {
 		connectionMap:  make(map[string]*agent.Connection),
 		connsCache:     make([]*agent.ConnectionData, 0),
 		threatLogCache: make([]*threatLogEntry, 0),
+		threatKick:     make(chan struct{}, 1),
 		agentID:        agentID,
 		hostID:         hostID,
 		stopCh:         make(chan struct{}),
@@ -95,14 +106,21 @@ func (a *Aggregator) Stop() {
 }
 
 // timerLoop 定时器循环，定期刷新和上报数据
+// 上报回调在本循环中同步执行，Controller 确认不及时时回调阻塞，数据留在缓存和映射表中合并
 func (a *Aggregator) timerLoop() {
 	ticker := time.NewTicker(time.Second * time.Duration(reportInterval))
 	defer ticker.Stop()
+	threatTicker := time.NewTicker(threatFlushInterval)
+	defer threatTicker.Stop()
 
 	for {
 		select {
 		case <-ticker.C:
 			a.flush() // 定时刷新数据
+		case <-threatTicker.C:
+			a.putThreatLogs()
+		case <-a.threatKick:
+			a.putThreatLogs()
 		case <-a.stopCh:
 			return
 		}
@@ -127,7 +145,15 @@ func (a *Aggregator) AddConnection(data *agent.ConnectionData) {
 func (a *Aggregator) AddThreatLog(mac net.HardwareAddr, slog *agent.ThreatLog) {
 	a.threatMutex.Lock()
 	a.threatLogCache = append(a.threatLogCache, &threatLogEntry{mac: mac, slog: slog})
+	full := len(a.threatLogCache) >= threatBatchMax
 	a.threatMutex.Unlock()
+
+	if full {
+		select {
+		case a.threatKick <- struct{}{}:
+		default:
+		}
+	}
 }
 
 // updateConnections 处理缓存的连接数据，更新到聚合映射表
@@ -210,8 +236,15 @@ func (a *Aggregator) putConnections() {
 	}
 	a.mutex.Unlock()
 
-	if len(list) > 0 && a.onConnections != nil {
-		a.onConnections(list)
+	if a.onConnections == nil {
+		return
+	}
+	for i := 0; i < len(list); i += connectionBatchMax {
+		end := i + connectionBatchMax
+		if end > len(list) {
+			end = len(list)
+		}
+		a.onConnections(list[i:end])
 	}
 }
 
@@ -227,7 +260,13 @@ func (a *Aggregator) putThreatLogs() {
 		for _, entry := range tmp {
 			logs = append(logs, entry.slog)
 		}
-		a.onThreatLogs(logs)
+		for i := 0; i < len(logs); i += threatBatchMax {
+			end := i + threatBatchMax
+			if end > len(logs) {
+				end = len(logs)
+			}
+			a.onThreatLogs(logs[i:end])
+		}
 	}
 }
 
@@ -111,6 +111,9 @@ func (e *Engine) Start() error {
 		if err := e.grpcClient.Register(); err != nil {
 			log.WithError(err).Warn("Failed to register agent")
 		}
+
+		// 订阅本节点相关的策略
+		e.grpcClient.WatchPolicies(e.policy.ApplyUpdate)
 	}
 
 	// 启动聚合器
@@ -341,6 +344,7 @@ func (e *Engine) GetStats() map[string]interface{} {
 	return map[string]interface{}{
 		"workloads":        len(e.workloads),
 		"policies":         e.policy.GetRuleCount(),
+		"policy_version":   e.policy.GetVersion(),
 		"connections":      e.aggregator.GetConnectionCount(),
 		"max_connections":  e.aggregator.GetMaxConnections(),
 		"dp_connected":     e.dpClient.IsConnected(),
@@ -9,7 +9,9 @@ import (
 	"time"
 
 	"google.golang.org/grpc"
+	"google.golang.org/grpc/codes"
 	"google.golang.org/grpc/credentials/insecure"
+	"google.golang.org/grpc/status"
 
 	log "github.com/sirupsen/logrus"
 
@@ -17,6 +19,12 @@ import (
 	"github.com/micro-segment/internal/agent"
 )
 
+// policyWatchRetry 策略订阅断开后的重试间隔
+const policyWatchRetry = 5 * time.Second
+
+// policyPollInterval Controller不支持策略订阅时获取策略的间隔
+const policyPollInterval = 30 * time.Second
+
 // Client gRPC客户端
 type Client struct {
 	mutex      sync.RWMutex
@@ -25,6 +33,10 @@ type Client struct {
 	serverAddr string
 	connected  bool
 
+	// 流式上报
+	connStream   *reportStream
+	threatStream *reportStream
+
 	// Agent信息
 	agentID  string
 	hostID   string
@@ -73,6 +85,14 @@ func (c *Client) Connect() error {
 	c.client = pb.NewControllerServiceClient(conn)
 	c.connected = true
 
+	client := c.client
+	c.connStream = newReportStream("connections", func(ctx context.Context) (grpc.ClientStream, error) {
+		return client.StreamConnections(ctx)
+	})
+	c.threatStream = newReportStream("threats", func(ctx context.Context) (grpc.ClientStream, error) {
+		return client.StreamThreats(ctx)
+	})
+
 	log.WithField("server", c.serverAddr).Info("Connected to Controller")
 	return nil
 }
@@ -88,6 +108,8 @@ func (c *Client) Disconnect() {
 	}
 
 	close(c.stopCh)
+	c.connStream.reset()
+	c.threatStream.reset()
 	c.conn.Close()
 	c.connected = false
 }
@@ -179,7 +201,7 @@ func (c *Client) sendHeartbeat() {
 }
 
 // ReportConnections 上报连接
-// 批量上报网络连接数据到Controller
+// 批量上报网络连接数据到Controller，优先走流式上报，窗口满时阻塞
 func (c *Client) ReportConnections(conns []*agent.Connection) error {
 	c.mutex.RLock()
 	if !c.connected {
@@ -187,11 +209,9 @@ func (c *Client) ReportConnections(conns []*agent.Connection) error {
 		return fmt.Errorf("not connected")
 	}
 	client := c.client
+	stream := c.connStream
 	c.mutex.RUnlock()
 
-	ctx, cancel := context.WithTimeout(context.Background(), 10*time.Second)
-	defer cancel()
-
 	pbConns := make([]*pb.Connection, 0, len(conns))
 	for _, conn := range conns {
 		pbConns = append(pbConns, &pb.Connection{
@@ -220,11 +240,27 @@ func (c *Client) ReportConnections(conns []*agent.Connection) error {
 		})
 	}
 
-	resp, err := client.ReportConnections(ctx, &pb.ConnectionReport{
+	report := &pb.ConnectionReport{
 		AgentId:     c.agentID,
 		HostId:      c.hostID,
 		Connections: pbConns,
+	}
+	err := stream.send(func(seq uint64) interface{} {
+		report.Seq = seq
+		return report
 	})
+	if err != errStreamUnsupported {
+		if err != nil {
+			return fmt.Errorf("report connections failed: %v", err)
+		}
+		return nil
+	}
+
+	ctx, cancel := context.WithTimeout(context.Background(), 10*time.Second)
+	defer cancel()
+
+	report.Seq = 0
+	resp, err := client.ReportConnections(ctx, report)
 	if err != nil {
 		return fmt.Errorf("report connections failed: %v", err)
 	}
@@ -237,7 +273,7 @@ func (c *Client) ReportConnections(conns []*agent.Connection) error {
 }
 
 // ReportThreats 上报威胁日志
-// 批量上报安全威胁检测结果到Controller
+// 批量上报安全威胁检测结果到Controller，优先走流式上报，窗口满时阻塞
 func (c *Client) ReportThreats(threats []*agent.ThreatLog) error {
 	c.mutex.RLock()
 	if !c.connected {
@@ -245,11 +281,9 @@ func (c *Client) ReportThreats(threats []*agent.ThreatLog) error {
 		return fmt.Errorf("not connected")
 	}
 	client := c.client
+	stream := c.threatStream
 	c.mutex.RUnlock()
 
-	ctx, cancel := context.WithTimeout(context.Background(), 10*time.Second)
-	defer cancel()
-
 	pbThreats := make([]*pb.ThreatLog, 0, len(threats))
 	for _, threat := range threats {
 		pbThreats = append(pbThreats, &pb.ThreatLog{
@@ -269,11 +303,27 @@ func (c *Client) ReportThreats(threats []*agent.ThreatLog) error {
 		})
 	}
 
-	resp, err := client.ReportThreats(ctx, &pb.ThreatReport{
+	report := &pb.ThreatReport{
 		AgentId: c.agentID,
 		HostId:  c.hostID,
 		Threats: pbThreats,
+	}
+	err := stream.send(func(seq uint64) interface{} {
+		report.Seq = seq
+		return report
 	})
+	if err != errStreamUnsupported {
+		if err != nil {
+			return fmt.Errorf("report threats failed: %v", err)
+		}
+		return nil
+	}
+
+	ctx, cancel := context.WithTimeout(context.Background(), 10*time.Second)
+	defer cancel()
+
+	report.Seq = 0
+	resp, err := client.ReportThreats(ctx, report)
 	if err != nil {
 		return fmt.Errorf("report threats failed: %v", err)
 	}
@@ -367,20 +417,125 @@ func (c *Client) GetPolicies(workloadIDs []string) ([]*agent.PolicyRule, error)
 
 	rules := make([]*agent.PolicyRule, 0, len(resp.Rules))
 	for _, r := range resp.Rules {
-		rules = append(rules, &agent.PolicyRule{
-			ID:           r.Id,
-			From:         r.From,
-			To:           r.To,
-			Ports:        r.Ports,
-			Applications: r.Applications,
-			Action:       agent.PolicyAction(r.Action),
-			Ingress:      r.Ingress,
-		})
+		rules = append(rules, policyRuleFromProto(r))
 	}
 
 	return rules, nil
 }
 
+// WatchPolicies 订阅策略
+// 后台订阅Controller推送的策略更新并交给onUpdate，断开后重新订阅；
+// Controller不支持订阅时改为定期获取全量策略
+func (c *Client) WatchPolicies(onUpdate func(*agent.PolicyUpdate)) {
+	go c.watchPoliciesLoop(onUpdate)
+}
+
+// watchPoliciesLoop 策略订阅循环
+func (c *Client) watchPoliciesLoop(onUpdate func(*agent.PolicyUpdate)) {
+	for {
+		err := c.watchPolicies(onUpdate)
+		select {
+		case <-c.stopCh:
+			return
+		default:
+		}
+
+		if status.Code(err) == codes.Unimplemented {
+			log.Info("Policy watch unsupported by Controller, polling policies")
+			c.pollPolicies(onUpdate)
+			return
+		}
+		log.WithError(err).Warn("Policy watch interrupted")
+
+		select {
+		case <-time.After(policyWatchRetry):
+		case <-c.stopCh:
+			return
+		}
+	}
+}
+
+// watchPolicies 订阅一次策略，直到流断开
+// 每次订阅的第一个更新是全量的
+func (c *Client) watchPolicies(onUpdate func(*agent.PolicyUpdate)) error {
+	c.mutex.RLock()
+	if !c.connected {
+		c.mutex.RUnlock()
+		return fmt.Errorf("not connected")
+	}
+	client := c.client
+	c.mutex.RUnlock()
+
+	ctx, cancel := context.WithCancel(context.Background())
+	defer cancel()
+	go func() {
+		select {
+		case <-c.stopCh:
+			cancel()
+		case <-ctx.Done():
+		}
+	}()
+
+	stream, err := client.WatchPolicies(ctx, &pb.PolicyWatchRequest{
+		AgentId: c.agentID,
+		HostId:  c.hostID,
+	})
+	if err != nil {
+		return err
+	}
+
+	for {
+		resp, err := stream.Recv()
+		if err != nil {
+			return err
+		}
+
+		update := &agent.PolicyUpdate{
+			Version: resp.Version,
+			Full:    resp.Full,
+			Rules:   make([]*agent.PolicyRule, 0, len(resp.Rules)),
+			Deleted: resp.DeletedIds,
+		}
+		for _, r := range resp.Rules {
+			update.Rules = append(update.Rules, policyRuleFromProto(r))
+		}
+		onUpdate(update)
+	}
+}
+
+// pollPolicies 定期获取全量策略
+func (c *Client) pollPolicies(onUpdate func(*agent.PolicyUpdate)) {
+	ticker := time.NewTicker(policyPollInterval)
+	defer ticker.Stop()
+
+	for {
+		if rules, err := c.GetPolicies(nil); err != nil {
+			log.WithError(err).Warn("Failed to get policies")
+		} else {
+			onUpdate(&agent.PolicyUpdate{Full: true, Rules: rules})
+		}
+
+		select {
+		case <-ticker.C:
+		case <-c.stopCh:
+			return
+		}
+	}
+}
+
+// policyRuleFromProto 转换proto策略规则
+func policyRuleFromProto(r *pb.PolicyRule) *agent.PolicyRule {
+	return &agent.PolicyRule{
+		ID:           r.Id,
+		From:         r.From,
+		To:           r.To,
+		Ports:        r.Ports,
+		Applications: r.Applications,
+		Action:       agent.PolicyAction(r.Action),
+		Ingress:      r.Ingress,
+	}
+}
+
 // ipToBytes 转换IP为字节
 // 将IP地址转换为字节数组，支持IPv4和IPv6
 func ipToBytes(ip net.IP) []byte {
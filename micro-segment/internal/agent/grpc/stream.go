@@ -0,0 +1,187 @@
+package grpc
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"sync"
+	"time"
+
+	"google.golang.org/grpc"
+	"google.golang.org/grpc/codes"
+	"google.golang.org/grpc/status"
+
+	log "github.com/sirupsen/logrus"
+
+	pb "github.com/micro-segment/api/proto"
+)
+
+// 流式上报：批次带序号在一条长连接的流上发送，Controller 处理完一批回一个确认，
+// 确认是累积的。未确认的批次数达到 Controller 给出的窗口时发送阻塞，把背压传回聚合器。
+// 新建的流在收到第一个确认之前窗口为 1，Controller 不支持流式上报时由调用方改用单次 RPC。
+
+// reportAckTimeout 等待确认的超时，超时后重建流
+const reportAckTimeout = 10 * time.Second
+
+// errStreamUnsupported Controller 未实现流式上报
+var errStreamUnsupported = errors.New("report stream unsupported")
+
+// reportStream 一类上报数据的流
+type reportStream struct {
+	name string
+	open func(ctx context.Context) (grpc.ClientStream, error)
+
+	sendMutex sync.Mutex // 发送串行化
+
+	mutex       sync.Mutex
+	stream      grpc.ClientStream
+	cancel      context.CancelFunc
+	seq         uint64 // 最后发送的批次序号
+	acked       uint64 // 最后确认的批次序号
+	window      uint64 // 允许未确认的批次数
+	err         error  // 流的接收错误
+	unsupported bool
+	ackCh       chan struct{}
+}
+
+// newReportStream 创建上报流，首次发送时才建立
+func newReportStream(name string, open func(ctx context.Context) (grpc.ClientStream, error)) *reportStream {
+	return &reportStream{
+		name:  name,
+		open:  open,
+		ackCh: make(chan struct{}, 1),
+	}
+}
+
+// send 发送一批数据，build 按批次序号生成消息
+// 窗口已满时阻塞等待确认；新建的流等到这一批被确认才返回
+func (r *reportStream) send(build func(seq uint64) interface{}) error {
+	r.sendMutex.Lock()
+	defer r.sendMutex.Unlock()
+
+	r.mutex.Lock()
+	if r.unsupported {
+		r.mutex.Unlock()
+		return errStreamUnsupported
+	}
+	fresh := r.stream == nil
+	if fresh {
+		ctx, cancel := context.WithCancel(context.Background())
+		stream, err := r.open(ctx)
+		if err != nil {
+			cancel()
+			r.mutex.Unlock()
+			return r.streamError(err)
+		}
+		r.stream, r.cancel = stream, cancel
+		r.acked, r.window, r.err = r.seq, 1, nil
+		go r.recvLoop(stream)
+	}
+	stream := r.stream
+	r.mutex.Unlock()
+
+	if err := r.waitAck(func() bool { return r.seq-r.acked < r.window }); err != nil {
+		return err
+	}
+
+	r.mutex.Lock()
+	r.seq++
+	seq := r.seq
+	r.mutex.Unlock()
+
+	if err := stream.SendMsg(build(seq)); err != nil {
+		// 流已断开，真正的错误由接收端得到
+		return r.waitAck(func() bool { return false })
+	}
+
+	if fresh {
+		return r.waitAck(func() bool { return r.acked >= seq })
+	}
+	return nil
+}
+
+// waitAck 等待确认直到 ready 成立，ready 在锁内调用
+func (r *reportStream) waitAck(ready func() bool) error {
+	timer := time.NewTimer(reportAckTimeout)
+	defer timer.Stop()
+
+	for {
+		r.mutex.Lock()
+		if r.err != nil {
+			err := r.err
+			r.mutex.Unlock()
+			r.reset()
+			return r.streamError(err)
+		}
+		ok := ready()
+		r.mutex.Unlock()
+		if ok {
+			return nil
+		}
+
+		select {
+		case <-r.ackCh:
+		case <-timer.C:
+			r.reset()
+			return fmt.Errorf("%s stream: ack timeout", r.name)
+		}
+	}
+}
+
+// recvLoop 接收确认，更新确认序号和窗口
+func (r *reportStream) recvLoop(stream grpc.ClientStream) {
+	for {
+		ack := new(pb.ReportAck)
+		err := stream.RecvMsg(ack)
+
+		r.mutex.Lock()
+		if r.stream != stream {
+			r.mutex.Unlock()
+			return
+		}
+		if err != nil {
+			r.err = err
+		} else {
+			if ack.Seq > r.acked {
+				r.acked = ack.Seq
+			}
+			if ack.Window > 0 {
+				r.window = uint64(ack.Window)
+			}
+		}
+		r.mutex.Unlock()
+
+		select {
+		case r.ackCh <- struct{}{}:
+		default:
+		}
+		if err != nil {
+			return
+		}
+	}
+}
+
+// streamError 转换流的错误，记录 Controller 是否支持流式上报
+func (r *reportStream) streamError(err error) error {
+	if status.Code(err) == codes.Unimplemented {
+		r.mutex.Lock()
+		r.unsupported = true
+		r.mutex.Unlock()
+		log.WithField("stream", r.name).Info("Report stream unsupported by Controller")
+		return errStreamUnsupported
+	}
+	return fmt.Errorf("%s stream: %v", r.name, err)
+}
+
+// reset 关闭当前的流，下次发送时重建
+func (r *reportStream) reset() {
+	r.mutex.Lock()
+	defer r.mutex.Unlock()
+
+	if r.stream != nil {
+		r.stream.CloseSend()
+		r.cancel()
+		r.stream, r.cancel = nil, nil
+	}
+	r.err = nil
+}
@@ -4,6 +4,7 @@ package policy
 
 import (
 	"net"
+	"slices"
 	"sync"
 
 	log "github.com/sirupsen/logrus"
@@ -16,6 +17,8 @@ import (
 type NetworkPolicy struct {
 	mutex    sync.RWMutex
 	rules    map[uint32]*agent.PolicyRule
+	dpRules  map[uint32]*dp.DPPolicy // 规则转换后的DP策略，规则不变时不重新转换
+	version  uint64                  // 已应用的Controller策略版本
 	dpClient *dp.DPClient
 }
 
@@ -24,6 +27,7 @@ type NetworkPolicy struct {
 func NewNetworkPolicy(dpClient *dp.DPClient) *NetworkPolicy {
 	return &NetworkPolicy{
 		rules:    make(map[uint32]*agent.PolicyRule),
+		dpRules:  make(map[uint32]*dp.DPPolicy),
 		dpClient: dpClient,
 	}
 }
@@ -35,6 +39,7 @@ func (p *NetworkPolicy) AddRule(rule *agent.PolicyRule) {
 	defer p.mutex.Unlock()
 
 	p.rules[rule.ID] = rule
+	p.dpRules[rule.ID] = p.ruleToDPPolicy(rule)
 	log.WithFields(log.Fields{
 		"id":     rule.ID,
 		"from":   rule.From,
@@ -50,6 +55,7 @@ func (p *NetworkPolicy) DeleteRule(id uint32) {
 	defer p.mutex.Unlock()
 
 	delete(p.rules, id)
+	delete(p.dpRules, id)
 	log.WithField("id", id).Debug("Policy rule deleted")
 }
 
@@ -83,10 +89,12 @@ func (p *NetworkPolicy) UpdateRules(rules []*agent.PolicyRule) {
 
 	// 清空旧规则
 	p.rules = make(map[uint32]*agent.PolicyRule)
+	p.dpRules = make(map[uint32]*dp.DPPolicy)
 
 	// 添加新规则
 	for _, rule := range rules {
 		p.rules[rule.ID] = rule
+		p.dpRules[rule.ID] = p.ruleToDPPolicy(rule)
 	}
 
 	log.WithField("count", len(rules)).Info("Policy rules updated")
@@ -95,16 +103,72 @@ func (p *NetworkPolicy) UpdateRules(rules []*agent.PolicyRule) {
 	p.syncToDP()
 }
 
+// ApplyUpdate 应用Controller推送的策略更新
+// 只转换新增和变更的规则，规则有变化时才同步到DP层
+func (p *NetworkPolicy) ApplyUpdate(update *agent.PolicyUpdate) {
+	p.mutex.Lock()
+	defer p.mutex.Unlock()
+
+	var changed, deleted int
+	keep := make(map[uint32]bool, len(update.Rules))
+	for _, rule := range update.Rules {
+		keep[rule.ID] = true
+		if old, ok := p.rules[rule.ID]; ok && samePolicyRule(old, rule) {
+			continue
+		}
+		p.rules[rule.ID] = rule
+		p.dpRules[rule.ID] = p.ruleToDPPolicy(rule)
+		changed++
+	}
+
+	for _, id := range update.Deleted {
+		if _, ok := p.rules[id]; ok {
+			delete(p.rules, id)
+			delete(p.dpRules, id)
+			deleted++
+		}
+	}
+
+	// 全量更新时移除不再下发的规则
+	if update.Full {
+		for id := range p.rules {
+			if !keep[id] {
+				delete(p.rules, id)
+				delete(p.dpRules, id)
+				deleted++
+			}
+		}
+	}
+
+	p.version = update.Version
+
+	log.WithFields(log.Fields{
+		"version": update.Version,
+		"full":    update.Full,
+		"changed": changed,
+		"deleted": deleted,
+	}).Debug("Policy update applied")
+
+	if changed > 0 || deleted > 0 {
+		p.syncToDP()
+	}
+}
+
+// samePolicyRule 比较两条规则是否相同
+func samePolicyRule(a, b *agent.PolicyRule) bool {
+	return a.ID == b.ID && a.From == b.From && a.To == b.To && a.Ports == b.Ports &&
+		a.Action == b.Action && a.Ingress == b.Ingress && slices.Equal(a.Applications, b.Applications)
+}
+
 // syncToDP 同步策略到DP层
-// 将内存中的策略规则转换并发送到DP执行
+// 将已转换的DP策略发送到DP执行
 func (p *NetworkPolicy) syncToDP() {
 	if p.dpClient == nil || !p.dpClient.IsConnected() {
 		return
 	}
 
-	dpPolicies := make([]*dp.DPPolicy, 0, len(p.rules))
-	for _, rule := range p.rules {
-		dpPolicy := p.ruleToDPPolicy(rule)
+	dpPolicies := make([]*dp.DPPolicy, 0, len(p.dpRules))
+	for _, dpPolicy := range p.dpRules {
 		if dpPolicy != nil {
 			dpPolicies = append(dpPolicies, dpPolicy)
 		}
@@ -142,6 +206,13 @@ func (p *NetworkPolicy) MatchPolicy(srcIP, dstIP net.IP, dstPort uint16, proto u
 	return 0, agent.PolicyActionViolate
 }
 
+// GetVersion 获取已应用的策略版本
+func (p *NetworkPolicy) GetVersion() uint64 {
+	p.mutex.RLock()
+	defer p.mutex.RUnlock()
+	return p.version
+}
+
 // GetRuleCount 获取规则数量
 // 返回当前策略规则总数
 func (p *NetworkPolicy) GetRuleCount() int {
@@ -145,6 +145,14 @@ type PolicyRule struct {
 	Ingress      bool          // 是否为入站规则
 }
 
+// PolicyUpdate Controller推送的策略更新，只包含本节点工作负载相关的规则
+type PolicyUpdate struct {
+	Version uint64        // 策略版本
+	Full    bool          // 全量更新，替换已有的规则
+	Rules   []*PolicyRule // 新增或变更的规则
+	Deleted []uint32      // 删除的规则ID
+}
+
 // ContainerEvent 容器生命周期事件类型
 type ContainerEvent int
 
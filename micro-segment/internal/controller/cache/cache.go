@@ -251,6 +251,45 @@ func (c *Cache) DeletePolicy(id uint32) {
 	delete(c.policies, id)
 }
 
+// HostPolicyPeers 获取主机上的工作负载可作为策略端点的名称
+// 包括工作负载的ID、名称、服务和所属的组，主机上有工作负载时包括"any"
+func (c *Cache) HostPolicyPeers(hostID string) map[string]bool {
+	c.mutex.RLock()
+	defer c.mutex.RUnlock()
+
+	peers := make(map[string]bool)
+	for id, cache := range c.workloads {
+		wl := cache.Workload
+		if wl.HostID != hostID {
+			continue
+		}
+		peers[id] = true
+		if wl.Name != "" {
+			peers[wl.Name] = true
+		}
+		if wl.Service != "" {
+			peers[wl.Service] = true
+		}
+		for _, group := range cache.Groups {
+			peers[group] = true
+		}
+	}
+
+	for name, cache := range c.groups {
+		for member := range cache.Members {
+			if wc, ok := c.workloads[member]; ok && wc.Workload.HostID == hostID {
+				peers[name] = true
+				break
+			}
+		}
+	}
+
+	if len(peers) > 0 {
+		peers["any"] = true
+	}
+	return peers
+}
+
 // ListPolicies 列出所有策略
 func (c *Cache) ListPolicies() []*controller.PolicyRule {
 	c.mutex.RLock()
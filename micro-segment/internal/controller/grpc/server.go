@@ -5,6 +5,7 @@ package grpc
 import (
 	"context"
 	"fmt"
+	"io"
 	"net"
 	"sync"
 	"time"
@@ -12,6 +13,7 @@ import (
 	"google.golang.org/grpc"
 
 	pb "github.com/micro-segment/api/proto"
+	controller "github.com/micro-segment/internal/controller"
 	"github.com/micro-segment/internal/controller/cache"
 	"github.com/micro-segment/internal/controller/policy"
 )
@@ -33,11 +35,22 @@ type Server struct {
 	// Agent管理
 	agents map[string]*AgentState
 
+	// 策略订阅，按主机记录订阅流的通知通道
+	watchMutex     sync.Mutex
+	policyWatchers map[string]map[chan struct{}]struct{}
+	watchStopCh    chan struct{}
+
 	// 回调函数
 	onAgentJoin  func(agentID, hostID string)
 	onAgentLeave func(agentID string)
 }
 
+// reportStreamWindow 流式上报允许Agent未确认的批次数
+const reportStreamWindow uint32 = 8
+
+// gracefulStopTimeout 优雅关闭的等待时间，Agent维持的长连接流超时后强制关闭
+const gracefulStopTimeout = 5 * time.Second
+
 // AgentState Agent状态
 type AgentState struct {
 	Info       *pb.AgentInfo
@@ -54,6 +67,8 @@ func NewServer(port int, c *cache.Cache, p *policy.Engine) *Server {
 		cache:  c,
 		policy: p,
 		agents: make(map[string]*AgentState),
+
+		policyWatchers: make(map[string]map[chan struct{}]struct{}),
 	}
 }
 
@@ -88,6 +103,10 @@ func (s *Server) Start() error {
 	s.grpcServer = grpc.NewServer()
 	pb.RegisterControllerServiceServer(s.grpcServer, s)
 
+	s.watchMutex.Lock()
+	s.watchStopCh = make(chan struct{})
+	s.watchMutex.Unlock()
+
 	s.running = true
 
 	go func() {
@@ -112,7 +131,21 @@ func (s *Server) Stop() {
 		return
 	}
 
-	s.grpcServer.GracefulStop()
+	// 结束策略订阅流
+	s.watchMutex.Lock()
+	close(s.watchStopCh)
+	s.watchMutex.Unlock()
+
+	done := make(chan struct{})
+	go func() {
+		s.grpcServer.GracefulStop()
+		close(done)
+	}()
+	select {
+	case <-done:
+	case <-time.After(gracefulStopTimeout):
+		s.grpcServer.Stop()
+	}
 	s.listener.Close()
 	s.running = false
 }
@@ -229,6 +262,57 @@ func (s *Server) ReportThreats(ctx context.Context, req *pb.ThreatReport) (*pb.R
 	}, nil
 }
 
+// StreamConnections 流式上报连接
+// 逐批处理Agent上报的连接，处理完一批即确认，Agent据确认窗口控制发送速度
+func (s *Server) StreamConnections(stream pb.ControllerService_StreamConnectionsServer) error {
+	for {
+		req, err := stream.Recv()
+		if err == io.EOF {
+			return nil
+		}
+		if err != nil {
+			return err
+		}
+
+		for _, conn := range req.Connections {
+			s.cache.UpdateConnectionFromProto(conn)
+		}
+
+		if err := stream.Send(&pb.ReportAck{
+			Seq:            req.Seq,
+			Message:        "ok",
+			Window:         reportStreamWindow,
+			ReportInterval: 5,
+		}); err != nil {
+			return err
+		}
+	}
+}
+
+// StreamThreats 流式上报威胁日志
+// 逐批接收Agent上报的威胁日志并确认
+func (s *Server) StreamThreats(stream pb.ControllerService_StreamThreatsServer) error {
+	for {
+		req, err := stream.Recv()
+		if err == io.EOF {
+			return nil
+		}
+		if err != nil {
+			return err
+		}
+
+		// TODO: 存储威胁日志
+
+		if err := stream.Send(&pb.ReportAck{
+			Seq:     req.Seq,
+			Message: "ok",
+			Window:  reportStreamWindow,
+		}); err != nil {
+			return err
+		}
+	}
+}
+
 // ReportWorkload 上报工作负载变更
 // 处理容器生命周期事件并更新工作负载缓存
 func (s *Server) ReportWorkload(ctx context.Context, req *pb.WorkloadEvent) (*pb.ReportResponse, error) {
@@ -241,6 +325,11 @@ func (s *Server) ReportWorkload(ctx context.Context, req *pb.WorkloadEvent) (*pb
 		}
 	}
 
+	// 主机上的工作负载变化后，该主机相关的策略可能不同
+	if req.Workload != nil {
+		s.wakePolicyWatchers(req.Workload.HostId)
+	}
+
 	return &pb.ReportResponse{
 		Code:    0,
 		Message: "ok",
@@ -254,16 +343,7 @@ func (s *Server) GetPolicies(ctx context.Context, req *pb.PolicyRequest) (*pb.Po
 
 	pbRules := make([]*pb.PolicyRule, 0, len(rules))
 	for _, rule := range rules {
-		pbRules = append(pbRules, &pb.PolicyRule{
-			Id:       rule.ID,
-			From:     rule.From,
-			To:       rule.To,
-			Ports:    rule.Ports,
-			Action:   actionToProto(rule.Action),
-			Priority: rule.Priority,
-			Disable:  rule.Disable,
-			Comment:  rule.Comment,
-		})
+		pbRules = append(pbRules, policyRuleToProto(rule))
 	}
 
 	return &pb.PolicyList{
@@ -271,6 +351,123 @@ func (s *Server) GetPolicies(ctx context.Context, req *pb.PolicyRequest) (*pb.Po
 	}, nil
 }
 
+// WatchPolicies 订阅策略
+// 先推送主机相关的全量规则，之后在规则或主机上的工作负载变化时推送增量
+func (s *Server) WatchPolicies(req *pb.PolicyWatchRequest, stream pb.ControllerService_WatchPoliciesServer) error {
+	wake := make(chan struct{}, 1)
+	s.policy.Watch(wake)
+	defer s.policy.Unwatch(wake)
+
+	stopCh := s.addPolicyWatcher(req.HostId, wake)
+	defer s.removePolicyWatcher(req.HostId, wake)
+
+	// 已推送的规则及其版本
+	sent := make(map[uint32]uint64)
+	full := true
+	for {
+		if update := s.policyUpdate(req.HostId, sent, full); update != nil {
+			if err := stream.Send(update); err != nil {
+				return err
+			}
+		}
+		full = false
+
+		select {
+		case <-wake:
+		case <-stopCh:
+			return nil
+		case <-stream.Context().Done():
+			return nil
+		}
+	}
+}
+
+// policyUpdate 生成主机的策略更新
+// 与已推送的规则比较，只包含新增、变更和不再相关的规则；没有变化时返回nil
+func (s *Server) policyUpdate(hostID string, sent map[uint32]uint64, full bool) *pb.PolicyUpdate {
+	version, rules, versions := s.policy.Snapshot()
+	peers := s.cache.HostPolicyPeers(hostID)
+
+	update := &pb.PolicyUpdate{Version: version, Full: full}
+	related := make(map[uint32]bool)
+	for i, rule := range rules {
+		if !peers[rule.From] && !peers[rule.To] {
+			continue
+		}
+		related[rule.ID] = true
+		if v, ok := sent[rule.ID]; ok && v == versions[i] {
+			continue
+		}
+		sent[rule.ID] = versions[i]
+		update.Rules = append(update.Rules, policyRuleToProto(rule))
+	}
+	for id := range sent {
+		if !related[id] {
+			delete(sent, id)
+			update.DeletedIds = append(update.DeletedIds, id)
+		}
+	}
+
+	if !full && len(update.Rules) == 0 && len(update.DeletedIds) == 0 {
+		return nil
+	}
+	return update
+}
+
+// addPolicyWatcher 登记主机的策略订阅流，返回服务器停止的通知通道
+func (s *Server) addPolicyWatcher(hostID string, wake chan struct{}) chan struct{} {
+	s.watchMutex.Lock()
+	defer s.watchMutex.Unlock()
+
+	watchers, ok := s.policyWatchers[hostID]
+	if !ok {
+		watchers = make(map[chan struct{}]struct{})
+		s.policyWatchers[hostID] = watchers
+	}
+	watchers[wake] = struct{}{}
+	return s.watchStopCh
+}
+
+// removePolicyWatcher 注销主机的策略订阅流
+func (s *Server) removePolicyWatcher(hostID string, wake chan struct{}) {
+	s.watchMutex.Lock()
+	defer s.watchMutex.Unlock()
+
+	if watchers, ok := s.policyWatchers[hostID]; ok {
+		delete(watchers, wake)
+		if len(watchers) == 0 {
+			delete(s.policyWatchers, hostID)
+		}
+	}
+}
+
+// wakePolicyWatchers 通知主机的策略订阅流重新计算策略
+func (s *Server) wakePolicyWatchers(hostID string) {
+	s.watchMutex.Lock()
+	defer s.watchMutex.Unlock()
+
+	for wake := range s.policyWatchers[hostID] {
+		select {
+		case wake <- struct{}{}:
+		default:
+		}
+	}
+}
+
+// policyRuleToProto 转换策略规则到proto
+func policyRuleToProto(rule *controller.PolicyRule) *pb.PolicyRule {
+	return &pb.PolicyRule{
+		Id:       rule.ID,
+		From:     rule.From,
+		To:       rule.To,
+		Ports:    rule.Ports,
+		Action:   actionToProto(rule.Action),
+		Priority: rule.Priority,
+		Disable:  rule.Disable,
+		Comment:  rule.Comment,
+	}
+}
+
 // actionToProto 转换动作到proto
 // 将策略动作字符串转换为protobuf枚举值
 func actionToProto(action string) uint32 {
@@ -23,14 +23,23 @@ type Engine struct {
 
 	// 组策略模式
 	groupModes map[string]controller.PolicyMode
+
+	// 策略版本，规则每次变更递增；ruleVersions 记录规则最后变更时的版本
+	version      uint64
+	ruleVersions map[uint32]uint64
+
+	// 订阅者，规则变更时通知
+	watchers map[chan struct{}]struct{}
 }
 
 // NewEngine 创建策略引擎
 func NewEngine() *Engine {
 	return &Engine{
-		rules:      make(map[uint32]*controller.PolicyRule),
-		ruleOrder:  make([]uint32, 0),
-		groupModes: make(map[string]controller.PolicyMode),
+		rules:        make(map[uint32]*controller.PolicyRule),
+		ruleOrder:    make([]uint32, 0),
+		groupModes:   make(map[string]controller.PolicyMode),
+		ruleVersions: make(map[uint32]uint64),
+		watchers:     make(map[chan struct{}]struct{}),
 	}
 }
 
@@ -50,6 +59,7 @@ func (e *Engine) AddRule(rule *controller.PolicyRule) error {
 
 	// 更新规则顺序
 	e.updateRuleOrder()
+	e.ruleChanged(rule.ID)
 
 	return nil
 }
@@ -65,6 +75,7 @@ func (e *Engine) UpdateRule(rule *controller.PolicyRule) error {
 
 	rule.UpdatedAt = time.Now()
 	e.rules[rule.ID] = rule
+	e.ruleChanged(rule.ID)
 
 	return nil
 }
@@ -80,6 +91,7 @@ func (e *Engine) DeleteRule(id uint32) error {
 
 	delete(e.rules, id)
 	e.updateRuleOrder()
+	e.ruleChanged(id)
 
 	return nil
 }
@@ -121,6 +133,54 @@ func (e *Engine) updateRuleOrder() {
 	})
 }
 
+// ruleChanged 记录规则变更并通知订阅者，调用方持有写锁
+func (e *Engine) ruleChanged(id uint32) {
+	e.version++
+	if _, ok := e.rules[id]; ok {
+		e.ruleVersions[id] = e.version
+	} else {
+		delete(e.ruleVersions, id)
+	}
+
+	for ch := range e.watchers {
+		select {
+		case ch <- struct{}{}:
+		default:
+		}
+	}
+}
+
+// Watch 订阅规则变更
+// ch 应有缓冲，未及时处理的多次变更合并为一次通知
+func (e *Engine) Watch(ch chan struct{}) {
+	e.mutex.Lock()
+	defer e.mutex.Unlock()
+	e.watchers[ch] = struct{}{}
+}
+
+// Unwatch 取消订阅
+func (e *Engine) Unwatch(ch chan struct{}) {
+	e.mutex.Lock()
+	defer e.mutex.Unlock()
+	delete(e.watchers, ch)
+}
+
+// Snapshot 获取当前策略版本、按优先级排序的规则及各规则的版本
+func (e *Engine) Snapshot() (uint64, []*controller.PolicyRule, []uint64) {
+	e.mutex.RLock()
+	defer e.mutex.RUnlock()
+
+	rules := make([]*controller.PolicyRule, 0, len(e.ruleOrder))
+	versions := make([]uint64, 0, len(e.ruleOrder))
+	for _, id := range e.ruleOrder {
+		if rule, ok := e.rules[id]; ok {
+			rules = append(rules, rule)
+			versions = append(versions, e.ruleVersions[id])
+		}
+	}
+	return e.version, rules, versions
+}
+
 // SetGroupMode 设置组策略模式
 func (e *Engine) SetGroupMode(groupName string, mode controller.PolicyMode) {
 	e.mutex.Lock()
@@ -19,9 +19,10 @@ cd api/proto
 cd "$PROJECT_ROOT"
 
 echo "2. 构建DP层..."
-cd internal/dp
+cd ../dp
 make clean
-make
+make MSEG_ONLY=1
+cp dp "$PROJECT_ROOT/bin/"
 cd "$PROJECT_ROOT"
 echo "✓ DP层构建完成: bin/dp"
 
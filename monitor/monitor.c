@@ -14,6 +14,9 @@
 #include <sys/time.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "../dp/utils/lat_hist.h"
 
 #define DEBUG_FILE "/var/log/ranger/monitor.log"
 
@@ -89,8 +92,14 @@
 
 #define ENV_THRT_SSL_TLS_1DOT0  "THRT_SSL_TLS_1DOT0"
 #define ENV_THRT_SSL_TLS_1DOT1  "THRT_SSL_TLS_1DOT1"
+#define ENV_DP_RESUME_SESSIONS  "ENF_DP_RESUME_SESSIONS"
+#define ENV_DP_SOFT_WATCHDOG    "ENF_DP_SOFT_WATCHDOG"
+#define ENV_DP_STALL_BACKTRACE  "ENF_DP_STALL_BACKTRACE"
+// Run one dp per numa node. The monitor sets it to the number of instances for the agent.
+#define ENV_DP_NUMA_INSTANCES   "ENF_DP_NUMA_INSTANCES"
 
 #define DP_MISS_HB_MAX 60
+#define DP_STALL_HB    5        // misses before the stage of a thread is logged
 #define PROC_EXIT_LIMIT  10
 
 enum {
@@ -100,7 +109,8 @@ enum {
     PROC_AGENT,
     PROC_SCANNER_STANDALONE,
     PROC_CTRL_OPA,
-    PROC_MAX,
+    PROC_DP_NUMA,   // dp instances 1 to DP_NUMA_MAX - 1, PROC_DP is instance 0
+    PROC_MAX = PROC_DP_NUMA + DP_NUMA_MAX - 1,
 };
 
 enum {
@@ -142,10 +152,16 @@ static proc_info_t g_procs[PROC_MAX] = {
 [PROC_AGENT] = {"agent", "/usr/local/bin/agent", },
 [PROC_SCANNER_STANDALONE] = {"scanner", "/usr/local/bin/scanner", },
 [PROC_CTRL_OPA] = {"opa", "/usr/local/bin/opa", },
+[PROC_DP_NUMA] = {"dp1", "/usr/local/bin/dp", },
+[PROC_DP_NUMA + 1] = {"dp2", "/usr/local/bin/dp", },
+[PROC_DP_NUMA + 2] = {"dp3", "/usr/local/bin/dp", },
 };
 
-static uint32_t g_dp_last_hb[MAX_DP_THREADS], g_dp_miss_hb[MAX_DP_THREADS];
-static dp_mnt_shm_t *g_shm;
+static int g_dp_instances = 1;
+static uint32_t g_dp_last_hb[DP_NUMA_MAX][MAX_DP_THREADS], g_dp_miss_hb[DP_NUMA_MAX][MAX_DP_THREADS];
+static int g_dp_soft_watchdog = 0;
+static int g_dp_stall_backtrace = 0;
+static dp_mnt_shm_t *g_shm[DP_NUMA_MAX];
 static int g_mode = MODE_CTRL;
 static int g_pipe_driver = RC_CONFIG_TC;
 static volatile sig_atomic_t g_exit_signal = 0;
@@ -188,12 +204,65 @@ static void debug(const char *fmt, ...)
     fflush(logfp);
 }
 
-static void *create_shm(size_t size)
+// Process of the dp instance
+static int dp_proc(int n)
+{
+    return n == 0 ? PROC_DP : PROC_DP_NUMA + n - 1;
+}
+
+// Instance of the dp process, -1 if the process is not dp
+static int dp_instance(int i)
+{
+    if (i == PROC_DP) {
+        return 0;
+    }
+    return i >= PROC_DP_NUMA && i < PROC_MAX ? i - PROC_DP_NUMA + 1 : -1;
+}
+
+static void set_dp_active(int active)
+{
+    int n;
+
+    for (n = 0; n < g_dp_instances; n ++) {
+        g_procs[dp_proc(n)].active = active;
+    }
+}
+
+// Numa nodes with cpus, numbered from 0
+static int count_numa_nodes(void)
 {
+    char path[64], list[16];
+    int n;
+
+    for (n = 0; n < DP_NUMA_MAX; n ++) {
+        FILE *fp;
+        int cpus = 0;
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+        if ((fp = fopen(path, "r")) != NULL) {
+            cpus = fgets(list, sizeof(list), fp) != NULL && isdigit(list[0]);
+            fclose(fp);
+        }
+        if (!cpus) {
+            break;
+        }
+    }
+    return max(n, 1);
+}
+
+// Same as dp_instance_name() of dp
+static void *create_shm(int n, size_t size)
+{
+    char name[64];
     int fd;
     void *ptr;
 
-    fd = shm_open(DP_MNT_SHM_NAME, O_CREAT | O_RDWR | O_TRUNC, S_IRWXU | S_IRWXG);
+    if (g_dp_instances > 1) {
+        snprintf(name, sizeof(name), "%s.%d", DP_MNT_SHM_NAME, n);
+    } else {
+        snprintf(name, sizeof(name), "%s", DP_MNT_SHM_NAME);
+    }
+    fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, S_IRWXU | S_IRWXG);
     if (fd < 0) {
         return NULL;
     }
@@ -248,15 +317,21 @@ static pid_t fork_exec(int i)
     char *telemetry_neuvector_ep, *telemetry_current_ver, *telemetry_freq, *csp_env, *csp_pause_interval;
     char *custom_check_control, *log_level, *key_rotation_period, *check_key_rotation_period;
     char *max_scanner_tasks, *max_concurrent_repo_scan_tasks, *scanner_lb_max, *scan_job_queue_capacity, *scan_job_fail_retry_max, *repo_scan_long_poll_timeout, *stale_scan_job_cleanup_interval_hour;
+    char instance[16];
     int a;
 
-    switch (i) {
+    switch (dp_instance(i) >= 0 ? PROC_DP : i) {
     case PROC_DP:
         // TODO: Here we set dp thread number to 1
         args[0] = g_procs[i].path;
         a = 1;
         args[a ++] = "-n";
         args[a ++] = "1";
+        if (g_dp_instances > 1) {
+            snprintf(instance, sizeof(instance), "%d/%d", dp_instance(i), g_dp_instances);
+            args[a ++] = "-N";
+            args[a ++] = instance;
+        }
         if ((iface = getenv(ENV_TAP_INTERFACE)) != NULL) {
             args[a ++] = "-i";
             args[a ++] = iface;
@@ -276,6 +351,11 @@ static pid_t fork_exec(int i)
                 args[a ++] = "thrt_tls_1dot1";
             }
         }
+        if ((enable = getenv(ENV_DP_RESUME_SESSIONS)) != NULL) {
+            if (checkImplicitEnableFlag(enable) == 1) {
+                args[a ++] = "-R";
+            }
+        }
         args[a] = NULL;
         break;
     case PROC_SCANNER:
@@ -774,9 +854,13 @@ static void wait_consul_exist()
 
 static void stop_related_proc(int cause)
 {
+    int n;
+
     switch (cause) {
     case PROC_AGENT:
-        stop_proc(PROC_DP, SIGTERM, false);
+        for (n = 0; n < g_dp_instances; n ++) {
+            stop_proc(dp_proc(n), SIGTERM, false);
+        }
         if (g_mode == MODE_AGENT) {
             wait_consul_exist();
         }
@@ -800,11 +884,11 @@ static void exit_handler(int sig)
 
 static int exit_monitor(void)
 {
-    int ret = 0;
+    int ret = 0, n;
 
     g_procs[PROC_CTRL].active = false;
     g_procs[PROC_SCANNER].active = false;
-    g_procs[PROC_DP].active = false;
+    set_dp_active(false);
     g_procs[PROC_AGENT].active = false;
     g_procs[PROC_SCANNER_STANDALONE].active = false;
 
@@ -819,12 +903,16 @@ static int exit_monitor(void)
         break;
     case MODE_AGENT:
         stop_proc(PROC_AGENT, SIGTERM, true);
-        stop_proc(PROC_DP, SIGTERM, false);
+        for (n = 0; n < g_dp_instances; n ++) {
+            stop_proc(dp_proc(n), SIGTERM, false);
+        }
         ret = system(SCRIPT_TEARDOWN);
         break;
     case MODE_CTRL_AGENT:
         stop_proc(PROC_AGENT, SIGTERM, true);
-        stop_proc(PROC_DP, SIGTERM, false);
+        for (n = 0; n < g_dp_instances; n ++) {
+            stop_proc(dp_proc(n), SIGTERM, false);
+        }
         stop_proc(PROC_CTRL, SIGTERM, true);
         // disable scanner in controller
         // stop_proc(PROC_SCANNER, SIGTERM, true);
@@ -837,7 +925,9 @@ static int exit_monitor(void)
 
     debug("Clean up.\n");
 
-    munmap(g_shm, sizeof(dp_mnt_shm_t));
+    for (n = 0; n < g_dp_instances; n ++) {
+        munmap(g_shm[n], sizeof(dp_mnt_shm_t));
+    }
     return ret;
 }
 
@@ -883,47 +973,137 @@ static void proc_exit_handler(int signal)
 
 static void dp_stop_handler(int signal)
 {
-    g_procs[PROC_DP].active = false;
+    set_dp_active(false);
 }
 
 static void dp_start_handler(int signal)
 {
-    g_procs[PROC_DP].active = true;
+    set_dp_active(true);
 }
 
-static void check_heartbeat(void)
+static const char *dp_stage_names[] = {
+    [DP_STAGE_IDLE]   = "idle",
+    [DP_STAGE_PACKET] = "packet",
+    [DP_STAGE_PARSER] = "parser",
+    [DP_STAGE_DETECT] = "detect",
+    [DP_STAGE_TIMER]  = "timer",
+    [DP_STAGE_CTRL]   = "ctrl",
+};
+
+// Thread i of dp instance n in the logs
+static const char *dp_thread_label(int n, int i)
+{
+    static char label[16];
+
+    if (g_dp_instances > 1) {
+        snprintf(label, sizeof(label), "dp%d.%d", n, i);
+    } else {
+        snprintf(label, sizeof(label), "dp%d", i);
+    }
+    return label;
+}
+
+static void dump_dp_stage(int n, int i)
+{
+    dp_mnt_stage_t st = g_shm[n]->dp_stage[i];
+    uint64_t ms = 0;
+
+    if (st.stage != DP_STAGE_IDLE && g_shm[n]->tsc_hz != 0) {
+        ms = (tsc_read() - st.since) * 1000 / g_shm[n]->tsc_hz;
+    }
+    debug("%s tid=%d stage=%s parser=%u session=%u ep=%02x:%02x:%02x:%02x:%02x:%02x "
+          "since=%" PRIu64 " for %" PRIu64 "ms quarantined=%u\n",
+          dp_thread_label(n, i), st.tid,
+          st.stage < sizeof(dp_stage_names) / sizeof(dp_stage_names[0]) ? dp_stage_names[st.stage] : "?",
+          st.stage == DP_STAGE_PARSER ? st.parser : 0, st.sess_id,
+          st.ep_mac[0], st.ep_mac[1], st.ep_mac[2], st.ep_mac[3], st.ep_mac[4], st.ep_mac[5],
+          st.since, ms, st.quarantined);
+}
+
+// The thread writes its backtrace to DP_STALL_FILE
+static void dump_dp_backtrace(int n, int i)
+{
+    int tid = g_shm[n]->dp_stage[i].tid;
+    pid_t pid = g_procs[dp_proc(n)].pid;
+
+    if (pid <= 0 || tid <= 0) {
+        return;
+    }
+    if (syscall(SYS_tgkill, pid, tid, DP_SIG_STALL_DUMP) == 0) {
+        usleep(200000);
+        debug("%s backtrace in %s\n", dp_thread_label(n, i), DP_STALL_FILE);
+    }
+}
+
+// Soft watchdog: ask a thread stuck on a packet to stop inspecting its session
+static void quarantine_dp_stage(int n, int i)
 {
+    dp_mnt_stage_t *st = &g_shm[n]->dp_stage[i];
+    uint32_t stage = st->stage, sess_id = st->sess_id;
+
+    if ((stage == DP_STAGE_PACKET || stage == DP_STAGE_PARSER || stage == DP_STAGE_DETECT) && sess_id != 0) {
+        debug("%s quarantine session=%u\n", dp_thread_label(n, i), sess_id);
+        st->quarantine = sess_id;
+    }
+}
+
+static void check_dp_heartbeat(int n)
+{
+    dp_mnt_shm_t *shm = g_shm[n];
+    uint32_t *last_hb = g_dp_last_hb[n], *miss_hb = g_dp_miss_hb[n];
     int i;
 
-    if (!g_procs[PROC_DP].active) {
+    if (!g_procs[dp_proc(n)].active) {
         return;
     }
 
     for (i = 0; i < MAX_DP_THREADS; i ++) {
-        if (!g_shm->dp_active[i]) {
+        if (!shm->dp_active[i]) {
             continue;
         }
 
-        if (g_shm->dp_hb[i] != g_dp_last_hb[i]) {
-           g_dp_last_hb[i] = g_shm->dp_hb[i];
-           g_dp_miss_hb[i] = 0;
+        if (shm->dp_hb[i] != last_hb[i]) {
+           if (miss_hb[i] >= DP_STALL_HB) {
+               debug("%s heartbeat back after %u misses\n", dp_thread_label(n, i), miss_hb[i]);
+           }
+           last_hb[i] = shm->dp_hb[i];
+           miss_hb[i] = 0;
            continue;
         }
 
-        g_dp_miss_hb[i] ++;
+        miss_hb[i] ++;
         // Suppress log for timer drifting. Only print when count is large than 1.
-        if (g_dp_miss_hb[i] > 1) {
-            debug("dp%d heartbeat miss count=%u hb=%u\n", i, g_dp_miss_hb[i], g_dp_last_hb[i]);
+        if (miss_hb[i] > 1) {
+            debug("%s heartbeat miss count=%u hb=%u\n", dp_thread_label(n, i), miss_hb[i], last_hb[i]);
+        }
+        if (miss_hb[i] == DP_STALL_HB) {
+            dump_dp_stage(n, i);
+            if (g_dp_soft_watchdog) {
+                quarantine_dp_stage(n, i);
+            }
         }
-        if (g_dp_miss_hb[i] > DP_MISS_HB_MAX) {
-            debug("kill dp for heartbeat miss.\n");
-            stop_proc(PROC_DP, SIGSEGV, false);
+        if (miss_hb[i] > DP_MISS_HB_MAX) {
+            dump_dp_stage(n, i);
+            if (g_dp_stall_backtrace) {
+                dump_dp_backtrace(n, i);
+            }
+            debug("kill %s for heartbeat miss.\n", g_procs[dp_proc(n)].name);
+            stop_proc(dp_proc(n), SIGSEGV, false);
 
-            g_dp_miss_hb[i] = 0;
+            miss_hb[i] = 0;
         }
     }
 }
 
+static void check_heartbeat(void)
+{
+    int n;
+
+    for (n = 0; n < g_dp_instances; n ++) {
+        check_dp_heartbeat(n);
+    }
+}
+
 static void help(const char *prog)
 {
     printf("%s:\n", prog);
@@ -936,7 +1116,7 @@ static void help(const char *prog)
 
 int main (int argc, char **argv)
 {
-    int i, ret;
+    int i, n, ret;
     struct timeval tmo;
     fd_set read_fds;
 
@@ -974,18 +1154,31 @@ int main (int argc, char **argv)
     signal(40, dp_stop_handler);
     signal(41, dp_start_handler);
 
-    g_shm = create_shm(sizeof(dp_mnt_shm_t));
-    if (g_shm == NULL) {
-        debug("Unable to create shared memory. Exit!\n");
-        return -1;
-    }
+    g_dp_soft_watchdog = checkImplicitEnableFlag(getenv(ENV_DP_SOFT_WATCHDOG));
+    g_dp_stall_backtrace = checkImplicitEnableFlag(getenv(ENV_DP_STALL_BACKTRACE));
 
-    debug("%s starts, pid=%d\n", argv[0], getpid());
+    if ((g_mode == MODE_AGENT || g_mode == MODE_CTRL_AGENT) &&
+        checkImplicitEnableFlag(getenv(ENV_DP_NUMA_INSTANCES)) == 1) {
+        char count[16];
 
-    for (i = 0; i < MAX_DP_THREADS; i ++) {
-        g_dp_last_hb[i] = g_dp_miss_hb[i] = g_shm->dp_hb[i] = 0;
+        g_dp_instances = count_numa_nodes();
+        snprintf(count, sizeof(count), "%d", g_dp_instances);
+        setenv(ENV_DP_NUMA_INSTANCES, count, 1);
     }
 
+    for (n = 0; n < g_dp_instances; n ++) {
+        g_shm[n] = create_shm(n, sizeof(dp_mnt_shm_t));
+        if (g_shm[n] == NULL) {
+            debug("Unable to create shared memory. Exit!\n");
+            return -1;
+        }
+        for (i = 0; i < MAX_DP_THREADS; i ++) {
+            g_dp_last_hb[n][i] = g_dp_miss_hb[n][i] = g_shm[n]->dp_hb[i] = 0;
+        }
+    }
+
+    debug("%s starts, pid=%d dp instances=%d\n", argv[0], getpid(), g_dp_instances);
+
     switch (g_mode) {
     case MODE_CTRL:
         g_procs[PROC_CTRL].active = true;
@@ -1002,7 +1195,7 @@ int main (int argc, char **argv)
             debug("WARNING: sysctl failed to load /etc/sysctl.conf (including net.core.somaxconn and net.unix.max_dgram_qlen)."
                   "It might have a performance implication on the system. rc = %d.\n", ret);
         }
-        g_procs[PROC_DP].active = true;
+        set_dp_active(true);
         g_procs[PROC_AGENT].active = true;
 
         ret = WEXITSTATUS(system(SCRIPT_CONFIG));
@@ -1022,7 +1215,7 @@ int main (int argc, char **argv)
         g_procs[PROC_CTRL].active = true;
         // disable scanner in controller
         // g_procs[PROC_SCANNER].active = true;
-        g_procs[PROC_DP].active = true;
+        set_dp_active(true);
         g_procs[PROC_AGENT].active = true;
 
         if (access(g_procs[PROC_CTRL].path, F_OK) == 0) {
@@ -1059,7 +1252,7 @@ int main (int argc, char **argv)
 
                     g_procs[i].pid = 0;
 
-                    switch (i) {
+                    switch (dp_instance(i) >= 0 ? PROC_DP : i) {
                     case PROC_CTRL:
                     case PROC_AGENT:
                     case PROC_DP:
@@ -1,6 +1,7 @@
 package share
 
 import (
+	"encoding/json"
 	"fmt"
 	"net"
 	"strconv"
@@ -1373,6 +1374,23 @@ type CLUSGroupIPPolicyVer struct {
 	RulesLen             int    `json:"rules_len"`
 	WorkloadSlot         int    `json:"workload_slot,omitempty"`
 	WorkloadLen          int    `json:"workload_len,omitempty"`
+	DeltaFrom            string `json:"delta_from,omitempty"`
+}
+
+// Key of the node rules delta, in the node rules of a version
+const PolicyIPRulesDeltaSlot string = "delta"
+
+// Node rules of a version built from the node rules of version Base. Each segment takes
+// Len rules from position Old of the base rules, or the next Len rules of Adds if Old is -1.
+type CLUSGroupIPPolicyDelta struct {
+	Base string               `json:"base"`
+	Segs []CLUSPolicyDeltaSeg `json:"segs"`
+	Adds []json.RawMessage    `json:"adds"`
+}
+
+type CLUSPolicyDeltaSeg struct {
+	Old int `json:"old"`
+	Len int `json:"len"`
 }
 
 type CLUSDlpRuleVer struct {
@@ -1490,6 +1508,7 @@ const (
 	CLUSEvDEKSeedUnavailable         // dekSeed unavailable (most likely because of RBAC neuvector-binding-secret-controller)
 	CLUSEvReEncryptWithDEK           // re-encrypt sensitive data in backup files with variant DEK
 	CLUSEvEncryptionSecretSet        // neuvector-store-secret secret is set
+	CLUSEvAgentDPOverload            // a dp thread enters or leaves the overload mode
 )
 
 const (
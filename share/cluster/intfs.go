@@ -861,6 +861,7 @@ func applyImpl(entries []transactEntry) (bool, error) {
 func (t *ClusterTransact) Apply() (bool, error) {
 	log.Debug("Transact")
 
+	t.coalesce()
 	if len(t.entries) == 0 {
 		return true, nil
 	}
@@ -909,6 +910,43 @@ func (t *ClusterTransact) Apply() (bool, error) {
 	return ok, err
 }
 
+// A key that is put or deleted again later in the transaction is only written the last time,
+// so that watchers are notified once for it. Keys written or checked by revision are kept as is.
+func (t *ClusterTransact) coalesce() {
+	if len(t.entries) < 2 {
+		return
+	}
+
+	last := make(map[string]int, len(t.entries))
+	for i, e := range t.entries {
+		switch e.verb {
+		case clusterTransactPut, clusterTransactDelete:
+			if j, ok := last[e.key]; !ok || j >= 0 {
+				last[e.key] = i
+			}
+		case clusterTransactPutRev, clusterTransactDeleteRev, clusterTransactCheckRev:
+			last[e.key] = -1
+		}
+	}
+	if len(last) == len(t.entries) {
+		return
+	}
+
+	entries := t.entries[:0]
+	for i, e := range t.entries {
+		if e.verb == clusterTransactPut || e.verb == clusterTransactDelete {
+			if j := last[e.key]; j >= 0 && j != i {
+				continue
+			}
+		}
+		entries = append(entries, e)
+	}
+	for i := len(entries); i < len(t.entries); i++ {
+		t.entries[i] = transactEntry{}
+	}
+	t.entries = entries
+}
+
 func (t *ClusterTransact) HasData() bool {
 	return len(t.entries) > 0
 }
@@ -228,16 +228,17 @@ func (m *CLUSBoolean) GetValue() bool {
 }
 
 type CLUSMetry struct {
-	CPU           float64 `protobuf:"fixed64,1,opt,name=CPU" json:"CPU,omitempty"`
-	Memory        uint64  `protobuf:"varint,2,opt,name=Memory" json:"Memory,omitempty"`
-	SessionIn     uint32  `protobuf:"varint,3,opt,name=SessionIn" json:"SessionIn,omitempty"`
-	SessionOut    uint32  `protobuf:"varint,4,opt,name=SessionOut" json:"SessionOut,omitempty"`
-	SessionCurIn  uint32  `protobuf:"varint,5,opt,name=SessionCurIn" json:"SessionCurIn,omitempty"`
-	SessionCurOut uint32  `protobuf:"varint,6,opt,name=SessionCurOut" json:"SessionCurOut,omitempty"`
-	PacketIn      uint64  `protobuf:"varint,7,opt,name=PacketIn" json:"PacketIn,omitempty"`
-	PacketOut     uint64  `protobuf:"varint,8,opt,name=PacketOut" json:"PacketOut,omitempty"`
-	ByteIn        uint64  `protobuf:"varint,9,opt,name=ByteIn" json:"ByteIn,omitempty"`
-	ByteOut       uint64  `protobuf:"varint,10,opt,name=ByteOut" json:"ByteOut,omitempty"`
+	CPU             float64 `protobuf:"fixed64,1,opt,name=CPU" json:"CPU,omitempty"`
+	Memory          uint64  `protobuf:"varint,2,opt,name=Memory" json:"Memory,omitempty"`
+	SessionIn       uint32  `protobuf:"varint,3,opt,name=SessionIn" json:"SessionIn,omitempty"`
+	SessionOut      uint32  `protobuf:"varint,4,opt,name=SessionOut" json:"SessionOut,omitempty"`
+	SessionCurIn    uint32  `protobuf:"varint,5,opt,name=SessionCurIn" json:"SessionCurIn,omitempty"`
+	SessionCurOut   uint32  `protobuf:"varint,6,opt,name=SessionCurOut" json:"SessionCurOut,omitempty"`
+	PacketIn        uint64  `protobuf:"varint,7,opt,name=PacketIn" json:"PacketIn,omitempty"`
+	PacketOut       uint64  `protobuf:"varint,8,opt,name=PacketOut" json:"PacketOut,omitempty"`
+	ByteIn          uint64  `protobuf:"varint,9,opt,name=ByteIn" json:"ByteIn,omitempty"`
+	ByteOut         uint64  `protobuf:"varint,10,opt,name=ByteOut" json:"ByteOut,omitempty"`
+	DatapathCPUTime uint64  `protobuf:"varint,11,opt,name=DatapathCPUTime" json:"DatapathCPUTime,omitempty"`
 }
 
 func (m *CLUSMetry) Reset()                    { *m = CLUSMetry{} }
@@ -315,6 +316,13 @@ func (m *CLUSMetry) GetByteOut() uint64 {
 	return 0
 }
 
+func (m *CLUSMetry) GetDatapathCPUTime() uint64 {
+	if m != nil {
+		return m.DatapathCPUTime
+	}
+	return 0
+}
+
 type CLUSStats struct {
 	ReadAt   int64      `protobuf:"varint,1,opt,name=ReadAt" json:"ReadAt,omitempty"`
 	Interval uint32     `protobuf:"varint,2,opt,name=Interval" json:"Interval,omitempty"`
@@ -384,34 +392,35 @@ func init() {
 func init() { proto.RegisterFile("common.proto", fileDescriptor0) }
 
 var fileDescriptor0 = []byte{
-	// 455 bytes of a gzipped FileDescriptorProto
-	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x74, 0x53, 0xcd, 0x6e, 0xd3, 0x40,
-	0x10, 0xae, 0xeb, 0x26, 0x4e, 0xa6, 0x49, 0x30, 0x43, 0x55, 0x59, 0x08, 0xa1, 0xc8, 0x40, 0x65,
-	0xf5, 0x10, 0x85, 0x20, 0x7a, 0xa7, 0xe6, 0x62, 0x89, 0x88, 0x68, 0x4d, 0x7b, 0x5f, 0xea, 0x85,
-	0x5a, 0xd8, 0xbb, 0x61, 0xbd, 0x46, 0xca, 0x33, 0xf0, 0x24, 0x3c, 0x17, 0x2f, 0x82, 0x76, 0xfc,
-	0x93, 0xb6, 0x2a, 0xb7, 0xf9, 0x7e, 0xc6, 0x9e, 0xfd, 0x76, 0x16, 0x26, 0x37, 0xaa, 0x2c, 0x95,
-	0x5c, 0x6c, 0xb5, 0x32, 0x0a, 0x07, 0xd5, 0x2d, 0xd7, 0x22, 0x1c, 0x83, 0xc7, 0x36, 0xf1, 0xb5,
-	0xca, 0xb3, 0xf0, 0xb7, 0x03, 0x27, 0xf1, 0xa7, 0xab, 0x74, 0xa3, 0xd5, 0xb7, 0xbc, 0xc8, 0xe5,
-	0x77, 0x26, 0x7e, 0xd6, 0xa2, 0x32, 0xf8, 0x06, 0xdc, 0xb8, 0xcc, 0x02, 0x67, 0xee, 0x44, 0xb3,
-	0xd5, 0xb3, 0x05, 0x35, 0x2e, 0x7a, 0x57, 0x5c, 0x66, 0xcc, 0xea, 0xb8, 0x04, 0x6f, 0x2d, 0xcc,
-	0xad, 0xca, 0xaa, 0xe0, 0x70, 0xee, 0x46, 0xb3, 0xd5, 0xe9, 0x43, 0x6b, 0x23, 0xb3, 0xce, 0x86,
-	0xcf, 0x61, 0xf4, 0xb1, 0xd6, 0xdc, 0xe4, 0x4a, 0x06, 0xee, 0xdc, 0x89, 0xa6, 0xac, 0xc7, 0xe1,
-	0x2b, 0x38, 0xb6, 0xc3, 0x5c, 0x2a, 0x55, 0x08, 0x2e, 0xf1, 0x04, 0x06, 0xd7, 0xbc, 0xa8, 0x05,
-	0x4d, 0x31, 0x62, 0x0d, 0x08, 0xff, 0x1c, 0xc2, 0xd8, 0xba, 0xd6, 0xc2, 0xe8, 0x1d, 0xfa, 0xe0,
-	0xc6, 0x9b, 0x2b, 0x72, 0x38, 0xcc, 0x96, 0x78, 0x0a, 0xc3, 0xb5, 0x28, 0x95, 0xde, 0x05, 0x87,
-	0x73, 0x27, 0x3a, 0x62, 0x2d, 0xc2, 0x17, 0x30, 0x4e, 0x45, 0x55, 0xe5, 0x4a, 0x26, 0xdd, 0x9f,
-	0xf7, 0x04, 0xbe, 0x04, 0x68, 0xc1, 0xe7, 0xda, 0x04, 0x47, 0x24, 0xdf, 0x61, 0x30, 0x84, 0x49,
-	0x8b, 0xe2, 0x5a, 0x27, 0x32, 0x18, 0x90, 0xe3, 0x1e, 0x87, 0xaf, 0x61, 0xba, 0xc7, 0xf6, 0x33,
-	0x43, 0x32, 0xdd, 0x27, 0x6d, 0x00, 0x1b, 0x7e, 0xf3, 0x43, 0x98, 0x44, 0x06, 0x1e, 0x4d, 0xd8,
-	0x63, 0x3b, 0x63, 0x53, 0xdb, 0xee, 0x11, 0x89, 0x7b, 0xc2, 0x9e, 0xec, 0x72, 0x67, 0x44, 0x22,
-	0x83, 0x71, 0x73, 0xb2, 0x06, 0x61, 0x00, 0x9e, 0xad, 0x6c, 0x0f, 0x90, 0xd0, 0xc1, 0xf0, 0xaf,
-	0xd3, 0x64, 0x95, 0x1a, 0x6e, 0x2a, 0xdb, 0xcf, 0x04, 0xcf, 0x3e, 0x18, 0x8a, 0xcb, 0x65, 0x2d,
-	0xb2, 0x13, 0x25, 0xd2, 0x08, 0xfd, 0x8b, 0x17, 0x94, 0xd9, 0x94, 0xf5, 0x18, 0xcf, 0x60, 0xf0,
-	0x45, 0x19, 0x5e, 0x50, 0x62, 0xc7, 0x2b, 0xbf, 0xbd, 0xde, 0xfe, 0x02, 0x58, 0x23, 0x5b, 0x5f,
-	0xba, 0xe5, 0xf2, 0x2d, 0x45, 0xf7, 0xa8, 0x8f, 0x64, 0x8c, 0x60, 0x48, 0xc5, 0x8a, 0x12, 0x7c,
-	0xcc, 0xd8, 0xea, 0x9d, 0xf3, 0x62, 0x49, 0x31, 0xfe, 0xd7, 0x79, 0xb1, 0x3c, 0x7f, 0x0f, 0x93,
-	0xbb, 0x9b, 0x89, 0x08, 0xb3, 0xd4, 0x70, 0x6d, 0x7a, 0xd2, 0x3f, 0xc0, 0xa7, 0x30, 0x4d, 0x8d,
-	0xda, 0xee, 0x29, 0xe7, 0xfc, 0x0c, 0x9e, 0x3c, 0xd8, 0x52, 0xf4, 0x68, 0x9b, 0xfc, 0x03, 0x84,
-	0x6e, 0x89, 0x7c, 0xe7, 0xeb, 0x90, 0x1e, 0xcf, 0xbb, 0x7f, 0x01, 0x00, 0x00, 0xff, 0xff, 0x45,
-	0xad, 0x79, 0xaa, 0x4c, 0x03, 0x00, 0x00,
+	// 467 bytes of a gzipped FileDescriptorProto
+	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x75, 0x53, 0xdb, 0x4e, 0x1b, 0x31,
+	0x10, 0xed, 0x12, 0x92, 0x4d, 0x26, 0x01, 0xd2, 0x01, 0xa1, 0x55, 0x55, 0x55, 0x68, 0xdb, 0xa2,
+	0x88, 0x87, 0x28, 0x4d, 0x05, 0xef, 0x10, 0x5e, 0x90, 0x40, 0x44, 0x0e, 0xf0, 0xee, 0x12, 0xb7,
+	0x59, 0x35, 0xbb, 0x4e, 0xbd, 0x5e, 0xa4, 0x7c, 0x03, 0x9f, 0xd7, 0x4f, 0xe0, 0x47, 0x18, 0xcf,
+	0x5e, 0x02, 0x11, 0xbc, 0xcd, 0x99, 0x73, 0x66, 0x3c, 0x3e, 0x1e, 0x43, 0xe7, 0x5e, 0xc7, 0xb1,
+	0x4e, 0xfa, 0x0b, 0xa3, 0xad, 0xc6, 0x7a, 0x3a, 0x93, 0x46, 0x85, 0x2d, 0xf0, 0xc5, 0x78, 0x74,
+	0xa7, 0xa3, 0x69, 0xf8, 0xe8, 0xc1, 0xde, 0xe8, 0xf2, 0x76, 0x32, 0x36, 0xfa, 0x77, 0x34, 0x8f,
+	0x92, 0x3f, 0x42, 0xfd, 0xcb, 0x54, 0x6a, 0xf1, 0x3b, 0xd4, 0x46, 0xf1, 0x34, 0xf0, 0x0e, 0xbc,
+	0xde, 0xf6, 0x70, 0xb7, 0xcf, 0x85, 0xfd, 0x4a, 0x45, 0x94, 0x70, 0x3c, 0x0e, 0xc0, 0xbf, 0x52,
+	0x76, 0xa6, 0xa7, 0x69, 0xb0, 0x71, 0x50, 0x23, 0xe9, 0xfe, 0xba, 0x34, 0xa7, 0x45, 0x29, 0xc3,
+	0x4f, 0xd0, 0x3c, 0xcf, 0x8c, 0xb4, 0x91, 0x4e, 0x82, 0x1a, 0x75, 0xdf, 0x12, 0x15, 0x0e, 0xbf,
+	0x42, 0xdb, 0x0d, 0x73, 0xa6, 0xf5, 0x5c, 0xc9, 0x04, 0xf7, 0xa0, 0x7e, 0x27, 0xe7, 0x99, 0xe2,
+	0x29, 0x9a, 0x22, 0x07, 0xe1, 0xff, 0x0d, 0x68, 0x39, 0x15, 0x35, 0x34, 0x4b, 0xec, 0xd2, 0x9c,
+	0xe3, 0x5b, 0x56, 0x78, 0xc2, 0x85, 0xb8, 0x0f, 0x8d, 0x2b, 0x15, 0x6b, 0xb3, 0xa4, 0x89, 0xbc,
+	0xde, 0xa6, 0x28, 0x10, 0x7e, 0x86, 0xd6, 0x44, 0xa5, 0x29, 0x9d, 0x73, 0x51, 0x9e, 0xbc, 0x4a,
+	0xe0, 0x17, 0x80, 0x02, 0x5c, 0x67, 0x36, 0xd8, 0x64, 0xfa, 0x45, 0x06, 0x43, 0xe8, 0x14, 0x68,
+	0x94, 0x19, 0x6a, 0x50, 0x67, 0xc5, 0xab, 0x1c, 0x7e, 0x83, 0xad, 0x15, 0x76, 0x6d, 0x1a, 0x2c,
+	0x7a, 0x9d, 0x74, 0x06, 0x8c, 0xe5, 0xfd, 0x5f, 0x65, 0xa9, 0x8b, 0xcf, 0x13, 0x56, 0xd8, 0xcd,
+	0x98, 0xc7, 0xae, 0xba, 0xc9, 0xe4, 0x2a, 0xe1, 0x6e, 0x76, 0xb6, 0xb4, 0x8a, 0xea, 0x5a, 0xf9,
+	0xcd, 0x72, 0x84, 0x01, 0xf8, 0x2e, 0x72, 0x35, 0xc0, 0x44, 0x09, 0xb1, 0x07, 0x3b, 0xe7, 0xd2,
+	0xca, 0x85, 0xb4, 0x33, 0xb2, 0xe6, 0x26, 0x8a, 0x55, 0xd0, 0x66, 0xc5, 0x7a, 0x3a, 0x7c, 0xf2,
+	0x72, 0x57, 0x27, 0x56, 0xda, 0xd4, 0x9d, 0x24, 0x94, 0x9c, 0x9e, 0x5a, 0x36, 0xb6, 0x26, 0x0a,
+	0xe4, 0x66, 0xbf, 0x48, 0xac, 0x32, 0x0f, 0x72, 0xce, 0xee, 0xd2, 0xe3, 0x95, 0x18, 0x0f, 0xa1,
+	0x7e, 0xa3, 0x2d, 0x11, 0xce, 0xdb, 0xf6, 0xb0, 0x5b, 0x2c, 0x42, 0xf5, 0x54, 0x22, 0xa7, 0x9d,
+	0x6e, 0xb2, 0x90, 0xc9, 0x0f, 0x36, 0xf9, 0x4d, 0x1d, 0xd3, 0x34, 0x7b, 0x83, 0x83, 0x21, 0x7b,
+	0xfd, 0x96, 0xb0, 0xe0, 0x4b, 0xe5, 0xc9, 0x80, 0x0d, 0x7f, 0x57, 0x79, 0x32, 0x38, 0x3a, 0x86,
+	0xce, 0xcb, 0x1d, 0x46, 0x84, 0x6d, 0xba, 0xb0, 0xb1, 0x55, 0xb2, 0xfb, 0x01, 0x3f, 0xd2, 0x2b,
+	0x5a, 0xbd, 0x58, 0xa5, 0xbc, 0xa3, 0x43, 0xd8, 0x59, 0xdb, 0x67, 0xf4, 0x79, 0xef, 0x48, 0x0e,
+	0xe5, 0xba, 0x75, 0xbd, 0x5f, 0x0d, 0xfe, 0x66, 0x3f, 0x9f, 0x01, 0x92, 0xd7, 0x24, 0x7b, 0x76,
+	0x03, 0x00, 0x00,
 }
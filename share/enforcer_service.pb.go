@@ -520,6 +520,11 @@ type CLUSDatapathCounter struct {
 	PS                  []byte   `protobuf:"bytes,36,opt,name=PS,proto3" json:"PS,omitempty"`
 	LimitDropConns      uint64   `protobuf:"varint,37,opt,name=LimitDropConns" json:"LimitDropConns,omitempty"`
 	LimitPassConns      uint64   `protobuf:"varint,38,opt,name=LimitPassConns" json:"LimitPassConns,omitempty"`
+	LatencySamples      []uint64 `protobuf:"varint,39,rep,packed,name=LatencySamples" json:"LatencySamples,omitempty"`
+	LatencyP50          []uint64 `protobuf:"varint,40,rep,packed,name=LatencyP50" json:"LatencyP50,omitempty"`
+	LatencyP99          []uint64 `protobuf:"varint,41,rep,packed,name=LatencyP99" json:"LatencyP99,omitempty"`
+	LatencyMax          []uint64 `protobuf:"varint,42,rep,packed,name=LatencyMax" json:"LatencyMax,omitempty"`
+	ParserCPUTime       []uint64 `protobuf:"varint,43,rep,packed,name=ParserCPUTime" json:"ParserCPUTime,omitempty"`
 }
 
 func (m *CLUSDatapathCounter) Reset()                    { *m = CLUSDatapathCounter{} }
@@ -793,6 +798,41 @@ func (m *CLUSDatapathCounter) GetLimitPassConns() uint64 {
 	return 0
 }
 
+func (m *CLUSDatapathCounter) GetLatencySamples() []uint64 {
+	if m != nil {
+		return m.LatencySamples
+	}
+	return nil
+}
+
+func (m *CLUSDatapathCounter) GetLatencyP50() []uint64 {
+	if m != nil {
+		return m.LatencyP50
+	}
+	return nil
+}
+
+func (m *CLUSDatapathCounter) GetLatencyP99() []uint64 {
+	if m != nil {
+		return m.LatencyP99
+	}
+	return nil
+}
+
+func (m *CLUSDatapathCounter) GetLatencyMax() []uint64 {
+	if m != nil {
+		return m.LatencyMax
+	}
+	return nil
+}
+
+func (m *CLUSDatapathCounter) GetParserCPUTime() []uint64 {
+	if m != nil {
+		return m.ParserCPUTime
+	}
+	return nil
+}
+
 type CLUSDerivedPolicyApp struct {
 	App    uint32 `protobuf:"varint,1,opt,name=App" json:"App,omitempty"`
 	Action uint32 `protobuf:"varint,2,opt,name=Action" json:"Action,omitempty"`
@@ -2433,6 +2473,86 @@ func (m *CLUSWlIDArray) GetWlID() []string {
 	return nil
 }
 
+type CLUSPolicyRuleHitReq struct {
+	ResetHits bool `protobuf:"varint,1,opt,name=ResetHits" json:"ResetHits,omitempty"`
+}
+
+func (m *CLUSPolicyRuleHitReq) Reset()                    { *m = CLUSPolicyRuleHitReq{} }
+func (m *CLUSPolicyRuleHitReq) String() string            { return proto.CompactTextString(m) }
+func (*CLUSPolicyRuleHitReq) ProtoMessage()               {}
+func (*CLUSPolicyRuleHitReq) Descriptor() ([]byte, []int) { return fileDescriptor2, []int{44} }
+
+func (m *CLUSPolicyRuleHitReq) GetResetHits() bool {
+	if m != nil {
+		return m.ResetHits
+	}
+	return false
+}
+
+type CLUSPolicyRuleHit struct {
+	ID        uint32 `protobuf:"varint,1,opt,name=ID" json:"ID,omitempty"`
+	Hits      uint64 `protobuf:"varint,2,opt,name=Hits" json:"Hits,omitempty"`
+	LastHitAt uint32 `protobuf:"varint,3,opt,name=LastHitAt" json:"LastHitAt,omitempty"`
+}
+
+func (m *CLUSPolicyRuleHit) Reset()                    { *m = CLUSPolicyRuleHit{} }
+func (m *CLUSPolicyRuleHit) String() string            { return proto.CompactTextString(m) }
+func (*CLUSPolicyRuleHit) ProtoMessage()               {}
+func (*CLUSPolicyRuleHit) Descriptor() ([]byte, []int) { return fileDescriptor2, []int{45} }
+
+func (m *CLUSPolicyRuleHit) GetID() uint32 {
+	if m != nil {
+		return m.ID
+	}
+	return 0
+}
+
+func (m *CLUSPolicyRuleHit) GetHits() uint64 {
+	if m != nil {
+		return m.Hits
+	}
+	return 0
+}
+
+func (m *CLUSPolicyRuleHit) GetLastHitAt() uint32 {
+	if m != nil {
+		return m.LastHitAt
+	}
+	return 0
+}
+
+type CLUSPolicyRuleHitArray struct {
+	Hits     []*CLUSPolicyRuleHit `protobuf:"bytes,1,rep,name=Hits" json:"Hits,omitempty"`
+	Since    uint32               `protobuf:"varint,2,opt,name=Since" json:"Since,omitempty"`
+	Overflow uint64               `protobuf:"varint,3,opt,name=Overflow" json:"Overflow,omitempty"`
+}
+
+func (m *CLUSPolicyRuleHitArray) Reset()                    { *m = CLUSPolicyRuleHitArray{} }
+func (m *CLUSPolicyRuleHitArray) String() string            { return proto.CompactTextString(m) }
+func (*CLUSPolicyRuleHitArray) ProtoMessage()               {}
+func (*CLUSPolicyRuleHitArray) Descriptor() ([]byte, []int) { return fileDescriptor2, []int{46} }
+
+func (m *CLUSPolicyRuleHitArray) GetHits() []*CLUSPolicyRuleHit {
+	if m != nil {
+		return m.Hits
+	}
+	return nil
+}
+
+func (m *CLUSPolicyRuleHitArray) GetSince() uint32 {
+	if m != nil {
+		return m.Since
+	}
+	return 0
+}
+
+func (m *CLUSPolicyRuleHitArray) GetOverflow() uint64 {
+	if m != nil {
+		return m.Overflow
+	}
+	return 0
+}
+
 func init() {
 	proto.RegisterType((*CLUSKick)(nil), "share.CLUSKick")
 	proto.RegisterType((*CLUSFilter)(nil), "share.CLUSFilter")
@@ -2478,6 +2598,9 @@ func init() {
 	proto.RegisterType((*CLUSMeter)(nil), "share.CLUSMeter")
 	proto.RegisterType((*CLUSMeterArray)(nil), "share.CLUSMeterArray")
 	proto.RegisterType((*CLUSWlIDArray)(nil), "share.CLUSWlIDArray")
+	proto.RegisterType((*CLUSPolicyRuleHitReq)(nil), "share.CLUSPolicyRuleHitReq")
+	proto.RegisterType((*CLUSPolicyRuleHit)(nil), "share.CLUSPolicyRuleHit")
+	proto.RegisterType((*CLUSPolicyRuleHitArray)(nil), "share.CLUSPolicyRuleHitArray")
 	proto.RegisterEnum("share.SnifferCmd", SnifferCmd_name, SnifferCmd_value)
 	proto.RegisterEnum("share.SnifferStatus", SnifferStatus_name, SnifferStatus_value)
 }
@@ -2585,6 +2708,7 @@ type EnforcerServiceClient interface {
 	GetContainerIntercept(ctx context.Context, in *CLUSFilter, opts ...grpc.CallOption) (*CLUSWorkloadIntercept, error)
 	GetMeterList(ctx context.Context, in *CLUSFilter, opts ...grpc.CallOption) (EnforcerService_GetMeterListClient, error)
 	ProfilingCmd(ctx context.Context, in *CLUSProfilingRequest, opts ...grpc.CallOption) (*RPCVoid, error)
+	GetPolicyRuleHits(ctx context.Context, in *CLUSPolicyRuleHitReq, opts ...grpc.CallOption) (*CLUSPolicyRuleHitArray, error)
 }
 
 type enforcerServiceClient struct {
@@ -2939,6 +3063,15 @@ func (c *enforcerServiceClient) ProfilingCmd(ctx context.Context, in *CLUSProfil
 	return out, nil
 }
 
+func (c *enforcerServiceClient) GetPolicyRuleHits(ctx context.Context, in *CLUSPolicyRuleHitReq, opts ...grpc.CallOption) (*CLUSPolicyRuleHitArray, error) {
+	out := new(CLUSPolicyRuleHitArray)
+	err := grpc.Invoke(ctx, "/share.EnforcerService/GetPolicyRuleHits", in, out, c.cc, opts...)
+	if err != nil {
+		return nil, err
+	}
+	return out, nil
+}
+
 // Server API for EnforcerService service
 
 type EnforcerServiceServer interface {
@@ -2970,6 +3103,7 @@ type EnforcerServiceServer interface {
 	GetContainerIntercept(context.Context, *CLUSFilter) (*CLUSWorkloadIntercept, error)
 	GetMeterList(*CLUSFilter, EnforcerService_GetMeterListServer) error
 	ProfilingCmd(context.Context, *CLUSProfilingRequest) (*RPCVoid, error)
+	GetPolicyRuleHits(context.Context, *CLUSPolicyRuleHitReq) (*CLUSPolicyRuleHitArray, error)
 }
 
 func RegisterEnforcerServiceServer(s *grpc.Server, srv EnforcerServiceServer) {
@@ -3492,6 +3626,24 @@ func _EnforcerService_ProfilingCmd_Handler(srv interface{}, ctx context.Context,
 	return interceptor(ctx, in, info, handler)
 }
 
+func _EnforcerService_GetPolicyRuleHits_Handler(srv interface{}, ctx context.Context, dec func(interface{}) error, interceptor grpc.UnaryServerInterceptor) (interface{}, error) {
+	in := new(CLUSPolicyRuleHitReq)
+	if err := dec(in); err != nil {
+		return nil, err
+	}
+	if interceptor == nil {
+		return srv.(EnforcerServiceServer).GetPolicyRuleHits(ctx, in)
+	}
+	info := &grpc.UnaryServerInfo{
+		Server:     srv,
+		FullMethod: "/share.EnforcerService/GetPolicyRuleHits",
+	}
+	handler := func(ctx context.Context, req interface{}) (interface{}, error) {
+		return srv.(EnforcerServiceServer).GetPolicyRuleHits(ctx, req.(*CLUSPolicyRuleHitReq))
+	}
+	return interceptor(ctx, in, info, handler)
+}
+
 var _EnforcerService_serviceDesc = grpc.ServiceDesc{
 	ServiceName: "share.EnforcerService",
 	HandlerType: (*EnforcerServiceServer)(nil),
@@ -3592,6 +3744,10 @@ var _EnforcerService_serviceDesc = grpc.ServiceDesc{
 			MethodName: "ProfilingCmd",
 			Handler:    _EnforcerService_ProfilingCmd_Handler,
 		},
+		{
+			MethodName: "GetPolicyRuleHits",
+			Handler:    _EnforcerService_GetPolicyRuleHits_Handler,
+		},
 	},
 	Streams: []grpc.StreamDesc{
 		{
@@ -3685,241 +3841,252 @@ var _EnforcerScanService_serviceDesc = grpc.ServiceDesc{
 func init() { proto.RegisterFile("enforcer_service.proto", fileDescriptor2) }
 
 var fileDescriptor2 = []byte{
-	// 3762 bytes of a gzipped FileDescriptorProto
-	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x94, 0x5a, 0x4f, 0x73, 0x1b, 0x39,
-	0x76, 0x5f, 0x92, 0xfa, 0x43, 0x42, 0xa2, 0x24, 0xb7, 0x35, 0x76, 0x9b, 0xf6, 0x78, 0x34, 0x3d,
-	0x3b, 0x1b, 0x65, 0x32, 0xe5, 0xf5, 0x6a, 0xe7, 0xcf, 0xc6, 0xa9, 0x9a, 0x19, 0x8a, 0x94, 0x34,
-	0xac, 0x11, 0x15, 0x1a, 0x94, 0xd7, 0x4e, 0x2a, 0x5b, 0xa9, 0x36, 0x09, 0x4a, 0x5d, 0x22, 0xbb,
-	0x7b, 0xd1, 0xa0, 0x6c, 0xe5, 0x9a, 0x43, 0x3e, 0x42, 0x0e, 0xa9, 0x7c, 0x88, 0xdc, 0x53, 0x39,
-	0xa5, 0x72, 0xc8, 0x07, 0xc8, 0x2d, 0x95, 0x7b, 0x6e, 0xf9, 0x04, 0x49, 0xbd, 0xf7, 0x80, 0x6e,
-	0xa0, 0x49, 0xc9, 0x9b, 0x13, 0xf1, 0x7e, 0x78, 0x78, 0x00, 0x1e, 0x80, 0xf7, 0xaf, 0xc9, 0x1e,
-	0x88, 0x78, 0x92, 0xc8, 0x91, 0x90, 0x7f, 0x9d, 0x09, 0x79, 0x1d, 0x8d, 0xc4, 0xb3, 0x54, 0x26,
-	0x2a, 0xf1, 0x56, 0xb3, 0xcb, 0x50, 0x8a, 0xd6, 0xe6, 0x28, 0x99, 0xcd, 0x92, 0x98, 0xc0, 0x16,
-	0xcb, 0x46, 0xa1, 0x6e, 0x07, 0x2f, 0x58, 0xbd, 0x73, 0xfa, 0x6a, 0xf8, 0x53, 0x34, 0xba, 0xf2,
-	0x1e, 0xb0, 0xb5, 0x8e, 0x92, 0xd3, 0x5e, 0xd7, 0xaf, 0xec, 0x55, 0xf6, 0x1b, 0x5c, 0x53, 0x80,
-	0x73, 0x11, 0x66, 0x49, 0xec, 0x57, 0x09, 0x27, 0x2a, 0x18, 0x33, 0x06, 0x63, 0x8f, 0xa3, 0xa9,
-	0x12, 0xd2, 0x6b, 0xb1, 0xfa, 0xeb, 0x44, 0x5e, 0x4d, 0x93, 0x70, 0xac, 0xc7, 0xe7, 0xb4, 0xb7,
-	0xc5, 0xaa, 0xbd, 0x2e, 0x8e, 0x6e, 0xf2, 0x6a, 0xaf, 0xeb, 0xed, 0xb2, 0xd5, 0xa1, 0x0a, 0xa5,
-	0xf2, 0x6b, 0x08, 0x11, 0x01, 0xe8, 0x69, 0x34, 0x8b, 0x94, 0xbf, 0x42, 0x28, 0x12, 0xc1, 0xff,
-	0xae, 0xb3, 0x0d, 0x98, 0x66, 0x28, 0xb2, 0x2c, 0x4a, 0x62, 0x2d, 0xab, 0x92, 0xcb, 0xb2, 0xe7,
-	0xad, 0x96, 0xe6, 0x7d, 0xc2, 0x1a, 0x47, 0xea, 0x52, 0xc8, 0xf3, 0x9b, 0x54, 0xe8, 0xb9, 0x0a,
-	0xc0, 0xf3, 0xd9, 0x7a, 0x6f, 0x30, 0x00, 0x35, 0xe8, 0x19, 0x0d, 0x09, 0xe3, 0x3a, 0xd3, 0x48,
-	0xc4, 0xaa, 0xdf, 0xee, 0xf8, 0xab, 0x7b, 0x95, 0xfd, 0x4d, 0x5e, 0x00, 0xd0, 0x3b, 0x14, 0xf2,
-	0x5a, 0x48, 0xe8, 0x5d, 0xa3, 0xde, 0x1c, 0x80, 0xf5, 0x10, 0x6b, 0x6f, 0xe0, 0xaf, 0x63, 0x67,
-	0x4e, 0x43, 0x1f, 0x31, 0xf6, 0x06, 0x7e, 0x9d, 0xfa, 0x0c, 0xed, 0x3d, 0x65, 0x8c, 0xf8, 0x06,
-	0x89, 0x54, 0x7e, 0x03, 0x17, 0x64, 0x21, 0xd0, 0x4f, 0xbc, 0xd8, 0xcf, 0xa8, 0xbf, 0x40, 0x40,
-	0x76, 0xaf, 0xd3, 0x1f, 0x74, 0x92, 0xb1, 0xf0, 0x37, 0xb0, 0x37, 0xa7, 0x4d, 0x1f, 0xaa, 0x61,
-	0xb3, 0xe8, 0x43, 0x2d, 0xec, 0xb1, 0x0d, 0x9a, 0x65, 0xa8, 0x42, 0x25, 0xfc, 0x26, 0x76, 0xdb,
-	0x10, 0x70, 0xd0, 0x3c, 0xc4, 0xb1, 0x45, 0x1c, 0x16, 0x64, 0xad, 0xfd, 0x4a, 0x65, 0xfe, 0xb6,
-	0xb3, 0xf6, 0x2b, 0x95, 0x59, 0x6b, 0x87, 0xfe, 0x1d, 0x67, 0xed, 0xd0, 0x9f, 0xaf, 0xe1, 0xf0,
-	0x46, 0x89, 0xcc, 0xbf, 0xb7, 0x57, 0xd9, 0x5f, 0xe1, 0x36, 0x54, 0xac, 0x81, 0x38, 0x3c, 0xe2,
-	0xb0, 0x20, 0xe0, 0x68, 0xa7, 0xe9, 0x34, 0x1a, 0x85, 0x2a, 0x4a, 0x62, 0xff, 0x3e, 0xad, 0xd2,
-	0x82, 0xbc, 0x1d, 0x56, 0x6b, 0x5f, 0x08, 0x7f, 0x17, 0x7b, 0xa0, 0xe9, 0x79, 0x6c, 0xa5, 0x37,
-	0x9e, 0x0a, 0xff, 0x23, 0x84, 0xb0, 0x0d, 0xd8, 0x69, 0x34, 0x11, 0xfe, 0x03, 0xc2, 0xa0, 0x8d,
-	0x37, 0x25, 0xbe, 0x90, 0x22, 0xcb, 0xfc, 0x87, 0x7b, 0x95, 0xfd, 0x3a, 0x37, 0x24, 0xc8, 0x3c,
-	0x0f, 0x53, 0xdf, 0x47, 0x14, 0x9a, 0x80, 0xf4, 0xa3, 0xb1, 0xff, 0x88, 0x90, 0x7e, 0x34, 0x06,
-	0xed, 0x0f, 0x92, 0x69, 0x34, 0xba, 0xe9, 0x8d, 0xfd, 0x16, 0x69, 0xdf, 0xd0, 0x5e, 0xc0, 0x36,
-	0xa9, 0xdd, 0x1e, 0xe1, 0xb2, 0x1f, 0x63, 0xbf, 0x83, 0x79, 0x3f, 0x67, 0x4d, 0x52, 0x45, 0x3b,
-	0x9b, 0xa1, 0x02, 0x9f, 0x20, 0x93, 0x0b, 0x02, 0x17, 0xa9, 0xc3, 0x70, 0x7d, 0x4c, 0x5c, 0x0e,
-	0xe8, 0xfd, 0x82, 0x6d, 0xe5, 0xc3, 0x48, 0x95, 0x4f, 0x51, 0x95, 0x25, 0x14, 0xf8, 0xf2, 0x81,
-	0xc4, 0xf7, 0x09, 0xf1, 0xb9, 0x28, 0xec, 0xed, 0xc7, 0x24, 0x53, 0x7d, 0xb8, 0x75, 0x7b, 0xb8,
-	0xe5, 0x9c, 0x86, 0xf7, 0xfc, 0x66, 0x32, 0xe9, 0x0d, 0xfc, 0x4f, 0xf1, 0xaa, 0x13, 0x01, 0xd6,
-	0xe4, 0xcd, 0x64, 0xd2, 0x4e, 0x53, 0x3f, 0xc0, 0x05, 0x6a, 0x0a, 0x74, 0xfc, 0x66, 0x32, 0xc1,
-	0xcb, 0xfd, 0x19, 0xbd, 0x46, 0x4d, 0x06, 0x87, 0x6c, 0xc7, 0x32, 0x00, 0x6d, 0x29, 0xc3, 0x1b,
-	0xef, 0x19, 0xbc, 0x24, 0xa4, 0x33, 0xbf, 0xb2, 0x57, 0xdb, 0xdf, 0x38, 0xf0, 0x9e, 0xa1, 0xad,
-	0x7b, 0x66, 0xb1, 0xf2, 0x9c, 0x27, 0xf8, 0x8f, 0x0a, 0xf3, 0xac, 0x9e, 0x4e, 0x32, 0x8f, 0xc1,
-	0x68, 0xc1, 0xc5, 0x9b, 0x4b, 0x4b, 0x12, 0x5d, 0xfe, 0x02, 0x42, 0x85, 0xcd, 0xe5, 0x79, 0x67,
-	0x90, 0x33, 0x91, 0x19, 0x2b, 0xa1, 0x9a, 0xef, 0x55, 0xb7, 0xe0, 0xab, 0xe5, 0x7c, 0x16, 0xea,
-	0xed, 0xb3, 0xed, 0xce, 0x5c, 0xc2, 0xeb, 0xcb, 0x19, 0xc9, 0xf8, 0x94, 0x61, 0x3c, 0xf6, 0xb9,
-	0xec, 0x15, 0x7c, 0xab, 0xfa, 0xd8, 0x6d, 0x30, 0xf8, 0x2f, 0xc6, 0xee, 0xc3, 0xc6, 0xba, 0xa1,
-	0x0a, 0xd3, 0x50, 0x5d, 0x9a, 0x9d, 0x3d, 0x61, 0x0d, 0xfe, 0x66, 0x10, 0x8e, 0xae, 0x84, 0xa2,
-	0x7d, 0xad, 0xf0, 0x02, 0x00, 0xd9, 0xfc, 0x4d, 0x57, 0x26, 0xa9, 0xe1, 0xa8, 0x22, 0x87, 0x0b,
-	0x82, 0x8c, 0xf3, 0x5c, 0x46, 0x8d, 0x64, 0x9c, 0xdb, 0x32, 0xce, 0x1d, 0x19, 0x2b, 0x24, 0xc3,
-	0x01, 0xe1, 0x82, 0x1f, 0x49, 0x99, 0x48, 0xc3, 0xb4, 0x8a, 0x4c, 0x0e, 0xe6, 0x7d, 0xc9, 0xee,
-	0x9d, 0x25, 0xc6, 0x68, 0x1b, 0xc6, 0x35, 0x64, 0x5c, 0xec, 0x80, 0x33, 0xeb, 0x0d, 0xae, 0xbf,
-	0x32, 0x7c, 0xeb, 0x64, 0x0a, 0x2c, 0x48, 0x73, 0x7c, 0x63, 0x38, 0xea, 0x39, 0x87, 0x81, 0xc0,
-	0x20, 0x9d, 0x77, 0x06, 0x86, 0xa1, 0x81, 0x0c, 0x16, 0xe2, 0x3d, 0x67, 0xf7, 0xcf, 0x3b, 0x83,
-	0xb3, 0x44, 0xab, 0xd9, 0x30, 0x32, 0x64, 0x5c, 0xd6, 0x05, 0x12, 0x5f, 0x75, 0x73, 0x89, 0x1b,
-	0x24, 0xb1, 0x40, 0x70, 0x4d, 0x9d, 0x7e, 0xce, 0xb0, 0xa9, 0xd7, 0x54, 0x40, 0xa0, 0xa9, 0x3f,
-	0x07, 0xdf, 0x64, 0x58, 0x9a, 0xa4, 0x29, 0x1b, 0x83, 0x13, 0x39, 0x96, 0xe1, 0xc5, 0x4c, 0xc4,
-	0x2a, 0x43, 0x43, 0xbc, 0xc2, 0x0b, 0xc0, 0xfb, 0x82, 0xed, 0x9c, 0x47, 0x33, 0x91, 0xcc, 0x55,
-	0xc1, 0xb4, 0x8d, 0x4c, 0x0b, 0x38, 0x9e, 0x5e, 0xa2, 0xc2, 0x69, 0x7e, 0xbb, 0x76, 0xf4, 0xe9,
-	0xd9, 0x20, 0xac, 0xda, 0xbe, 0xfa, 0xda, 0x30, 0xdb, 0xf7, 0x7e, 0x8f, 0x6d, 0xd8, 0x97, 0x5e,
-	0x1b, 0x66, 0xfb, 0xc6, 0x07, 0x6c, 0xd3, 0xb9, 0xee, 0xf7, 0x69, 0x5f, 0xce, 0x5d, 0x7f, 0xca,
-	0x98, 0x75, 0xd1, 0x77, 0x49, 0x7b, 0x3d, 0xa7, 0x1f, 0x2e, 0x55, 0x5f, 0x28, 0x21, 0x33, 0x34,
-	0xd7, 0x2b, 0xdc, 0x42, 0x60, 0x15, 0x03, 0x99, 0xbc, 0xbf, 0xd1, 0x0c, 0x0f, 0x68, 0x15, 0x16,
-	0x84, 0x2e, 0x7d, 0x2e, 0x75, 0xff, 0x43, 0xd2, 0x5c, 0x0e, 0xc0, 0x1a, 0x3b, 0x73, 0x79, 0x9a,
-	0x5c, 0x74, 0xc2, 0xd1, 0xa5, 0xc8, 0xd0, 0x9e, 0xaf, 0x70, 0x07, 0x83, 0x17, 0x7e, 0x2c, 0x85,
-	0x18, 0x17, 0xba, 0x7d, 0x44, 0x26, 0xd1, 0x45, 0x61, 0xa6, 0x76, 0x96, 0x89, 0xd9, 0xdb, 0xe9,
-	0x4d, 0x86, 0xf6, 0x7e, 0x85, 0x17, 0x40, 0x2e, 0xa5, 0x60, 0x79, 0x6c, 0x49, 0x71, 0xf8, 0x06,
-	0xa1, 0xcc, 0x44, 0x61, 0x9c, 0x9e, 0xec, 0xd5, 0x80, 0xcf, 0x45, 0xe1, 0x1c, 0x09, 0x31, 0xd7,
-	0xe6, 0x63, 0x64, 0x73, 0x41, 0xb8, 0x19, 0xe4, 0x52, 0xc0, 0xe5, 0xff, 0x8a, 0xcf, 0xa7, 0xda,
-	0xf0, 0x37, 0xf9, 0x02, 0xee, 0xf2, 0x1e, 0x10, 0xef, 0x27, 0x65, 0x5e, 0xc2, 0x71, 0x76, 0xc4,
-	0xba, 0xc9, 0x2c, 0x8c, 0xe2, 0x0c, 0x7d, 0x40, 0x93, 0xbb, 0x20, 0xd8, 0x3c, 0x1b, 0xe8, 0x0d,
-	0x32, 0x74, 0x09, 0x4d, 0x5e, 0x86, 0xe1, 0x9c, 0x4f, 0x12, 0x9e, 0xcc, 0x55, 0x14, 0x8b, 0x4c,
-	0x3b, 0x08, 0x0b, 0x41, 0xe7, 0x9c, 0x25, 0x13, 0xf4, 0x10, 0x9b, 0x1c, 0xdb, 0x10, 0x10, 0x0e,
-	0x86, 0xfe, 0xcf, 0x11, 0xa9, 0x0e, 0x86, 0xa0, 0x39, 0x8c, 0x1c, 0xe1, 0x7a, 0x74, 0x92, 0x38,
-	0xce, 0xfc, 0xcf, 0x49, 0xc3, 0x2e, 0x9a, 0xf3, 0x0d, 0xc2, 0x2c, 0x23, 0xbe, 0x5f, 0x58, 0x7c,
-	0x39, 0x1a, 0xbc, 0x61, 0xbb, 0x68, 0x60, 0x85, 0x8c, 0xae, 0xc5, 0x58, 0x7b, 0xe6, 0x14, 0x1d,
-	0x3d, 0x78, 0xb1, 0x8a, 0x0e, 0x27, 0xd2, 0x14, 0x5c, 0x9b, 0x76, 0xe3, 0xe4, 0x23, 0x34, 0x85,
-	0x01, 0xf4, 0x7c, 0x2a, 0x7a, 0x5d, 0xed, 0x13, 0x34, 0x15, 0xfc, 0x4b, 0x95, 0x7d, 0xb4, 0x20,
-	0x1a, 0xfa, 0x16, 0x82, 0x5c, 0x08, 0x98, 0xe5, 0xa8, 0x37, 0x40, 0xc1, 0x9b, 0x9c, 0x08, 0x40,
-	0xbb, 0x19, 0xc4, 0x99, 0x35, 0x42, 0x91, 0x80, 0xd9, 0xb0, 0x9b, 0xa3, 0x41, 0xde, 0xe4, 0x9a,
-	0x02, 0x1c, 0x19, 0xb8, 0x8e, 0x68, 0x35, 0x05, 0x3a, 0x45, 0xaf, 0xbb, 0x46, 0x01, 0x0f, 0x06,
-	0x93, 0xbb, 0x6c, 0x15, 0x7e, 0x39, 0x5a, 0xd7, 0x26, 0x27, 0xc2, 0x0e, 0x98, 0xeb, 0x6e, 0xc0,
-	0x5c, 0xec, 0xbc, 0xe1, 0xec, 0xdc, 0x0a, 0x9c, 0x98, 0x1b, 0x38, 0x79, 0x6c, 0xe5, 0xf8, 0x65,
-	0xf7, 0x0c, 0x2d, 0x65, 0x83, 0x63, 0xdb, 0xfb, 0x25, 0x5b, 0x69, 0xa7, 0x29, 0x18, 0x47, 0x70,
-	0xe8, 0x8f, 0x2d, 0x87, 0x5e, 0x56, 0x3e, 0x47, 0xc6, 0x60, 0xc0, 0x5a, 0x4b, 0xf5, 0x47, 0x31,
-	0xc2, 0x01, 0x5b, 0xa5, 0xdb, 0x4b, 0x01, 0xc2, 0x93, 0xdb, 0xe4, 0x01, 0x13, 0x27, 0xd6, 0xe0,
-	0x3f, 0x2b, 0xcc, 0x5f, 0xca, 0xd0, 0x0f, 0x53, 0xef, 0x98, 0xad, 0xeb, 0xa6, 0x16, 0xf9, 0xe5,
-	0x5d, 0x22, 0xfb, 0x61, 0xfa, 0x4c, 0xff, 0x1e, 0xc5, 0x4a, 0xde, 0x70, 0x33, 0x18, 0x82, 0x26,
-	0x68, 0x42, 0x04, 0xa5, 0x0f, 0x34, 0xa7, 0x5b, 0xbf, 0x63, 0x9b, 0xf6, 0x20, 0xb8, 0x65, 0x57,
-	0xe2, 0x46, 0x67, 0x54, 0xd0, 0xf4, 0xbe, 0x65, 0xab, 0xd7, 0xe1, 0x74, 0x4e, 0x43, 0x37, 0x0e,
-	0x3e, 0xbd, 0x6b, 0x0d, 0xa8, 0x08, 0x4e, 0xfc, 0x2f, 0xaa, 0xbf, 0xa9, 0x04, 0xff, 0x5c, 0xa7,
-	0x60, 0x6a, 0x20, 0x93, 0xb7, 0x62, 0x38, 0x9f, 0xcd, 0x42, 0x79, 0x83, 0xd6, 0x2f, 0x89, 0x55,
-	0x18, 0xc5, 0x42, 0xd2, 0xe6, 0x30, 0x08, 0xb5, 0x31, 0x7c, 0xc3, 0xd1, 0xd8, 0x61, 0xab, 0xea,
-	0x37, 0xec, 0xc2, 0xf0, 0x86, 0x07, 0xd1, 0x78, 0x20, 0x93, 0x11, 0x30, 0xd1, 0x8d, 0xb7, 0x10,
-	0x98, 0xed, 0x4c, 0xbc, 0x03, 0x4a, 0x64, 0x99, 0x30, 0xe1, 0x8f, 0x83, 0x81, 0x5d, 0x39, 0x13,
-	0xef, 0x86, 0xf3, 0x2c, 0x8d, 0x46, 0x80, 0x9a, 0xd8, 0xc7, 0x01, 0x31, 0xe6, 0x32, 0x33, 0x0f,
-	0x55, 0x92, 0x66, 0xfa, 0x0e, 0x97, 0x50, 0xef, 0x0b, 0xb6, 0xf5, 0xfa, 0x74, 0xa8, 0x12, 0x19,
-	0x5e, 0x88, 0xd7, 0xa1, 0x1a, 0x5d, 0xd2, 0xb5, 0x3e, 0xac, 0xfa, 0x15, 0x5e, 0xea, 0x81, 0x9b,
-	0x3c, 0x88, 0xc6, 0x43, 0xa1, 0xf4, 0x15, 0xd7, 0x14, 0xac, 0x5a, 0xdb, 0xdc, 0xf3, 0xf0, 0xed,
-	0x54, 0xe8, 0x7b, 0xee, 0x60, 0xb0, 0x9e, 0x5e, 0x9c, 0xa8, 0x68, 0x72, 0x83, 0xb2, 0x44, 0xa6,
-	0xd3, 0xb4, 0x12, 0x8a, 0xb6, 0x5d, 0x26, 0xa3, 0xc3, 0x69, 0x32, 0xba, 0xe2, 0x49, 0xa2, 0xe3,
-	0x85, 0x26, 0x2f, 0xa1, 0x0e, 0x5f, 0x3f, 0x94, 0x57, 0x99, 0x4e, 0xde, 0x4a, 0x28, 0xc4, 0x4f,
-	0x39, 0x82, 0xb7, 0xa6, 0x13, 0x2b, 0x9d, 0xc8, 0x2d, 0x76, 0x78, 0xcf, 0x98, 0x97, 0x83, 0xdd,
-	0x48, 0xf6, 0x93, 0x18, 0xd8, 0x29, 0xab, 0x5b, 0xd2, 0x03, 0x67, 0x71, 0x1c, 0x4d, 0x45, 0x3f,
-	0x89, 0x8f, 0xae, 0xf3, 0x90, 0xa2, 0xc9, 0x5d, 0xd0, 0xe2, 0x3a, 0x91, 0xc9, 0x3c, 0x35, 0x59,
-	0x9e, 0x0b, 0xa2, 0xf7, 0x23, 0xe0, 0x38, 0xa4, 0x9d, 0xdf, 0xa3, 0x1d, 0xb9, 0x28, 0xec, 0x28,
-	0x47, 0xfa, 0xb1, 0x22, 0x56, 0x8f, 0x76, 0xb4, 0xd0, 0xe1, 0x70, 0xc3, 0xba, 0x51, 0x55, 0xf7,
-	0x4b, 0xdc, 0xa6, 0xc3, 0x5d, 0x03, 0xda, 0x87, 0xdd, 0xf2, 0x1a, 0xd0, 0xb7, 0xd9, 0x7c, 0x83,
-	0x50, 0x5d, 0x66, 0x3a, 0x4d, 0x2c, 0xa1, 0xd6, 0xce, 0x71, 0x92, 0x4c, 0x67, 0x8e, 0x2e, 0x08,
-	0xf7, 0x47, 0x03, 0xbd, 0xf8, 0xf5, 0x98, 0x42, 0x90, 0x26, 0x77, 0x30, 0x6b, 0xc6, 0x5e, 0x4c,
-	0x33, 0xfa, 0xce, 0x8c, 0x1a, 0xb5, 0x66, 0xec, 0xc5, 0x38, 0xe3, 0x23, 0x67, 0x46, 0x02, 0x41,
-	0x2b, 0xfd, 0xf0, 0xfd, 0xd1, 0x75, 0x38, 0xed, 0x5c, 0x86, 0xf1, 0xcb, 0xb9, 0x98, 0x0b, 0x93,
-	0x7f, 0x2e, 0x76, 0x80, 0xcc, 0x7e, 0xf8, 0xfe, 0x24, 0x91, 0xc6, 0xf9, 0x52, 0x26, 0xea, 0x82,
-	0xc1, 0x7f, 0x57, 0x2c, 0xf3, 0xa1, 0x9f, 0x2b, 0x98, 0xa8, 0x41, 0x44, 0x45, 0x9f, 0x55, 0x0e,
-	0x4d, 0x74, 0x29, 0x69, 0x44, 0xf5, 0x98, 0x55, 0x8e, 0x6d, 0xc0, 0xce, 0xc2, 0x19, 0x95, 0x61,
-	0x1a, 0x1c, 0xdb, 0x80, 0xf1, 0x79, 0x34, 0xd6, 0x26, 0x00, 0xdb, 0x80, 0x1d, 0x01, 0x46, 0x2f,
-	0x1e, 0xdb, 0x58, 0x71, 0x19, 0x85, 0x31, 0x04, 0xb1, 0xe6, 0x8d, 0x17, 0x00, 0xf6, 0xaa, 0x50,
-	0x2a, 0xa0, 0x74, 0x3a, 0x50, 0x00, 0x68, 0x6c, 0x45, 0x9a, 0x48, 0x25, 0xc6, 0xfa, 0x49, 0xe7,
-	0x34, 0x06, 0x85, 0xc6, 0x54, 0xe0, 0x8b, 0x6e, 0xf0, 0x02, 0x08, 0xce, 0xc8, 0x3b, 0xdb, 0x7b,
-	0x25, 0xc7, 0xf2, 0x35, 0x6b, 0x14, 0xe6, 0x8b, 0x3c, 0xc1, 0x43, 0xcb, 0x0a, 0xdb, 0x03, 0x78,
-	0xc1, 0x19, 0xc4, 0x94, 0x82, 0x62, 0x77, 0x3e, 0x0b, 0xba, 0x7a, 0x53, 0x31, 0xab, 0xf6, 0xc6,
-	0x46, 0x9b, 0xd5, 0x42, 0x9b, 0x2d, 0x56, 0xef, 0x5c, 0x46, 0xd3, 0xb1, 0x14, 0xb1, 0x5f, 0xdb,
-	0xab, 0xed, 0xaf, 0xf2, 0x9c, 0xa6, 0xda, 0x82, 0x54, 0x19, 0x98, 0xda, 0x15, 0xaa, 0x7e, 0x19,
-	0x3a, 0x38, 0x67, 0x0f, 0x17, 0xe7, 0xa3, 0x1d, 0xfc, 0x29, 0x63, 0x39, 0x62, 0xb6, 0xf0, 0xa8,
-	0xbc, 0x85, 0x9c, 0x83, 0x5b, 0xcc, 0xc1, 0xdf, 0x56, 0x28, 0xe1, 0xd4, 0x97, 0x2d, 0x52, 0x89,
-	0x84, 0x26, 0x9e, 0x79, 0xa8, 0x2e, 0xf5, 0x4e, 0xb0, 0x0d, 0x58, 0x3f, 0xcc, 0xae, 0x74, 0x76,
-	0x89, 0x6d, 0x08, 0x2d, 0x7a, 0x59, 0x37, 0x92, 0x78, 0x11, 0xea, 0x9c, 0x08, 0x08, 0x14, 0x20,
-	0x92, 0x10, 0x23, 0xaa, 0xfe, 0xd5, 0xb9, 0x21, 0x81, 0x1f, 0xe4, 0x43, 0xe6, 0x58, 0xdb, 0x6f,
-	0x70, 0x22, 0x82, 0x53, 0x72, 0xd3, 0xa5, 0x45, 0xd0, 0xe6, 0x9e, 0x9b, 0x11, 0xb4, 0xaf, 0x96,
-	0xb5, 0xaf, 0x12, 0xbf, 0x91, 0xf6, 0x3f, 0xa6, 0x3a, 0x10, 0x47, 0x93, 0x89, 0x90, 0x5c, 0xfc,
-	0x7e, 0x2e, 0x32, 0xe5, 0x7d, 0xc6, 0x6a, 0x9d, 0x19, 0x9d, 0xcd, 0xd6, 0xc1, 0x3d, 0x2d, 0x46,
-	0xf3, 0x74, 0x66, 0x63, 0x0e, 0xbd, 0x56, 0x6d, 0xb3, 0x81, 0xa1, 0xda, 0x53, 0xc6, 0x4c, 0xc6,
-	0xaa, 0x03, 0xbe, 0x06, 0xb7, 0x10, 0xe8, 0x87, 0x49, 0xcf, 0xe6, 0xb3, 0xb7, 0x42, 0xea, 0x9b,
-	0x6f, 0x21, 0xc6, 0x50, 0x0c, 0xa3, 0xbf, 0x11, 0xbd, 0xb8, 0x7f, 0xa8, 0xdf, 0x81, 0x83, 0x81,
-	0x93, 0xa2, 0xaa, 0x2b, 0x3e, 0x86, 0x06, 0xd7, 0x14, 0x84, 0xee, 0xdd, 0xb9, 0xc4, 0x6a, 0x57,
-	0x2f, 0x1e, 0x8a, 0x51, 0x12, 0x8f, 0x75, 0x04, 0xb7, 0x80, 0x07, 0x9f, 0xd3, 0x31, 0xe6, 0x5b,
-	0xce, 0xd2, 0x24, 0xce, 0xec, 0xc8, 0x13, 0xb7, 0x13, 0x7c, 0xcf, 0xee, 0x59, 0x6c, 0x7a, 0x9e,
-	0x12, 0xd3, 0x5d, 0x35, 0xd8, 0xe0, 0xef, 0xaa, 0xba, 0x7e, 0x4b, 0x12, 0x16, 0xc6, 0xfa, 0x6c,
-	0xbd, 0x7d, 0x21, 0x62, 0x95, 0x2b, 0xd1, 0x90, 0x1f, 0xd4, 0xe4, 0x97, 0x6c, 0x6d, 0xa8, 0x42,
-	0x35, 0xa7, 0x10, 0x62, 0xeb, 0x60, 0xd7, 0x3d, 0x21, 0xea, 0xe3, 0x9a, 0x07, 0xee, 0x62, 0x5b,
-	0x5e, 0x50, 0x01, 0xa2, 0xc1, 0xb1, 0x5d, 0x3a, 0x8b, 0xb5, 0x85, 0xb3, 0xf0, 0xd8, 0x0a, 0xe8,
-	0x1c, 0x75, 0x58, 0xe3, 0xd8, 0x76, 0xad, 0x4d, 0x1d, 0x3b, 0x5c, 0x6b, 0x03, 0x31, 0x07, 0x76,
-	0x36, 0xb0, 0x33, 0xa7, 0xf3, 0x3a, 0x16, 0x2d, 0x2f, 0xaf, 0x63, 0x65, 0x44, 0x2f, 0xad, 0x63,
-	0xe9, 0xc3, 0xc9, 0x79, 0x4a, 0xa7, 0xd6, 0x4d, 0xde, 0xc5, 0x56, 0x81, 0xbd, 0x38, 0xb5, 0xcf,
-	0xd9, 0xb6, 0xc5, 0x36, 0x18, 0x85, 0x29, 0xbe, 0xcf, 0x91, 0x0e, 0xee, 0x36, 0x39, 0xb6, 0x83,
-	0x97, 0x24, 0x2d, 0x7f, 0xdd, 0xa7, 0xc9, 0x05, 0x17, 0xbf, 0x5f, 0x30, 0x49, 0x79, 0xb9, 0x9e,
-	0x8c, 0x52, 0xb9, 0x5c, 0x5f, 0xb3, 0xcb, 0xf5, 0x7f, 0xb2, 0x4c, 0x64, 0x86, 0xcc, 0xc9, 0xc5,
-	0x5f, 0xbe, 0xd5, 0xd3, 0x13, 0x11, 0xfc, 0xa3, 0xbe, 0x1b, 0xc6, 0x93, 0x18, 0x1f, 0x51, 0xb1,
-	0x7c, 0x84, 0x65, 0x0f, 0x9b, 0x85, 0x77, 0x01, 0xa8, 0xa6, 0x13, 0x16, 0x83, 0x9d, 0x14, 0x9e,
-	0x04, 0xda, 0x88, 0x0d, 0x0b, 0x4f, 0x02, 0x6d, 0xf4, 0x38, 0xaf, 0xa2, 0xb1, 0x49, 0x76, 0xa0,
-	0x8d, 0x1e, 0x07, 0xb0, 0x75, 0xed, 0x71, 0x34, 0xd6, 0x99, 0x8d, 0x33, 0xbf, 0x8e, 0x46, 0x07,
-	0xdb, 0x38, 0x36, 0x49, 0xa8, 0x36, 0x5f, 0xe7, 0xd8, 0x06, 0xec, 0x55, 0x26, 0x24, 0x06, 0x7a,
-	0x0d, 0x8e, 0x6d, 0x4c, 0xc0, 0xe8, 0x5e, 0x52, 0x72, 0x63, 0x6e, 0xa0, 0xcf, 0xd6, 0x51, 0x73,
-	0x6d, 0x85, 0x71, 0x5c, 0x8d, 0x1b, 0xd2, 0x4a, 0x9f, 0x9a, 0x34, 0x82, 0xa8, 0xa0, 0x9b, 0x7b,
-	0xdb, 0xc2, 0xf9, 0x3c, 0x5f, 0x74, 0x3e, 0x9e, 0x6b, 0xb9, 0xcb, 0x7e, 0xe7, 0x07, 0x32, 0x6e,
-	0x3a, 0x39, 0xe8, 0x4e, 0x53, 0x4c, 0x31, 0x97, 0xe9, 0xfa, 0x96, 0x04, 0x36, 0xf8, 0xa7, 0x2a,
-	0xb9, 0x12, 0x57, 0x04, 0xad, 0x07, 0x6c, 0x7c, 0x32, 0xce, 0xe5, 0x60, 0xe5, 0x17, 0x52, 0x4d,
-	0x31, 0x69, 0x8f, 0x94, 0x91, 0x43, 0x14, 0xbc, 0x8e, 0x76, 0x9a, 0x4e, 0x6f, 0x8c, 0xf9, 0x5f,
-	0xe5, 0x39, 0x0d, 0x63, 0x5e, 0x4f, 0xfb, 0xe1, 0x08, 0x5e, 0x33, 0xe8, 0x5c, 0x53, 0xde, 0xd7,
-	0xac, 0xae, 0xe7, 0x23, 0x17, 0xe0, 0x3a, 0x2a, 0x77, 0x45, 0x3c, 0x67, 0x85, 0x61, 0xaf, 0xc3,
-	0x09, 0x0d, 0x5b, 0xfb, 0xe0, 0x30, 0xc3, 0x0a, 0xbb, 0x91, 0xd1, 0x38, 0xf3, 0xd7, 0xf7, 0x6a,
-	0x70, 0x17, 0xa0, 0x0d, 0xe7, 0xf6, 0x2e, 0x9c, 0x20, 0x5c, 0x47, 0xd8, 0x90, 0x26, 0x91, 0xc3,
-	0xef, 0x2a, 0x14, 0x3e, 0xe4, 0x74, 0xf0, 0xaf, 0x15, 0x27, 0xb9, 0xd7, 0x53, 0x41, 0x02, 0x74,
-	0xca, 0x58, 0x41, 0xdd, 0x9e, 0x49, 0x16, 0x3c, 0xcf, 0x8a, 0x26, 0x65, 0x92, 0xd6, 0xf8, 0xd6,
-	0xef, 0xd8, 0x76, 0xa9, 0x7b, 0x49, 0xce, 0xf8, 0x95, 0x9b, 0x33, 0x3e, 0xbd, 0x75, 0xb6, 0x85,
-	0x84, 0xf1, 0x2f, 0x96, 0x9d, 0x3c, 0x4d, 0xb3, 0xec, 0x06, 0x95, 0xbf, 0xf4, 0x41, 0x7c, 0x12,
-	0x2a, 0x25, 0x24, 0x16, 0xc4, 0x6b, 0x18, 0x9f, 0x68, 0x3a, 0x98, 0xb0, 0x27, 0xb7, 0x88, 0xa6,
-	0x9b, 0x75, 0xcc, 0xb6, 0x2c, 0x30, 0xca, 0xaf, 0xfb, 0xed, 0xab, 0x27, 0xed, 0x94, 0x46, 0x05,
-	0x7f, 0xbc, 0xfc, 0x20, 0x46, 0xf8, 0xa9, 0x26, 0x1c, 0x19, 0x3d, 0xf5, 0xc3, 0x51, 0xf0, 0x57,
-	0x4e, 0x41, 0xa1, 0x60, 0xa5, 0x05, 0x7d, 0xc7, 0x36, 0x0a, 0xe8, 0x8e, 0xb2, 0x42, 0xc1, 0xc4,
-	0xed, 0x01, 0xc1, 0xbf, 0x57, 0xd8, 0x03, 0x3b, 0x4d, 0xd7, 0x4f, 0xf5, 0xb6, 0xd7, 0x68, 0x22,
-	0xaa, 0xaa, 0x15, 0x51, 0x15, 0x2f, 0xb4, 0x66, 0x5b, 0x0a, 0x8c, 0x64, 0xa5, 0x08, 0x95, 0x18,
-	0xb7, 0x95, 0x2e, 0xc4, 0x17, 0x00, 0x9c, 0xc2, 0xab, 0x74, 0x1c, 0x2a, 0xd1, 0x56, 0xba, 0x00,
-	0x9f, 0xd3, 0x30, 0x12, 0x93, 0x33, 0x9c, 0x9e, 0xc2, 0x89, 0x02, 0x80, 0xbb, 0xdf, 0x99, 0x5c,
-	0xe0, 0x05, 0x5f, 0x27, 0xef, 0xac, 0xc9, 0x80, 0xb3, 0xc7, 0xcb, 0xf7, 0x42, 0xba, 0xfa, 0xb5,
-	0x5b, 0x7c, 0xf9, 0x78, 0x49, 0x95, 0xa2, 0x18, 0x62, 0x55, 0x5f, 0xee, 0x5b, 0x1c, 0x18, 0xa2,
-	0x81, 0x76, 0x9e, 0xb0, 0x06, 0x17, 0xa3, 0xb9, 0xcc, 0xa2, 0x6b, 0x52, 0x51, 0x9d, 0x17, 0x80,
-	0x15, 0x0d, 0x55, 0x9d, 0x68, 0xc8, 0xe8, 0xaf, 0x66, 0xe9, 0x6f, 0x97, 0xad, 0x72, 0x71, 0x21,
-	0xde, 0xeb, 0x60, 0x99, 0x08, 0xd0, 0xcf, 0xa1, 0xb8, 0x0c, 0xaf, 0xa3, 0x44, 0xea, 0xf8, 0x20,
-	0xa7, 0x3f, 0xa0, 0x1f, 0x4f, 0x97, 0xac, 0xd6, 0xc9, 0x4f, 0x40, 0xdb, 0xd6, 0x59, 0xdd, 0xd5,
-	0xd9, 0xa9, 0x53, 0x5c, 0x32, 0xdb, 0xcb, 0xa3, 0x56, 0x5b, 0x61, 0xad, 0x45, 0x85, 0x19, 0x7e,
-	0xa3, 0xad, 0x7f, 0xa8, 0xb2, 0x47, 0xd0, 0x9d, 0x87, 0x44, 0xb1, 0x12, 0x72, 0x24, 0x52, 0xfa,
-	0x5e, 0x6c, 0xca, 0x7a, 0x26, 0x1e, 0x37, 0x98, 0xc8, 0xf5, 0x84, 0x6d, 0x7c, 0x04, 0xed, 0x8e,
-	0x2e, 0x21, 0x42, 0x13, 0x74, 0xf4, 0xaa, 0x03, 0x18, 0xd5, 0x0f, 0x89, 0x00, 0xf4, 0xb0, 0x53,
-	0x7c, 0x0f, 0x27, 0x02, 0x74, 0xdf, 0x8b, 0xf3, 0xf2, 0x61, 0x83, 0x6b, 0x0a, 0xf0, 0xa3, 0xf7,
-	0x88, 0xd3, 0xb5, 0xd1, 0x14, 0x7e, 0x06, 0x41, 0x0e, 0xda, 0x2b, 0xe9, 0xc7, 0x86, 0x80, 0x83,
-	0x78, 0x89, 0x83, 0xcc, 0xaa, 0x0d, 0x41, 0xaa, 0x7a, 0xa4, 0xff, 0xee, 0x40, 0x3c, 0xe4, 0x7c,
-	0x5d, 0x30, 0xf8, 0x7b, 0x6d, 0x7f, 0x17, 0xb4, 0xb3, 0x10, 0x81, 0xe2, 0x1e, 0xa6, 0x51, 0x4c,
-	0xd6, 0xb1, 0xce, 0x35, 0x05, 0xd1, 0xe1, 0xcb, 0x79, 0x28, 0xc3, 0x18, 0x72, 0x5f, 0x9d, 0xae,
-	0x58, 0x88, 0xf7, 0x0d, 0x15, 0x49, 0xc9, 0x61, 0x6d, 0x1c, 0xec, 0x59, 0x27, 0xb6, 0xf4, 0x48,
-	0xa8, 0x8c, 0x9a, 0x41, 0x44, 0xdc, 0x00, 0x26, 0xfc, 0xf6, 0x00, 0xb7, 0x05, 0x1b, 0x79, 0xbd,
-	0xd7, 0x90, 0x77, 0xfe, 0xb3, 0xe1, 0x01, 0x5b, 0x83, 0xd3, 0xcb, 0x6b, 0xbf, 0x9a, 0x82, 0x53,
-	0xc2, 0x2f, 0x80, 0xe6, 0x3f, 0x14, 0x48, 0xc0, 0x1d, 0x3e, 0x0d, 0x33, 0x45, 0x3d, 0x14, 0x0e,
-	0x15, 0x40, 0xfe, 0x15, 0x7c, 0xcd, 0xfd, 0x0a, 0x3e, 0x4c, 0xc3, 0xd8, 0xc4, 0x44, 0xd0, 0xc6,
-	0x4f, 0x5c, 0x69, 0x2a, 0x24, 0x45, 0x7d, 0x94, 0x4b, 0x5b, 0x08, 0xf4, 0x9f, 0x26, 0xef, 0x4c,
-	0xbf, 0xfe, 0x07, 0x43, 0x81, 0x98, 0x6f, 0xe5, 0x2c, 0xff, 0x56, 0x1e, 0xbc, 0x60, 0x5b, 0xb9,
-	0x22, 0xe8, 0x15, 0xec, 0xb3, 0x35, 0xfd, 0x8d, 0x86, 0x9e, 0xc1, 0x8e, 0xa5, 0x54, 0xec, 0xe0,
-	0xba, 0x3f, 0xf8, 0x8c, 0x35, 0x51, 0xd3, 0xd3, 0x5e, 0x37, 0x0f, 0x44, 0x5e, 0xd3, 0x9f, 0x57,
-	0xf0, 0x29, 0x42, 0xfb, 0x8b, 0x43, 0xc6, 0x8a, 0x7c, 0xcd, 0xdb, 0x61, 0x9b, 0x18, 0x71, 0x69,
-	0x68, 0xe7, 0x67, 0xde, 0x36, 0xdb, 0x80, 0xf0, 0xdc, 0x00, 0x15, 0xef, 0x1e, 0x6b, 0x72, 0x31,
-	0x4b, 0xae, 0x85, 0x81, 0xaa, 0x5f, 0x7c, 0xcd, 0x9a, 0x4e, 0x46, 0xe1, 0x31, 0xb6, 0x76, 0x1c,
-	0x46, 0x53, 0x31, 0xde, 0xf9, 0x99, 0xb7, 0xc1, 0xd6, 0xf9, 0x3c, 0x8e, 0xa3, 0xf8, 0x62, 0xa7,
-	0x02, 0x04, 0x48, 0x4b, 0xc5, 0x78, 0xa7, 0x7a, 0x70, 0xca, 0x3c, 0x73, 0x21, 0x3b, 0x61, 0x3a,
-	0xa4, 0xbf, 0xe5, 0x78, 0xdf, 0xb0, 0x9d, 0x5e, 0x76, 0xc2, 0x07, 0x9d, 0x4e, 0x32, 0x4b, 0x25,
-	0xc4, 0x67, 0x63, 0x6f, 0x4b, 0xef, 0x91, 0x0f, 0x3a, 0xbf, 0x4d, 0xa2, 0x71, 0xcb, 0x0e, 0xe7,
-	0x0e, 0x93, 0x64, 0x2a, 0xc2, 0xf8, 0xe0, 0xdf, 0xb6, 0xd8, 0xb6, 0x11, 0x67, 0x64, 0xfd, 0x11,
-	0x5b, 0xc1, 0xff, 0xed, 0x6c, 0x5b, 0xfc, 0x00, 0xb4, 0x4a, 0x02, 0xbd, 0xef, 0xd8, 0xd6, 0x89,
-	0x50, 0xba, 0x54, 0x79, 0x1a, 0x65, 0xca, 0xbb, 0xe7, 0xe6, 0xc4, 0x4a, 0xc8, 0xd6, 0xc3, 0xc5,
-	0xef, 0xe7, 0xa8, 0xd7, 0xe7, 0x15, 0xef, 0x57, 0x6c, 0xb3, 0x33, 0x15, 0xa1, 0xf9, 0xe8, 0xb4,
-	0x6c, 0x74, 0x79, 0xca, 0x5f, 0xb2, 0x3a, 0x4c, 0xa9, 0x42, 0x95, 0x2d, 0x63, 0xb7, 0x8f, 0x95,
-	0x98, 0xbe, 0x65, 0xcd, 0x13, 0xa1, 0xd0, 0xb0, 0x12, 0xb0, 0x6b, 0x3f, 0x27, 0x73, 0xc8, 0x4b,
-	0x06, 0x7e, 0xc7, 0xee, 0x15, 0x9b, 0x33, 0x5f, 0xbf, 0xcb, 0x2a, 0x7d, 0xb4, 0xb8, 0x39, 0xc3,
-	0xfa, 0x03, 0xf3, 0x4e, 0x84, 0x2a, 0x7f, 0x3e, 0x2f, 0x0b, 0x70, 0xcc, 0x71, 0x89, 0xf7, 0x27,
-	0xf6, 0x11, 0x48, 0x28, 0xd7, 0xde, 0x97, 0x6e, 0xfc, 0x93, 0x0f, 0x7c, 0x31, 0xf0, 0xbe, 0x65,
-	0x9b, 0x4e, 0x6d, 0xbe, 0xbc, 0x90, 0x85, 0x42, 0x93, 0x61, 0xfc, 0x9e, 0x6d, 0xdb, 0x85, 0x27,
-	0x90, 0x55, 0x1e, 0xfb, 0xe4, 0x96, 0x22, 0x15, 0xbd, 0x9f, 0x0e, 0x56, 0x91, 0xad, 0xb2, 0xcf,
-	0x32, 0x11, 0x4f, 0x6f, 0x2d, 0x12, 0x19, 0x21, 0xf6, 0x83, 0x7b, 0xb4, 0x24, 0x97, 0xa5, 0xda,
-	0x8a, 0xa3, 0xd0, 0x72, 0x0d, 0xe2, 0x07, 0xb6, 0x01, 0x47, 0xaa, 0x73, 0x5e, 0xcf, 0x5f, 0x64,
-	0x5d, 0x76, 0x67, 0xed, 0xb4, 0xfa, 0x98, 0x6e, 0xbc, 0x95, 0xfe, 0x2e, 0x99, 0xcf, 0x64, 0xcf,
-	0xad, 0x07, 0x8b, 0x7d, 0x30, 0xe6, 0x79, 0xc5, 0x3b, 0x65, 0x3b, 0x27, 0x42, 0xd9, 0xc9, 0x6c,
-	0xe6, 0x48, 0x2a, 0x65, 0xce, 0xad, 0xdb, 0xfb, 0xb2, 0xe7, 0x15, 0xef, 0x39, 0xdb, 0xe2, 0xf3,
-	0xb8, 0x9b, 0x8c, 0xae, 0x84, 0x3c, 0x14, 0xf1, 0xe8, 0x72, 0x41, 0xbd, 0xe5, 0x67, 0xf4, 0x15,
-	0xf3, 0xf8, 0x3c, 0xfe, 0x69, 0xfe, 0x56, 0xc8, 0x58, 0x28, 0x91, 0xfd, 0x61, 0xa3, 0x7e, 0xc4,
-	0x2b, 0x5d, 0x2e, 0xd0, 0x7d, 0xe0, 0x36, 0x2e, 0x2d, 0xa5, 0xfd, 0x86, 0xb1, 0x13, 0xa1, 0x4c,
-	0x7a, 0xfe, 0x01, 0xab, 0xe1, 0xdc, 0xa6, 0xef, 0xf1, 0x59, 0x6a, 0xe8, 0xc7, 0x28, 0x53, 0x89,
-	0xbc, 0xf9, 0x7f, 0x09, 0x38, 0xa2, 0x77, 0xe9, 0x44, 0xd4, 0x4b, 0x97, 0x70, 0x57, 0x00, 0x9e,
-	0x7a, 0x9c, 0xf9, 0x0b, 0x62, 0x74, 0x62, 0xb0, 0x4c, 0xd8, 0x67, 0x77, 0xe7, 0x16, 0xb4, 0xb4,
-	0xbe, 0xfd, 0xe0, 0xad, 0x00, 0x7f, 0x99, 0xc0, 0x4f, 0xef, 0x4a, 0x0f, 0x48, 0xdc, 0x6f, 0xd9,
-	0xc7, 0x85, 0xb8, 0xfc, 0xdf, 0x2e, 0x56, 0x72, 0xb0, 0x44, 0x6c, 0x70, 0x67, 0x3c, 0x4d, 0x72,
-	0x07, 0xac, 0xb5, 0x28, 0x37, 0x8f, 0xa9, 0xff, 0x30, 0xe3, 0xe4, 0xc6, 0xa8, 0x3f, 0xe2, 0xc6,
-	0xf3, 0x8b, 0x5d, 0x84, 0x54, 0x1f, 0x38, 0x96, 0xc5, 0x18, 0xec, 0x05, 0xdb, 0x3c, 0x11, 0x0a,
-	0x5d, 0xf9, 0x6d, 0x0e, 0xe9, 0xa3, 0xb2, 0xeb, 0x37, 0xee, 0xe8, 0xcf, 0xd0, 0x44, 0x4e, 0xa2,
-	0x69, 0x14, 0x5f, 0x80, 0x95, 0x79, 0xec, 0x5e, 0x21, 0xea, 0x30, 0x76, 0xa6, 0xf4, 0x36, 0x0e,
-	0x5e, 0xb2, 0xfb, 0xb9, 0x1f, 0x1d, 0x85, 0xb1, 0xf1, 0xa5, 0x2f, 0xd8, 0x26, 0x90, 0xfa, 0xd9,
-	0x64, 0xb9, 0xe5, 0x02, 0x50, 0x3b, 0x78, 0x23, 0x71, 0xdb, 0xea, 0x02, 0x57, 0xf0, 0x76, 0x0d,
-	0xff, 0x4a, 0xfb, 0xeb, 0xff, 0x0b, 0x00, 0x00, 0xff, 0xff, 0xde, 0x4b, 0xa4, 0xfe, 0x85, 0x2b,
-	0x00, 0x00,
+	// 3939 bytes of a gzipped FileDescriptorProto
+	0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x94, 0x5a, 0x4b, 0x73, 0x1b, 0x49,
+	0x72, 0x5e, 0x00, 0x7c, 0x00, 0xc5, 0xa7, 0x5a, 0x1c, 0xa9, 0x45, 0x3d, 0x86, 0xd3, 0xb3, 0xb3,
+	0xcb, 0xd5, 0x4e, 0x68, 0xb5, 0xdc, 0xd1, 0xcc, 0x4a, 0x8e, 0x98, 0x19, 0x10, 0x20, 0x29, 0xc4,
+	0x10, 0x1a, 0xa8, 0x40, 0xae, 0x64, 0x87, 0x37, 0x1c, 0x2d, 0xa0, 0x40, 0x76, 0x10, 0xe8, 0xee,
+	0xad, 0x2e, 0x50, 0xa2, 0xaf, 0x3e, 0xf8, 0xe4, 0xf3, 0x1e, 0x1c, 0xfe, 0x11, 0xbe, 0x3b, 0x7c,
+	0xf2, 0xc9, 0x3f, 0xc0, 0x37, 0xff, 0x01, 0xdf, 0xfc, 0x0b, 0xec, 0xc8, 0xcc, 0xaa, 0xee, 0xaa,
+	0x06, 0x48, 0xcd, 0x9e, 0x50, 0xf9, 0x55, 0xd6, 0x2b, 0x2b, 0x2b, 0x5f, 0x0d, 0x76, 0x47, 0xc4,
+	0xa3, 0x44, 0x0e, 0x84, 0xfc, 0xbb, 0x4c, 0xc8, 0xcb, 0x68, 0x20, 0x9e, 0xa4, 0x32, 0x51, 0x89,
+	0xb7, 0x98, 0x9d, 0x87, 0x52, 0x6c, 0xaf, 0x0e, 0x92, 0xc9, 0x24, 0x89, 0x09, 0xdc, 0x66, 0xd9,
+	0x20, 0xd4, 0xed, 0xe0, 0x05, 0xab, 0xb7, 0x8e, 0x4f, 0xfb, 0x3f, 0x44, 0x83, 0x0b, 0xef, 0x0e,
+	0x5b, 0x6a, 0x29, 0x39, 0xee, 0xb4, 0xfd, 0xca, 0x4e, 0x65, 0xb7, 0xc1, 0x35, 0x05, 0x38, 0x17,
+	0x61, 0x96, 0xc4, 0x7e, 0x95, 0x70, 0xa2, 0x82, 0x21, 0x63, 0x30, 0xf6, 0x30, 0x1a, 0x2b, 0x21,
+	0xbd, 0x6d, 0x56, 0x7f, 0x93, 0xc8, 0x8b, 0x71, 0x12, 0x0e, 0xf5, 0xf8, 0x9c, 0xf6, 0xd6, 0x59,
+	0xb5, 0xd3, 0xc6, 0xd1, 0x6b, 0xbc, 0xda, 0x69, 0x7b, 0x5b, 0x6c, 0xb1, 0xaf, 0x42, 0xa9, 0xfc,
+	0x1a, 0x42, 0x44, 0x00, 0x7a, 0x1c, 0x4d, 0x22, 0xe5, 0x2f, 0x10, 0x8a, 0x44, 0xf0, 0x7f, 0xcb,
+	0x6c, 0x05, 0x96, 0xe9, 0x8b, 0x2c, 0x8b, 0x92, 0x58, 0xcf, 0x55, 0xc9, 0xe7, 0xb2, 0xd7, 0xad,
+	0x96, 0xd6, 0x7d, 0xc0, 0x1a, 0x07, 0xea, 0x5c, 0xc8, 0x93, 0xab, 0x54, 0xe8, 0xb5, 0x0a, 0xc0,
+	0xf3, 0xd9, 0x72, 0xa7, 0xd7, 0x03, 0x31, 0xe8, 0x15, 0x0d, 0x09, 0xe3, 0x5a, 0xe3, 0x48, 0xc4,
+	0xaa, 0xdb, 0x6c, 0xf9, 0x8b, 0x3b, 0x95, 0xdd, 0x55, 0x5e, 0x00, 0xd0, 0xdb, 0x17, 0xf2, 0x52,
+	0x48, 0xe8, 0x5d, 0xa2, 0xde, 0x1c, 0x80, 0xfd, 0x10, 0x6b, 0xa7, 0xe7, 0x2f, 0x63, 0x67, 0x4e,
+	0x43, 0x1f, 0x31, 0x76, 0x7a, 0x7e, 0x9d, 0xfa, 0x0c, 0xed, 0x3d, 0x62, 0x8c, 0xf8, 0x7a, 0x89,
+	0x54, 0x7e, 0x03, 0x37, 0x64, 0x21, 0xd0, 0x4f, 0xbc, 0xd8, 0xcf, 0xa8, 0xbf, 0x40, 0x60, 0xee,
+	0x4e, 0xab, 0xdb, 0x6b, 0x25, 0x43, 0xe1, 0xaf, 0x60, 0x6f, 0x4e, 0x9b, 0x3e, 0x14, 0xc3, 0x6a,
+	0xd1, 0x87, 0x52, 0xd8, 0x61, 0x2b, 0xb4, 0x4a, 0x5f, 0x85, 0x4a, 0xf8, 0x6b, 0xd8, 0x6d, 0x43,
+	0xc0, 0x41, 0xeb, 0x10, 0xc7, 0x3a, 0x71, 0x58, 0x90, 0xb5, 0xf7, 0x0b, 0x95, 0xf9, 0x1b, 0xce,
+	0xde, 0x2f, 0x54, 0x66, 0xed, 0x1d, 0xfa, 0x37, 0x9d, 0xbd, 0x43, 0x7f, 0xbe, 0x87, 0xfd, 0x2b,
+	0x25, 0x32, 0xff, 0xd6, 0x4e, 0x65, 0x77, 0x81, 0xdb, 0x50, 0xb1, 0x07, 0xe2, 0xf0, 0x88, 0xc3,
+	0x82, 0x80, 0xa3, 0x99, 0xa6, 0xe3, 0x68, 0x10, 0xaa, 0x28, 0x89, 0xfd, 0xdb, 0xb4, 0x4b, 0x0b,
+	0xf2, 0x36, 0x59, 0xad, 0x79, 0x26, 0xfc, 0x2d, 0xec, 0x81, 0xa6, 0xe7, 0xb1, 0x85, 0xce, 0x70,
+	0x2c, 0xfc, 0x4f, 0x10, 0xc2, 0x36, 0x60, 0xc7, 0xd1, 0x48, 0xf8, 0x77, 0x08, 0x83, 0x36, 0x6a,
+	0x4a, 0x7c, 0x26, 0x45, 0x96, 0xf9, 0x77, 0x77, 0x2a, 0xbb, 0x75, 0x6e, 0x48, 0x98, 0xf3, 0x24,
+	0x4c, 0x7d, 0x1f, 0x51, 0x68, 0x02, 0xd2, 0x8d, 0x86, 0xfe, 0x3d, 0x42, 0xba, 0xd1, 0x10, 0xa4,
+	0xdf, 0x4b, 0xc6, 0xd1, 0xe0, 0xaa, 0x33, 0xf4, 0xb7, 0x49, 0xfa, 0x86, 0xf6, 0x02, 0xb6, 0x4a,
+	0xed, 0xe6, 0x00, 0xb7, 0x7d, 0x1f, 0xfb, 0x1d, 0xcc, 0xfb, 0x39, 0x5b, 0x23, 0x51, 0x34, 0xb3,
+	0x09, 0x0a, 0xf0, 0x01, 0x32, 0xb9, 0x20, 0x70, 0x91, 0x38, 0x0c, 0xd7, 0x43, 0xe2, 0x72, 0x40,
+	0xef, 0x17, 0x6c, 0x3d, 0x1f, 0x46, 0xa2, 0x7c, 0x84, 0xa2, 0x2c, 0xa1, 0xc0, 0x97, 0x0f, 0x24,
+	0xbe, 0x4f, 0x89, 0xcf, 0x45, 0xe1, 0x6c, 0x2f, 0x93, 0x4c, 0x75, 0x41, 0xeb, 0x76, 0xf0, 0xc8,
+	0x39, 0x0d, 0xef, 0xf9, 0xed, 0x68, 0xd4, 0xe9, 0xf9, 0x9f, 0xa1, 0xaa, 0x13, 0x01, 0xd6, 0xe4,
+	0xed, 0x68, 0xd4, 0x4c, 0x53, 0x3f, 0xc0, 0x0d, 0x6a, 0x0a, 0x64, 0xfc, 0x76, 0x34, 0x42, 0xe5,
+	0xfe, 0x9c, 0x5e, 0xa3, 0x26, 0x83, 0x7d, 0xb6, 0x69, 0x19, 0x80, 0xa6, 0x94, 0xe1, 0x95, 0xf7,
+	0x04, 0x5e, 0x12, 0xd2, 0x99, 0x5f, 0xd9, 0xa9, 0xed, 0xae, 0xec, 0x79, 0x4f, 0xd0, 0xd6, 0x3d,
+	0xb1, 0x58, 0x79, 0xce, 0x13, 0xfc, 0x57, 0x85, 0x79, 0x56, 0x4f, 0x2b, 0x99, 0xc6, 0x60, 0xb4,
+	0x40, 0xf1, 0xa6, 0xd2, 0x9a, 0x89, 0x94, 0xbf, 0x80, 0x50, 0x60, 0x53, 0x79, 0xd2, 0xea, 0xe5,
+	0x4c, 0x64, 0xc6, 0x4a, 0xa8, 0xe6, 0x3b, 0x6d, 0x17, 0x7c, 0xb5, 0x9c, 0xcf, 0x42, 0xbd, 0x5d,
+	0xb6, 0xd1, 0x9a, 0x4a, 0x78, 0x7d, 0x39, 0x23, 0x19, 0x9f, 0x32, 0x8c, 0xd7, 0x3e, 0x95, 0x9d,
+	0x82, 0x6f, 0x51, 0x5f, 0xbb, 0x0d, 0x06, 0xff, 0xb4, 0xca, 0x6e, 0xc3, 0xc1, 0xda, 0xa1, 0x0a,
+	0xd3, 0x50, 0x9d, 0x9b, 0x93, 0x3d, 0x60, 0x0d, 0xfe, 0xb6, 0x17, 0x0e, 0x2e, 0x84, 0xa2, 0x73,
+	0x2d, 0xf0, 0x02, 0x80, 0xb9, 0xf9, 0xdb, 0xb6, 0x4c, 0x52, 0xc3, 0x51, 0x45, 0x0e, 0x17, 0x84,
+	0x39, 0x4e, 0xf2, 0x39, 0x6a, 0x34, 0xc7, 0x89, 0x3d, 0xc7, 0x89, 0x33, 0xc7, 0x02, 0xcd, 0xe1,
+	0x80, 0xa0, 0xe0, 0x07, 0x52, 0x26, 0xd2, 0x30, 0x2d, 0x22, 0x93, 0x83, 0x79, 0x5f, 0xb2, 0x5b,
+	0xaf, 0x12, 0x63, 0xb4, 0x0d, 0xe3, 0x12, 0x32, 0xce, 0x76, 0xc0, 0x9d, 0x75, 0x7a, 0x97, 0x5f,
+	0x19, 0xbe, 0x65, 0x32, 0x05, 0x16, 0xa4, 0x39, 0xbe, 0x36, 0x1c, 0xf5, 0x9c, 0xc3, 0x40, 0x60,
+	0x90, 0x4e, 0x5a, 0x3d, 0xc3, 0xd0, 0x40, 0x06, 0x0b, 0xf1, 0x9e, 0xb2, 0xdb, 0x27, 0xad, 0xde,
+	0xab, 0x44, 0x8b, 0xd9, 0x30, 0x32, 0x64, 0x9c, 0xd7, 0x05, 0x33, 0x9e, 0xb6, 0xf3, 0x19, 0x57,
+	0x68, 0xc6, 0x02, 0xc1, 0x3d, 0xb5, 0xba, 0x39, 0xc3, 0xaa, 0xde, 0x53, 0x01, 0x81, 0xa4, 0x7e,
+	0x04, 0xdf, 0x64, 0x58, 0xd6, 0x48, 0x52, 0x36, 0x06, 0x37, 0x72, 0x28, 0xc3, 0xb3, 0x89, 0x88,
+	0x55, 0x86, 0x86, 0x78, 0x81, 0x17, 0x80, 0xf7, 0x98, 0x6d, 0x9e, 0x44, 0x13, 0x91, 0x4c, 0x55,
+	0xc1, 0xb4, 0x81, 0x4c, 0x33, 0x38, 0xde, 0x5e, 0xa2, 0xc2, 0x71, 0xae, 0x5d, 0x9b, 0xfa, 0xf6,
+	0x6c, 0x10, 0x76, 0x6d, 0xab, 0xbe, 0x36, 0xcc, 0xb6, 0xde, 0xef, 0xb0, 0x15, 0x5b, 0xe9, 0xb5,
+	0x61, 0xb6, 0x35, 0x3e, 0x60, 0xab, 0x8e, 0xba, 0xdf, 0xa6, 0x73, 0x39, 0xba, 0xfe, 0x88, 0x31,
+	0x4b, 0xd1, 0xb7, 0x48, 0x7a, 0x1d, 0xa7, 0x1f, 0x94, 0xaa, 0x2b, 0x94, 0x90, 0x19, 0x9a, 0xeb,
+	0x05, 0x6e, 0x21, 0xb0, 0x8b, 0x9e, 0x4c, 0x3e, 0x5c, 0x69, 0x86, 0x3b, 0xb4, 0x0b, 0x0b, 0x42,
+	0x97, 0x3e, 0x95, 0xba, 0xff, 0x2e, 0x49, 0x2e, 0x07, 0x60, 0x8f, 0xad, 0xa9, 0x3c, 0x4e, 0xce,
+	0x5a, 0xe1, 0xe0, 0x5c, 0x64, 0x68, 0xcf, 0x17, 0xb8, 0x83, 0xc1, 0x0b, 0x3f, 0x94, 0x42, 0x0c,
+	0x0b, 0xd9, 0xde, 0x23, 0x93, 0xe8, 0xa2, 0xb0, 0x52, 0x33, 0xcb, 0xc4, 0xe4, 0xdd, 0xf8, 0x2a,
+	0x43, 0x7b, 0xbf, 0xc0, 0x0b, 0x20, 0x9f, 0xa5, 0x60, 0xb9, 0x6f, 0xcd, 0xe2, 0xf0, 0xf5, 0x42,
+	0x99, 0x89, 0xc2, 0x38, 0x3d, 0xd8, 0xa9, 0x01, 0x9f, 0x8b, 0xc2, 0x3d, 0x12, 0x62, 0xd4, 0xe6,
+	0x21, 0xb2, 0xb9, 0x20, 0x68, 0x06, 0xb9, 0x14, 0x70, 0xf9, 0xbf, 0xe5, 0xd3, 0xb1, 0x36, 0xfc,
+	0x6b, 0x7c, 0x06, 0x77, 0x79, 0xf7, 0x88, 0xf7, 0xd3, 0x32, 0x2f, 0xe1, 0xb8, 0x3a, 0x62, 0xed,
+	0x64, 0x12, 0x46, 0x71, 0x86, 0x3e, 0x60, 0x8d, 0xbb, 0x20, 0xd8, 0x3c, 0x1b, 0xe8, 0xf4, 0x32,
+	0x74, 0x09, 0x6b, 0xbc, 0x0c, 0xc3, 0x3d, 0x1f, 0x25, 0x3c, 0x99, 0xaa, 0x28, 0x16, 0x99, 0x76,
+	0x10, 0x16, 0x82, 0xce, 0x39, 0x4b, 0x46, 0xe8, 0x21, 0x56, 0x39, 0xb6, 0x21, 0x20, 0xec, 0xf5,
+	0xfd, 0x9f, 0x23, 0x52, 0xed, 0xf5, 0x41, 0x72, 0x18, 0x39, 0x82, 0x7a, 0xb4, 0x92, 0x38, 0xce,
+	0xfc, 0x2f, 0x48, 0xc2, 0x2e, 0x9a, 0xf3, 0xf5, 0xc2, 0x2c, 0x23, 0xbe, 0x5f, 0x58, 0x7c, 0x39,
+	0x8a, 0x7c, 0xa1, 0x12, 0xf1, 0xe0, 0xaa, 0x1f, 0x4e, 0x52, 0x90, 0xc6, 0x2f, 0xe9, 0x26, 0x5c,
+	0x14, 0xf6, 0xae, 0x91, 0xde, 0xb3, 0xa7, 0xfe, 0x2e, 0xf2, 0x58, 0x88, 0xdd, 0xff, 0xfc, 0xb9,
+	0xff, 0x2b, 0xb7, 0xff, 0xf9, 0x73, 0xab, 0xbf, 0x1b, 0x7e, 0xf0, 0x1f, 0x3b, 0xfd, 0xdd, 0xf0,
+	0x43, 0x71, 0xd3, 0xad, 0xde, 0x29, 0x3c, 0x67, 0xff, 0xd7, 0xf6, 0x4d, 0x6b, 0x30, 0x78, 0xcb,
+	0xb6, 0xd0, 0x1d, 0x08, 0x19, 0x5d, 0x8a, 0xa1, 0x8e, 0x23, 0x52, 0x0c, 0x4b, 0xc0, 0xe7, 0x56,
+	0x74, 0xf0, 0x93, 0xa6, 0xe0, 0x88, 0x75, 0xd0, 0x41, 0x1e, 0x4d, 0x53, 0x18, 0xee, 0x4f, 0xc7,
+	0xa2, 0xd3, 0xd6, 0x1e, 0x4c, 0x53, 0xc1, 0xbf, 0x57, 0xd9, 0x27, 0x33, 0x53, 0x43, 0xdf, 0x4c,
+	0x48, 0x0e, 0xe1, 0xbd, 0x1c, 0x74, 0x7a, 0x38, 0xf1, 0x2a, 0x27, 0x02, 0xd0, 0x76, 0x06, 0x51,
+	0x71, 0x8d, 0x50, 0x24, 0x60, 0x35, 0xec, 0xe6, 0xe8, 0x3e, 0x56, 0xb9, 0xa6, 0x00, 0x47, 0x06,
+	0xae, 0xe3, 0x6f, 0x4d, 0x81, 0x06, 0x60, 0x8c, 0xb0, 0x44, 0xe1, 0x19, 0x86, 0xbe, 0x5b, 0x6c,
+	0x11, 0x7e, 0x39, 0xfa, 0x82, 0x35, 0x4e, 0x84, 0x1d, 0xde, 0xd7, 0xdd, 0xf0, 0xbe, 0x38, 0x79,
+	0xc3, 0x39, 0xb9, 0x15, 0xe6, 0x31, 0x37, 0xcc, 0xf3, 0xd8, 0xc2, 0xe1, 0xeb, 0xf6, 0x2b, 0xb4,
+	0xeb, 0x0d, 0x8e, 0x6d, 0xef, 0x37, 0x6c, 0xa1, 0x99, 0xa6, 0x60, 0xca, 0x21, 0xfc, 0xb8, 0x6f,
+	0x85, 0x1f, 0x65, 0xe1, 0x73, 0x64, 0x0c, 0x7a, 0x6c, 0x7b, 0xae, 0xfc, 0x28, 0xa2, 0xd9, 0x63,
+	0x8b, 0xf4, 0xd6, 0x28, 0x9c, 0x79, 0x70, 0xdd, 0x7c, 0xc0, 0xc4, 0x89, 0x35, 0xf8, 0xef, 0x0a,
+	0xf3, 0xe7, 0x32, 0x74, 0xc3, 0xd4, 0x3b, 0x64, 0xcb, 0xba, 0xa9, 0xa7, 0xfc, 0xf2, 0xa6, 0x29,
+	0xbb, 0x61, 0xfa, 0x44, 0xff, 0x1e, 0xc4, 0x4a, 0x5e, 0x71, 0x33, 0x18, 0x42, 0x3c, 0x68, 0x42,
+	0xbc, 0xa7, 0x2f, 0x34, 0xa7, 0xb7, 0xff, 0xc8, 0x56, 0xed, 0x41, 0xa0, 0x65, 0x17, 0xe2, 0x4a,
+	0xe7, 0x7f, 0xd0, 0xf4, 0xbe, 0x61, 0x8b, 0x97, 0xe1, 0x78, 0x4a, 0x43, 0x57, 0xf6, 0x3e, 0xbb,
+	0x69, 0x0f, 0x28, 0x08, 0x4e, 0xfc, 0x2f, 0xaa, 0xbf, 0xaf, 0x04, 0xff, 0x56, 0xa7, 0xd0, 0xaf,
+	0x27, 0x93, 0x77, 0xa2, 0x3f, 0x9d, 0x4c, 0x42, 0x79, 0x85, 0xb6, 0x3a, 0x89, 0x55, 0x18, 0xc5,
+	0x42, 0xd2, 0xe1, 0x30, 0x64, 0xb6, 0x31, 0xb4, 0x38, 0xd1, 0xd0, 0x61, 0xab, 0x6a, 0x8b, 0xe3,
+	0xc2, 0xf0, 0xea, 0x7a, 0xd1, 0xb0, 0x27, 0x93, 0x01, 0x30, 0x91, 0xc6, 0x5b, 0x08, 0xac, 0xf6,
+	0x4a, 0xbc, 0x07, 0x4a, 0x64, 0x99, 0x30, 0xc1, 0x9a, 0x83, 0xc1, 0xcb, 0x7c, 0x25, 0xde, 0xf7,
+	0xa7, 0x59, 0x1a, 0x0d, 0x00, 0x35, 0x91, 0x9a, 0x03, 0x62, 0x84, 0x68, 0x56, 0xee, 0xab, 0x24,
+	0xcd, 0xb4, 0x0e, 0x97, 0x50, 0xef, 0x31, 0x5b, 0x7f, 0x73, 0xdc, 0x57, 0x89, 0x0c, 0xcf, 0xc4,
+	0x9b, 0x50, 0x0d, 0xce, 0x49, 0xad, 0xf7, 0xab, 0x7e, 0x85, 0x97, 0x7a, 0x40, 0x93, 0x7b, 0xd1,
+	0xb0, 0x2f, 0x94, 0x56, 0x71, 0x4d, 0xc1, 0xae, 0xb5, 0x87, 0x38, 0x09, 0xdf, 0x8d, 0x85, 0xd6,
+	0x73, 0x07, 0x83, 0xfd, 0x74, 0xe2, 0x44, 0x45, 0xa3, 0x2b, 0x9c, 0x4b, 0x64, 0x3a, 0xa9, 0x2c,
+	0xa1, 0xe8, 0x89, 0x64, 0x32, 0xd8, 0x1f, 0x27, 0x83, 0x0b, 0x9e, 0x24, 0x3a, 0xba, 0x59, 0xe3,
+	0x25, 0xd4, 0xe1, 0xeb, 0x86, 0xf2, 0x22, 0xd3, 0xa9, 0x66, 0x09, 0x85, 0x68, 0x2f, 0x47, 0x50,
+	0x6b, 0x5a, 0xb1, 0xd2, 0x69, 0xe7, 0x6c, 0x87, 0xf7, 0x84, 0x79, 0x39, 0xd8, 0x8e, 0x64, 0x37,
+	0x89, 0x81, 0x9d, 0x72, 0xd0, 0x39, 0x3d, 0x70, 0x17, 0x87, 0xd1, 0x58, 0x74, 0x93, 0xf8, 0xe0,
+	0x32, 0x0f, 0x80, 0xd6, 0xb8, 0x0b, 0x5a, 0x5c, 0x47, 0x32, 0x99, 0xa6, 0x26, 0x27, 0x75, 0x41,
+	0xf4, 0xd5, 0x04, 0x1c, 0x86, 0x74, 0xf2, 0x5b, 0x74, 0x22, 0x17, 0x85, 0x13, 0xe5, 0x48, 0x37,
+	0x56, 0xc4, 0xea, 0xd1, 0x89, 0x66, 0x3a, 0x1c, 0x6e, 0xd8, 0x37, 0x8a, 0xea, 0x76, 0x89, 0xdb,
+	0x74, 0xb8, 0x7b, 0x40, 0xfb, 0xb0, 0x55, 0xde, 0x03, 0x7a, 0x62, 0x9b, 0xaf, 0x17, 0xaa, 0xf3,
+	0x4c, 0x27, 0xb5, 0x25, 0xd4, 0x3a, 0x39, 0x2e, 0x92, 0xe9, 0x3c, 0xd7, 0x05, 0x41, 0x7f, 0x34,
+	0xd0, 0x89, 0xdf, 0x0c, 0x29, 0x60, 0x5a, 0xe3, 0x0e, 0x66, 0xad, 0xd8, 0x89, 0x69, 0x45, 0xdf,
+	0x59, 0x51, 0xa3, 0xd6, 0x8a, 0x9d, 0x18, 0x57, 0xbc, 0xe7, 0xac, 0x48, 0x20, 0x48, 0xa5, 0x1b,
+	0x7e, 0x38, 0xb8, 0x0c, 0xc7, 0xad, 0xf3, 0x30, 0x7e, 0x3d, 0x15, 0x53, 0x61, 0xb2, 0xe5, 0xd9,
+	0x0e, 0x98, 0xb3, 0x1b, 0x7e, 0x38, 0x4a, 0xa4, 0x09, 0x15, 0x28, 0x6f, 0x76, 0xc1, 0xe0, 0x7f,
+	0x2a, 0x96, 0xf9, 0xd0, 0xcf, 0x15, 0x4c, 0x54, 0x2f, 0xa2, 0x12, 0xd5, 0x22, 0x87, 0x26, 0xba,
+	0x94, 0x34, 0xa2, 0xea, 0xd1, 0x22, 0xc7, 0x36, 0x60, 0xaf, 0xc2, 0x09, 0x15, 0x8d, 0x1a, 0x1c,
+	0xdb, 0x80, 0xf1, 0x69, 0x34, 0xd4, 0x26, 0x00, 0xdb, 0x80, 0x1d, 0x00, 0x46, 0x2f, 0x1e, 0xdb,
+	0x58, 0x1f, 0x1a, 0x84, 0x31, 0xb8, 0x63, 0xf3, 0xc6, 0x0b, 0x00, 0x7b, 0x55, 0x28, 0x15, 0xba,
+	0x70, 0x4a, 0x5e, 0x0a, 0x00, 0x8d, 0xad, 0x48, 0x13, 0xa9, 0xc4, 0x50, 0x3f, 0xe9, 0x9c, 0xc6,
+	0x10, 0xd6, 0x98, 0x0a, 0x7c, 0xd1, 0x0d, 0x5e, 0x00, 0xc1, 0x2b, 0xf2, 0xce, 0xf6, 0x59, 0xc9,
+	0xb1, 0x3c, 0x63, 0x8d, 0xc2, 0x7c, 0x91, 0x27, 0xb8, 0x6b, 0x59, 0x61, 0x7b, 0x00, 0x2f, 0x38,
+	0x83, 0x98, 0x12, 0x66, 0xec, 0xce, 0x57, 0x41, 0x57, 0x6f, 0xea, 0x7b, 0xd5, 0xce, 0xd0, 0x48,
+	0xb3, 0x5a, 0x48, 0x73, 0x9b, 0xd5, 0x5b, 0xe7, 0xd1, 0x78, 0x28, 0x45, 0xec, 0xd7, 0x76, 0x6a,
+	0xbb, 0x8b, 0x3c, 0xa7, 0xa9, 0x12, 0x22, 0x55, 0x06, 0xa6, 0x76, 0x81, 0x6a, 0x75, 0x86, 0x0e,
+	0x4e, 0xd8, 0xdd, 0xd9, 0xf5, 0xe8, 0x04, 0xcf, 0x19, 0xcb, 0x11, 0x73, 0x84, 0x7b, 0xe5, 0x23,
+	0xe4, 0x1c, 0xdc, 0x62, 0x0e, 0xfe, 0xa1, 0x42, 0xe9, 0xb1, 0x56, 0xb6, 0x48, 0x25, 0x12, 0x9a,
+	0x78, 0xe7, 0xa1, 0x3a, 0xd7, 0x27, 0xc1, 0x36, 0x60, 0xdd, 0x30, 0xbb, 0xd0, 0xb9, 0x30, 0xb6,
+	0x21, 0xb4, 0xe8, 0x64, 0xed, 0x48, 0xa2, 0x22, 0xd4, 0x39, 0x11, 0x10, 0x28, 0x40, 0x24, 0x21,
+	0x06, 0x54, 0xab, 0xac, 0x73, 0x43, 0x02, 0x3f, 0xcc, 0x0f, 0x79, 0x6e, 0x6d, 0xb7, 0xc1, 0x89,
+	0x08, 0x8e, 0xc9, 0x4d, 0x97, 0x36, 0x41, 0x87, 0x7b, 0x6a, 0x46, 0xd0, 0xb9, 0xb6, 0xad, 0x73,
+	0x95, 0xf8, 0xcd, 0x6c, 0xff, 0x6b, 0x6a, 0x19, 0x71, 0x34, 0x1a, 0x09, 0xc9, 0xc5, 0x9f, 0xa6,
+	0x22, 0x53, 0xde, 0xe7, 0xac, 0xd6, 0x9a, 0xd0, 0xdd, 0xac, 0xef, 0xdd, 0xd2, 0xd3, 0x68, 0x9e,
+	0xd6, 0x64, 0xc8, 0xa1, 0xd7, 0xaa, 0xc4, 0x36, 0x30, 0x54, 0x7b, 0xc4, 0x98, 0xc9, 0xaf, 0x75,
+	0xc0, 0xd7, 0xe0, 0x16, 0x02, 0xfd, 0xb0, 0xe8, 0xab, 0xe9, 0xe4, 0x9d, 0x90, 0x5a, 0xf3, 0x2d,
+	0xc4, 0x18, 0x8a, 0x7e, 0xf4, 0xf7, 0xa2, 0x13, 0x77, 0xf7, 0xf5, 0x3b, 0x70, 0x30, 0x70, 0x52,
+	0x54, 0x23, 0xc6, 0xc7, 0xd0, 0xe0, 0x9a, 0x82, 0x44, 0xa3, 0x3d, 0x95, 0x58, 0x9b, 0xeb, 0xc4,
+	0x7d, 0x31, 0x48, 0xe2, 0xa1, 0x8e, 0xe0, 0x66, 0xf0, 0xe0, 0x0b, 0xba, 0xc6, 0xfc, 0xc8, 0x59,
+	0x9a, 0xc4, 0x99, 0x1d, 0x79, 0xe2, 0x71, 0x82, 0xef, 0xd8, 0x2d, 0x8b, 0x4d, 0xaf, 0x53, 0x62,
+	0xba, 0xa9, 0x62, 0x1c, 0xfc, 0x63, 0x55, 0x57, 0x9b, 0x69, 0x86, 0x99, 0xb1, 0x3e, 0x5b, 0x6e,
+	0x9e, 0x89, 0x58, 0xe5, 0x42, 0x34, 0xe4, 0x47, 0x25, 0xf9, 0x25, 0x5b, 0xea, 0xab, 0x50, 0x4d,
+	0x29, 0x84, 0x58, 0xdf, 0xdb, 0x72, 0x6f, 0x88, 0xfa, 0xb8, 0xe6, 0x01, 0x5d, 0x6c, 0xca, 0x33,
+	0x2a, 0x97, 0x34, 0x38, 0xb6, 0x4b, 0x77, 0xb1, 0x34, 0x73, 0x17, 0x1e, 0x5b, 0x00, 0x99, 0xa3,
+	0x0c, 0x6b, 0x1c, 0xdb, 0xae, 0xb5, 0xa9, 0x63, 0x87, 0x6b, 0x6d, 0x20, 0xe6, 0xc0, 0xce, 0x06,
+	0x76, 0xe6, 0x74, 0x5e, 0x75, 0xa3, 0xed, 0xe5, 0x55, 0xb7, 0x8c, 0xe8, 0xb9, 0x55, 0x37, 0x7d,
+	0x39, 0x39, 0x4f, 0xe9, 0xd6, 0xda, 0xc9, 0xfb, 0xd8, 0xfa, 0x1c, 0x50, 0xdc, 0xda, 0x17, 0x6c,
+	0xc3, 0x62, 0xeb, 0x0d, 0xc2, 0x14, 0xdf, 0xe7, 0x40, 0x07, 0x77, 0xab, 0x1c, 0xdb, 0xc1, 0x6b,
+	0x9a, 0x2d, 0x7f, 0xdd, 0xc7, 0xc9, 0x19, 0x17, 0x7f, 0x9a, 0x31, 0x49, 0xf9, 0xc7, 0x05, 0x32,
+	0x4a, 0xe5, 0x8f, 0x0b, 0x35, 0xfb, 0xe3, 0xc2, 0xaf, 0xe7, 0x4d, 0x99, 0x21, 0x73, 0x72, 0xf6,
+	0x37, 0xef, 0xf4, 0xf2, 0x44, 0x04, 0xff, 0xa2, 0x75, 0xc3, 0x78, 0x12, 0xe3, 0x23, 0x2a, 0x96,
+	0x8f, 0xb0, 0xec, 0xe1, 0x5a, 0xe1, 0x5d, 0x00, 0xaa, 0xe9, 0x84, 0xc5, 0x60, 0x47, 0x85, 0x27,
+	0x81, 0x36, 0x62, 0xfd, 0xc2, 0x93, 0x40, 0x1b, 0x3d, 0xce, 0x69, 0x34, 0x34, 0xc9, 0x0e, 0xb4,
+	0xd1, 0xe3, 0x00, 0xb6, 0xac, 0x3d, 0x8e, 0xc6, 0x5a, 0x93, 0x61, 0xe6, 0xd7, 0xd1, 0xe8, 0x60,
+	0x1b, 0xc7, 0x26, 0x09, 0x7d, 0x49, 0xa8, 0x73, 0x6c, 0x03, 0x76, 0x9a, 0x09, 0x89, 0x81, 0x5e,
+	0x83, 0x63, 0x1b, 0x13, 0x30, 0xd2, 0x4b, 0x4a, 0x6e, 0x8c, 0x06, 0xfa, 0x6c, 0x19, 0x25, 0xd7,
+	0x54, 0x18, 0xc7, 0xd5, 0xb8, 0x21, 0xad, 0xf4, 0x69, 0x8d, 0x46, 0x10, 0x15, 0xb4, 0x73, 0x6f,
+	0x5b, 0x38, 0x9f, 0xa7, 0xb3, 0xce, 0xc7, 0x73, 0x2d, 0x77, 0xd9, 0xef, 0x7c, 0x4f, 0xc6, 0x4d,
+	0x27, 0x07, 0xed, 0x71, 0x8a, 0x29, 0xe6, 0x3c, 0x59, 0x5f, 0x93, 0xc0, 0x06, 0xff, 0x5a, 0x25,
+	0x57, 0xe2, 0x4e, 0x41, 0xfb, 0x01, 0x1b, 0x9f, 0x0c, 0xf3, 0x79, 0xb0, 0x4e, 0x0d, 0xa9, 0xa6,
+	0x18, 0x35, 0x07, 0xca, 0xcc, 0x43, 0x14, 0xbc, 0x8e, 0x66, 0x9a, 0x8e, 0xaf, 0x8c, 0xf9, 0x5f,
+	0xe4, 0x39, 0x0d, 0x63, 0xde, 0x8c, 0xbb, 0xe1, 0x00, 0x5e, 0x33, 0xc8, 0x5c, 0x53, 0xde, 0x33,
+	0x56, 0xd7, 0xeb, 0x91, 0x0b, 0x70, 0x1d, 0x95, 0xbb, 0x23, 0x9e, 0xb3, 0xc2, 0xb0, 0x37, 0xe1,
+	0x88, 0x86, 0x2d, 0x7d, 0x74, 0x98, 0x61, 0x85, 0xd3, 0xc8, 0x68, 0x98, 0xf9, 0xcb, 0x3b, 0x35,
+	0xd0, 0x05, 0x68, 0xc3, 0xbd, 0xbd, 0x0f, 0x47, 0x08, 0xd7, 0x11, 0x36, 0xa4, 0x49, 0xe4, 0xf0,
+	0x2b, 0x10, 0x85, 0x0f, 0x39, 0x1d, 0xfc, 0x47, 0xc5, 0x49, 0xee, 0xf5, 0x52, 0x90, 0x00, 0x1d,
+	0x33, 0x56, 0x50, 0xd7, 0x67, 0x92, 0x05, 0xcf, 0x93, 0xa2, 0x49, 0x99, 0xa4, 0x35, 0x7e, 0xfb,
+	0x8f, 0x6c, 0xa3, 0xd4, 0x3d, 0x27, 0x67, 0xfc, 0xca, 0xcd, 0x19, 0x1f, 0x5d, 0xbb, 0xda, 0x4c,
+	0xc2, 0xf8, 0xd7, 0xf3, 0x6e, 0x9e, 0x96, 0x99, 0xa7, 0x41, 0xe5, 0xef, 0x92, 0x10, 0x9f, 0x84,
+	0x4a, 0x09, 0x89, 0xe5, 0xfb, 0x1a, 0xc6, 0x27, 0x9a, 0x0e, 0x46, 0xec, 0xc1, 0x35, 0x53, 0x93,
+	0x66, 0x1d, 0xb2, 0x75, 0x0b, 0x8c, 0x72, 0x75, 0xbf, 0x7e, 0xf7, 0x24, 0x9d, 0xd2, 0xa8, 0xe0,
+	0x57, 0xf3, 0x2f, 0x62, 0x80, 0x1f, 0x96, 0xc2, 0x81, 0x91, 0x53, 0x37, 0x1c, 0x04, 0x7f, 0xeb,
+	0x14, 0x14, 0x0a, 0x56, 0xda, 0xd0, 0xb7, 0x6c, 0xa5, 0x80, 0x6e, 0x28, 0x2b, 0x14, 0x4c, 0xdc,
+	0x1e, 0x10, 0xfc, 0x67, 0x85, 0xdd, 0xb1, 0xd3, 0x74, 0xfd, 0x54, 0xaf, 0x7b, 0x8d, 0x26, 0xa2,
+	0xaa, 0x5a, 0x11, 0x55, 0xf1, 0x42, 0x6b, 0xb6, 0xa5, 0xc0, 0x48, 0x56, 0x8a, 0x50, 0x89, 0x61,
+	0x53, 0xe9, 0xcf, 0x06, 0x05, 0x00, 0xb7, 0x70, 0x9a, 0x0e, 0x43, 0x25, 0x9a, 0x4a, 0x7f, 0x2e,
+	0xc8, 0x69, 0x18, 0x89, 0xc9, 0x19, 0x2e, 0x4f, 0xe1, 0x44, 0x01, 0x80, 0xee, 0xb7, 0x46, 0x67,
+	0xa8, 0xe0, 0xcb, 0xe4, 0x9d, 0x35, 0x19, 0x70, 0x76, 0x7f, 0xfe, 0x59, 0x48, 0x56, 0xbf, 0x73,
+	0x8b, 0x2f, 0x0f, 0xe7, 0x54, 0x29, 0x8a, 0x21, 0x56, 0xf5, 0xe5, 0xb6, 0xc5, 0x81, 0x21, 0x1a,
+	0x48, 0xe7, 0x01, 0x6b, 0x70, 0x31, 0x98, 0xca, 0x2c, 0xba, 0x24, 0x11, 0xd5, 0x79, 0x01, 0x58,
+	0xd1, 0x50, 0xd5, 0x89, 0x86, 0x8c, 0xfc, 0x6a, 0x96, 0xfc, 0xb6, 0xd8, 0x22, 0x17, 0x67, 0xe2,
+	0x83, 0x0e, 0x96, 0x89, 0x00, 0xf9, 0xec, 0x8b, 0xf3, 0xf0, 0x32, 0x4a, 0xa4, 0x8e, 0x0f, 0x72,
+	0xfa, 0x23, 0xf2, 0xf1, 0x74, 0xc9, 0x6a, 0x99, 0xfc, 0x04, 0xb4, 0x6d, 0x99, 0xd5, 0x5d, 0x99,
+	0x1d, 0x3b, 0xc5, 0x25, 0x73, 0xbc, 0x3c, 0x6a, 0xb5, 0x05, 0xb6, 0x3d, 0x2b, 0x30, 0xc3, 0x6f,
+	0xa4, 0xf5, 0xcf, 0x55, 0x76, 0x0f, 0xba, 0xf3, 0x90, 0x28, 0x56, 0x42, 0x0e, 0x44, 0x4a, 0x5f,
+	0xb7, 0x4d, 0x59, 0xcf, 0xc4, 0xe3, 0x06, 0x13, 0xb9, 0x9c, 0xb0, 0x8d, 0x8f, 0xa0, 0xd9, 0xd2,
+	0x25, 0x44, 0x68, 0x82, 0x8c, 0x4e, 0x5b, 0x80, 0x51, 0xfd, 0x90, 0x08, 0x40, 0xf7, 0x5b, 0xc5,
+	0xd7, 0x7b, 0x22, 0x40, 0xf6, 0x9d, 0x38, 0x2f, 0x1f, 0x36, 0xb8, 0xa6, 0x00, 0x3f, 0xf8, 0x80,
+	0x38, 0xa9, 0x8d, 0xa6, 0xf0, 0xa3, 0x0d, 0x72, 0xd0, 0x59, 0x49, 0x3e, 0x36, 0x04, 0x1c, 0xc4,
+	0x4b, 0x1c, 0x64, 0x56, 0x6d, 0x08, 0x52, 0xd5, 0x03, 0xfd, 0xe7, 0x0c, 0xe2, 0x21, 0xe7, 0xeb,
+	0x82, 0xc1, 0x9f, 0xb5, 0xfd, 0x9d, 0x91, 0xce, 0x4c, 0x04, 0x8a, 0x67, 0x18, 0x47, 0x31, 0x59,
+	0xc7, 0x3a, 0xd7, 0x14, 0x44, 0x87, 0xaf, 0xa7, 0xa1, 0x0c, 0x63, 0xc8, 0x7d, 0x75, 0xba, 0x62,
+	0x21, 0xde, 0xd7, 0x54, 0x24, 0x25, 0x87, 0xb5, 0xb2, 0xb7, 0x63, 0xdd, 0xd8, 0xdc, 0x2b, 0xa1,
+	0x32, 0x6a, 0x06, 0x11, 0x71, 0x03, 0x98, 0xf0, 0x4b, 0x09, 0x68, 0x0b, 0x36, 0xf2, 0x7a, 0xaf,
+	0x21, 0x6f, 0xfc, 0x1f, 0xc6, 0x1d, 0xb6, 0x04, 0xb7, 0x97, 0xd7, 0x7e, 0x35, 0x05, 0xb7, 0x84,
+	0xdf, 0x2b, 0xcd, 0x3f, 0x3e, 0x90, 0x00, 0x1d, 0x3e, 0x0e, 0x33, 0x45, 0x3d, 0x14, 0x0e, 0x15,
+	0x40, 0xfe, 0xcd, 0x7e, 0xc9, 0xfd, 0x66, 0xdf, 0x4f, 0xc3, 0xd8, 0xc4, 0x44, 0xd0, 0xc6, 0x0f,
+	0x72, 0x69, 0x2a, 0x24, 0x45, 0x7d, 0x94, 0x4b, 0x5b, 0x08, 0x96, 0xdb, 0x93, 0xf7, 0xa6, 0x5f,
+	0xff, 0xdf, 0xa2, 0x40, 0xcc, 0x97, 0x7d, 0x96, 0x7f, 0xd9, 0x0f, 0x5e, 0xb0, 0xf5, 0x5c, 0x10,
+	0xf4, 0x0a, 0x76, 0xd9, 0x92, 0xfe, 0xa2, 0x44, 0xcf, 0x60, 0xd3, 0x12, 0x2a, 0x76, 0x70, 0xdd,
+	0x1f, 0x7c, 0xce, 0xd6, 0x50, 0xd2, 0xe3, 0x4e, 0x3b, 0x0f, 0x44, 0xde, 0xd0, 0x5f, 0x6d, 0xf0,
+	0x29, 0x42, 0x3b, 0xf8, 0x8a, 0x6a, 0xf7, 0x45, 0x41, 0xf4, 0x65, 0xa4, 0x20, 0xc2, 0x45, 0x83,
+	0x92, 0x09, 0xf5, 0x32, 0xd2, 0xdf, 0x72, 0xd1, 0xa0, 0x68, 0x20, 0x38, 0xa5, 0x9c, 0xc7, 0x19,
+	0x35, 0x53, 0x92, 0xf7, 0xd8, 0x02, 0x8e, 0xd6, 0xb9, 0x2d, 0xb4, 0x8d, 0x9c, 0x5f, 0x46, 0x10,
+	0xe3, 0xd5, 0x0a, 0x39, 0x23, 0x10, 0x7c, 0x20, 0xeb, 0xef, 0x4c, 0x4b, 0x5b, 0xff, 0x52, 0xcf,
+	0x45, 0x67, 0xf6, 0xed, 0x70, 0xce, 0xd9, 0x39, 0xad, 0x02, 0xe1, 0x78, 0x14, 0x0f, 0x84, 0x76,
+	0xb3, 0x44, 0x80, 0xb6, 0xfc, 0x78, 0x29, 0xe4, 0x68, 0x9c, 0xbc, 0xd7, 0x5f, 0x96, 0x73, 0xfa,
+	0xf1, 0x3e, 0x63, 0x45, 0xda, 0xea, 0x6d, 0xb2, 0x55, 0x0c, 0x3c, 0x35, 0xb4, 0xf9, 0x33, 0x6f,
+	0x83, 0xad, 0x40, 0x96, 0x62, 0x80, 0x8a, 0x77, 0x8b, 0xad, 0x71, 0x31, 0x49, 0x2e, 0x85, 0x81,
+	0xaa, 0x8f, 0x9f, 0xb1, 0x35, 0x27, 0xb1, 0xf2, 0x18, 0x5b, 0x3a, 0x0c, 0xa3, 0xb1, 0x18, 0x6e,
+	0xfe, 0xcc, 0x5b, 0x61, 0xcb, 0x7c, 0x1a, 0xc7, 0x51, 0x7c, 0xb6, 0x59, 0x01, 0x02, 0x66, 0x4b,
+	0xc5, 0x70, 0xb3, 0xba, 0x77, 0xcc, 0x3c, 0xf3, 0x2e, 0x5b, 0x61, 0xda, 0xa7, 0xff, 0x52, 0x79,
+	0x5f, 0xb3, 0xcd, 0x4e, 0x76, 0xc4, 0x7b, 0xad, 0x56, 0x32, 0x49, 0x25, 0x84, 0xa9, 0x43, 0x6f,
+	0x5d, 0x1f, 0x9b, 0xf7, 0x5a, 0x7f, 0x48, 0xa2, 0xe1, 0xb6, 0x1d, 0xd5, 0xee, 0x27, 0xc9, 0x58,
+	0x84, 0xf1, 0xde, 0x9f, 0x37, 0xd8, 0x86, 0x99, 0xce, 0xcc, 0xf5, 0x4b, 0xb6, 0x80, 0x7f, 0xb6,
+	0xda, 0xb0, 0xf8, 0x01, 0xd8, 0x2e, 0x4d, 0xe8, 0x7d, 0xcb, 0xd6, 0x8f, 0x84, 0xd2, 0x15, 0xdb,
+	0xe3, 0x28, 0x53, 0xde, 0x2d, 0xb7, 0x34, 0xa0, 0x84, 0xdc, 0xbe, 0x3b, 0xfb, 0xa7, 0x07, 0xbc,
+	0xa3, 0xa7, 0x15, 0xef, 0xb7, 0x6c, 0xb5, 0x35, 0x16, 0xa1, 0xf9, 0x52, 0x38, 0x6f, 0x74, 0x79,
+	0xc9, 0xdf, 0xb0, 0x3a, 0x2c, 0xa9, 0x42, 0x95, 0xcd, 0x63, 0xb7, 0xb5, 0x9b, 0x98, 0xbe, 0x61,
+	0x6b, 0x47, 0x42, 0xa1, 0x7f, 0x21, 0x60, 0xcb, 0xb6, 0x2a, 0x46, 0xd7, 0xe7, 0x0c, 0xfc, 0x96,
+	0xdd, 0x2a, 0x0e, 0x67, 0xfe, 0xb2, 0x50, 0x16, 0xe9, 0xbd, 0xd9, 0xc3, 0x19, 0xd6, 0xef, 0x99,
+	0x77, 0x24, 0x54, 0xf9, 0x3f, 0x0f, 0xe5, 0x09, 0x1c, 0xaf, 0x54, 0xe2, 0xfd, 0x81, 0x7d, 0x02,
+	0x33, 0x94, 0x3f, 0x41, 0xcc, 0x3d, 0xf8, 0xa7, 0x1f, 0xf9, 0x70, 0xe2, 0x7d, 0xc3, 0x56, 0x9d,
+	0x4f, 0x14, 0xe5, 0x8d, 0xcc, 0xd4, 0xdb, 0x0c, 0xe3, 0x77, 0x6c, 0xc3, 0xae, 0xbf, 0xc1, 0x5c,
+	0xe5, 0xb1, 0x0f, 0xae, 0xa9, 0xd5, 0xd1, 0x5b, 0x6c, 0x61, 0x31, 0xdd, 0xaa, 0x7e, 0xcd, 0x9b,
+	0xe2, 0xd1, 0xb5, 0xb5, 0x32, 0x33, 0x89, 0xfd, 0xe0, 0xee, 0xcd, 0x49, 0xe9, 0xa9, 0xc4, 0xe4,
+	0x08, 0xb4, 0x5c, 0x8a, 0xf9, 0x9e, 0xad, 0xc0, 0x95, 0xea, 0xd4, 0xdf, 0xf3, 0x67, 0x59, 0xe7,
+	0xe9, 0xac, 0x5d, 0x5d, 0x38, 0x24, 0x8d, 0xb7, 0xaa, 0x00, 0x73, 0xd6, 0x33, 0x45, 0x84, 0xed,
+	0x3b, 0xb3, 0x7d, 0x30, 0xe6, 0x69, 0xc5, 0x3b, 0x66, 0x9b, 0x47, 0x42, 0xd9, 0x39, 0x7d, 0xe6,
+	0xcc, 0x54, 0x2a, 0x20, 0x6c, 0x5f, 0xdf, 0x97, 0x3d, 0xad, 0x78, 0x4f, 0xd9, 0x3a, 0x9f, 0xc6,
+	0xed, 0x64, 0x70, 0x21, 0xe4, 0xbe, 0x88, 0x07, 0xe7, 0x33, 0xe2, 0x2d, 0x3f, 0xa3, 0xaf, 0x98,
+	0xc7, 0xa7, 0xf1, 0x0f, 0xd3, 0x77, 0x42, 0xc6, 0x42, 0x89, 0xec, 0xa7, 0x8d, 0x7a, 0x89, 0x2a,
+	0x5d, 0xae, 0x53, 0x7e, 0x44, 0x1b, 0xe7, 0x56, 0x14, 0x7f, 0xcf, 0xd8, 0x91, 0x50, 0xa6, 0x4a,
+	0xf1, 0x11, 0xab, 0xe1, 0x68, 0xd3, 0x77, 0xf8, 0x2c, 0x35, 0xf4, 0x32, 0xca, 0x54, 0x22, 0xaf,
+	0xfe, 0xa2, 0x09, 0x0e, 0xe8, 0x5d, 0x3a, 0x89, 0xc5, 0xdc, 0x2d, 0xdc, 0x94, 0x87, 0xa4, 0x1e,
+	0x67, 0xfe, 0xcc, 0x34, 0x3a, 0x3f, 0x9a, 0x37, 0xd9, 0xe7, 0x37, 0xa7, 0x58, 0xb4, 0xb5, 0xae,
+	0xfd, 0xe0, 0xad, 0x3c, 0x67, 0xde, 0x84, 0x9f, 0xdd, 0x94, 0x25, 0xd1, 0x74, 0x7f, 0x60, 0x0f,
+	0x8b, 0xe9, 0xf2, 0xbf, 0x28, 0x59, 0x39, 0xd2, 0x9c, 0x69, 0x83, 0x1b, 0xd3, 0x0a, 0x9a, 0xb7,
+	0xc7, 0xb6, 0x67, 0xe7, 0xcd, 0x53, 0x8b, 0x9f, 0x66, 0x9c, 0xdc, 0x50, 0xfd, 0x25, 0x1e, 0x3c,
+	0x57, 0xec, 0x22, 0xb2, 0xfc, 0xc8, 0xb5, 0xcc, 0x86, 0xa2, 0x2f, 0xd8, 0xea, 0x91, 0x50, 0x18,
+	0xd1, 0x5c, 0xe7, 0x90, 0x3e, 0x29, 0x47, 0x40, 0xc6, 0x1d, 0xfd, 0x15, 0x9a, 0xc8, 0x51, 0x34,
+	0x8e, 0xe2, 0x33, 0xb0, 0x32, 0xf7, 0x5d, 0x15, 0xa2, 0x0e, 0x63, 0x67, 0xca, 0x6f, 0xe3, 0x47,
+	0xd2, 0x4b, 0x3b, 0xba, 0xc8, 0xdc, 0x19, 0x4a, 0x21, 0xd3, 0xf6, 0xc3, 0xeb, 0x3a, 0x71, 0x3f,
+	0x7b, 0xaf, 0xd9, 0xed, 0xdc, 0x31, 0x0f, 0xc2, 0xd8, 0x38, 0xe7, 0x17, 0x6c, 0x15, 0x48, 0xfd,
+	0x0e, 0xb3, 0xdc, 0x14, 0x02, 0xa8, 0x23, 0x06, 0xb3, 0xc5, 0x0d, 0xab, 0x0b, 0x7c, 0xcb, 0xbb,
+	0x25, 0xfc, 0x43, 0xf5, 0xef, 0xfe, 0x3f, 0x00, 0x00, 0xff, 0xff, 0x65, 0x1f, 0x3a, 0xb4, 0x8b,
+	0x2d, 0x00, 0x00,
 }
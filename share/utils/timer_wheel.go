@@ -2,61 +2,73 @@ package utils
 
 import (
 	"errors"
+	"strconv"
 	"sync"
 	"time"
 )
 
+// Hierarchical timer wheel in ticks, like the dp's timer_wheel. The bottom level has a slot per
+// tick, each upper level slot spans a full turn of the level below. A timer is put on the level
+// its delay falls into and moved down a level when the level below turns over to its slot, so
+// add and remove are O(1) and a tick only looks at the slots it passes.
+//
+//   level 0: 256 x 1 tick, level 1-4: 64 x 256, 16K, 1M and 64M ticks
+//
+// Timers are nodes of a pool linked by index, a handle is the node index and its generation.
+// Freed nodes are reused, once the pool has grown to the peak number of timers adding and
+// removing a timer does not allocate.
+
 type TimerWheel struct {
-	tickDuration  time.Duration
-	roundDuration time.Duration
-	wheelCount    int
-	wheel         []*Iterator
-	tick          *time.Ticker
-	lock          sync.Mutex
-	wheelCursor   int
-	mask          int
+	tickDuration time.Duration
+	tick         *time.Ticker
+	lock         sync.Mutex
+	current      uint64 // last tick expired
+	slots        [wheelSlots]int32
+	nodes        []wheelNode
+	free         int32
+	expired      []TimerTask
 }
 
 type TimerTask interface {
 	Expire()
 }
 
-type Iterator struct {
-	items map[string]*WheelTimeOut
-}
+// Zero is never a valid handle
+type TimerHandle uint64
 
-type WheelTimeOut struct {
-	delay  time.Duration
-	index  int
-	rounds int
-	task   TimerTask
+type wheelNode struct {
+	task    TimerTask
+	expires uint64
+	prev    int32
+	next    int32
+	slot    int32 // -1 if free
+	gen     uint32
 }
 
 const (
 	default_tick_duration = time.Second
-	default_wheel_count   = 3600
+
+	wheelLevels  = 5
+	wheelL0Bits  = 8
+	wheelLnBits  = 6
+	wheelL0Slots = 1 << wheelL0Bits
+	wheelLnSlots = 1 << wheelLnBits
+	wheelSlots   = wheelL0Slots + (wheelLevels-1)*wheelLnSlots
+	wheelMaxTick = 1<<(wheelL0Bits+(wheelLevels-1)*wheelLnBits) - 1
+
+	wheelNil int32 = -1
 )
 
 func NewTimerWheel() *TimerWheel {
-	return &TimerWheel{
-		tickDuration:  default_tick_duration,
-		wheelCount:    default_wheel_count,
-		wheel:         createWheel(default_wheel_count),
-		wheelCursor:   0,
-		mask:          default_wheel_count - 1,
-		roundDuration: default_tick_duration * default_wheel_count,
-	}
+	return NewTimerWheelWithTick(default_tick_duration)
 }
 
 func NewTimerWheelWithTick(tick time.Duration) *TimerWheel {
-	return &TimerWheel{
-		tickDuration:  tick,
-		wheelCount:    default_wheel_count,
-		wheel:         createWheel(default_wheel_count),
-		wheelCursor:   0,
-		mask:          default_wheel_count - 1,
-		roundDuration: default_tick_duration * default_wheel_count,
+	t := &TimerWheel{tickDuration: tick, free: wheelNil}
+	for i := range t.slots {
+		t.slots[i] = wheelNil
 	}
+	return t
 }
 
 func (t *TimerWheel) Start() {
@@ -64,16 +76,16 @@ func (t *TimerWheel) Start() {
 	go func() {
 		for range t.tick.C {
 			t.lock.Lock()
-			t.wheelCursor++
-			if t.wheelCursor == t.wheelCount {
-				t.wheelCursor = 0
-			}
-
-			iterator := t.wheel[t.wheelCursor]
-			tasks := t.fetchExpiredTimeouts(iterator)
+			t.roll()
+			tasks := t.expired
 			t.lock.Unlock()
 
+			// Only this goroutine uses the expired list, so it is kept for the next tick
 			t.notifyExpiredTimeOut(tasks)
+			for i := range tasks {
+				tasks[i] = nil
+			}
+			t.expired = tasks[:0]
 		}
 	}()
 }
@@ -82,104 +94,164 @@ func (t *TimerWheel) Stop() {
 	t.tick.Stop()
 }
 
-func createWheel(wheelCount int) []*Iterator {
-	arr := make([]*Iterator, wheelCount)
-
-	for v := 0; v < wheelCount; v++ {
-		arr[v] = &Iterator{items: make(map[string]*WheelTimeOut)}
-	}
-	return arr
-}
-
-func (t *TimerWheel) AddTask(task TimerTask, delay time.Duration) (string, error) {
+func (t *TimerWheel) AddTimer(task TimerTask, delay time.Duration) (TimerHandle, error) {
 	if task == nil {
-		return "", errors.New("task is empty")
+		return 0, errors.New("task is empty")
 	}
 	if delay <= 0 {
-		return "", errors.New("delay Must be greater than zero")
+		return 0, errors.New("delay Must be greater than zero")
 	}
-	timeOut := &WheelTimeOut{
-		delay: delay,
-		task:  task,
+	ticks := uint64(delay / t.tickDuration)
+	if ticks == 0 {
+		ticks = 1 // smallest unit delay
+	} else if ticks > wheelMaxTick {
+		ticks = wheelMaxTick
 	}
 
-	tid, err := t.scheduleTimeOut(timeOut)
+	t.lock.Lock()
+	defer t.lock.Unlock()
 
-	return tid, err
+	idx := t.allocNode()
+	n := &t.nodes[idx]
+	n.task = task
+	n.expires = t.current + ticks
+	t.insert(idx)
+	return TimerHandle(uint64(n.gen)<<32 | uint64(idx+1)), nil
 }
 
-func (t *TimerWheel) RemoveTask(taskId string) {
+// A handle of a timer that has expired or was removed is ignored
+func (t *TimerWheel) RemoveTimer(h TimerHandle) {
 	t.lock.Lock()
 	defer t.lock.Unlock()
 
-	for _, it := range t.wheel {
-		for k := range it.items {
-			if taskId == k {
-				delete(it.items, k)
-			}
-		}
+	idx := int32(uint32(h)) - 1
+	if idx < 0 || int(idx) >= len(t.nodes) {
+		return
+	}
+	n := &t.nodes[idx]
+	if n.slot == wheelNil || n.gen != uint32(h>>32) {
+		return
 	}
+	t.unlink(idx)
+	t.freeNode(idx)
 }
 
-func (t *TimerWheel) scheduleTimeOut(timeOut *WheelTimeOut) (string, error) {
-	if timeOut.delay < t.tickDuration {
-		timeOut.delay = t.tickDuration // smallest unit delay
+// The task ID is the handle in text, for callers that keep it as a string
+func (t *TimerWheel) AddTask(task TimerTask, delay time.Duration) (string, error) {
+	h, err := t.AddTimer(task, delay)
+	if err != nil {
+		return "", err
 	}
-	lastRoundDelay := timeOut.delay % t.roundDuration  // position within a boundary (3600 seconds)
-	relativeIndex := lastRoundDelay / t.tickDuration   // relative slot index (after the current slot index)
-	remainingRounds := timeOut.delay / t.roundDuration // repeating counter; if tm < 3600s, it is 0
+	return strconv.FormatUint(uint64(h), 16), nil
+}
 
-	t.lock.Lock()
-	defer t.lock.Unlock()
-	stopIndex := t.wheelCursor + int(relativeIndex) // real slot index from current slot index
-	if stopIndex >= t.wheelCount {                  // wrap around
-		stopIndex = stopIndex - t.wheelCount
-	}
-
-	// task's slot assignment
-	timeOut.rounds = int(remainingRounds)
-	timeOut.index = stopIndex
-	item := t.wheel[stopIndex]
-	if item == nil {
-		item = &Iterator{
-			items: make(map[string]*WheelTimeOut),
-		}
+func (t *TimerWheel) RemoveTask(taskId string) {
+	if h, err := strconv.ParseUint(taskId, 16, 64); err == nil {
+		t.RemoveTimer(TimerHandle(h))
 	}
+}
 
-	// In case GetGuid is not random enough ??
-	for i := 0; i < 16; i++ {
-		key, err := GetGuid()
-		if err != nil {
-			return "", err
-		}
-		if _, ok := item.items[key]; !ok {
-			// Good, no collision
-			item.items[key] = timeOut
-			t.wheel[stopIndex] = item
-			return key, nil
+func (t *TimerWheel) allocNode() int32 {
+	if t.free != wheelNil {
+		idx := t.free
+		t.free = t.nodes[idx].next
+		return idx
+	}
+	t.nodes = append(t.nodes, wheelNode{slot: wheelNil})
+	return int32(len(t.nodes) - 1)
+}
+
+func (t *TimerWheel) freeNode(idx int32) {
+	n := &t.nodes[idx]
+	n.task = nil
+	n.slot = wheelNil
+	n.gen++
+	n.next = t.free
+	t.free = idx
+}
+
+func wheelSlot(expires, current uint64) int32 {
+	delta := expires - current
+	if expires < current {
+		delta = 0
+	}
+	if delta < wheelL0Slots {
+		return int32(expires & (wheelL0Slots - 1))
+	}
+	shift := uint(wheelL0Bits)
+	for l := 1; l < wheelLevels; l++ {
+		if l == wheelLevels-1 || delta < 1<<(shift+wheelLnBits) {
+			return int32(wheelL0Slots + (l-1)*wheelLnSlots + int((expires>>shift)&(wheelLnSlots-1)))
 		}
+		shift += wheelLnBits
 	}
+	return 0
+}
 
-	return "", errors.New("Failed to create unique task key")
+func (t *TimerWheel) insert(idx int32) {
+	n := &t.nodes[idx]
+	s := wheelSlot(n.expires, t.current)
+	n.slot = s
+	n.prev = wheelNil
+	n.next = t.slots[s]
+	if n.next != wheelNil {
+		t.nodes[n.next].prev = idx
+	}
+	t.slots[s] = idx
 }
 
-func (t *TimerWheel) fetchExpiredTimeouts(iterator *Iterator) []*WheelTimeOut {
-	task := []*WheelTimeOut{}
+func (t *TimerWheel) unlink(idx int32) {
+	n := &t.nodes[idx]
+	if n.prev != wheelNil {
+		t.nodes[n.prev].next = n.next
+	} else {
+		t.slots[n.slot] = n.next
+	}
+	if n.next != wheelNil {
+		t.nodes[n.next].prev = n.prev
+	}
+	n.prev = wheelNil
+	n.next = wheelNil
+}
 
-	for k, v := range iterator.items {
-		if v.rounds <= 0 {
-			task = append(task, v)
-			delete(iterator.items, k)
-		} else {
-			v.rounds--
+// Move the timers of an upper level slot down, they all expire within its span
+func (t *TimerWheel) cascade(s int32) {
+	idx := t.slots[s]
+	t.slots[s] = wheelNil
+	for idx != wheelNil {
+		next := t.nodes[idx].next
+		t.insert(idx)
+		idx = next
+	}
+}
+
+// Advance a tick and move its timers to the expired list
+func (t *TimerWheel) roll() {
+	t.current++
+
+	shift := uint(wheelL0Bits)
+	for l := 1; l < wheelLevels; l++ {
+		if t.current&(1<<shift-1) != 0 {
+			break
 		}
+		t.cascade(int32(wheelL0Slots + (l-1)*wheelLnSlots + int((t.current>>shift)&(wheelLnSlots-1))))
+		shift += wheelLnBits
 	}
 
-	return task
+	s := int32(t.current & (wheelL0Slots - 1))
+	idx := t.slots[s]
+	t.slots[s] = wheelNil
+	for idx != wheelNil {
+		n := &t.nodes[idx]
+		next := n.next
+		t.expired = append(t.expired, n.task)
+		t.freeNode(idx)
+		idx = next
+	}
 }
 
-func (t *TimerWheel) notifyExpiredTimeOut(tasks []*WheelTimeOut) {
+func (t *TimerWheel) notifyExpiredTimeOut(tasks []TimerTask) {
 	for _, task := range tasks {
-		go task.task.Expire()
+		go task.Expire()
 	}
 }
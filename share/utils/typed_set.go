@@ -0,0 +1,251 @@
+package utils
+
+import (
+	"fmt"
+	"strings"
+)
+
+// StringSet and Uint32Set keep their elements unboxed, unlike Set. The elements are kept in a
+// slice, which is scanned while the set is small; a map index is only built when the set grows
+// past typedSetInline elements. Items() returns the slice itself, so iterating a set allocates
+// nothing. The order of the elements is not kept when an element is removed. The sets are not
+// thread-safe, and a nil set reads as an empty one.
+
+const typedSetInline = 8
+
+type StringSet struct {
+	items []string
+	index map[string]int // position in items, nil while the set is small
+}
+
+func NewStringSet(s ...string) *StringSet {
+	set := &StringSet{items: make([]string, 0, len(s))}
+	for _, item := range s {
+		set.Add(item)
+	}
+	return set
+}
+
+func (set *StringSet) find(s string) int {
+	if set == nil {
+		return -1
+	}
+	if set.index != nil {
+		if i, ok := set.index[s]; ok {
+			return i
+		}
+		return -1
+	}
+	for i, item := range set.items {
+		if item == s {
+			return i
+		}
+	}
+	return -1
+}
+
+// Adds an element to the set. Returns whether the item was added.
+func (set *StringSet) Add(s string) bool {
+	if set.find(s) >= 0 {
+		return false
+	}
+	set.items = append(set.items, s)
+	if set.index != nil {
+		set.index[s] = len(set.items) - 1
+	} else if len(set.items) > typedSetInline {
+		set.index = make(map[string]int, len(set.items))
+		for i, item := range set.items {
+			set.index[item] = i
+		}
+	}
+	return true
+}
+
+func (set *StringSet) Remove(s string) {
+	i := set.find(s)
+	if i < 0 {
+		return
+	}
+	last := len(set.items) - 1
+	if i != last {
+		set.items[i] = set.items[last]
+		if set.index != nil {
+			set.index[set.items[i]] = i
+		}
+	}
+	set.items = set.items[:last]
+	if set.index != nil {
+		delete(set.index, s)
+	}
+}
+
+func (set *StringSet) Contains(s string) bool {
+	return set.find(s) >= 0
+}
+
+func (set *StringSet) Cardinality() int {
+	if set == nil {
+		return 0
+	}
+	return len(set.items)
+}
+
+func (set *StringSet) Clear() {
+	set.items = set.items[:0]
+	set.index = nil
+}
+
+// The elements of the set, valid until the set is changed. The caller must not modify it.
+func (set *StringSet) Items() []string {
+	if set == nil {
+		return nil
+	}
+	return set.items
+}
+
+func (set *StringSet) Clone() *StringSet {
+	clone := &StringSet{items: make([]string, len(set.Items()))}
+	copy(clone.items, set.Items())
+	if set.Cardinality() > typedSetInline {
+		clone.index = make(map[string]int, len(clone.items))
+		for i, item := range clone.items {
+			clone.index[item] = i
+		}
+	}
+	return clone
+}
+
+// Returns a new set with the elements of both sets.
+func (set *StringSet) Union(other *StringSet) *StringSet {
+	union := set.Clone()
+	for _, item := range other.Items() {
+		union.Add(item)
+	}
+	return union
+}
+
+func (set *StringSet) Equal(other *StringSet) bool {
+	if set.Cardinality() != other.Cardinality() {
+		return false
+	}
+	for _, item := range set.Items() {
+		if !other.Contains(item) {
+			return false
+		}
+	}
+	return true
+}
+
+func (set *StringSet) String() string {
+	return fmt.Sprintf("{%s}", strings.Join(set.Items(), ", "))
+}
+
+type Uint32Set struct {
+	items []uint32
+	index map[uint32]int // position in items, nil while the set is small
+}
+
+func NewUint32Set(s ...uint32) *Uint32Set {
+	set := &Uint32Set{items: make([]uint32, 0, len(s))}
+	for _, item := range s {
+		set.Add(item)
+	}
+	return set
+}
+
+func (set *Uint32Set) find(v uint32) int {
+	if set == nil {
+		return -1
+	}
+	if set.index != nil {
+		if i, ok := set.index[v]; ok {
+			return i
+		}
+		return -1
+	}
+	for i, item := range set.items {
+		if item == v {
+			return i
+		}
+	}
+	return -1
+}
+
+// Adds an element to the set. Returns whether the item was added.
+func (set *Uint32Set) Add(v uint32) bool {
+	if set.find(v) >= 0 {
+		return false
+	}
+	set.items = append(set.items, v)
+	if set.index != nil {
+		set.index[v] = len(set.items) - 1
+	} else if len(set.items) > typedSetInline {
+		set.index = make(map[uint32]int, len(set.items))
+		for i, item := range set.items {
+			set.index[item] = i
+		}
+	}
+	return true
+}
+
+func (set *Uint32Set) Remove(v uint32) {
+	i := set.find(v)
+	if i < 0 {
+		return
+	}
+	last := len(set.items) - 1
+	if i != last {
+		set.items[i] = set.items[last]
+		if set.index != nil {
+			set.index[set.items[i]] = i
+		}
+	}
+	set.items = set.items[:last]
+	if set.index != nil {
+		delete(set.index, v)
+	}
+}
+
+func (set *Uint32Set) Contains(v uint32) bool {
+	return set.find(v) >= 0
+}
+
+func (set *Uint32Set) Cardinality() int {
+	if set == nil {
+		return 0
+	}
+	return len(set.items)
+}
+
+func (set *Uint32Set) Clear() {
+	set.items = set.items[:0]
+	set.index = nil
+}
+
+// The elements of the set, valid until the set is changed. The caller must not modify it.
+func (set *Uint32Set) Items() []uint32 {
+	if set == nil {
+		return nil
+	}
+	return set.items
+}
+
+func (set *Uint32Set) Equal(other *Uint32Set) bool {
+	if set.Cardinality() != other.Cardinality() {
+		return false
+	}
+	for _, item := range set.Items() {
+		if !other.Contains(item) {
+			return false
+		}
+	}
+	return true
+}
+
+func (set *Uint32Set) String() string {
+	items := make([]string, 0, set.Cardinality())
+	for _, item := range set.Items() {
+		items = append(items, fmt.Sprintf("%v", item))
+	}
+	return fmt.Sprintf("{%s}", strings.Join(items, ", "))
+}
@@ -1,7 +1,9 @@
 package utils
 
 import (
+	"fmt"
 	"testing"
+	"time"
 
 	"net"
 
@@ -286,3 +288,82 @@ func TestBytesDisplay(t *testing.T) {
 		t.Errorf("(%v) and (%v) is not equal\n", num, str)
 	}
 }
+
+type wheelTestTask struct {
+	id int
+}
+
+func (t *wheelTestTask) Expire() {
+}
+
+func TestTimerWheelRoll(t *testing.T) {
+	w := NewTimerWheelWithTick(time.Second)
+
+	delays := []int{1, 3, 255, 256, 300, 20000, 70000}
+	handles := make([]TimerHandle, len(delays))
+	for i, d := range delays {
+		handles[i], _ = w.AddTimer(&wheelTestTask{id: i}, time.Duration(d)*time.Second)
+	}
+	removed, _ := w.AddTimer(&wheelTestTask{id: -1}, 300*time.Second)
+	w.RemoveTimer(removed)
+	// stale handle, its node is reused by the next timer
+	w.RemoveTimer(removed)
+
+	expired := make(map[int]int)
+	for tick := 1; tick <= 70000; tick++ {
+		w.roll()
+		for _, task := range w.expired {
+			expired[task.(*wheelTestTask).id] = tick
+		}
+		w.expired = w.expired[:0]
+	}
+	for i, d := range delays {
+		if expired[i] != d {
+			t.Errorf("Timer expired at wrong tick: delay=%v tick=%v", d, expired[i])
+		}
+	}
+	if _, ok := expired[-1]; ok || len(expired) != len(delays) {
+		t.Errorf("Unexpected expired timers: %v", expired)
+	}
+
+	// all nodes are free and reused
+	for i := 0; i < len(delays)+1; i++ {
+		w.AddTimer(&wheelTestTask{id: i}, time.Second)
+	}
+	if len(w.nodes) != len(delays)+1 {
+		t.Errorf("Timer nodes not reused: %v", len(w.nodes))
+	}
+}
+
+func TestStringSet(t *testing.T) {
+	set := NewStringSet("a", "b")
+	if set.Add("a") || set.Cardinality() != 2 || !set.Contains("b") || set.Contains("c") {
+		t.Errorf("Unexpected set: %v", set)
+	}
+
+	// cross the inline size, the index is built, then removed elements should be gone
+	for i := 0; i < typedSetInline*2; i++ {
+		set.Add(fmt.Sprintf("n%d", i))
+	}
+	set.Remove("a")
+	set.Remove("n3")
+	if set.Cardinality() != typedSetInline*2 || set.Contains("a") || set.Contains("n3") || !set.Contains("n15") {
+		t.Errorf("Unexpected set: %v", set)
+	}
+	for i, item := range set.Items() {
+		if set.find(item) != i {
+			t.Errorf("Wrong index: %v %v", item, i)
+		}
+	}
+
+	other := set.Clone()
+	other.Add("a")
+	if set.Equal(other) || !set.Union(NewStringSet("a")).Equal(other) {
+		t.Errorf("Unexpected set: %v %v", set, other)
+	}
+
+	var empty *StringSet
+	if empty.Contains("a") || empty.Cardinality() != 0 || len(empty.Items()) != 0 {
+		t.Errorf("Nil set should be empty")
+	}
+}
@@ -0,0 +1,924 @@
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <netinet/ether.h>
+#include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <linux/if_packet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Load test of a running dp through its real rings and epoll loop. Two veth pairs are
+// created and their dp ends registered as an inline port pair of a synthetic endpoint,
+// with the ctrl messages the agent sends. Clients on the vex side open HTTP, TLS and DNS
+// sessions to the endpoint behind the vin side, and the server side answers each packet
+// the dp forwards, so every packet crosses the dp once.
+//
+//   client - gex == vex - dp - vin == gin - server
+//
+// A session has one packet in flight at a time, its latency is from the write on one side
+// to the read on the other. Packets that never come out are counted as drops.
+
+#define DPLOAD_CTRL_SOCK      "/tmp/dp_listen.sock"
+#define DPLOAD_SLOTS          65536
+#define DPLOAD_TIMEOUT_NS     1000000000ULL
+#define DPLOAD_DRAIN_NS       1000000000ULL
+#define DPLOAD_HIST_US        100000            // 1us buckets up to 100ms, then one more
+#define DPLOAD_MAX_FRAME      1514
+#define DPLOAD_MIN_FRAME      64
+#define DPLOAD_RX_BURST       64
+
+#define DPLOAD_SERVER_IP      0x0a640001        // 10.100.0.1
+#define DPLOAD_CLIENT_NET     0x0ac80000        // 10.200.0.0/16, a client per slot
+
+#ifndef PACKET_IGNORE_OUTGOING
+#define PACKET_IGNORE_OUTGOING 23
+#endif
+
+enum {
+    PROTO_HTTP = 0,
+    PROTO_TLS,
+    PROTO_DNS,
+    PROTO_MAX,
+};
+
+static const char *proto_names[PROTO_MAX] = {
+    [PROTO_HTTP] = "http",
+    [PROTO_TLS]  = "tls",
+    [PROTO_DNS]  = "dns",
+};
+
+static const uint16_t proto_ports[PROTO_MAX] = {
+    [PROTO_HTTP] = 80,
+    [PROTO_TLS]  = 443,
+    [PROTO_DNS]  = 53,
+};
+
+// The packet a session waits for, and the side it is read on
+enum {
+    ST_FREE = 0,
+    ST_SYN,         // server
+    ST_SYNACK,      // client
+    ST_REQUEST,     // server
+    ST_RESPONSE,    // client
+    ST_FIN,         // server
+    ST_FINACK,      // client
+    ST_LASTACK,     // server
+    ST_QUERY,       // server
+    ST_ANSWER,      // client
+};
+
+#define SIDE_CLIENT 0
+#define SIDE_SERVER 1
+
+typedef struct sess_ {
+    uint8_t state;
+    uint8_t proto;
+    uint16_t cport;
+    uint16_t size;          // frame size of the response
+    uint32_t cseq, sseq;    // next sequence numbers
+    uint64_t sent_ns;
+} sess_t;
+
+typedef struct mix_ {
+    int cnt;
+    int total;
+    int values[16];
+    int weights[16];
+} mix_t;
+
+typedef struct stats_ {
+    uint64_t sessions[PROTO_MAX];
+    uint64_t completed[PROTO_MAX];
+    uint64_t timeouts;
+    uint64_t busy;          // no free slot for a new session
+    uint64_t tx_packets, tx_bytes, tx_errors;
+    uint64_t rx_packets, rx_bytes, rx_stray;
+    uint32_t hist[DPLOAD_HIST_US + 1];
+    uint64_t lat_max_ns;
+} stats_t;
+
+static sess_t g_sess[DPLOAD_SLOTS];
+static stats_t g_stats;
+static uint8_t g_ep_mac[ETH_ALEN], g_peer_mac[ETH_ALEN];
+static int g_fd[2] = {-1, -1};
+static uint64_t g_seed = 0xd910ad;
+static volatile sig_atomic_t g_running = 1;
+
+static void help(const char *prog)
+{
+    printf("%s: load test a running dp through a port pair of veths\n", prog);
+    printf("  h: help\n");
+    printf("  e: endpoint mac, default 02:dd:00:00:00:01\n");
+    printf("  r: new sessions per second, default 1000\n");
+    printf("  t: seconds to run, default 10\n");
+    printf("  m: protocol mix, default http=50,tls=30,dns=20\n");
+    printf("  s: frame size mix of the responses, default 128=40,576=30,1514=30\n");
+    printf("  p: prefix of the veth names, default dpl\n");
+    printf("  k: keep the port pair and the veths after the run\n");
+}
+
+static void signal_exit(int num)
+{
+    g_running = 0;
+}
+
+static inline int max_int(int a, int b)
+{
+    return a > b ? a : b;
+}
+
+static inline int min_int(int a, int b)
+{
+    return a < b ? a : b;
+}
+
+static inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline uint32_t rand32(void)
+{
+    uint64_t x = g_seed;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    g_seed = x;
+    return (uint32_t)(x >> 16);
+}
+
+// "a=wa,b=wb,..." where a value is a name of 'names', or a number if names is NULL
+static int parse_mix(const char *str, const char **names, int name_cnt, mix_t *mix)
+{
+    char buf[256], *tok, *save = NULL;
+
+    memset(mix, 0, sizeof(*mix));
+    snprintf(buf, sizeof(buf), "%s", str);
+    for (tok = strtok_r(buf, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        int i, value = -1, weight;
+
+        if (eq == NULL || mix->cnt >= sizeof(mix->values) / sizeof(mix->values[0])) {
+            return -1;
+        }
+        *eq = '\0';
+        weight = atoi(eq + 1);
+        if (names != NULL) {
+            for (i = 0; i < name_cnt; i ++) {
+                if (strcasecmp(tok, names[i]) == 0) {
+                    value = i;
+                }
+            }
+        } else {
+            value = atoi(tok);
+        }
+        if (value < 0 || weight < 0) {
+            return -1;
+        }
+        mix->values[mix->cnt] = value;
+        mix->weights[mix->cnt] = weight;
+        mix->total += weight;
+        mix->cnt ++;
+    }
+    return mix->total > 0 ? 0 : -1;
+}
+
+static int pick_mix(const mix_t *mix)
+{
+    int i, w = rand32() % mix->total;
+
+    for (i = 0; i < mix->cnt; i ++) {
+        if (w < mix->weights[i]) {
+            return mix->values[i];
+        }
+        w -= mix->weights[i];
+    }
+    return mix->values[mix->cnt - 1];
+}
+
+// -- setup
+
+static int run_cmd(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static int run_cmd(const char *fmt, ...)
+{
+    char cmd[256];
+    va_list args;
+    int ret;
+
+    va_start(args, fmt);
+    vsnprintf(cmd, sizeof(cmd), fmt, args);
+    va_end(args);
+
+    ret = system(cmd);
+    if (ret != 0) {
+        printf("Failed: %s\n", cmd);
+        return -1;
+    }
+    return 0;
+}
+
+static int veth_add(const char *dp_end, const char *gen_end)
+{
+    if (run_cmd("ip link add %s type veth peer name %s", dp_end, gen_end) < 0 ||
+        run_cmd("ip link set %s up", dp_end) < 0 || run_cmd("ip link set %s up", gen_end) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int ctrl_send(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static int ctrl_send(const char *fmt, ...)
+{
+    struct sockaddr_un addr;
+    char msg[1024];
+    va_list args;
+    int fd, len, ret;
+
+    va_start(args, fmt);
+    len = vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+
+    fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, DPLOAD_CTRL_SOCK, sizeof(addr.sun_path) - 1);
+
+    ret = sendto(fd, msg, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+    close(fd);
+    if (ret < 0) {
+        printf("Failed to send to dp: %s\n", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int open_side(const char *iface)
+{
+    struct sockaddr_ll sll;
+    int fd, one = 1, bufsize = 4 * 1024 * 1024;
+
+    fd = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK, htons(ETH_P_ALL));
+    if (fd < 0) {
+        printf("Failed to open a packet socket: %s\n", strerror(errno));
+        return -1;
+    }
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex = if_nametoindex(iface);
+    if (sll.sll_ifindex == 0 || bind(fd, (struct sockaddr *)&sll, sizeof(sll)) < 0) {
+        printf("Failed to bind to %s: %s\n", iface, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    // Older kernels don't have it, outgoing packets are skipped on read then
+    setsockopt(fd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof(bufsize));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+    return fd;
+}
+
+// -- packets
+
+static uint16_t cksum_add(uint32_t sum, const void *data, int len)
+{
+    const uint8_t *p = data;
+
+    while (len > 1) {
+        sum += (p[0] << 8) | p[1];
+        p += 2;
+        len -= 2;
+    }
+    if (len > 0) {
+        sum += p[0] << 8;
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return sum;
+}
+
+static uint16_t l4_cksum(const struct iphdr *iph, const void *l4, int len)
+{
+    uint8_t pseudo[12];
+    uint32_t sum;
+
+    memcpy(pseudo, &iph->saddr, 4);
+    memcpy(pseudo + 4, &iph->daddr, 4);
+    pseudo[8] = 0;
+    pseudo[9] = iph->protocol;
+    pseudo[10] = len >> 8;
+    pseudo[11] = len & 0xff;
+    sum = cksum_add(0, pseudo, sizeof(pseudo));
+    return htons(~cksum_add(sum, l4, len));
+}
+
+static inline uint32_t client_ip(int slot)
+{
+    return DPLOAD_CLIENT_NET | slot;
+}
+
+static int build_packet(uint8_t *buf, int slot, int side, uint8_t tcp_flags,
+                        const uint8_t *payload, int plen)
+{
+    sess_t *s = &g_sess[slot];
+    struct ethhdr *eth = (struct ethhdr *)buf;
+    struct iphdr *iph = (struct iphdr *)(eth + 1);
+    uint8_t *l4 = (uint8_t *)(iph + 1);
+    bool to_server = side == SIDE_CLIENT;
+    uint16_t sport = proto_ports[s->proto];
+    int l4len;
+
+    memcpy(eth->h_dest, to_server ? g_ep_mac : g_peer_mac, ETH_ALEN);
+    memcpy(eth->h_source, to_server ? g_peer_mac : g_ep_mac, ETH_ALEN);
+    eth->h_proto = htons(ETH_P_IP);
+
+    memset(iph, 0, sizeof(*iph));
+    iph->version = 4;
+    iph->ihl = 5;
+    iph->ttl = 64;
+    iph->id = htons(rand32());
+    iph->saddr = htonl(to_server ? client_ip(slot) : DPLOAD_SERVER_IP);
+    iph->daddr = htonl(to_server ? DPLOAD_SERVER_IP : client_ip(slot));
+
+    if (s->proto == PROTO_DNS) {
+        struct udphdr *udph = (struct udphdr *)l4;
+
+        l4len = sizeof(*udph) + plen;
+        udph->source = htons(to_server ? s->cport : sport);
+        udph->dest = htons(to_server ? sport : s->cport);
+        udph->len = htons(l4len);
+        udph->check = 0;
+        memcpy(udph + 1, payload, plen);
+        iph->protocol = IPPROTO_UDP;
+        udph->check = l4_cksum(iph, udph, l4len);
+    } else {
+        struct tcphdr *tcph = (struct tcphdr *)l4;
+
+        l4len = sizeof(*tcph) + plen;
+        memset(tcph, 0, sizeof(*tcph));
+        tcph->source = htons(to_server ? s->cport : sport);
+        tcph->dest = htons(to_server ? sport : s->cport);
+        tcph->seq = htonl(to_server ? s->cseq : s->sseq);
+        tcph->ack_seq = (tcp_flags & TH_ACK) ? htonl(to_server ? s->sseq : s->cseq) : 0;
+        tcph->doff = sizeof(*tcph) / 4;
+        ((uint8_t *)tcph)[13] = tcp_flags;
+        tcph->window = htons(65535);
+        memcpy(tcph + 1, payload, plen);
+        iph->protocol = IPPROTO_TCP;
+        tcph->check = l4_cksum(iph, tcph, l4len);
+
+        if (to_server) {
+            s->cseq += plen + ((tcp_flags & (TH_SYN | TH_FIN)) ? 1 : 0);
+        } else {
+            s->sseq += plen + ((tcp_flags & (TH_SYN | TH_FIN)) ? 1 : 0);
+        }
+    }
+
+    iph->tot_len = htons(sizeof(*iph) + l4len);
+    iph->check = htons(~cksum_add(0, iph, sizeof(*iph)));
+    return sizeof(*eth) + sizeof(*iph) + l4len;
+}
+
+static const char http_request[] =
+    "GET /index.html HTTP/1.1\r\nHost: load.test\r\nUser-Agent: dpload\r\nAccept: */*\r\n\r\n";
+
+// Room a frame leaves for the payload
+static int payload_room(int proto, int frame)
+{
+    int hdrs = sizeof(struct ethhdr) + sizeof(struct iphdr) +
+               (proto == PROTO_DNS ? sizeof(struct udphdr) : sizeof(struct tcphdr));
+
+    return frame > hdrs ? frame - hdrs : 0;
+}
+
+static int http_response(uint8_t *buf, int room)
+{
+    const char *fmt = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: %5d\r\n\r\n";
+    int hlen = snprintf(NULL, 0, fmt, 0), body = max_int(room - hlen, 0);
+
+    snprintf((char *)buf, hlen + 1, fmt, body);
+    memset(buf + hlen, 'x', body);
+    return hlen + body;
+}
+
+static inline void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xff;
+}
+
+static inline void put24(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 16;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = v & 0xff;
+}
+
+static void fill_random(uint8_t *p, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i ++) {
+        p[i] = rand32();
+    }
+}
+
+// A TLS 1.2 ClientHello with the SNI extension
+static int tls_client_hello(uint8_t *buf)
+{
+    static const uint16_t ciphers[] = {0xc02f, 0xc030, 0xc02b, 0xc02c, 0x009c, 0x002f};
+    static const char sni[] = "load.test";
+    uint8_t *p = buf + 9;
+    int i, ext_len = 9 + strlen(sni), body_len;
+
+    put16(p, 0x0303);
+    p += 2;
+    fill_random(p, 32);
+    p += 32;
+    *p ++ = 0;                                  // session id
+    put16(p, sizeof(ciphers));
+    p += 2;
+    for (i = 0; i < sizeof(ciphers) / sizeof(ciphers[0]); i ++) {
+        put16(p, ciphers[i]);
+        p += 2;
+    }
+    *p ++ = 1;                                  // compression methods
+    *p ++ = 0;
+    put16(p, 4 + ext_len);                      // extensions
+    p += 2;
+    put16(p, 0);                                // server_name
+    put16(p + 2, ext_len);
+    put16(p + 4, ext_len - 2);
+    p[6] = 0;                                   // host_name
+    put16(p + 7, strlen(sni));
+    memcpy(p + 9, sni, strlen(sni));
+    p += 4 + ext_len;
+
+    body_len = p - (buf + 9);
+    buf[0] = 0x16;                              // handshake record
+    put16(buf + 1, 0x0301);
+    put16(buf + 3, body_len + 4);
+    buf[5] = 0x01;                              // client_hello
+    put24(buf + 6, body_len);
+    return p - buf;
+}
+
+// A ServerHello, then application data to fill the room
+static int tls_server_response(uint8_t *buf, int room)
+{
+    uint8_t *p = buf + 9;
+    int hello_len, data;
+
+    put16(p, 0x0303);
+    p += 2;
+    fill_random(p, 32);
+    p += 32;
+    *p ++ = 0;                                  // session id
+    put16(p, 0xc02f);
+    p += 2;
+    *p ++ = 0;                                  // compression
+    put16(p, 0);                                // extensions
+    p += 2;
+
+    hello_len = p - (buf + 9);
+    buf[0] = 0x16;
+    put16(buf + 1, 0x0303);
+    put16(buf + 3, hello_len + 4);
+    buf[5] = 0x02;                              // server_hello
+    put24(buf + 6, hello_len);
+
+    data = room - (p - buf) - 5;
+    if (data <= 0) {
+        return p - buf;
+    }
+    p[0] = 0x17;                                // application data record
+    put16(p + 1, 0x0303);
+    put16(p + 3, data);
+    fill_random(p + 5, data);
+    return p - buf + 5 + data;
+}
+
+// A query for load.test, or its answer
+static int dns_message(uint8_t *buf, uint16_t id, bool answer)
+{
+    static const uint8_t qname[] = "\x04load\x04test";
+    uint8_t *p = buf;
+
+    put16(p, id);
+    put16(p + 2, answer ? 0x8180 : 0x0100);
+    put16(p + 4, 1);
+    put16(p + 6, answer ? 1 : 0);
+    put16(p + 8, 0);
+    put16(p + 10, 0);
+    p += 12;
+    memcpy(p, qname, sizeof(qname));            // with the root label
+    p += sizeof(qname);
+    put16(p, 1);                                // A
+    put16(p + 2, 1);                            // IN
+    p += 4;
+    if (answer) {
+        put16(p, 0xc00c);
+        put16(p + 2, 1);
+        put16(p + 4, 1);
+        put16(p + 6, 0);                        // ttl
+        put16(p + 8, 60);
+        put16(p + 10, 4);
+        p += 12;
+        *p ++ = 10;
+        *p ++ = 100;
+        *p ++ = 0;
+        *p ++ = 1;
+    }
+    return p - buf;
+}
+
+static void send_packet(int slot, int side, uint8_t tcp_flags, const uint8_t *payload, int plen,
+                        int next_state)
+{
+    uint8_t frame[DPLOAD_MAX_FRAME + 64];
+    sess_t *s = &g_sess[slot];
+    int len = build_packet(frame, slot, side, tcp_flags, payload, plen);
+
+    if (len < DPLOAD_MIN_FRAME) {
+        memset(frame + len, 0, DPLOAD_MIN_FRAME - len);
+        len = DPLOAD_MIN_FRAME;
+    }
+
+    s->state = next_state;
+    s->sent_ns = now_ns();
+    if (send(g_fd[side], frame, len, 0) < 0) {
+        g_stats.tx_errors ++;
+        return;
+    }
+    g_stats.tx_packets ++;
+    g_stats.tx_bytes += len;
+}
+
+// -- sessions
+
+// The response of the server or the next packet of the client, for a packet read on 'side'
+static void sess_step(int slot, int side)
+{
+    uint8_t payload[DPLOAD_MAX_FRAME];
+    sess_t *s = &g_sess[slot];
+    int room = payload_room(s->proto, s->size), len;
+
+    switch (s->state) {
+    case ST_SYN:
+        send_packet(slot, SIDE_SERVER, TH_SYN | TH_ACK, NULL, 0, ST_SYNACK);
+        break;
+    case ST_SYNACK:
+        if (s->proto == PROTO_HTTP) {
+            len = sizeof(http_request) - 1;
+            memcpy(payload, http_request, len);
+        } else {
+            len = tls_client_hello(payload);
+        }
+        send_packet(slot, SIDE_CLIENT, TH_ACK | TH_PUSH, payload, len, ST_REQUEST);
+        break;
+    case ST_REQUEST:
+        len = s->proto == PROTO_HTTP ? http_response(payload, room) : tls_server_response(payload, room);
+        send_packet(slot, SIDE_SERVER, TH_ACK | TH_PUSH, payload, len, ST_RESPONSE);
+        break;
+    case ST_RESPONSE:
+        send_packet(slot, SIDE_CLIENT, TH_FIN | TH_ACK, NULL, 0, ST_FIN);
+        break;
+    case ST_FIN:
+        send_packet(slot, SIDE_SERVER, TH_FIN | TH_ACK, NULL, 0, ST_FINACK);
+        break;
+    case ST_FINACK:
+        send_packet(slot, SIDE_CLIENT, TH_ACK, NULL, 0, ST_LASTACK);
+        break;
+    case ST_QUERY:
+        len = dns_message(payload, s->cport, true);
+        send_packet(slot, SIDE_SERVER, 0, payload, len, ST_ANSWER);
+        break;
+    case ST_LASTACK:
+    case ST_ANSWER:
+        g_stats.completed[s->proto] ++;
+        s->state = ST_FREE;
+        break;
+    }
+}
+
+static void sess_start(uint64_t n, const mix_t *protos, const mix_t *sizes, uint64_t now)
+{
+    uint8_t payload[512];
+    int slot = n % DPLOAD_SLOTS, len;
+    sess_t *s = &g_sess[slot];
+
+    if (s->state != ST_FREE) {
+        if (now - s->sent_ns < DPLOAD_TIMEOUT_NS) {
+            g_stats.busy ++;
+            return;
+        }
+        g_stats.timeouts ++;
+    }
+
+    // A slot is a client address, its port changes with each session of the slot
+    s->proto = pick_mix(protos);
+    s->size = max_int(min_int(pick_mix(sizes), DPLOAD_MAX_FRAME), DPLOAD_MIN_FRAME);
+    s->cport = 1024 + (n / DPLOAD_SLOTS) % 64000;
+    s->cseq = rand32();
+    s->sseq = rand32();
+    g_stats.sessions[s->proto] ++;
+
+    if (s->proto == PROTO_DNS) {
+        len = dns_message(payload, s->cport, false);
+        send_packet(slot, SIDE_CLIENT, 0, payload, len, ST_QUERY);
+    } else {
+        send_packet(slot, SIDE_CLIENT, TH_SYN, NULL, 0, ST_SYN);
+    }
+}
+
+static inline bool state_side(int state, int side)
+{
+    switch (state) {
+    case ST_SYN:
+    case ST_REQUEST:
+    case ST_FIN:
+    case ST_LASTACK:
+    case ST_QUERY:
+        return side == SIDE_SERVER;
+    case ST_SYNACK:
+    case ST_RESPONSE:
+    case ST_FINACK:
+    case ST_ANSWER:
+        return side == SIDE_CLIENT;
+    }
+    return false;
+}
+
+static void lat_add(uint64_t ns)
+{
+    uint64_t us = ns / 1000;
+
+    g_stats.hist[us < DPLOAD_HIST_US ? us : DPLOAD_HIST_US] ++;
+    if (ns > g_stats.lat_max_ns) {
+        g_stats.lat_max_ns = ns;
+    }
+}
+
+// Match a frame read on 'side' to the session waiting for it
+static void recv_frame(int side, const uint8_t *frame, int len, uint64_t now)
+{
+    const struct ethhdr *eth = (const struct ethhdr *)frame;
+    const struct iphdr *iph = (const struct iphdr *)(eth + 1);
+    uint32_t cip;
+    int slot;
+
+    if (len < sizeof(*eth) + sizeof(*iph) + sizeof(struct udphdr) || eth->h_proto != htons(ETH_P_IP)) {
+        return;
+    }
+
+    cip = ntohl(side == SIDE_SERVER ? iph->saddr : iph->daddr);
+    if ((cip & 0xffff0000) != DPLOAD_CLIENT_NET ||
+        ntohl(side == SIDE_SERVER ? iph->daddr : iph->saddr) != DPLOAD_SERVER_IP) {
+        return;
+    }
+
+    g_stats.rx_packets ++;
+    g_stats.rx_bytes += len;
+
+    slot = cip & 0xffff;
+    if (!state_side(g_sess[slot].state, side)) {
+        g_stats.rx_stray ++;
+        return;
+    }
+    lat_add(now - g_sess[slot].sent_ns);
+    sess_step(slot, side);
+}
+
+static void recv_side(int side)
+{
+    uint8_t frame[DPLOAD_MAX_FRAME + 64];
+    struct sockaddr_ll from;
+    socklen_t fromlen;
+    int i, len;
+
+    for (i = 0; i < DPLOAD_RX_BURST; i ++) {
+        fromlen = sizeof(from);
+        len = recvfrom(g_fd[side], frame, sizeof(frame), 0, (struct sockaddr *)&from, &fromlen);
+        if (len < 0) {
+            return;
+        }
+        if (from.sll_pkttype != PACKET_OUTGOING) {
+            recv_frame(side, frame, len, now_ns());
+        }
+    }
+}
+
+// -- report
+
+static double lat_percentile(uint64_t total, double pct)
+{
+    uint64_t want = (uint64_t)(total * pct / 100), seen = 0;
+    int i;
+
+    for (i = 0; i <= DPLOAD_HIST_US; i ++) {
+        seen += g_stats.hist[i];
+        if (seen > want) {
+            return i;
+        }
+    }
+    return DPLOAD_HIST_US;
+}
+
+static void report(uint64_t ns)
+{
+    uint64_t lats = 0, sessions = 0, completed = 0, lost;
+    double secs = (double)ns / 1000000000;
+    int i;
+
+    for (i = 0; i <= DPLOAD_HIST_US; i ++) {
+        lats += g_stats.hist[i];
+    }
+    for (i = 0; i < PROTO_MAX; i ++) {
+        sessions += g_stats.sessions[i];
+        completed += g_stats.completed[i];
+    }
+    lost = g_stats.tx_packets > g_stats.rx_packets ? g_stats.tx_packets - g_stats.rx_packets : 0;
+
+    printf("seconds=%.1f sessions=%lu completed=%lu timeouts=%lu busy=%lu\n",
+           secs, sessions, completed, g_stats.timeouts, g_stats.busy);
+    for (i = 0; i < PROTO_MAX; i ++) {
+        printf("%s sessions=%lu completed=%lu\n", proto_names[i], g_stats.sessions[i], g_stats.completed[i]);
+    }
+    printf("tx_packets=%lu tx_errors=%lu rx_packets=%lu rx_stray=%lu drops=%lu drop_rate=%.4f%%\n",
+           g_stats.tx_packets, g_stats.tx_errors, g_stats.rx_packets, g_stats.rx_stray, lost,
+           g_stats.tx_packets > 0 ? (double)lost * 100 / g_stats.tx_packets : 0);
+    printf("rx_pps=%.0f rx_mbps=%.1f\n",
+           secs > 0 ? g_stats.rx_packets / secs : 0, secs > 0 ? g_stats.rx_bytes * 8 / secs / 1000000 : 0);
+    printf("latency_us p50=%.0f p90=%.0f p99=%.0f p999=%.0f max=%.0f\n",
+           lat_percentile(lats, 50), lat_percentile(lats, 90), lat_percentile(lats, 99),
+           lat_percentile(lats, 99.9), (double)g_stats.lat_max_ns / 1000);
+}
+
+// -- main
+
+static void run(uint32_t rate, uint32_t seconds, const mix_t *protos, const mix_t *sizes)
+{
+    struct pollfd pfd[2];
+    uint64_t start = now_ns(), end = start + (uint64_t)seconds * 1000000000, now, n = 0;
+    int i;
+
+    for (i = 0; i < 2; i ++) {
+        pfd[i].fd = g_fd[i];
+        pfd[i].events = POLLIN;
+    }
+
+    while (g_running) {
+        now = now_ns();
+        if (now >= end + DPLOAD_DRAIN_NS) {
+            break;
+        }
+
+        // Sessions due by now, at a steady rate
+        if (now < end) {
+            uint64_t due = (now - start) * rate / 1000000000;
+
+            for (; n < due; n ++) {
+                sess_start(n, protos, sizes, now);
+            }
+        }
+
+        if (poll(pfd, 2, 1) > 0) {
+            for (i = 0; i < 2; i ++) {
+                if (pfd[i].revents & POLLIN) {
+                    recv_side(i);
+                }
+            }
+        }
+    }
+
+    // Sessions still waiting at the end
+    for (i = 0; i < DPLOAD_SLOTS; i ++) {
+        if (g_sess[i].state != ST_FREE) {
+            g_stats.timeouts ++;
+        }
+    }
+
+    now = now_ns();
+    report((now < end ? now : end) - start);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *ep_mac = "02:dd:00:00:00:01", *prefix = "dpl";
+    const char *proto_mix = "http=50,tls=30,dns=20", *size_mix = "128=40,576=30,1514=30";
+    char vin[IFNAMSIZ], vex[IFNAMSIZ], gin[IFNAMSIZ], gex[IFNAMSIZ];
+    uint32_t rate = 1000, seconds = 10;
+    bool keep = false;
+    mix_t protos, sizes;
+    int arg, ret = -1;
+
+    while ((arg = getopt(argc, argv, "he:r:t:m:s:p:k")) != -1) {
+        switch (arg) {
+        case 'e':
+            ep_mac = optarg;
+            break;
+        case 'r':
+            rate = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            seconds = strtoul(optarg, NULL, 10);
+            break;
+        case 'm':
+            proto_mix = optarg;
+            break;
+        case 's':
+            size_mix = optarg;
+            break;
+        case 'p':
+            prefix = optarg;
+            break;
+        case 'k':
+            keep = true;
+            break;
+        default:
+            help(argv[0]);
+            exit(-2);
+        }
+    }
+
+    if (ether_aton_r(ep_mac, (struct ether_addr *)g_ep_mac) == NULL ||
+        parse_mix(proto_mix, proto_names, PROTO_MAX, &protos) < 0 ||
+        parse_mix(size_mix, NULL, 0, &sizes) < 0 || rate == 0 || strlen(prefix) > IFNAMSIZ - 5) {
+        help(argv[0]);
+        exit(-2);
+    }
+    memcpy(g_peer_mac, g_ep_mac, ETH_ALEN);
+    g_peer_mac[ETH_ALEN - 1] ^= 0xff;
+
+    snprintf(vin, sizeof(vin), "%svin", prefix);
+    snprintf(vex, sizeof(vex), "%svex", prefix);
+    snprintf(gin, sizeof(gin), "%sgin", prefix);
+    snprintf(gex, sizeof(gex), "%sgex", prefix);
+
+    signal(SIGTERM, signal_exit);
+    signal(SIGINT, signal_exit);
+
+    if (veth_add(vin, gin) < 0 || veth_add(vex, gex) < 0) {
+        goto cleanup_veth;
+    }
+
+    // As the agent adds an inline workload
+    if (ctrl_send("{\"ctrl_add_mac\":{\"iface\":\"%s\",\"mac\":\"%s\",\"ucmac\":\"\",\"bcmac\":\"\"}}",
+                  vin, ep_mac) < 0 ||
+        ctrl_send("{\"ctrl_cfg_mac\":{\"macs\":[\"%s\"],\"tap\":false}}", ep_mac) < 0 ||
+        ctrl_send("{\"ctrl_add_port_pair\":{\"vin_iface\":\"%s\",\"vex_iface\":\"%s\",\"epmac\":\"%s\",\"quar\":false}}",
+                  vin, vex, ep_mac) < 0) {
+        goto cleanup_dp;
+    }
+
+    g_fd[SIDE_CLIENT] = open_side(gex);
+    g_fd[SIDE_SERVER] = open_side(gin);
+    if (g_fd[SIDE_CLIENT] < 0 || g_fd[SIDE_SERVER] < 0) {
+        goto cleanup_dp;
+    }
+
+    // Give the dp thread time to open its rings
+    sleep(1);
+
+    printf("ep=%s rate=%u seconds=%u protocols=%s sizes=%s\n", ep_mac, rate, seconds, proto_mix, size_mix);
+    run(rate, seconds, &protos, &sizes);
+    ret = 0;
+
+cleanup_dp:
+    if (g_fd[SIDE_CLIENT] >= 0) {
+        close(g_fd[SIDE_CLIENT]);
+    }
+    if (g_fd[SIDE_SERVER] >= 0) {
+        close(g_fd[SIDE_SERVER]);
+    }
+    if (keep) {
+        return ret;
+    }
+    ctrl_send("{\"ctrl_del_port_pair\":{\"vin_iface\":\"%s\",\"vex_iface\":\"%s\"}}", vin, vex);
+    ctrl_send("{\"ctrl_del_mac\":{\"iface\":\"%s\",\"mac\":\"%s\"}}", vin, ep_mac);
+cleanup_veth:
+    run_cmd("ip link del %s 2>/dev/null", vin);
+    run_cmd("ip link del %s 2>/dev/null", vex);
+    return ret;
+}